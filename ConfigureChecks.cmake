@@ -7,21 +7,26 @@ include(CheckFunctionExists)
 include(CheckLibraryExists)
 include(CheckSymbolExists)
 include(CheckTypeSize)
+include(CheckStructHasMember)
 include(CheckCSourceCompiles)
 include(CheckCXXSourceCompiles)
 include(CheckCXXCompilerFlag)
 
 check_include_files(dlfcn.h       HAVE_DLFCN_H)
 check_include_files(errno.h       LOG4CPLUS_HAVE_ERRNO_H )
+check_include_files(execinfo.h    LOG4CPLUS_HAVE_EXECINFO_H )
 check_include_files(iconv.h       LOG4CPLUS_HAVE_ICONV_H )
 check_include_files(limits.h      LOG4CPLUS_HAVE_LIMITS_H )
 check_include_files(sys/types.h   LOG4CPLUS_HAVE_SYS_TYPES_H )
 check_include_files("sys/types.h;sys/socket.h"  LOG4CPLUS_HAVE_SYS_SOCKET_H )
 check_include_files(sys/syscall.h LOG4CPLUS_HAVE_SYS_SYSCALL_H )
+check_include_files("sys/types.h;sys/un.h"      LOG4CPLUS_HAVE_SYS_UN_H )
+check_include_files(sys/ioctl.h   LOG4CPLUS_HAVE_SYS_IOCTL_H )
 check_include_files("sys/types.h;sys/time.h"    LOG4CPLUS_HAVE_SYS_TIME_H )
 check_include_files("sys/types.h;sys/timeb.h"   LOG4CPLUS_HAVE_SYS_TIMEB_H )
 check_include_files("sys/types.h;sys/stat.h"    LOG4CPLUS_HAVE_SYS_STAT_H )
 check_include_files(sys/file.h    LOG4CPLUS_HAVE_SYS_FILE_H )
+check_include_files(sys/inotify.h LOG4CPLUS_HAVE_SYS_INOTIFY_H )
 check_include_files(syslog.h      LOG4CPLUS_HAVE_SYSLOG_H )
 check_include_files(arpa/inet.h   LOG4CPLUS_HAVE_ARPA_INET_H )
 check_include_files(netinet/in.h  LOG4CPLUS_HAVE_NETINET_IN_H )
@@ -62,8 +67,13 @@ endif (ANDROID)
 check_function_exists(gmtime_r      LOG4CPLUS_HAVE_GMTIME_R )
 check_function_exists(localtime_r   LOG4CPLUS_HAVE_LOCALTIME_R )
 check_function_exists(gettimeofday  LOG4CPLUS_HAVE_GETTIMEOFDAY )
+check_struct_has_member("struct tm" tm_gmtoff time.h
+  LOG4CPLUS_HAVE_STRUCT_TM_TM_GMTOFF )
 check_function_exists(getpid        LOG4CPLUS_HAVE_GETPID )
 check_function_exists(poll          LOG4CPLUS_HAVE_POLL )
+check_function_exists(sendmmsg      LOG4CPLUS_HAVE_SENDMMSG )
+check_function_exists(pthread_setname_np LOG4CPLUS_HAVE_PTHREAD_SETNAME_NP )
+check_function_exists(pthread_setaffinity_np LOG4CPLUS_HAVE_PTHREAD_SETAFFINITY_NP )
 check_function_exists(pipe          LOG4CPLUS_HAVE_PIPE )
 check_function_exists(pipe2         LOG4CPLUS_HAVE_PIPE2 )
 check_function_exists(accept4       LOG4CPLUS_HAVE_ACCEPT4 )
@@ -71,6 +81,7 @@ check_function_exists(ftime         LOG4CPLUS_HAVE_FTIME )
 check_function_exists(stat          LOG4CPLUS_HAVE_STAT )
 check_function_exists(lstat         LOG4CPLUS_HAVE_LSTAT )
 check_function_exists(fcntl         LOG4CPLUS_HAVE_FCNTL )
+check_function_exists(fallocate     LOG4CPLUS_HAVE_FALLOCATE )
 check_function_exists(lockf         LOG4CPLUS_HAVE_FLOCK )
 check_function_exists(flock         LOG4CPLUS_HAVE_LOCKF )
 check_function_exists(htons         LOG4CPLUS_HAVE_HTONS )
@@ -332,11 +343,13 @@ set(HAVE_ICONV_CLOSE           ${LOG4CPLUS_HAVE_ICONV_CLOSE} )
 set(HAVE_ICONV                 ${LOG4CPLUS_HAVE_ICONV} )
 set(HAVE_LSTAT                 ${LOG4CPLUS_HAVE_LSTAT} )
 set(HAVE_FCNTL                 ${LOG4CPLUS_HAVE_FCNTL} )
+set(HAVE_FALLOCATE             ${LOG4CPLUS_HAVE_FALLOCATE} )
 set(HAVE_LOCKF                 ${LOG4CPLUS_HAVE_LOCKF} )
 set(HAVE_FLOCK                 ${LOG4CPLUS_HAVE_FLOCK} )
 set(HAVE_LOCALTIME_R           ${LOG4CPLUS_HAVE_LOCALTIME_R} )
 set(HAVE_NTOHL                 ${LOG4CPLUS_HAVE_NTOHL} )
 set(HAVE_NTOHS                 ${LOG4CPLUS_HAVE_NTOHS} )
+set(HAVE_SENDMMSG              ${LOG4CPLUS_HAVE_SENDMMSG} )
 set(HAVE_STAT                  ${LOG4CPLUS_HAVE_STAT} )
 
 set(HAVE_VFPRINTF_S            ${LOG4CPLUS_HAVE_VFPRINTF_S} )
@@ -5,7 +5,6 @@ am
 =]## Generated by Autogen from [= (tpl-file) =]
 
 AM_CPPFLAGS = -I$(top_srcdir)/include \
-	-I$(top_srcdir)/threadpool \
 	-I$(top_builddir)/include \
 	-I$(top_srcdir)/catch/single_include/catch2 \
         -DCATCH_CONFIG_PREFIX_ALL=1 \
@@ -32,6 +32,7 @@
 
 #include <log4cplus/layout.h>
 #include <log4cplus/loglevel.h>
+#include <log4cplus/metrics.h>
 #include <log4cplus/tstring.h>
 #include <log4cplus/helpers/pointer.h>
 #include <log4cplus/spi/filter.h>
@@ -40,7 +41,10 @@
 #include <memory>
 #include <mutex>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <span>
+#include <vector>
 
 
 namespace log4cplus {
@@ -54,6 +58,20 @@ namespace log4cplus {
     }
 
 
+    namespace internal
+    {
+
+        class async_strand;
+        struct appender_metrics;
+
+    }
+
+
+    //! Receives events visited by Appender::emergencyDump().
+    typedef void (* EmergencyEventVisitor) (
+        const log4cplus::spi::InternalLoggingEvent& event, void * arg);
+
+
     /**
      * This class is used to "handle" errors encountered in an {@link
      * log4cplus::Appender}.
@@ -128,10 +146,33 @@ namespace log4cplus {
      * \sa FileAppender
      * </dd>
      *
+     * <dt><tt>MaxLockHoldMs</tt></dt>
+     * <dd>Batches of events, e.g., those of AsyncAppender's queue, are
+     * written under single lock of the lock file. When this property
+     * is not zero, the lock file is released and taken again after
+     * this many milliseconds so that other processes are not kept
+     * waiting for the whole batch. Default is <tt>0</tt>, no limit.
+     * </dd>
+     *
      * <dt><tt>AsyncAppend</tt></dt>
      * <dd>Set this property to <tt>true</tt> if you want all appends using
      * this appender to be done asynchronously. Default is <tt>false</tt>.</dd>
      *
+     * <dt><tt>AsyncFanOut</tt></dt>
+     * <dd>Set this property to <tt>true</tt> together with
+     * <tt>AsyncAppend</tt> to let the appender share a single copy of
+     * each event with other such appenders of the same logger instead
+     * of copying it for itself. Each appender still appends from its
+     * own queue, so a slow one does not delay the others. Shared
+     * events are appended one by one instead of in batches. Default is
+     * <tt>false</tt>.</dd>
+     *
+     * <dt><tt>Metrics</tt></dt>
+     * <dd>Set this property to <tt>true</tt> to collect AppenderMetrics
+     * of this appender. Default is <tt>false</tt>.
+     * \sa setMetricsEnabled()
+     * </dd>
+     *
      * </dl>
      */
     class LOG4CPLUS_EXPORT Appender
@@ -190,6 +231,37 @@ namespace log4cplus {
          */
         void doAppend(const log4cplus::spi::InternalLoggingEvent& event);
 
+        /**
+         * Queues `event`, which other appenders may queue as well, for
+         * asynchronous append when isAsyncFanOut() is true; otherwise
+         * it is the same as `doAppend()`. The event has to capture
+         * fields required by this appender.
+         */
+        void doAppendShared(
+            std::shared_ptr<log4cplus::spi::InternalLoggingEvent const> const & event);
+
+        //! \return True if doAppendShared() queues events without
+        //! copying them, see <tt>AsyncFanOut</tt> property.
+        bool isAsyncFanOut() const;
+
+        /**
+         * This method performs threshold checks and invokes filters for
+         * each of the events, then delegates logging of the accepted
+         * events to the subclasses specific {@link #appendBatch}
+         * method. The appender lock and the lock file are acquired only
+         * once for the whole batch.
+         */
+        void syncDoAppendBatch(
+            std::span<log4cplus::spi::InternalLoggingEvent const> events);
+
+        /**
+         * This function checks `async` flag. It either executes
+         * `syncDoAppendBatch()` directly or enqueues asynchronous
+         * append of each of the events to thread pool thread.
+         */
+        void doAppendBatch(
+            std::span<log4cplus::spi::InternalLoggingEvent const> events);
+
         /**
          * Get the name of this appender. The name uniquely identifies the
          * appender.
@@ -252,7 +324,10 @@ namespace log4cplus {
          * Returns this appenders threshold LogLevel. See the {@link
          * #setThreshold} method for the meaning of this option.
          */
-        LogLevel getThreshold() const { return threshold; }
+        LogLevel getThreshold() const
+        {
+            return threshold.load(std::memory_order_relaxed);
+        }
 
         /**
          * Set the threshold LogLevel. All log events with lower LogLevel
@@ -262,7 +337,7 @@ namespace log4cplus {
          * value of the <b>Threshold</b> option to a LogLevel
          * string, such as "DEBUG", "INFO" and so on.
          */
-        void setThreshold(LogLevel th) { threshold = th; }
+        void setThreshold(LogLevel th);
 
         /**
          * Check whether the message LogLevel is below the appender's
@@ -270,7 +345,8 @@ namespace log4cplus {
          * always <code>true</code>.
          */
         bool isAsSevereAsThreshold(LogLevel ll) const {
-            return ((ll != NOT_SET_LOG_LEVEL) && (ll >= threshold));
+            return ((ll != NOT_SET_LOG_LEVEL)
+                && (ll >= threshold.load(std::memory_order_relaxed)));
         }
 
         /**
@@ -279,6 +355,100 @@ namespace log4cplus {
          */
         void waitToFinishAsyncLogging();
 
+        /**
+         * Waits for events being asynchronously logged to finish or
+         * until <code>deadline</code>, whichever comes first.
+         *
+         * @return <code>true</code> if no event is in flight.
+         */
+        bool waitToFinishAsyncLogging(
+            std::chrono::steady_clock::time_point deadline);
+
+        /**
+         * Returns <code>true</code> if events passed to doAppend() are
+         * processed on another thread. Such appenders work with copies
+         * of the events and do not need their messages formatted by the
+         * logging thread.
+         */
+        virtual bool isAsynchronous() const;
+
+        /**
+         * Returns combination of spi::EventFields this appender reads.
+         * Copies of events handed over to other threads capture only
+         * these. The default implementation combines fields read by the
+         * layout and by the filter chain; appenders that read event
+         * fields directly have to override it.
+         */
+        virtual unsigned getRequiredEventFields() const;
+
+        /**
+         * Tells whether events of LogLevel <code>ll</code> from logger
+         * <code>loggerName</code>, logged by the calling thread, may pass
+         * the threshold and the filter chain of this appender, see
+         * spi::preCheckFilter(). Sets <code>contextual</code> to
+         * <code>true</code> when the answer depends on NDC or MDC of the
+         * calling thread.
+         */
+        bool mayAppend(LogLevel ll, const log4cplus::tstring& loggerName,
+            bool& contextual) const;
+
+        /**
+         * Tells whether anything consumes events of LogLevel
+         * <code>ll</code> written by this appender now, e.g., whether a
+         * tracing session listens to them. When it does not, mayAppend()
+         * is false and loggers whose appenders all lack consumers are
+         * not enabled for <code>ll</code>. The answer is cached; an
+         * appender whose consumers come and go has to call
+         * consumersChanged(). The default implementation returns
+         * <code>true</code>.
+         */
+        virtual bool hasConsumers(LogLevel ll) const;
+
+        /**
+         * Prepares resources of the emergency path, see
+         * addEmergencyAppender(). It is called outside of any signal
+         * handler. The default implementation does nothing.
+         */
+        virtual void prepareEmergency();
+
+        /**
+         * Writes already formatted <code>data</code> to the output of
+         * the appender using async-signal-safe means only, bypassing
+         * locks, buffers and the layout of the appender. It is called
+         * by the emergency path, possibly from a signal handler.
+         * \return <code>false</code> if the appender has no such
+         * output. The default implementation returns
+         * <code>false</code>.
+         */
+        virtual bool emergencyWrite(const char * data, std::size_t size)
+            noexcept;
+
+        /**
+         * Passes events kept in memory by the appender and not yet
+         * appended, e.g., those waiting in the queue of AsyncAppender,
+         * to <code>visitor</code>, without taking any lock. It is
+         * called by emergencyFlush(), possibly from a signal handler.
+         * The default implementation visits nothing.
+         */
+        virtual void emergencyDump(EmergencyEventVisitor visitor, void * arg)
+            noexcept;
+
+        /**
+         * Enables or disables collection of AppenderMetrics. Counters
+         * are kept while metrics are disabled and continue when they
+         * are enabled again. Appending with disabled metrics costs one
+         * load of a pointer.
+         */
+        void setMetricsEnabled(bool enabled);
+
+        bool isMetricsEnabled() const;
+
+        /**
+         * Returns snapshot of metrics of this appender. Counters of an
+         * appender that has never had metrics enabled are all zero.
+         */
+        AppenderMetrics getMetrics() const;
+
     protected:
       // Methods
         /**
@@ -288,47 +458,166 @@ namespace log4cplus {
          */
         virtual void append(const log4cplus::spi::InternalLoggingEvent& event) = 0;
 
+        /**
+         * Subclasses of <code>Appender</code> can override this
+         * method to log a sequence of events more efficiently than
+         * one by one. The default implementation calls {@link
+         * #append} for each of the events.
+         * @see doAppendBatch method.
+         */
+        virtual void appendBatch(
+            std::span<log4cplus::spi::InternalLoggingEvent const> events);
+
+        //! Formats <code>event</code> into a per-thread string. While
+        //! a logger appends the event, appenders whose layouts have
+        //! the same Layout::getCacheKey() format it only once.
         tstring & formatEvent (const log4cplus::spi::InternalLoggingEvent& event) const;
 
+        //! Drops answers of hasConsumers() cached by loggers.
+        static void consumersChanged();
+
+        //! Appends formatted <code>event</code> to <code>output</code>,
+        //! so that appenders can format into their own buffers instead
+        //! of copying the per-thread string returned by the other
+        //! overload.
+        void formatEvent (const log4cplus::spi::InternalLoggingEvent& event,
+            tstring & output) const;
+
+        //! Appends all <code>events</code> formatted by
+        //! Layout::formatBatch() to <code>output</code>.
+        void formatEvents (
+            std::span<log4cplus::spi::InternalLoggingEvent const> events,
+            tstring & output) const;
+
+        //! Accounts event lost by the appender itself, e.g., because of
+        //! full queue, in AppenderMetrics::dropped.
+        void recordDroppedEvent();
+
       // Data
-        /** The layout variable does not need to be set if the appender
-         *  implementation has its own layout. */
-        std::unique_ptr<Layout> layout;
+        // Fields read by every append come first, in a cache line
+        // apart from the reference count and the mutex of SharedObject.
 
-        /** Appenders are named. */
-        log4cplus::tstring name;
+        /**
+         * There is no LogLevel threshold filtering by default. It is
+         * read without locking by doAppend() and by the append loop of
+         * AppenderAttachableImpl.
+         */
+        alignas (LOG4CPLUS_CACHE_LINE_SIZE) std::atomic<LogLevel> threshold;
+
+        /** Is this appender closed? */
+        bool closed;
+
+        //! Asynchronous append.
+        bool async;
+
+        //! Asynchronous append shares events with other appenders.
+        bool asyncFanOut;
+
+        //! Use lock file for inter-process synchronization of access
+        //! to log file.
+        bool useLockFile;
 
-        /** There is no LogLevel threshold filtering by default.  */
-        LogLevel threshold;
+        //! The appender synchronizes append() itself, so doAppend()
+        //! does not take access_mutex. Such appender checks that it
+        //! is open in append(); its filters must not be changed while
+        //! events are appended.
+        bool concurrentAppend;
+
+        //! append() only hands events over to other thread, so that
+        //! doAppend() lets fork() wait for it like for asynchronous
+        //! append, see AsyncAppender.
+        bool forkGate;
 
         /** The first filter in the filter chain. Set to <code>null</code>
          *  initially. */
         log4cplus::spi::FilterPtr filter;
 
+        //! <code>filter</code> compiled by setFilter().
+        log4cplus::spi::FilterProgram filterProgram;
+
+        //! Filters of a chain published by setFilter().
+        typedef std::vector<spi::FilterPtr> PreFilterChain;
+
+        //! Filters of <code>filter</code> as of the last setFilter(),
+        //! read by mayAppend() without <code>access_mutex</code>. Null
+        //! when there are no filters.
+        std::atomic<PreFilterChain const *> preFilterChain;
+
+        //! Chains published by setFilter(). Replaced ones are kept
+        //! until destruction because producers may still read them.
+        std::vector<std::unique_ptr<PreFilterChain const>> preFilterChains;
+
+        //! Counters of metrics, null when metrics are disabled.
+        std::atomic<internal::appender_metrics *> metrics;
+
+        //! Event fields combined from layout and filters, computed on
+        //! first use of getRequiredEventFields().
+        mutable std::atomic<unsigned> requiredEventFields;
+
+        /** The layout variable does not need to be set if the appender
+         *  implementation has its own layout. */
+        std::unique_ptr<Layout> layout;
+
+        /** Appenders are named. */
+        log4cplus::tstring name;
+
         /** It is assumed and enforced that errorHandler is never null. */
         std::unique_ptr<ErrorHandler> errorHandler;
 
         //! Optional system wide synchronization lock.
         std::unique_ptr<helpers::LockFile> lockFile;
 
-        //! Use lock file for inter-process synchronization of access
-        //! to log file.
-        bool useLockFile;
+        //! Maximal time in milliseconds the lock file is held while
+        //! a batch of events is appended, 0 for no limit.
+        unsigned long lockHoldTime;
+
+        //! Counters allocated by first setMetricsEnabled(true).
+        std::unique_ptr<internal::appender_metrics> metricsStorage;
 
-        //! Asynchronous append.
-        bool async;
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-        std::atomic<std::size_t> in_flight;
-        std::mutex in_flight_mutex;
-        std::condition_variable in_flight_condition;
+        //! Queue of events waiting for asynchronous append.
+        std::unique_ptr<internal::async_strand> asyncStrand;
+
+        //! Number of events being appended asynchronously. Waiters
+        //! block on it with std::atomic::wait(). Every asynchronous
+        //! append writes it, so it has a cache line of its own.
+        alignas (LOG4CPLUS_CACHE_LINE_SIZE) std::atomic<std::size_t> in_flight;
+        char in_flight_padding[LOG4CPLUS_CACHE_LINE_SIZE
+            - sizeof (std::atomic<std::size_t>)];
 #endif
 
-        /** Is this appender closed? */
-        bool closed;
-
     private:
+        //! Checks threshold and filters and appends the event. Accounts
+        //! outcome in <code>m</code> when it is not null.
+        void appendIfAccepted(
+            const log4cplus::spi::InternalLoggingEvent& event,
+            internal::appender_metrics * m);
+
+        //! Batch counterpart of appendIfAccepted().
+        void appendBatchIfAccepted(
+            std::span<log4cplus::spi::InternalLoggingEvent const> events,
+            internal::appender_metrics * m);
+
+        //! Checks the filter chain through <code>filterProgram</code>
+        //! unless <code>filter</code> has been replaced without
+        //! setFilter().
+        log4cplus::spi::FilterResult checkFilters(
+            const log4cplus::spi::InternalLoggingEvent& event) const
+        {
+            return filterProgram.getChain () == filter.get ()
+                ? filterProgram.check (event)
+                : spi::checkFilter (filter.get (), event);
+        }
+
+        //! Appends events returned by spi::Filter::takeSummary() of the
+        //! filter chain for <code>event</code>.
+        void appendFilterSummaries(
+            const log4cplus::spi::InternalLoggingEvent& event);
+
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-        void subtract_in_flight();
+        void subtract_in_flight(std::size_t count = 1);
+
+        friend class internal::async_strand;
 #endif
     };
 
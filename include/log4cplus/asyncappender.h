@@ -48,17 +48,110 @@
 #include <log4cplus/appender.h>
 #include <log4cplus/thread/threads.h>
 #include <log4cplus/helpers/appenderattachableimpl.h>
+#include <atomic>
+#include <functional>
+#include <vector>
 
 
 namespace log4cplus
 {
 
+namespace internal
+{
+
+struct async_appender_registry;
+
+} // namespace internal
+
 
 /**
    This `Appender` is a wrapper to which other appenders can be attached. The
    attached appendres are then appended to from a separate thread which reads
    events appended to this appender from a queue.
 
+   <h3>Properties</h3>
+   <dl>
+
+   <dt><tt>Appender</tt></dt>
+   <dd>Name of the factory of the attached appender. Its properties
+   are under the <tt>Appender.</tt> subkey.</dd>
+
+   <dt><tt>QueueLimit</tt></dt>
+   <dd>Maximal length of the events queue. Default is 100, or 1024
+   when <tt>QueueMaxBytes</tt> is set.</dd>
+
+   <dt><tt>QueueMaxBytes</tt></dt>
+   <dd>Maximal approximate footprint of queued events, in bytes,
+   counting their messages, NDC and MDC. Suffixes "KB" and "MB" are
+   recognized. An event that does not fit is handled according to
+   <tt>OverflowPolicy</tt> like an event that does not fit into full
+   queue. Default is 0, no limit.</dd>
+
+   <dt><tt>OverflowPolicy</tt></dt>
+   <dd>What to do with events which do not fit into the full queue.
+   <tt>Block</tt> (default) blocks the logging thread until there is
+   room in the queue. <tt>DropNewest</tt> drops the event being
+   logged. <tt>DropOldest</tt> drops the oldest queued event to make
+   room for the new one. <tt>DropBelowLevel</tt> drops the event
+   being logged if its log level is below <tt>OverflowLogLevel</tt>
+   and blocks otherwise.</dd>
+
+   <dt><tt>OverflowLogLevel</tt></dt>
+   <dd>Log level threshold used by the <tt>DropBelowLevel</tt>
+   policy. Default is <tt>WARN</tt>.</dd>
+
+   <dt><tt>ReportDroppedEvents</tt></dt>
+   <dd>When set to <tt>true</tt>, a warning event with the count of
+   dropped events is appended to the attached appenders once the
+   queue backlog clears. Default is <tt>false</tt>.</dd>
+
+   <dt><tt>QueueHighWaterMark</tt></dt>
+   <dd>Queue depth at which a warning is printed through LogLog,
+   unless a callback is set by setHighWaterCallback(). The warning is
+   repeated only after the queue gets below the mark again. Default
+   is 0, no warning.</dd>
+
+   <dt><tt>Lanes.1.Threshold</tt>, <tt>Lanes.2.Threshold</tt>, ...</dt>
+   <dd>Log levels of lanes of the queue. An event goes into the lane
+   of the highest threshold it meets, or into the main queue if it
+   meets none. The queue thread takes events of the lanes, the highest
+   threshold first, before events of the main queue, so, e.g., a
+   <tt>FATAL</tt> event does not wait behind a backlog of
+   <tt>DEBUG</tt> events. Order of events is kept within each lane
+   only. Each lane has its own <tt>QueueLimit</tt> (default 100),
+   <tt>QueueMaxBytes</tt>, <tt>OverflowPolicy</tt> and
+   <tt>OverflowLogLevel</tt> under the same subkey, e.g.,
+   <tt>Lanes.1.QueueLimit</tt>.</dd>
+
+   <dt><tt>ConsumerThreads</tt></dt>
+   <dd>Number of queue threads appending events to the attached
+   appenders. Each of them has its own queue, with its own
+   <tt>QueueLimit</tt>, <tt>QueueMaxBytes</tt> and lanes, and events
+   are hashed onto them by <tt>ConsumerKey</tt>, so that order of
+   events of the same key is kept. The threads run appends in
+   parallel only if the attached appenders do not serialize them,
+   e.g., ThreadShardedAppender. Default is 1, or one per NUMA node
+   with <tt>ConsumerKey=Node</tt>.</dd>
+
+   <dt><tt>ConsumerKey</tt></dt>
+   <dd>What events are hashed by when there are more
+   <tt>ConsumerThreads</tt>: <tt>Logger</tt> (default) for logger
+   name, <tt>Thread</tt> for thread name, <tt>MDC</tt> for value of
+   MDC key <tt>ConsumerMDCKey</tt>, or <tt>Node</tt> for NUMA node
+   of the CPU the logging thread runs on. With <tt>Node</tt>, each
+   queue thread is restricted to CPUs of its node, so that queues are
+   not shared across sockets; order of events is kept per node, and
+   per logging thread as long as it stays on its node. Use
+   <tt>SequenceKey</tt> to restore global order.</dd>
+
+   <dt><tt>SequenceKey</tt></dt>
+   <dd>When set, each queued event gets key/value field of this name
+   holding a number that increases in the order in which the events
+   have been queued, across all lanes, so that output can be put back
+   in order.</dd>
+
+   </dl>
+
    \sa helpers::AppenderAttachableImpl
  */
 class LOG4CPLUS_EXPORT AsyncAppender
@@ -66,23 +159,200 @@ class LOG4CPLUS_EXPORT AsyncAppender
     , public helpers::AppenderAttachableImpl
 {
 public:
+    //! Policy for events that do not fit into full queue.
+    enum OverflowPolicy
+    {
+        //! Block the logging thread until there is room in the queue.
+        BLOCK,
+
+        //! Drop the event being logged.
+        DROP_NEWEST,
+
+        //! Drop the oldest queued event.
+        DROP_OLDEST,
+
+        //! Drop the event being logged if its log level is below
+        //! overflow log level, block otherwise.
+        DROP_BELOW_LEVEL
+    };
+
+    //! What events are hashed by onto queue threads, see
+    //! <tt>ConsumerKey</tt>.
+    enum ConsumerKey
+    {
+        CONSUMER_KEY_LOGGER,
+        CONSUMER_KEY_THREAD,
+        CONSUMER_KEY_MDC,
+        //! NUMA node of the logging thread's CPU.
+        CONSUMER_KEY_NODE
+    };
+
+    //! Lane of the events queue, see <tt>Lanes</tt>.
+    struct Lane
+    {
+        //! Events of this log level and above go into the lane.
+        LogLevel threshold = ERROR_LOG_LEVEL;
+
+        //! Maximal length of the lane.
+        unsigned queueLimit = 100;
+
+        //! Maximal approximate footprint of queued events, zero if
+        //! unlimited.
+        std::size_t maxBytes = 0;
+
+        OverflowPolicy overflowPolicy = BLOCK;
+        LogLevel overflowLogLevel = WARN_LOG_LEVEL;
+    };
+
     AsyncAppender (SharedAppenderPtr const & app, unsigned max_len);
     AsyncAppender (helpers::Properties const &);
     virtual ~AsyncAppender ();
 
     virtual void close ();
 
+    virtual bool isAsynchronous () const;
+
+    //! Returns fields required by the attached appenders.
+    virtual unsigned getRequiredEventFields () const;
+
+    //! Visits events waiting in the queue. Events already taken by
+    //! the queue thread are not visited.
+    virtual void emergencyDump (EmergencyEventVisitor visitor, void * arg)
+        noexcept;
+
+    //! Sets overflow policy. It should be set before the appender
+    //! is used for logging.
+    //!
+    //! \param policy Overflow policy.
+    //! \param ll Log level threshold used by DROP_BELOW_LEVEL policy.
+    void setOverflowPolicy (OverflowPolicy policy,
+        LogLevel ll = WARN_LOG_LEVEL);
+
+    //! \return Current overflow policy.
+    OverflowPolicy getOverflowPolicy () const;
+
+    //! Enables or disables reporting of dropped events.
+    void setReportDroppedEvents (bool report);
+
+    //! \return Total number of events dropped because of full queue.
+    std::size_t getDroppedEventsCount () const;
+
+    //! Appends event with count of dropped events, if there are any
+    //! not yet reported. Called by the queue thread.
+    void reportDroppedEvents ();
+
+    //! \return Statistics of the events queue, see
+    //! thread::Queue::get_stats(). With more queue threads, counters
+    //! of their queues are summed, except for maximums and ages.
+    thread::QueueStats getQueueStats () const;
+
+    //! Sets callback called by the logging thread whose event raises
+    //! depth of the queue to <code>highWater</code>, see
+    //! thread::Queue::set_high_water_callback(). It can be used to
+    //! shed load, e.g., by raising log levels, before producers
+    //! stall. Zero <code>highWater</code> disables the callback.
+    void setHighWaterCallback (std::size_t highWater,
+        thread::HighWaterCallback callback);
+
+    //! Replaces the events queue by one of maximal length
+    //! <code>len</code>, see <tt>QueueLimit</tt>. Events already
+    //! queued are appended first; logging threads wait meanwhile.
+    //! \return <code>false</code> if the appender is closed or has
+    //! fallen back to synchronous operation.
+    bool setQueueLimit (unsigned len);
+
+    //! Adds <code>lane</code> to the events queue, replacing the
+    //! queue like setQueueLimit(). Events go into the first lane,
+    //! in the order of addition, whose threshold they meet, and
+    //! lanes are drained in that order, so they should be added
+    //! from the highest threshold.
+    //! \return <code>false</code> if the appender is closed or has
+    //! fallen back to synchronous operation.
+    bool addLane (Lane const & lane);
+
+    //! \return Statistics of lane with index <code>i</code>.
+    thread::QueueStats getLaneStats (std::size_t i) const;
+
+    //! Sets <tt>ConsumerThreads</tt> to <code>count</code>, replacing
+    //! the events queue like setQueueLimit().
+    //!
+    //! \param count Number of queue threads. Zero stands for one
+    //! thread, or one per NUMA node with CONSUMER_KEY_NODE.
+    //! \param key What events are hashed by onto the threads.
+    //! \param mdcKey MDC key used with CONSUMER_KEY_MDC.
+    bool setConsumerThreads (unsigned count,
+        ConsumerKey key = CONSUMER_KEY_LOGGER,
+        tstring const & mdcKey = tstring ());
+
+    //! Sets <tt>SequenceKey</tt>, replacing the events queue like
+    //! setQueueLimit().
+    bool setSequenceKey (tstring const & key);
+
+    //! Limits approximate footprint of queued events to
+    //! <code>bytes</code>, see <tt>QueueMaxBytes</tt> and
+    //! thread::Queue::set_max_bytes(). Zero removes the limit.
+    void setQueueMaxBytes (std::size_t bytes);
+
 protected:
     virtual void append (spi::InternalLoggingEvent const &);
 
     void init_queue_thread (unsigned);
 
-    thread::AbstractThreadPtr queue_thread;
-    thread::QueuePtr queue;
+    //! Replaces the events queues by the one made by
+    //! <code>make</code> from the first current one and its clones and
+    //! starts new queue threads for them.
+    bool replace_queue (
+        std::function<thread::Queue * (thread::Queue const &)> const & make);
+
+    //! Accounts one dropped event.
+    void event_dropped ();
+
+    //! Creates queue thread for queue with index <code>index</code>.
+    thread::AbstractThreadPtr make_queue_thread (
+        thread::QueuePtr const & queue, std::size_t index);
+
+    //! \return Index of queue of <code>ev</code>.
+    std::size_t consumer_index (spi::InternalLoggingEvent const & ev) const;
+
+    //! Queue threads, one for each queue in <code>queues</code>.
+    std::vector<thread::AbstractThreadPtr> queue_threads;
+    std::vector<thread::QueuePtr> queues;
+
+    //! Number of queue threads.
+    unsigned consumerThreads;
+
+    //! What events are hashed by onto the queue threads.
+    ConsumerKey consumerKey;
+
+    //! MDC key for CONSUMER_KEY_MDC.
+    tstring consumerMDCKey;
+
+    //! Overflow policy.
+    OverflowPolicy overflowPolicy;
+
+    //! Log level threshold for DROP_BELOW_LEVEL policy.
+    LogLevel overflowLogLevel;
+
+    //! Report dropped events summary.
+    bool reportDropped;
+
+    //! Lanes of the events queue, in the order of the queue's lanes.
+    std::vector<Lane> lanes;
+
+    //! Key of sequence field, empty if events are not stamped.
+    tstring sequenceKey;
+
+    //! Total number of dropped events.
+    std::atomic<std::size_t> droppedEvents;
+
+    //! Number of dropped events not yet reported.
+    std::atomic<std::size_t> unreportedDroppedEvents;
 
 private:
     AsyncAppender (AsyncAppender const &);
     AsyncAppender & operator = (AsyncAppender const &);
+
+    friend struct internal::async_appender_registry;
 };
 
 
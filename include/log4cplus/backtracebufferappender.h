@@ -0,0 +1,141 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    backtracebufferappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+/** @file */
+
+#ifndef LOG4CPLUS_BACKTRACE_BUFFER_APPENDER_HEADER_
+#define LOG4CPLUS_BACKTRACE_BUFFER_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/appender.h>
+#include <log4cplus/helpers/appenderattachableimpl.h>
+#include <memory>
+
+
+namespace log4cplus
+{
+
+/**
+ * Keeps the last events of each thread, or of each value of an MDC
+ * entry such as a request id, and passes them to the attached
+ * appenders only when an event of <tt>TriggerLevel</tt> or above
+ * arrives. So, e.g., DEBUG events give context to an ERROR without
+ * being written when nothing goes wrong.
+ *
+ * Events are captured into preallocated slots whose storage is reused
+ * by later events; they are not formatted until they are passed on.
+ * The trigger event is passed on after the buffered ones, and the
+ * buffer is emptied. Events in buffers are lost when the appender is
+ * closed, unless flushBuffers() is called.
+ *
+ * Loggers have to be enabled for the buffered levels; the threshold of
+ * the attached appenders should let them through.
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>BufferSize</tt></dt>
+ * <dd>Number of events kept per thread or MDC value. Defaults to
+ * 100.</dd>
+ *
+ * <dt><tt>TriggerLevel</tt></dt>
+ * <dd>Log level of events that pass on the buffer. Defaults to
+ * <tt>ERROR</tt>.</dd>
+ *
+ * <dt><tt>MDCKey</tt></dt>
+ * <dd>Name of the MDC entry whose value selects the buffer. Events
+ * without the entry, and all events when it is not set, use the
+ * buffer of their thread.</dd>
+ *
+ * <dt><tt>MaxBuffers</tt></dt>
+ * <dd>Maximal number of buffers; the least recently used one is
+ * dropped to make room for a new one. Defaults to 256.</dd>
+ *
+ * <dt><tt>Appender</tt></dt>
+ * <dd>Name of the factory of the attached appender. Its properties
+ * are under the <tt>Appender.</tt> subkey.</dd>
+ * </dl>
+ *
+ * \sa helpers::AppenderAttachableImpl
+ */
+class LOG4CPLUS_EXPORT BacktraceBufferAppender
+    : public Appender
+    , public helpers::AppenderAttachableImpl
+{
+public:
+    BacktraceBufferAppender (SharedAppenderPtr const & app,
+        std::size_t bufferSize = 100,
+        LogLevel triggerLevel = ERROR_LOG_LEVEL);
+    BacktraceBufferAppender (helpers::Properties const & properties);
+    virtual ~BacktraceBufferAppender ();
+
+    virtual void close ();
+
+    //! Returns fields required by the attached appenders.
+    virtual unsigned getRequiredEventFields () const;
+
+    //! Passes events of all buffers to the attached appenders, buffer
+    //! by buffer, and empties the buffers.
+    void flushBuffers ();
+
+    //! \return Number of buffered events.
+    std::size_t getBufferedCount () const;
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+
+    std::size_t bufferSize;
+    LogLevel triggerLevel;
+    tstring mdcKey;
+    std::size_t maxBuffers;
+
+private:
+    struct Buffers;
+
+    void init ();
+
+    std::unique_ptr<Buffers> buffers;
+
+    BacktraceBufferAppender (BacktraceBufferAppender const &);
+    BacktraceBufferAppender & operator = (BacktraceBufferAppender const &);
+};
+
+
+typedef helpers::SharedObjectPtr<BacktraceBufferAppender>
+    BacktraceBufferAppenderPtr;
+
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_BACKTRACE_BUFFER_APPENDER_HEADER_
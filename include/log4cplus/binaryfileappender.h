@@ -0,0 +1,107 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    binaryfileappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_BINARY_FILE_APPENDER_HEADER_
+#define LOG4CPLUS_BINARY_FILE_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/appender.h>
+#include <log4cplus/binarylog.h>
+#include <fstream>
+
+
+namespace log4cplus
+{
+
+/**
+ * Writes events into a file as compact binary records, see
+ * BinaryLogWriter. Events logged through LOG4CPLUS_BINLOG_* macros are
+ * stored without formatting their messages. Layout is not used. The
+ * files can be turned into text with log4cplus-decode tool.
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>File</tt></dt>
+ * <dd>This property specifies output file name.</dd>
+ *
+ * <dt><tt>ImmediateFlush</tt></dt>
+ * <dd>When it is set true, output stream will be flushed after
+ * each appended event.</dd>
+ *
+ * <dt><tt>Append</tt></dt>
+ * <dd>When it is set true, output file will be appended to
+ * instead of being truncated at opening.</dd>
+ *
+ * <dt><tt>CreateDirs</tt></dt>
+ * <dd>Set this property to <tt>true</tt> if you want to create
+ * missing directories in path leading to log file.</dd>
+ * </dl>
+ */
+class LOG4CPLUS_EXPORT BinaryFileAppender
+    : public Appender
+{
+public:
+    BinaryFileAppender (tstring const & filename,
+        std::ios_base::openmode mode = std::ios_base::trunc,
+        bool immediateFlush = true, bool createDirs = false);
+    BinaryFileAppender (helpers::Properties const & properties);
+    virtual ~BinaryFileAppender ();
+
+    virtual void close ();
+
+    //! Events are written whole, all fields are required.
+    virtual unsigned getRequiredEventFields () const;
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+
+    void open ();
+
+    bool immediateFlush;
+    bool createDirs;
+    tstring filename;
+    std::ios_base::openmode fileOpenMode;
+    std::ofstream out;
+    BinaryLogWriter writer;
+
+private:
+    BinaryFileAppender (BinaryFileAppender const &);
+    BinaryFileAppender & operator = (BinaryFileAppender const &);
+};
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_BINARY_FILE_APPENDER_HEADER_
@@ -0,0 +1,343 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    binarylog.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file
+ * This header defines binary structured logging: call sites register
+ * their format string once and events carry only packed arguments
+ * which are turned into text when the message is needed or offline by
+ * BinaryLogReader. */
+
+#ifndef LOG4CPLUS_BINARY_LOG_HEADER_
+#define LOG4CPLUS_BINARY_LOG_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/loggingmacros.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+
+namespace log4cplus
+{
+
+//! Types of arguments stored in binary log records.
+enum BinaryLogArgType : unsigned char
+{
+    BINLOG_ARG_BOOL = 1,
+    BINLOG_ARG_CHAR,
+    BINLOG_ARG_INT,
+    BINLOG_ARG_UINT,
+    BINLOG_ARG_DOUBLE,
+    BINLOG_ARG_STRING,
+    BINLOG_ARG_POINTER
+};
+
+
+/**
+ * Call site of one of LOG4CPLUS_BINLOG_* macros. Each site gets process
+ * wide unique identifier when it is first executed. The format string
+ * uses <code>{}</code> as argument placeholders, <code>{{</code> and
+ * <code>}}</code> produce literal braces.
+ */
+class LOG4CPLUS_EXPORT BinaryLogSite
+{
+public:
+    BinaryLogSite (tchar const * format, char const * file, int line,
+        char const * function);
+
+    BinaryLogSite (BinaryLogSite const &) = delete;
+    BinaryLogSite & operator = (BinaryLogSite const &) = delete;
+
+    //! \return Identifier of this site. It is never zero.
+    unsigned getId () const { return id; }
+
+    tstring_view getFormat () const { return format; }
+    char const * getFile () const { return file; }
+    int getLine () const { return line; }
+    char const * getFunction () const { return function; }
+
+private:
+    tstring_view format;
+    char const * file;
+    int line;
+    char const * function;
+    unsigned id;
+};
+
+
+/**
+ * Message of binary log event. It holds arguments packed in their
+ * binary form and formats them only when text is needed.
+ */
+class LOG4CPLUS_EXPORT BinaryLogMessage final
+    : public spi::DeferredMessage
+{
+public:
+    explicit BinaryLogMessage (BinaryLogSite const & site);
+    virtual ~BinaryLogMessage ();
+
+    void format (tstring & message) const override;
+
+    BinaryLogSite const & getSite () const { return site; }
+
+    //! \return Packed arguments.
+    std::string const & getArguments () const { return args; }
+
+    //! Packs argument. Supported are integral, enumeration, floating
+    //! point and pointer types and whatever converts to tstring_view.
+    template <typename T>
+    void addArgument (T const & value);
+
+    void addUInt (BinaryLogArgType type, std::uint64_t value);
+    void addInt (std::int64_t value);
+    void addDouble (double value);
+    void addString (tstring_view const & value);
+
+private:
+    BinaryLogSite const & site;
+    std::string args;
+};
+
+
+template <typename T>
+void
+BinaryLogMessage::addArgument (T const & value)
+{
+    if constexpr (std::is_same_v<T, bool>)
+        addUInt (BINLOG_ARG_BOOL, value);
+    else if constexpr (std::is_same_v<T, tchar>)
+        addUInt (BINLOG_ARG_CHAR,
+            static_cast<std::make_unsigned_t<tchar>> (value));
+    else if constexpr (std::is_enum_v<T>)
+        addArgument (static_cast<std::underlying_type_t<T>> (value));
+    else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+        addInt (value);
+    else if constexpr (std::is_integral_v<T>)
+        addUInt (BINLOG_ARG_UINT, value);
+    else if constexpr (std::is_floating_point_v<T>)
+        addDouble (static_cast<double> (value));
+    else if constexpr (std::is_convertible_v<T const &, tstring_view>)
+        addString (tstring_view (value));
+    else if constexpr (std::is_pointer_v<T>)
+        addUInt (BINLOG_ARG_POINTER,
+            reinterpret_cast<std::uintptr_t> (value));
+    else
+        static_assert (sizeof (T) == 0,
+            "unsupported binary log argument type");
+}
+
+
+//! Formats packed arguments using format string of BinaryLogSite
+//! syntax and appends the result to <code>message</code>. Placeholders
+//! without argument are copied verbatim, extra arguments are ignored.
+LOG4CPLUS_EXPORT void formatBinaryLogMessage (tstring & message,
+    tstring_view const & format, std::string_view const & args);
+
+
+/**
+ * Encodes events into binary log records. Each record starts with its
+ * type and size. Call site definitions and logger and thread names are
+ * written only once, before the first event that refers to them.
+ * Events without BinaryLogMessage are recorded with their formatted
+ * message. Key/value fields are recorded in their binary form, in a
+ * record preceding the event, and so is sequence number of the event,
+ * if it has one. NDC and MDC are not recorded.
+ */
+class LOG4CPLUS_EXPORT BinaryLogWriter
+{
+public:
+    explicit BinaryLogWriter (std::ostream & out);
+    ~BinaryLogWriter ();
+
+    //! Writes header and forgets all written definitions. It has to
+    //! be called at the start of the output.
+    void writeHeader ();
+
+    void write (spi::InternalLoggingEvent const & event);
+
+private:
+    LOG4CPLUS_PRIVATE unsigned nameId (tstring const & name);
+    LOG4CPLUS_PRIVATE void writeRecord (unsigned char type);
+
+    std::ostream & out;
+    std::vector<bool> writtenSites;
+    std::unordered_map<tstring, unsigned> names;
+    std::string payload;
+    std::string record;
+};
+
+
+/**
+ * Decodes records written by BinaryLogWriter back into events with
+ * formatted messages. Malformed input is reported by throwing
+ * std::runtime_error.
+ */
+class LOG4CPLUS_EXPORT BinaryLogReader
+{
+public:
+    explicit BinaryLogReader (std::istream & in);
+    ~BinaryLogReader ();
+
+    //! Reads next event.
+    //! \return <code>false</code> at the end of the input.
+    bool read (spi::InternalLoggingEvent & event);
+
+private:
+    struct Site
+    {
+        tstring format;
+        tstring file;
+        int line;
+        tstring function;
+    };
+
+    std::istream & in;
+    std::unordered_map<std::uint64_t, Site> sites;
+    std::unordered_map<std::uint64_t, tstring> names;
+    //! Key/value fields of the next event.
+    spi::KeyValues keyValues;
+    //! Sequence number of the next event, 0 if it has none.
+    std::uint64_t sequence;
+    std::string payload;
+    bool headerSeen;
+};
+
+
+namespace detail
+{
+
+template <typename... Args>
+void
+macro_binlog (log4cplus::LoggerRef const & logger,
+    log4cplus::LogLevel log_level, BinaryLogSite const & site,
+    Args const &... args)
+{
+    auto msg = std::make_shared<BinaryLogMessage> (site);
+    (msg->addArgument (args), ...);
+    macro_forced_log (logger, log_level, std::move (msg), site.getFile (),
+        site.getLine (), site.getFunction ());
+}
+
+} // namespace detail
+
+} // namespace log4cplus
+
+
+#define LOG4CPLUS_MACRO_BINLOG_BODY(logger, logLevel, logFmt, ...)      \
+    LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
+    do {                                                                \
+        if constexpr (log4cplus::detail::macro_level_enabled (          \
+                log4cplus::logLevel, LOG4CPLUS_COMPILE_TIME_MIN_LEVEL,  \
+                log4cplus_compile_time_min_level)) {                    \
+            auto const & _l                                             \
+                = log4cplus::detail::macros_get_logger (logger);        \
+            if (LOG4CPLUS_MACRO_LOGLEVEL_PRED (                         \
+                    _l.isEnabledFor (log4cplus::logLevel),              \
+                    logLevel)) {                                        \
+                LOG4CPLUS_MACRO_LOG_LOCATION (_logLocation);            \
+                static log4cplus::BinaryLogSite const _binlogSite (     \
+                    logFmt, _logLocation.file_name (),                  \
+                    _logLocation.line (),                               \
+                    _logLocation.function_name ());                     \
+                log4cplus::detail::macro_binlog (_l,                    \
+                    log4cplus::logLevel, _binlogSite                    \
+                    __VA_OPT__(,) __VA_ARGS__);                         \
+            }                                                           \
+        }                                                               \
+    } while (false)                                                     \
+    LOG4CPLUS_RESTORE_DOWHILE_WARNING()
+
+/**
+ * @def LOG4CPLUS_BINLOG_INFO(logger, logFmt, ...) These macros log
+ * binary structured events. <code>logFmt</code> has to be a string
+ * literal using <code>{}</code> placeholders, the arguments are packed
+ * in binary form. Use with BinaryFileAppender and decode the files
+ * with log4cplus-decode.
+ */
+#if !defined(LOG4CPLUS_DISABLE_TRACE)
+#define LOG4CPLUS_BINLOG_TRACE(logger, logFmt, ...)                     \
+    LOG4CPLUS_MACRO_BINLOG_BODY (logger, TRACE_LOG_LEVEL, logFmt        \
+        __VA_OPT__(,) __VA_ARGS__)
+#else
+#define LOG4CPLUS_BINLOG_TRACE(logger, logFmt, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_DEBUG)
+#define LOG4CPLUS_BINLOG_DEBUG(logger, logFmt, ...)                     \
+    LOG4CPLUS_MACRO_BINLOG_BODY (logger, DEBUG_LOG_LEVEL, logFmt        \
+        __VA_OPT__(,) __VA_ARGS__)
+#else
+#define LOG4CPLUS_BINLOG_DEBUG(logger, logFmt, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_INFO)
+#define LOG4CPLUS_BINLOG_INFO(logger, logFmt, ...)                      \
+    LOG4CPLUS_MACRO_BINLOG_BODY (logger, INFO_LOG_LEVEL, logFmt         \
+        __VA_OPT__(,) __VA_ARGS__)
+#else
+#define LOG4CPLUS_BINLOG_INFO(logger, logFmt, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_WARN)
+#define LOG4CPLUS_BINLOG_WARN(logger, logFmt, ...)                      \
+    LOG4CPLUS_MACRO_BINLOG_BODY (logger, WARN_LOG_LEVEL, logFmt         \
+        __VA_OPT__(,) __VA_ARGS__)
+#else
+#define LOG4CPLUS_BINLOG_WARN(logger, logFmt, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_ERROR)
+#define LOG4CPLUS_BINLOG_ERROR(logger, logFmt, ...)                     \
+    LOG4CPLUS_MACRO_BINLOG_BODY (logger, ERROR_LOG_LEVEL, logFmt        \
+        __VA_OPT__(,) __VA_ARGS__)
+#else
+#define LOG4CPLUS_BINLOG_ERROR(logger, logFmt, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_FATAL)
+#define LOG4CPLUS_BINLOG_FATAL(logger, logFmt, ...)                     \
+    LOG4CPLUS_MACRO_BINLOG_BODY (logger, FATAL_LOG_LEVEL, logFmt        \
+        __VA_OPT__(,) __VA_ARGS__)
+#else
+#define LOG4CPLUS_BINLOG_FATAL(logger, logFmt, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+
+#endif // LOG4CPLUS_BINARY_LOG_HEADER_
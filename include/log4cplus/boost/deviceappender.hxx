@@ -36,6 +36,12 @@
 #include <boost/iostreams/operations.hpp>
 #include <boost/shared_ptr.hpp>
 #include <log4cplus/appender.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/tstring.h>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
 
 
 namespace log4cplus
@@ -74,9 +80,39 @@ struct device_type_traits<boost::shared_ptr<T> >
 };
 
 
+//! Devices with member <code>write_buffers()</code> accepting a span
+//! of string views are given the events of a batch as a buffer
+//! sequence, one buffer per event, instead of a single write.
+template <typename T>
+concept buffer_sequence_device = requires (T & d,
+    std::span<tstring_view const> buffers)
+{
+    d.write_buffers (buffers);
+};
+
+
 } // namespace device_appender_detail
 
 
+/**
+ * Writes formatted events into a Boost.Iostreams sink device.
+ *
+ * Batches of events, e.g., from AsyncAppender, are formatted into one
+ * buffer which is written by a single <code>write</code>. Devices
+ * satisfying <code>device_appender_detail::buffer_sequence_device</code>
+ * receive the events of the buffer as a sequence of buffers, so they
+ * can tell the events apart without copying them again.
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>CloseDevice</tt></dt>
+ * <dd>When present, the device is closed when the appender is.</dd>
+ *
+ * <dt><tt>BatchSize</tt></dt>
+ * <dd>Size of the buffer, in characters, after which a batch is
+ * written in several parts. Defaults to 64 KiB.</dd>
+ * </dl>
+ */
 template <typename Device>
 class DeviceAppender
     : public Appender
@@ -89,12 +125,14 @@ public:
     DeviceAppender (D & d, bool close_device = true)
         : device (d)
         , close_flag (close_device)
+        , batch_size (64 * 1024)
     { }
 
     template <typename D>
     DeviceAppender (boost::shared_ptr<D> const & d, bool close_device = true)
         : device (d)
         , close_flag (close_device)
+        , batch_size (64 * 1024)
     { }
 
     template <typename D>
@@ -102,10 +140,7 @@ public:
         : Appender (props)
         , device (d)
     {
-        if (props.exists (LOG4CPLUS_TEXT ("CloseDevice")))
-            close_flag = true;
-        else
-            close_flag = false;
+        init (props);
     }
 
     template <typename D>
@@ -114,10 +149,7 @@ public:
         : Appender (props)
         , device (d)
     {
-        if (props.exists (LOG4CPLUS_TEXT ("CloseDevice")))
-            close_flag = true;
-        else
-            close_flag = false;
+        init (props);
     }
 
     virtual
@@ -142,10 +174,77 @@ protected:
             str.c_str (), str.size ());
     }
 
+    virtual
+    void
+    appendBatch (std::span<log4cplus::spi::InternalLoggingEvent const> events)
+    {
+        for (auto const & event : events)
+        {
+            boundaries.push_back (batch.size ());
+            formatEvent (event, batch);
+            if (batch.size () >= batch_size)
+                writeBatch ();
+        }
+
+        if (! batch.empty ())
+            writeBatch ();
+    }
+
+    //! Writes events collected in <code>batch</code>.
+    void
+    writeBatch ()
+    {
+        auto & dev = device_traits::unwrap (device);
+        typedef std::remove_cvref_t<decltype (dev)> device_value_type;
+
+        if constexpr (device_appender_detail::buffer_sequence_device<
+            device_value_type>)
+        {
+            boundaries.push_back (batch.size ());
+            buffers.clear ();
+            for (std::size_t i = 0; i + 1 < boundaries.size (); ++i)
+                buffers.emplace_back (batch.data () + boundaries[i],
+                    boundaries[i + 1] - boundaries[i]);
+
+            dev.write_buffers (std::span<tstring_view const> (buffers));
+        }
+        else
+            boost::iostreams::write (dev, batch.data (),
+                static_cast<std::streamsize> (batch.size ()));
+
+        batch.clear ();
+        boundaries.clear ();
+    }
+
     device_type device;
     bool close_flag;
 
+    //! Characters after which a batch is written in several parts.
+    std::size_t batch_size;
+
+    //! Formatted events of the batch being written.
+    tstring batch;
+
+    //! Offsets of the events in <code>batch</code>.
+    std::vector<std::size_t> boundaries;
+
+    //! Buffer sequence passed to <code>write_buffers()</code>.
+    std::vector<tstring_view> buffers;
+
 private:
+    void
+    init (const helpers::Properties & props)
+    {
+        if (props.exists (LOG4CPLUS_TEXT ("CloseDevice")))
+            close_flag = true;
+        else
+            close_flag = false;
+
+        unsigned long size = 64 * 1024;
+        props.getULong (size, LOG4CPLUS_TEXT ("BatchSize"));
+        batch_size = size;
+    }
+
     DeviceAppender (DeviceAppender const &);
     DeviceAppender & operator = (DeviceAppender const &);
 };
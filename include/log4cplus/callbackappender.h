@@ -36,32 +36,87 @@
 
 #include <log4cplus/appender.h>
 #include <log4cplus/clogger.h>
+#include <cstddef>
+#include <span>
+#include <vector>
 
 
 namespace log4cplus {
 
 /**
 * Send log events to a C function callback.
+*
+* Instead of calling the callback for every event, the appender can
+* collect events and pass them in arrays of log4cplus_event_view_t to a
+* batch callback, see setBatchCallback(). Events appended in batches,
+* e.g., by the asynchronous append queue, are passed without being
+* copied.
+*
+* <h3>Properties</h3>
+* <dl>
+* <dt><tt>BatchSize</tt></dt>
+* <dd>Maximum number of events passed to the batch callback at once.
+* Default is 64.</dd>
+*
+* <dt><tt>BatchIntervalMs</tt></dt>
+* <dd>Partial batch is passed at least this often, in milliseconds.
+* Default is 0, no timer; events are then passed as they come, in
+* arrays of the batches they are appended in, and events appended one
+* by one are passed one by one.</dd>
+* </dl>
 */
 class LOG4CPLUS_EXPORT CallbackAppender
     : public Appender {
 public:
     CallbackAppender();
     CallbackAppender(log4cplus_log_event_callback_t callback, void * cookie);
+    CallbackAppender(log4cplus_log_event_batch_callback_t callback,
+        void * cookie, std::size_t batchSize,
+        unsigned long batchIntervalMs = 0);
     CallbackAppender(const log4cplus::helpers::Properties&);
 
     virtual ~CallbackAppender();
     virtual void close();
 
+    //! The callback receives all fields of events.
+    virtual unsigned getRequiredEventFields() const;
+
     void setCookie(void *);
     void setCallback(log4cplus_log_event_callback_t);
 
+    //! Sets callback receiving arrays of events. It replaces callback
+    //! set by setCallback().
+    void setBatchCallback(log4cplus_log_event_batch_callback_t);
+
 protected:
     virtual void append(const log4cplus::spi::InternalLoggingEvent& event);
+    virtual void appendBatch(
+        std::span<log4cplus::spi::InternalLoggingEvent const> events);
 
 private:
-    log4cplus_log_event_callback_t callback;
-    void * cookie;
+    //! Passes <code>events</code> to the batch callback.
+    void deliver(std::span<log4cplus::spi::InternalLoggingEvent const> events);
+
+    //! Passes collected events, if any, to the batch callback.
+    void flushPending();
+
+    void startTimer();
+
+    log4cplus_log_event_callback_t callback = nullptr;
+    log4cplus_log_event_batch_callback_t batchCallback = nullptr;
+    void * cookie = nullptr;
+
+    std::size_t batchSize = 64;
+    unsigned long batchInterval = 0;
+    bool batchTimerRegistered = false;
+
+    //! Copies of events collected for the next batch. Only the first
+    //! <code>pendingCount</code> are valid, the rest keep their storage.
+    std::vector<log4cplus::spi::InternalLoggingEvent> pending;
+    std::size_t pendingCount = 0;
+
+    //! Views passed to the batch callback, reused between batches.
+    std::vector<log4cplus_event_view_t> views;
 
     // Disallow copying of instances of this class
     CallbackAppender(const CallbackAppender&) = delete;
@@ -0,0 +1,206 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    callsiteprofile.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file
+ * Per call site profile of logging macros. It is collected when
+ * <code>LOG4CPLUS_MACRO_CALL_SITE_PROFILE</code> is defined before
+ * <code>log4cplus/loggingmacros.h</code> is included. Every logging
+ * macro then registers a static CallSite record that counts how many
+ * times the statement has been reached, how many times it has logged,
+ * bytes of its messages and, for every CallSite::sample_period-th
+ * logged message, the time spent formatting and logging it.
+ */
+
+#ifndef LOG4CPLUS_CALLSITEPROFILE_HEADER_
+#define LOG4CPLUS_CALLSITEPROFILE_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/loglevel.h>
+#include <log4cplus/streams.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined (__x86_64__) || defined (__i386__)
+#  include <x86intrin.h>
+#  define LOG4CPLUS_CALL_SITE_HAVE_RDTSC
+#elif defined (_MSC_VER) && (defined (_M_X64) || defined (_M_IX86))
+#  include <intrin.h>
+#  define LOG4CPLUS_CALL_SITE_HAVE_RDTSC
+#endif
+
+
+namespace log4cplus {
+
+
+    //! Snapshot of one CallSite, see getCallSiteProfile().
+    struct CallSiteProfile
+    {
+        char const * file = nullptr;
+        int line = 0;
+        char const * function = nullptr;
+        LogLevel logLevel = NOT_SET_LOG_LEVEL;
+
+        //! Times the statement has been reached.
+        std::uint64_t checks = 0;
+
+        //! Times it has logged a message.
+        std::uint64_t emitted = 0;
+
+        //! Total length of its messages in bytes.
+        std::uint64_t bytes = 0;
+
+        //! Number of timed emissions and their total duration.
+        std::uint64_t samples = 0;
+        std::chrono::nanoseconds sampledTime {0};
+
+        //! Times the statement has been skipped because its log level
+        //! was disabled.
+        std::uint64_t disabled () const { return checks - emitted; }
+
+        //! Estimated time spent by all emissions.
+        std::chrono::nanoseconds
+        estimatedTime () const
+        {
+            if (samples == 0)
+                return std::chrono::nanoseconds (0);
+
+            return std::chrono::nanoseconds (static_cast<std::int64_t>(
+                    static_cast<double>(sampledTime.count ())
+                    * static_cast<double>(emitted)
+                    / static_cast<double>(samples)));
+        }
+    };
+
+
+    //! Returns profiles of all call sites registered so far, sorted by
+    //! estimatedTime() from the most expensive.
+    LOG4CPLUS_EXPORT std::vector<CallSiteProfile> getCallSiteProfile ();
+
+    //! Writes table of getCallSiteProfile() to <code>os</code>.
+    LOG4CPLUS_EXPORT void dumpCallSiteProfile (tostream & os);
+
+
+    namespace detail {
+
+    //! Returns current value of the clock used to time call sites:
+    //! time stamp counter where available, nanoseconds of
+    //! <code>std::chrono::steady_clock</code> elsewhere.
+    inline
+    std::uint64_t
+    call_site_ticks ()
+    {
+#if defined (LOG4CPLUS_CALL_SITE_HAVE_RDTSC)
+        return __rdtsc ();
+#else
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds> (
+                std::chrono::steady_clock::now ().time_since_epoch ())
+            .count ());
+#endif
+    }
+
+
+    //! Static record of one logging statement. Records link themselves
+    //! into a global list when constructed and are never unlinked, so
+    //! they must not live in code that is unloaded.
+    struct LOG4CPLUS_EXPORT CallSite
+    {
+        //! One of this many emissions is timed.
+        static std::uint64_t const sample_period = 16;
+
+        CallSite (char const * file, int line, char const * function,
+            LogLevel ll);
+
+        CallSite (CallSite const &) = delete;
+        CallSite & operator = (CallSite const &) = delete;
+
+        char const * const file;
+        int const line;
+        char const * const function;
+        LogLevel const logLevel;
+
+        std::atomic<std::uint64_t> checks {0};
+        std::atomic<std::uint64_t> emitted {0};
+        std::atomic<std::uint64_t> bytes {0};
+        std::atomic<std::uint64_t> samples {0};
+        std::atomic<std::uint64_t> sampledTicks {0};
+
+        CallSite * next = nullptr;
+    };
+
+
+    //! Accounts one emission of <code>site</code> for its lifetime.
+    class CallSiteEmission
+    {
+    public:
+        explicit CallSiteEmission (CallSite & s)
+            : site (s)
+            , start (site.emitted.fetch_add (1, std::memory_order_relaxed)
+                % CallSite::sample_period == 0 ? call_site_ticks () : 0)
+        { }
+
+        ~CallSiteEmission ()
+        {
+            if (start == 0)
+                return;
+
+            site.samples.fetch_add (1, std::memory_order_relaxed);
+            site.sampledTicks.fetch_add (call_site_ticks () - start,
+                std::memory_order_relaxed);
+        }
+
+        void
+        addBytes (std::size_t chars, std::size_t char_size)
+        {
+            site.bytes.fetch_add (chars * char_size,
+                std::memory_order_relaxed);
+        }
+
+        CallSiteEmission (CallSiteEmission const &) = delete;
+        CallSiteEmission & operator = (CallSiteEmission const &) = delete;
+
+    private:
+        CallSite & site;
+        std::uint64_t const start;
+    };
+
+    } // namespace detail
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_CALLSITEPROFILE_HEADER_
@@ -60,6 +60,42 @@ namespace log4cplus
 {
 
 
+/**
+ * Appends events as records of a Common Log File System log.
+ *
+ * Records are appended into the marshalling area and the log is
+ * flushed to the last appended record once <tt>FlushRecords</tt>
+ * records are pending, or when an event is appended
+ * <tt>FlushInterval</tt> milliseconds or more after the first pending
+ * one. Pending records are flushed by close().
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>LogName</tt></dt>
+ * <dd>Name of the log.</dd>
+ *
+ * <dt><tt>LogSize</tt></dt>
+ * <dd>Size of a new container, in bytes.</dd>
+ *
+ * <dt><tt>BufferSize</tt></dt>
+ * <dd>Size of the marshalling area buffers, in bytes. Longer records
+ * are truncated.</dd>
+ *
+ * <dt><tt>FlushRecords</tt></dt>
+ * <dd>Number of appended records after which the log is flushed.
+ * Defaults to 1.</dd>
+ *
+ * <dt><tt>FlushInterval</tt></dt>
+ * <dd>Milliseconds after which pending records are flushed. Zero, the
+ * default, disables the time threshold.</dd>
+ *
+ * <dt><tt>AsyncFlush</tt></dt>
+ * <dd>When <tt>true</tt>, flushes are issued as overlapped I/O and
+ * appending continues while they complete. At most one flush is
+ * outstanding; records appended meanwhile are flushed by the next
+ * one.</dd>
+ * </dl>
+ */
 class LOG4CPLUS_CLFSAPPENDER_EXPORT CLFSAppender
     : public Appender
 {
@@ -71,10 +107,29 @@ public:
 
     virtual void close ();
 
+    //! Flushes all pending records and waits for the flush.
+    void flush ();
+
     static void registerAppender ();
 
 protected:
     virtual void append (spi::InternalLoggingEvent const &);
+    virtual void appendBatch (
+        std::span<spi::InternalLoggingEvent const> events);
+
+    //! Appends one record into the marshalling area.
+    bool appendRecord (spi::InternalLoggingEvent const &);
+
+    //! Flushes pending records if a threshold has been reached.
+    void flushIfDue ();
+
+    //! Starts flush up to the last appended record.
+    void startFlush ();
+
+    //! Waits for outstanding overlapped flush, if any.
+    //! \return <code>false</code> if the flush is still running and
+    //! <code>wait</code> is <code>false</code>.
+    bool completeFlush (bool wait);
 
     void init (tstring const & logname, unsigned long logsize,
         unsigned long buffersize);
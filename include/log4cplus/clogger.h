@@ -34,6 +34,8 @@
 #endif
 
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -101,6 +103,63 @@ LOG4CPLUS_EXPORT int log4cplus_logger_force_log(const log4cplus_char_t *name,
 LOG4CPLUS_EXPORT int log4cplus_logger_force_log_str(const log4cplus_char_t *name,
     log4cplus_loglevel_t ll, const log4cplus_char_t *msg);
 
+// Handles of loggers spare the lookup of the logger by name in every
+// call. A handle keeps its logger alive until it is released; its level
+// check follows changes of configuration.
+
+//! \return Handle of logger <code>name</code>, or of the root logger if
+//! <code>name</code> is null; null on failure.
+LOG4CPLUS_EXPORT log4cplus_logger_t log4cplus_logger_get(
+    const log4cplus_char_t *name);
+LOG4CPLUS_EXPORT void log4cplus_logger_release(log4cplus_logger_t logger);
+
+LOG4CPLUS_EXPORT int log4cplus_logger_is_enabled_for_h(
+    log4cplus_logger_t logger, log4cplus_loglevel_t ll);
+
+LOG4CPLUS_EXPORT int log4cplus_logger_log_h(log4cplus_logger_t logger,
+    log4cplus_loglevel_t ll, const log4cplus_char_t *msgfmt, ...)
+    LOG4CPLUS_FORMAT_ATTRIBUTE (__printf__, 3, 4);
+
+LOG4CPLUS_EXPORT int log4cplus_logger_log_str_h(log4cplus_logger_t logger,
+    log4cplus_loglevel_t ll, const log4cplus_char_t *msg);
+
+LOG4CPLUS_EXPORT int log4cplus_logger_force_log_h(log4cplus_logger_t logger,
+    log4cplus_loglevel_t ll, const log4cplus_char_t *msgfmt, ...)
+    LOG4CPLUS_FORMAT_ATTRIBUTE (__printf__, 3, 4);
+
+LOG4CPLUS_EXPORT int log4cplus_logger_force_log_str_h(
+    log4cplus_logger_t logger, log4cplus_loglevel_t ll,
+    const log4cplus_char_t *msg);
+
+//! Record passed to log4cplus_logger_log_batch_h().
+typedef struct log4cplus_record_t
+{
+    log4cplus_loglevel_t ll;
+    const log4cplus_char_t *message;
+    //! Time stamp of the record; zero in both fields stands for time of
+    //! the call.
+    unsigned long long timestamp_secs;
+    unsigned long timestamp_usecs;
+    //! Location of the record; <code>file</code> and
+    //! <code>function</code> may be null.
+    const char *file;
+    int line;
+    const char *function;
+} log4cplus_record_t;
+
+//! Logs those of <code>count</code> records whose level the logger is
+//! enabled for, passing them to appenders in batches. The strings have
+//! to stay valid only during the call.
+LOG4CPLUS_EXPORT int log4cplus_logger_log_batch_h(log4cplus_logger_t logger,
+    const log4cplus_record_t *records, size_t count);
+
+//! Logs without checking the level, with the location of the caller.
+//! <code>file</code> and <code>function</code> may be null.
+LOG4CPLUS_EXPORT int log4cplus_logger_force_log_loc_h(
+    log4cplus_logger_t logger, log4cplus_loglevel_t ll, const char *file,
+    int line, const char *function, const log4cplus_char_t *msgfmt, ...)
+    LOG4CPLUS_FORMAT_ATTRIBUTE (__printf__, 6, 7);
+
 //! CallbackAppender callback type.
 typedef void (* log4cplus_log_event_callback_t)(void * cookie,
     log4cplus_char_t const * message, log4cplus_char_t const * loggerName,
@@ -113,6 +172,62 @@ LOG4CPLUS_EXPORT int log4cplus_add_callback_appender(
     const log4cplus_char_t * logger, log4cplus_log_event_callback_t callback,
     void * cookie);
 
+//! Event passed to log4cplus_log_event_batch_callback_t. The strings
+//! point into the event and stay valid only during the callback;
+//! <code>file</code> and <code>function</code> are empty, not null,
+//! when unknown.
+typedef struct log4cplus_event_view_t
+{
+    const log4cplus_char_t *message;
+    size_t message_len;
+    const log4cplus_char_t *logger_name;
+    log4cplus_loglevel_t ll;
+    const log4cplus_char_t *thread;
+    const log4cplus_char_t *thread2;
+    unsigned long long timestamp_secs;
+    unsigned long timestamp_usecs;
+    const log4cplus_char_t *file;
+    const log4cplus_char_t *function;
+    int line;
+} log4cplus_event_view_t;
+
+//! Batched CallbackAppender callback type.
+typedef void (* log4cplus_log_event_batch_callback_t)(void * cookie,
+    const log4cplus_event_view_t *events, size_t count);
+
+//! Adds CallbackAppender passing events to <code>callback</code> in
+//! arrays of up to <code>batch_size</code> events. Partial batches are
+//! passed at least every <code>batch_interval_ms</code> milliseconds,
+//! or right after each batch of appended events when it is zero. The
+//! appender appends asynchronously, so the callback runs on a thread
+//! pool thread.
+LOG4CPLUS_EXPORT int log4cplus_add_batch_callback_appender(
+    const log4cplus_char_t * logger,
+    log4cplus_log_event_batch_callback_t callback, void * cookie,
+    size_t batch_size, unsigned long batch_interval_ms);
+
+// Runtime control, see log4cplus::RuntimeControl.
+
+//! Executes runtime control <code>command</code>. Unless
+//! <code>reply</code> is null, the reply, truncated to
+//! <code>reply_size</code> characters including the terminating null
+//! character, is stored into it.
+//! \return 0 on success, -1 if the command has failed.
+LOG4CPLUS_EXPORT int log4cplus_control(const log4cplus_char_t *command,
+    log4cplus_char_t *reply, size_t reply_size);
+
+//! Sets log level of logger <code>prefix</code> and its descendants.
+LOG4CPLUS_EXPORT int log4cplus_control_set_log_level(
+    const log4cplus_char_t *prefix, log4cplus_loglevel_t ll);
+
+LOG4CPLUS_EXPORT int log4cplus_control_set_appender_enabled(
+    const log4cplus_char_t *name, int enabled);
+
+//! Starts serving runtime control commands at unix socket
+//! <code>path</code>, or stops it if <code>path</code> is null.
+//! \return 0 on success, ENOTSUP where unix sockets are not supported.
+LOG4CPLUS_EXPORT int log4cplus_control_listen(const log4cplus_char_t *path);
+
 // Custom LogLevel
 LOG4CPLUS_EXPORT int log4cplus_add_log_level(unsigned int ll,
     const log4cplus_char_t *ll_name);
@@ -123,4 +238,97 @@ LOG4CPLUS_EXPORT int log4cplus_remove_log_level(unsigned int ll,
 }
 #endif
 
+// Logging macros for C. They check the level of the logger handle
+// before the arguments are evaluated and pass location of the call.
+// LOG4CPLUS_DISABLE_<LEVEL> removes the macros of the level and of the
+// levels below it at compile time, as it does for the C++ macros.
+
+#if defined(LOG4CPLUS_DISABLE_FATAL) && !defined(LOG4CPLUS_DISABLE_ERROR)
+#define LOG4CPLUS_DISABLE_ERROR
+#endif
+#if defined(LOG4CPLUS_DISABLE_ERROR) && !defined(LOG4CPLUS_DISABLE_WARN)
+#define LOG4CPLUS_DISABLE_WARN
+#endif
+#if defined(LOG4CPLUS_DISABLE_WARN) && !defined(LOG4CPLUS_DISABLE_INFO)
+#define LOG4CPLUS_DISABLE_INFO
+#endif
+#if defined(LOG4CPLUS_DISABLE_INFO) && !defined(LOG4CPLUS_DISABLE_DEBUG)
+#define LOG4CPLUS_DISABLE_DEBUG
+#endif
+#if defined(LOG4CPLUS_DISABLE_DEBUG) && !defined(LOG4CPLUS_DISABLE_TRACE)
+#define LOG4CPLUS_DISABLE_TRACE
+#endif
+
+#if defined (LOG4CPLUS_DISABLE_FILE_MACRO)
+#  define LOG4CPLUS_C_CALLER_FILE() 0
+#  define LOG4CPLUS_C_CALLER_LINE() -1
+#else
+#  define LOG4CPLUS_C_CALLER_FILE() __FILE__
+#  define LOG4CPLUS_C_CALLER_LINE() __LINE__
+#endif
+
+#if defined (LOG4CPLUS_DISABLE_FUNCTION_MACRO)
+#  define LOG4CPLUS_C_CALLER_FUNCTION() 0
+#elif defined (_MSC_VER)
+#  define LOG4CPLUS_C_CALLER_FUNCTION() __FUNCTION__
+#else
+#  define LOG4CPLUS_C_CALLER_FUNCTION() __func__
+#endif
+
+#define LOG4CPLUS_C_DOWHILE_NOTHING() do { } while (0)
+
+#define LOG4CPLUS_C_LOG(handle, ll, ...)                                \
+    do {                                                                \
+        log4cplus_logger_t const _l4cp_c_handle = (handle);            \
+        log4cplus_loglevel_t const _l4cp_c_ll = (ll);                  \
+        if (log4cplus_logger_is_enabled_for_h (_l4cp_c_handle,         \
+                _l4cp_c_ll))                                            \
+            log4cplus_logger_force_log_loc_h (_l4cp_c_handle,          \
+                _l4cp_c_ll, LOG4CPLUS_C_CALLER_FILE (),                 \
+                LOG4CPLUS_C_CALLER_LINE (),                             \
+                LOG4CPLUS_C_CALLER_FUNCTION (), __VA_ARGS__);           \
+    } while (0)
+
+#if !defined(LOG4CPLUS_DISABLE_TRACE)
+#define LOG4CPLUS_C_TRACE(handle, ...)                                  \
+    LOG4CPLUS_C_LOG (handle, L4CP_TRACE_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_C_TRACE(handle, ...) LOG4CPLUS_C_DOWHILE_NOTHING ()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_DEBUG)
+#define LOG4CPLUS_C_DEBUG(handle, ...)                                  \
+    LOG4CPLUS_C_LOG (handle, L4CP_DEBUG_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_C_DEBUG(handle, ...) LOG4CPLUS_C_DOWHILE_NOTHING ()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_INFO)
+#define LOG4CPLUS_C_INFO(handle, ...)                                   \
+    LOG4CPLUS_C_LOG (handle, L4CP_INFO_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_C_INFO(handle, ...) LOG4CPLUS_C_DOWHILE_NOTHING ()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_WARN)
+#define LOG4CPLUS_C_WARN(handle, ...)                                   \
+    LOG4CPLUS_C_LOG (handle, L4CP_WARN_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_C_WARN(handle, ...) LOG4CPLUS_C_DOWHILE_NOTHING ()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_ERROR)
+#define LOG4CPLUS_C_ERROR(handle, ...)                                  \
+    LOG4CPLUS_C_LOG (handle, L4CP_ERROR_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_C_ERROR(handle, ...) LOG4CPLUS_C_DOWHILE_NOTHING ()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_FATAL)
+#define LOG4CPLUS_C_FATAL(handle, ...)                                  \
+    LOG4CPLUS_C_LOG (handle, L4CP_FATAL_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_C_FATAL(handle, ...) LOG4CPLUS_C_DOWHILE_NOTHING ()
+#endif
+
 #endif /*?LOG4CPLUS_CLOGGERHEADER_*/
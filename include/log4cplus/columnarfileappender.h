@@ -0,0 +1,149 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    columnarfileappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+/** @file */
+
+#ifndef LOG4CPLUS_COLUMNAR_FILE_APPENDER_HEADER_
+#define LOG4CPLUS_COLUMNAR_FILE_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/appender.h>
+#include <log4cplus/columnarlog.h>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+
+namespace log4cplus
+{
+
+/**
+ * Writes events into a file as blocks of columns, see
+ * ColumnarLogWriter, for long-term retention. Time stamps are delta
+ * encoded, levels, logger and thread names and selected MDC values are
+ * dictionary encoded, and each block records range of its time stamps
+ * and levels. Queries for a time range or a level, e.g., through
+ * log4cplus-cat, then read only headers of most blocks and only some
+ * columns of the others. Layout is not used.
+ *
+ * Events wait in memory until their block is written, so they are
+ * lost when the process crashes. A block cut short by a crash is
+ * removed when the file is appended to.
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>File</tt></dt>
+ * <dd>This property specifies output file name.</dd>
+ *
+ * <dt><tt>Append</tt></dt>
+ * <dd>When it is set true, output file will be appended to
+ * instead of being truncated at opening.</dd>
+ *
+ * <dt><tt>CreateDirs</tt></dt>
+ * <dd>Set this property to <tt>true</tt> if you want to create
+ * missing directories in path leading to log file.</dd>
+ *
+ * <dt><tt>BlockEvents</tt></dt>
+ * <dd>Number of events in a block. Defaults to 8192.</dd>
+ *
+ * <dt><tt>BlockIntervalMs</tt></dt>
+ * <dd>Block is written at least this many milliseconds after its
+ * first event, even when it is not full. Zero, the default, disables
+ * the limit.</dd>
+ *
+ * <dt><tt>MDCColumns</tt></dt>
+ * <dd>Comma separated list of MDC keys whose values are stored, each
+ * in a column of its own. Other MDC keys are not stored.</dd>
+ *
+ * <dt><tt>CompressionLevel</tt></dt>
+ * <dd>zstd compression level of the columns. Zero disables
+ * compression. Defaults to 3 when log4cplus is built with zstd and to
+ * 0 otherwise.</dd>
+ * </dl>
+ */
+class LOG4CPLUS_EXPORT ColumnarFileAppender
+    : public Appender
+{
+public:
+    ColumnarFileAppender (tstring const & filename,
+        std::ios_base::openmode mode = std::ios_base::trunc,
+        std::size_t blockEvents = 8192, bool createDirs = false);
+    ColumnarFileAppender (helpers::Properties const & properties);
+    virtual ~ColumnarFileAppender ();
+
+    virtual void close ();
+
+    //! Thread name and, with <tt>MDCColumns</tt>, MDC are stored.
+    virtual unsigned getRequiredEventFields () const;
+
+    //! Writes events waiting for their block.
+    void writeBlock ();
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+
+    //! Adds all events to the current block at once.
+    virtual void appendBatch (
+        std::span<spi::InternalLoggingEvent const> events);
+
+    void open ();
+
+    bool createDirs;
+    tstring filename;
+    std::ios_base::openmode fileOpenMode;
+    std::size_t blockEvents;
+    unsigned long blockInterval;
+    std::vector<tstring> mdcKeys;
+    int compressionLevel;
+    std::ofstream out;
+    std::unique_ptr<ColumnarLogWriter> writer;
+
+    //! Time of the first event of the current block.
+    helpers::Time blockSince;
+
+private:
+    void init ();
+
+    //! Indicates whether or not the <tt>BlockIntervalMs</tt> timer is
+    //! registered with the shared flush timer thread.
+    bool blockTimerRegistered;
+
+    ColumnarFileAppender (ColumnarFileAppender const &);
+    ColumnarFileAppender & operator = (ColumnarFileAppender const &);
+};
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_COLUMNAR_FILE_APPENDER_HEADER_
@@ -0,0 +1,259 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    columnarlog.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+/** @file
+ * This header defines columnar log files: events are collected into
+ * blocks and each block stores its events column by column, with
+ * statistics that let readers skip blocks without reading their
+ * columns. */
+
+#ifndef LOG4CPLUS_COLUMNAR_LOG_HEADER_
+#define LOG4CPLUS_COLUMNAR_LOG_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/loglevel.h>
+#include <log4cplus/tstring.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <cstdint>
+#include <fstream>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace log4cplus
+{
+
+namespace spi
+{
+
+class InternalLoggingEvent;
+
+} // namespace spi
+
+
+namespace internal
+{
+
+struct columnar_codec;
+
+} // namespace internal
+
+
+//! Columns of columnar log blocks. The values are bits of column masks
+//! passed to ColumnarLogReader::read().
+enum ColumnarLogColumn : unsigned
+{
+    //! Time stamps, in microseconds, delta encoded.
+    COLUMNAR_TIMESTAMP = 0x01,
+    //! Levels, dictionary encoded.
+    COLUMNAR_LEVEL = 0x02,
+    //! Logger names, dictionary encoded.
+    COLUMNAR_LOGGER = 0x04,
+    //! Thread names, dictionary encoded.
+    COLUMNAR_THREAD = 0x08,
+    //! Messages.
+    COLUMNAR_MESSAGE = 0x10,
+    //! Values of MDC keys, one dictionary encoded column per key.
+    COLUMNAR_MDC = 0x20,
+    COLUMNAR_ALL = 0x3F
+};
+
+
+/**
+ * Collects events into blocks and writes them column by column. Each
+ * block starts with its statistics, the range of time stamps and of
+ * levels, and with a directory of its columns, so that readers can
+ * skip the block or read only some of its columns. Strings are stored
+ * as UTF-8. Columns are compressed with zstd when it is available and
+ * compression is enabled. NDC, key/value fields and location are not
+ * stored.
+ */
+class LOG4CPLUS_EXPORT ColumnarLogWriter
+{
+public:
+    //! Values of MDC keys in <code>mdcKeys</code> are stored in
+    //! columns of their own; other keys are not stored. Columns are
+    //! compressed at <code>compressionLevel</code> when it is not zero.
+    ColumnarLogWriter (std::ostream & out,
+        std::vector<tstring> const & mdcKeys = std::vector<tstring> (),
+        int compressionLevel = 0);
+    ~ColumnarLogWriter ();
+
+    //! Writes header. It has to be called at the start of the output;
+    //! it can be written again, e.g., when the output is appended to.
+    void writeHeader ();
+
+    //! Adds event to the current block.
+    void add (spi::InternalLoggingEvent const & event);
+
+    //! \return Number of events in the current block.
+    std::size_t size () const { return timestamps.size (); }
+
+    //! Writes the current block and starts a new one. Does nothing when
+    //! the block is empty.
+    void writeBlock ();
+
+private:
+    //! Distinct values of a column and id of the value of each event.
+    struct Dictionary
+    {
+        void add (tstring const & value);
+        void clear ();
+
+        std::unordered_map<tstring, std::uint64_t> ids;
+        //! Lengths of the values in the order of their ids.
+        std::string lengths;
+        //! The values, one after another.
+        std::string bytes;
+        //! Id of the value of each event.
+        std::string column;
+    };
+
+    LOG4CPLUS_PRIVATE void writeColumn (std::string & header,
+        std::string & data, ColumnarLogColumn kind,
+        tstring const & name, std::string const & raw);
+
+    std::ostream & out;
+    std::vector<tstring> mdcKeys;
+    std::shared_ptr<internal::columnar_codec> codec;
+
+    std::vector<std::int64_t> timestamps;
+    std::vector<LogLevel> levels;
+    Dictionary loggers;
+    Dictionary threads;
+    std::vector<Dictionary> mdc;
+    //! Lengths of the messages.
+    std::string messageLengths;
+    //! The messages, one after another.
+    std::string messageBytes;
+};
+
+
+/**
+ * Reads files written by ColumnarLogWriter. Constructor reads headers
+ * of all blocks; columns are read only when asked for. Malformed input
+ * is reported by throwing std::runtime_error. A block cut short at the
+ * end of the file, e.g., by a crash of the writer, is ignored.
+ */
+class LOG4CPLUS_EXPORT ColumnarLogReader
+{
+public:
+    //! Column of a block.
+    struct Column
+    {
+        ColumnarLogColumn kind;
+        //! MDC key of COLUMNAR_MDC columns.
+        tstring name;
+        //! Zero for uncompressed columns, one for zstd.
+        unsigned char codec;
+        //! Position of the column in the file.
+        std::uint64_t offset;
+        //! Size of the column in the file.
+        std::uint64_t size;
+        //! Size of the column when it is decompressed.
+        std::uint64_t rawSize;
+    };
+
+    //! Header of a block.
+    struct Block
+    {
+        //! Position of the block in the file.
+        std::uint64_t offset;
+        std::size_t events;
+        helpers::Time minTime;
+        helpers::Time maxTime;
+        LogLevel minLevel;
+        LogLevel maxLevel;
+        std::vector<Column> columns;
+    };
+
+    //! Columns of a block. Columns which were not read are empty.
+    struct Rows
+    {
+        std::vector<helpers::Time> timestamps;
+        std::vector<LogLevel> levels;
+        std::vector<tstring> loggers;
+        std::vector<tstring> threads;
+        std::vector<tstring> messages;
+        //! MDC key and its values.
+        std::vector<std::pair<tstring, std::vector<tstring>>> mdc;
+    };
+
+    /**
+     * Opens file <code>name</code> and reads headers of its blocks.
+     *
+     * @throws std::runtime_error if the file cannot be opened or if it
+     * is not a columnar log.
+     */
+    explicit ColumnarLogReader (tstring const & name);
+    ~ColumnarLogReader ();
+
+    //! \return <code>true</code> if file <code>name</code> starts
+    //! with columnar log header.
+    static bool isColumnarLog (tstring const & name);
+
+    std::vector<Block> const & getBlocks () const { return blocks; }
+
+    //! \return Size of the file up to the end of its last complete
+    //! block.
+    std::uint64_t getValidSize () const { return validSize; }
+
+    //! Reads and decodes columns of <code>block</code> selected by
+    //! <code>columns</code>, a combination of ColumnarLogColumn.
+    void read (Block const & block, unsigned columns, Rows & rows);
+
+private:
+    LOG4CPLUS_PRIVATE std::string const & readColumn (
+        Column const & column);
+
+    std::ifstream in;
+    std::vector<Block> blocks;
+    std::uint64_t validSize;
+    std::shared_ptr<internal::columnar_codec> codec;
+    std::string buffer;
+    std::string raw;
+
+    ColumnarLogReader (ColumnarLogReader const &);
+    ColumnarLogReader & operator = (ColumnarLogReader const &);
+};
+
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_COLUMNAR_LOG_HEADER_
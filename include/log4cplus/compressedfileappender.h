@@ -0,0 +1,163 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    compressedfileappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+/** @file */
+
+#ifndef LOG4CPLUS_COMPRESSED_FILE_APPENDER_HEADER_
+#define LOG4CPLUS_COMPRESSED_FILE_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/fileappender.h>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace log4cplus
+{
+
+namespace internal
+{
+
+struct zstd_frame_compressor;
+
+} // namespace internal
+
+
+/**
+ * Writes events compressed by zstd as they arrive. Formatted events
+ * are collected into frames of <tt>FrameSize</tt> bytes, each frame is
+ * compressed independently and appended to the file. When the file is
+ * closed or rolled over, a seek table in the zstd seekable format is
+ * appended as a skippable frame, so that readers can decompress any
+ * frame without decompressing those before it. The file is a valid
+ * zstd stream at all times, apart from the frame being written.
+ *
+ * Rollover and backups work as in RollingFileAppender; <tt>MaxFileSize</tt>
+ * limits the compressed size. In UNICODE builds events are encoded as
+ * UTF-8. Events wait in memory until their frame is written, so they
+ * are lost when the process crashes. When log4cplus is built without
+ * zstd, the appender writes plain text like RollingFileAppender.
+ *
+ * <h3>Properties</h3>
+ * <p>Properties additional to {@link RollingFileAppender}'s
+ * properties, except <tt>Compression</tt>, <tt>Index</tt> and
+ * <tt>UseLockFile</tt> which are not supported:
+ *
+ * <dl>
+ * <dt><tt>FrameSize</tt></dt>
+ * <dd>Uncompressed size of a frame, in bytes. Suffixes "KB" and "MB"
+ * are recognized. Defaults to 256 KB.</dd>
+ *
+ * <dt><tt>FrameIntervalMs</tt></dt>
+ * <dd>Frame is written at least this many milliseconds after its
+ * first event, even when it is not full. Zero, the default, disables
+ * the limit.</dd>
+ *
+ * <dt><tt>CompressionLevel</tt></dt>
+ * <dd>zstd compression level. Defaults to 3.</dd>
+ * </dl>
+ */
+class LOG4CPLUS_EXPORT CompressedRollingFileAppender
+    : public RollingFileAppender
+{
+public:
+    CompressedRollingFileAppender (tstring const & filename,
+        long maxFileSize = 10 * 1024 * 1024, int maxBackupIndex = 1,
+        std::size_t frameSize = 256 * 1024, bool createDirs = false);
+    CompressedRollingFileAppender (helpers::Properties const & properties);
+    virtual ~CompressedRollingFileAppender ();
+
+    virtual void close ();
+
+    //! Compresses and writes events waiting for their frame.
+    void writeFrame ();
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+    virtual void open (std::ios_base::openmode mode);
+
+    //! Writes pending frame and the seek table and closes the file.
+    void finishFile ();
+
+    //! Loads seek table of existing file opened for appending and
+    //! removes it from the file, so that frames can be added.
+    void resumeFile ();
+
+    //! Uncompressed size of a frame.
+    std::size_t frameSize;
+
+    //! Milliseconds after which a frame is written even if it is not
+    //! full; zero disables the limit.
+    unsigned long frameInterval;
+
+    int compressionLevel;
+
+    //! Formatted events of the frame being collected.
+    std::string pending;
+
+    //! Time of the first event in <code>pending</code>.
+    helpers::Time pendingSince;
+
+    //! Compressed and uncompressed sizes of frames in the file.
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> seekTable;
+
+    //! The compressed file; <code>out</code> is not used.
+    std::ofstream file;
+
+    std::shared_ptr<internal::zstd_frame_compressor> compressor;
+
+private:
+    void init ();
+
+    //! Indicates whether or not the <tt>FrameIntervalMs</tt> timer is
+    //! registered with the shared flush timer thread.
+    bool frameTimerRegistered;
+
+    CompressedRollingFileAppender (CompressedRollingFileAppender const &);
+    CompressedRollingFileAppender & operator = (
+        CompressedRollingFileAppender const &);
+};
+
+
+typedef helpers::SharedObjectPtr<CompressedRollingFileAppender>
+    SharedCompressedRollingFileAppenderPtr;
+
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_COMPRESSED_FILE_APPENDER_HEADER_
@@ -164,6 +164,12 @@
 
 #define LOG4CPLUS_INIT_PRIORITY_BASE (65535 / 2)
 
+//! Size of cache line assumed when frequently written data are kept
+//! apart from read-mostly data.
+#if ! defined (LOG4CPLUS_CACHE_LINE_SIZE)
+#  define LOG4CPLUS_CACHE_LINE_SIZE 64
+#endif
+
 #include <log4cplus/helpers/thread-config.h>
 
 #if defined (LOG4CPLUS_SINGLE_THREADED)
@@ -195,9 +201,44 @@ LOG4CPLUS_EXPORT void initialize ();
 //! \note using `log4cplus::Initializer` is preferred
 LOG4CPLUS_EXPORT void deinitialize ();
 
-//! Set thread pool size.
+//! Set thread pool size, the maximal number of its threads. The
+//! threads are started on demand. The default is the number of
+//! hardware threads, at least 4.
 LOG4CPLUS_EXPORT void setThreadPoolSize (std::size_t pool_size);
 
+//! Set time after which idle thread of the thread pool exits. The
+//! default is 10 seconds.
+LOG4CPLUS_EXPORT void setThreadPoolIdleTimeout (unsigned milliseconds);
+
+//! Set time limit of deinitialize() and of destruction of the last
+//! `log4cplus::Initializer`, see
+//! Hierarchy::shutdown(std::chrono::milliseconds). Thread pool workers
+//! still busy at the deadline are abandoned instead of joined. Zero, the
+//! default, waits without limit.
+LOG4CPLUS_EXPORT void setShutdownTimeout (unsigned milliseconds);
+
+//! Set capacity, in characters, above which per thread formatting
+//! buffers are released instead of being kept for reuse. The buffers
+//! otherwise keep their capacity between events, so one huge message
+//! would pin its memory in every thread that logged it. Zero means no
+//! limit. The default is 1 MiB.
+LOG4CPLUS_EXPORT void setThreadBufferCapacityLimit (std::size_t limit);
+
+//! Set number of per thread data objects kept for reuse. A thread's
+//! first logging call takes one instead of constructing its string
+//! streams and buffers, and its exit resets and returns it. Missing
+//! objects are created right away, so the pool is warm before the
+//! first thread starts. The default is 16; the maximum is 1024. Zero
+//! frees the pool.
+LOG4CPLUS_EXPORT void setThreadDataPoolSize (std::size_t size);
+
+//! When enabled, destruction of the default context at process exit
+//! only shuts down appenders and the thread pool. Loggers and the rest
+//! of the context are left to the operating system instead of being
+//! destroyed one by one, which makes exit of processes with very large
+//! logger hierarchies fast. Disabled by default.
+LOG4CPLUS_EXPORT void setFastExit (bool enabled);
+
 } // namespace log4cplus
 
 #endif
@@ -113,6 +113,13 @@
 #define LOG4CPLUS_DLLMAIN_HINSTANCE HINSTANCE
 #define LOG4CPLUS_HAVE_NT_EVENT_LOG
 
+// TraceLogging comes with Windows 10 SDK.
+#if defined (_MSC_VER) && defined (__has_include)
+#  if __has_include (<TraceLoggingProvider.h>)
+#    define LOG4CPLUS_HAVE_TRACELOGGING
+#  endif
+#endif
+
 // log4cplus_EXPORTS is used by the CMake build system.  DLL_EXPORT is
 // used by the autotools build system.
 #if (defined (log4cplus_EXPORTS) || defined (log4cplusU_EXPORTS) \
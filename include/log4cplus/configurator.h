@@ -114,6 +114,25 @@ namespace log4cplus
         static void doConfigure(const log4cplus::tstring& configFilename,
             Hierarchy& h = Logger::getDefaultHierarchy(), unsigned flags = 0);
 
+        /**
+         * Like doConfigure() but keeps resolved configuration in binary
+         * file <code>snapshotFile</code>. When the snapshot is valid, it
+         * is loaded instead of parsing <code>configFilename</code> and
+         * substituting variables. The snapshot is written again when
+         * <code>configFilename</code> changed modification time or size,
+         * when any environment variable referenced by the configuration
+         * changed or when <code>flags</code> differ.
+         *
+         * Files pulled in using <code>include</code> directive are not
+         * checked for changes. The snapshot format depends on byte order
+         * and on size of <code>tchar</code>; it is a local cache, not an
+         * interchange format.
+         */
+        static void doConfigureFromSnapshot(
+            const log4cplus::tstring& configFilename,
+            const log4cplus::tstring& snapshotFile,
+            Hierarchy& h = Logger::getDefaultHierarchy(), unsigned flags = 0);
+
         /**
          * Read configuration from a file. <b>The existing configuration is
          * not cleared nor reset.</b> If you require a different behavior,
@@ -188,6 +207,8 @@ namespace log4cplus
          *
          * Similar to the root logger syntax, each <i>appenderName</i>
          * (separated by commas) will be attached to the named logger.
+         * Appender names which the properties do not define refer to
+         * appenders of Hierarchy::getSharedAppenders(), if any.
          *
          * See the <a href="../../../../manual.html#additivity">appender
          * additivity rule</a> in the user manual for the meaning of the
@@ -201,7 +222,51 @@ namespace log4cplus
          * <h3>Global configuration</h3>
          *
          * Property <pre>log4cplus.threadPoolSize</pre> can be used to adjust
-         * size of log4cplus' internal thread pool.
+         * size of log4cplus' internal thread pool. Its threads are started
+         * on demand and exit after they have been idle for
+         * <pre>log4cplus.threadPoolIdleTimeout</pre> milliseconds.
+         *
+         * Property <pre>log4cplus.threadBufferCapacityLimit</pre> sets
+         * capacity above which per thread formatting buffers are released,
+         * see setThreadBufferCapacityLimit().
+         *
+         * Property <pre>log4cplus.stackTraceLogLevel</pre>, e.g.,
+         * <code>ERROR</code>, sets log level from which events capture
+         * stack trace of the logging call, see
+         * spi::setStackTraceLogLevel().
+         *
+         * Property <pre>log4cplus.eventSequenceNumbers</pre> set to
+         * <code>true</code> numbers events, see
+         * spi::setEventSequencing().
+         *
+         * Property <pre>log4cplus.shutdownTimeout</pre> limits, in
+         * milliseconds, the time log4cplus::deinitialize() takes, see
+         * setShutdownTimeout().
+         *
+         * Property <pre>log4cplus.eventClock</pre>, one of
+         * <code>System</code>, <code>Coarse</code> or <code>Tsc</code>,
+         * selects the clock time stamps of events are read from, see
+         * helpers::setEventClock().
+         *
+         * Properties <pre>log4cplus.backgroundThreads.cpus</pre> (e.g.,
+         * <code>0-3,8</code>), <pre>log4cplus.backgroundThreads.policy</pre>
+         * (one of <code>Other</code>, <code>Batch</code>, <code>Idle</code>,
+         * <code>Fifo</code> or <code>RR</code>),
+         * <pre>log4cplus.backgroundThreads.priority</pre> and
+         * <pre>log4cplus.backgroundThreads.namePrefix</pre> set affinity,
+         * scheduling and names of threads log4cplus starts afterwards, see
+         * thread::setBackgroundThreadSettings().
+         *
+         * Properties <pre>log4cplus.logLogRateLimit</pre> (messages per
+         * second) and <pre>log4cplus.logLogDedupWindow</pre> (milliseconds)
+         * limit log4cplus' own warnings and errors, see
+         * helpers::LogLog::setRateLimit().
+         *
+         * Appenders are constructed concurrently on the internal thread
+         * pool, so that appenders blocking in their constructors, e.g.,
+         * on slow file systems or name resolution, do not add up.
+         * Property <pre>log4cplus.parallelAppenderStartup</pre> set to
+         * <code>false</code> constructs them one after another.
          *
          * <h3>Example</h3>
          *
@@ -354,6 +419,14 @@ namespace log4cplus
     class ConfigurationWatchDogThread;
 
 
+    /**
+     * Configures log4cplus from <code>propertyFile</code> and watches
+     * the file for changes. Changes are noticed by inotify where it is
+     * available, otherwise by checking the file every
+     * <code>millis</code> milliseconds. Only loggers and appenders whose
+     * properties changed are configured again; other appenders keep
+     * their open files and connections.
+     */
     class LOG4CPLUS_EXPORT ConfigureAndWatchThread {
     public:
       // ctor and dtor
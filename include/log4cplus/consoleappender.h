@@ -31,7 +31,9 @@
 #endif
 
 #include <log4cplus/appender.h>
+#include <log4cplus/helpers/timehelper.h>
 #include <locale>
+#include <string>
 
 namespace log4cplus {
     /**
@@ -65,7 +67,32 @@ namespace log4cplus {
      * Note: if <tt>Locale</tt> is set, <tt>ImmediateFlush</tt> will
      * be set to true automatically.
      * </dd>
-     * 
+     *
+     * <dt><tt>DirectWrite</tt></dt>
+     * <dd>When it is set true, events are written directly to file
+     * descriptor 1 or 2 (standard output or error handle on Windows)
+     * from a buffer of the appender, bypassing <code>std::cout</code>,
+     * <code>std::cerr</code> and the console mutex shared by all
+     * console appenders. Events are encoded as UTF-8 in UNICODE
+     * builds; <tt>Locale</tt> is ignored. When the output is a
+     * terminal, each event is written immediately. Otherwise, e.g.,
+     * for a pipe to a log collector, events are written once
+     * <tt>BufferSize</tt> bytes are buffered, at the latest after
+     * <tt>FlushIntervalMs</tt>, and in one write per batch of
+     * <tt>AsyncAppend</tt>. Output written through the streams by
+     * other code is not ordered with respect to the events, and
+     * writes longer than <code>PIPE_BUF</code> may interleave with
+     * writes of other processes.</dd>
+     *
+     * <dt><tt>BufferSize</tt></dt>
+     * <dd>Size of the <tt>DirectWrite</tt> buffer, in bytes. Defaults
+     * to 64 KB.</dd>
+     *
+     * <dt><tt>FlushIntervalMs</tt></dt>
+     * <dd>Longest time, in milliseconds, an event may wait in the
+     * <tt>DirectWrite</tt> buffer. Defaults to 100. Zero leaves the
+     * events in the buffer until it is full or the appender is
+     * closed.</dd>
      * </dl>
      * \sa Appender
      */
@@ -85,8 +112,16 @@ namespace log4cplus {
         //! classes to synchronize output to console.
         static log4cplus::thread::Mutex const & getOutputMutex();
 
+        //! Writes <code>data</code> directly to standard output or
+        //! error, bypassing the streams and the <tt>DirectWrite</tt>
+        //! buffer.
+        virtual bool emergencyWrite(const char * data, std::size_t size)
+            noexcept;
+
     protected:
         virtual void append(const spi::InternalLoggingEvent& event);
+        virtual void appendBatch(
+            std::span<spi::InternalLoggingEvent const> events);
 
       // Data
         bool logToStdErr;
@@ -97,6 +132,33 @@ namespace log4cplus {
         bool immediateFlush;
 
         std::unique_ptr<std::locale> locale;
+
+        //! Events are written to the file descriptor, see
+        //! <tt>DirectWrite</tt> property.
+        bool directWrite;
+
+        //! The output is a terminal.
+        bool terminal;
+
+        unsigned long bufferSize;
+        unsigned long flushInterval;
+
+        //! Encoded events waiting to be written.
+        std::string buffer;
+
+        //! Writes <code>buffer</code> to the output and clears it.
+        void writeBuffer ();
+
+    private:
+        void initDirectWrite ();
+        void timedFlush ();
+
+        //! Indicates whether or not this appender is registered with
+        //! the shared flush timer thread.
+        bool flushTimerRegistered;
+
+        //! Time of the last write, used when there is no timer thread.
+        log4cplus::helpers::Time lastWrite;
     };
 
 } // end namespace log4cplus
@@ -0,0 +1,242 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    diagnosticcontext.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+/** @file */
+
+#ifndef LOG4CPLUS_DIAGNOSTIC_CONTEXT_HEADER_
+#define LOG4CPLUS_DIAGNOSTIC_CONTEXT_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/mdc.h>
+#include <log4cplus/ndc.h>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#if defined (__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L \
+    && defined (__has_include)
+#  if __has_include (<coroutine>)
+#    define LOG4CPLUS_HAVE_COROUTINES
+#    include <coroutine>
+#  endif
+#endif
+
+
+namespace log4cplus
+{
+
+
+//! Immutable snapshot of NDC stack. Null pointer stands for empty stack.
+typedef std::shared_ptr<DiagnosticContextStack const>
+    DiagnosticContextStackPtr;
+
+
+/**
+ * Snapshot of MDC and NDC of a thread that can be carried to another
+ * thread, e.g., with a task submitted to thread pool, and installed
+ * there. Both capturing and installing copy only two reference counted
+ * pointers; MDC and NDC copy the shared contents on the next change in
+ * either thread.
+ *
+ * \sa DiagnosticContextGuard, bindDiagnosticContext(),
+ * withDiagnosticContext()
+ */
+class LOG4CPLUS_EXPORT DiagnosticContextHandle
+{
+public:
+    //! Creates handle of empty context.
+    DiagnosticContextHandle ();
+    DiagnosticContextHandle (MappedDiagnosticContextPtr mdc,
+        DiagnosticContextStackPtr ndc);
+
+    //! \return Current context of the calling thread.
+    static DiagnosticContextHandle capture ();
+
+    /**
+     * Replaces context of the calling thread with this one.
+     *
+     * \return Context the thread had before.
+     */
+    DiagnosticContextHandle install () const;
+
+    MappedDiagnosticContextPtr const & getMDC () const;
+    DiagnosticContextStackPtr const & getNDC () const;
+
+    //! \return <code>true</code> if neither MDC nor NDC has any value.
+    bool empty () const;
+
+private:
+    MappedDiagnosticContextPtr mdc;
+    DiagnosticContextStackPtr ndc;
+};
+
+
+/**
+ * Installs context in the calling thread for its lifetime and then
+ * restores the context the thread had. It has to be destroyed by the
+ * thread that created it.
+ */
+class LOG4CPLUS_EXPORT DiagnosticContextGuard
+{
+public:
+    explicit DiagnosticContextGuard (DiagnosticContextHandle const & context);
+    ~DiagnosticContextGuard ();
+
+    DiagnosticContextGuard (DiagnosticContextGuard const &) = delete;
+    DiagnosticContextGuard & operator = (
+        DiagnosticContextGuard const &) = delete;
+
+private:
+    DiagnosticContextHandle saved;
+    //! Joined NDC messages of the saved context, see NDC::get().
+    tstring savedNDCFull;
+    bool savedNDCFullValid;
+};
+
+
+/**
+ * \return Callable that runs <code>func</code> with context of the
+ * calling thread installed, in whichever thread it is called.
+ */
+template <typename Func>
+auto
+bindDiagnosticContext (Func && func)
+{
+    return [context = DiagnosticContextHandle::capture (),
+        func = std::forward<Func> (func)] (auto &&... args) mutable
+        -> decltype (auto)
+    {
+        DiagnosticContextGuard guard (context);
+        return func (std::forward<decltype (args)> (args)...);
+    };
+}
+
+
+#if defined (LOG4CPLUS_HAVE_COROUTINES)
+
+namespace detail
+{
+
+template <typename Awaitable>
+decltype (auto)
+get_awaiter (Awaitable && awaitable)
+{
+    if constexpr (requires {
+            std::forward<Awaitable> (awaitable).operator co_await (); })
+        return std::forward<Awaitable> (awaitable).operator co_await ();
+    else if constexpr (requires {
+            operator co_await (std::forward<Awaitable> (awaitable)); })
+        return operator co_await (std::forward<Awaitable> (awaitable));
+    else
+        return std::forward<Awaitable> (awaitable);
+}
+
+} // namespace detail
+
+
+/**
+ * Awaiter that captures MDC and NDC when the coroutine suspends and
+ * installs them in the thread that resumes it, see
+ * withDiagnosticContext().
+ */
+template <typename Awaitable>
+class DiagnosticContextAwaiter
+{
+public:
+    typedef std::remove_cvref_t<decltype (detail::get_awaiter (
+        std::declval<Awaitable> ()))> awaiter_type;
+
+    explicit DiagnosticContextAwaiter (Awaitable && awaitable)
+        : awaiter (detail::get_awaiter (std::forward<Awaitable> (awaitable)))
+    { }
+
+    bool
+    await_ready ()
+    {
+        return awaiter.await_ready ();
+    }
+
+    template <typename Promise>
+    decltype (auto)
+    await_suspend (std::coroutine_handle<Promise> handle)
+    {
+        // The coroutine can be resumed before await_suspend() returns.
+        context = DiagnosticContextHandle::capture ();
+        suspended = true;
+        return awaiter.await_suspend (handle);
+    }
+
+    decltype (auto)
+    await_resume ()
+    {
+        if (suspended)
+            context.install ();
+
+        return awaiter.await_resume ();
+    }
+
+private:
+    awaiter_type awaiter;
+    DiagnosticContextHandle context;
+    bool suspended = false;
+};
+
+
+/**
+ * Wraps <code>awaitable</code> so that the coroutine awaiting it keeps
+ * its MDC and NDC if it is resumed by another thread:
+ *
+ * <pre>
+ *     co_await log4cplus::withDiagnosticContext (socket.async_read ());
+ * </pre>
+ *
+ * The context replaces the one of the resuming thread, executors that
+ * resume coroutines should do so under DiagnosticContextGuard to keep
+ * their own context.
+ */
+template <typename Awaitable>
+DiagnosticContextAwaiter<Awaitable>
+withDiagnosticContext (Awaitable && awaitable)
+{
+    return DiagnosticContextAwaiter<Awaitable> (
+        std::forward<Awaitable> (awaitable));
+}
+
+#endif // LOG4CPLUS_HAVE_COROUTINES
+
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_DIAGNOSTIC_CONTEXT_HEADER_
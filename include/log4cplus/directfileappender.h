@@ -0,0 +1,240 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    directfileappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_DIRECT_FILE_APPENDER_HEADER_
+#define LOG4CPLUS_DIRECT_FILE_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/appender.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+
+namespace log4cplus
+{
+
+namespace internal
+{
+
+class io_uring_writer;
+struct direct_io_segment;
+
+} // namespace internal
+
+
+/**
+ * Appends log events to a file using the operating system's file API
+ * directly, bypassing iostreams and their locale machinery. Formatted
+ * events are encoded as UTF-8 (in UNICODE builds; narrow builds write
+ * characters as they are) and written using <code>writev()</code>
+ * (<code>WriteFile()</code> on Windows).
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>File</tt></dt>
+ * <dd>This property specifies output file name.</dd>
+ *
+ * <dt><tt>Append</tt></dt>
+ * <dd>When it is set true, output file will be appended to
+ * instead of being truncated at opening.</dd>
+ *
+ * <dt><tt>AtomicAppend</tt></dt>
+ * <dd>When it is set true (the default), the file is opened with
+ * <code>O_APPEND</code> (<code>FILE_APPEND_DATA</code> on Windows) so
+ * that each write lands at the end of the file even when several
+ * processes log into it. Each write contains only whole records,
+ * therefore <tt>UseLockFile</tt> is not needed.</dd>
+ *
+ * <dt><tt>BufferSize</tt></dt>
+ * <dd>Non-zero value makes the appender gather records and write
+ * them once at least this many bytes are waiting. Buffered records
+ * are written at the latest when the appender is closed. By default,
+ * each event is written immediately.</dd>
+ *
+ * <dt><tt>CreateDirs</tt></dt>
+ * <dd>Set this property to <tt>true</tt> if you want to create
+ * missing directories in path leading to log file.</dd>
+ *
+ * <dt><tt>SyncWrites</tt></dt>
+ * <dd>Set this property to <tt>true</tt> to make each write durable
+ * with <code>fdatasync()</code> (<code>FlushFileBuffers()</code> on
+ * Windows) before the next one is done.</dd>
+ *
+ * <dt><tt>IoUring</tt></dt>
+ * <dd>Set this property to <tt>true</tt> to submit writes through
+ * io_uring on Linux. The appender then does not wait for the writes
+ * to complete; up to four of them, each from a buffer registered with
+ * the kernel, are in flight. Events are formatted right into these
+ * buffers. A write starts only after the previous
+ * ones have completed, so records stay in order. With
+ * <tt>SyncWrites</tt> the sync is linked to the write and submitted
+ * together with it. The property is honoured only when log4cplus is
+ * built with io_uring support; otherwise, or when the ring cannot be
+ * set up, e.g., because the kernel does not support it, the appender
+ * writes with <code>writev()</code>.</dd>
+ *
+ * <dt><tt>DirectIO</tt></dt>
+ * <dd>Set this property to <tt>true</tt> to write around the page
+ * cache, with <code>O_DIRECT</code> (<code>F_NOCACHE</code> on macOS,
+ * <code>FILE_FLAG_NO_BUFFERING</code> on Windows), so that high
+ * volume of logging does not evict other data from the cache.
+ * Records are collected in a buffer of <tt>SegmentSize</tt> bytes
+ * aligned for the device, which is written once it is full. The
+ * partial last segment is written, padded and then truncated back,
+ * when the file is closed or rolled over. Events are thus not in the
+ * file until a segment fills up, and only one process may write the
+ * file; <tt>Append</tt> keeps working, <tt>AtomicAppend</tt>,
+ * <tt>BufferSize</tt> and <tt>IoUring</tt> are ignored. When the file
+ * system does not support direct I/O, the segments are written
+ * through the page cache.</dd>
+ *
+ * <dt><tt>SegmentSize</tt></dt>
+ * <dd>Size of the <tt>DirectIO</tt> segment. Suffixes "KB" and "MB"
+ * are recognized. Defaults to 1 MB; it is rounded up to a multiple of
+ * 4 KB.</dd>
+ *
+ * <dt><tt>MaxFileSize</tt></dt>
+ * <dd>With <tt>DirectIO</tt>, the file is rolled over like
+ * RollingFileAppender does it when the next event would make it
+ * longer than this. Suffixes "KB" and "MB" are recognized. Zero, the
+ * default, disables the rollover.</dd>
+ *
+ * <dt><tt>MaxBackupIndex</tt></dt>
+ * <dd>Number of backup files kept by the rollover. Defaults to 1.</dd>
+ * </dl>
+ */
+class LOG4CPLUS_EXPORT DirectFileAppender
+    : public Appender
+{
+public:
+    DirectFileAppender (tstring const & filename, bool append = false,
+        bool atomicAppend = true, bool createDirs = false);
+    DirectFileAppender (helpers::Properties const & properties);
+    virtual ~DirectFileAppender ();
+
+    virtual void close ();
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+    virtual void appendBatch (
+        std::span<spi::InternalLoggingEvent const> events);
+
+    void open ();
+    bool isOpen () const;
+
+    //! Writes <code>pending</code> followed by <code>record</code>
+    //! using a single system call where possible and clears
+    //! <code>pending</code>.
+    void writeRecords (std::string const & record);
+
+    //! Appends <code>event</code> encoded as UTF-8 to
+    //! <code>output</code>. In narrow builds the layout formats it
+    //! right into <code>output</code>.
+    void formatRecord (spi::InternalLoggingEvent const & event,
+        std::string & output);
+
+    //! Same as formatRecord() for all <code>events</code>, formatted
+    //! by Layout::formatBatch().
+    void formatRecords (std::span<spi::InternalLoggingEvent const> events,
+        std::string & output);
+
+    tstring filename;
+    bool appendMode;
+    bool atomicAppend;
+    bool createDirs;
+    bool syncWrites;
+    bool useIoUring;
+    unsigned long bufferSize;
+
+    //! Encoded records waiting to be written.
+    std::string pending;
+
+    //! Encoded current record.
+    std::string record;
+
+#if defined (_WIN32)
+    //! File HANDLE.
+    void * handle;
+#else
+    int fd;
+#endif
+
+    //! Submits writes when <tt>IoUring</tt> is in use, otherwise null.
+    std::unique_ptr<internal::io_uring_writer> ring;
+
+    bool directIO;
+    std::size_t segmentSize;
+    unsigned long maxFileSize;
+    unsigned int maxBackupIndex;
+
+    //! Collects records when <tt>DirectIO</tt> is in use, otherwise
+    //! null.
+    std::unique_ptr<internal::direct_io_segment> segment;
+
+    //! Adds <code>record</code> to <code>segment</code> and writes
+    //! the segment whenever it fills up.
+    void appendDirect (std::string const & record);
+
+    //! Writes the partial last segment and cuts off its padding.
+    void writeSegmentTail ();
+
+    //! Rolls the file over in <tt>DirectIO</tt> mode.
+    void rollover ();
+
+private:
+    //! \returns Buffer events are formatted into: a buffer of
+    //! <code>ring</code>, which is then written without copying, or
+    //! <code>pending</code>.
+    std::string & outputBuffer ();
+
+    //! Writes contents of outputBuffer().
+    void writeOutput ();
+
+    void syncFile ();
+    void openFile (bool truncate);
+    void closeFile ();
+    bool openDirect (bool truncate);
+    bool writeAt (char const * data, std::size_t size,
+        std::uint64_t offset);
+
+    DirectFileAppender (DirectFileAppender const &);
+    DirectFileAppender & operator = (DirectFileAppender const &);
+};
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_DIRECT_FILE_APPENDER_HEADER_
@@ -0,0 +1,101 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    emergency.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+/** @file
+ * Emergency logging path for crash handlers. */
+
+#ifndef LOG4CPLUS_EMERGENCY_HEADER_
+#define LOG4CPLUS_EMERGENCY_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/appender.h>
+#include <log4cplus/loglevel.h>
+#include <cstddef>
+
+
+namespace log4cplus
+{
+
+//! Maximal number of appenders registered for the emergency path.
+constexpr std::size_t EMERGENCY_APPENDERS_MAX = 16;
+
+/**
+ * Registers <code>appender</code> for the emergency path and reserves
+ * <code>bufferSize</code> bytes for its emergency lines. Calls
+ * Appender::prepareEmergency(). The registry keeps a reference to the
+ * appender.
+ *
+ * Appenders which override Appender::emergencyWrite(), e.g., file and
+ * console appenders, receive the lines. Appenders which override
+ * Appender::emergencyDump(), e.g., AsyncAppender, give their backlog
+ * to emergencyFlush().
+ *
+ * \return <code>false</code> if <code>EMERGENCY_APPENDERS_MAX</code>
+ * appenders are already registered.
+ */
+LOG4CPLUS_EXPORT bool addEmergencyAppender (
+    SharedAppenderPtr const & appender, std::size_t bufferSize = 4096);
+
+/**
+ * Unregisters <code>appender</code>. It waits for emergency writes in
+ * progress, so it must not be called from a signal handler.
+ */
+LOG4CPLUS_EXPORT void removeEmergencyAppender (
+    SharedAppenderPtr const & appender);
+
+/**
+ * Writes line with current time, <code>ll</code>, <code>logger</code>
+ * and <code>message</code> to all registered appenders. It does not
+ * allocate memory, take locks or use streams; it is async-signal-safe
+ * as long as Appender::emergencyWrite() of the registered appenders
+ * is. Lines longer than the reserved buffer are truncated.
+ * Registered appenders whose buffer is in use by another thread are
+ * skipped.
+ */
+LOG4CPLUS_EXPORT void emergencyLog (LogLevel ll, char const * logger,
+    char const * message) noexcept;
+
+/**
+ * Writes events kept in memory by the registered appenders, e.g.,
+ * queued by AsyncAppender, to all registered appenders, in the same
+ * form as emergencyLog(). It is async-signal-safe under the same
+ * conditions. Events are read without synchronization with the
+ * threads that own them; the dump is a best effort.
+ */
+LOG4CPLUS_EXPORT void emergencyFlush () noexcept;
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_EMERGENCY_HEADER_
@@ -0,0 +1,97 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    etwappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_ETW_APPENDER_HEADER_
+#define LOG4CPLUS_ETW_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#if defined (LOG4CPLUS_HAVE_TRACELOGGING)
+
+#include <log4cplus/appender.h>
+
+
+namespace log4cplus
+{
+
+/**
+ * Writes events to Event Tracing for Windows through TraceLogging
+ * provider <tt>log4cplus</tt>, GUID
+ * <tt>{2f76fada-f0bd-529c-9207-3fe9c7569176}</tt>, derived from the
+ * name, so that sessions can enable it by name. No manifest is needed.
+ *
+ * Each event is written as event <tt>LogEvent</tt> with typed fields
+ * <tt>Level</tt>, <tt>Logger</tt>, <tt>Thread</tt>, <tt>Message</tt>
+ * and <tt>MDC</tt>, the latter as <tt>key=value</tt> pairs separated
+ * by semicolons. The ETW level follows LogLevel: FATAL is critical,
+ * DEBUG and TRACE are verbose. The layout is not used.
+ *
+ * The appender reports through hasConsumers() whether a session
+ * listens at the level of an event. Loggers whose other appenders do
+ * not want the event are then not enabled for it, so events nobody
+ * consumes are not even built.
+ */
+class LOG4CPLUS_EXPORT EtwAppender
+    : public Appender
+{
+public:
+    EtwAppender ();
+    EtwAppender (helpers::Properties const & properties);
+    virtual ~EtwAppender ();
+
+    virtual void close ();
+
+    //! \return <code>true</code> if an ETW session listens at level
+    //! of <code>ll</code>.
+    virtual bool hasConsumers (LogLevel ll) const;
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+
+    void init ();
+
+    //! Buffer for MDC field, reused between events.
+    tstring mdcBuffer;
+
+private:
+    EtwAppender (EtwAppender const &);
+    EtwAppender & operator = (EtwAppender const &);
+};
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_HAVE_TRACELOGGING
+
+#endif // LOG4CPLUS_ETW_APPENDER_HEADER_
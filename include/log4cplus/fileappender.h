@@ -32,16 +32,38 @@
 
 #include <log4cplus/appender.h>
 #include <log4cplus/fstreams.h>
+#include <log4cplus/helpers/bloomfilter.h>
+#include <log4cplus/helpers/fileinfo.h>
 #include <log4cplus/helpers/timehelper.h>
 #include <log4cplus/helpers/lockfile.h>
+#include <atomic>
+#include <cstdint>
 #include <fstream>
+#include <functional>
 #include <locale>
 #include <memory>
+#include <vector>
 
 
 namespace log4cplus
 {
 
+    namespace internal
+    {
+        struct background_file_tasks;
+        struct file_sync_state;
+        struct filename_template;
+    }
+
+    //! Compression of rolled over files, see <tt>Compression</tt>
+    //! property of RollingFileAppender and TimeBasedRollingFileAppender.
+    enum RolledFileCompression { NO_COMPRESSION, GZIP_COMPRESSION,
+                                 ZSTD_COMPRESSION };
+
+    //! When file appenders make written events durable, see
+    //! <tt>SyncPolicy</tt> property of FileAppenderBase.
+    enum FileSyncPolicy { SYNC_NONE, SYNC_INTERVAL, SYNC_GROUP_COMMIT };
+
     /**
      * Base class for Appenders writing log events to a file.
      * It is constructed with uninitialized file object, so all
@@ -50,7 +72,14 @@ namespace log4cplus
      * <h3>Properties</h3>
      * <dl>
      * <dt><tt>File</tt></dt>
-     * <dd>This property specifies output file name.</dd>
+     * <dd>This property specifies output file name. Each
+     * <tt>%pid</tt> in the name is replaced by id of the process, so
+     * that processes sharing the configuration write into separate
+     * files and need no <tt>UseLockFile</tt>. FileAppender and
+     * RollingFileAppender switch to the file of the child process on
+     * the first event appended after <code>fork()</code>; events still
+     * buffered at the fork are written by both processes, so the
+     * stream should be flushed before forking.</dd>
      *
      * <dt><tt>ImmediateFlush</tt></dt>
      * <dd>When it is set true, output stream will be flushed after
@@ -70,6 +99,39 @@ namespace log4cplus
      * stream using a buffer of given size.
      * </dd>
      *
+     * <dt><tt>FlushBytes</tt></dt>
+     * <dd>Non-zero value of this property makes the appender buffer
+     * output and flush it once at least this many characters have
+     * been written since the last flush. Unless <tt>BufferSize</tt>
+     * is set, it also sets the stream buffer size so that the writes
+     * are combined. It overrides <tt>ImmediateFlush</tt>.
+     * </dd>
+     *
+     * <dt><tt>FlushIntervalMs</tt></dt>
+     * <dd>Non-zero value of this property makes the appender buffer
+     * output and flush it at the latest this many milliseconds after
+     * the first unflushed write. The flushes are done by a timer
+     * thread shared by all file appenders. It can be combined with
+     * <tt>FlushBytes</tt> and it overrides <tt>ImmediateFlush</tt>.
+     * </dd>
+     *
+     * <dt><tt>SyncPolicy</tt></dt>
+     * <dd>This property says when written events are forced to the
+     * storage device by <code>fdatasync()</code>. With <tt>None</tt>,
+     * the default, they are left to the OS. <tt>Interval</tt> syncs
+     * the file every <tt>SyncIntervalMs</tt> milliseconds, on the
+     * timer thread used by <tt>FlushIntervalMs</tt>.
+     * <tt>GroupCommit</tt> syncs the file on demand: a thread calling
+     * waitForDurableLogging() blocks until a sync covers the events
+     * it has appended. Threads waiting at the same time share one
+     * sync, and appending is not blocked while the sync runs.
+     * </dd>
+     *
+     * <dt><tt>SyncIntervalMs</tt></dt>
+     * <dd>Interval of the <tt>Interval</tt> sync policy, in
+     * milliseconds. Defaults to 1000.
+     * </dd>
+     *
      * <dt><tt>UseLockFile</tt></dt>
      * <dd>Set this property to <tt>true</tt> if you want your output
      * to go into a log file shared by multiple processes. When this
@@ -102,6 +164,15 @@ namespace log4cplus
      * \sa spi::getLocaleFactoryRegistry()
      * </dd>
      *
+     * <dt><tt>Encoding</tt></dt>
+     * <dd>Set this property to <tt>UTF-8</tt> to write UTF-8 regardless
+     * of the <tt>Locale</tt> property. Formatted events are then
+     * transcoded in bulk by a built-in conversion instead of the
+     * locale's one. The default value is <tt>Locale</tt>, which keeps
+     * the conversion of the imbued locale. It only matters in UNICODE
+     * builds.
+     * </dd>
+     *
      * <dt><tt>CreateDirs</tt></dt>
      * <dd>Set this property to <tt>true</tt> if you want to create
      * missing directories in path leading to log file and lock file.
@@ -126,6 +197,38 @@ namespace log4cplus
       //! \returns Locale imbued in fstream.
         virtual std::locale getloc () const;
 
+      //! Sets flush policy, see <tt>FlushBytes</tt> and
+      //! <tt>FlushIntervalMs</tt> properties. Zero disables the
+      //! respective limit.
+        void setFlushPolicy (unsigned long bytes, unsigned long intervalMs);
+
+      //! Sets compression of rolled over files. Compression methods
+      //! not available in this build are ignored with a warning.
+        void setCompression (RolledFileCompression compression);
+
+      //! Flushes the stream and forces events appended so far to the
+      //! storage device.
+      //! \returns <code>false</code> if the sync has failed or if
+      //! <tt>SyncPolicy</tt> is <tt>None</tt>.
+        bool sync ();
+
+      //! Blocks until the first <code>event</code> events counted
+      //! since the file has been opened are on the storage device.
+      //! Concurrent callers share one sync.
+      //! \returns <code>false</code> if the sync covering the event
+      //! has failed or if <tt>SyncPolicy</tt> is <tt>None</tt>.
+        bool waitForSync (std::uint64_t event);
+
+      //! Opens the current file once more, for appending by
+      //! emergencyWrite().
+        virtual void prepareEmergency ();
+
+      //! Writes <code>data</code> by <code>write()</code> at the end
+      //! of the current file. Characters waiting in the stream buffer
+      //! are not written.
+        virtual bool emergencyWrite (const char * data, std::size_t size)
+            noexcept;
+
     protected:
       // Ctors
         FileAppenderBase(const log4cplus::tstring& filename,
@@ -138,10 +241,21 @@ namespace log4cplus
         void init();
 
         virtual void append(const spi::InternalLoggingEvent& event);
+        virtual void appendBatch(
+            std::span<spi::InternalLoggingEvent const> events);
 
         virtual void open(std::ios_base::openmode mode);
         bool reopen();
 
+        //! \returns <code>true</code> when flushing is controlled by
+        //! <code>flushBytes</code> and <code>flushInterval</code>.
+        bool hasFlushPolicy () const
+        { return flushBytes != 0 || flushInterval != 0; }
+
+        //! Flushes output stream after writing <code>written</code>
+        //! characters, according to the flush settings.
+        void flushAfterWrite (std::size_t written);
+
       // Data
         /**
          * Immediate flush means that the underlying writer or output stream
@@ -180,18 +294,207 @@ namespace log4cplus
         log4cplus::tofstream out;
         log4cplus::tstring filename;
         log4cplus::tstring localeName;
+
+        //! Output is encoded as UTF-8 by internal::with_utf8_codecvt()
+        //! instead of the imbued locale, see <tt>Encoding</tt> property.
+        bool utf8Encoding;
+
         log4cplus::tstring lockFileName;
         std::ios_base::openmode fileOpenMode;
 
         log4cplus::helpers::Time reopen_time;
 
+        /**
+         * When this variable is true, append() does not flush the
+         * output stream. It is set by appendBatch() which flushes the
+         * stream only once after the whole batch has been written.
+         */
+        bool deferFlush;
+
+        /**
+         * Flush the stream once this many characters are waiting to be
+         * flushed. Zero disables the limit.
+         */
+        unsigned long flushBytes;
+
+        /**
+         * Longest time written characters may wait to be flushed, in
+         * milliseconds. Zero disables the limit.
+         */
+        unsigned long flushInterval;
+
+        //! Count of characters written since the last flush.
+        std::size_t unflushed;
+
+        //! Time of the last flush, used when there is no timer thread.
+        log4cplus::helpers::Time lastFlush;
+
+        //! Compression of rolled over files.
+        RolledFileCompression compression;
+
+        //! \returns Name that rolled over file <code>file</code> gets
+        //! once it is compressed.
+        log4cplus::tstring getCompressedFilename (
+            const log4cplus::tstring& file) const;
+
+        /**
+         * Runs <code>task</code> on the internal thread pool, if it is
+         * available, without holding <code>access_mutex</code>. Tasks
+         * of one appender run one after another in submission order.
+         * They are used for work on rolled over files, e.g., shifting
+         * of backups, compression and history cleanup.
+         */
+        void runInBackground (std::function<void ()> task);
+
+        //! Waits until tasks started by runInBackground() finish.
+        void waitForBackgroundTasks ();
+
+        /**
+         * Writes already formatted event <code>str</code> and flushes
+         * the stream as configured. It is used by append().
+         *
+         * @return <code>false</code> if the file is not open and it
+         * cannot be reopened.
+         */
+        bool appendFormatted (const log4cplus::tstring& str);
+
+        /**
+         * Opens file of the current process when the file name has
+         * <tt>%pid</tt> placeholders and the process has forked since
+         * the file was opened.
+         *
+         * @return <code>true</code> if other file has been opened.
+         */
+        bool switchShard ();
+
+        //! File name with <tt>%pid</tt> placeholders, empty if the name
+        //! has none.
+        log4cplus::tstring shardPattern;
+
+        //! Process whose file is open when <code>shardPattern</code>
+        //! is not empty.
+        unsigned long shardProcess;
+
+        //! Sync policy, see <tt>SyncPolicy</tt> property.
+        FileSyncPolicy syncPolicy;
+
+        //! Interval of <code>SYNC_INTERVAL</code> policy, in
+        //! milliseconds.
+        unsigned long syncInterval;
+
+        //! Count of events appended while <code>syncPolicy</code> is
+        //! not <code>SYNC_NONE</code>.
+        std::uint64_t appendedEvents;
+
+        /**
+         * Descriptor of the current file used for syncing it, -1 when
+         * <code>syncPolicy</code> is <code>SYNC_NONE</code>. Derived
+         * classes which open files by other means than open() have to
+         * call openSyncFile() after the file is opened.
+         */
+        int syncFd;
+
+        //! Syncs and closes the previous <code>syncFd</code> and opens
+        //! the current file for syncing. Also reopens
+        //! <code>emergencyFd</code>.
+        void openSyncFile ();
+
+        //! Descriptor of the current file opened for appending by
+        //! emergencyWrite(), -1 until prepareEmergency() is called.
+        std::atomic<int> emergencyFd;
+
+        //! Set by prepareEmergency().
+        bool emergencyPrepared;
+
+        //! Replaces <code>emergencyFd</code> with the current file
+        //! after prepareEmergency() has been called.
+        void openEmergencyFile ();
+
+        //! Reads <tt>Index</tt>, <tt>IndexEvery</tt> and
+        //! <tt>IndexIntervalMs</tt> properties of the appenders which
+        //! support them.
+        void initIndex (const log4cplus::helpers::Properties& properties);
+
+        //! Opens index of the current file, see <tt>Index</tt>
+        //! property of RollingFileAppender. The index is truncated if
+        //! <code>truncate</code> is <code>true</code>. The first event
+        //! appended afterwards always gets an entry.
+        void openIndex (bool truncate);
+
+        //! \returns <code>true</code> if event with time stamp
+        //! <code>time</code> gets an entry in the index, according to
+        //! <code>indexEvery</code> and <code>indexInterval</code>.
+        bool indexDue (log4cplus::helpers::Time const & time);
+
+        //! Writes index entry of event with time stamp
+        //! <code>time</code> that starts at byte <code>offset</code>.
+        void writeIndex (log4cplus::helpers::Time const & time,
+            long long offset);
+
+        //! Write index of the file, see <tt>Index</tt> property.
+        bool useIndex;
+
+        //! Index of the open file.
+        std::ofstream indexOut;
+
+        //! Write index entry for every this many events. Zero disables
+        //! the limit.
+        unsigned long indexEvery;
+
+        //! Write index entry at least this many milliseconds after the
+        //! previous one. Zero disables the limit.
+        unsigned long indexInterval;
+
+        //! Count of events appended since the last index entry.
+        unsigned long unindexed;
+
+        //! Time stamp of the last index entry.
+        log4cplus::helpers::Time lastIndexTime;
+
     private:
+        LOG4CPLUS_PRIVATE void flushNow ();
+        LOG4CPLUS_PRIVATE void timedFlush ();
+        LOG4CPLUS_PRIVATE void updateFlushTimer ();
+        LOG4CPLUS_PRIVATE bool syncFile (std::uint64_t & target);
+        LOG4CPLUS_PRIVATE void updateSyncTimer ();
+
+        //! Indicates whether or not this appender is registered with
+        //! the shared flush timer thread.
+        bool flushTimerRegistered;
+
+        //! State shared with background tasks.
+        std::shared_ptr<internal::background_file_tasks> backgroundTasks;
+
+        //! Progress of syncs, shared by threads waiting for them.
+        std::shared_ptr<internal::file_sync_state> syncState;
+
+        //! Indicates whether or not the <tt>Interval</tt> sync is
+        //! registered with the shared flush timer thread.
+        bool syncTimerRegistered;
+
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+        //! Time of the last <tt>Interval</tt> sync.
+        log4cplus::helpers::Time lastSync;
+#endif
+
       // Disallow copying of instances of this class
         FileAppenderBase(const FileAppenderBase&);
         FileAppenderBase& operator=(const FileAppenderBase&);
     };
 
 
+    /**
+     * Blocks until events appended by the calling thread to file
+     * appenders with <tt>GroupCommit</tt> sync policy are on the
+     * storage device. It covers events appended synchronously since
+     * the previous call, not events handed over to <tt>AsyncAppend</tt>
+     * or other threads.
+     *
+     * @return <code>false</code> if a sync has failed.
+     */
+    LOG4CPLUS_EXPORT bool waitForDurableLogging ();
+
+
     /**
      * Appends log events to a file.
      *
@@ -237,7 +540,78 @@ namespace log4cplus
      * <dd>This property limits the number of backup output
      * files; e.g. how many <tt>log.1</tt>, <tt>log.2</tt> etc. files
      * will be kept.</dd>
+     *
+     * <dt><tt>Compression</tt></dt>
+     * <dd>Set this property to <tt>gzip</tt> or <tt>zstd</tt> to
+     * compress each rolled over file on a background thread. The
+     * backups are then named <tt>log.1.gz</tt>, <tt>log.2.gz</tt> etc.
+     * (<tt>.zst</tt> for zstd). The compression methods are
+     * available only when log4cplus is built with zlib or zstd,
+     * respectively.</dd>
+     *
+     * <dt><tt>Preallocate</tt></dt>
+     * <dd>Set this property to <tt>true</tt> to reserve disk space for
+     * the whole <tt>MaxFileSize</tt> when the file is opened, so that
+     * it does not get fragmented by many small appends. The file size
+     * visible to readers stays the size of the written data; space left
+     * unused is released when the file is rolled over or closed. It is
+     * supported where <code>fallocate()</code> is available and it is
+     * ignored elsewhere.</dd>
+     *
+     * <dt><tt>Index</tt></dt>
+     * <dd>Set this property to <tt>true</tt> to write index of the
+     * file into <tt>File</tt> with <tt>.idx</tt> appended. It has an
+     * entry for each indexed event: its time stamp in microseconds
+     * since epoch and offset of its first byte in the file, both as
+     * 64-bit little endian integers. Index of a backup is named after
+     * the backup, e.g., <tt>log.1.idx</tt>. With <tt>%pid</tt> in
+     * <tt>File</tt> the indices let <tt>log4cplus-merge</tt> interleave
+     * files of all processes in order of time; that needs an entry for
+     * every event. <tt>log4cplus-cat</tt> uses the index to seek to a
+     * time range, for which sparse index is enough. The index is
+     * flushed together with the file only when the file is flushed
+     * after each event; otherwise it can lag behind the file until the
+     * next rollover or close.</dd>
+     *
+     * <dt><tt>IndexEvery</tt></dt>
+     * <dd>Write index entry only for every this many events. Defaults
+     * to 1, that is, every event, unless <tt>IndexIntervalMs</tt> is
+     * set, then it defaults to 0 which disables the limit.</dd>
+     *
+     * <dt><tt>IndexIntervalMs</tt></dt>
+     * <dd>Write index entry for the first event at least this many
+     * milliseconds after the previous entry. An event gets an entry
+     * when any of the limits is reached. The first event in a file
+     * always gets one. Zero, the default, disables the limit.</dd>
+     *
+     * <dt><tt>BloomKeys</tt></dt>
+     * <dd>Comma separated list of MDC keys, e.g.,
+     * <tt>traceId,userId</tt>. When set, the appender keeps a Bloom
+     * filter over the values of these keys in events written into the
+     * file and writes it into <tt>File</tt> with <tt>.bloom</tt>
+     * appended when the file is rolled over or closed. The filter of a
+     * backup is named after the backup, e.g., <tt>log.1.bloom</tt>.
+     * <tt>log4cplus-find</tt> checks the filters and reads only the
+     * files which can contain a value. A file appended to after a
+     * crash, which did not leave a filter behind, gets no filter. It
+     * is not supported with <tt>UseLockFile</tt>.</dd>
+     *
+     * <dt><tt>BloomExpectedValues</tt></dt>
+     * <dd>Number of distinct values per file the filter is sized for.
+     * Defaults to 100000.</dd>
+     *
+     * <dt><tt>BloomFalsePositiveRate</tt></dt>
+     * <dd>Probability that the filter reports a value that the file
+     * does not contain, at <tt>BloomExpectedValues</tt> values.
+     * Defaults to 0.01, which takes about 1.2 bytes per value.</dd>
      * </dl>
+     *
+     * <p>Rollover only renames the active file aside (to
+     * <tt>log.rolling.N</tt>) and reopens it. Shifting of the backups
+     * and compression then run on a background thread. With
+     * <tt>UseLockFile</tt> set, the backups are shifted during the
+     * rollover while the lock file is held, as other processes
+     * coordinate through it.
      */
     class LOG4CPLUS_EXPORT RollingFileAppender : public FileAppender {
     public:
@@ -252,16 +626,62 @@ namespace log4cplus
       // Dtor
         virtual ~RollingFileAppender();
 
+      // Methods
+        virtual void close();
+
+      //! Adds MDC field to required fields when <tt>BloomKeys</tt> is
+      //! set.
+        virtual unsigned getRequiredEventFields() const;
+
     protected:
         virtual void append(const spi::InternalLoggingEvent& event);
         void rollover(bool alreadyLocked = false);
 
+      //! Adds values of <tt>BloomKeys</tt> of the event to the filter
+      //! of the file.
+        void addBloomValues(const spi::InternalLoggingEvent& event);
+
+      //! Writes the filter of the closed file next to it.
+        void saveBloomFilter();
+
       // Data
         long maxFileSize;
         int maxBackupIndex;
 
+      //! Serial number used to name files moved aside by rollover()
+      //! before the backups are shifted.
+        unsigned long rolloverSerial;
+
+      //! Size of the file as tracked by the appender, so that it does
+      //! not need to query the stream after each write.
+        long fileSize;
+
+      //! Identity of the open file, used to detect rollovers done by
+      //! other processes when <tt>UseLockFile</tt> is set.
+        helpers::FileInfo fileInfo;
+
+      //! Reserve <tt>MaxFileSize</tt> bytes of disk space for the file.
+        bool preallocate;
+
+      //! MDC keys whose values are added to the Bloom filter.
+        std::vector<tstring> bloomKeys;
+        std::size_t bloomExpectedValues;
+        double bloomFalsePositiveRate;
+        helpers::BloomFilter bloomFilter;
+
+      //! The filter covers all events of the file, so that it can be
+      //! written next to it.
+        bool bloomComplete;
+
+      //! Updates file size and index after a file has been opened.
+        void fileOpened();
+
     private:
         LOG4CPLUS_PRIVATE void init(long maxFileSize, int maxBackupIndex);
+        LOG4CPLUS_PRIVATE void updateFileInfo();
+        LOG4CPLUS_PRIVATE void initBloomFilter(
+            const log4cplus::helpers::Properties& properties);
+        LOG4CPLUS_PRIVATE void openBloomFilter();
     };
 
 
@@ -368,7 +788,12 @@ namespace log4cplus
      *
      * <dt><tt>MaxHistory</tt></dt>
      * <dd>The optional maxHistory property controls the maximum number of
-     * archive files to keep, deleting older files.</dd>
+     * archive files to keep, deleting older files. Archives are removed
+     * on a background thread. When the directory part of the pattern has
+     * no date fields and its file name part has only numeric ones,
+     * including the year, old archives are found by one listing of the
+     * directory, whatever their age; otherwise only names of the periods
+     * since the last clean up are tried.</dd>
      *
      * <dt><tt>CleanHistoryOnStart</tt></dt>
      * <dd>If set to true, archive removal will be executed on appender start
@@ -380,6 +805,20 @@ namespace log4cplus
      * with legacy code, however it may lead to undesired behaviour
      * as described in the github issue #120.</dd>
      *
+     * <dt><tt>Compression</tt></dt>
+     * <dd>Set this property to <tt>gzip</tt> or <tt>zstd</tt> to
+     * compress each rolled over file on a background thread. The
+     * compressed archive gets <tt>.gz</tt> (<tt>.zst</tt> for zstd)
+     * appended to its name. <tt>MaxHistory</tt> cleaning removes
+     * both compressed and uncompressed archives.</dd>
+     *
+     * <dt><tt>Index</tt>, <tt>IndexEvery</tt>,
+     * <tt>IndexIntervalMs</tt></dt>
+     * <dd>Write index of the file as described at
+     * RollingFileAppender. Index of an archive is named after the
+     * uncompressed archive with <tt>.idx</tt> appended and it is
+     * removed together with the archive.</dd>
+     *
      * </dl>
      */
     class LOG4CPLUS_EXPORT TimeBasedRollingFileAppender : public FileAppenderBase {
@@ -403,6 +842,9 @@ namespace log4cplus
         void close();
         void rollover(bool alreadyLocked = false);
         void clean(helpers::Time time);
+        //! \returns Task that removes files older than
+        //! <tt>MaxHistory</tt>; see clean().
+        std::function<void ()> cleanTask(helpers::Time time);
         helpers::Time::duration getRolloverPeriodDuration() const;
         helpers::Time calculateNextRolloverTime(const helpers::Time& t) const;
 
@@ -415,6 +857,8 @@ namespace log4cplus
         log4cplus::helpers::Time lastHeartBeat;
         log4cplus::helpers::Time nextRolloverTime;
         bool rollOnClose;
+        //! <code>filenamePattern</code> compiled for clean().
+        std::shared_ptr<internal::filename_template const> filenameTemplate;
 
     private:
         LOG4CPLUS_PRIVATE void init();
@@ -31,11 +31,15 @@
 #endif
 
 #include <log4cplus/tstring.h>
+#include <log4cplus/loglevel.h>
 #include <log4cplus/helpers/pointer.h>
 #include <log4cplus/spi/appenderattachable.h>
 #include <log4cplus/thread/syncprims.h>
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <span>
 #include <vector>
 
 
@@ -48,13 +52,30 @@ namespace log4cplus {
         class LOG4CPLUS_EXPORT AppenderAttachableImpl
             : public log4cplus::spi::AppenderAttachable
         {
+        private:
+            //! Storage of <code>appender_list_mutex</code> unless it has
+            //! been given to the constructor.
+            std::unique_ptr<thread::Mutex> own_appender_list_mutex;
+
         public:
           // Data
-            thread::Mutex appender_list_mutex;
+            /**
+             * Serializes modifications of the appenders list. The append
+             * loop does not lock it, it uses the current snapshot instead.
+             * It can be shared with other objects.
+             */
+            thread::Mutex & appender_list_mutex;
 
           // Ctors
             AppenderAttachableImpl();
 
+            /**
+             * Uses <code>listMutex</code>, which has to outlive this
+             * object, as <code>appender_list_mutex</code>. Loggers share
+             * a few mutexes of their hierarchy this way.
+             */
+            explicit AppenderAttachableImpl(thread::Mutex & listMutex);
+
           // Dtor
             virtual ~AppenderAttachableImpl();
 
@@ -102,17 +123,68 @@ namespace log4cplus {
             virtual void removeAppender(const log4cplus::tstring& name);
 
             /**
-             * Call the <code>doAppend</code> method on all attached appenders.
+             * Call the <code>doAppend</code> method on all attached
+             * appenders. The list is skipped as a whole when the event is
+             * under the thresholds of all of them, see getMinThreshold().
+             *
+             * @return Number of attached appenders.
              */
             int appendLoopOnAppenders(const spi::InternalLoggingEvent& event) const;
 
+            /**
+             * Call the <code>doAppendBatch</code> method on all attached
+             * appenders.
+             */
+            int appendLoopOnAppenders(
+                std::span<spi::InternalLoggingEvent const> events) const;
+
         protected:
           // Types
             typedef std::vector<SharedAppenderPtr> ListType;
+            typedef std::shared_ptr<ListType> ListPtr;
+
+          // Methods
+            /**
+             * Returns the current snapshot of the appenders list. It can be
+             * null if there are no appenders.
+             */
+            ListPtr getAppenderList() const;
+
+            /**
+             * Publishes new snapshot of the appenders list and returns the
+             * previous one.
+             * NOTE: This method has to be called with the
+             * <code>appender_list_mutex</code> locked.
+             */
+            ListPtr setAppenderList(ListPtr list);
+
+            /**
+             * Returns the lowest threshold of the attached appenders, see
+             * Appender::getThreshold(). Events of lower log levels would
+             * be rejected by all of them. Thresholds under
+             * ALL_LOG_LEVEL, i.e., NOT_SET_LOG_LEVEL, count as
+             * ALL_LOG_LEVEL.
+             */
+            LogLevel getMinThreshold() const;
 
           // Data
-            /** Array of appenders. */
-            ListType appenderList;
+            /**
+             * Immutable snapshot of the array of appenders. Modifications
+             * copy the current snapshot and swap the pointer atomically.
+             */
+            std::atomic<ListPtr> appenderList;
+
+        private:
+            LOG4CPLUS_PRIVATE std::uint64_t getListSummary() const;
+
+            /**
+             * Cached minimal threshold and count of the appenders in
+             * <code>appenderList</code>. The upper 32 bits hold the
+             * internal::pre_filter_generation it has been computed at,
+             * then 16 bits of the count and 16 bits of the threshold,
+             * both saturated.
+             */
+            mutable std::atomic<std::uint64_t> listSummary;
         };  // end class AppenderAttachableImpl
 
     } // end namespace helpers
@@ -0,0 +1,96 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    bloomfilter.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+/** @file */
+
+#ifndef LOG4CPLUS_HELPERS_BLOOMFILTER_HEADER_
+#define LOG4CPLUS_HELPERS_BLOOMFILTER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <log4cplus/tstring.h>
+
+
+namespace log4cplus::helpers {
+
+
+/**
+ * Bloom filter over key/value pairs, e.g., MDC values written into a
+ * log file. A pair that was added is always reported as possibly
+ * contained; other pairs are reported so with about the false positive
+ * rate the filter was sized for. Values are hashed in UTF-8, so files
+ * written by char and wchar_t builds can be read by both.
+ */
+class LOG4CPLUS_EXPORT BloomFilter
+{
+public:
+    //! Empty filter that contains nothing and cannot be added to,
+    //! until one is loaded.
+    BloomFilter ();
+
+    //! Filter sized for <code>expectedValues</code> distinct pairs at
+    //! <code>falsePositiveRate</code>.
+    BloomFilter (std::size_t expectedValues, double falsePositiveRate);
+
+    void add (tstring_view key, tstring_view value);
+
+    //! \return <code>false</code> if the pair certainly was not added.
+    bool mightContain (tstring_view key, tstring_view value) const;
+
+    //! Writes the filter into file <code>name</code>.
+    //! \return <code>false</code> when the file cannot be written.
+    bool save (tstring const & name) const;
+
+    //! Replaces the filter by one written by save() into file
+    //! <code>name</code>.
+    //! \return <code>false</code> when the file is missing or
+    //! malformed; the filter is then left unchanged.
+    bool load (tstring const & name);
+
+    std::size_t getBitCount () const { return bits.size () * 64; }
+    unsigned getHashCount () const { return hashes; }
+
+private:
+    std::vector<std::uint64_t> bits;
+    unsigned hashes;
+};
+
+
+} // namespace log4cplus::helpers
+
+#endif // LOG4CPLUS_HELPERS_BLOOMFILTER_HEADER_
@@ -0,0 +1,140 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    bufferstream.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef LOG4CPLUS_HELPERS_BUFFERSTREAM_H
+#define LOG4CPLUS_HELPERS_BUFFERSTREAM_H
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/streams.h>
+#include <log4cplus/tstring.h>
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+
+namespace log4cplus { namespace helpers {
+
+
+//! Stream buffer writing into a growable character buffer. Unlike
+//! <code>std::basic_stringbuf</code> it gives up its storage only in
+//! clear() over a capacity limit, so a stream reused for every event
+//! stops allocating once it has grown to the longest message.
+class LOG4CPLUS_EXPORT buffer_streambuf
+    : public std::basic_streambuf<tchar>
+{
+public:
+    buffer_streambuf ();
+    ~buffer_streambuf () override;
+
+    buffer_streambuf (buffer_streambuf const &) = delete;
+    buffer_streambuf & operator = (buffer_streambuf const &) = delete;
+
+    //! \return Characters written since the last clear().
+    tstring_view
+    view () const noexcept
+    {
+        return tstring_view (pbase (),
+            static_cast<std::size_t> (pptr () - pbase ()));
+    }
+
+    //! \return Number of characters the buffer holds without growing.
+    std::size_t
+    capacity () const noexcept
+    {
+        return buf.size ();
+    }
+
+    //! Grows the buffer to hold at least <code>n</code> characters.
+    void reserve (std::size_t n);
+
+    //! Empties the buffer. Its storage is released if its capacity is
+    //! over <code>limit</code>, otherwise it is kept. Zero means no
+    //! limit.
+    void clear (std::size_t limit = 0);
+
+protected:
+    int_type overflow (int_type ch) override;
+    std::streamsize xsputn (char_type const * s, std::streamsize n)
+        override;
+
+private:
+    void grow (std::size_t n);
+    void set_put_area (std::size_t size);
+
+    std::vector<tchar> buf;
+};
+
+
+//! Output stream writing into a buffer_streambuf. It stands in for
+//! <code>tostringstream</code> where the stream is reused.
+class LOG4CPLUS_EXPORT buffer_ostream
+    : public tostream
+{
+public:
+    buffer_ostream ();
+    ~buffer_ostream () override;
+
+    buffer_ostream (buffer_ostream const &) = delete;
+    buffer_ostream & operator = (buffer_ostream const &) = delete;
+
+    buffer_streambuf *
+    rdbuf () const noexcept
+    {
+        return const_cast<buffer_streambuf *>(&buf);
+    }
+
+    //! \return Characters written since the last clear of the buffer.
+    tstring_view
+    view () const noexcept
+    {
+        return buf.view ();
+    }
+
+    //! \return Copy of view().
+    tstring
+    str () const
+    {
+        return tstring (view ());
+    }
+
+private:
+    buffer_streambuf buf;
+};
+
+
+} } // namespace log4cplus { namespace helpers
+
+
+#endif // LOG4CPLUS_HELPERS_BUFFERSTREAM_H
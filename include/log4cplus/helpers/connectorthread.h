@@ -34,11 +34,20 @@
 #include <log4cplus/thread/syncprims.h>
 #include <log4cplus/thread/threads.h>
 #include <log4cplus/helpers/socket.h>
+#include <memory>
 
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
 
-namespace log4cplus { namespace helpers {
+namespace log4cplus {
+
+namespace internal {
+
+struct reconnect_backoff;
+
+} // namespace internal
+
+namespace helpers {
 
 
 class LOG4CPLUS_EXPORT ConnectorThread;
@@ -87,6 +96,16 @@ public:
     //! This function triggers (`trigger_ev`) connection check and
     //! attempt to re-connect a broken connection, when necessary.
     void trigger ();
+
+    //! Makes the pause after failed connection attempt start at
+    //! <code>initialDelay</code> milliseconds and double with each
+    //! following failure up to <code>maxDelay</code>. Each pause is
+    //! randomly shortened by up to a half. Threads which pass the same
+    //! non-empty <code>key</code>, e.g., host and port of their server,
+    //! share the pause and do not try to connect at the same time. The
+    //! default is a 5 second pause.
+    void setReconnectBackoff (tstring const & key, unsigned initialDelay,
+        unsigned maxDelay);
     
 protected:
     //! reference to ConnectorThread's client
@@ -95,8 +114,15 @@ protected:
     //! This event is the re-connection trigger.
     thread::ManualResetEvent trigger_ev;
 
+    //! Signaled by terminate(); it cuts short the pause after failed
+    //! connection attempt.
+    thread::ManualResetEvent exit_ev;
+
     //! When this variable set to true when ConnectorThread is signaled to 
     bool exit_flag;
+
+    //! Pause after failed connection attempt.
+    std::shared_ptr<internal::reconnect_backoff> backoff;
 };
 
 
@@ -47,6 +47,11 @@ struct LOG4CPLUS_EXPORT FileInfo
     helpers::Time mtime;
     bool is_link;
     off_t size;
+
+    //! Device and inode identify the file. They are zero where the
+    //! platform does not provide them.
+    dev_t device;
+    ino_t inode;
 };
 
 
@@ -48,6 +48,10 @@ public:
     void lock () const;
     void unlock () const;
 
+    //! Takes the lock if no other process holds it.
+    //! \return <code>true</code> if the lock has been taken.
+    bool try_lock () const;
+
 private:
     void open (int) const;
     void close () const;
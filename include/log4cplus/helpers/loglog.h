@@ -33,11 +33,28 @@
 #include <log4cplus/tstring.h>
 #include <log4cplus/streams.h>
 #include <log4cplus/thread/syncprims.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
 
 
 namespace log4cplus {
     namespace helpers {
 
+        //! Counters of LogLog warnings and errors, see LogLog::getStats().
+        struct LogLogStats
+        {
+            //! Messages written out or passed to the asynchronous sink.
+            std::uint64_t emitted = 0;
+            //! Repeats suppressed within the deduplication window.
+            std::uint64_t deduplicated = 0;
+            //! Messages suppressed by the per second limit.
+            std::uint64_t rateLimited = 0;
+            //! Messages dropped because the asynchronous sink lagged.
+            std::uint64_t dropped = 0;
+        };
+
         /**
          * This class used to output log statements from within the log4cplus package.
          *
@@ -101,6 +118,37 @@ namespace log4cplus {
             void warn(const log4cplus::tstring& msg) const;
             void warn(tchar const * msg) const;
 
+            /**
+             * Limits warnings and errors, e.g., of appenders retrying a
+             * connection to a collector that is down.
+             *
+             * @param messagesPerSecond At most this many messages are
+             * written out each second; 0 means no limit.
+             * @param dedupWindowMs Repeats of a message within this many
+             * milliseconds of its last output are suppressed; 0 disables
+             * deduplication.
+             *
+             * Numbers of suppressed messages are reported with the next
+             * message written out.
+             */
+            void setRateLimit(unsigned messagesPerSecond,
+                unsigned dedupWindowMs);
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+            /**
+             * Passes warnings and errors, including their prefixes, to
+             * <code>sink</code> on log4cplus' internal thread pool
+             * instead of writing them to <code>std::cerr</code>. The
+             * calling thread takes no lock; messages exceeding the queue
+             * capacity are dropped and counted. An empty function
+             * restores the default output.
+             */
+            void setAsyncSink(std::function<void (tstring const &)> sink);
+#endif
+
+            //! Returns counters of warnings and errors.
+            LogLogStats getStats() const;
+
             // Public ctor and dtor to be used only by internal::DefaultContext.
             LogLog();
             virtual ~LogLog();
@@ -119,18 +167,28 @@ namespace log4cplus {
                 bool (LogLog:: * cond) () const, tchar const *,
                 StringType const &, bool throw_flag = false) const;
 
-            LOG4CPLUS_PRIVATE static void set_tristate_from_env (TriState *,
+            LOG4CPLUS_PRIVATE static TriState get_tristate_from_env (
                 tchar const * envvar);
 
+            LOG4CPLUS_PRIVATE bool admit (tstring & text) const;
+            LOG4CPLUS_PRIVATE void emit (tostream & os, tstring const & text)
+                const;
+            LOG4CPLUS_PRIVATE void drain_async_sink () const;
+
             LOG4CPLUS_PRIVATE bool get_quiet_mode () const;
             LOG4CPLUS_PRIVATE bool get_not_quiet_mode () const;
             LOG4CPLUS_PRIVATE bool get_debug_mode () const;
 
             // Data
-            mutable TriState debugEnabled;
-            mutable TriState quietMode;
+            mutable std::atomic<TriState> debugEnabled;
+            mutable std::atomic<TriState> quietMode;
             thread::Mutex mutex;
 
+            struct Limiter;
+            struct AsyncSink;
+            std::unique_ptr<Limiter> limiter;
+            std::unique_ptr<AsyncSink> asyncSink;
+
             LOG4CPLUS_PRIVATE LogLog(const LogLog&);
             LOG4CPLUS_PRIVATE LogLog & operator = (LogLog const &);
         };
@@ -47,10 +47,12 @@ namespace log4cplus {
     namespace helpers {
 
         /******************************************************************************
-         *                       Class SharedObject (from pp. 204-205)                *
+         *                       Class SharedObjectBase                               *
          ******************************************************************************/
 
-        class LOG4CPLUS_EXPORT SharedObject
+        //! Reference counted base of SharedObject without the access mutex,
+        //! for objects created in large numbers, e.g., loggers.
+        class LOG4CPLUS_EXPORT SharedObjectBase
         {
         public:
             void addReference() const LOG4CPLUS_NOEXCEPT;
@@ -58,30 +60,21 @@ namespace log4cplus {
 
         protected:
           // Ctor
-            SharedObject()
-                : access_mutex()
-                , count__(0)
-            { }
-
-            SharedObject(const SharedObject&)
-                : access_mutex()
-                , count__(0)
-            { }
-
-            SharedObject(SharedObject &&)
-                : access_mutex()
-                , count__(0)
-            { }
+            SharedObjectBase() LOG4CPLUS_NOEXCEPT;
+            SharedObjectBase(const SharedObjectBase&) LOG4CPLUS_NOEXCEPT;
+            SharedObjectBase(SharedObjectBase &&) LOG4CPLUS_NOEXCEPT;
 
           // Dtor
-            virtual ~SharedObject();
+            virtual ~SharedObjectBase();
 
           // Operators
-            SharedObject& operator=(const SharedObject&) LOG4CPLUS_NOEXCEPT { return *this; }
-            SharedObject& operator=(SharedObject &&) LOG4CPLUS_NOEXCEPT { return *this; }
+            SharedObjectBase& operator=(const SharedObjectBase&) LOG4CPLUS_NOEXCEPT { return *this; }
+            SharedObjectBase& operator=(SharedObjectBase &&) LOG4CPLUS_NOEXCEPT { return *this; }
 
-        public:
-            thread::Mutex access_mutex;
+          // Methods
+            //! Destroys the object when its last reference is dropped. The
+            //! default implementation uses <code>delete</code>.
+            virtual void dispose() const;
 
         private:
 #if defined (LOG4CPLUS_SINGLE_THREADED)
@@ -93,6 +86,31 @@ namespace log4cplus {
         };
 
 
+        /******************************************************************************
+         *                       Class SharedObject (from pp. 204-205)                *
+         ******************************************************************************/
+
+        class LOG4CPLUS_EXPORT SharedObject
+            : public SharedObjectBase
+        {
+        protected:
+          // Ctor
+            SharedObject();
+            SharedObject(const SharedObject&);
+            SharedObject(SharedObject &&);
+
+          // Dtor
+            virtual ~SharedObject();
+
+          // Operators
+            SharedObject& operator=(const SharedObject&) LOG4CPLUS_NOEXCEPT { return *this; }
+            SharedObject& operator=(SharedObject &&) LOG4CPLUS_NOEXCEPT { return *this; }
+
+        public:
+            thread::Mutex access_mutex;
+        };
+
+
         /******************************************************************************
          *           Template Class SharedObjectPtr (from pp. 203, 206)               *
          ******************************************************************************/
@@ -190,14 +208,14 @@ namespace log4cplus {
         //! @{
         inline
         void
-        intrusive_ptr_add_ref (SharedObject const * so)
+        intrusive_ptr_add_ref (SharedObjectBase const * so)
         {
             so->addReference();
         }
 
         inline
         void
-        intrusive_ptr_release (SharedObject const * so)
+        intrusive_ptr_release (SharedObjectBase const * so)
         {
             so->removeReference();
         }
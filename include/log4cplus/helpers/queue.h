@@ -33,7 +33,15 @@
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
 
-#include <deque>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <condition_variable>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/thread/threads.h>
 #include <log4cplus/thread/syncprims.h>
@@ -42,7 +50,71 @@
 namespace log4cplus { namespace thread {
 
 
+//! Size of cache line assumed by the queue for padding of its shared
+//! fields and slots.
+constexpr std::size_t queue_cache_line_size = LOG4CPLUS_CACHE_LINE_SIZE;
+
+
+//! Snapshot of queue state, see Queue::get_stats().
+struct QueueStats
+{
+    //! Maximal number of queued events.
+    std::size_t capacity = 0;
+
+    //! Number of events queued at the time of the snapshot.
+    std::size_t depth = 0;
+
+    //! Largest depth seen so far.
+    std::size_t highWaterMark = 0;
+
+    //! Number of producers that had to wait for room in the queue.
+    std::uint64_t blockedPuts = 0;
+
+    //! Total time producers waited for room in the queue.
+    std::chrono::nanoseconds blockedTime {0};
+
+    //! Number of batches taken by the consumer.
+    std::uint64_t batches = 0;
+
+    //! Total number of events in these batches.
+    std::uint64_t batchedEvents = 0;
+
+    //! Largest batch taken by the consumer.
+    std::size_t maxBatch = 0;
+
+    //! Time since the oldest queued event has been logged, zero when
+    //! the queue is empty or when it is not tracked.
+    std::chrono::microseconds oldestEventAge {0};
+
+    //! Approximate footprint of queued events, in bytes, see
+    //! Queue::set_max_bytes().
+    std::size_t queuedBytes = 0;
+
+    //! Limit of queuedBytes, zero if unlimited.
+    std::size_t maxBytes = 0;
+};
+
+
+//! Callback invoked with the current queue depth when it reaches
+//! configured high-water threshold.
+typedef std::function<void (std::size_t depth)> HighWaterCallback;
+
+
 //! Single consumer, multiple producers queue.
+//!
+//! The queue is a bounded ring buffer of preallocated event slots.
+//! Producers claim a slot by atomic increment of the tail position and
+//! publish it by bumping the slot's sequence number. The consumer takes
+//! published slots in order. Producers can also discard the oldest
+//! published slot to make room for new events. Neither side takes a
+//! lock unless the queue is full (producers) or empty (consumer) and
+//! the thread has to sleep.
+//!
+//! Slots hold InternalLoggingEvent objects, not serialized records.
+//! The consumer empties events it has processed and hands their
+//! storage back to the slots it takes, so that events put into slots
+//! reuse the capacity of their strings. A batch never holds more than
+//! total_capacity() events.
 class LOG4CPLUS_EXPORT Queue
     : public virtual helpers::SharedObject
 {
@@ -51,8 +123,11 @@ public:
     typedef unsigned flags_type;
 
     //! Queue storage type.
-    typedef std::deque<spi::InternalLoggingEvent> queue_storage_type;
+    typedef std::vector<spi::InternalLoggingEvent> queue_storage_type;
 
+    //! \param len Maximal length of the queue. The capacity of the
+    //! ring buffer is rounded up to the nearest power of two, at least
+    //! two; the rounding is reported through helpers::LogLog::debug().
     explicit Queue (unsigned len = 100);
     virtual ~Queue ();
 
@@ -65,24 +140,79 @@ public:
     // Producers' methods.
 
     //! Puts event <code>ev</code> into queue, sets QUEUE flag and
-    //! sets internal event object into signaled state. If the EXIT
-    //! flags is already set upon entering the function, nothing is
-    //! inserted into the queue. The function can block on internal
-    //! semaphore if the queue has reached maximal allowed
-    //! length. Calling thread is unblocked either by consumer thread
-    //! removing item from queue or by any other thread calling
-    //! signal_exit().
+    //! wakes up the consumer if it is waiting. If the EXIT flags is
+    //! already set upon entering the function, nothing is inserted
+    //! into the queue. The function can block if the queue has
+    //! reached maximal allowed length. Calling thread is unblocked
+    //! either by consumer thread removing item from queue or by any
+    //! other thread calling signal_exit().
+    //!
+    //! \param ev spi::InternalLoggingEvent to be put into the queue.
+    //! \param fields Combination of spi::EventFields captured in the
+    //! queued copy of <code>ev</code>.
+    //! \return Flags.
+    flags_type put_event (spi::InternalLoggingEvent const & ev,
+        unsigned fields = spi::EVENT_FIELDS_ALL);
+
+    //! Puts event <code>ev</code> into queue like put_event() but
+    //! never blocks. If the queue is full, the event is not inserted
+    //! and FULL flag is set in the return value.
     //!
     //! \param ev spi::InternalLoggingEvent to be put into the queue.
+    //! \param fields Combination of spi::EventFields captured in the
+    //! queued copy of <code>ev</code>.
     //! \return Flags.
-    flags_type put_event (spi::InternalLoggingEvent const & ev);
+    flags_type try_put_event (spi::InternalLoggingEvent const & ev,
+        unsigned fields = spi::EVENT_FIELDS_ALL);
+
+    //! Removes the oldest event from the queue without passing it to
+    //! the consumer.
+    //!
+    //! \return True if an event has been discarded.
+    bool discard_oldest ();
+
+    //! \return True if there is no published event in the queue and
+    //! in its lanes.
+    bool empty () const;
 
-    //! Sets EXIT flag and DRAIN flag and sets internal event object
-    //! into signaled state.
+    //! \return True if the queue is empty, no producer is putting an
+    //! event into it and the consumer waits for events, so it does not
+    //! hold locks of appenders it appends to. Used by fork handlers.
+    bool idle () const;
+
+    //! Sets EXIT flag and DRAIN flag and wakes up both the consumer
+    //! and any blocked producers.
     //! \param drain If true, DRAIN flag will be set, otherwise unset.
     //! \return Flags, ERROR_BIT can be set upon error.
     flags_type signal_exit (bool drain = true);
 
+    // Lanes.
+
+    //! Adds lane of maximal length <code>len</code>. Producers put
+    //! events into the lane through get_lane(). The consumer of this
+    //! queue takes events of the lanes, in the order of their
+    //! addition, before the events of this queue, so events put into a
+    //! lane are not stuck behind a backlog of this queue. Order is
+    //! preserved within a lane only. Lanes have to be added before the
+    //! queue is used.
+    //! \return Index of the lane.
+    std::size_t add_lane (unsigned len);
+
+    //! \return Number of lanes added by add_lane().
+    std::size_t lane_count () const;
+
+    //! \return Lane with index <code>i</code>. It is an ordinary queue,
+    //! except that it has no consumer of its own.
+    Queue & get_lane (std::size_t i) const;
+
+    //! Makes producers stamp each queued event with key/value field
+    //! <code>key</code> holding a number increasing across this queue,
+    //! its lanes and its clones, so that output can be put back in
+    //! order. Empty
+    //! <code>key</code> disables the stamping. It has to be set before
+    //! the queue is used.
+    void set_sequence_key (tstring key);
+
     // Consumer's methods.
 
     //! The get_events() function is used by queue's consumer. It
@@ -100,10 +230,61 @@ public:
     //! Upon error, return value has one of the error flags set.
     //!
     //! \param buf Pointer to storage of spi::InternalLoggingEvent
-    //! instances to be filled from queue.
+    //! instances to be filled from queue. Events left in it by the
+    //! previous call are emptied and their storage is reused for
+    //! further events, so steady flow of events does not allocate.
     //! \return Flags.
     flags_type get_events (queue_storage_type * buf);
 
+    //! Passes published events, oldest first, to <code>visit</code>
+    //! without taking any lock and without consuming them. Events
+    //! being taken or refilled concurrently may be skipped or seen
+    //! torn, so it is meant for the emergency path only, see
+    //! Appender::emergencyDump().
+    void emergency_visit (
+        void (* visit) (spi::InternalLoggingEvent const &, void *),
+        void * arg) const noexcept;
+
+    // Instrumentation.
+
+    //! \return Statistics of the queue. Counters are read one by one
+    //! without stopping producers, so they need not be mutually
+    //! consistent.
+    QueueStats get_stats () const;
+
+    //! Sets <code>callback</code> that is called by a producer whose
+    //! event raises queue depth to <code>threshold</code>. The
+    //! callback is called again only after the consumer takes the
+    //! queue below the threshold. It runs on the producer's thread
+    //! and must not put events into this queue. Zero
+    //! <code>threshold</code> disables the callback.
+    void set_high_water_callback (std::size_t threshold,
+        HighWaterCallback callback);
+
+    //! Limits approximate footprint of queued events to
+    //! <code>bytes</code>, in addition to the limit of their count.
+    //! The footprint of an event is the size of the event object plus
+    //! the sizes of its message, NDC and captured MDC. An event that
+    //! does not fit waits, or fails with FULL flag when put by
+    //! try_put_event(), unless the queue is empty; a single event
+    //! larger than the limit is thus still queued. Zero
+    //! <code>bytes</code> removes the limit.
+    void set_max_bytes (std::size_t bytes);
+
+    //! \return Limit set by set_max_bytes().
+    std::size_t get_max_bytes () const;
+
+    //! Creates empty queue with the same capacity, byte limit,
+    //! high-water callback, lanes and sequence key. A child process created by fork() uses it in place of
+    //! this queue, whose synchronization objects can have waiters that
+    //! do not exist there.
+    Queue * clone_empty () const;
+
+    //! Creates empty queue with the same byte limit, high-water
+    //! callback, lanes and sequence key and with maximal length
+    //! <code>len</code>.
+    Queue * clone_empty (unsigned len) const;
+
     //! Possible state flags.
     enum Flags
     {
@@ -128,24 +309,188 @@ public:
 
         //! ERROR_AFTER signals error that has occurred after queue has
         //! already been touched.
-        ERROR_AFTER = 0x0020
+        ERROR_AFTER = 0x0020,
+
+        //! FULL flag is set in return value of try_put_event() if the
+        //! event has not been inserted because the queue is full.
+        FULL        = 0x0040
     };
 
 protected:
-    //! Queue storage.
-    queue_storage_type queue;
+    //! One slot of the ring buffer.
+    struct alignas (queue_cache_line_size) Slot
+    {
+        //! Sequence number of the slot. Value equal to a position
+        //! means the slot is free to be filled by the producer which
+        //! has claimed that position. Value equal to position + 1
+        //! means the slot has been published and can be consumed.
+        std::atomic<std::size_t> sequence;
+
+        //! False if producer failed to fill the slot. Such slots are
+        //! skipped by the consumer.
+        bool valid;
+
+        //! Event stored in the slot. Its storage is reused by
+        //! subsequent events.
+        spi::InternalLoggingEvent event;
+
+        //! Copy of the event's timestamp in microseconds since epoch
+        //! that can be read while the slot is queued.
+        std::atomic<std::int64_t> timestamp;
+
+        //! Footprint of the event reserved by its producer, released
+        //! together with the slot.
+        std::size_t bytes;
+    };
 
-    //! Mutex protecting queue and flags.
-    Mutex mutex;
+    //! Common implementation of put_event() and try_put_event().
+    flags_type put_event_impl (spi::InternalLoggingEvent const & ev,
+        unsigned fields, bool block);
 
-    //! Event on which consumer can wait if it finds queue empty.
-    ManualResetEvent ev_consumer;
+    //! Claims free slot without blocking.
+    //! \return False if the queue is full.
+    bool try_claim_slot (std::size_t & pos);
 
-    //! Semaphore that limits the queue length.
-    Semaphore sem;
+    //! Claims published slot at head position <code>pos</code>.
+    //! \return False if the slot has not been published.
+    bool try_take_head (std::size_t & pos, Slot * & slot);
+
+    //! Makes taken slot available to producers of the next lap.
+    void release_slot (Slot & slot, std::size_t pos);
+
+    //! Waits until slot for position <code>pos</code> is free.
+    //! \return False if the wait has been abandoned because of EXIT.
+    bool wait_for_free_slot (Slot & slot, std::size_t pos);
+
+    //! Waits until <code>ready()</code> returns true. Producers are
+    //! woken by wake_producers().
+    //! \return False if the wait has been abandoned because of EXIT.
+    template <typename Ready>
+    bool wait_producer (Ready ready);
+
+    //! Adds <code>bytes</code> to queued_bytes if they fit under
+    //! max_bytes or if nothing is queued.
+    //! \return False if they do not fit.
+    bool try_reserve_bytes (std::size_t bytes);
+
+    //! Returns bytes reserved by try_reserve_bytes().
+    void release_bytes (std::size_t bytes);
+
+    //! Wakes producers blocked in wait_for_free_slot(), if any.
+    void wake_producers ();
+
+    //! Takes all published slots and moves their events into
+    //! <code>buf</code>, or discards them if <code>buf</code> is null.
+    //! Taking stops once <code>buf</code> holds total_capacity() events
+    //! of the consumer queue. Slots whose events are moved get storage
+    //! of spare events of the consumer in exchange.
+    //! \return Number of slots taken.
+    std::size_t take_published (queue_storage_type * buf);
+
+    //! Empties events of <code>buf</code>, consumed since the previous
+    //! get_events() call, and keeps them as spare events before
+    //! clearing <code>buf</code>.
+    void recycle_events (queue_storage_type & buf);
+
+    //! \return Number of slots of this queue and its lanes.
+    std::size_t total_capacity () const;
+
+    //! True if slot at head position has been published.
+    bool head_published () const;
+
+    //! True if slot at head position of this queue or of any of its
+    //! lanes has been published.
+    bool any_published () const;
+
+    //! \return True if a producer is putting an event into this queue
+    //! or into any of its lanes.
+    bool any_active_producer () const;
+
+    //! \return Number of claimed and not yet consumed slots.
+    std::size_t current_depth () const;
+
+    //! Updates high-water mark with <code>depth</code> and calls
+    //! high-water callback if it is due.
+    void note_depth (std::size_t depth);
+
+    //! Accounts batch of <code>size</code> events taken by the
+    //! consumer and re-arms high-water callback.
+    void note_batch (std::size_t size);
+
+    //! Ring buffer storage, allocated from getMemoryResource().
+    std::pmr::vector<Slot> slots;
+
+    //! Mask to turn position into slot index.
+    std::size_t mask;
+
+    //! Position of the next slot to be claimed by producers.
+    alignas (queue_cache_line_size) std::atomic<std::size_t> tail;
+
+    //! Number of producers inside put_event().
+    std::atomic<std::size_t> active_producers;
+
+    //! Position of the next slot to be consumed. Advanced by the
+    //! consumer and by discard_oldest().
+    alignas (queue_cache_line_size) std::atomic<std::size_t> head;
 
     //! State flags.
-    flags_type flags;
+    alignas (queue_cache_line_size) std::atomic<flags_type> flags;
+
+    //! Set by consumer before it goes to sleep on ev_consumer.
+    std::atomic<bool> consumer_waiting;
+
+    //! Event on which consumer can wait if it finds queue empty.
+    ManualResetEvent ev_consumer;
+
+    //! Approximate footprint of events in claimed slots.
+    std::atomic<std::size_t> queued_bytes;
+
+    //! Limit of queued_bytes, zero if unlimited.
+    std::atomic<std::size_t> max_bytes;
+
+    //! Number of producers sleeping because the queue is full.
+    std::atomic<std::size_t> producers_waiting;
+
+    //! Mutex and condition used by producers waiting for free slot.
+    std::mutex producers_mutex;
+    std::condition_variable producers_cv;
+
+    //! Counters reported by get_stats().
+    std::atomic<std::size_t> high_water;
+    std::atomic<std::uint64_t> blocked_puts;
+    std::atomic<std::uint64_t> blocked_ns;
+    std::atomic<std::uint64_t> batches;
+    std::atomic<std::uint64_t> batched_events;
+    std::atomic<std::size_t> max_batch;
+
+    //! Consumed events emptied by recycle_events(). Their strings keep
+    //! their capacity, so events put into slots that get them in
+    //! exchange do not allocate, and consumed events are not destroyed
+    //! field by field. Used by the consumer only; lanes use the spare
+    //! events of their owner.
+    queue_storage_type spare_events;
+
+    //! Lanes added by add_lane().
+    std::vector<helpers::SharedObjectPtr<Queue>> lanes;
+
+    //! Queue whose consumer takes events of this lane, null if this
+    //! queue is not a lane.
+    Queue * owner;
+
+    //! Key of sequence field, empty if events are not stamped.
+    tstring sequence_key;
+
+    //! Next sequence number, shared with clones of this queue; lanes
+    //! use the one of their owner.
+    std::shared_ptr<std::atomic<std::uint64_t>> next_sequence;
+
+    //! High-water threshold, zero if disabled.
+    std::atomic<std::size_t> high_water_threshold;
+    //! Cleared when the callback is called, set again by the
+    //! consumer when depth falls below the threshold.
+    std::atomic<bool> high_water_armed;
+    mutable std::mutex high_water_mutex;
+    HighWaterCallback high_water_callback;
 };
 
 
@@ -155,6 +500,24 @@ typedef helpers::SharedObjectPtr<Queue> QueuePtr;
 } } // namespace log4cplus { namespace thread {
 
 
+namespace log4cplus {
+
+
+//! \return Statistics of the queue of events waiting for appenders
+//! with <tt>AsyncAppend=true</tt> in the internal thread pool. Batches
+//! are events appended by one worker in a row. Age of the oldest event
+//! is not tracked.
+LOG4CPLUS_EXPORT thread::QueueStats getThreadPoolQueueStats ();
+
+//! Sets callback called when depth of the thread pool queue reaches
+//! <code>threshold</code>, see thread::Queue::set_high_water_callback().
+LOG4CPLUS_EXPORT void setThreadPoolHighWaterCallback (std::size_t threshold,
+    thread::HighWaterCallback callback);
+
+
+} // namespace log4cplus
+
+
 #endif // LOG4CPLUS_SINGLE_THREADED
 
 #endif // LOG4CPLUS_HELPERS_QUEUE_H
@@ -31,7 +31,10 @@
 #endif
 
 #include <array>
+#include <memory>
 #include <optional>
+#include <span>
+#include <string_view>
 
 #include <log4cplus/tstring.h>
 #include <log4cplus/helpers/socketbuffer.h>
@@ -52,8 +55,39 @@ namespace log4cplus {
 
         typedef std::ptrdiff_t SOCKET_TYPE;
 
+        class TlsChannel;
+        class TlsContext;
+
         extern LOG4CPLUS_EXPORT SOCKET_TYPE const INVALID_SOCKET_VALUE;
 
+
+        //! Options of client connections, see connectSocket().
+        struct SocketOptions
+        {
+            //! Disables Nagle's algorithm (<code>TCP_NODELAY</code>).
+            bool noDelay = true;
+
+            //! Size of send buffer (<code>SO_SNDBUF</code>), in bytes;
+            //! 0 keeps the system default.
+            std::size_t sendBufferSize = 0;
+
+            //! Enables TCP keep-alive probes (<code>SO_KEEPALIVE</code>).
+            bool keepAlive = false;
+
+            //! Seconds of idle connection before the first keep-alive
+            //! probe, seconds between probes and number of unanswered
+            //! probes after which the connection is dropped. 0 keeps
+            //! the system default; not every system supports them.
+            unsigned keepAliveIdle = 0;
+            unsigned keepAliveInterval = 0;
+            unsigned keepAliveCount = 0;
+
+            //! Milliseconds for which addresses of resolved host name are
+            //! reused by following connections to the same host and
+            //! port; 0 resolves the name every time.
+            unsigned dnsCacheTtl = 0;
+        };
+
         class LOG4CPLUS_EXPORT AbstractSocket {
         public:
             AbstractSocket();
@@ -89,17 +123,47 @@ namespace log4cplus {
             Socket(SOCKET_TYPE sock, SocketState state, int err);
             Socket(const tstring& address, unsigned short port,
                 bool udp = false, bool ipv6 = false);
+            Socket(const tstring& address, unsigned short port,
+                bool udp, bool ipv6, SocketOptions const & options);
             Socket(Socket &&) LOG4CPLUS_NOEXCEPT;
             virtual ~Socket();
 
             Socket & operator = (Socket &&) LOG4CPLUS_NOEXCEPT;
 
           // methods
+            virtual void close();
+
+            //! Performs TLS handshake using <code>context</code>; all
+            //! following reads and writes are encrypted. The socket is
+            //! closed when the handshake fails.
+            //! \return True if the handshake succeeded.
+            bool startTls(TlsContext & context);
+
+            //! \return TLS session of this socket, if any.
+            TlsChannel * getTlsChannel() const { return tls.get (); }
+
+            //! \return Bytes sent but not acknowledged by the peer yet,
+            //! see helpers::getUnsentBytes().
+            std::size_t getUnsentBytes() const;
+
             virtual bool read(SocketBuffer& buffer);
+
+            //! Reads at most <code>len</code> bytes through TLS channel,
+            //! if any, returning as soon as some are available. Closes
+            //! the socket on error or when peer closes the connection.
+            //! \return Number of bytes read, or 0 when closed.
+            std::size_t readSome(char * buffer, std::size_t len);
             virtual bool write(const SocketBuffer& buffer);
             virtual bool write(const std::string & buffer);
             virtual bool write(std::size_t bufferCount,
                 SocketBuffer const * const * buffers);
+            //! Sends all <code>buffers</code> with single system call,
+            //! without concatenating them first.
+            virtual bool write(std::span<std::string_view const> buffers);
+            //! Sends each buffer as separate datagram, several of them
+            //! with single system call where supported.
+            virtual bool writeDatagrams(
+                std::span<std::string_view const> datagrams);
 
             template <typename... Args>
             static bool write(Socket & socket, Args &&... args)
@@ -108,6 +172,11 @@ namespace log4cplus {
                     (&args)... };
                 return socket.write (sizeof... (args), buffers);
             }
+
+            void swap (Socket &);
+
+        protected:
+            std::unique_ptr<TlsChannel> tls;
         };
 
 
@@ -136,27 +205,76 @@ namespace log4cplus {
         };
 
 
+        //! Host names of form <code>unix://path</code>, e.g.,
+        //! <code>unix:///run/log.sock</code>, select local
+        //! (<code>AF_UNIX</code>) socket at <code>path</code> instead of
+        //! TCP or UDP one wherever a host name is accepted. Port and
+        //! IP version are ignored for them.
+        //! \return True if <code>host</code> is of that form;
+        //! <code>path</code> is set to its path then.
+        LOG4CPLUS_EXPORT bool parseUnixSocketHost (tstring const & host,
+            tstring & path);
+
         LOG4CPLUS_EXPORT SOCKET_TYPE openSocket(unsigned short port, bool udp,
             bool ipv6, SocketState& state);
+        //! Opens listening socket; <code>host</code> may name local
+        //! socket, see parseUnixSocketHost().
         LOG4CPLUS_EXPORT SOCKET_TYPE openSocket(tstring const & host,
             unsigned short port, bool udp, bool ipv6, SocketState& state);
 
         LOG4CPLUS_EXPORT SOCKET_TYPE connectSocket(const log4cplus::tstring& hostn,
             unsigned short port, bool udp, bool ipv6, SocketState& state);
+        //! Connects socket with <code>options</code> set before the
+        //! connection is made. Options which cannot be set are
+        //! reported through LogLog. Local sockets named by
+        //! <code>hostn</code>, see parseUnixSocketHost(), are connected
+        //! without options.
+        LOG4CPLUS_EXPORT SOCKET_TYPE connectSocket(const log4cplus::tstring& hostn,
+            unsigned short port, bool udp, bool ipv6, SocketState& state,
+            SocketOptions const & options);
+        //! Forgets addresses cached by connectSocket().
+        LOG4CPLUS_EXPORT void clearDnsCache ();
+        //! Connects local (<code>AF_UNIX</code>) socket bound to
+        //! filesystem <code>path</code>. On Linux, path starting with
+        //! '@' names socket in abstract namespace. On Windows, only
+        //! stream sockets are supported, where the SDK provides them.
+        LOG4CPLUS_EXPORT SOCKET_TYPE connectUnixSocket(tstring const & path,
+            bool datagram, SocketState& state);
+        //! Binds local socket to <code>path</code>, like
+        //! connectUnixSocket() names it, and listens on it unless it is
+        //! <code>datagram</code>. Stale socket file at the path is
+        //! removed first.
+        LOG4CPLUS_EXPORT SOCKET_TYPE openUnixSocket(tstring const & path,
+            bool datagram, SocketState& state);
         LOG4CPLUS_EXPORT SOCKET_TYPE acceptSocket(SOCKET_TYPE sock, SocketState& state);
         LOG4CPLUS_EXPORT int closeSocket(SOCKET_TYPE sock);
         LOG4CPLUS_EXPORT int shutdownSocket(SOCKET_TYPE sock);
 
         LOG4CPLUS_EXPORT long read(SOCKET_TYPE sock, SocketBuffer& buffer);
+
+        //! Reads at most <code>len</code> bytes, returning as soon as
+        //! some are available.
+        //! \return Number of bytes read, 0 on orderly shutdown, or -1.
+        LOG4CPLUS_EXPORT long readSome(SOCKET_TYPE sock, char * buffer,
+            std::size_t len);
         LOG4CPLUS_EXPORT long write(SOCKET_TYPE sock,
             const SocketBuffer& buffer);
         LOG4CPLUS_EXPORT long write(SOCKET_TYPE sock, std::size_t bufferCount,
             SocketBuffer const * const * buffers);
         LOG4CPLUS_EXPORT long write(SOCKET_TYPE sock,
             const std::string & buffer);
+        LOG4CPLUS_EXPORT long write(SOCKET_TYPE sock,
+            std::span<std::string_view const> buffers);
+        //! \return Number of datagrams sent, or -1 if none could be.
+        LOG4CPLUS_EXPORT long writeDatagrams(SOCKET_TYPE sock,
+            std::span<std::string_view const> datagrams);
 
         LOG4CPLUS_EXPORT std::optional<tstring> getHostname (bool fqdn);
         LOG4CPLUS_EXPORT int setTCPNoDelay (SOCKET_TYPE, bool);
+        //! \return Number of bytes written to <code>sock</code> that
+        //! the peer has not acknowledged yet, or 0 where the system
+        //! cannot tell.
+        LOG4CPLUS_EXPORT std::size_t getUnsentBytes (SOCKET_TYPE sock);
 
     } // end namespace helpers
 } // end namespace log4cplus
@@ -37,7 +37,9 @@ namespace log4cplus {
 namespace helpers {
 
 /**
- *
+ * Fixed capacity buffer used for socket messages. Storage of buffers
+ * up to 64 KiB comes from a per thread pool, so creating a buffer for
+ * each message does not allocate.
  */
 class LOG4CPLUS_EXPORT SocketBuffer
 {
@@ -51,6 +53,9 @@ public:
     void setSize(std::size_t s) { size = s; }
     std::size_t getPos() const { return pos; }
 
+    //! Resets size and position so that the buffer can be reused.
+    void clear() { size = 0; pos = 0; }
+
     unsigned char readByte();
     unsigned short readShort();
     unsigned int readInt();
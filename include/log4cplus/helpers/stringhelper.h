@@ -33,7 +33,9 @@
 #include <log4cplus/tstring.h>
 
 #include <algorithm>
+#include <charconv>
 #include <limits>
+#include <type_traits>
 
 
 namespace log4cplus {
@@ -95,112 +97,29 @@ namespace log4cplus {
         }
 
 
-        template <typename intType, typename stringType, bool isSigned>
-        struct ConvertIntegerToStringHelper;
-
-
-        template <typename intType, typename charType>
-        struct ConvertIntegerToStringHelper<intType, charType, true>
-        {
-            static inline
-            void
-            step1 (charType * & it, intType & value)
-            {
-                // The sign of the result of the modulo operator is
-                // implementation defined. That's why we work with
-                // positive counterpart instead.  Also, in twos
-                // complement arithmetic the smallest negative number
-                // does not have positive counterpart; the range is
-                // asymetric.  That's why we handle the case of value
-                // == min() specially here.
-                if (LOG4CPLUS_UNLIKELY (
-                    value == (std::numeric_limits<intType>::min) ()))
-                {
-                    intType const r = value / 10;
-                    intType const a = (-r) * 10;
-                    intType const mod = -(a + value);
-                    value = -r;
-
-                    *(it - 1)
-                        = static_cast<charType>(LOG4CPLUS_TEXT('0') + mod);
-                    --it;
-                }
-                else
-                    value = -value;
-            }
-
-            static
-            bool
-            is_negative (intType val)
-            {
-                return val < 0;
-            }
-        };
-
-
-        template <typename intType, typename charType>
-        struct ConvertIntegerToStringHelper<intType, charType, false>
-        {
-            static inline
-            void
-            step1 (charType * &, intType &)
-            {
-                // This will never be called for unsigned types.
-            }
-
-            static
-            bool
-            is_negative (intType)
-            {
-                return false;
-            }
-        };
-
-
+        /**
+         * Converts integer <code>value</code> to its decimal form in
+         * <code>str</code>. It uses std::to_chars() so the result does
+         * not depend on locale and nothing but <code>str</code> is
+         * allocated.
+         */
         template <class stringType, class intType>
         inline
         void
         convertIntegerToString (stringType & str, intType value)
         {
-            typedef std::numeric_limits<intType> intTypeLimits;
-            typedef typename stringType::value_type charType;
-            typedef ConvertIntegerToStringHelper<intType, charType,
-                intTypeLimits::is_signed> HelperType;
-
-            charType buffer[intTypeLimits::digits10 + 2];
-            const std::size_t buffer_size
-                = sizeof (buffer) / sizeof (charType);
-
-            charType * it = &buffer[buffer_size];
-            charType const * const buf_end = &buffer[buffer_size];
-
-            if (LOG4CPLUS_UNLIKELY (value == 0))
-            {
-                --it;
-                *it = LOG4CPLUS_TEXT('0');
-            }
-            else
-            {
-                bool const negative = HelperType::is_negative (value);
-                if (negative)
-                    HelperType::step1 (it, value);
-
-                for (; value != 0; --it)
-                {
-                    intType mod = value % 10;
-                    value = value / 10;
-                    *(it - 1) = static_cast<charType>(LOG4CPLUS_TEXT('0')
-                        + mod);
-                }
-
-                if (negative)
-                {
-                    --it;
-                    *it = LOG4CPLUS_TEXT('-');
-                }
-            }
-
-            str.assign (static_cast<charType const *>(it), buf_end);
+            static_assert (std::is_integral_v<intType>
+                && ! std::is_same_v<intType, bool>,
+                "convertIntegerToString() needs integer type");
+
+            // Sign and one more digit than digits10 guarantees.
+            char buffer[std::numeric_limits<intType>::digits10 + 2];
+            std::to_chars_result const res
+                = std::to_chars (buffer, buffer + sizeof (buffer), value);
+
+            // Widens digits for wide strings.
+            str.assign (static_cast<char const *> (buffer),
+                static_cast<char const *> (res.ptr));
         }
 
 
@@ -264,6 +183,50 @@ namespace log4cplus {
         }
 
 
+        //! \return Size of buffer that encodeUtf8() needs for
+        //! <code>units</code> wide characters.
+        constexpr
+        std::size_t
+        utf8MaxSize (std::size_t units)
+        {
+            return units * (sizeof (wchar_t) == 2 ? 3 : 4);
+        }
+
+
+        /**
+         * Encodes UTF-16 (2 byte wchar_t) or UTF-32 (4 byte wchar_t)
+         * string <code>src</code> as UTF-8 into <code>dest</code>, which
+         * has to have room for utf8MaxSize(src.size()) bytes. Unlike
+         * tostring(), it does not depend on locale and it does not
+         * allocate. Invalid characters and lone surrogates are replaced
+         * by U+FFFD.
+         *
+         * @return Number of bytes written.
+         */
+        LOG4CPLUS_EXPORT std::size_t encodeUtf8 (char * dest,
+            std::wstring_view src);
+
+        //! Appends <code>src</code> encoded by encodeUtf8() to
+        //! <code>out</code>.
+        LOG4CPLUS_EXPORT void appendUtf8 (std::string & out,
+            std::wstring_view src);
+
+        /**
+         * Decodes UTF-8 string <code>src</code> into <code>dest</code>,
+         * which has to have room for src.size() wide characters. Each
+         * byte of invalid or truncated sequences is replaced by U+FFFD.
+         *
+         * @return Number of wide characters written.
+         */
+        LOG4CPLUS_EXPORT std::size_t decodeUtf8 (wchar_t * dest,
+            std::string_view src);
+
+        //! Appends <code>src</code> decoded by decodeUtf8() to
+        //! <code>out</code>.
+        LOG4CPLUS_EXPORT void appendFromUtf8 (std::wstring & out,
+            std::string_view src);
+
+
     } // namespace helpers
 
 } // namespace log4cplus
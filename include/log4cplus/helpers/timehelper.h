@@ -52,6 +52,8 @@ namespace chrono = std::chrono;
 typedef chrono::system_clock Clock;
 typedef chrono::duration<long long, std::micro> Duration;
 typedef chrono::time_point<Clock, Duration> Time;
+//! Time with nanosecond resolution, see eventNowPrecise().
+typedef chrono::time_point<Clock, chrono::nanoseconds> PreciseTime;
 
 
 template <typename FromDuration>
@@ -71,6 +73,38 @@ now ()
 }
 
 
+//! Sources of logging event time stamps, see setEventClock().
+enum class EventClock : int
+{
+    //! std::chrono::system_clock, the default.
+    System,
+    //! CLOCK_REALTIME_COARSE where available. Its resolution is the
+    //! kernel tick, usually 1 to 4 ms, but it never enters the kernel.
+    Coarse,
+    //! CPU time stamp counter calibrated against the system clock and
+    //! re-synchronized with it every second. Used only with invariant
+    //! TSC, otherwise the system clock is used.
+    Tsc
+};
+
+
+/**
+ * Selects the clock time stamps of logging events are read from, for
+ * the whole process. Selecting <code>EventClock::Tsc</code> blocks for
+ * about 10 ms while the counter is calibrated.
+ */
+LOG4CPLUS_EXPORT void setEventClock (EventClock clock);
+
+LOG4CPLUS_EXPORT EventClock getEventClock ();
+
+//! \return Current time read from the clock selected by setEventClock().
+LOG4CPLUS_EXPORT Time eventNow ();
+
+//! \return Current time read from the clock selected by setEventClock(),
+//! with nanosecond resolution where the clock has it.
+LOG4CPLUS_EXPORT PreciseTime eventNowPrecise ();
+
+
 inline
 Time
 from_time_t (time_t t_time)
@@ -119,6 +153,16 @@ microseconds_part (Time const & the_time)
 }
 
 
+inline
+long
+nanoseconds_part (PreciseTime const & the_time)
+{
+    Time const time = chrono::floor<Duration> (the_time);
+    return microseconds_part (time) * 1000L
+        + static_cast<long>((the_time - time).count ());
+}
+
+
 inline
 Time
 time_from_parts (time_t tv_sec, long tv_usec)
@@ -155,6 +199,9 @@ void localTime (tm* t, Time const &);
  * <code>%q</code> - 3 character field that provides milliseconds
  * <code>%Q</code> - 7 character field that provides fractional
  * milliseconds.
+ * <code>%N</code> - 9 character field that provides nanoseconds; time
+ * stamps of <code>Time</code> have microsecond resolution, see
+ * spi::InternalLoggingEvent::getPreciseTimestamp().
  */
 LOG4CPLUS_EXPORT
 log4cplus::tstring getFormattedTime (log4cplus::tstring const & fmt,
@@ -0,0 +1,139 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    tlscontext.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_HELPERS_TLSCONTEXT_HEADER_
+#define LOG4CPLUS_HELPERS_TLSCONTEXT_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string_view>
+
+#include <log4cplus/tstring.h>
+#include <log4cplus/helpers/socket.h>
+
+
+namespace log4cplus::helpers {
+
+
+//! Settings of TLS context, see createTlsContext().
+struct LOG4CPLUS_EXPORT TlsConfig
+{
+    //! Accepting side of connections when true, connecting otherwise.
+    bool server = false;
+
+    //! File with trusted CA certificates in PEM format. When empty,
+    //! client uses system default trust store. Server requires
+    //! client certificates issued by these CAs when it is set.
+    tstring caFile;
+
+    //! Own certificate chain and private key in PEM format. Required
+    //! for server, optional client certificate for client.
+    tstring certFile;
+    tstring keyFile;
+
+    //! Expected name in server certificate and SNI, client only.
+    tstring serverName;
+
+    //! Whether client verifies server certificate.
+    bool verifyPeer = true;
+
+    //! Lets the kernel encrypt sent data where supported (Linux kTLS),
+    //! so that writes stay plain gather writes of the socket.
+    bool kernelOffload = false;
+};
+
+
+//! Established TLS session over connected socket.
+class LOG4CPLUS_EXPORT TlsChannel
+{
+public:
+    virtual ~TlsChannel ();
+
+    //! \return Number of bytes read, or 0 or -1 when the connection
+    //! was closed or failed.
+    virtual long read (char * buffer, std::size_t len) = 0;
+
+    //! Sends all <code>buffers</code>.
+    virtual bool write (std::span<std::string_view const> buffers) = 0;
+
+    //! Sends TLS close notification; the socket stays open.
+    virtual void shutdown () = 0;
+
+    //! \return True if the session was resumed from previous one.
+    virtual bool isResumed () const = 0;
+
+    //! \return True if the kernel encrypts sent data.
+    virtual bool isKernelOffloaded () const = 0;
+};
+
+
+//! TLS backend state shared by connections, like certificates and
+//! cached sessions. Instances have to be thread safe.
+class LOG4CPLUS_EXPORT TlsContext
+{
+public:
+    virtual ~TlsContext ();
+
+    //! Performs TLS handshake over connected <code>sock</code>.
+    //! Client resumes last session established by this context when
+    //! the server allows it.
+    //! \return Null when the handshake failed.
+    virtual std::unique_ptr<TlsChannel> startSession (SOCKET_TYPE sock) = 0;
+};
+
+
+//! Creates TLS context of custom backend.
+typedef std::function<std::unique_ptr<TlsContext> (TlsConfig const &)>
+    TlsBackend;
+
+
+//! Installs TLS backend used by createTlsContext(). Empty function
+//! restores built-in backend.
+LOG4CPLUS_EXPORT void setTlsBackend (TlsBackend backend);
+
+//! \return New TLS context of installed or built-in backend, null
+//! if there is no backend or the configuration is unusable.
+LOG4CPLUS_EXPORT std::unique_ptr<TlsContext> createTlsContext (
+    TlsConfig const & config);
+
+
+} // namespace log4cplus::helpers
+
+
+#endif // LOG4CPLUS_HELPERS_TLSCONTEXT_HEADER_
@@ -32,8 +32,13 @@
 
 #include <log4cplus/logger.h>
 #include <log4cplus/thread/syncprims.h>
+#include <array>
+#include <atomic>
+#include <functional>
 #include <map>
 #include <memory>
+#include <memory_resource>
+#include <string_view>
 #include <vector>
 
 
@@ -41,6 +46,62 @@ namespace log4cplus {
     // Forward Declarations
     class HierarchyLocker;
 
+    namespace detail {
+        class named_logger_cache;
+    }
+
+    namespace internal {
+        class logger_arena;
+    }
+
+    /**
+     * Appenders shared by several hierarchies, e.g., by independent
+     * hierarchies of plugins hosted in one process that write into the
+     * same files. Hierarchies given the registry, see
+     * Hierarchy::setSharedAppenders(), let PropertyConfigurator refer to
+     * the appenders by name and only detach them at shutdown, so that
+     * one of the hierarchies can be reconfigured or shut down without
+     * touching the others. Closing the appenders is up to the owner of
+     * the registry, see closeAll().
+     */
+    class LOG4CPLUS_EXPORT SharedAppenderRegistry
+    {
+    public:
+        SharedAppenderRegistry();
+        ~SharedAppenderRegistry();
+
+        //! Adds <code>appender</code> under its name, replacing an
+        //! appender of the same name.
+        void put(SharedAppenderPtr appender);
+
+        //! Returns appender named <code>name</code>, or null.
+        SharedAppenderPtr get(const log4cplus::tstring_view& name) const;
+
+        //! Returns <code>true</code> if <code>appender</code> is in this
+        //! registry.
+        bool contains(Appender const * appender) const;
+
+        //! Removes appender named <code>name</code> without closing it.
+        void remove(const log4cplus::tstring_view& name);
+
+        SharedAppenderPtrList getAll() const;
+
+        //! Closes all appenders and empties the registry.
+        void closeAll();
+
+    private:
+        mutable thread::Mutex mutex;
+        std::map<log4cplus::tstring, SharedAppenderPtr, std::less<>>
+            appenders;
+
+        SharedAppenderRegistry(SharedAppenderRegistry const &) = delete;
+        SharedAppenderRegistry & operator = (
+            SharedAppenderRegistry const &) = delete;
+    };
+
+    typedef std::shared_ptr<SharedAppenderRegistry> SharedAppenderRegistryPtr;
+
+
     /**
      * This class is specialized in retrieving loggers by name and
      * also maintaining the logger hierarchy.
@@ -74,6 +135,13 @@ namespace log4cplus {
          */
         Hierarchy();
 
+        /**
+         * Create a new Logger hierarchy whose loggers are allocated from
+         * 'resource' instead of getMemoryResource(). The resource has to
+         * outlive the hierarchy and all of its loggers.
+         */
+        explicit Hierarchy(std::pmr::memory_resource * resource);
+
       // Dtor
         virtual ~Hierarchy();
 
@@ -185,6 +253,86 @@ namespace log4cplus {
          */
         virtual LoggerList getCurrentLoggers();
 
+        /**
+         * Sets LogLevel of all existing loggers whose names match
+         * <code>pattern</code> to <code>ll</code>. The pattern can
+         * contain wildcards <code>*</code>, matching any sequence of
+         * characters including dots, and <code>?</code>, matching any
+         * single character. E.g., <code>net.*</code> selects all
+         * descendants of logger <code>net</code> but not <code>net</code>
+         * itself. The root logger is never selected.
+         *
+         * Only loggers whose names start with the part of the pattern
+         * before the first wildcard are visited and cached effective log
+         * levels are invalidated once for the whole update.
+         *
+         * @return Number of loggers that have been updated.
+         */
+        virtual std::size_t setLogLevels(const log4cplus::tstring_view& pattern,
+            LogLevel ll);
+
+        /**
+         * Returns metrics of all appenders with enabled metrics that
+         * are attached to loggers of this hierarchy, directly or
+         * through other appenders like AsyncAppender. Every appender is
+         * reported once.
+         * \sa Appender::setMetricsEnabled()
+         */
+        virtual std::vector<AppenderMetrics> collectMetrics();
+
+        /**
+         * Raises effective log level of every logger of this hierarchy
+         * to at least <code>ll</code>, e.g., by LoadShedder under
+         * back-pressure. NOT_SET_LOG_LEVEL removes the floor. Loggers
+         * pick the change up through their cached effective log level,
+         * so the floor adds nothing to logging calls.
+         */
+        void setSheddingThreshold(LogLevel ll);
+
+        //! Returns log level set by setSheddingThreshold().
+        LogLevel getSheddingThreshold() const;
+
+        /**
+         * Enables or disables accounting of events and bytes of their
+         * messages per logger, see volumeReport(). Every thread counts
+         * into its own table, so that counting takes no locked
+         * instructions; tables of exited threads are merged into
+         * totals. Disabled by default.
+         */
+        void setVolumeAccounting(bool enabled);
+
+        //! Returns value set by setVolumeAccounting().
+        bool isVolumeAccounting() const;
+
+        /**
+         * Returns <code>topN</code> loggers with the most bytes logged
+         * through them and their descendants while volume accounting
+         * was enabled, and <code>topN</code> appenders with enabled
+         * metrics that formatted the most bytes.
+         * \sa setVolumeAccounting(), collectMetrics(), VolumeReporter
+         */
+        VolumeReport volumeReport(std::size_t topN);
+
+        /**
+         * Returns number of events whose message, NDC or MDC values
+         * have been cut by capture limits of loggers of this hierarchy.
+         * \sa Logger::setCaptureLimits()
+         */
+        std::uint64_t getTruncatedEventCount() const;
+
+        /**
+         * Sets registry of appenders this hierarchy shares with others.
+         * PropertyConfigurator configuring this hierarchy resolves
+         * appender names it does not define itself in the registry, and
+         * shutdown() detaches appenders of the registry from loggers
+         * without closing them. Hierarchies are cheap, a process can
+         * keep one per plugin.
+         */
+        void setSharedAppenders(SharedAppenderRegistryPtr registry);
+
+        //! Returns registry set by setSharedAppenders(), if any.
+        SharedAppenderRegistryPtr getSharedAppenders() const;
+
         /**
          * Is the LogLevel specified by <code>level</code> enabled?
          */
@@ -235,11 +383,52 @@ namespace log4cplus {
          */
         virtual void shutdown();
 
+        /**
+         * Shuts down the hierarchy like shutdown() but returns after at
+         * most <code>timeout</code>.
+         *
+         * Logging is disabled first, see disableAll(); resetConfiguration()
+         * enables it again. Then all appenders are drained of events in
+         * flight and closed concurrently, appenders with nested appenders
+         * before the others, while the thread pool finishes its tasks.
+         * Appenders whose close() is still running at the deadline are
+         * reported and left to finish on their own threads.
+         */
+        ShutdownReport shutdown(std::chrono::milliseconds timeout);
+
     private:
       // Types
-        typedef std::vector<Logger> ProvisionNode;
-        typedef std::map<log4cplus::tstring, ProvisionNode, std::less<>> ProvisionNodeMap;
-        typedef std::map<log4cplus::tstring, Logger, std::less<>> LoggerMap;
+        /**
+         * Node of the logger name space. There is one node for each
+         * dot separated segment of logger names, keyed by the segment
+         * in <code>children</code> of the node of the preceding
+         * segments. Nodes without <code>logger</code> stand for names
+         * of which only descendants have been created.
+         */
+        struct LoggerNode
+        {
+            Logger logger;
+            std::map<log4cplus::tstring, std::unique_ptr<LoggerNode>,
+                std::less<>> children;
+        };
+
+        struct LoggerNameHash
+        {
+            using is_transparent = void;
+
+            std::size_t
+            operator () (log4cplus::tstring_view const & name) const noexcept
+            {
+                return std::hash<log4cplus::tstring_view> () (name);
+            }
+        };
+
+        //! Open addressing hash table of loggers, see loggerIndex.
+        struct LoggerIndexTable;
+        typedef std::shared_ptr<LoggerIndexTable> LoggerIndexMapPtr;
+
+        static constexpr std::size_t LOGGER_INDEX_SHARDS = 16;
+        static constexpr std::size_t APPENDER_LIST_MUTEXES = 32;
 
       // Methods
         /**
@@ -258,53 +447,127 @@ namespace log4cplus {
         void initializeLoggerList(LoggerList& list) const;
 
         /**
-         * This method loops through all the *potential* parents of
-         * logger'. There 3 possible cases:
-         *
-         * 1) No entry for the potential parent of 'logger' exists
-         *
-         *    We create a ProvisionNode for this potential parent and insert
-         *    'logger' in that provision node.
-         *
-         * 2) There is an entry of type Logger for the potential parent.
+         * Looks up an existing logger in <code>loggerIndex</code> without
+         * taking any lock.
          *
-         *    The entry is 'logger's nearest existing parent. We update logger's
-         *    parent field with this entry. We also break from the loop
-         *    because updating our parent's parent is our parent's
-         *    responsibility.
-         *
-         * 3) There entry is of type ProvisionNode for this potential parent.
-         *
-         *    We add 'logger' to the list of children for this potential parent.
+         * @return true and sets 'logger' if the logger exists.
          */
-        LOG4CPLUS_PRIVATE void updateParents(Logger const & logger);
+        LOG4CPLUS_PRIVATE
+        bool findLogger(const log4cplus::tstring_view& name,
+            Logger& logger) const;
 
         /**
-         * We update the links for all the children that placed themselves
-         * in the provision node 'pn'. The second argument 'logger' is a
-         * reference for the newly created Logger, parent of all the
-         * children in 'pn'
-         *
-         * We loop on all the children 'c' in 'pn':
-         *
-         *    If the child 'c' has been already linked to a child of
-         *    'logger' then there is no need to update 'c'.
-         *
-         *   Otherwise, we set logger's parent field to c's parent and set
-         *   c's parent field to logger.
+         * Publishes a newly created logger in <code>loggerIndex</code>.
+         * Its shard is replaced by a copy of twice the size when it
+         * becomes half full.
+         * NOTE: This method has to be called with the
+         * <code>hashtable_mutex</code> locked.
+         */
+        LOG4CPLUS_PRIVATE
+        void publishLogger(Logger const & logger);
+
+        /**
+         * Returns shard of <code>loggerIndex</code> for logger 'name'.
+         */
+        LOG4CPLUS_PRIVATE
+        std::atomic<LoggerIndexMapPtr>&
+        getLoggerIndexShard(const log4cplus::tstring_view& name) const;
+
+        /**
+         * Returns one of <code>appenderListMutexes</code> for logger
+         * 'name'.
+         */
+        LOG4CPLUS_PRIVATE
+        thread::Mutex & getAppenderListMutex(
+            const log4cplus::tstring_view& name);
+
+        /**
+         * Re-links loggers below 'node' to 'parent'. Only the nearest
+         * loggers on each path down from 'node' are updated, loggers
+         * further down keep pointing to those.
          */
-        LOG4CPLUS_PRIVATE void updateChildren(ProvisionNode& pn,
-            Logger const & logger);
+        LOG4CPLUS_PRIVATE static void adoptChildren(LoggerNode & node,
+            spi::LoggerImpl * parent);
+
+        /**
+         * Appends loggers of the subtree of 'node', except the one of
+         * 'node' itself, to 'list'.
+         */
+        LOG4CPLUS_PRIVATE static void collectLoggers(LoggerNode const & node,
+            LoggerList & list);
+
+        /**
+         * Invalidates effective log level cached by every logger of this
+         * hierarchy. It has to be called after anything that can change
+         * the result of LoggerImpl::getChainedLogLevel() or the disable
+         * threshold: level assignment, parent links re-wiring, etc.
+         */
+        LOG4CPLUS_PRIVATE void invalidateLogLevelCaches();
 
      // Data
         thread::Mutex hashtable_mutex;
         std::unique_ptr<spi::LoggerFactory> defaultFactory;
-        ProvisionNodeMap provisionNodes;
-        LoggerMap loggerPtrs;
+        //! Root of the logger name space, <code>root</code> itself is
+        //! not stored in it.
+        LoggerNode loggerTree;
+        std::size_t loggerCount;
+
+        /**
+         * Read-optimized copy of <code>loggerTree</code>. Slots of shards
+         * are filled in with atomic stores and never cleared, so that
+         * lookups of existing loggers do not need to lock
+         * <code>hashtable_mutex</code>. Each shard keeps its loggers
+         * alive while it is referenced.
+         */
+        mutable std::array<std::atomic<LoggerIndexMapPtr>, LOGGER_INDEX_SHARDS>
+            loggerIndex;
+
+        /**
+         * Appender list mutexes shared by the loggers of this hierarchy,
+         * so that loggers do not carry one each. They have to outlive
+         * the loggers, including <code>root</code>.
+         */
+        std::array<thread::Mutex, APPENDER_LIST_MUTEXES> appenderListMutexes;
+
+        /**
+         * Memory of loggers created by DefaultLoggerFactory. The arena
+         * is released by the destructor of this hierarchy, it goes
+         * away with the last of the loggers.
+         */
+        internal::logger_arena * loggerArena;
+
         Logger root;
 
         int disableValue;
 
+        /**
+         * Generation of log levels configuration. Loggers cache their
+         * effective log level together with the generation it was computed
+         * at and recompute it when the generations differ. Zero is never
+         * used so that the initial cache value of loggers is always stale.
+         */
+        std::atomic<unsigned> levelGeneration;
+
+        //! See setSheddingThreshold().
+        std::atomic<LogLevel> sheddingThreshold;
+
+        //! See setVolumeAccounting().
+        std::atomic<bool> volumeAccounting;
+
+        //! Identifies counts of this hierarchy in per thread volume
+        //! tables, which may outlive it.
+        std::uint64_t const volumeId;
+
+        //! Set when any logger of this hierarchy has been given
+        //! capture limits, so that others do not look for them.
+        std::atomic<bool> captureLimited;
+
+        //! See getTruncatedEventCount().
+        std::atomic<std::uint64_t> truncatedEvents;
+
+        //! See setSharedAppenders().
+        std::atomic<SharedAppenderRegistryPtr> sharedAppenders;
+
         bool emittedNoAppenderWarning;
 
         // Disallow copying of instances of this class
@@ -314,6 +577,7 @@ namespace log4cplus {
      // Friends
         friend class log4cplus::spi::LoggerImpl;
         friend class log4cplus::HierarchyLocker;
+        friend class log4cplus::detail::named_logger_cache;
     };
 
 
@@ -0,0 +1,231 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    httpbulkappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_HTTP_BULK_APPENDER_HEADER_
+#define LOG4CPLUS_HTTP_BULK_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#ifndef LOG4CPLUS_SINGLE_THREADED
+
+#include <log4cplus/appender.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+
+namespace log4cplus
+{
+
+namespace internal
+{
+
+struct http_bulk_sender;
+
+} // namespace internal
+
+
+/**
+ * Posts formatted events in bulk requests to HTTP log ingestion
+ * endpoints, e.g., Elasticsearch <tt>_bulk</tt> API, Grafana Loki push
+ * API or Splunk HTTP Event Collector.
+ *
+ * Records are accumulated into a request body until it reaches
+ * <tt>MaxBodySize</tt> or until the <tt>FlushInterval</tt> timer
+ * seals it. Sealed bodies are queued for <tt>MaxInFlight</tt> sender
+ * threads. Each of them keeps its own persistent connection, which a
+ * ConnectorThread reopens in the background when it breaks, so up to
+ * <tt>MaxInFlight</tt> requests are in flight at once. Bodies can be
+ * gzip compressed. Requests failing on connection errors or with
+ * statuses 408, 429 and 5xx are retried with exponential backoff.
+ * Records are dropped when <tt>QueueLimit</tt> bytes of bodies wait
+ * in the queue.
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>URL</tt></dt>
+ * <dd>URL of the endpoint, <tt>http</tt> or <tt>https</tt>.</dd>
+ *
+ * <dt><tt>Format</tt></dt>
+ * <dd>Framing of records in the body:
+ * <tt>NDJSON</tt> (default), one record per line;
+ * <tt>JSON</tt>, array of records;
+ * <tt>Elasticsearch</tt>, <tt>_bulk</tt> API with
+ * <tt>BulkAction</tt> line, <tt>{"index":{}}</tt> by default, before
+ * each record;
+ * <tt>Loki</tt>, single stream of Loki push API labelled by
+ * <tt>Labels</tt>, records as lines;
+ * <tt>Splunk</tt>, HEC events with records as string events.
+ * Records of <tt>NDJSON</tt>, <tt>JSON</tt> and <tt>Elasticsearch</tt>
+ * are expected to be JSON objects formatted by, e.g., JsonLayout.</dd>
+ *
+ * <dt><tt>Labels</tt></dt>
+ * <dd>Stream labels for <tt>Loki</tt> as comma separated
+ * <tt>key=value</tt> pairs.</dd>
+ *
+ * <dt><tt>ContentType</tt></dt>
+ * <dd>Overrides Content-Type implied by <tt>Format</tt>.</dd>
+ *
+ * <dt><tt>Headers</tt></dt>
+ * <dd>Additional HTTP headers as comma separated <tt>key=value</tt>
+ * pairs, e.g., <tt>Authorization=Splunk token</tt>.</dd>
+ *
+ * <dt><tt>MaxBodySize</tt></dt>
+ * <dd>Maximal size of uncompressed body. Suffixes "KB" and "MB" are
+ * recognized. Defaults to 1 MB.</dd>
+ *
+ * <dt><tt>FlushInterval</tt></dt>
+ * <dd>Milliseconds after which partially filled body is sent.
+ * Defaults to 1000.</dd>
+ *
+ * <dt><tt>MaxInFlight</tt></dt>
+ * <dd>Number of connections and concurrent requests. Defaults to
+ * 2.</dd>
+ *
+ * <dt><tt>Gzip</tt></dt>
+ * <dd>Compress bodies with gzip when set to <tt>true</tt>. Requires
+ * zlib support.</dd>
+ *
+ * <dt><tt>MaxRetries</tt></dt>
+ * <dd>Number of retries of failed request. Defaults to 3.</dd>
+ *
+ * <dt><tt>RetryBackoff</tt></dt>
+ * <dd>Milliseconds before the first retry; the delay doubles with
+ * each retry up to 30 seconds. Defaults to 500.</dd>
+ *
+ * <dt><tt>QueueLimit</tt></dt>
+ * <dd>Maximal size of queued bodies. Suffixes "KB" and "MB" are
+ * recognized. Defaults to 16 MB.</dd>
+ *
+ * <dt><tt>TlsCAFile</tt>, <tt>TlsCertFile</tt>, <tt>TlsKeyFile</tt>,
+ * <tt>TlsServerName</tt>, <tt>TlsVerifyPeer</tt></dt>
+ * <dd>TLS settings used with <tt>https</tt>, same as those of
+ * SocketAppender.</dd>
+ * </dl>
+ */
+class LOG4CPLUS_EXPORT HttpBulkAppender
+    : public Appender
+{
+public:
+    //! Framing of records in request bodies.
+    enum BodyFormat
+    {
+        NDJSON,
+        JSON_ARRAY,
+        ELASTICSEARCH_BULK,
+        LOKI_PUSH,
+        SPLUNK_HEC
+    };
+
+    //! Counters, see getStats().
+    struct SendStats
+    {
+        //! Requests accepted by the endpoint.
+        std::uint64_t requests = 0;
+        //! Records in accepted requests.
+        std::uint64_t sentRecords = 0;
+        //! Records in requests that failed after retries.
+        std::uint64_t failedRecords = 0;
+        //! Records dropped because the queue was full.
+        std::uint64_t droppedRecords = 0;
+        std::uint64_t retries = 0;
+        //! Size of queued bodies.
+        std::size_t queuedBytes = 0;
+    };
+
+    HttpBulkAppender (tstring const & url, BodyFormat format = NDJSON);
+    HttpBulkAppender (helpers::Properties const & properties);
+    virtual ~HttpBulkAppender ();
+
+    //! Sends the pending body and waits for queued requests.
+    virtual void close ();
+
+    //! Seals the pending body and waits until it and all bodies
+    //! queued before it have been sent or have failed.
+    void flush ();
+
+    SendStats getStats () const;
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+
+    //! Appends <code>event</code> formatted as <code>formatted</code>
+    //! to <code>out</code> framed as the body format requires.
+    void encodeRecord (std::string & out,
+        spi::InternalLoggingEvent const & event,
+        tstring const & formatted) const;
+
+    //! Queues the pending body for sending. Caller holds
+    //! access_mutex.
+    void sealBody ();
+
+    BodyFormat format;
+    std::size_t maxBodySize;
+    unsigned flushInterval;
+    //! Action line of ELASTICSEARCH_BULK records.
+    std::string bulkAction;
+
+    //! Framing of records in body.
+    std::string bodyPrefix;
+    std::string separator;
+    std::string bodySuffix;
+
+    //! Body being filled and number of its records.
+    std::string body;
+    std::size_t bodyRecords;
+
+    //! Buffers reused by append().
+    std::string record;
+    tstring scratch;
+
+private:
+    void init (tstring const & url, helpers::Properties const & properties);
+
+    bool flushTimerRegistered;
+    std::unique_ptr<internal::http_bulk_sender> sender;
+
+    HttpBulkAppender (HttpBulkAppender const &);
+    HttpBulkAppender & operator = (HttpBulkAppender const &);
+};
+
+
+typedef helpers::SharedObjectPtr<HttpBulkAppender> HttpBulkAppenderPtr;
+
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_SINGLE_THREADED
+
+#endif // LOG4CPLUS_HTTP_BULK_APPENDER_HEADER_
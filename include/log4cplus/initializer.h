@@ -30,12 +30,110 @@
 #pragma once
 #endif
 
+#include <chrono>
+#include <cstddef>
 #include <memory>
+#include <memory_resource>
 
 
 namespace log4cplus
 {
 
+namespace helpers
+{
+
+enum class EventClock : int;
+
+} // namespace helpers
+
+
+namespace thread
+{
+
+struct BackgroundThreadSettings;
+
+} // namespace thread
+
+
+//! Settings of per thread data pool, see setThreadDataPoolSize().
+struct ThreadDataPoolSettings
+{
+    //! Number of per thread data objects created up front and kept for
+    //! reuse.
+    std::size_t size = 0;
+};
+
+
+//! Settings of shutdown, see setShutdownTimeout().
+struct ShutdownSettings
+{
+    //! Time limit of shutdown at destruction; zero means no limit.
+    std::chrono::milliseconds timeout {0};
+};
+
+
+//! Set memory resource library internal allocations are made from:
+//! memory of loggers, asynchronous events, ring buffers of queues and
+//! per thread data. Each block is returned to the resource it came
+//! from, so the resource has to outlive the loggers and log4cplus
+//! threads. Blocks are allocated and freed on application threads as
+//! well as on log4cplus threads, so the resource has to be thread safe,
+//! e.g., `std::pmr::synchronized_pool_resource`. It applies to
+//! allocations made after the call. Null restores the default,
+//! `std::pmr::new_delete_resource()`. Strings inside events and per
+//! thread formatting buffers still come from the default heap.
+LOG4CPLUS_EXPORT void setMemoryResource (
+    std::pmr::memory_resource * resource);
+
+//! Returns memory resource set by setMemoryResource().
+LOG4CPLUS_EXPORT std::pmr::memory_resource * getMemoryResource ();
+
+
+//! Settings of library internal allocations, see setMemoryResource().
+struct MemorySettings
+{
+    //! Resource of library internal allocations; null means the
+    //! default.
+    std::pmr::memory_resource * resource = nullptr;
+};
+
+
+//! Settings of real-time mode, see enableRealTimeMode().
+struct RealTimeSettings
+{
+    //! Number of per thread data objects created and warmed up front.
+    std::size_t threadDataObjects = 16;
+    //! Capacity, in characters, reserved in per thread formatting
+    //! buffers, event messages and queue slots. Zero turns real-time
+    //! mode off.
+    std::size_t bufferCapacity = 1024;
+    //! Number of events for asynchronous appending preallocated for
+    //! each thread.
+    std::size_t asyncEvents = 64;
+    //! Lock current and future pages of the process into memory.
+    bool lockMemory = true;
+};
+
+
+//! Prepares logging for threads which must not allocate or fault pages
+//! in on their logging path. Fills the pool of per thread data with
+//! objects whose string buffers, string streams and pooled events have
+//! their storage reserved and touched; queues created afterwards
+//! reserve messages of their slots the same way. With
+//! RealTimeSettings::lockMemory it also locks all pages of the process,
+//! including buffers allocated later, e.g., by FileAppender, into
+//! memory. Locking is supported only on POSIX systems; its failure is
+//! reported through helpers::LogLog. Messages longer than
+//! RealTimeSettings::bufferCapacity still allocate.
+LOG4CPLUS_EXPORT void enableRealTimeMode (RealTimeSettings const & settings);
+
+//! Warms up per thread data of the calling thread like
+//! enableRealTimeMode() does for pooled objects. Call it at start of
+//! threads created before enableRealTimeMode() or threads which should
+//! not depend on the pool.
+LOG4CPLUS_EXPORT void warmUpThread ();
+
+
 /**
    This class helps with initialization and shutdown of log4cplus. Its
    constructor calls `log4cplus::initialize()` and its destructor calls
@@ -48,6 +146,31 @@ class LOG4CPLUS_EXPORT Initializer
 {
 public:
     Initializer ();
+
+    //! Also selects the clock time stamps of events are read from, see
+    //! helpers::setEventClock().
+    explicit Initializer (helpers::EventClock eventClock);
+
+    //! Also sets placement and scheduling of log4cplus threads, see
+    //! thread::setBackgroundThreadSettings().
+    explicit Initializer (
+        thread::BackgroundThreadSettings const & threadSettings);
+
+    //! Also fills the pool of per thread data, see
+    //! setThreadDataPoolSize().
+    explicit Initializer (ThreadDataPoolSettings const & poolSettings);
+
+    //! Also bounds the time its destruction takes, see
+    //! setShutdownTimeout().
+    explicit Initializer (ShutdownSettings const & shutdownSettings);
+
+    //! Also sets memory resource of library internal allocations, see
+    //! setMemoryResource().
+    explicit Initializer (MemorySettings const & memorySettings);
+
+    //! Also enables real-time mode, see enableRealTimeMode().
+    explicit Initializer (RealTimeSettings const & realTimeSettings);
+
     ~Initializer ();
 
     Initializer (Initializer const &) = delete;
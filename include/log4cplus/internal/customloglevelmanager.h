@@ -48,11 +48,14 @@
 #  error "This header must not be be used outside log4cplus' implementation files."
 #endif
 
-#include <map>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
 #include <log4cplus/thread/syncprims.h>
 #include <log4cplus/internal/internal.h>
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-#include <shared_mutex>
+#include <mutex>
 #endif
 
 namespace log4cplus {
@@ -62,17 +65,40 @@ namespace internal {
 
 /**
  * Custom log level manager used by C API.
+ *
+ * Registered levels are kept in immutable tables. add() and remove()
+ * publish a modified copy, so toString() and fromString() only load a
+ * pointer and search a flat sorted array, without locking.
+ *
+ * The first add() registers a translator forwarding to this object
+ * with LogLevelManager, which therefore has to be destroyed first.
  */
 class LOG4CPLUS_PRIVATE CustomLogLevelManager
-    : virtual public LogLevelTranslator
 {
 protected:
+    struct Table
+    {
+        //! Sorted by LogLevel.
+        std::vector<std::pair<LogLevel, tstring>> ll2nm;
+
+        //! Sorted by name.
+        std::vector<std::pair<tstring, LogLevel>> nm2ll;
+    };
+
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    mutable std::shared_mutex mtx;
+    //! Serializes add() and remove().
+    std::mutex mtx;
 #endif
     bool pushed_methods;
-    std::map<LogLevel, tstring> ll2nm;
-    std::map<tstring, LogLevel, std::less<>> nm2ll;
+
+    //! Currently published table.
+    std::atomic<Table const *> table;
+
+    //! All tables published so far. Replaced tables are kept so that
+    //! concurrent readers and strings returned by toString() stay valid.
+    std::vector<std::unique_ptr<Table const>> tables;
+
+    void publish (std::unique_ptr<Table const> t);
 
 public:
     CustomLogLevelManager ();
@@ -82,10 +108,9 @@ public:
 
     bool remove(LogLevel ll, tstring const &nm);
 
-protected:
-    virtual log4cplus::tstring const & toString (LogLevel ll) const;
+    log4cplus::tstring const & toString (LogLevel ll) const;
 
-    virtual LogLevel fromString (const log4cplus::tstring_view& s) const;
+    LogLevel fromString (const log4cplus::tstring_view& s) const;
 };
 
 LOG4CPLUS_PRIVATE CustomLogLevelManager & getCustomLogLevelManager ();
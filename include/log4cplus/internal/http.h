@@ -0,0 +1,101 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    http.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file
+ * This header contains declaration internal to log4cplus. They must never be
+ * visible from user accesible headers or exported in DLL/shared libray.
+ */
+
+
+#ifndef LOG4CPLUS_INTERNAL_HTTP_H_
+#define LOG4CPLUS_INTERNAL_HTTP_H_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#if ! defined (INSIDE_LOG4CPLUS)
+#  error "This header must not be be used outside log4cplus' implementation files."
+#endif
+
+#include <log4cplus/tstring.h>
+#include <log4cplus/helpers/socket.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace log4cplus::internal {
+
+
+//! Parts of <tt>http</tt> or <tt>https</tt> URL.
+struct http_url
+{
+    tstring host;
+    unsigned short port = 80;
+    tstring path;
+    bool tls = false;
+    //! Host is bracketed IPv6 address.
+    bool ipv6 = false;
+};
+
+
+//! Parses <tt>scheme://host[:port][/path]</tt> URL. Empty path is
+//! replaced by <code>defaultPath</code>.
+//! \return <code>false</code> for scheme other than <tt>http</tt> and
+//! <tt>https</tt>.
+bool parse_http_url (http_url & url, tstring const & str,
+    tstring const & defaultPath = tstring (LOG4CPLUS_TEXT ("/")));
+
+
+//! Parses comma separated <tt>key=value</tt> pairs, the format of,
+//! e.g., <tt>OTEL_EXPORTER_OTLP_HEADERS</tt>.
+std::vector<std::pair<tstring, tstring>> parse_key_value_list (
+    tstring const & list);
+
+
+//! \return Request line of <tt>POST</tt> request to <code>url</code>
+//! followed by <tt>Host</tt>, <tt>User-Agent</tt> and
+//! <code>headers</code>, each line ending with CRLF. Content-Length
+//! and the empty line are left to the caller.
+std::string http_post_header (http_url const & url,
+    std::vector<std::pair<tstring, tstring>> const & headers);
+
+
+//! Reads HTTP response and discards its body. Closes
+//! <code>socket</code> unless the connection can be kept alive.
+//! \return Status code, or 0 when no valid response was received.
+int read_http_response (helpers::Socket & socket);
+
+
+} // namespace log4cplus::internal
+
+#endif // LOG4CPLUS_INTERNAL_HTTP_H_
@@ -47,21 +47,36 @@
 #  error "This header must not be be used outside log4cplus' implementation files."
 #endif
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <locale>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 #include <sstream>
+#include <cstdint>
 #include <cstdio>
+#include <ctime>
 #include <log4cplus/tstring.h>
 #include <log4cplus/streams.h>
 #include <log4cplus/ndc.h>
 #include <log4cplus/mdc.h>
+#include <log4cplus/metrics.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/thread/impl/tls.h>
+#include <log4cplus/thread/syncprims.h>
+#include <log4cplus/helpers/bufferstream.h>
 #include <log4cplus/helpers/snprintf.h>
 
 
 namespace log4cplus {
 
+class Appender;
+
 namespace internal {
 
 
@@ -69,6 +84,9 @@ namespace internal {
 //! by reference arises.
 extern log4cplus::tstring const empty_str;
 
+//! Canonical empty MDC, see MappedDiagnosticContextPtr.
+extern MappedDiagnosticContextMap const empty_mdc;
+
 
 struct gft_scratch_pad
 {
@@ -97,35 +115,245 @@ struct gft_scratch_pad
 };
 
 
+//! Output of a layout shared by appenders, cached for the event being
+//! appended, see layout_cache_scope.
+struct layout_cache_entry
+{
+    //! Key from get_layout_cache_key().
+    unsigned key = 0;
+    tstring str;
+};
+
+
 struct appender_sratch_pad
 {
     appender_sratch_pad ();
     ~appender_sratch_pad ();
 
-    tostringstream oss;
+    helpers::buffer_ostream oss;
     tstring str;
     std::string chstr;
+    //! Narrow copy of <code>oss</code> when <code>chstr</code> already
+    //! holds other data.
+    std::string chstr2;
+};
+
+
+//! Free blocks of helpers::SocketBuffer storage, kept per thread so
+//! that buffers are reused without locking.
+struct socket_buffer_pool
+{
+    socket_buffer_pool ();
+    ~socket_buffer_pool ();
+
+    //! Size classes are powers of two from 64 B up to 64 KiB.
+    static std::size_t const min_shift = 6;
+    static std::size_t const max_shift = 16;
+    //! Number of free blocks kept for each size class.
+    static std::size_t const max_blocks = 4;
+
+    std::vector<char *> blocks[max_shift - min_shift + 1];
+};
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+struct async_event;
+
+
+//! Events for asynchronous appending recycled per producing thread, see
+//! enqueueAsyncDoAppend(). Pool threads return appended events into
+//! <code>returned</code>; the producing thread takes them back when its
+//! <code>free</code> list runs out.
+struct async_event_pool
+{
+    async_event_pool ();
+    ~async_event_pool ();
+
+    //! Maximal number of events owned by the pool. Events allocated
+    //! beyond it are freed after appending.
+    static constexpr std::size_t max_events = 256;
+
+    //! Free events, used only by the producing thread.
+    async_event * free;
+    //! Events returned by pool threads.
+    std::atomic<async_event *> returned;
+    //! Number of events owned by the pool.
+    std::size_t events;
+};
+#endif
+
+
+//! Per-second cache of DatePatternConverter output, see
+//! DatePatternConverter::convert().
+struct date_cache_entry
+{
+    //! Unique id of the converter that owns the entry, 0 when unused.
+    std::uint64_t converter_id = 0;
+    //! Second for which <code>parts</code> are valid.
+    time_t seconds = 0;
+    //! Formatted segments of the date format around %q and %Q.
+    std::vector<tstring> parts;
+};
+
+
+//! Offset of local time from UTC, see helpers::localTime().
+struct local_time_cache
+{
+    //! Interval [begin, end) of seconds since epoch the offset is valid
+    //! for.
+    time_t begin = 0;
+    time_t end = 0;
+    //! False if the offset changes within the interval.
+    bool valid = false;
+    long gmtoff = 0;
+    int isdst = 0;
+    char const * zone = nullptr;
+};
+
+
+//! Number of entries of per_thread_data::date_cache.
+std::size_t const DATE_CACHE_SIZE = 4;
+
+//! \return New unique id for per_thread_data::date_cache and
+//! per_thread_data::converter_cache entries.
+std::uint64_t new_date_cache_id ();
+
+
+//! Cached output of a pattern converter for a logger or file name,
+//! e.g., abbreviated logger name of %c{N} or <code>file:line</code> of
+//! %l, see LoggerPatternConverter::convert().
+struct converter_cache_entry
+{
+    //! Unique id of the converter that owns the entry, 0 when unused.
+    std::uint64_t converter_id = 0;
+    //! Line number the output is valid for, if the converter uses it.
+    int line = 0;
+    //! Logger or file name the output is valid for.
+    tstring key;
+    //! Formatted output.
+    tstring value;
+};
+
+
+//! Number of entries of per_thread_data::converter_cache.
+std::size_t const CONVERTER_CACHE_SIZE = 16;
+
+
+//! Builds value of %q (milliseconds) date format specifier.
+void build_q_value (log4cplus::tstring & q_str, long tv_usec);
+
+//! Builds value of %Q (milliseconds with fraction) date format specifier.
+void build_uc_q_value (log4cplus::tstring & uc_q_str, long tv_usec,
+    log4cplus::tstring & tmp);
+
+
+//! Allocates <code>size</code> bytes, aligned for any fundamental
+//! type, from getMemoryResource(). The block remembers its resource for
+//! resource_deallocate(). Defined in global-init.cxx.
+void * resource_allocate (std::size_t size);
+
+//! Returns block of <code>size</code> bytes allocated by
+//! resource_allocate() to its resource.
+void resource_deallocate (void * p, std::size_t size) noexcept;
+
+
+//! Events and message bytes of one logger counted by one thread, see
+//! Hierarchy::setVolumeAccounting(). Only the owning thread writes the
+//! counters, without locked instructions; atomics let reports read
+//! them.
+struct logger_volume_entry
+{
+    //! Hierarchy::volumeId of the logger's hierarchy.
+    std::uint64_t hierarchy_id = 0;
+    tstring name;
+    std::atomic<std::uint64_t> events {0};
+    std::atomic<std::uint64_t> bytes {0};
 };
 
 
+//! Volume counted by one thread, keyed by address of logger.
+//! <code>mtx</code> guards changes of <code>entries</code> against
+//! reports; the owning thread looks entries up without it.
+struct thread_volume
+{
+    std::mutex mtx;
+    std::unordered_map<void const *, std::unique_ptr<logger_volume_entry>>
+        entries;
+};
+
+
+//! \return New unique Hierarchy::volumeId.
+std::uint64_t new_volume_id ();
+
+
 //! Per thread data.
 struct per_thread_data
 {
     per_thread_data ();
     ~per_thread_data ();
 
+    static void *
+    operator new (std::size_t size)
+    {
+        return resource_allocate (size);
+    }
+
+    static void
+    operator delete (void * p, std::size_t size) noexcept
+    {
+        resource_deallocate (p, size);
+    }
+
+    //! Returns the object to the state of a new one for reuse by
+    //! another thread. Buffers keep their capacity up to
+    //! get_thread_buffer_capacity_limit(); caches which do not depend
+    //! on the thread are kept.
+    void reset ();
+
     tstring macros_str;
-    tostringstream macros_oss;
-    tostringstream layout_oss;
-    DiagnosticContextStack ndc_dcs;
-    MappedDiagnosticContextMap mdc_map;
+    helpers::buffer_ostream macros_oss;
+    //! Stream of detail::get_macro_body_oss(), created on first use.
+    std::unique_ptr<tostringstream> macros_tostringstream;
+    helpers::buffer_ostream layout_oss;
+    tstring layout_str;
+    //! Null stands for empty stack. Shared with DiagnosticContextHandle
+    //! snapshots, copied by push and pop only if it is still referred to.
+    std::shared_ptr<DiagnosticContextStack> ndc_dcs;
+    //! Messages of ndc_dcs joined by NDC::get(), kept up to date by
+    //! push and pop while ndc_full_valid is set.
+    log4cplus::tstring ndc_full;
+    bool ndc_full_valid = false;
+    std::shared_ptr<MappedDiagnosticContext> mdc_map;
+    //! Copy of keys registered with MDC::registerKey().
+    std::vector<tstring> mdc_keys;
     log4cplus::tstring thread_name;
     log4cplus::tstring thread_name2;
     gft_scratch_pad gft_sp;
     appender_sratch_pad appender_sp;
+    //! Event being appended by this thread, see layout_cache_scope.
+    spi::InternalLoggingEvent const * layout_cache_event = nullptr;
+    //! Number of entries of layout_cache valid for layout_cache_event.
+    std::size_t layout_cache_used = 0;
+    std::vector<layout_cache_entry> layout_cache;
+    socket_buffer_pool sb_pool;
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    //! Shared with pooled events until they have been appended.
+    std::shared_ptr<async_event_pool> async_events;
+#endif
     log4cplus::tstring faa_str;
     log4cplus::tstring ll_str;
     spi::InternalLoggingEvent forced_log_ev;
+    //! Volume counted by this thread, registered for reports on first
+    //! use. Null until then.
+    std::shared_ptr<thread_volume> volume;
+    //! Block of event sequence numbers leased by this thread, see
+    //! InternalLoggingEvent::assignSequenceNumber().
+    std::uint64_t sequence_next = 0;
+    std::uint64_t sequence_end = 0;
+    date_cache_entry date_cache[DATE_CACHE_SIZE];
+    std::size_t date_cache_next = 0;
+    converter_cache_entry converter_cache[CONVERTER_CACHE_SIZE];
+    local_time_cache lt_cache;
     std::FILE * fnull;
     log4cplus::helpers::snprintf_buf snprintf_buf;
 };
@@ -133,6 +361,63 @@ struct per_thread_data
 
 per_thread_data * alloc_ptd ();
 
+
+//! Resets <code>p</code> and keeps it for alloc_ptd() of another thread
+//! if the pool has room, otherwise deletes it. See
+//! setThreadDataPoolSize().
+void release_ptd (per_thread_data * p);
+
+
+//! Counts event with message of <code>bytes</code> bytes logged
+//! through <code>logger</code> named <code>name</code> into table of the
+//! calling thread. Defined in metrics.cxx.
+void count_logger_volume (void const * logger, tstring const & name,
+    std::uint64_t hierarchy_id, std::size_t bytes);
+
+
+//! Merges volume counted by thread of <code>p</code> into totals of
+//! exited threads and clears its table.
+void merge_thread_volume (per_thread_data * p);
+
+
+//! \return Counts of loggers of hierarchy <code>hierarchy_id</code>
+//! summed over all threads, by logger name.
+std::vector<LoggerVolume> collect_logger_volume (std::uint64_t hierarchy_id);
+
+
+//! \return Limit set by setThreadBufferCapacityLimit().
+std::size_t get_thread_buffer_capacity_limit ();
+
+
+//! \return Capacity set by enableRealTimeMode(), zero when real-time
+//! mode is not enabled.
+std::size_t get_real_time_buffer_capacity ();
+
+
+//! Reserves and touches buffers of <code>p</code> for real-time mode,
+//! see enableRealTimeMode(). Does nothing unless it is enabled.
+void warm_ptd (per_thread_data * p);
+
+
+//! Empties per thread buffer <code>buf</code>. Its capacity is kept
+//! for the next event unless it exceeds
+//! get_thread_buffer_capacity_limit().
+void clear_thread_buffer (tstring & buf);
+
+
+//! \return Entry of per_thread_data::date_cache owned by
+//! <code>id</code>. New entry gets <code>parts</code> empty segments
+//! and is stale for <code>seconds</code>.
+date_cache_entry & get_date_cache_entry (per_thread_data * p,
+    std::uint64_t id, std::size_t parts, time_t seconds);
+
+//! \return Entry of per_thread_data::converter_cache for converter
+//! <code>id</code>, <code>key</code> and <code>line</code>. When
+//! <code>hit</code> is false the entry has been taken over and its
+//! <code>value</code> has to be filled in by the caller.
+converter_cache_entry & get_converter_cache_entry (per_thread_data * p,
+    std::uint64_t id, tstring const & key, int line, bool & hit);
+
 // TLS key whose value is pointer struct per_thread_data.
 extern log4cplus::thread::impl::tls_key_type tls_storage_key;
 
@@ -227,6 +512,383 @@ get_appender_sp ()
 }
 
 
+//! \return Key shared by all layouts of configuration
+//! <code>config</code>, never 0. Defined in layout.cxx.
+unsigned get_layout_cache_key (tstring const & config);
+
+
+//! Set once two layouts have got the same key from
+//! get_layout_cache_key(); until then appending does not track events
+//! for layout_cache_scope.
+extern std::atomic<bool> layout_cache_enabled;
+
+
+//! Lets appenders whose layouts have the same cache key share one
+//! formatted result while <code>event</code> is appended by this
+//! thread. A nested scope for the same event does nothing; any other
+//! scope empties the cache when it is entered and left.
+class layout_cache_scope
+{
+public:
+    explicit layout_cache_scope (spi::InternalLoggingEvent const & event)
+        : ptd (nullptr)
+        , prev (nullptr)
+    {
+        if (LOG4CPLUS_LIKELY (
+                ! layout_cache_enabled.load (std::memory_order_relaxed)))
+            return;
+
+        per_thread_data * const p = get_ptd ();
+        if (p->layout_cache_event == &event)
+            return;
+
+        ptd = p;
+        prev = ptd->layout_cache_event;
+        ptd->layout_cache_event = &event;
+        ptd->layout_cache_used = 0;
+    }
+
+    ~layout_cache_scope ()
+    {
+        if (ptd)
+        {
+            ptd->layout_cache_event = prev;
+            ptd->layout_cache_used = 0;
+        }
+    }
+
+private:
+    per_thread_data * ptd;
+    spi::InternalLoggingEvent const * prev;
+
+    layout_cache_scope (layout_cache_scope const &) = delete;
+    layout_cache_scope & operator = (layout_cache_scope const &) = delete;
+};
+
+
+//! Appends <code>str</code> encoded as UTF-8 to <code>out</code>. In
+//! narrow builds characters are copied as they are.
+void append_utf8 (std::string & out, tstring_view str);
+
+
+//! Appends <code>str</code> as content of JSON string. Defined in
+//! structuredlayout.cxx.
+void append_json_escaped (tstring & output, tstring_view str);
+
+
+//! \return Copy of <code>loc</code> whose codecvt<wchar_t, char> facet
+//! converts to and from UTF-8 in bulk with helpers::encodeUtf8() and
+//! helpers::decodeUtf8(), independently of the locale.
+std::locale with_utf8_codecvt (std::locale const & loc);
+
+
+//! Lock-free counterpart of LatencyHistogram. Defined in metrics.cxx.
+struct latency_histogram_counters
+{
+    void record (std::chrono::steady_clock::duration duration);
+    void snapshot (LatencyHistogram & histogram) const;
+
+    std::atomic<std::uint64_t> buckets[LatencyHistogram::bucket_count] {};
+    std::atomic<std::uint64_t> sum_ns {0};
+    std::atomic<std::uint64_t> max_ns {0};
+};
+
+
+//! Counters of an appender with enabled metrics, see AppenderMetrics.
+struct appender_metrics
+{
+    std::atomic<std::uint64_t> events {0};
+    std::atomic<std::uint64_t> bytes {0};
+    std::atomic<std::uint64_t> filtered {0};
+    std::atomic<std::uint64_t> dropped {0};
+    std::atomic<std::uint64_t> errors {0};
+    latency_histogram_counters append_latency;
+    latency_histogram_counters queue_latency;
+};
+
+
+//! Decisions of LoadShedder, separated from sampling. Defined in
+//! metrics.cxx.
+struct load_shedding_state
+{
+    static constexpr unsigned max_step = 2;
+
+    //! Takes one sample. <code>pressure</code> is the largest ratio of
+    //! a measure to its threshold; <code>dropped</code> tells that
+    //! events were lost since the last sample.
+    //! \return New step.
+    unsigned update (double pressure, bool dropped,
+        unsigned restore_intervals);
+
+    unsigned step = 0;
+    //! Consecutive samples with low pressure.
+    unsigned calm = 0;
+};
+
+
+//! Drops cached results of spi::LoggerImpl::mayLog(). Called when
+//! appenders, their thresholds or filters, or additivity change.
+//! Defined in loggerimpl.cxx.
+void invalidate_pre_filter_caches ();
+
+//! Generation of the caches invalidated by
+//! invalidate_pre_filter_caches(). Zero is never used.
+extern std::atomic<unsigned> pre_filter_generation;
+
+
+//! Memory of loggers created by DefaultLoggerFactory, carved from
+//! large chunks. Loggers are destroyed one by one, but the chunks are
+//! released all at once, when the Hierarchy and all its loggers are
+//! gone. Memory of loggers dropped by Hierarchy::clear() is not reused
+//! before that. Chunks come from <code>resource</code>, or from
+//! getMemoryResource() at the time of their allocation if it is null.
+//! Defined in loggerimpl.cxx.
+class logger_arena
+{
+public:
+    explicit logger_arena (std::pmr::memory_resource * resource_)
+        : resource (resource_)
+    { }
+
+    logger_arena (logger_arena const &) = delete;
+    logger_arena & operator = (logger_arena const &) = delete;
+
+    //! Allocates memory of one logger and takes a reference for it.
+    void * allocate (std::size_t size, std::size_t alignment);
+
+    //! Drops a reference of a destroyed logger or of the Hierarchy.
+    //! The last one frees the arena.
+    void release ();
+
+private:
+    ~logger_arena ();
+
+    //! Chunks double in size from <code>first_chunk_size</code> up to
+    //! <code>chunk_size</code>, so that hierarchies with few loggers,
+    //! e.g., one per plugin, stay small.
+    static constexpr std::size_t first_chunk_size = 4 * 1024;
+    static constexpr std::size_t chunk_size = 64 * 1024;
+
+    struct chunk
+    {
+        void * memory;
+        std::size_t size;
+        std::pmr::memory_resource * resource;
+    };
+
+    std::pmr::memory_resource * const resource;
+    thread::Mutex mutex;
+    std::vector<chunk> chunks;
+    char * next = nullptr;
+    char * end = nullptr;
+    //! References of the loggers and one of the Hierarchy.
+    std::atomic<std::size_t> refs {1};
+};
+
+
+//! Shifts backups of <code>filename</code> like RollingFileAppender
+//! does and renames the file to the first backup. Defined in
+//! fileappender.cxx.
+void roll_file_backups (tstring const & filename,
+    unsigned int maxBackupIndex);
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+//! Registers <code>callback</code> of <code>owner</code> to be called
+//! every <code>interval</code> from the timer wheel thread shared by
+//! appenders' flushes and other periodic tasks. Callbacks should be
+//! short, they delay each other. Defined in flushtimer.cxx.
+void add_timer (void const * owner,
+    std::chrono::milliseconds interval, std::function<void ()> callback);
+
+//! Unregisters callbacks of <code>owner</code>. When it returns, the
+//! callback is not running and it will not be called again.
+void remove_timer (void const * owner);
+
+
+class executor;
+
+
+//! Task run by executor. A task can be submitted again only after its
+//! run() has started.
+class executor_task
+{
+public:
+    virtual void run (executor & exec) = 0;
+
+protected:
+    ~executor_task () = default;
+
+private:
+    //! Next task in worker's queue.
+    executor_task * next_task = nullptr;
+
+    friend class executor;
+};
+
+
+//! Link of intrusive multiple producer, single consumer queue.
+struct async_node
+{
+    std::atomic<async_node *> next {nullptr};
+};
+
+
+//! Events of one asynchronous appender in order of appending. The
+//! strand is submitted to executor when its first event is queued and
+//! then runs until it has appended all of them, so at most one worker
+//! appends to the appender at a time. Defined in global-init.cxx.
+class async_strand final
+    : public executor_task
+{
+public:
+    explicit async_strand (Appender * owner);
+    ~async_strand ();
+
+    //! Queues <code>node</code>. Returns <code>true</code> when the
+    //! strand has to be submitted to executor.
+    bool push (async_node * node);
+
+    void run (executor & exec) override;
+
+private:
+    //! Removes oldest node. Called only by the running strand.
+    async_node * pop ();
+
+    Appender * const owner;
+    std::atomic<async_node *> tail;
+    async_node * head;
+    async_node stub;
+    //! Number of queued nodes.
+    std::atomic<std::size_t> pending;
+    //! Events being appended, moved out of the queued nodes.
+    std::vector<spi::InternalLoggingEvent> batch;
+};
+
+
+//! Thread pool for asynchronous appending and other background tasks.
+//! Every worker has its own queue of tasks and idle workers steal tasks
+//! from queues of others. Workers are started on demand, when a task is
+//! submitted and no worker waits for one, up to the pool size, and they
+//! exit after they have been idle for the idle timeout. Defined in
+//! executor.cxx.
+class executor
+{
+public:
+    //! \param threads Maximal number of workers.
+    //! \param idle_timeout Time after which idle worker exits.
+    explicit executor (std::size_t threads,
+        std::chrono::milliseconds idle_timeout = default_idle_timeout);
+    //! Runs all submitted tasks, including those they submit, and joins
+    //! workers.
+    ~executor ();
+
+    //! Queues <code>task</code>. Tasks submitted from a worker go to
+    //! its own queue.
+    void submit (executor_task * task);
+    void submit (std::function<void ()> task);
+
+    //! Sets maximal number of workers. Workers above it exit.
+    void set_pool_size (std::size_t threads);
+
+    void set_idle_timeout (std::chrono::milliseconds timeout);
+    std::chrono::milliseconds get_idle_timeout () const;
+
+    //! Waits until no task is queued or running.
+    void wait_until_idle ();
+
+    //! Waits until no task is queued or running or until
+    //! <code>deadline</code>.
+    //! \return True if no task is queued or running.
+    bool wait_until_idle (std::chrono::steady_clock::time_point deadline);
+
+    //! \return True if no task is queued or running, besides the one
+    //! calling it.
+    bool is_idle () const;
+
+    std::size_t get_pool_size () const;
+
+    //! \return Number of running workers.
+    std::size_t get_worker_count () const;
+
+    //! Maximal number of workers.
+    static std::size_t const max_workers = 64;
+
+    static constexpr std::chrono::milliseconds default_idle_timeout {10000};
+
+    //! \return Default pool size: number of hardware threads, at least
+    //! 4 and at most max_workers.
+    static std::size_t default_pool_size ();
+
+private:
+    struct worker;
+
+    void work (worker & w);
+    executor_task * take (worker & w);
+    void start (worker & w);
+
+    //! Starts worker unless there is a waiting one or the pool is
+    //! full. Called with <code>mtx</code> locked.
+    void start_worker_if_needed ();
+
+    std::unique_ptr<worker []> workers;
+    std::atomic<std::size_t> pool_size;
+    //! Number of running workers.
+    std::atomic<std::size_t> live;
+    std::chrono::milliseconds idle_timeout;
+    std::atomic<std::size_t> next_worker;
+    //! Number of tasks in workers' queues.
+    std::atomic<std::size_t> queued;
+    //! Number of tasks queued or running.
+    std::atomic<std::size_t> outstanding;
+    //! Number of workers waiting for tasks.
+    std::atomic<std::size_t> sleepers;
+    mutable std::mutex mtx;
+    std::condition_variable work_cond;
+    std::condition_variable idle_cond;
+    bool stop;
+};
+
+
+#if defined (LOG4CPLUS_USE_PTHREADS)
+//! Appender::doAppend() holds it while it hands an event over to other
+//! thread, so that fork handlers can wait for such appends to finish
+//! and keep new ones out until fork() returns. Threads of log4cplus
+//! itself are exempt; the handlers wait for their work separately.
+//! Defined in global-init.cxx.
+class fork_gate_guard
+{
+public:
+    explicit fork_gate_guard (bool enter);
+    ~fork_gate_guard ();
+
+    fork_gate_guard (fork_gate_guard const &) = delete;
+    fork_gate_guard & operator = (fork_gate_guard const &) = delete;
+
+    //! Exempts the calling thread from the gate.
+    static void exempt_current_thread ();
+
+private:
+    bool entered;
+};
+
+
+//! Locks the list of open AsyncAppender instances until
+//! async_appenders_after_fork(). Defined in asyncappender.cxx.
+void async_appenders_lock_for_fork ();
+
+//! \return True if queues of all AsyncAppender instances are idle,
+//! see thread::Queue::idle().
+bool async_appenders_idle ();
+
+//! Unlocks the list. In child process, it replaces queues and queue
+//! threads of the appenders first.
+void async_appenders_after_fork (bool child);
+#endif
+
+#endif
+
+
 } // namespace internal {
 
 
@@ -234,6 +896,7 @@ namespace detail
 {
 
 LOG4CPLUS_EXPORT void clear_tostringstream (tostringstream &);
+LOG4CPLUS_EXPORT void clear_tostringstream (helpers::buffer_ostream &);
 
 } // namespace detail
 
@@ -53,6 +53,8 @@
 #include <log4cplus/helpers/socket.h>
 
 #include <cerrno>
+#include <memory>
+#include <vector>
 #ifdef LOG4CPLUS_HAVE_ERRNO_H
 #include <errno.h>
 #endif
@@ -211,6 +213,32 @@ get_last_socket_error ()
 }
 
 
+//! One result of name resolution done by connectSocket().
+struct resolved_address
+{
+    int family;
+    int socktype;
+    int protocol;
+    //! Bytes of <code>sockaddr</code>.
+    std::vector<unsigned char> addr;
+};
+
+
+typedef std::vector<resolved_address> resolved_addresses;
+
+
+//! \return Addresses stored by store_resolved_addresses() for the same
+//! host, port and flags less than <code>ttl</code> milliseconds ago,
+//! or null.
+std::shared_ptr<resolved_addresses const> find_resolved_addresses (
+    tstring const & host, unsigned short port, bool udp, bool ipv6,
+    unsigned ttl);
+
+
+void store_resolved_addresses (tstring const & host, unsigned short port,
+    bool udp, bool ipv6, std::shared_ptr<resolved_addresses const> addrs);
+
+
 } // namespace helpers {
 
 } // namespace log4cplus {
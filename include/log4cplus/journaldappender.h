@@ -0,0 +1,112 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    journaldappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_JOURNALD_APPENDER_HEADER_
+#define LOG4CPLUS_JOURNALD_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#if defined (LOG4CPLUS_HAVE_SYS_UN_H) && ! defined (_WIN32)
+
+#include <log4cplus/appender.h>
+#include <string>
+
+
+namespace log4cplus
+{
+
+/**
+ * Sends events to systemd journal through its native protocol, without
+ * libsystemd. Each event is one datagram with fields
+ * <tt>MESSAGE</tt>, <tt>PRIORITY</tt>, <tt>CODE_FILE</tt>,
+ * <tt>CODE_LINE</tt>, <tt>CODE_FUNC</tt>,
+ * <tt>SYSLOG_IDENTIFIER</tt>, <tt>LOG4CPLUS_LOGGER</tt>,
+ * <tt>LOG4CPLUS_THREAD</tt> and <tt>LOG4CPLUS_NDC</tt>. MDC entries
+ * and key/value fields of the event follow as fields of their own;
+ * their keys are turned into journal field names by upper-casing them
+ * and replacing other characters than letters, digits and underscores
+ * by underscores, and <tt>X_</tt> is prepended to names not starting
+ * with a letter. Empty fields are left out.
+ *
+ * <tt>MESSAGE</tt> is the message of the event; the layout is not
+ * used. Events too large for a datagram are passed in a sealed memfd,
+ * where it is available; otherwise they are dropped.
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>Ident</tt></dt>
+ * <dd>Value of <tt>SYSLOG_IDENTIFIER</tt> field. Journal uses name
+ * of the process when it is not set.</dd>
+ *
+ * <dt><tt>Socket</tt></dt>
+ * <dd>Path of the journal socket. Defaults to
+ * <tt>/run/systemd/journal/socket</tt>.</dd>
+ * </dl>
+ */
+class LOG4CPLUS_EXPORT JournaldAppender
+    : public Appender
+{
+public:
+    JournaldAppender (tstring const & ident = tstring ());
+    JournaldAppender (helpers::Properties const & properties);
+    virtual ~JournaldAppender ();
+
+    virtual void close ();
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+
+    void open ();
+
+    //! Sends <code>datagram</code> through a memfd.
+    bool sendThroughMemfd ();
+
+    std::string ident;
+    std::string socketPath;
+    int fd;
+
+    //! Serialized event, reused between events.
+    std::string datagram;
+
+private:
+    JournaldAppender (JournaldAppender const &);
+    JournaldAppender & operator = (JournaldAppender const &);
+};
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_HAVE_SYS_UN_H && ! _WIN32
+
+#endif // LOG4CPLUS_JOURNALD_APPENDER_HEADER_
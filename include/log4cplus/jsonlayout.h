@@ -0,0 +1,118 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    jsonlayout.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+/** @file */
+
+#ifndef LOG4CPLUS_JSON_LAYOUT_HEADER_
+#define LOG4CPLUS_JSON_LAYOUT_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/structuredlayout.h>
+
+#include <vector>
+
+
+namespace log4cplus {
+
+    /**
+     * Formats events as JSON objects, one per event, suitable for
+     * Elasticsearch and similar log processors. For example:
+     *
+     * <pre>
+     * {"timestamp":"2026-10-15T12:34:56.789Z","level":"INFO","logger":"app.db","thread":"1234","message":"Connected to \"db1\"."}
+     * </pre>
+     *
+     * String values are escaped as JSON requires; characters outside
+     * ASCII are written as they are and it is left to the appender to
+     * encode them, e.g., FileAppender with <code>Encoding=UTF-8</code>.
+     * MDC is written as nested object. Key/value fields are written as
+     * nested object too, with numbers and booleans unquoted; NaN and
+     * infinities become <code>null</code>. Stack trace is written as
+     * array of frames. Empty NDC, MDC, key/value fields, file, function
+     * and stack trace and unknown line are omitted.
+     *
+     * <h3>Properties</h3>
+     *
+     * Besides properties of StructuredLayout:
+     *
+     * <dl>
+     * <dt><tt>NDJSON</tt></dt>
+     * <dd>When <code>true</code>, the default, every object is followed
+     * by a new line as newline delimited JSON requires. Set it to
+     * <code>false</code> for appenders which frame events on their own,
+     * like SocketAppender or SysLogAppender.</dd>
+     * </dl>
+     */
+    class LOG4CPLUS_EXPORT JsonLayout
+        : public StructuredLayout
+    {
+    public:
+        //! Writes all fields with default names as NDJSON.
+        JsonLayout();
+        JsonLayout(const log4cplus::helpers::Properties& properties);
+        virtual ~JsonLayout();
+
+        using StructuredLayout::formatAndAppend;
+        virtual void formatAndAppend(log4cplus::tstring& output,
+                                     const log4cplus::spi::InternalLoggingEvent& event);
+
+    protected:
+        struct Writers;
+
+        //! Appends member of one field to the object being formatted.
+        struct FieldWriter
+        {
+            void (* write) (JsonLayout const & layout,
+                log4cplus::tstring & output, log4cplus::tstring const & key,
+                const log4cplus::spi::InternalLoggingEvent& event);
+            //! Quoted and escaped name of the member.
+            log4cplus::tstring key;
+        };
+
+        void init();
+
+        //! Writers of the selected fields, in output order.
+        std::vector<FieldWriter> writers;
+        bool ndjson = true;
+
+    private:
+      // Disallow copying of instances of this class
+        JsonLayout(const JsonLayout&);
+        JsonLayout& operator=(const JsonLayout&);
+    };
+
+} // end namespace log4cplus
+
+#endif // LOG4CPLUS_JSON_LAYOUT_HEADER_
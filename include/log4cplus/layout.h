@@ -37,6 +37,7 @@
 
 #include <vector>
 #include <memory>
+#include <span>
 
 
 namespace log4cplus {
@@ -80,9 +81,46 @@ namespace log4cplus {
         virtual void formatAndAppend(log4cplus::tostream& output,
             const log4cplus::spi::InternalLoggingEvent& event) = 0;
 
+        /**
+         * Appends formatted event to <code>output</code>. The default
+         * implementation formats the event into a per-thread string
+         * stream using the stream overload; layouts which can append to
+         * a string directly should override it. Layouts overriding only
+         * one of the overloads bring the other one into scope with
+         * <code>using Layout::formatAndAppend;</code>.
+         */
+        virtual void formatAndAppend(log4cplus::tstring& output,
+            const log4cplus::spi::InternalLoggingEvent& event);
+
+        /**
+         * Appends all <code>events</code>, formatted one after another,
+         * to <code>output</code>. The default implementation calls the
+         * string overload of formatAndAppend() for each event.
+         */
+        virtual void formatBatch(
+            std::span<log4cplus::spi::InternalLoggingEvent const> events,
+            log4cplus::tstring& output);
+
+        /**
+         * Returns combination of spi::EventFields this layout reads. The
+         * default implementation returns spi::EVENT_FIELDS_ALL.
+         */
+        virtual unsigned getRequiredEventFields() const;
+
+        /**
+         * Returns key shared by layouts of equal configuration, or 0.
+         * Appenders whose layouts have the same key format an event
+         * once and share the result, see Appender::formatEvent().
+         */
+        unsigned getCacheKey() const { return cacheKey; }
+
     protected:
         LogLevelManager& llmCache;
 
+        //! Set by layouts whose output depends only on the event and
+        //! their configuration, see internal::get_layout_cache_key().
+        unsigned cacheKey = 0;
+
     private:
       // Disable copy
         Layout(const Layout&);
@@ -109,8 +147,10 @@ namespace log4cplus {
         SimpleLayout(const log4cplus::helpers::Properties& properties);
         virtual ~SimpleLayout();
 
+        using Layout::formatAndAppend;
         virtual void formatAndAppend(log4cplus::tostream& output,
                                      const log4cplus::spi::InternalLoggingEvent& event);
+        virtual unsigned getRequiredEventFields() const;
 
     private:
       // Disallow copying of instances of this class
@@ -171,9 +211,15 @@ namespace log4cplus {
         TTCCLayout(const log4cplus::helpers::Properties& properties);
         virtual ~TTCCLayout();
 
+        using Layout::formatAndAppend;
         virtual void formatAndAppend(log4cplus::tostream& output,
                                      const log4cplus::spi::InternalLoggingEvent& event);
 
+        //! Returns thread name and NDC regardless of thread and context
+        //! printing settings as those can change while the layout is
+        //! used.
+        virtual unsigned getRequiredEventFields() const;
+
         bool getThreadPrinting() const;
         void setThreadPrinting(bool);
 
@@ -306,6 +352,9 @@ namespace log4cplus {
      *   <li>%%p -- Locale's equivalent of AM or PM</li>
      *   <li>%%q -- milliseconds as decimal(0-999) -- <b>Log4CPLUS specific</b>
      *   <li>%%Q -- fractional milliseconds as decimal(0-999.999) -- <b>Log4CPLUS specific</b>
+     *   <li>%%N -- nanoseconds as 9 digit decimal(000000000-999999999),
+     *       sub-microsecond digits come from the event clock, see
+     *       helpers::setEventClock() -- <b>Log4CPLUS specific</b>
      *   <li>%%S -- Second as decimal(0-59)</li>
      *   <li>%%U -- Week of year, Sunday being first day(0-53)</li>
      *   <li>%%w -- Weekday as a decimal(0-6, Sunday being 0)</li>
@@ -380,6 +429,18 @@ namespace log4cplus {
      * </tr>
      *
      * <tr>
+     *   <td align=center><b>K</b></td>
+     *
+     *   <td>Used to output the typed key/value fields of the logging
+     *   event, e.g., those given to LOG4CPLUS_INFO_KV(). It takes
+     *   optional key parameter. Without the key parameter (%%K), it
+     *   outputs all fields in the same form as %%X. With the key
+     *   (%%K{key}), it outputs just the key's value; numbers are
+     *   formatted only here.
+     *   </td>
+     * </tr>
+     *
+     * <tr>
      * <td align=center><b>l</b></td>
      *
      *   <td>Equivalent to using "%F:%L"
@@ -440,6 +501,15 @@ namespace log4cplus {
      * </tr>
      *
      * <tr>
+     *   <td align=center><b>S</b></td>
+     *
+     *   <td>Used to output the stack trace of the logging call, one
+     *   line per frame, each starting with a tab and <code>at</code>
+     *   and ending with a new line. Nothing is output for events
+     *   without stack trace, see spi::setStackTraceLogLevel().</td>
+     * </tr>
+     *
+     * <tr>
      *   <td align=center><b>t</b></td>
      *
      *   <td>Used to output the thread ID of the thread that generated
@@ -482,6 +552,14 @@ namespace log4cplus {
      * </tr>
      *
      * <tr>
+     *   <td align=center><b>Y</b></td>
+     *
+     *   <td>Used to output the sequence number of the logging event.
+     *   Nothing is output for events without it, see
+     *   spi::setEventSequencing().</td>
+     * </tr>
+     *
+     * <tr>
      *   <td align=center><b>"%%"</b></td>
      *   <td>The sequence "%%" outputs a single percent sign.
      *   </td>
@@ -624,6 +702,18 @@ namespace log4cplus {
 
         virtual void formatAndAppend(log4cplus::tostream& output,
                                      const log4cplus::spi::InternalLoggingEvent& event);
+        virtual void formatAndAppend(log4cplus::tstring& output,
+                                     const log4cplus::spi::InternalLoggingEvent& event);
+
+        //! Reserves room for the whole batch in <code>output</code>
+        //! after the first event, then runs the converters of the
+        //! rest. Events of one second share the date conversion
+        //! through the per-thread date cache.
+        virtual void formatBatch(
+            std::span<log4cplus::spi::InternalLoggingEvent const> events,
+            log4cplus::tstring& output);
+
+        virtual unsigned getRequiredEventFields() const;
 
     protected:
         void init(const log4cplus::tstring& pattern, unsigned ndcMaxDepth = 0);
@@ -631,6 +721,8 @@ namespace log4cplus {
       // Data
         log4cplus::tstring pattern;
         std::vector<std::unique_ptr<pattern::PatternConverter> > parsedPattern;
+        //! Event fields read by <code>parsedPattern</code>.
+        unsigned requiredEventFields;
 
     private:
       // Disallow copying of instances of this class
@@ -56,6 +56,19 @@ namespace log4cplus {
      * <dd>Boolean value specifying whether to use IPv6 (true) or IPv4
      * (false). Default value is false.</dd>
      *
+     * <dt><tt>BatchSize</tt></dt>
+     * <dd>Several <code>log4j:event</code> elements are packed into
+     * single datagram of up to this many bytes, e.g. 1400 to fit
+     * Ethernet MTU. Event bigger than this is sent alone. Default value
+     * is 0; each event is sent as separate datagram.</dd>
+     *
+     * <dt><tt>BatchIntervalMs</tt></dt>
+     * <dd>Partially filled datagram is sent at least this often, in
+     * milliseconds. Default value is 0, no timer. Without timer
+     * collected events wait for the next event or for appender's
+     * closing; batches appended with <code>doAppendBatch()</code> are
+     * sent right away.</dd>
+     *
      * </dl>
      */
     class LOG4CPLUS_EXPORT Log4jUdpAppender : public Appender {
@@ -71,9 +84,20 @@ namespace log4cplus {
       // Methods
         virtual void close();
 
+        //! Events are sent whole, all fields are required.
+        virtual unsigned getRequiredEventFields() const;
+
     protected:
         void openSocket();
         virtual void append(const spi::InternalLoggingEvent& event);
+        virtual void appendBatch(
+            std::span<spi::InternalLoggingEvent const> events);
+
+        //! Formats <code>log4j:event</code> element into eventXml.
+        void formatXml(const spi::InternalLoggingEvent& event);
+
+        //! Sends collected events, if any.
+        void flushDatagram();
 
       // Data
         log4cplus::helpers::Socket socket;
@@ -81,10 +105,21 @@ namespace log4cplus {
         int port;
         bool ipv6 = false;
 
+        unsigned long batchSize = 0;
+        unsigned long batchInterval = 0;
+
+        //! XML of the event being sent, reused between events.
+        log4cplus::tstring eventXml;
+
+        //! Events collected for the next datagram, see BatchSize.
+        std::string datagram;
+
     private:
       // Disallow copying of instances of this class
         Log4jUdpAppender(const Log4jUdpAppender&);
         Log4jUdpAppender& operator=(const Log4jUdpAppender&);
+
+        bool batchTimerRegistered = false;
     };
 } // end namespace log4cplus
 
@@ -0,0 +1,111 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    logfmtlayout.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+/** @file */
+
+#ifndef LOG4CPLUS_LOGFMT_LAYOUT_HEADER_
+#define LOG4CPLUS_LOGFMT_LAYOUT_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/structuredlayout.h>
+
+#include <vector>
+
+
+namespace log4cplus {
+
+    /**
+     * Formats events as logfmt lines of space separated
+     * <code>key=value</code> pairs, as Loki and similar log processors
+     * read them. For example:
+     *
+     * <pre>
+     * timestamp=2026-10-15T12:34:56.789Z level=INFO logger=app.db thread=1234 mdc.user=alice message="Connected to \"db1\"."
+     * </pre>
+     *
+     * Values are quoted only when they are empty or contain space,
+     * <code>=</code>, <code>"</code>, <code>\</code> or control
+     * characters; quoted values are escaped like JSON strings. Every
+     * MDC entry is written as its own pair whose key is the MDC key
+     * prefixed by name of the <code>mdc</code> field and a dot, or
+     * without any prefix when the name is empty; key/value fields are
+     * written the same way under the <code>kv</code> field. Characters
+     * that cannot appear in keys are replaced by <code>_</code>. Frames
+     * of stack trace are separated by <code>;</code>. Empty NDC, file,
+     * function and stack trace and unknown line are omitted.
+     *
+     * See StructuredLayout for properties.
+     */
+    class LOG4CPLUS_EXPORT LogfmtLayout
+        : public StructuredLayout
+    {
+    public:
+        //! Writes all fields with default names.
+        LogfmtLayout();
+        LogfmtLayout(const log4cplus::helpers::Properties& properties);
+        virtual ~LogfmtLayout();
+
+        using StructuredLayout::formatAndAppend;
+        virtual void formatAndAppend(log4cplus::tstring& output,
+                                     const log4cplus::spi::InternalLoggingEvent& event);
+
+    protected:
+        struct Writers;
+
+        //! Appends pair of one field to the line being formatted.
+        struct FieldWriter
+        {
+            void (* write) (LogfmtLayout const & layout,
+                log4cplus::tstring & output, log4cplus::tstring const & key,
+                const log4cplus::spi::InternalLoggingEvent& event);
+            //! Space, sanitized name and <code>=</code>; for the MDC
+            //! and key/value fields, the prefix of their keys.
+            log4cplus::tstring key;
+        };
+
+        void init();
+
+        //! Writers of the selected fields, in output order.
+        std::vector<FieldWriter> writers;
+
+    private:
+      // Disallow copying of instances of this class
+        LogfmtLayout(const LogfmtLayout&);
+        LogfmtLayout& operator=(const LogfmtLayout&);
+    };
+
+} // end namespace log4cplus
+
+#endif // LOG4CPLUS_LOGFMT_LAYOUT_HEADER_
@@ -36,6 +36,9 @@
 #include <log4cplus/spi/appenderattachable.h>
 #include <log4cplus/spi/loggerfactory.h>
 
+#include <chrono>
+#include <memory>
+#include <span>
 #include <vector>
 
 
@@ -47,11 +50,13 @@ namespace log4cplus
     class Hierarchy;
     class HierarchyLocker;
     class DefaultLoggerFactory;
+    class LoggerRef;
 
     namespace spi
     {
 
         class LoggerImpl;
+        struct CaptureLimits;
 
     }
 
@@ -61,6 +66,25 @@ namespace log4cplus
     typedef std::vector<Logger> LoggerList;
 
 
+    //! Outcome of shutdown with a deadline, see
+    //! Hierarchy::shutdown(std::chrono::milliseconds).
+    struct ShutdownReport
+    {
+        //! Names of appenders that were not drained and closed by the
+        //! deadline.
+        std::vector<tstring> undrainedAppenders;
+
+        //! <code>false</code> if the thread pool still had tasks queued
+        //! or running at the deadline.
+        bool threadPoolIdle = true;
+
+        bool complete () const
+        {
+            return threadPoolIdle && undrainedAppenders.empty ();
+        }
+    };
+
+
     /**
      * This is the central class in the log4cplus package. One of the
      * distintive features of log4cplus are hierarchical loggers and their
@@ -149,6 +173,12 @@ namespace log4cplus
          */
         static void shutdown();
 
+        /**
+         * Shuts down the default hierarchy within <code>timeout</code>,
+         * see Hierarchy::shutdown(std::chrono::milliseconds).
+         */
+        static ShutdownReport shutdown(std::chrono::milliseconds timeout);
+
       // Non-Static Methods
         /**
          * If <code>assertionVal</code> parameter is <code>false</code>, then
@@ -195,6 +225,16 @@ namespace log4cplus
 
         void forcedLog(spi::InternalLoggingEvent const &) const;
 
+        /**
+         * Logs the events of <code>events</code> whose LogLevel this
+         * logger is enabled for. Appenders receive runs of consecutive
+         * enabled events at once, through Appender::doAppendBatch(),
+         * so language bindings can submit many preformatted records per
+         * call. Events keep their own logger names and time stamps, see
+         * spi::InternalLoggingEvent::setTimestamp().
+         */
+        void logBatch(std::span<spi::InternalLoggingEvent const> events) const;
+
         /**
          * Call the appenders in the hierrachy starting at
          * <code>this</code>.  If no appenders could be found, emit a
@@ -208,6 +248,30 @@ namespace log4cplus
          */
         void callAppenders(const spi::InternalLoggingEvent& event) const;
 
+        /**
+         * Batch counterpart of callAppenders(). Appenders receive the
+         * events at once through Appender::doAppendBatch(), e.g., when
+         * a collector forwards events decoded from a client.
+         */
+        void callAppenders(
+            std::span<spi::InternalLoggingEvent const> events) const;
+
+        /**
+         * Returns <code>true</code> if all appenders that would receive
+         * events from this logger are asynchronous.
+         *
+         * @see spi::LoggerImpl::hasOnlyAsyncAppenders()
+         */
+        bool hasOnlyAsyncAppenders() const;
+
+        /**
+         * Returns combination of spi::EventFields read by appenders that
+         * would receive events from this logger.
+         *
+         * @see spi::LoggerImpl::getRequiredEventFields()
+         */
+        unsigned getRequiredEventFields() const;
+
         /**
          * Starting from this logger, search the logger hierarchy for a
          * "set" LogLevel and return it. Otherwise, return the LogLevel of the
@@ -218,6 +282,15 @@ namespace log4cplus
          */
         LogLevel getChainedLogLevel() const;
 
+        /**
+         * Returns the lowest LogLevel that passes the chained LogLevel,
+         * the shedding threshold and the disable threshold of the
+         * hierarchy. isEnabledFor() also consults appenders and
+         * filters. The value is cached until log levels of the
+         * hierarchy change.
+         */
+        LogLevel getEnabledThreshold() const;
+
         /**
          * Returns the assigned LogLevel, if any, for this Logger.
          *
@@ -251,6 +324,21 @@ namespace log4cplus
          */
         void setAdditivity(bool additive);
 
+        /**
+         * Sets limits on sizes of message, NDC and MDC values of events
+         * logged through forcedLog() by this logger and by its
+         * descendants without limits of their own. Oversized data are
+         * cut before the event is copied anywhere, see
+         * spi::InternalLoggingEvent::applyCaptureLimits(), and counted
+         * by Hierarchy::getTruncatedEventCount(). Null removes the
+         * limits of this logger.
+         */
+        void setCaptureLimits(
+            std::shared_ptr<spi::CaptureLimits const> limits);
+
+        //! Returns limits set by setCaptureLimits() on this logger.
+        std::shared_ptr<spi::CaptureLimits const> getCaptureLimits() const;
+
       // AppenderAttachable Methods
         virtual void addAppender(SharedAppenderPtr newAppender);
 
@@ -279,6 +367,11 @@ namespace log4cplus
          */
         Logger getParent() const;
 
+        /**
+         * Returns non-owning handle of this Logger. See LoggerRef.
+         */
+        LoggerRef view() const LOG4CPLUS_NOEXCEPT;
+
     protected:
       // Data
         /** This is a pointer to the implementation class. */
@@ -302,6 +395,70 @@ namespace log4cplus
         friend class log4cplus::Hierarchy;
         friend class log4cplus::HierarchyLocker;
         friend class log4cplus::DefaultLoggerFactory;
+        friend class log4cplus::LoggerRef;
+    };
+
+
+    /**
+     * Non-owning handle of a Logger. Unlike Logger, copying and
+     * destroying it does not touch the reference count shared by all
+     * handles of the logger, so it is cheap to pass by value and to
+     * store in many objects. The logger it refers to is kept alive by
+     * its Hierarchy; the handle is valid until the Hierarchy is
+     * cleared, shut down or destroyed.
+     *
+     * The logging macros accept it in place of Logger.
+     */
+    class LOG4CPLUS_EXPORT LoggerRef
+    {
+    public:
+        LoggerRef () LOG4CPLUS_NOEXCEPT = default;
+        LoggerRef (Logger const & logger) LOG4CPLUS_NOEXCEPT
+            : value (logger.value)
+        { }
+
+        //! \return Owning handle of the same logger.
+        Logger lock() const;
+
+        bool isEnabledFor(LogLevel ll) const;
+
+        void log(LogLevel ll, const log4cplus::tstring_view& message,
+            const char* file = LOG4CPLUS_CALLER_FILE (),
+            int line = LOG4CPLUS_CALLER_LINE (),
+            const char* function = LOG4CPLUS_CALLER_FUNCTION ()) const;
+
+        void forcedLog(LogLevel ll, const log4cplus::tstring_view& message,
+            const char* file = LOG4CPLUS_CALLER_FILE (),
+            int line = LOG4CPLUS_CALLER_LINE (),
+            const char* function = LOG4CPLUS_CALLER_FUNCTION ()) const;
+
+        void forcedLog(spi::InternalLoggingEvent const &) const;
+
+        bool hasOnlyAsyncAppenders() const;
+
+        LogLevel getChainedLogLevel() const;
+
+        log4cplus::tstring const & getName() const;
+
+        explicit operator bool () const LOG4CPLUS_NOEXCEPT
+        {
+            return value != nullptr;
+        }
+
+        friend bool operator == (LoggerRef const & a, LoggerRef const & b)
+            LOG4CPLUS_NOEXCEPT
+        {
+            return a.value == b.value;
+        }
+
+        friend bool operator != (LoggerRef const & a, LoggerRef const & b)
+            LOG4CPLUS_NOEXCEPT
+        {
+            return a.value != b.value;
+        }
+
+    private:
+        spi::LoggerImpl * value = nullptr;
     };
 
 
@@ -33,10 +33,38 @@
 
 #include <log4cplus/streams.h>
 #include <log4cplus/logger.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/helpers/bufferstream.h>
 #include <log4cplus/helpers/snprintf.h>
 #include <log4cplus/tracelogger.h>
+#if defined (LOG4CPLUS_MACRO_CALL_SITE_PROFILE)
+#  include <log4cplus/callsiteprofile.h>
+#endif
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <sstream>
 #include <utility>
+#include <version>
+
+#if defined (LOG4CPLUS_WITH_FMT)
+#  define LOG4CPLUS_HAVE_FORMAT
+#  include <fmt/format.h>
+#  if defined (UNICODE)
+#    include <fmt/xchar.h>
+#  endif
+#elif defined (__cpp_lib_format) && __cpp_lib_format >= 202207L
+#  define LOG4CPLUS_HAVE_STD_FORMAT
+#  define LOG4CPLUS_HAVE_FORMAT
+#  include <format>
+#endif
+
+#if defined (LOG4CPLUS_HAVE_FORMAT)
+#  include <iterator>
+#  include <memory>
+#  include <tuple>
+#  include <type_traits>
+#endif
 
 
 #if defined(_MSC_VER)
@@ -74,6 +102,34 @@
 #define LOG4CPLUS_DISABLE_TRACE
 #endif
 
+/**
+ * @def LOG4CPLUS_COMPILE_TIME_MIN_LEVEL Logging macros of log levels
+ * below this value compile to nothing, including the evaluation of
+ * their arguments. It applies to the plain, _STR, _FMT and _FORMAT
+ * variants of the level macros and to the LOG4CPLUS_BINLOG_ macros, but
+ * not to LOG4CPLUS_TRACE_METHOD(). It can be set for the whole build or,
+ * before including this header, for one translation unit.
+ *
+ * Namespaces, functions and, as a static member, classes can raise the
+ * floor for the statements inside them by declaring their own
+ * <code>log4cplus_compile_time_min_level</code>:
+ * \code
+ * namespace codec {
+ * constexpr log4cplus::LogLevel log4cplus_compile_time_min_level
+ *     = log4cplus::INFO_LOG_LEVEL;
+ * }
+ * \endcode
+ */
+#if ! defined (LOG4CPLUS_COMPILE_TIME_MIN_LEVEL)
+#define LOG4CPLUS_COMPILE_TIME_MIN_LEVEL log4cplus::ALL_LOG_LEVEL
+#endif
+
+
+//! Default of the scoped compile time floor, see
+//! LOG4CPLUS_COMPILE_TIME_MIN_LEVEL.
+constexpr log4cplus::LogLevel log4cplus_compile_time_min_level
+    = log4cplus::ALL_LOG_LEVEL;
+
 
 namespace log4cplus
 {
@@ -82,17 +138,36 @@ namespace detail
 {
 
 
+constexpr
+bool
+macro_level_enabled (LogLevel ll, LogLevel min_level,
+    LogLevel scope_min_level)
+{
+    return ll >= min_level && ll >= scope_min_level;
+}
+
+
+//! Loggers given by lvalues are used through non-owning handles, so
+//! that the reference count of the logger is not touched.
 inline
-Logger
+LoggerRef
 macros_get_logger (Logger const & logger)
 {
-    return logger;
+    return LoggerRef (logger);
 }
 
 
 inline
-Logger const &
+LoggerRef
 macros_get_logger (Logger & logger)
+{
+    return LoggerRef (logger);
+}
+
+
+inline
+LoggerRef
+macros_get_logger (LoggerRef const & logger)
 {
     return logger;
 }
@@ -121,17 +196,283 @@ macros_get_logger (tchar const * logger)
 }
 
 
+//! Per call site cache of the logger and of its enabled threshold used
+//! when the logger is given by a string literal name. Entries are
+//! revalidated when the log levels generation of the default hierarchy
+//! changes. Replaced entries are retired rather than freed because other
+//! threads may still be using them; that only happens after
+//! Hierarchy::clear().
+class LOG4CPLUS_EXPORT named_logger_cache
+{
+public:
+    constexpr named_logger_cache () = default;
+
+    named_logger_cache (named_logger_cache const &) = delete;
+    named_logger_cache & operator = (named_logger_cache const &) = delete;
+
+    LoggerRef
+    get_logger (tchar const * name)
+    {
+        entry const * e = current.load (std::memory_order_acquire);
+        if (LOG4CPLUS_LIKELY (e != nullptr
+                && static_cast<unsigned>(
+                    state.load (std::memory_order_relaxed) >> 32)
+                == e->generation->load (std::memory_order_acquire)))
+            return e->logger;
+
+        return refresh (name);
+    }
+
+    //! \return Logger::getEnabledThreshold() as of the last
+    //! get_logger().
+    LogLevel
+    threshold () const
+    {
+        return static_cast<LogLevel>(
+            static_cast<std::int32_t>(static_cast<std::uint32_t>(
+                    state.load (std::memory_order_relaxed))));
+    }
+
+    //! Valid only after get_logger() has returned <code>l</code>.
+    bool
+    is_enabled_for (LoggerRef const & l, LogLevel ll) const
+    {
+        return ll >= threshold () && l.isEnabledFor (ll);
+    }
+
+private:
+    struct entry
+    {
+        Logger logger;
+        std::atomic<unsigned> const * generation;
+    };
+
+    Logger const & refresh (tchar const * name);
+
+    //! Takes ownership of replaced entry <code>e</code>; retired entries
+    //! are freed at exit.
+    static void retire (entry const * e);
+
+    std::atomic<entry const *> current {nullptr};
+
+    //! Log levels generation in the upper 32 bits, enabled threshold
+    //! of the logger in the lower 32 bits.
+    std::atomic<std::uint64_t> state {0};
+};
+
+
+//! Static state of one logging macro expansion. It is empty unless the
+//! logger is given by a string literal name.
+template <typename T>
+struct macro_logger_cache
+{ };
+
+
+template <std::size_t N>
+struct macro_logger_cache<tchar const (&)[N]>
+    : named_logger_cache
+{ };
+
+
+template <typename T, typename L>
+inline
+decltype (auto)
+macros_get_logger (macro_logger_cache<T> &, L && logger)
+{
+    return macros_get_logger (std::forward<L> (logger));
+}
+
+
+template <std::size_t N>
+inline
+LoggerRef
+macros_get_logger (macro_logger_cache<tchar const (&)[N]> & cache,
+    tchar const (& name)[N])
+{
+    return cache.get_logger (name);
+}
+
+
+template <typename T>
+inline
+bool
+macros_is_enabled_for (macro_logger_cache<T> const &, LoggerRef const & l,
+    LogLevel ll)
+{
+    return l.isEnabledFor (ll);
+}
+
+
+template <std::size_t N>
+inline
+bool
+macros_is_enabled_for (macro_logger_cache<tchar const (&)[N]> const & cache,
+    LoggerRef const & l, LogLevel ll)
+{
+    return cache.is_enabled_for (l, ll);
+}
+
+
 LOG4CPLUS_EXPORT void clear_tostringstream (tostringstream &);
+LOG4CPLUS_EXPORT void clear_tostringstream (helpers::buffer_ostream &);
 
 
+//! Per thread stream of LOG4CPLUS_MACRO_BODY, cleared for a new message.
+LOG4CPLUS_EXPORT log4cplus::helpers::buffer_ostream & get_macro_body_stream ();
+//! Per thread string stream, cleared for a new message. Kept for code
+//! compiled against earlier headers; macros use get_macro_body_stream().
 LOG4CPLUS_EXPORT log4cplus::tostringstream & get_macro_body_oss ();
 LOG4CPLUS_EXPORT log4cplus::helpers::snprintf_buf & get_macro_body_snprintf_buf ();
-LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
+LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::LoggerRef const &,
     log4cplus::LogLevel, log4cplus::tstring_view const &, char const *, int,
     char const *);
-LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
+LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::LoggerRef const &,
     log4cplus::LogLevel, log4cplus::tchar const *, char const *, int,
     char const *);
+LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::LoggerRef const &,
+    log4cplus::LogLevel, spi::DeferredMessagePtr, char const *, int,
+    char const *);
+
+//! \return Thread local event set up for logging by the *_KV macros.
+LOG4CPLUS_EXPORT spi::InternalLoggingEvent & macro_kv_event (
+    log4cplus::LoggerRef const &, log4cplus::LogLevel,
+    log4cplus::tstring_view const &, char const *, int, char const *);
+
+
+inline
+void
+add_key_values (spi::KeyValues &)
+{ }
+
+
+template <typename Value, typename... Rest>
+void
+add_key_values (spi::KeyValues & kvs, tstring_view const & key,
+    Value const & value, Rest const &... rest)
+{
+    kvs.add (key, value);
+    add_key_values (kvs, rest...);
+}
+
+
+//! Logs <code>msg</code> with key/value fields given as alternating
+//! keys and values in <code>args</code>. Values are stored in their
+//! binary form.
+template <typename... Args>
+void
+macro_forced_log_kv (log4cplus::LoggerRef const & logger,
+    log4cplus::LogLevel log_level, char const * filename, int line,
+    char const * func, tstring_view const & msg, Args const &... args)
+{
+    static_assert (sizeof... (Args) % 2 == 0,
+        "key/value arguments have to come in pairs");
+
+    spi::InternalLoggingEvent & ev = macro_kv_event (logger, log_level, msg,
+        filename, line, func);
+    add_key_values (ev.getKeyValues (), args...);
+    logger.forcedLog (ev);
+}
+
+
+LOG4CPLUS_EXPORT log4cplus::tstring & get_macro_body_str ();
+
+
+#if defined (LOG4CPLUS_HAVE_FORMAT)
+//! Library implementing the LOG4CPLUS_*_FORMAT macros: {fmt} when
+//! log4cplus is built with it, std::format otherwise.
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+namespace format_lib = std;
+#else
+namespace format_lib = fmt;
+#endif
+
+
+//! Type used to store an argument of deferred formatting. Strings
+//! are copied, everything else is stored by value.
+template <typename T>
+using deferred_format_arg_t = std::conditional_t<
+    std::is_convertible_v<T const &, tstring_view>, tstring,
+    std::decay_t<T>>;
+
+
+//! Message formatted by vformat_to() when it is first needed.
+template <typename... Args>
+class DeferredFormatMessage final
+    : public spi::DeferredMessage
+{
+public:
+    template <typename... A>
+    explicit DeferredFormatMessage (tstring_view f, A &&... a)
+        : fmt (f)
+        , args (std::forward<A> (a)...)
+    { }
+
+    void
+    format (tstring & message) const override
+    {
+        std::apply (
+            [&] (auto const &... a)
+            {
+                format_lib::vformat_to (std::back_inserter (message), fmt,
+#if defined (UNICODE)
+                    format_lib::make_wformat_args (a...)
+#else
+                    format_lib::make_format_args (a...)
+#endif
+                    );
+            },
+            args);
+    }
+
+private:
+    //! Format string; it is a compile time constant.
+    tstring_view fmt;
+    std::tuple<Args...> args;
+};
+
+
+//! Formats and logs message. When all appenders the event would reach
+//! are asynchronous, the arguments are copied and the formatting is
+//! left to the appenders' threads. Arguments and their formatters
+//! have to be self contained for that; types referring to other
+//! objects are formatted immediately only if they are not copyable.
+template <typename... Args>
+void
+macro_format_log (log4cplus::LoggerRef const & logger,
+    log4cplus::LogLevel log_level, char const * filename, int line,
+    char const * func,
+    format_lib::basic_format_string<tchar, std::type_identity_t<Args>...> fmt,
+    Args &&... args)
+{
+    if constexpr (sizeof... (Args) != 0
+        && (std::is_constructible_v<deferred_format_arg_t<Args>, Args &&>
+            && ...))
+    {
+        if (logger.hasOnlyAsyncAppenders ())
+        {
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+            tstring_view const fmt_view = fmt.get ();
+#else
+            format_lib::basic_string_view<tchar> const fmt_view = fmt;
+#endif
+            macro_forced_log (logger, log_level,
+                std::make_shared<
+                    DeferredFormatMessage<deferred_format_arg_t<Args>...>> (
+                        tstring_view (fmt_view.data (), fmt_view.size ()),
+                        std::forward<Args> (args)...),
+                filename, line, func);
+            return;
+        }
+    }
+
+    tstring & str = get_macro_body_str ();
+    format_lib::format_to (std::back_inserter (str), fmt,
+        std::forward<Args> (args)...);
+    macro_forced_log (logger, log_level, tstring_view (str), filename,
+        line, func);
+}
+
+#endif // defined (LOG4CPLUS_HAVE_FORMAT)
 
 
 
@@ -175,8 +516,9 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
             LOG4CPLUS_MACRO_FUNCTION () }
 #endif // defined (__cpp_lib_source_location) && __cpp_lib_source_location >= 201907L
 
+// Static, so that outlined lambdas use it without capturing it.
 #define LOG4CPLUS_MACRO_LOG_LOCATION(logLocation)                   \
-    log4cplus::helpers::SourceLocation constexpr logLocation        \
+    static log4cplus::helpers::SourceLocation constexpr logLocation \
         { LOG4CPLUS_MACRO_LOG_LOCATION_VALUE() }
 
 
@@ -201,6 +543,48 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
     LOG4CPLUS_MACRO_ ## logLevel (pred)
 
 
+/**
+ * @def LOG4CPLUS_MACRO_DISABLE_OUTLINING The part of a logging macro
+ * that formats and logs the message is outlined into a lambda that is
+ * not inlined, so that a call site keeps only the level check and a
+ * call inline. The lambda of TRACE and DEBUG statements is also marked
+ * cold. Define this macro to expand the whole statement in place, e.g.,
+ * for compilers that do not capture structured bindings in lambdas.
+ */
+#if defined (__GNUC__)
+#  define LOG4CPLUS_MACRO_OUTLINED __attribute__ ((__noinline__))
+#  define LOG4CPLUS_MACRO_OUTLINED_COLD \
+    __attribute__ ((__noinline__, __cold__))
+#else
+#  define LOG4CPLUS_MACRO_OUTLINED /* empty */
+#  define LOG4CPLUS_MACRO_OUTLINED_COLD /* empty */
+#endif
+
+#define LOG4CPLUS_MACRO_OUTLINED_TRACE_LOG_LEVEL \
+    LOG4CPLUS_MACRO_OUTLINED_COLD
+#define LOG4CPLUS_MACRO_OUTLINED_DEBUG_LOG_LEVEL \
+    LOG4CPLUS_MACRO_OUTLINED_COLD
+#define LOG4CPLUS_MACRO_OUTLINED_INFO_LOG_LEVEL \
+    LOG4CPLUS_MACRO_OUTLINED
+#define LOG4CPLUS_MACRO_OUTLINED_WARN_LOG_LEVEL \
+    LOG4CPLUS_MACRO_OUTLINED
+#define LOG4CPLUS_MACRO_OUTLINED_ERROR_LOG_LEVEL \
+    LOG4CPLUS_MACRO_OUTLINED
+#define LOG4CPLUS_MACRO_OUTLINED_FATAL_LOG_LEVEL \
+    LOG4CPLUS_MACRO_OUTLINED
+
+#if defined (LOG4CPLUS_MACRO_DISABLE_OUTLINING)
+#  define LOG4CPLUS_MACRO_OUTLINED_BEGIN(logLevel) {
+#  define LOG4CPLUS_MACRO_OUTLINED_END() }
+
+#else
+#  define LOG4CPLUS_MACRO_OUTLINED_BEGIN(logLevel)  \
+    [&] () LOG4CPLUS_MACRO_OUTLINED_ ## logLevel {
+#  define LOG4CPLUS_MACRO_OUTLINED_END() } ()
+
+#endif
+
+
 // Either use temporary instances of ostringstream
 // and snprintf_buf, or use thread-local instances.
 #if defined (LOG4CPLUS_MACRO_DISABLE_TLS)
@@ -212,8 +596,8 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
 
 #else
 #  define LOG4CPLUS_MACRO_INSTANTIATE_OSTRINGSTREAM(var)    \
-    log4cplus::tostringstream & var                         \
-        = log4cplus::detail::get_macro_body_oss ()
+    log4cplus::helpers::buffer_ostream & var                \
+        = log4cplus::detail::get_macro_body_stream ()
 
 #  define LOG4CPLUS_MACRO_INSTANTIATE_SNPRINTF_BUF(var)     \
     log4cplus::helpers::snprintf_buf & var                  \
@@ -222,21 +606,61 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
 #endif
 
 
+// Per call site profile, see log4cplus/callsiteprofile.h.
+#if defined (LOG4CPLUS_MACRO_CALL_SITE_PROFILE)
+#  define LOG4CPLUS_MACRO_CALL_SITE(logLevel)                           \
+    static log4cplus::detail::CallSite _log4cplus_call_site (           \
+        LOG4CPLUS_MACRO_FILE (), __LINE__, LOG4CPLUS_MACRO_FUNCTION (), \
+        log4cplus::logLevel);                                           \
+    _log4cplus_call_site.checks.fetch_add (1, std::memory_order_relaxed)
+
+#  define LOG4CPLUS_MACRO_CALL_SITE_EMISSION()                          \
+    log4cplus::detail::CallSiteEmission _log4cplus_call_site_emission ( \
+        _log4cplus_call_site)
+
+#  define LOG4CPLUS_MACRO_CALL_SITE_BYTES(chars)                        \
+    _log4cplus_call_site_emission.addBytes ((chars),                    \
+        sizeof (log4cplus::tchar))
+
+#else
+#  define LOG4CPLUS_MACRO_CALL_SITE(logLevel) /* empty */
+#  define LOG4CPLUS_MACRO_CALL_SITE_EMISSION() /* empty */
+#  define LOG4CPLUS_MACRO_CALL_SITE_BYTES(chars) /* empty */
+
+#endif
+
+
 #define LOG4CPLUS_MACRO_BODY(logger, logEvent, logLevel)                \
     LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
     do {                                                                \
-        log4cplus::Logger const & _l                                    \
-            = log4cplus::detail::macros_get_logger (logger);            \
-        if (LOG4CPLUS_MACRO_LOGLEVEL_PRED (                             \
-                _l.isEnabledFor (log4cplus::logLevel), logLevel)) {     \
-            LOG4CPLUS_MACRO_INSTANTIATE_OSTRINGSTREAM (_log4cplus_buf); \
-            _log4cplus_buf << logEvent;                                 \
-            LOG4CPLUS_MACRO_LOG_LOCATION (_logLocation);                \
-            log4cplus::detail::macro_forced_log (_l,                    \
-                log4cplus::logLevel, _log4cplus_buf.str(),              \
-                _logLocation.file_name (),                              \
-                _logLocation.line (),                                   \
-                _logLocation.function_name ());                         \
+        if constexpr (log4cplus::detail::macro_level_enabled (          \
+                log4cplus::logLevel, LOG4CPLUS_COMPILE_TIME_MIN_LEVEL,  \
+                log4cplus_compile_time_min_level)) {                    \
+            static log4cplus::detail::macro_logger_cache<               \
+                decltype ((logger))> _log4cplus_logger_cache;           \
+            auto const & _l                                             \
+                = log4cplus::detail::macros_get_logger (                \
+                    _log4cplus_logger_cache, logger);                   \
+            LOG4CPLUS_MACRO_CALL_SITE (logLevel);                       \
+            if (LOG4CPLUS_MACRO_LOGLEVEL_PRED (                         \
+                    log4cplus::detail::macros_is_enabled_for (          \
+                        _log4cplus_logger_cache, _l,                    \
+                        log4cplus::logLevel),                           \
+                    logLevel)) {                                        \
+                LOG4CPLUS_MACRO_LOG_LOCATION (_logLocation);            \
+                LOG4CPLUS_MACRO_OUTLINED_BEGIN (logLevel)               \
+                LOG4CPLUS_MACRO_CALL_SITE_EMISSION ();                  \
+                LOG4CPLUS_MACRO_INSTANTIATE_OSTRINGSTREAM (_log4cplus_buf); \
+                _log4cplus_buf << logEvent;                             \
+                LOG4CPLUS_MACRO_CALL_SITE_BYTES (                       \
+                    _log4cplus_buf.view ().size ());                    \
+                log4cplus::detail::macro_forced_log (_l,                \
+                    log4cplus::logLevel, _log4cplus_buf.view (),        \
+                    _logLocation.file_name (),                          \
+                    _logLocation.line (),                               \
+                    _logLocation.function_name ());                     \
+                LOG4CPLUS_MACRO_OUTLINED_END ();                        \
+            }                                                           \
         }                                                               \
     } while (false)                                                     \
     LOG4CPLUS_RESTORE_DOWHILE_WARNING()
@@ -245,16 +669,30 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
 #define LOG4CPLUS_MACRO_STR_BODY(logger, logEvent, logLevel)            \
     LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
     do {                                                                \
-        log4cplus::Logger const & _l                                    \
-            = log4cplus::detail::macros_get_logger (logger);            \
-        if (LOG4CPLUS_MACRO_LOGLEVEL_PRED (                             \
-                _l.isEnabledFor (log4cplus::logLevel), logLevel)) {     \
-            LOG4CPLUS_MACRO_LOG_LOCATION (_logLocation);                \
-            log4cplus::detail::macro_forced_log (_l,                    \
-                log4cplus::logLevel, logEvent,                          \
-                _logLocation.file_name (),                              \
-                _logLocation.line (),                                   \
-                _logLocation.function_name ());                         \
+        if constexpr (log4cplus::detail::macro_level_enabled (          \
+                log4cplus::logLevel, LOG4CPLUS_COMPILE_TIME_MIN_LEVEL,  \
+                log4cplus_compile_time_min_level)) {                    \
+            static log4cplus::detail::macro_logger_cache<               \
+                decltype ((logger))> _log4cplus_logger_cache;           \
+            auto const & _l                                             \
+                = log4cplus::detail::macros_get_logger (                \
+                    _log4cplus_logger_cache, logger);                   \
+            LOG4CPLUS_MACRO_CALL_SITE (logLevel);                       \
+            if (LOG4CPLUS_MACRO_LOGLEVEL_PRED (                         \
+                    log4cplus::detail::macros_is_enabled_for (          \
+                        _log4cplus_logger_cache, _l,                    \
+                        log4cplus::logLevel),                           \
+                    logLevel)) {                                        \
+                LOG4CPLUS_MACRO_LOG_LOCATION (_logLocation);            \
+                LOG4CPLUS_MACRO_OUTLINED_BEGIN (logLevel)               \
+                LOG4CPLUS_MACRO_CALL_SITE_EMISSION ();                  \
+                log4cplus::detail::macro_forced_log (_l,                \
+                    log4cplus::logLevel, logEvent,                      \
+                    _logLocation.file_name (),                          \
+                    _logLocation.line (),                               \
+                    _logLocation.function_name ());                     \
+                LOG4CPLUS_MACRO_OUTLINED_END ();                        \
+            }                                                           \
         }                                                               \
     } while (false)                                                     \
     LOG4CPLUS_RESTORE_DOWHILE_WARNING()
@@ -262,19 +700,100 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
 #define LOG4CPLUS_MACRO_FMT_BODY(logger, logLevel, ...)                 \
     LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
     do {                                                                \
-        log4cplus::Logger const & _l                                    \
-            = log4cplus::detail::macros_get_logger (logger);            \
-        if (LOG4CPLUS_MACRO_LOGLEVEL_PRED (                             \
-                _l.isEnabledFor (log4cplus::logLevel), logLevel)) {     \
-            LOG4CPLUS_MACRO_INSTANTIATE_SNPRINTF_BUF (_snpbuf);         \
-            log4cplus::tchar const * _logEvent                          \
-                = _snpbuf.print (__VA_ARGS__);                          \
-            LOG4CPLUS_MACRO_LOG_LOCATION (_logLocation);                \
-            log4cplus::detail::macro_forced_log (_l,                    \
-                log4cplus::logLevel, _logEvent,                         \
-                _logLocation.file_name (),                              \
-                _logLocation.line (),                                   \
-                _logLocation.function_name ());                         \
+        if constexpr (log4cplus::detail::macro_level_enabled (          \
+                log4cplus::logLevel, LOG4CPLUS_COMPILE_TIME_MIN_LEVEL,  \
+                log4cplus_compile_time_min_level)) {                    \
+            static log4cplus::detail::macro_logger_cache<               \
+                decltype ((logger))> _log4cplus_logger_cache;           \
+            auto const & _l                                             \
+                = log4cplus::detail::macros_get_logger (                \
+                    _log4cplus_logger_cache, logger);                   \
+            LOG4CPLUS_MACRO_CALL_SITE (logLevel);                       \
+            if (LOG4CPLUS_MACRO_LOGLEVEL_PRED (                         \
+                    log4cplus::detail::macros_is_enabled_for (          \
+                        _log4cplus_logger_cache, _l,                    \
+                        log4cplus::logLevel),                           \
+                    logLevel)) {                                        \
+                LOG4CPLUS_MACRO_LOG_LOCATION (_logLocation);            \
+                LOG4CPLUS_MACRO_OUTLINED_BEGIN (logLevel)               \
+                LOG4CPLUS_MACRO_CALL_SITE_EMISSION ();                  \
+                LOG4CPLUS_MACRO_INSTANTIATE_SNPRINTF_BUF (_snpbuf);     \
+                log4cplus::tchar const * _logEvent                      \
+                    = _snpbuf.print (__VA_ARGS__);                      \
+                LOG4CPLUS_MACRO_CALL_SITE_BYTES (                       \
+                    std::char_traits<log4cplus::tchar>::length (        \
+                        _logEvent));                                    \
+                log4cplus::detail::macro_forced_log (_l,                \
+                    log4cplus::logLevel, _logEvent,                     \
+                    _logLocation.file_name (),                          \
+                    _logLocation.line (),                               \
+                    _logLocation.function_name ());                     \
+                LOG4CPLUS_MACRO_OUTLINED_END ();                        \
+            }                                                           \
+        }                                                               \
+    } while (false)                                                     \
+    LOG4CPLUS_RESTORE_DOWHILE_WARNING()
+
+#define LOG4CPLUS_MACRO_FORMAT_BODY(logger, logLevel, ...)              \
+    LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
+    do {                                                                \
+        if constexpr (log4cplus::detail::macro_level_enabled (          \
+                log4cplus::logLevel, LOG4CPLUS_COMPILE_TIME_MIN_LEVEL,  \
+                log4cplus_compile_time_min_level)) {                    \
+            static log4cplus::detail::macro_logger_cache<               \
+                decltype ((logger))> _log4cplus_logger_cache;           \
+            auto const & _l                                             \
+                = log4cplus::detail::macros_get_logger (                \
+                    _log4cplus_logger_cache, logger);                   \
+            LOG4CPLUS_MACRO_CALL_SITE (logLevel);                       \
+            if (LOG4CPLUS_MACRO_LOGLEVEL_PRED (                         \
+                    log4cplus::detail::macros_is_enabled_for (          \
+                        _log4cplus_logger_cache, _l,                    \
+                        log4cplus::logLevel),                           \
+                    logLevel)) {                                        \
+                LOG4CPLUS_MACRO_LOG_LOCATION (_logLocation);            \
+                LOG4CPLUS_MACRO_OUTLINED_BEGIN (logLevel)               \
+                LOG4CPLUS_MACRO_CALL_SITE_EMISSION ();                  \
+                log4cplus::detail::macro_format_log (_l,                \
+                    log4cplus::logLevel,                                \
+                    _logLocation.file_name (),                          \
+                    _logLocation.line (),                               \
+                    _logLocation.function_name (),                      \
+                    __VA_ARGS__);                                       \
+                LOG4CPLUS_MACRO_OUTLINED_END ();                        \
+            }                                                           \
+        }                                                               \
+    } while (false)                                                     \
+    LOG4CPLUS_RESTORE_DOWHILE_WARNING()
+
+#define LOG4CPLUS_MACRO_KV_BODY(logger, logLevel, ...)                  \
+    LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
+    do {                                                                \
+        if constexpr (log4cplus::detail::macro_level_enabled (          \
+                log4cplus::logLevel, LOG4CPLUS_COMPILE_TIME_MIN_LEVEL,  \
+                log4cplus_compile_time_min_level)) {                    \
+            static log4cplus::detail::macro_logger_cache<               \
+                decltype ((logger))> _log4cplus_logger_cache;           \
+            auto const & _l                                             \
+                = log4cplus::detail::macros_get_logger (                \
+                    _log4cplus_logger_cache, logger);                   \
+            LOG4CPLUS_MACRO_CALL_SITE (logLevel);                       \
+            if (LOG4CPLUS_MACRO_LOGLEVEL_PRED (                         \
+                    log4cplus::detail::macros_is_enabled_for (          \
+                        _log4cplus_logger_cache, _l,                    \
+                        log4cplus::logLevel),                           \
+                    logLevel)) {                                        \
+                LOG4CPLUS_MACRO_LOG_LOCATION (_logLocation);            \
+                LOG4CPLUS_MACRO_OUTLINED_BEGIN (logLevel)               \
+                LOG4CPLUS_MACRO_CALL_SITE_EMISSION ();                  \
+                log4cplus::detail::macro_forced_log_kv (_l,             \
+                    log4cplus::logLevel,                                \
+                    _logLocation.file_name (),                          \
+                    _logLocation.line (),                               \
+                    _logLocation.function_name (),                      \
+                    __VA_ARGS__);                                       \
+                LOG4CPLUS_MACRO_OUTLINED_END ();                        \
+            }                                                           \
         }                                                               \
     } while (false)                                                     \
     LOG4CPLUS_RESTORE_DOWHILE_WARNING()
@@ -285,10 +804,23 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
  * upon entry and exiting of a method.
  * <code>logEvent</code> will be streamed into an <code>ostream</code>.
  */
+/**
+ * @def LOG4CPLUS_TRACE_SCOPE(logger, msg) This macro creates a
+ * TraceScope which logs one TRACE_LOG_LEVEL message with the
+ * duration of the rest of the enclosing scope to <code>logger</code>
+ * upon its exit. <code>msg</code> has to be a string literal.
+ */
 #if !defined(LOG4CPLUS_DISABLE_TRACE)
 #define LOG4CPLUS_TRACE_METHOD(logger, logEvent)                        \
     log4cplus::TraceLogger _log4cplus_trace_logger(logger, logEvent,    \
         LOG4CPLUS_MACRO_LOG_LOCATION_VALUE ());
+#define LOG4CPLUS_TRACE_SCOPE(logger, msg)                              \
+    static constexpr log4cplus::TraceScopeSite                          \
+        _log4cplus_trace_scope_site {                                   \
+            msg, LOG4CPLUS_MACRO_LOG_LOCATION_VALUE () };               \
+    log4cplus::TraceScope _log4cplus_trace_scope (                      \
+        log4cplus::detail::macros_get_logger (logger),                  \
+        _log4cplus_trace_scope_site)
 #define LOG4CPLUS_TRACE(logger, logEvent)                               \
     LOG4CPLUS_MACRO_BODY (logger, logEvent, TRACE_LOG_LEVEL)
 #define LOG4CPLUS_TRACE_STR(logger, logEvent)                           \
@@ -298,6 +830,7 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
 
 #else
 #define LOG4CPLUS_TRACE_METHOD(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
+#define LOG4CPLUS_TRACE_SCOPE(logger, msg) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_TRACE(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_TRACE_STR(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_TRACE_FMT(logger, logFmt, ...) LOG4CPLUS_DOWHILE_NOTHING()
@@ -404,6 +937,116 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
 
 #endif
 
+/**
+ * @def LOG4CPLUS_TRACE_FORMAT(logger, fmt, ...) These macros format the
+ * message using std::format() syntax. The format string is checked at
+ * compile time. If all appenders of <code>logger</code> are
+ * asynchronous, formatting is deferred to the appenders' threads.
+ * Without std::format, the macros use {fmt} when log4cplus has been
+ * built with it.
+ */
+#if defined (LOG4CPLUS_HAVE_FORMAT)
+#if !defined(LOG4CPLUS_DISABLE_TRACE)
+#define LOG4CPLUS_TRACE_FORMAT(logger, ...)                             \
+    LOG4CPLUS_MACRO_FORMAT_BODY (logger, TRACE_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_TRACE_FORMAT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_DEBUG)
+#define LOG4CPLUS_DEBUG_FORMAT(logger, ...)                             \
+    LOG4CPLUS_MACRO_FORMAT_BODY (logger, DEBUG_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_DEBUG_FORMAT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_INFO)
+#define LOG4CPLUS_INFO_FORMAT(logger, ...)                              \
+    LOG4CPLUS_MACRO_FORMAT_BODY (logger, INFO_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_INFO_FORMAT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_WARN)
+#define LOG4CPLUS_WARN_FORMAT(logger, ...)                              \
+    LOG4CPLUS_MACRO_FORMAT_BODY (logger, WARN_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_WARN_FORMAT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_ERROR)
+#define LOG4CPLUS_ERROR_FORMAT(logger, ...)                             \
+    LOG4CPLUS_MACRO_FORMAT_BODY (logger, ERROR_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_ERROR_FORMAT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_FATAL)
+#define LOG4CPLUS_FATAL_FORMAT(logger, ...)                             \
+    LOG4CPLUS_MACRO_FORMAT_BODY (logger, FATAL_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_FATAL_FORMAT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+#endif // defined (LOG4CPLUS_HAVE_FORMAT)
+
+/**
+ * @def LOG4CPLUS_INFO_KV(logger, msg, ...) These macros log message
+ * <code>msg</code> with typed key/value fields given as alternating
+ * keys and values, e.g.:
+ *
+ * <pre>
+ * LOG4CPLUS_INFO_KV (logger, LOG4CPLUS_TEXT ("request done"),
+ *     LOG4CPLUS_TEXT ("user"), id, LOG4CPLUS_TEXT ("latency_us"), t);
+ * </pre>
+ *
+ * Values are integral, enumeration, floating point or string types.
+ * They are stored in the event without formatting, see
+ * spi::KeyValues; layouts print them as they need, e.g., JsonLayout
+ * as typed JSON values or PatternLayout by %%K{key}.
+ */
+#if !defined(LOG4CPLUS_DISABLE_TRACE)
+#define LOG4CPLUS_TRACE_KV(logger, ...)                                 \
+    LOG4CPLUS_MACRO_KV_BODY (logger, TRACE_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_TRACE_KV(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_DEBUG)
+#define LOG4CPLUS_DEBUG_KV(logger, ...)                                 \
+    LOG4CPLUS_MACRO_KV_BODY (logger, DEBUG_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_DEBUG_KV(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_INFO)
+#define LOG4CPLUS_INFO_KV(logger, ...)                                  \
+    LOG4CPLUS_MACRO_KV_BODY (logger, INFO_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_INFO_KV(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_WARN)
+#define LOG4CPLUS_WARN_KV(logger, ...)                                  \
+    LOG4CPLUS_MACRO_KV_BODY (logger, WARN_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_WARN_KV(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_ERROR)
+#define LOG4CPLUS_ERROR_KV(logger, ...)                                 \
+    LOG4CPLUS_MACRO_KV_BODY (logger, ERROR_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_ERROR_KV(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+#if !defined(LOG4CPLUS_DISABLE_FATAL)
+#define LOG4CPLUS_FATAL_KV(logger, ...)                                 \
+    LOG4CPLUS_MACRO_KV_BODY (logger, FATAL_LOG_LEVEL, __VA_ARGS__)
+#else
+#define LOG4CPLUS_FATAL_KV(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+
+
 //! Helper macro for LOG4CPLUS_ASSERT() macro.
 #define LOG4CPLUS_ASSERT_STRINGIFY(X) #X
 
@@ -32,6 +32,7 @@
 #pragma once
 #endif
 
+#include <atomic>
 #include <vector>
 #include <memory>
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
@@ -167,10 +168,29 @@ namespace log4cplus {
 
         void pushLogLevelTranslator(SharedLogLevelTranslatorPtr);
 
+        /**
+         * Returns a number that changes whenever results of toString()
+         * and fromString() may have changed. Users that cache
+         * toString() results compare it to find out their cache is
+         * stale.
+         */
+        unsigned getGeneration() const
+        {
+            return generation.load (std::memory_order_acquire);
+        }
+
+        /**
+         * Changes the value returned by getGeneration(). Translators
+         * that start translating other levels after they have been
+         * pushed have to call it.
+         */
+        void invalidateCaches();
+
     private:
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
         mutable std::shared_mutex mtx;
 #endif
+        std::atomic<unsigned> generation;
 
         typedef std::vector<SharedLogLevelTranslatorPtr> LogLevelTranslatorList;
         LogLevelTranslatorList translator_list;
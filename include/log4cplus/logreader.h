@@ -0,0 +1,170 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    logreader.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_LOG_READER_HEADER_
+#define LOG4CPLUS_LOG_READER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/tstring.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace log4cplus
+{
+
+/**
+ * Read-only view of a log file written by RollingFileAppender or
+ * TimeBasedRollingFileAppender. The file is memory mapped and its
+ * index, written with <tt>Index</tt> property, is used to find the
+ * part of the file holding events of a time range without scanning
+ * the file from its start.
+ *
+ * Index entries can be sparse, see <tt>IndexEvery</tt> and
+ * <tt>IndexIntervalMs</tt> properties. The range found is then
+ * widened to the nearest entries: it can start and end with events
+ * that are outside of the requested times.
+ */
+class LOG4CPLUS_EXPORT IndexedLogReader
+{
+public:
+    //! Index entry.
+    struct Entry
+    {
+        //! Time stamp of the event, in microseconds since epoch.
+        std::int64_t time;
+
+        //! Offset of the first byte of the event in the file.
+        std::uint64_t offset;
+    };
+
+    /**
+     * Maps file <code>name</code> and reads its index,
+     * <code>name</code> with <tt>.idx</tt> appended. A missing index
+     * is not an error; the whole file is then in any time range.
+     *
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    explicit IndexedLogReader (tstring const & name);
+    ~IndexedLogReader ();
+
+    //! \returns Contents of the file.
+    std::string_view contents () const
+    { return std::string_view (data, size); }
+
+    //! \returns Entries of the index, ordered by offsets. Entries
+    //! pointing past the end of the file are dropped.
+    std::vector<Entry> const & getIndex () const
+    { return index; }
+
+    //! \returns Offset in the file from which events at or after
+    //! <code>since</code> are found.
+    std::size_t seek (helpers::Time const & since) const;
+
+    //! \returns Offset in the file up to which events at or before
+    //! <code>until</code> are found.
+    std::size_t seekEnd (helpers::Time const & until) const;
+
+private:
+    char const * data;
+    std::size_t size;
+    std::vector<Entry> index;
+
+    IndexedLogReader (IndexedLogReader const &);
+    IndexedLogReader & operator = (IndexedLogReader const &);
+};
+
+
+/**
+ * Merges log files, e.g., files written by several processes through
+ * <tt>%pid</tt> in file name, into one stream ordered by time stamps
+ * of the events. Files are memory mapped. Event times come from the
+ * index of a file when it has one; that needs an entry for every
+ * event. In files without index, each line that starts with a time
+ * stamp in the date format starts an event. Other lines, e.g.,
+ * continuations of multi-line messages, go with the preceding event.
+ */
+class LOG4CPLUS_EXPORT LogMerger
+{
+public:
+    /**
+     * @param dateFormat Format of local time stamps at starts of lines
+     * of files without index: the format of <tt>%D</tt> conversion of
+     * the PatternLayout that wrote the files, preceded by any text the
+     * pattern has before it. Supported are <tt>%Y</tt>, <tt>%m</tt>,
+     * <tt>%d</tt>, <tt>%H</tt>, <tt>%M</tt>, <tt>%S</tt>, <tt>%q</tt>,
+     * <tt>%Q</tt> and <tt>%%</tt>; other characters have to match
+     * exactly. Empty format allows only files with index.
+     */
+    explicit LogMerger (tstring const & dateFormat = tstring ());
+    ~LogMerger ();
+
+    /**
+     * Maps file <code>name</code> and finds its events.
+     *
+     * @throws std::runtime_error if the file cannot be opened, or if
+     * it has no index and there is no date format.
+     */
+    void addFile (tstring const & name);
+
+    /**
+     * Passes contents of the files to <code>sink</code> in order of
+     * time stamps of the events. Events of equal time stamps keep the
+     * order of the files. Runs of events of one file which are not
+     * interleaved by events of other files are passed in one call.
+     */
+    void merge (std::function<void (std::string_view)> const & sink) const;
+
+private:
+    struct Source;
+
+    std::string dateFormat;
+    std::vector<std::unique_ptr<Source>> sources;
+
+    LogMerger (LogMerger const &);
+    LogMerger & operator = (LogMerger const &);
+};
+
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_LOG_READER_HEADER_
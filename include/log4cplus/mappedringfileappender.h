@@ -0,0 +1,135 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    mappedringfileappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_MAPPED_RING_FILE_APPENDER_HEADER_
+#define LOG4CPLUS_MAPPED_RING_FILE_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/appender.h>
+#include <cstdint>
+#include <string>
+
+
+namespace log4cplus
+{
+
+/**
+ * Flight recorder style appender. It preallocates a file of fixed
+ * size, maps it into memory and copies formatted records into the
+ * mapping as a ring buffer. Appending an event does not involve any
+ * system call. Once the ring is full, the oldest records are
+ * overwritten.
+ *
+ * The file starts with a small header holding the ring capacity and
+ * the total number of bytes ever written. The header is updated
+ * atomically after each record is copied, so the log survives a crash
+ * of the process and can be inspected post-mortem without any flush,
+ * see readContents(). Reopening an existing ring file of the same
+ * size continues where the previous writer stopped.
+ *
+ * Records are stored encoded as UTF-8 in UNICODE builds.
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>File</tt></dt>
+ * <dd>This property specifies ring file name.</dd>
+ *
+ * <dt><tt>FileSize</tt></dt>
+ * <dd>Capacity of the ring, in bytes. Suffixes "KB" and "MB" are
+ * recognized. Defaults to 10 MB; the minimum is 4 KB.</dd>
+ *
+ * <dt><tt>CreateDirs</tt></dt>
+ * <dd>Set this property to <tt>true</tt> if you want to create
+ * missing directories in path leading to the ring file.</dd>
+ * </dl>
+ */
+class LOG4CPLUS_EXPORT MappedRingFileAppender
+    : public Appender
+{
+public:
+    MappedRingFileAppender (tstring const & filename,
+        std::size_t fileSize = 10 * 1024 * 1024, bool createDirs = false);
+    MappedRingFileAppender (helpers::Properties const & properties);
+    virtual ~MappedRingFileAppender ();
+
+    virtual void close ();
+
+    /**
+     * Reads records retained in ring file <code>filename</code>,
+     * oldest first, into <code>contents</code>. If the ring has
+     * wrapped, the partially overwritten oldest record is dropped.
+     *
+     * @return <code>false</code> if the file cannot be read or it is
+     * not a ring file.
+     */
+    static bool readContents (tstring const & filename,
+        std::string & contents);
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+
+    void open ();
+
+    tstring filename;
+    std::size_t fileSize;
+    bool createDirs;
+
+    //! Encoded current record.
+    std::string record;
+
+    //! Start of the mapping.
+    char * mapping;
+
+#if defined (_WIN32)
+    //! File HANDLE.
+    void * handle;
+
+    //! File mapping object HANDLE.
+    void * mappingHandle;
+#else
+    int fd;
+#endif
+
+private:
+    void init ();
+
+    MappedRingFileAppender (MappedRingFileAppender const &);
+    MappedRingFileAppender & operator = (MappedRingFileAppender const &);
+};
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_MAPPED_RING_FILE_APPENDER_HEADER_
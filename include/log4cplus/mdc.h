@@ -33,7 +33,10 @@
 
 #include <log4cplus/tstring.h>
 
+#include <cstddef>
 #include <map>
+#include <memory>
+#include <vector>
 
 
 namespace log4cplus
@@ -43,6 +46,43 @@ namespace log4cplus
 typedef std::map<tstring, tstring> MappedDiagnosticContextMap;
 
 
+//! Handle of MDC key registered with MDC::registerKey().
+enum class MDCKey : std::size_t { };
+
+
+//! Contents of MDC.
+struct LOG4CPLUS_EXPORT MappedDiagnosticContext
+{
+    MappedDiagnosticContext ();
+
+    //! Takes <code>map</code> and indexes values of keys registered so
+    //! far.
+    explicit MappedDiagnosticContext (MappedDiagnosticContextMap map);
+
+    // Values point into the map of the same object.
+    MappedDiagnosticContext (MappedDiagnosticContext const &) = delete;
+    MappedDiagnosticContext & operator = (
+        MappedDiagnosticContext const &) = delete;
+
+    //! \return Value of registered <code>key</code>, or null if it is
+    //! not set.
+    tstring const * get (MDCKey key) const;
+
+    MappedDiagnosticContextMap map;
+
+    //! Values of registered keys in <code>map</code> indexed by MDCKey,
+    //! null for keys that are not set. Keys registered after the last
+    //! change of the context are beyond its end.
+    std::vector<tstring const *> values;
+};
+
+
+//! Immutable snapshot of MDC shared by events. Null pointer stands for
+//! empty context.
+typedef std::shared_ptr<MappedDiagnosticContext const>
+    MappedDiagnosticContextPtr;
+
+
 class LOG4CPLUS_EXPORT MDC
 {
 public:
@@ -57,14 +97,33 @@ public:
     bool get (tstring * value, tstring const & key) const;
     void remove (tstring const & key);
 
+    /**
+     * Registers well-known <code>key</code>. Values of registered keys
+     * are found by index instead of map look up, layouts and filters
+     * register the keys they use when they are configured. Registering
+     * the same key again returns the same handle.
+     */
+    static MDCKey registerKey (tstring const & key);
+
+    void put (MDCKey key, tstring const & value);
+    bool get (tstring * value, MDCKey key) const;
+
     MappedDiagnosticContextMap const & getContext () const;
 
+    /**
+     * Returns current context without copying it. The snapshot is
+     * replaced, and copied only if it is still referred to, by
+     * put() and remove().
+     */
+    MappedDiagnosticContextPtr getSnapshot () const;
+
     // Public ctor and dtor but only to be used by internal::DefaultContext.
     MDC ();
     virtual ~MDC ();
 
 private:
-    LOG4CPLUS_PRIVATE static MappedDiagnosticContextMap * getPtr ();
+    LOG4CPLUS_PRIVATE static std::shared_ptr<MappedDiagnosticContext> *
+        getPtr ();
 };
 
 
@@ -0,0 +1,278 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    metrics.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_METRICS_HEADER_
+#define LOG4CPLUS_METRICS_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/tstring.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace log4cplus {
+
+    class Hierarchy;
+    class Logger;
+
+
+    /**
+     * Snapshot of a log-linear histogram of durations in nanoseconds.
+     * Every power of two range is split into four buckets of equal
+     * width, so that a bucket bounds its values within 25%. Durations
+     * of 2^40 ns (about 18 minutes) and longer fall into the last
+     * bucket.
+     */
+    struct LOG4CPLUS_EXPORT LatencyHistogram
+    {
+        static std::size_t const sub_bucket_bits = 2;
+        static std::size_t const max_bits = 40;
+        static std::size_t const bucket_count
+            = (max_bits - sub_bucket_bits + 1) << sub_bucket_bits;
+
+        //! Returns index of bucket that holds <code>ns</code>.
+        static std::size_t bucketIndex (std::uint64_t ns);
+
+        //! Returns the smallest duration that falls into bucket
+        //! <code>index</code>.
+        static std::uint64_t bucketLowerBound (std::size_t index);
+
+        //! Returns upper bound of a duration not greater than the
+        //! <code>q</code>-quantile, <code>0 <= q <= 1</code>, of
+        //! recorded durations.
+        std::uint64_t quantile (double q) const;
+
+        std::array<std::uint64_t, bucket_count> buckets {};
+        //! Number of recorded durations.
+        std::uint64_t count = 0;
+        std::uint64_t sumNs = 0;
+        std::uint64_t maxNs = 0;
+    };
+
+
+    /**
+     * Counters of an appender with enabled metrics, see
+     * Appender::setMetricsEnabled() and Hierarchy::collectMetrics().
+     */
+    struct LOG4CPLUS_EXPORT AppenderMetrics
+    {
+        log4cplus::tstring name;
+
+        //! Events passed to <code>Appender::append()</code>.
+        std::uint64_t events = 0;
+
+        //! Bytes of output formatted by the appender's layout.
+        std::uint64_t bytes = 0;
+
+        //! Events rejected by threshold or filters.
+        std::uint64_t filtered = 0;
+
+        //! Events lost because the appender was closed, its lock file
+        //! could not be locked or its queue was full.
+        std::uint64_t dropped = 0;
+
+        //! Events whose append threw an exception.
+        std::uint64_t errors = 0;
+
+        //! Durations of <code>Appender::syncDoAppend()</code>, including
+        //! wait for the appender's lock.
+        LatencyHistogram appendLatency;
+
+        //! Time events of appenders with <tt>AsyncAppend=true</tt>
+        //! spent queued before a worker started appending them.
+        LatencyHistogram queueLatency;
+    };
+
+
+    /**
+     * Volume of events logged through a logger, see
+     * Hierarchy::setVolumeAccounting() and Hierarchy::volumeReport().
+     */
+    struct LOG4CPLUS_EXPORT LoggerVolume
+    {
+        log4cplus::tstring name;
+
+        //! Events logged through the logger itself.
+        std::uint64_t events = 0;
+
+        //! Bytes of messages of <code>events</code>.
+        std::uint64_t bytes = 0;
+
+        //! Events logged through the logger and all its descendants.
+        std::uint64_t totalEvents = 0;
+
+        //! Bytes of messages of <code>totalEvents</code>.
+        std::uint64_t totalBytes = 0;
+    };
+
+
+    /**
+     * Top talkers of a hierarchy, see Hierarchy::volumeReport().
+     */
+    struct LOG4CPLUS_EXPORT VolumeReport
+    {
+        //! Loggers with counted events and their ancestors, by
+        //! <code>totalBytes</code> in descending order.
+        std::vector<LoggerVolume> loggers;
+
+        //! Appenders with enabled metrics, by formatted bytes in
+        //! descending order.
+        std::vector<AppenderMetrics> appenders;
+    };
+
+
+    /**
+     * Formats <code>metrics</code> in Prometheus text exposition
+     * format. Latencies are exported as histograms in seconds with
+     * bucket boundaries at powers of two nanoseconds.
+     */
+    LOG4CPLUS_EXPORT log4cplus::tstring formatPrometheusMetrics (
+        std::vector<AppenderMetrics> const & metrics);
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    class MetricsDumpTask;
+
+    /**
+     * Periodically logs metrics of all appenders of a hierarchy that
+     * have metrics enabled, one INFO event per appender, to the given
+     * logger. Dumping stops when the instance is destroyed.
+     */
+    class LOG4CPLUS_EXPORT MetricsReporter
+    {
+    public:
+        MetricsReporter (Logger const & logger, unsigned millis = 60 * 1000);
+        MetricsReporter (Logger const & logger, unsigned millis,
+            Hierarchy & hierarchy);
+        ~MetricsReporter ();
+
+    private:
+        MetricsReporter (MetricsReporter const &) = delete;
+        MetricsReporter & operator = (MetricsReporter const &) = delete;
+
+        MetricsDumpTask * dumpTask;
+    };
+
+
+    class VolumeReportTask;
+
+    /**
+     * Periodically logs Hierarchy::volumeReport() of a hierarchy with
+     * volume accounting enabled, one INFO event per logger and per
+     * appender of the report, to the given logger. Reporting stops when
+     * the instance is destroyed.
+     */
+    class LOG4CPLUS_EXPORT VolumeReporter
+    {
+    public:
+        VolumeReporter (Logger const & logger, unsigned millis = 60 * 1000,
+            std::size_t topN = 10);
+        VolumeReporter (Logger const & logger, unsigned millis,
+            std::size_t topN, Hierarchy & hierarchy);
+        ~VolumeReporter ();
+
+    private:
+        VolumeReporter (VolumeReporter const &) = delete;
+        VolumeReporter & operator = (VolumeReporter const &) = delete;
+
+        VolumeReportTask * reportTask;
+    };
+
+
+    //! Thresholds of LoadShedder.
+    struct LoadSheddingSettings
+    {
+        //! Period of sampling, in milliseconds.
+        unsigned intervalMillis = 250;
+
+        //! Number of events queued in the thread pool and in
+        //! AsyncAppender queues that counts as pressure. Twice as many
+        //! sheds INFO as well.
+        std::size_t queueDepth = 10000;
+
+        //! 99th percentile of <code>Appender::syncDoAppend()</code>
+        //! durations over a sampling period, of appenders with enabled
+        //! metrics, that counts as pressure. Twice as much sheds INFO as
+        //! well.
+        std::chrono::nanoseconds appendLatency {std::chrono::milliseconds (5)};
+
+        //! Number of consecutive samples with less than half the
+        //! pressure after which shedding steps back.
+        unsigned restoreIntervals = 8;
+    };
+
+
+    class LoadSheddingTask;
+
+    /**
+     * Governor that sheds logging load under back-pressure. It samples
+     * depth of asynchronous queues, append latencies and drop counters
+     * of appenders with enabled metrics of a hierarchy and raises its
+     * Hierarchy::setSheddingThreshold(): first TRACE and DEBUG events
+     * are dropped, then INFO events. Drops escalate by one step. The
+     * threshold is lowered one step at a time once pressure stays below
+     * half of the thresholds for LoadSheddingSettings::restoreIntervals
+     * samples. Every change is logged to the given logger. The
+     * threshold is removed when the instance is destroyed.
+     */
+    class LOG4CPLUS_EXPORT LoadShedder
+    {
+    public:
+        explicit LoadShedder (Logger const & logger,
+            LoadSheddingSettings const & settings = LoadSheddingSettings ());
+        LoadShedder (Logger const & logger,
+            LoadSheddingSettings const & settings, Hierarchy & hierarchy);
+        ~LoadShedder ();
+
+        //! Returns current step: 0 sheds nothing, 1 sheds TRACE and
+        //! DEBUG events, 2 sheds INFO events as well.
+        unsigned getStep () const;
+
+    private:
+        LoadShedder (LoadShedder const &) = delete;
+        LoadShedder & operator = (LoadShedder const &) = delete;
+
+        LoadSheddingTask * sheddingTask;
+    };
+#endif
+
+} // end namespace log4cplus
+
+#endif // LOG4CPLUS_METRICS_HEADER_
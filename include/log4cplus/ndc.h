@@ -147,7 +147,9 @@ namespace log4cplus {
         void inherit(const DiagnosticContextStack& stack);
 
         /**
-         * Used when printing the diagnostic context.
+         * Used when printing the diagnostic context. Messages of all
+         * levels are joined only when this is called, the result is
+         * reused until the next change of the context.
          */
         log4cplus::tstring const & get() const;
 
@@ -260,7 +262,7 @@ namespace log4cplus {
 
     private:
       // Methods
-        LOG4CPLUS_PRIVATE static DiagnosticContextStack* getPtr();
+        LOG4CPLUS_PRIVATE static DiagnosticContextStack const * getPtr();
 
         template <typename StringType>
         LOG4CPLUS_PRIVATE
@@ -299,7 +301,11 @@ namespace log4cplus {
 
       // Data
         log4cplus::tstring message; /*!< The message at this context level. */
-        log4cplus::tstring fullMessage; /*!< The entire message stack. */
+        /**
+         * The entire message stack, set only by the constructors with
+         * parent context. NDC keeps only messages, see NDC::get().
+         */
+        log4cplus::tstring fullMessage;
     };
 
 
@@ -33,12 +33,31 @@
 
 #include <log4cplus/appender.h>
 #include <log4cplus/config/windowsh-inc.h>
+#include <memory>
 
 
 namespace log4cplus {
 
     /**
-     * Appends log events to NT EventLog. 
+     * Appends log events to NT EventLog.
+     *
+     * <h3>Properties</h3>
+     * <dl>
+     * <dt><tt>server</tt>, <tt>log</tt>, <tt>source</tt></dt>
+     * <dd>Server and log to write to and the event source. The log
+     * defaults to <tt>Application</tt>.</dd>
+     *
+     * <dt><tt>Asynchronous</tt></dt>
+     * <dd>Set this property to <tt>true</tt> to report events from a
+     * writer thread of the appender. Logging threads only format the
+     * events and queue them; the writer takes all queued events at once
+     * and reports them without holding the appender lock. The queue
+     * buffers are reused. Not available in single threaded builds.</dd>
+     *
+     * <dt><tt>QueueLimit</tt></dt>
+     * <dd>Number of queued events at which logging threads wait for the
+     * writer. Defaults to 1000.</dd>
+     * </dl>
      */
     class LOG4CPLUS_EXPORT NTEventLogAppender : public Appender {
     public:
@@ -54,6 +73,9 @@ namespace log4cplus {
       // public Methods
         virtual void close();
 
+        //! Writer thread loop of asynchronous mode.
+        void writerLoop();
+
     protected:
         virtual void append(const spi::InternalLoggingEvent& event);
         virtual WORD getEventType(const spi::InternalLoggingEvent& event);
@@ -65,6 +87,9 @@ namespace log4cplus {
          */
         void addRegistryInfo();
 
+        //! Reports formatted message to the event log.
+        void reportEvent(WORD type, WORD category, tstring const & message);
+
       // Data
         log4cplus::tstring server;
         log4cplus::tstring log;
@@ -73,6 +98,9 @@ namespace log4cplus {
         SID* pCurrentUserSID;
 
     private:
+        struct AsyncWriter;
+        std::unique_ptr<AsyncWriter> writer;
+
       // Disallow copying of instances of this class
         NTEventLogAppender(const NTEventLogAppender&);
         NTEventLogAppender& operator=(const NTEventLogAppender&);
@@ -0,0 +1,232 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    otlpappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_OTLP_APPENDER_HEADER_
+#define LOG4CPLUS_OTLP_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#ifndef LOG4CPLUS_SINGLE_THREADED
+
+#include <log4cplus/appender.h>
+#include <log4cplus/helpers/socket.h>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+
+namespace log4cplus
+{
+
+namespace helpers
+{
+
+class TlsContext;
+
+} // namespace helpers
+
+
+namespace internal
+{
+
+struct otlp_exporter;
+
+} // namespace internal
+
+
+/**
+ * Exports events as OpenTelemetry log records to an OTLP collector
+ * through OTLP/HTTP with binary protobuf payload, i.e., <tt>POST</tt>
+ * of <tt>ExportLogsServiceRequest</tt> messages to <tt>/v1/logs</tt>.
+ *
+ * Events are encoded as <tt>LogRecord</tt> messages right into the
+ * queue that the exporter thread sends from, the way
+ * <tt>BatchLogRecordProcessor</tt> of OpenTelemetry SDKs batches them:
+ * a request is sent when <tt>MaxExportBatchSize</tt> records are
+ * queued or <tt>ScheduleDelay</tt> after the first queued one, and
+ * events are dropped while <tt>MaxQueueSize</tt> records wait. Logging
+ * threads never wait for the collector.
+ *
+ * A record carries time stamp of the event, severity number and text
+ * of its log level, the message as body and these attributes: logger
+ * name as <tt>logger.name</tt>, thread as <tt>thread.name</tt>,
+ * location as <tt>code.file.path</tt>, <tt>code.line.number</tt> and
+ * <tt>code.function.name</tt>, MDC entries as strings and key/value
+ * fields with their types. Hexadecimal trace and span IDs are taken
+ * from MDC entries named by <tt>TraceIdKey</tt> and
+ * <tt>SpanIdKey</tt>.
+ *
+ * Only OTLP/HTTP is supported; OTLP/gRPC needs HTTP/2.
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>Endpoint</tt></dt>
+ * <dd>URL of the logs endpoint. Defaults to
+ * <tt>http://localhost:4318/v1/logs</tt>. Scheme <tt>https</tt>
+ * enables TLS.</dd>
+ *
+ * <dt><tt>IPv6</tt></dt>
+ * <dd>Connect to the collector through IPv6. Implied by bracketed
+ * address in <tt>Endpoint</tt>.</dd>
+ *
+ * <dt><tt>Headers</tt></dt>
+ * <dd>Additional HTTP headers as comma separated <tt>key=value</tt>
+ * pairs, e.g., for authentication.</dd>
+ *
+ * <dt><tt>ServiceName</tt></dt>
+ * <dd>Value of <tt>service.name</tt> resource attribute. Defaults to
+ * <tt>unknown_service</tt>.</dd>
+ *
+ * <dt><tt>ResourceAttributes</tt></dt>
+ * <dd>Additional resource attributes as comma separated
+ * <tt>key=value</tt> pairs. <tt>host.name</tt> is always set.</dd>
+ *
+ * <dt><tt>TraceIdKey</tt>, <tt>SpanIdKey</tt></dt>
+ * <dd>MDC keys of trace and span IDs. Default to <tt>trace_id</tt>
+ * and <tt>span_id</tt>.</dd>
+ *
+ * <dt><tt>MaxExportBatchSize</tt></dt>
+ * <dd>Maximal number of records in one request. Defaults to 512.</dd>
+ *
+ * <dt><tt>ScheduleDelay</tt></dt>
+ * <dd>Milliseconds a queued record waits for a full batch. Defaults
+ * to 1000.</dd>
+ *
+ * <dt><tt>MaxQueueSize</tt></dt>
+ * <dd>Maximal number of queued records. Defaults to 2048.</dd>
+ *
+ * <dt><tt>TlsCAFile</tt>, <tt>TlsCertFile</tt>, <tt>TlsKeyFile</tt>,
+ * <tt>TlsServerName</tt>, <tt>TlsVerifyPeer</tt></dt>
+ * <dd>TLS settings used with <tt>https</tt>, same as those of
+ * SocketAppender.</dd>
+ * </dl>
+ */
+class LOG4CPLUS_EXPORT OtlpAppender
+    : public Appender
+{
+public:
+    //! Export counters, see getStats().
+    struct ExportStats
+    {
+        //! Records sent and accepted by the collector.
+        std::uint64_t exported = 0;
+        //! Records of requests that failed.
+        std::uint64_t failed = 0;
+        //! Records dropped because the queue was full.
+        std::uint64_t dropped = 0;
+        //! Records waiting in the queue.
+        std::size_t queued = 0;
+    };
+
+    explicit OtlpAppender (
+        tstring const & endpoint
+            = LOG4CPLUS_TEXT ("http://localhost:4318/v1/logs"),
+        tstring const & serviceName = LOG4CPLUS_TEXT ("unknown_service"));
+    OtlpAppender (helpers::Properties const & properties);
+    virtual ~OtlpAppender ();
+
+    //! Exports queued records and stops the exporter thread.
+    virtual void close ();
+
+    virtual unsigned getRequiredEventFields () const;
+
+    //! Exports records queued so far and waits until it is done.
+    //! \return <code>false</code> when some of the requests failed.
+    bool forceFlush ();
+
+    ExportStats getStats () const;
+
+    //! Appends fields of <tt>LogRecord</tt> message for
+    //! <code>event</code> to <code>out</code>.
+    void encodeLogRecord (std::string & out,
+        spi::InternalLoggingEvent const & event) const;
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+
+    //! Sends one request whose protobuf body is concatenation of
+    //! <code>body</code>. Called by the exporter thread.
+    //! \return <code>true</code> when the collector accepted it.
+    virtual bool exportRequest (std::span<std::string_view const> body);
+
+    tstring host;
+    unsigned short port;
+    tstring path;
+    bool useTls;
+    bool ipv6;
+    tstring traceIdKey;
+    tstring spanIdKey;
+    std::size_t maxExportBatchSize;
+    unsigned scheduleDelay;
+    std::size_t maxQueueSize;
+
+    //! Request line and fixed headers, without Content-Length.
+    std::string requestHeader;
+    //! Encoded <tt>resource</tt> field of <tt>ResourceLogs</tt>.
+    std::string resource;
+    //! Encoded <tt>scope</tt> field of <tt>ScopeLogs</tt>.
+    std::string scope;
+
+    // Used by the exporter thread only.
+    std::unique_ptr<helpers::TlsContext> tlsContext;
+    helpers::Socket socket;
+    std::chrono::steady_clock::time_point nextConnect;
+
+private:
+    void init (tstring const & endpoint, tstring const & serviceName,
+        tstring const & resourceAttributes, tstring const & headers,
+        helpers::Properties const * properties);
+    bool connect ();
+
+    std::unique_ptr<internal::otlp_exporter> exporter;
+
+    friend struct internal::otlp_exporter;
+
+    OtlpAppender (OtlpAppender const &);
+    OtlpAppender & operator = (OtlpAppender const &);
+};
+
+
+typedef helpers::SharedObjectPtr<OtlpAppender> OtlpAppenderPtr;
+
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_SINGLE_THREADED
+
+#endif // LOG4CPLUS_OTLP_APPENDER_HEADER_
@@ -43,6 +43,7 @@
 #endif
 
 #include <log4cplus/appender.h>
+#include <memory>
 
 #if defined (_WIN32)
   #if defined (log4cplusqt5debugappender_EXPORTS) \
@@ -69,10 +70,37 @@
 #endif // !_WIN32
 
 
+class QObject;
+class QThread;
+
+
 namespace log4cplus
 {
 
 
+/**
+ * Passes events to Qt message handling through <code>qDebug()</code>,
+ * <code>qWarning()</code> and <code>qCritical()</code>.
+ *
+ * By default the message handler is called by the logging thread.
+ * With <tt>Queued</tt> set, events are formatted by the logging thread
+ * and pushed onto a lock-free queue. An object living in the target
+ * thread, the main thread unless setTargetThread() says otherwise,
+ * passes all queued events to Qt at once from that thread's event
+ * loop. Events still queued are passed to Qt by close().
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>Queued</tt></dt>
+ * <dd>Set to <tt>true</tt> to hand events over to the target
+ * thread. Defaults to <tt>false</tt>.</dd>
+ *
+ * <dt><tt>DrainInterval</tt></dt>
+ * <dd>Milliseconds the target thread collects events before it passes
+ * them to Qt, e.g., 16 to pass them once per frame. Zero, the
+ * default, passes them in the next event loop iteration.</dd>
+ * </dl>
+ */
 class LOG4CPLUS_QT5DEBUGAPPENDER_EXPORT Qt5DebugAppender
     : public Appender
 {
@@ -83,11 +111,28 @@ public:
 
     virtual void close ();
 
+    //! Sets thread which passes queued events to Qt. It has to run
+    //! an event loop. Has to be called before the first event is
+    //! appended.
+    void setTargetThread (QThread * thread);
+
     static void registerAppender ();
 
+    struct Queue;
+
 protected:
     virtual void append (spi::InternalLoggingEvent const &);
 
+    bool queued;
+    unsigned drainInterval;
+    QThread * targetThread;
+
+    //! State shared with the object in the target thread.
+    std::shared_ptr<Queue> queue;
+
+    //! Object in the target thread which drains the queue.
+    QObject * receiver;
+
 private:
     Qt5DebugAppender (Qt5DebugAppender const &);
     Qt5DebugAppender & operator = (Qt5DebugAppender const &);
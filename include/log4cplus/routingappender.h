@@ -0,0 +1,161 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    routingappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_ROUTING_APPENDER_HEADER_
+#define LOG4CPLUS_ROUTING_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/appender.h>
+#include <log4cplus/thread/syncprims.h>
+#include <functional>
+#include <memory>
+
+
+namespace log4cplus
+{
+
+/**
+ * Dispatches events to child appenders by a route key computed from
+ * the event, e.g., to write a log file per tenant. The key is the
+ * value of an MDC entry or, when no MDC key is set, the first
+ * <tt>LoggerDepth</tt> components of the logger name. Children are
+ * created on first event of their key and kept in a hash map, so an
+ * event costs one lookup instead of running filters of an appender per
+ * key.
+ *
+ * At most <tt>MaxRoutes</tt> children are open; the least recently
+ * used one is closed to make room for a new one. Children idle for
+ * <tt>IdleTimeout</tt> are closed as well. A closed child is recreated
+ * by the next event of its key, so its file should be opened for
+ * appending. An evicted child is closed once events being appended to
+ * it by other threads are done.
+ *
+ * Filters of this appender must be set up before it is used.
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>MDCKey</tt></dt>
+ * <dd>Name of the MDC entry whose value is the route key.</dd>
+ *
+ * <dt><tt>LoggerDepth</tt></dt>
+ * <dd>Number of leading components of the logger name used as the
+ * route key when <tt>MDCKey</tt> is not set. Defaults to 1.</dd>
+ *
+ * <dt><tt>DefaultRoute</tt></dt>
+ * <dd>Route key of events with empty key. Defaults to
+ * <tt>default</tt>.</dd>
+ *
+ * <dt><tt>MaxRoutes</tt></dt>
+ * <dd>Maximal number of open children. Defaults to 256.</dd>
+ *
+ * <dt><tt>IdleTimeout</tt></dt>
+ * <dd>Seconds after which a child without events is closed. Defaults
+ * to 0, children are closed only to make room for others.</dd>
+ *
+ * <dt><tt>Appender</tt></dt>
+ * <dd>Name of the factory of the children. Their properties are under
+ * the <tt>Appender.</tt> subkey. Each <tt>%route</tt> in their
+ * <tt>File</tt> property is replaced by the route key, with
+ * characters other than letters, digits, <tt>-</tt>, <tt>_</tt> and
+ * <tt>.</tt> replaced by <tt>_</tt>; when there is none, <tt>.</tt>
+ * and the key are appended.</dd>
+ * </dl>
+ */
+class LOG4CPLUS_EXPORT RoutingAppender
+    : public Appender
+{
+public:
+    //! Creates child appender of route <code>key</code>. It can return
+    //! null; events of the key are dropped then.
+    typedef std::function<SharedAppenderPtr (tstring const & key)>
+        RouteFactory;
+
+    RoutingAppender (RouteFactory factory, tstring const & mdcKey,
+        std::size_t maxRoutes = 256);
+    RoutingAppender (helpers::Properties const & properties);
+    virtual ~RoutingAppender ();
+
+    virtual void close ();
+
+    //! Children are not known in advance, so all fields are required.
+    virtual unsigned getRequiredEventFields () const;
+
+    //! \return Child of route <code>key</code> if it is open.
+    SharedAppenderPtr getRoute (tstring_view key) const;
+
+    //! \return Number of open children.
+    std::size_t getRouteCount () const;
+
+    //! Closes children idle for longer than <tt>IdleTimeout</tt>.
+    //! Called periodically when the timeout is set.
+    void closeIdleRoutes ();
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+
+    //! Computes route key of <code>event</code>. The view refers to
+    //! data of the event or of this appender.
+    virtual tstring_view routeKey (
+        spi::InternalLoggingEvent const & event) const;
+
+    RouteFactory factory;
+    tstring mdcKey;
+    unsigned loggerDepth;
+    tstring defaultRoute;
+    std::size_t maxRoutes;
+    //! In milliseconds, 0 for none.
+    unsigned long idleTimeout;
+
+private:
+    struct Routes;
+
+    void init ();
+
+    //! Protects <code>routes</code>.
+    thread::Mutex routesMutex;
+    std::unique_ptr<Routes> routes;
+
+    RoutingAppender (RoutingAppender const &);
+    RoutingAppender & operator = (RoutingAppender const &);
+};
+
+
+typedef helpers::SharedObjectPtr<RoutingAppender> RoutingAppenderPtr;
+
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_ROUTING_APPENDER_HEADER_
@@ -0,0 +1,180 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    runtimecontrol.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+/** @file */
+
+#ifndef LOG4CPLUS_RUNTIME_CONTROL_HEADER_
+#define LOG4CPLUS_RUNTIME_CONTROL_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/appender.h>
+#include <log4cplus/hierarchy.h>
+#include <log4cplus/loglevel.h>
+#include <log4cplus/tstring.h>
+#include <map>
+#include <memory>
+#include <mutex>
+
+
+namespace log4cplus
+{
+
+/**
+ * Changes parts of configuration of a running process without
+ * reconfiguring it as a whole, e.g., the log level of a subtree of
+ * loggers or the threshold of a single appender.
+ *
+ * Log levels and appender thresholds are changed through the same
+ * generation counters as by Logger::setLogLevel() and
+ * Appender::setThreshold(), so that logging threads pick up the
+ * changes without taking any lock.
+ *
+ * Appenders are looked up by name among appenders attached to the
+ * loggers of the hierarchy, directly or through other appenders.
+ * All appenders of the name are changed.
+ *
+ * <h3>Commands</h3>
+ * execute() accepts these commands, the same as ControlEndpoint:
+ * <dl>
+ * <dt><tt>level LOGGER LEVEL</tt></dt>
+ * <dd>setLogLevel(); <tt>LEVEL</tt> can be <tt>INHERITED</tt>.</dd>
+ *
+ * <dt><tt>enable APPENDER</tt>, <tt>disable APPENDER</tt></dt>
+ * <dd>setAppenderEnabled()</dd>
+ *
+ * <dt><tt>queue APPENDER LIMIT</tt></dt>
+ * <dd>setQueueLimit()</dd>
+ *
+ * <dt><tt>flush APPENDER BYTES INTERVAL_MS</tt></dt>
+ * <dd>setFlushPolicy()</dd>
+ *
+ * <dt><tt>list</tt></dt>
+ * <dd>Number and names of the appenders, with <tt>:disabled</tt>
+ * appended to names of disabled ones.</dd>
+ * </dl>
+ */
+class LOG4CPLUS_EXPORT RuntimeControl
+{
+public:
+    explicit RuntimeControl (Hierarchy & hierarchy = getDefaultHierarchy ());
+    ~RuntimeControl ();
+
+    //! Sets log level of logger <code>prefix</code>, which is created
+    //! if it does not exist, and of all its existing descendants, so
+    //! that the descendants configured with levels of their own follow
+    //! as well. Name <tt>root</tt> selects the root logger and all
+    //! loggers.
+    //! \return Number of updated loggers.
+    std::size_t setLogLevel (tstring_view const & prefix, LogLevel ll);
+
+    //! Disables appenders named <code>name</code> by raising their
+    //! threshold to <code>OFF_LOG_LEVEL</code>, or restores threshold
+    //! they had before disabling.
+    //! \return Number of found appenders.
+    std::size_t setAppenderEnabled (tstring const & name, bool enabled);
+
+    //! Calls AsyncAppender::setQueueLimit() of appenders named
+    //! <code>name</code>.
+    //! \return Number of updated appenders.
+    std::size_t setQueueLimit (tstring const & name, unsigned len);
+
+    //! Calls FileAppenderBase::setFlushPolicy() of appenders named
+    //! <code>name</code>.
+    //! \return Number of updated appenders.
+    std::size_t setFlushPolicy (tstring const & name, unsigned long bytes,
+        unsigned long intervalMs);
+
+    //! Executes one of the commands listed above.
+    //! \return Reply starting with <tt>OK</tt>, followed by the number
+    //! of updated loggers or appenders, or with <tt>ERROR</tt>,
+    //! followed by the reason.
+    //! \param ok Set to <code>false</code> when the command fails.
+    tstring execute (tstring_view const & command, bool & ok);
+
+private:
+    SharedAppenderPtrList findAppenders (tstring const & name) const;
+
+    Hierarchy & hierarchy;
+
+    std::mutex mtx;
+    //! Thresholds of disabled appenders.
+    std::map<Appender *, std::pair<SharedAppenderPtr, LogLevel>> disabled;
+
+    RuntimeControl (RuntimeControl const &);
+    RuntimeControl & operator = (RuntimeControl const &);
+};
+
+
+//! \return RuntimeControl of the default hierarchy, used by the C API.
+LOG4CPLUS_EXPORT RuntimeControl & getDefaultRuntimeControl ();
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_HAVE_SYS_UN_H) && ! defined (_WIN32)
+
+/**
+ * Serves RuntimeControl commands on a unix stream socket from a thread
+ * of its own. Each line received is one command, each reply is one
+ * line. Access is
+ * controlled by permissions of the socket file, see
+ * <code>chmod</code>.
+ *
+ * E.g.: <code>echo "level net DEBUG" | socat - UNIX-CONNECT:path</code>.
+ */
+class LOG4CPLUS_EXPORT ControlEndpoint
+{
+public:
+    //! Listens at <code>path</code>; stale socket file is replaced.
+    ControlEndpoint (RuntimeControl & control, tstring const & path);
+
+    //! Stops the thread and removes the socket file.
+    ~ControlEndpoint ();
+
+    //! \return <code>false</code> if the socket could not be opened.
+    bool isOpen () const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+
+    ControlEndpoint (ControlEndpoint const &);
+    ControlEndpoint & operator = (ControlEndpoint const &);
+};
+
+#endif
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_RUNTIME_CONTROL_HEADER_
@@ -0,0 +1,201 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    sharedmemoryappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_SHARED_MEMORY_APPENDER_HEADER_
+#define LOG4CPLUS_SHARED_MEMORY_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#ifndef LOG4CPLUS_SINGLE_THREADED
+
+#include <log4cplus/appender.h>
+#include <log4cplus/helpers/appenderattachableimpl.h>
+#include <log4cplus/helpers/lockfile.h>
+#include <log4cplus/thread/syncprims.h>
+#include <log4cplus/thread/threads.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+
+namespace log4cplus
+{
+
+/**
+ * Collects events of several processes through a ring buffer in a
+ * shared file mapping. Every process that logs through the appender
+ * copies its events into the ring without taking any cross-process
+ * lock. A single drainer takes them out and appends them to the
+ * attached appenders, so, e.g., only one process writes the real log
+ * file.
+ *
+ * Each instance runs a drainer thread that competes for the lock
+ * file. The thread which gets it drains the ring until its appender is
+ * closed or its process exits, then another one takes over. Processes
+ * forked after the appender has been created only produce events.
+ *
+ * Events are transferred in the same form as SocketAppender sends
+ * them; MDC and key/value fields are not carried over. An event is
+ * dropped if it does not fit into <tt>MaxEventSize</tt>, or if the
+ * ring stays full for <tt>FullTimeout</tt>. A record whose producer
+ * died while copying it is skipped after <tt>StallTimeout</tt>.
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>File</tt></dt>
+ * <dd>Name of the file backing the ring. All processes sharing the
+ * appender have to use the same name.</dd>
+ *
+ * <dt><tt>LockFile</tt></dt>
+ * <dd>Lock file electing the drainer. Defaults to <tt>File</tt> with
+ * <tt>.lock</tt> appended.</dd>
+ *
+ * <dt><tt>RingSize</tt></dt>
+ * <dd>Capacity of the ring, in bytes. Suffixes "KB" and "MB" are
+ * recognized. Defaults to 1 MB; the minimum is 4 KB.</dd>
+ *
+ * <dt><tt>MaxEventSize</tt></dt>
+ * <dd>Maximal size of serialized event, in bytes. Defaults to the
+ * maximal SocketAppender message size.</dd>
+ *
+ * <dt><tt>DrainInterval</tt></dt>
+ * <dd>Milliseconds the drainer sleeps when the ring is empty, and
+ * between attempts to become the drainer. Defaults to 10.</dd>
+ *
+ * <dt><tt>FullTimeout</tt></dt>
+ * <dd>Milliseconds a producer waits for room in full ring before
+ * it drops the event. Defaults to 1000.</dd>
+ *
+ * <dt><tt>StallTimeout</tt></dt>
+ * <dd>Milliseconds after which an incomplete record is skipped.
+ * Defaults to 5000.</dd>
+ *
+ * <dt><tt>CreateDirs</tt></dt>
+ * <dd>Set this property to <tt>true</tt> if you want to create
+ * missing directories in paths leading to the files.</dd>
+ *
+ * <dt><tt>Appender</tt></dt>
+ * <dd>Name of the factory of the attached appender. Its properties
+ * are under the <tt>Appender.</tt> subkey.</dd>
+ * </dl>
+ *
+ * \sa helpers::AppenderAttachableImpl
+ */
+class LOG4CPLUS_EXPORT SharedMemoryAppender
+    : public Appender
+    , public helpers::AppenderAttachableImpl
+{
+public:
+    SharedMemoryAppender (SharedAppenderPtr const & app,
+        tstring const & filename, std::size_t ringSize = 1024 * 1024);
+    SharedMemoryAppender (helpers::Properties const & properties);
+    virtual ~SharedMemoryAppender ();
+
+    virtual void close ();
+
+    //! Returns fields required by the attached appenders.
+    virtual unsigned getRequiredEventFields () const;
+
+    //! \return <code>true</code> while this instance is the drainer.
+    bool isDrainer () const;
+
+    //! Appends all complete records in the ring to the attached
+    //! appenders. Called by the drainer thread.
+    //! \return Number of appended events.
+    std::size_t drain ();
+
+    //! Drainer thread loop.
+    void drainerLoop ();
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+
+    void open ();
+
+    tstring filename;
+    tstring lockFileName;
+    std::size_t ringSize;
+    std::size_t maxEventSize;
+    unsigned drainInterval;
+    unsigned fullTimeout;
+    unsigned stallTimeout;
+    bool createDirs;
+
+    //! Start of the mapping.
+    char * mapping;
+    //! Size of the mapping.
+    std::size_t mappingSize;
+
+#if defined (_WIN32)
+    //! File HANDLE.
+    void * handle;
+
+    //! File mapping object HANDLE.
+    void * mappingHandle;
+#else
+    int fd;
+#endif
+
+    std::unique_ptr<helpers::LockFile> lockFile;
+    std::atomic<bool> drainer;
+    thread::ManualResetEvent stopDrainer;
+    thread::AbstractThreadPtr drainerThread;
+
+    //! Process that created the appender and runs its drainer thread.
+    std::uint64_t creatorProcess;
+
+    //! Position and start, in milliseconds, of the stall of the record
+    //! at the tail.
+    std::uint64_t stallPosition;
+    std::uint64_t stallStart;
+
+private:
+    void init ();
+    bool tryBecomeDrainer ();
+    void resignDrainer ();
+
+    SharedMemoryAppender (SharedMemoryAppender const &);
+    SharedMemoryAppender & operator = (SharedMemoryAppender const &);
+};
+
+
+typedef helpers::SharedObjectPtr<SharedMemoryAppender> SharedMemoryAppenderPtr;
+
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_SINGLE_THREADED
+
+#endif // LOG4CPLUS_SHARED_MEMORY_APPENDER_HEADER_
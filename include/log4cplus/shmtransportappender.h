@@ -0,0 +1,207 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    shmtransportappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_SHM_TRANSPORT_APPENDER_HEADER_
+#define LOG4CPLUS_SHM_TRANSPORT_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#if defined (LOG4CPLUS_HAVE_SYS_UN_H) && defined (__linux__)
+
+#include <log4cplus/appender.h>
+#include <log4cplus/socketappender.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+namespace log4cplus
+{
+
+/**
+ * Passes events to a logging server on the same host through a shared
+ * memory ring of its own, e.g., to <tt>loggingserver
+ * --shm-socket</tt>.
+ *
+ * On the first event the appender creates the ring in a memfd and
+ * registers it, together with an eventfd, with the server over a unix
+ * stream socket. Events are then copied into the ring in the wire
+ * format 2 of SocketAppender, without any system call; the eventfd is
+ * written only when the ring goes from empty to non-empty. The server
+ * decodes the records in place and frees their space.
+ *
+ * When the ring stays full for <tt>FullTimeout</tt>, the event is
+ * dropped. When the server goes away, events are dropped until
+ * registration with a new server instance succeeds; it is attempted
+ * at most once a second.
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>Socket</tt></dt>
+ * <dd>Path of the unix socket of the server. Defaults to
+ * <tt>/tmp/log4cplus-shm.sock</tt>.</dd>
+ *
+ * <dt><tt>RingSize</tt></dt>
+ * <dd>Capacity of the ring, in bytes. Suffixes "KB" and "MB" are
+ * recognized. Defaults to 1 MB; the minimum is 4 KB.</dd>
+ *
+ * <dt><tt>FullTimeout</tt></dt>
+ * <dd>Milliseconds to wait for room in full ring before the event is
+ * dropped. Defaults to 1000.</dd>
+ *
+ * <dt><tt>ServerName</tt></dt>
+ * <dd>Same as that of SocketAppender. The server also names the
+ * client by it in its statistics.</dd>
+ * </dl>
+ */
+class LOG4CPLUS_EXPORT ShmTransportAppender
+    : public Appender
+{
+public:
+    ShmTransportAppender (tstring const & socketPath,
+        std::size_t ringSize = 1024 * 1024);
+    ShmTransportAppender (helpers::Properties const & properties);
+    virtual ~ShmTransportAppender ();
+
+    virtual void close ();
+    virtual unsigned getRequiredEventFields () const;
+
+    //! \return <code>true</code> while the ring is registered with a
+    //! server.
+    bool isConnected () const;
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+
+    //! Creates the ring and registers it with the server.
+    bool connect ();
+    void disconnect ();
+
+    //! Copies length prefixed frames of <code>frames</code> into the
+    //! ring, each of them contiguous, and wakes the server when the
+    //! ring has been empty.
+    //! \return <code>false</code> when they do not fit.
+    bool writeFrames (std::string const & frames);
+
+    tstring socketPath;
+    tstring serverName;
+    std::size_t ringSize;
+    unsigned fullTimeout;
+
+    int connection;
+    int wakeupFd;
+    char * mapping;
+    std::size_t mappingSize;
+    std::chrono::steady_clock::time_point nextConnect;
+
+    helpers::SocketMessageEncoder encoder;
+    //! Encoded frames, reused between events.
+    std::string frames;
+    //! Set when a frame which might have defined dictionary entries
+    //! has been dropped; the whole dictionary precedes the next event.
+    bool resendDictionary;
+
+private:
+    void init ();
+
+    ShmTransportAppender (ShmTransportAppender const &);
+    ShmTransportAppender & operator = (ShmTransportAppender const &);
+};
+
+
+namespace helpers
+{
+
+/**
+ * Server side of ShmTransportAppender. Each instance serves one
+ * registered ring.
+ */
+class LOG4CPLUS_EXPORT ShmTransportReceiver
+{
+public:
+    //! Reads registration of ShmTransportAppender from
+    //! <code>connection</code>, accepted on socket opened by
+    //! openShmTransportListener(), maps the ring and confirms the
+    //! registration. Takes ownership of <code>connection</code>.
+    explicit ShmTransportReceiver (int connection);
+    ~ShmTransportReceiver ();
+
+    //! \return <code>false</code> when registration failed or the
+    //! ring has been found corrupted.
+    bool isOpen () const;
+
+    //! \return Connection with the client. It becomes readable when
+    //! the client closes it.
+    int getConnection () const;
+
+    //! \return Descriptor readable after the ring went from empty to
+    //! non-empty.
+    int getWakeupFd () const;
+
+    //! \return Name sent by the client.
+    std::string const & getIdent () const;
+
+    //! Decodes events of all records in the ring into
+    //! <code>events</code> and frees their space.
+    //! \return <code>false</code> when the ring is corrupted.
+    bool receive (std::vector<spi::InternalLoggingEvent> & events);
+
+private:
+    int connection;
+    int wakeupFd;
+    char * mapping;
+    std::size_t mappingSize;
+    std::size_t ringSize;
+    std::string ident;
+    SocketMessageDecoder decoder;
+
+    ShmTransportReceiver (ShmTransportReceiver const &);
+    ShmTransportReceiver & operator = (ShmTransportReceiver const &);
+};
+
+
+//! Opens non-blocking listening unix stream socket at
+//! <code>path</code> for ShmTransportAppender clients. Stale socket
+//! file is replaced.
+//! \return Socket descriptor, or -1.
+LOG4CPLUS_EXPORT int openShmTransportListener (tstring const & path);
+
+} // namespace helpers
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_HAVE_SYS_UN_H && __linux__
+
+#endif // LOG4CPLUS_SHM_TRANSPORT_APPENDER_HEADER_
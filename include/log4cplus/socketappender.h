@@ -32,14 +32,28 @@
 
 #include <log4cplus/appender.h>
 #include <log4cplus/helpers/socket.h>
+#include <log4cplus/helpers/tlscontext.h>
 #include <log4cplus/thread/syncprims.h>
 #include <log4cplus/thread/threads.h>
 #include <log4cplus/helpers/connectorthread.h>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
 
 
 namespace log4cplus
 {
 
+    namespace internal {
+
+        struct socket_compressor;
+        struct socket_decompressor;
+
+    } // namespace internal
+
 #ifndef UNICODE
     std::size_t const LOG4CPLUS_MAX_MESSAGE_SIZE = 8*1024;
 #else
@@ -47,6 +61,96 @@ namespace log4cplus
 #endif
 
 
+    namespace helpers {
+
+        /**
+         * Writes events in wire format 2. Names are entered into
+         * per connection dictionary on their first use and referred to
+         * by id afterwards.
+         */
+        class LOG4CPLUS_EXPORT SocketMessageEncoder
+        {
+        public:
+            SocketMessageEncoder();
+            ~SocketMessageEncoder();
+
+            //! Appends length prefixed message to <code>out</code>.
+            //! With <code>useDictionary</code> false, all strings are
+            //! sent inline and the message does not depend on earlier
+            //! messages.
+            void encode (std::string & out,
+                const log4cplus::spi::InternalLoggingEvent& event,
+                const log4cplus::tstring& serverName, bool useDictionary);
+
+            //! Appends message carrying zstd frame of
+            //! <code>frames</code>, length prefixed messages of either
+            //! wire format, compressed by <code>compressor</code>.
+            //! \return False if compression fails.
+            static bool encodeCompressed (std::string & out,
+                std::span<std::string_view const> frames,
+                internal::socket_compressor & compressor);
+
+            //! Appends message defining all dictionary entries. Sending
+            //! it first makes messages encoded so far decodable on a new
+            //! connection. Nothing is appended for empty dictionary.
+            void encodeDictionary (std::string & out) const;
+
+            //! Forgets all dictionary entries, e.g., when connection is
+            //! lost.
+            void reset ();
+
+        private:
+            void appendName (std::string & out,
+                const log4cplus::tstring& name, bool useDictionary);
+
+            std::map<log4cplus::tstring, std::size_t> ids;
+            std::vector<log4cplus::tstring const *> names;
+        };
+
+
+        /**
+         * Reads messages of both wire formats. One instance has to be
+         * used for all messages received over single connection.
+         */
+        class LOG4CPLUS_EXPORT SocketMessageDecoder
+        {
+        public:
+            SocketMessageDecoder();
+            ~SocketMessageDecoder();
+
+            //! \return False for messages that do not carry an event
+            //! or that cannot be decoded.
+            bool decode (SocketBuffer & buffer,
+                log4cplus::spi::InternalLoggingEvent & event);
+
+            //! Decodes message of <code>size</code> bytes at
+            //! <code>data</code>, without the length prefix. Messages
+            //! of wire format 2 are decoded in place.
+            bool decode (char const * data, std::size_t size,
+                log4cplus::spi::InternalLoggingEvent & event);
+
+            //! Appends all events carried by the message to
+            //! <code>events</code>; compressed batch carries several.
+            //! \return Number of appended events.
+            std::size_t decode (char const * data, std::size_t size,
+                std::vector<log4cplus::spi::InternalLoggingEvent> & events);
+
+            //! Sets zstd dictionary compressed batches have been
+            //! compressed with, see <tt>CompressionDictionary</tt>.
+            void setCompressionDictionary (std::string const & dictionary);
+
+        private:
+            bool decompress (char const * data, std::size_t size,
+                std::string & out);
+
+            std::vector<log4cplus::tstring> names;
+            std::shared_ptr<internal::socket_decompressor> decompressor;
+            std::string compressionDictionary;
+        };
+
+    } // end namespace helpers
+
+
     /**
      * Sends {@link spi::InternalLoggingEvent} objects to a remote a log server.
      *
@@ -66,10 +170,12 @@ namespace log4cplus
      *   at the server.
      *
      *   <li>If the remote server is down, the logging requests are
-     *   simply dropped. However, if and when the server comes back up,
-     *   then event transmission is resumed transparently. This
-     *   transparent reconneciton is performed by a <em>connector</em>
-     *   thread which periodically attempts to connect to the server.
+     *   simply dropped, unless spooling is enabled, see
+     *   <tt>SpoolSize</tt> and <tt>SpoolFile</tt> below. However, if
+     *   and when the server comes back up, then event transmission is
+     *   resumed transparently. This transparent reconneciton is
+     *   performed by a <em>connector</em> thread which periodically
+     *   attempts to connect to the server.
      *
      *   <li>Logging events are automatically <em>buffered</em> by the
      *   native TCP implementation. This means that if the link to server
@@ -88,7 +194,12 @@ namespace log4cplus
      * <h3>Properties</h3>
      * <dl>
      * <dt><tt>host</tt></dt>
-     * <dd>Remote host name to connect and send events to.</dd>
+     * <dd>Remote host name to connect and send events to. Name of form
+     * <code>unix:///path</code> connects local (<code>AF_UNIX</code>)
+     * stream socket at <code>/path</code> instead, e.g., of a collector
+     * on the same host; on Linux, <code>unix://\@name</code> names
+     * socket in abstract namespace. Buffering, batching and
+     * reconnection work the same.</dd>
      *
      * <dt><tt>port</tt></dt>
      * <dd>Port on remote host to send events to.</dd>
@@ -100,6 +211,152 @@ namespace log4cplus
      * <dd>Boolean value specifying whether to use IPv6 (true) or IPv4
      * (false). Default value is false.</dd>
      *
+     * <dt><tt>AsyncConnect</tt></dt>
+     * <dd>When true, the appender does not connect in its constructor;
+     * the connector thread makes the first connection. Events appended
+     * until its first attempt finishes are spooled, up to 1 MB or
+     * <tt>SpoolSize</tt> if it is larger, and are sent once it
+     * succeeds. Single threaded builds connect when the first event is
+     * sent. When false, the constructor connects and blocks until it
+     * succeeds or fails. Default value is true.</dd>
+     *
+     * <dt><tt>ReconnectDelayMs</tt>, <tt>ReconnectMaxDelayMs</tt></dt>
+     * <dd>Pause after failed connection attempt, in milliseconds. It
+     * starts at <tt>ReconnectDelayMs</tt> and doubles with each
+     * following failure up to <tt>ReconnectMaxDelayMs</tt>; each pause
+     * is randomly shortened by up to a half. Appenders connecting to
+     * the same host and port share the pause, so they do not all retry
+     * at once when the server comes back. Default values are 5000 and
+     * 60000.</dd>
+     *
+     * <dt><tt>TcpNoDelay</tt></dt>
+     * <dd>Boolean value specifying whether Nagle's algorithm is
+     * disabled. Default value is true; batching properties below
+     * already coalesce small writes.</dd>
+     *
+     * <dt><tt>SendBufferSize</tt></dt>
+     * <dd>Size of socket send buffer, in bytes. Default value is 0, the
+     * system default.</dd>
+     *
+     * <dt><tt>KeepAlive</tt></dt>
+     * <dd>Boolean value specifying whether TCP keep-alive probes are
+     * sent on idle connection, so that a dead server is noticed.
+     * Default value is false.</dd>
+     *
+     * <dt><tt>KeepAliveIdle</tt>, <tt>KeepAliveInterval</tt>,
+     * <tt>KeepAliveCount</tt></dt>
+     * <dd>Seconds of idle connection before the first probe, seconds
+     * between probes, and number of unanswered probes after which the
+     * connection is dropped, where the system supports them. Default
+     * values are 0, the system defaults.</dd>
+     *
+     * <dt><tt>DnsCacheTtlMs</tt></dt>
+     * <dd>Milliseconds for which addresses of the server are reused by
+     * reconnections instead of resolving its name again. Default value
+     * is 0, the name is resolved for each connection.</dd>
+     *
+     * <dt><tt>Endpoints</tt></dt>
+     * <dd>Comma separated list of <tt>host:port</tt> servers to use
+     * instead of <tt>host</tt> and <tt>port</tt>; <tt>port</tt> is used
+     * for entries without one. Entries may name local sockets like
+     * <tt>host</tt>. One connection is kept to each of them,
+     * each batch of events is sent over one of the connected ones and
+     * when the write fails, it is sent over the next one. Events are
+     * spooled only when none is connected; events written when a
+     * connection fails may reach both servers. Wire format 2 names are
+     * not entered into dictionary in this mode, any event can go to
+     * any server. Each server gets its own TLS session, its name is
+     * used unless <tt>TlsServerName</tt> is set.</dd>
+     *
+     * <dt><tt>LoadBalancing</tt></dt>
+     * <dd>Either <tt>RoundRobin</tt> (default), rotating connections
+     * for each batch, or <tt>LeastOutstanding</tt>, choosing the one
+     * with the least bytes not yet acknowledged by its server, where
+     * the system reports it.</dd>
+     *
+     * <dt><tt>BatchSize</tt></dt>
+     * <dd>Events are collected and sent with single write once this
+     * many bytes of them have accumulated. Default value is 0; events
+     * are sent one by one unless any of the batching properties is
+     * set.</dd>
+     *
+     * <dt><tt>BatchEvents</tt></dt>
+     * <dd>Collected events are sent once there are this many of them.
+     * Default value is 0, no limit.</dd>
+     *
+     * <dt><tt>BatchIntervalMs</tt></dt>
+     * <dd>Collected events are sent at least this often, in
+     * milliseconds. Default value is 0, no timer. Without timer
+     * collected events wait for the next event or for appender's
+     * closing.</dd>
+     *
+     * <dt><tt>SpoolSize</tt></dt>
+     * <dd>While the server is unreachable, up to this many bytes of
+     * events are kept in memory and are sent, in order, once the
+     * connection is re-established. When the spool is full, the oldest
+     * events are dropped. Default value is 0, events are dropped while
+     * disconnected.</dd>
+     *
+     * <dt><tt>SpoolFile</tt></dt>
+     * <dd>When the in-memory spool is full, its contents are moved to
+     * this file instead of dropping them. The file is replayed before
+     * the in-memory spool, it also keeps events spooled at appender's
+     * closing for the next run. Events being replayed when the
+     * connection fails again may be sent twice.</dd>
+     *
+     * <dt><tt>WireFormat</tt></dt>
+     * <dd>Either 1 (default) or 2. Format 2 uses variable length
+     * integers, sends logger, thread, file, function and MDC key names
+     * once per connection and then refers to them by id. It also
+     * carries MDC and it has no limit on message size. Servers tell
+     * the formats apart by the version byte of each message, see
+     * helpers::SocketMessageDecoder.</dd>
+     *
+     * <dt><tt>Compression</tt></dt>
+     * <dd>Either <tt>none</tt> (default) or <tt>zstd</tt>. Each batch
+     * written to the server is compressed as one zstd frame, in the
+     * thread that writes it. The server recognizes compressed batches
+     * by their message type; servers built without zstd drop them.
+     * Spooled events are kept uncompressed and are compressed when
+     * they are sent.</dd>
+     *
+     * <dt><tt>CompressionLevel</tt></dt>
+     * <dd>zstd compression level. Default value is 1.</dd>
+     *
+     * <dt><tt>CompressionDictionary</tt></dt>
+     * <dd>File with zstd dictionary, e.g., trained by <tt>zstd
+     * --train</tt> on typical messages. The server has to be given the
+     * same dictionary.</dd>
+     *
+     * <dt><tt>Tls</tt></dt>
+     * <dd>Boolean value specifying whether the connection is
+     * encrypted with TLS, see helpers::createTlsContext(). Reconnects
+     * resume the previous TLS session when the server allows it.
+     * Default value is false.</dd>
+     *
+     * <dt><tt>TlsCAFile</tt></dt>
+     * <dd>PEM file with CA certificates the server certificate is
+     * verified against. System trust store is used by default.</dd>
+     *
+     * <dt><tt>TlsCertFile</tt>, <tt>TlsKeyFile</tt></dt>
+     * <dd>PEM files with client certificate and its private key, for
+     * servers requiring client authentication.</dd>
+     *
+     * <dt><tt>TlsServerName</tt></dt>
+     * <dd>Name expected in server certificate and sent in SNI.
+     * Default value is <tt>host</tt>.</dd>
+     *
+     * <dt><tt>TlsVerifyPeer</tt></dt>
+     * <dd>Boolean value specifying whether server certificate is
+     * verified. Default value is true.</dd>
+     *
+     * <dt><tt>TlsKernelOffload</tt></dt>
+     * <dd>Boolean value specifying whether to let the kernel encrypt
+     * sent data (Linux kTLS) where the TLS backend and the kernel
+     * support it. Writes then stay plain gather writes without copying
+     * events into TLS records in user space. Default value is
+     * false.</dd>
+     *
      * </dl>
      */
     class LOG4CPLUS_EXPORT SocketAppender
@@ -121,10 +378,49 @@ namespace log4cplus
       // Methods
         virtual void close();
 
+        //! Events are sent whole, all fields are required.
+        virtual unsigned getRequiredEventFields() const;
+
     protected:
         void openSocket();
         void initConnector ();
         virtual void append(const spi::InternalLoggingEvent& event);
+        virtual void appendBatch(
+            std::span<spi::InternalLoggingEvent const> events);
+
+        //! Checks connection state and triggers reconnection.
+        //! \return True if the connection is usable.
+        bool ensureConnected();
+
+        //! Appends length prefixed <code>event</code> to sendBuffer.
+        //! \return False if the event cannot be serialized.
+        bool appendFrame(const spi::InternalLoggingEvent& event);
+
+        //! \return True if sendBuffer should be sent now.
+        bool batchFull() const;
+
+        //! Sends spooled events and sendBuffer. Events that cannot be
+        //! sent are spooled.
+        void flushBatch();
+
+        //! Sends <code>frames</code>, marks the connection broken on
+        //! failure.
+        bool writeFrames(const std::string& frames);
+        bool writeFrames(std::span<std::string_view const> frames);
+
+        //! Sends spool file and in-memory spool.
+        //! \return True if the spool has been emptied.
+        bool replaySpool();
+
+        //! Keeps <code>frames</code> until the connection is back.
+        void spoolFrames(std::string && frames);
+
+        //! Moves in-memory spool to the spool file.
+        bool spillSpool();
+
+        //! \return <code>true</code> if events are kept while
+        //! disconnected.
+        bool spooling() const;
 
       // Data
         log4cplus::helpers::Socket socket;
@@ -132,6 +428,87 @@ namespace log4cplus
         unsigned int port;
         log4cplus::tstring serverName;
         bool ipv6 = false;
+        helpers::SocketOptions socketOptions;
+        unsigned int reconnectDelay = 5 * 1000;
+        unsigned int reconnectMaxDelay = 60 * 1000;
+
+        //! Length prefixed events waiting to be sent.
+        std::string sendBuffer;
+        std::size_t sendBufferEvents = 0;
+        unsigned long batchSize = 0;
+        unsigned long batchEvents = 0;
+        unsigned long batchInterval = 0;
+
+        //! Batches of events kept while disconnected, oldest first.
+        std::deque<std::string> spool;
+        std::size_t spoolBytes = 0;
+        unsigned long spoolSize = 0;
+        log4cplus::tstring spoolFile;
+        bool spoolFileUsed = false;
+        //! Bytes of events dropped since the last replay.
+        std::size_t spoolDropped = 0;
+
+        unsigned int wireFormat = 1;
+        helpers::SocketMessageEncoder encoder;
+
+        //! Set when batches are compressed, see <tt>Compression</tt>.
+        std::shared_ptr<internal::socket_compressor> compressor;
+        //! Compressed message being written.
+        std::string compressedFrames;
+
+        //! Set when the connection is encrypted, see <tt>Tls</tt>.
+        bool useTls = false;
+        std::unique_ptr<helpers::TlsContext> tlsContext;
+
+        //! Connects new socket, including TLS handshake.
+        helpers::Socket connectServer();
+        helpers::Socket connectServer(tstring const & serverHost,
+            unsigned int serverPort, helpers::TlsContext * context);
+
+        //! One of the servers given by <tt>Endpoints</tt>, with its own
+        //! connection and reconnection thread.
+        struct Endpoint
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+            : public virtual helpers::IConnectorThreadClient
+#endif
+        {
+            Endpoint (SocketAppender & owner_, tstring const & host_,
+                unsigned int port_);
+
+            SocketAppender & owner;
+            tstring host;
+            unsigned int port;
+            helpers::Socket socket;
+            std::unique_ptr<helpers::TlsContext> tlsContext;
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+            virtual thread::Mutex const & ctcGetAccessMutex () const;
+            virtual helpers::Socket & ctcGetSocket ();
+            virtual helpers::Socket ctcConnect ();
+            virtual void ctcSetConnected ();
+
+            volatile bool connected = true;
+            helpers::SharedObjectPtr<helpers::ConnectorThread> connector;
+
+            //! Set until the first connection attempt of
+            //! <tt>AsyncConnect</tt> finishes.
+            bool connectPending = false;
+#endif
+        };
+
+        //! \return True if <code>endpoint</code> can be written to.
+        bool isUsable (Endpoint const & endpoint) const;
+
+        //! \return Usable endpoint for the next batch, or null.
+        Endpoint * selectEndpoint ();
+
+        //! Marks <code>endpoint</code> broken and starts reconnecting.
+        void endpointFailed (Endpoint & endpoint);
+
+        //! Empty unless <tt>Endpoints</tt> is set.
+        std::vector<std::unique_ptr<Endpoint>> endpoints;
+        std::size_t nextEndpoint = 0;
+        bool leastOutstanding = false;
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
         virtual thread::Mutex const & ctcGetAccessMutex () const;
@@ -141,9 +518,29 @@ namespace log4cplus
 
         volatile bool connected;
         helpers::SharedObjectPtr<helpers::ConnectorThread> connector;
+        bool batchTimerRegistered = false;
+
+        //! Set until the first connection attempt of
+        //! <tt>AsyncConnect</tt> finishes.
+        bool connectPending = false;
+
+        //! Count of connections whose first attempt has not finished
+        //! yet, see <tt>AsyncConnect</tt>.
+        std::atomic<std::size_t> pendingConnects {0};
+
+        //! Marks first connection attempt finished.
+        void connectFinished (bool & pending);
 #endif
 
+        //! Connect in the background, see <tt>AsyncConnect</tt>.
+        bool asyncConnect = true;
+
     private:
+        LOG4CPLUS_PRIVATE void initBatching ();
+        LOG4CPLUS_PRIVATE void initTls (helpers::Properties const &);
+        LOG4CPLUS_PRIVATE void initCompression (helpers::Properties const &);
+        LOG4CPLUS_PRIVATE void initEndpoints (helpers::Properties const &);
+
       // Disallow copying of instances of this class
         SocketAppender(const SocketAppender&);
         SocketAppender& operator=(const SocketAppender&);
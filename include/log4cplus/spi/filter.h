@@ -31,10 +31,16 @@
 #pragma once
 #endif
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <vector>
 
 #include <log4cplus/helpers/pointer.h>
 #include <log4cplus/loglevel.h>
+#include <log4cplus/mdc.h>
+#include <log4cplus/thread/syncprims.h>
 
 
 namespace log4cplus {
@@ -74,6 +80,27 @@ namespace log4cplus {
         LOG4CPLUS_EXPORT FilterResult checkFilter(const Filter* filter,
                                                   const InternalLoggingEvent& event);
 
+        /**
+         * Returns combination of EventFields read by filters of the chain
+         * starting at <code>filter</code>.
+         *
+         * Note: <code>filter</code> can be NULL.
+         */
+        LOG4CPLUS_EXPORT unsigned getRequiredEventFields(const Filter* filter);
+
+        /**
+         * Like checkFilter() but uses Filter::preDecide() so the event
+         * does not have to exist. It never returns <code>DENY</code> for
+         * events that checkFilter() would accept. <code>contextual</code>
+         * is set to <code>true</code> when the result depends on NDC or
+         * MDC of the calling thread.
+         *
+         * Note: <code>filter</code> can be NULL.
+         */
+        LOG4CPLUS_EXPORT FilterResult preCheckFilter(const Filter* filter,
+            LogLevel ll, const log4cplus::tstring& loggerName,
+            bool& contextual);
+
         typedef helpers::SharedObjectPtr<Filter> FilterPtr;
 
 
@@ -130,6 +157,37 @@ namespace log4cplus {
              */
             virtual FilterResult decide(const InternalLoggingEvent& event) const = 0;
 
+            /**
+             * Returns combination of EventFields that decide() reads. The
+             * default implementation returns EVENT_FIELDS_ALL.
+             */
+            virtual unsigned getRequiredEventFields() const;
+
+            /**
+             * Returns the decision decide() makes for every event of log
+             * level <code>ll</code> from logger <code>loggerName</code>
+             * logged by the calling thread with its current NDC and MDC.
+             * Loggers use it to skip building events that no appender
+             * would append. Returns <code>ACCEPT</code> when the decision
+             * needs other parts of the event. This is also the default
+             * implementation. Sets <code>contextual</code> to
+             * <code>true</code> when the decision reads NDC or MDC so that
+             * it is not cached. Appenders call it without their lock,
+             * concurrently with decide().
+             */
+            virtual FilterResult preDecide(LogLevel ll,
+                const log4cplus::tstring& loggerName, bool& contextual) const;
+
+            /**
+             * Called by appenders for each <code>event</code> that passed
+             * the whole filter chain, before it is appended. Returns an
+             * event to append ahead of it, or null. Filters that deny
+             * events use it to report them, e.g., "Last message repeated
+             * 10 times." The default implementation returns null.
+             */
+            virtual std::unique_ptr<InternalLoggingEvent> takeSummary(
+                const InternalLoggingEvent& event) const;
+
           // Data
             /**
              * Points to the next filter in the filter chain.
@@ -138,6 +196,59 @@ namespace log4cplus {
         };
 
 
+        /**
+         * Filter chain compiled into an array of operations, checked in
+         * one loop. Built-in filters with known decisions, i.e.,
+         * DenyAllFilter, LogLevelMatchFilter, LogLevelRangeFilter,
+         * StringMatchFilter, MultiStringMatchFilter, NDCMatchFilter and
+         * MDCMatchFilter, are decided without virtual calls; other
+         * filters, including subclasses of the built-in ones, through
+         * Filter::decide().
+         *
+         * The program refers to the filters of the chain, so the chain
+         * has to outlive it. Filters appended to the chain after it was
+         * compiled are checked by checkFilter().
+         */
+        class LOG4CPLUS_EXPORT FilterProgram
+        {
+        public:
+            FilterProgram();
+            explicit FilterProgram(const Filter* chain);
+
+            /**
+             * Returns the same result as
+             * <code>checkFilter(getChain(), event)</code>.
+             */
+            FilterResult check(const InternalLoggingEvent& event) const;
+
+            //! Returns the first filter of the compiled chain.
+            const Filter* getChain() const { return chain; }
+
+        private:
+            enum OpCode : unsigned char
+            {
+                OP_DECIDE,
+                OP_DENY_ALL,
+                OP_LOG_LEVEL_MATCH,
+                OP_LOG_LEVEL_RANGE,
+                OP_STRING_MATCH,
+                OP_MULTI_STRING_MATCH,
+                OP_NDC_MATCH,
+                OP_MDC_MATCH
+            };
+
+            struct Op
+            {
+                OpCode code;
+                const Filter* filter;
+            };
+
+            std::vector<Op> ops;
+            const Filter* chain;
+            const Filter* last;
+        };
+
+
 
         /**
          * This filter drops all logging events.
@@ -157,6 +268,9 @@ namespace log4cplus {
              * {@link InternalLoggingEvent} parameter.
              */
             virtual FilterResult decide(const InternalLoggingEvent& event) const;
+            virtual unsigned getRequiredEventFields() const;
+            virtual FilterResult preDecide(LogLevel ll,
+                const log4cplus::tstring& loggerName, bool& contextual) const;
         };
 
 
@@ -187,10 +301,14 @@ namespace log4cplus {
              * property is set to <code>false</code>.
              */
             virtual FilterResult decide(const InternalLoggingEvent& event) const;
+            virtual unsigned getRequiredEventFields() const;
+            virtual FilterResult preDecide(LogLevel ll,
+                const log4cplus::tstring& loggerName, bool& contextual) const;
 
         private:
           // Methods
             LOG4CPLUS_PRIVATE void init();
+            LOG4CPLUS_PRIVATE FilterResult decideLogLevel(LogLevel ll) const;
 
           // Data
             /** Do we return ACCEPT when a match occurs. Default is <code>true</code>. */
@@ -235,10 +353,14 @@ namespace log4cplus {
              * Return the decision of this filter.
              */
             virtual FilterResult decide(const InternalLoggingEvent& event) const;
+            virtual unsigned getRequiredEventFields() const;
+            virtual FilterResult preDecide(LogLevel ll,
+                const log4cplus::tstring& loggerName, bool& contextual) const;
 
         private:
           // Methods
             LOG4CPLUS_PRIVATE void init();
+            LOG4CPLUS_PRIVATE FilterResult decideLogLevel(LogLevel ll) const;
 
           // Data
             /** Do we return ACCEPT when a match occurs. Default is <code>true</code>. */
@@ -270,6 +392,9 @@ namespace log4cplus {
              * Returns {@link #NEUTRAL} is there is no string match.
              */
             virtual FilterResult decide(const InternalLoggingEvent& event) const;
+            virtual unsigned getRequiredEventFields() const;
+            virtual FilterResult preDecide(LogLevel ll,
+                const log4cplus::tstring& loggerName, bool& contextual) const;
 
         private:
           // Methods
@@ -281,6 +406,53 @@ namespace log4cplus {
             log4cplus::tstring stringToMatch;
         };
 
+
+        /**
+         * This filter is like StringMatchFilter with any number of
+         * strings to match.
+         *
+         * The filter admits options <b>StringsToMatch</b>, a list of
+         * strings separated by the first character of <b>Separator</b>
+         * (<code>,</code> by default), and <b>AcceptOnMatch</b>. The
+         * strings are compiled into one Aho-Corasick automaton, so each
+         * message is scanned once however many strings there are. If any
+         * of the strings occurs in the message, then the {@link #decide}
+         * method returns {@link #ACCEPT} if the <b>AcceptOnMatch</b> option
+         * value is true, if it is false then {@link #DENY} is returned. If
+         * there is no match, {@link #NEUTRAL} is returned.
+         */
+        class LOG4CPLUS_EXPORT MultiStringMatchFilter : public Filter {
+        public:
+          // ctors
+            MultiStringMatchFilter();
+            MultiStringMatchFilter(const log4cplus::helpers::Properties& p);
+            MultiStringMatchFilter(
+                const std::vector<log4cplus::tstring>& stringsToMatch,
+                bool acceptOnMatch = true);
+            virtual ~MultiStringMatchFilter();
+
+            /**
+             * Returns {@link #NEUTRAL} is there is no string match.
+             */
+            virtual FilterResult decide(const InternalLoggingEvent& event) const;
+            virtual unsigned getRequiredEventFields() const;
+            virtual FilterResult preDecide(LogLevel ll,
+                const log4cplus::tstring& loggerName, bool& contextual) const;
+
+        private:
+            struct Automaton;
+
+          // Methods
+            LOG4CPLUS_PRIVATE void compile(
+                const std::vector<log4cplus::tstring>& stringsToMatch);
+
+          // Data
+            /** Do we return ACCEPT when a match occurs. Default is <code>true</code>. */
+            bool acceptOnMatch;
+            /** Null when there is no non-empty string to match. */
+            std::unique_ptr<Automaton const> automaton;
+        };
+
         /**
          * This filter allows using `std::function<FilterResult(const
          * InternalLoggingEvent &)>`.
@@ -336,10 +508,16 @@ namespace log4cplus {
                  * Returns {@link #NEUTRAL} is there is no string match.
                  */
                 virtual FilterResult decide(const InternalLoggingEvent& event) const;
+                virtual unsigned getRequiredEventFields() const;
+                virtual FilterResult preDecide(LogLevel ll,
+                    const log4cplus::tstring& loggerName,
+                    bool& contextual) const;
 
             private:
               // Methods
                 LOG4CPLUS_PRIVATE void init();
+                LOG4CPLUS_PRIVATE FilterResult decideNDC(
+                    const log4cplus::tstring& ndcStr) const;
 
               // Data
                 /** Do we return ACCEPT when a match occurs. Default is <code>true</code>. */
@@ -382,10 +560,16 @@ namespace log4cplus {
                  * Returns {@link #NEUTRAL} is there is no string match.
                  */
                 virtual FilterResult decide(const InternalLoggingEvent& event) const;
+                virtual unsigned getRequiredEventFields() const;
+                virtual FilterResult preDecide(LogLevel ll,
+                    const log4cplus::tstring& loggerName,
+                    bool& contextual) const;
 
             private:
               // Methods
                 LOG4CPLUS_PRIVATE void init();
+                LOG4CPLUS_PRIVATE FilterResult decideMDC(
+                    const log4cplus::tstring& mdcStr) const;
 
               // Data
                 /** Do we return ACCEPT when a match occurs. Default is <code>true</code>. */
@@ -394,10 +578,169 @@ namespace log4cplus {
                 bool neutralOnEmpty;
                 /** The MDC key to retrieve **/
                 log4cplus::tstring mdcKeyToMatch;
+                /** Registered mdcKeyToMatch **/
+                MDCKey mdcKeyHandle {};
                 /** the MDC value to match **/
                 log4cplus::tstring mdcValueToMatch;
         };
 
+
+        /**
+         * This filter limits the rate of events with a token bucket per
+         * call site or per logger.
+         *
+         * The filter admits options <b>Rate</b>, <b>Burst</b>,
+         * <b>PerCallSite</b> and <b>Buckets</b>. Events of one call site
+         * (<code>file:line</code> of the event) or, if
+         * <b>PerCallSite</b> is <code>false</code>, of one logger share a
+         * bucket which refills at <b>Rate</b> events per second and holds
+         * at most <b>Burst</b> events, <b>Rate</b> by default. {@link
+         * #DENY} is returned for events exceeding the rate, otherwise
+         * {@link #NEUTRAL}. If <b>Rate</b> is 0, the default, every event
+         * is passed. The rate is measured by event timestamps.
+         *
+         * Keys are hashed into a table of <b>Buckets</b> buckets, 256 by
+         * default, rounded up to a power of two; keys colliding in a
+         * bucket share its rate. Buckets are updated with atomic
+         * compare-and-swap, without locking. The number of denied events
+         * is reported before the next passed event.
+         */
+        class LOG4CPLUS_EXPORT RateLimitFilter : public Filter
+        {
+        public:
+          // ctors
+            RateLimitFilter();
+            RateLimitFilter(const log4cplus::helpers::Properties& p);
+            RateLimitFilter(unsigned rate, unsigned burst,
+                bool perCallSite = true, unsigned buckets = 256);
+            virtual ~RateLimitFilter();
+
+            /**
+             * Returns {@link #DENY} if the bucket of the event is empty.
+             */
+            virtual FilterResult decide(const InternalLoggingEvent& event) const;
+            virtual unsigned getRequiredEventFields() const;
+            virtual std::unique_ptr<InternalLoggingEvent> takeSummary(
+                const InternalLoggingEvent& event) const;
+
+        private:
+          // Methods
+            LOG4CPLUS_PRIVATE void init(unsigned rate, unsigned burst,
+                unsigned buckets);
+
+          // Data
+            bool perCallSite;
+            //! Nanoseconds to refill one event, 0 if there is no limit.
+            std::int64_t interval;
+            //! Nanoseconds to refill the whole bucket.
+            std::int64_t tolerance;
+            std::size_t bucketMask;
+            //! Theoretical arrival time of the next event in each bucket,
+            //! in nanoseconds since the epoch (GCRA form of token bucket).
+            std::unique_ptr<std::atomic<std::int64_t>[]> buckets;
+            //! Events denied since the last summary.
+            mutable std::atomic<std::size_t> denied;
+        };
+
+
+        /**
+         * This filter collapses identical consecutive events.
+         *
+         * Events with the same logger, LogLevel and message as the event
+         * appended last get {@link #DENY}, other events get {@link
+         * #NEUTRAL}. Before the next different event a "Last message
+         * repeated N times." event is appended. The filter keeps hashes
+         * of events only and checks for a repetition without locking.
+         */
+        class LOG4CPLUS_EXPORT DuplicateSuppressionFilter : public Filter
+        {
+        public:
+          // ctors
+            DuplicateSuppressionFilter();
+            DuplicateSuppressionFilter(const log4cplus::helpers::Properties& p);
+            virtual ~DuplicateSuppressionFilter();
+
+            /**
+             * Returns {@link #DENY} if the event repeats the last one.
+             */
+            virtual FilterResult decide(const InternalLoggingEvent& event) const;
+            virtual unsigned getRequiredEventFields() const;
+            virtual std::unique_ptr<InternalLoggingEvent> takeSummary(
+                const InternalLoggingEvent& event) const;
+
+        private:
+          // Data
+            //! Hash of the event appended last, 0 before the first one.
+            mutable std::atomic<std::size_t> lastHash;
+            //! Repetitions denied since the last different event.
+            mutable std::atomic<std::size_t> repeated;
+            //! Guards logger name and LogLevel of the repeated event,
+            //! written when repetition starts.
+            mutable thread::Mutex summaryMutex;
+            mutable log4cplus::tstring summaryLogger;
+            mutable LogLevel summaryLogLevel;
+        };
+
+
+        /**
+         * This filter samples events by the value of an MDC key, e.g., a
+         * trace id, so that either all or none of the events of a request
+         * are logged.
+         *
+         * The filter admits options <b>MDCKey</b>, <b>Ratio</b>,
+         * <b>AcceptOnMatch</b> and <b>NeutralOnEmpty</b>. The value of
+         * MDCKey is hashed with a fast non-cryptographic hash; a
+         * <b>Ratio</b> fraction of the values, 1 by default, is sampled.
+         * Events of values not sampled get {@link #DENY}. Events of
+         * sampled values get {@link #ACCEPT} if <b>AcceptOnMatch</b> is
+         * true and {@link #NEUTRAL} if it is false, the default.
+         *
+         * If <code>NeutralOnEmpty</code> is true, the default, and the
+         * value of MDCKey is empty, then {@link #NEUTRAL} is returned;
+         * otherwise the empty value is sampled as any other.
+         *
+         * The decision depends only on the MDC of the logging thread, so
+         * loggers make it before creating the event and unsampled events
+         * are not formatted.
+         */
+        class LOG4CPLUS_EXPORT SamplingFilter : public Filter
+        {
+        public:
+          // ctors
+            SamplingFilter();
+            SamplingFilter(const log4cplus::helpers::Properties& p);
+            SamplingFilter(const log4cplus::tstring& mdcKey, double ratio,
+                bool acceptOnMatch = false);
+
+            /**
+             * Returns {@link #DENY} if the value of MDCKey is not sampled.
+             */
+            virtual FilterResult decide(const InternalLoggingEvent& event) const;
+            virtual unsigned getRequiredEventFields() const;
+            virtual FilterResult preDecide(LogLevel ll,
+                const log4cplus::tstring& loggerName,
+                bool& contextual) const;
+
+        private:
+          // Methods
+            LOG4CPLUS_PRIVATE void init(const log4cplus::tstring& mdcKey,
+                double ratio);
+            LOG4CPLUS_PRIVATE FilterResult decideValue(
+                const log4cplus::tstring* value) const;
+
+          // Data
+            /** Do we return ACCEPT when a value is sampled. Default is <code>false</code>. */
+            bool acceptOnMatch;
+            /** Return NEUTRAL if the value is empty. Default is <code>true</code>. */
+            bool neutralOnEmpty;
+            /** Values hashing below it are sampled. */
+            std::uint64_t threshold;
+            /** Sample all values, for ratio of 1. */
+            bool sampleAll;
+            log4cplus::tstring mdcKey;
+            MDCKey mdcKeyHandle {};
+        };
+
     } // end namespace spi
 } // end namespace log4cplus
 
@@ -0,0 +1,188 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    keyvalues.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file
+ * Typed key/value fields of logging events. They are attached by the
+ * <code>LOG4CPLUS_*_KV</code> macros and kept in their binary form;
+ * numbers are turned into text only by layouts that print them. */
+
+#ifndef LOG4CPLUS_SPI_KEY_VALUES_HEADER_
+#define LOG4CPLUS_SPI_KEY_VALUES_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/tstring.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+
+namespace log4cplus {
+    namespace spi {
+
+        //! Types of key/value field values.
+        enum KeyValueType : unsigned char
+        {
+            KV_BOOL,
+            KV_INT,
+            KV_UINT,
+            KV_DOUBLE,
+            KV_STRING
+        };
+
+
+        /**
+         * View of one key/value field. The key and string value refer
+         * to storage of KeyValues and stay valid until it is modified.
+         */
+        struct KeyValue
+        {
+            tstring_view key;
+            KeyValueType type = KV_BOOL;
+            union
+            {
+                bool b;
+                std::int64_t i;
+                std::uint64_t u;
+                double d;
+            };
+            tstring_view str;
+
+            KeyValue () : u (0) { }
+        };
+
+
+        /**
+         * Ordered list of typed key/value fields of a logging event.
+         * Keys and string values are copied into single buffer so that
+         * instances reused by the logging macros do not allocate once
+         * they have grown to their working size.
+         */
+        class LOG4CPLUS_EXPORT KeyValues
+        {
+        public:
+            KeyValues ();
+            KeyValues (KeyValues const &);
+            KeyValues (KeyValues &&) noexcept;
+            ~KeyValues ();
+
+            KeyValues & operator = (KeyValues const &);
+            KeyValues & operator = (KeyValues &&) noexcept;
+
+            //! Removes all fields; the storage is kept.
+            void clear ();
+
+            bool empty () const { return entries.empty (); }
+            std::size_t size () const { return entries.size (); }
+
+            KeyValue operator [] (std::size_t i) const;
+
+            //! Finds first field named <code>key</code>.
+            //! \return <code>false</code> when there is none.
+            bool find (tstring_view const & key, KeyValue & kv) const;
+
+            //! Adds field. Supported are integral, enumeration and
+            //! floating point types and whatever converts to
+            //! tstring_view.
+            template <typename T>
+            void add (tstring_view const & key, T const & value);
+
+            void addBool (tstring_view const & key, bool value);
+            void addInt (tstring_view const & key, std::int64_t value);
+            void addUInt (tstring_view const & key, std::uint64_t value);
+            void addDouble (tstring_view const & key, double value);
+            void addString (tstring_view const & key,
+                tstring_view const & value);
+
+            void swap (KeyValues &) noexcept;
+
+            //! Appends text form of value of <code>kv</code>. Doubles
+            //! are printed in the shortest form that reads back the
+            //! same value.
+            static void appendValue (tstring & output, KeyValue const & kv);
+
+        private:
+            struct Entry
+            {
+                std::size_t keyPos;
+                std::size_t keyLen;
+                std::size_t strPos;
+                std::size_t strLen;
+                KeyValueType type;
+                union
+                {
+                    bool b;
+                    std::int64_t i;
+                    std::uint64_t u;
+                    double d;
+                };
+            };
+
+            LOG4CPLUS_PRIVATE Entry & addEntry (tstring_view const & key,
+                KeyValueType type);
+
+            std::vector<Entry> entries;
+            //! Keys and string values of all entries.
+            tstring chars;
+        };
+
+
+        template <typename T>
+        void
+        KeyValues::add (tstring_view const & key, T const & value)
+        {
+            if constexpr (std::is_same_v<T, bool>)
+                addBool (key, value);
+            else if constexpr (std::is_same_v<T, tchar>)
+                addString (key, tstring_view (&value, 1));
+            else if constexpr (std::is_enum_v<T>)
+                add (key, static_cast<std::underlying_type_t<T>> (value));
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+                addInt (key, value);
+            else if constexpr (std::is_integral_v<T>)
+                addUInt (key, value);
+            else if constexpr (std::is_floating_point_v<T>)
+                addDouble (key, static_cast<double> (value));
+            else if constexpr (std::is_convertible_v<T const &, tstring_view>)
+                addString (key, tstring_view (value));
+            else
+                static_assert (sizeof (T) == 0,
+                    "unsupported key/value field type");
+        }
+
+    } // end namespace spi
+} // end namespace log4cplus
+
+#endif // LOG4CPLUS_SPI_KEY_VALUES_HEADER_
@@ -34,22 +34,32 @@
 #include <log4cplus/helpers/appenderattachableimpl.h>
 #include <log4cplus/helpers/pointer.h>
 #include <log4cplus/spi/loggerfactory.h>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <span>
 #include <vector>
 
 
 namespace log4cplus {
     class DefaultLoggerFactory;
+    class LoggerRef;
+
+    namespace internal {
+        class logger_arena;
+    }
 
     namespace spi {
 
+        struct CaptureLimits;
+
         /**
          * This is the central class in the log4cplus package. One of the
          * distintive features of log4cplus are hierarchical loggers and their
          * evaluation.
          */
         class LOG4CPLUS_EXPORT LoggerImpl
-            : public virtual log4cplus::helpers::SharedObject,
+            : public log4cplus::helpers::SharedObjectBase,
               public log4cplus::helpers::AppenderAttachableImpl
         {
         public:
@@ -70,15 +80,39 @@ namespace log4cplus {
              */
             virtual void callAppenders(const InternalLoggingEvent& event);
 
+            //! Batch counterpart of callAppenders(). Appenders receive
+            //! the events through Appender::doAppendBatch().
+            virtual void callAppenders(
+                std::span<InternalLoggingEvent const> events);
+
             /**
              * Close all attached appenders implementing the AppenderAttachable
              * interface.
              */
             virtual void closeNestedAppenders();
 
+            /**
+             * Returns <code>true</code> if there is at least one appender
+             * that would receive events from this logger and all such
+             * appenders are asynchronous.
+             *
+             * @see Appender::isAsynchronous()
+             */
+            bool hasOnlyAsyncAppenders() const;
+
+            /**
+             * Returns combination of EventFields read by appenders that
+             * would receive events from this logger.
+             *
+             * @see Appender::getRequiredEventFields()
+             */
+            unsigned getRequiredEventFields() const;
+
             /**
              * Check whether this logger is enabled for a given LogLevel passed
-             * as parameter.
+             * as parameter. Events that thresholds and filters of all
+             * appenders reachable from this logger would drop, see
+             * Appender::mayAppend(), are reported as disabled too.
              *
              * @return boolean True if this logger is enabled for <code>ll</code>.
              */
@@ -113,7 +147,7 @@ namespace log4cplus {
             /**
              * Set the LogLevel of this Logger.
              */
-            void setLogLevel(LogLevel _ll) { this->ll = _ll; }
+            void setLogLevel(LogLevel _ll);
 
             /**
              * Return the the {@link Hierarchy} where this <code>Logger</code>
@@ -136,8 +170,22 @@ namespace log4cplus {
              */
             void setAdditivity(bool additive);
 
+            //! See Logger::setCaptureLimits().
+            void setCaptureLimits(
+                std::shared_ptr<CaptureLimits const> limits);
+
+            //! Returns limits set by setCaptureLimits() on this logger.
+            std::shared_ptr<CaptureLimits const> getCaptureLimits() const;
+
             virtual ~LoggerImpl();
 
+            /**
+             * Creates a logger in the logger arena of <code>h</code>, see
+             * Hierarchy. Used by DefaultLoggerFactory.
+             */
+            static LoggerImpl * create(const log4cplus::tstring_view& name,
+                Hierarchy& h);
+
         protected:
           // Ctors
             /**
@@ -171,10 +219,20 @@ namespace log4cplus {
 
             virtual void forcedLog(spi::InternalLoggingEvent const & ev);
 
+            //! Logs events of <code>events</code> which are enabled,
+            //! passing runs of consecutive ones to callAppenders().
+            virtual void logBatch(
+                std::span<spi::InternalLoggingEvent const> events);
+
 
           // Data
+            // Fields below are read by every logging call and rarely
+            // written. They start in a cache line apart from the mutex
+            // and the appenders list of AppenderAttachableImpl and from
+            // the reference count of SharedObject.
+
             /** The name of this logger */
-            log4cplus::tstring name;
+            alignas (LOG4CPLUS_CACHE_LINE_SIZE) log4cplus::tstring name;
 
             /**
              * The assigned LogLevel of this logger.
@@ -199,12 +257,62 @@ namespace log4cplus {
             bool additive;
 
         private:
+          // Methods
+            /**
+             * Returns the lowest log level that passes both the effective
+             * log level of this logger and the hierarchy disable
+             * threshold. The value is cached and recomputed only when the
+             * log levels generation of the hierarchy changes.
+             */
+            LOG4CPLUS_PRIVATE LogLevel getEnabledThreshold() const;
+
+            /**
+             * Returns <code>false</code> when no appender reachable from
+             * this logger would append events of log level <code>ll</code>
+             * logged by the calling thread. Results that do not depend on
+             * NDC or MDC are cached for the standard log levels until
+             * appenders, their thresholds or filters, or additivity change.
+             */
+            LOG4CPLUS_PRIVATE bool mayLog(LogLevel ll) const;
+            LOG4CPLUS_PRIVATE unsigned computePreFilter(LogLevel ll) const;
+
+            //! Returns capture limits of the nearest logger, starting at
+            //! this one, which has any.
+            LOG4CPLUS_PRIVATE std::shared_ptr<CaptureLimits const>
+                getChainedCaptureLimits() const;
+
           // Data
             /** Loggers need to know what Hierarchy they are in. */
             Hierarchy& hierarchy;
 
+            /**
+             * Cached result of getEnabledThreshold(). The upper 32 bits
+             * hold the hierarchy log levels generation, the lower 32 bits
+             * hold the threshold.
+             */
+            mutable std::atomic<std::uint64_t> cachedThreshold;
+
+            /**
+             * Cached results of mayLog() for TRACE_LOG_LEVEL to
+             * FATAL_LOG_LEVEL. The upper 32 bits hold the pre-filter
+             * generation, the lower 32 bits hold the result.
+             */
+            mutable std::atomic<std::uint64_t> cachedPreFilter[6];
+
+            //! See setCaptureLimits().
+            std::atomic<std::shared_ptr<CaptureLimits const>> captureLimits;
+
+            /**
+             * Arena holding memory of this logger, null when the logger
+             * has been allocated with <code>new</code>.
+             */
+            internal::logger_arena * arena;
+
+            void dispose() const override;
+
           // Friends
             friend class log4cplus::Logger;
+            friend class log4cplus::LoggerRef;
             friend class log4cplus::DefaultLoggerFactory;
             friend class log4cplus::Hierarchy;
         };
@@ -35,11 +35,123 @@
 #include <log4cplus/ndc.h>
 #include <log4cplus/mdc.h>
 #include <log4cplus/tstring.h>
+#include <log4cplus/spi/keyvalues.h>
 #include <log4cplus/helpers/timehelper.h>
 #include <log4cplus/thread/threads.h>
 
 namespace log4cplus {
     namespace spi {
+        /**
+         * Message of a logging event whose formatting is deferred until
+         * the message is first needed, e.g., by an appender's layout
+         * running on AsyncAppender's thread. Implementations have to
+         * own all data they need for formatting.
+         */
+        class LOG4CPLUS_EXPORT DeferredMessage
+        {
+        public:
+            virtual ~DeferredMessage ();
+
+            //! Formats the message into <code>message</code>.
+            virtual void format (log4cplus::tstring & message) const = 0;
+        };
+
+        typedef std::shared_ptr<DeferredMessage const> DeferredMessagePtr;
+
+
+        /**
+         * Raw return addresses of the stack of a logging call,
+         * innermost first. They are symbolized only when formatted, see
+         * symbolizeStackFrame().
+         */
+        struct StackTrace
+        {
+            static constexpr std::size_t max_frames = 32;
+
+            std::size_t size = 0;
+            void * frames[max_frames];
+        };
+
+        typedef std::shared_ptr<StackTrace const> StackTracePtr;
+
+
+        /**
+         * Captures return addresses of the calling thread's stack,
+         * leaving out the innermost <code>skip</code> frames besides
+         * the one of this function. Returns null where stack traces
+         * are not supported. Defined in stacktrace.cxx.
+         */
+        LOG4CPLUS_EXPORT StackTracePtr currentStackTrace (unsigned skip = 0);
+
+        /**
+         * Returns description of return address <code>address</code>:
+         * module, demangled function name and offset where they are
+         * known, and the address itself. Descriptions are cached for the
+         * life of the process, so every address is resolved only once.
+         */
+        LOG4CPLUS_EXPORT log4cplus::tstring const & symbolizeStackFrame (
+            void * address);
+
+        /**
+         * Events of at least log level <code>ll</code> capture stack
+         * trace of the logging call, see
+         * InternalLoggingEvent::captureStackTrace(). The default is
+         * OFF_LOG_LEVEL, stack traces are not captured.
+         */
+        LOG4CPLUS_EXPORT void setStackTraceLogLevel (LogLevel ll);
+
+        //! Returns log level set by setStackTraceLogLevel().
+        LOG4CPLUS_EXPORT LogLevel getStackTraceLogLevel ();
+
+        /**
+         * Enables sequence numbers of events, see
+         * InternalLoggingEvent::getSequenceNumber(). Disabled by default.
+         */
+        LOG4CPLUS_EXPORT void setEventSequencing (bool enable);
+
+        //! Returns value set by setEventSequencing().
+        LOG4CPLUS_EXPORT bool getEventSequencing ();
+
+
+        /**
+         * Bits naming the fields of InternalLoggingEvent that are costly
+         * to capture because they are fetched from the logging thread or
+         * converted from borrowed strings. Layouts, filters and appenders
+         * report which of them they read so that events handed over to
+         * other threads capture only those.
+         */
+        enum EventFields : unsigned
+        {
+            EVENT_FIELDS_NONE    = 0,
+            EVENT_FIELD_NDC      = 0x0001,
+            EVENT_FIELD_MDC      = 0x0002,
+            EVENT_FIELD_THREAD   = 0x0004,
+            EVENT_FIELD_THREAD2  = 0x0008,
+            EVENT_FIELD_FILE     = 0x0010,
+            EVENT_FIELD_FUNCTION = 0x0020,
+            EVENT_FIELDS_ALL     = 0x003F
+        };
+
+
+        /**
+         * Limits on sizes of event data, applied when the event is
+         * logged, see Logger::setCaptureLimits(). Zero means no limit.
+         */
+        struct CaptureLimits
+        {
+            //! Maximum number of characters of the message.
+            std::size_t maxMessageSize = 0;
+            //! Maximum number of NDC levels, the outermost ones are kept.
+            std::size_t maxNDCDepth = 0;
+            //! Maximum number of characters of each MDC value.
+            std::size_t maxMDCValueSize = 0;
+            //! Appended to message, NDC and MDC values that have been cut.
+            log4cplus::tstring marker = LOG4CPLUS_TEXT ("...");
+        };
+
+        typedef std::shared_ptr<CaptureLimits const> CaptureLimitsPtr;
+
+
         /**
          * The internal representation of logging events. When an affirmative
          * decision is made to log then a <code>InternalLoggingEvent</code>
@@ -83,6 +195,15 @@ namespace log4cplus {
             InternalLoggingEvent(
                 const log4cplus::spi::InternalLoggingEvent& rhs);
 
+            /**
+             * Copies <code>rhs</code> but captures only the fields named
+             * by <code>fields</code>, a combination of EventFields; the
+             * other ones are left empty.
+             */
+            InternalLoggingEvent(
+                const log4cplus::spi::InternalLoggingEvent& rhs,
+                unsigned fields);
+
             virtual ~InternalLoggingEvent();
 
             void setLoggingEvent (const log4cplus::tstring_view & logger,
@@ -90,9 +211,81 @@ namespace log4cplus {
                 const char * filename, int line,
                 const char * function = nullptr);
 
+            /**
+             * Same as the other setLoggingEvent() overload but the logger
+             * name is borrowed instead of copied. The string pointed to by
+             * <code>logger</code>, usually the name owned by LoggerImpl,
+             * has to outlive the logging call. Copies of the event own
+             * their logger name.
+             */
+            void setLoggingEvent (const log4cplus::tstring * logger,
+                LogLevel ll, const log4cplus::tstring_view & message,
+                const char * filename, int line,
+                const char * function = nullptr);
+
             void setFunction (char const * func);
             void setFunction (log4cplus::tstring_view const &);
 
+            /**
+             * Replaces time stamp taken by setLoggingEvent(), e.g., for
+             * records buffered by language bindings before they are
+             * passed to Logger::logBatch().
+             */
+            void setTimestamp (log4cplus::helpers::Time const & time);
+
+            //! Replaces time stamp like setTimestamp() does, keeping its
+            //! nanoseconds, see getPreciseTimestamp().
+            void setPreciseTimestamp (
+                log4cplus::helpers::PreciseTime const & time);
+
+            /**
+             * Sets message that will be formatted when getMessage() is
+             * first called. Copies of the event share the deferred
+             * message.
+             */
+            void setDeferredMessage (DeferredMessagePtr msg);
+
+            /**
+             * Returns the deferred message set by setDeferredMessage(),
+             * if any. It stays available after the message is formatted
+             * so that appenders can use its original form.
+             */
+            DeferredMessagePtr const & getDeferredMessage () const
+            { return deferredMessage; }
+
+            /**
+             * Reserves and touches storage for messages of up to
+             * <code>capacity</code> characters so that setting them
+             * later does not allocate or fault pages in. Clears the
+             * message.
+             */
+            void reserveMessage (std::size_t capacity);
+
+            /**
+             * Returns <code>true</code> if message or MDC values of this
+             * event exceed <code>limits</code>.
+             */
+            bool exceedsCaptureLimits (CaptureLimits const & limits) const;
+
+            /**
+             * Cuts message, NDC and MDC values of this event down to
+             * <code>limits</code> and appends their marker to each of
+             * them that has been cut, see captureLimitedNDC().
+             *
+             * @return <code>true</code> if anything has been cut.
+             */
+            bool applyCaptureLimits (CaptureLimits const & limits);
+
+            /**
+             * Captures NDC of the calling thread like getNDC() does but
+             * keeps only its outermost <code>limits.maxNDCDepth</code>
+             * levels followed by the marker. Does nothing when NDC has
+             * been captured already.
+             *
+             * @return <code>true</code> if any levels have been left out.
+             */
+            bool captureLimitedNDC (CaptureLimits const & limits) const;
+
 
           // public virtual methods
             /** The application supplied message of logging event. */
@@ -116,7 +309,7 @@ namespace log4cplus {
              */
             const log4cplus::tstring& getLoggerName() const
             {
-                return loggerName;
+                return loggerNameRef ? *loggerNameRef : loggerName;
             }
 
             /** LogLevel of logging event. */
@@ -136,38 +329,44 @@ namespace log4cplus {
                 return ndc;
             }
 
-            MappedDiagnosticContextMap const & getMDCCopy () const
+            MappedDiagnosticContextMap const & getMDCCopy () const;
+
+            /**
+             * MDC of the event as a shared snapshot; copies of the event
+             * refer to the same snapshot.
+             */
+            MappedDiagnosticContextPtr const & getMDCSnapshot () const
             {
                 if (!mdcCached)
                 {
-                    mdc = log4cplus::getMDC().getContext ();
+                    mdc = log4cplus::getMDC().getSnapshot ();
                     mdcCached = true;
                 }
                 return mdc;
             }
 
             tstring const & getMDC (tstring const & key) const;
+            tstring const & getMDC (MDCKey key) const;
 
-            /** The name of thread in which this logging event was generated. */
+            /**
+             * The name of thread in which this logging event was
+             * generated. During the logging call this refers to the name
+             * kept by the thread, it is copied into the event only by
+             * gatherThreadSpecificData() and by copying the event.
+             */
             const log4cplus::tstring& getThread() const
             {
                 if (! threadCached)
-                {
-                    thread = thread::getCurrentThreadName ();
-                    threadCached = true;
-                }
+                    return thread::getCurrentThreadName ();
                 return thread;
             }
 
             //! The alternative name of thread in which this logging event
-            //! was generated.
+            //! was generated, see getThread().
             const log4cplus::tstring& getThread2() const
             {
                 if (! thread2Cached)
-                {
-                    thread2 = thread::getCurrentThreadName2 ();
-                    thread2Cached = true;
-                }
+                    return thread::getCurrentThreadName2 ();
                 return thread2;
             }
 
@@ -178,9 +377,49 @@ namespace log4cplus {
                 return timestamp;
             }
 
+            /**
+             * Time stamp when the event was created, with nanosecond
+             * resolution of clocks that have it; getTimestamp() is
+             * truncated to microseconds.
+             */
+            log4cplus::helpers::PreciseTime getPreciseTimestamp() const
+            {
+                return timestamp
+                    + std::chrono::nanoseconds (timestampNanos);
+            }
+
+            /**
+             * Sequence number of the event, 0 if it has none. Numbers are
+             * unique in the process and increase within every thread;
+             * merges of events written by several appenders or processes
+             * order events of equal time stamps by them.
+             */
+            std::uint64_t getSequenceNumber() const { return sequence; }
+
+            void setSequenceNumber (std::uint64_t seq) { sequence = seq; }
+
+            /**
+             * Assigns sequence number to the event unless it already has
+             * one. LoggerImpl::callAppenders() calls it while
+             * getEventSequencing() is enabled. Numbers are taken from
+             * blocks leased by every thread from a global counter, so
+             * the counter is touched once per block, not per event.
+             */
+            void assignSequenceNumber () const;
+
             /** The is the file where this log statement was written */
             const log4cplus::tstring& getFile() const
             {
+                if (fileRef)
+                {
+#if defined (UNICODE)
+                    file = LOG4CPLUS_C_STR_TO_TSTRING (fileRef);
+#else
+                    // Keeps capacity of events reused by the macros.
+                    file.assign (fileRef);
+#endif
+                    fileRef = nullptr;
+                }
                 return file;
             }
 
@@ -189,13 +428,61 @@ namespace log4cplus {
 
             log4cplus::tstring const & getFunction () const
             {
+                if (functionRef)
+                {
+#if defined (UNICODE)
+                    function = LOG4CPLUS_C_STR_TO_TSTRING (functionRef);
+#else
+                    // Keeps capacity of events reused by the macros.
+                    function.assign (functionRef);
+#endif
+                    functionRef = nullptr;
+                }
                 return function;
             }
 
-            void gatherThreadSpecificData () const;
+            /**
+             * Typed key/value fields of the event, e.g., those given to
+             * LOG4CPLUS_INFO_KV(). They are always captured by copies.
+             */
+            KeyValues const & getKeyValues () const { return keyValues; }
+            KeyValues & getKeyValues () { return keyValues; }
+
+            /**
+             * Stack trace of the logging call, if it has been captured.
+             * Copies of the event share it.
+             */
+            StackTracePtr const & getStackTrace () const
+            { return stackTrace; }
+
+            void setStackTrace (StackTracePtr trace)
+            { stackTrace = std::move (trace); }
+
+            /**
+             * Captures stack trace of the calling thread unless the event
+             * already has one. LoggerImpl::callAppenders() calls it for
+             * events of at least getStackTraceLogLevel().
+             */
+            void captureStackTrace () const;
+
+            /**
+             * Captures fields named by <code>fields</code>, a combination
+             * of EventFields, that are still fetched from the logging
+             * thread or refer to borrowed strings.
+             */
+            void gatherThreadSpecificData (
+                unsigned fields = EVENT_FIELDS_ALL) const;
 
             void swap (InternalLoggingEvent &);
 
+            /**
+             * Same as operator=() but captures only the fields named by
+             * <code>fields</code>, a combination of EventFields; the other
+             * ones are left empty.
+             */
+            void assign (const log4cplus::spi::InternalLoggingEvent& rhs,
+                unsigned fields);
+
           // public operators
             log4cplus::spi::InternalLoggingEvent&
             operator=(const log4cplus::spi::InternalLoggingEvent& rhs);
@@ -204,18 +491,50 @@ namespace log4cplus {
             static unsigned int getDefaultType();
 
         protected:
+          // Methods
+            LOG4CPLUS_PRIVATE void copyMessage (
+                const InternalLoggingEvent & rhs);
+
+            LOG4CPLUS_PRIVATE void setLoggingEventData (LogLevel ll,
+                const log4cplus::tstring_view & message,
+                const char * filename, int line, const char * function);
+
           // Data
-            log4cplus::tstring message;
-            log4cplus::tstring loggerName;
+            mutable log4cplus::tstring message;
+            /**
+             * Large message moved out of <code>message</code> when the
+             * event is first copied. Copies share it instead of copying
+             * the characters.
+             */
+            mutable std::shared_ptr<log4cplus::tstring const> sharedMessage;
+            /** Deferred form of the message, if any. */
+            mutable DeferredMessagePtr deferredMessage;
+            mutable log4cplus::tstring loggerName;
+            /** Borrowed logger name, see setLoggingEvent(). */
+            mutable log4cplus::tstring const * loggerNameRef;
             LogLevel ll;
             mutable log4cplus::tstring ndc;
-            mutable MappedDiagnosticContextMap mdc;
+            mutable MappedDiagnosticContextPtr mdc;
             mutable log4cplus::tstring thread;
             mutable log4cplus::tstring thread2;
             log4cplus::helpers::Time timestamp;
-            log4cplus::tstring file;
-            log4cplus::tstring function;
+            mutable log4cplus::tstring file;
+            mutable log4cplus::tstring function;
+            /**
+             * File and function names passed as C strings are borrowed
+             * and converted into <code>file</code> and <code>function</code>
+             * only when they are first asked for or when the event is
+             * copied.
+             */
+            mutable char const * fileRef;
+            mutable char const * functionRef;
+            KeyValues keyValues;
+            mutable StackTracePtr stackTrace;
+            //! See getSequenceNumber().
+            mutable std::uint64_t sequence;
             int line;
+            //! Nanoseconds of the time stamp within its microsecond.
+            std::uint16_t timestampNanos;
             /** Indicates whether or not the Threadname has been retrieved. */
             mutable bool threadCached;
             mutable bool thread2Cached;
@@ -223,6 +542,9 @@ namespace log4cplus {
             mutable bool ndcCached;
             /** Indicates whether or not the MDC has been retrieved. */
             mutable bool mdcCached;
+            /** Indicates whether or not the deferred message has been
+                formatted into <code>message</code>. */
+            mutable bool messageCached;
         };
 
     } // end namespace spi
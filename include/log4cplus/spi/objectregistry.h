@@ -32,8 +32,10 @@
 
 #include <log4cplus/tstring.h>
 #include <log4cplus/thread/syncprims.h>
+#include <atomic>
 #include <map>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 
@@ -93,11 +95,20 @@ namespace log4cplus {
 
           // Types
             typedef std::map<log4cplus::tstring, void*> ObjectMap;
+            typedef std::unordered_map<log4cplus::tstring, void*> ObjectIndex;
+            typedef std::shared_ptr<ObjectIndex const> ObjectIndexPtr;
 
           // Data
             thread::Mutex mutex;
             ObjectMap data;
 
+            /**
+             * Read-optimized copy of <code>data</code>. It is an immutable
+             * snapshot replaced as a whole by putVal(), so that exists()
+             * and getVal() do not need to lock <code>mutex</code>.
+             */
+            std::atomic<ObjectIndexPtr> index;
+
         private:
             ObjectRegistryBase (ObjectRegistryBase const &);
             ObjectRegistryBase & operator = (ObjectRegistryBase const &);
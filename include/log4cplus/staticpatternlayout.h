@@ -0,0 +1,587 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    staticpatternlayout.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_STATIC_PATTERN_LAYOUT_HEADER_
+#define LOG4CPLUS_STATIC_PATTERN_LAYOUT_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/layout.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/spi/factory.h>
+#include <log4cplus/spi/loggingevent.h>
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <utility>
+
+
+namespace log4cplus {
+
+    namespace pattern {
+
+        /**
+         * Wrapper that allows string literals to be used as template
+         * arguments of StaticPatternLayout.
+         */
+        template <std::size_t N>
+        struct StaticPattern
+        {
+            consteval StaticPattern (tchar const (& str)[N])
+            {
+                for (std::size_t i = 0; i != N; ++i)
+                    value[i] = str[i];
+            }
+
+            constexpr log4cplus::tstring_view
+            view () const
+            {
+                return log4cplus::tstring_view (value, N - 1);
+            }
+
+            tchar value[N];
+        };
+
+
+        enum StaticFieldType : unsigned char
+        {
+            LITERAL_FIELD,
+            LOGLEVEL_FIELD,
+            NDC_FIELD,
+            MESSAGE_FIELD,
+            NEWLINE_FIELD,
+            BASENAME_FIELD,
+            FILE_FIELD,
+            THREAD_FIELD,
+            THREAD2_FIELD,
+            LINE_FIELD,
+            FULL_LOCATION_FIELD,
+            FUNCTION_FIELD,
+            LOGGER_FIELD,
+            MDC_FIELD,
+            LOCAL_DATE_FIELD,
+            GMT_DATE_FIELD,
+            PROCESS_FIELD,
+            RELATIVE_TIMESTAMP_FIELD,
+            KEY_VALUES_FIELD,
+            SEQUENCE_FIELD
+        };
+
+
+        /**
+         * One element of a pattern parsed at compile time. Literal text
+         * and options are stored as ranges of the pattern string.
+         */
+        struct StaticField
+        {
+            StaticFieldType type = LITERAL_FIELD;
+            std::size_t begin = 0;
+            std::size_t length = 0;
+            int minLen = -1;
+            std::size_t maxLen = (std::numeric_limits<std::size_t>::max) ();
+            bool leftAlign = false;
+            bool trimStart = true;
+            int precision = 0;
+
+            constexpr bool
+            isPadded () const
+            {
+                return minLen >= 0
+                    || maxLen != (std::numeric_limits<std::size_t>::max) ();
+            }
+        };
+
+
+        template <std::size_t N>
+        struct StaticParsedPattern
+        {
+            std::array<StaticField, N> fields {};
+            std::size_t count = 0;
+        };
+
+
+        //! Reports malformed pattern; never defined so that using it in
+        //! constant evaluation is a compile time error.
+        void staticPatternError (char const * msg);
+
+
+        /**
+         * Parses pattern the same way as PatternParser does, with the
+         * difference that unsupported or malformed conversion specifiers
+         * are compile time errors.
+         */
+        template <std::size_t N>
+        consteval StaticParsedPattern<N>
+        parseStaticPattern (log4cplus::tstring_view p)
+        {
+            StaticParsedPattern<N> r;
+            std::size_t pos = 0;
+            std::size_t litBegin = 0;
+            std::size_t litLen = 0;
+
+            auto flush = [&] {
+                if (litLen != 0)
+                {
+                    StaticField & f = r.fields[r.count++];
+                    f.type = LITERAL_FIELD;
+                    f.begin = litBegin;
+                    f.length = litLen;
+                }
+                litLen = 0;
+            };
+
+            auto addLiteral = [&] (std::size_t at) {
+                if (litLen != 0 && litBegin + litLen == at)
+                    ++litLen;
+                else
+                {
+                    flush ();
+                    litBegin = at;
+                    litLen = 1;
+                }
+            };
+
+            auto isDigit = [] (tchar c) {
+                return c >= LOG4CPLUS_TEXT ('0') && c <= LOG4CPLUS_TEXT ('9');
+            };
+
+            while (pos < p.size ())
+            {
+                tchar c = p[pos++];
+                // The last char is always a literal.
+                if (c != LOG4CPLUS_TEXT ('%') || pos == p.size ())
+                {
+                    addLiteral (pos - 1);
+                    continue;
+                }
+                else if (p[pos] == LOG4CPLUS_TEXT ('%'))
+                {
+                    addLiteral (pos - 1);
+                    ++pos;
+                    continue;
+                }
+
+                flush ();
+
+                StaticField f;
+                enum { CONVERTER_STATE, MIN_STATE, DOT_STATE, MAX_STATE }
+                    state = CONVERTER_STATE;
+                for (bool done = false; ! done; )
+                {
+                    if (pos == p.size ())
+                        staticPatternError ("incomplete conversion specifier");
+
+                    c = p[pos++];
+                    switch (state)
+                    {
+                    case CONVERTER_STATE:
+                        if (c == LOG4CPLUS_TEXT ('-'))
+                            f.leftAlign = true;
+                        else if (c == LOG4CPLUS_TEXT ('.'))
+                            state = DOT_STATE;
+                        else if (isDigit (c))
+                        {
+                            f.minLen = c - LOG4CPLUS_TEXT ('0');
+                            state = MIN_STATE;
+                        }
+                        else
+                            done = true;
+                        break;
+
+                    case MIN_STATE:
+                        if (isDigit (c))
+                            f.minLen = f.minLen * 10 + (c - LOG4CPLUS_TEXT ('0'));
+                        else if (c == LOG4CPLUS_TEXT ('.'))
+                            state = DOT_STATE;
+                        else
+                            done = true;
+                        break;
+
+                    case DOT_STATE:
+                        if (c == LOG4CPLUS_TEXT ('-'))
+                            f.trimStart = false;
+                        else if (isDigit (c))
+                        {
+                            f.maxLen = static_cast<std::size_t>(
+                                c - LOG4CPLUS_TEXT ('0'));
+                            state = MAX_STATE;
+                        }
+                        else
+                            staticPatternError ("expected digit after '.'");
+                        break;
+
+                    case MAX_STATE:
+                        if (isDigit (c))
+                            f.maxLen = f.maxLen * 10
+                                + static_cast<std::size_t>(
+                                    c - LOG4CPLUS_TEXT ('0'));
+                        else
+                            done = true;
+                        break;
+                    }
+                }
+
+                // Extract optional {...} option.
+                bool hasOption = false;
+                auto extractOption = [&] {
+                    if (pos < p.size () && p[pos] == LOG4CPLUS_TEXT ('{'))
+                    {
+                        std::size_t const end = p.find (LOG4CPLUS_TEXT ('}'), pos);
+                        if (end == log4cplus::tstring_view::npos)
+                            staticPatternError ("no matching '}' found");
+                        f.begin = pos + 1;
+                        f.length = end - pos - 1;
+                        pos = end + 1;
+                        hasOption = true;
+                    }
+                };
+
+                switch (c)
+                {
+                case LOG4CPLUS_TEXT ('b'): f.type = BASENAME_FIELD; break;
+                case LOG4CPLUS_TEXT ('F'): f.type = FILE_FIELD; break;
+                case LOG4CPLUS_TEXT ('i'): f.type = PROCESS_FIELD; break;
+                case LOG4CPLUS_TEXT ('l'): f.type = FULL_LOCATION_FIELD; break;
+                case LOG4CPLUS_TEXT ('L'): f.type = LINE_FIELD; break;
+                case LOG4CPLUS_TEXT ('m'): f.type = MESSAGE_FIELD; break;
+                case LOG4CPLUS_TEXT ('M'): f.type = FUNCTION_FIELD; break;
+                case LOG4CPLUS_TEXT ('n'): f.type = NEWLINE_FIELD; break;
+                case LOG4CPLUS_TEXT ('p'): f.type = LOGLEVEL_FIELD; break;
+                case LOG4CPLUS_TEXT ('r'): f.type = RELATIVE_TIMESTAMP_FIELD; break;
+                case LOG4CPLUS_TEXT ('t'): f.type = THREAD_FIELD; break;
+                case LOG4CPLUS_TEXT ('T'): f.type = THREAD2_FIELD; break;
+                case LOG4CPLUS_TEXT ('x'): f.type = NDC_FIELD; break;
+                case LOG4CPLUS_TEXT ('Y'): f.type = SEQUENCE_FIELD; break;
+
+                case LOG4CPLUS_TEXT ('c'):
+                    f.type = LOGGER_FIELD;
+                    extractOption ();
+                    // Same as std::atoi() used by PatternParser.
+                    for (std::size_t i = 0;
+                         i != f.length && isDigit (p[f.begin + i]); ++i)
+                        f.precision = f.precision * 10
+                            + (p[f.begin + i] - LOG4CPLUS_TEXT ('0'));
+                    f.begin = f.length = 0;
+                    break;
+
+                case LOG4CPLUS_TEXT ('d'):
+                case LOG4CPLUS_TEXT ('D'):
+                    f.type = c == LOG4CPLUS_TEXT ('d')
+                        ? GMT_DATE_FIELD : LOCAL_DATE_FIELD;
+                    extractOption ();
+                    if (f.length == 0)
+                        hasOption = false;
+                    break;
+
+                case LOG4CPLUS_TEXT ('X'):
+                    f.type = MDC_FIELD;
+                    extractOption ();
+                    break;
+
+                case LOG4CPLUS_TEXT ('K'):
+                    f.type = KEY_VALUES_FIELD;
+                    extractOption ();
+                    break;
+
+                default:
+                    staticPatternError ("unsupported conversion specifier");
+                }
+
+                // Zero length option means default, e.g., for dates.
+                if (! hasOption)
+                    f.begin = f.length = 0;
+
+                r.fields[r.count++] = f;
+            }
+
+            flush ();
+            return r;
+        }
+
+
+        //! Returns combination of spi::EventFields the fields of parsed
+        //! pattern read, same as PatternLayout::getRequiredEventFields().
+        template <std::size_t N>
+        constexpr unsigned
+        staticRequiredEventFields (StaticParsedPattern<N> const & p)
+        {
+            unsigned fields = spi::EVENT_FIELDS_NONE;
+            for (std::size_t i = 0; i != p.count; ++i)
+                switch (p.fields[i].type)
+                {
+                case NDC_FIELD:
+                    fields |= spi::EVENT_FIELD_NDC;
+                    break;
+
+                case MDC_FIELD:
+                    fields |= spi::EVENT_FIELD_MDC;
+                    break;
+
+                case BASENAME_FIELD:
+                case FILE_FIELD:
+                case FULL_LOCATION_FIELD:
+                    fields |= spi::EVENT_FIELD_FILE;
+                    break;
+
+                case THREAD_FIELD:
+                    fields |= spi::EVENT_FIELD_THREAD;
+                    break;
+
+                case THREAD2_FIELD:
+                    fields |= spi::EVENT_FIELD_THREAD2;
+                    break;
+
+                case FUNCTION_FIELD:
+                    fields |= spi::EVENT_FIELD_FUNCTION;
+                    break;
+
+                default:
+                    break;
+                }
+
+            return fields;
+        }
+
+
+        //! Appends string to output observing field's padding and
+        //! truncation rules, same as PatternConverter::formatAndAppend().
+        LOG4CPLUS_EXPORT void staticAppendPadded (log4cplus::tstring & output,
+            log4cplus::tstring_view str, StaticField const & field);
+
+        //! Returns emptied per-thread buffer used by the stream overload
+        //! of StaticPatternLayout::formatAndAppend().
+        LOG4CPLUS_EXPORT log4cplus::tstring & staticLayoutBuffer ();
+
+        //! Formats fields that cannot be referenced directly in the event.
+        //! The returned reference is to a per-thread buffer.
+        LOG4CPLUS_EXPORT log4cplus::tstring const & staticFormatField (
+            StaticField const & field, log4cplus::tstring const & option,
+            spi::InternalLoggingEvent const & event);
+
+        LOG4CPLUS_EXPORT log4cplus::tstring_view staticLoggerName (
+            log4cplus::tstring const & name, int precision);
+
+        LOG4CPLUS_EXPORT log4cplus::tstring_view staticNDC (
+            log4cplus::tstring const & ndc, unsigned precision);
+
+    } // namespace pattern
+
+
+    /**
+     * A PatternLayout whose conversion pattern is parsed at compile time.
+     * Formatting of an event is expanded into a fixed sequence of field
+     * writes without virtual calls to per-field converters and, for most
+     * fields, without temporary strings.
+     *
+     * All conversion specifiers of PatternLayout except <b>%%E</b>,
+     * <b>%%h</b> and <b>%%H</b> are supported and produce the same
+     * output. Unsupported or malformed specifiers fail compilation.
+     *
+     * <pre>
+     * using MyLayout = log4cplus::StaticPatternLayout<
+     *     LOG4CPLUS_TEXT ("%d{%H:%M:%S} %-5p [%t] %c{2} - %m%n")>;
+     *
+     * log4cplus::registerStaticPatternLayout<MyLayout> (
+     *     LOG4CPLUS_TEXT ("MyLayout"));
+     * </pre>
+     *
+     * <h3>Properties</h3>
+     *
+     * <dl>
+     * <dt><tt>NDCMaxDepth</tt></dt>
+     * <dd>This property limits how many deepest NDC components will
+     * be printed by <b>%%x</b> specifier.</dd>
+     * </dl>
+     */
+    template <pattern::StaticPattern Pattern>
+    class StaticPatternLayout
+        : public Layout
+    {
+    public:
+        static constexpr auto parsed
+            = pattern::parseStaticPattern<sizeof (Pattern.value)
+                / sizeof (tchar)> (Pattern.view ());
+
+        StaticPatternLayout ()
+        {
+            init ();
+        }
+
+        StaticPatternLayout (const log4cplus::helpers::Properties& properties)
+            : Layout (properties)
+        {
+            properties.getUInt (ndcMaxDepth, LOG4CPLUS_TEXT ("NDCMaxDepth"));
+            init ();
+        }
+
+        virtual void formatAndAppend (log4cplus::tostream& output,
+            const log4cplus::spi::InternalLoggingEvent& event)
+        {
+            log4cplus::tstring & buffer = pattern::staticLayoutBuffer ();
+            formatAndAppend (buffer, event);
+            output.write (buffer.data (),
+                static_cast<std::streamsize>(buffer.size ()));
+        }
+
+        virtual void formatAndAppend (log4cplus::tstring& output,
+            const log4cplus::spi::InternalLoggingEvent& event)
+        {
+            formatAndAppendImpl (output, event,
+                std::make_index_sequence<parsed.count> ());
+        }
+
+        virtual unsigned getRequiredEventFields () const
+        {
+            return pattern::staticRequiredEventFields (parsed);
+        }
+
+    private:
+        void
+        init ()
+        {
+            // Options have to be tstrings for MDC and key/value lookup
+            // and date formatting.
+            for (std::size_t i = 0; i != parsed.count; ++i)
+            {
+                pattern::StaticField const & f = parsed.fields[i];
+                if (f.type == pattern::LOCAL_DATE_FIELD
+                    || f.type == pattern::GMT_DATE_FIELD)
+                    options[i] = f.length != 0
+                        ? log4cplus::tstring (
+                            Pattern.view ().substr (f.begin, f.length))
+                        : log4cplus::tstring (
+                            LOG4CPLUS_TEXT ("%Y-%m-%d %H:%M:%S"));
+                else if (f.type == pattern::MDC_FIELD
+                    || f.type == pattern::KEY_VALUES_FIELD)
+                    options[i].assign (
+                        Pattern.view ().substr (f.begin, f.length));
+            }
+        }
+
+        template <std::size_t... I>
+        void
+        formatAndAppendImpl (log4cplus::tstring& output,
+            const log4cplus::spi::InternalLoggingEvent& event,
+            std::index_sequence<I...>)
+        {
+            (appendField<I> (output, event), ...);
+        }
+
+        template <std::size_t I>
+        void
+        appendField (log4cplus::tstring& output,
+            const log4cplus::spi::InternalLoggingEvent& event)
+        {
+            constexpr pattern::StaticField f = parsed.fields[I];
+
+            if constexpr (f.type == pattern::LITERAL_FIELD)
+                output.append (Pattern.value + f.begin, f.length);
+            else if constexpr (f.type == pattern::NEWLINE_FIELD
+                && ! f.isPadded ())
+                output.push_back (LOG4CPLUS_TEXT ('\n'));
+            else
+                append<f> (output, fieldValue<I> (event));
+        }
+
+        template <pattern::StaticField f>
+        static void
+        append (log4cplus::tstring& output, log4cplus::tstring_view str)
+        {
+            if constexpr (f.isPadded ())
+                pattern::staticAppendPadded (output, str, f);
+            else
+                output.append (str);
+        }
+
+        template <std::size_t I>
+        log4cplus::tstring_view
+        fieldValue (const log4cplus::spi::InternalLoggingEvent& event) const
+        {
+            constexpr pattern::StaticField f = parsed.fields[I];
+
+            if constexpr (f.type == pattern::LOGLEVEL_FIELD)
+                return llmCache.toString (event.getLogLevel ());
+            else if constexpr (f.type == pattern::MESSAGE_FIELD)
+                return event.getMessage ();
+            else if constexpr (f.type == pattern::NEWLINE_FIELD)
+                return LOG4CPLUS_TEXT ("\n");
+            else if constexpr (f.type == pattern::FILE_FIELD)
+                return event.getFile ();
+            else if constexpr (f.type == pattern::FUNCTION_FIELD)
+                return event.getFunction ();
+            else if constexpr (f.type == pattern::THREAD_FIELD)
+                return event.getThread ();
+            else if constexpr (f.type == pattern::THREAD2_FIELD)
+                return event.getThread2 ();
+            else if constexpr (f.type == pattern::LOGGER_FIELD)
+                return pattern::staticLoggerName (event.getLoggerName (),
+                    f.precision);
+            else if constexpr (f.type == pattern::NDC_FIELD)
+                return pattern::staticNDC (event.getNDC (), ndcMaxDepth);
+            else if constexpr (f.type == pattern::MDC_FIELD)
+            {
+                if (! options[I].empty ())
+                    return event.getMDC (options[I]);
+                else
+                    return pattern::staticFormatField (f, options[I], event);
+            }
+            else
+                return pattern::staticFormatField (f, options[I], event);
+        }
+
+        unsigned ndcMaxDepth = 0;
+        std::array<log4cplus::tstring, parsed.count> options;
+    };
+
+
+    /**
+     * Registers StaticPatternLayout instance <code>LayoutType</code>
+     * with the layout factory registry under <code>name</code> so that
+     * it can be used from property files.
+     */
+    template <typename LayoutType>
+    void
+    registerStaticPatternLayout (log4cplus::tchar const * name)
+    {
+        spi::getLayoutFactoryRegistry ().put (
+            std::unique_ptr<spi::LayoutFactory> (
+                new spi::FactoryTempl<LayoutType, spi::LayoutFactory> (name)));
+    }
+
+} // end namespace log4cplus
+
+#endif // LOG4CPLUS_STATIC_PATTERN_LAYOUT_HEADER_
@@ -0,0 +1,159 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    structuredlayout.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+/** @file */
+
+#ifndef LOG4CPLUS_STRUCTURED_LAYOUT_HEADER_
+#define LOG4CPLUS_STRUCTURED_LAYOUT_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/layout.h>
+
+#include <memory>
+#include <vector>
+
+
+namespace log4cplus {
+
+    /**
+     * Base of layouts which write events as a sequence of named fields,
+     * JsonLayout and LogfmtLayout. It selects and names the fields and
+     * formats the timestamp; derived layouts build their field writers
+     * from getFields() once, at construction.
+     *
+     * <h3>Properties</h3>
+     *
+     * <dl>
+     * <dt><tt>Fields</tt></dt>
+     * <dd>Comma separated list of fields in the order in which they are
+     * written. Known fields are <code>timestamp</code>,
+     * <code>level</code>, <code>logger</code>, <code>thread</code>,
+     * <code>ndc</code>, <code>mdc</code>, <code>kv</code>,
+     * <code>file</code>, <code>line</code>, <code>function</code>,
+     * <code>message</code>, <code>stack</code> and <code>seq</code>. The
+     * default is all of them in this order. <code>kv</code> are typed
+     * key/value fields of the event, see spi::KeyValues.
+     * <code>stack</code> is the stack trace of the event, see
+     * spi::setStackTraceLogLevel(); every frame is described by
+     * spi::symbolizeStackFrame(), which keeps module, offset and raw
+     * address for offline symbolization. <code>seq</code> is the
+     * sequence number of the event, written only for events that have
+     * one, see spi::setEventSequencing().</dd>
+     *
+     * <dt><tt>FieldName.<i>field</i></tt></dt>
+     * <dd>Name of the field in the output. Default is the name of the
+     * field.</dd>
+     *
+     * <dt><tt>DateFormat</tt></dt>
+     * <dd>Format of the timestamp, see helpers::getFormattedTime(). The
+     * default is ISO 8601, <code>%Y-%m-%dT%H:%M:%S.%qZ</code>. It must
+     * not contain <code>}</code>.</dd>
+     *
+     * <dt><tt>Use_gmtime</tt></dt>
+     * <dd>Formats the timestamp in UTC when <code>true</code>, which is
+     * the default, and in local time otherwise.</dd>
+     * </dl>
+     */
+    class LOG4CPLUS_EXPORT StructuredLayout
+        : public Layout
+    {
+    public:
+        //! Fields of InternalLoggingEvent structured layouts can write.
+        enum Field
+        {
+            TIMESTAMP_FIELD,
+            LEVEL_FIELD,
+            LOGGER_FIELD,
+            THREAD_FIELD,
+            NDC_FIELD,
+            MDC_FIELD,
+            KV_FIELD,
+            FILE_FIELD,
+            LINE_FIELD,
+            FUNCTION_FIELD,
+            MESSAGE_FIELD,
+            STACK_FIELD,
+            SEQUENCE_FIELD
+        };
+
+        //! Selected field and its name.
+        struct FieldSpec
+        {
+            Field field;
+            log4cplus::tstring name;
+        };
+
+        virtual ~StructuredLayout();
+
+        //! Formats the event into the per-thread layout buffer using the
+        //! string overload and writes it to <code>output</code>.
+        virtual void formatAndAppend(log4cplus::tostream& output,
+                                     const log4cplus::spi::InternalLoggingEvent& event);
+        virtual void formatAndAppend(log4cplus::tstring& output,
+                                     const log4cplus::spi::InternalLoggingEvent& event) = 0;
+
+        virtual unsigned getRequiredEventFields() const;
+
+        //! Returns selected fields in output order.
+        std::vector<FieldSpec> const & getFields() const;
+
+    protected:
+        //! Selects all fields with default names.
+        StructuredLayout();
+        StructuredLayout(const log4cplus::helpers::Properties& properties);
+
+        //! Appends timestamp of <code>event</code> formatted according
+        //! to <code>DateFormat</code>, without any quoting.
+        void appendTimestamp(log4cplus::tstring& output,
+            const log4cplus::spi::InternalLoggingEvent& event) const;
+
+    private:
+        void addField(Field field, log4cplus::tstring const & name);
+        void initDateFormat(log4cplus::tstring const & dateFormat,
+            bool use_gmtime);
+
+        std::vector<FieldSpec> fields;
+        //! Formats the timestamp with cached per-second prefix.
+        std::unique_ptr<PatternLayout> dateLayout;
+        unsigned requiredEventFields = 0;
+
+      // Disallow copying of instances of this class
+        StructuredLayout(const StructuredLayout&);
+        StructuredLayout& operator=(const StructuredLayout&);
+    };
+
+} // end namespace log4cplus
+
+#endif // LOG4CPLUS_STRUCTURED_LAYOUT_HEADER_
@@ -33,11 +33,22 @@
 #include <log4cplus/appender.h>
 #include <log4cplus/helpers/socket.h>
 #include <log4cplus/helpers/connectorthread.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 
 namespace log4cplus
 {
 
+    namespace internal
+    {
+
+        struct syslog_sender;
+
+    } // namespace internal
+
+
     /**
      * Appends log events to a file.
      *
@@ -53,10 +64,29 @@ namespace log4cplus
      * names (case insensitive), e.g. auth, cron, kern, mail, news
      * etc.</dd>
      *
+     * <dt><tt>LocalSocket</tt></dt>
+     * <dd>Path of local syslog datagram socket, e.g.
+     * <code>/dev/log</code>; on Linux, path starting with '@' names
+     * socket in abstract namespace. When this property is specified and
+     * <tt>host</tt> is not, messages are written directly to this
+     * socket instead of calling <code>syslog()</code>, so they do not
+     * serialize on its process wide lock. Batches of messages are
+     * written with single <code>sendmmsg()</code> call where
+     * available. Not supported on Windows.</dd>
+     *
+     * <dt><tt>LocalFormat</tt></dt>
+     * <dd>Format of messages written to <tt>LocalSocket</tt>, either
+     * <code>rfc3164</code> or <code>rfc5424</code>. The default value
+     * is <code>rfc3164</code>, the format <code>syslog()</code>
+     * uses.</dd>
+     *
      * <dt><tt>host</tt></dt>
      * <dd>Destination syslog host. When this property is specified,
      * messages are sent using UDP to destination host, otherwise
-     * messages are logged to local syslog.</dd>
+     * messages are logged to local syslog. Name of form
+     * <code>unix:///path</code> sends them to local
+     * (<code>AF_UNIX</code>) socket at <code>/path</code> instead,
+     * datagram or stream one according to <tt>udp</tt>.</dd>
      *
      * <dt><tt>port</tt></dt>
      * <dd>Destination port of syslog service on host specified by the
@@ -75,6 +105,27 @@ namespace log4cplus
      * <dd>Boolean value specifying whether to use FQDN for hostname field.
      * Default value is true.</dd>
      *
+     * <dt><tt>AsyncConnect</tt></dt>
+     * <dd>When true, the remote syslog is connected by the connector
+     * thread instead of the constructor, so name resolution and TCP
+     * connection do not block it. Messages logged before the
+     * connection is made are dropped. Single threaded builds connect
+     * when the first message is sent. Default value is true.</dd>
+     *
+     * <dt><tt>QueueLimit</tt></dt>
+     * <dd>When this property is set to non-zero number of bytes,
+     * remote syslog messages are queued and sent by separate sender
+     * thread, so logging threads never wait for the network. TCP
+     * messages are coalesced into octet counted batches, each written
+     * with single call. UDP datagrams are sent with single
+     * <code>sendmmsg()</code> call where available and through
+     * Registered I/O on Windows 8 and later when built with
+     * <code>WITH_RIO</code>. Messages which do
+     * not fit into the queue are dropped and counted, see
+     * getRemoteQueueStats(). This property is ignored in single
+     * threaded builds. Default value is 0, messages are sent
+     * synchronously.</dd>
+     *
      * </dl>
      *
      * \note Messages sent to remote syslog using UDP are conforming
@@ -95,6 +146,22 @@ namespace log4cplus
             RSTTcp
         };
 
+        //! Counters of remote messages queue, see \c QueueLimit.
+        struct RemoteQueueStats
+        {
+            //! Messages written to the socket.
+            std::uint64_t sent = 0;
+
+            //! Messages dropped because the queue was full.
+            std::uint64_t dropped = 0;
+
+            //! Messages lost because they could not be sent.
+            std::uint64_t failed = 0;
+
+            //! Size of messages currently waiting in the queue.
+            std::size_t queuedBytes = 0;
+        };
+
       // Ctors
 #if defined (LOG4CPLUS_HAVE_SYSLOG_H)
         SysLogAppender(const tstring& ident);
@@ -110,6 +177,10 @@ namespace log4cplus
       // Methods
         virtual void close();
 
+        //! \return Counters of remote messages queue. All counters
+        //! are zero when \c QueueLimit is not set.
+        RemoteQueueStats getRemoteQueueStats () const;
+
     protected:
         virtual int getSysLogLevel(const LogLevel& ll) const;
         virtual void append(const spi::InternalLoggingEvent& event);
@@ -119,6 +190,42 @@ namespace log4cplus
 #endif
         //! Remote syslog worker function.
         void appendRemote(const spi::InternalLoggingEvent& event);
+        //! Local syslog socket (<tt>LocalSocket</tt>) worker function.
+        void appendLocalSocket(const spi::InternalLoggingEvent& event);
+
+        //! Coalesces frames of TCP remote syslog into single write.
+        virtual void appendBatch(
+            std::span<spi::InternalLoggingEvent const> events);
+
+        //! Checks connection state and triggers reconnection.
+        //! \return True if the connection is usable.
+        bool ensureRemoteConnected ();
+
+        //! Formats remote syslog message, without octet count frame
+        //! header. The returned view refers to per thread scratch
+        //! buffer; it is valid until the next formatting.
+        std::string_view formatRemote (const spi::InternalLoggingEvent& event);
+
+        //! Formats RFC3164 message for local syslog socket, see
+        //! formatRemote() for lifetime of the returned view.
+        std::string_view formatLocal (const spi::InternalLoggingEvent& event);
+
+        //! Sends each event as separate datagram, with as few system
+        //! calls as possible.
+        void appendDatagrams (std::span<spi::InternalLoggingEvent const> events);
+
+        //! Writes datagrams to local syslog socket. Reconnects once when
+        //! syslog daemon was restarted.
+        //! \return False if the write failed.
+        bool writeLocal (std::span<std::string_view const> datagrams);
+
+        //! \return Octet count frame header of TCP message.
+        static std::string frameHeader (std::string_view msg);
+
+        //! Writes data to remote syslog socket.
+        //! \return False if the write failed.
+        bool writeRemote (std::string const & data);
+        bool writeRemote (std::span<std::string_view const> data);
 
       // Data
         tstring ident;
@@ -135,10 +242,22 @@ namespace log4cplus
         bool connected;
         bool ipv6 = false;
 
+        //! Connect in the background, see <tt>AsyncConnect</tt>.
+        bool asyncConnect = true;
+
+        //! Path of local syslog socket, see <tt>LocalSocket</tt>.
+        tstring localSocket;
+        bool localRfc5424 = false;
+
+        //! Scratch buffers of appendDatagrams().
+        std::vector<std::size_t> datagramEnds;
+        std::vector<std::string_view> datagramViews;
+
         static tstring const remoteTimeFormat;
 
         void initConnector ();
         void openSocket ();
+        void openLocalSocket ();
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
         virtual thread::Mutex const & ctcGetAccessMutex () const;
@@ -149,6 +268,10 @@ namespace log4cplus
         helpers::SharedObjectPtr<helpers::ConnectorThread> connector;
 #endif
 
+        //! Queue and sender thread of remote messages; set only when
+        //! \c QueueLimit is non-zero.
+        std::unique_ptr<internal::syslog_sender> sender;
+
     private:
       // Disallow copying of instances of this class
         SysLogAppender(const SysLogAppender&);
@@ -156,6 +279,15 @@ namespace log4cplus
 
         std::string identStr;
         tstring hostname;
+
+        //! HOSTNAME and APP-NAME fields of remote message header with
+        //! separating spaces; they are the same for each message.
+        tstring remoteHeader;
+
+        //! Id of per thread cache of formatted TIMESTAMP field.
+        std::uint64_t timeCacheId = 0;
+
+        void initRemoteHeader ();
     };
 
 } // end namespace log4cplus
@@ -0,0 +1,187 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    lockprofile.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file
+ * Contention profile of log4cplus internal locks. Internal locks are
+ * associated with named LockSite instances; while profiling is enabled
+ * by setLockProfilingEnabled(), every acquisition records how long the
+ * thread waited for the lock and how long it held it.
+ */
+
+#ifndef LOG4CPLUS_THREAD_LOCKPROFILE_H
+#define LOG4CPLUS_THREAD_LOCKPROFILE_H
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/streams.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+
+namespace log4cplus {
+
+namespace thread {
+
+
+//! Snapshot of one LockSite, see getLockProfile().
+struct LockSiteProfile
+{
+    char const * name = nullptr;
+
+    //! Number of acquisitions and how many of them had to wait.
+    std::uint64_t acquisitions = 0;
+    std::uint64_t contended = 0;
+
+    //! Total and longest time spent waiting for the lock.
+    std::chrono::nanoseconds waitTime {0};
+    std::chrono::nanoseconds maxWaitTime {0};
+
+    //! Total and longest time the lock was held. Zero for locks used
+    //! with condition variables, whose hold time is not measured.
+    std::chrono::nanoseconds holdTime {0};
+    std::chrono::nanoseconds maxHoldTime {0};
+};
+
+
+//! Named lock site shared by all instances of one lock, e.g., access
+//! mutexes of all appenders. Instances have static storage duration;
+//! they are constant initialized so that locks can be used during
+//! static initialization, and they join the list reported by
+//! getLockProfile() when first acquired with profiling enabled.
+class LOG4CPLUS_EXPORT LockSite
+{
+public:
+    explicit constexpr LockSite (char const * name_)
+        : name (name_)
+    { }
+
+    LockSite (LockSite const &) = delete;
+    LockSite & operator = (LockSite const &) = delete;
+
+    char const * get_name () const { return name; }
+
+    static bool
+    is_enabled ()
+    {
+        return enabled.load (std::memory_order_relaxed);
+    }
+
+    //! Locks <code>m</code>. Returns start of hold for release(), zero
+    //! when profiling is disabled.
+    template <typename Lockable>
+    std::uint64_t
+    acquire (Lockable & m)
+    {
+        if (! is_enabled ())
+        {
+            m.lock ();
+            return 0;
+        }
+
+        if (m.try_lock ())
+            return acquired (0);
+
+        std::uint64_t const start = now ();
+        m.lock ();
+        return acquired (start);
+    }
+
+    //! Returns start of wait for acquired() for locks that cannot be
+    //! tried; every such acquisition counts as contended.
+    std::uint64_t
+    wait_start () const
+    {
+        return is_enabled () ? now () : 0;
+    }
+
+    //! Accounts an acquisition that waited since <code>wait_start</code>,
+    //! or did not wait if it is zero. Returns start of hold.
+    std::uint64_t acquired (std::uint64_t wait_start);
+
+    //! Accounts release of a lock held since <code>hold_start</code>.
+    void
+    release (std::uint64_t hold_start)
+    {
+        if (hold_start != 0)
+            released (hold_start);
+    }
+
+    LockSiteProfile get_profile () const;
+    void reset ();
+
+    //! See setLockProfilingEnabled().
+    static void set_enabled (bool);
+
+    //! Returns all registered sites, see getLockProfile().
+    static std::vector<LockSite *> get_sites ();
+
+private:
+    static std::uint64_t now ();
+    void released (std::uint64_t hold_start);
+    void register_site ();
+
+    static std::atomic<bool> enabled;
+
+    char const * const name;
+    std::atomic<bool> registered {false};
+    LockSite * next = nullptr;
+
+    std::atomic<std::uint64_t> acquisitions {0};
+    std::atomic<std::uint64_t> contended {0};
+    std::atomic<std::uint64_t> wait_ns {0};
+    std::atomic<std::uint64_t> max_wait_ns {0};
+    std::atomic<std::uint64_t> hold_ns {0};
+    std::atomic<std::uint64_t> max_hold_ns {0};
+};
+
+
+//! Enables or disables recording of lock profile. Disabled by default.
+LOG4CPLUS_EXPORT void setLockProfilingEnabled (bool enabled);
+
+//! Returns profiles of all lock sites acquired while profiling was
+//! enabled, sorted by total wait time from the longest.
+LOG4CPLUS_EXPORT std::vector<LockSiteProfile> getLockProfile ();
+
+//! Writes table of getLockProfile() to <code>os</code>.
+LOG4CPLUS_EXPORT void dumpLockProfile (tostream & os);
+
+//! Zeroes counters of all lock sites.
+LOG4CPLUS_EXPORT void resetLockProfile ();
+
+
+} } // namespace log4cplus { namespace thread {
+
+#endif // LOG4CPLUS_THREAD_LOCKPROFILE_H
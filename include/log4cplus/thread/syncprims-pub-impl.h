@@ -62,7 +62,23 @@ LOG4CPLUS_EXPORT void syncprims_throw_exception [[noreturn]] (
 
 LOG4CPLUS_INLINE_EXPORT
 Mutex::Mutex ()
-    LOG4CPLUS_THREADED (: mtx ())
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    : mtx ()
+    , site (nullptr)
+    , depth (0)
+    , hold_start (0)
+#endif
+{ }
+
+
+LOG4CPLUS_INLINE_EXPORT
+Mutex::Mutex (LockSite & LOG4CPLUS_THREADED (s))
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    : mtx ()
+    , site (&s)
+    , depth (0)
+    , hold_start (0)
+#endif
 { }
 
 
@@ -75,7 +91,12 @@ LOG4CPLUS_INLINE_EXPORT
 void
 Mutex::lock () const
 {
-    LOG4CPLUS_THREADED (mtx.lock ());
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (site)
+        profiled_lock ();
+    else
+        mtx.lock ();
+#endif
 }
 
 
@@ -83,7 +104,12 @@ LOG4CPLUS_INLINE_EXPORT
 void
 Mutex::unlock () const
 {
-    LOG4CPLUS_THREADED (mtx.unlock ());
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (site)
+        profiled_unlock ();
+    else
+        mtx.unlock ();
+#endif
 }
 
 
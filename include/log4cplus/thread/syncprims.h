@@ -31,6 +31,7 @@
 #pragma once
 #endif
 
+#include <cstdint>
 #include <mutex>
 #include <condition_variable>
 
@@ -60,10 +61,16 @@ private:
 };
 
 
+class LockSite;
+
+
 class LOG4CPLUS_EXPORT Mutex
 {
 public:
     Mutex ();
+    //! Mutex whose contention is recorded in <code>site</code>, see
+    //! log4cplus/thread/lockprofile.h.
+    explicit Mutex (LockSite & site);
     ~Mutex ();
     Mutex (Mutex const &) = delete;
     Mutex & operator = (Mutex const &) = delete;
@@ -72,7 +79,17 @@ public:
     void unlock () const;
 
 private:
-    LOG4CPLUS_THREADED (mutable std::recursive_mutex mtx;)
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    void profiled_lock () const;
+    void profiled_unlock () const;
+
+    mutable std::recursive_mutex mtx;
+    LockSite * const site;
+    //! Recursion depth and start of hold, used only by the owner when
+    //! <code>site</code> is set.
+    mutable unsigned depth;
+    mutable std::uint64_t hold_start;
+#endif
 };
 
 
@@ -32,6 +32,7 @@
 
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include <log4cplus/tstring.h>
 #include <log4cplus/helpers/pointer.h>
@@ -44,6 +45,12 @@ LOG4CPLUS_EXPORT log4cplus::tstring const & getCurrentThreadName();
 LOG4CPLUS_EXPORT log4cplus::tstring const & getCurrentThreadName2();
 LOG4CPLUS_EXPORT void setCurrentThreadName(const log4cplus::tstring & name);
 LOG4CPLUS_EXPORT void setCurrentThreadName2(const log4cplus::tstring & name);
+//! Sets the name like setCurrentThreadName() and also gives it to the
+//! system and debuggers, using pthread_setname_np() or
+//! SetThreadDescription() where available. Length limits of the system,
+//! 15 bytes on Linux, apply only to the latter.
+LOG4CPLUS_EXPORT void setCurrentThreadSystemName(
+    const log4cplus::tstring & name);
 LOG4CPLUS_EXPORT void yield();
 LOG4CPLUS_EXPORT void blockAllSignals();
 
@@ -63,6 +70,58 @@ private:
 };
 
 
+/**
+ * Placement and scheduling of threads started by log4cplus, i.e.,
+ * AsyncAppender's queue thread, thread pool workers, connector
+ * threads, configuration watch dog and flush timer.
+ */
+struct LOG4CPLUS_EXPORT BackgroundThreadSettings
+{
+    enum Policy
+    {
+        //! Keep policy and priority inherited from the starting thread.
+        POLICY_INHERIT,
+        POLICY_OTHER,
+        //! SCHED_BATCH where available.
+        POLICY_BATCH,
+        //! SCHED_IDLE where available.
+        POLICY_IDLE,
+        POLICY_FIFO,
+        POLICY_RR
+    };
+
+    //! CPUs the threads may run on. Empty keeps inherited affinity.
+    std::vector<unsigned> cpus;
+    Policy policy = POLICY_INHERIT;
+    //! Priority for POLICY_FIFO and POLICY_RR.
+    int priority = 0;
+    //! When not empty, the threads are named, see
+    //! setCurrentThreadSystemName(), by the prefix and their role, e.g.,
+    //! <code>log4cplus-pool</code>.
+    log4cplus::tstring namePrefix;
+};
+
+//! Sets settings applied to log4cplus threads started after the call.
+LOG4CPLUS_EXPORT void setBackgroundThreadSettings(
+    BackgroundThreadSettings const & settings);
+LOG4CPLUS_EXPORT BackgroundThreadSettings getBackgroundThreadSettings();
+//! Applies the settings to the calling thread. log4cplus threads call
+//! it when they start, <code>role</code> completes their name. Failures
+//! are reported through helpers::LogLog.
+LOG4CPLUS_EXPORT void applyBackgroundThreadSettings(
+    const log4cplus::tstring & role);
+
+//! \return Number of NUMA nodes, 1 where they cannot be determined.
+LOG4CPLUS_EXPORT unsigned getNumaNodeCount ();
+//! \return Index, less than getNumaNodeCount(), of NUMA node of the CPU
+//! the calling thread runs on, 0 where it cannot be determined.
+LOG4CPLUS_EXPORT unsigned getCurrentNumaNode ();
+//! Restricts the calling thread to CPUs of NUMA node with index
+//! <code>node</code>.
+//! \return <code>false</code> if it is not supported or it has failed.
+LOG4CPLUS_EXPORT bool setCurrentThreadNumaNode (unsigned node);
+
+
 #ifndef LOG4CPLUS_SINGLE_THREADED
 
 
@@ -90,6 +149,9 @@ protected:
     // Force objects to be constructed on the heap
     virtual ~AbstractThread();
 
+    //! Sets role passed to applyBackgroundThreadSettings() by start().
+    void setThreadRole (const log4cplus::tstring & role);
+
 private:
     enum Flags
     {
@@ -99,6 +161,7 @@ private:
 
     std::unique_ptr<std::thread> thread;
     mutable std::atomic<int> flags;
+    log4cplus::tstring threadRole;
 };
 
 typedef helpers::SharedObjectPtr<AbstractThread> AbstractThreadPtr;
@@ -0,0 +1,127 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    threadshardedappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_THREAD_SHARDED_APPENDER_HEADER_
+#define LOG4CPLUS_THREAD_SHARDED_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#ifndef LOG4CPLUS_SINGLE_THREADED
+
+#include <log4cplus/appender.h>
+#include <vector>
+
+
+namespace log4cplus
+{
+
+/**
+ * Spreads events over several child appenders by the thread that logs
+ * them, for outputs where order of events of different threads does
+ * not matter. Threads are numbered in order of their first event and
+ * each <tt>ThreadsPerShard</tt> consecutive threads share one child,
+ * wrapping around after the last one. The appender itself takes no
+ * lock, so only threads sharing a child contend for its lock.
+ *
+ * The children are created from the same properties. Each
+ * <tt>%shard</tt> in their <tt>File</tt> property is replaced by index
+ * of the child; when there is none, <tt>.</tt> and the index are
+ * appended, so that every child writes its own file. With
+ * <tt>Index</tt> set for RollingFileAppender children,
+ * <tt>log4cplus-merge</tt> interleaves the files, including their
+ * backups, in order of time.
+ *
+ * Filters of this appender must be set up before it is used. Threshold
+ * can be changed at any time.
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>Shards</tt></dt>
+ * <dd>Number of child appenders. Defaults to number of hardware
+ * threads.</dd>
+ *
+ * <dt><tt>ThreadsPerShard</tt></dt>
+ * <dd>Number of consecutive threads sharing a child. Defaults to 1.</dd>
+ *
+ * <dt><tt>Appender</tt></dt>
+ * <dd>Name of the factory of the children. Their properties are under
+ * the <tt>Appender.</tt> subkey.</dd>
+ * </dl>
+ */
+class LOG4CPLUS_EXPORT ThreadShardedAppender
+    : public Appender
+{
+public:
+    ThreadShardedAppender (std::vector<SharedAppenderPtr> shards,
+        unsigned threadsPerShard = 1);
+    ThreadShardedAppender (helpers::Properties const & properties);
+    virtual ~ThreadShardedAppender ();
+
+    virtual void close ();
+
+    //! Returns fields required by the children.
+    virtual unsigned getRequiredEventFields () const;
+
+    //! \return Child that receives events of the calling thread, or
+    //! null if there are no children.
+    SharedAppenderPtr getShard () const;
+
+    std::vector<SharedAppenderPtr> const & getShards () const;
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+
+    //! Index of the child for the calling thread.
+    std::size_t shardIndex () const;
+
+    //! Immutable after construction.
+    std::vector<SharedAppenderPtr> shards;
+    unsigned threadsPerShard;
+
+private:
+    ThreadShardedAppender (ThreadShardedAppender const &);
+    ThreadShardedAppender & operator = (ThreadShardedAppender const &);
+};
+
+
+typedef helpers::SharedObjectPtr<ThreadShardedAppender>
+    ThreadShardedAppenderPtr;
+
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_SINGLE_THREADED
+
+#endif // LOG4CPLUS_THREAD_SHARDED_APPENDER_HEADER_
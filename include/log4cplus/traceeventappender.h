@@ -0,0 +1,134 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    traceeventappender.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_TRACE_EVENT_APPENDER_HEADER_
+#define LOG4CPLUS_TRACE_EVENT_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/directfileappender.h>
+#include <log4cplus/layout.h>
+#include <cstdint>
+#include <unordered_set>
+
+
+namespace log4cplus
+{
+
+/**
+ * Formats events as objects of the Chrome trace event format, which
+ * Perfetto and <code>chrome://tracing</code> load, each followed by
+ * comma and new line. For example:
+ *
+ * <pre>
+ * {"name":"query","cat":"app.db","ph":"X","ts":1760531696789012.345,"dur":1234.567,"pid":4321,"tid":4325},
+ * </pre>
+ *
+ * Events with key/value field <code>duration_ns</code>, like those
+ * of LOG4CPLUS_TRACE_SCOPE(), become complete (<code>X</code>) events
+ * which end at time stamp of the event. Messages of TraceLogger
+ * starting with <code>"ENTER: "</code> and <code>"EXIT:  "</code>
+ * become begin (<code>B</code>) and end (<code>E</code>) events, the
+ * rest instant (<code>i</code>) events. The name is the message, the
+ * category is the logger name. Thread ids are the alternative thread
+ * names, see thread::getCurrentThreadName2(), when they are numeric,
+ * otherwise their hashes. The first event of every thread is preceded
+ * by metadata event naming the thread.
+ *
+ * The layout keeps track of threads it has seen; it is meant to be
+ * used by single appender, which serializes its calls.
+ *
+ * \sa TraceEventAppender
+ */
+class LOG4CPLUS_EXPORT TraceEventLayout
+    : public Layout
+{
+public:
+    TraceEventLayout ();
+    TraceEventLayout (helpers::Properties const & properties);
+    virtual ~TraceEventLayout ();
+
+    virtual void formatAndAppend (tostream & output,
+        spi::InternalLoggingEvent const & event);
+    virtual void formatAndAppend (tstring & output,
+        spi::InternalLoggingEvent const & event);
+    virtual unsigned getRequiredEventFields () const;
+
+protected:
+    //! Process id, taken when the layout is created.
+    std::int64_t processId;
+
+    //! Thread ids that have had their name written.
+    std::unordered_set<std::int64_t> namedThreads;
+
+private:
+    TraceEventLayout (TraceEventLayout const &);
+    TraceEventLayout & operator = (TraceEventLayout const &);
+};
+
+
+/**
+ * Writes trace of events in the JSON array form of the Chrome trace
+ * event format, formatted by TraceEventLayout, so that the file can
+ * be opened in Perfetto (ui.perfetto.dev) or
+ * <code>chrome://tracing</code>. Opening bracket is written when the
+ * file is empty; the closing one is optional in the format and is
+ * never written, so that the file stays valid when the process is
+ * killed and it can be appended to.
+ *
+ * The file is written by DirectFileAppender and takes all of its
+ * properties, except that the layout is always TraceEventLayout,
+ * <tt>BufferSize</tt> defaults to 64 KB and the <tt>DirectIO</tt>
+ * rollover is not supported.
+ */
+class LOG4CPLUS_EXPORT TraceEventAppender
+    : public DirectFileAppender
+{
+public:
+    TraceEventAppender (tstring const & filename, bool append = false,
+        bool createDirs = false);
+    TraceEventAppender (helpers::Properties const & properties);
+    virtual ~TraceEventAppender ();
+
+private:
+    void init ();
+
+    TraceEventAppender (TraceEventAppender const &);
+    TraceEventAppender & operator = (TraceEventAppender const &);
+};
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_TRACE_EVENT_APPENDER_HEADER_
@@ -32,6 +32,7 @@
 
 #include <log4cplus/logger.h>
 #include <log4cplus/helpers/source_location.h>
+#include <chrono>
 
 
 namespace log4cplus
@@ -93,6 +94,71 @@ private:
 };
 
 
+/**
+ * Static description of a scope traced by TraceScope. The
+ * LOG4CPLUS_TRACE_SCOPE() macro keeps one per call site.
+ */
+struct TraceScopeSite
+{
+    log4cplus::tchar const * msg;
+    log4cplus::helpers::SourceLocation location;
+};
+
+
+namespace detail
+{
+
+//! Logs exit of scope described by <code>site</code> that has been
+//! entered at <code>start</code>.
+LOG4CPLUS_EXPORT void trace_scope_exit (LoggerRef const & logger,
+    TraceScopeSite const & site,
+    std::chrono::steady_clock::time_point start);
+
+} // namespace detail
+
+
+/**
+ * This class is a cheaper alternative to TraceLogger. Whether
+ * TRACE_LOG_LEVEL is enabled for <code>logger</code> is checked only
+ * once, on entry, which otherwise only takes a time stamp. On exit,
+ * single TRACE_LOG_LEVEL event is logged with the message of the site
+ * and with key/value field <code>duration_ns</code> holding time
+ * spent in the scope, in nanoseconds.
+ * <p>
+ * The logger is not owned. It has to outlive the scope, which loggers
+ * kept by their hierarchy do.
+ * <p>
+ * @see LOG4CPLUS_TRACE_SCOPE
+ */
+class TraceScope
+{
+public:
+    TraceScope (LoggerRef l, TraceScopeSite const & s)
+        : logger (l), site (s), enabled (l.isEnabledFor (TRACE_LOG_LEVEL))
+    {
+        if (LOG4CPLUS_UNLIKELY (enabled))
+            start = std::chrono::steady_clock::now ();
+    }
+
+    ~TraceScope ()
+    {
+        if (LOG4CPLUS_UNLIKELY (enabled))
+            detail::trace_scope_exit (logger, site, start);
+    }
+
+    TraceScope (TraceScope const &) = delete;
+    TraceScope (TraceScope &&) = delete;
+    TraceScope & operator = (TraceScope const &) = delete;
+    TraceScope & operator = (TraceScope &&) = delete;
+
+private:
+    LoggerRef logger;
+    TraceScopeSite const & site;
+    std::chrono::steady_clock::time_point start;
+    bool enabled;
+};
+
+
 } // log4cplus
 
 
@@ -34,6 +34,7 @@
 #if defined(_WIN32) && defined (LOG4CPLUS_HAVE_WIN32_CONSOLE)
 
 #include <log4cplus/appender.h>
+#include <log4cplus/helpers/timehelper.h>
 
 
 namespace log4cplus
@@ -58,6 +59,32 @@ namespace log4cplus
     * <dd>See MSDN documentation for
     * <a href="http://msdn.microsoft.com/en-us/library/windows/desktop/ms682088(v=vs.85).aspx#_win32_character_attributes">
     * Character Attributes</a>.
+    *
+    * <dt><tt>Buffered</tt></dt>
+    * <dd>When it is set true, formatted events are collected in a
+    * buffer of the appender and written by one
+    * <code>WriteConsole()</code> call, with the text attributes set
+    * once around it, when <tt>BufferSize</tt> characters are
+    * buffered, at the latest after <tt>FlushIntervalMs</tt>, and once
+    * per batch of <tt>AsyncAppend</tt>. The console handle, its type
+    * and the original text attributes are looked up once.</dd>
+    *
+    * <dt><tt>BufferSize</tt></dt>
+    * <dd>Size of the <tt>Buffered</tt> buffer, in characters. Defaults
+    * to 64 K.</dd>
+    *
+    * <dt><tt>FlushIntervalMs</tt></dt>
+    * <dd>Longest time, in milliseconds, an event may wait in the
+    * <tt>Buffered</tt> buffer. Defaults to 100. Zero leaves the events
+    * in the buffer until it is full or the appender is closed.</dd>
+    *
+    * <dt><tt>VirtualTerminal</tt></dt>
+    * <dd>When it is set true together with <tt>Buffered</tt>, the
+    * console is switched to virtual terminal processing and
+    * <tt>TextColor</tt> is expressed by escape sequences inside the
+    * written text instead of <code>SetConsoleTextAttribute()</code>
+    * calls. Consoles without virtual terminal support fall back to
+    * the attribute calls.</dd>
     * </dl>
     */
     class LOG4CPLUS_EXPORT Win32ConsoleAppender
@@ -73,15 +100,53 @@ namespace log4cplus
 
     protected:
         virtual void append (spi::InternalLoggingEvent const &);
+        virtual void appendBatch (
+            std::span<spi::InternalLoggingEvent const> events);
 
         void write_handle (void *, tchar const *, std::size_t);
         void write_console (void *, tchar const *, std::size_t);
 
+        //! Writes characters by <code>WriteConsole()</code> in chunks it
+        //! accepts, without touching the text attributes.
+        void write_console_chars (void *, tchar const *, std::size_t);
+
+        //! Looks up the output of the <tt>Buffered</tt> mode.
+        void init_buffered_output ();
+
+        //! Writes <code>buffer</code> to the output and clears it.
+        void flush_buffer ();
+
         bool alloc_console;
         bool log_to_std_err;
         unsigned int text_color;
 
+        bool buffered;
+        bool virtual_terminal;
+        unsigned long buffer_size;
+        unsigned long flush_interval;
+
+        //! Formatted events waiting to be written.
+        tstring buffer;
+
+        //! Output handle looked up by init_buffered_output().
+        void * output_handle;
+        bool output_ready;
+        bool output_is_console;
+
+        //! Virtual terminal processing has been enabled.
+        bool vt_enabled;
+
+        //! Text attributes of the console before the first write.
+        unsigned short original_attributes;
+
     private:
+        void timed_flush ();
+
+        bool flush_timer_registered;
+
+        //! Time of the last write, used when there is no timer thread.
+        helpers::Time last_write;
+
         Win32ConsoleAppender (Win32ConsoleAppender const &);
         Win32ConsoleAppender & operator = (Win32ConsoleAppender const &);
     };
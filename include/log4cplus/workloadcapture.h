@@ -0,0 +1,172 @@
+// -*- C++ -*-
+// Module:  Log4cplus
+// File:    workloadcapture.h
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+/** @file
+ * This header defines capture of the shape of logging workload: which
+ * loggers log at which levels, how often, from how many threads and
+ * how big the messages, NDC and MDC are. Contents of the messages are
+ * not captured. The replaybench benchmark regenerates the workload
+ * against any configuration. */
+
+#ifndef LOG4CPLUS_WORKLOAD_CAPTURE_HEADER_
+#define LOG4CPLUS_WORKLOAD_CAPTURE_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/appender.h>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace log4cplus
+{
+
+//! Shape of a captured event.
+struct WorkloadEvent
+{
+    //! Microseconds since the first captured event.
+    std::int64_t time;
+
+    LogLevel level;
+
+    //! Index of the logger in WorkloadCaptureReader::getLoggers().
+    std::uint32_t logger;
+
+    //! Index of the thread; threads are numbered from zero in order of
+    //! their first events.
+    std::uint32_t thread;
+
+    //! Sizes are in characters.
+    std::uint32_t messageSize;
+    std::uint32_t ndcSize;
+
+    //! Number of MDC entries and size of their keys and values.
+    std::uint32_t mdcCount;
+    std::uint32_t mdcSize;
+};
+
+
+/**
+ * Records shapes of events, see WorkloadEvent, into a compact file.
+ * Names of loggers are recorded once, events take a few bytes each.
+ * Layout is not used.
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>File</tt></dt>
+ * <dd>This property specifies output file name. The file is
+ * truncated when it is opened.</dd>
+ *
+ * <dt><tt>CreateDirs</tt></dt>
+ * <dd>Set this property to <tt>true</tt> if you want to create
+ * missing directories in path leading to the file.</dd>
+ * </dl>
+ */
+class LOG4CPLUS_EXPORT WorkloadCaptureAppender
+    : public Appender
+{
+public:
+    WorkloadCaptureAppender (tstring const & filename,
+        bool createDirs = false);
+    WorkloadCaptureAppender (helpers::Properties const & properties);
+    virtual ~WorkloadCaptureAppender ();
+
+    virtual void close ();
+
+    //! Thread name, NDC and MDC are measured.
+    virtual unsigned getRequiredEventFields () const;
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const & event);
+
+    void open ();
+
+    tstring filename;
+    bool createDirs;
+    std::ofstream out;
+
+    //! Indices of loggers and threads.
+    std::map<tstring, std::uint32_t, std::less<>> loggers;
+    std::map<tstring, std::uint32_t, std::less<>> threads;
+
+    //! Time stamp, in microseconds since epoch, of the previous event.
+    std::int64_t previousTime;
+
+    //! Record being written.
+    std::string record;
+
+private:
+    WorkloadCaptureAppender (WorkloadCaptureAppender const &);
+    WorkloadCaptureAppender & operator = (WorkloadCaptureAppender const &);
+};
+
+
+/**
+ * Reads file written by WorkloadCaptureAppender.
+ */
+class LOG4CPLUS_EXPORT WorkloadCaptureReader
+{
+public:
+    /**
+     * Reads all events of file <code>name</code>. A record cut short,
+     * e.g., by a crash, ends the file.
+     *
+     * @throws std::runtime_error if the file cannot be opened or if it
+     * is malformed.
+     */
+    explicit WorkloadCaptureReader (tstring const & name);
+
+    //! \returns Time stamp of the first event.
+    helpers::Time getStart () const { return start; }
+
+    std::vector<tstring> const & getLoggers () const { return loggers; }
+    std::vector<WorkloadEvent> const & getEvents () const { return events; }
+
+    //! \returns Number of distinct threads.
+    std::uint32_t getThreadCount () const { return threadCount; }
+
+private:
+    helpers::Time start;
+    std::vector<tstring> loggers;
+    std::vector<WorkloadEvent> events;
+    std::uint32_t threadCount;
+};
+
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_WORKLOAD_CAPTURE_HEADER_
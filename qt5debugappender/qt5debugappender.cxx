@@ -33,9 +33,16 @@
 #include <log4cplus/helpers/property.h>
 #include <log4cplus/spi/factory.h>
 #include <log4cplus/spi/loggingevent.h>
+#include <atomic>
 #include <sstream>
 #include <iomanip>
+#include <string>
 #include <QtGlobal>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QObject>
+#include <QThread>
+#include <QTimer>
 #include <log4cplus/config/windowsh-inc.h>
 
 
@@ -44,14 +51,175 @@ namespace log4cplus
 {
 
 
+namespace
+{
+
+//! Event formatted by the logging thread.
+struct QueuedMessage
+{
+    LogLevel ll;
+    std::string message;
+    std::string file;
+    std::string function;
+    std::string logger;
+    int line;
+    QueuedMessage * next;
+};
+
+
+void
+output_message (QueuedMessage const & msg)
+{
+    QMessageLogger qlogger (msg.file.c_str (), msg.line,
+        msg.function.c_str (), msg.logger.c_str ());
+    void (QMessageLogger:: * log_func) (const char *, ...) const = 0;
+
+    if (msg.ll >= ERROR_LOG_LEVEL)
+        log_func = &QMessageLogger::critical;
+    else if (msg.ll >= WARN_LOG_LEVEL)
+        log_func = &QMessageLogger::warning;
+    else
+        log_func = &QMessageLogger::debug;
+
+    (qlogger.*log_func) ("%s", msg.message.c_str ());
+}
+
+
+void
+fill_message (QueuedMessage & msg, spi::InternalLoggingEvent const & ev,
+    tstring const & formatted)
+{
+    msg.ll = ev.getLogLevel ();
+    msg.message = LOG4CPLUS_TSTRING_TO_STRING (formatted);
+    msg.file = LOG4CPLUS_TSTRING_TO_STRING (ev.getFile ());
+    msg.function = LOG4CPLUS_TSTRING_TO_STRING (ev.getFunction ());
+    msg.logger = LOG4CPLUS_TSTRING_TO_STRING (ev.getLoggerName ());
+    msg.line = ev.getLine ();
+    msg.next = nullptr;
+}
+
+
+QEvent::Type const drain_event_type
+    = static_cast<QEvent::Type> (QEvent::registerEventType ());
+
+} // namespace
+
+
+//! Lock-free stack of messages pushed by logging threads. The target
+//! thread takes all of them at once and reverses them.
+struct Qt5DebugAppender::Queue
+{
+    ~Queue ()
+    {
+        drain (false);
+    }
+
+    //! \return <code>true</code> if the target thread has to be
+    //! notified.
+    bool
+    push (QueuedMessage * msg)
+    {
+        msg->next = head.load (std::memory_order_relaxed);
+        while (! head.compare_exchange_weak (msg->next, msg,
+            std::memory_order_release, std::memory_order_relaxed))
+            ;
+
+        return ! scheduled.exchange (true, std::memory_order_acq_rel);
+    }
+
+    void
+    drain (bool output)
+    {
+        // Messages pushed after this store schedule another drain.
+        scheduled.store (false, std::memory_order_release);
+        QueuedMessage * msg = head.exchange (nullptr,
+            std::memory_order_acquire);
+
+        QueuedMessage * ordered = nullptr;
+        while (msg)
+        {
+            QueuedMessage * next = msg->next;
+            msg->next = ordered;
+            ordered = msg;
+            msg = next;
+        }
+
+        while (ordered)
+        {
+            QueuedMessage * next = ordered->next;
+            if (output)
+                output_message (*ordered);
+            delete ordered;
+            ordered = next;
+        }
+    }
+
+    std::atomic<QueuedMessage *> head{nullptr};
+    std::atomic<bool> scheduled{false};
+};
+
+
+namespace
+{
+
+//! Lives in the target thread. Drains the queue when it receives
+//! the drain event, possibly after collecting events for the drain
+//! interval.
+class DrainReceiver
+    : public QObject
+{
+public:
+    DrainReceiver (std::shared_ptr<Qt5DebugAppender::Queue> q,
+        unsigned interval)
+        : queue (std::move (q))
+        , drainInterval (static_cast<int> (interval))
+    { }
+
+    virtual bool
+    event (QEvent * ev)
+    {
+        if (ev->type () != drain_event_type)
+            return QObject::event (ev);
+
+        if (drainInterval == 0)
+            queue->drain (true);
+        else
+        {
+            std::shared_ptr<Qt5DebugAppender::Queue> q (queue);
+            QTimer::singleShot (drainInterval, this,
+                [q] { q->drain (true); });
+        }
+
+        return true;
+    }
+
+private:
+    std::shared_ptr<Qt5DebugAppender::Queue> queue;
+    int drainInterval;
+};
+
+} // namespace
+
+
 Qt5DebugAppender::Qt5DebugAppender ()
     : Appender ()
+    , queued (false)
+    , drainInterval (0)
+    , targetThread (nullptr)
+    , receiver (nullptr)
 { }
 
 
 Qt5DebugAppender::Qt5DebugAppender (helpers::Properties const & props)
     : Appender (props)
-{ }
+    , queued (false)
+    , drainInterval (0)
+    , targetThread (nullptr)
+    , receiver (nullptr)
+{
+    props.getBool (queued, LOG4CPLUS_TEXT ("Queued"));
+    props.getUInt (drainInterval, LOG4CPLUS_TEXT ("DrainInterval"));
+}
 
 
 Qt5DebugAppender::~Qt5DebugAppender ()
@@ -62,36 +230,60 @@ Qt5DebugAppender::~Qt5DebugAppender ()
 
 void
 Qt5DebugAppender::close ()
-{ }
+{
+    if (receiver)
+    {
+        // Deleting the receiver cancels its pending drain; the queued
+        // events are passed to Qt below.
+        receiver->deleteLater ();
+        receiver = nullptr;
+    }
+
+    if (queue)
+        queue->drain (true);
+}
+
+
+void
+Qt5DebugAppender::setTargetThread (QThread * thread)
+{
+    targetThread = thread;
+}
 
 
 void
 Qt5DebugAppender::append (spi::InternalLoggingEvent const & ev)
 {
-    // TODO: Expose log4cplus' internal TLS to use here.
-    tostringstream oss;    
-    layout->formatAndAppend(oss, ev);
-
-    LogLevel const ll = ev.getLogLevel ();
-    std::string const & file = LOG4CPLUS_TSTRING_TO_STRING (ev.getFile ());
-    std::string const & func = LOG4CPLUS_TSTRING_TO_STRING (ev.getFunction ());
-    std::string const & logger
-        = LOG4CPLUS_TSTRING_TO_STRING (ev.getLoggerName ());
-    int const line = ev.getLine ();
-
-    QMessageLogger qlogger (file.c_str (), line, func.c_str (),
-        logger.c_str ());
-    void (QMessageLogger:: * log_func) (const char *, ...) const = 0;
+    tstring const & formatted = formatEvent (ev);
 
-    if (ll >= ERROR_LOG_LEVEL)
-        log_func = &QMessageLogger::critical;
-    else if (ll >= WARN_LOG_LEVEL)
-        log_func = &QMessageLogger::warning;
-    else
-        log_func = &QMessageLogger::debug;
-    
-    (qlogger.*log_func) ("%s",
-        LOG4CPLUS_TSTRING_TO_STRING (oss.str ()).c_str ());
+    if (queued && ! receiver)
+    {
+        QThread * thread = targetThread;
+        if (! thread && QCoreApplication::instance ())
+            thread = QCoreApplication::instance ()->thread ();
+
+        // Without an application object there is no event loop to
+        // drain the queue yet.
+        if (thread)
+        {
+            queue = std::make_shared<Queue> ();
+            receiver = new DrainReceiver (queue, drainInterval);
+            receiver->moveToThread (thread);
+        }
+    }
+
+    if (! receiver)
+    {
+        QueuedMessage msg;
+        fill_message (msg, ev, formatted);
+        output_message (msg);
+        return;
+    }
+
+    QueuedMessage * msg = new QueuedMessage;
+    fill_message (*msg, ev, formatted);
+    if (queue->push (msg))
+        QCoreApplication::postEvent (receiver, new QEvent (drain_event_type));
 }
 
 
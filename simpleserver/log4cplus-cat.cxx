@@ -0,0 +1,358 @@
+// Module:  Log4cplus
+// File:    log4cplus-cat.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Prints events of a time range from files written by
+// RollingFileAppender or TimeBasedRollingFileAppender. With Index=true
+// the range is found through the index of each file instead of
+// scanning the file from its start. Files written by
+// ColumnarFileAppender are recognized by their header; blocks outside
+// of the range are skipped by their statistics.
+
+#include <log4cplus/columnarlog.h>
+#include <log4cplus/initializer.h>
+#include <log4cplus/layout.h>
+#include <log4cplus/logreader.h>
+#include <log4cplus/loglevel.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace
+{
+
+using log4cplus::helpers::Time;
+
+
+//! Parses seconds since epoch, or local time as
+//! <tt>YYYY-MM-DD[ T]HH:MM:SS</tt>, both with optional fraction of
+//! second.
+bool
+parse_time (char const * str, Time & time)
+{
+    std::string_view s (str);
+    std::string_view fraction;
+    std::size_t const dot = s.find ('.');
+    if (dot != std::string_view::npos)
+    {
+        fraction = s.substr (dot + 1);
+        s = s.substr (0, dot);
+    }
+
+    long long micros = 0;
+    long long scale = 1000000;
+    for (char c : fraction)
+    {
+        if (! std::isdigit (static_cast<unsigned char> (c)))
+            return false;
+        scale /= 10;
+        micros += (c - '0') * scale;
+    }
+
+    if (! s.empty ()
+        && s.find_first_not_of ("0123456789") == std::string_view::npos)
+    {
+        time = log4cplus::helpers::from_time_t (
+            static_cast<std::time_t> (std::atoll (std::string (s).c_str ())));
+    }
+    else
+    {
+        std::tm t = std::tm ();
+        char sep = 0;
+        char rest = 0;
+        if (std::sscanf (std::string (s).c_str (),
+                "%4d-%2d-%2d%c%2d:%2d:%2d%c", &t.tm_year, &t.tm_mon,
+                &t.tm_mday, &sep, &t.tm_hour, &t.tm_min, &t.tm_sec,
+                &rest) != 7
+            || (sep != ' ' && sep != 'T'))
+            return false;
+
+        t.tm_year -= 1900;
+        t.tm_mon -= 1;
+        t.tm_isdst = -1;
+        time = log4cplus::helpers::from_struct_tm (&t);
+    }
+
+    time += std::chrono::microseconds (micros);
+    return true;
+}
+
+
+struct level_name
+{
+    std::string name;
+    log4cplus::LogLevel level;
+};
+
+
+//! \returns Level named by the first word of <code>line</code> that
+//! is a name of a level, <code>NOT_SET_LOG_LEVEL</code> if there is
+//! none.
+log4cplus::LogLevel
+find_level (std::string_view line, std::vector<level_name> const & names)
+{
+    auto const is_word_char = [] (char c)
+    { return std::isalnum (static_cast<unsigned char> (c)) || c == '_'; };
+
+    for (std::size_t i = 0; i != line.size (); )
+    {
+        if (! is_word_char (line[i]))
+        {
+            ++i;
+            continue;
+        }
+
+        std::size_t end = i;
+        while (end != line.size () && is_word_char (line[end]))
+            ++end;
+
+        std::string_view const word = line.substr (i, end - i);
+        for (level_name const & n : names)
+            if (word == n.name)
+                return n.level;
+
+        i = end;
+    }
+
+    return log4cplus::NOT_SET_LOG_LEVEL;
+}
+
+
+//! \returns True if <code>name</code> is <code>logger</code> or one of
+//! its descendants.
+bool
+logger_matches (log4cplus::tstring const & name,
+    log4cplus::tstring const & logger)
+{
+    return name.compare (0, logger.size (), logger) == 0
+        && (name.size () == logger.size ()
+            || name[logger.size ()] == LOG4CPLUS_TEXT ('.'));
+}
+
+
+//! Prints events of columnar log <code>file</code>. Only time stamp,
+//! level and logger columns of blocks within the range are read, the
+//! other columns are read for blocks with matching events.
+void
+print_columnar (log4cplus::tstring const & file, Time since, Time until,
+    log4cplus::LogLevel threshold, log4cplus::tstring const & logger)
+{
+    log4cplus::PatternLayout layout (LOG4CPLUS_TEXT (
+        "%D{%Y-%m-%d %H:%M:%S.%q} [%t] %-5p %c - %m%n"));
+    log4cplus::ColumnarLogReader reader (file);
+    log4cplus::ColumnarLogReader::Rows rows;
+    std::vector<std::size_t> matches;
+    log4cplus::tstring line;
+    for (auto const & block : reader.getBlocks ())
+    {
+        if (block.maxTime < since || block.minTime > until
+            || block.maxLevel < threshold)
+            continue;
+
+        reader.read (block, log4cplus::COLUMNAR_TIMESTAMP
+            | log4cplus::COLUMNAR_LEVEL
+            | (logger.empty () ? 0u : log4cplus::COLUMNAR_LOGGER), rows);
+        matches.clear ();
+        for (std::size_t i = 0; i != block.events; ++i)
+            if (rows.timestamps[i] >= since && rows.timestamps[i] <= until
+                && rows.levels[i] >= threshold
+                && (logger.empty ()
+                    || logger_matches (rows.loggers[i], logger)))
+                matches.push_back (i);
+
+        if (matches.empty ())
+            continue;
+
+        reader.read (block, log4cplus::COLUMNAR_ALL, rows);
+        for (std::size_t i : matches)
+        {
+            log4cplus::MappedDiagnosticContextMap mdc;
+            for (auto const & column : rows.mdc)
+                if (! column.second[i].empty ())
+                    mdc[column.first] = column.second[i];
+
+            log4cplus::spi::InternalLoggingEvent const event (
+                rows.loggers[i], rows.levels[i], log4cplus::tstring_view (),
+                mdc, rows.messages[i], rows.threads[i],
+                log4cplus::tstring_view (), rows.timestamps[i],
+                log4cplus::tstring_view (), -1);
+            line.clear ();
+            layout.formatAndAppend (line, event);
+            std::cout << LOG4CPLUS_TSTRING_TO_STRING (line);
+        }
+    }
+}
+
+
+void
+usage (char const * name)
+{
+    std::cerr << "Usage: " << name
+        << " [--since <time>] [--until <time>] [--level <level>]"
+        " [--logger <logger>] <file>...\n"
+        "Time is seconds since epoch or local YYYY-MM-DD HH:MM:SS, both"
+        " with optional fraction.\n"
+        "Logger selects the logger and its descendants in columnar"
+        " logs.\n";
+}
+
+} // namespace
+
+
+int
+main (int argc, char * argv[])
+{
+    log4cplus::Initializer initializer;
+
+    Time since = Time::min ();
+    Time until = Time::max ();
+    log4cplus::LogLevel threshold = log4cplus::NOT_SET_LOG_LEVEL;
+    log4cplus::tstring logger;
+    std::vector<char const *> files;
+    for (int i = 1; i != argc; ++i)
+    {
+        bool const has_value = i + 1 != argc;
+        if (std::strcmp (argv[i], "--since") == 0 && has_value)
+        {
+            if (! parse_time (argv[++i], since))
+            {
+                std::cerr << "Invalid time: " << argv[i] << '\n';
+                return EXIT_FAILURE;
+            }
+        }
+        else if (std::strcmp (argv[i], "--until") == 0 && has_value)
+        {
+            if (! parse_time (argv[++i], until))
+            {
+                std::cerr << "Invalid time: " << argv[i] << '\n';
+                return EXIT_FAILURE;
+            }
+        }
+        else if (std::strcmp (argv[i], "--level") == 0 && has_value)
+        {
+            threshold = log4cplus::getLogLevelManager ().fromString (
+                LOG4CPLUS_C_STR_TO_TSTRING (argv[++i]));
+            if (threshold == log4cplus::NOT_SET_LOG_LEVEL)
+            {
+                std::cerr << "Unknown level: " << argv[i] << '\n';
+                return EXIT_FAILURE;
+            }
+        }
+        else if (std::strcmp (argv[i], "--logger") == 0 && has_value)
+            logger = LOG4CPLUS_C_STR_TO_TSTRING (argv[++i]);
+        else if (argv[i][0] == '-' && argv[i][1] == '-')
+        {
+            usage (argv[0]);
+            return EXIT_FAILURE;
+        }
+        else
+            files.push_back (argv[i]);
+    }
+
+    if (files.empty ())
+    {
+        usage (argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<level_name> names;
+    for (log4cplus::LogLevel ll : {log4cplus::TRACE_LOG_LEVEL,
+            log4cplus::DEBUG_LOG_LEVEL, log4cplus::INFO_LOG_LEVEL,
+            log4cplus::WARN_LOG_LEVEL, log4cplus::ERROR_LOG_LEVEL,
+            log4cplus::FATAL_LOG_LEVEL})
+        names.push_back (level_name {LOG4CPLUS_TSTRING_TO_STRING (
+            log4cplus::getLogLevelManager ().toString (ll)), ll});
+
+    for (char const * file : files)
+    {
+        try
+        {
+            log4cplus::tstring const name (LOG4CPLUS_C_STR_TO_TSTRING (file));
+            if (log4cplus::ColumnarLogReader::isColumnarLog (name))
+            {
+                print_columnar (name, since, until, threshold, logger);
+                continue;
+            }
+
+            log4cplus::IndexedLogReader reader (name);
+            std::string_view const contents = reader.contents ();
+            std::size_t const begin = reader.seek (since);
+            std::size_t const end = since <= until
+                ? (std::max) (begin, reader.seekEnd (until))
+                : begin;
+            std::string_view const range
+                = contents.substr (begin, end - begin);
+
+            if (threshold == log4cplus::NOT_SET_LOG_LEVEL)
+            {
+                std::cout.write (range.data (),
+                    static_cast<std::streamsize> (range.size ()));
+                continue;
+            }
+
+            // Lines without level, e.g., continuation of multi-line
+            // messages, go with the preceding line.
+            bool print = false;
+            for (std::size_t pos = 0; pos != range.size (); )
+            {
+                std::size_t eol = range.find ('\n', pos);
+                eol = eol == std::string_view::npos
+                    ? range.size () : eol + 1;
+                std::string_view const line = range.substr (pos, eol - pos);
+                log4cplus::LogLevel const ll = find_level (line, names);
+                if (ll != log4cplus::NOT_SET_LOG_LEVEL)
+                    print = ll >= threshold;
+                if (print)
+                    std::cout.write (line.data (),
+                        static_cast<std::streamsize> (line.size ()));
+                pos = eol;
+            }
+        }
+        catch (std::exception const & e)
+        {
+            std::cout.flush ();
+            std::cerr << e.what () << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout.flush ();
+    return std::cout ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,87 @@
+// Module:  Log4cplus
+// File:    log4cplus-decode.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Decodes files written by BinaryFileAppender into text.
+
+#include <log4cplus/binarylog.h>
+#include <log4cplus/initializer.h>
+#include <log4cplus/layout.h>
+#include <log4cplus/streams.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+
+
+int
+main (int argc, char * argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <file> [pattern]\n";
+        return EXIT_FAILURE;
+    }
+
+    log4cplus::Initializer initializer;
+
+    std::ifstream in (argv[1], std::ios_base::in | std::ios_base::binary);
+    if (! in)
+    {
+        std::cerr << "Unable to open file: " << argv[1] << '\n';
+        return EXIT_FAILURE;
+    }
+
+    log4cplus::tstring const pattern = argc > 2
+        ? LOG4CPLUS_C_STR_TO_TSTRING (argv[2])
+        : log4cplus::tstring (LOG4CPLUS_TEXT (
+            "%D{%Y-%m-%d %H:%M:%S.%q} [%t] %-5p %c - %m%n"));
+    log4cplus::PatternLayout layout (pattern);
+
+    log4cplus::BinaryLogReader reader (in);
+    log4cplus::spi::InternalLoggingEvent event;
+    log4cplus::tstring line;
+    try
+    {
+        while (reader.read (event))
+        {
+            line.clear ();
+            layout.formatAndAppend (line, event);
+            log4cplus::tcout << line;
+        }
+    }
+    catch (std::exception const & e)
+    {
+        log4cplus::tcout.flush ();
+        std::cerr << e.what () << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
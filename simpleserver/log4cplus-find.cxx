@@ -0,0 +1,189 @@
+// Module:  Log4cplus
+// File:    log4cplus-find.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Finds events with given MDC value in files written by
+// RollingFileAppender with BloomKeys set. Bloom filters of the files
+// are checked first and only files which can contain the value are
+// read. Files without a filter are always read.
+
+#include <log4cplus/initializer.h>
+#include <log4cplus/helpers/bloomfilter.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace
+{
+
+bool
+ends_with (std::string_view str, std::string_view suffix)
+{
+    return str.size () >= suffix.size ()
+        && str.compare (str.size () - suffix.size (), suffix.size (),
+            suffix) == 0;
+}
+
+
+//! Arguments are taken as UTF-8, the encoding values are hashed in.
+log4cplus::tstring
+from_utf8 (std::string const & str)
+{
+#if defined (UNICODE)
+    std::wstring result;
+    log4cplus::helpers::appendFromUtf8 (result, str);
+    return result;
+#else
+    return str;
+#endif
+}
+
+
+bool
+is_compressed (std::string_view name)
+{
+    return ends_with (name, ".gz") || ends_with (name, ".zst");
+}
+
+
+//! Loads filter of file <code>name</code>. Filter of compressed backup
+//! is named after the backup before its compression.
+bool
+load_filter (log4cplus::helpers::BloomFilter & filter,
+    std::string const & name)
+{
+    if (filter.load (LOG4CPLUS_C_STR_TO_TSTRING (name + ".bloom")))
+        return true;
+
+    if (! is_compressed (name))
+        return false;
+
+    std::string const base = name.substr (0, name.rfind ('.'));
+    return filter.load (LOG4CPLUS_C_STR_TO_TSTRING (base + ".bloom"));
+}
+
+
+//! Prints lines of file <code>name</code> containing
+//! <code>value</code>.
+//! \return Number of printed lines.
+std::size_t
+print_matches (std::string const & name, std::string const & value,
+    bool prefix)
+{
+    std::ifstream in (name, std::ios_base::binary);
+    if (! in)
+    {
+        std::cerr << "Unable to open file: " << name << '\n';
+        return 0;
+    }
+
+    std::size_t count = 0;
+    std::string line;
+    while (std::getline (in, line))
+        if (line.find (value) != std::string::npos)
+        {
+            if (prefix)
+                std::cout << name << ':';
+            std::cout << line << '\n';
+            ++count;
+        }
+
+    return count;
+}
+
+} // namespace
+
+
+int
+main (int argc, char * argv[])
+{
+    int arg = 1;
+    bool const list = arg < argc && std::strcmp (argv[arg], "-l") == 0;
+    if (list)
+        ++arg;
+
+    char const * const eq = arg < argc ? std::strchr (argv[arg], '=') : 0;
+    if (! eq || eq == argv[arg] || arg + 1 >= argc)
+    {
+        std::cerr << "Usage: " << argv[0]
+            << " [-l] <key>=<value> <file>...\n"
+            << "  -l  only list files which can contain the value\n";
+        return EXIT_FAILURE;
+    }
+
+    log4cplus::Initializer initializer;
+
+    std::string const key (argv[arg],
+        static_cast<std::size_t> (eq - argv[arg]));
+    std::string const value (eq + 1);
+    log4cplus::tstring const tkey = from_utf8 (key);
+    log4cplus::tstring const tvalue = from_utf8 (value);
+    ++arg;
+
+    std::vector<std::string> candidates;
+    std::size_t skipped = 0;
+    for (; arg != argc; ++arg)
+    {
+        std::string const name (argv[arg]);
+        if (ends_with (name, ".bloom") || ends_with (name, ".idx"))
+            continue;
+
+        log4cplus::helpers::BloomFilter filter;
+        if (load_filter (filter, name) && ! filter.mightContain (tkey, tvalue))
+            ++skipped;
+        else
+            candidates.push_back (name);
+    }
+
+    std::cerr << candidates.size () << " candidate file(s), " << skipped
+        << " skipped by Bloom filter\n";
+
+    std::size_t found = 0;
+    for (std::string const & name : candidates)
+    {
+        if (list)
+        {
+            std::cout << name << '\n';
+            ++found;
+        }
+        else if (is_compressed (name))
+            std::cerr << name << ": compressed; decompress it to search it\n";
+        else
+            found += print_matches (name, value,
+                skipped + candidates.size () > 1);
+    }
+
+    std::cout.flush ();
+    return found != 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
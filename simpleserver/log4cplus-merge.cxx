@@ -0,0 +1,160 @@
+// Module:  Log4cplus
+// File:    log4cplus-merge.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Merges files written by RollingFileAppender with Index=true, e.g., by
+// several processes through %pid in file name, into one stream ordered
+// by time stamps of the events. Files without index are merged by time
+// stamps at starts of their lines in the format given by --date-format.
+
+#include <log4cplus/initializer.h>
+#include <log4cplus/logreader.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace
+{
+
+//! Collects output into large writes; runs of events merged from one
+//! file are typically much shorter than a disk block.
+class output_buffer
+{
+public:
+    output_buffer ()
+        : failed (false)
+    {
+        buffer.reserve (capacity);
+    }
+
+    void
+    write (std::string_view data)
+    {
+        if (buffer.size () + data.size () > capacity)
+        {
+            flush ();
+            if (data.size () >= capacity)
+            {
+                write_out (data);
+                return;
+            }
+        }
+
+        buffer.append (data);
+    }
+
+    bool
+    flush ()
+    {
+        write_out (buffer);
+        buffer.clear ();
+        return ! failed && std::fflush (stdout) == 0;
+    }
+
+private:
+    static std::size_t const capacity = 1024 * 1024;
+
+    void
+    write_out (std::string_view data)
+    {
+        if (! data.empty ()
+            && std::fwrite (data.data (), 1, data.size (), stdout)
+                != data.size ())
+            failed = true;
+    }
+
+    std::string buffer;
+    bool failed;
+};
+
+
+void
+usage (char const * name)
+{
+    std::cerr << "Usage: " << name << " [--date-format <format>] <file>...\n"
+        "Files without index are merged by time stamps at starts of their"
+        " lines,\n"
+        "e.g., --date-format \"%Y-%m-%d %H:%M:%S,%q\" for PatternLayout"
+        " with\n"
+        "%D{%Y-%m-%d %H:%M:%S,%q} at its start.\n";
+}
+
+} // namespace
+
+
+int
+main (int argc, char * argv[])
+{
+    log4cplus::Initializer initializer;
+
+    char const * date_format = "";
+    std::vector<char const *> files;
+    for (int i = 1; i != argc; ++i)
+    {
+        if (std::strcmp (argv[i], "--date-format") == 0 && i + 1 != argc)
+            date_format = argv[++i];
+        else if (argv[i][0] == '-' && argv[i][1] == '-')
+        {
+            usage (argv[0]);
+            return EXIT_FAILURE;
+        }
+        else
+            files.push_back (argv[i]);
+    }
+
+    if (files.empty ())
+    {
+        usage (argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    output_buffer out;
+    try
+    {
+        log4cplus::LogMerger merger (
+            LOG4CPLUS_C_STR_TO_TSTRING (date_format));
+        for (char const * file : files)
+            merger.addFile (LOG4CPLUS_C_STR_TO_TSTRING (file));
+
+        merger.merge ([&out] (std::string_view part) { out.write (part); });
+    }
+    catch (std::exception const & e)
+    {
+        out.flush ();
+        std::cerr << e.what () << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return out.flush () ? EXIT_SUCCESS : EXIT_FAILURE;
+}
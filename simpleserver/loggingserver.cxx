@@ -18,17 +18,66 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <log4cplus/config.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <iostream>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <log4cplus/configurator.h>
 #include <log4cplus/socketappender.h>
+#include <log4cplus/shmtransportappender.h>
 #include <log4cplus/helpers/socket.h>
+#include <log4cplus/helpers/tlscontext.h>
 #include <log4cplus/thread/threads.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/thread/syncprims.h>
 #include <log4cplus/log4cplus.h>
 
+#if defined (__linux__)
+#  define LOGGINGSERVER_USE_EPOLL
+#elif defined (__APPLE__) || defined (__FreeBSD__) || defined (__NetBSD__) \
+    || defined (__OpenBSD__) || defined (__DragonFly__)
+#  define LOGGINGSERVER_USE_KQUEUE
+#elif defined (LOG4CPLUS_HAVE_POLL) && defined (LOG4CPLUS_HAVE_POLL_H)
+#  define LOGGINGSERVER_USE_POLL
+#endif
+
+#if defined (LOGGINGSERVER_USE_EPOLL) || defined (LOGGINGSERVER_USE_KQUEUE) \
+    || defined (LOGGINGSERVER_USE_POLL)
+#  define LOGGINGSERVER_EVENT_LOOP
+#  include <cerrno>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/types.h>
+#  include <sys/socket.h>
+#  include <netinet/in.h>
+#  include <arpa/inet.h>
+#  if defined (LOGGINGSERVER_USE_EPOLL)
+#    include <sys/epoll.h>
+#  elif defined (LOGGINGSERVER_USE_KQUEUE)
+#    include <sys/event.h>
+#    include <sys/time.h>
+#  else
+#    include <poll.h>
+#  endif
+#endif
+
 
 namespace loggingserver
 {
@@ -163,11 +212,15 @@ class ClientThread
     : public log4cplus::thread::AbstractThread
 {
 public:
-    ClientThread(log4cplus::helpers::Socket clientsock_, Reaper & reaper_)
+    ClientThread(log4cplus::helpers::Socket clientsock_, Reaper & reaper_,
+        log4cplus::helpers::TlsContext * tls_,
+        std::string const & compressionDictionary)
         : self_reference (log4cplus::thread::AbstractThreadPtr (this))
         , clientsock(std::move (clientsock_))
         , reaper (reaper_)
+        , tls (tls_)
     {
+        decoder.setCompressionDictionary (compressionDictionary);
         std::cout << "Received a client connection!!!!" << std::endl;
     }
 
@@ -181,7 +234,9 @@ public:
 private:
     log4cplus::thread::AbstractThreadPtr self_reference;
     log4cplus::helpers::Socket clientsock;
+    log4cplus::helpers::SocketMessageDecoder decoder;
     Reaper & reaper;
+    log4cplus::helpers::TlsContext * tls;
 };
 
 
@@ -190,6 +245,10 @@ loggingserver::ClientThread::run()
 {
     try
     {
+        // Handshake runs in client's thread, not to stall accepting.
+        if (tls && !clientsock.startTls(*tls))
+            std::cerr << "TLS handshake with client failed." << std::endl;
+
         while (true)
         {
             if (!clientsock.isOpen())
@@ -205,11 +264,14 @@ loggingserver::ClientThread::run()
             if (!clientsock.read(buffer))
                 break;
 
-            log4cplus::spi::InternalLoggingEvent event
-                = log4cplus::helpers::readFromBuffer(buffer);
-            log4cplus::Logger logger
-                = log4cplus::Logger::getInstance(event.getLoggerName());
-            logger.callAppenders(event);
+            std::vector<log4cplus::spi::InternalLoggingEvent> events;
+            decoder.decode(buffer.getBuffer(), buffer.getSize(), events);
+            for (log4cplus::spi::InternalLoggingEvent const & event : events)
+            {
+                log4cplus::Logger logger
+                    = log4cplus::Logger::getInstance(event.getLoggerName());
+                logger.callAppenders(event);
+            }
         }
     }
     catch (...)
@@ -221,6 +283,901 @@ loggingserver::ClientThread::run()
     reaper.visit (std::move (self_reference));
 }
 
+#if defined (LOGGINGSERVER_EVENT_LOOP)
+/**
+   Readiness notification for a set of non-blocking sockets. Each
+   worker thread has its own instance.
+ */
+class Poller
+{
+public:
+    Poller ();
+    ~Poller ();
+
+    //! Adds fd for read readiness. Exclusive registration of the
+    //! listening socket wakes only one of the workers, where supported.
+    bool add (int fd, bool exclusive = false);
+    void remove (int fd);
+
+    //! Waits until some sockets are readable and stores them into
+    //! ready, or until timeout milliseconds pass; -1 waits forever.
+    void wait (std::vector<int> & ready, int timeout = -1);
+
+private:
+    Poller (Poller const &);
+    Poller & operator = (Poller const &);
+
+#if defined (LOGGINGSERVER_USE_POLL)
+    std::vector<struct pollfd> fds;
+#else
+    int pfd;
+#endif
+};
+
+
+#if defined (LOGGINGSERVER_USE_EPOLL)
+Poller::Poller ()
+    : pfd (epoll_create1 (EPOLL_CLOEXEC))
+{ }
+
+
+Poller::~Poller ()
+{
+    ::close (pfd);
+}
+
+
+bool
+Poller::add (int fd, bool exclusive)
+{
+    struct epoll_event ev = epoll_event ();
+    ev.events = EPOLLIN;
+#if defined (EPOLLEXCLUSIVE)
+    if (exclusive)
+        ev.events |= EPOLLEXCLUSIVE;
+#else
+    (void) exclusive;
+#endif
+    ev.data.fd = fd;
+    return epoll_ctl (pfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+
+void
+Poller::remove (int fd)
+{
+    struct epoll_event ev = epoll_event ();
+    epoll_ctl (pfd, EPOLL_CTL_DEL, fd, &ev);
+}
+
+
+void
+Poller::wait (std::vector<int> & ready, int timeout)
+{
+    struct epoll_event events[64];
+    int const n = epoll_wait (pfd, events, 64, timeout);
+    for (int i = 0; i < n; ++i)
+        ready.push_back (events[i].data.fd);
+}
+
+#elif defined (LOGGINGSERVER_USE_KQUEUE)
+Poller::Poller ()
+    : pfd (kqueue ())
+{ }
+
+
+Poller::~Poller ()
+{
+    ::close (pfd);
+}
+
+
+bool
+Poller::add (int fd, bool)
+{
+    struct kevent ev;
+    EV_SET (&ev, fd, EVFILT_READ, EV_ADD, 0, 0, nullptr);
+    return kevent (pfd, &ev, 1, nullptr, 0, nullptr) == 0;
+}
+
+
+void
+Poller::remove (int fd)
+{
+    struct kevent ev;
+    EV_SET (&ev, fd, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+    kevent (pfd, &ev, 1, nullptr, 0, nullptr);
+}
+
+
+void
+Poller::wait (std::vector<int> & ready, int timeout)
+{
+    struct timespec ts;
+    ts.tv_sec = timeout / 1000;
+    ts.tv_nsec = timeout % 1000 * 1000000L;
+    struct kevent events[64];
+    int const n = kevent (pfd, nullptr, 0, events, 64,
+        timeout < 0 ? nullptr : &ts);
+    for (int i = 0; i < n; ++i)
+        ready.push_back (static_cast<int> (events[i].ident));
+}
+
+#else
+Poller::Poller ()
+{ }
+
+
+Poller::~Poller ()
+{ }
+
+
+bool
+Poller::add (int fd, bool)
+{
+    struct pollfd pfd = pollfd ();
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    fds.push_back (pfd);
+    return true;
+}
+
+
+void
+Poller::remove (int fd)
+{
+    for (std::size_t i = 0; i != fds.size (); ++i)
+        if (fds[i].fd == fd)
+        {
+            fds[i] = fds.back ();
+            fds.pop_back ();
+            break;
+        }
+}
+
+
+void
+Poller::wait (std::vector<int> & ready, int timeout)
+{
+    if (::poll (&fds[0], fds.size (), timeout) <= 0)
+        return;
+
+    for (std::size_t i = 0; i != fds.size (); ++i)
+        if (fds[i].revents != 0)
+            ready.push_back (fds[i].fd);
+}
+
+#endif
+
+
+bool
+setNonBlocking (int fd)
+{
+    int const flags = fcntl (fd, F_GETFL, 0);
+    return flags != -1 && fcntl (fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+
+//! Counters of one client, shared by its event loop worker, the sink
+//! and the statistics reporter.
+struct ClientStats
+{
+    unsigned id = 0;
+    std::string peer;
+    std::atomic<std::uint64_t> events {0};
+    std::atomic<std::uint64_t> bytes {0};
+    //! Events decoded but not yet appended.
+    std::atomic<std::size_t> pending {0};
+
+    // Accessed by the reporter only.
+    std::uint64_t reportedEvents = 0;
+    std::uint64_t reportedBytes = 0;
+};
+
+typedef std::shared_ptr<ClientStats> ClientStatsPtr;
+
+
+/**
+   Connected clients, for statistics on their rates.
+ */
+class ClientRegistry
+{
+public:
+    ClientStatsPtr add (std::string const & peer);
+    void remove (ClientStatsPtr const & client);
+
+    //! Prints rates of all clients over the last interval seconds.
+    void report (unsigned interval);
+
+private:
+    std::mutex mtx;
+    std::vector<ClientStatsPtr> clients;
+    unsigned nextId = 0;
+};
+
+
+ClientStatsPtr
+ClientRegistry::add (std::string const & peer)
+{
+    ClientStatsPtr client (new ClientStats);
+    client->peer = peer;
+
+    std::lock_guard<std::mutex> guard (mtx);
+    client->id = nextId++;
+    clients.push_back (client);
+    return client;
+}
+
+
+void
+ClientRegistry::remove (ClientStatsPtr const & client)
+{
+    std::lock_guard<std::mutex> guard (mtx);
+    clients.erase (std::remove (clients.begin (), clients.end (), client),
+        clients.end ());
+}
+
+
+void
+ClientRegistry::report (unsigned interval)
+{
+    std::lock_guard<std::mutex> guard (mtx);
+    for (ClientStatsPtr const & client : clients)
+    {
+        std::uint64_t const events = client->events.load ();
+        std::uint64_t const bytes = client->bytes.load ();
+        std::cout << client->peer << ": "
+            << (events - client->reportedEvents) / interval << " events/s, "
+            << (bytes - client->reportedBytes) / interval << " bytes/s, "
+            << client->pending.load () << " pending\n";
+        client->reportedEvents = events;
+        client->reportedBytes = bytes;
+    }
+    std::cout << std::flush;
+}
+
+
+/**
+   Appends decoded events through the hierarchy from its own threads, so
+   that slow appenders do not stall decoding. Batches of one client
+   always go to the same thread, which keeps them in order. Consecutive
+   events of the same logger reach the appenders as one batch.
+ */
+class Sink
+{
+public:
+    Sink (unsigned threads, std::size_t maxPending_);
+    ~Sink ();
+
+    void submit (ClientStatsPtr const & client,
+        std::vector<log4cplus::spi::InternalLoggingEvent> && events);
+
+    //! Events of a client that may wait for appending before reading
+    //! from it is paused.
+    std::size_t const maxPending;
+
+private:
+    struct Batch
+    {
+        ClientStatsPtr client;
+        std::vector<log4cplus::spi::InternalLoggingEvent> events;
+    };
+
+    struct Lane
+    {
+        std::mutex mtx;
+        std::condition_variable cond;
+        std::deque<Batch> queue;
+        bool stop = false;
+        std::thread thread;
+    };
+
+    static void run (Lane & lane);
+
+    std::vector<std::unique_ptr<Lane>> lanes;
+};
+
+
+Sink::Sink (unsigned threads, std::size_t maxPending_)
+    : maxPending (maxPending_)
+{
+    for (unsigned i = 0; i != (std::max) (threads, 1u); ++i)
+    {
+        lanes.emplace_back (new Lane);
+        Lane & lane = *lanes.back ();
+        lane.thread = std::thread ([&lane] { run (lane); });
+    }
+}
+
+
+Sink::~Sink ()
+{
+    for (auto & lane : lanes)
+    {
+        {
+            std::lock_guard<std::mutex> guard (lane->mtx);
+            lane->stop = true;
+        }
+        lane->cond.notify_one ();
+        lane->thread.join ();
+    }
+}
+
+
+void
+Sink::submit (ClientStatsPtr const & client,
+    std::vector<log4cplus::spi::InternalLoggingEvent> && events)
+{
+    client->pending += events.size ();
+
+    Lane & lane = *lanes[client->id % lanes.size ()];
+    {
+        std::lock_guard<std::mutex> guard (lane.mtx);
+        lane.queue.push_back (Batch {client, std::move (events)});
+    }
+    lane.cond.notify_one ();
+}
+
+
+void
+Sink::run (Lane & lane)
+{
+    for (;;)
+    {
+        Batch batch;
+        {
+            std::unique_lock<std::mutex> guard (lane.mtx);
+            lane.cond.wait (guard,
+                [&lane] { return lane.stop || ! lane.queue.empty (); });
+            if (lane.queue.empty ())
+                return;
+
+            batch = std::move (lane.queue.front ());
+            lane.queue.pop_front ();
+        }
+
+        auto const & events = batch.events;
+        for (auto it = events.begin (); it != events.end (); )
+        {
+            log4cplus::tstring const & name = it->getLoggerName ();
+            auto const runEnd = std::find_if (it + 1, events.end (),
+                [&name] (log4cplus::spi::InternalLoggingEvent const & ev) {
+                    return ev.getLoggerName () != name; });
+
+            log4cplus::Logger::getInstance (name).callAppenders (
+                std::span<log4cplus::spi::InternalLoggingEvent const> (
+                    &*it, static_cast<std::size_t> (runEnd - it)));
+            it = runEnd;
+        }
+
+        batch.client->pending -= events.size ();
+    }
+}
+
+
+//! \return Address and port of peer of connected socket.
+std::string
+peerName (int fd)
+{
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof (addr);
+    char host[INET6_ADDRSTRLEN] = "?";
+    unsigned port = 0;
+    if (getpeername (fd, reinterpret_cast<struct sockaddr *> (&addr), &len)
+        == 0)
+    {
+        if (addr.ss_family == AF_INET)
+        {
+            auto const & in = reinterpret_cast<struct sockaddr_in &> (addr);
+            inet_ntop (AF_INET, &in.sin_addr, host, sizeof (host));
+            port = ntohs (in.sin_port);
+        }
+        else if (addr.ss_family == AF_INET6)
+        {
+            auto const & in6 = reinterpret_cast<struct sockaddr_in6 &> (addr);
+            inet_ntop (AF_INET6, &in6.sin6_addr, host, sizeof (host));
+            port = ntohs (in6.sin6_port);
+        }
+        else if (addr.ss_family == AF_UNIX)
+            // Clients of local socket are usually unnamed.
+            return "unix:" + std::to_string (fd);
+    }
+
+    return std::string (host) + ":" + std::to_string (port);
+}
+
+
+/**
+   Event loop worker. All workers wait on the shared listening socket,
+   the worker that accepts a client owns it until it disconnects. The
+   worker decodes events of its clients and hands them to the sink in
+   batches. Compressed batches are decompressed here as well. When the
+   sink falls behind a client, the worker stops reading from it, so
+   that TCP flow control slows the client down.
+ */
+class EventLoopWorker
+{
+public:
+    EventLoopWorker (int listenFd_, Sink & sink_, ClientRegistry & registry_,
+        std::string const & compressionDictionary_)
+        : listenFd (listenFd_)
+        , sink (sink_)
+        , registry (registry_)
+        , compressionDictionary (compressionDictionary_)
+    { }
+
+    void run ();
+
+private:
+    struct Client
+    {
+        //! Received bytes not yet decoded.
+        std::string input;
+        log4cplus::helpers::SocketMessageDecoder decoder;
+        ClientStatsPtr stats;
+        bool paused = false;
+    };
+
+    void acceptClients ();
+    void readClient (int fd, Client & client);
+    void dispatch (Client & client);
+    void closeClient (int fd);
+
+    //! Stops watching clients the sink is behind and resumes those
+    //! it has caught up with.
+    void throttle ();
+
+    int listenFd;
+    Sink & sink;
+    ClientRegistry & registry;
+    std::string const & compressionDictionary;
+    Poller poller;
+    std::unordered_map<int, Client> clients;
+    std::vector<int> paused;
+};
+
+
+void
+EventLoopWorker::run ()
+{
+    if (! poller.add (listenFd, true))
+    {
+        std::cerr << "Cannot watch server socket." << std::endl;
+        return;
+    }
+
+    std::vector<int> ready;
+    for (;;)
+    {
+        ready.clear ();
+        // Paused clients are checked for resumption periodically.
+        poller.wait (ready, paused.empty () ? -1 : 10);
+        for (int fd : ready)
+        {
+            if (fd == listenFd)
+            {
+                acceptClients ();
+                continue;
+            }
+
+            auto it = clients.find (fd);
+            if (it != clients.end () && ! it->second.paused)
+                readClient (fd, it->second);
+        }
+
+        throttle ();
+    }
+}
+
+
+void
+EventLoopWorker::acceptClients ()
+{
+    for (;;)
+    {
+        int const fd = ::accept (listenFd, nullptr, nullptr);
+        if (fd == -1)
+        {
+            // EAGAIN means other worker took the connection.
+            if (errno == EINTR)
+                continue;
+
+            return;
+        }
+
+        if (! setNonBlocking (fd) || ! poller.add (fd))
+        {
+            ::close (fd);
+            continue;
+        }
+
+        Client & client = clients[fd];
+        client.stats = registry.add (peerName (fd));
+        client.decoder.setCompressionDictionary (compressionDictionary);
+        std::cout << "Received a client connection!!!!" << std::endl;
+    }
+}
+
+
+void
+EventLoopWorker::readClient (int fd, Client & client)
+{
+    // Limit reads per wake-up so that one busy client cannot starve
+    // others; level triggered readiness reports the rest again.
+    char chunk[64 * 1024];
+    for (int i = 0; i != 16; ++i)
+    {
+        ssize_t const n = ::recv (fd, chunk, sizeof (chunk), 0);
+        if (n > 0)
+        {
+            client.input.append (chunk, static_cast<std::size_t> (n));
+            client.stats->bytes += static_cast<std::size_t> (n);
+            continue;
+        }
+        else if (n < 0 && errno == EINTR)
+            continue;
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+
+        dispatch (client);
+        closeClient (fd);
+        return;
+    }
+
+    dispatch (client);
+}
+
+
+void
+EventLoopWorker::dispatch (Client & client)
+{
+    std::string const & input = client.input;
+    std::vector<log4cplus::spi::InternalLoggingEvent> events;
+    std::size_t pos = 0;
+    while (input.size () - pos >= sizeof (unsigned int))
+    {
+        unsigned char const * const prefix
+            = reinterpret_cast<unsigned char const *> (input.data () + pos);
+        std::size_t const msgSize = (std::size_t (prefix[0]) << 24)
+            | (std::size_t (prefix[1]) << 16)
+            | (std::size_t (prefix[2]) << 8)
+            | std::size_t (prefix[3]);
+        if (input.size () - pos - sizeof (unsigned int) < msgSize)
+            break;
+
+        pos += sizeof (unsigned int);
+        client.decoder.decode (input.data () + pos, msgSize, events);
+        pos += msgSize;
+    }
+
+    client.input.erase (0, pos);
+    if (! events.empty ())
+    {
+        client.stats->events += events.size ();
+        sink.submit (client.stats, std::move (events));
+    }
+}
+
+
+void
+EventLoopWorker::closeClient (int fd)
+{
+    auto it = clients.find (fd);
+    if (! it->second.paused)
+        poller.remove (fd);
+    ::close (fd);
+    registry.remove (it->second.stats);
+    clients.erase (it);
+    std::cout << "Client connection closed." << std::endl;
+}
+
+
+void
+EventLoopWorker::throttle ()
+{
+    for (std::size_t i = 0; i != paused.size (); )
+    {
+        int const fd = paused[i];
+        Client & client = clients[fd];
+        if (client.stats->pending.load () > sink.maxPending / 2
+            || ! poller.add (fd))
+        {
+            ++i;
+            continue;
+        }
+
+        client.paused = false;
+        paused[i] = paused.back ();
+        paused.pop_back ();
+    }
+
+    for (auto & entry : clients)
+    {
+        Client & client = entry.second;
+        if (! client.paused
+            && client.stats->pending.load () >= sink.maxPending)
+        {
+            poller.remove (entry.first);
+            client.paused = true;
+            paused.push_back (entry.first);
+        }
+    }
+}
+
+
+#if defined (LOG4CPLUS_HAVE_SYS_UN_H) && defined (__linux__)
+/**
+   Serves ShmTransportAppender clients on this host. Each client has a
+   ring of its own; the worker waits on its wakeup descriptor, which
+   becomes readable only when the ring goes from empty to non-empty,
+   and decodes the records in place. When the sink falls behind a
+   client, its wakeup descriptor is not watched, so the ring fills up
+   and the client drops events after its FullTimeout.
+ */
+class ShmTransportWorker
+{
+public:
+    ShmTransportWorker (int listenFd_, Sink & sink_,
+        ClientRegistry & registry_)
+        : listenFd (listenFd_)
+        , sink (sink_)
+        , registry (registry_)
+    { }
+
+    void run ();
+
+private:
+    struct Client
+    {
+        std::unique_ptr<log4cplus::helpers::ShmTransportReceiver> receiver;
+        ClientStatsPtr stats;
+        bool paused = false;
+    };
+
+    void acceptClients ();
+    void receive (Client & client);
+    void closeClient (int connection);
+    void throttle ();
+
+    int listenFd;
+    Sink & sink;
+    ClientRegistry & registry;
+    Poller poller;
+    //! Clients by their connections.
+    std::unordered_map<int, Client> clients;
+    //! Connections by wakeup descriptors.
+    std::unordered_map<int, int> wakeups;
+    std::vector<int> paused;
+};
+
+
+void
+ShmTransportWorker::run ()
+{
+    if (! poller.add (listenFd))
+    {
+        std::cerr << "Cannot watch shared memory transport socket."
+            << std::endl;
+        return;
+    }
+
+    std::vector<int> ready;
+    for (;;)
+    {
+        ready.clear ();
+        poller.wait (ready, paused.empty () ? -1 : 10);
+        for (int fd : ready)
+        {
+            if (fd == listenFd)
+            {
+                acceptClients ();
+                continue;
+            }
+
+            auto wakeup = wakeups.find (fd);
+            if (wakeup != wakeups.end ())
+            {
+                Client & client = clients[wakeup->second];
+                if (! client.paused)
+                    receive (client);
+                continue;
+            }
+
+            // The client never writes after registration, readable
+            // connection means it has gone away. Its ring is still
+            // mapped here and is drained first.
+            auto it = clients.find (fd);
+            if (it != clients.end ())
+            {
+                receive (it->second);
+                closeClient (fd);
+            }
+        }
+
+        throttle ();
+    }
+}
+
+
+void
+ShmTransportWorker::acceptClients ()
+{
+    for (;;)
+    {
+        int const fd = ::accept4 (listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return;
+        }
+
+        Client client;
+        client.receiver.reset (
+            new log4cplus::helpers::ShmTransportReceiver (fd));
+        if (! client.receiver->isOpen ())
+            continue;
+
+        int const wakeupFd = client.receiver->getWakeupFd ();
+        if (! poller.add (fd))
+            continue;
+        if (! poller.add (wakeupFd))
+        {
+            poller.remove (fd);
+            continue;
+        }
+
+        client.stats = registry.add ("shm " + client.receiver->getIdent ());
+        wakeups[wakeupFd] = fd;
+        Client & added = clients[fd] = std::move (client);
+        std::cout << "Received a shared memory client!!!!" << std::endl;
+
+        // Events appended before the registration was confirmed.
+        receive (added);
+    }
+}
+
+
+void
+ShmTransportWorker::receive (Client & client)
+{
+    std::vector<log4cplus::spi::InternalLoggingEvent> events;
+    client.receiver->receive (events);
+    if (! events.empty ())
+    {
+        client.stats->events += events.size ();
+        sink.submit (client.stats, std::move (events));
+    }
+}
+
+
+void
+ShmTransportWorker::closeClient (int connection)
+{
+    auto it = clients.find (connection);
+    int const wakeupFd = it->second.receiver->getWakeupFd ();
+    poller.remove (connection);
+    if (! it->second.paused)
+        poller.remove (wakeupFd);
+    else
+        paused.erase (std::find (paused.begin (), paused.end (),
+            connection));
+
+    wakeups.erase (wakeupFd);
+    registry.remove (it->second.stats);
+    clients.erase (it);
+    std::cout << "Shared memory client closed." << std::endl;
+}
+
+
+void
+ShmTransportWorker::throttle ()
+{
+    for (std::size_t i = 0; i != paused.size (); )
+    {
+        Client & client = clients[paused[i]];
+        if (client.stats->pending.load () > sink.maxPending / 2
+            || ! poller.add (client.receiver->getWakeupFd ()))
+        {
+            ++i;
+            continue;
+        }
+
+        // The ring has not been empty since pausing, so the client
+        // has not signalled anything new.
+        client.paused = false;
+        paused[i] = paused.back ();
+        paused.pop_back ();
+        receive (client);
+    }
+
+    for (auto & entry : clients)
+    {
+        Client & client = entry.second;
+        if (! client.paused
+            && client.stats->pending.load () >= sink.maxPending)
+        {
+            poller.remove (client.receiver->getWakeupFd ());
+            client.paused = true;
+            paused.push_back (entry.first);
+        }
+    }
+}
+#endif
+
+
+int
+runEventLoop (log4cplus::tstring const & host, int port, bool ipv6,
+    unsigned threads, unsigned sinkThreads, std::size_t maxPending,
+    unsigned statsInterval, log4cplus::tstring const & shmSocket,
+    std::string const & compressionDictionary)
+{
+    log4cplus::helpers::SocketState state;
+    log4cplus::helpers::SOCKET_TYPE const sock
+        = log4cplus::helpers::openSocket (host,
+            static_cast<unsigned short> (port), false, ipv6, state);
+    if (sock == log4cplus::helpers::INVALID_SOCKET_VALUE) {
+        std::cerr << "Could not open server socket, maybe port "
+            << port << " is already in use." << std::endl;
+        return 2;
+    }
+
+    int const listenFd = static_cast<int> (sock);
+    // Allow for many clients connecting at once.
+    ::listen (listenFd, SOMAXCONN);
+    if (! setNonBlocking (listenFd)) {
+        std::cerr << "Could not make server socket non-blocking."
+            << std::endl;
+        return 2;
+    }
+
+    Sink sink (sinkThreads, maxPending);
+    ClientRegistry registry;
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i != threads; ++i)
+        workers.emplace_back ([listenFd, &sink, &registry,
+                &compressionDictionary] {
+            EventLoopWorker (listenFd, sink, registry,
+                compressionDictionary).run ();
+        });
+
+#if defined (LOG4CPLUS_HAVE_SYS_UN_H) && defined (__linux__)
+    if (! shmSocket.empty ())
+    {
+        int const shmFd
+            = log4cplus::helpers::openShmTransportListener (shmSocket);
+        if (shmFd == -1)
+            std::cerr << "Could not open shared memory transport socket."
+                << std::endl;
+        else
+            workers.emplace_back ([shmFd, &sink, &registry] {
+                ShmTransportWorker (shmFd, sink, registry).run ();
+            });
+    }
+#else
+    (void) shmSocket;
+#endif
+
+    if (statsInterval != 0)
+        workers.emplace_back ([statsInterval, &registry] {
+            for (;;)
+            {
+                std::this_thread::sleep_for (
+                    std::chrono::seconds (statsInterval));
+                registry.report (statsInterval);
+            }
+        });
+
+    for (std::thread & worker : workers)
+        worker.join ();
+
+    return 0;
+}
+
+#endif // defined (LOGGINGSERVER_EVENT_LOOP)
+
 } // namespace loggingserver
 
 
@@ -231,21 +1188,112 @@ main(int argc, char** argv)
 {
     log4cplus::Initializer initializer;
 
-    if(argc < 4) {
-        std::cout << "Usage: host port config_file [<IP version>]\n"
+    // --threads N selects event loop mode with N worker threads.
+    unsigned threads = 0;
+    unsigned sinkThreads = 1;
+    std::size_t maxPending = 64 * 1024;
+    unsigned statsInterval = 0;
+    log4cplus::tstring shmSocket;
+    std::string compressionDictionary;
+    log4cplus::helpers::TlsConfig tlsConfig;
+    tlsConfig.server = true;
+    std::vector<char *> args;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp (argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (std::strcmp (argv[i], "--sink-threads") == 0 && i + 1 < argc)
+            sinkThreads = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (std::strcmp (argv[i], "--max-pending") == 0 && i + 1 < argc)
+            maxPending = static_cast<std::size_t>(std::atol(argv[++i]));
+        else if (std::strcmp (argv[i], "--stats") == 0 && i + 1 < argc)
+            statsInterval = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (std::strcmp (argv[i], "--shm-socket") == 0 && i + 1 < argc)
+            shmSocket = LOG4CPLUS_C_STR_TO_TSTRING(argv[++i]);
+        else if (std::strcmp (argv[i], "--compression-dictionary") == 0
+            && i + 1 < argc)
+        {
+            std::ifstream in (argv[++i], std::ios_base::binary);
+            compressionDictionary.assign (std::istreambuf_iterator<char> (in),
+                std::istreambuf_iterator<char> ());
+            if (compressionDictionary.empty ()) {
+                std::cerr << "Could not read compression dictionary "
+                    << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (std::strcmp (argv[i], "--tls-cert") == 0 && i + 1 < argc)
+            tlsConfig.certFile = LOG4CPLUS_C_STR_TO_TSTRING(argv[++i]);
+        else if (std::strcmp (argv[i], "--tls-key") == 0 && i + 1 < argc)
+            tlsConfig.keyFile = LOG4CPLUS_C_STR_TO_TSTRING(argv[++i]);
+        else if (std::strcmp (argv[i], "--tls-ca") == 0 && i + 1 < argc)
+            tlsConfig.caFile = LOG4CPLUS_C_STR_TO_TSTRING(argv[++i]);
+        else
+            args.push_back (argv[i]);
+    }
+
+    if(args.size() < 3) {
+        std::cout << "Usage: [--threads N [--sink-threads N]"
+            " [--max-pending N] [--stats S] [--shm-socket path]]"
+            " [--compression-dictionary file]"
+            " [--tls-cert file [--tls-key file]"
+            " [--tls-ca file]] host port config_file [<IP version>]\n"
             << "<IP version> either 0 for IPv4 (default) or 1 for IPv6\n"
+            << "host unix:///path listens on local socket at /path"
+            " instead (unix://@name in abstract namespace on Linux),"
+            " port is ignored then\n"
+            << "--threads N serves clients from N event loop threads"
+            " instead of thread per client; they decode events and\n"
+            "  pass them in batches to --sink-threads threads (default 1)"
+            " that append them\n"
+            << "--max-pending N stops reading from a client while N of its"
+            " events wait for appending (default 65536)\n"
+            << "--stats S prints events per second of each client every"
+            " S seconds\n"
+            << "--shm-socket path also accepts ShmTransportAppender clients"
+            " of this host at unix socket path (Linux only)\n"
+            << "--compression-dictionary file decompresses batches of"
+            " clients using the same CompressionDictionary\n"
+            << "--tls-cert accepts TLS connections only, --tls-ca"
+            " requires client certificates\n"
             << std::flush;
         return 1;
     }
-    int const port = std::atoi(argv[2]);
-    bool const ipv6 = argc >= 5 ? !!std::atoi(argv[4]) : false;
-    const log4cplus::tstring configFile = LOG4CPLUS_C_STR_TO_TSTRING(argv[3]);
+    int const port = std::atoi(args[1]);
+    bool const ipv6 = args.size() >= 4 ? !!std::atoi(args[3]) : false;
+    const log4cplus::tstring configFile = LOG4CPLUS_C_STR_TO_TSTRING(args[2]);
 
     log4cplus::PropertyConfigurator config(configFile);
     config.configure();
 
+    std::unique_ptr<log4cplus::helpers::TlsContext> tls;
+    if (!tlsConfig.certFile.empty()) {
+        tls = log4cplus::helpers::createTlsContext (tlsConfig);
+        if (!tls) {
+            std::cerr << "Could not set up TLS." << std::endl;
+            return 3;
+        }
+
+        if (threads != 0) {
+            std::cerr << "--threads is not supported with TLS,"
+                " using thread per client." << std::endl;
+            threads = 0;
+        }
+    }
+
+    if (threads != 0) {
+#if defined (LOGGINGSERVER_EVENT_LOOP)
+        return loggingserver::runEventLoop (
+            LOG4CPLUS_C_STR_TO_TSTRING(args[0]), port, ipv6, threads,
+            sinkThreads, (std::max) (maxPending, std::size_t (1)),
+            statsInterval, shmSocket, compressionDictionary);
+#else
+        std::cerr << "--threads is not supported on this platform,"
+            " using thread per client." << std::endl;
+#endif
+    }
+
     log4cplus::helpers::ServerSocket serverSocket(port, false, ipv6,
-        LOG4CPLUS_C_STR_TO_TSTRING(argv[1]));
+        LOG4CPLUS_C_STR_TO_TSTRING(args[0]));
     if (!serverSocket.isOpen()) {
         std::cerr << "Could not open server socket, maybe port "
             << port << " is already in use." << std::endl;
@@ -257,7 +1305,8 @@ main(int argc, char** argv)
     for (;;)
     {
         loggingserver::ClientThread *thr =
-            new loggingserver::ClientThread(serverSocket.accept(), reaper);
+            new loggingserver::ClientThread(serverSocket.accept(), reaper,
+                tls.get (), compressionDictionary);
         thr->start();
     }
 
@@ -28,8 +28,25 @@
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <stdexcept>
+#include <thread>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/ndc.h>
+#include <log4cplus/asyncappender.h>
+#include <log4cplus/helpers/appenderattachableimpl.h>
+#include <log4cplus/helpers/queue.h>
+#include <cstdio>
+#include <vector>
+#include <catch.hpp>
+#if defined (LOG4CPLUS_USE_PTHREADS)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#endif
 
 
 namespace log4cplus
@@ -78,36 +95,64 @@ OnlyOnceErrorHandler::reset()
 
 
 
+namespace
+{
+
+//! Value of Appender::requiredEventFields that is yet to be computed.
+unsigned const required_event_fields_unknown = ~0u;
+
+//! Number of events appended between checks of lock file hold time.
+std::ptrdiff_t const lock_hold_piece = 32;
+
+} // namespace
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // log4cplus::Appender ctors
 ///////////////////////////////////////////////////////////////////////////////
 
 Appender::Appender()
- : layout(new SimpleLayout),
+ : threshold(NOT_SET_LOG_LEVEL),
+   closed(false),
+   async(false),
+   asyncFanOut(false),
+   useLockFile(false),
+   concurrentAppend(false),
+   forkGate(false),
+   preFilterChain(nullptr),
+   metrics(nullptr),
+   requiredEventFields(required_event_fields_unknown),
+   layout(new SimpleLayout),
    name(internal::empty_str),
-   threshold(NOT_SET_LOG_LEVEL),
    errorHandler(new OnlyOnceErrorHandler),
-   useLockFile(false),
-   async(false),
+   lockHoldTime(0)
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-   in_flight(0),
+   , asyncStrand(new internal::async_strand (this))
+   , in_flight(0)
 #endif
-   closed(false)
 {
 }
 
 
 
 Appender::Appender(const log4cplus::helpers::Properties & properties)
-    : layout(new SimpleLayout)
-    , threshold(NOT_SET_LOG_LEVEL)
-    , errorHandler(new OnlyOnceErrorHandler)
-    , useLockFile(false)
+    : threshold(NOT_SET_LOG_LEVEL)
+    , closed(false)
     , async(false)
+    , asyncFanOut(false)
+    , useLockFile(false)
+    , concurrentAppend(false)
+    , forkGate(false)
+    , preFilterChain(nullptr)
+    , metrics(nullptr)
+    , requiredEventFields(required_event_fields_unknown)
+    , layout(new SimpleLayout)
+    , errorHandler(new OnlyOnceErrorHandler)
+    , lockHoldTime(0)
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    , asyncStrand(new internal::async_strand (this))
     , in_flight(0)
 #endif
-    , closed(false)
 {
     if(properties.exists( LOG4CPLUS_TEXT("layout") ))
     {
@@ -147,9 +192,15 @@ Appender::Appender(const log4cplus::helpers::Properties & properties)
     if(properties.exists(LOG4CPLUS_TEXT("Threshold"))) {
         tstring tmp = properties.getProperty(LOG4CPLUS_TEXT("Threshold"));
         tmp = log4cplus::helpers::toUpper(tmp);
-        threshold = log4cplus::getLogLevelManager().fromString(tmp);
+        threshold.store(log4cplus::getLogLevelManager().fromString(tmp),
+            std::memory_order_relaxed);
     }
 
+    bool enableMetrics = false;
+    properties.getBool (enableMetrics, LOG4CPLUS_TEXT("Metrics"));
+    if (enableMetrics)
+        setMetricsEnabled (true);
+
     // Configure the filters
     helpers::Properties filterProps
         = properties.getPropertySubset( LOG4CPLUS_TEXT("filters.") );
@@ -202,10 +253,13 @@ Appender::Appender(const log4cplus::helpers::Properties & properties)
                 LOG4CPLUS_TEXT (
                     "UseLockFile is true but LockFile is not specified"));
         }
+
+        properties.getULong (lockHoldTime, LOG4CPLUS_TEXT("MaxLockHoldMs"));
     }
 
     // Deal with asynchronous append flag.
     properties.getBool (async, LOG4CPLUS_TEXT("AsyncAppend"));
+    properties.getBool (asyncFanOut, LOG4CPLUS_TEXT("AsyncFanOut"));
 }
 
 
@@ -237,10 +291,186 @@ Appender::waitToFinishAsyncLogging()
         // When async flag is true we might have some logging still in flight
         // on thread pool threads. Wait for them to finish.
 
-        std::unique_lock<std::mutex> lock (in_flight_mutex);
-        in_flight_condition.wait (lock,
-            [&] { return this->in_flight == 0; });
+        std::size_t count;
+        while ((count = in_flight.load (std::memory_order_acquire)) != 0)
+            in_flight.wait (count, std::memory_order_acquire);
+    }
+#endif
+}
+
+
+bool
+Appender::waitToFinishAsyncLogging(
+    std::chrono::steady_clock::time_point deadline)
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+    if (async)
+    {
+        // std::atomic::wait() has no timeout; poll with growing sleeps,
+        // up to a millisecond.
+        std::chrono::microseconds pause (10);
+        while (in_flight.load (std::memory_order_acquire) != 0)
+        {
+            auto const now = std::chrono::steady_clock::now ();
+            if (now >= deadline)
+                return false;
+
+            std::this_thread::sleep_for ((std::min) (
+                std::chrono::duration_cast<std::chrono::microseconds> (
+                    deadline - now), pause));
+            pause = (std::min) (pause * 2, std::chrono::microseconds (1000));
+        }
+    }
+#endif
+
+    return true;
+}
+
+
+unsigned
+Appender::getRequiredEventFields() const
+{
+    unsigned fields = requiredEventFields.load (std::memory_order_relaxed);
+    if (fields == required_event_fields_unknown)
+    {
+        thread::MutexGuard guard (access_mutex);
+
+        fields = spi::getRequiredEventFields (filter.get ());
+        if (layout)
+            fields |= layout->getRequiredEventFields ();
+        requiredEventFields.store (fields, std::memory_order_relaxed);
+    }
+
+    return fields;
+}
+
+
+void
+Appender::setThreshold(LogLevel th)
+{
+    threshold.store (th, std::memory_order_relaxed);
+    internal::invalidate_pre_filter_caches ();
+}
+
+
+bool
+Appender::mayAppend(LogLevel ll, const log4cplus::tstring& loggerName,
+    bool& contextual) const
+{
+    if (! isAsSevereAsThreshold (ll) || ! hasConsumers (ll))
+        return false;
+
+    // Loggers call this for every event whose pre-filter result depends
+    // on NDC or MDC, so it does not take access_mutex.
+    PreFilterChain const * chain
+        = preFilterChain.load (std::memory_order_acquire);
+    if (! chain)
+        return true;
+
+    spi::FilterResult result = spi::ACCEPT;
+    for (spi::FilterPtr const & f : *chain)
+    {
+        result = f->preDecide (ll, loggerName, contextual);
+        if (result != spi::NEUTRAL)
+            break;
     }
+
+    return result != spi::DENY;
+}
+
+
+bool
+Appender::hasConsumers(LogLevel) const
+{
+    return true;
+}
+
+
+void
+Appender::prepareEmergency()
+{ }
+
+
+bool
+Appender::emergencyWrite(const char *, std::size_t) noexcept
+{
+    return false;
+}
+
+
+void
+Appender::emergencyDump(EmergencyEventVisitor, void *) noexcept
+{ }
+
+
+void
+Appender::consumersChanged()
+{
+    internal::invalidate_pre_filter_caches ();
+}
+
+
+void
+Appender::setMetricsEnabled(bool enabled)
+{
+    thread::MutexGuard guard (access_mutex);
+
+    if (enabled && ! metricsStorage)
+        metricsStorage = std::make_unique<internal::appender_metrics> ();
+
+    metrics.store (enabled ? metricsStorage.get () : nullptr,
+        std::memory_order_release);
+}
+
+
+bool
+Appender::isMetricsEnabled() const
+{
+    return metrics.load (std::memory_order_relaxed) != nullptr;
+}
+
+
+AppenderMetrics
+Appender::getMetrics() const
+{
+    AppenderMetrics result;
+
+    thread::MutexGuard guard (access_mutex);
+
+    result.name = name;
+    internal::appender_metrics const * const m = metricsStorage.get ();
+    if (! m)
+        return result;
+
+    result.events = m->events.load (std::memory_order_relaxed);
+    result.bytes = m->bytes.load (std::memory_order_relaxed);
+    result.filtered = m->filtered.load (std::memory_order_relaxed);
+    result.dropped = m->dropped.load (std::memory_order_relaxed);
+    result.errors = m->errors.load (std::memory_order_relaxed);
+    m->append_latency.snapshot (result.appendLatency);
+    m->queue_latency.snapshot (result.queueLatency);
+    return result;
+}
+
+
+void
+Appender::recordDroppedEvent()
+{
+    if (internal::appender_metrics * const m
+        = metrics.load (std::memory_order_acquire))
+        m->dropped.fetch_add (1, std::memory_order_relaxed);
+}
+
+
+bool
+Appender::isAsynchronous() const
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+    return async;
+#else
+    return false;
 #endif
 }
 
@@ -268,16 +498,15 @@ bool Appender::isClosed() const
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
 void
-Appender::subtract_in_flight ()
+Appender::subtract_in_flight (std::size_t count)
 {
 #if defined (LOG4CPLUS_ENABLE_THREAD_POOL)
     std::size_t const prev = std::atomic_fetch_sub_explicit (&in_flight,
-        std::size_t (1), std::memory_order_acq_rel);
-    if (prev == 1)
-    {
-        std::unique_lock<std::mutex> lock (in_flight_mutex);
-        in_flight_condition.notify_all ();
-    }
+        count, std::memory_order_acq_rel);
+    if (prev == count)
+        in_flight.notify_all ();
+#else
+    (void) count;
 #endif
 }
 
@@ -286,24 +515,41 @@ Appender::subtract_in_flight ()
 
 // from global-init.cxx
 void enqueueAsyncDoAppend (SharedAppenderPtr const & appender,
-    spi::InternalLoggingEvent const & event);
+    internal::async_strand & strand, spi::InternalLoggingEvent const & event,
+    unsigned fields);
+void enqueueAsyncDoAppend (SharedAppenderPtr const & appender,
+    internal::async_strand & strand,
+    std::shared_ptr<spi::InternalLoggingEvent const> const & event);
 
 
 void
 Appender::doAppend(const log4cplus::spi::InternalLoggingEvent& event)
 {
+    // Reject events under the threshold before they are queued or
+    // access_mutex is taken. appendIfAccepted() checks it again.
+    if (! isAsSevereAsThreshold (event.getLogLevel ()))
+    {
+        if (internal::appender_metrics * const m
+            = metrics.load (std::memory_order_acquire))
+            m->filtered.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+#if defined (LOG4CPLUS_USE_PTHREADS)
+    internal::fork_gate_guard const gate (async || forkGate);
+#endif
+
 #if ! defined (LOG4CPLUS_SINGLE_THREADED) \
     && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
     if (async)
     {
-        event.gatherThreadSpecificData ();
-
         std::atomic_fetch_add_explicit (&in_flight, std::size_t (1),
             std::memory_order_relaxed);
 
         try
         {
-            enqueueAsyncDoAppend (SharedAppenderPtr (this), event);
+            enqueueAsyncDoAppend (SharedAppenderPtr (this), *asyncStrand,
+                event, getRequiredEventFields ());
         }
         catch (...)
         {
@@ -317,6 +563,59 @@ Appender::doAppend(const log4cplus::spi::InternalLoggingEvent& event)
 }
 
 
+void
+Appender::doAppendShared(
+    std::shared_ptr<spi::InternalLoggingEvent const> const & event)
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+    if (isAsyncFanOut ())
+    {
+        if (! isAsSevereAsThreshold (event->getLogLevel ()))
+        {
+            if (internal::appender_metrics * const m
+                = metrics.load (std::memory_order_acquire))
+                m->filtered.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+
+#if defined (LOG4CPLUS_USE_PTHREADS)
+        internal::fork_gate_guard const gate (true);
+#endif
+
+        std::atomic_fetch_add_explicit (&in_flight, std::size_t (1),
+            std::memory_order_relaxed);
+
+        try
+        {
+            enqueueAsyncDoAppend (SharedAppenderPtr (this), *asyncStrand,
+                event);
+        }
+        catch (...)
+        {
+            subtract_in_flight ();
+            throw;
+        }
+        return;
+    }
+#endif
+
+    doAppend (*event);
+}
+
+
+bool
+Appender::isAsyncFanOut() const
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+    return async && asyncFanOut;
+#else
+    return false;
+#endif
+}
+
+
 void
 Appender::asyncDoAppend(const log4cplus::spi::InternalLoggingEvent& event)
 {
@@ -347,25 +646,60 @@ Appender::asyncDoAppend(const log4cplus::spi::InternalLoggingEvent& event)
 void
 Appender::syncDoAppend(const log4cplus::spi::InternalLoggingEvent& event)
 {
-    thread::MutexGuard guard (access_mutex);
-
-    if(closed) {
-        helpers::getLogLog().error(
-            LOG4CPLUS_TEXT("Attempted to append to closed appender named [")
-            + name
-            + LOG4CPLUS_TEXT("]."));
+    internal::appender_metrics * const m
+        = metrics.load (std::memory_order_acquire);
+    if (! m)
+    {
+        appendIfAccepted (event, nullptr);
         return;
     }
 
-    // Check appender's threshold logging level.
+    auto const start = std::chrono::steady_clock::now ();
+    try
+    {
+        appendIfAccepted (event, m);
+    }
+    catch (...)
+    {
+        m->errors.fetch_add (1, std::memory_order_relaxed);
+        throw;
+    }
+    m->append_latency.record (std::chrono::steady_clock::now () - start);
+}
+
 
-    if (! isAsSevereAsThreshold(event.getLogLevel()))
-        return;
+void
+Appender::appendIfAccepted(const spi::InternalLoggingEvent& event,
+    internal::appender_metrics * m)
+{
+    // Appenders with concurrentAppend synchronize append() and check
+    // that they are open themselves.
+    thread::MutexGuard guard;
+    if (! concurrentAppend)
+    {
+        guard.attach_and_lock (access_mutex);
+
+        if(closed) {
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("Attempted to append to closed appender named [")
+                + name
+                + LOG4CPLUS_TEXT("]."));
+            if (m)
+                m->dropped.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+    }
 
-    // Evaluate filters attached to this appender.
+    // Check appender's threshold logging level and evaluate filters
+    // attached to this appender.
 
-    if (checkFilter(filter.get(), event) == spi::DENY)
+    if (! isAsSevereAsThreshold(event.getLogLevel())
+        || checkFilters(event) == spi::DENY)
+    {
+        if (m)
+            m->filtered.fetch_add (1, std::memory_order_relaxed);
         return;
+    }
 
     // Lock system wide lock.
 
@@ -378,27 +712,332 @@ Appender::syncDoAppend(const log4cplus::spi::InternalLoggingEvent& event)
         }
         catch (std::runtime_error const &)
         {
+            if (m)
+                m->dropped.fetch_add (1, std::memory_order_relaxed);
             return;
         }
     }
 
-    // Finally append given event.
+    // Finally append given event, after summaries of events denied by
+    // filters.
 
+    appendFilterSummaries(event);
     append(event);
+    if (m)
+        m->events.fetch_add (1, std::memory_order_relaxed);
+}
+
+
+void
+Appender::appendFilterSummaries(const spi::InternalLoggingEvent& event)
+{
+    for (spi::Filter const * f = filter.get (); f; f = f->next.get ())
+    {
+        std::unique_ptr<spi::InternalLoggingEvent> const summary
+            = f->takeSummary (event);
+        if (summary)
+            append (*summary);
+    }
+}
+
+
+void
+Appender::doAppendBatch (
+    std::span<spi::InternalLoggingEvent const> events)
+{
+#if defined (LOG4CPLUS_USE_PTHREADS)
+    internal::fork_gate_guard const gate (async || forkGate);
+#endif
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+    if (async)
+    {
+        for (auto const & event : events)
+            doAppend (event);
+    }
+    else
+#endif
+        syncDoAppendBatch (events);
+}
+
+
+void
+Appender::syncDoAppendBatch (
+    std::span<spi::InternalLoggingEvent const> events)
+{
+    if (events.empty ())
+        return;
+
+    internal::appender_metrics * const m
+        = metrics.load (std::memory_order_acquire);
+    if (! m)
+    {
+        appendBatchIfAccepted (events, nullptr);
+        return;
+    }
+
+    auto const start = std::chrono::steady_clock::now ();
+    try
+    {
+        appendBatchIfAccepted (events, m);
+    }
+    catch (...)
+    {
+        m->errors.fetch_add (events.size (), std::memory_order_relaxed);
+        throw;
+    }
+
+    // Every event of the batch is accounted with its share of the time.
+    auto const share = (std::chrono::steady_clock::now () - start)
+        / events.size ();
+    for (std::size_t i = 0; i != events.size (); ++i)
+        m->append_latency.record (share);
+}
+
+
+void
+Appender::appendBatchIfAccepted (
+    std::span<spi::InternalLoggingEvent const> events,
+    internal::appender_metrics * m)
+{
+    thread::MutexGuard guard;
+    if (! concurrentAppend)
+    {
+        guard.attach_and_lock (access_mutex);
+
+        if(closed) {
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("Attempted to append to closed appender named [")
+                + name
+                + LOG4CPLUS_TEXT("]."));
+            if (m)
+                m->dropped.fetch_add (events.size (),
+                    std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    // Lock system wide lock.
+
+    bool const locked = useLockFile && lockFile.get ();
+    helpers::LockFileGuard lfguard;
+    if (locked)
+    {
+        try
+        {
+            lfguard.attach_and_lock (*lockFile);
+        }
+        catch (std::runtime_error const &)
+        {
+            if (m)
+                m->dropped.fetch_add (events.size (),
+                    std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    using iterator = std::span<spi::InternalLoggingEvent const>::iterator;
+    auto lock_start = std::chrono::steady_clock::now ();
+
+    // Appends events of [first, last). When lock hold time is limited,
+    // they are appended in pieces and the lock file is released and
+    // taken again between them once the time is up, so that other
+    // processes are not kept waiting for the whole batch. Returns
+    // position of the first event which has not been appended because
+    // the lock file could not be taken again.
+    auto const append_run = [&] (iterator first, iterator last) -> iterator
+    {
+        if (! locked || lockHoldTime == 0)
+        {
+            appendBatch (std::span<spi::InternalLoggingEvent const> (
+                first, last));
+            return last;
+        }
+
+        while (first != last)
+        {
+            if (std::chrono::steady_clock::now () - lock_start
+                >= std::chrono::milliseconds (lockHoldTime))
+            {
+                lfguard.unlock ();
+                lfguard.detach ();
+                try
+                {
+                    lfguard.attach_and_lock (*lockFile);
+                }
+                catch (std::runtime_error const &)
+                {
+                    return first;
+                }
+                lock_start = std::chrono::steady_clock::now ();
+            }
+
+            iterator const piece_end = last - first > lock_hold_piece
+                ? first + lock_hold_piece
+                : last;
+            appendBatch (std::span<spi::InternalLoggingEvent const> (
+                first, piece_end));
+            first = piece_end;
+        }
+
+        return last;
+    };
+
+    // Append runs of consecutive events which pass threshold check and
+    // filters. Summaries of events denied by filters interrupt the runs.
+
+    std::size_t filtered = 0;
+    auto const end = events.end ();
+    auto stop = end;
+    auto run_begin = events.begin ();
+    for (auto it = run_begin; it != end && stop == end; ++it)
+    {
+        if (isAsSevereAsThreshold (it->getLogLevel ())
+            && checkFilters (*it) != spi::DENY)
+        {
+            for (spi::Filter const * f = filter.get (); f; f = f->next.get ())
+            {
+                std::unique_ptr<spi::InternalLoggingEvent> const summary
+                    = f->takeSummary (*it);
+                if (! summary)
+                    continue;
+
+                if (run_begin != it)
+                {
+                    iterator const appended = append_run (run_begin, it);
+                    if (appended != it)
+                    {
+                        stop = appended;
+                        break;
+                    }
+                }
+
+                append (*summary);
+                run_begin = it;
+            }
+
+            continue;
+        }
+
+        if (run_begin != it)
+        {
+            iterator const appended = append_run (run_begin, it);
+            if (appended != it)
+            {
+                stop = appended;
+                break;
+            }
+        }
+
+        ++filtered;
+        run_begin = it + 1;
+    }
+
+    if (stop == end && run_begin != end)
+        stop = append_run (run_begin, end);
+
+    if (m)
+    {
+        std::size_t const dropped = static_cast<std::size_t> (end - stop);
+        m->filtered.fetch_add (filtered, std::memory_order_relaxed);
+        m->dropped.fetch_add (dropped, std::memory_order_relaxed);
+        m->events.fetch_add (events.size () - filtered - dropped,
+            std::memory_order_relaxed);
+    }
+}
+
+
+void
+Appender::appendBatch (std::span<spi::InternalLoggingEvent const> events)
+{
+    for (auto const & event : events)
+        append (event);
+}
+
+
+namespace
+{
+
+//! Appends <code>event</code> formatted by <code>layout</code>. Layouts
+//! with equal cache keys format the event once while it is appended by
+//! the scope of internal::layout_cache_scope.
+void
+formatShared (Layout & layout, spi::InternalLoggingEvent const & event,
+    tstring & output)
+{
+    unsigned const key = layout.getCacheKey ();
+    internal::per_thread_data * ptd;
+    if (key == 0
+        || ! internal::layout_cache_enabled.load (std::memory_order_relaxed)
+        || (ptd = internal::get_ptd ())->layout_cache_event != &event)
+    {
+        layout.formatAndAppend (output, event);
+        return;
+    }
+
+    for (std::size_t i = 0; i != ptd->layout_cache_used; ++i)
+        if (ptd->layout_cache[i].key == key)
+        {
+            output += ptd->layout_cache[i].str;
+            return;
+        }
+
+    if (ptd->layout_cache_used == ptd->layout_cache.size ())
+        ptd->layout_cache.emplace_back ();
+
+    internal::layout_cache_entry & entry
+        = ptd->layout_cache[ptd->layout_cache_used];
+    entry.key = key;
+    internal::clear_thread_buffer (entry.str);
+    layout.formatAndAppend (entry.str, event);
+    ++ptd->layout_cache_used;
+    output += entry.str;
 }
 
+} // namespace
+
 
 tstring &
 Appender::formatEvent (const spi::InternalLoggingEvent& event) const
 {
     internal::appender_sratch_pad & appender_sp = internal::get_appender_sp ();
-    detail::clear_tostringstream (appender_sp.oss);
-    layout->formatAndAppend(appender_sp.oss, event);
-    appender_sp.str = appender_sp.oss.str();
+    appender_sp.str.clear ();
+    formatShared (*layout, event, appender_sp.str);
+    if (internal::appender_metrics * const m
+        = metrics.load (std::memory_order_relaxed))
+        m->bytes.fetch_add (appender_sp.str.size () * sizeof (tchar),
+            std::memory_order_relaxed);
     return appender_sp.str;
 }
 
 
+void
+Appender::formatEvent (const spi::InternalLoggingEvent& event,
+    tstring & output) const
+{
+    std::size_t const start = output.size ();
+    formatShared (*layout, event, output);
+    if (internal::appender_metrics * const m
+        = metrics.load (std::memory_order_relaxed))
+        m->bytes.fetch_add ((output.size () - start) * sizeof (tchar),
+            std::memory_order_relaxed);
+}
+
+
+void
+Appender::formatEvents (std::span<spi::InternalLoggingEvent const> events,
+    tstring & output) const
+{
+    std::size_t const start = output.size ();
+    layout->formatBatch(events, output);
+    if (internal::appender_metrics * const m
+        = metrics.load (std::memory_order_relaxed))
+        m->bytes.fetch_add ((output.size () - start) * sizeof (tchar),
+            std::memory_order_relaxed);
+}
+
+
 log4cplus::tstring
 Appender::getName()
 {
@@ -447,6 +1086,8 @@ Appender::setLayout(std::unique_ptr<Layout> lo)
     thread::MutexGuard guard (access_mutex);
 
     this->layout = std::move(lo);
+    requiredEventFields.store (required_event_fields_unknown,
+        std::memory_order_relaxed);
 }
 
 
@@ -466,6 +1107,24 @@ Appender::setFilter(log4cplus::spi::FilterPtr f)
     thread::MutexGuard guard (access_mutex);
 
     filter = std::move (f);
+    filterProgram = spi::FilterProgram (filter.get ());
+
+    // mayAppend() gets its own list of the filters, so that
+    // addFilter() appending to the chain does not race with it.
+    if (filter)
+    {
+        auto chain = std::make_unique<PreFilterChain> ();
+        for (spi::Filter * f2 = filter.get (); f2; f2 = f2->next.get ())
+            chain->emplace_back (f2);
+        preFilterChain.store (chain.get (), std::memory_order_release);
+        preFilterChains.push_back (std::move (chain));
+    }
+    else
+        preFilterChain.store (nullptr, std::memory_order_release);
+
+    requiredEventFields.store (required_event_fields_unknown,
+        std::memory_order_relaxed);
+    internal::invalidate_pre_filter_caches ();
 }
 
 
@@ -502,4 +1161,377 @@ Appender::addFilter (std::function<
 }
 
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Lock file held across batch", "[appender]")
+{
+    struct TestAppender
+        : Appender
+    {
+        explicit TestAppender (helpers::Properties const & props)
+            : Appender (props)
+        { }
+
+        ~TestAppender () { destructorImpl (); }
+
+        void close () override { closed = true; }
+
+        std::vector<std::size_t> pieces;
+        std::size_t next = 0;
+        std::size_t mismatches = 0;
+
+    protected:
+        void append (spi::InternalLoggingEvent const & ev) override
+        {
+            if (std::stoul (ev.getMessage ()) != next++)
+                ++mismatches;
+            std::this_thread::sleep_for (std::chrono::microseconds (100));
+        }
+
+        void appendBatch (std::span<spi::InternalLoggingEvent const> events)
+            override
+        {
+            pieces.push_back (events.size ());
+            Appender::appendBatch (events);
+        }
+    };
+
+    tstring const lock_file_name (LOG4CPLUS_TEXT ("appender_batch_test.lock"));
+    std::size_t const event_count = 200;
+    std::vector<spi::InternalLoggingEvent> events;
+    for (std::size_t i = 0; i != event_count; ++i)
+        events.emplace_back (LOG4CPLUS_TEXT ("test"), INFO_LOG_LEVEL,
+            helpers::convertIntegerToString (i), __FILE__, __LINE__);
+
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("UseLockFile"), LOG4CPLUS_TEXT ("true"));
+    props.setProperty (LOG4CPLUS_TEXT ("LockFile"), lock_file_name);
+    props.setProperty (LOG4CPLUS_TEXT ("Metrics"), LOG4CPLUS_TEXT ("true"));
+
+    CATCH_SECTION ("without limit")
+    {
+        helpers::SharedObjectPtr<TestAppender> appender (
+            new TestAppender (props));
+        appender->syncDoAppendBatch (events);
+        CATCH_REQUIRE (appender->pieces == std::vector<std::size_t> {
+                event_count});
+        CATCH_REQUIRE (appender->mismatches == 0);
+    }
+
+    CATCH_SECTION ("with limit")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("MaxLockHoldMs"),
+            LOG4CPLUS_TEXT ("1"));
+        helpers::SharedObjectPtr<TestAppender> appender (
+            new TestAppender (props));
+        appender->syncDoAppendBatch (events);
+        CATCH_REQUIRE (appender->pieces.size () > 1);
+        for (std::size_t piece : appender->pieces)
+            CATCH_REQUIRE (piece <= static_cast<std::size_t> (
+                    lock_hold_piece));
+        CATCH_REQUIRE (appender->next == event_count);
+        CATCH_REQUIRE (appender->mismatches == 0);
+        CATCH_REQUIRE (appender->getMetrics ().events == event_count);
+    }
+
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (lock_file_name).c_str ());
+}
+#endif
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Layouts with equal configuration share output", "[appender]")
+{
+    struct CountingLayout
+        : Layout
+    {
+        explicit CountingLayout (unsigned key) { cacheKey = key; }
+
+        using Layout::formatAndAppend;
+        void formatAndAppend (tostream & output,
+            spi::InternalLoggingEvent const & ev) override
+        {
+            ++calls;
+            output << ev.getMessage () << LOG4CPLUS_TEXT ('\n');
+        }
+
+        std::size_t calls = 0;
+    };
+
+    struct TestAppender
+        : Appender
+    {
+        explicit TestAppender (unsigned key)
+            : layout (new CountingLayout (key))
+        {
+            setLayout (std::unique_ptr<Layout> (layout));
+        }
+
+        ~TestAppender () { destructorImpl (); }
+
+        void close () override { }
+
+        CountingLayout * layout;
+        tstring output;
+
+    protected:
+        void append (spi::InternalLoggingEvent const & ev) override
+        {
+            output += formatEvent (ev);
+        }
+    };
+
+    CATCH_REQUIRE (PatternLayout (LOG4CPLUS_TEXT ("%m%n")).getCacheKey ()
+        == PatternLayout (LOG4CPLUS_TEXT ("%m%n")).getCacheKey ());
+    CATCH_REQUIRE (PatternLayout (LOG4CPLUS_TEXT ("%m%n")).getCacheKey ()
+        != PatternLayout (LOG4CPLUS_TEXT ("%m")).getCacheKey ());
+    CATCH_REQUIRE (SimpleLayout ().getCacheKey () == 0);
+
+    unsigned const key = internal::get_layout_cache_key (
+        LOG4CPLUS_TEXT ("test layout"));
+    unsigned const other = internal::get_layout_cache_key (
+        LOG4CPLUS_TEXT ("other test layout"));
+    helpers::SharedObjectPtr<TestAppender> first (new TestAppender (key));
+    helpers::SharedObjectPtr<TestAppender> second (new TestAppender (key));
+    helpers::SharedObjectPtr<TestAppender> third (new TestAppender (other));
+    helpers::AppenderAttachableImpl appenders;
+    appenders.addAppender (SharedAppenderPtr (first.get ()));
+    appenders.addAppender (SharedAppenderPtr (second.get ()));
+    appenders.addAppender (SharedAppenderPtr (third.get ()));
+
+    spi::InternalLoggingEvent ev (LOG4CPLUS_TEXT ("test"), INFO_LOG_LEVEL,
+        LOG4CPLUS_TEXT ("1"), __FILE__, __LINE__);
+    appenders.appendLoopOnAppenders (ev);
+    // The same object with different content.
+    ev.setLoggingEvent (LOG4CPLUS_TEXT ("test"), INFO_LOG_LEVEL,
+        LOG4CPLUS_TEXT ("2"), __FILE__, __LINE__);
+    appenders.appendLoopOnAppenders (ev);
+
+    tstring const expected (LOG4CPLUS_TEXT ("1\n2\n"));
+    CATCH_REQUIRE (first->output == expected);
+    CATCH_REQUIRE (second->output == expected);
+    CATCH_REQUIRE (third->output == expected);
+    CATCH_REQUIRE (first->layout->calls + second->layout->calls == 2);
+    CATCH_REQUIRE (third->layout->calls == 2);
+
+    // Appended outside of a logger, the event is formatted by each.
+    first->doAppend (ev);
+    second->doAppend (ev);
+    CATCH_REQUIRE (first->layout->calls + second->layout->calls == 4);
+}
+#endif
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) \
+    && ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+CATCH_TEST_CASE ("Asynchronous append", "[appender]")
+{
+    struct TestAppender
+        : Appender
+    {
+        explicit TestAppender (helpers::Properties const & props)
+            : Appender (props)
+        { }
+
+        ~TestAppender () { destructorImpl (); }
+
+        void close () override { closed = true; }
+
+        std::atomic<std::size_t> events {0};
+        std::atomic<std::size_t> mismatches {0};
+        //! Next expected sequence number of each producing thread.
+        std::size_t next[4] {};
+
+    protected:
+        void append (spi::InternalLoggingEvent const & ev) override
+        {
+            // Only NDC is read by the layout; thread name is not copied.
+            if (ev.getNDC () != ev.getMessage () || ! ev.getThread ().empty ())
+                ++mismatches;
+
+            // Events of each thread arrive in order of appending.
+            std::size_t & expected = next[std::stoul (ev.getMessage ())];
+            if (std::stoul (ev.getLoggerName ()) != expected++)
+                ++mismatches;
+            ++events;
+        }
+    };
+
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("AsyncAppend"), LOG4CPLUS_TEXT ("true"));
+    helpers::SharedObjectPtr<TestAppender> appender (new TestAppender (props));
+    appender->setLayout (std::make_unique<PatternLayout> (
+        LOG4CPLUS_TEXT ("%x - %m%n")));
+
+    std::size_t const thread_count = 4;
+    std::size_t const event_count = 5000;
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i != thread_count; ++i)
+        threads.emplace_back (
+            [&appender, i]
+            {
+                tstring const context
+                    = helpers::convertIntegerToString (i);
+                NDCContextCreator ndc (context);
+                for (std::size_t j = 0; j != event_count; ++j)
+                {
+                    spi::InternalLoggingEvent ev (
+                        helpers::convertIntegerToString (j), INFO_LOG_LEVEL,
+                        context, __FILE__, __LINE__);
+                    appender->doAppend (ev);
+                }
+            });
+    for (auto & thread : threads)
+        thread.join ();
+
+    appender->waitToFinishAsyncLogging ();
+    CATCH_REQUIRE (appender->events == thread_count * event_count);
+    CATCH_REQUIRE (appender->mismatches == 0);
+
+    thread::QueueStats const stats = getThreadPoolQueueStats ();
+    CATCH_REQUIRE (stats.batchedEvents >= thread_count * event_count);
+    CATCH_REQUIRE (stats.highWaterMark >= 1);
+}
+#endif
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) \
+    && ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+CATCH_TEST_CASE ("Asynchronous fan-out", "[appender]")
+{
+    struct TestAppender
+        : Appender
+    {
+        explicit TestAppender (helpers::Properties const & props)
+            : Appender (props)
+        { }
+
+        ~TestAppender () { destructorImpl (); }
+
+        void close () override { closed = true; }
+
+        std::vector<spi::InternalLoggingEvent const *> events;
+
+    protected:
+        void append (spi::InternalLoggingEvent const & ev) override
+        {
+            events.push_back (&ev);
+        }
+    };
+
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("AsyncAppend"), LOG4CPLUS_TEXT ("true"));
+    props.setProperty (LOG4CPLUS_TEXT ("AsyncFanOut"), LOG4CPLUS_TEXT ("true"));
+    helpers::SharedObjectPtr<TestAppender> first (new TestAppender (props));
+    helpers::SharedObjectPtr<TestAppender> second (new TestAppender (props));
+    CATCH_REQUIRE (first->isAsyncFanOut ());
+
+    helpers::AppenderAttachableImpl attachable;
+    attachable.addAppender (SharedAppenderPtr (first.get ()));
+    attachable.addAppender (SharedAppenderPtr (second.get ()));
+
+    std::size_t const event_count = 10;
+    for (std::size_t i = 0; i != event_count; ++i)
+        attachable.appendLoopOnAppenders (spi::InternalLoggingEvent (
+                LOG4CPLUS_TEXT ("test"), INFO_LOG_LEVEL,
+                helpers::convertIntegerToString (i), __FILE__, __LINE__));
+
+    first->waitToFinishAsyncLogging ();
+    second->waitToFinishAsyncLogging ();
+
+    // Both appenders have seen the same copy of each event.
+    CATCH_REQUIRE (first->events.size () == event_count);
+    CATCH_REQUIRE (first->events == second->events);
+    attachable.removeAllAppenders ();
+}
+#endif
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) \
+    && defined (LOG4CPLUS_USE_PTHREADS) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+CATCH_TEST_CASE ("Asynchronous append across fork", "[appender]")
+{
+    struct TestAppender
+        : Appender
+    {
+        explicit TestAppender (helpers::Properties const & props)
+            : Appender (props)
+        { }
+
+        ~TestAppender () { destructorImpl (); }
+
+        void close () override { closed = true; }
+
+        std::atomic<std::size_t> events {0};
+
+    protected:
+        void append (spi::InternalLoggingEvent const &) override
+        {
+            ++events;
+        }
+    };
+
+    helpers::Properties pool_props;
+    pool_props.setProperty (LOG4CPLUS_TEXT ("AsyncAppend"),
+        LOG4CPLUS_TEXT ("true"));
+    helpers::SharedObjectPtr<TestAppender> pooled (
+        new TestAppender (pool_props));
+    helpers::SharedObjectPtr<TestAppender> queued (
+        new TestAppender (helpers::Properties ()));
+    AsyncAppenderPtr async (
+        new AsyncAppender (SharedAppenderPtr (queued.get ()), 16));
+
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+        INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"), __FILE__, __LINE__);
+
+    // Keep both paths busy while the main thread forks.
+    std::atomic<bool> stop {false};
+    std::thread producer (
+        [&]
+        {
+            while (! stop.load (std::memory_order_relaxed))
+            {
+                pooled->doAppend (ev);
+                async->doAppend (ev);
+            }
+        });
+
+    std::size_t const event_count = 100;
+    for (int i = 0; i != 5; ++i)
+    {
+        pid_t const child = fork ();
+        if (child == 0)
+        {
+            // Nothing is in flight in the child and both paths have
+            // new threads consuming the events.
+            std::size_t const pooled_before = pooled->events;
+            std::size_t const queued_before = queued->events;
+            for (std::size_t j = 0; j != event_count; ++j)
+            {
+                pooled->doAppend (ev);
+                async->doAppend (ev);
+            }
+            pooled->waitToFinishAsyncLogging ();
+            async->close ();
+            _exit (pooled->events == pooled_before + event_count
+                && queued->events == queued_before + event_count ? 0 : 1);
+        }
+        CATCH_REQUIRE (child > 0);
+        int status = -1;
+        CATCH_REQUIRE (waitpid (child, &status, 0) == child);
+        CATCH_REQUIRE (WIFEXITED (status));
+        CATCH_REQUIRE (WEXITSTATUS (status) == 0);
+    }
+
+    stop = true;
+    producer.join ();
+    pooled->waitToFinishAsyncLogging ();
+    async->close ();
+    CATCH_REQUIRE (async->getDroppedEventsCount () == 0);
+}
+#endif
+
+
 } // namespace log4cplus
@@ -24,8 +24,12 @@
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/thread/lockprofile.h>
+#include <log4cplus/internal/internal.h>
 
 #include <algorithm>
+#include <limits>
+#include <memory>
 
 
 namespace log4cplus
@@ -50,7 +54,23 @@ namespace helpers
 // log4cplus::helpers::AppenderAttachableImpl ctor and dtor
 //////////////////////////////////////////////////////////////////////////////
 
-AppenderAttachableImpl::AppenderAttachableImpl() = default;
+//! Shared by appender list mutexes of all loggers and appenders.
+static thread::LockSite appender_list_mutex_site (
+    "AppenderAttachableImpl::appender_list_mutex");
+
+
+AppenderAttachableImpl::AppenderAttachableImpl()
+    : own_appender_list_mutex (
+        std::make_unique<thread::Mutex> (appender_list_mutex_site))
+    , appender_list_mutex (*own_appender_list_mutex)
+    , listSummary (0)
+{ }
+
+
+AppenderAttachableImpl::AppenderAttachableImpl(thread::Mutex & listMutex)
+    : appender_list_mutex (listMutex)
+    , listSummary (0)
+{ }
 
 
 AppenderAttachableImpl::~AppenderAttachableImpl() = default;
@@ -72,11 +92,16 @@ AppenderAttachableImpl::addAppender(SharedAppenderPtr newAppender)
 
     thread::MutexGuard guard (appender_list_mutex);
 
-    auto it = std::find(appenderList.begin(), appenderList.end(), newAppender);
-    if (it == appenderList.end())
-    {
-        appenderList.push_back(newAppender);
-    }
+    ListPtr const list = getAppenderList ();
+    if (list
+        && std::find(list->begin(), list->end(), newAppender) != list->end())
+        return;
+
+    auto newList = list
+        ? std::make_shared<ListType>(*list)
+        : std::make_shared<ListType>();
+    newList->push_back(std::move(newAppender));
+    setAppenderList(std::move(newList));
 }
 
 
@@ -84,9 +109,11 @@ AppenderAttachableImpl::addAppender(SharedAppenderPtr newAppender)
 AppenderAttachableImpl::ListType
 AppenderAttachableImpl::getAllAppenders()
 {
-    thread::MutexGuard guard (appender_list_mutex);
-
-    return appenderList;
+    ListPtr const list = getAppenderList ();
+    if (list)
+        return *list;
+    else
+        return ListType ();
 }
 
 
@@ -94,9 +121,11 @@ AppenderAttachableImpl::getAllAppenders()
 SharedAppenderPtr
 AppenderAttachableImpl::getAppender(const log4cplus::tstring& name)
 {
-    thread::MutexGuard guard (appender_list_mutex);
+    ListPtr const list = getAppenderList ();
+    if (! list)
+        return SharedAppenderPtr ();
 
-    for (SharedAppenderPtr & ptr : appenderList)
+    for (SharedAppenderPtr const & ptr : *list)
     {
         if (ptr->getName() == name)
             return ptr;
@@ -112,14 +141,17 @@ AppenderAttachableImpl::removeAllAppenders()
 {
     thread::MutexGuard guard (appender_list_mutex);
 
+    ListPtr list = setAppenderList (ListPtr ());
+
     // Clear appenders in specific order because the order of destruction of
     // std::vector elements is surprisingly unspecified and it breaks our
-    // tests' expectations.
-
-    for (auto & app : appenderList)
-        app = SharedAppenderPtr ();
+    // tests' expectations. This is only possible when no append loop is
+    // still holding the old snapshot; it is not published any more so the
+    // use count cannot grow.
 
-    appenderList.clear ();
+    if (list && list.use_count () == 1)
+        for (auto & app : *list)
+            app = SharedAppenderPtr ();
 }
 
 
@@ -135,10 +167,16 @@ AppenderAttachableImpl::removeAppender(SharedAppenderPtr appender)
 
     thread::MutexGuard guard (appender_list_mutex);
 
-    auto it = std::find(appenderList.begin(), appenderList.end(), appender);
-    if (it != appenderList.end())
+    ListPtr const list = getAppenderList ();
+    if (! list)
+        return;
+
+    auto it = std::find(list->begin(), list->end(), appender);
+    if (it != list->end())
     {
-        appenderList.erase(it);
+        auto newList = std::make_shared<ListType>(*list);
+        newList->erase(newList->begin() + (it - list->begin()));
+        setAppenderList(newList->empty () ? ListPtr () : std::move(newList));
     }
 }
 
@@ -155,20 +193,130 @@ AppenderAttachableImpl::removeAppender(const log4cplus::tstring& name)
 int
 AppenderAttachableImpl::appendLoopOnAppenders(const spi::InternalLoggingEvent& event) const
 {
+    std::uint64_t const summary = getListSummary ();
+    if (event.getLogLevel () < static_cast<LogLevel> (summary & 0xFFFF))
+        return static_cast<int> ((summary >> 16) & 0xFFFF);
+
     int count = 0;
 
-    thread::MutexGuard guard (appender_list_mutex);
+    ListPtr const list = getAppenderList ();
+    if (! list)
+        return count;
+
+    // Asynchronous appenders with fan-out share one copy of the event
+    // when there are more of them.
+    std::size_t fan_out = 0;
+    unsigned fields = spi::EVENT_FIELDS_NONE;
+    for (auto const & appender : *list)
+        if (appender->isAsyncFanOut ()
+            && appender->isAsSevereAsThreshold (event.getLogLevel ()))
+        {
+            ++fan_out;
+            fields |= appender->getRequiredEventFields ();
+        }
+
+    std::shared_ptr<spi::InternalLoggingEvent> shared;
+    if (fan_out > 1)
+    {
+        shared = std::make_shared<spi::InternalLoggingEvent> ();
+        shared->assign (event, fields);
+    }
 
-    for (auto & appender : appenderList)
+    internal::layout_cache_scope layout_cache (event);
+    for (auto & appender : *list)
     {
         ++count;
-        appender->doAppend(event);
+        if (shared && appender->isAsyncFanOut ())
+            appender->doAppendShared(shared);
+        else
+            appender->doAppend(event);
     }
 
     return count;
 }
 
 
+int
+AppenderAttachableImpl::appendLoopOnAppenders(
+    std::span<spi::InternalLoggingEvent const> events) const
+{
+    int count = 0;
+
+    ListPtr const list = getAppenderList ();
+    if (! list)
+        return count;
+
+    for (auto & appender : *list)
+    {
+        ++count;
+        appender->doAppendBatch(events);
+    }
+
+    return count;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// log4cplus::helpers::AppenderAttachableImpl protected methods
+///////////////////////////////////////////////////////////////////////////////
+
+AppenderAttachableImpl::ListPtr
+AppenderAttachableImpl::getAppenderList() const
+{
+    return appenderList.load (std::memory_order_acquire);
+}
+
+
+AppenderAttachableImpl::ListPtr
+AppenderAttachableImpl::setAppenderList(ListPtr list)
+{
+    ListPtr old = appenderList.exchange (std::move (list),
+        std::memory_order_acq_rel);
+    internal::invalidate_pre_filter_caches ();
+    return old;
+}
+
+
+LogLevel
+AppenderAttachableImpl::getMinThreshold() const
+{
+    return static_cast<LogLevel> (getListSummary () & 0xFFFF);
+}
+
+
+std::uint64_t
+AppenderAttachableImpl::getListSummary() const
+{
+    std::uint64_t const cached = listSummary.load (std::memory_order_relaxed);
+    unsigned const generation
+        = internal::pre_filter_generation.load (std::memory_order_acquire);
+    if (static_cast<unsigned> (cached >> 32) == generation)
+        return cached;
+
+    // Saturated values only make the skip in appendLoopOnAppenders()
+    // less eager.
+    std::uint64_t count = 0;
+    std::uint64_t threshold = 0;
+    ListPtr const list = getAppenderList ();
+    if (list && ! list->empty ())
+    {
+        count = (std::min) (list->size (), std::size_t (0xFFFF));
+        LogLevel min_threshold = (std::numeric_limits<LogLevel>::max) ();
+        for (auto const & appender : *list)
+            min_threshold = (std::min) (min_threshold,
+                appender->getThreshold ());
+        threshold = static_cast<std::uint64_t> (
+            std::clamp<LogLevel> (min_threshold, ALL_LOG_LEVEL, 0xFFFF));
+    }
+
+    std::uint64_t const summary = (std::uint64_t (generation) << 32)
+        | (count << 16) | threshold;
+    listSummary.store (summary, std::memory_order_relaxed);
+    return summary;
+}
+
+
 } // namespace helpers
 
 
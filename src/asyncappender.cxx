@@ -28,7 +28,22 @@
 #include <log4cplus/spi/factory.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/loggingmacros.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/internal/internal.h>
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <map>
+#include <set>
+#include <catch.hpp>
+#endif
 
 
 namespace log4cplus
@@ -43,20 +58,30 @@ class QueueThread
     : public thread::AbstractThread
 {
 public:
-    QueueThread (AsyncAppenderPtr, thread::QueuePtr);
+    //! \param node Index of NUMA node the thread is restricted to, or
+    //! -1.
+    QueueThread (AsyncAppenderPtr, thread::QueuePtr, int node = -1);
 
     void run() override;
 
+    //! Drops references to the appender and the queue. Used in child
+    //! process after fork(), where the thread does not run.
+    void orphan ();
+
 private:
     AsyncAppenderPtr appenders;
     thread::QueuePtr queue;
+    int node;
 };
 
 
-QueueThread::QueueThread (AsyncAppenderPtr aai, thread::QueuePtr q)
+QueueThread::QueueThread (AsyncAppenderPtr aai, thread::QueuePtr q, int n)
     : appenders (std::move (aai))
     , queue (std::move (q))
-{ }
+    , node (n)
+{
+    setThreadRole (LOG4CPLUS_TEXT ("async"));
+}
 
 
 void
@@ -65,15 +90,26 @@ QueueThread::run()
     using ev_buf_type = log4cplus::thread::Queue::queue_storage_type;
     ev_buf_type ev_buf;
 
+#if defined (LOG4CPLUS_USE_PTHREADS)
+    internal::fork_gate_guard::exempt_current_thread ();
+#endif
+
+    if (node >= 0 && ! thread::setCurrentThreadNumaNode (
+            static_cast<unsigned> (node)))
+        helpers::getLogLog ().debug (
+            LOG4CPLUS_TEXT ("Queue thread not restricted to NUMA node ")
+            + helpers::convertIntegerToString (node));
+
     while (true)
     {
         unsigned qflags = queue->get_events (&ev_buf);
         if (qflags & thread::Queue::EVENT)
         {
-            auto const ev_buf_end = ev_buf.end ();
-            for (auto it = ev_buf.begin ();
-                it != ev_buf_end; ++it)
-                appenders->appendLoopOnAppenders (*it);
+            appenders->appendLoopOnAppenders (
+                std::span<spi::InternalLoggingEvent const> (ev_buf));
+
+            if (queue->empty ())
+                appenders->reportDroppedEvents ();
         }
 
         if (((thread::Queue::EXIT | thread::Queue::DRAIN
@@ -87,11 +123,236 @@ QueueThread::run()
 }
 
 
+void
+QueueThread::orphan ()
+{
+    appenders = AsyncAppenderPtr ();
+    queue = thread::QueuePtr ();
+}
+
+
+//! Reads size in bytes, suffixes "KB" and "MB" are recognized.
+std::size_t
+read_byte_size (helpers::Properties const & props, tchar const * key)
+{
+    tstring const str (helpers::toUpper (props.getProperty (key)));
+    if (str.empty ())
+        return 0;
+
+    std::size_t size = std::strtoul (
+        LOG4CPLUS_TSTRING_TO_STRING (str).c_str (), nullptr, 10);
+    tstring::size_type const len = str.length ();
+    if (len > 2 && str.compare (len - 2, 2, LOG4CPLUS_TEXT ("MB")) == 0)
+        size *= (1024 * 1024); // convert to megabytes
+    else if (len > 2 && str.compare (len - 2, 2, LOG4CPLUS_TEXT ("KB")) == 0)
+        size *= 1024; // convert to kilobytes
+    return size;
+}
+
+
+//! Reads <tt>OverflowPolicy</tt> and <tt>OverflowLogLevel</tt>
+//! properties.
+void
+read_overflow_policy (helpers::Properties const & props,
+    AsyncAppender::OverflowPolicy & policy, LogLevel & overflow_ll)
+{
+    tstring const policy_str (helpers::toUpper (
+        props.getProperty (LOG4CPLUS_TEXT ("OverflowPolicy"))));
+    if (policy_str.empty () || policy_str == LOG4CPLUS_TEXT ("BLOCK"))
+        policy = AsyncAppender::BLOCK;
+    else if (policy_str == LOG4CPLUS_TEXT ("DROPNEWEST"))
+        policy = AsyncAppender::DROP_NEWEST;
+    else if (policy_str == LOG4CPLUS_TEXT ("DROPOLDEST"))
+        policy = AsyncAppender::DROP_OLDEST;
+    else if (policy_str == LOG4CPLUS_TEXT ("DROPBELOWLEVEL"))
+        policy = AsyncAppender::DROP_BELOW_LEVEL;
+    else
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("AsyncAppender::AsyncAppender()")
+            LOG4CPLUS_TEXT (" - \"OverflowPolicy\" not valid: ")
+            + props.getProperty (LOG4CPLUS_TEXT ("OverflowPolicy")));
+
+    tstring const & overflow_ll_str
+        = props.getProperty (LOG4CPLUS_TEXT ("OverflowLogLevel"));
+    if (! overflow_ll_str.empty ())
+    {
+        LogLevel const ll = getLogLevelManager ().fromString (
+            helpers::toUpper (overflow_ll_str));
+        if (ll != NOT_SET_LOG_LEVEL)
+            overflow_ll = ll;
+    }
+}
+
+
+//! \return Number of queue threads for <tt>ConsumerThreads</tt>
+//! <code>count</code>; zero stands for one thread, or one per NUMA node
+//! when events are hashed by node.
+unsigned
+consumer_thread_count (unsigned count, AsyncAppender::ConsumerKey key)
+{
+    if (count != 0)
+        return count;
+    else if (key == AsyncAppender::CONSUMER_KEY_NODE)
+        return thread::getNumaNodeCount ();
+    else
+        return 1;
+}
+
+
+//! Adds counters of <code>stats</code> to <code>total</code>.
+void
+add_stats (thread::QueueStats & total, thread::QueueStats const & stats)
+{
+    total.capacity += stats.capacity;
+    total.depth += stats.depth;
+    total.highWaterMark = (std::max) (total.highWaterMark,
+        stats.highWaterMark);
+    total.blockedPuts += stats.blockedPuts;
+    total.blockedTime += stats.blockedTime;
+    total.batches += stats.batches;
+    total.batchedEvents += stats.batchedEvents;
+    total.maxBatch = (std::max) (total.maxBatch, stats.maxBatch);
+    total.oldestEventAge = (std::max) (total.oldestEventAge,
+        stats.oldestEventAge);
+    total.queuedBytes += stats.queuedBytes;
+    total.maxBytes += stats.maxBytes;
+}
+
+
 } // namespace
 
 
+#if defined (LOG4CPLUS_USE_PTHREADS)
+namespace internal
+{
+
+//! Open AsyncAppender instances, for fork handlers.
+struct async_appender_registry
+{
+    std::mutex mtx;
+    std::vector<AsyncAppender *> appenders;
+
+    static
+    async_appender_registry &
+    get ()
+    {
+        // Leaked so that appenders closed during static destruction
+        // can still remove themselves.
+        static async_appender_registry * const registry
+            = new async_appender_registry;
+        return *registry;
+    }
+
+    void
+    remove (AsyncAppender * app)
+    {
+        std::lock_guard<std::mutex> guard (mtx);
+        appenders.erase (std::remove (appenders.begin (), appenders.end (),
+            app), appenders.end ());
+    }
+
+    static
+    bool
+    idle (AsyncAppender const & app)
+    {
+        return std::all_of (app.queues.begin (), app.queues.end (),
+            [] (thread::QueuePtr const & queue) { return queue->idle (); });
+    }
+
+    //! Replaces queue and queue thread of <code>app</code> in child
+    //! process after fork().
+    static
+    void
+    restart (AsyncAppender & app)
+    {
+        if (app.queue_threads.empty ())
+            return;
+
+        // Neither std::thread of the queue threads, which do not
+        // exist in the child, nor synchronization objects of the
+        // queues can be destroyed here, so both are leaked.
+        std::vector<thread::AbstractThreadPtr> const old_threads
+            = std::move (app.queue_threads);
+        std::vector<thread::QueuePtr> const old_queues
+            = std::move (app.queues);
+        app.queue_threads.clear ();
+        app.queues.clear ();
+        for (std::size_t i = 0; i != old_threads.size (); ++i)
+        {
+            old_threads[i]->addReference ();
+            old_queues[i]->addReference ();
+        }
+
+        try
+        {
+            for (thread::QueuePtr const & old_queue : old_queues)
+            {
+                app.queues.emplace_back (old_queue->clone_empty ());
+                app.queue_threads.push_back (app.make_queue_thread (
+                    app.queues.back (), app.queues.size () - 1));
+                app.queue_threads.back ()->start ();
+            }
+        }
+        catch (...)
+        {
+            // append() falls back to synchronous operation.
+            for (thread::QueuePtr const & queue : app.queues)
+                queue->signal_exit (false);
+            for (thread::AbstractThreadPtr const & queue_thread
+                     : app.queue_threads)
+                if (queue_thread->isRunning ())
+                    queue_thread->join ();
+            app.queue_threads.clear ();
+            app.queues.clear ();
+        }
+
+        for (thread::AbstractThreadPtr const & old_thread : old_threads)
+            static_cast<QueueThread &> (*old_thread).orphan ();
+    }
+};
+
+
+void
+async_appenders_lock_for_fork ()
+{
+    async_appender_registry::get ().mtx.lock ();
+}
+
+
+bool
+async_appenders_idle ()
+{
+    async_appender_registry const & registry = async_appender_registry::get ();
+    return std::all_of (registry.appenders.begin (), registry.appenders.end (),
+        [] (AsyncAppender const * app) {
+            return async_appender_registry::idle (*app); });
+}
+
+
+void
+async_appenders_after_fork (bool child)
+{
+    async_appender_registry & registry = async_appender_registry::get ();
+    if (child)
+        for (AsyncAppender * app : registry.appenders)
+            async_appender_registry::restart (*app);
+
+    registry.mtx.unlock ();
+}
+
+} // namespace internal
+#endif
+
+
 AsyncAppender::AsyncAppender (SharedAppenderPtr const & app,
     unsigned queue_len)
+    : consumerThreads (1)
+    , consumerKey (CONSUMER_KEY_LOGGER)
+    , overflowPolicy (BLOCK)
+    , overflowLogLevel (WARN_LOG_LEVEL)
+    , reportDropped (false)
+    , droppedEvents (0)
+    , unreportedDroppedEvents (0)
 {
     addAppender (app);
     init_queue_thread (queue_len);
@@ -100,6 +361,13 @@ AsyncAppender::AsyncAppender (SharedAppenderPtr const & app,
 
 AsyncAppender::AsyncAppender (helpers::Properties const & props)
     : Appender (props)
+    , consumerThreads (1)
+    , consumerKey (CONSUMER_KEY_LOGGER)
+    , overflowPolicy (BLOCK)
+    , overflowLogLevel (WARN_LOG_LEVEL)
+    , reportDropped (false)
+    , droppedEvents (0)
+    , unreportedDroppedEvents (0)
 {
     tstring const & appender_name (
         props.getProperty (LOG4CPLUS_TEXT ("Appender")));
@@ -125,10 +393,92 @@ AsyncAppender::AsyncAppender (helpers::Properties const & props)
         LOG4CPLUS_TEXT ("Appender."));
     addAppender (factory->createObject (appender_props));
 
-    unsigned queue_len = 100;
+    std::size_t const max_bytes = read_byte_size (props,
+        LOG4CPLUS_TEXT ("QueueMaxBytes"));
+
+    // With byte limit, the count limit only bounds preallocated slots.
+    unsigned queue_len = max_bytes != 0 ? 1024 : 100;
     props.getUInt (queue_len, LOG4CPLUS_TEXT ("QueueLimit"));
 
+    read_overflow_policy (props, overflowPolicy, overflowLogLevel);
+
+    props.getBool (reportDropped, LOG4CPLUS_TEXT ("ReportDroppedEvents"));
+
+    helpers::Properties const lane_props
+        = props.getPropertySubset (LOG4CPLUS_TEXT ("Lanes."));
+    for (unsigned i = 1; ; ++i)
+    {
+        helpers::Properties const one_lane = lane_props.getPropertySubset (
+            helpers::convertIntegerToString (i) + LOG4CPLUS_TEXT ("."));
+        tstring const & threshold_str
+            = one_lane.getProperty (LOG4CPLUS_TEXT ("Threshold"));
+        if (threshold_str.empty ())
+            break;
+
+        Lane lane;
+        lane.threshold = getLogLevelManager ().fromString (
+            helpers::toUpper (threshold_str));
+        if (lane.threshold == NOT_SET_LOG_LEVEL)
+        {
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("AsyncAppender::AsyncAppender()")
+                LOG4CPLUS_TEXT (" - lane \"Threshold\" not valid: ")
+                + threshold_str);
+            continue;
+        }
+
+        lane.maxBytes = read_byte_size (one_lane,
+            LOG4CPLUS_TEXT ("QueueMaxBytes"));
+        one_lane.getUInt (lane.queueLimit, LOG4CPLUS_TEXT ("QueueLimit"));
+        read_overflow_policy (one_lane, lane.overflowPolicy,
+            lane.overflowLogLevel);
+        lanes.push_back (lane);
+    }
+
+    // The most important lane is drained first.
+    std::stable_sort (lanes.begin (), lanes.end (),
+        [] (Lane const & a, Lane const & b) {
+            return a.threshold > b.threshold; });
+
+    sequenceKey = props.getProperty (LOG4CPLUS_TEXT ("SequenceKey"));
+
+    unsigned consumer_threads = 0;
+    props.getUInt (consumer_threads, LOG4CPLUS_TEXT ("ConsumerThreads"));
+    tstring const consumer_key_str (helpers::toUpper (
+        props.getProperty (LOG4CPLUS_TEXT ("ConsumerKey"))));
+    if (consumer_key_str.empty ()
+        || consumer_key_str == LOG4CPLUS_TEXT ("LOGGER"))
+        consumerKey = CONSUMER_KEY_LOGGER;
+    else if (consumer_key_str == LOG4CPLUS_TEXT ("THREAD"))
+        consumerKey = CONSUMER_KEY_THREAD;
+    else if (consumer_key_str == LOG4CPLUS_TEXT ("MDC"))
+        consumerKey = CONSUMER_KEY_MDC;
+    else if (consumer_key_str == LOG4CPLUS_TEXT ("NODE"))
+        consumerKey = CONSUMER_KEY_NODE;
+    else
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("AsyncAppender::AsyncAppender()")
+            LOG4CPLUS_TEXT (" - \"ConsumerKey\" not valid: ")
+            + props.getProperty (LOG4CPLUS_TEXT ("ConsumerKey")));
+    consumerMDCKey = props.getProperty (LOG4CPLUS_TEXT ("ConsumerMDCKey"));
+    consumerThreads = consumer_thread_count (consumer_threads, consumerKey);
+
+    unsigned high_water = 0;
+    props.getUInt (high_water, LOG4CPLUS_TEXT ("QueueHighWaterMark"));
+
     init_queue_thread (queue_len);
+    setQueueMaxBytes (max_bytes);
+
+    if (high_water != 0)
+        setHighWaterCallback (high_water,
+            [this] (std::size_t depth)
+            {
+                helpers::getLogLog ().warn (
+                    LOG4CPLUS_TEXT ("AsyncAppender named [") + name
+                    + LOG4CPLUS_TEXT ("] has ")
+                    + helpers::convertIntegerToString (depth)
+                    + LOG4CPLUS_TEXT (" queued events"));
+            });
 }
 
 
@@ -141,9 +491,34 @@ AsyncAppender::~AsyncAppender ()
 void
 AsyncAppender::init_queue_thread (unsigned queue_len)
 {
-    queue = new thread::Queue (queue_len);
-    queue_thread = new QueueThread (AsyncAppenderPtr (this), queue);
-    queue_thread->start ();
+    // Events are only queued here, fork handlers wait for them to be
+    // appended by the queue thread.
+    forkGate = true;
+
+#if defined (LOG4CPLUS_USE_PTHREADS)
+    internal::async_appender_registry & registry
+        = internal::async_appender_registry::get ();
+    std::lock_guard<std::mutex> guard (registry.mtx);
+#endif
+
+    thread::QueuePtr const first (new thread::Queue (queue_len));
+    for (Lane const & lane : lanes)
+        first->get_lane (first->add_lane (lane.queueLimit))
+            .set_max_bytes (lane.maxBytes);
+    first->set_sequence_key (sequenceKey);
+
+    // Clones share the sequence counter of the first queue.
+    for (unsigned i = 0; i != consumerThreads; ++i)
+    {
+        queues.push_back (i == 0 ? first
+            : thread::QueuePtr (first->clone_empty ()));
+        queue_threads.push_back (
+            make_queue_thread (queues.back (), i));
+        queue_threads.back ()->start ();
+    }
+#if defined (LOG4CPLUS_USE_PTHREADS)
+    registry.appenders.push_back (this);
+#endif
     helpers::getLogLog ().debug (LOG4CPLUS_TEXT("Queue thread started."));
 }
 
@@ -151,7 +526,12 @@ AsyncAppender::init_queue_thread (unsigned queue_len)
 void
 AsyncAppender::close ()
 {
-    if (queue)
+#if defined (LOG4CPLUS_USE_PTHREADS)
+    internal::async_appender_registry::get ().remove (this);
+#endif
+
+    // All queues are drained in parallel.
+    for (thread::QueuePtr const & queue : queues)
     {
         unsigned ret = queue->signal_exit ();
         if (ret & (thread::Queue::ERROR_BIT | thread::Queue::ERROR_AFTER))
@@ -159,33 +539,354 @@ AsyncAppender::close ()
                 LOG4CPLUS_TEXT ("Error in AsyncAppender::close"));
     }
 
-    if (queue_thread && queue_thread->isRunning ())
-        queue_thread->join ();
+    for (thread::AbstractThreadPtr const & queue_thread : queue_threads)
+        if (queue_thread->isRunning ())
+            queue_thread->join ();
 
     removeAllAppenders();
 
-    queue_thread = nullptr;
-    queue = nullptr;
+    queue_threads.clear ();
+    queues.clear ();
+}
+
+
+void
+AsyncAppender::setOverflowPolicy (OverflowPolicy policy, LogLevel ll)
+{
+    overflowPolicy = policy;
+    overflowLogLevel = ll;
+}
+
+
+AsyncAppender::OverflowPolicy
+AsyncAppender::getOverflowPolicy () const
+{
+    return overflowPolicy;
+}
+
+
+void
+AsyncAppender::setReportDroppedEvents (bool report)
+{
+    reportDropped = report;
+}
+
+
+std::size_t
+AsyncAppender::getDroppedEventsCount () const
+{
+    return droppedEvents.load (std::memory_order_relaxed);
+}
+
+
+void
+AsyncAppender::event_dropped ()
+{
+    droppedEvents.fetch_add (1, std::memory_order_relaxed);
+    unreportedDroppedEvents.fetch_add (1, std::memory_order_relaxed);
+    recordDroppedEvent ();
+}
+
+
+thread::QueueStats
+AsyncAppender::getQueueStats () const
+{
+    thread::QueueStats stats;
+    for (thread::QueuePtr const & queue : queues)
+        add_stats (stats, queue->get_stats ());
+    return stats;
+}
+
+
+void
+AsyncAppender::emergencyDump (EmergencyEventVisitor visitor, void * arg)
+    noexcept
+{
+    for (thread::QueuePtr const & queue : queues)
+        queue->emergency_visit (visitor, arg);
+}
+
+
+void
+AsyncAppender::setHighWaterCallback (std::size_t highWater,
+    thread::HighWaterCallback callback)
+{
+    for (thread::QueuePtr const & queue : queues)
+        queue->set_high_water_callback (highWater, callback);
+}
+
+
+void
+AsyncAppender::setQueueMaxBytes (std::size_t bytes)
+{
+    for (thread::QueuePtr const & queue : queues)
+        queue->set_max_bytes (bytes);
+}
+
+
+thread::QueueStats
+AsyncAppender::getLaneStats (std::size_t i) const
+{
+    thread::QueueStats stats;
+    for (thread::QueuePtr const & queue : queues)
+        if (i < queue->lane_count ())
+            add_stats (stats, queue->get_lane (i).get_stats ());
+    return stats;
+}
+
+
+bool
+AsyncAppender::setQueueLimit (unsigned len)
+{
+    return replace_queue (
+        [len] (thread::Queue const & old) {
+            return old.clone_empty (len); });
+}
+
+
+bool
+AsyncAppender::addLane (Lane const & lane)
+{
+    return replace_queue (
+        [&] (thread::Queue const & old)
+        {
+            thread::Queue * const new_queue = old.clone_empty ();
+            new_queue->get_lane (new_queue->add_lane (lane.queueLimit))
+                .set_max_bytes (lane.maxBytes);
+            lanes.push_back (lane);
+            return new_queue;
+        });
+}
+
+
+bool
+AsyncAppender::setConsumerThreads (unsigned count, ConsumerKey key,
+    tstring const & mdcKey)
+{
+    return replace_queue (
+        [&] (thread::Queue const & old)
+        {
+            consumerThreads = consumer_thread_count (count, key);
+            consumerKey = key;
+            consumerMDCKey = mdcKey;
+            return old.clone_empty ();
+        });
+}
+
+
+bool
+AsyncAppender::setSequenceKey (tstring const & key)
+{
+    return replace_queue (
+        [&] (thread::Queue const & old)
+        {
+            thread::Queue * const new_queue = old.clone_empty ();
+            new_queue->set_sequence_key (key);
+            sequenceKey = key;
+            return new_queue;
+        });
+}
+
+
+bool
+AsyncAppender::replace_queue (
+    std::function<thread::Queue * (thread::Queue const &)> const & make)
+{
+    // Logging threads put events into the queue under access_mutex.
+    thread::MutexGuard guard (access_mutex);
+    if (closed || queues.empty ()
+        || ! std::all_of (queue_threads.begin (), queue_threads.end (),
+            [] (thread::AbstractThreadPtr const & queue_thread) {
+                return queue_thread->isRunning (); }))
+        return false;
+
+    std::vector<thread::QueuePtr> new_queues;
+    std::vector<thread::AbstractThreadPtr> new_threads;
+    new_queues.emplace_back (make (*queues.front ()));
+    while (new_queues.size () != consumerThreads)
+        new_queues.emplace_back (new_queues.front ()->clone_empty ());
+    for (std::size_t i = 0; i != new_queues.size (); ++i)
+        new_threads.push_back (make_queue_thread (new_queues[i], i));
+
+    // Drain the old queues so that events stay in order.
+    for (thread::QueuePtr const & queue : queues)
+        queue->signal_exit ();
+    for (thread::AbstractThreadPtr const & queue_thread : queue_threads)
+        queue_thread->join ();
+    for (thread::AbstractThreadPtr const & new_thread : new_threads)
+        new_thread->start ();
+
+#if defined (LOG4CPLUS_USE_PTHREADS)
+    std::lock_guard<std::mutex> registry_guard (
+        internal::async_appender_registry::get ().mtx);
+#endif
+    queues = std::move (new_queues);
+    queue_threads = std::move (new_threads);
+    return true;
+}
+
+
+void
+AsyncAppender::reportDroppedEvents ()
+{
+    if (! reportDropped
+        || unreportedDroppedEvents.load (std::memory_order_relaxed) == 0)
+        return;
+
+    std::size_t const count
+        = unreportedDroppedEvents.exchange (0, std::memory_order_relaxed);
+    if (count == 0)
+        return;
+
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("log4cplus"),
+        WARN_LOG_LEVEL,
+        LOG4CPLUS_TEXT ("AsyncAppender [") + name
+        + LOG4CPLUS_TEXT ("]: ")
+        + helpers::convertIntegerToString (count)
+        + LOG4CPLUS_TEXT (" events dropped"),
+        __FILE__, __LINE__, LOG4CPLUS_MACRO_FUNCTION ());
+    appendLoopOnAppenders (ev);
+}
+
+
+bool
+AsyncAppender::isAsynchronous () const
+{
+    return true;
+}
+
+
+unsigned
+AsyncAppender::getRequiredEventFields () const
+{
+    // Own filters are checked before events are queued. Fields are
+    // needed only by the attached appenders.
+    unsigned fields = spi::EVENT_FIELDS_NONE;
+    if (ListPtr const list = getAppenderList ())
+        for (auto const & appender : *list)
+            fields |= appender->getRequiredEventFields ();
+
+    return fields;
+}
+
+
+thread::AbstractThreadPtr
+AsyncAppender::make_queue_thread (thread::QueuePtr const & queue,
+    std::size_t index)
+{
+    int const node = consumerKey == CONSUMER_KEY_NODE
+        ? static_cast<int> (index % thread::getNumaNodeCount ()) : -1;
+    return thread::AbstractThreadPtr (
+        new QueueThread (AsyncAppenderPtr (this), queue, node));
+}
+
+
+std::size_t
+AsyncAppender::consumer_index (spi::InternalLoggingEvent const & ev) const
+{
+    if (queues.size () == 1)
+        return 0;
+
+    tstring const * key;
+    switch (consumerKey)
+    {
+    case CONSUMER_KEY_THREAD:
+        key = &ev.getThread ();
+        break;
+
+    case CONSUMER_KEY_MDC:
+        key = &ev.getMDC (consumerMDCKey);
+        break;
+
+    case CONSUMER_KEY_NODE:
+        return thread::getCurrentNumaNode () % queues.size ();
+
+    case CONSUMER_KEY_LOGGER:
+    default:
+        key = &ev.getLoggerName ();
+        break;
+    }
+
+    return std::hash<tstring> () (*key) % queues.size ();
 }
 
 
 void
 AsyncAppender::append (spi::InternalLoggingEvent const & ev)
 {
-    if (queue_thread && queue_thread->isRunning ())
+    std::size_t const index = queues.empty () ? 0 : consumer_index (ev);
+    if (! queues.empty () && queue_threads[index]->isRunning ())
     {
-        unsigned ret = queue->put_event (ev);
+        unsigned const fields = getRequiredEventFields ();
+        thread::QueuePtr const & queue = queues[index];
+
+        // Event goes into the first lane whose threshold it meets.
+        thread::Queue * target = queue.get ();
+        OverflowPolicy policy = overflowPolicy;
+        LogLevel overflow_ll = overflowLogLevel;
+        LogLevel const ll = ev.getLogLevel ();
+        for (std::size_t i = 0; i != lanes.size (); ++i)
+            if (ll >= lanes[i].threshold)
+            {
+                target = &queue->get_lane (i);
+                policy = lanes[i].overflowPolicy;
+                overflow_ll = lanes[i].overflowLogLevel;
+                break;
+            }
+
+        unsigned ret;
+        switch (policy)
+        {
+        case DROP_NEWEST:
+            ret = target->try_put_event (ev, fields);
+            if (ret & thread::Queue::FULL)
+                event_dropped ();
+            break;
+
+        case DROP_OLDEST:
+            while ((ret = target->try_put_event (ev, fields))
+                & thread::Queue::FULL)
+            {
+                if (target->discard_oldest ())
+                    event_dropped ();
+                else
+                    // Oldest slot is still being filled by other
+                    // producer.
+                    std::this_thread::yield ();
+            }
+            break;
+
+        case DROP_BELOW_LEVEL:
+            ret = target->try_put_event (ev, fields);
+            if (ret & thread::Queue::FULL)
+            {
+                if (ll < overflow_ll)
+                    event_dropped ();
+                else
+                    ret = target->put_event (ev, fields);
+            }
+            break;
+
+        case BLOCK:
+        default:
+            ret = target->put_event (ev, fields);
+            break;
+        }
+
         if (ret & (thread::Queue::ERROR_BIT | thread::Queue::ERROR_AFTER))
         {
             getErrorHandler ()->error (
                 LOG4CPLUS_TEXT ("Error in AsyncAppender::append,")
                 LOG4CPLUS_TEXT (" event queue has been lost."));
-            // Exit the queue consumer thread without draining
-            // the events queue.
-            queue->signal_exit (false);
-            queue_thread->join ();
-            queue_thread = nullptr;
-            queue = nullptr;
+            // Exit the queue consumer threads without draining
+            // the events queues.
+            for (thread::QueuePtr const & q : queues)
+                q->signal_exit (false);
+            for (thread::AbstractThreadPtr const & queue_thread
+                     : queue_threads)
+                queue_thread->join ();
+            queue_threads.clear ();
+            queues.clear ();
             appendLoopOnAppenders (ev);
         }
     }
@@ -198,6 +899,81 @@ AsyncAppender::append (spi::InternalLoggingEvent const & ev)
 }
 
 
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("AsyncAppender consumer threads", "[appender]")
+{
+    struct TestAppender
+        : Appender
+    {
+        TestAppender ()
+        {
+            concurrentAppend = true;
+        }
+
+        ~TestAppender () { destructorImpl (); }
+
+        void close () override { closed = true; }
+
+        std::mutex mtx;
+        std::map<tstring, std::vector<tstring>> events;
+        std::set<std::thread::id> threads;
+
+    protected:
+        void append (spi::InternalLoggingEvent const & ev) override
+        {
+            std::lock_guard<std::mutex> guard (mtx);
+            events[ev.getLoggerName ()].push_back (ev.getMessage ());
+            threads.insert (std::this_thread::get_id ());
+        }
+    };
+
+    helpers::SharedObjectPtr<TestAppender> child (new TestAppender);
+    AsyncAppenderPtr async (
+        new AsyncAppender (SharedAppenderPtr (child.get ()), 16));
+    CATCH_REQUIRE (async->setConsumerThreads (4));
+    CATCH_REQUIRE (async->getQueueStats ().capacity == 4 * 16);
+
+    std::size_t const logger_count = 16;
+    std::size_t const event_count = 200;
+    for (std::size_t i = 0; i != event_count; ++i)
+        for (std::size_t j = 0; j != logger_count; ++j)
+            async->doAppend (spi::InternalLoggingEvent (
+                helpers::convertIntegerToString (j), INFO_LOG_LEVEL,
+                helpers::convertIntegerToString (i), __FILE__, __LINE__));
+    async->close ();
+
+    // Events of each logger keep their order.
+    CATCH_REQUIRE (child->events.size () == logger_count);
+    for (auto const & logger_events : child->events)
+    {
+        CATCH_REQUIRE (logger_events.second.size () == event_count);
+        for (std::size_t i = 0; i != event_count; ++i)
+            CATCH_REQUIRE (logger_events.second[i]
+                == helpers::convertIntegerToString (i));
+    }
+    CATCH_REQUIRE (child->threads.size () > 1);
+
+    // One queue per NUMA node, events of this thread go to its node.
+    helpers::SharedObjectPtr<TestAppender> node_child (new TestAppender);
+    AsyncAppenderPtr by_node (
+        new AsyncAppender (SharedAppenderPtr (node_child.get ()), 16));
+    CATCH_REQUIRE (by_node->setConsumerThreads (0,
+        AsyncAppender::CONSUMER_KEY_NODE));
+    unsigned const nodes = thread::getNumaNodeCount ();
+    CATCH_REQUIRE (thread::getCurrentNumaNode () < nodes);
+    CATCH_REQUIRE (by_node->getQueueStats ().capacity == nodes * 16);
+    for (std::size_t i = 0; i != event_count; ++i)
+        by_node->doAppend (spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("n"),
+            INFO_LOG_LEVEL, helpers::convertIntegerToString (i),
+            __FILE__, __LINE__));
+    by_node->close ();
+    CATCH_REQUIRE (node_child->events[LOG4CPLUS_TEXT ("n")].size ()
+        == event_count);
+}
+#endif
+
+
 } // namespace log4cplus
 
 
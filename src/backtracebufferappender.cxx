@@ -0,0 +1,386 @@
+// Module:  Log4cplus
+// File:    backtracebufferappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/backtracebufferappender.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/spi/factory.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <log4cplus/callbackappender.h>
+#include <log4cplus/mdc.h>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+struct buffer_key_hash
+{
+    using is_transparent = void;
+
+    std::size_t
+    operator () (tstring_view key) const noexcept
+    {
+        return std::hash<tstring_view> () (key);
+    }
+};
+
+
+typedef std::vector<spi::InternalLoggingEvent> event_slots;
+
+} // namespace
+
+
+struct BacktraceBufferAppender::Buffers
+{
+    //! Events of one thread or MDC value, oldest at <code>start</code>.
+    struct Ring
+    {
+        event_slots slots;
+        std::size_t start = 0;
+        std::size_t count = 0;
+        //! Position of the key in <code>lru</code>.
+        std::list<tstring const *>::iterator position;
+    };
+
+    std::unordered_map<tstring, Ring, buffer_key_hash, std::equal_to<>> map;
+    //! Keys of <code>map</code>, most recently used first.
+    std::list<tstring const *> lru;
+    //! Slots of the last dropped ring, reused by the next new one.
+    event_slots spare;
+    //! Key of the current event, reused between events.
+    tstring key;
+
+    Ring &
+    get (std::size_t bufferSize, std::size_t maxBuffers)
+    {
+        auto it = map.find (key);
+        if (it != map.end ())
+        {
+            lru.splice (lru.begin (), lru, it->second.position);
+            return it->second;
+        }
+
+        if (map.size () >= maxBuffers && ! lru.empty ())
+        {
+            auto const last = map.find (*lru.back ());
+            spare.swap (last->second.slots);
+            lru.pop_back ();
+            map.erase (last);
+        }
+
+        it = map.emplace (key, Ring ()).first;
+        Ring & ring = it->second;
+        ring.slots.swap (spare);
+        ring.slots.resize (bufferSize);
+        lru.push_front (&it->first);
+        ring.position = lru.begin ();
+        return ring;
+    }
+
+    //! Passes events of <code>ring</code> to <code>appenders</code>,
+    //! oldest first, and empties it.
+    static
+    void
+    flush (helpers::AppenderAttachableImpl const & appenders, Ring & ring)
+    {
+        std::size_t const size = ring.slots.size ();
+        std::size_t const first = (std::min) (ring.count, size - ring.start);
+        if (first != 0)
+            appenders.appendLoopOnAppenders (
+                std::span<spi::InternalLoggingEvent const> (
+                    ring.slots.data () + ring.start, first));
+        if (ring.count != first)
+            appenders.appendLoopOnAppenders (
+                std::span<spi::InternalLoggingEvent const> (
+                    ring.slots.data (), ring.count - first));
+
+        ring.start = 0;
+        ring.count = 0;
+    }
+};
+
+
+
+
+BacktraceBufferAppender::BacktraceBufferAppender (
+    SharedAppenderPtr const & app, std::size_t bufferSize_,
+    LogLevel triggerLevel_)
+    : bufferSize (bufferSize_)
+    , triggerLevel (triggerLevel_)
+    , maxBuffers (256)
+{
+    addAppender (app);
+    init ();
+}
+
+
+BacktraceBufferAppender::BacktraceBufferAppender (
+    helpers::Properties const & props)
+    : Appender (props)
+    , bufferSize (100)
+    , triggerLevel (ERROR_LOG_LEVEL)
+    , mdcKey (props.getProperty (LOG4CPLUS_TEXT ("MDCKey")))
+    , maxBuffers (256)
+{
+    unsigned buffer_size = static_cast<unsigned> (bufferSize);
+    props.getUInt (buffer_size, LOG4CPLUS_TEXT ("BufferSize"));
+    bufferSize = buffer_size;
+
+    unsigned max_buffers = static_cast<unsigned> (maxBuffers);
+    props.getUInt (max_buffers, LOG4CPLUS_TEXT ("MaxBuffers"));
+    maxBuffers = max_buffers;
+
+    tstring const & trigger_str
+        = props.getProperty (LOG4CPLUS_TEXT ("TriggerLevel"));
+    if (! trigger_str.empty ())
+    {
+        LogLevel const ll = getLogLevelManager ().fromString (
+            helpers::toUpper (trigger_str));
+        if (ll != NOT_SET_LOG_LEVEL)
+            triggerLevel = ll;
+    }
+
+    tstring const & appender_name (
+        props.getProperty (LOG4CPLUS_TEXT ("Appender")));
+    if (appender_name.empty ())
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unspecified appender for")
+            LOG4CPLUS_TEXT (" BacktraceBufferAppender."));
+    else if (spi::AppenderFactory * factory
+        = spi::getAppenderFactoryRegistry ().get (appender_name))
+        addAppender (factory->createObject (props.getPropertySubset (
+            LOG4CPLUS_TEXT ("Appender."))));
+    else
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("BacktraceBufferAppender::")
+            LOG4CPLUS_TEXT ("BacktraceBufferAppender()")
+            LOG4CPLUS_TEXT (" - Cannot find AppenderFactory: ")
+            + appender_name);
+
+    init ();
+}
+
+
+BacktraceBufferAppender::~BacktraceBufferAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+BacktraceBufferAppender::init ()
+{
+    if (bufferSize == 0)
+        bufferSize = 1;
+    if (maxBuffers == 0)
+        maxBuffers = 1;
+
+    buffers.reset (new Buffers);
+}
+
+
+void
+BacktraceBufferAppender::close ()
+{
+    {
+        thread::MutexGuard guard (access_mutex);
+        if (closed)
+            return;
+
+        buffers->lru.clear ();
+        buffers->map.clear ();
+        closed = true;
+    }
+
+    removeAllAppenders ();
+}
+
+
+unsigned
+BacktraceBufferAppender::getRequiredEventFields () const
+{
+    // Own filters are checked before events are buffered. Fields are
+    // needed only by the attached appenders.
+    unsigned fields = spi::EVENT_FIELDS_NONE;
+    if (ListPtr const list = getAppenderList ())
+        for (auto const & appender : *list)
+            fields |= appender->getRequiredEventFields ();
+
+    return fields;
+}
+
+
+void
+BacktraceBufferAppender::flushBuffers ()
+{
+    thread::MutexGuard guard (access_mutex);
+    for (auto it = buffers->lru.rbegin (); it != buffers->lru.rend (); ++it)
+        Buffers::flush (*this, buffers->map.find (**it)->second);
+}
+
+
+std::size_t
+BacktraceBufferAppender::getBufferedCount () const
+{
+    thread::MutexGuard guard (access_mutex);
+    std::size_t count = 0;
+    for (auto const & entry : buffers->map)
+        count += entry.second.count;
+
+    return count;
+}
+
+
+void
+BacktraceBufferAppender::append (spi::InternalLoggingEvent const & event)
+{
+    // Prefixes keep MDC values apart from thread names.
+    tstring & key = buffers->key;
+    key.assign (1, LOG4CPLUS_TEXT ('t'));
+    if (! mdcKey.empty ())
+    {
+        tstring const & value = event.getMDC (mdcKey);
+        if (! value.empty ())
+        {
+            key.assign (1, LOG4CPLUS_TEXT ('m'));
+            key += value;
+        }
+    }
+    if (key.size () == 1)
+        key += event.getThread ();
+
+    Buffers::Ring & ring = buffers->get (bufferSize, maxBuffers);
+    if (event.getLogLevel () >= triggerLevel)
+    {
+        Buffers::flush (*this, ring);
+        appendLoopOnAppenders (event);
+        return;
+    }
+
+    // The slot keeps storage of the event it held before.
+    std::size_t const size = ring.slots.size ();
+    spi::InternalLoggingEvent * slot;
+    if (ring.count == size)
+    {
+        slot = &ring.slots[ring.start];
+        ring.start = (ring.start + 1) % size;
+    }
+    else
+        slot = &ring.slots[(ring.start + ring.count++) % size];
+
+    slot->assign (event, getRequiredEventFields ());
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("BacktraceBufferAppender", "[appender]")
+{
+    std::vector<tstring> messages;
+    SharedAppenderPtr const sink (new CallbackAppender (
+        [] (void * cookie, log4cplus_char_t const * message,
+            log4cplus_char_t const *, log4cplus_loglevel_t,
+            log4cplus_char_t const *, log4cplus_char_t const *,
+            unsigned long long, unsigned long, log4cplus_char_t const *,
+            log4cplus_char_t const *, int)
+        {
+            static_cast<std::vector<tstring> *> (cookie)->push_back (message);
+        },
+        &messages));
+
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("BufferSize"), LOG4CPLUS_TEXT ("3"));
+    props.setProperty (LOG4CPLUS_TEXT ("MDCKey"), LOG4CPLUS_TEXT ("request"));
+    props.setProperty (LOG4CPLUS_TEXT ("MaxBuffers"), LOG4CPLUS_TEXT ("2"));
+    props.setProperty (LOG4CPLUS_TEXT ("Appender"),
+        LOG4CPLUS_TEXT ("log4cplus::NullAppender"));
+    BacktraceBufferAppender appender (props);
+    appender.addAppender (sink);
+
+    auto const log = [&appender] (LogLevel ll, tstring const & msg) {
+        appender.doAppend (spi::InternalLoggingEvent (
+            LOG4CPLUS_TEXT ("backtrace.test"), ll, msg, __FILE__, __LINE__,
+            nullptr)); };
+
+    MDC & mdc = getMDC ();
+    mdc.put (LOG4CPLUS_TEXT ("request"), LOG4CPLUS_TEXT ("1"));
+    for (int i = 0; i != 5; ++i)
+        log (DEBUG_LOG_LEVEL, LOG4CPLUS_TEXT ("debug ")
+            + helpers::convertIntegerToString (i));
+    CATCH_REQUIRE (messages.empty ());
+    CATCH_REQUIRE (appender.getBufferedCount () == 3);
+
+    // Other request does not see the context of the first one.
+    mdc.put (LOG4CPLUS_TEXT ("request"), LOG4CPLUS_TEXT ("2"));
+    log (INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("other"));
+    log (ERROR_LOG_LEVEL, LOG4CPLUS_TEXT ("failure 2"));
+    CATCH_REQUIRE (messages == std::vector<tstring> {
+            LOG4CPLUS_TEXT ("other"), LOG4CPLUS_TEXT ("failure 2")});
+    messages.clear ();
+
+    mdc.put (LOG4CPLUS_TEXT ("request"), LOG4CPLUS_TEXT ("1"));
+    log (FATAL_LOG_LEVEL, LOG4CPLUS_TEXT ("failure 1"));
+    CATCH_REQUIRE (messages == std::vector<tstring> {
+            LOG4CPLUS_TEXT ("debug 2"), LOG4CPLUS_TEXT ("debug 3"),
+            LOG4CPLUS_TEXT ("debug 4"), LOG4CPLUS_TEXT ("failure 1")});
+    messages.clear ();
+    CATCH_REQUIRE (appender.getBufferedCount () == 0);
+
+    // The least recently used buffer is dropped for a third one; events
+    // without the MDC entry are buffered by thread.
+    log (DEBUG_LOG_LEVEL, LOG4CPLUS_TEXT ("request 1"));
+    mdc.put (LOG4CPLUS_TEXT ("request"), LOG4CPLUS_TEXT ("2"));
+    log (DEBUG_LOG_LEVEL, LOG4CPLUS_TEXT ("request 2"));
+    mdc.remove (LOG4CPLUS_TEXT ("request"));
+    log (DEBUG_LOG_LEVEL, LOG4CPLUS_TEXT ("thread"));
+    CATCH_REQUIRE (appender.getBufferedCount () == 2);
+
+    appender.flushBuffers ();
+    CATCH_REQUIRE (messages == std::vector<tstring> {
+            LOG4CPLUS_TEXT ("request 2"), LOG4CPLUS_TEXT ("thread")});
+
+    appender.close ();
+}
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+} // namespace log4cplus
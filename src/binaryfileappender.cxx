@@ -0,0 +1,138 @@
+// Module:  Log4cplus
+// File:    binaryfileappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/binaryfileappender.h>
+#include <log4cplus/fstreams.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/internal/env.h>
+
+
+namespace log4cplus
+{
+
+
+BinaryFileAppender::BinaryFileAppender (tstring const & filename_,
+    std::ios_base::openmode mode_, bool immediateFlush_, bool createDirs_)
+    : immediateFlush (immediateFlush_)
+    , createDirs (createDirs_)
+    , filename (filename_)
+    , fileOpenMode (mode_)
+    , writer (out)
+{
+    open ();
+}
+
+
+BinaryFileAppender::BinaryFileAppender (helpers::Properties const & props)
+    : Appender (props)
+    , immediateFlush (true)
+    , createDirs (false)
+    , fileOpenMode (std::ios_base::trunc)
+    , writer (out)
+{
+    filename = props.getProperty (LOG4CPLUS_TEXT ("File"));
+    props.getBool (immediateFlush, LOG4CPLUS_TEXT ("ImmediateFlush"));
+    props.getBool (createDirs, LOG4CPLUS_TEXT ("CreateDirs"));
+
+    bool app = false;
+    props.getBool (app, LOG4CPLUS_TEXT ("Append"));
+    fileOpenMode = app ? std::ios_base::app : std::ios_base::trunc;
+
+    open ();
+}
+
+
+BinaryFileAppender::~BinaryFileAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+BinaryFileAppender::close ()
+{
+    thread::MutexGuard guard (access_mutex);
+
+    out.close ();
+    closed = true;
+}
+
+
+unsigned
+BinaryFileAppender::getRequiredEventFields () const
+{
+    return spi::EVENT_FIELDS_ALL;
+}
+
+
+void
+BinaryFileAppender::open ()
+{
+    if (createDirs)
+        internal::make_dirs (filename);
+
+    out.open (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (filename).c_str (),
+        fileOpenMode | std::ios_base::out | std::ios_base::binary);
+    if (! out.good ())
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to open file: ") + filename);
+        return;
+    }
+
+    // Each session starts with its own header so that appending to
+    // existing file keeps it decodable.
+    writer.writeHeader ();
+    helpers::getLogLog ().debug (
+        LOG4CPLUS_TEXT ("Just opened file: ") + filename);
+}
+
+
+// This method does not need to be locked since it is called by
+// doAppend() which performs the locking
+void
+BinaryFileAppender::append (spi::InternalLoggingEvent const & event)
+{
+    if (! out.good ())
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("file is not open: ") + filename);
+        return;
+    }
+
+    writer.write (event);
+    if (immediateFlush)
+        out.flush ();
+}
+
+
+} // namespace log4cplus
@@ -0,0 +1,811 @@
+// Module:  Log4cplus
+// File:    binarylog.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/binarylog.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <istream>
+#include <ostream>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <sstream>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+//! Record types.
+char const BINLOG_HEADER = 'H';
+char const BINLOG_SITE = 'S';
+char const BINLOG_NAME = 'N';
+char const BINLOG_EVENT = 'E';
+char const BINLOG_KEY_VALUES = 'K';
+char const BINLOG_SEQUENCE = 'Q';
+
+char const binlog_magic[] = "log4cplus-binlog";
+std::uint64_t const binlog_version = 1;
+
+
+void
+put_varint (std::string & buf, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buf.push_back (static_cast<char> ((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buf.push_back (static_cast<char> (value));
+}
+
+
+std::uint64_t
+zigzag (std::int64_t value)
+{
+    return (static_cast<std::uint64_t> (value) << 1)
+        ^ static_cast<std::uint64_t> (value >> 63);
+}
+
+
+std::int64_t
+unzigzag (std::uint64_t value)
+{
+    return static_cast<std::int64_t> (value >> 1)
+        ^ -static_cast<std::int64_t> (value & 1);
+}
+
+
+//! Strings are stored as count of code units followed by each code
+//! unit as varint so that the same file decodes in both char and
+//! wchar_t builds.
+void
+put_string (std::string & buf, tstring_view const & str)
+{
+    put_varint (buf, str.size ());
+    for (tchar ch : str)
+        put_varint (buf, static_cast<std::make_unsigned_t<tchar>> (ch));
+}
+
+
+void
+put_double (std::string & buf, double value)
+{
+    std::uint64_t const bits = std::bit_cast<std::uint64_t> (value);
+    for (unsigned i = 0; i != 8; ++i)
+        buf.push_back (static_cast<char> (bits >> (8 * i)));
+}
+
+
+//! Key/value fields use the same type tags and value encoding as
+//! arguments of BinaryLogMessage.
+void
+put_key_value (std::string & buf, spi::KeyValue const & kv)
+{
+    put_string (buf, kv.key);
+    switch (kv.type)
+    {
+    case spi::KV_BOOL:
+        buf.push_back (static_cast<char> (BINLOG_ARG_BOOL));
+        put_varint (buf, kv.b);
+        break;
+
+    case spi::KV_INT:
+        buf.push_back (static_cast<char> (BINLOG_ARG_INT));
+        put_varint (buf, zigzag (kv.i));
+        break;
+
+    case spi::KV_UINT:
+        buf.push_back (static_cast<char> (BINLOG_ARG_UINT));
+        put_varint (buf, kv.u);
+        break;
+
+    case spi::KV_DOUBLE:
+        buf.push_back (static_cast<char> (BINLOG_ARG_DOUBLE));
+        put_double (buf, kv.d);
+        break;
+
+    case spi::KV_STRING:
+        buf.push_back (static_cast<char> (BINLOG_ARG_STRING));
+        put_string (buf, kv.str);
+        break;
+    }
+}
+
+
+void
+put_bytes (std::string & buf, char const * str)
+{
+    std::string_view const bytes (str ? str : "");
+    put_varint (buf, bytes.size ());
+    buf.append (bytes);
+}
+
+
+[[noreturn]]
+void
+report_malformed (tchar const * what)
+{
+    helpers::getLogLog ().error (
+        tstring (LOG4CPLUS_TEXT ("Malformed binary log: ")) + what, true);
+    // Not reached, getLogLog().error() throws.
+    throw std::runtime_error ("malformed binary log");
+}
+
+
+//! Reads values from record payload.
+struct Cursor
+{
+    explicit Cursor (std::string_view const & data_)
+        : data (data_)
+        , pos (0)
+    { }
+
+    bool
+    empty () const
+    {
+        return pos == data.size ();
+    }
+
+    unsigned char
+    byte ()
+    {
+        if (empty ())
+            report_malformed (LOG4CPLUS_TEXT ("truncated record"));
+
+        return static_cast<unsigned char> (data[pos++]);
+    }
+
+    std::uint64_t
+    varint ()
+    {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; ; shift += 7)
+        {
+            if (shift >= 64)
+                report_malformed (LOG4CPLUS_TEXT ("overlong varint"));
+
+            unsigned char const b = byte ();
+            value |= static_cast<std::uint64_t> (b & 0x7f) << shift;
+            if (! (b & 0x80))
+                return value;
+        }
+    }
+
+    void
+    string (tstring & str)
+    {
+        std::uint64_t const size = varint ();
+        if (size > data.size () - pos)
+            report_malformed (LOG4CPLUS_TEXT ("truncated string"));
+
+        for (std::uint64_t i = 0; i != size; ++i)
+            str += static_cast<tchar> (varint ());
+    }
+
+    tstring
+    string ()
+    {
+        tstring str;
+        string (str);
+        return str;
+    }
+
+    std::string_view
+    bytes ()
+    {
+        std::uint64_t const size = varint ();
+        if (size > data.size () - pos)
+            report_malformed (LOG4CPLUS_TEXT ("truncated string"));
+
+        std::string_view const result = data.substr (pos, size);
+        pos += size;
+        return result;
+    }
+
+    double
+    dbl ()
+    {
+        std::uint64_t bits = 0;
+        for (unsigned i = 0; i != 8; ++i)
+            bits |= static_cast<std::uint64_t> (byte ()) << (8 * i);
+        return std::bit_cast<double> (bits);
+    }
+
+    std::string_view
+    rest () const
+    {
+        return data.substr (pos);
+    }
+
+    std::string_view data;
+    std::size_t pos;
+};
+
+
+void
+append_chars (tstring & message, char const * first, char const * last)
+{
+    for (; first != last; ++first)
+        message += static_cast<tchar> (*first);
+}
+
+
+template <typename T>
+void
+append_number (tstring & message, T value, int base = 10)
+{
+    char buf[32];
+    std::to_chars_result const res
+        = std::to_chars (buf, buf + sizeof (buf), value, base);
+    append_chars (message, buf, res.ptr);
+}
+
+
+void
+append_argument (tstring & message, Cursor & args)
+{
+    switch (args.byte ())
+    {
+    case BINLOG_ARG_BOOL:
+        message += args.varint () ? LOG4CPLUS_TEXT ("true")
+            : LOG4CPLUS_TEXT ("false");
+        break;
+
+    case BINLOG_ARG_CHAR:
+        message += static_cast<tchar> (args.varint ());
+        break;
+
+    case BINLOG_ARG_INT:
+        append_number (message, unzigzag (args.varint ()));
+        break;
+
+    case BINLOG_ARG_UINT:
+        append_number (message, args.varint ());
+        break;
+
+    case BINLOG_ARG_DOUBLE:
+    {
+        char buf[32];
+        std::to_chars_result const res = std::to_chars (buf,
+            buf + sizeof (buf), args.dbl ());
+        append_chars (message, buf, res.ptr);
+        break;
+    }
+
+    case BINLOG_ARG_STRING:
+        args.string (message);
+        break;
+
+    case BINLOG_ARG_POINTER:
+        message += LOG4CPLUS_TEXT ("0x");
+        append_number (message, args.varint (), 16);
+        break;
+
+    default:
+        report_malformed (LOG4CPLUS_TEXT ("unknown argument type"));
+    }
+}
+
+
+void
+read_key_values (spi::KeyValues & kvs, Cursor & cur)
+{
+    kvs.clear ();
+    tstring key;
+    tstring str;
+    for (std::uint64_t count = cur.varint (); count != 0; --count)
+    {
+        key.clear ();
+        cur.string (key);
+        switch (cur.byte ())
+        {
+        case BINLOG_ARG_BOOL:
+            kvs.addBool (key, cur.varint () != 0);
+            break;
+
+        case BINLOG_ARG_INT:
+            kvs.addInt (key, unzigzag (cur.varint ()));
+            break;
+
+        case BINLOG_ARG_UINT:
+            kvs.addUInt (key, cur.varint ());
+            break;
+
+        case BINLOG_ARG_DOUBLE:
+            kvs.addDouble (key, cur.dbl ());
+            break;
+
+        case BINLOG_ARG_STRING:
+            str.clear ();
+            cur.string (str);
+            kvs.addString (key, str);
+            break;
+
+        default:
+            report_malformed (LOG4CPLUS_TEXT ("unknown key/value type"));
+        }
+    }
+}
+
+
+} // namespace
+
+
+//
+//
+//
+
+BinaryLogSite::BinaryLogSite (tchar const * format_, char const * file_,
+    int line_, char const * function_)
+    : format (format_)
+    , file (file_)
+    , line (line_)
+    , function (function_)
+{
+    static std::atomic<unsigned> last_id {0};
+    id = last_id.fetch_add (1, std::memory_order_relaxed) + 1;
+}
+
+
+//
+//
+//
+
+BinaryLogMessage::BinaryLogMessage (BinaryLogSite const & site_)
+    : site (site_)
+{ }
+
+
+BinaryLogMessage::~BinaryLogMessage () = default;
+
+
+void
+BinaryLogMessage::format (tstring & message) const
+{
+    formatBinaryLogMessage (message, site.getFormat (), args);
+}
+
+
+void
+BinaryLogMessage::addUInt (BinaryLogArgType type, std::uint64_t value)
+{
+    args.push_back (static_cast<char> (type));
+    put_varint (args, value);
+}
+
+
+void
+BinaryLogMessage::addInt (std::int64_t value)
+{
+    args.push_back (static_cast<char> (BINLOG_ARG_INT));
+    put_varint (args, zigzag (value));
+}
+
+
+void
+BinaryLogMessage::addDouble (double value)
+{
+    args.push_back (static_cast<char> (BINLOG_ARG_DOUBLE));
+    put_double (args, value);
+}
+
+
+void
+BinaryLogMessage::addString (tstring_view const & value)
+{
+    args.push_back (static_cast<char> (BINLOG_ARG_STRING));
+    put_string (args, value);
+}
+
+
+//
+//
+//
+
+void
+formatBinaryLogMessage (tstring & message, tstring_view const & format,
+    std::string_view const & args_data)
+{
+    Cursor args (args_data);
+    std::size_t const size = format.size ();
+    for (std::size_t i = 0; i != size; ++i)
+    {
+        tchar const ch = format[i];
+        tchar const next = i + 1 != size ? format[i + 1] : 0;
+        if ((ch == LOG4CPLUS_TEXT ('{') || ch == LOG4CPLUS_TEXT ('}'))
+            && next == ch)
+        {
+            message += ch;
+            ++i;
+        }
+        else if (ch == LOG4CPLUS_TEXT ('{') && next == LOG4CPLUS_TEXT ('}')
+            && ! args.empty ())
+        {
+            append_argument (message, args);
+            ++i;
+        }
+        else
+            message += ch;
+    }
+}
+
+
+//
+//
+//
+
+BinaryLogWriter::BinaryLogWriter (std::ostream & out_)
+    : out (out_)
+{ }
+
+
+BinaryLogWriter::~BinaryLogWriter () = default;
+
+
+void
+BinaryLogWriter::writeHeader ()
+{
+    writtenSites.clear ();
+    names.clear ();
+
+    payload.assign (binlog_magic, sizeof (binlog_magic) - 1);
+    put_varint (payload, binlog_version);
+    writeRecord (BINLOG_HEADER);
+}
+
+
+void
+BinaryLogWriter::write (spi::InternalLoggingEvent const & event)
+{
+    auto const msg = dynamic_cast<BinaryLogMessage const *> (
+        event.getDeferredMessage ().get ());
+
+    unsigned site_id = 0;
+    if (msg)
+    {
+        BinaryLogSite const & site = msg->getSite ();
+        site_id = site.getId ();
+        if (site_id >= writtenSites.size ())
+            writtenSites.resize (site_id + 1);
+
+        if (! writtenSites[site_id])
+        {
+            payload.clear ();
+            put_varint (payload, site_id);
+            put_string (payload, site.getFormat ());
+            put_bytes (payload, site.getFile ());
+            put_varint (payload, zigzag (site.getLine ()));
+            put_bytes (payload, site.getFunction ());
+            writeRecord (BINLOG_SITE);
+            writtenSites[site_id] = true;
+        }
+    }
+
+    unsigned const logger_id = nameId (event.getLoggerName ());
+    unsigned const thread_id = nameId (event.getThread ());
+
+    spi::KeyValues const & kvs = event.getKeyValues ();
+    if (! kvs.empty ())
+    {
+        payload.clear ();
+        put_varint (payload, kvs.size ());
+        for (std::size_t i = 0; i != kvs.size (); ++i)
+            put_key_value (payload, kvs[i]);
+        writeRecord (BINLOG_KEY_VALUES);
+    }
+
+    if (event.getSequenceNumber () != 0)
+    {
+        payload.clear ();
+        put_varint (payload, event.getSequenceNumber ());
+        writeRecord (BINLOG_SEQUENCE);
+    }
+
+    payload.clear ();
+    put_varint (payload, site_id);
+    put_varint (payload, zigzag (event.getLogLevel ()));
+    put_varint (payload, zigzag (
+        std::chrono::duration_cast<std::chrono::nanoseconds> (
+            event.getTimestamp ().time_since_epoch ()).count ()));
+    put_varint (payload, logger_id);
+    put_varint (payload, thread_id);
+    if (msg)
+        payload += msg->getArguments ();
+    else
+    {
+        payload.push_back (static_cast<char> (BINLOG_ARG_STRING));
+        put_string (payload, event.getMessage ());
+    }
+    writeRecord (BINLOG_EVENT);
+}
+
+
+unsigned
+BinaryLogWriter::nameId (tstring const & name)
+{
+    auto it = names.find (name);
+    if (it != names.end ())
+        return it->second;
+
+    unsigned const id = static_cast<unsigned> (names.size ()) + 1;
+    names.emplace (name, id);
+
+    payload.clear ();
+    put_varint (payload, id);
+    put_string (payload, name);
+    writeRecord (BINLOG_NAME);
+
+    return id;
+}
+
+
+void
+BinaryLogWriter::writeRecord (unsigned char type)
+{
+    record.clear ();
+    record.push_back (static_cast<char> (type));
+    put_varint (record, payload.size ());
+    out.write (record.data (), static_cast<std::streamsize> (record.size ()));
+    out.write (payload.data (),
+        static_cast<std::streamsize> (payload.size ()));
+}
+
+
+//
+//
+//
+
+BinaryLogReader::BinaryLogReader (std::istream & in_)
+    : in (in_)
+    , sequence (0)
+    , headerSeen (false)
+{ }
+
+
+BinaryLogReader::~BinaryLogReader () = default;
+
+
+bool
+BinaryLogReader::read (spi::InternalLoggingEvent & event)
+{
+    typedef std::istream::traits_type traits;
+
+    for (;;)
+    {
+        traits::int_type const type = in.get ();
+        if (traits::eq_int_type (type, traits::eof ()))
+            return false;
+
+        std::uint64_t size = 0;
+        for (unsigned shift = 0; ; shift += 7)
+        {
+            traits::int_type const b = in.get ();
+            if (traits::eq_int_type (b, traits::eof ()))
+                report_malformed (LOG4CPLUS_TEXT ("truncated record"));
+            if (shift >= 64)
+                report_malformed (LOG4CPLUS_TEXT ("overlong varint"));
+
+            size |= static_cast<std::uint64_t> (b & 0x7f) << shift;
+            if (! (b & 0x80))
+                break;
+        }
+
+        payload.resize (size);
+        in.read (payload.data (), static_cast<std::streamsize> (size));
+        if (static_cast<std::uint64_t> (in.gcount ()) != size)
+            report_malformed (LOG4CPLUS_TEXT ("truncated record"));
+
+        Cursor cur (payload);
+        if (type == BINLOG_HEADER)
+        {
+            std::string_view const magic (binlog_magic,
+                sizeof (binlog_magic) - 1);
+            if (cur.data.substr (0, magic.size ()) != magic)
+                report_malformed (LOG4CPLUS_TEXT ("bad header"));
+
+            cur.pos = magic.size ();
+            if (cur.varint () != binlog_version)
+                report_malformed (LOG4CPLUS_TEXT ("unsupported version"));
+
+            sites.clear ();
+            names.clear ();
+            keyValues.clear ();
+            sequence = 0;
+            headerSeen = true;
+            continue;
+        }
+
+        if (! headerSeen)
+            report_malformed (LOG4CPLUS_TEXT ("missing header"));
+
+        switch (type)
+        {
+        case BINLOG_SITE:
+        {
+            std::uint64_t const id = cur.varint ();
+            Site & site = sites[id];
+            site.format = cur.string ();
+            site.file = LOG4CPLUS_STRING_TO_TSTRING (
+                std::string (cur.bytes ()));
+            site.line = static_cast<int> (unzigzag (cur.varint ()));
+            site.function = LOG4CPLUS_STRING_TO_TSTRING (
+                std::string (cur.bytes ()));
+            break;
+        }
+
+        case BINLOG_NAME:
+        {
+            std::uint64_t const id = cur.varint ();
+            names[id] = cur.string ();
+            break;
+        }
+
+        case BINLOG_KEY_VALUES:
+            read_key_values (keyValues, cur);
+            break;
+
+        case BINLOG_SEQUENCE:
+            sequence = cur.varint ();
+            break;
+
+        case BINLOG_EVENT:
+        {
+            static Site const no_site {
+                LOG4CPLUS_TEXT ("{}"), tstring (), -1, tstring () };
+
+            std::uint64_t const site_id = cur.varint ();
+            Site const * site = &no_site;
+            if (site_id != 0)
+            {
+                auto it = sites.find (site_id);
+                if (it == sites.end ())
+                    report_malformed (LOG4CPLUS_TEXT ("unknown call site"));
+                site = &it->second;
+            }
+
+            auto const ll = static_cast<LogLevel> (unzigzag (cur.varint ()));
+            std::chrono::nanoseconds const ns (unzigzag (cur.varint ()));
+            auto const logger = names.find (cur.varint ());
+            auto const thread = names.find (cur.varint ());
+            if (logger == names.end () || thread == names.end ())
+                report_malformed (LOG4CPLUS_TEXT ("unknown name"));
+
+            tstring message;
+            formatBinaryLogMessage (message, site->format, cur.rest ());
+
+            event = spi::InternalLoggingEvent (logger->second, ll,
+                tstring_view (), MappedDiagnosticContextMap (), message,
+                thread->second, tstring_view (),
+                helpers::Time (std::chrono::duration_cast<
+                    helpers::Time::duration> (ns)),
+                site->file, site->line, site->function);
+            event.getKeyValues ().swap (keyValues);
+            keyValues.clear ();
+            event.setSequenceNumber (sequence);
+            sequence = 0;
+            return true;
+        }
+
+        default:
+            // Skip unknown records.
+            break;
+        }
+    }
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("BinaryLog", "[binarylog]")
+{
+    BinaryLogSite const site (
+        LOG4CPLUS_TEXT ("a={} b={} c={} {{}} d={} e={} f={}"),
+        "file.cxx", 42, "func");
+
+    auto msg = std::make_shared<BinaryLogMessage> (site);
+    msg->addArgument (-5);
+    msg->addArgument (7u);
+    msg->addArgument (LOG4CPLUS_TEXT ("str"));
+    msg->addArgument (true);
+    msg->addArgument (1.5);
+    tstring const expected (
+        LOG4CPLUS_TEXT ("a=-5 b=7 c=str {} d=true e=1.5 f={}"));
+
+    spi::InternalLoggingEvent ev (LOG4CPLUS_TEXT ("binlog.test"),
+        INFO_LOG_LEVEL, tstring_view (), "file.cxx", 42, "func");
+    ev.setDeferredMessage (msg);
+    ev.getKeyValues ().add (LOG4CPLUS_TEXT ("user"), 42);
+    ev.getKeyValues ().add (LOG4CPLUS_TEXT ("ratio"), 0.25);
+    ev.getKeyValues ().add (LOG4CPLUS_TEXT ("name"), LOG4CPLUS_TEXT ("x"));
+    ev.setSequenceNumber (1234567);
+
+    CATCH_SECTION ("format")
+    {
+        CATCH_REQUIRE (ev.getMessage () == expected);
+    }
+
+    CATCH_SECTION ("round trip")
+    {
+        std::stringstream buf (std::ios_base::in | std::ios_base::out
+            | std::ios_base::binary);
+        BinaryLogWriter writer (buf);
+        writer.writeHeader ();
+        writer.write (ev);
+        writer.write (ev);
+
+        spi::InternalLoggingEvent plain (LOG4CPLUS_TEXT ("binlog.plain"),
+            WARN_LOG_LEVEL, LOG4CPLUS_TEXT ("plain {}"), nullptr, -1,
+            nullptr);
+        writer.write (plain);
+
+        BinaryLogReader reader (buf);
+        spi::InternalLoggingEvent out;
+        for (int i = 0; i != 2; ++i)
+        {
+            CATCH_REQUIRE (reader.read (out));
+            CATCH_REQUIRE (out.getMessage () == expected);
+            CATCH_REQUIRE (out.getLoggerName () == ev.getLoggerName ());
+            CATCH_REQUIRE (out.getLogLevel () == INFO_LOG_LEVEL);
+            CATCH_REQUIRE (out.getThread () == ev.getThread ());
+            CATCH_REQUIRE (out.getTimestamp () == ev.getTimestamp ());
+            CATCH_REQUIRE (out.getFile () == LOG4CPLUS_TEXT ("file.cxx"));
+            CATCH_REQUIRE (out.getLine () == 42);
+            CATCH_REQUIRE (out.getFunction () == LOG4CPLUS_TEXT ("func"));
+            CATCH_REQUIRE (out.getSequenceNumber () == 1234567);
+
+            spi::KeyValues const & kvs = out.getKeyValues ();
+            CATCH_REQUIRE (kvs.size () == 3);
+            CATCH_REQUIRE (kvs[0].key == LOG4CPLUS_TEXT ("user"));
+            CATCH_REQUIRE (kvs[0].type == spi::KV_INT);
+            CATCH_REQUIRE (kvs[0].i == 42);
+            CATCH_REQUIRE (kvs[1].type == spi::KV_DOUBLE);
+            CATCH_REQUIRE (kvs[1].d == 0.25);
+            CATCH_REQUIRE (kvs[2].str == LOG4CPLUS_TEXT ("x"));
+        }
+
+        CATCH_REQUIRE (reader.read (out));
+        CATCH_REQUIRE (out.getMessage () == LOG4CPLUS_TEXT ("plain {}"));
+        CATCH_REQUIRE (out.getLogLevel () == WARN_LOG_LEVEL);
+        CATCH_REQUIRE (out.getKeyValues ().empty ());
+        CATCH_REQUIRE (out.getSequenceNumber () == 0);
+        CATCH_REQUIRE (! reader.read (out));
+    }
+}
+
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+} // namespace log4cplus
@@ -0,0 +1,271 @@
+// Module:  Log4cplus
+// File:    bloomfilter.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/helpers/bloomfilter.h>
+#include <log4cplus/fstreams.h>
+#include <log4cplus/internal/internal.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/helpers/stringhelper.h>
+#include <catch.hpp>
+#include <cstdio>
+#endif
+
+
+namespace log4cplus::helpers {
+
+
+namespace
+{
+
+char const bloom_magic[] = "log4cplus-bloom";
+unsigned char const bloom_version = 1;
+
+//! Magic, version, number of hashes and number of bits.
+std::size_t const bloom_header_size = sizeof (bloom_magic) - 1 + 2 + 8;
+
+//! Upper bound of filters read from files, 1 GiB of bits.
+std::uint64_t const max_bloom_bits = std::uint64_t (8) << 30;
+
+unsigned const max_bloom_hashes = 30;
+
+
+//! FNV-1a over UTF-8 of the key, a zero byte and the value.
+std::uint64_t
+hash_pair (tstring_view key, tstring_view value)
+{
+    std::string bytes;
+    internal::append_utf8 (bytes, key);
+    bytes.push_back ('\0');
+    internal::append_utf8 (bytes, value);
+
+    std::uint64_t hash = 0xCBF29CE484222325ull;
+    for (char const ch : bytes)
+    {
+        hash ^= static_cast<unsigned char> (ch);
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+
+//! SplitMix64 finalizer; derives the second hash of double hashing.
+std::uint64_t
+mix (std::uint64_t hash)
+{
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBull;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+} // namespace
+
+
+BloomFilter::BloomFilter ()
+    : hashes (0)
+{ }
+
+
+BloomFilter::BloomFilter (std::size_t expectedValues,
+    double falsePositiveRate)
+{
+    double const n = static_cast<double> ((std::max) (expectedValues,
+        std::size_t (1)));
+    double const p = (std::min) ((std::max) (falsePositiveRate, 1e-9), 0.5);
+    double const ln2 = std::log (2.0);
+    double const m = std::ceil (-n * std::log (p) / (ln2 * ln2));
+    bits.resize (static_cast<std::size_t> ((m + 63) / 64));
+    hashes = static_cast<unsigned> ((std::min) ((std::max) (
+        std::lround (static_cast<double> (getBitCount ()) / n * ln2), 1L),
+        long (max_bloom_hashes)));
+}
+
+
+void
+BloomFilter::add (tstring_view key, tstring_view value)
+{
+    if (bits.empty ())
+        return;
+
+    std::uint64_t const size = getBitCount ();
+    std::uint64_t h1 = hash_pair (key, value);
+    std::uint64_t const h2 = mix (h1) | 1;
+    for (unsigned i = 0; i != hashes; ++i, h1 += h2)
+    {
+        std::uint64_t const bit = h1 % size;
+        bits[bit / 64] |= std::uint64_t (1) << (bit % 64);
+    }
+}
+
+
+bool
+BloomFilter::mightContain (tstring_view key, tstring_view value) const
+{
+    if (bits.empty ())
+        return false;
+
+    std::uint64_t const size = getBitCount ();
+    std::uint64_t h1 = hash_pair (key, value);
+    std::uint64_t const h2 = mix (h1) | 1;
+    for (unsigned i = 0; i != hashes; ++i, h1 += h2)
+    {
+        std::uint64_t const bit = h1 % size;
+        if (! (bits[bit / 64] & (std::uint64_t (1) << (bit % 64))))
+            return false;
+    }
+
+    return true;
+}
+
+
+bool
+BloomFilter::save (tstring const & name) const
+{
+    std::string data (bloom_magic, sizeof (bloom_magic) - 1);
+    data.push_back (static_cast<char> (bloom_version));
+    data.push_back (static_cast<char> (hashes));
+    auto const put_u64 = [&data] (std::uint64_t value)
+    {
+        for (unsigned i = 0; i != 8; ++i)
+            data.push_back (static_cast<char> (value >> (8 * i)));
+    };
+    put_u64 (getBitCount ());
+    for (std::uint64_t word : bits)
+        put_u64 (word);
+
+    std::ofstream out (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (name).c_str (),
+        std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+    out.write (data.data (), static_cast<std::streamsize> (data.size ()));
+    out.close ();
+    return ! ! out;
+}
+
+
+bool
+BloomFilter::load (tstring const & name)
+{
+    std::ifstream in (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (name).c_str (),
+        std::ios_base::in | std::ios_base::binary);
+    unsigned char header[bloom_header_size];
+    if (! in.read (reinterpret_cast<char *> (header), sizeof (header))
+        || std::memcmp (header, bloom_magic, sizeof (bloom_magic) - 1) != 0)
+        return false;
+
+    unsigned char const * const fields = header + sizeof (bloom_magic) - 1;
+    std::uint64_t size = 0;
+    for (unsigned i = 0; i != 8; ++i)
+        size |= std::uint64_t (fields[2 + i]) << (8 * i);
+    if (fields[0] != bloom_version || fields[1] == 0
+        || fields[1] > max_bloom_hashes || size == 0 || size % 64 != 0
+        || size > max_bloom_bits)
+        return false;
+
+    std::vector<std::uint64_t> words (static_cast<std::size_t> (size / 64));
+    unsigned char word[8];
+    for (std::uint64_t & value : words)
+    {
+        if (! in.read (reinterpret_cast<char *> (word), sizeof (word)))
+            return false;
+
+        value = 0;
+        for (unsigned i = 0; i != 8; ++i)
+            value |= std::uint64_t (word[i]) << (8 * i);
+    }
+
+    bits.swap (words);
+    hashes = fields[1];
+    return true;
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("BloomFilter", "[helpers]")
+{
+    tstring const key (LOG4CPLUS_TEXT ("traceId"));
+    auto const value = [] (int i)
+    {
+        return LOG4CPLUS_TEXT ("trace-") + convertIntegerToString (i);
+    };
+
+    BloomFilter filter (1000, 0.01);
+    CATCH_REQUIRE (filter.getBitCount () >= 9585);
+    CATCH_REQUIRE (filter.getHashCount () == 7);
+    for (int i = 0; i != 1000; ++i)
+        filter.add (key, value (i));
+
+    CATCH_SECTION ("added values are found")
+    {
+        for (int i = 0; i != 1000; ++i)
+            CATCH_REQUIRE (filter.mightContain (key, value (i)));
+    }
+
+    CATCH_SECTION ("other values are mostly rejected")
+    {
+        int found = 0;
+        for (int i = 1000; i != 11000; ++i)
+            found += filter.mightContain (key, value (i));
+        CATCH_REQUIRE (found < 300);
+        CATCH_REQUIRE (! filter.mightContain (LOG4CPLUS_TEXT ("userId"),
+                value (1)));
+    }
+
+    CATCH_SECTION ("save and load")
+    {
+        tstring const name (LOG4CPLUS_TEXT ("log4cplus-bloom-test.bloom"));
+        CATCH_REQUIRE (filter.save (name));
+
+        BloomFilter loaded;
+        CATCH_REQUIRE (! loaded.mightContain (key, value (1)));
+        CATCH_REQUIRE (loaded.load (name));
+        CATCH_REQUIRE (loaded.getBitCount () == filter.getBitCount ());
+        for (int i = 0; i != 1000; ++i)
+            CATCH_REQUIRE (loaded.mightContain (key, value (i)));
+
+        {
+            std::ofstream out (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (name)
+                .c_str (), std::ios_base::binary);
+            out << "log4cplus-bloom";
+        }
+        CATCH_REQUIRE (! loaded.load (name));
+        CATCH_REQUIRE (loaded.mightContain (key, value (1)));
+        std::remove (LOG4CPLUS_TSTRING_TO_STRING (name).c_str ());
+    }
+}
+#endif
+
+
+} // namespace log4cplus::helpers
@@ -0,0 +1,134 @@
+// Module:  Log4cplus
+// File:    bufferstream.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/helpers/bufferstream.h>
+#include <algorithm>
+#include <climits>
+
+
+namespace log4cplus { namespace helpers {
+
+
+//! Capacity of the first allocation of buffer_streambuf.
+static std::size_t const min_capacity = 256;
+
+
+buffer_streambuf::buffer_streambuf () = default;
+
+
+buffer_streambuf::~buffer_streambuf () = default;
+
+
+void
+buffer_streambuf::reserve (std::size_t n)
+{
+    if (n > buf.size ())
+        grow (n);
+}
+
+
+void
+buffer_streambuf::clear (std::size_t limit)
+{
+    if (limit != 0 && buf.size () > limit)
+        std::vector<tchar> ().swap (buf);
+
+    set_put_area (0);
+}
+
+
+buffer_streambuf::int_type
+buffer_streambuf::overflow (int_type ch)
+{
+    if (traits_type::eq_int_type (ch, traits_type::eof ()))
+        return traits_type::not_eof (ch);
+
+    if (pptr () == epptr ())
+        grow (buf.size () + 1);
+
+    *pptr () = traits_type::to_char_type (ch);
+    pbump (1);
+    return ch;
+}
+
+
+std::streamsize
+buffer_streambuf::xsputn (char_type const * s, std::streamsize n)
+{
+    if (n <= 0)
+        return 0;
+
+    std::size_t const len = static_cast<std::size_t> (n);
+    std::size_t const size = view ().size ();
+    if (len > static_cast<std::size_t> (epptr () - pptr ()))
+        grow (size + len);
+
+    traits_type::copy (pptr (), s, len);
+    set_put_area (size + len);
+    return n;
+}
+
+
+//! Grows the buffer to at least <code>n</code> characters, at least
+//! doubling it, and keeps its contents.
+void
+buffer_streambuf::grow (std::size_t n)
+{
+    std::size_t const size = view ().size ();
+    buf.resize ((std::max) ({n, buf.size () * 2, min_capacity}));
+    set_put_area (size);
+}
+
+
+//! Points the put area at the whole buffer with <code>size</code>
+//! characters written.
+void
+buffer_streambuf::set_put_area (std::size_t size)
+{
+    setp (buf.data (), buf.data () + buf.size ());
+    // pbump() takes int.
+    while (size != 0)
+    {
+        int const step = static_cast<int> (
+            (std::min) (size, static_cast<std::size_t> (INT_MAX)));
+        pbump (step);
+        size -= static_cast<std::size_t> (step);
+    }
+}
+
+
+buffer_ostream::buffer_ostream ()
+    : tostream (&buf)
+{ }
+
+
+buffer_ostream::~buffer_ostream () = default;
+
+
+} } // namespace log4cplus { namespace helpers
@@ -25,7 +25,11 @@
 #include <log4cplus/callbackappender.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/helpers/timehelper.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/internal/internal.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <chrono>
 
 
 namespace log4cplus
@@ -42,9 +46,28 @@ CallbackAppender::CallbackAppender(log4cplus_log_event_callback_t callback_,
 { }
 
 
+CallbackAppender::CallbackAppender(
+    log4cplus_log_event_batch_callback_t callback_, void * cookie_,
+    std::size_t batchSize_, unsigned long batchIntervalMs)
+    : batchCallback (callback_)
+    , cookie (cookie_)
+    , batchSize ((std::max) (batchSize_, std::size_t (1)))
+    , batchInterval (batchIntervalMs)
+{
+    startTimer ();
+}
+
+
 CallbackAppender::CallbackAppender(const helpers::Properties& properties)
     : Appender(properties)
-{ }
+{
+    properties.getULong (batchInterval, LOG4CPLUS_TEXT ("BatchIntervalMs"));
+    unsigned long size = 0;
+    if (properties.getULong (size, LOG4CPLUS_TEXT ("BatchSize")))
+        batchSize = (std::max) (size, 1ul);
+
+    startTimer ();
+}
 
 
 CallbackAppender::~CallbackAppender()
@@ -53,16 +76,94 @@ CallbackAppender::~CallbackAppender()
 }
 
 
+void
+CallbackAppender::startTimer()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (batchInterval != 0)
+    {
+        internal::add_timer (this,
+            std::chrono::milliseconds (batchInterval),
+            [this]
+            {
+                thread::MutexGuard guard (access_mutex);
+                flushPending ();
+            });
+        batchTimerRegistered = true;
+    }
+#endif
+}
+
+
 void
 CallbackAppender::close()
 {
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // This has to be done before locking access_mutex; the timer thread
+    // locks it while holding its own mutex.
+    if (batchTimerRegistered)
+    {
+        internal::remove_timer (this);
+        batchTimerRegistered = false;
+    }
+#endif
+
+    thread::MutexGuard guard (access_mutex);
+    flushPending ();
+    closed = true;
+}
+
+
+unsigned
+CallbackAppender::getRequiredEventFields() const
+{
+    return spi::EVENT_FIELDS_ALL;
+}
+
+
+void
+CallbackAppender::setCookie(void * cookie_)
+{
+    thread::MutexGuard guard (access_mutex);
+    cookie = cookie_;
+}
+
+
+void
+CallbackAppender::setCallback(log4cplus_log_event_callback_t callback_)
+{
+    thread::MutexGuard guard (access_mutex);
+    callback = callback_;
+}
+
+
+void
+CallbackAppender::setBatchCallback(
+    log4cplus_log_event_batch_callback_t callback_)
+{
+    thread::MutexGuard guard (access_mutex);
+    batchCallback = callback_;
 }
 
 
 void
 CallbackAppender::append(const spi::InternalLoggingEvent& ev)
 {
-    if (callback)
+    if (batchCallback && batchInterval == 0)
+        // Without timer nothing would pass collected events on.
+        deliver (std::span<spi::InternalLoggingEvent const> (&ev, 1));
+    else if (batchCallback)
+    {
+        // Storage of the copies is reused, see pending.
+        if (pendingCount == pending.size ())
+            pending.emplace_back (ev);
+        else
+            pending[pendingCount] = ev;
+
+        if (++pendingCount >= batchSize)
+            flushPending ();
+    }
+    else if (callback)
     {
         helpers::Time const & t = ev.getTimestamp();
         callback(cookie, ev.getMessage().c_str(),
@@ -76,4 +177,77 @@ CallbackAppender::append(const spi::InternalLoggingEvent& ev)
 }
 
 
+// This method does not need to be locked since it is called by
+// syncDoAppendBatch() which performs the locking
+void
+CallbackAppender::appendBatch(
+    std::span<spi::InternalLoggingEvent const> events)
+{
+    if (! batchCallback)
+    {
+        Appender::appendBatch (events);
+        return;
+    }
+
+    // Events of the batch stay valid during the call, whole batches of
+    // them are passed without copying.
+    if (pendingCount != 0)
+    {
+        std::size_t const fill = (std::min) (batchSize - pendingCount,
+            events.size ());
+        Appender::appendBatch (events.first (fill));
+        events = events.subspan (fill);
+    }
+
+    while (events.size () >= batchSize)
+    {
+        deliver (events.first (batchSize));
+        events = events.subspan (batchSize);
+    }
+
+    if (batchInterval == 0)
+    {
+        flushPending ();
+        if (! events.empty ())
+            deliver (events);
+    }
+    else
+        Appender::appendBatch (events);
+}
+
+
+void
+CallbackAppender::deliver(std::span<spi::InternalLoggingEvent const> events)
+{
+    views.clear ();
+    for (spi::InternalLoggingEvent const & ev : events)
+    {
+        helpers::Time const & t = ev.getTimestamp ();
+        tstring const & message = ev.getMessage ();
+        views.push_back (log4cplus_event_view_t {
+            message.c_str (), message.size (),
+            ev.getLoggerName ().c_str (), ev.getLogLevel (),
+            ev.getThread ().c_str (), ev.getThread2 ().c_str (),
+            static_cast<unsigned long long> (helpers::to_time_t (t)),
+            static_cast<unsigned long> (helpers::microseconds_part (t)),
+            ev.getFile ().c_str (), ev.getFunction ().c_str (),
+            ev.getLine () });
+    }
+
+    batchCallback (cookie, views.data (), views.size ());
+}
+
+
+void
+CallbackAppender::flushPending()
+{
+    if (pendingCount == 0 || ! batchCallback)
+        return;
+
+    deliver (std::span<spi::InternalLoggingEvent const> (pending.data (),
+        pendingCount));
+    pendingCount = 0;
+}
+
+
 } // namespace log4cplus
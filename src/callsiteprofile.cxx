@@ -0,0 +1,236 @@
+// Module:  Log4cplus
+// File:    callsiteprofile.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+// Profile the logging statements of the unit test below.
+#define LOG4CPLUS_MACRO_CALL_SITE_PROFILE
+#endif
+
+#include <log4cplus/callsiteprofile.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <algorithm>
+#include <iomanip>
+#include <thread>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/hierarchy.h>
+#include <log4cplus/loggingmacros.h>
+#include <log4cplus/nullappender.h>
+#include <catch.hpp>
+#endif
+
+
+namespace log4cplus
+{
+
+
+namespace
+{
+
+//! Head of list of all registered call sites.
+std::atomic<detail::CallSite *> call_sites {nullptr};
+
+
+//! Reference point for conversion of call_site_ticks() to time, taken
+//! when the first call site is registered.
+struct tick_origin
+{
+    std::uint64_t ticks;
+    std::chrono::steady_clock::time_point time;
+};
+
+
+tick_origin const &
+get_tick_origin ()
+{
+    static tick_origin const origin {detail::call_site_ticks (),
+        std::chrono::steady_clock::now ()};
+    return origin;
+}
+
+
+//! Returns number of call_site_ticks() per nanosecond, measured since
+//! get_tick_origin().
+double
+ticks_per_ns ()
+{
+    tick_origin const & origin = get_tick_origin ();
+    auto elapsed = std::chrono::steady_clock::now () - origin.time;
+    if (elapsed < std::chrono::milliseconds (10))
+    {
+        std::this_thread::sleep_for (std::chrono::milliseconds (10));
+        elapsed = std::chrono::steady_clock::now () - origin.time;
+    }
+
+    double const ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds> (elapsed)
+        .count ());
+    return static_cast<double>(detail::call_site_ticks () - origin.ticks)
+        / ns;
+}
+
+} // namespace
+
+
+namespace detail
+{
+
+CallSite::CallSite (char const * file_, int line_, char const * function_,
+    LogLevel ll)
+    : file (file_)
+    , line (line_)
+    , function (function_)
+    , logLevel (ll)
+{
+    get_tick_origin ();
+
+    CallSite * head = call_sites.load (std::memory_order_relaxed);
+    do
+        next = head;
+    while (! call_sites.compare_exchange_weak (head, this,
+            std::memory_order_release, std::memory_order_relaxed));
+}
+
+} // namespace detail
+
+
+std::vector<CallSiteProfile>
+getCallSiteProfile ()
+{
+    std::vector<CallSiteProfile> result;
+    detail::CallSite const * site = call_sites.load (std::memory_order_acquire);
+    if (! site)
+        return result;
+
+    double const tpn = ticks_per_ns ();
+    for (; site; site = site->next)
+    {
+        CallSiteProfile profile;
+        profile.file = site->file;
+        profile.line = site->line;
+        profile.function = site->function;
+        profile.logLevel = site->logLevel;
+        profile.checks = site->checks.load (std::memory_order_relaxed);
+        profile.emitted = site->emitted.load (std::memory_order_relaxed);
+        profile.bytes = site->bytes.load (std::memory_order_relaxed);
+        profile.samples = site->samples.load (std::memory_order_relaxed);
+        profile.sampledTime = std::chrono::nanoseconds (
+            static_cast<std::int64_t>(static_cast<double>(
+                    site->sampledTicks.load (std::memory_order_relaxed))
+                / tpn));
+        // Counters are read one by one while other threads log.
+        profile.checks = (std::max) (profile.checks, profile.emitted);
+        result.push_back (profile);
+    }
+
+    std::stable_sort (result.begin (), result.end (),
+        [] (CallSiteProfile const & a, CallSiteProfile const & b)
+        {
+            return a.estimatedTime () > b.estimatedTime ();
+        });
+    return result;
+}
+
+
+void
+dumpCallSiteProfile (tostream & os)
+{
+    LogLevelManager & llm = getLogLevelManager ();
+
+    os << std::setw (14) << LOG4CPLUS_TEXT ("est. time [us]")
+        << std::setw (12) << LOG4CPLUS_TEXT ("emitted")
+        << std::setw (12) << LOG4CPLUS_TEXT ("disabled")
+        << std::setw (14) << LOG4CPLUS_TEXT ("bytes")
+        << std::setw (10) << LOG4CPLUS_TEXT ("avg [ns]")
+        << LOG4CPLUS_TEXT ("  level  location\n");
+
+    for (CallSiteProfile const & p : getCallSiteProfile ())
+    {
+        auto const avg = p.samples == 0 ? 0
+            : p.sampledTime.count () / static_cast<std::int64_t>(p.samples);
+        os << std::setw (14)
+            << std::chrono::duration_cast<std::chrono::microseconds> (
+                p.estimatedTime ()).count ()
+            << std::setw (12) << p.emitted
+            << std::setw (12) << p.disabled ()
+            << std::setw (14) << p.bytes
+            << std::setw (10) << avg
+            << LOG4CPLUS_TEXT ("  ") << std::left << std::setw (5)
+            << llm.toString (p.logLevel) << std::right
+            << LOG4CPLUS_TEXT ("  ")
+            << (p.file ? LOG4CPLUS_C_STR_TO_TSTRING (p.file) : tstring ())
+            << LOG4CPLUS_TEXT (':') << p.line;
+        if (p.function)
+            os << LOG4CPLUS_TEXT (' ')
+                << LOG4CPLUS_C_STR_TO_TSTRING (p.function);
+        os << LOG4CPLUS_TEXT ('\n');
+    }
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Call site profile", "[callsiteprofile]")
+{
+    Hierarchy h;
+    Logger logger = h.getInstance (LOG4CPLUS_TEXT ("callsiteprofile"));
+    logger.addAppender (SharedAppenderPtr (new NullAppender));
+    logger.setLogLevel (INFO_LOG_LEVEL);
+
+    int const line = __LINE__ + 4;
+    for (int i = 0; i != 40; ++i)
+    {
+        // Enabled only in even iterations.
+        LOG4CPLUS_INFO (logger, LOG4CPLUS_TEXT ("0123456789"));
+        logger.setLogLevel (i % 2 ? INFO_LOG_LEVEL : ERROR_LOG_LEVEL);
+    }
+
+    std::vector<CallSiteProfile> const profile = getCallSiteProfile ();
+    auto const it = std::find_if (profile.begin (), profile.end (),
+        [&] (CallSiteProfile const & p) { return p.line == line; });
+    CATCH_REQUIRE (it != profile.end ());
+    CATCH_REQUIRE (it->logLevel == INFO_LOG_LEVEL);
+    CATCH_REQUIRE (it->checks == 40);
+    CATCH_REQUIRE (it->emitted == 20);
+    CATCH_REQUIRE (it->disabled () == 20);
+    CATCH_REQUIRE (it->bytes == 20 * 10 * sizeof (tchar));
+    CATCH_REQUIRE (it->samples == 2);
+
+    tostringstream report;
+    dumpCallSiteProfile (report);
+    CATCH_REQUIRE (report.str ().find (LOG4CPLUS_TEXT ("callsiteprofile.cxx:")
+            + helpers::convertIntegerToString (line)) != tstring::npos);
+
+    h.shutdown ();
+}
+#endif
+
+
+} // namespace log4cplus
@@ -69,15 +69,25 @@ loglog_win32_error (tchar const * msg)
 
 struct CLFSAppender::Data
 {
-    Data ()
-        : log_handle (INVALID_HANDLE_VALUE)
-        , buffer_size (0)
-    = default;
-
     tstring log_name;
-    HANDLE log_handle;
+    HANDLE log_handle{INVALID_HANDLE_VALUE};
     void * buffer{nullptr};
-    ULONG buffer_size;
+    ULONG buffer_size{0};
+
+    unsigned long flush_records{1};
+    unsigned long flush_interval{0};
+    bool async_flush{false};
+
+    //! Records appended since the last started flush.
+    unsigned long pending{0};
+    //! GetTickCount64() at the first of the pending records.
+    ULONGLONG pending_since{0};
+    //! LSN of the last appended record.
+    CLFS_LSN last_lsn{};
+    CLFS_LSN flushed_lsn{};
+
+    OVERLAPPED flush_overlapped{};
+    bool flush_outstanding{false};
 };
 
 
@@ -101,6 +111,12 @@ CLFSAppender::CLFSAppender (helpers::Properties const & props)
     unsigned long buffersize = CLFS_APPENDER_DEFAULT_BUFFER_SIZE;
     props.getULong (buffersize, LOG4CPLUS_TEXT ("BufferSize"));
 
+    props.getULong (data->flush_records, LOG4CPLUS_TEXT ("FlushRecords"));
+    if (data->flush_records == 0)
+        data->flush_records = 1;
+    props.getULong (data->flush_interval, LOG4CPLUS_TEXT ("FlushInterval"));
+    props.getBool (data->async_flush, LOG4CPLUS_TEXT ("AsyncFlush"));
+
     init (logname, logsize, buffersize);
 }
 
@@ -137,7 +153,8 @@ CLFSAppender::init (tstring const & logname, unsigned long logsize,
     data->log_handle = CreateLogFile (
         helpers::towstring (data->log_name).c_str (), GENERIC_WRITE | GENERIC_READ,
         FILE_SHARE_DELETE | FILE_SHARE_WRITE | FILE_SHARE_READ, 0,
-        OPEN_ALWAYS, FILE_ATTRIBUTE_ARCHIVE);
+        OPEN_ALWAYS, FILE_ATTRIBUTE_ARCHIVE
+            | (data->async_flush ? FILE_FLAG_OVERLAPPED : 0));
 
     if (data->log_handle == INVALID_HANDLE_VALUE)
     {
@@ -208,9 +225,25 @@ CLFSAppender::init (tstring const & logname, unsigned long logsize,
         goto error;
     }
 
+    if (data->async_flush)
+    {
+        data->flush_overlapped.hEvent = CreateEvent (0, TRUE, FALSE, 0);
+        if (! data->flush_overlapped.hEvent)
+        {
+            loglog_win32_error (LOG4CPLUS_TEXT ("CreateEvent()"));
+            data->async_flush = false;
+        }
+    }
+
     return;
 
 error:
+    if (data->buffer)
+    {
+        DeleteLogMarshallingArea (data->buffer);
+        data->buffer = nullptr;
+    }
+
     if (data->log_handle != INVALID_HANDLE_VALUE
         && data->log_handle)
     {
@@ -227,34 +260,162 @@ CLFSAppender::close ()
 {
     if (data->log_handle != INVALID_HANDLE_VALUE)
     {
+        flush ();
+        if (data->buffer)
+        {
+            DeleteLogMarshallingArea (data->buffer);
+            data->buffer = nullptr;
+        }
+
         CloseHandle (data->log_handle);
         data->log_handle = INVALID_HANDLE_VALUE;
     }
+
+    if (data->flush_overlapped.hEvent)
+    {
+        CloseHandle (data->flush_overlapped.hEvent);
+        data->flush_overlapped.hEvent = 0;
+    }
 }
 
 
 void
-CLFSAppender::append (spi::InternalLoggingEvent const & ev)
+CLFSAppender::flush ()
 {
     if (data->log_handle == INVALID_HANDLE_VALUE)
         return;
 
-    // TODO: Expose log4cplus' internal TLS to use here.
-    tostringstream oss;
-    layout->formatAndAppend(oss, ev);
+    completeFlush (true);
+    if (data->pending != 0)
+    {
+        startFlush ();
+        completeFlush (true);
+    }
+}
+
 
-    tstring str (oss.str ());
-    if ((str.size () + 1) * sizeof (tchar) > data->buffer_size)
-        str.resize (data->buffer_size / sizeof (tchar));
+bool
+CLFSAppender::appendRecord (spi::InternalLoggingEvent const & ev)
+{
+    tstring const & formatted = formatEvent (ev);
+    std::size_t length = formatted.size () + 1;
+    if (length * sizeof (tchar) > data->buffer_size)
+        length = data->buffer_size / sizeof (tchar);
 
+    // Truncated records do not keep the terminating NUL.
     CLFS_WRITE_ENTRY clfs_write_entry;
-    clfs_write_entry.Buffer = const_cast<tchar *>(str.c_str ());
-    clfs_write_entry.ByteLength
-        = static_cast<ULONG>((str.size () + 1) * sizeof (tchar));
+    clfs_write_entry.Buffer = const_cast<tchar *>(formatted.c_str ());
+    clfs_write_entry.ByteLength = static_cast<ULONG>(length * sizeof (tchar));
 
+    // Records stay in the marshalling area until flushIfDue() flushes
+    // them, or until the area runs out of free buffers.
     if (! ReserveAndAppendLog (data->buffer, &clfs_write_entry, 1, 0, 0, 0, 0,
-        CLFS_FLAG_FORCE_APPEND, 0, 0))
+        0, &data->last_lsn, 0))
+    {
         loglog_win32_error (LOG4CPLUS_TEXT ("ReserveAndAppendLog"));
+        return false;
+    }
+
+    if (data->pending++ == 0)
+        data->pending_since = GetTickCount64 ();
+
+    return true;
+}
+
+
+void
+CLFSAppender::flushIfDue ()
+{
+    if (data->pending == 0)
+        return;
+
+    if (data->pending < data->flush_records
+        && (data->flush_interval == 0
+            || GetTickCount64 () - data->pending_since
+                < data->flush_interval))
+        return;
+
+    // With an overlapped flush still running the records stay pending
+    // and the next append retries.
+    if (! completeFlush (! data->async_flush))
+        return;
+
+    startFlush ();
+}
+
+
+void
+CLFSAppender::startFlush ()
+{
+    data->pending = 0;
+
+    if (! data->async_flush)
+    {
+        if (! FlushLogToLsn (data->buffer, &data->last_lsn,
+            &data->flushed_lsn, 0))
+            loglog_win32_error (LOG4CPLUS_TEXT ("FlushLogToLsn"));
+
+        return;
+    }
+
+    ResetEvent (data->flush_overlapped.hEvent);
+    if (FlushLogToLsn (data->buffer, &data->last_lsn, &data->flushed_lsn,
+        &data->flush_overlapped))
+        return;
+
+    if (GetLastError () == ERROR_IO_PENDING)
+        data->flush_outstanding = true;
+    else
+        loglog_win32_error (LOG4CPLUS_TEXT ("FlushLogToLsn"));
+}
+
+
+bool
+CLFSAppender::completeFlush (bool wait)
+{
+    if (! data->flush_outstanding)
+        return true;
+
+    DWORD transferred = 0;
+    if (! GetOverlappedResult (data->log_handle, &data->flush_overlapped,
+        &transferred, wait))
+    {
+        if (GetLastError () == ERROR_IO_INCOMPLETE)
+            return false;
+
+        loglog_win32_error (LOG4CPLUS_TEXT ("FlushLogToLsn"));
+    }
+
+    data->flush_outstanding = false;
+    return true;
+}
+
+
+void
+CLFSAppender::append (spi::InternalLoggingEvent const & ev)
+{
+    if (data->log_handle == INVALID_HANDLE_VALUE)
+        return;
+
+    if (appendRecord (ev))
+        flushIfDue ();
+}
+
+
+void
+CLFSAppender::appendBatch (std::span<spi::InternalLoggingEvent const> events)
+{
+    if (data->log_handle == INVALID_HANDLE_VALUE)
+        return;
+
+    // The whole batch is appended into the marshalling area before the
+    // thresholds are checked, so it is flushed at most once.
+    bool appended = false;
+    for (auto const & ev : events)
+        appended |= appendRecord (ev);
+
+    if (appended)
+        flushIfDue ();
 }
 
 
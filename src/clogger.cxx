@@ -28,11 +28,17 @@
 #include <log4cplus/configurator.h>
 #include <log4cplus/streams.h>
 #include <log4cplus/helpers/snprintf.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/initializer.h>
 #include <log4cplus/callbackappender.h>
+#include <log4cplus/runtimecontrol.h>
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/internal/customloglevelmanager.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdio>
 #include <cstdarg>
@@ -40,11 +46,56 @@
 
 #include <sstream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <chrono>
+#include <thread>
+#include <catch.hpp>
+#endif
 
 using namespace log4cplus;
 using namespace log4cplus::helpers;
 
 
+namespace
+{
+
+//! Formats message into the per-thread buffer, which keeps its
+//! capacity between calls, and logs it without checking the level.
+void
+format_and_log(Logger const & logger, loglevel_t ll,
+    const log4cplus_char_t *msgfmt, std::va_list ap,
+    const char *file = nullptr, int line = -1, const char *function = nullptr)
+{
+    snprintf_buf & buf = internal::get_ptd()->snprintf_buf;
+    const tchar * msg = nullptr;
+    int ret;
+
+    do
+    {
+        std::va_list args;
+        va_copy(args, ap);
+        ret = buf.print_va_list(msg, msgfmt, args);
+        va_end(args);
+    }
+    while (ret == -1);
+
+    logger.forcedLog(ll, msg, file, line, function);
+}
+
+
+Logger const &
+to_logger(log4cplus_logger_t logger)
+{
+    return *static_cast<Logger const *>(logger);
+}
+
+} // namespace
+
+
 LOG4CPLUS_EXPORT void *
 log4cplus_initialize(void)
 {
@@ -228,6 +279,41 @@ log4cplus_add_callback_appender(const log4cplus_char_t * logger_name,
 }
 
 
+LOG4CPLUS_EXPORT int
+log4cplus_add_batch_callback_appender(const log4cplus_char_t * logger_name,
+    log4cplus_log_event_batch_callback_t callback, void * cookie,
+    size_t batch_size, unsigned long batch_interval_ms)
+{
+    if (! callback)
+        return EINVAL;
+
+    try
+    {
+        Logger logger = logger_name
+            ? Logger::getInstance(logger_name)
+            : Logger::getRoot();
+        helpers::Properties props;
+        props.setProperty(LOG4CPLUS_TEXT("AsyncAppend"),
+            LOG4CPLUS_TEXT("true"));
+        props.setProperty(LOG4CPLUS_TEXT("BatchSize"),
+            helpers::convertIntegerToString(batch_size));
+        props.setProperty(LOG4CPLUS_TEXT("BatchIntervalMs"),
+            helpers::convertIntegerToString(batch_interval_ms));
+        helpers::SharedObjectPtr<CallbackAppender> appender(
+            new CallbackAppender(props));
+        appender->setBatchCallback(callback);
+        appender->setCookie(cookie);
+        logger.addAppender(SharedAppenderPtr(appender.get()));
+    }
+    catch (std::exception const &)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+
 LOG4CPLUS_EXPORT int
 log4cplus_logger_exists(const log4cplus_char_t *name)
 {
@@ -275,19 +361,10 @@ log4cplus_logger_log(const log4cplus_char_t *name, loglevel_t ll,
 
         if( logger.isEnabledFor(ll) )
         {
-            const tchar * msg = nullptr;
-            snprintf_buf buf;
             std::va_list ap;
-
-            do
-            {
-                va_start(ap, msgfmt);
-                retval = buf.print_va_list(msg, msgfmt, ap);
-                va_end(ap);
-            }
-            while (retval == -1);
-
-            logger.forcedLog(ll, msg, nullptr, -1);
+            va_start(ap, msgfmt);
+            format_and_log(logger, ll, msgfmt, ap);
+            va_end(ap);
         }
 
         retval = 0;
@@ -336,23 +413,122 @@ log4cplus_logger_force_log(const log4cplus_char_t *name, loglevel_t ll,
     try
     {
         Logger logger = name ? Logger::getInstance(name) : Logger::getRoot();
-        const tchar * msg = nullptr;
-        snprintf_buf buf;
         std::va_list ap;
+        va_start(ap, msgfmt);
+        format_and_log(logger, ll, msgfmt, ap);
+        va_end(ap);
+
+        retval = 0;
+    }
+    catch(std::exception const &)
+    {
+        // Fall through.
+    }
+
+    return retval;
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_logger_force_log_str(const log4cplus_char_t *name, loglevel_t ll,
+    const log4cplus_char_t *msg)
+{
+    int retval = -1;
 
-        do
+    try
+    {
+        Logger logger = name ? Logger::getInstance(name) : Logger::getRoot();
+        logger.forcedLog(ll, msg, nullptr, -1);
+        retval = 0;
+    }
+    catch (std::exception const &)
+    {
+        // Fall through.
+    }
+
+    return retval;
+}
+
+
+LOG4CPLUS_EXPORT log4cplus_logger_t
+log4cplus_logger_get(const log4cplus_char_t *name)
+{
+    try
+    {
+        return new Logger(name ? Logger::getInstance(name)
+            : Logger::getRoot());
+    }
+    catch (std::exception const &)
+    {
+        return nullptr;
+    }
+}
+
+
+LOG4CPLUS_EXPORT void
+log4cplus_logger_release(log4cplus_logger_t logger)
+{
+    delete static_cast<Logger *>(logger);
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_logger_is_enabled_for_h(log4cplus_logger_t logger, loglevel_t ll)
+{
+    if (!logger)
+        return false;
+
+    return to_logger(logger).isEnabledFor(ll);
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_logger_log_h(log4cplus_logger_t logger, loglevel_t ll,
+    const log4cplus_char_t *msgfmt, ...)
+{
+    if (!logger || !msgfmt)
+        return EINVAL;
+
+    int retval = -1;
+
+    try
+    {
+        if (to_logger(logger).isEnabledFor(ll))
         {
+            std::va_list ap;
             va_start(ap, msgfmt);
-            retval = buf.print_va_list(msg, msgfmt, ap);
+            format_and_log(to_logger(logger), ll, msgfmt, ap);
             va_end(ap);
         }
-        while (retval == -1);
 
-        logger.forcedLog(ll, msg, nullptr, -1);
+        retval = 0;
+    }
+    catch (std::exception const &)
+    {
+        // Fall through.
+    }
+
+    return retval;
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_logger_log_str_h(log4cplus_logger_t logger, loglevel_t ll,
+    const log4cplus_char_t *msg)
+{
+    if (!logger || !msg)
+        return EINVAL;
+
+    int retval = -1;
+
+    try
+    {
+        if (to_logger(logger).isEnabledFor(ll))
+            to_logger(logger).forcedLog(ll, msg, nullptr, -1);
 
         retval = 0;
     }
-    catch(std::exception const &)
+    catch (std::exception const &)
     {
         // Fall through.
     }
@@ -362,15 +538,114 @@ log4cplus_logger_force_log(const log4cplus_char_t *name, loglevel_t ll,
 
 
 LOG4CPLUS_EXPORT int
-log4cplus_logger_force_log_str(const log4cplus_char_t *name, loglevel_t ll,
+log4cplus_logger_force_log_h(log4cplus_logger_t logger, loglevel_t ll,
+    const log4cplus_char_t *msgfmt, ...)
+{
+    if (!logger || !msgfmt)
+        return EINVAL;
+
+    int retval = -1;
+
+    try
+    {
+        std::va_list ap;
+        va_start(ap, msgfmt);
+        format_and_log(to_logger(logger), ll, msgfmt, ap);
+        va_end(ap);
+
+        retval = 0;
+    }
+    catch (std::exception const &)
+    {
+        // Fall through.
+    }
+
+    return retval;
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_logger_force_log_str_h(log4cplus_logger_t logger, loglevel_t ll,
     const log4cplus_char_t *msg)
 {
+    if (!logger || !msg)
+        return EINVAL;
+
     int retval = -1;
 
     try
     {
-        Logger logger = name ? Logger::getInstance(name) : Logger::getRoot();
-        logger.forcedLog(ll, msg, nullptr, -1);
+        to_logger(logger).forcedLog(ll, msg, nullptr, -1);
+        retval = 0;
+    }
+    catch (std::exception const &)
+    {
+        // Fall through.
+    }
+
+    return retval;
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_logger_log_batch_h(log4cplus_logger_t logger,
+    const log4cplus_record_t *records, size_t count)
+{
+    if (!logger || (!records && count != 0))
+        return EINVAL;
+
+    int retval = -1;
+
+    try
+    {
+        Logger const & l = to_logger(logger);
+
+        // Events keep capacity of their strings between calls.
+        thread_local std::vector<spi::InternalLoggingEvent> events;
+        events.resize(count);
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            log4cplus_record_t const & rec = records[i];
+            spi::InternalLoggingEvent & ev = events[i];
+            ev.setLoggingEvent(&l.getName(), rec.ll,
+                rec.message ? rec.message : LOG4CPLUS_TEXT(""),
+                rec.file, rec.line, rec.function);
+            if (rec.timestamp_secs != 0 || rec.timestamp_usecs != 0)
+                ev.setTimestamp(time_from_parts(
+                    static_cast<time_t>(rec.timestamp_secs),
+                    static_cast<long>(rec.timestamp_usecs)));
+        }
+
+        l.logBatch(events);
+        retval = 0;
+    }
+    catch (std::exception const &)
+    {
+        // Fall through.
+    }
+
+    return retval;
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_logger_force_log_loc_h(log4cplus_logger_t logger, loglevel_t ll,
+    const char *file, int line, const char *function,
+    const log4cplus_char_t *msgfmt, ...)
+{
+    if (!logger || !msgfmt)
+        return EINVAL;
+
+    int retval = -1;
+
+    try
+    {
+        std::va_list ap;
+        va_start(ap, msgfmt);
+        format_and_log(to_logger(logger), ll, msgfmt, ap, file, line,
+            function);
+        va_end(ap);
+
         retval = 0;
     }
     catch (std::exception const &)
@@ -384,38 +659,94 @@ log4cplus_logger_force_log_str(const log4cplus_char_t *name, loglevel_t ll,
 
 namespace log4cplus::internal {
 
+namespace
+{
+
+//! Translator registered with LogLevelManager on behalf of
+//! CustomLogLevelManager. LogLevelManager owns its translators through
+//! SharedObjectPtr, so it cannot be given CustomLogLevelManager itself.
+class CustomLogLevelTranslator
+    : virtual public LogLevelTranslator
+{
+public:
+    explicit CustomLogLevelTranslator (CustomLogLevelManager const & m)
+        : manager (m)
+    { }
+
+    log4cplus::tstring const &
+    toString (LogLevel ll) const override
+    {
+        return manager.toString (ll);
+    }
+
+    LogLevel
+    fromString (const log4cplus::tstring_view& s) const override
+    {
+        return manager.fromString (s);
+    }
+
+private:
+    CustomLogLevelManager const & manager;
+};
+
+} // namespace
+
+
 CustomLogLevelManager::CustomLogLevelManager ()
     : pushed_methods (false)
+    , table (nullptr)
 { }
 
 
 CustomLogLevelManager::~CustomLogLevelManager () = default;
 
 
+void
+CustomLogLevelManager::publish (std::unique_ptr<Table const> t)
+{
+    table.store (t.get (), std::memory_order_release);
+    tables.push_back (std::move (t));
+    getLogLevelManager ().invalidateCaches ();
+}
+
+
 bool
 CustomLogLevelManager::add(LogLevel ll, tstring const &nm)
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    std::unique_lock guard (mtx);
+    std::lock_guard guard (mtx);
 #endif
 
     if (! pushed_methods)
     {
         pushed_methods = true;
-        getLogLevelManager().pushLogLevelTranslator (SharedLogLevelTranslatorPtr (this));
+        getLogLevelManager().pushLogLevelTranslator (
+            SharedLogLevelTranslatorPtr (new CustomLogLevelTranslator (*this)));
     }
 
-    auto i = ll2nm.lower_bound(ll);
-    if( ( i != ll2nm.end() ) && ( i->first == ll ) && ( i->second != nm ) )
+    Table const * const current = table.load (std::memory_order_relaxed);
+    auto t = current ? std::make_unique<Table> (*current)
+        : std::make_unique<Table> ();
+
+    auto i = std::lower_bound (t->ll2nm.begin (), t->ll2nm.end (), ll,
+        [](auto const & item, LogLevel key) { return item.first < key; });
+    bool const ll_found = i != t->ll2nm.end() && i->first == ll;
+    if( ll_found && ( i->second != nm ) )
         return false;
 
-    auto j = nm2ll.lower_bound(nm);
-    if( ( j != nm2ll.end() ) && ( j->first == nm ) && ( j->second != ll ) )
+    auto j = std::lower_bound (t->nm2ll.begin (), t->nm2ll.end (), nm,
+        [](auto const & item, tstring const & key) { return item.first < key; });
+    bool const nm_found = j != t->nm2ll.end() && j->first == nm;
+    if( nm_found && ( j->second != ll ) )
         return false;
 
     // there is no else after return
-    ll2nm.insert( i, std::make_pair(ll, nm) );
-    nm2ll.insert( j, std::make_pair(nm, ll) );
+    if (ll_found && nm_found)
+        return true;
+
+    t->ll2nm.emplace( i, ll, nm );
+    t->nm2ll.emplace( j, nm, ll );
+    publish (std::move (t));
 
     return true;
 }
@@ -425,15 +756,23 @@ bool
 CustomLogLevelManager::remove(LogLevel ll, tstring const &nm)
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    std::unique_lock guard (mtx);
+    std::lock_guard guard (mtx);
 #endif
 
-    auto i = ll2nm.find(ll);
-    auto j = nm2ll.find(nm);
-    if( ( i != ll2nm.end() ) && ( j != nm2ll.end() ) &&
+    Table const * const current = table.load (std::memory_order_relaxed);
+    if (! current)
+        return false;
+
+    auto t = std::make_unique<Table> (*current);
+    auto i = std::find_if (t->ll2nm.begin (), t->ll2nm.end (),
+        [&](auto const & item) { return item.first == ll; });
+    auto j = std::find_if (t->nm2ll.begin (), t->nm2ll.end (),
+        [&](auto const & item) { return item.first == nm; });
+    if( ( i != t->ll2nm.end() ) && ( j != t->nm2ll.end() ) &&
         ( i->first == j->second ) && ( i->second == j->first ) ) {
-        ll2nm.erase(i);
-        nm2ll.erase(j);
+        t->ll2nm.erase(i);
+        t->nm2ll.erase(j);
+        publish (std::move (t));
 
         return true;
     }
@@ -446,12 +785,13 @@ CustomLogLevelManager::remove(LogLevel ll, tstring const &nm)
 log4cplus::tstring const &
 CustomLogLevelManager::toString (LogLevel ll) const
 {
-#if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    std::shared_lock guard (mtx);
-#endif
+    Table const * const t = table.load (std::memory_order_acquire);
+    if (! t)
+        return internal::empty_str;
 
-    auto i = ll2nm.find(ll);
-    if( i != ll2nm.end() )
+    auto i = std::lower_bound (t->ll2nm.begin (), t->ll2nm.end (), ll,
+        [](auto const & item, LogLevel key) { return item.first < key; });
+    if( i != t->ll2nm.end() && i->first == ll )
         return i->second;
 
     return internal::empty_str;
@@ -461,11 +801,14 @@ CustomLogLevelManager::toString (LogLevel ll) const
 LogLevel
 CustomLogLevelManager::fromString (const log4cplus::tstring_view& nm) const
 {
-#if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    std::shared_lock guard (mtx);
-#endif
-    auto i = nm2ll.find(nm);
-    if( i != nm2ll.end() )
+    Table const * const t = table.load (std::memory_order_acquire);
+    if (! t)
+        return NOT_SET_LOG_LEVEL;
+
+    auto i = std::lower_bound (t->nm2ll.begin (), t->nm2ll.end (), nm,
+        [](auto const & item, tstring_view const & key)
+        { return item.first < key; });
+    if( i != t->nm2ll.end() && i->first == nm )
         return i->second;
 
     return NOT_SET_LOG_LEVEL;
@@ -474,6 +817,109 @@ CustomLogLevelManager::fromString (const log4cplus::tstring_view& nm) const
 } // namespace log4cplus
 
 
+LOG4CPLUS_EXPORT int
+log4cplus_control(const log4cplus_char_t *command, log4cplus_char_t *reply,
+    size_t reply_size)
+{
+    if (!command)
+        return EINVAL;
+
+    try
+    {
+        bool ok = false;
+        tstring const result
+            = getDefaultRuntimeControl().execute(command, ok);
+        if (reply && reply_size != 0)
+        {
+            std::size_t const len = (std::min)(result.size(), reply_size - 1);
+            std::copy(result.begin(), result.begin() + len, reply);
+            reply[len] = 0;
+        }
+
+        return ok ? 0 : -1;
+    }
+    catch (std::exception const &)
+    {
+        return -1;
+    }
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_control_set_log_level(const log4cplus_char_t *prefix,
+    loglevel_t ll)
+{
+    if (!prefix)
+        return EINVAL;
+
+    try
+    {
+        getDefaultRuntimeControl().setLogLevel(prefix, ll);
+    }
+    catch (std::exception const &)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_control_set_appender_enabled(const log4cplus_char_t *name,
+    int enabled)
+{
+    if (!name)
+        return EINVAL;
+
+    try
+    {
+        return getDefaultRuntimeControl().setAppenderEnabled(name,
+            enabled != 0) != 0 ? 0 : -1;
+    }
+    catch (std::exception const &)
+    {
+        return -1;
+    }
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_control_listen(const log4cplus_char_t *path)
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_HAVE_SYS_UN_H) && ! defined (_WIN32)
+    static std::mutex mtx;
+    static std::unique_ptr<ControlEndpoint> endpoint;
+
+    try
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        endpoint.reset();
+        if (!path)
+            return 0;
+
+        endpoint.reset(new ControlEndpoint(getDefaultRuntimeControl(),
+            path));
+        if (!endpoint->isOpen())
+        {
+            endpoint.reset();
+            return -1;
+        }
+    }
+    catch (std::exception const &)
+    {
+        return -1;
+    }
+
+    return 0;
+#else
+    (void) path;
+    return ENOTSUP;
+#endif
+}
+
+
 LOG4CPLUS_EXPORT int
 log4cplus_add_log_level(unsigned int ll, const log4cplus_char_t *ll_name)
 {
@@ -499,3 +945,345 @@ log4cplus_remove_log_level(unsigned int ll, const log4cplus_char_t *ll_name)
 
     return -1;
 }
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("C logger handles", "[clogger]")
+{
+    struct event
+    {
+        tstring message;
+        loglevel_t ll;
+    };
+    std::vector<event> events;
+    auto const callback = [] (void * cookie, log4cplus_char_t const * message,
+        log4cplus_char_t const *, log4cplus_loglevel_t ll,
+        log4cplus_char_t const *, log4cplus_char_t const *,
+        unsigned long long, unsigned long, log4cplus_char_t const *,
+        log4cplus_char_t const *, int)
+    {
+        static_cast<std::vector<event> *> (cookie)->push_back (
+            event {message, ll});
+    };
+
+    tchar const logger_name[] = LOG4CPLUS_TEXT ("test.clogger.handle");
+    Logger logger = Logger::getInstance (logger_name);
+    logger.setAdditivity (false);
+    logger.setLogLevel (INFO_LOG_LEVEL);
+    CATCH_REQUIRE (log4cplus_add_callback_appender (logger_name, callback,
+            &events) == 0);
+
+    log4cplus_logger_t const handle = log4cplus_logger_get (logger_name);
+    CATCH_REQUIRE (handle);
+    CATCH_REQUIRE (! log4cplus_logger_is_enabled_for_h (handle,
+            L4CP_DEBUG_LOG_LEVEL));
+    CATCH_REQUIRE (log4cplus_logger_is_enabled_for_h (handle,
+            L4CP_INFO_LOG_LEVEL));
+
+    CATCH_REQUIRE (log4cplus_logger_log_h (handle, L4CP_DEBUG_LOG_LEVEL,
+            LOG4CPLUS_TEXT ("skipped %d"), 1) == 0);
+    CATCH_REQUIRE (log4cplus_logger_log_h (handle, L4CP_INFO_LOG_LEVEL,
+            LOG4CPLUS_TEXT ("value %d"), 42) == 0);
+    tstring const long_arg (1000, LOG4CPLUS_TEXT ('x'));
+    CATCH_REQUIRE (log4cplus_logger_log_h (handle, L4CP_WARN_LOG_LEVEL,
+            LOG4CPLUS_TEXT ("%s!"), long_arg.c_str ()) == 0);
+    CATCH_REQUIRE (log4cplus_logger_log_str_h (handle, L4CP_INFO_LOG_LEVEL,
+            LOG4CPLUS_TEXT ("plain")) == 0);
+    CATCH_REQUIRE (log4cplus_logger_force_log_h (handle, L4CP_DEBUG_LOG_LEVEL,
+            LOG4CPLUS_TEXT ("forced %d"), 2) == 0);
+    CATCH_REQUIRE (log4cplus_logger_force_log_str_h (handle,
+            L4CP_DEBUG_LOG_LEVEL, LOG4CPLUS_TEXT ("forced str")) == 0);
+    CATCH_REQUIRE (log4cplus_logger_log_h (nullptr, L4CP_INFO_LOG_LEVEL,
+            LOG4CPLUS_TEXT ("none")) == EINVAL);
+
+    CATCH_REQUIRE (events.size () == 5);
+    CATCH_REQUIRE (events[0].message == LOG4CPLUS_TEXT ("value 42"));
+    CATCH_REQUIRE (events[0].ll == L4CP_INFO_LOG_LEVEL);
+    CATCH_REQUIRE (events[1].message == long_arg + LOG4CPLUS_TEXT ("!"));
+    CATCH_REQUIRE (events[2].message == LOG4CPLUS_TEXT ("plain"));
+    CATCH_REQUIRE (events[3].message == LOG4CPLUS_TEXT ("forced 2"));
+    CATCH_REQUIRE (events[4].message == LOG4CPLUS_TEXT ("forced str"));
+
+    // The handle follows level changes.
+    logger.setLogLevel (DEBUG_LOG_LEVEL);
+    CATCH_REQUIRE (log4cplus_logger_is_enabled_for_h (handle,
+            L4CP_DEBUG_LOG_LEVEL));
+
+    CATCH_SECTION ("macros")
+    {
+        events.clear ();
+        int evaluated = 0;
+        logger.setLogLevel (INFO_LOG_LEVEL);
+        LOG4CPLUS_C_DEBUG (handle, LOG4CPLUS_TEXT ("skipped %d"), ++evaluated);
+        CATCH_REQUIRE (evaluated == 0);
+
+        struct location
+        {
+            tstring file;
+            tstring function;
+            int line;
+        };
+        location loc {};
+        log4cplus_logger_t const loc_handle = log4cplus_logger_get (
+            LOG4CPLUS_TEXT ("test.clogger.location"));
+        Logger loc_logger = Logger::getInstance (
+            LOG4CPLUS_TEXT ("test.clogger.location"));
+        loc_logger.setAdditivity (false);
+        CATCH_REQUIRE (log4cplus_add_callback_appender (
+                LOG4CPLUS_TEXT ("test.clogger.location"),
+                [] (void * cookie, log4cplus_char_t const *,
+                    log4cplus_char_t const *, log4cplus_loglevel_t,
+                    log4cplus_char_t const *, log4cplus_char_t const *,
+                    unsigned long long, unsigned long,
+                    log4cplus_char_t const * file,
+                    log4cplus_char_t const * function, int line)
+                {
+                    auto & l = *static_cast<location *> (cookie);
+                    l.file = file;
+                    l.function = function;
+                    l.line = line;
+                }, &loc) == 0);
+
+        int const line = __LINE__ + 1;
+        LOG4CPLUS_C_WARN (loc_handle, LOG4CPLUS_TEXT ("at %d"), ++evaluated);
+        CATCH_REQUIRE (evaluated == 1);
+        CATCH_REQUIRE (loc.line == line);
+        CATCH_REQUIRE (loc.file.find (LOG4CPLUS_TEXT ("clogger.cxx"))
+            != tstring::npos);
+        CATCH_REQUIRE (! loc.function.empty ());
+
+        log4cplus_logger_release (loc_handle);
+        loc_logger.removeAllAppenders ();
+        loc_logger.setAdditivity (true);
+    }
+
+    CATCH_SECTION ("batch")
+    {
+        struct stamped
+        {
+            tstring message;
+            unsigned long long secs;
+            int line;
+        };
+        std::vector<stamped> batch_events;
+        log4cplus_logger_t const batch_handle = log4cplus_logger_get (
+            LOG4CPLUS_TEXT ("test.clogger.batch"));
+        Logger batch_logger = Logger::getInstance (
+            LOG4CPLUS_TEXT ("test.clogger.batch"));
+        batch_logger.setAdditivity (false);
+        batch_logger.setLogLevel (INFO_LOG_LEVEL);
+        CATCH_REQUIRE (log4cplus_add_callback_appender (
+                LOG4CPLUS_TEXT ("test.clogger.batch"),
+                [] (void * cookie, log4cplus_char_t const * message,
+                    log4cplus_char_t const *, log4cplus_loglevel_t,
+                    log4cplus_char_t const *, log4cplus_char_t const *,
+                    unsigned long long secs, unsigned long,
+                    log4cplus_char_t const *, log4cplus_char_t const *,
+                    int line)
+                {
+                    static_cast<std::vector<stamped> *> (cookie)->push_back (
+                        stamped {message, secs, line});
+                }, &batch_events) == 0);
+
+        log4cplus_record_t const records[] = {
+            {L4CP_INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("first"), 1000, 5,
+             "a.c", 1, "f"},
+            {L4CP_DEBUG_LOG_LEVEL, LOG4CPLUS_TEXT ("disabled"), 1001, 0,
+             nullptr, 2, nullptr},
+            {L4CP_ERROR_LOG_LEVEL, LOG4CPLUS_TEXT ("second"), 1002, 0,
+             nullptr, 3, nullptr},
+            {L4CP_WARN_LOG_LEVEL, LOG4CPLUS_TEXT ("third"), 0, 0,
+             nullptr, 4, nullptr}};
+        CATCH_REQUIRE (log4cplus_logger_log_batch_h (batch_handle, records,
+                sizeof (records) / sizeof (records[0])) == 0);
+        CATCH_REQUIRE (log4cplus_logger_log_batch_h (batch_handle, nullptr,
+                0) == 0);
+
+        CATCH_REQUIRE (batch_events.size () == 3);
+        CATCH_REQUIRE (batch_events[0].message == LOG4CPLUS_TEXT ("first"));
+        CATCH_REQUIRE (batch_events[0].secs == 1000);
+        CATCH_REQUIRE (batch_events[0].line == 1);
+        CATCH_REQUIRE (batch_events[1].message == LOG4CPLUS_TEXT ("second"));
+        CATCH_REQUIRE (batch_events[1].secs == 1002);
+        CATCH_REQUIRE (batch_events[2].message == LOG4CPLUS_TEXT ("third"));
+        CATCH_REQUIRE (batch_events[2].secs > 1002);
+
+        log4cplus_logger_release (batch_handle);
+        batch_logger.removeAllAppenders ();
+        batch_logger.setLogLevel (NOT_SET_LOG_LEVEL);
+        batch_logger.setAdditivity (true);
+    }
+
+    log4cplus_logger_release (handle);
+    logger.removeAllAppenders ();
+    logger.setLogLevel (NOT_SET_LOG_LEVEL);
+    logger.setAdditivity (true);
+}
+
+
+CATCH_TEST_CASE ("C batch callback appender", "[clogger]")
+{
+    struct batches
+    {
+        std::mutex mtx;
+        std::vector<std::vector<tstring>> received;
+    };
+    batches got;
+    auto const callback = [] (void * cookie,
+        log4cplus_event_view_t const * events, size_t count)
+    {
+        auto & b = *static_cast<batches *> (cookie);
+        std::vector<tstring> messages;
+        for (size_t i = 0; i != count; ++i)
+            messages.emplace_back (events[i].message, events[i].message_len);
+        std::lock_guard<std::mutex> guard (b.mtx);
+        b.received.push_back (std::move (messages));
+    };
+
+    tchar const logger_name[] = LOG4CPLUS_TEXT ("test.clogger.batch_callback");
+    Logger logger = Logger::getInstance (logger_name);
+    logger.setAdditivity (false);
+    logger.setLogLevel (TRACE_LOG_LEVEL);
+    spi::InternalLoggingEvent events[5];
+    for (int i = 0; i != 5; ++i)
+        events[i].setLoggingEvent (logger.getName (), INFO_LOG_LEVEL,
+            convertIntegerToString (i), nullptr, -1);
+
+    CATCH_SECTION ("arrays of appended batches")
+    {
+        helpers::SharedObjectPtr<CallbackAppender> appender (
+            new CallbackAppender (callback, &got, 2));
+        appender->syncDoAppendBatch (events);
+        CATCH_REQUIRE (got.received.size () == 3);
+        CATCH_REQUIRE (got.received[0] == std::vector<tstring> {
+                LOG4CPLUS_TEXT ("0"), LOG4CPLUS_TEXT ("1")});
+        CATCH_REQUIRE (got.received[2] == std::vector<tstring> {
+                LOG4CPLUS_TEXT ("4")});
+
+        appender->syncDoAppend (events[0]);
+        CATCH_REQUIRE (got.received.size () == 4);
+        appender->close ();
+    }
+
+    CATCH_SECTION ("timer passes partial batches")
+    {
+        helpers::SharedObjectPtr<CallbackAppender> appender (
+            new CallbackAppender (callback, &got, 4, 10));
+        for (auto const & ev : events)
+            appender->syncDoAppend (ev);
+        {
+            std::lock_guard<std::mutex> guard (got.mtx);
+            CATCH_REQUIRE (got.received.size () == 1);
+            CATCH_REQUIRE (got.received[0].size () == 4);
+        }
+
+        for (int i = 0; i != 500; ++i)
+        {
+            {
+                std::lock_guard<std::mutex> guard (got.mtx);
+                if (got.received.size () == 2)
+                    break;
+            }
+            std::this_thread::sleep_for (std::chrono::milliseconds (10));
+        }
+
+        appender->close ();
+        CATCH_REQUIRE (got.received.size () == 2);
+        CATCH_REQUIRE (got.received[1] == std::vector<tstring> {
+                LOG4CPLUS_TEXT ("4")});
+    }
+
+    CATCH_SECTION ("C interface")
+    {
+        CATCH_REQUIRE (log4cplus_add_batch_callback_appender (logger_name,
+                nullptr, &got, 8, 0) == EINVAL);
+        CATCH_REQUIRE (log4cplus_add_batch_callback_appender (logger_name,
+                callback, &got, 8, 0) == 0);
+        logger.logBatch (events);
+        logger.forcedLog (INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("5"));
+        for (auto & appender : logger.getAllAppenders ())
+            appender->waitToFinishAsyncLogging ();
+
+        std::vector<tstring> all;
+        for (auto const & batch : got.received)
+        {
+            CATCH_REQUIRE (batch.size () <= 8);
+            all.insert (all.end (), batch.begin (), batch.end ());
+        }
+        CATCH_REQUIRE (all.size () == 6);
+        CATCH_REQUIRE (all.back () == LOG4CPLUS_TEXT ("5"));
+    }
+
+    logger.removeAllAppenders ();
+    logger.setLogLevel (NOT_SET_LOG_LEVEL);
+    logger.setAdditivity (true);
+}
+
+
+CATCH_TEST_CASE ("C runtime control", "[clogger]")
+{
+    tchar const logger_name[] = LOG4CPLUS_TEXT ("test.clogger.control");
+    Logger logger = Logger::getInstance (logger_name);
+    Logger child = Logger::getInstance (
+        LOG4CPLUS_TEXT ("test.clogger.control.child"));
+    child.setLogLevel (ERROR_LOG_LEVEL);
+
+    CATCH_REQUIRE (log4cplus_control_set_log_level (logger_name,
+            L4CP_TRACE_LOG_LEVEL) == 0);
+    CATCH_REQUIRE (child.getLogLevel () == TRACE_LOG_LEVEL);
+
+    log4cplus_char_t reply[8];
+    CATCH_REQUIRE (log4cplus_control (
+            LOG4CPLUS_TEXT ("level test.clogger.control WARN"), reply,
+            sizeof (reply) / sizeof (reply[0])) == 0);
+    CATCH_REQUIRE (tstring (reply) == LOG4CPLUS_TEXT ("OK 2"));
+    CATCH_REQUIRE (logger.getLogLevel () == WARN_LOG_LEVEL);
+
+    // Reply is truncated.
+    CATCH_REQUIRE (log4cplus_control (LOG4CPLUS_TEXT ("frobnicate"), reply,
+            sizeof (reply) / sizeof (reply[0])) == -1);
+    CATCH_REQUIRE (tstring (reply) == LOG4CPLUS_TEXT ("ERROR i"));
+
+    CATCH_REQUIRE (log4cplus_control_set_appender_enabled (
+            LOG4CPLUS_TEXT ("test.clogger.missing"), 0) == -1);
+    CATCH_REQUIRE (log4cplus_control (nullptr, nullptr, 0) == EINVAL);
+}
+
+
+CATCH_TEST_CASE ("Custom log levels", "[loglevel]")
+{
+    LogLevelManager & llm = getLogLevelManager ();
+    LogLevel const audit = 35123;
+    tstring const audit_name (LOG4CPLUS_TEXT ("TEST_AUDIT"));
+
+    CATCH_REQUIRE (log4cplus_add_log_level (audit, audit_name.c_str ()) == 0);
+    CATCH_REQUIRE (log4cplus_add_log_level (audit, audit_name.c_str ()) == 0);
+    CATCH_REQUIRE (log4cplus_add_log_level (audit,
+            LOG4CPLUS_TEXT ("TEST_OTHER")) == -1);
+    CATCH_REQUIRE (log4cplus_add_log_level (audit + 1,
+            audit_name.c_str ()) == -1);
+
+    tstring const & name = llm.toString (audit);
+    CATCH_REQUIRE (name == audit_name);
+    CATCH_REQUIRE (llm.fromString (audit_name) == audit);
+
+    CATCH_REQUIRE (log4cplus_add_log_level (audit + 10,
+            LOG4CPLUS_TEXT ("TEST_NOTICE")) == 0);
+    CATCH_REQUIRE (llm.fromString (LOG4CPLUS_TEXT ("TEST_NOTICE"))
+        == audit + 10);
+
+    CATCH_REQUIRE (log4cplus_remove_log_level (audit,
+            LOG4CPLUS_TEXT ("TEST_NOTICE")) == -1);
+    CATCH_REQUIRE (log4cplus_remove_log_level (audit,
+            audit_name.c_str ()) == 0);
+    CATCH_REQUIRE (llm.fromString (audit_name) == NOT_SET_LOG_LEVEL);
+    CATCH_REQUIRE (llm.toString (audit + 10)
+        == LOG4CPLUS_TEXT ("TEST_NOTICE"));
+
+    // Strings handed out earlier outlive removal.
+    CATCH_REQUIRE (name == audit_name);
+
+    CATCH_REQUIRE (log4cplus_remove_log_level (audit + 10,
+            LOG4CPLUS_TEXT ("TEST_NOTICE")) == 0);
+}
+#endif
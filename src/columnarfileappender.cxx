@@ -0,0 +1,277 @@
+// Module:  Log4cplus
+// File:    columnarfileappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/columnarfileappender.h>
+#include <log4cplus/fstreams.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/internal/env.h>
+#include <log4cplus/internal/internal.h>
+#include <chrono>
+#include <filesystem>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+
+
+namespace log4cplus
+{
+
+
+namespace
+{
+
+#if defined (LOG4CPLUS_WITH_ZSTD)
+int const default_compression_level = 3;
+#else
+int const default_compression_level = 0;
+#endif
+
+} // namespace
+
+
+ColumnarFileAppender::ColumnarFileAppender (tstring const & filename_,
+    std::ios_base::openmode mode_, std::size_t blockEvents_,
+    bool createDirs_)
+    : createDirs (createDirs_)
+    , filename (filename_)
+    , fileOpenMode (mode_)
+    , blockEvents (blockEvents_)
+    , blockInterval (0)
+    , compressionLevel (default_compression_level)
+    , blockTimerRegistered (false)
+{
+    init ();
+}
+
+
+ColumnarFileAppender::ColumnarFileAppender (
+    helpers::Properties const & props)
+    : Appender (props)
+    , createDirs (false)
+    , fileOpenMode (std::ios_base::trunc)
+    , blockEvents (8192)
+    , blockInterval (0)
+    , compressionLevel (default_compression_level)
+    , blockTimerRegistered (false)
+{
+    filename = props.getProperty (LOG4CPLUS_TEXT ("File"));
+    props.getBool (createDirs, LOG4CPLUS_TEXT ("CreateDirs"));
+
+    bool app = false;
+    props.getBool (app, LOG4CPLUS_TEXT ("Append"));
+    fileOpenMode = app ? std::ios_base::app : std::ios_base::trunc;
+
+    unsigned long events = 0;
+    if (props.getULong (events, LOG4CPLUS_TEXT ("BlockEvents")))
+        blockEvents = events;
+    props.getULong (blockInterval, LOG4CPLUS_TEXT ("BlockIntervalMs"));
+    helpers::tokenize (props.getProperty (LOG4CPLUS_TEXT ("MDCColumns")),
+        LOG4CPLUS_TEXT (','), std::back_inserter (mdcKeys));
+    props.getInt (compressionLevel, LOG4CPLUS_TEXT ("CompressionLevel"));
+
+    init ();
+}
+
+
+ColumnarFileAppender::~ColumnarFileAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+ColumnarFileAppender::init ()
+{
+    if (blockEvents == 0)
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("ColumnarFileAppender: BlockEvents property")
+            LOG4CPLUS_TEXT (" value is zero. Resetting to 1."));
+        blockEvents = 1;
+    }
+
+    open ();
+    writer = std::make_unique<ColumnarLogWriter> (out, mdcKeys,
+        compressionLevel);
+    if (out.good ())
+        writer->writeHeader ();
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (blockInterval != 0)
+    {
+        internal::add_timer (this,
+            std::chrono::milliseconds (blockInterval),
+            [this]
+            {
+                thread::MutexGuard guard (access_mutex);
+                if (writer->size () != 0
+                    && helpers::now () - blockSince
+                        >= std::chrono::milliseconds (blockInterval))
+                    writeBlock ();
+            });
+        blockTimerRegistered = true;
+    }
+#endif
+}
+
+
+void
+ColumnarFileAppender::close ()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // The timer callback locks access_mutex.
+    if (blockTimerRegistered)
+    {
+        internal::remove_timer (this);
+        blockTimerRegistered = false;
+    }
+#endif
+
+    thread::MutexGuard guard (access_mutex);
+
+    writeBlock ();
+    out.close ();
+    closed = true;
+}
+
+
+unsigned
+ColumnarFileAppender::getRequiredEventFields () const
+{
+    return spi::EVENT_FIELD_THREAD
+        | (mdcKeys.empty () ? 0u : spi::EVENT_FIELD_MDC);
+}
+
+
+void
+ColumnarFileAppender::writeBlock ()
+{
+    if (! writer || writer->size () == 0)
+        return;
+
+    writer->writeBlock ();
+    out.flush ();
+    if (! out.good ())
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to write block to file: ") + filename);
+}
+
+
+void
+ColumnarFileAppender::open ()
+{
+    if (createDirs)
+        internal::make_dirs (filename);
+
+    if (fileOpenMode & std::ios_base::app)
+    {
+        // A block cut short by a crash would hide blocks appended after
+        // it.
+        try
+        {
+            if (ColumnarLogReader::isColumnarLog (filename))
+            {
+                std::uint64_t const validSize
+                    = ColumnarLogReader (filename).getValidSize ();
+                std::filesystem::path const path (
+                    LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (filename));
+                std::error_code ec;
+                if (validSize != std::filesystem::file_size (path, ec)
+                    && ! ec)
+                    std::filesystem::resize_file (path, validSize, ec);
+                if (ec)
+                    helpers::getLogLog ().error (
+                        LOG4CPLUS_TEXT ("Unable to truncate file ")
+                        + filename);
+            }
+        }
+        catch (std::runtime_error const &)
+        {
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("Appending to malformed columnar log ")
+                + filename);
+        }
+    }
+
+    out.open (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (filename).c_str (),
+        fileOpenMode | std::ios_base::out | std::ios_base::binary);
+    if (! out.good ())
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to open file: ") + filename);
+        return;
+    }
+
+    helpers::getLogLog ().debug (
+        LOG4CPLUS_TEXT ("Just opened file: ") + filename);
+}
+
+
+// This method does not need to be locked since it is called by
+// doAppend() which performs the locking
+void
+ColumnarFileAppender::append (spi::InternalLoggingEvent const & event)
+{
+    appendBatch (std::span<spi::InternalLoggingEvent const> (&event, 1));
+}
+
+
+void
+ColumnarFileAppender::appendBatch (
+    std::span<spi::InternalLoggingEvent const> events)
+{
+    if (! out.good ())
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("file is not open: ") + filename);
+        return;
+    }
+
+    for (spi::InternalLoggingEvent const & event : events)
+    {
+        if (writer->size () == 0)
+            blockSince = helpers::now ();
+
+        writer->add (event);
+        if (writer->size () >= blockEvents)
+            writeBlock ();
+    }
+
+    if (blockInterval != 0 && writer->size () != 0
+        && helpers::now () - blockSince
+            >= std::chrono::milliseconds (blockInterval))
+        writeBlock ();
+}
+
+
+} // namespace log4cplus
@@ -0,0 +1,843 @@
+// Module:  Log4cplus
+// File:    columnarlog.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/columnarlog.h>
+#include <log4cplus/fstreams.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/internal/internal.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+
+#if defined (LOG4CPLUS_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <cstdio>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace internal
+{
+
+//! Compresses columns of one writer or decompresses columns of one
+//! reader.
+struct columnar_codec
+{
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    std::unique_ptr<ZSTD_CCtx, std::size_t (*) (ZSTD_CCtx *)> cctx {
+        nullptr, &ZSTD_freeCCtx};
+    std::unique_ptr<ZSTD_DCtx, std::size_t (*) (ZSTD_DCtx *)> dctx {
+        nullptr, &ZSTD_freeDCtx};
+#endif
+
+    //! Compressed column.
+    std::string buffer;
+};
+
+} // namespace internal
+
+
+namespace
+{
+
+//! Record types.
+char const COLUMNAR_HEADER = 'H';
+char const COLUMNAR_BLOCK = 'B';
+
+char const columnar_magic[] = "log4cplus-columnar";
+std::uint64_t const columnar_version = 1;
+
+//! Column codecs.
+unsigned char const CODEC_NONE = 0;
+unsigned char const CODEC_ZSTD = 1;
+
+//! Smaller columns are stored uncompressed.
+std::size_t const min_compressed_column = 64;
+
+//! Limits sizes read from the file before anything is allocated.
+std::uint64_t const max_block_header_size = 16 * 1024 * 1024;
+std::uint64_t const max_column_size = 1024 * 1024 * 1024;
+
+
+void
+put_varint (std::string & buf, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buf.push_back (static_cast<char> ((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buf.push_back (static_cast<char> (value));
+}
+
+
+std::uint64_t
+zigzag (std::int64_t value)
+{
+    return (static_cast<std::uint64_t> (value) << 1)
+        ^ static_cast<std::uint64_t> (value >> 63);
+}
+
+
+std::int64_t
+unzigzag (std::uint64_t value)
+{
+    return static_cast<std::int64_t> (value >> 1)
+        ^ -static_cast<std::int64_t> (value & 1);
+}
+
+
+//! Appends UTF-8 <code>str</code> to <code>bytes</code> and its length
+//! to <code>lengths</code>.
+void
+put_string (std::string & lengths, std::string & bytes, tstring_view str)
+{
+    std::size_t const start = bytes.size ();
+    internal::append_utf8 (bytes, str);
+    put_varint (lengths, bytes.size () - start);
+}
+
+
+void
+append_from_utf8 (tstring & str, std::string_view bytes)
+{
+#if defined (UNICODE)
+    helpers::appendFromUtf8 (str, bytes);
+#else
+    str.append (bytes);
+#endif
+}
+
+
+[[noreturn]]
+void
+report_malformed (tchar const * what)
+{
+    helpers::getLogLog ().error (
+        tstring (LOG4CPLUS_TEXT ("Malformed columnar log: ")) + what, true);
+    // Not reached, getLogLog().error() throws.
+    throw std::runtime_error ("malformed columnar log");
+}
+
+
+//! Reads values from block header or column.
+struct Cursor
+{
+    explicit Cursor (std::string_view const & data_)
+        : data (data_)
+        , pos (0)
+    { }
+
+    unsigned char
+    byte ()
+    {
+        if (pos == data.size ())
+            report_malformed (LOG4CPLUS_TEXT ("truncated data"));
+
+        return static_cast<unsigned char> (data[pos++]);
+    }
+
+    std::uint64_t
+    varint ()
+    {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; ; shift += 7)
+        {
+            if (shift >= 64)
+                report_malformed (LOG4CPLUS_TEXT ("overlong varint"));
+
+            unsigned char const b = byte ();
+            value |= static_cast<std::uint64_t> (b & 0x7f) << shift;
+            if (! (b & 0x80))
+                return value;
+        }
+    }
+
+    std::string_view
+    bytes (std::uint64_t size)
+    {
+        if (size > data.size () - pos)
+            report_malformed (LOG4CPLUS_TEXT ("truncated string"));
+
+        std::string_view const result = data.substr (pos, size);
+        pos += size;
+        return result;
+    }
+
+    //! Reads <code>count</code> lengths followed by the strings.
+    void
+    strings (std::vector<tstring> & out, std::uint64_t count)
+    {
+        if (count > data.size () - pos)
+            report_malformed (LOG4CPLUS_TEXT ("truncated strings"));
+
+        std::vector<std::uint64_t> lengths;
+        lengths.reserve (count);
+        for (std::uint64_t i = 0; i != count; ++i)
+            lengths.push_back (varint ());
+
+        out.reserve (out.size () + count);
+        for (std::uint64_t length : lengths)
+        {
+            out.emplace_back ();
+            append_from_utf8 (out.back (), bytes (length));
+        }
+    }
+
+    //! Reads dictionary and ids of <code>events</code> values.
+    void
+    dictionary (std::vector<tstring> & out, std::size_t events)
+    {
+        std::vector<tstring> values;
+        strings (values, varint ());
+
+        out.reserve (events);
+        for (std::size_t i = 0; i != events; ++i)
+        {
+            std::uint64_t const id = varint ();
+            if (id >= values.size ())
+                report_malformed (LOG4CPLUS_TEXT ("unknown dictionary id"));
+
+            out.push_back (values[id]);
+        }
+    }
+
+    std::string_view data;
+    std::size_t pos;
+};
+
+
+//! Reads varint from <code>in</code>.
+//! \return <code>false</code> at the end of the input.
+bool
+read_varint (std::istream & in, std::uint64_t & value)
+{
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+        int const b = in.get ();
+        if (b == std::char_traits<char>::eof ())
+            return false;
+
+        value |= static_cast<std::uint64_t> (b & 0x7f) << shift;
+        if (! (b & 0x80))
+            return true;
+    }
+
+    report_malformed (LOG4CPLUS_TEXT ("overlong varint"));
+}
+
+
+helpers::Time
+from_micros (std::int64_t micros)
+{
+    return helpers::Time (std::chrono::duration_cast<helpers::Time::duration> (
+            std::chrono::microseconds (micros)));
+}
+
+
+std::int64_t
+to_micros (helpers::Time const & time)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds> (
+        time.time_since_epoch ()).count ();
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ColumnarLogWriter
+///////////////////////////////////////////////////////////////////////////////
+
+void
+ColumnarLogWriter::Dictionary::add (tstring const & value)
+{
+    auto const result = ids.try_emplace (value, ids.size ());
+    if (result.second)
+        put_string (lengths, bytes, value);
+
+    put_varint (column, result.first->second);
+}
+
+
+void
+ColumnarLogWriter::Dictionary::clear ()
+{
+    ids.clear ();
+    lengths.clear ();
+    bytes.clear ();
+    column.clear ();
+}
+
+
+ColumnarLogWriter::ColumnarLogWriter (std::ostream & out_,
+    std::vector<tstring> const & mdcKeys_, int compressionLevel)
+    : out (out_)
+    , mdcKeys (mdcKeys_)
+    , mdc (mdcKeys_.size ())
+{
+    if (compressionLevel == 0)
+        return;
+
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    auto newCodec = std::make_shared<internal::columnar_codec> ();
+    newCodec->cctx.reset (ZSTD_createCCtx ());
+    if (! newCodec->cctx
+        || ZSTD_isError (ZSTD_CCtx_setParameter (newCodec->cctx.get (),
+                ZSTD_c_compressionLevel, compressionLevel)))
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("ColumnarLogWriter- Unable to set up")
+            LOG4CPLUS_TEXT (" compression"));
+        return;
+    }
+
+    codec = std::move (newCodec);
+
+#else
+    helpers::getLogLog ().warn (
+        LOG4CPLUS_TEXT ("zstd compression is not available"));
+
+#endif
+}
+
+
+ColumnarLogWriter::~ColumnarLogWriter ()
+{ }
+
+
+void
+ColumnarLogWriter::writeHeader ()
+{
+    std::string record (1, COLUMNAR_HEADER);
+    record.append (columnar_magic, sizeof (columnar_magic) - 1);
+    put_varint (record, columnar_version);
+    out.write (record.data (), static_cast<std::streamsize> (record.size ()));
+}
+
+
+void
+ColumnarLogWriter::add (spi::InternalLoggingEvent const & event)
+{
+    timestamps.push_back (to_micros (event.getTimestamp ()));
+    levels.push_back (event.getLogLevel ());
+    loggers.add (event.getLoggerName ());
+    threads.add (event.getThread ());
+    put_string (messageLengths, messageBytes, event.getMessage ());
+    for (std::size_t i = 0; i != mdcKeys.size (); ++i)
+        mdc[i].add (event.getMDC (mdcKeys[i]));
+}
+
+
+void
+ColumnarLogWriter::writeColumn (std::string & header, std::string & data,
+    ColumnarLogColumn kind, tstring const & name, std::string const & raw)
+{
+    unsigned char codecId = CODEC_NONE;
+    std::string const * stored = &raw;
+
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    if (codec && raw.size () >= min_compressed_column)
+    {
+        std::string & buffer = codec->buffer;
+        buffer.resize (ZSTD_compressBound (raw.size ()));
+        std::size_t const size = ZSTD_compress2 (codec->cctx.get (),
+            buffer.data (), buffer.size (), raw.data (), raw.size ());
+        if (! ZSTD_isError (size) && size < raw.size ())
+        {
+            buffer.resize (size);
+            stored = &buffer;
+            codecId = CODEC_ZSTD;
+        }
+    }
+#endif
+
+    header.push_back (static_cast<char> (kind));
+    std::string nameBytes;
+    put_string (header, nameBytes, name);
+    header += nameBytes;
+    header.push_back (static_cast<char> (codecId));
+    put_varint (header, stored->size ());
+    put_varint (header, raw.size ());
+    data += *stored;
+}
+
+
+void
+ColumnarLogWriter::writeBlock ()
+{
+    std::size_t const events = timestamps.size ();
+    if (events == 0)
+        return;
+
+    auto const times = std::minmax_element (timestamps.begin (),
+        timestamps.end ());
+    auto const lls = std::minmax_element (levels.begin (), levels.end ());
+
+    std::string header;
+    put_varint (header, events);
+    put_varint (header, zigzag (*times.first));
+    put_varint (header, static_cast<std::uint64_t> (
+        *times.second - *times.first));
+    put_varint (header, zigzag (*lls.first));
+    put_varint (header, zigzag (*lls.second));
+    put_varint (header, 5 + mdcKeys.size ());
+
+    std::string data;
+    std::string raw;
+    tstring const noName;
+
+    // Deltas of consecutive events, the first from the minimum.
+    std::int64_t previous = *times.first;
+    for (std::int64_t time : timestamps)
+    {
+        put_varint (raw, zigzag (time - previous));
+        previous = time;
+    }
+    writeColumn (header, data, COLUMNAR_TIMESTAMP, noName, raw);
+
+    std::vector<LogLevel> distinct (levels);
+    std::sort (distinct.begin (), distinct.end ());
+    distinct.erase (std::unique (distinct.begin (), distinct.end ()),
+        distinct.end ());
+    raw.clear ();
+    put_varint (raw, distinct.size ());
+    for (LogLevel ll : distinct)
+        put_varint (raw, zigzag (ll));
+    for (LogLevel ll : levels)
+        put_varint (raw, static_cast<std::uint64_t> (
+            std::lower_bound (distinct.begin (), distinct.end (), ll)
+            - distinct.begin ()));
+    writeColumn (header, data, COLUMNAR_LEVEL, noName, raw);
+
+    auto const dictionary_column = [&] (Dictionary const & dict)
+    {
+        raw.clear ();
+        put_varint (raw, dict.ids.size ());
+        raw += dict.lengths;
+        raw += dict.bytes;
+        raw += dict.column;
+    };
+
+    dictionary_column (loggers);
+    writeColumn (header, data, COLUMNAR_LOGGER, noName, raw);
+    dictionary_column (threads);
+    writeColumn (header, data, COLUMNAR_THREAD, noName, raw);
+
+    raw = messageLengths;
+    raw += messageBytes;
+    writeColumn (header, data, COLUMNAR_MESSAGE, noName, raw);
+
+    for (std::size_t i = 0; i != mdcKeys.size (); ++i)
+    {
+        dictionary_column (mdc[i]);
+        writeColumn (header, data, COLUMNAR_MDC, mdcKeys[i], raw);
+    }
+
+    std::string record (1, COLUMNAR_BLOCK);
+    put_varint (record, header.size ());
+    out.write (record.data (), static_cast<std::streamsize> (record.size ()));
+    out.write (header.data (), static_cast<std::streamsize> (header.size ()));
+    out.write (data.data (), static_cast<std::streamsize> (data.size ()));
+
+    timestamps.clear ();
+    levels.clear ();
+    loggers.clear ();
+    threads.clear ();
+    for (Dictionary & dict : mdc)
+        dict.clear ();
+    messageLengths.clear ();
+    messageBytes.clear ();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ColumnarLogReader
+///////////////////////////////////////////////////////////////////////////////
+
+ColumnarLogReader::ColumnarLogReader (tstring const & name)
+    : validSize (0)
+{
+    in.open (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (name).c_str (),
+        std::ios_base::in | std::ios_base::binary);
+    if (! in)
+        throw std::runtime_error ("Unable to open file: "
+            + LOG4CPLUS_TSTRING_TO_STRING (name));
+
+    if (! isColumnarLog (name))
+        throw std::runtime_error ("Not a columnar log: "
+            + LOG4CPLUS_TSTRING_TO_STRING (name));
+
+    in.seekg (0, std::ios_base::end);
+    std::uint64_t const size = static_cast<std::uint64_t> (
+        std::streamoff (in.tellg ()));
+    in.seekg (0);
+
+    // Records are read until the end of the file or until a record
+    // which is cut short.
+    std::string header;
+    for (;;)
+    {
+        std::uint64_t const offset = static_cast<std::uint64_t> (
+            std::streamoff (in.tellg ()));
+        int const type = in.get ();
+        if (type == std::char_traits<char>::eof ())
+            break;
+
+        if (type == COLUMNAR_HEADER)
+        {
+            char magic[sizeof (columnar_magic) - 1];
+            std::uint64_t version = 0;
+            if (! in.read (magic, sizeof (magic))
+                || ! read_varint (in, version))
+                break;
+
+            if (std::memcmp (magic, columnar_magic, sizeof (magic)) != 0)
+                report_malformed (LOG4CPLUS_TEXT ("bad header"));
+            if (version > columnar_version)
+                report_malformed (LOG4CPLUS_TEXT ("unsupported version"));
+        }
+        else if (type == COLUMNAR_BLOCK)
+        {
+            std::uint64_t headerSize = 0;
+            if (! read_varint (in, headerSize))
+                break;
+            if (headerSize > max_block_header_size)
+                report_malformed (LOG4CPLUS_TEXT ("block header too big"));
+
+            header.resize (static_cast<std::size_t> (headerSize));
+            if (! in.read (header.data (),
+                    static_cast<std::streamsize> (header.size ())))
+                break;
+
+            Block block;
+            block.offset = offset;
+            Cursor cur (header);
+            block.events = static_cast<std::size_t> (cur.varint ());
+            std::int64_t const minTime = unzigzag (cur.varint ());
+            block.minTime = from_micros (minTime);
+            block.maxTime = from_micros (minTime
+                + static_cast<std::int64_t> (cur.varint ()));
+            block.minLevel = static_cast<LogLevel> (unzigzag (cur.varint ()));
+            block.maxLevel = static_cast<LogLevel> (unzigzag (cur.varint ()));
+
+            std::uint64_t position = static_cast<std::uint64_t> (
+                std::streamoff (in.tellg ()));
+            for (std::uint64_t count = cur.varint (); count != 0; --count)
+            {
+                Column column;
+                column.kind = static_cast<ColumnarLogColumn> (cur.byte ());
+                append_from_utf8 (column.name, cur.bytes (cur.varint ()));
+                column.codec = cur.byte ();
+                column.offset = position;
+                column.size = cur.varint ();
+                column.rawSize = cur.varint ();
+                if (column.size > max_column_size
+                    || column.rawSize > max_column_size)
+                    report_malformed (LOG4CPLUS_TEXT ("column too big"));
+
+                position += column.size;
+                block.columns.push_back (std::move (column));
+            }
+
+            if (position > size)
+                break;
+
+            in.seekg (static_cast<std::streamoff> (position));
+            blocks.push_back (std::move (block));
+        }
+        else
+            report_malformed (LOG4CPLUS_TEXT ("unknown record"));
+
+        validSize = static_cast<std::uint64_t> (std::streamoff (in.tellg ()));
+    }
+
+    in.clear ();
+}
+
+
+ColumnarLogReader::~ColumnarLogReader ()
+{ }
+
+
+bool
+ColumnarLogReader::isColumnarLog (tstring const & name)
+{
+    std::ifstream file (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (name).c_str (),
+        std::ios_base::in | std::ios_base::binary);
+    char start[sizeof (columnar_magic)];
+    return file.read (start, sizeof (start))
+        && start[0] == COLUMNAR_HEADER
+        && std::memcmp (start + 1, columnar_magic, sizeof (start) - 1) == 0;
+}
+
+
+std::string const &
+ColumnarLogReader::readColumn (Column const & column)
+{
+    buffer.resize (static_cast<std::size_t> (column.size));
+    in.seekg (static_cast<std::streamoff> (column.offset));
+    if (! in.read (buffer.data (), static_cast<std::streamsize> (column.size)))
+    {
+        in.clear ();
+        report_malformed (LOG4CPLUS_TEXT ("truncated column"));
+    }
+
+    if (column.codec == CODEC_NONE)
+        return buffer;
+
+    if (column.codec != CODEC_ZSTD)
+        report_malformed (LOG4CPLUS_TEXT ("unknown column codec"));
+
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    if (! codec)
+    {
+        codec = std::make_shared<internal::columnar_codec> ();
+        codec->dctx.reset (ZSTD_createDCtx ());
+    }
+
+    raw.resize (static_cast<std::size_t> (column.rawSize));
+    std::size_t const size = codec->dctx
+        ? ZSTD_decompressDCtx (codec->dctx.get (), raw.data (), raw.size (),
+            buffer.data (), buffer.size ())
+        : 0;
+    if (ZSTD_isError (size) || size != raw.size ())
+        report_malformed (LOG4CPLUS_TEXT ("column does not decompress"));
+
+    return raw;
+
+#else
+    throw std::runtime_error ("zstd compression is not available");
+
+#endif
+}
+
+
+void
+ColumnarLogReader::read (Block const & block, unsigned columns, Rows & rows)
+{
+    rows = Rows ();
+    for (Column const & column : block.columns)
+    {
+        if (! (column.kind & columns))
+            continue;
+
+        Cursor cur (readColumn (column));
+        switch (column.kind)
+        {
+        case COLUMNAR_TIMESTAMP:
+        {
+            std::int64_t time = to_micros (block.minTime);
+            rows.timestamps.reserve (block.events);
+            for (std::size_t i = 0; i != block.events; ++i)
+            {
+                time += unzigzag (cur.varint ());
+                rows.timestamps.push_back (from_micros (time));
+            }
+            break;
+        }
+
+        case COLUMNAR_LEVEL:
+        {
+            std::vector<LogLevel> values;
+            for (std::uint64_t count = cur.varint (); count != 0; --count)
+                values.push_back (static_cast<LogLevel> (
+                    unzigzag (cur.varint ())));
+
+            rows.levels.reserve (block.events);
+            for (std::size_t i = 0; i != block.events; ++i)
+            {
+                std::uint64_t const id = cur.varint ();
+                if (id >= values.size ())
+                    report_malformed (
+                        LOG4CPLUS_TEXT ("unknown dictionary id"));
+
+                rows.levels.push_back (values[id]);
+            }
+            break;
+        }
+
+        case COLUMNAR_LOGGER:
+            cur.dictionary (rows.loggers, block.events);
+            break;
+
+        case COLUMNAR_THREAD:
+            cur.dictionary (rows.threads, block.events);
+            break;
+
+        case COLUMNAR_MESSAGE:
+            cur.strings (rows.messages, block.events);
+            break;
+
+        case COLUMNAR_MDC:
+            rows.mdc.emplace_back (column.name, std::vector<tstring> ());
+            cur.dictionary (rows.mdc.back ().second, block.events);
+            break;
+
+        default:
+            // Skip unknown columns.
+            break;
+        }
+    }
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("ColumnarLog", "[columnarlog]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-columnar-test.log"));
+    std::string const name (LOG4CPLUS_TSTRING_TO_STRING (file_name));
+    helpers::Time const start = helpers::from_time_t (1700000000);
+
+    auto const make_event = [&] (int i)
+    {
+        MappedDiagnosticContextMap mdc;
+        if (i % 2 == 0)
+            mdc[LOG4CPLUS_TEXT ("user")] = LOG4CPLUS_TEXT ("alice");
+        return spi::InternalLoggingEvent (
+            i % 3 == 0 ? LOG4CPLUS_TEXT ("a.b") : LOG4CPLUS_TEXT ("c"),
+            i % 4 == 0 ? ERROR_LOG_LEVEL : INFO_LOG_LEVEL, tstring_view (),
+            mdc, LOG4CPLUS_TEXT ("message ")
+                + helpers::convertIntegerToString (i),
+            LOG4CPLUS_TEXT ("main"), tstring_view (),
+            start + std::chrono::milliseconds (i * 10), tstring_view (), -1);
+    };
+
+    auto const write = [&] (int compressionLevel)
+    {
+        std::ofstream out (name, std::ios_base::binary);
+        ColumnarLogWriter writer (out,
+            std::vector<tstring> {LOG4CPLUS_TEXT ("user")}, compressionLevel);
+        writer.writeHeader ();
+        for (int i = 0; i != 100; ++i)
+        {
+            writer.add (make_event (i));
+            if (i == 59)
+                writer.writeBlock ();
+        }
+        writer.writeBlock ();
+    };
+
+    auto const check = [&]
+    {
+        ColumnarLogReader reader (file_name);
+        auto const & blocks = reader.getBlocks ();
+        CATCH_REQUIRE (blocks.size () == 2);
+        CATCH_REQUIRE (blocks[0].events == 60);
+        CATCH_REQUIRE (blocks[1].events == 40);
+        CATCH_REQUIRE (blocks[1].minTime
+            == start + std::chrono::milliseconds (600));
+        CATCH_REQUIRE (blocks[1].maxTime
+            == start + std::chrono::milliseconds (990));
+        CATCH_REQUIRE (blocks[0].minLevel == INFO_LOG_LEVEL);
+        CATCH_REQUIRE (blocks[0].maxLevel == ERROR_LOG_LEVEL);
+
+        ColumnarLogReader::Rows rows;
+        reader.read (blocks[1], COLUMNAR_ALL, rows);
+        CATCH_REQUIRE (rows.messages.size () == 40);
+        CATCH_REQUIRE (rows.mdc.size () == 1);
+        for (std::size_t i = 0; i != 40; ++i)
+        {
+            spi::InternalLoggingEvent const ev (
+                make_event (static_cast<int> (i) + 60));
+            CATCH_REQUIRE (rows.timestamps[i] == ev.getTimestamp ());
+            CATCH_REQUIRE (rows.levels[i] == ev.getLogLevel ());
+            CATCH_REQUIRE (rows.loggers[i] == ev.getLoggerName ());
+            CATCH_REQUIRE (rows.threads[i] == ev.getThread ());
+            CATCH_REQUIRE (rows.messages[i] == ev.getMessage ());
+            CATCH_REQUIRE (rows.mdc[0].second[i]
+                == ev.getMDC (LOG4CPLUS_TEXT ("user")));
+        }
+
+        // Only the selected columns are read.
+        reader.read (blocks[0], COLUMNAR_LEVEL | COLUMNAR_LOGGER, rows);
+        CATCH_REQUIRE (rows.levels.size () == 60);
+        CATCH_REQUIRE (rows.loggers.size () == 60);
+        CATCH_REQUIRE (rows.messages.empty ());
+        CATCH_REQUIRE (rows.timestamps.empty ());
+        return reader.getValidSize ();
+    };
+
+    CATCH_SECTION ("round trip")
+    {
+        write (0);
+        std::uint64_t const size = check ();
+
+        // Block cut short is ignored.
+        {
+            std::ofstream out (name,
+                std::ios_base::binary | std::ios_base::app);
+            out.write ("B\x20\x05", 3);
+        }
+        CATCH_REQUIRE (check () == size);
+    }
+
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    CATCH_SECTION ("compressed columns")
+    {
+        write (3);
+        check ();
+
+        ColumnarLogReader reader (file_name);
+        bool compressed = false;
+        for (auto const & column : reader.getBlocks ()[0].columns)
+            compressed = compressed || column.codec != 0;
+        CATCH_REQUIRE (compressed);
+    }
+#endif
+
+    CATCH_SECTION ("other files are rejected")
+    {
+        {
+            std::ofstream out (name, std::ios_base::binary);
+            out << "plain text\n";
+        }
+        CATCH_REQUIRE (! ColumnarLogReader::isColumnarLog (file_name));
+        CATCH_REQUIRE_THROWS_AS (ColumnarLogReader (file_name),
+            std::runtime_error);
+    }
+
+    std::remove (name.c_str ());
+}
+
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+} // namespace log4cplus
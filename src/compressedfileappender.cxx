@@ -0,0 +1,723 @@
+// Module:  Log4cplus
+// File:    compressedfileappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/compressedfileappender.h>
+#include <log4cplus/streams.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/internal/internal.h>
+#include <log4cplus/internal/env.h>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iterator>
+#include <system_error>
+
+#if defined (LOG4CPLUS_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <cstdio>
+#endif
+
+
+namespace log4cplus
+{
+
+
+#if defined (LOG4CPLUS_WITH_ZSTD)
+namespace internal
+{
+
+//! Compresses frames of one CompressedRollingFileAppender.
+struct zstd_frame_compressor
+{
+    std::unique_ptr<ZSTD_CCtx, std::size_t (*) (ZSTD_CCtx *)> cctx {
+        ZSTD_createCCtx (), &ZSTD_freeCCtx};
+
+    //! Output buffer reused by all frames.
+    std::string buffer;
+};
+
+} // namespace internal
+#endif
+
+
+namespace
+{
+
+//! Magic number of the skippable frame holding the seek table.
+std::uint32_t const skippable_magic = 0x184D2A5Eu;
+
+//! Mask of magic numbers of all skippable frames.
+std::uint32_t const skippable_magic_mask = 0xFFFFFFF0u;
+
+//! Magic number at the end of the seek table.
+std::uint32_t const seekable_magic = 0x8F92EAB1u;
+
+//! Skippable frame magic number and size.
+std::size_t const skippable_header_size = 8;
+
+//! Number of frames, descriptor and seekable magic number.
+std::size_t const seek_table_footer_size = 9;
+
+//! Compressed and decompressed size of a frame.
+std::size_t const seek_table_entry_size = 8;
+
+//! Frames are limited so that their sizes fit the seek table entries.
+std::size_t const maximum_frame_size = 1024 * 1024 * 1024;
+
+
+void
+put_le32 (std::string & out, std::uint32_t value)
+{
+    for (int i = 0; i != 4; ++i)
+        out.push_back (static_cast<char> ((value >> (i * 8)) & 0xff));
+}
+
+
+#if defined (LOG4CPLUS_WITH_ZSTD)
+//! Magic number of zstd frames.
+std::uint32_t const zstd_magic = 0xFD2FB528u;
+
+
+std::uint32_t
+get_le32 (unsigned char const * in)
+{
+    return std::uint32_t (in[0])
+        | (std::uint32_t (in[1]) << 8)
+        | (std::uint32_t (in[2]) << 16)
+        | (std::uint32_t (in[3]) << 24);
+}
+#endif
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CompressedRollingFileAppender ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+CompressedRollingFileAppender::CompressedRollingFileAppender (
+    tstring const & filename_, long maxFileSize_, int maxBackupIndex_,
+    std::size_t frameSize_, bool createDirs_)
+    : RollingFileAppender (filename_, maxFileSize_, maxBackupIndex_, true,
+        createDirs_)
+    , frameSize (frameSize_)
+    , frameInterval (0)
+    , compressionLevel (3)
+    , frameTimerRegistered (false)
+{
+    init ();
+}
+
+
+CompressedRollingFileAppender::CompressedRollingFileAppender (
+    helpers::Properties const & properties)
+    : RollingFileAppender (properties)
+    , frameSize (256 * 1024)
+    , frameInterval (0)
+    , compressionLevel (3)
+    , frameTimerRegistered (false)
+{
+    tstring const tmp (
+        helpers::toUpper (
+            properties.getProperty (LOG4CPLUS_TEXT ("FrameSize"))));
+    if (! tmp.empty ())
+    {
+        std::size_t size = std::strtoul (
+            LOG4CPLUS_TSTRING_TO_STRING (tmp).c_str (), nullptr, 10);
+        tstring::size_type const len = tmp.length ();
+        if (len > 2
+            && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT ("MB")) == 0)
+            size *= (1024 * 1024); // convert to megabytes
+        else if (len > 2
+            && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT ("KB")) == 0)
+            size *= 1024; // convert to kilobytes
+        frameSize = size;
+    }
+
+    properties.getULong (frameInterval, LOG4CPLUS_TEXT ("FrameIntervalMs"));
+    properties.getInt (compressionLevel,
+        LOG4CPLUS_TEXT ("CompressionLevel"));
+
+    init ();
+}
+
+
+CompressedRollingFileAppender::~CompressedRollingFileAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+CompressedRollingFileAppender::init ()
+{
+    helpers::LogLog & loglog = helpers::getLogLog ();
+
+    if (frameSize == 0 || frameSize > maximum_frame_size)
+    {
+        tostringstream oss;
+        oss << LOG4CPLUS_TEXT ("CompressedRollingFileAppender: FrameSize")
+            LOG4CPLUS_TEXT (" property value is out of range. Resetting to ")
+            << 256 * 1024 << ".";
+        loglog.warn (oss.str ());
+        frameSize = 256 * 1024;
+    }
+
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    auto newCompressor = std::make_shared<internal::zstd_frame_compressor> ();
+    ZSTD_CCtx * const cctx = newCompressor->cctx.get ();
+    if (! cctx || ZSTD_isError (ZSTD_CCtx_setParameter (cctx,
+                ZSTD_c_compressionLevel, compressionLevel)))
+    {
+        loglog.error (
+            LOG4CPLUS_TEXT ("CompressedRollingFileAppender- Unable to set up")
+            LOG4CPLUS_TEXT (" compression; writing plain text"));
+        return;
+    }
+
+    // Other processes appending into the same file would interleave
+    // their frames with seek tables that do not know about them.
+    if (useLockFile)
+    {
+        loglog.warn (
+            LOG4CPLUS_TEXT ("CompressedRollingFileAppender: UseLockFile")
+            LOG4CPLUS_TEXT (" property is not supported"));
+        useLockFile = false;
+        lockFile.reset ();
+    }
+
+    if (useIndex)
+    {
+        loglog.warn (
+            LOG4CPLUS_TEXT ("CompressedRollingFileAppender: Index")
+            LOG4CPLUS_TEXT (" property is not supported"));
+        useIndex = false;
+        indexOut.close ();
+    }
+
+    if (compression != NO_COMPRESSION)
+    {
+        loglog.warn (
+            LOG4CPLUS_TEXT ("CompressedRollingFileAppender: Compression")
+            LOG4CPLUS_TEXT (" property is not supported"));
+        setCompression (NO_COMPRESSION);
+    }
+
+    compressor = std::move (newCompressor);
+    pending.reserve (frameSize);
+
+    // The base class has opened the file as text. Its Bloom filter is
+    // written back so that fileOpened() below picks it up again.
+    out.close ();
+    out.clear ();
+    saveBloomFilter ();
+    open (fileOpenMode);
+    fileOpened ();
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (frameInterval != 0)
+    {
+        // FileAppenderBase registers its flush timer under this.
+        internal::add_timer (&pending,
+            std::chrono::milliseconds (frameInterval),
+            [this]
+            {
+                thread::MutexGuard guard (access_mutex);
+                if (! pending.empty ()
+                    && helpers::now () - pendingSince
+                        >= std::chrono::milliseconds (frameInterval))
+                    writeFrame ();
+            });
+        frameTimerRegistered = true;
+    }
+#endif
+
+#else
+    loglog.warn (LOG4CPLUS_TEXT ("zstd compression is not available"));
+
+#endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CompressedRollingFileAppender public methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+CompressedRollingFileAppender::close ()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // The timer callback locks access_mutex.
+    if (frameTimerRegistered)
+    {
+        internal::remove_timer (&pending);
+        frameTimerRegistered = false;
+    }
+#endif
+
+    {
+        thread::MutexGuard guard (access_mutex);
+        finishFile ();
+    }
+
+    RollingFileAppender::close ();
+}
+
+
+void
+CompressedRollingFileAppender::writeFrame ()
+{
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    if (pending.empty () || ! compressor)
+        return;
+
+    if (! file.is_open ())
+    {
+        getErrorHandler ()->error (LOG4CPLUS_TEXT ("file is not open: ")
+            + filename);
+        pending.clear ();
+        return;
+    }
+
+    std::string & buffer = compressor->buffer;
+    buffer.resize (ZSTD_compressBound (pending.size ()));
+    std::size_t const size = ZSTD_compress2 (compressor->cctx.get (),
+        buffer.data (), buffer.size (), pending.data (), pending.size ());
+    if (ZSTD_isError (size))
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("CompressedRollingFileAppender- Compression")
+            LOG4CPLUS_TEXT (" failed: ")
+            + LOG4CPLUS_C_STR_TO_TSTRING (ZSTD_getErrorName (size)));
+        pending.clear ();
+        return;
+    }
+
+    // Each frame is flushed so that the file ends with complete frames
+    // whenever the process dies.
+    file.write (buffer.data (), static_cast<std::streamsize> (size));
+    file.flush ();
+    if (! file)
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to write frame to file: ") + filename);
+        file.clear ();
+    }
+    else
+        seekTable.emplace_back (static_cast<std::uint32_t> (size),
+            static_cast<std::uint32_t> (pending.size ()));
+
+    fileSize += static_cast<long> (size);
+    pending.clear ();
+#endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CompressedRollingFileAppender protected methods
+///////////////////////////////////////////////////////////////////////////////
+
+// This method does not need to be locked since it is called by
+// doAppend() which performs the locking
+void
+CompressedRollingFileAppender::append (
+    spi::InternalLoggingEvent const & event)
+{
+    if (! compressor)
+    {
+        RollingFileAppender::append (event);
+        return;
+    }
+
+    if (! shardPattern.empty ()
+        && static_cast<unsigned long> (internal::get_process_id ())
+            != shardProcess)
+    {
+        // Frames and file are inherited from the parent process. Leave
+        // them to the parent.
+        pending.clear ();
+        seekTable.clear ();
+        file.close ();
+        file.clear ();
+        if (switchShard ())
+            fileOpened ();
+    }
+
+    if (fileSize > maxFileSize)
+    {
+        finishFile ();
+        rollover (true);
+    }
+
+    if (pending.empty ())
+        pendingSince = helpers::now ();
+
+    internal::append_utf8 (pending, formatEvent (event));
+    addBloomValues (event);
+
+    if (pending.size () >= frameSize
+        || (frameInterval != 0
+            && helpers::now () - pendingSince
+                >= std::chrono::milliseconds (frameInterval)))
+        writeFrame ();
+
+    if (fileSize > maxFileSize)
+    {
+        finishFile ();
+        rollover (true);
+    }
+}
+
+
+void
+CompressedRollingFileAppender::open (std::ios_base::openmode mode)
+{
+    if (! compressor)
+    {
+        RollingFileAppender::open (mode);
+        return;
+    }
+
+    if (createDirs)
+        internal::make_dirs (filename);
+
+    file.close ();
+    file.clear ();
+    seekTable.clear ();
+
+    bool const append_ = (mode & (std::ios_base::app | std::ios_base::ate))
+        != 0;
+    if (append_)
+        resumeFile ();
+
+    file.open (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (filename).c_str (),
+        std::ios_base::out | std::ios_base::binary
+        | (append_ ? std::ios_base::app : std::ios_base::trunc));
+    if (! file)
+    {
+        getErrorHandler ()->error (LOG4CPLUS_TEXT ("Unable to open file: ")
+            + filename);
+        return;
+    }
+
+    helpers::getLogLog ().debug (LOG4CPLUS_TEXT ("Just opened file: ")
+        + filename);
+    openSyncFile ();
+}
+
+
+void
+CompressedRollingFileAppender::finishFile ()
+{
+    if (! compressor || ! file.is_open ())
+        return;
+
+    writeFrame ();
+    if (! seekTable.empty ())
+    {
+        std::string table;
+        table.reserve (skippable_header_size
+            + seekTable.size () * seek_table_entry_size
+            + seek_table_footer_size);
+        put_le32 (table, skippable_magic);
+        put_le32 (table, static_cast<std::uint32_t> (
+            seekTable.size () * seek_table_entry_size
+            + seek_table_footer_size));
+        for (auto const & entry : seekTable)
+        {
+            put_le32 (table, entry.first);
+            put_le32 (table, entry.second);
+        }
+
+        put_le32 (table, static_cast<std::uint32_t> (seekTable.size ()));
+        table.push_back (0);
+        put_le32 (table, seekable_magic);
+
+        file.write (table.data (), static_cast<std::streamsize> (table.size ()));
+        fileSize += static_cast<long> (table.size ());
+    }
+
+    file.close ();
+    if (! file)
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to write seek table to file: ")
+            + filename);
+
+    file.clear ();
+    seekTable.clear ();
+}
+
+
+void
+CompressedRollingFileAppender::resumeFile ()
+{
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    std::ifstream in (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (filename).c_str (),
+        std::ios_base::binary);
+    if (! in)
+        return;
+
+    in.seekg (0, std::ios_base::end);
+    std::uint64_t const size = static_cast<std::uint64_t> (
+        std::streamoff (in.tellg ()));
+    if (size == 0)
+        return;
+
+    // File closed properly ends with the seek table.
+    std::uint64_t keep = size;
+    bool loaded = false;
+    unsigned char footer[seek_table_footer_size];
+    if (size >= skippable_header_size + seek_table_footer_size
+        && in.seekg (static_cast<std::streamoff> (size - sizeof (footer)))
+        && in.read (reinterpret_cast<char *> (footer), sizeof (footer))
+        && get_le32 (footer + 5) == seekable_magic
+        && footer[4] == 0)
+    {
+        std::uint64_t const frames = get_le32 (footer);
+        std::uint64_t const tableSize = skippable_header_size
+            + frames * seek_table_entry_size + seek_table_footer_size;
+        std::vector<unsigned char> table (
+            static_cast<std::size_t> (tableSize - seek_table_footer_size));
+        if (tableSize <= size
+            && in.seekg (static_cast<std::streamoff> (size - tableSize))
+            && in.read (reinterpret_cast<char *> (table.data ()),
+                static_cast<std::streamsize> (table.size ()))
+            && get_le32 (table.data ()) == skippable_magic
+            && get_le32 (table.data () + 4) == tableSize - skippable_header_size)
+        {
+            std::uint64_t compressed = 0;
+            for (std::size_t i = skippable_header_size; i != table.size ();
+                i += seek_table_entry_size)
+            {
+                seekTable.emplace_back (get_le32 (&table[i]),
+                    get_le32 (&table[i + 4]));
+                compressed += seekTable.back ().first;
+            }
+
+            keep = size - tableSize;
+            loaded = compressed == keep;
+            if (! loaded)
+                seekTable.clear ();
+        }
+    }
+
+    if (! loaded)
+    {
+        // The process writing the file did not close it. Rebuild the
+        // table from the frames themselves.
+        in.clear ();
+        in.seekg (0);
+        std::string const data {std::istreambuf_iterator<char> (in),
+            std::istreambuf_iterator<char> ()};
+        std::size_t pos = 0;
+        while (pos != data.size ())
+        {
+            std::size_t const compressed = ZSTD_findFrameCompressedSize (
+                data.data () + pos, data.size () - pos);
+            if (ZSTD_isError (compressed))
+                break;
+
+            unsigned long long const decompressed = ZSTD_getFrameContentSize (
+                data.data () + pos, compressed);
+            if (decompressed == ZSTD_CONTENTSIZE_ERROR
+                || decompressed == ZSTD_CONTENTSIZE_UNKNOWN)
+                break;
+
+            seekTable.emplace_back (static_cast<std::uint32_t> (compressed),
+                static_cast<std::uint32_t> (decompressed));
+            pos += compressed;
+        }
+
+        keep = pos;
+        if (pos != data.size () && data.size () - pos >= 4)
+        {
+            std::uint32_t const magic = get_le32 (
+                reinterpret_cast<unsigned char const *> (data.data () + pos));
+            if (magic != zstd_magic
+                && (magic & skippable_magic_mask)
+                    != (skippable_magic & skippable_magic_mask))
+            {
+                // Not a frame cut short by a crash. Keep the data, even
+                // though readers of the seek table will not find it.
+                helpers::getLogLog ().error (filename
+                    + LOG4CPLUS_TEXT (" does not contain zstd frames only;")
+                    LOG4CPLUS_TEXT (" appending to it anyway"));
+                seekTable.clear ();
+                keep = size;
+            }
+        }
+    }
+
+    in.close ();
+    if (keep == size)
+        return;
+
+    std::error_code ec;
+    std::filesystem::resize_file (
+        std::filesystem::path (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (filename)),
+        keep, ec);
+    if (ec)
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("Unable to truncate seek table of file ")
+            + filename);
+        seekTable.clear ();
+    }
+#endif
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("CompressedRollingFileAppender", "[appender]")
+{
+    tstring const file_name (
+        LOG4CPLUS_TEXT ("log4cplus-compressed-test.log"));
+    std::string const name (LOG4CPLUS_TSTRING_TO_STRING (file_name));
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+        INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("x"), __FILE__, __LINE__, nullptr);
+    // "INFO - x" and EOL
+    std::string const line ("INFO - x\n");
+
+    auto const log = [&] (bool append, int events)
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("File"), file_name);
+        props.setProperty (LOG4CPLUS_TEXT ("Append"),
+            append ? LOG4CPLUS_TEXT ("true") : LOG4CPLUS_TEXT ("false"));
+        props.setProperty (LOG4CPLUS_TEXT ("FrameSize"),
+            LOG4CPLUS_TEXT ("64"));
+        CompressedRollingFileAppender appender (props);
+        for (int i = 0; i != events; ++i)
+            appender.doAppend (ev);
+    };
+
+    auto const read_file = [&]
+    {
+        std::ifstream in (name, std::ios_base::binary);
+        return std::string {std::istreambuf_iterator<char> (in),
+            std::istreambuf_iterator<char> ()};
+    };
+
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    // Decompresses frames listed in the seek table at the end of the
+    // file.
+    auto const read_frames = [&] (std::size_t & frames)
+    {
+        std::string const data = read_file ();
+        CATCH_REQUIRE (data.size () >= skippable_header_size
+            + seek_table_footer_size);
+        auto const bytes = reinterpret_cast<unsigned char const *> (
+            data.data ());
+        CATCH_REQUIRE (get_le32 (bytes + data.size () - 4) == seekable_magic);
+        frames = get_le32 (bytes + data.size () - seek_table_footer_size);
+        std::size_t const table = data.size () - seek_table_footer_size
+            - frames * seek_table_entry_size;
+        CATCH_REQUIRE (get_le32 (bytes + table - skippable_header_size)
+            == skippable_magic);
+
+        std::unique_ptr<ZSTD_DCtx, std::size_t (*) (ZSTD_DCtx *)> dctx {
+            ZSTD_createDCtx (), &ZSTD_freeDCtx};
+        std::string text;
+        std::size_t pos = 0;
+        for (std::size_t i = 0; i != frames; ++i)
+        {
+            std::uint32_t const compressed = get_le32 (
+                bytes + table + i * seek_table_entry_size);
+            std::uint32_t const decompressed = get_le32 (
+                bytes + table + i * seek_table_entry_size + 4);
+            std::string frame (decompressed, '\0');
+            CATCH_REQUIRE (ZSTD_decompressDCtx (dctx.get (), frame.data (),
+                    frame.size (), data.data () + pos, compressed)
+                == decompressed);
+            text += frame;
+            pos += compressed;
+        }
+
+        CATCH_REQUIRE (pos == table - skippable_header_size);
+        return text;
+    };
+
+    std::size_t frames = 0;
+
+    CATCH_SECTION ("frames are listed in seek table")
+    {
+        log (false, 10);
+        std::string expected;
+        for (int i = 0; i != 10; ++i)
+            expected += line;
+        CATCH_REQUIRE (read_frames (frames) == expected);
+        CATCH_REQUIRE (frames == 2);
+
+        log (true, 1);
+        CATCH_REQUIRE (read_frames (frames) == expected + line);
+        CATCH_REQUIRE (frames == 3);
+    }
+
+    CATCH_SECTION ("file without seek table is resumed")
+    {
+        log (false, 10);
+        std::string const data = read_file ();
+        std::size_t const table = skippable_header_size
+            + 2 * seek_table_entry_size + seek_table_footer_size;
+
+        // Cut the seek table and the end of the last frame.
+        std::filesystem::resize_file (name, data.size () - table - 3);
+        log (true, 1);
+
+        std::string expected;
+        for (int i = 0; i != 9; ++i)
+            expected += line;
+        CATCH_REQUIRE (read_frames (frames) == expected);
+        CATCH_REQUIRE (frames == 2);
+    }
+
+#else
+    CATCH_SECTION ("plain text is written without zstd")
+    {
+        log (false, 2);
+        CATCH_REQUIRE (read_file () == line + line);
+    }
+
+#endif
+
+    std::remove (name.c_str ());
+}
+#endif
+
+
+} // namespace log4cplus
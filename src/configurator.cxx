@@ -19,6 +19,7 @@
 // limitations under the License.
 
 #include <log4cplus/configurator.h>
+#include <log4cplus/fstreams.h>
 #include <log4cplus/hierarchylocker.h>
 #include <log4cplus/hierarchy.h>
 #include <log4cplus/helpers/loglog.h>
@@ -30,6 +31,7 @@
 #include <log4cplus/thread/syncprims-pub-impl.h>
 #include <log4cplus/spi/factory.h>
 #include <log4cplus/spi/loggerimpl.h>
+#include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/internal/env.h>
 
 #ifdef LOG4CPLUS_HAVE_SYS_TYPES_H
@@ -46,11 +48,37 @@
 #include <tchar.h>
 #endif
 
+#if defined (LOG4CPLUS_HAVE_SYS_INOTIFY_H) && defined (LOG4CPLUS_HAVE_POLL) \
+    && defined (LOG4CPLUS_HAVE_PIPE2) && ! defined (LOG4CPLUS_SINGLE_THREADED)
+#define LOG4CPLUS_WATCHDOG_USE_INOTIFY
+#include <sys/inotify.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <sstream>
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <atomic>
+#include <thread>
+#endif
+
 
 namespace log4cplus
 {
@@ -58,6 +86,13 @@ namespace log4cplus
 
 void initializeLog4cplus();
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+// from global-init.cxx
+void enqueueAsyncTask (std::function<void ()> task);
+
+#endif
+
 
 namespace
 {
@@ -102,6 +137,530 @@ namespace
         return pflags;
     }
 
+
+    //! Sets thread::BackgroundThreadSettings from
+    //! <code>backgroundThreads.*</code> properties, if there are any.
+    static
+    void
+    configure_background_threads (helpers::Properties const & properties)
+    {
+        helpers::Properties const props = properties.getPropertySubset (
+            LOG4CPLUS_TEXT ("backgroundThreads."));
+        if (props.size () == 0)
+            return;
+
+        helpers::LogLog & loglog = helpers::getLogLog ();
+        thread::BackgroundThreadSettings settings;
+
+        // List of CPUs and CPU ranges, e.g., 0-3,8.
+        std::vector<tstring> cpus;
+        helpers::tokenize (props.getProperty (LOG4CPLUS_TEXT ("cpus")),
+            LOG4CPLUS_TEXT (','), std::back_inserter (cpus));
+        for (tstring const & range : cpus)
+        {
+            tstring::size_type const dash = range.find (LOG4CPLUS_TEXT ('-'));
+            unsigned long first, last;
+            try
+            {
+                first = std::stoul (range.substr (0, dash));
+                last = dash == tstring::npos
+                    ? first : std::stoul (range.substr (dash + 1));
+            }
+            catch (std::exception const &)
+            {
+                loglog.error (
+                    LOG4CPLUS_TEXT ("Invalid log4cplus.backgroundThreads.cpus: ")
+                    + range);
+                continue;
+            }
+
+            for (; first <= (std::min) (last, 1023UL); ++first)
+                settings.cpus.push_back (static_cast<unsigned>(first));
+        }
+
+        tstring const & policy = props.getProperty (
+            LOG4CPLUS_TEXT ("policy"));
+        if (policy == LOG4CPLUS_TEXT ("Other"))
+            settings.policy = thread::BackgroundThreadSettings::POLICY_OTHER;
+        else if (policy == LOG4CPLUS_TEXT ("Batch"))
+            settings.policy = thread::BackgroundThreadSettings::POLICY_BATCH;
+        else if (policy == LOG4CPLUS_TEXT ("Idle"))
+            settings.policy = thread::BackgroundThreadSettings::POLICY_IDLE;
+        else if (policy == LOG4CPLUS_TEXT ("Fifo"))
+            settings.policy = thread::BackgroundThreadSettings::POLICY_FIFO;
+        else if (policy == LOG4CPLUS_TEXT ("RR"))
+            settings.policy = thread::BackgroundThreadSettings::POLICY_RR;
+        else if (! policy.empty ())
+            loglog.error (
+                LOG4CPLUS_TEXT ("Unknown log4cplus.backgroundThreads.policy: ")
+                + policy);
+
+        props.getInt (settings.priority, LOG4CPLUS_TEXT ("priority"));
+        settings.namePrefix = props.getProperty (
+            LOG4CPLUS_TEXT ("namePrefix"));
+
+        thread::setBackgroundThreadSettings (settings);
+    }
+
+
+    //! Calls <code>work</code> for indices from 0 to
+    //! <code>count</code> - 1. With <code>parallel</code> set, the calls
+    //! are spread over the internal thread pool and the calling thread,
+    //! which takes any work the pool has not started yet. Returns after
+    //! all calls have finished.
+    static
+    void
+    run_concurrently (std::size_t count, bool parallel,
+        std::function<void (std::size_t)> const & work)
+    {
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+        struct shared_work
+        {
+            //! Claims and runs the next call.
+            //! \return False if there is none left.
+            bool
+            run_one ()
+            {
+                std::size_t i;
+                {
+                    std::lock_guard<std::mutex> guard (mtx);
+                    if (next == count)
+                        return false;
+
+                    i = next++;
+                }
+
+                (*work) (i);
+
+                std::lock_guard<std::mutex> guard (mtx);
+                if (++done == count)
+                    cv.notify_all ();
+                return true;
+            }
+
+            std::mutex mtx;
+            std::condition_variable cv;
+            std::size_t next = 0;
+            std::size_t done = 0;
+            std::size_t count = 0;
+            //! Valid only while there are unclaimed calls.
+            std::function<void (std::size_t)> const * work = nullptr;
+        };
+
+        if (parallel && count > 1)
+        {
+            // Helpers starting after all work has been claimed find
+            // nothing to do; the state outlives this function for them.
+            auto const state = std::make_shared<shared_work> ();
+            state->count = count;
+            state->work = &work;
+            try
+            {
+                for (std::size_t i = 1; i != count; ++i)
+                    enqueueAsyncTask ([state] { while (state->run_one ()); });
+            }
+            catch (std::exception const &)
+            {
+                // The thread pool is not usable; the calls run here.
+            }
+
+            while (state->run_one ())
+                ;
+
+            std::unique_lock<std::mutex> lock (state->mtx);
+            state->cv.wait (lock, [&] { return state->done == count; });
+            return;
+        }
+#else
+        (void) parallel;
+#endif
+
+        for (std::size_t i = 0; i != count; ++i)
+            work (i);
+    }
+
+
+    //! Applies properties that do not configure appenders, loggers and
+    //! additivity. Returns value of <code>disableOverride</code>.
+    static
+    bool
+    configure_globals (helpers::Properties const & properties)
+    {
+        // Configure log4cplus internals.
+        bool internal_debugging = false;
+        if (properties.getBool (internal_debugging,
+                LOG4CPLUS_TEXT ("configDebug")))
+            helpers::getLogLog ().setInternalDebugging (internal_debugging);
+
+        bool quiet_mode = false;
+        if (properties.getBool (quiet_mode, LOG4CPLUS_TEXT ("quietMode")))
+            helpers::getLogLog ().setQuietMode (quiet_mode);
+
+        bool disable_override = false;
+        properties.getBool (disable_override,
+            LOG4CPLUS_TEXT ("disableOverride"));
+
+        initializeLog4cplus();
+
+        configure_background_threads (properties);
+
+        // The pool is sized by default and its threads start on
+        // demand, so it is left alone unless it is configured.
+        unsigned int thread_pool_size;
+        if (properties.getUInt (thread_pool_size,
+                LOG4CPLUS_TEXT ("threadPoolSize")))
+            setThreadPoolSize ((std::min) (thread_pool_size, 1024U));
+
+        unsigned int idle_timeout;
+        if (properties.getUInt (idle_timeout,
+                LOG4CPLUS_TEXT ("threadPoolIdleTimeout")))
+            setThreadPoolIdleTimeout (idle_timeout);
+
+        unsigned int shutdown_timeout;
+        if (properties.getUInt (shutdown_timeout,
+                LOG4CPLUS_TEXT ("shutdownTimeout")))
+            setShutdownTimeout (shutdown_timeout);
+
+        tstring const & stack_trace_level = properties.getProperty (
+            LOG4CPLUS_TEXT ("stackTraceLogLevel"));
+        if (! stack_trace_level.empty ())
+        {
+            LogLevel const ll
+                = getLogLevelManager ().fromString (stack_trace_level);
+            if (ll != NOT_SET_LOG_LEVEL)
+                spi::setStackTraceLogLevel (ll);
+            else
+                helpers::getLogLog ().error (
+                    LOG4CPLUS_TEXT ("Unknown stackTraceLogLevel: ")
+                    + stack_trace_level);
+        }
+
+        bool event_sequencing = false;
+        if (properties.getBool (event_sequencing,
+                LOG4CPLUS_TEXT ("eventSequenceNumbers")))
+            spi::setEventSequencing (event_sequencing);
+
+        unsigned int buffer_limit;
+        if (properties.getUInt (buffer_limit,
+                LOG4CPLUS_TEXT ("threadBufferCapacityLimit")))
+            setThreadBufferCapacityLimit (buffer_limit);
+
+        unsigned int loglog_rate_limit = 0;
+        unsigned int loglog_dedup_window = 0;
+        bool const loglog_limited
+            = properties.getUInt (loglog_rate_limit,
+                LOG4CPLUS_TEXT ("logLogRateLimit"))
+            | properties.getUInt (loglog_dedup_window,
+                LOG4CPLUS_TEXT ("logLogDedupWindow"));
+        if (loglog_limited)
+            helpers::getLogLog ().setRateLimit (loglog_rate_limit,
+                loglog_dedup_window);
+
+        tstring const & event_clock = properties.getProperty (
+            LOG4CPLUS_TEXT ("eventClock"));
+        if (event_clock == LOG4CPLUS_TEXT ("System"))
+            helpers::setEventClock (helpers::EventClock::System);
+        else if (event_clock == LOG4CPLUS_TEXT ("Coarse"))
+            helpers::setEventClock (helpers::EventClock::Coarse);
+        else if (event_clock == LOG4CPLUS_TEXT ("Tsc"))
+            helpers::setEventClock (helpers::EventClock::Tsc);
+        else if (! event_clock.empty ())
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("Unknown log4cplus.eventClock: ")
+                + event_clock);
+
+        return disable_override;
+    }
+
+
+    //! Splits logger configuration <code>config</code> into LogLevel
+    //! and appender names.
+    static
+    std::vector<tstring>
+    tokenize_logger_config (tstring const & config)
+    {
+        // Remove all spaces from config
+        tstring configString;
+        std::remove_copy_if(config.begin(), config.end(),
+            std::back_inserter (configString),
+            [](tchar const ch) -> bool { return ch == LOG4CPLUS_TEXT(' '); });
+
+        // "Tokenize" configString
+        std::vector<tstring> tokens;
+        helpers::tokenize(configString, LOG4CPLUS_TEXT(','),
+            std::back_insert_iterator<std::vector<tstring> >(tokens));
+        return tokens;
+    }
+
+
+    //! Configuration snapshot layout. All numbers are in native byte
+    //! order, strings are 32 bit length in tchars followed by the
+    //! characters:
+    //!
+    //!   magic, tchar size, flags, source mtime (us), source size,
+    //!   environment variables count, (name, value)...,
+    //!   properties count, (key, value)..., FNV-1a hash of all above
+    char const SNAPSHOT_MAGIC[8]
+        = { 'L', '4', 'C', 'P', 'S', 'N', 'A', 'P' };
+
+
+    static
+    std::uint64_t
+    snapshot_hash (char const * data, std::size_t size)
+    {
+        std::uint64_t hash = 14695981039346656037ULL;
+        for (std::size_t i = 0; i != size; ++i)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+
+    class snapshot_writer
+    {
+    public:
+        template <typename T>
+        void
+        put (T value)
+        {
+            buffer.append (reinterpret_cast<char const *>(&value),
+                sizeof (value));
+        }
+
+        void
+        put (tstring const & str)
+        {
+            put (static_cast<std::uint32_t>(str.size ()));
+            buffer.append (reinterpret_cast<char const *>(str.data ()),
+                str.size () * sizeof (tchar));
+        }
+
+        std::string buffer;
+    };
+
+
+    class snapshot_reader
+    {
+    public:
+        snapshot_reader (char const * b, char const * e)
+            : pos (b)
+            , end (e)
+        { }
+
+        template <typename T>
+        bool
+        get (T & value)
+        {
+            if (static_cast<std::size_t>(end - pos) < sizeof (value))
+                return false;
+
+            std::memcpy (&value, pos, sizeof (value));
+            pos += sizeof (value);
+            return true;
+        }
+
+        bool
+        get (tstring & str)
+        {
+            std::uint32_t len;
+            if (! get (len)
+                || static_cast<std::size_t>(end - pos) / sizeof (tchar) < len)
+                return false;
+
+            str.resize (len);
+            std::memcpy (&str[0], pos, len * sizeof (tchar));
+            pos += len * sizeof (tchar);
+            return true;
+        }
+
+        char const * pos;
+        char const * end;
+    };
+
+
+    //! Adds names of all <code>${name}</code> references in
+    //! <code>str</code> to <code>names</code>. Nested references yield
+    //! some bogus names as well; that only makes the check stricter.
+    static
+    void
+    collect_var_names (std::set<tstring> & names, tstring const & str)
+    {
+        static tchar const DELIM_START[] = LOG4CPLUS_TEXT("${");
+        tstring::size_type start = str.find (DELIM_START);
+        while (start != tstring::npos)
+        {
+            tstring::size_type const stop
+                = str.find (LOG4CPLUS_TEXT('}'), start + 2);
+            if (stop == tstring::npos)
+                break;
+
+            names.insert (str.substr (start + 2, stop - start - 2));
+            start = str.find (DELIM_START, start + 2);
+        }
+    }
+
+
+    //! Returns values of environment variables that substitution of
+    //! <code>source</code> can consult, keyed by their names.
+    static
+    std::map<tstring, tstring>
+    snapshot_environment (helpers::Properties const & source)
+    {
+        std::set<tstring> names;
+        for (tstring const & key : source.propertyNames ())
+        {
+            collect_var_names (names, key);
+            collect_var_names (names, source.getProperty (key));
+        }
+
+        // Values of environment variables can reference other variables
+        // when recursive expansion is enabled.
+        std::map<tstring, tstring> env;
+        while (! names.empty ())
+        {
+            tstring name = std::move (*names.begin ());
+            names.erase (names.begin ());
+            if (env.find (name) != env.end ())
+                continue;
+
+            tstring value;
+            internal::get_env_var (value, name);
+            collect_var_names (names, value);
+            env.emplace (std::move (name), std::move (value));
+        }
+
+        return env;
+    }
+
+
+    static
+    std::int64_t
+    snapshot_mtime (helpers::FileInfo const & fi)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            fi.mtime.time_since_epoch ()).count ();
+    }
+
+
+    static
+    void
+    save_snapshot (tstring const & snapshot_file,
+        helpers::Properties const & source,
+        helpers::Properties const & resolved, helpers::FileInfo const & fi,
+        unsigned flags)
+    {
+        snapshot_writer writer;
+        writer.buffer.append (SNAPSHOT_MAGIC, sizeof (SNAPSHOT_MAGIC));
+        writer.put (static_cast<std::uint32_t>(sizeof (tchar)));
+        writer.put (static_cast<std::uint32_t>(flags));
+        writer.put (snapshot_mtime (fi));
+        writer.put (static_cast<std::int64_t>(fi.size));
+
+        std::map<tstring, tstring> const env = snapshot_environment (source);
+        writer.put (static_cast<std::uint32_t>(env.size ()));
+        for (auto const & kv : env)
+        {
+            writer.put (kv.first);
+            writer.put (kv.second);
+        }
+
+        std::vector<tstring> const keys = resolved.propertyNames ();
+        writer.put (static_cast<std::uint32_t>(keys.size ()));
+        for (tstring const & key : keys)
+        {
+            writer.put (key);
+            writer.put (resolved.getProperty (key));
+        }
+
+        writer.put (snapshot_hash (writer.buffer.data (),
+            writer.buffer.size ()));
+
+        std::ofstream out (
+            LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (snapshot_file).c_str (),
+            std::ios_base::out | std::ios_base::trunc
+            | std::ios_base::binary);
+        out.write (writer.buffer.data (),
+            static_cast<std::streamsize>(writer.buffer.size ()));
+        out.close ();
+        if (! out)
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("Failed to write configuration snapshot ")
+                + snapshot_file);
+    }
+
+
+    //! Loads resolved properties from <code>snapshot_file</code>.
+    //! Returns false if the snapshot is missing, damaged or stale.
+    static
+    bool
+    load_snapshot (helpers::Properties & resolved,
+        tstring const & snapshot_file, helpers::FileInfo const & fi,
+        unsigned flags)
+    {
+        std::ifstream in (
+            LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (snapshot_file).c_str (),
+            std::ios_base::in | std::ios_base::binary);
+        if (! in)
+            return false;
+
+        std::string const buffer {std::istreambuf_iterator<char> (in),
+            std::istreambuf_iterator<char> ()};
+        std::uint64_t hash;
+        if (buffer.size () < sizeof (SNAPSHOT_MAGIC) + sizeof (hash)
+            || buffer.compare (0, sizeof (SNAPSHOT_MAGIC), SNAPSHOT_MAGIC,
+                sizeof (SNAPSHOT_MAGIC)) != 0)
+            return false;
+
+        std::size_t const payload_size = buffer.size () - sizeof (hash);
+        std::memcpy (&hash, buffer.data () + payload_size, sizeof (hash));
+        if (hash != snapshot_hash (buffer.data (), payload_size))
+            return false;
+
+        snapshot_reader reader (buffer.data () + sizeof (SNAPSHOT_MAGIC),
+            buffer.data () + payload_size);
+        std::uint32_t tchar_size, snapshot_flags, count;
+        std::int64_t mtime, size;
+        if (! reader.get (tchar_size) || tchar_size != sizeof (tchar)
+            || ! reader.get (snapshot_flags) || snapshot_flags != flags
+            || ! reader.get (mtime) || mtime != snapshot_mtime (fi)
+            || ! reader.get (size) || size != fi.size
+            || ! reader.get (count))
+            return false;
+
+        tstring key, value, current;
+        for (; count != 0; --count)
+        {
+            if (! reader.get (key) || ! reader.get (value))
+                return false;
+
+            current.clear ();
+            internal::get_env_var (current, key);
+            if (current != value)
+                return false;
+        }
+
+        if (! reader.get (count))
+            return false;
+
+        helpers::Properties props;
+        for (; count != 0; --count)
+        {
+            if (! reader.get (key) || ! reader.get (value))
+                return false;
+
+            props.setProperty (key, value);
+        }
+
+        if (reader.pos != reader.end)
+            return false;
+
+        resolved = std::move (props);
+        return true;
+    }
+
 } // namespace
 
 
@@ -168,6 +727,39 @@ PropertyConfigurator::doConfigure(const tstring& file, Hierarchy& h,
 }
 
 
+void
+PropertyConfigurator::doConfigureFromSnapshot(const tstring& file,
+    const tstring& snapshotFile, Hierarchy& h, unsigned flags)
+{
+    // Stat the source before reading it so that a change made while
+    // reading is caught by the next run.
+    helpers::FileInfo fi;
+    if (helpers::getFileInfo (&fi, file) != 0)
+    {
+        doConfigure (file, h, flags);
+        return;
+    }
+
+    helpers::Properties resolved;
+    if (load_snapshot (resolved, snapshotFile, fi, flags))
+    {
+        helpers::getLogLog ().debug (
+            LOG4CPLUS_TEXT ("Using configuration snapshot ") + snapshotFile);
+        PropertyConfigurator tmp (helpers::Properties (), h, flags);
+        tmp.propertyFilename = file;
+        tmp.properties = std::move (resolved);
+        tmp.configure ();
+        return;
+    }
+
+    helpers::Properties const source (file, pcflag_to_pflags_encoding (flags));
+    PropertyConfigurator tmp (source, h, flags);
+    tmp.propertyFilename = file;
+    save_snapshot (snapshotFile, source, tmp.properties, fi, flags);
+    tmp.configure ();
+}
+
+
 
 //////////////////////////////////////////////////////////////////////////////
 // PropertyConfigurator public methods
@@ -176,27 +768,7 @@ PropertyConfigurator::doConfigure(const tstring& file, Hierarchy& h,
 void
 PropertyConfigurator::configure()
 {
-    // Configure log4cplus internals.
-    bool internal_debugging = false;
-    if (properties.getBool (internal_debugging, LOG4CPLUS_TEXT ("configDebug")))
-        helpers::getLogLog ().setInternalDebugging (internal_debugging);
-
-    bool quiet_mode = false;
-    if (properties.getBool (quiet_mode, LOG4CPLUS_TEXT ("quietMode")))
-        helpers::getLogLog ().setQuietMode (quiet_mode);
-
-    bool disable_override = false;
-    properties.getBool (disable_override, LOG4CPLUS_TEXT ("disableOverride"));
-
-    initializeLog4cplus();
-
-    unsigned int thread_pool_size;
-    if (properties.getUInt (thread_pool_size, LOG4CPLUS_TEXT ("threadPoolSize")))
-        thread_pool_size = (std::min) (thread_pool_size, 1024U);
-    else
-        thread_pool_size = 4;
-
-    setThreadPoolSize (thread_pool_size);
+    bool const disable_override = configure_globals (properties);
 
     configureAppenders();
     configureLoggers();
@@ -254,6 +826,13 @@ PropertyConfigurator::replaceEnvironVariables()
         keys = properties.propertyNames();
         for (auto & key : keys)
         {
+            // Most properties have nothing to substitute.
+            static tchar const DELIM_START[] = LOG4CPLUS_TEXT("${");
+            if (key.find (DELIM_START) == tstring::npos
+                && properties.getProperty(key).find (DELIM_START)
+                    == tstring::npos)
+                continue;
+
             val = properties.getProperty(key);
 
             subKey.clear ();
@@ -302,17 +881,7 @@ PropertyConfigurator::configureLoggers()
 void
 PropertyConfigurator::configureLogger(Logger logger, const tstring& config)
 {
-    // Remove all spaces from config
-    tstring configString;
-    std::remove_copy_if(config.begin(), config.end(),
-        std::back_inserter (configString),
-        [](tchar const ch) -> bool { return ch == LOG4CPLUS_TEXT(' '); });
-
-    // "Tokenize" configString
-    std::vector<tstring> tokens;
-    helpers::tokenize(configString, LOG4CPLUS_TEXT(','),
-        std::back_insert_iterator<std::vector<tstring> >(tokens));
-
+    std::vector<tstring> const tokens = tokenize_logger_config (config);
     if (tokens.empty ())
     {
         helpers::getLogLog().error(
@@ -335,11 +904,22 @@ PropertyConfigurator::configureLogger(Logger logger, const tstring& config)
     // Remove all existing appenders first so that we do not duplicate output.
     logger.removeAllAppenders ();
 
-    // Set the Appenders
+    // Set the Appenders. Names not defined by the properties refer to
+    // appenders shared with other hierarchies, if any.
+    SharedAppenderRegistryPtr const shared = h.getSharedAppenders ();
     for(std::vector<tstring>::size_type j=1; j<tokens.size(); ++j)
     {
         auto appenderIt = appenders.find(tokens[j]);
-        if (appenderIt == appenders.end())
+        if (appenderIt != appenders.end())
+        {
+            addAppender(logger, appenderIt->second);
+            continue;
+        }
+
+        SharedAppenderPtr sharedAppender;
+        if (shared)
+            sharedAppender = shared->get (tokens[j]);
+        if (! sharedAppender)
         {
             helpers::getLogLog().error(
                 LOG4CPLUS_TEXT("PropertyConfigurator::configureLogger()")
@@ -347,7 +927,7 @@ PropertyConfigurator::configureLogger(Logger logger, const tstring& config)
                 + tokens[j]);
             continue;
         }
-        addAppender(logger, appenderIt->second);
+        addAppender(logger, sharedAppender);
     }
 }
 
@@ -359,10 +939,23 @@ PropertyConfigurator::configureAppenders()
     helpers::Properties appenderProperties =
         properties.getPropertySubset(LOG4CPLUS_TEXT("appender."));
     std::vector<tstring> appendersProps = appenderProperties.propertyNames();
+
+    struct PendingAppender
+    {
+        tstring name;
+        spi::AppenderFactory * factory;
+        helpers::Properties properties;
+        SharedAppenderPtr appender;
+        tstring error;
+    };
+
+    std::vector<PendingAppender> pending;
     tstring factoryName;
     for (tstring & appenderName : appendersProps)
     {
-        if (appenderName.find (LOG4CPLUS_TEXT('.')) == tstring::npos)
+        // Appenders already in the map are kept as they are.
+        if (appenderName.find (LOG4CPLUS_TEXT('.')) == tstring::npos
+            && appenders.find (appenderName) == appenders.end ())
         {
             factoryName = appenderProperties.getProperty(appenderName);
             spi::AppenderFactory* factory
@@ -379,34 +972,59 @@ PropertyConfigurator::configureAppenders()
             helpers::Properties props_subset
                 = appenderProperties.getPropertySubset(appenderName
                 + LOG4CPLUS_TEXT("."));
+            pending.push_back (PendingAppender {std::move (appenderName),
+                factory, std::move (props_subset), SharedAppenderPtr (),
+                tstring ()});
+        }
+    } // end for loop
+
+    // Appenders are independent of each other; constructors that block,
+    // e.g., on name resolution, overlap.
+    bool parallel = true;
+    properties.getBool (parallel,
+        LOG4CPLUS_TEXT ("parallelAppenderStartup"));
+    run_concurrently (pending.size (), parallel,
+        [&pending] (std::size_t i)
+        {
+            PendingAppender & item = pending[i];
             try
             {
-                SharedAppenderPtr appender
-                    = factory->createObject(props_subset);
-                if (! appender)
-                {
-                    helpers::getLogLog().error(
-                        LOG4CPLUS_TEXT("PropertyConfigurator::")
-                        LOG4CPLUS_TEXT("configureAppenders()")
-                        LOG4CPLUS_TEXT("- Failed to create Appender: ")
-                        + appenderName);
-                }
-                else
-                {
-                    appender->setName(appenderName);
-                    appenders[std::move (appenderName)] = appender;
-                }
+                item.appender = item.factory->createObject (item.properties);
             }
-            catch(std::exception const & e)
+            catch (std::exception const & e)
             {
-                helpers::getLogLog().error(
-                    LOG4CPLUS_TEXT("PropertyConfigurator::")
-                    LOG4CPLUS_TEXT("configureAppenders()")
-                    LOG4CPLUS_TEXT("- Error while creating Appender: ")
-                    + LOG4CPLUS_C_STR_TO_TSTRING(e.what()));
+                item.error = LOG4CPLUS_C_STR_TO_TSTRING (e.what ());
             }
+            catch (...)
+            {
+                item.error = LOG4CPLUS_TEXT ("unknown exception");
+            }
+        });
+
+    for (PendingAppender & item : pending)
+    {
+        if (! item.error.empty ())
+        {
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("PropertyConfigurator::")
+                LOG4CPLUS_TEXT("configureAppenders()")
+                LOG4CPLUS_TEXT("- Error while creating Appender: ")
+                + item.error);
         }
-    } // end for loop
+        else if (! item.appender)
+        {
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("PropertyConfigurator::")
+                LOG4CPLUS_TEXT("configureAppenders()")
+                LOG4CPLUS_TEXT("- Failed to create Appender: ")
+                + item.name);
+        }
+        else
+        {
+            item.appender->setName(item.name);
+            appenders[std::move (item.name)] = std::move (item.appender);
+        }
+    }
 }
 
 
@@ -503,13 +1121,30 @@ public:
         lastFileInfo.is_link = false;
 
         updateLastModInfo();
+        initNotification();
+        setThreadRole (LOG4CPLUS_TEXT ("watchdog"));
     }
 
-    ~ConfigurationWatchDogThread () override = default;
+    ~ConfigurationWatchDogThread () override
+    {
+#if defined (LOG4CPLUS_WATCHDOG_USE_INOTIFY)
+        for (int fd : {inotifyFd, wakeupFds[0], wakeupFds[1]})
+            if (fd != -1)
+                ::close (fd);
+#endif
+    }
 
     void terminate ()
     {
         shouldTerminate.signal ();
+#if defined (LOG4CPLUS_WATCHDOG_USE_INOTIFY)
+        if (wakeupFds[1] != -1)
+        {
+            char const ch = 0;
+            // Failure is harmless, poll() times out eventually.
+            (void) ::write (wakeupFds[1], &ch, 1);
+        }
+#endif
         join ();
     }
 
@@ -521,32 +1156,138 @@ protected:
     bool checkForFileModification();
     void updateLastModInfo();
 
+    //! Waits for change notification or for waitMillis. Returns false
+    //! when the thread should terminate. Sets <code>notified</code> when
+    //! the properties file has been written or replaced.
+    bool waitForChange(bool & notified);
+
+    //! Applies changes of properties file, leaving appenders and
+    //! loggers whose properties did not change untouched.
+    void reconfigureIncrementally();
+
 private:
     ConfigurationWatchDogThread (ConfigurationWatchDogThread const &) = delete;
     ConfigurationWatchDogThread & operator = (
         ConfigurationWatchDogThread const &) = delete;
 
+    void initNotification();
+
     unsigned int const waitMillis;
     thread::ManualResetEvent shouldTerminate;
     helpers::FileInfo lastFileInfo;
     HierarchyLocker* lock;
+#if defined (LOG4CPLUS_WATCHDOG_USE_INOTIFY)
+    //! Watches directory of the properties file, so that replacing the
+    //! file by rename is noticed as well.
+    int inotifyFd = -1;
+    //! Written by terminate() to interrupt poll().
+    int wakeupFds[2] = {-1, -1};
+    std::string fileBaseName;
+#endif
 };
 
 
+void
+ConfigurationWatchDogThread::initNotification()
+{
+#if defined (LOG4CPLUS_WATCHDOG_USE_INOTIFY)
+    std::string const file = LOG4CPLUS_TSTRING_TO_STRING (propertyFilename);
+    std::string::size_type const slash = file.rfind ('/');
+    std::string const dir = slash == std::string::npos
+        ? std::string (".") : file.substr (0, (std::max) (slash,
+            std::string::size_type (1)));
+    fileBaseName = slash == std::string::npos ? file : file.substr (slash + 1);
+
+    inotifyFd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd == -1
+        || inotify_add_watch (inotifyFd, dir.c_str (),
+            IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE) == -1
+        || pipe2 (wakeupFds, O_CLOEXEC) == -1)
+    {
+        helpers::getLogLog ().debug (
+            LOG4CPLUS_TEXT ("ConfigurationWatchDogThread: inotify is not")
+            LOG4CPLUS_TEXT (" available, polling ") + propertyFilename);
+        for (int * fd : {&inotifyFd, &wakeupFds[0], &wakeupFds[1]})
+            if (*fd != -1)
+            {
+                ::close (*fd);
+                *fd = -1;
+            }
+    }
+#endif
+}
+
+
+bool
+ConfigurationWatchDogThread::waitForChange(bool & notified)
+{
+    notified = false;
+
+#if defined (LOG4CPLUS_WATCHDOG_USE_INOTIFY)
+    if (inotifyFd != -1)
+    {
+        struct pollfd fds[2] = {
+            { wakeupFds[0], POLLIN, 0 },
+            { inotifyFd, POLLIN, 0 } };
+        int const ret = poll (fds, 2, static_cast<int>(waitMillis));
+        if (ret == -1 && errno != EINTR)
+        {
+            // Fall back to polling for good instead of failing again
+            // on every wait.
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("ConfigurationWatchDogThread: poll() failed,")
+                LOG4CPLUS_TEXT (" polling ") + propertyFilename);
+            ::close (inotifyFd);
+            inotifyFd = -1;
+            return ! shouldTerminate.timed_wait (waitMillis);
+        }
+
+        if (fds[0].revents & POLLIN)
+            return false;
+
+        if (fds[1].revents & POLLIN)
+        {
+            alignas (struct inotify_event) char buf[4096];
+            ssize_t len;
+            while ((len = ::read (inotifyFd, buf, sizeof (buf))) > 0)
+            {
+                for (char const * ptr = buf; ptr < buf + len; )
+                {
+                    auto const ev
+                        = reinterpret_cast<struct inotify_event const *>(ptr);
+                    if (ev->len != 0 && fileBaseName == ev->name
+                        && (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)))
+                        notified = true;
+
+                    ptr += sizeof (struct inotify_event) + ev->len;
+                }
+            }
+        }
+
+        return true;
+    }
+#endif
+
+    return ! shouldTerminate.timed_wait (waitMillis);
+}
+
+
 void
 ConfigurationWatchDogThread::run()
 {
-    while (! shouldTerminate.timed_wait (waitMillis))
+    bool notified;
+    while (waitForChange (notified))
     {
-        bool modified = checkForFileModification();
+        // Other changes in the directory, e.g., replaced symbolic links,
+        // and timeouts are checked by file modification time and size.
+        bool modified = notified || checkForFileModification();
         if(modified) {
             // Lock the Hierarchy
             HierarchyLocker theLock(h);
             lock = &theLock;
 
             // reconfigure the Hierarchy
-            theLock.resetConfiguration();
-            reconfigure();
+            reconfigureIncrementally();
             updateLastModInfo();
 
             // release the lock
@@ -556,6 +1297,188 @@ ConfigurationWatchDogThread::run()
 }
 
 
+void
+ConfigurationWatchDogThread::reconfigureIncrementally()
+{
+    helpers::Properties const oldProperties (std::move (properties));
+    properties = helpers::Properties (propertyFilename,
+        pcflag_to_pflags_encoding (PropertyConfigurator::flags));
+    init();
+    helpers::Properties const & newProperties = properties;
+
+    h.disable (Hierarchy::DISABLE_OFF);
+    bool const disable_override = configure_globals (properties);
+
+    tstring const rootKey (LOG4CPLUS_TEXT ("rootLogger"));
+    tstring const loggerPrefix (LOG4CPLUS_TEXT ("logger."));
+    tstring const appenderPrefix (LOG4CPLUS_TEXT ("appender."));
+    tstring const additivityPrefix (LOG4CPLUS_TEXT ("additivity."));
+
+    // Keys of configured loggers, old and new, in full form.
+    std::set<tstring> loggerKeys;
+    for (helpers::Properties const * props : {&oldProperties, &newProperties})
+    {
+        if (props->exists (rootKey))
+            loggerKeys.insert (rootKey);
+        for (tstring const & name
+            : props->getPropertySubset (loggerPrefix).propertyNames ())
+            loggerKeys.insert (loggerPrefix + name);
+    }
+
+    // Appenders currently attached to configured loggers, by name.
+    AppenderMap current;
+    for (tstring const & key : loggerKeys)
+    {
+        if (! oldProperties.exists (key))
+            continue;
+
+        Logger logger = key == rootKey ? h.getRoot ()
+            : getLogger (key.substr (loggerPrefix.size ()));
+        for (SharedAppenderPtr & appender : logger.getAllAppenders ())
+            current.emplace (appender->getName (), appender);
+    }
+
+    // Appenders referred to by the new configuration of loggers.
+    std::set<tstring> referenced;
+    for (tstring const & key : loggerKeys)
+    {
+        if (! properties.exists (key))
+            continue;
+
+        std::vector<tstring> const tokens
+            = tokenize_logger_config (properties.getProperty (key));
+        if (! tokens.empty ())
+            referenced.insert (tokens.begin () + 1, tokens.end ());
+    }
+
+    // Reuse appenders whose definitions did not change and that are
+    // still referred to.
+    helpers::Properties const oldAppenderProps
+        = oldProperties.getPropertySubset (appenderPrefix);
+    helpers::Properties const newAppenderProps
+        = properties.getPropertySubset (appenderPrefix);
+    auto const same_subset = [] (helpers::Properties const & a,
+        helpers::Properties const & b)
+    {
+        if (a.size () != b.size ())
+            return false;
+
+        for (tstring const & key : a.propertyNames ())
+            if (! b.exists (key) || a.getProperty (key) != b.getProperty (key))
+                return false;
+
+        return true;
+    };
+
+    std::set<tstring> changed;
+    std::set<tstring> unused;
+    for (auto & entry : current)
+    {
+        tstring const & name = entry.first;
+        tstring const subsetPrefix = name + LOG4CPLUS_TEXT (".");
+        if (referenced.count (name) == 0)
+            unused.insert (name);
+        else if (newAppenderProps.exists (name)
+            && oldAppenderProps.getProperty (name)
+                == newAppenderProps.getProperty (name)
+            && same_subset (oldAppenderProps.getPropertySubset (subsetPrefix),
+                newAppenderProps.getPropertySubset (subsetPrefix)))
+            appenders.emplace (name, entry.second);
+        else
+            changed.insert (name);
+    }
+
+    // Loggers to configure again are those whose configuration changed
+    // or refers to a changed appender.
+    struct DirtyLogger
+    {
+        Logger logger;
+        //! New configuration, null if the logger is not configured.
+        tstring const * config;
+        bool root;
+    };
+    std::vector<DirtyLogger> dirty;
+    for (tstring const & key : loggerKeys)
+    {
+        tstring const & oldConfig = oldProperties.getProperty (key);
+        tstring const & newConfig = properties.getProperty (key);
+        bool isDirty = oldProperties.exists (key) != properties.exists (key)
+            || oldConfig != newConfig;
+        if (! isDirty)
+        {
+            std::vector<tstring> const tokens
+                = tokenize_logger_config (newConfig);
+            isDirty = std::any_of (tokens.begin () + (tokens.empty () ? 0 : 1),
+                tokens.end (), [&changed] (tstring const & name)
+                { return changed.count (name) != 0; });
+        }
+
+        if (! isDirty)
+            continue;
+
+        Logger logger = key == rootKey ? h.getRoot ()
+            : getLogger (key.substr (loggerPrefix.size ()));
+
+        // Detach changed appenders before they are closed.
+        logger.removeAllAppenders ();
+        dirty.push_back (DirtyLogger { std::move (logger),
+            properties.exists (key) ? &newConfig : nullptr, key == rootKey });
+    }
+
+    // Close changed appenders before their replacements open the same
+    // files or connections. Appenders no logger refers to anymore have
+    // been detached from their loggers, whose configuration changed, and
+    // are closed as well.
+    for (std::set<tstring> const * names : {&changed, &unused})
+        for (tstring const & name : *names)
+        {
+            SharedAppenderPtr & appender = current[name];
+            if (appender)
+            {
+                appender->close ();
+                appender = SharedAppenderPtr ();
+            }
+        }
+
+    configureAppenders();
+
+    for (DirtyLogger & entry : dirty)
+    {
+        if (entry.config)
+            configureLogger (entry.logger, *entry.config);
+        else
+            // The logger is not configured anymore.
+            entry.logger.setLogLevel (
+                entry.root ? DEBUG_LOG_LEVEL : NOT_SET_LOG_LEVEL);
+    }
+
+    // Additivity is reset to the default when it is not configured.
+    std::set<tstring> additivityNames;
+    for (helpers::Properties const * props : {&oldProperties, &newProperties})
+        for (tstring const & name
+            : props->getPropertySubset (additivityPrefix).propertyNames ())
+            additivityNames.insert (name);
+
+    for (tstring const & name : additivityNames)
+    {
+        tstring const key = additivityPrefix + name;
+        if (oldProperties.exists (key) && properties.exists (key)
+            && oldProperties.getProperty (key) == properties.getProperty (key))
+            continue;
+
+        bool additivity = true;
+        properties.getBool (additivity, key);
+        getLogger (name).setAdditivity (additivity);
+    }
+
+    if (disable_override)
+        h.disable (Hierarchy::DISABLE_OVERRIDE);
+
+    // Erase the appenders so that we are not artificially keeping them "alive".
+    appenders.clear ();
+}
+
+
 Logger
 ConfigurationWatchDogThread::getLogger(const tstring& name)
 {
@@ -645,4 +1568,255 @@ ConfigureAndWatchThread::~ConfigureAndWatchThread()
 #endif
 
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Configuration snapshot", "[configurator]")
+{
+    tstring const config_file (
+        LOG4CPLUS_TEXT ("log4cplus-snapshot-test.properties"));
+    tstring const snapshot_file (
+        LOG4CPLUS_TEXT ("log4cplus-snapshot-test.bin"));
+    auto const write_file = [] (tstring const & name, std::string const & text)
+    {
+        std::ofstream out (LOG4CPLUS_TSTRING_TO_STRING (name).c_str (),
+            std::ios_base::trunc | std::ios_base::binary);
+        out << text;
+    };
+    unsigned const flags = PropertyConfigurator::fShadowEnvironment;
+    auto const configure = [&]
+    {
+        Hierarchy h;
+        PropertyConfigurator::doConfigureFromSnapshot (config_file,
+            snapshot_file, h, flags);
+        return h.getInstance (LOG4CPLUS_TEXT ("a.b")).getLogLevel ();
+    };
+
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (snapshot_file).c_str ());
+    write_file (config_file, "level=WARN\n"
+        "log4cplus.logger.a.b=${level}\n");
+    CATCH_REQUIRE (configure () == WARN_LOG_LEVEL);
+
+    helpers::FileInfo fi;
+    CATCH_REQUIRE (helpers::getFileInfo (&fi, snapshot_file) == 0);
+    CATCH_REQUIRE (fi.size > 0);
+
+    CATCH_SECTION ("snapshot is used")
+    {
+        helpers::Properties resolved;
+        helpers::getFileInfo (&fi, config_file);
+        CATCH_REQUIRE (load_snapshot (resolved, snapshot_file, fi, flags));
+        CATCH_REQUIRE (resolved.size () == 1);
+        CATCH_REQUIRE (resolved.getProperty (LOG4CPLUS_TEXT ("logger.a.b"))
+            == LOG4CPLUS_TEXT ("WARN"));
+        CATCH_REQUIRE (! load_snapshot (resolved, snapshot_file, fi, 0));
+        CATCH_REQUIRE (configure () == WARN_LOG_LEVEL);
+    }
+
+    CATCH_SECTION ("changed source is read again")
+    {
+        write_file (config_file, "log4cplus.logger.a.b=ERROR\n");
+        CATCH_REQUIRE (configure () == ERROR_LOG_LEVEL);
+        CATCH_REQUIRE (configure () == ERROR_LOG_LEVEL);
+    }
+
+    CATCH_SECTION ("damaged snapshot is ignored")
+    {
+        write_file (snapshot_file, "L4CPSNAP garbage");
+        CATCH_REQUIRE (configure () == WARN_LOG_LEVEL);
+        helpers::Properties resolved;
+        helpers::getFileInfo (&fi, config_file);
+        CATCH_REQUIRE (load_snapshot (resolved, snapshot_file, fi, flags));
+    }
+
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (snapshot_file).c_str ());
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (config_file).c_str ());
+}
+
+
+namespace
+{
+
+//! Appender whose constructor blocks for a while, like one resolving
+//! host name of a server.
+class SlowStartAppender
+    : public Appender
+{
+public:
+    explicit SlowStartAppender (helpers::Properties const & props)
+        : Appender (props)
+    {
+        unsigned const now = ++active;
+        unsigned seen = maxActive.load ();
+        while (now > seen && ! maxActive.compare_exchange_weak (seen, now))
+            ;
+        std::this_thread::sleep_for (std::chrono::milliseconds (100));
+        --active;
+    }
+
+    virtual ~SlowStartAppender ()
+    {
+        destructorImpl ();
+    }
+
+    virtual void close ()
+    { }
+
+    static std::atomic<unsigned> active;
+    static std::atomic<unsigned> maxActive;
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const &)
+    { }
+};
+
+std::atomic<unsigned> SlowStartAppender::active {0};
+std::atomic<unsigned> SlowStartAppender::maxActive {0};
+
+} // namespace
+
+
+CATCH_TEST_CASE ("Parallel appender startup", "[configurator]")
+{
+    spi::getAppenderFactoryRegistry ().put (
+        std::unique_ptr<spi::AppenderFactory> (
+            new spi::FactoryTempl<SlowStartAppender, spi::AppenderFactory> (
+                LOG4CPLUS_TEXT ("test::SlowStartAppender"))));
+
+    helpers::Properties props;
+    tstring names;
+    for (int i = 0; i != 4; ++i)
+    {
+        tstring const name = LOG4CPLUS_TEXT ("S")
+            + helpers::convertIntegerToString (i);
+        props.setProperty (LOG4CPLUS_TEXT ("log4cplus.appender.") + name,
+            LOG4CPLUS_TEXT ("test::SlowStartAppender"));
+        names += LOG4CPLUS_TEXT (", ") + name;
+    }
+    props.setProperty (LOG4CPLUS_TEXT ("log4cplus.logger.slow"),
+        LOG4CPLUS_TEXT ("INFO") + names);
+
+    bool parallel = true;
+    CATCH_SECTION ("parallel")
+    { }
+    CATCH_SECTION ("sequential")
+    {
+        props.setProperty (
+            LOG4CPLUS_TEXT ("log4cplus.parallelAppenderStartup"),
+            LOG4CPLUS_TEXT ("false"));
+        parallel = false;
+    }
+
+    SlowStartAppender::maxActive = 0;
+    Hierarchy h;
+    PropertyConfigurator configurator (props, h);
+    configurator.configure ();
+
+    SharedAppenderPtrList const appenders
+        = h.getInstance (LOG4CPLUS_TEXT ("slow")).getAllAppenders ();
+    CATCH_REQUIRE (appenders.size () == 4);
+    for (SharedAppenderPtr const & appender : appenders)
+        CATCH_REQUIRE (appender->getName ().size () == 2);
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+    CATCH_REQUIRE ((SlowStartAppender::maxActive > 1) == parallel);
+#else
+    CATCH_REQUIRE (SlowStartAppender::maxActive == 1);
+    (void) parallel;
+#endif
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+namespace
+{
+
+//! Watchdog whose thread does nothing, the test reconfigures through it
+//! directly.
+class TestWatchDog
+    : public ConfigurationWatchDogThread
+{
+public:
+    using ConfigurationWatchDogThread::ConfigurationWatchDogThread;
+    using ConfigurationWatchDogThread::reconfigureIncrementally;
+
+protected:
+    void run () override
+    { }
+};
+
+
+//! Appender that only records being closed.
+class ClosingAppender
+    : public Appender
+{
+public:
+    explicit ClosingAppender (helpers::Properties const & props)
+        : Appender (props)
+    { }
+
+    virtual ~ClosingAppender ()
+    {
+        destructorImpl ();
+    }
+
+    virtual void close ()
+    {
+        closed = true;
+    }
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const &)
+    { }
+};
+
+} // namespace
+
+
+CATCH_TEST_CASE ("Incremental reconfiguration", "[configurator]")
+{
+    tstring const config_file (
+        LOG4CPLUS_TEXT ("log4cplus-watchdog-test.properties"));
+    auto const write_config = [&] (char const * loggerConfig)
+    {
+        std::ofstream out (LOG4CPLUS_TSTRING_TO_STRING (config_file).c_str (),
+            std::ios_base::trunc);
+        out << "log4cplus.appender.A=test::ClosingAppender\n"
+            "log4cplus.appender.B=test::ClosingAppender\n"
+            "log4cplus.logger.watchdog.test=" << loggerConfig << "\n";
+    };
+
+    spi::getAppenderFactoryRegistry ().put (
+        std::unique_ptr<spi::AppenderFactory> (
+            new spi::FactoryTempl<ClosingAppender, spi::AppenderFactory> (
+                LOG4CPLUS_TEXT ("test::ClosingAppender"))));
+
+    write_config ("INFO, A, B");
+    helpers::SharedObjectPtr<TestWatchDog> watchdog (
+        new TestWatchDog (config_file, 1000));
+    watchdog->start ();
+    watchdog->join ();
+    watchdog->configure ();
+
+    Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("watchdog.test"));
+    SharedAppenderPtr const a = logger.getAppender (LOG4CPLUS_TEXT ("A"));
+    SharedAppenderPtr const b = logger.getAppender (LOG4CPLUS_TEXT ("B"));
+    CATCH_REQUIRE (a);
+    CATCH_REQUIRE (b);
+
+    // A is still defined but no logger refers to it anymore.
+    write_config ("WARN, B");
+    watchdog->reconfigureIncrementally ();
+    CATCH_REQUIRE (logger.getLogLevel () == WARN_LOG_LEVEL);
+    CATCH_REQUIRE (! logger.getAppender (LOG4CPLUS_TEXT ("A")));
+    CATCH_REQUIRE (logger.getAppender (LOG4CPLUS_TEXT ("B")) == b);
+    CATCH_REQUIRE (a->isClosed ());
+    CATCH_REQUIRE (! b->isClosed ());
+
+    logger.removeAllAppenders ();
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (config_file).c_str ());
+}
+#endif
+#endif
+
+
 } // namespace log4cplus
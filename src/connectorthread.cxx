@@ -23,13 +23,137 @@
 
 #include <log4cplus/helpers/connectorthread.h>
 #include <log4cplus/helpers/loglog.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <random>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#endif
 
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
 
+namespace log4cplus::internal {
+
+
+//! Pause between connection attempts, possibly shared by several
+//! ConnectorThread instances.
+struct reconnect_backoff
+{
+    typedef std::chrono::steady_clock clock;
+
+    reconnect_backoff (unsigned initial, unsigned max)
+        : initial_delay (initial)
+        , max_delay ((std::max) (initial, max))
+    { }
+
+    //! \return Time left until the next attempt may be made. When it
+    //! is zero and earlier attempts failed, the attempt is reserved for
+    //! the caller and others have to wait for another pause.
+    std::chrono::milliseconds
+    claim ()
+    {
+        std::lock_guard guard (mtx);
+        clock::time_point const now = clock::now ();
+        if (now < next_attempt)
+            return std::chrono::ceil<std::chrono::milliseconds> (
+                next_attempt - now);
+
+        if (failures != 0)
+            next_attempt = now + delay ();
+
+        return std::chrono::milliseconds::zero ();
+    }
+
+    //! Records failed attempt.
+    //! \return Pause before the next attempt.
+    std::chrono::milliseconds
+    failed ()
+    {
+        std::lock_guard guard (mtx);
+        ++failures;
+        std::chrono::milliseconds const d = delay ();
+        next_attempt = clock::now () + d;
+        return d;
+    }
+
+    //! Records successful attempt.
+    void
+    succeeded ()
+    {
+        std::lock_guard guard (mtx);
+        failures = 0;
+        next_attempt = clock::time_point ();
+    }
+
+    //! Doubles initial delay for each failure except the first, up to
+    //! the maximum, and takes a random part of its second half away.
+    std::chrono::milliseconds
+    delay () const
+    {
+        unsigned const doublings = (std::min) (
+            failures == 0 ? 0u : failures - 1, 31u);
+        std::uint64_t const full = (std::min<std::uint64_t>) (max_delay,
+            std::uint64_t (initial_delay) << doublings);
+
+        thread_local std::minstd_rand rng (std::random_device {} ());
+        std::uniform_int_distribution<std::uint64_t> dist (0, full / 2);
+        return std::chrono::milliseconds (full - dist (rng));
+    }
+
+    unsigned const initial_delay;
+    unsigned const max_delay;
+
+    std::mutex mtx;
+    unsigned failures = 0;
+    clock::time_point next_attempt;
+};
+
+
+} // namespace log4cplus::internal
+
+
 namespace log4cplus::helpers {
 
 
+namespace
+{
+
+//! \return Backoff shared by all live users of <code>key</code>.
+std::shared_ptr<internal::reconnect_backoff>
+get_shared_backoff (tstring const & key, unsigned initial, unsigned max)
+{
+    static std::mutex mtx;
+    static std::map<tstring, std::weak_ptr<internal::reconnect_backoff>>
+        registry;
+
+    std::lock_guard guard (mtx);
+    std::weak_ptr<internal::reconnect_backoff> & entry = registry[key];
+    std::shared_ptr<internal::reconnect_backoff> backoff = entry.lock ();
+    if (! backoff)
+    {
+        backoff = std::make_shared<internal::reconnect_backoff> (initial,
+            max);
+        entry = backoff;
+    }
+
+    // Drop entries of servers nobody connects to anymore.
+    for (auto it = registry.begin (); it != registry.end (); )
+        if (it->second.expired ())
+            it = registry.erase (it);
+        else
+            ++it;
+
+    return backoff;
+}
+
+} // namespace
+
+
 IConnectorThreadClient::~IConnectorThreadClient () = default;
 
 //
@@ -40,7 +164,11 @@ ConnectorThread::ConnectorThread (
     IConnectorThreadClient & client)
     : ctc (client)
     , exit_flag (false)
-{ }
+    , backoff (std::make_shared<internal::reconnect_backoff> (5 * 1000,
+            5 * 1000))
+{
+    setThreadRole (LOG4CPLUS_TEXT ("connector"));
+}
 
 
 ConnectorThread::~ConnectorThread () = default;
@@ -75,7 +203,22 @@ ConnectorThread::run ()
                 continue;
         }
 
-        // The socket is not open, try to reconnect.
+        // The socket is not open, try to reconnect unless another
+        // thread sharing the backoff is due to do it first.
+
+        std::shared_ptr<internal::reconnect_backoff> current_backoff;
+        {
+            thread::MutexGuard guard (access_mutex);
+            current_backoff = backoff;
+        }
+
+        std::chrono::milliseconds const wait = current_backoff->claim ();
+        if (wait.count () != 0)
+        {
+            exit_ev.timed_wait (static_cast<unsigned long> (wait.count ()));
+            trigger_ev.signal ();
+            continue;
+        }
 
         helpers::Socket new_socket (ctc.ctcConnect ());
         if (! new_socket.isOpen ())
@@ -84,14 +227,17 @@ ConnectorThread::run ()
                 LOG4CPLUS_TEXT("ConnectorThread::run()")
                 LOG4CPLUS_TEXT("- Cannot connect to server"));
 
-            // Sleep for a short while after unsuccessful connection attempt
+            // Sleep for a while after unsuccessful connection attempt
             // so that we do not try to reconnect after each logging attempt
             // which could be many times per second.
-            std::this_thread::sleep_for (std::chrono::seconds (5));
+            exit_ev.timed_wait (
+                static_cast<unsigned long> (current_backoff->failed ().count ()));
 
             continue;
         }
 
+        current_backoff->succeeded ();
+
         // Connection was successful, move the socket into client.
 
         {
@@ -110,6 +256,7 @@ ConnectorThread::terminate ()
         thread::MutexGuard guard (access_mutex);
         exit_flag = true;
         trigger_ev.signal ();
+        exit_ev.signal ();
     }
     join ();
 }
@@ -122,6 +269,61 @@ ConnectorThread::trigger ()
 }
 
 
+void
+ConnectorThread::setReconnectBackoff (tstring const & key,
+    unsigned initialDelay, unsigned maxDelay)
+{
+    std::shared_ptr<internal::reconnect_backoff> new_backoff = key.empty ()
+        ? std::make_shared<internal::reconnect_backoff> (initialDelay,
+            maxDelay)
+        : get_shared_backoff (key, initialDelay, maxDelay);
+
+    thread::MutexGuard guard (access_mutex);
+    backoff = std::move (new_backoff);
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Reconnect backoff", "[sockets]")
+{
+    CATCH_SECTION ("delay doubles up to maximum with jitter")
+    {
+        internal::reconnect_backoff backoff (100, 1000);
+        CATCH_REQUIRE (backoff.claim ().count () == 0);
+
+        long long const expected[] = {100, 200, 400, 800, 1000, 1000};
+        for (long long full : expected)
+        {
+            long long const d = backoff.failed ().count ();
+            CATCH_REQUIRE (d <= full);
+            CATCH_REQUIRE (d >= full - full / 2);
+        }
+
+        CATCH_REQUIRE (backoff.claim ().count () > 0);
+        backoff.succeeded ();
+        CATCH_REQUIRE (backoff.claim ().count () == 0);
+        CATCH_REQUIRE (backoff.claim ().count () == 0);
+    }
+
+    CATCH_SECTION ("backoff is shared by key")
+    {
+        auto a = get_shared_backoff (LOG4CPLUS_TEXT ("host:1"), 1000, 1000);
+        auto b = get_shared_backoff (LOG4CPLUS_TEXT ("host:1"), 1, 1);
+        auto c = get_shared_backoff (LOG4CPLUS_TEXT ("host:2"), 1000, 1000);
+        CATCH_REQUIRE (a == b);
+        CATCH_REQUIRE (a != c);
+
+        // After a failure, only one of the sharing threads may retry when
+        // the pause ends.
+        a->failed ();
+        a->next_attempt = internal::reconnect_backoff::clock::now ();
+        CATCH_REQUIRE (a->claim ().count () == 0);
+        CATCH_REQUIRE (b->claim ().count () > 0);
+    }
+}
+#endif
+
+
 } // namespace log4cplus::helpers
 
 #endif // ! defined (LOG4CPLUS_SINGLE_THREADED)
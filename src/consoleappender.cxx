@@ -18,6 +18,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+#include <log4cplus/config/windowsh-inc.h>
+
 #include <log4cplus/layout.h>
 #include <log4cplus/consoleappender.h>
 #include <log4cplus/streams.h>
@@ -25,10 +32,25 @@
 #include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/helpers/property.h>
 #include <log4cplus/internal/env.h>
+#include <log4cplus/internal/internal.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <ostream>
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#if ! defined (_WIN32)
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#endif
+#endif
+
 
 namespace log4cplus
 {
@@ -57,7 +79,12 @@ ConsoleAppender::ConsoleAppender(bool logToStdErr_,
     bool immediateFlush_)
 : logToStdErr(logToStdErr_),
   immediateFlush(immediateFlush_),
-  locale(nullptr)
+  locale(nullptr),
+  directWrite(false),
+  terminal(false),
+  bufferSize(64 * 1024),
+  flushInterval(100),
+  flushTimerRegistered(false)
 {
 }
 
@@ -67,17 +94,29 @@ ConsoleAppender::ConsoleAppender(const helpers::Properties & properties)
 : Appender(properties),
   logToStdErr(false),
   immediateFlush(false),
-  locale(nullptr)
+  locale(nullptr),
+  directWrite(false),
+  terminal(false),
+  bufferSize(64 * 1024),
+  flushInterval(100),
+  flushTimerRegistered(false)
 {
     properties.getBool (logToStdErr, LOG4CPLUS_TEXT("logToStdErr"));
     properties.getBool (immediateFlush, LOG4CPLUS_TEXT("ImmediateFlush"));
+    properties.getBool (directWrite, LOG4CPLUS_TEXT("DirectWrite"));
+    properties.getULong (bufferSize, LOG4CPLUS_TEXT("BufferSize"));
+    properties.getULong (flushInterval, LOG4CPLUS_TEXT("FlushIntervalMs"));
 
     tstring localeName;
-    if (properties.getString(localeName, LOG4CPLUS_TEXT("Locale"))) {
+    if (! directWrite
+        && properties.getString(localeName, LOG4CPLUS_TEXT("Locale"))) {
         locale = std::make_unique<std::locale>(internal::get_locale_by_name(localeName));
         // we need to flash immediately if non-default locale is used
         immediateFlush = true;
     }
+
+    if (directWrite)
+        initDirectWrite ();
 }
 
 
@@ -98,6 +137,19 @@ ConsoleAppender::close()
 {
     helpers::getLogLog().debug(
         LOG4CPLUS_TEXT("Entering ConsoleAppender::close().."));
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // This has to be done before locking access_mutex; the timer thread
+    // locks it while holding its own mutex.
+    if (flushTimerRegistered)
+    {
+        internal::remove_timer (this);
+        flushTimerRegistered = false;
+    }
+#endif
+
+    thread::MutexGuard guard (access_mutex);
+    writeBuffer ();
     closed = true;
 }
 
@@ -107,9 +159,154 @@ ConsoleAppender::close()
 // ConsoleAppender protected methods
 //////////////////////////////////////////////////////////////////////////////
 
+void
+ConsoleAppender::initDirectWrite ()
+{
+#if defined (_WIN32)
+    HANDLE const handle = GetStdHandle (
+        logToStdErr ? STD_ERROR_HANDLE : STD_OUTPUT_HANDLE);
+    terminal = GetFileType (handle) == FILE_TYPE_CHAR;
+#else
+    terminal = ::isatty (logToStdErr ? STDERR_FILENO : STDOUT_FILENO) == 1;
+#endif
+
+    buffer.reserve (bufferSize);
+    lastWrite = helpers::now ();
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (! terminal && ! immediateFlush && flushInterval != 0)
+    {
+        internal::add_timer (this,
+            std::chrono::milliseconds (flushInterval),
+            [this] { timedFlush (); });
+        flushTimerRegistered = true;
+    }
+#endif
+}
+
+
+bool
+ConsoleAppender::emergencyWrite (const char * data, std::size_t size)
+    noexcept
+{
+#if defined (_WIN32)
+    HANDLE const handle = GetStdHandle (
+        logToStdErr ? STD_ERROR_HANDLE : STD_OUTPUT_HANDLE);
+    while (size != 0)
+    {
+        DWORD written = 0;
+        if (! WriteFile (handle, data, static_cast<DWORD> (size), &written,
+                nullptr) || written == 0)
+            return false;
+
+        data += written;
+        size -= written;
+    }
+
+#else
+    int const fd = logToStdErr ? STDERR_FILENO : STDOUT_FILENO;
+    while (size != 0)
+    {
+        ssize_t const ret = ::write (fd, data, size);
+        if (ret == -1 && errno == EINTR)
+            continue;
+
+        if (ret <= 0)
+            return false;
+
+        data += ret;
+        size -= static_cast<std::size_t> (ret);
+    }
+
+#endif
+
+    return true;
+}
+
+
+void
+ConsoleAppender::timedFlush ()
+{
+    thread::MutexGuard guard (access_mutex);
+    writeBuffer ();
+}
+
+
+void
+ConsoleAppender::writeBuffer ()
+{
+    if (buffer.empty ())
+        return;
+
+    char const * data = buffer.data ();
+    std::size_t left = buffer.size ();
+
+#if defined (_WIN32)
+    HANDLE const handle = GetStdHandle (
+        logToStdErr ? STD_ERROR_HANDLE : STD_OUTPUT_HANDLE);
+    while (left != 0)
+    {
+        DWORD written = 0;
+        if (! WriteFile (handle, data, static_cast<DWORD> (left), &written,
+                nullptr))
+        {
+            getErrorHandler ()->error (
+                LOG4CPLUS_TEXT ("WriteFile() failed: ")
+                + helpers::convertIntegerToString (GetLastError ()));
+            break;
+        }
+
+        data += written;
+        left -= written;
+    }
+
+#else
+    int const fd = logToStdErr ? STDERR_FILENO : STDOUT_FILENO;
+    while (left != 0)
+    {
+        ssize_t const ret = ::write (fd, data, left);
+        if (ret == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            getErrorHandler ()->error (
+                LOG4CPLUS_TEXT ("write() failed: ")
+                + helpers::convertIntegerToString (errno));
+            break;
+        }
+
+        data += ret;
+        left -= static_cast<std::size_t> (ret);
+    }
+
+#endif
+
+    buffer.clear ();
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+    lastWrite = helpers::now ();
+#endif
+}
+
+
 void
 ConsoleAppender::append(const spi::InternalLoggingEvent& event)
 {
+    if (directWrite)
+    {
+        internal::append_utf8 (buffer, formatEvent (event));
+        if (terminal || immediateFlush || buffer.size () >= bufferSize)
+            writeBuffer ();
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+        // Without timer thread the interval is checked when writing.
+        else if (flushInterval != 0
+            && helpers::now () - lastWrite
+                >= helpers::chrono::milliseconds (flushInterval))
+            writeBuffer ();
+#endif
+        return;
+    }
+
     thread::MutexGuard guard (getOutputMutex ());
 
     tostream& output = (logToStdErr ? tcerr : tcout);
@@ -129,4 +326,104 @@ ConsoleAppender::append(const spi::InternalLoggingEvent& event)
 }
 
 
+void
+ConsoleAppender::appendBatch(
+    std::span<spi::InternalLoggingEvent const> events)
+{
+    if (! directWrite)
+    {
+        Appender::appendBatch (events);
+        return;
+    }
+
+    // The whole batch goes out in as few writes as the buffer allows,
+    // also to a terminal. Events are formatted in chunks just filling
+    // the buffer, estimated from the size of records so far.
+    std::size_t record = 0;
+    for (std::size_t i = 0; i != events.size (); )
+    {
+        std::size_t const room = buffer.size () < bufferSize
+            ? bufferSize - buffer.size () : 0;
+        std::size_t const count = (std::min) (events.size () - i,
+            record != 0 ? room / record + 1 : 1);
+        std::size_t const before = buffer.size ();
+#if defined (UNICODE)
+        tstring & str = internal::get_appender_sp ().str;
+        str.clear ();
+        formatEvents (events.subspan (i, count), str);
+        internal::append_utf8 (buffer, str);
+#else
+        formatEvents (events.subspan (i, count), buffer);
+#endif
+        record = (std::max) ((buffer.size () - before) / count,
+            std::size_t (1));
+        i += count;
+        if (buffer.size () >= bufferSize)
+            writeBuffer ();
+    }
+
+    if (terminal || immediateFlush)
+        writeBuffer ();
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) && ! defined (_WIN32)
+CATCH_TEST_CASE ("ConsoleAppender direct write", "[appender]")
+{
+    char const file_name[] = "log4cplus-console-test.log";
+    auto const read_file = [&]
+    {
+        std::ifstream in (file_name, std::ios_base::binary);
+        std::ostringstream oss;
+        oss << in.rdbuf ();
+        return oss.str ();
+    };
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+        INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"), __FILE__, __LINE__,
+        nullptr);
+    std::string const line ("INFO - message\n");
+
+    // Standard error is not a terminal while it goes to the file.
+    int const file = ::open (file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    CATCH_REQUIRE (file != -1);
+    int const saved = ::dup (STDERR_FILENO);
+    ::dup2 (file, STDERR_FILENO);
+    ::close (file);
+
+    std::string contents[3];
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("logToStdErr"),
+            LOG4CPLUS_TEXT ("true"));
+        props.setProperty (LOG4CPLUS_TEXT ("DirectWrite"),
+            LOG4CPLUS_TEXT ("true"));
+        props.setProperty (LOG4CPLUS_TEXT ("BufferSize"),
+            LOG4CPLUS_TEXT ("40"));
+        props.setProperty (LOG4CPLUS_TEXT ("FlushIntervalMs"),
+            LOG4CPLUS_TEXT ("0"));
+        ConsoleAppender appender (props);
+
+        appender.doAppend (ev);
+        appender.doAppend (ev);
+        contents[0] = read_file ();
+
+        std::vector<spi::InternalLoggingEvent> const batch (2, ev);
+        appender.doAppendBatch (batch);
+        contents[1] = read_file ();
+
+        appender.close ();
+        contents[2] = read_file ();
+    }
+
+    ::dup2 (saved, STDERR_FILENO);
+    ::close (saved);
+    std::remove (file_name);
+
+    CATCH_REQUIRE (contents[0].empty ());
+    CATCH_REQUIRE (contents[1] == line + line + line);
+    CATCH_REQUIRE (contents[2] == line + line + line + line);
+}
+
+#endif
+
 } // namespace log4cplus
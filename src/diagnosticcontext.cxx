@@ -0,0 +1,290 @@
+// Module:  Log4cplus
+// File:    diagnosticcontext.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/diagnosticcontext.h>
+#include <log4cplus/internal/internal.h>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+#include <exception>
+#include <thread>
+#endif
+#endif
+
+
+namespace log4cplus
+{
+
+
+namespace
+{
+
+//! Moves context of <code>ptd</code> out and installs
+//! <code>context</code> in its place. MDC and NDC copy the shared
+//! contents before they change them, the casts do not allow changes of
+//! snapshots held by others.
+DiagnosticContextHandle
+exchange_context (internal::per_thread_data & ptd,
+    DiagnosticContextHandle const & context)
+{
+    DiagnosticContextHandle previous (std::move (ptd.mdc_map),
+        std::move (ptd.ndc_dcs));
+    ptd.mdc_map = std::const_pointer_cast<MappedDiagnosticContext> (
+        context.getMDC ());
+    ptd.ndc_dcs = std::const_pointer_cast<DiagnosticContextStack> (
+        context.getNDC ());
+    ptd.ndc_full_valid = false;
+    return previous;
+}
+
+} // namespace
+
+
+//
+// DiagnosticContextHandle
+//
+
+DiagnosticContextHandle::DiagnosticContextHandle () = default;
+
+
+DiagnosticContextHandle::DiagnosticContextHandle (
+    MappedDiagnosticContextPtr mdc_, DiagnosticContextStackPtr ndc_)
+    : mdc (std::move (mdc_))
+    , ndc (std::move (ndc_))
+{ }
+
+
+DiagnosticContextHandle
+DiagnosticContextHandle::capture ()
+{
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    return DiagnosticContextHandle (ptd->mdc_map, ptd->ndc_dcs);
+}
+
+
+DiagnosticContextHandle
+DiagnosticContextHandle::install () const
+{
+    return exchange_context (*internal::get_ptd (), *this);
+}
+
+
+MappedDiagnosticContextPtr const &
+DiagnosticContextHandle::getMDC () const
+{
+    return mdc;
+}
+
+
+DiagnosticContextStackPtr const &
+DiagnosticContextHandle::getNDC () const
+{
+    return ndc;
+}
+
+
+bool
+DiagnosticContextHandle::empty () const
+{
+    return (! mdc || mdc->map.empty ()) && (! ndc || ndc->empty ());
+}
+
+
+//
+// DiagnosticContextGuard
+//
+
+DiagnosticContextGuard::DiagnosticContextGuard (
+    DiagnosticContextHandle const & context)
+{
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    savedNDCFull.swap (ptd->ndc_full);
+    savedNDCFullValid = ptd->ndc_full_valid;
+    saved = exchange_context (*ptd, context);
+}
+
+
+DiagnosticContextGuard::~DiagnosticContextGuard ()
+{
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    exchange_context (*ptd, saved);
+    savedNDCFull.swap (ptd->ndc_full);
+    ptd->ndc_full_valid = savedNDCFullValid;
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("DiagnosticContextHandle", "[NDC][MDC]")
+{
+    MDC & mdc = getMDC ();
+    NDC & ndc = getNDC ();
+    mdc.clear ();
+    ndc.clear ();
+    mdc.put (LOG4CPLUS_TEXT ("request"), LOG4CPLUS_TEXT ("1"));
+    ndc.push (LOG4CPLUS_TEXT ("outer"));
+    ndc.push (LOG4CPLUS_TEXT ("inner"));
+
+    CATCH_SECTION ("snapshot does not follow changes")
+    {
+        DiagnosticContextHandle const handle
+            = DiagnosticContextHandle::capture ();
+        CATCH_REQUIRE (handle.getMDC () == mdc.getSnapshot ());
+        mdc.put (LOG4CPLUS_TEXT ("request"), LOG4CPLUS_TEXT ("2"));
+        ndc.pop_void ();
+        ndc.push (LOG4CPLUS_TEXT ("other"));
+
+        CATCH_REQUIRE (handle.getMDC ()->map.at (LOG4CPLUS_TEXT ("request"))
+            == LOG4CPLUS_TEXT ("1"));
+        CATCH_REQUIRE (handle.getNDC ()->size () == 2);
+        CATCH_REQUIRE (handle.getNDC ()->back ().message
+            == LOG4CPLUS_TEXT ("inner"));
+        CATCH_REQUIRE (ndc.get () == LOG4CPLUS_TEXT ("outer other"));
+    }
+
+    CATCH_SECTION ("guard installs and restores")
+    {
+        CATCH_REQUIRE (ndc.get () == LOG4CPLUS_TEXT ("outer inner"));
+        DiagnosticContextHandle const empty;
+        CATCH_REQUIRE (empty.empty ());
+        {
+            DiagnosticContextGuard guard (empty);
+            CATCH_REQUIRE (mdc.getContext ().empty ());
+            CATCH_REQUIRE (ndc.get ().empty ());
+            mdc.put (LOG4CPLUS_TEXT ("task"), LOG4CPLUS_TEXT ("x"));
+            ndc.push (LOG4CPLUS_TEXT ("task"));
+            CATCH_REQUIRE (ndc.get () == LOG4CPLUS_TEXT ("task"));
+        }
+
+        tstring value;
+        CATCH_REQUIRE (mdc.get (&value, LOG4CPLUS_TEXT ("request")));
+        CATCH_REQUIRE (value == LOG4CPLUS_TEXT ("1"));
+        CATCH_REQUIRE (! mdc.get (&value, LOG4CPLUS_TEXT ("task")));
+        CATCH_REQUIRE (ndc.get () == LOG4CPLUS_TEXT ("outer inner"));
+        CATCH_REQUIRE (empty.empty ());
+    }
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    CATCH_SECTION ("bound callable carries context to other thread")
+    {
+        tstring seenNDC;
+        tstring seenMDC;
+        auto task = bindDiagnosticContext ([&] {
+            seenNDC = getNDC ().get ();
+            getMDC ().get (&seenMDC, LOG4CPLUS_TEXT ("request"));
+            getNDC ().push (LOG4CPLUS_TEXT ("task"));
+        });
+        std::thread ([&] {
+            task ();
+            CATCH_REQUIRE (getNDC ().get ().empty ());
+        }).join ();
+
+        CATCH_REQUIRE (seenNDC == LOG4CPLUS_TEXT ("outer inner"));
+        CATCH_REQUIRE (seenMDC == LOG4CPLUS_TEXT ("1"));
+        CATCH_REQUIRE (ndc.get () == LOG4CPLUS_TEXT ("outer inner"));
+    }
+#endif
+
+    mdc.clear ();
+    ndc.clear ();
+}
+
+
+#if defined (LOG4CPLUS_HAVE_COROUTINES) && ! defined (LOG4CPLUS_SINGLE_THREADED)
+namespace
+{
+
+struct detached_task
+{
+    struct promise_type
+    {
+        detached_task get_return_object () { return {}; }
+        std::suspend_never initial_suspend () noexcept { return {}; }
+        std::suspend_never final_suspend () noexcept { return {}; }
+        void return_void () { }
+        void unhandled_exception () { std::terminate (); }
+    };
+};
+
+
+//! Resumes the awaiting coroutine in a new thread, with empty context.
+struct resume_in_new_thread
+{
+    std::thread * worker;
+
+    bool await_ready () { return false; }
+
+    void
+    await_suspend (std::coroutine_handle<> handle)
+    {
+        *worker = std::thread ([handle] {
+            DiagnosticContextGuard guard {DiagnosticContextHandle ()};
+            handle.resume ();
+        });
+    }
+
+    void await_resume () { }
+};
+
+
+detached_task
+coroutine_body (std::thread * worker, tstring * seenNDC, tstring * afterNDC)
+{
+    getNDC ().push (LOG4CPLUS_TEXT ("coroutine"));
+    co_await withDiagnosticContext (resume_in_new_thread {worker});
+    *seenNDC = getNDC ().get ();
+    getNDC ().pop_void ();
+    co_await resume_in_new_thread {worker + 1};
+    *afterNDC = getNDC ().get ();
+}
+
+} // namespace
+
+
+CATCH_TEST_CASE ("DiagnosticContextAwaiter", "[NDC]")
+{
+    getNDC ().clear ();
+    std::thread workers[2];
+    tstring seenNDC;
+    tstring afterNDC = LOG4CPLUS_TEXT ("unset");
+    coroutine_body (workers, &seenNDC, &afterNDC);
+    getNDC ().pop_void ();
+    workers[0].join ();
+    workers[1].join ();
+
+    CATCH_REQUIRE (seenNDC == LOG4CPLUS_TEXT ("coroutine"));
+    // Without the wrapper the context stays behind.
+    CATCH_REQUIRE (afterNDC.empty ());
+}
+#endif
+
+#endif
+
+
+} // namespace log4cplus
@@ -0,0 +1,1459 @@
+// Module:  Log4cplus
+// File:    directfileappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_SYS_TYPES_H)
+#include <sys/types.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_SYS_STAT_H)
+#include <sys/stat.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_FCNTL_H)
+#include <fcntl.h>
+#endif
+#if ! defined (_WIN32)
+#include <sys/uio.h>
+#endif
+#if defined (LOG4CPLUS_WITH_IO_URING)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#include <log4cplus/config/windowsh-inc.h>
+
+#include <log4cplus/directfileappender.h>
+#include <log4cplus/fstreams.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/internal/env.h>
+#include <log4cplus/internal/internal.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <new>
+#include <vector>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <cstdio>
+#include <sstream>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+#if defined (_WIN32)
+HANDLE const invalid_handle = INVALID_HANDLE_VALUE;
+
+#endif
+
+//! Alignment of buffers, offsets and sizes of direct I/O writes. It
+//! covers logical block sizes of common devices.
+std::size_t const direct_io_alignment = 4096;
+
+
+//! Reads size property <code>name</code> with optional "KB" or "MB"
+//! suffix into <code>value</code>.
+void
+get_size_property (helpers::Properties const & props, tchar const * name,
+    unsigned long & value)
+{
+    tstring const tmp (helpers::toUpper (props.getProperty (name)));
+    if (tmp.empty ())
+        return;
+
+    unsigned long size = std::strtoul (
+        LOG4CPLUS_TSTRING_TO_STRING (tmp).c_str (), nullptr, 10);
+    tstring::size_type const len = tmp.length ();
+    if (len > 2
+        && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT ("MB")) == 0)
+        size *= (1024 * 1024); // convert to megabytes
+    else if (len > 2
+        && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT ("KB")) == 0)
+        size *= 1024; // convert to kilobytes
+    value = size;
+}
+
+} // namespace
+
+
+namespace internal
+{
+
+#if defined (LOG4CPLUS_WITH_IO_URING)
+//! Writes buffers to a file through io_uring without waiting for them,
+//! see <tt>IoUring</tt> property of DirectFileAppender. The ring is
+//! driven by raw system calls; it is used only by the appender holding
+//! its lock.
+class io_uring_writer
+{
+public:
+    //! Sets up the ring for <code>fd</code>.
+    //! \return Null, with <code>error</code> set, if io_uring is not
+    //! usable.
+    static std::unique_ptr<io_uring_writer> create (int fd,
+        std::size_t bufferSize, bool sync, int & error);
+
+    ~io_uring_writer ();
+
+    //! \return Buffer records are formatted into until it is
+    //! submitted. Waits for a free buffer if all are in flight.
+    std::string & slab ();
+
+    //! Submits write of the buffer returned by slab(), if there is
+    //! any. The buffer is reused once the write completes.
+    void submit ();
+
+    //! Waits until all submitted writes have completed.
+    void wait_all ();
+
+    //! \return Error code of the first failed write since the last
+    //! call, or zero.
+    int take_error ();
+
+private:
+    //! Number of buffers, which is also the limit of writes in flight.
+    static unsigned const buffer_count = 4;
+    //! User data of linked syncs.
+    static std::uint64_t const sync_tag = ~std::uint64_t (0);
+
+    io_uring_writer () = default;
+
+    io_uring_sqe * next_sqe ();
+    void reap ();
+    bool wait_one ();
+
+    int fd = -1;
+    int ring_fd = -1;
+    bool sync = false;
+
+    void * sq_ring = MAP_FAILED;
+    std::size_t sq_ring_size = 0;
+    void * cq_ring = MAP_FAILED;
+    std::size_t cq_ring_size = 0;
+    io_uring_sqe * sqes = static_cast<io_uring_sqe *> (MAP_FAILED);
+    std::size_t sqes_size = 0;
+
+    unsigned * sq_tail = nullptr;
+    unsigned * sq_mask = nullptr;
+    unsigned * sq_array = nullptr;
+    unsigned * cq_head = nullptr;
+    unsigned * cq_tail = nullptr;
+    unsigned * cq_mask = nullptr;
+    io_uring_cqe * cqes = nullptr;
+
+    //! Arena of buffers formatted records are written from. A buffer
+    //! which has grown over its reserved size has been reallocated
+    //! and it is not registered any more.
+    std::string buffers[buffer_count];
+    char const * registered[buffer_count] = {};
+    std::size_t registered_size[buffer_count] = {};
+    //! Buffer returned by slab(), <code>buffer_count</code> if none.
+    unsigned current = buffer_count;
+    //! Returned by slab() when no buffer can be freed.
+    std::string spare;
+    //! Sizes of writes in flight, zero for free buffers.
+    std::size_t in_flight[buffer_count] = {};
+    unsigned busy = 0;
+    //! Queued entries not yet consumed by the kernel.
+    unsigned unsubmitted = 0;
+    int error = 0;
+};
+
+
+namespace
+{
+
+int
+sys_io_uring_setup (unsigned entries, io_uring_params * params)
+{
+    return static_cast<int> (::syscall (__NR_io_uring_setup, entries,
+        params));
+}
+
+
+int
+sys_io_uring_enter (int ring_fd, unsigned to_submit, unsigned min_complete,
+    unsigned flags)
+{
+    return static_cast<int> (::syscall (__NR_io_uring_enter, ring_fd,
+        to_submit, min_complete, flags, nullptr, 0));
+}
+
+
+int
+sys_io_uring_register (int ring_fd, unsigned opcode, void const * arg,
+    unsigned nr_args)
+{
+    return static_cast<int> (::syscall (__NR_io_uring_register, ring_fd,
+        opcode, arg, nr_args));
+}
+
+} // namespace
+
+
+std::unique_ptr<io_uring_writer>
+io_uring_writer::create (int fd, std::size_t bufferSize, bool sync,
+    int & error)
+{
+    std::unique_ptr<io_uring_writer> w (new io_uring_writer);
+    w->fd = fd;
+    w->sync = sync;
+
+    // Each write can be followed by linked sync.
+    io_uring_params params;
+    std::memset (&params, 0, sizeof (params));
+    w->ring_fd = sys_io_uring_setup (2 * buffer_count, &params);
+    if (w->ring_fd == -1)
+    {
+        error = errno;
+        return nullptr;
+    }
+
+    // Writes at the current file position need IORING_FEAT_RW_CUR_POS.
+    if (! (params.features & IORING_FEAT_RW_CUR_POS))
+    {
+        error = ENOTSUP;
+        return nullptr;
+    }
+
+    w->sq_ring_size = params.sq_off.array
+        + params.sq_entries * sizeof (unsigned);
+    w->cq_ring_size = params.cq_off.cqes
+        + params.cq_entries * sizeof (io_uring_cqe);
+    bool const single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap)
+        w->sq_ring_size = w->cq_ring_size
+            = (std::max) (w->sq_ring_size, w->cq_ring_size);
+
+    w->sq_ring = ::mmap (nullptr, w->sq_ring_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, w->ring_fd, IORING_OFF_SQ_RING);
+    if (w->sq_ring == MAP_FAILED)
+    {
+        error = errno;
+        return nullptr;
+    }
+
+    if (! single_mmap)
+    {
+        w->cq_ring = ::mmap (nullptr, w->cq_ring_size,
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, w->ring_fd,
+            IORING_OFF_CQ_RING);
+        if (w->cq_ring == MAP_FAILED)
+        {
+            error = errno;
+            return nullptr;
+        }
+    }
+
+    w->sqes_size = params.sq_entries * sizeof (io_uring_sqe);
+    w->sqes = static_cast<io_uring_sqe *> (::mmap (nullptr, w->sqes_size,
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, w->ring_fd,
+        IORING_OFF_SQES));
+    if (w->sqes == MAP_FAILED)
+    {
+        error = errno;
+        return nullptr;
+    }
+
+    char * const sq = static_cast<char *> (w->sq_ring);
+    char * const cq = static_cast<char *> (
+        single_mmap ? w->sq_ring : w->cq_ring);
+    w->sq_tail = reinterpret_cast<unsigned *> (sq + params.sq_off.tail);
+    w->sq_mask = reinterpret_cast<unsigned *> (sq + params.sq_off.ring_mask);
+    w->sq_array = reinterpret_cast<unsigned *> (sq + params.sq_off.array);
+    w->cq_head = reinterpret_cast<unsigned *> (cq + params.cq_off.head);
+    w->cq_tail = reinterpret_cast<unsigned *> (cq + params.cq_off.tail);
+    w->cq_mask = reinterpret_cast<unsigned *> (cq + params.cq_off.ring_mask);
+    w->cqes = reinterpret_cast<io_uring_cqe *> (cq + params.cq_off.cqes);
+
+    // Batches of DirectFileAppender::appendBatch() are written once
+    // they reach 64 KiB; leave room for the record that crosses it.
+    std::size_t const size
+        = 2 * (std::max) (std::size_t (64 * 1024), bufferSize);
+    iovec iov[buffer_count];
+    for (unsigned i = 0; i != buffer_count; ++i)
+    {
+        w->buffers[i].reserve (size);
+        iov[i].iov_base = w->buffers[i].data ();
+        iov[i].iov_len = w->buffers[i].capacity ();
+    }
+
+    // Registration fails, e.g., when it would exceed RLIMIT_MEMLOCK.
+    // Plain writes from the same buffers work then.
+    if (sys_io_uring_register (w->ring_fd, IORING_REGISTER_BUFFERS, iov,
+            buffer_count) == 0)
+        for (unsigned i = 0; i != buffer_count; ++i)
+        {
+            w->registered[i] = w->buffers[i].data ();
+            w->registered_size[i] = w->buffers[i].capacity ();
+        }
+
+    return w;
+}
+
+
+io_uring_writer::~io_uring_writer ()
+{
+    if (ring_fd != -1 && sq_tail)
+        wait_all ();
+
+    if (sqes != MAP_FAILED)
+        ::munmap (sqes, sqes_size);
+    if (cq_ring != MAP_FAILED)
+        ::munmap (cq_ring, cq_ring_size);
+    if (sq_ring != MAP_FAILED)
+        ::munmap (sq_ring, sq_ring_size);
+    if (ring_fd != -1)
+        ::close (ring_fd);
+}
+
+
+io_uring_sqe *
+io_uring_writer::next_sqe ()
+{
+    unsigned const tail = *sq_tail;
+    unsigned const index = tail & *sq_mask;
+    io_uring_sqe * const sqe = &sqes[index];
+    std::memset (sqe, 0, sizeof (*sqe));
+    sq_array[index] = index;
+    std::atomic_ref<unsigned> (*sq_tail).store (tail + 1,
+        std::memory_order_release);
+    return sqe;
+}
+
+
+std::string &
+io_uring_writer::slab ()
+{
+    if (current != buffer_count)
+        return buffers[current];
+
+    reap ();
+    while (busy == buffer_count)
+        if (! wait_one ())
+        {
+            // The ring is broken and the error is recorded. The
+            // records are dropped.
+            spare.clear ();
+            return spare;
+        }
+
+    unsigned i = 0;
+    while (in_flight[i] != 0)
+        ++i;
+
+    current = i;
+    buffers[i].clear ();
+    return buffers[i];
+}
+
+
+void
+io_uring_writer::submit ()
+{
+    if (current == buffer_count)
+        return;
+
+    unsigned const i = current;
+    current = buffer_count;
+
+    std::string & buf = buffers[i];
+    std::size_t const size = buf.size ();
+    if (size == 0)
+        return;
+
+    // Growing over the reserved size has moved the buffer out of the
+    // registered memory for good; its old pages may be reused.
+    if (buf.data () != registered[i]
+        || buf.capacity () != registered_size[i])
+        registered[i] = nullptr;
+
+    io_uring_sqe * const sqe = next_sqe ();
+    sqe->opcode = registered[i] ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<std::uint64_t> (buf.data ());
+    sqe->len = static_cast<std::uint32_t> (size);
+    // Write at the current position, or at the end with O_APPEND.
+    sqe->off = ~std::uint64_t (0);
+    sqe->buf_index = static_cast<std::uint16_t> (i);
+    sqe->user_data = i;
+    // Start only after the previous writes so that records are not
+    // reordered.
+    if (busy != 0)
+        sqe->flags |= IOSQE_IO_DRAIN;
+
+    unsigned to_submit = 1;
+    if (sync)
+    {
+        sqe->flags |= IOSQE_IO_LINK;
+        io_uring_sqe * const sync_sqe = next_sqe ();
+        sync_sqe->opcode = IORING_OP_FSYNC;
+        sync_sqe->fd = fd;
+        sync_sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        sync_sqe->user_data = sync_tag;
+        ++to_submit;
+    }
+
+    in_flight[i] = size;
+    ++busy;
+    unsubmitted += to_submit;
+
+    int ret;
+    while ((ret = sys_io_uring_enter (ring_fd, unsubmitted, 0, 0)) == -1
+        && errno == EINTR)
+    { }
+    if (ret == -1)
+    {
+        // The entries stay queued and get submitted with the next
+        // call, or by wait_one().
+        if (error == 0)
+            error = errno;
+    }
+    else
+        unsubmitted -= (std::min) (unsubmitted, unsigned (ret));
+
+}
+
+
+void
+io_uring_writer::reap ()
+{
+    std::atomic_ref<unsigned> head_ref (*cq_head);
+    unsigned head = head_ref.load (std::memory_order_relaxed);
+    unsigned const tail = std::atomic_ref<unsigned> (*cq_tail).load (
+        std::memory_order_acquire);
+    for (; head != tail; ++head)
+    {
+        io_uring_cqe const & cqe = cqes[head & *cq_mask];
+        if (cqe.user_data == sync_tag)
+        {
+            // Sync of failed write is cancelled; that is reported
+            // already.
+            if (cqe.res < 0 && cqe.res != -ECANCELED && error == 0)
+                error = -cqe.res;
+            continue;
+        }
+
+        std::size_t const i = static_cast<std::size_t> (cqe.user_data);
+        if (cqe.res < 0)
+        {
+            if (error == 0)
+                error = -cqe.res;
+        }
+        else if (static_cast<std::size_t> (cqe.res) != in_flight[i]
+            && error == 0)
+            error = EIO;
+
+        in_flight[i] = 0;
+        --busy;
+    }
+
+    head_ref.store (head, std::memory_order_release);
+}
+
+
+bool
+io_uring_writer::wait_one ()
+{
+    int ret;
+    while ((ret = sys_io_uring_enter (ring_fd, unsubmitted, 1,
+                IORING_ENTER_GETEVENTS)) == -1
+        && errno == EINTR)
+    { }
+    if (ret == -1)
+    {
+        if (error == 0)
+            error = errno;
+        return false;
+    }
+
+    unsubmitted -= (std::min) (unsubmitted, unsigned (ret));
+    reap ();
+    return true;
+}
+
+
+void
+io_uring_writer::wait_all ()
+{
+    reap ();
+    while (busy != 0 && wait_one ())
+    { }
+}
+
+
+int
+io_uring_writer::take_error ()
+{
+    int const ret = error;
+    error = 0;
+    return ret;
+}
+
+#else
+class io_uring_writer
+{ };
+
+#endif // defined (LOG4CPLUS_WITH_IO_URING)
+
+
+//! Buffer of DirectFileAppender with <tt>DirectIO</tt>, aligned for
+//! direct I/O. It is allocated once and reused for all segments of
+//! the files of the appender.
+struct direct_io_segment
+{
+    explicit direct_io_segment (std::size_t size_)
+        : data (static_cast<char *> (::operator new (size_,
+            std::align_val_t (direct_io_alignment))))
+        , size (size_)
+    { }
+
+    ~direct_io_segment ()
+    {
+        ::operator delete (data, std::align_val_t (direct_io_alignment));
+    }
+
+    direct_io_segment (direct_io_segment const &) = delete;
+    direct_io_segment & operator = (direct_io_segment const &) = delete;
+
+    char * const data;
+    std::size_t const size;
+
+    //! Count of bytes of records in <code>data</code>.
+    std::size_t used = 0;
+
+    //! Offset of <code>data</code> in the file, multiple of
+    //! <code>direct_io_alignment</code>.
+    std::uint64_t offset = 0;
+};
+
+} // namespace internal
+
+
+DirectFileAppender::DirectFileAppender (tstring const & filename_,
+    bool append_, bool atomicAppend_, bool createDirs_)
+    : filename (filename_)
+    , appendMode (append_)
+    , atomicAppend (atomicAppend_)
+    , createDirs (createDirs_)
+    , syncWrites (false)
+    , useIoUring (false)
+    , bufferSize (0)
+#if defined (_WIN32)
+    , handle (invalid_handle)
+#else
+    , fd (-1)
+#endif
+    , directIO (false)
+    , segmentSize (1024 * 1024)
+    , maxFileSize (0)
+    , maxBackupIndex (1)
+{
+    open ();
+}
+
+
+DirectFileAppender::DirectFileAppender (helpers::Properties const & props)
+    : Appender (props)
+    , appendMode (false)
+    , atomicAppend (true)
+    , createDirs (false)
+    , syncWrites (false)
+    , useIoUring (false)
+    , bufferSize (0)
+#if defined (_WIN32)
+    , handle (invalid_handle)
+#else
+    , fd (-1)
+#endif
+    , directIO (false)
+    , segmentSize (1024 * 1024)
+    , maxFileSize (0)
+    , maxBackupIndex (1)
+{
+    filename = props.getProperty (LOG4CPLUS_TEXT ("File"));
+    props.getBool (appendMode, LOG4CPLUS_TEXT ("Append"));
+    props.getBool (atomicAppend, LOG4CPLUS_TEXT ("AtomicAppend"));
+    props.getBool (createDirs, LOG4CPLUS_TEXT ("CreateDirs"));
+    props.getULong (bufferSize, LOG4CPLUS_TEXT ("BufferSize"));
+    props.getBool (syncWrites, LOG4CPLUS_TEXT ("SyncWrites"));
+    props.getBool (useIoUring, LOG4CPLUS_TEXT ("IoUring"));
+    props.getBool (directIO, LOG4CPLUS_TEXT ("DirectIO"));
+    unsigned long segment_size = static_cast<unsigned long> (segmentSize);
+    get_size_property (props, LOG4CPLUS_TEXT ("SegmentSize"), segment_size);
+    get_size_property (props, LOG4CPLUS_TEXT ("MaxFileSize"), maxFileSize);
+    props.getUInt (maxBackupIndex, LOG4CPLUS_TEXT ("MaxBackupIndex"));
+
+    segmentSize = (std::max) (std::size_t (segment_size),
+        direct_io_alignment);
+    segmentSize = (segmentSize + direct_io_alignment - 1)
+        / direct_io_alignment * direct_io_alignment;
+
+    open ();
+}
+
+
+DirectFileAppender::~DirectFileAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+DirectFileAppender::close ()
+{
+    thread::MutexGuard guard (access_mutex);
+
+    closeFile ();
+    segment.reset ();
+    closed = true;
+}
+
+
+void
+DirectFileAppender::closeFile ()
+{
+    if (! isOpen ())
+        return;
+
+    if (segment)
+        writeSegmentTail ();
+    else if (! pending.empty ())
+    {
+        record.clear ();
+        writeRecords (record);
+    }
+
+#if defined (LOG4CPLUS_WITH_IO_URING)
+    if (ring)
+    {
+        ring->submit ();
+        ring->wait_all ();
+        if (int const err = ring->take_error ())
+            getErrorHandler ()->error (
+                LOG4CPLUS_TEXT ("io_uring write failed: ")
+                + helpers::convertIntegerToString (err));
+        ring.reset ();
+    }
+#endif
+
+#if defined (_WIN32)
+    CloseHandle (handle);
+    handle = invalid_handle;
+#else
+    ::close (fd);
+    fd = -1;
+#endif
+}
+
+
+void
+DirectFileAppender::open ()
+{
+    openFile (! appendMode);
+}
+
+
+void
+DirectFileAppender::openFile (bool truncate)
+{
+    if (createDirs)
+        internal::make_dirs (filename);
+
+    if (directIO)
+    {
+        if (openDirect (truncate))
+            helpers::getLogLog ().debug (
+                LOG4CPLUS_TEXT ("Just opened file: ") + filename);
+        else
+            getErrorHandler ()->error (
+                LOG4CPLUS_TEXT ("Unable to open file: ") + filename);
+        return;
+    }
+
+#if defined (_WIN32)
+    DWORD const access = atomicAppend ? FILE_APPEND_DATA : GENERIC_WRITE;
+    DWORD const disposition = truncate ? CREATE_ALWAYS : OPEN_ALWAYS;
+    handle = CreateFile (filename.c_str (), access,
+        FILE_SHARE_DELETE | FILE_SHARE_WRITE | FILE_SHARE_READ, nullptr,
+        disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle != invalid_handle && ! truncate && ! atomicAppend)
+        SetFilePointer (handle, 0, nullptr, FILE_END);
+
+#else
+    int flags = O_WRONLY | O_CREAT
+#if defined (O_CLOEXEC)
+        | O_CLOEXEC
+#endif
+        ;
+    if (truncate)
+        flags |= O_TRUNC;
+    if (atomicAppend)
+        flags |= O_APPEND;
+
+    mode_t const mode = (S_IRWXU ^ S_IXUSR)
+        | (S_IRWXG ^ S_IXGRP)
+        | (S_IRWXO ^ S_IXOTH);
+
+    fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (filename).c_str (), flags,
+        mode);
+    if (fd != -1 && ! truncate && ! atomicAppend)
+        ::lseek (fd, 0, SEEK_END);
+
+#endif
+
+    if (! isOpen ())
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to open file: ") + filename);
+        return;
+    }
+
+    helpers::getLogLog ().debug (
+        LOG4CPLUS_TEXT ("Just opened file: ") + filename);
+
+    if (! useIoUring)
+        return;
+
+#if defined (LOG4CPLUS_WITH_IO_URING)
+    int error = 0;
+    ring = internal::io_uring_writer::create (fd, bufferSize, syncWrites,
+        error);
+    if (! ring)
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("io_uring is not available, error ")
+            + helpers::convertIntegerToString (error)
+            + LOG4CPLUS_TEXT ("; writing ") + filename
+            + LOG4CPLUS_TEXT (" with writev()"));
+#else
+    helpers::getLogLog ().debug (
+        LOG4CPLUS_TEXT ("Built without io_uring support; writing ")
+        + filename + LOG4CPLUS_TEXT (" with writev()"));
+#endif
+}
+
+
+bool
+DirectFileAppender::isOpen () const
+{
+#if defined (_WIN32)
+    return handle != invalid_handle;
+#else
+    return fd != -1;
+#endif
+}
+
+
+bool
+DirectFileAppender::openDirect (bool truncate)
+{
+    if (! segment)
+        segment = std::make_unique<internal::direct_io_segment> (
+            segmentSize);
+
+    segment->used = 0;
+    segment->offset = 0;
+
+#if defined (_WIN32)
+    DWORD const disposition = truncate ? CREATE_ALWAYS : OPEN_ALWAYS;
+    DWORD const share = FILE_SHARE_DELETE | FILE_SHARE_WRITE
+        | FILE_SHARE_READ;
+    handle = CreateFile (filename.c_str (), GENERIC_WRITE, share, nullptr,
+        disposition, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING,
+        nullptr);
+    if (handle == invalid_handle
+        && GetLastError () == ERROR_INVALID_PARAMETER)
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("Direct I/O is not supported for ") + filename
+            + LOG4CPLUS_TEXT ("; writing through the cache"));
+        handle = CreateFile (filename.c_str (), GENERIC_WRITE, share,
+            nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+    }
+
+    if (handle == invalid_handle)
+        return false;
+
+    LARGE_INTEGER size;
+    if (! GetFileSizeEx (handle, &size))
+        size.QuadPart = 0;
+    std::uint64_t const file_size = static_cast<std::uint64_t> (
+        size.QuadPart);
+
+#else
+    int flags = O_WRONLY | O_CREAT
+#if defined (O_CLOEXEC)
+        | O_CLOEXEC
+#endif
+        ;
+    if (truncate)
+        flags |= O_TRUNC;
+
+    mode_t const mode = (S_IRWXU ^ S_IXUSR)
+        | (S_IRWXG ^ S_IXGRP)
+        | (S_IRWXO ^ S_IXOTH);
+
+    std::string const path (LOG4CPLUS_TSTRING_TO_STRING (filename));
+#if defined (O_DIRECT)
+    fd = ::open (path.c_str (), flags | O_DIRECT, mode);
+    if (fd == -1 && errno == EINVAL)
+    {
+        // E.g., tmpfs does not support O_DIRECT.
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("Direct I/O is not supported for ") + filename
+            + LOG4CPLUS_TEXT ("; writing through the cache"));
+        fd = ::open (path.c_str (), flags, mode);
+    }
+
+#else
+    fd = ::open (path.c_str (), flags, mode);
+#if defined (F_NOCACHE)
+    if (fd != -1)
+        (void) ::fcntl (fd, F_NOCACHE, 1);
+#endif
+
+#endif
+
+    if (fd == -1)
+        return false;
+
+    off_t const end = ::lseek (fd, 0, SEEK_END);
+    std::uint64_t const file_size = end == -1
+        ? 0 : static_cast<std::uint64_t> (end);
+
+#endif
+
+    // Appending continues in the last partial block of the file, which
+    // is read into the segment and written again with new records.
+    std::uint64_t const block = file_size / direct_io_alignment
+        * direct_io_alignment;
+    std::size_t const tail = static_cast<std::size_t> (file_size - block);
+    segment->offset = block;
+    if (tail != 0)
+    {
+        std::ifstream in (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (filename)
+            .c_str (), std::ios_base::binary);
+        in.seekg (static_cast<std::streamoff> (block));
+        if (in.read (segment->data, static_cast<std::streamsize> (tail)))
+            segment->used = tail;
+        else
+        {
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("Unable to read end of file ") + filename
+                + LOG4CPLUS_TEXT ("; appending after a gap"));
+            segment->offset = block + direct_io_alignment;
+        }
+    }
+
+    return true;
+}
+
+
+bool
+DirectFileAppender::writeAt (char const * data, std::size_t size,
+    std::uint64_t offset)
+{
+#if defined (_WIN32)
+    while (size != 0)
+    {
+        OVERLAPPED ov = {};
+        ov.Offset = static_cast<DWORD> (offset);
+        ov.OffsetHigh = static_cast<DWORD> (offset >> 32);
+        // Chunks are kept aligned for FILE_FLAG_NO_BUFFERING.
+        DWORD const chunk = static_cast<DWORD> ((std::min) (size,
+            std::size_t (1) << 30));
+        DWORD written = 0;
+        if (! WriteFile (handle, data, chunk, &written, &ov))
+        {
+            getErrorHandler ()->error (
+                LOG4CPLUS_TEXT ("WriteFile() failed: ")
+                + helpers::convertIntegerToString (GetLastError ()));
+            return false;
+        }
+
+        data += written;
+        size -= written;
+        offset += written;
+    }
+
+#else
+    while (size != 0)
+    {
+        ssize_t const ret = ::pwrite (fd, data, size,
+            static_cast<off_t> (offset));
+        if (ret == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            getErrorHandler ()->error (
+                LOG4CPLUS_TEXT ("pwrite() failed: ")
+                + helpers::convertIntegerToString (errno));
+            return false;
+        }
+
+        data += ret;
+        size -= static_cast<std::size_t> (ret);
+        offset += static_cast<std::uint64_t> (ret);
+    }
+
+#endif
+
+    return true;
+}
+
+
+void
+DirectFileAppender::appendDirect (std::string const & rec)
+{
+    if (! isOpen ())
+        return;
+
+    if (maxFileSize != 0)
+    {
+        std::uint64_t const size = segment->offset + segment->used;
+        if (size != 0 && size + rec.size () > maxFileSize)
+        {
+            rollover ();
+            if (! isOpen ())
+                return;
+        }
+    }
+
+    for (std::size_t done = 0; done != rec.size (); )
+    {
+        std::size_t const chunk = (std::min) (rec.size () - done,
+            segment->size - segment->used);
+        std::memcpy (segment->data + segment->used, rec.data () + done,
+            chunk);
+        segment->used += chunk;
+        done += chunk;
+
+        if (segment->used == segment->size)
+        {
+            if (writeAt (segment->data, segment->size, segment->offset)
+                && syncWrites)
+                syncFile ();
+
+            segment->offset += segment->size;
+            segment->used = 0;
+        }
+    }
+}
+
+
+void
+DirectFileAppender::writeSegmentTail ()
+{
+    std::size_t const tail = segment->used;
+    if (tail == 0)
+        return;
+
+    // Direct I/O writes whole blocks; the padding is cut off after.
+    std::size_t const padded = (tail + direct_io_alignment - 1)
+        / direct_io_alignment * direct_io_alignment;
+    std::memset (segment->data + tail, 0, padded - tail);
+    if (! writeAt (segment->data, padded, segment->offset))
+        return;
+
+    std::uint64_t const end = segment->offset + tail;
+#if defined (_WIN32)
+    LARGE_INTEGER pos;
+    pos.QuadPart = static_cast<LONGLONG> (end);
+    if (! SetFilePointerEx (handle, pos, nullptr, FILE_BEGIN)
+        || ! SetEndOfFile (handle))
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("SetEndOfFile() failed: ")
+            + helpers::convertIntegerToString (GetLastError ()));
+
+#else
+    if (::ftruncate (fd, static_cast<off_t> (end)) != 0)
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("ftruncate() failed: ")
+            + helpers::convertIntegerToString (errno));
+
+#endif
+
+    if (syncWrites)
+        syncFile ();
+}
+
+
+void
+DirectFileAppender::rollover ()
+{
+    closeFile ();
+
+    if (maxBackupIndex > 0)
+        internal::roll_file_backups (filename, maxBackupIndex);
+
+    openFile (true);
+}
+
+
+void
+DirectFileAppender::syncFile ()
+{
+#if defined (_WIN32)
+    if (! FlushFileBuffers (handle))
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("FlushFileBuffers() failed: ")
+            + helpers::convertIntegerToString (GetLastError ()));
+
+#else
+#if defined (_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+    int const ret = ::fdatasync (fd);
+#else
+    int const ret = ::fsync (fd);
+#endif
+    if (ret == -1)
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("fdatasync() failed: ")
+            + helpers::convertIntegerToString (errno));
+
+#endif
+}
+
+
+void
+DirectFileAppender::writeRecords (std::string const & rec)
+{
+#if defined (_WIN32)
+    for (std::string const * buf : {&pending, &rec})
+    {
+        char const * data = buf->data ();
+        std::size_t left = buf->size ();
+        while (left != 0)
+        {
+            DWORD const chunk = static_cast<DWORD> ((std::min) (left,
+                std::size_t ((std::numeric_limits<DWORD>::max) ())));
+            DWORD written = 0;
+            if (! WriteFile (handle, data, chunk, &written, nullptr))
+            {
+                getErrorHandler ()->error (
+                    LOG4CPLUS_TEXT ("WriteFile() failed: ")
+                    + helpers::convertIntegerToString (GetLastError ()));
+                pending.clear ();
+                return;
+            }
+
+            data += written;
+            left -= written;
+        }
+    }
+
+#else
+    iovec iov[2];
+    iov[0].iov_base = const_cast<char *> (pending.data ());
+    iov[0].iov_len = pending.size ();
+    iov[1].iov_base = const_cast<char *> (rec.data ());
+    iov[1].iov_len = rec.size ();
+
+    iovec * first = iov;
+    int count = 2;
+    while (count != 0)
+    {
+        ssize_t const ret = ::writev (fd, first, count);
+        if (ret == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            getErrorHandler ()->error (
+                LOG4CPLUS_TEXT ("writev() failed: ")
+                + helpers::convertIntegerToString (errno));
+            break;
+        }
+
+        // Skip what has been written after a partial write.
+        std::size_t written = static_cast<std::size_t> (ret);
+        while (count != 0 && written >= first->iov_len)
+        {
+            written -= first->iov_len;
+            ++first;
+            --count;
+        }
+
+        if (count != 0)
+        {
+            first->iov_base = static_cast<char *> (first->iov_base)
+                + written;
+            first->iov_len -= written;
+        }
+    }
+
+#endif
+
+    if (syncWrites)
+        syncFile ();
+
+    pending.clear ();
+}
+
+
+void
+DirectFileAppender::formatRecord (spi::InternalLoggingEvent const & event,
+    std::string & output)
+{
+#if defined (UNICODE)
+    internal::append_utf8 (output, formatEvent (event));
+#else
+    formatEvent (event, output);
+#endif
+}
+
+
+void
+DirectFileAppender::formatRecords (
+    std::span<spi::InternalLoggingEvent const> events, std::string & output)
+{
+#if defined (UNICODE)
+    tstring & str = internal::get_appender_sp ().str;
+    str.clear ();
+    formatEvents (events, str);
+    internal::append_utf8 (output, str);
+#else
+    formatEvents (events, output);
+#endif
+}
+
+
+std::string &
+DirectFileAppender::outputBuffer ()
+{
+#if defined (LOG4CPLUS_WITH_IO_URING)
+    if (ring)
+        return ring->slab ();
+#endif
+
+    return pending;
+}
+
+
+void
+DirectFileAppender::writeOutput ()
+{
+#if defined (LOG4CPLUS_WITH_IO_URING)
+    if (ring)
+    {
+        ring->submit ();
+        if (int const err = ring->take_error ())
+            getErrorHandler ()->error (
+                LOG4CPLUS_TEXT ("io_uring write failed: ")
+                + helpers::convertIntegerToString (err));
+        return;
+    }
+#endif
+
+    record.clear ();
+    writeRecords (record);
+}
+
+
+// This method does not need to be locked since it is called by
+// doAppend() which performs the locking
+void
+DirectFileAppender::append (spi::InternalLoggingEvent const & event)
+{
+    if (! isOpen ())
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("file is not open: ") + filename);
+        return;
+    }
+
+    if (segment)
+    {
+        record.clear ();
+        formatRecord (event, record);
+        appendDirect (record);
+        return;
+    }
+
+    // The event is formatted right into the buffer it is written from.
+    std::string & output = outputBuffer ();
+    formatRecord (event, output);
+    if (output.size () >= bufferSize)
+        writeOutput ();
+}
+
+
+// This method does not need to be locked since it is called by
+// syncDoAppendBatch() which performs the locking
+void
+DirectFileAppender::appendBatch (
+    std::span<spi::InternalLoggingEvent const> events)
+{
+    if (! isOpen ())
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("file is not open: ") + filename);
+        return;
+    }
+
+    if (segment)
+    {
+        for (auto const & event : events)
+        {
+            record.clear ();
+            formatRecord (event, record);
+            appendDirect (record);
+        }
+
+        return;
+    }
+
+    // Size of the gathered batch after which it is written.
+    std::size_t const batch_write_threshold
+        = (std::max) (std::size_t (64 * 1024), std::size_t (bufferSize));
+
+    // Events are formatted in chunks just reaching the threshold,
+    // estimated from the size of records so far.
+    std::size_t buffered = 0;
+    std::size_t recordSize = 0;
+    for (std::size_t i = 0; i != events.size (); )
+    {
+        std::string & output = outputBuffer ();
+        std::size_t const room = output.size () < batch_write_threshold
+            ? batch_write_threshold - output.size () : 0;
+        std::size_t const count = (std::min) (events.size () - i,
+            recordSize != 0 ? room / recordSize + 1 : 1);
+        std::size_t const before = output.size ();
+        formatRecords (events.subspan (i, count), output);
+        recordSize = (std::max) ((output.size () - before) / count,
+            std::size_t (1));
+        i += count;
+        buffered = output.size ();
+        if (buffered >= batch_write_threshold)
+        {
+            writeOutput ();
+            buffered = 0;
+        }
+    }
+
+    if (buffered != 0 && buffered >= bufferSize)
+        writeOutput ();
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("DirectFileAppender", "[appender]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-direct-test.log"));
+    auto const read_file = [&]
+    {
+        std::ifstream in (LOG4CPLUS_TSTRING_TO_STRING (file_name).c_str (),
+            std::ios_base::binary);
+        std::ostringstream oss;
+        oss << in.rdbuf ();
+        return oss.str ();
+    };
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+        INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"), __FILE__, __LINE__,
+        nullptr);
+    std::string const line ("INFO - message\n");
+
+    CATCH_SECTION ("immediate writes")
+    {
+        DirectFileAppender appender (file_name);
+        appender.doAppend (ev);
+        CATCH_REQUIRE (read_file () == line);
+
+        appender.doAppendBatch (
+            std::span<spi::InternalLoggingEvent const> (&ev, 1));
+        CATCH_REQUIRE (read_file () == line + line);
+        appender.close ();
+    }
+
+    CATCH_SECTION ("buffered writes")
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("File"), file_name);
+        props.setProperty (LOG4CPLUS_TEXT ("BufferSize"),
+            LOG4CPLUS_TEXT ("40"));
+        DirectFileAppender appender (props);
+
+        appender.doAppend (ev);
+        appender.doAppend (ev);
+        CATCH_REQUIRE (read_file ().empty ());
+
+        appender.doAppend (ev);
+        CATCH_REQUIRE (read_file () == line + line + line);
+
+        appender.doAppend (ev);
+        appender.close ();
+        CATCH_REQUIRE (read_file () == line + line + line + line);
+    }
+
+    CATCH_SECTION ("io_uring writes")
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("File"), file_name);
+        props.setProperty (LOG4CPLUS_TEXT ("IoUring"),
+            LOG4CPLUS_TEXT ("true"));
+        props.setProperty (LOG4CPLUS_TEXT ("SyncWrites"),
+            LOG4CPLUS_TEXT ("true"));
+        DirectFileAppender appender (props);
+
+        // Single events, batches and records larger than the ring's
+        // buffers keep their order.
+        std::string expected;
+        for (int i = 0; i != 100; ++i)
+        {
+            appender.doAppend (ev);
+            expected += line;
+        }
+
+        std::vector<spi::InternalLoggingEvent> const batch (5000, ev);
+        appender.doAppendBatch (batch);
+        for (std::size_t i = 0; i != batch.size (); ++i)
+            expected += line;
+
+        tstring const big_message (300 * 1024, LOG4CPLUS_TEXT ('x'));
+        spi::InternalLoggingEvent const big (LOG4CPLUS_TEXT ("test"),
+            INFO_LOG_LEVEL, big_message, __FILE__, __LINE__, nullptr);
+        appender.doAppend (big);
+        appender.doAppend (ev);
+        expected += "INFO - " + std::string (300 * 1024, 'x') + "\n" + line;
+
+        appender.close ();
+        CATCH_REQUIRE (read_file () == expected);
+    }
+
+    CATCH_SECTION ("direct I/O")
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("File"), file_name);
+        props.setProperty (LOG4CPLUS_TEXT ("DirectIO"),
+            LOG4CPLUS_TEXT ("true"));
+        props.setProperty (LOG4CPLUS_TEXT ("SegmentSize"),
+            LOG4CPLUS_TEXT ("4KB"));
+
+        std::string expected;
+        {
+            DirectFileAppender appender (props);
+            for (int i = 0; i != 1000; ++i)
+            {
+                appender.doAppend (ev);
+                expected += line;
+            }
+
+            // Only full segments are written before close.
+            CATCH_REQUIRE (read_file ().size () == 3 * 4096);
+            appender.close ();
+        }
+        CATCH_REQUIRE (read_file () == expected);
+
+        // Appending goes on in the partial last block.
+        props.setProperty (LOG4CPLUS_TEXT ("Append"),
+            LOG4CPLUS_TEXT ("true"));
+        DirectFileAppender appender (props);
+        std::vector<spi::InternalLoggingEvent> const batch (10, ev);
+        appender.doAppendBatch (batch);
+        for (std::size_t i = 0; i != batch.size (); ++i)
+            expected += line;
+        appender.close ();
+        CATCH_REQUIRE (read_file () == expected);
+    }
+
+    CATCH_SECTION ("direct I/O rollover")
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("File"), file_name);
+        props.setProperty (LOG4CPLUS_TEXT ("DirectIO"),
+            LOG4CPLUS_TEXT ("true"));
+        props.setProperty (LOG4CPLUS_TEXT ("SegmentSize"),
+            LOG4CPLUS_TEXT ("4KB"));
+        props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+            LOG4CPLUS_TEXT ("10KB"));
+        props.setProperty (LOG4CPLUS_TEXT ("MaxBackupIndex"),
+            LOG4CPLUS_TEXT ("2"));
+        DirectFileAppender appender (props);
+        for (int i = 0; i != 2000; ++i)
+            appender.doAppend (ev);
+        appender.close ();
+
+        for (int i = 0; i <= 2; ++i)
+        {
+            tstring const name = i == 0
+                ? file_name
+                : file_name + LOG4CPLUS_TEXT (".")
+                    + helpers::convertIntegerToString (i);
+            std::ifstream in (LOG4CPLUS_TSTRING_TO_STRING (name).c_str (),
+                std::ios_base::binary | std::ios_base::ate);
+            CATCH_REQUIRE (in.is_open ());
+            std::streamoff const size = in.tellg ();
+            CATCH_REQUIRE (size > 0);
+            CATCH_REQUIRE (size <= 10 * 1024);
+            CATCH_REQUIRE (size % std::streamoff (line.size ()) == 0);
+            in.close ();
+            if (i != 0)
+                std::remove (LOG4CPLUS_TSTRING_TO_STRING (name).c_str ());
+        }
+
+        tstring const oldest = file_name + LOG4CPLUS_TEXT (".3");
+        CATCH_REQUIRE (! std::ifstream (
+            LOG4CPLUS_TSTRING_TO_STRING (oldest).c_str ()).is_open ());
+    }
+
+    CATCH_SECTION ("append mode")
+    {
+        {
+            DirectFileAppender appender (file_name);
+            appender.doAppend (ev);
+        }
+        DirectFileAppender appender (file_name, true);
+        appender.doAppend (ev);
+        CATCH_REQUIRE (read_file () == line + line);
+        appender.close ();
+    }
+
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (file_name).c_str ());
+}
+
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+} // namespace log4cplus
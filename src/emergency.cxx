@@ -0,0 +1,567 @@
+// Module:  Log4cplus
+// File:    emergency.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+#if ! defined (_WIN32)
+#include <time.h>
+#endif
+
+#include <log4cplus/emergency.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <log4cplus/asyncappender.h>
+#include <log4cplus/fileappender.h>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+//! Registered appender as seen by the emergency path.
+struct emergency_slot
+{
+    std::atomic<Appender *> appender {nullptr};
+
+    //! Set while <code>buffer</code> is used by a thread.
+    std::atomic<bool> busy {false};
+
+    char * buffer = nullptr;
+    std::size_t size = 0;
+};
+
+
+emergency_slot slots[EMERGENCY_APPENDERS_MAX];
+
+
+//! Number of threads inside emergencyLog() or emergencyFlush().
+std::atomic<unsigned> active_threads {0};
+
+
+//! Owns what the slots point to. Used outside of the emergency path
+//! only.
+struct emergency_registry
+{
+    std::mutex mtx;
+    SharedAppenderPtr appenders[EMERGENCY_APPENDERS_MAX];
+    std::unique_ptr<char[]> buffers[EMERGENCY_APPENDERS_MAX];
+
+    static emergency_registry &
+    get ()
+    {
+        // Intentionally leaked so that slots stay valid during static
+        // destruction.
+        static emergency_registry * const registry = new emergency_registry;
+        return *registry;
+    }
+};
+
+
+struct active_thread_guard
+{
+    active_thread_guard () noexcept
+    {
+        active_threads.fetch_add (1, std::memory_order_acq_rel);
+    }
+
+    ~active_thread_guard ()
+    {
+        active_threads.fetch_sub (1, std::memory_order_acq_rel);
+    }
+};
+
+
+//! Formats an emergency line into a fixed buffer. The line is
+//! truncated to the buffer, keeping the terminating new line.
+class line_writer
+{
+public:
+    line_writer (char * buf, std::size_t size) noexcept
+        : begin (buf)
+        , p (buf)
+        , end (buf + size - 1)
+    { }
+
+    void
+    put (char c) noexcept
+    {
+        if (p != end)
+            *p++ = c;
+    }
+
+    void
+    put (char const * s) noexcept
+    {
+        if (! s)
+            return;
+
+        while (*s)
+            put (*s++);
+    }
+
+    void
+    put (tchar const * s, std::size_t n) noexcept
+    {
+#if defined (UNICODE)
+        // Encodes UTF-8 without allocating. Surrogates of UTF-16 are
+        // encoded one by one.
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            auto const c = static_cast<std::uint32_t> (s[i]);
+            if (c < 0x80)
+                put (static_cast<char> (c));
+            else if (c < 0x800)
+            {
+                put (static_cast<char> (0xC0 | (c >> 6)));
+                put (static_cast<char> (0x80 | (c & 0x3F)));
+            }
+            else if (c < 0x10000)
+            {
+                put (static_cast<char> (0xE0 | (c >> 12)));
+                put (static_cast<char> (0x80 | ((c >> 6) & 0x3F)));
+                put (static_cast<char> (0x80 | (c & 0x3F)));
+            }
+            else
+            {
+                put (static_cast<char> (0xF0 | (c >> 18)));
+                put (static_cast<char> (0x80 | ((c >> 12) & 0x3F)));
+                put (static_cast<char> (0x80 | ((c >> 6) & 0x3F)));
+                put (static_cast<char> (0x80 | (c & 0x3F)));
+            }
+        }
+#else
+        for (std::size_t i = 0; i != n; ++i)
+            put (s[i]);
+#endif
+    }
+
+    void
+    put_number (std::uint64_t value, unsigned width) noexcept
+    {
+        char digits[20];
+        unsigned count = 0;
+        do
+        {
+            digits[count++] = static_cast<char> ('0' + value % 10);
+            value /= 10;
+        }
+        while (value != 0);
+
+        for (; width > count; --width)
+            put ('0');
+
+        while (count != 0)
+            put (digits[--count]);
+    }
+
+    //! Puts UTC time <code>usecs</code> since the epoch and level.
+    void
+    put_header (std::int64_t usecs, LogLevel ll) noexcept
+    {
+        std::int64_t secs = usecs / 1000000;
+        std::int64_t frac = usecs % 1000000;
+        if (frac < 0)
+        {
+            frac += 1000000;
+            secs -= 1;
+        }
+
+        std::int64_t days = secs / 86400;
+        std::int64_t day_secs = secs % 86400;
+        if (day_secs < 0)
+        {
+            day_secs += 86400;
+            days -= 1;
+        }
+
+        // Civil date from days since the epoch, see
+        // http://howardhinnant.github.io/date_algorithms.html.
+        days += 719468;
+        std::int64_t const era = (days >= 0 ? days : days - 146096) / 146097;
+        std::int64_t const doe = days - era * 146097;
+        std::int64_t const yoe
+            = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        std::int64_t const doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        std::int64_t const mp = (5 * doy + 2) / 153;
+        std::int64_t const day = doy - (153 * mp + 2) / 5 + 1;
+        std::int64_t const month = mp < 10 ? mp + 3 : mp - 9;
+        std::int64_t const year = yoe + era * 400 + (month <= 2);
+
+        put_number (static_cast<std::uint64_t> (year), 4);
+        put ('-');
+        put_number (static_cast<std::uint64_t> (month), 2);
+        put ('-');
+        put_number (static_cast<std::uint64_t> (day), 2);
+        put (' ');
+        put_number (static_cast<std::uint64_t> (day_secs / 3600), 2);
+        put (':');
+        put_number (static_cast<std::uint64_t> (day_secs / 60 % 60), 2);
+        put (':');
+        put_number (static_cast<std::uint64_t> (day_secs % 60), 2);
+        put ('.');
+        put_number (static_cast<std::uint64_t> (frac), 6);
+        put (' ');
+        put (level_name (ll));
+        put (' ');
+    }
+
+    //! \return Length of the finished line.
+    std::size_t
+    finish () noexcept
+    {
+        *p++ = '\n';
+        return static_cast<std::size_t> (p - begin);
+    }
+
+private:
+    //! Names of the predefined levels; LogLevelManager is not usable
+    //! here.
+    static char const *
+    level_name (LogLevel ll) noexcept
+    {
+        if (ll >= FATAL_LOG_LEVEL)
+            return "FATAL";
+        else if (ll >= ERROR_LOG_LEVEL)
+            return "ERROR";
+        else if (ll >= WARN_LOG_LEVEL)
+            return "WARN";
+        else if (ll >= INFO_LOG_LEVEL)
+            return "INFO";
+        else if (ll >= DEBUG_LOG_LEVEL)
+            return "DEBUG";
+        else
+            return "TRACE";
+    }
+
+    char * begin;
+    char * p;
+    char * end;
+};
+
+
+//! \return Current time in microseconds since the epoch, read by
+//! async-signal-safe means.
+std::int64_t
+emergency_now () noexcept
+{
+#if defined (_WIN32)
+    return std::chrono::duration_cast<std::chrono::microseconds> (
+        std::chrono::system_clock::now ().time_since_epoch ()).count ();
+#else
+    struct timespec ts;
+    ::clock_gettime (CLOCK_REALTIME, &ts);
+    return static_cast<std::int64_t> (ts.tv_sec) * 1000000
+        + ts.tv_nsec / 1000;
+#endif
+}
+
+
+//! Writes <code>line</code> to all registered appenders.
+void
+write_all (char const * line, std::size_t size) noexcept
+{
+    for (auto & slot : slots)
+        if (Appender * const appender
+            = slot.appender.load (std::memory_order_acquire))
+            appender->emergencyWrite (line, size);
+}
+
+
+//! EmergencyEventVisitor of emergencyFlush(). The argument is the
+//! slot of the appender being dumped.
+void
+dump_event (spi::InternalLoggingEvent const & event, void * arg) noexcept
+{
+    emergency_slot & slot = *static_cast<emergency_slot *> (arg);
+    line_writer writer (slot.buffer, slot.size);
+    writer.put_header (std::chrono::duration_cast<std::chrono::microseconds> (
+            event.getTimestamp ().time_since_epoch ()).count (),
+        event.getLogLevel ());
+    tstring const & logger = event.getLoggerName ();
+    writer.put (logger.data (), logger.size ());
+    writer.put (" - ");
+    tstring const & message = event.getMessage ();
+    writer.put (message.data (), message.size ());
+    std::size_t const size = writer.finish ();
+    write_all (slot.buffer, size);
+}
+
+} // namespace
+
+
+bool
+addEmergencyAppender (SharedAppenderPtr const & appender,
+    std::size_t bufferSize)
+{
+    if (! appender)
+        return false;
+
+    appender->prepareEmergency ();
+
+    emergency_registry & registry = emergency_registry::get ();
+    std::lock_guard<std::mutex> guard (registry.mtx);
+    std::size_t free_index = EMERGENCY_APPENDERS_MAX;
+    for (std::size_t i = 0; i != EMERGENCY_APPENDERS_MAX; ++i)
+    {
+        if (registry.appenders[i] == appender)
+            return true;
+        else if (! registry.appenders[i] && free_index == EMERGENCY_APPENDERS_MAX)
+            free_index = i;
+    }
+
+    if (free_index == EMERGENCY_APPENDERS_MAX)
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("Too many emergency appenders, not adding ")
+            + appender->getName ());
+        return false;
+    }
+
+    // A line needs at least its new line character.
+    bufferSize = (std::max) (bufferSize, std::size_t (2));
+    registry.appenders[free_index] = appender;
+    registry.buffers[free_index].reset (new char[bufferSize]);
+
+    emergency_slot & slot = slots[free_index];
+    slot.buffer = registry.buffers[free_index].get ();
+    slot.size = bufferSize;
+    slot.appender.store (appender.get (), std::memory_order_release);
+    return true;
+}
+
+
+void
+removeEmergencyAppender (SharedAppenderPtr const & appender)
+{
+    emergency_registry & registry = emergency_registry::get ();
+    std::lock_guard<std::mutex> guard (registry.mtx);
+    for (std::size_t i = 0; i != EMERGENCY_APPENDERS_MAX; ++i)
+    {
+        if (! appender || registry.appenders[i] != appender)
+            continue;
+
+        emergency_slot & slot = slots[i];
+        slot.appender.store (nullptr, std::memory_order_release);
+
+        // Threads which have already seen the appender may still be
+        // writing through it.
+        while (active_threads.load (std::memory_order_acquire) != 0)
+            std::this_thread::yield ();
+
+        slot.buffer = nullptr;
+        slot.size = 0;
+        registry.buffers[i].reset ();
+        registry.appenders[i] = SharedAppenderPtr ();
+    }
+}
+
+
+void
+emergencyLog (LogLevel ll, char const * logger, char const * message)
+    noexcept
+{
+    active_thread_guard active;
+    std::int64_t const usecs = emergency_now ();
+    for (auto & slot : slots)
+    {
+        Appender * const appender
+            = slot.appender.load (std::memory_order_acquire);
+        if (! appender || slot.busy.exchange (true, std::memory_order_acquire))
+            continue;
+
+        line_writer writer (slot.buffer, slot.size);
+        writer.put_header (usecs, ll);
+        writer.put (logger);
+        writer.put (" - ");
+        writer.put (message);
+        appender->emergencyWrite (slot.buffer, writer.finish ());
+
+        slot.busy.store (false, std::memory_order_release);
+    }
+}
+
+
+void
+emergencyFlush () noexcept
+{
+    active_thread_guard active;
+    for (auto & slot : slots)
+    {
+        Appender * const appender
+            = slot.appender.load (std::memory_order_acquire);
+        if (! appender || slot.busy.exchange (true, std::memory_order_acquire))
+            continue;
+
+        appender->emergencyDump (&dump_event, &slot);
+
+        slot.busy.store (false, std::memory_order_release);
+    }
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Emergency logging", "[emergency]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-emergency-test.log"));
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (file_name).c_str ());
+    auto const read_file = [&]
+    {
+        std::ifstream in (LOG4CPLUS_TSTRING_TO_STRING (file_name).c_str (),
+            std::ios_base::binary);
+        std::ostringstream oss;
+        oss << in.rdbuf ();
+        return oss.str ();
+    };
+
+    SharedAppenderPtr file (new FileAppender (file_name));
+    file->setLayout (std::unique_ptr<Layout> (new SimpleLayout));
+
+    CATCH_SECTION ("line")
+    {
+        CATCH_REQUIRE (addEmergencyAppender (file, 64));
+        emergencyLog (ERROR_LOG_LEVEL, "crash", "last words");
+        emergencyLog (FATAL_LOG_LEVEL, "crash",
+            "a message much longer than the reserved buffer");
+
+        std::string const contents = read_file ();
+        std::size_t const eol = contents.find ('\n');
+        CATCH_REQUIRE (eol != std::string::npos);
+        std::string const first = contents.substr (0, eol);
+        CATCH_REQUIRE (first[4] == '-');
+        CATCH_REQUIRE (first[10] == ' ');
+        CATCH_REQUIRE (first[19] == '.');
+        CATCH_REQUIRE (first.substr (27) == "ERROR crash - last words");
+        std::string const second = contents.substr (eol + 1);
+        CATCH_REQUIRE (second.size () == 64);
+        CATCH_REQUIRE (second.back () == '\n');
+        CATCH_REQUIRE (second.compare (27, 20, "FATAL crash - a mess") == 0);
+    }
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    CATCH_SECTION ("async backlog")
+    {
+        // Appender which holds the queue thread in its first append.
+        class BlockingAppender
+            : public Appender
+        {
+        public:
+            BlockingAppender () = default;
+            ~BlockingAppender () { destructorImpl (); }
+            void close () { }
+
+            void
+            wait_entered ()
+            {
+                std::unique_lock<std::mutex> lock (mtx);
+                cond.wait (lock, [this] { return entered; });
+            }
+
+            void
+            release ()
+            {
+                std::lock_guard<std::mutex> lock (mtx);
+                released = true;
+                cond.notify_all ();
+            }
+
+        protected:
+            void
+            append (spi::InternalLoggingEvent const &)
+            {
+                std::unique_lock<std::mutex> lock (mtx);
+                entered = true;
+                cond.notify_all ();
+                cond.wait (lock, [this] { return released; });
+            }
+
+        private:
+            std::mutex mtx;
+            std::condition_variable cond;
+            bool entered = false;
+            bool released = false;
+        };
+
+        helpers::SharedObjectPtr<BlockingAppender> blocking (
+            new BlockingAppender);
+        SharedAppenderPtr async (
+            new AsyncAppender (SharedAppenderPtr (blocking.get ()), 16));
+        CATCH_REQUIRE (addEmergencyAppender (file));
+        CATCH_REQUIRE (addEmergencyAppender (async));
+
+        auto const event = [] (tchar const * message)
+        {
+            return spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("worker"),
+                WARN_LOG_LEVEL, message, __FILE__, __LINE__, nullptr);
+        };
+
+        async->doAppend (event (LOG4CPLUS_TEXT ("taken")));
+        blocking->wait_entered ();
+        async->doAppend (event (LOG4CPLUS_TEXT ("queued 1")));
+        async->doAppend (event (LOG4CPLUS_TEXT ("queued 2")));
+
+        emergencyFlush ();
+        std::string const contents = read_file ();
+        CATCH_REQUIRE (contents.find ("WARN worker - queued 1\n")
+            != std::string::npos);
+        CATCH_REQUIRE (contents.find ("queued 1") < contents.find ("queued 2"));
+        CATCH_REQUIRE (contents.find ("taken") == std::string::npos);
+
+        removeEmergencyAppender (async);
+        blocking->release ();
+        async->close ();
+    }
+#endif
+
+    removeEmergencyAppender (file);
+    file->close ();
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (file_name).c_str ());
+}
+
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+} // namespace log4cplus
@@ -0,0 +1,214 @@
+// Module:  Log4cplus
+// File:    etwappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <log4cplus/config.hxx>
+#if defined (LOG4CPLUS_HAVE_TRACELOGGING)
+
+#include <log4cplus/config/windowsh-inc.h>
+#include <TraceLoggingProvider.h>
+
+#include <log4cplus/etwappender.h>
+#include <log4cplus/loglevel.h>
+#include <log4cplus/mdc.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/internal/internal.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <mutex>
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+// The GUID is hashed from the provider name the same way EventSource
+// does it, see documentation of EtwAppender.
+TRACELOGGING_DEFINE_PROVIDER (log4cplus_provider, "log4cplus",
+    (0x2f76fada, 0xf0bd, 0x529c,
+        0x92, 0x07, 0x3f, 0xe9, 0xc7, 0x56, 0x91, 0x76));
+
+
+//! Guards registration of the provider shared by all appenders.
+std::mutex provider_mutex;
+unsigned provider_users = 0;
+
+
+//! Called by ETW when a session enables or disables the provider.
+void NTAPI
+provider_callback (LPCGUID, ULONG, UCHAR, ULONGLONG, ULONGLONG,
+    PEVENT_FILTER_DESCRIPTOR, PVOID)
+{
+    internal::invalidate_pre_filter_caches ();
+}
+
+
+UCHAR
+etw_level (LogLevel ll)
+{
+    if (ll >= FATAL_LOG_LEVEL)
+        return WINEVENT_LEVEL_CRITICAL;
+    else if (ll >= ERROR_LOG_LEVEL)
+        return WINEVENT_LEVEL_ERROR;
+    else if (ll >= WARN_LOG_LEVEL)
+        return WINEVENT_LEVEL_WARNING;
+    else if (ll >= INFO_LOG_LEVEL)
+        return WINEVENT_LEVEL_INFO;
+    else
+        return WINEVENT_LEVEL_VERBOSE;
+}
+
+} // namespace
+
+
+#if defined (UNICODE)
+#  define LOG4CPLUS_ETW_TSTRING(str, name) TraceLoggingWideString (str, name)
+#else
+#  define LOG4CPLUS_ETW_TSTRING(str, name) TraceLoggingString (str, name)
+#endif
+
+// TraceLogging needs the level as a constant.
+#define LOG4CPLUS_ETW_WRITE(level)                                      \
+    TraceLoggingWrite (log4cplus_provider, "LogEvent",                 \
+        TraceLoggingLevel (level),                                      \
+        TraceLoggingInt32 (event.getLogLevel (), "Level"),              \
+        LOG4CPLUS_ETW_TSTRING (event.getLoggerName ().c_str (),         \
+            "Logger"),                                                  \
+        LOG4CPLUS_ETW_TSTRING (event.getThread ().c_str (), "Thread"), \
+        LOG4CPLUS_ETW_TSTRING (event.getMessage ().c_str (),            \
+            "Message"),                                                 \
+        LOG4CPLUS_ETW_TSTRING (mdcBuffer.c_str (), "MDC"))
+
+
+EtwAppender::EtwAppender ()
+{
+    init ();
+}
+
+
+EtwAppender::EtwAppender (helpers::Properties const & props)
+    : Appender (props)
+{
+    init ();
+}
+
+
+EtwAppender::~EtwAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+EtwAppender::init ()
+{
+    std::lock_guard guard (provider_mutex);
+    if (provider_users++ == 0)
+    {
+        HRESULT const hr = TraceLoggingRegisterEx (log4cplus_provider,
+            provider_callback, nullptr);
+        if (FAILED (hr))
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("EtwAppender: TraceLoggingRegisterEx failed"));
+    }
+}
+
+
+void
+EtwAppender::close ()
+{
+    if (closed)
+        return;
+
+    {
+        std::lock_guard guard (provider_mutex);
+        if (--provider_users == 0)
+            TraceLoggingUnregister (log4cplus_provider);
+    }
+
+    closed = true;
+    consumersChanged ();
+}
+
+
+bool
+EtwAppender::hasConsumers (LogLevel ll) const
+{
+    return TraceLoggingProviderEnabled (log4cplus_provider, etw_level (ll),
+        0);
+}
+
+
+void
+EtwAppender::append (spi::InternalLoggingEvent const & event)
+{
+    UCHAR const level = etw_level (event.getLogLevel ());
+    if (! TraceLoggingProviderEnabled (log4cplus_provider, level, 0))
+        return;
+
+    mdcBuffer.clear ();
+    for (auto const & kv : event.getMDCCopy ())
+    {
+        if (! mdcBuffer.empty ())
+            mdcBuffer += LOG4CPLUS_TEXT (';');
+        mdcBuffer += kv.first;
+        mdcBuffer += LOG4CPLUS_TEXT ('=');
+        mdcBuffer += kv.second;
+    }
+
+    switch (level)
+    {
+    case WINEVENT_LEVEL_CRITICAL:
+        LOG4CPLUS_ETW_WRITE (WINEVENT_LEVEL_CRITICAL);
+        break;
+
+    case WINEVENT_LEVEL_ERROR:
+        LOG4CPLUS_ETW_WRITE (WINEVENT_LEVEL_ERROR);
+        break;
+
+    case WINEVENT_LEVEL_WARNING:
+        LOG4CPLUS_ETW_WRITE (WINEVENT_LEVEL_WARNING);
+        break;
+
+    case WINEVENT_LEVEL_INFO:
+        LOG4CPLUS_ETW_WRITE (WINEVENT_LEVEL_INFO);
+        break;
+
+    default:
+        LOG4CPLUS_ETW_WRITE (WINEVENT_LEVEL_VERBOSE);
+        break;
+    }
+}
+
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_HAVE_TRACELOGGING
@@ -0,0 +1,499 @@
+// Module:  Log4cplus
+// File:    executor.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/config.hxx>
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+#include <log4cplus/internal/internal.h>
+#include <log4cplus/thread/threads.h>
+#include <algorithm>
+#include <thread>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <vector>
+#include <catch.hpp>
+#endif
+
+
+namespace log4cplus { namespace internal {
+
+
+struct executor::worker
+{
+    std::size_t index = 0;
+
+    //! Protects the queue.
+    std::mutex mtx;
+    executor_task * head = nullptr;
+    executor_task * tail = nullptr;
+    //! Number of queued tasks, read without locking by thieves.
+    std::atomic<std::size_t> size {0};
+
+    std::thread thread;
+    //! Set while <code>thread</code> runs work(); protected by
+    //! executor::mtx.
+    bool running = false;
+};
+
+
+namespace
+{
+
+//! Executor and index of the worker the current thread runs, if any.
+thread_local executor const * current_executor = nullptr;
+thread_local std::size_t current_worker_index = 0;
+
+
+//! Wraps function submitted to executor.
+class function_task final
+    : public executor_task
+{
+public:
+    explicit function_task (std::function<void ()> f)
+        : func (std::move (f))
+    { }
+
+    void
+    run (executor &) override
+    {
+        std::unique_ptr<function_task> const guard (this);
+        func ();
+    }
+
+private:
+    std::function<void ()> func;
+};
+
+} // namespace
+
+
+executor::executor (std::size_t threads,
+    std::chrono::milliseconds timeout)
+    : workers (new worker[max_workers])
+    , pool_size (0)
+    , live (0)
+    , idle_timeout (timeout)
+    , next_worker (0)
+    , queued (0)
+    , outstanding (0)
+    , sleepers (0)
+    , stop (false)
+{
+    for (std::size_t i = 0; i != max_workers; ++i)
+        workers[i].index = i;
+
+    set_pool_size (threads);
+}
+
+
+executor::~executor ()
+{
+    {
+        std::unique_lock<std::mutex> lock (mtx);
+        stop = true;
+    }
+    work_cond.notify_all ();
+
+    for (std::size_t i = 0; i != max_workers; ++i)
+        if (workers[i].thread.joinable ())
+            workers[i].thread.join ();
+}
+
+
+void
+executor::submit (executor_task * task)
+{
+    outstanding.fetch_add (1, std::memory_order_relaxed);
+
+    worker * const w = current_executor == this
+        ? &workers[current_worker_index]
+        : &workers[next_worker.fetch_add (1, std::memory_order_relaxed)
+            % pool_size.load (std::memory_order_relaxed)];
+
+    task->next_task = nullptr;
+    {
+        std::lock_guard<std::mutex> guard (w->mtx);
+        if (w->tail)
+            w->tail->next_task = task;
+        else
+            w->head = task;
+        w->tail = task;
+        w->size.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    // Exiting worker decrements live before it checks queued, see
+    // work(), so either it sees this task or this sees it gone.
+    queued.fetch_add (1, std::memory_order_seq_cst);
+    if (sleepers.load (std::memory_order_seq_cst) != 0
+        || live.load (std::memory_order_seq_cst)
+            < pool_size.load (std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> guard (mtx);
+        if (sleepers.load (std::memory_order_relaxed) != 0)
+            work_cond.notify_one ();
+        else
+            start_worker_if_needed ();
+    }
+}
+
+
+void
+executor::submit (std::function<void ()> task)
+{
+    std::unique_ptr<function_task> ft (new function_task (std::move (task)));
+    submit (ft.get ());
+    ft.release ();
+}
+
+
+void
+executor::set_pool_size (std::size_t threads)
+{
+    threads = (std::clamp) (threads, std::size_t (1),
+        std::size_t (max_workers));
+
+    std::unique_lock<std::mutex> lock (mtx);
+    if (stop)
+        return;
+
+    pool_size.store (threads, std::memory_order_relaxed);
+
+    // Wake up workers above the new size so that they exit.
+    work_cond.notify_all ();
+}
+
+
+void
+executor::set_idle_timeout (std::chrono::milliseconds timeout)
+{
+    std::lock_guard<std::mutex> guard (mtx);
+    idle_timeout = timeout;
+    work_cond.notify_all ();
+}
+
+
+std::chrono::milliseconds
+executor::get_idle_timeout () const
+{
+    std::lock_guard<std::mutex> guard (mtx);
+    return idle_timeout;
+}
+
+
+void
+executor::start_worker_if_needed ()
+{
+    if (stop || sleepers.load (std::memory_order_relaxed) != 0)
+        return;
+
+    std::size_t const size = pool_size.load (std::memory_order_relaxed);
+    for (std::size_t i = 0; i != size; ++i)
+    {
+        worker & w = workers[i];
+        if (w.running)
+            continue;
+
+        // Thread of worker that has exited on its own.
+        if (w.thread.joinable ())
+            w.thread.join ();
+        start (w);
+        return;
+    }
+}
+
+
+void
+executor::wait_until_idle ()
+{
+    std::unique_lock<std::mutex> lock (mtx);
+    idle_cond.wait (lock,
+        [this] {
+            return outstanding.load (std::memory_order_acquire) == 0; });
+}
+
+
+bool
+executor::wait_until_idle (std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock (mtx);
+    return idle_cond.wait_until (lock, deadline,
+        [this] {
+            return outstanding.load (std::memory_order_acquire) == 0; });
+}
+
+
+bool
+executor::is_idle () const
+{
+    return outstanding.load (std::memory_order_acquire)
+        == (current_executor == this ? 1u : 0u);
+}
+
+
+std::size_t
+executor::get_pool_size () const
+{
+    return pool_size.load (std::memory_order_relaxed);
+}
+
+
+std::size_t
+executor::get_worker_count () const
+{
+    return live.load (std::memory_order_relaxed);
+}
+
+
+std::size_t
+executor::default_pool_size ()
+{
+    return (std::clamp) (std::size_t (std::thread::hardware_concurrency ()),
+        std::size_t (4), std::size_t (max_workers));
+}
+
+
+void
+executor::start (worker & w)
+{
+    thread::SignalsBlocker sb;
+    w.running = true;
+    live.fetch_add (1, std::memory_order_seq_cst);
+    try
+    {
+        w.thread = std::thread ([this, &w] { work (w); });
+    }
+    catch (...)
+    {
+        w.running = false;
+        live.fetch_sub (1, std::memory_order_seq_cst);
+        throw;
+    }
+}
+
+
+executor_task *
+executor::take (worker & w)
+{
+    // Own queue first, then steal from the others, including queues of
+    // workers that have exited after pool size was reduced.
+    for (std::size_t i = 0; i != max_workers; ++i)
+    {
+        worker & victim = workers[(w.index + i) % max_workers];
+        if (victim.size.load (std::memory_order_relaxed) == 0)
+            continue;
+
+        std::lock_guard<std::mutex> guard (victim.mtx);
+        executor_task * const task = victim.head;
+        if (! task)
+            continue;
+
+        victim.head = task->next_task;
+        if (! victim.head)
+            victim.tail = nullptr;
+        victim.size.fetch_sub (1, std::memory_order_relaxed);
+        queued.fetch_sub (1, std::memory_order_relaxed);
+        return task;
+    }
+
+    return nullptr;
+}
+
+
+void
+executor::work (worker & w)
+{
+    current_executor = this;
+    current_worker_index = w.index;
+    thread::applyBackgroundThreadSettings (LOG4CPLUS_TEXT ("pool"));
+#if defined (LOG4CPLUS_USE_PTHREADS)
+    fork_gate_guard::exempt_current_thread ();
+#endif
+
+    for (;;)
+    {
+        if (executor_task * const task = take (w))
+        {
+            try
+            {
+                task->run (*this);
+            }
+            catch (...)
+            {
+                // Tasks report their own errors.
+            }
+
+            if (outstanding.fetch_sub (1, std::memory_order_acq_rel) == 1)
+            {
+                std::lock_guard<std::mutex> guard (mtx);
+                idle_cond.notify_all ();
+                if (stop)
+                    work_cond.notify_all ();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock (mtx);
+        sleepers.fetch_add (1, std::memory_order_seq_cst);
+        bool const woken = work_cond.wait_for (lock, idle_timeout,
+            [&] {
+                return queued.load (std::memory_order_seq_cst) != 0
+                    || (stop
+                        && outstanding.load (std::memory_order_acquire) == 0)
+                    || (! stop
+                        && w.index >= pool_size.load (
+                            std::memory_order_relaxed));
+            });
+
+        // Idle or surplus worker leaves, unless a task has been queued
+        // meanwhile; submit() checks live after it has queued a task.
+        bool const leave = stop
+            ? outstanding.load (std::memory_order_acquire) == 0
+            : ! woken || w.index >= pool_size.load (std::memory_order_relaxed);
+        if (leave)
+            live.fetch_sub (1, std::memory_order_seq_cst);
+        sleepers.fetch_sub (1, std::memory_order_seq_cst);
+
+        if (queued.load (std::memory_order_seq_cst) != 0 && ! stop)
+        {
+            if (leave)
+                live.fetch_add (1, std::memory_order_seq_cst);
+            continue;
+        }
+
+        if (leave)
+        {
+            w.running = false;
+            break;
+        }
+    }
+
+    current_executor = nullptr;
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Executor", "[executor]")
+{
+    std::atomic<std::size_t> count {0};
+
+    CATCH_SECTION ("runs submitted tasks")
+    {
+        executor exec (4);
+        for (std::size_t i = 0; i != 1000; ++i)
+            exec.submit ([&count] { ++count; });
+        exec.wait_until_idle ();
+        CATCH_REQUIRE (count == 1000);
+    }
+
+    CATCH_SECTION ("tasks submitted by tasks")
+    {
+        executor exec (2);
+        for (std::size_t i = 0; i != 100; ++i)
+            exec.submit (
+                [&count, &exec]
+                {
+                    exec.submit ([&count] { ++count; });
+                    ++count;
+                });
+        exec.wait_until_idle ();
+        CATCH_REQUIRE (count == 200);
+    }
+
+    CATCH_SECTION ("pool size changes")
+    {
+        executor exec (1);
+        for (std::size_t size : {8, 2, 0, 3})
+        {
+            exec.set_pool_size (size);
+            for (std::size_t i = 0; i != 100; ++i)
+                exec.submit ([&count] { ++count; });
+        }
+        exec.wait_until_idle ();
+        CATCH_REQUIRE (count == 400);
+    }
+
+    CATCH_SECTION ("workers start on demand and exit when idle")
+    {
+        executor exec (4, std::chrono::milliseconds (20));
+        CATCH_REQUIRE (exec.get_worker_count () == 0);
+
+        std::mutex mtx;
+        std::condition_variable cond;
+        bool release = false;
+        for (std::size_t i = 0; i != 4; ++i)
+            exec.submit (
+                [&]
+                {
+                    std::unique_lock<std::mutex> lock (mtx);
+                    ++count;
+                    cond.notify_all ();
+                    cond.wait (lock, [&] { return release; });
+                });
+
+        // Blocked tasks make the pool grow to its size.
+        {
+            std::unique_lock<std::mutex> lock (mtx);
+            cond.wait (lock, [&] { return count == 4; });
+            CATCH_REQUIRE (exec.get_worker_count () == 4);
+            release = true;
+            cond.notify_all ();
+        }
+        exec.wait_until_idle ();
+
+        for (int i = 0; i != 500 && exec.get_worker_count () != 0; ++i)
+            std::this_thread::sleep_for (std::chrono::milliseconds (10));
+        CATCH_REQUIRE (exec.get_worker_count () == 0);
+
+        exec.submit ([&count] { ++count; });
+        exec.wait_until_idle ();
+        CATCH_REQUIRE (count == 5);
+    }
+
+    CATCH_SECTION ("destructor runs queued tasks")
+    {
+        {
+            executor exec (1);
+            for (std::size_t i = 0; i != 100; ++i)
+                exec.submit (
+                    [&count]
+                    {
+                        std::this_thread::yield ();
+                        ++count;
+                    });
+        }
+        CATCH_REQUIRE (count == 100);
+    }
+}
+#endif
+
+
+} } // namespace log4cplus { namespace internal {
+
+#endif // ! defined (LOG4CPLUS_SINGLE_THREADED)
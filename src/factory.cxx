@@ -24,14 +24,32 @@
 #include <log4cplus/helpers/thread-config.h>
 #include <log4cplus/helpers/property.h>
 #include <log4cplus/asyncappender.h>
+#include <log4cplus/backtracebufferappender.h>
+#include <log4cplus/binaryfileappender.h>
+#include <log4cplus/columnarfileappender.h>
+#include <log4cplus/compressedfileappender.h>
 #include <log4cplus/consoleappender.h>
+#include <log4cplus/directfileappender.h>
+#include <log4cplus/etwappender.h>
 #include <log4cplus/fileappender.h>
+#include <log4cplus/httpbulkappender.h>
+#include <log4cplus/journaldappender.h>
+#include <log4cplus/jsonlayout.h>
+#include <log4cplus/logfmtlayout.h>
+#include <log4cplus/mappedringfileappender.h>
 #include <log4cplus/nteventlogappender.h>
 #include <log4cplus/nullappender.h>
+#include <log4cplus/otlpappender.h>
+#include <log4cplus/routingappender.h>
+#include <log4cplus/sharedmemoryappender.h>
+#include <log4cplus/shmtransportappender.h>
 #include <log4cplus/socketappender.h>
 #include <log4cplus/syslogappender.h>
+#include <log4cplus/threadshardedappender.h>
+#include <log4cplus/traceeventappender.h>
 #include <log4cplus/win32debugappender.h>
 #include <log4cplus/win32consoleappender.h>
+#include <log4cplus/workloadcapture.h>
 #include <log4cplus/log4judpappender.h>
 
 
@@ -163,10 +181,16 @@ void initializeFactoryRegistry()
     DisableFactoryLocking<spi::AppenderFactoryRegistry> dfl_reg (reg);
     LOG4CPLUS_REG_APPENDER (reg, ConsoleAppender);
     LOG4CPLUS_REG_APPENDER (reg, NullAppender);
+    LOG4CPLUS_REG_APPENDER (reg, BinaryFileAppender);
+    LOG4CPLUS_REG_APPENDER (reg, ColumnarFileAppender);
     LOG4CPLUS_REG_APPENDER (reg, FileAppender);
+    LOG4CPLUS_REG_APPENDER (reg, DirectFileAppender);
+    LOG4CPLUS_REG_APPENDER (reg, TraceEventAppender);
     LOG4CPLUS_REG_APPENDER (reg, RollingFileAppender);
+    LOG4CPLUS_REG_APPENDER (reg, CompressedRollingFileAppender);
     LOG4CPLUS_REG_APPENDER (reg, DailyRollingFileAppender);
     LOG4CPLUS_REG_APPENDER (reg, TimeBasedRollingFileAppender);
+    LOG4CPLUS_REG_APPENDER (reg, MappedRingFileAppender);
     LOG4CPLUS_REG_APPENDER (reg, SocketAppender);
 #if defined(_WIN32)
 #  if defined(LOG4CPLUS_HAVE_NT_EVENT_LOG)
@@ -176,18 +200,37 @@ void initializeFactoryRegistry()
     LOG4CPLUS_REG_APPENDER (reg, Win32ConsoleAppender);
 #  endif
     LOG4CPLUS_REG_APPENDER (reg, Win32DebugAppender);
+#  if defined(LOG4CPLUS_HAVE_TRACELOGGING)
+    LOG4CPLUS_REG_APPENDER (reg, EtwAppender);
+#  endif
 #endif
     LOG4CPLUS_REG_APPENDER (reg, SysLogAppender);
+#if defined (LOG4CPLUS_HAVE_SYS_UN_H) && ! defined (_WIN32)
+    LOG4CPLUS_REG_APPENDER (reg, JournaldAppender);
+#endif
+#if defined (LOG4CPLUS_HAVE_SYS_UN_H) && defined (__linux__)
+    LOG4CPLUS_REG_APPENDER (reg, ShmTransportAppender);
+#endif
 #ifndef LOG4CPLUS_SINGLE_THREADED
     LOG4CPLUS_REG_APPENDER (reg, AsyncAppender);
+    LOG4CPLUS_REG_APPENDER (reg, HttpBulkAppender);
+    LOG4CPLUS_REG_APPENDER (reg, OtlpAppender);
+    LOG4CPLUS_REG_APPENDER (reg, SharedMemoryAppender);
+    LOG4CPLUS_REG_APPENDER (reg, ThreadShardedAppender);
 #endif
+    LOG4CPLUS_REG_APPENDER (reg, BacktraceBufferAppender);
     LOG4CPLUS_REG_APPENDER (reg, Log4jUdpAppender);
+    LOG4CPLUS_REG_APPENDER (reg, RoutingAppender);
+    LOG4CPLUS_REG_APPENDER (reg, WorkloadCaptureAppender);
 
     spi::LayoutFactoryRegistry& reg2 = spi::getLayoutFactoryRegistry();
     DisableFactoryLocking<spi::LayoutFactoryRegistry> dfl_reg2 (reg2);
     LOG4CPLUS_REG_LAYOUT (reg2, SimpleLayout);
     LOG4CPLUS_REG_LAYOUT (reg2, TTCCLayout);
     LOG4CPLUS_REG_LAYOUT (reg2, PatternLayout);
+    LOG4CPLUS_REG_LAYOUT (reg2, JsonLayout);
+    LOG4CPLUS_REG_LAYOUT (reg2, LogfmtLayout);
+    LOG4CPLUS_REG_LAYOUT (reg2, TraceEventLayout);
 
     spi::FilterFactoryRegistry& reg3 = spi::getFilterFactoryRegistry();
     DisableFactoryLocking<spi::FilterFactoryRegistry> dfl_reg3 (reg3);
@@ -195,8 +238,12 @@ void initializeFactoryRegistry()
     LOG4CPLUS_REG_FILTER (reg3, LogLevelMatchFilter);
     LOG4CPLUS_REG_FILTER (reg3, LogLevelRangeFilter);
     LOG4CPLUS_REG_FILTER (reg3, StringMatchFilter);
+    LOG4CPLUS_REG_FILTER (reg3, MultiStringMatchFilter);
     LOG4CPLUS_REG_FILTER (reg3, NDCMatchFilter);
     LOG4CPLUS_REG_FILTER (reg3, MDCMatchFilter);
+    LOG4CPLUS_REG_FILTER (reg3, RateLimitFilter);
+    LOG4CPLUS_REG_FILTER (reg3, DuplicateSuppressionFilter);
+    LOG4CPLUS_REG_FILTER (reg3, SamplingFilter);
 
     spi::LocaleFactoryRegistry& reg4 = spi::getLocaleFactoryRegistry();
     DisableFactoryLocking<spi::LocaleFactoryRegistry> dfl_reg4 (reg4);
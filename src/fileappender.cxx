@@ -33,9 +33,41 @@
 #include <algorithm>
 #include <memory>
 #include <sstream>
+#include <chrono>
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <log4cplus/thread/threads.h>
+#endif
 #include <cstdio>
 #include <stdexcept>
 #include <cmath> // std::fmod
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <system_error>
+#include <vector>
+
+#if defined (_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#else
+#if defined (LOG4CPLUS_HAVE_FCNTL_H) || defined (LOG4CPLUS_HAVE_FALLOCATE)
+#include <fcntl.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_UNISTD_H) || defined (LOG4CPLUS_HAVE_FALLOCATE)
+#include <unistd.h>
+#endif
+#endif
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+#include <zlib.h>
+#endif
+#if defined (LOG4CPLUS_WITH_ZSTD)
+#include <zstd.h>
+#endif
 
 // For _wrename() and _wremove() on Windows.
 #include <stdio.h>
@@ -46,6 +78,11 @@
 
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 #include <catch.hpp>
+#include <atomic>
+#if ! defined (_WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 #endif
 
 
@@ -154,249 +191,1753 @@ loglog_opening_result (helpers::LogLog & loglog,
 
 static
 void
-rolloverFiles(const tstring& filename, unsigned int maxBackupIndex)
+rolloverFiles(const tstring& filename, unsigned int maxBackupIndex,
+    const tstring& compressedSuffix = tstring ())
 {
     helpers::LogLog * loglog = helpers::LogLog::getLogLog();
 
-    // Delete the oldest file
-    tostringstream buffer;
-    buffer << filename << LOG4CPLUS_TEXT(".") << maxBackupIndex;
-    long ret = file_remove (buffer.str ());
+    // Backups are rotated both with and without the suffix of
+    // compressed files. Uncompressed backups remain when compression
+    // fails or when it has been enabled only recently.
+    tstring const suffixes[2] = {tstring (), compressedSuffix};
+    std::size_t const suffixCount = compressedSuffix.empty () ? 1 : 2;
 
-    tostringstream source_oss;
-    tostringstream target_oss;
+    // Backup indices are formatted without locale so that names do not
+    // get digit grouping, e.g., "log.1,000".
+    auto const backup_name = [&filename] (int index)
+    {
+        return filename + LOG4CPLUS_TEXT(".")
+            + helpers::convertIntegerToString (index);
+    };
+
+    // Delete the oldest file
+    tstring const oldest = backup_name (static_cast<int> (maxBackupIndex));
+    long ret;
+    for (std::size_t s = 0; s != suffixCount; ++s)
+        ret = file_remove (oldest + suffixes[s]);
 
     // Map {(maxBackupIndex - 1), ..., 2, 1} to {maxBackupIndex, ..., 3, 2}
     for (int i = maxBackupIndex - 1; i >= 1; --i)
     {
-        source_oss.str(internal::empty_str);
-        target_oss.str(internal::empty_str);
-
-        source_oss << filename << LOG4CPLUS_TEXT(".") << i;
-        target_oss << filename << LOG4CPLUS_TEXT(".") << (i+1);
+        tstring const source_name = backup_name (i);
+        tstring const target_name = backup_name (i + 1);
 
-        tstring const source (source_oss.str ());
-        tstring const target (target_oss.str ());
+        for (std::size_t s = 0; s != suffixCount; ++s)
+        {
+            tstring const source (source_name + suffixes[s]);
+            tstring const target (target_name + suffixes[s]);
 
 #if defined (_WIN32)
-        // Try to remove the target first. It seems it is not
-        // possible to rename over existing file.
-        ret = file_remove (target);
+            // Try to remove the target first. It seems it is not
+            // possible to rename over existing file.
+            ret = file_remove (target);
 #endif
 
-        ret = file_rename (source, target);
-        loglog_renaming_result (*loglog, source, target, ret);
+            ret = file_rename (source, target);
+            loglog_renaming_result (*loglog, source, target, ret);
+        }
     }
 } // end rolloverFiles()
 
-} // namespace
-
 
-///////////////////////////////////////////////////////////////////////////////
-// FileAppenderBase ctors and dtor
-///////////////////////////////////////////////////////////////////////////////
+#if defined (LOG4CPLUS_HAVE_FALLOCATE) && defined (FALLOC_FL_KEEP_SIZE)
+static
+int
+open_for_allocation (tstring const & name)
+{
+    return ::open (LOG4CPLUS_TSTRING_TO_STRING (name).c_str (), O_WRONLY
+#if defined (O_CLOEXEC)
+        | O_CLOEXEC
+#endif
+        );
+}
 
-FileAppenderBase::FileAppenderBase(const tstring& filename_,
-    std::ios_base::openmode mode_, bool immediateFlush_, bool createDirs_)
-    : immediateFlush(immediateFlush_)
-    , createDirs (createDirs_)
-    , reopenDelay(1)
-    , bufferSize (0)
-    , buffer (nullptr)
-    , filename(filename_)
-    , localeName (LOG4CPLUS_TEXT ("DEFAULT"))
-    , fileOpenMode(mode_)
-{ }
+#endif
 
 
-FileAppenderBase::FileAppenderBase(const Properties& props,
-                                   std::ios_base::openmode mode_)
-    : Appender(props)
-    , immediateFlush(true)
-    , createDirs (false)
-    , reopenDelay(1)
-    , bufferSize (0)
-    , buffer (nullptr)
+//! Reserves <code>size</code> bytes of disk space for file
+//! <code>name</code> without changing its size.
+static
+void
+preallocate_file (tstring const & name, long size)
 {
-    filename = props.getProperty(LOG4CPLUS_TEXT("File"));
-    lockFileName = props.getProperty (LOG4CPLUS_TEXT ("LockFile"));
-    localeName = props.getProperty (LOG4CPLUS_TEXT ("Locale"), LOG4CPLUS_TEXT ("DEFAULT"));
+#if defined (LOG4CPLUS_HAVE_FALLOCATE) && defined (FALLOC_FL_KEEP_SIZE)
+    int const fd = open_for_allocation (name);
+    if (fd == -1)
+        return;
 
-    props.getBool (immediateFlush, LOG4CPLUS_TEXT("ImmediateFlush"));
-    props.getBool (createDirs, LOG4CPLUS_TEXT("CreateDirs"));
-    props.getInt (reopenDelay, LOG4CPLUS_TEXT("ReopenDelay"));
-    props.getULong (bufferSize, LOG4CPLUS_TEXT("BufferSize"));
+    if (::fallocate (fd, FALLOC_FL_KEEP_SIZE, 0, size) != 0)
+        helpers::getLogLog ().debug (
+            LOG4CPLUS_TEXT ("Failed to preallocate file ") + name
+            + LOG4CPLUS_TEXT ("; error ")
+            + helpers::convertIntegerToString (errno));
 
-    bool app = (mode_ & (std::ios_base::app | std::ios_base::ate)) != 0;
-    props.getBool (app, LOG4CPLUS_TEXT("Append"));
-    fileOpenMode = app ? std::ios::app : std::ios::trunc;
+    ::close (fd);
 
-    if (props.getProperty(LOG4CPLUS_TEXT("TextMode"), LOG4CPLUS_TEXT("Text"))
-        == LOG4CPLUS_TEXT("Binary"))
-        fileOpenMode |= std::ios_base::binary;
+#else
+    (void) name;
+    (void) size;
+
+#endif
 }
 
 
-void
-FileAppenderBase::init()
+//! Opens file <code>name</code> for syncing.
+//! \returns Descriptor or -1.
+static
+int
+open_for_sync (tstring const & name)
 {
-    if (useLockFile && lockFileName.empty ())
-    {
-        if (filename.empty())
-        {
-            getErrorHandler()->error(LOG4CPLUS_TEXT
-                ("UseLockFile is true but neither LockFile nor File are specified"));
-            return;
-        }
+#if defined (_WIN32)
+#  if defined (UNICODE)
+    return ::_wopen (name.c_str (), _O_WRONLY | _O_NOINHERIT);
+#  else
+    return ::_open (name.c_str (), _O_WRONLY | _O_NOINHERIT);
+#  endif
+#else
+    return ::open (LOG4CPLUS_TSTRING_TO_STRING (name).c_str (), O_WRONLY
+#if defined (O_CLOEXEC)
+        | O_CLOEXEC
+#endif
+        );
+#endif
+}
 
-        lockFileName = filename;
-        lockFileName += LOG4CPLUS_TEXT(".lock");
-    }
 
-    if (bufferSize != 0)
-    {
-        buffer.reset (new tchar[bufferSize]);
-        out.rdbuf ()->pubsetbuf (buffer.get (), bufferSize);
-    }
+//! Opens file <code>name</code> for appending by the emergency path.
+//! \returns Descriptor or -1.
+static
+int
+open_for_emergency (tstring const & name)
+{
+#if defined (_WIN32)
+#  if defined (UNICODE)
+    return ::_wopen (name.c_str (),
+        _O_WRONLY | _O_APPEND | _O_BINARY | _O_NOINHERIT);
+#  else
+    return ::_open (name.c_str (),
+        _O_WRONLY | _O_APPEND | _O_BINARY | _O_NOINHERIT);
+#  endif
+#else
+    return ::open (LOG4CPLUS_TSTRING_TO_STRING (name).c_str (),
+        O_WRONLY | O_APPEND
+#if defined (O_CLOEXEC)
+        | O_CLOEXEC
+#endif
+        );
+#endif
+}
 
-    helpers::LockFileGuard guard;
-    if (useLockFile && ! lockFile)
-    {
-        if (createDirs)
-            internal::make_dirs (lockFileName);
 
-        try
-        {
-            lockFile = std::make_unique<helpers::LockFile> (lockFileName);
-            guard.attach_and_lock (*lockFile);
-        }
-        catch (std::runtime_error const &)
-        {
-            // We do not need to do any logging here as the internals
-            // of LockFile already use LogLog to report the failure.
-            return;
-        }
-    }
+//! Forces written data of file <code>fd</code> to storage device.
+//! \returns Zero on success, error code otherwise.
+static
+int
+sync_file (int fd)
+{
+#if defined (_WIN32)
+    return ::_commit (fd) == 0 ? 0 : errno;
+#elif defined (_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+    return ::fdatasync (fd) == 0 ? 0 : errno;
+#else
+    return ::fsync (fd) == 0 ? 0 : errno;
+#endif
+}
 
-    open(fileOpenMode);
-    imbue (internal::get_locale_by_name (localeName));
+
+static
+int
+dup_sync_file (int fd)
+{
+#if defined (_WIN32)
+    return ::_dup (fd);
+#else
+    return ::fcntl (fd,
+#if defined (F_DUPFD_CLOEXEC)
+        F_DUPFD_CLOEXEC,
+#else
+        F_DUPFD,
+#endif
+        0);
+#endif
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// FileAppenderBase public methods
-///////////////////////////////////////////////////////////////////////////////
 
+static
 void
-FileAppenderBase::close()
+close_sync_file (int fd)
 {
-    thread::MutexGuard guard (access_mutex);
+#if defined (_WIN32)
+    ::_close (fd);
+#else
+    ::close (fd);
+#endif
+}
 
-    out.close();
-    buffer.reset ();
-    closed = true;
+
+static
+void
+loglog_sync_failure (tstring const & name, int err)
+{
+    helpers::getLogLog ().error (
+        LOG4CPLUS_TEXT ("Failed to sync file ") + name
+        + LOG4CPLUS_TEXT ("; error ")
+        + helpers::convertIntegerToString (err));
 }
 
 
-std::locale
-FileAppenderBase::imbue(std::locale const& loc)
+//! Releases disk space reserved by preallocate_file() beyond the end
+//! of file <code>name</code>.
+static
+void
+release_preallocation (tstring const & name, long reserved)
 {
-    return out.imbue (loc);
+#if defined (LOG4CPLUS_HAVE_FALLOCATE) && defined (FALLOC_FL_KEEP_SIZE)
+    int const fd = open_for_allocation (name);
+    if (fd == -1)
+        return;
+
+    // Truncating the file to its own size frees blocks reserved beyond
+    // its end.
+    off_t const size = ::lseek (fd, 0, SEEK_END);
+    if (size != -1 && size < reserved)
+        (void) ::ftruncate (fd, size);
+
+    ::close (fd);
+
+#else
+    (void) name;
+    (void) reserved;
+
+#endif
 }
 
 
-std::locale
-FileAppenderBase::getloc () const
+//! Size of chunks in which rolled over files are compressed.
+std::size_t const compression_chunk_size = 64 * 1024;
+
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+static
+bool
+gzip_file (std::ifstream & in, tstring const & target)
 {
-    return out.getloc ();
+#if defined (UNICODE) && defined (_WIN32)
+    gzFile gz = gzopen_w (target.c_str (), "wb");
+#else
+    gzFile gz = gzopen (LOG4CPLUS_TSTRING_TO_STRING (target).c_str (), "wb");
+#endif
+    if (! gz)
+        return false;
+
+    std::unique_ptr<char[]> buf (new char[compression_chunk_size]);
+    bool ok = true;
+    while (ok && in)
+    {
+        in.read (buf.get (), compression_chunk_size);
+        std::streamsize const size = in.gcount ();
+        if (size != 0
+            && gzwrite (gz, buf.get (), static_cast<unsigned> (size))
+                != static_cast<int> (size))
+            ok = false;
+    }
+
+    return gzclose (gz) == Z_OK && ok && in.eof ();
 }
 
+#endif
 
-///////////////////////////////////////////////////////////////////////////////
-// FileAppenderBase protected methods
-///////////////////////////////////////////////////////////////////////////////
 
-// This method does not need to be locked since it is called by
-// doAppend() which performs the locking
-void
-FileAppenderBase::append(const spi::InternalLoggingEvent& event)
+#if defined (LOG4CPLUS_WITH_ZSTD)
+static
+bool
+zstd_file (std::ifstream & in, tstring const & target)
 {
-    if(!out.good()) {
-        if(!reopen()) {
-            getErrorHandler()->error(  LOG4CPLUS_TEXT("file is not open: ")
-                                     + filename);
-            return;
+    std::ofstream out (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (target).c_str (),
+        std::ios_base::binary | std::ios_base::trunc);
+    if (! out)
+        return false;
+
+    std::unique_ptr<ZSTD_CCtx, std::size_t (*) (ZSTD_CCtx *)> cctx (
+        ZSTD_createCCtx (), &ZSTD_freeCCtx);
+    if (! cctx)
+        return false;
+
+    std::size_t const out_size = ZSTD_CStreamOutSize ();
+    std::unique_ptr<char[]> in_buf (new char[compression_chunk_size]);
+    std::unique_ptr<char[]> out_buf (new char[out_size]);
+    bool last = false;
+    while (! last)
+    {
+        in.read (in_buf.get (), compression_chunk_size);
+        if (in.bad ())
+            return false;
+
+        last = in.eof ();
+        ZSTD_EndDirective const mode = last ? ZSTD_e_end : ZSTD_e_continue;
+        ZSTD_inBuffer input = {in_buf.get (),
+            static_cast<std::size_t> (in.gcount ()), 0};
+        bool finished = false;
+        while (! finished)
+        {
+            ZSTD_outBuffer output = {out_buf.get (), out_size, 0};
+            std::size_t const remaining = ZSTD_compressStream2 (cctx.get (),
+                &output, &input, mode);
+            if (ZSTD_isError (remaining))
+                return false;
+
+            out.write (out_buf.get (),
+                static_cast<std::streamsize> (output.pos));
+            finished = last ? remaining == 0 : input.pos == input.size;
         }
-        // Resets the error handler to make it
-        // ready to handle a future append error.
-        else
-            getErrorHandler()->reset();
     }
 
-    if (useLockFile)
-        out.seekp (0, std::ios_base::end);
+    out.close ();
+    return ! out.fail ();
+}
 
-    layout->formatAndAppend(out, event);
+#endif
 
-    if(immediateFlush || useLockFile)
-        out.flush();
-}
 
+//! Compresses <code>src</code> into <code>target</code> and removes
+//! <code>src</code> when it succeeds.
+static
 void
-FileAppenderBase::open(std::ios_base::openmode mode)
+compress_file (tstring const & src, tstring const & target,
+    RolledFileCompression compression)
 {
-    if (createDirs)
-        internal::make_dirs (filename);
-
-    out.open(LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME(filename).c_str(), mode);
+    helpers::LogLog & loglog = helpers::getLogLog ();
 
-    if(!out.good()) {
-        getErrorHandler()->error(LOG4CPLUS_TEXT("Unable to open file: ") + filename);
+    std::ifstream in (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (src).c_str (),
+        std::ios_base::binary);
+    if (! in)
+    {
+        loglog.error (LOG4CPLUS_TEXT ("Failed to open file ") + src
+            + LOG4CPLUS_TEXT (" for compression"));
         return;
     }
-    helpers::getLogLog().debug(LOG4CPLUS_TEXT("Just opened file: ") + filename);
-}
 
-bool
-FileAppenderBase::reopen()
-{
-    // When append never failed and the file re-open attempt must
-    // be delayed, set the time when reopen should take place.
-    if (reopen_time == log4cplus::helpers::Time () && reopenDelay != 0)
-        reopen_time = log4cplus::helpers::now ()
-            + helpers::chrono::seconds (reopenDelay);
-    else
+    bool ok = false;
+    switch (compression)
     {
-        // Otherwise, check for end of the delay (or absence of delay)
-        // to re-open the file.
-        if (reopen_time <= log4cplus::helpers::now ()
-            || reopenDelay == 0)
-        {
-            // Close the current file
-            out.close();
-            // reset flags since the C++ standard specified that all
-            // the flags should remain unchanged on a close
-            out.clear();
+#if defined (LOG4CPLUS_WITH_ZLIB)
+    case GZIP_COMPRESSION:
+        ok = gzip_file (in, target);
+        break;
+#endif
 
-            // Re-open the file.
-            open(std::ios_base::out | std::ios_base::ate | std::ios_base::app);
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    case ZSTD_COMPRESSION:
+        ok = zstd_file (in, target);
+        break;
+#endif
 
-            // Reset last fail time.
-            reopen_time = log4cplus::helpers::Time ();
+    default:
+        break;
+    }
 
-            // Succeed if no errors are found.
-            if(out.good())
-                return true;
-        }
+    in.close ();
+    if (! ok)
+    {
+        loglog.error (LOG4CPLUS_TEXT ("Failed to compress file ") + src
+            + LOG4CPLUS_TEXT (" to ") + target);
+        file_remove (target);
+        return;
     }
-    return false;
+
+    loglog.debug (LOG4CPLUS_TEXT ("Compressed file ") + src
+        + LOG4CPLUS_TEXT (" to ") + target);
+    file_remove (src);
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// FileAppender ctors and dtor
-///////////////////////////////////////////////////////////////////////////////
 
-FileAppender::FileAppender(
-    const tstring& filename_,
+//! Shifts backups of <code>filename</code>, renames <code>source</code>
+//! to the first backup and compresses it.
+static
+void
+roll_backups (tstring const & filename, tstring const & source,
+    unsigned int maxBackupIndex, RolledFileCompression compression,
+    tstring const & compressedSuffix)
+{
+    helpers::LogLog & loglog = helpers::getLogLog ();
+
+    rolloverFiles (filename, maxBackupIndex, compressedSuffix);
+
+    // Rename source to fileName.1
+    tstring const target = filename + LOG4CPLUS_TEXT(".1");
+
+    long ret;
+
+#if defined (_WIN32)
+    // Try to remove the target first. It seems it is not
+    // possible to rename over existing file.
+    ret = file_remove (target);
+#endif
+
+    loglog.debug (
+        LOG4CPLUS_TEXT("Renaming file ")
+        + source
+        + LOG4CPLUS_TEXT(" to ")
+        + target);
+    ret = file_rename (source, target);
+    loglog_renaming_result (loglog, source, target, ret);
+
+    if (ret == 0 && compression != NO_COMPRESSION)
+        compress_file (target, target + compressedSuffix, compression);
+}
+
+
+//! Placeholder of process id in file names, see <tt>File</tt> property.
+tchar const shard_pid_token[] = LOG4CPLUS_TEXT ("%pid");
+
+
+//! Replaces <tt>%pid</tt> placeholders in <code>pattern</code> by
+//! <code>pid</code>.
+static
+tstring
+expand_shard_name (tstring const & pattern, unsigned long pid)
+{
+    tstring const id = helpers::convertIntegerToString (pid);
+    tstring::size_type const token_len = sizeof (shard_pid_token)
+        / sizeof (shard_pid_token[0]) - 1;
+
+    tstring name;
+    tstring::size_type pos = 0;
+    for (tstring::size_type found;
+        (found = pattern.find (shard_pid_token, pos)) != tstring::npos;
+        pos = found + token_len)
+    {
+        name.append (pattern, pos, found - pos);
+        name += id;
+    }
+    name.append (pattern, pos, tstring::npos);
+
+    return name;
+}
+
+
+//! Shifts files named after backups of <code>filename</code> with
+//! <code>suffix</code> appended, e.g., indices, and makes the one of
+//! <code>filename</code> the one of its first backup, see <tt>Index</tt>
+//! and <tt>BloomKeys</tt> properties of RollingFileAppender.
+static
+void
+roll_sidecar (tstring const & filename, unsigned int maxBackupIndex,
+    tstring const & suffix)
+{
+    helpers::LogLog & loglog = helpers::getLogLog ();
+    auto const index_name = [&] (int index)
+    {
+        return filename + LOG4CPLUS_TEXT(".")
+            + helpers::convertIntegerToString (index) + suffix;
+    };
+
+    long ret = file_remove (index_name (static_cast<int> (maxBackupIndex)));
+    for (int i = static_cast<int> (maxBackupIndex); i >= 1; --i)
+    {
+        tstring const source = i == 1
+            ? filename + suffix
+            : index_name (i - 1);
+        tstring const target = index_name (i);
+
+#if defined (_WIN32)
+        ret = file_remove (target);
+#endif
+
+        ret = file_rename (source, target);
+        loglog_renaming_result (loglog, source, target, ret);
+    }
+}
+
+} // namespace
+
+
+namespace internal
+{
+
+void
+roll_file_backups (tstring const & filename, unsigned int maxBackupIndex)
+{
+    roll_backups (filename, filename, maxBackupIndex, NO_COMPRESSION,
+        tstring ());
+}
+
+
+//! Runs background tasks of single appender one after another, in
+//! the order they have been submitted.
+struct background_file_tasks
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    //! Runs queued tasks until the queue is empty.
+    void
+    drain ()
+    {
+        for (;;)
+        {
+            std::function<void ()> task;
+            {
+                std::unique_lock<std::mutex> lock (mtx);
+                if (queue.empty ())
+                {
+                    running = false;
+                    cond.notify_all ();
+                    return;
+                }
+
+                task = std::move (queue.front ());
+                queue.pop_front ();
+            }
+
+            run (task);
+        }
+    }
+
+    std::mutex mtx;
+    std::condition_variable cond;
+    std::deque<std::function<void ()>> queue;
+    bool running = false;
+#endif
+
+    static
+    void
+    run (std::function<void ()> const & task)
+    {
+        try
+        {
+            task ();
+        }
+        catch (std::exception const & e)
+        {
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("Exception in file appender background task: ")
+                + LOG4CPLUS_C_STR_TO_TSTRING (e.what ()));
+        }
+    }
+};
+
+
+//! Progress of syncs of one file appender. Events are numbered by
+//! FileAppenderBase::appendedEvents.
+struct file_sync_state
+{
+    //! Records the end of sync of events up to <code>target</code>.
+    void
+    completed (std::uint64_t target, bool ok)
+    {
+        if (! ok)
+        {
+            failedAfter = (std::min) (synced, target);
+            failedThrough = target;
+        }
+
+        synced = (std::max) (synced, target);
+        syncing = false;
+    }
+
+    //! \returns <code>true</code> if event <code>event</code> is on
+    //! the device.
+    bool
+    durable (std::uint64_t event) const
+    {
+        return event <= synced
+            && ! (failedAfter < event && event <= failedThrough);
+    }
+
+    //! Blocks until event <code>event</code> is synced.
+    bool
+    wait (std::uint64_t event)
+    {
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        // The first waiter syncs the file for everybody. Waiters
+        // arriving during the sync wait for it and then, if their
+        // events have been written after the sync has started, one of
+        // them syncs again.
+        std::unique_lock<std::mutex> lock (mtx);
+        while (synced < event && syncFile)
+        {
+            if (syncing)
+            {
+                cond.wait (lock);
+                continue;
+            }
+
+            syncing = true;
+            lock.unlock ();
+
+            std::uint64_t target = 0;
+            bool ok = false;
+            try
+            {
+                ok = syncFile (target);
+            }
+            catch (...)
+            {
+                lock.lock ();
+                syncing = false;
+                cond.notify_all ();
+                throw;
+            }
+
+            lock.lock ();
+            completed (target, ok);
+            cond.notify_all ();
+        }
+
+#else
+        if (synced < event && syncFile)
+        {
+            std::uint64_t target = 0;
+            bool const ok = syncFile (target);
+            completed (target, ok);
+        }
+
+#endif
+
+        return durable (event);
+    }
+
+    //! Detaches the state from closed appender.
+    void
+    detach ()
+    {
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        std::unique_lock<std::mutex> lock (mtx);
+        cond.wait (lock, [this] { return ! syncing; });
+#endif
+        syncFile = nullptr;
+    }
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    std::mutex mtx;
+    std::condition_variable cond;
+#endif
+    //! Syncs the file of the appender, empty once it is closed.
+    std::function<bool (std::uint64_t &)> syncFile;
+    std::uint64_t synced = 0;
+    std::uint64_t failedAfter = 0;
+    std::uint64_t failedThrough = 0;
+    bool syncing = false;
+};
+
+
+//! File name pattern of TimeBasedRollingFileAppender, after
+//! preprocessing, compiled for finding archives by one listing of their
+//! directory and reading their times back from their names. It is
+//! usable only if the directory has no time fields and the file name
+//! has only numeric ones, including the year.
+struct filename_template
+{
+    explicit
+    filename_template (tstring const & pattern)
+    {
+#if defined (_WIN32)
+        tstring::size_type const slash
+            = pattern.find_last_of (LOG4CPLUS_TEXT ("/\\"));
+#else
+        tstring::size_type const slash
+            = pattern.find_last_of (LOG4CPLUS_TEXT ('/'));
+#endif
+        tstring::size_type const name_start
+            = slash == tstring::npos ? 0 : slash + 1;
+        directory.assign (pattern, 0, name_start);
+        if (directory.find (LOG4CPLUS_TEXT ('%')) != tstring::npos)
+            return;
+
+        bool has_year = false;
+        tstring literal;
+        for (tstring::size_type i = name_start; i != pattern.size (); ++i)
+        {
+            tchar const c = pattern[i];
+            if (c != LOG4CPLUS_TEXT ('%'))
+            {
+                literal += c;
+                continue;
+            }
+            else if (++i == pattern.size ())
+                return;
+
+            tchar const field = pattern[i];
+            int width;
+            switch (field)
+            {
+            case LOG4CPLUS_TEXT ('%'):
+                literal += field;
+                continue;
+
+            case LOG4CPLUS_TEXT ('Y'):
+                width = 4;
+                break;
+
+            case LOG4CPLUS_TEXT ('j'):
+                width = 3;
+                break;
+
+            case LOG4CPLUS_TEXT ('y'):
+            case LOG4CPLUS_TEXT ('m'):
+            case LOG4CPLUS_TEXT ('d'):
+            case LOG4CPLUS_TEXT ('H'):
+            case LOG4CPLUS_TEXT ('M'):
+            case LOG4CPLUS_TEXT ('S'):
+                width = 2;
+                break;
+
+            default:
+                return;
+            }
+
+            if (! literal.empty ())
+                parts.push_back (part {0, 0, std::move (literal)});
+            literal.clear ();
+            parts.push_back (part {field, width, tstring ()});
+            has_year = has_year || field == LOG4CPLUS_TEXT ('Y')
+                || field == LOG4CPLUS_TEXT ('y');
+        }
+
+        if (! literal.empty ())
+            parts.push_back (part {0, 0, std::move (literal)});
+        usable = has_year;
+    }
+
+    //! \return <code>true</code> and start of the period of the
+    //! archive in <code>time</code> if file <code>name</code>, without
+    //! directory, matches the template.
+    bool
+    match (tstring const & name, helpers::Time & time) const
+    {
+        tm t = tm ();
+        t.tm_mday = 1;
+        t.tm_isdst = -1;
+        int day_of_year = 0;
+        tstring::size_type pos = 0;
+        for (part const & p : parts)
+        {
+            if (! p.field)
+            {
+                if (name.compare (pos, p.literal.size (), p.literal) != 0)
+                    return false;
+
+                pos += p.literal.size ();
+                continue;
+            }
+
+            if (name.size () - pos < static_cast<std::size_t> (p.width))
+                return false;
+
+            int value = 0;
+            for (int k = 0; k != p.width; ++k, ++pos)
+            {
+                tchar const ch = name[pos];
+                if (ch < LOG4CPLUS_TEXT ('0') || ch > LOG4CPLUS_TEXT ('9'))
+                    return false;
+
+                value = value * 10 + (ch - LOG4CPLUS_TEXT ('0'));
+            }
+
+            switch (p.field)
+            {
+            case LOG4CPLUS_TEXT ('Y'): t.tm_year = value - 1900; break;
+            // POSIX strptime() convention.
+            case LOG4CPLUS_TEXT ('y'): t.tm_year = value < 69 ? value + 100 : value; break;
+            case LOG4CPLUS_TEXT ('m'): t.tm_mon = value - 1; break;
+            case LOG4CPLUS_TEXT ('d'): t.tm_mday = value; break;
+            case LOG4CPLUS_TEXT ('j'): day_of_year = value; break;
+            case LOG4CPLUS_TEXT ('H'): t.tm_hour = value; break;
+            case LOG4CPLUS_TEXT ('M'): t.tm_min = value; break;
+            case LOG4CPLUS_TEXT ('S'): t.tm_sec = value; break;
+            }
+        }
+
+        if (pos != name.size ())
+            return false;
+
+        // mktime() normalizes day of year given as day of January.
+        if (day_of_year != 0)
+        {
+            t.tm_mon = 0;
+            t.tm_mday = day_of_year;
+        }
+
+        try
+        {
+            time = helpers::from_struct_tm (&t);
+        }
+        catch (std::system_error const &)
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    //! Removes archives, together with their compressed variants and
+    //! indices, whose periods start at <code>cutoff</code> or before.
+    void
+    remove_expired (helpers::Time cutoff, tstring const & compressedSuffix,
+        bool useIndex) const
+    {
+        namespace fs = std::filesystem;
+        helpers::LogLog & loglog = helpers::getLogLog ();
+        tstring const index_suffix (LOG4CPLUS_TEXT (".idx"));
+        auto const strip_suffix = [] (tstring & name, tstring const & suffix)
+        {
+            if (suffix.empty () || name.size () <= suffix.size ()
+                || name.compare (name.size () - suffix.size (),
+                    suffix.size (), suffix) != 0)
+                return false;
+
+            name.resize (name.size () - suffix.size ());
+            return true;
+        };
+
+        std::error_code ec;
+        fs::directory_iterator it (directory.empty ()
+            ? fs::path (LOG4CPLUS_TEXT ("."))
+            : fs::path (directory), ec);
+        std::vector<tstring> expired;
+        for (; ! ec && it != fs::directory_iterator (); it.increment (ec))
+        {
+#if defined (UNICODE)
+            tstring const name = it->path ().filename ().wstring ();
+#else
+            tstring const name = it->path ().filename ().string ();
+#endif
+            tstring archive = name;
+            if (! strip_suffix (archive, compressedSuffix) && useIndex)
+                strip_suffix (archive, index_suffix);
+
+            helpers::Time time;
+            if (match (archive, time) && time <= cutoff)
+                expired.push_back (directory + name);
+        }
+
+        if (ec)
+            loglog.debug (LOG4CPLUS_TEXT ("Unable to list directory of ")
+                LOG4CPLUS_TEXT ("archives: ") + directory);
+
+        for (tstring const & filename : expired)
+        {
+            loglog.debug (LOG4CPLUS_TEXT ("Removing file ") + filename);
+            file_remove (filename);
+        }
+    }
+
+    struct part
+    {
+        //! Conversion character of numeric field, zero for literal.
+        tchar field;
+        //! Digits of numeric field.
+        int width;
+        tstring literal;
+    };
+
+    bool usable = false;
+    //! Directory of the archives, including the trailing separator.
+    tstring directory;
+    std::vector<part> parts;
+};
+
+} // namespace internal
+
+
+namespace
+{
+
+//! Sync state of appender with <tt>GroupCommit</tt> sync policy and
+//! the last event the thread has appended to it.
+struct durable_append
+{
+    std::shared_ptr<internal::file_sync_state> state;
+    std::uint64_t event;
+};
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+thread_local
+#endif
+std::vector<durable_append> durable_appends;
+
+
+void
+note_durable_append (std::shared_ptr<internal::file_sync_state> const & state,
+    std::uint64_t event)
+{
+    for (auto & rec : durable_appends)
+        if (rec.state == state)
+        {
+            rec.event = event;
+            return;
+        }
+
+    durable_appends.push_back (durable_append {state, event});
+}
+
+} // namespace
+
+
+bool
+waitForDurableLogging ()
+{
+    std::vector<durable_append> appends;
+    appends.swap (durable_appends);
+
+    bool ok = true;
+    for (auto const & rec : appends)
+        ok = rec.state->wait (rec.event) && ok;
+
+    return ok;
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+// from global-init.cxx
+void enqueueAsyncTask (std::function<void ()> task);
+
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FileAppenderBase ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+FileAppenderBase::FileAppenderBase(const tstring& filename_,
+    std::ios_base::openmode mode_, bool immediateFlush_, bool createDirs_)
+    : immediateFlush(immediateFlush_)
+    , createDirs (createDirs_)
+    , reopenDelay(1)
+    , bufferSize (0)
+    , buffer (nullptr)
+    , filename(filename_)
+    , localeName (LOG4CPLUS_TEXT ("DEFAULT"))
+    , utf8Encoding (false)
+    , fileOpenMode(mode_)
+    , deferFlush (false)
+    , flushBytes (0)
+    , flushInterval (0)
+    , unflushed (0)
+    , compression (NO_COMPRESSION)
+    , shardProcess (0)
+    , syncPolicy (SYNC_NONE)
+    , syncInterval (1000)
+    , appendedEvents (0)
+    , syncFd (-1)
+    , emergencyFd (-1)
+    , emergencyPrepared (false)
+    , useIndex (false)
+    , indexEvery (1)
+    , indexInterval (0)
+    , unindexed (0)
+    , flushTimerRegistered (false)
+    , syncTimerRegistered (false)
+{ }
+
+
+FileAppenderBase::FileAppenderBase(const Properties& props,
+                                   std::ios_base::openmode mode_)
+    : Appender(props)
+    , immediateFlush(true)
+    , createDirs (false)
+    , reopenDelay(1)
+    , bufferSize (0)
+    , buffer (nullptr)
+    , utf8Encoding (false)
+    , deferFlush (false)
+    , flushBytes (0)
+    , flushInterval (0)
+    , unflushed (0)
+    , compression (NO_COMPRESSION)
+    , shardProcess (0)
+    , syncPolicy (SYNC_NONE)
+    , syncInterval (1000)
+    , appendedEvents (0)
+    , syncFd (-1)
+    , emergencyFd (-1)
+    , emergencyPrepared (false)
+    , useIndex (false)
+    , indexEvery (1)
+    , indexInterval (0)
+    , unindexed (0)
+    , flushTimerRegistered (false)
+    , syncTimerRegistered (false)
+{
+    filename = props.getProperty(LOG4CPLUS_TEXT("File"));
+    lockFileName = props.getProperty (LOG4CPLUS_TEXT ("LockFile"));
+    localeName = props.getProperty (LOG4CPLUS_TEXT ("Locale"), LOG4CPLUS_TEXT ("DEFAULT"));
+
+    props.getBool (immediateFlush, LOG4CPLUS_TEXT("ImmediateFlush"));
+    props.getBool (createDirs, LOG4CPLUS_TEXT("CreateDirs"));
+    props.getInt (reopenDelay, LOG4CPLUS_TEXT("ReopenDelay"));
+    props.getULong (bufferSize, LOG4CPLUS_TEXT("BufferSize"));
+    props.getULong (flushBytes, LOG4CPLUS_TEXT("FlushBytes"));
+    props.getULong (flushInterval, LOG4CPLUS_TEXT("FlushIntervalMs"));
+
+    tstring const encoding = helpers::toLower (
+        props.getProperty (LOG4CPLUS_TEXT ("Encoding")));
+    if (encoding == LOG4CPLUS_TEXT ("utf-8")
+        || encoding == LOG4CPLUS_TEXT ("utf8"))
+        utf8Encoding = true;
+    else if (! encoding.empty ()
+        && encoding != LOG4CPLUS_TEXT ("locale"))
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("Unknown Encoding property value: ") + encoding);
+
+    tstring const syncPolicyName = helpers::toLower (
+        props.getProperty (LOG4CPLUS_TEXT ("SyncPolicy")));
+    if (syncPolicyName == LOG4CPLUS_TEXT ("interval"))
+        syncPolicy = SYNC_INTERVAL;
+    else if (syncPolicyName == LOG4CPLUS_TEXT ("groupcommit"))
+        syncPolicy = SYNC_GROUP_COMMIT;
+    else if (! syncPolicyName.empty ()
+        && syncPolicyName != LOG4CPLUS_TEXT ("none"))
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("Unknown SyncPolicy property value: ")
+            + syncPolicyName);
+    props.getULong (syncInterval, LOG4CPLUS_TEXT ("SyncIntervalMs"));
+
+    tstring const compressionName = helpers::toLower (
+        props.getProperty (LOG4CPLUS_TEXT ("Compression")));
+    if (compressionName == LOG4CPLUS_TEXT ("gzip"))
+        setCompression (GZIP_COMPRESSION);
+    else if (compressionName == LOG4CPLUS_TEXT ("zstd"))
+        setCompression (ZSTD_COMPRESSION);
+    else if (! compressionName.empty ()
+        && compressionName != LOG4CPLUS_TEXT ("none"))
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("Unknown Compression property value: ")
+            + compressionName);
+
+    bool app = (mode_ & (std::ios_base::app | std::ios_base::ate)) != 0;
+    props.getBool (app, LOG4CPLUS_TEXT("Append"));
+    fileOpenMode = app ? std::ios::app : std::ios::trunc;
+
+    if (props.getProperty(LOG4CPLUS_TEXT("TextMode"), LOG4CPLUS_TEXT("Text"))
+        == LOG4CPLUS_TEXT("Binary"))
+        fileOpenMode |= std::ios_base::binary;
+}
+
+
+void
+FileAppenderBase::init()
+{
+    if (shardPattern.empty ()
+        && filename.find (shard_pid_token) != tstring::npos)
+    {
+        shardPattern = filename;
+        shardProcess = static_cast<unsigned long> (
+            internal::get_process_id ());
+        filename = expand_shard_name (shardPattern, shardProcess);
+    }
+
+    if (useLockFile && lockFileName.empty ())
+    {
+        if (filename.empty())
+        {
+            getErrorHandler()->error(LOG4CPLUS_TEXT
+                ("UseLockFile is true but neither LockFile nor File are specified"));
+            return;
+        }
+
+        lockFileName = filename;
+        lockFileName += LOG4CPLUS_TEXT(".lock");
+    }
+
+    // Let the stream buffer hold everything up to the flush threshold
+    // so that the writes are combined.
+    if (bufferSize == 0 && flushBytes != 0)
+        bufferSize = flushBytes;
+
+    if (bufferSize != 0)
+    {
+        buffer.reset (new tchar[bufferSize]);
+        out.rdbuf ()->pubsetbuf (buffer.get (), bufferSize);
+    }
+
+    if (syncPolicy != SYNC_NONE && ! syncState)
+    {
+        syncState = std::make_shared<internal::file_sync_state> ();
+        syncState->syncFile
+            = [this] (std::uint64_t & target) { return syncFile (target); };
+    }
+
+    helpers::LockFileGuard guard;
+    if (useLockFile && ! lockFile)
+    {
+        if (createDirs)
+            internal::make_dirs (lockFileName);
+
+        try
+        {
+            lockFile = std::make_unique<helpers::LockFile> (lockFileName);
+            guard.attach_and_lock (*lockFile);
+        }
+        catch (std::runtime_error const &)
+        {
+            // We do not need to do any logging here as the internals
+            // of LockFile already use LogLog to report the failure.
+            return;
+        }
+    }
+
+    open(fileOpenMode);
+    imbue (internal::get_locale_by_name (localeName));
+    lastFlush = helpers::now ();
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+    lastSync = lastFlush;
+#endif
+    updateFlushTimer ();
+    updateSyncTimer ();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// FileAppenderBase public methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+FileAppenderBase::close()
+{
+    waitForBackgroundTasks ();
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // This has to be done before locking access_mutex; the timer thread
+    // locks it while holding its own mutex.
+    if (flushTimerRegistered)
+    {
+        internal::remove_timer (this);
+        flushTimerRegistered = false;
+    }
+
+    if (syncTimerRegistered)
+    {
+        internal::remove_timer (syncState.get ());
+        syncTimerRegistered = false;
+    }
+#endif
+
+    if (syncState && ! closed)
+    {
+        sync ();
+        syncState->detach ();
+    }
+
+    thread::MutexGuard guard (access_mutex);
+
+    out.close();
+    indexOut.close ();
+    buffer.reset ();
+    if (syncFd != -1)
+    {
+        close_sync_file (syncFd);
+        syncFd = -1;
+    }
+    int const fd = emergencyFd.exchange (-1);
+    if (fd != -1)
+        close_sync_file (fd);
+    closed = true;
+}
+
+
+std::locale
+FileAppenderBase::imbue(std::locale const& loc)
+{
+    return out.imbue (utf8Encoding ? internal::with_utf8_codecvt (loc) : loc);
+}
+
+
+std::locale
+FileAppenderBase::getloc () const
+{
+    return out.getloc ();
+}
+
+
+void
+FileAppenderBase::setFlushPolicy (unsigned long bytes,
+    unsigned long intervalMs)
+{
+    {
+        thread::MutexGuard guard (access_mutex);
+        flushNow ();
+        flushBytes = bytes;
+        flushInterval = intervalMs;
+    }
+
+    updateFlushTimer ();
+}
+
+
+bool
+FileAppenderBase::sync ()
+{
+    std::uint64_t event;
+    {
+        thread::MutexGuard guard (access_mutex);
+        event = appendedEvents;
+    }
+
+    return waitForSync (event);
+}
+
+
+bool
+FileAppenderBase::waitForSync (std::uint64_t event)
+{
+    return syncState && syncState->wait (event);
+}
+
+
+void
+FileAppenderBase::setCompression (RolledFileCompression compression_)
+{
+    switch (compression_)
+    {
+#if ! defined (LOG4CPLUS_WITH_ZLIB)
+    case GZIP_COMPRESSION:
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("gzip compression is not available"));
+        compression_ = NO_COMPRESSION;
+        break;
+#endif
+
+#if ! defined (LOG4CPLUS_WITH_ZSTD)
+    case ZSTD_COMPRESSION:
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("zstd compression is not available"));
+        compression_ = NO_COMPRESSION;
+        break;
+#endif
+
+    default:
+        break;
+    }
+
+    thread::MutexGuard guard (access_mutex);
+    compression = compression_;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FileAppenderBase protected methods
+///////////////////////////////////////////////////////////////////////////////
+
+tstring
+FileAppenderBase::getCompressedFilename (const tstring& file) const
+{
+    switch (compression)
+    {
+    case GZIP_COMPRESSION:
+        return file + LOG4CPLUS_TEXT (".gz");
+
+    case ZSTD_COMPRESSION:
+        return file + LOG4CPLUS_TEXT (".zst");
+
+    default:
+        return file;
+    }
+}
+
+
+void
+FileAppenderBase::runInBackground (std::function<void ()> task)
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+    if (! backgroundTasks)
+        backgroundTasks = std::make_shared<internal::background_file_tasks> ();
+
+    auto const state = backgroundTasks;
+    {
+        std::unique_lock<std::mutex> lock (state->mtx);
+        state->queue.push_back (std::move (task));
+        if (state->running)
+            return;
+
+        state->running = true;
+    }
+
+    try
+    {
+        enqueueAsyncTask ([state] { state->drain (); });
+    }
+    catch (std::exception const &)
+    {
+        // The thread pool is not usable; run the tasks here.
+        state->drain ();
+    }
+
+#else
+    internal::background_file_tasks::run (task);
+
+#endif
+}
+
+
+void
+FileAppenderBase::waitForBackgroundTasks ()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (! backgroundTasks)
+        return;
+
+    auto const & state = *backgroundTasks;
+    std::unique_lock<std::mutex> lock (backgroundTasks->mtx);
+    backgroundTasks->cond.wait (lock,
+        [&state] { return ! state.running && state.queue.empty (); });
+#endif
+}
+
+
+// This method does not need to be locked since it is called by
+// doAppend() which performs the locking
+void
+FileAppenderBase::append(const spi::InternalLoggingEvent& event)
+{
+    switchShard ();
+    appendFormatted (formatEvent (event));
+}
+
+
+bool
+FileAppenderBase::switchShard ()
+{
+    if (shardPattern.empty ())
+        return false;
+
+    unsigned long const pid
+        = static_cast<unsigned long> (internal::get_process_id ());
+    if (pid == shardProcess)
+        return false;
+
+    // The stream is inherited from the parent process. Leave its file
+    // to the parent.
+    out.close ();
+    out.clear ();
+
+    shardProcess = pid;
+    filename = expand_shard_name (shardPattern, shardProcess);
+    open (fileOpenMode);
+    return true;
+}
+
+
+bool
+FileAppenderBase::appendFormatted (const tstring& str)
+{
+    if(!out.good()) {
+        if(!reopen()) {
+            getErrorHandler()->error(  LOG4CPLUS_TEXT("file is not open: ")
+                                     + filename);
+            return false;
+        }
+        // Resets the error handler to make it
+        // ready to handle a future append error.
+        else
+            getErrorHandler()->reset();
+    }
+
+    if (useLockFile)
+        out.seekp (0, std::ios_base::end);
+
+    out.write (str.data (), static_cast<std::streamsize> (str.size ()));
+
+    if (hasFlushPolicy ())
+        flushAfterWrite (str.size ());
+    else if((immediateFlush || useLockFile) && ! deferFlush)
+        out.flush();
+
+    if (syncPolicy != SYNC_NONE)
+    {
+        ++appendedEvents;
+        if (syncPolicy == SYNC_GROUP_COMMIT)
+            note_durable_append (syncState, appendedEvents);
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+        // Without timer thread the interval is checked when writing.
+        else if (syncInterval != 0
+            && helpers::now () - lastSync
+                >= helpers::chrono::milliseconds (syncInterval))
+        {
+            lastSync = helpers::now ();
+            sync ();
+        }
+#endif
+    }
+
+    return true;
+}
+
+
+void
+FileAppenderBase::flushAfterWrite (std::size_t written)
+{
+    unflushed += written;
+    if (deferFlush)
+        return;
+
+    if (useLockFile
+        || (flushBytes != 0 && unflushed >= flushBytes))
+        flushNow ();
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+    // Without timer thread the interval is checked when writing.
+    else if (flushInterval != 0
+        && helpers::now () - lastFlush
+            >= helpers::chrono::milliseconds (flushInterval))
+        flushNow ();
+#endif
+}
+
+
+void
+FileAppenderBase::flushNow ()
+{
+    if (unflushed == 0)
+        return;
+
+    out.flush ();
+    unflushed = 0;
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+    lastFlush = helpers::now ();
+#endif
+}
+
+
+void
+FileAppenderBase::timedFlush ()
+{
+    thread::MutexGuard guard (access_mutex);
+    flushNow ();
+}
+
+
+bool
+FileAppenderBase::syncFile (std::uint64_t & target)
+{
+    int fd = -1;
+    tstring syncName;
+    {
+        thread::MutexGuard guard (access_mutex);
+        out.flush ();
+        unflushed = 0;
+        target = appendedEvents;
+        if (syncFd != -1)
+        {
+            // The descriptor is duplicated so that the file can be
+            // closed by rollover while it is being synced.
+            fd = dup_sync_file (syncFd);
+            syncName = filename;
+        }
+    }
+
+    if (fd == -1)
+        return false;
+
+    int const err = sync_file (fd);
+    close_sync_file (fd);
+    if (err != 0)
+    {
+        loglog_sync_failure (syncName, err);
+        return false;
+    }
+
+    return true;
+}
+
+
+void
+FileAppenderBase::openEmergencyFile ()
+{
+    if (! emergencyPrepared)
+        return;
+
+    int const fd = open_for_emergency (filename);
+    if (fd == -1)
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("Unable to open file for emergency writes: ")
+            + filename);
+
+    // The descriptor is swapped, not closed first, so that a concurrent
+    // emergencyWrite() does not write into a reused descriptor. A write
+    // racing with the close of the old one goes to the previous file.
+    int const old = emergencyFd.exchange (fd);
+    if (old != -1)
+        close_sync_file (old);
+}
+
+
+void
+FileAppenderBase::prepareEmergency ()
+{
+    thread::MutexGuard guard (access_mutex);
+    if (closed || emergencyPrepared)
+        return;
+
+    emergencyPrepared = true;
+    openEmergencyFile ();
+}
+
+
+bool
+FileAppenderBase::emergencyWrite (const char * data, std::size_t size)
+    noexcept
+{
+    int const fd = emergencyFd.load ();
+    if (fd == -1)
+        return false;
+
+    while (size != 0)
+    {
+#if defined (_WIN32)
+        int const ret = ::_write (fd, data, static_cast<unsigned> (size));
+#else
+        ssize_t const ret = ::write (fd, data, size);
+        if (ret == -1 && errno == EINTR)
+            continue;
+#endif
+        if (ret <= 0)
+            return false;
+
+        data += ret;
+        size -= static_cast<std::size_t> (ret);
+    }
+
+    return true;
+}
+
+
+void
+FileAppenderBase::openSyncFile ()
+{
+    openEmergencyFile ();
+
+    if (syncPolicy == SYNC_NONE)
+        return;
+
+    if (syncFd != -1)
+    {
+        // Events written into the previous file, e.g., before
+        // rollover, have to be on the device before later syncs
+        // report them as synced.
+        int const err = sync_file (syncFd);
+        close_sync_file (syncFd);
+        syncFd = -1;
+        if (err != 0)
+        {
+            loglog_sync_failure (filename, err);
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+            std::unique_lock<std::mutex> lock (syncState->mtx);
+#endif
+            syncState->failedAfter = syncState->synced;
+            syncState->failedThrough = appendedEvents;
+        }
+    }
+
+    syncFd = open_for_sync (filename);
+    if (syncFd == -1)
+        loglog_sync_failure (filename, errno);
+}
+
+
+void
+FileAppenderBase::initIndex (const Properties& properties)
+{
+    properties.getBool (useIndex, LOG4CPLUS_TEXT ("Index"));
+    properties.getULong (indexInterval, LOG4CPLUS_TEXT ("IndexIntervalMs"));
+    if (indexInterval != 0)
+        indexEvery = 0;
+    properties.getULong (indexEvery, LOG4CPLUS_TEXT ("IndexEvery"));
+}
+
+
+void
+FileAppenderBase::openIndex (bool truncate)
+{
+    indexOut.close ();
+    indexOut.clear ();
+    unindexed = 0;
+    lastIndexTime = Time ();
+
+    tstring const indexName = filename + LOG4CPLUS_TEXT (".idx");
+    indexOut.open (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (indexName).c_str (),
+        std::ios_base::out | std::ios_base::binary
+        | (truncate ? std::ios_base::trunc : std::ios_base::app));
+    if (! indexOut)
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("Failed to open index file ") + indexName);
+}
+
+
+bool
+FileAppenderBase::indexDue (Time const & time)
+{
+    ++unindexed;
+    return lastIndexTime == Time ()
+        || (indexEvery != 0 && unindexed >= indexEvery)
+        || (indexInterval != 0 && time - lastIndexTime
+            >= std::chrono::milliseconds (indexInterval));
+}
+
+
+void
+FileAppenderBase::writeIndex (Time const & time, long long offset)
+{
+    unindexed = 0;
+    lastIndexTime = time;
+
+
+    std::uint64_t const fields[2] = {
+        static_cast<std::uint64_t> (
+            std::chrono::duration_cast<std::chrono::microseconds> (
+                time.time_since_epoch ()).count ()),
+        static_cast<std::uint64_t> (offset) };
+
+    char entry[16];
+    for (std::size_t i = 0; i != 16; ++i)
+        entry[i] = static_cast<char> (fields[i / 8] >> (i % 8 * 8));
+    indexOut.write (entry, sizeof (entry));
+
+    // Keep the index as current as the file.
+    if (! hasFlushPolicy () && (immediateFlush || useLockFile)
+        && ! deferFlush)
+        indexOut.flush ();
+}
+
+
+
+
+void
+FileAppenderBase::updateSyncTimer ()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (syncTimerRegistered)
+    {
+        internal::remove_timer (syncState.get ());
+        syncTimerRegistered = false;
+    }
+
+    if (syncPolicy == SYNC_INTERVAL && syncInterval != 0)
+    {
+        internal::add_timer (syncState.get (),
+            std::chrono::milliseconds (syncInterval),
+            [this] { sync (); });
+        syncTimerRegistered = true;
+    }
+#endif
+}
+
+
+void
+FileAppenderBase::updateFlushTimer ()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (flushTimerRegistered)
+    {
+        internal::remove_timer (this);
+        flushTimerRegistered = false;
+    }
+
+    if (flushInterval != 0)
+    {
+        internal::add_timer (this,
+            std::chrono::milliseconds (flushInterval),
+            [this] { timedFlush (); });
+        flushTimerRegistered = true;
+    }
+#endif
+}
+
+
+// This method does not need to be locked since it is called by
+// syncDoAppendBatch() which performs the locking
+void
+FileAppenderBase::appendBatch(
+    std::span<spi::InternalLoggingEvent const> events)
+{
+    struct defer_flush_guard
+    {
+        bool & flag;
+
+        explicit defer_flush_guard (bool & f)
+            : flag (f)
+        {
+            flag = true;
+        }
+
+        ~defer_flush_guard ()
+        {
+            flag = false;
+        }
+    };
+
+    {
+        defer_flush_guard guard (deferFlush);
+
+        // Derived appenders' append() is used for each event so that
+        // their rollover logic is applied.
+        for (auto const & event : events)
+            append(event);
+    }
+
+    if (hasFlushPolicy ())
+        flushAfterWrite (0);
+    else if(immediateFlush || useLockFile)
+        out.flush();
+}
+
+void
+FileAppenderBase::open(std::ios_base::openmode mode)
+{
+    if (createDirs)
+        internal::make_dirs (filename);
+
+    out.open(LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME(filename).c_str(), mode);
+
+    if(!out.good()) {
+        getErrorHandler()->error(LOG4CPLUS_TEXT("Unable to open file: ") + filename);
+        return;
+    }
+    helpers::getLogLog().debug(LOG4CPLUS_TEXT("Just opened file: ") + filename);
+    openSyncFile ();
+}
+
+bool
+FileAppenderBase::reopen()
+{
+    // When append never failed and the file re-open attempt must
+    // be delayed, set the time when reopen should take place.
+    if (reopen_time == log4cplus::helpers::Time () && reopenDelay != 0)
+        reopen_time = log4cplus::helpers::now ()
+            + helpers::chrono::seconds (reopenDelay);
+    else
+    {
+        // Otherwise, check for end of the delay (or absence of delay)
+        // to re-open the file.
+        if (reopen_time <= log4cplus::helpers::now ()
+            || reopenDelay == 0)
+        {
+            // Close the current file
+            out.close();
+            // reset flags since the C++ standard specified that all
+            // the flags should remain unchanged on a close
+            out.clear();
+
+            // Re-open the file.
+            open(std::ios_base::out | std::ios_base::ate | std::ios_base::app);
+
+            // Reset last fail time.
+            reopen_time = log4cplus::helpers::Time ();
+
+            // Succeed if no errors are found.
+            if(out.good())
+                return true;
+        }
+    }
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// FileAppender ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+FileAppender::FileAppender(
+    const tstring& filename_,
     std::ios_base::openmode mode_,
     bool immediateFlush_,
     bool createDirs_)
@@ -443,6 +1984,10 @@ RollingFileAppender::RollingFileAppender(const tstring& filename_,
     long maxFileSize_, int maxBackupIndex_, bool immediateFlush_,
     bool createDirs_)
     : FileAppender(filename_, std::ios_base::app, immediateFlush_, createDirs_)
+    , preallocate (false)
+    , bloomExpectedValues (100000)
+    , bloomFalsePositiveRate (0.01)
+    , bloomComplete (false)
 {
     init(maxFileSize_, maxBackupIndex_);
 }
@@ -450,6 +1995,10 @@ RollingFileAppender::RollingFileAppender(const tstring& filename_,
 
 RollingFileAppender::RollingFileAppender(const Properties& properties)
     : FileAppender(properties, std::ios_base::app)
+    , preallocate (false)
+    , bloomExpectedValues (100000)
+    , bloomFalsePositiveRate (0.01)
+    , bloomComplete (false)
 {
     long tmpMaxFileSize = DEFAULT_ROLLING_LOG_SIZE;
     int tmpMaxBackupIndex = 1;
@@ -458,72 +2007,258 @@ RollingFileAppender::RollingFileAppender(const Properties& properties)
             properties.getProperty (LOG4CPLUS_TEXT ("MaxFileSize"))));
     if (! tmp.empty ())
     {
-        tmpMaxFileSize = std::atoi(LOG4CPLUS_TSTRING_TO_STRING(tmp).c_str());
-        if (tmpMaxFileSize != 0)
+        tmpMaxFileSize = std::atoi(LOG4CPLUS_TSTRING_TO_STRING(tmp).c_str());
+        if (tmpMaxFileSize != 0)
+        {
+            tstring::size_type const len = tmp.length();
+            if (len > 2
+                && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT("MB")) == 0)
+                tmpMaxFileSize *= (1024 * 1024); // convert to megabytes
+            else if (len > 2
+                && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT("KB")) == 0)
+                tmpMaxFileSize *= 1024; // convert to kilobytes
+        }
+    }
+
+    properties.getInt (tmpMaxBackupIndex, LOG4CPLUS_TEXT("MaxBackupIndex"));
+    properties.getBool (preallocate, LOG4CPLUS_TEXT("Preallocate"));
+    initIndex (properties);
+    initBloomFilter (properties);
+
+    init(tmpMaxFileSize, tmpMaxBackupIndex);
+}
+
+
+void
+RollingFileAppender::initBloomFilter(const Properties& properties)
+{
+    helpers::LogLog & loglog = helpers::getLogLog ();
+
+    helpers::tokenize (properties.getProperty (LOG4CPLUS_TEXT ("BloomKeys")),
+        LOG4CPLUS_TEXT (','), std::back_inserter (bloomKeys));
+    bloomKeys.erase (std::remove (bloomKeys.begin (), bloomKeys.end (),
+            internal::empty_str),
+        bloomKeys.end ());
+    if (bloomKeys.empty ())
+        return;
+
+    // Other processes append events the filter would not know about.
+    if (useLockFile)
+    {
+        loglog.warn (
+            LOG4CPLUS_TEXT ("RollingFileAppender: BloomKeys property is not")
+            LOG4CPLUS_TEXT (" supported with UseLockFile"));
+        bloomKeys.clear ();
+        return;
+    }
+
+    properties.getULong (bloomExpectedValues,
+        LOG4CPLUS_TEXT ("BloomExpectedValues"));
+
+    tstring const & rateStr = properties.getProperty (
+        LOG4CPLUS_TEXT ("BloomFalsePositiveRate"));
+    if (! rateStr.empty ())
+    {
+        std::istringstream iss (LOG4CPLUS_TSTRING_TO_STRING (rateStr));
+        iss.imbue (std::locale::classic ());
+        double rate = 0;
+        if (! (iss >> rate) || rate <= 0 || rate >= 1)
+            loglog.error (
+                LOG4CPLUS_TEXT ("RollingFileAppender: BloomFalsePositiveRate")
+                LOG4CPLUS_TEXT (" is not a number between 0 and 1: ")
+                + rateStr);
+        else
+            bloomFalsePositiveRate = rate;
+    }
+}
+
+
+void
+RollingFileAppender::init(long maxFileSize_, int maxBackupIndex_)
+{
+    if (maxFileSize_ < MINIMUM_ROLLING_LOG_SIZE)
+    {
+        tostringstream oss;
+        oss << LOG4CPLUS_TEXT ("RollingFileAppender: MaxFileSize property")
+            LOG4CPLUS_TEXT (" value is too small. Resetting to ")
+            << MINIMUM_ROLLING_LOG_SIZE << ".";
+        helpers::getLogLog ().warn (oss.str ());
+        maxFileSize_ = MINIMUM_ROLLING_LOG_SIZE;
+    }
+
+    maxFileSize = maxFileSize_;
+    maxBackupIndex = (std::max)(maxBackupIndex_, 1);
+    rolloverSerial = 0;
+    fileOpened ();
+}
+
+
+RollingFileAppender::~RollingFileAppender()
+{
+    destructorImpl();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RollingFileAppender protected methods
+///////////////////////////////////////////////////////////////////////////////
+
+// This method does not need to be locked since it is called by
+// doAppend() which performs the locking
+void
+RollingFileAppender::append(const spi::InternalLoggingEvent& event)
+{
+    if (switchShard ())
+        fileOpened ();
+
+    if (useLockFile)
+    {
+        // Other processes write into the file as well. Learn its size
+        // from the end of the file.
+        std::streampos const end = out.rdbuf ()->pubseekoff (0,
+            std::ios_base::end, std::ios_base::out);
+        if (end != std::streampos (-1))
+            fileSize = static_cast<long> (std::streamoff (end));
+    }
+
+    // Rotate log file if needed before appending to it.
+    if (fileSize > maxFileSize)
+        rollover(true);
+
+    // Index needs offset in bytes; the tracked size is in characters.
+    bool const indexed = useIndex && indexDue (event.getTimestamp ());
+    long long offset = fileSize;
+    if (indexed && ! useLockFile)
+    {
+        std::streampos const pos = out.tellp ();
+        if (pos != std::streampos (-1))
+            offset = std::streamoff (pos);
+    }
+
+    tstring const & str = formatEvent (event);
+    if (appendFormatted (str))
+    {
+        fileSize += static_cast<long> (str.size ());
+        if (indexed)
+            writeIndex (event.getTimestamp (), offset);
+        addBloomValues (event);
+    }
+
+    // Rotate log file if needed after appending to it.
+    if (fileSize > maxFileSize)
+        rollover(true);
+}
+
+
+void
+RollingFileAppender::close()
+{
+    FileAppender::close ();
+    {
+        thread::MutexGuard guard (access_mutex);
+        saveBloomFilter ();
+    }
+
+    if (! preallocate)
+        return;
+
+    // Other processes might be appending; truncation must not race
+    // with them.
+    helpers::LockFileGuard guard;
+    if (useLockFile && lockFile)
+    {
+        try
         {
-            tstring::size_type const len = tmp.length();
-            if (len > 2
-                && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT("MB")) == 0)
-                tmpMaxFileSize *= (1024 * 1024); // convert to megabytes
-            else if (len > 2
-                && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT("KB")) == 0)
-                tmpMaxFileSize *= 1024; // convert to kilobytes
+            guard.attach_and_lock (*lockFile);
+        }
+        catch (std::runtime_error const &)
+        {
+            return;
         }
     }
 
-    properties.getInt (tmpMaxBackupIndex, LOG4CPLUS_TEXT("MaxBackupIndex"));
+    release_preallocation (filename, maxFileSize);
+}
 
-    init(tmpMaxFileSize, tmpMaxBackupIndex);
+
+void
+RollingFileAppender::fileOpened()
+{
+    updateFileInfo ();
+    if (preallocate && fileSize < maxFileSize)
+        preallocate_file (filename, maxFileSize);
+    if (useIndex)
+        openIndex (fileSize == 0);
+    openBloomFilter ();
 }
 
 
 void
-RollingFileAppender::init(long maxFileSize_, int maxBackupIndex_)
+RollingFileAppender::openBloomFilter()
 {
-    if (maxFileSize_ < MINIMUM_ROLLING_LOG_SIZE)
-    {
-        tostringstream oss;
-        oss << LOG4CPLUS_TEXT ("RollingFileAppender: MaxFileSize property")
-            LOG4CPLUS_TEXT (" value is too small. Resetting to ")
-            << MINIMUM_ROLLING_LOG_SIZE << ".";
-        helpers::getLogLog ().warn (oss.str ());
-        maxFileSize_ = MINIMUM_ROLLING_LOG_SIZE;
-    }
+    if (bloomKeys.empty ())
+        return;
 
-    maxFileSize = maxFileSize_;
-    maxBackupIndex = (std::max)(maxBackupIndex_, 1);
+    tstring const bloomName = filename + LOG4CPLUS_TEXT (".bloom");
+    bloomFilter = helpers::BloomFilter (bloomExpectedValues,
+        bloomFalsePositiveRate);
+    bloomComplete = fileSize == 0 || bloomFilter.load (bloomName);
+    if (! bloomComplete)
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("RollingFileAppender: No Bloom filter for ")
+            + filename + LOG4CPLUS_TEXT ("; it will not get one"));
+
+    // Filter left next to the file would miss events appended from now
+    // on if the process did not write it again.
+    file_remove (bloomName);
 }
 
 
-RollingFileAppender::~RollingFileAppender()
+void
+RollingFileAppender::addBloomValues(const spi::InternalLoggingEvent& event)
 {
-    destructorImpl();
+    for (tstring const & key : bloomKeys)
+    {
+        tstring const & value = event.getMDC (key);
+        if (! value.empty ())
+            bloomFilter.add (key, value);
+    }
 }
 
 
-///////////////////////////////////////////////////////////////////////////////
-// RollingFileAppender protected methods
-///////////////////////////////////////////////////////////////////////////////
-
-// This method does not need to be locked since it is called by
-// doAppend() which performs the locking
 void
-RollingFileAppender::append(const spi::InternalLoggingEvent& event)
+RollingFileAppender::saveBloomFilter()
 {
-    // Seek to the end of log file so that tellp() below returns the
-    // right size.
-    if (useLockFile)
-        out.seekp (0, std::ios_base::end);
+    if (! bloomComplete)
+        return;
 
-    // Rotate log file if needed before appending to it.
-    if (out.tellp() > maxFileSize)
-        rollover(true);
+    bloomComplete = false;
+    tstring const bloomName = filename + LOG4CPLUS_TEXT (".bloom");
+    if (! bloomFilter.save (bloomName))
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("RollingFileAppender: Unable to write ")
+            + bloomName);
+}
 
-    FileAppender::append(event);
 
-    // Rotate log file if needed after appending to it.
-    if (out.tellp() > maxFileSize)
-        rollover(true);
+unsigned
+RollingFileAppender::getRequiredEventFields() const
+{
+    return FileAppender::getRequiredEventFields ()
+        | (bloomKeys.empty () ? 0u : spi::EVENT_FIELD_MDC);
+}
+
+
+void
+RollingFileAppender::updateFileInfo()
+{
+    if (getFileInfo (&fileInfo, filename) == 0)
+        fileSize = static_cast<long> (fileInfo.size);
+    else
+    {
+        fileInfo = helpers::FileInfo ();
+        fileSize = 0;
+    }
 }
 
 
@@ -538,6 +2273,8 @@ RollingFileAppender::rollover(bool alreadyLocked)
     // Reset flags since the C++ standard specified that all the flags
     // should remain unchanged on a close.
     out.clear();
+    indexOut.close ();
+    saveBloomFilter ();
 
     if (useLockFile)
     {
@@ -558,7 +2295,9 @@ RollingFileAppender::rollover(bool alreadyLocked)
 
         helpers::FileInfo fi;
         if (getFileInfo (&fi, filename) == -1
-            || fi.size < maxFileSize)
+            || fi.size < maxFileSize
+            || fi.device != fileInfo.device
+            || fi.inode != fileInfo.inode)
         {
             // The file has already been rolled by another
             // process. Just reopen with the new file.
@@ -566,34 +2305,63 @@ RollingFileAppender::rollover(bool alreadyLocked)
             // Open it up again.
             open (std::ios_base::out | std::ios_base::ate | std::ios_base::app);
             loglog_opening_result (loglog, out, filename);
+            fileOpened ();
 
             return;
         }
     }
 
+    if (preallocate)
+        release_preallocation (filename, maxFileSize);
+
     // If maxBackups <= 0, then there is no file renaming to be done.
     if (maxBackupIndex > 0)
     {
-        rolloverFiles(filename, maxBackupIndex);
-
-        // Rename fileName to fileName.1
-        tstring target = filename + LOG4CPLUS_TEXT(".1");
+        tstring const compressedSuffix
+            = getCompressedFilename (internal::empty_str);
+
+        // Indices and filters are small; they are shifted right away so
+        // that the new file does not get those of the old one.
+        if (useIndex)
+            roll_sidecar (filename, maxBackupIndex,
+                LOG4CPLUS_TEXT (".idx"));
+        if (! bloomKeys.empty ())
+            roll_sidecar (filename, maxBackupIndex,
+                LOG4CPLUS_TEXT (".bloom"));
+
+        if (useLockFile)
+        {
+            // Locks of the lock file are owned by the whole process, a
+            // background thread could not hold it on its own. Shift the
+            // backups now, while the lock is held.
+            roll_backups (filename, filename, maxBackupIndex, compression,
+                compressedSuffix);
+        }
+        else
+        {
+            // Only move the file aside here. Shifting of backups, which
+            // can take many renames, runs in the background.
+            tstring const staging = filename + LOG4CPLUS_TEXT (".rolling.")
+                + helpers::convertIntegerToString (rolloverSerial++);
 
-        long ret;
+            long ret;
 
 #if defined (_WIN32)
-        // Try to remove the target first. It seems it is not
-        // possible to rename over existing file.
-        ret = file_remove (target);
+            ret = file_remove (staging);
 #endif
 
-        loglog.debug (
-            LOG4CPLUS_TEXT("Renaming file ")
-            + filename
-            + LOG4CPLUS_TEXT(" to ")
-            + target);
-        ret = file_rename (filename, target);
-        loglog_renaming_result (loglog, filename, target, ret);
+            ret = file_rename (filename, staging);
+            loglog_renaming_result (loglog, filename, staging, ret);
+            if (ret == 0)
+                runInBackground (
+                    [filename = filename, staging,
+                        maxBackupIndex = maxBackupIndex,
+                        compression = compression, compressedSuffix]
+                    {
+                        roll_backups (filename, staging, maxBackupIndex,
+                            compression, compressedSuffix);
+                    });
+        }
     }
     else
     {
@@ -603,6 +2371,7 @@ RollingFileAppender::rollover(bool alreadyLocked)
     // Open it up again in truncation mode
     open(std::ios::out | std::ios::trunc);
     loglog_opening_result (loglog, out, filename);
+    fileOpened ();
 }
 
 
@@ -795,9 +2564,7 @@ DailyRollingFileAppender::rollover(bool alreadyLocked)
 
     // Do not overwriet the newest file either, e.g. if "log.2009-11-07"
     // already exists rename it to "log.2009-11-07.1"
-    tostringstream backup_target_oss;
-    backup_target_oss << scheduledFilename << LOG4CPLUS_TEXT(".") << 1;
-    tstring backupTarget = backup_target_oss.str();
+    tstring backupTarget = scheduledFilename + LOG4CPLUS_TEXT(".1");
 
     helpers::LogLog & loglog = helpers::getLogLog();
     long ret;
@@ -1296,6 +3063,7 @@ TimeBasedRollingFileAppender::TimeBasedRollingFileAppender(
     properties.getInt(maxHistory, LOG4CPLUS_TEXT("MaxHistory"));
     properties.getBool(cleanHistoryOnStart, LOG4CPLUS_TEXT("CleanHistoryOnStart"));
     properties.getBool(rollOnClose, LOG4CPLUS_TEXT("RollOnClose"));
+    initIndex (properties);
     filenamePattern = preprocessFilenamePattern(filenamePattern, schedule);
 
     init();
@@ -1321,16 +3089,20 @@ TimeBasedRollingFileAppender::init()
 
     FileAppenderBase::init();
 
+    filenameTemplate = std::make_shared<internal::filename_template const> (
+        filenamePattern);
+
     Time now = helpers::now();
     nextRolloverTime = calculateNextRolloverTime(now);
 
     if (LOG4CPLUS_UNLIKELY(cleanHistoryOnStart))
     {
-        clean(now + maxHistory*getRolloverPeriodDuration());
+        runInBackground (
+            cleanTask (now + maxHistory*getRolloverPeriodDuration()));
     }
     else
     {
-        clean(now);
+        runInBackground (cleanTask (now));
     }
 
     lastHeartBeat = now;
@@ -1343,7 +3115,19 @@ TimeBasedRollingFileAppender::append(const spi::InternalLoggingEvent& event)
         rollover(true);
     }
 
-    FileAppenderBase::append(event);
+    if (! useIndex)
+    {
+        FileAppenderBase::append(event);
+        return;
+    }
+
+    // Switch files before the offset is taken; open() reopens the
+    // index.
+    switchShard ();
+    std::streampos const pos = indexDue (event.getTimestamp ())
+        ? out.tellp () : std::streampos (-1);
+    if (appendFormatted (formatEvent (event)) && pos != std::streampos (-1))
+        writeIndex (event.getTimestamp (), std::streamoff (pos));
 }
 
 void
@@ -1365,6 +3149,9 @@ TimeBasedRollingFileAppender::open(std::ios_base::openmode mode)
         return;
     }
     helpers::getLogLog().debug(LOG4CPLUS_TEXT("Just opened file: ") + currentFilename);
+    openSyncFile ();
+    if (useIndex)
+        openIndex ((mode & std::ios_base::trunc) != 0);
 }
 
 void
@@ -1397,12 +3184,24 @@ TimeBasedRollingFileAppender::rollover(bool alreadyLocked)
     // reset flags since the C++ standard specified that all the flags
     // should remain unchanged on a close
     out.clear();
+    indexOut.close ();
 
     if (filename != scheduledFilename)
     {
         helpers::LogLog & loglog = helpers::getLogLog();
         long ret;
 
+        if (useIndex)
+        {
+            tstring const suffix (LOG4CPLUS_TEXT (".idx"));
+#if defined (_WIN32)
+            file_remove (scheduledFilename + suffix);
+#endif
+            ret = file_rename (filename + suffix, scheduledFilename + suffix);
+            loglog_renaming_result (loglog, filename + suffix,
+                scheduledFilename + suffix, ret);
+        }
+
 #if defined (_WIN32)
         // Try to remove the target first. It seems it is not
         // possible to rename over existing file.
@@ -1416,10 +3215,19 @@ TimeBasedRollingFileAppender::rollover(bool alreadyLocked)
             + scheduledFilename);
         ret = file_rename (filename, scheduledFilename);
         loglog_renaming_result (loglog, filename, scheduledFilename, ret);
+        if (ret == 0 && compression != NO_COMPRESSION)
+            runInBackground (
+                [src = scheduledFilename,
+                    target = getCompressedFilename (scheduledFilename),
+                    compression = compression]
+                {
+                    compress_file (src, target, compression);
+                });
     }
 
+    // Scanning for old files can take a while, do it in the background.
     Time now = helpers::now();
-    clean(now);
+    runInBackground (cleanTask (now));
 
     open(std::ios::out | std::ios::trunc);
 
@@ -1428,6 +3236,12 @@ TimeBasedRollingFileAppender::rollover(bool alreadyLocked)
 
 void
 TimeBasedRollingFileAppender::clean(Time time)
+{
+    cleanTask (time) ();
+}
+
+std::function<void ()>
+TimeBasedRollingFileAppender::cleanTask(Time time)
 {
     Time::duration interval = std::chrono::hours{31*24}; // ~1 month
     if (lastHeartBeat != Time{})
@@ -1438,17 +3252,38 @@ TimeBasedRollingFileAppender::clean(Time time)
     Time::duration period = getRolloverPeriodDuration();
     long periods = long(interval.count () / period.count ());
 
-    helpers::LogLog & loglog = helpers::getLogLog();
-    for (long i = 0; i < periods; i++)
-    {
-        long periodToRemove = (-maxHistory - 1) - i;
-        Time timeToRemove = time + periodToRemove * period;
-        tstring filenameToRemove = helpers::getFormattedTime(filenamePattern, timeToRemove, false);
-        loglog.debug(LOG4CPLUS_TEXT("Removing file ") + filenameToRemove);
-        file_remove(filenameToRemove);
-    }
-
     lastHeartBeat = time;
+
+    // One listing of the directory finds all expired archives, however
+    // long the appender has not been running.
+    if (filenameTemplate && filenameTemplate->usable)
+        return [filenameTemplate = filenameTemplate,
+            compressedSuffix = getCompressedFilename (internal::empty_str),
+            useIndex = useIndex,
+            cutoff = time - (maxHistory + 1) * period]
+        {
+            filenameTemplate->remove_expired (cutoff, compressedSuffix,
+                useIndex);
+        };
+
+    return [filenamePattern = filenamePattern, maxHistory = maxHistory,
+        compressedSuffix = getCompressedFilename (internal::empty_str),
+        useIndex = useIndex, time, period, periods]
+    {
+        helpers::LogLog & loglog = helpers::getLogLog();
+        for (long i = 0; i < periods; i++)
+        {
+            long periodToRemove = (-maxHistory - 1) - i;
+            Time timeToRemove = time + periodToRemove * period;
+            tstring filenameToRemove = helpers::getFormattedTime(filenamePattern, timeToRemove, false);
+            loglog.debug(LOG4CPLUS_TEXT("Removing file ") + filenameToRemove);
+            file_remove(filenameToRemove);
+            if (! compressedSuffix.empty ())
+                file_remove(filenameToRemove + compressedSuffix);
+            if (useIndex)
+                file_remove(filenameToRemove + LOG4CPLUS_TEXT(".idx"));
+        }
+    };
 }
 
 Time::duration
@@ -1504,7 +3339,602 @@ CATCH_TEST_CASE ("TimeBasedRollingFileAppender", "[appender]")
         CATCH_REQUIRE (schedule == DAILY);
     }
 
+    CATCH_SECTION ("index")
+    {
+        tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-tbr-test.log"));
+        tstring const archive_name = helpers::getFormattedTime (
+            LOG4CPLUS_TEXT ("log4cplus-tbr-test-%Y-%m-%d.log"),
+            helpers::now (), false);
+        tstring const index_name = archive_name + LOG4CPLUS_TEXT (".idx");
+
+        Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("File"), file_name);
+        props.setProperty (LOG4CPLUS_TEXT ("FilenamePattern"),
+            LOG4CPLUS_TEXT ("log4cplus-tbr-test-%d{yyyy-MM-dd}.log"));
+        props.setProperty (LOG4CPLUS_TEXT ("Append"),
+            LOG4CPLUS_TEXT ("false"));
+        props.setProperty (LOG4CPLUS_TEXT ("Index"), LOG4CPLUS_TEXT ("true"));
+        props.setProperty (LOG4CPLUS_TEXT ("IndexEvery"),
+            LOG4CPLUS_TEXT ("2"));
+        spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+            INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("x"), __FILE__, __LINE__,
+            nullptr);
+        {
+            TimeBasedRollingFileAppender appender (props);
+            for (int i = 0; i != 5; ++i)
+                appender.doAppend (ev);
+
+            // Rollover on close moves the index along with the file.
+        }
+
+        std::ifstream in (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (index_name)
+            .c_str (), std::ios_base::binary);
+        std::vector<std::uint64_t> offsets;
+        unsigned char entry[16];
+        while (in.read (reinterpret_cast<char *> (entry), sizeof (entry)))
+            offsets.push_back (entry[8]);
+        in.close ();
+
+        // "INFO - x" and EOL
+        CATCH_REQUIRE (offsets == std::vector<std::uint64_t> {0, 18, 36});
+
+        file_remove (archive_name);
+        file_remove (index_name);
+        file_remove (file_name);
+        file_remove (file_name + LOG4CPLUS_TEXT (".idx"));
+    }
+
+    CATCH_SECTION ("file name template")
+    {
+        internal::filename_template const tmpl (
+            LOG4CPLUS_TEXT ("logs/app-%Y-%m-%d-%H.log"));
+        CATCH_REQUIRE (tmpl.usable);
+        CATCH_REQUIRE (tmpl.directory == LOG4CPLUS_TEXT ("logs/"));
+
+        helpers::Time const hour = helpers::truncate_fractions (
+            helpers::now ());
+        helpers::Time time;
+        CATCH_REQUIRE (tmpl.match (helpers::getFormattedTime (
+                    LOG4CPLUS_TEXT ("app-%Y-%m-%d-%H.log"), hour, false),
+                time));
+        CATCH_REQUIRE (time <= hour);
+        CATCH_REQUIRE (hour - time < std::chrono::hours (1));
+        CATCH_REQUIRE (! tmpl.match (LOG4CPLUS_TEXT ("app-2024-01-01.log"),
+                time));
+        CATCH_REQUIRE (! tmpl.match (LOG4CPLUS_TEXT ("app-2024-01-01-0x.log"),
+                time));
+
+        CATCH_REQUIRE (! internal::filename_template (
+                LOG4CPLUS_TEXT ("%Y/app-%m.log")).usable);
+        CATCH_REQUIRE (! internal::filename_template (
+                LOG4CPLUS_TEXT ("app-%m-%d.log")).usable);
+        CATCH_REQUIRE (! internal::filename_template (
+                LOG4CPLUS_TEXT ("app-%Y-%W.log")).usable);
+    }
+
+    CATCH_SECTION ("history clean up by directory listing")
+    {
+        namespace fs = std::filesystem;
+        tstring const dir (LOG4CPLUS_TEXT ("log4cplus-tbr-clean/"));
+        tstring const pattern (LOG4CPLUS_TEXT ("app-%Y-%m-%d-%H.log"));
+        fs::create_directories (fs::path (dir));
+        helpers::Time const now = helpers::now ();
+        auto const archive = [&] (int hoursAgo)
+        {
+            return dir + helpers::getFormattedTime (pattern,
+                now - std::chrono::hours (hoursAgo), false);
+        };
+        auto const exists = [] (tstring const & name)
+        {
+            return fs::exists (fs::path (name));
+        };
+        for (tstring const & name : {archive (1), archive (5),
+                archive (24 * 400), dir + LOG4CPLUS_TEXT ("other.txt")})
+            std::ofstream (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (name)
+                .c_str ());
+
+        {
+            TimeBasedRollingFileAppender appender (
+                dir + LOG4CPLUS_TEXT ("app.log"),
+                dir + LOG4CPLUS_TEXT ("app-%d{yyyy-MM-dd-HH}.log"), 2,
+                false, true, false, false);
+        }
+
+        CATCH_REQUIRE (exists (archive (1)));
+        CATCH_REQUIRE (! exists (archive (5)));
+        CATCH_REQUIRE (! exists (archive (24 * 400)));
+        CATCH_REQUIRE (exists (dir + LOG4CPLUS_TEXT ("other.txt")));
+        fs::remove_all (fs::path (dir));
+    }
+}
+
+
+CATCH_TEST_CASE ("FileAppender flush policy", "[appender]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-flush-test.log"));
+    auto const file_size = [&]
+    {
+        std::ifstream in (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (file_name)
+            .c_str (), std::ios_base::ate | std::ios_base::binary);
+        return static_cast<long> (in.tellg ());
+    };
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+        INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("0123456789"), __FILE__, __LINE__,
+        nullptr);
+
+    CATCH_SECTION ("flush after given size")
+    {
+        Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("File"), file_name);
+        props.setProperty (LOG4CPLUS_TEXT ("FlushBytes"),
+            LOG4CPLUS_TEXT ("64"));
+        props.setProperty (LOG4CPLUS_TEXT ("FlushIntervalMs"),
+            LOG4CPLUS_TEXT ("60000"));
+        FileAppender appender (props);
+
+        appender.doAppend (ev);
+        CATCH_REQUIRE (file_size () == 0);
+
+        for (int i = 0; i != 4; ++i)
+            appender.doAppend (ev);
+        CATCH_REQUIRE (file_size () > 0);
+        appender.close ();
+    }
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    CATCH_SECTION ("flush after given interval")
+    {
+        FileAppender appender (file_name);
+        appender.setFlushPolicy (0, 20);
+
+        appender.doAppend (ev);
+        for (int i = 0; i != 500 && file_size () == 0; ++i)
+            std::this_thread::sleep_for (std::chrono::milliseconds (10));
+        CATCH_REQUIRE (file_size () > 0);
+        appender.close ();
+    }
+#endif
+
+    file_remove (file_name);
+}
+
+
+CATCH_TEST_CASE ("FileAppender sync policy", "[appender]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-sync-test.log"));
+    auto const file_size = [&]
+    {
+        std::ifstream in (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (file_name)
+            .c_str (), std::ios_base::ate | std::ios_base::binary);
+        return static_cast<long> (in.tellg ());
+    };
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+        INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("0123456789"), __FILE__, __LINE__,
+        nullptr);
+
+    CATCH_SECTION ("group commit")
+    {
+        Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("File"), file_name);
+        props.setProperty (LOG4CPLUS_TEXT ("ImmediateFlush"),
+            LOG4CPLUS_TEXT ("false"));
+        props.setProperty (LOG4CPLUS_TEXT ("SyncPolicy"),
+            LOG4CPLUS_TEXT ("GroupCommit"));
+        FileAppender appender (props);
+
+        CATCH_REQUIRE (waitForDurableLogging ());
+        appender.doAppend (ev);
+        CATCH_REQUIRE (file_size () == 0);
+        CATCH_REQUIRE (waitForDurableLogging ());
+        long const event_size = file_size ();
+        CATCH_REQUIRE (event_size > 0);
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        std::atomic<int> failures (0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t != 4; ++t)
+            threads.emplace_back ([&]
+                {
+                    for (int i = 0; i != 50; ++i)
+                    {
+                        appender.doAppend (ev);
+                        if (! waitForDurableLogging ())
+                            ++failures;
+                    }
+                });
+        for (auto & thread : threads)
+            thread.join ();
+        CATCH_REQUIRE (failures == 0);
+        CATCH_REQUIRE (file_size () == 201 * event_size);
+#endif
+
+        appender.doAppend (ev);
+        appender.close ();
+        CATCH_REQUIRE (waitForDurableLogging ());
+    }
+
+    CATCH_SECTION ("no sync")
+    {
+        FileAppender appender (file_name);
+        appender.doAppend (ev);
+        CATCH_REQUIRE (! appender.sync ());
+        CATCH_REQUIRE (waitForDurableLogging ());
+        appender.close ();
+    }
+
+    file_remove (file_name);
+}
+
+
+#if defined (UNICODE)
+CATCH_TEST_CASE ("FileAppender UTF-8 encoding", "[appender]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-utf8-test.log"));
+    {
+        Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("File"), file_name);
+        props.setProperty (LOG4CPLUS_TEXT ("Locale"),
+            LOG4CPLUS_TEXT ("CLASSIC"));
+        props.setProperty (LOG4CPLUS_TEXT ("Encoding"),
+            LOG4CPLUS_TEXT ("UTF-8"));
+        FileAppender appender (props);
+        appender.setLayout (std::make_unique<PatternLayout> (
+                LOG4CPLUS_TEXT ("%m%n")));
+        appender.doAppend (spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("test"),
+                INFO_LOG_LEVEL, L"caf\u00E9 \u20AC", __FILE__, __LINE__,
+                nullptr));
+        appender.close ();
+    }
+
+    std::ifstream in (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (file_name)
+        .c_str (), std::ios_base::binary);
+    std::string line;
+    std::getline (in, line);
+    in.close ();
+    CATCH_REQUIRE (line == "caf\xC3\xA9 \xE2\x82\xAC");
+
+    file_remove (file_name);
+}
+#endif
+
+
+CATCH_TEST_CASE ("RollingFileAppender background rollover", "[appender]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-rollover-test.log"));
+    auto const backup = [&] (tstring const & suffix, int i)
+    {
+        return file_name + suffix + helpers::convertIntegerToString (i);
+    };
+    auto const exists = [] (tstring const & name)
+    {
+        return std::ifstream (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (name)
+            .c_str ()).good ();
+    };
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+        INFO_LOG_LEVEL, tstring (1000, LOG4CPLUS_TEXT ('x')), __FILE__,
+        __LINE__, nullptr);
+
+    {
+        RollingFileAppender appender (file_name, 200 * 1024L, 3);
+        for (int i = 0; i != 4 * 205; ++i)
+            appender.doAppend (ev);
+        appender.close ();
+    }
+
+    for (int i = 1; i <= 3; ++i)
+        CATCH_REQUIRE (exists (backup (LOG4CPLUS_TEXT ("."), i)));
+    CATCH_REQUIRE (! exists (backup (LOG4CPLUS_TEXT ("."), 4)));
+    for (int i = 0; i != 4; ++i)
+        CATCH_REQUIRE (! exists (backup (LOG4CPLUS_TEXT (".rolling."), i)));
+
+    for (int i = 1; i <= 3; ++i)
+        file_remove (backup (LOG4CPLUS_TEXT ("."), i));
+    file_remove (file_name);
+}
+
+
+CATCH_TEST_CASE ("RollingFileAppender foreign rollover", "[appender]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-foreign-test.log"));
+    auto const file_size = [&]
+    {
+        helpers::FileInfo fi;
+        return getFileInfo (&fi, file_name) == 0 ? long (fi.size) : -1L;
+    };
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+        INFO_LOG_LEVEL, tstring (1000, LOG4CPLUS_TEXT ('x')), __FILE__,
+        __LINE__, nullptr);
+
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), file_name);
+    props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+        LOG4CPLUS_TEXT ("200KB"));
+    props.setProperty (LOG4CPLUS_TEXT ("UseLockFile"),
+        LOG4CPLUS_TEXT ("true"));
+
+    {
+        RollingFileAppender first (props);
+        RollingFileAppender second (props);
+
+        // The second appender rolls the shared file over.
+        for (int i = 0; i != 205; ++i)
+            second.doAppend (ev);
+        long const size = file_size ();
+        CATCH_REQUIRE (size < 200 * 1024L);
+
+        // The first appender notices and continues in the new file.
+        for (int i = 0; i != 10; ++i)
+            first.doAppend (ev);
+        CATCH_REQUIRE (file_size () > size);
+
+        first.close ();
+        second.close ();
+    }
+
+    file_remove (file_name + LOG4CPLUS_TEXT (".1"));
+    file_remove (file_name + LOG4CPLUS_TEXT (".lock"));
+    file_remove (file_name);
+}
+
+
+CATCH_TEST_CASE ("RollingFileAppender preallocation", "[appender]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-prealloc-test.log"));
+    auto const file_size = [&]
+    {
+        helpers::FileInfo fi;
+        return getFileInfo (&fi, file_name) == 0 ? long (fi.size) : -1L;
+    };
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+        INFO_LOG_LEVEL, tstring (1000, LOG4CPLUS_TEXT ('x')), __FILE__,
+        __LINE__, nullptr);
+    long const line_size = 1000 + 8; // "INFO - " prefix and EOL
+
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), file_name);
+    props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+        LOG4CPLUS_TEXT ("200KB"));
+    props.setProperty (LOG4CPLUS_TEXT ("Preallocate"),
+        LOG4CPLUS_TEXT ("true"));
+
+    // Reserved space must not show in the file size, neither before
+    // nor after a rollover.
+    {
+        RollingFileAppender appender (props);
+        CATCH_REQUIRE (file_size () == 0);
+
+        for (int i = 0; i != 10; ++i)
+            appender.doAppend (ev);
+        CATCH_REQUIRE (file_size () == 10 * line_size);
+
+        for (int i = 0; i != 200; ++i)
+            appender.doAppend (ev);
+        appender.close ();
+        CATCH_REQUIRE (file_size () < 200 * 1024L);
+        CATCH_REQUIRE (file_size () % line_size == 0);
+    }
+
+    file_remove (file_name + LOG4CPLUS_TEXT (".1"));
+    file_remove (file_name);
+}
+
+
+CATCH_TEST_CASE ("RollingFileAppender shards and index", "[appender]")
+{
+    tstring const pattern (LOG4CPLUS_TEXT ("log4cplus-shard-%pid-test.log"));
+    auto const shard_name = [&] (unsigned long pid)
+    {
+        return expand_shard_name (pattern, pid);
+    };
+    auto const file_size = [] (tstring const & name)
+    {
+        helpers::FileInfo fi;
+        return getFileInfo (&fi, name) == 0 ? long (fi.size) : -1L;
+    };
+    auto const read_index = [] (tstring const & name)
+    {
+        std::ifstream in (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (name)
+            .c_str (), std::ios_base::binary);
+        std::vector<std::uint64_t> offsets;
+        unsigned char entry[16];
+        while (in.read (reinterpret_cast<char *> (entry), sizeof (entry)))
+        {
+            std::uint64_t offset = 0;
+            for (std::size_t i = 0; i != 8; ++i)
+                offset |= std::uint64_t (entry[8 + i]) << (i * 8);
+            offsets.push_back (offset);
+        }
+        return offsets;
+    };
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+        INFO_LOG_LEVEL, tstring (1000, LOG4CPLUS_TEXT ('x')), __FILE__,
+        __LINE__, nullptr);
+    long const line_size = 1000 + 8; // "INFO - " prefix and EOL
+
+    CATCH_REQUIRE (expand_shard_name (LOG4CPLUS_TEXT ("a%pid.%pid"), 42)
+        == LOG4CPLUS_TEXT ("a42.42"));
+
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), pattern);
+    props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+        LOG4CPLUS_TEXT ("200KB"));
+    props.setProperty (LOG4CPLUS_TEXT ("Index"), LOG4CPLUS_TEXT ("true"));
+
+    unsigned long const pid
+        = static_cast<unsigned long> (internal::get_process_id ());
+    tstring const file_name = shard_name (pid);
+    tstring const index_name = file_name + LOG4CPLUS_TEXT (".idx");
+    tstring const backup_index_name = file_name + LOG4CPLUS_TEXT (".1.idx");
+
+    {
+        RollingFileAppender appender (props);
+        for (int i = 0; i != 250; ++i)
+            appender.doAppend (ev);
+
+#if defined (LOG4CPLUS_HAVE_GETPID) && ! defined (_WIN32)
+        // Forked child writes into its own file.
+        pid_t const child = fork ();
+        if (child == 0)
+        {
+            appender.doAppend (ev);
+            _exit (0);
+        }
+        CATCH_REQUIRE (child > 0);
+        int status = 0;
+        waitpid (child, &status, 0);
+        tstring const child_name
+            = shard_name (static_cast<unsigned long> (child));
+        CATCH_REQUIRE (file_size (child_name) == line_size);
+        CATCH_REQUIRE (read_index (child_name + LOG4CPLUS_TEXT (".idx"))
+            == std::vector<std::uint64_t> {0});
+        file_remove (child_name + LOG4CPLUS_TEXT (".idx"));
+        file_remove (child_name);
+#endif
+
+        appender.close ();
+    }
+
+    // Every event has entry in the index of its file.
+    std::vector<std::uint64_t> const backup_offsets
+        = read_index (backup_index_name);
+    std::vector<std::uint64_t> const offsets = read_index (index_name);
+    CATCH_REQUIRE (long (backup_offsets.size ()) * line_size
+        == file_size (file_name + LOG4CPLUS_TEXT (".1")));
+    CATCH_REQUIRE (long (offsets.size ()) * line_size
+        == file_size (file_name));
+    CATCH_REQUIRE (backup_offsets.size () + offsets.size () == 250);
+    for (std::size_t i = 0; i != offsets.size (); ++i)
+        CATCH_REQUIRE (offsets[i] == i * line_size);
+
+    file_remove (backup_index_name);
+    file_remove (index_name);
+    file_remove (file_name + LOG4CPLUS_TEXT (".1"));
+    file_remove (file_name);
+}
+
+
+CATCH_TEST_CASE ("RollingFileAppender Bloom filter", "[appender]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-bloom-test.log"));
+    tstring const bloom_name = file_name + LOG4CPLUS_TEXT (".bloom");
+    tstring const backup_bloom_name = file_name + LOG4CPLUS_TEXT (".1.bloom");
+    tstring const key (LOG4CPLUS_TEXT ("traceId"));
+    auto const trace = [] (int i)
+    {
+        return LOG4CPLUS_TEXT ("trace-") + helpers::convertIntegerToString (i);
+    };
+    auto const event = [&] (int i)
+    {
+        MappedDiagnosticContextMap mdc;
+        mdc[key] = trace (i);
+        return spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("test"),
+            INFO_LOG_LEVEL, tstring_view (), mdc,
+            tstring (1000, LOG4CPLUS_TEXT ('x')), tstring_view (),
+            tstring_view (), helpers::now (), tstring_view (), 0);
+    };
+
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), file_name);
+    props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+        LOG4CPLUS_TEXT ("200KB"));
+    props.setProperty (LOG4CPLUS_TEXT ("BloomKeys"), key);
+    props.setProperty (LOG4CPLUS_TEXT ("BloomExpectedValues"),
+        LOG4CPLUS_TEXT ("1000"));
+
+    {
+        RollingFileAppender appender (props);
+        for (int i = 0; i != 250; ++i)
+            appender.doAppend (event (i));
+        appender.close ();
+    }
+
+    // About 200 events went into the backup, the rest into the file.
+    helpers::BloomFilter backup;
+    helpers::BloomFilter current;
+    CATCH_REQUIRE (backup.load (backup_bloom_name));
+    CATCH_REQUIRE (current.load (bloom_name));
+    CATCH_REQUIRE (backup.mightContain (key, trace (0)));
+    CATCH_REQUIRE (! current.mightContain (key, trace (0)));
+    CATCH_REQUIRE (current.mightContain (key, trace (249)));
+    CATCH_REQUIRE (! backup.mightContain (key, trace (249)));
+
+    // Appending to the file keeps its filter.
+    {
+        RollingFileAppender appender (props);
+        CATCH_REQUIRE (! std::ifstream (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (
+                    bloom_name).c_str ()).good ());
+        appender.doAppend (event (1000));
+        appender.close ();
+    }
+
+    CATCH_REQUIRE (current.load (bloom_name));
+    CATCH_REQUIRE (current.mightContain (key, trace (249)));
+    CATCH_REQUIRE (current.mightContain (key, trace (1000)));
+
+    file_remove (backup_bloom_name);
+    file_remove (bloom_name);
+    file_remove (file_name + LOG4CPLUS_TEXT (".1"));
+    file_remove (file_name);
+}
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+CATCH_TEST_CASE ("RollingFileAppender compression", "[appender]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-compress-test.log"));
+    auto const exists = [] (tstring const & name)
+    {
+        return std::ifstream (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (name)
+            .c_str ()).good ();
+    };
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+        INFO_LOG_LEVEL, tstring (1000, LOG4CPLUS_TEXT ('x')), __FILE__,
+        __LINE__, nullptr);
+
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), file_name);
+    props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+        LOG4CPLUS_TEXT ("200KB"));
+    props.setProperty (LOG4CPLUS_TEXT ("MaxBackupIndex"),
+        LOG4CPLUS_TEXT ("2"));
+    props.setProperty (LOG4CPLUS_TEXT ("Compression"),
+        LOG4CPLUS_TEXT ("gzip"));
+
+    // Write enough for three rollovers so that the oldest backup is
+    // removed.
+    {
+        RollingFileAppender appender (props);
+        for (int i = 0; i != 3 * 205; ++i)
+            appender.doAppend (ev);
+        appender.close ();
+    }
+
+    for (int i = 1; i <= 2; ++i)
+    {
+        tstring const backup = file_name + LOG4CPLUS_TEXT (".")
+            + helpers::convertIntegerToString (i);
+        tstring const compressed = backup + LOG4CPLUS_TEXT (".gz");
+        CATCH_REQUIRE (! exists (backup));
+        CATCH_REQUIRE (exists (compressed));
+
+        gzFile gz = gzopen (
+            LOG4CPLUS_TSTRING_TO_STRING (compressed).c_str (), "rb");
+        CATCH_REQUIRE (gz);
+        char buf[4096];
+        long size = 0;
+        int ret;
+        while ((ret = gzread (gz, buf, sizeof (buf))) > 0)
+            size += ret;
+        gzclose (gz);
+        CATCH_REQUIRE (size > 200 * 1024L);
+
+        file_remove (compressed);
+    }
+
+    CATCH_REQUIRE (! exists (file_name + LOG4CPLUS_TEXT (".3.gz")));
+    file_remove (file_name);
 }
+
+#endif // defined (LOG4CPLUS_WITH_ZLIB)
 #endif
 
 
@@ -53,6 +53,8 @@ getFileInfo (FileInfo * fi, tstring const & name)
     fi->mtime = helpers::from_time_t (fileStatus.st_mtime);
     fi->is_link = false;
     fi->size = fileStatus.st_size;
+    fi->device = fileStatus.st_dev;
+    fi->inode = fileStatus.st_ino;
 
 #else
     struct stat fileStatus;
@@ -63,6 +65,8 @@ getFileInfo (FileInfo * fi, tstring const & name)
     fi->mtime = helpers::from_time_t (fileStatus.st_mtime);
     fi->is_link = S_ISLNK (fileStatus.st_mode);
     fi->size = fileStatus.st_size;
+    fi->device = fileStatus.st_dev;
+    fi->inode = fileStatus.st_ino;
 
 #endif
 
@@ -24,11 +24,20 @@
 #include <log4cplus/helpers/property.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/ndc.h>
+#include <log4cplus/mdc.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <type_traits>
+#include <typeinfo>
 
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 #include <log4cplus/logger.h>
-#include <log4cplus/ndc.h>
-#include <log4cplus/mdc.h>
 #include <catch.hpp>
 #endif
 
@@ -56,6 +65,140 @@ checkFilter(const Filter* filter, const InternalLoggingEvent& event)
 }
 
 
+FilterResult
+preCheckFilter(const Filter* filter, LogLevel ll,
+    const log4cplus::tstring& loggerName, bool& contextual)
+{
+    const Filter* currentFilter = filter;
+    while(currentFilter) {
+        FilterResult result
+            = currentFilter->preDecide(ll, loggerName, contextual);
+        if(result != NEUTRAL) {
+            return result;
+        }
+
+        currentFilter = currentFilter->next.get();
+    }
+
+    return ACCEPT;
+}
+
+
+unsigned
+getRequiredEventFields(const Filter* filter)
+{
+    unsigned fields = EVENT_FIELDS_NONE;
+    for (const Filter* currentFilter = filter; currentFilter;
+         currentFilter = currentFilter->next.get())
+        fields |= currentFilter->getRequiredEventFields();
+
+    return fields;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FilterProgram implementation
+///////////////////////////////////////////////////////////////////////////////
+
+FilterProgram::FilterProgram()
+    : chain(nullptr)
+    , last(nullptr)
+{ }
+
+
+FilterProgram::FilterProgram(const Filter* chain_)
+    : chain(chain_)
+    , last(nullptr)
+{
+    for (const Filter* f = chain; f; f = f->next.get())
+    {
+        // Only the exact classes; subclasses may override decide().
+        std::type_info const & type = typeid(*f);
+        OpCode code = OP_DECIDE;
+        if (type == typeid(DenyAllFilter))
+            code = OP_DENY_ALL;
+        else if (type == typeid(LogLevelMatchFilter))
+            code = OP_LOG_LEVEL_MATCH;
+        else if (type == typeid(LogLevelRangeFilter))
+            code = OP_LOG_LEVEL_RANGE;
+        else if (type == typeid(StringMatchFilter))
+            code = OP_STRING_MATCH;
+        else if (type == typeid(MultiStringMatchFilter))
+            code = OP_MULTI_STRING_MATCH;
+        else if (type == typeid(NDCMatchFilter))
+            code = OP_NDC_MATCH;
+        else if (type == typeid(MDCMatchFilter))
+            code = OP_MDC_MATCH;
+
+        ops.push_back(Op{code, f});
+        last = f;
+
+        // Nothing after DenyAllFilter is ever consulted.
+        if (code == OP_DENY_ALL)
+            break;
+    }
+}
+
+
+FilterResult
+FilterProgram::check(const InternalLoggingEvent& event) const
+{
+    // Qualified calls below are not virtual and get inlined.
+    for (Op const & op : ops)
+    {
+        FilterResult result;
+        switch (op.code)
+        {
+        case OP_DENY_ALL:
+            return DENY;
+
+        case OP_LOG_LEVEL_MATCH:
+            result = static_cast<const LogLevelMatchFilter*>(op.filter)
+                ->LogLevelMatchFilter::decide(event);
+            break;
+
+        case OP_LOG_LEVEL_RANGE:
+            result = static_cast<const LogLevelRangeFilter*>(op.filter)
+                ->LogLevelRangeFilter::decide(event);
+            break;
+
+        case OP_STRING_MATCH:
+            result = static_cast<const StringMatchFilter*>(op.filter)
+                ->StringMatchFilter::decide(event);
+            break;
+
+        case OP_MULTI_STRING_MATCH:
+            result = static_cast<const MultiStringMatchFilter*>(op.filter)
+                ->MultiStringMatchFilter::decide(event);
+            break;
+
+        case OP_NDC_MATCH:
+            result = static_cast<const NDCMatchFilter*>(op.filter)
+                ->NDCMatchFilter::decide(event);
+            break;
+
+        case OP_MDC_MATCH:
+            result = static_cast<const MDCMatchFilter*>(op.filter)
+                ->MDCMatchFilter::decide(event);
+            break;
+
+        default:
+            result = op.filter->decide(event);
+            break;
+        }
+
+        if (result != NEUTRAL)
+            return result;
+    }
+
+    if (last && last->next)
+        return checkFilter(last->next.get(), event);
+
+    return ACCEPT;
+}
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // Filter implementation
@@ -77,6 +220,27 @@ Filter::appendFilter(FilterPtr filter)
 }
 
 
+unsigned
+Filter::getRequiredEventFields() const
+{
+    return EVENT_FIELDS_ALL;
+}
+
+
+FilterResult
+Filter::preDecide(LogLevel, const log4cplus::tstring&, bool&) const
+{
+    return ACCEPT;
+}
+
+
+std::unique_ptr<InternalLoggingEvent>
+Filter::takeSummary(const InternalLoggingEvent&) const
+{
+    return nullptr;
+}
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // DenyAllFilter implementation
@@ -96,6 +260,20 @@ DenyAllFilter::decide(const InternalLoggingEvent&) const
 }
 
 
+unsigned
+DenyAllFilter::getRequiredEventFields() const
+{
+    return EVENT_FIELDS_NONE;
+}
+
+
+FilterResult
+DenyAllFilter::preDecide(LogLevel, const log4cplus::tstring&, bool&) const
+{
+    return DENY;
+}
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // LogLevelMatchFilter implementation
@@ -130,12 +308,27 @@ LogLevelMatchFilter::init()
 
 FilterResult
 LogLevelMatchFilter::decide(const InternalLoggingEvent& event) const
+{
+    return decideLogLevel(event.getLogLevel());
+}
+
+
+FilterResult
+LogLevelMatchFilter::preDecide(LogLevel ll, const log4cplus::tstring&,
+    bool&) const
+{
+    return decideLogLevel(ll);
+}
+
+
+FilterResult
+LogLevelMatchFilter::decideLogLevel(LogLevel ll) const
 {
     if(logLevelToMatch == NOT_SET_LOG_LEVEL) {
         return NEUTRAL;
     }
 
-    bool matchOccured = (logLevelToMatch == event.getLogLevel());
+    bool matchOccured = (logLevelToMatch == ll);
 
     if(matchOccured) {
         return (acceptOnMatch ? ACCEPT : DENY);
@@ -146,6 +339,13 @@ LogLevelMatchFilter::decide(const InternalLoggingEvent& event) const
 }
 
 
+unsigned
+LogLevelMatchFilter::getRequiredEventFields() const
+{
+    return EVENT_FIELDS_NONE;
+}
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // LogLevelRangeFilter implementation
@@ -186,7 +386,21 @@ LogLevelRangeFilter::init()
 FilterResult
 LogLevelRangeFilter::decide(const InternalLoggingEvent& event) const
 {
-    LogLevel const eventLogLevel = event.getLogLevel ();
+    return decideLogLevel(event.getLogLevel());
+}
+
+
+FilterResult
+LogLevelRangeFilter::preDecide(LogLevel ll, const log4cplus::tstring&,
+    bool&) const
+{
+    return decideLogLevel(ll);
+}
+
+
+FilterResult
+LogLevelRangeFilter::decideLogLevel(LogLevel eventLogLevel) const
+{
     if((logLevelMin != NOT_SET_LOG_LEVEL) && (eventLogLevel < logLevelMin)) {
         // priority of event is less than minimum
         return DENY;
@@ -209,6 +423,13 @@ LogLevelRangeFilter::decide(const InternalLoggingEvent& event) const
 }
 
 
+unsigned
+LogLevelRangeFilter::getRequiredEventFields() const
+{
+    return EVENT_FIELDS_NONE;
+}
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // StringMatchFilter implementation
@@ -255,6 +476,241 @@ StringMatchFilter::decide(const InternalLoggingEvent& event) const
 }
 
 
+unsigned
+StringMatchFilter::getRequiredEventFields() const
+{
+    return EVENT_FIELDS_NONE;
+}
+
+
+FilterResult
+StringMatchFilter::preDecide(LogLevel, const log4cplus::tstring&, bool&) const
+{
+    // Without a string to match the message does not matter.
+    return stringToMatch.empty () ? NEUTRAL : ACCEPT;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MultiStringMatchFilter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+//! Aho-Corasick automaton converted to a deterministic one, with
+//! transitions for every state and character class in one table.
+struct MultiStringMatchFilter::Automaton
+{
+    typedef std::make_unsigned_t<tchar> uchar;
+
+    //! Character class of characters below 256; 0 is the class of
+    //! characters that do not occur in any of the strings.
+    std::uint32_t narrowClasses[256] {};
+    //! Sorted classes of other characters.
+    std::vector<std::pair<uchar, std::uint32_t>> wideClasses;
+    std::size_t classCount = 1;
+    //! Next state for each state and character class.
+    std::vector<std::uint32_t> next;
+    //! Whether one of the strings ends in the state.
+    std::vector<bool> accepting;
+
+    //! \return True if <code>ch</code> has its class in narrowClasses.
+    //! Narrow characters always do, the comparison is compiled only for
+    //! wide ones.
+    template <typename Char>
+    static bool
+    isNarrow (Char ch)
+    {
+        if constexpr (sizeof (Char) > 1)
+            return ch < 256;
+        else
+            return true;
+    }
+
+    std::uint32_t
+    classOf (tchar ch) const
+    {
+        uchar const uch = static_cast<uchar>(ch);
+        if (isNarrow (uch))
+            return narrowClasses[uch];
+
+        auto const it = std::lower_bound (wideClasses.begin (),
+            wideClasses.end (), uch,
+            [] (std::pair<uchar, std::uint32_t> const & entry, uchar key)
+            { return entry.first < key; });
+        return it != wideClasses.end () && it->first == uch ? it->second : 0;
+    }
+
+    bool
+    matches (tstring const & message) const
+    {
+        std::uint32_t state = 0;
+        for (tchar const ch : message)
+        {
+            state = next[state * classCount + classOf (ch)];
+            if (accepting[state])
+                return true;
+        }
+
+        return false;
+    }
+};
+
+
+MultiStringMatchFilter::MultiStringMatchFilter()
+    : acceptOnMatch (true)
+{ }
+
+
+MultiStringMatchFilter::MultiStringMatchFilter(
+    const helpers::Properties& properties)
+    : acceptOnMatch (true)
+{
+    properties.getBool (acceptOnMatch, LOG4CPLUS_TEXT("AcceptOnMatch"));
+
+    tstring const & separator
+        = properties.getProperty (LOG4CPLUS_TEXT("Separator"));
+    std::vector<tstring> strings;
+    helpers::tokenize (
+        properties.getProperty (LOG4CPLUS_TEXT("StringsToMatch")),
+        separator.empty () ? LOG4CPLUS_TEXT (',') : separator[0],
+        std::back_inserter (strings));
+    compile (strings);
+}
+
+
+MultiStringMatchFilter::MultiStringMatchFilter(
+    const std::vector<tstring>& stringsToMatch, bool acceptOnMatch_)
+    : acceptOnMatch (acceptOnMatch_)
+{
+    compile (stringsToMatch);
+}
+
+
+MultiStringMatchFilter::~MultiStringMatchFilter() = default;
+
+
+void
+MultiStringMatchFilter::compile(const std::vector<tstring>& stringsToMatch)
+{
+    auto a = std::make_unique<Automaton> ();
+    typedef Automaton::uchar uchar;
+
+    // Give each character occurring in the strings its own class.
+    std::vector<uchar> chars;
+    for (tstring const & str : stringsToMatch)
+        for (tchar const ch : str)
+            chars.push_back (static_cast<uchar>(ch));
+    std::sort (chars.begin (), chars.end ());
+    chars.erase (std::unique (chars.begin (), chars.end ()), chars.end ());
+    if (chars.empty ())
+        return;
+
+    for (uchar const ch : chars)
+    {
+        std::uint32_t const cls = static_cast<std::uint32_t>(a->classCount++);
+        if (Automaton::isNarrow (ch))
+            a->narrowClasses[ch] = cls;
+        else
+            a->wideClasses.emplace_back (ch, cls);
+    }
+
+    // Build the trie. Missing transitions are marked as absent.
+    std::size_t const classCount = a->classCount;
+    std::uint32_t const absent = ~std::uint32_t (0);
+    a->next.assign (classCount, absent);
+    a->accepting.assign (1, false);
+    for (tstring const & str : stringsToMatch)
+    {
+        if (str.empty ())
+            continue;
+
+        std::uint32_t state = 0;
+        for (tchar const ch : str)
+        {
+            std::uint32_t & target
+                = a->next[state * classCount + a->classOf (ch)];
+            if (target == absent)
+            {
+                target = static_cast<std::uint32_t>(a->accepting.size ());
+                a->next.resize (a->next.size () + classCount, absent);
+                a->accepting.push_back (false);
+            }
+            state = a->next[state * classCount + a->classOf (ch)];
+        }
+        a->accepting[state] = true;
+    }
+
+    // Fill in missing transitions from failure links in breadth-first
+    // order, so that each state's failure state is complete before it.
+    std::vector<std::uint32_t> fail (a->accepting.size (), 0);
+    std::vector<std::uint32_t> queue;
+    for (std::size_t cls = 0; cls != classCount; ++cls)
+    {
+        std::uint32_t & target = a->next[cls];
+        if (target == absent)
+            target = 0;
+        else
+            queue.push_back (target);
+    }
+
+    for (std::size_t i = 0; i != queue.size (); ++i)
+    {
+        std::uint32_t const state = queue[i];
+        if (a->accepting[fail[state]])
+            a->accepting[state] = true;
+
+        for (std::size_t cls = 0; cls != classCount; ++cls)
+        {
+            std::uint32_t & target = a->next[state * classCount + cls];
+            std::uint32_t const fallback
+                = a->next[fail[state] * classCount + cls];
+            if (target == absent)
+                target = fallback;
+            else
+            {
+                fail[target] = fallback;
+                queue.push_back (target);
+            }
+        }
+    }
+
+    automaton = std::move (a);
+}
+
+
+FilterResult
+MultiStringMatchFilter::decide(const InternalLoggingEvent& event) const
+{
+    const tstring& message = event.getMessage();
+
+    if(! automaton || message.empty ()) {
+        return NEUTRAL;
+    }
+
+    if(! automaton->matches(message)) {
+        return NEUTRAL;
+    }
+    else {  // we've got a match
+        return (acceptOnMatch ? ACCEPT : DENY);
+    }
+}
+
+
+unsigned
+MultiStringMatchFilter::getRequiredEventFields() const
+{
+    return EVENT_FIELDS_NONE;
+}
+
+
+FilterResult
+MultiStringMatchFilter::preDecide(LogLevel, const log4cplus::tstring&,
+    bool&) const
+{
+    return automaton ? ACCEPT : NEUTRAL;
+}
+
+
 //
 //
 //
@@ -297,8 +753,20 @@ void NDCMatchFilter::init()
 
 FilterResult NDCMatchFilter::decide(const InternalLoggingEvent& event) const
 {
-    const tstring& ndcStr = event.getNDC();
+    return decideNDC(event.getNDC());
+}
+
 
+FilterResult NDCMatchFilter::preDecide(LogLevel, const tstring&,
+    bool& contextual) const
+{
+    contextual = true;
+    return decideNDC(getNDC().get());
+}
+
+
+FilterResult NDCMatchFilter::decideNDC(const tstring& ndcStr) const
+{
     if(neutralOnEmpty && (ndcToMatch.empty () || ndcStr.empty()))
     {
         return NEUTRAL;
@@ -310,6 +778,14 @@ FilterResult NDCMatchFilter::decide(const InternalLoggingEvent& event) const
     return (acceptOnMatch ? DENY : ACCEPT);
 }
 
+
+unsigned
+NDCMatchFilter::getRequiredEventFields() const
+{
+    return EVENT_FIELD_NDC;
+}
+
+
 //
 // MDC Match filter
 //
@@ -326,6 +802,8 @@ MDCMatchFilter::MDCMatchFilter(const helpers::Properties& properties)
     properties.getBool (neutralOnEmpty,LOG4CPLUS_TEXT("NeutralOnEmpty"));
     mdcValueToMatch = properties.getProperty(LOG4CPLUS_TEXT("MDCValueToMatch"));
     mdcKeyToMatch = properties.getProperty(LOG4CPLUS_TEXT("MDCKeyToMatch"));
+    if (! mdcKeyToMatch.empty ())
+        mdcKeyHandle = MDC::registerKey (mdcKeyToMatch);
 }
 
 
@@ -341,8 +819,25 @@ FilterResult MDCMatchFilter::decide(const InternalLoggingEvent& event) const
     if(neutralOnEmpty && (mdcKeyToMatch.empty() || mdcValueToMatch.empty()))
         return NEUTRAL;
 
-    const tstring& mdcStr = event.getMDC(mdcKeyToMatch);
+    return decideMDC(event.getMDC(mdcKeyHandle));
+}
+
 
+FilterResult MDCMatchFilter::preDecide(LogLevel, const tstring&,
+    bool& contextual) const
+{
+    if(neutralOnEmpty && (mdcKeyToMatch.empty() || mdcValueToMatch.empty()))
+        return NEUTRAL;
+
+    contextual = true;
+    tstring mdcStr;
+    getMDC().get(&mdcStr, mdcKeyHandle);
+    return decideMDC(mdcStr);
+}
+
+
+FilterResult MDCMatchFilter::decideMDC(const tstring& mdcStr) const
+{
     if(neutralOnEmpty && mdcStr.empty())
         return NEUTRAL;
 
@@ -353,6 +848,365 @@ FilterResult MDCMatchFilter::decide(const InternalLoggingEvent& event) const
 }
 
 
+unsigned
+MDCMatchFilter::getRequiredEventFields() const
+{
+    return EVENT_FIELD_MDC;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RateLimitFilter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+std::unique_ptr<InternalLoggingEvent>
+makeSummary (InternalLoggingEvent const & event, tstring const & loggerName,
+    LogLevel ll, tstring const & message)
+{
+    return std::make_unique<InternalLoggingEvent> (loggerName, ll,
+        tstring_view (), MappedDiagnosticContextMap (), message,
+        event.getThread (), event.getThread2 (), event.getTimestamp (),
+        tstring_view (), 0);
+}
+
+} // namespace
+
+
+RateLimitFilter::RateLimitFilter()
+    : perCallSite (true)
+{
+    init (0, 0, 1);
+}
+
+
+RateLimitFilter::RateLimitFilter(const helpers::Properties& properties)
+    : perCallSite (true)
+{
+    unsigned rate = 0;
+    properties.getUInt (rate, LOG4CPLUS_TEXT("Rate"));
+    unsigned burst = rate;
+    properties.getUInt (burst, LOG4CPLUS_TEXT("Burst"));
+    unsigned bucketCount = 256;
+    properties.getUInt (bucketCount, LOG4CPLUS_TEXT("Buckets"));
+    properties.getBool (perCallSite, LOG4CPLUS_TEXT("PerCallSite"));
+    init (rate, burst, bucketCount);
+}
+
+
+RateLimitFilter::RateLimitFilter(unsigned rate, unsigned burst,
+    bool perCallSite_, unsigned bucketCount)
+    : perCallSite (perCallSite_)
+{
+    init (rate, burst, bucketCount);
+}
+
+
+RateLimitFilter::~RateLimitFilter() = default;
+
+
+void
+RateLimitFilter::init(unsigned rate, unsigned burst, unsigned bucketCount)
+{
+    std::int64_t const second = 1000000000;
+    interval = rate == 0 ? 0 : std::max<std::int64_t> (second / rate, 1);
+    tolerance = interval * std::max (burst, 1u);
+
+    std::size_t size = 1;
+    while (size < bucketCount && size < (std::size_t (1) << 20))
+        size <<= 1;
+    bucketMask = size - 1;
+    buckets = std::make_unique<std::atomic<std::int64_t>[]> (size);
+    for (std::size_t i = 0; i != size; ++i)
+        buckets[i].store (std::numeric_limits<std::int64_t>::min (),
+            std::memory_order_relaxed);
+    denied.store (0, std::memory_order_relaxed);
+}
+
+
+FilterResult
+RateLimitFilter::decide(const InternalLoggingEvent& event) const
+{
+    if (interval == 0)
+        return NEUTRAL;
+
+    std::size_t hash;
+    if (perCallSite)
+        hash = std::hash<tstring> () (event.getFile ())
+            ^ (static_cast<std::size_t>(event.getLine ())
+                * std::size_t (0x9E3779B97F4A7C15ull));
+    else
+        hash = std::hash<tstring> () (event.getLoggerName ());
+    std::atomic<std::int64_t> & bucket = buckets[hash & bucketMask];
+
+    std::int64_t const now = std::chrono::duration_cast<
+        std::chrono::nanoseconds> (
+            event.getTimestamp ().time_since_epoch ()).count ();
+    std::int64_t tat = bucket.load (std::memory_order_relaxed);
+    for (;;)
+    {
+        std::int64_t const newTat = std::max (tat, now) + interval;
+        if (newTat - now > tolerance)
+        {
+            denied.fetch_add (1, std::memory_order_relaxed);
+            return DENY;
+        }
+
+        if (bucket.compare_exchange_weak (tat, newTat,
+                std::memory_order_relaxed))
+            return NEUTRAL;
+    }
+}
+
+
+unsigned
+RateLimitFilter::getRequiredEventFields() const
+{
+    return perCallSite ? EVENT_FIELD_FILE : EVENT_FIELDS_NONE;
+}
+
+
+std::unique_ptr<InternalLoggingEvent>
+RateLimitFilter::takeSummary(const InternalLoggingEvent& event) const
+{
+    if (denied.load (std::memory_order_relaxed) == 0)
+        return nullptr;
+
+    std::size_t const count = denied.exchange (0, std::memory_order_relaxed);
+    if (count == 0)
+        return nullptr;
+
+    return makeSummary (event, event.getLoggerName (), WARN_LOG_LEVEL,
+        LOG4CPLUS_TEXT ("Rate limit denied ")
+        + helpers::convertIntegerToString (count)
+        + LOG4CPLUS_TEXT (" messages."));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// DuplicateSuppressionFilter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+std::size_t
+hashEvent (InternalLoggingEvent const & event)
+{
+    std::hash<tstring> const hasher;
+    std::size_t const hash = hasher (event.getMessage ())
+        ^ (hasher (event.getLoggerName ()) * 31)
+        ^ static_cast<std::size_t>(event.getLogLevel ());
+    // 0 is reserved for no event.
+    return hash == 0 ? 1 : hash;
+}
+
+} // namespace
+
+
+DuplicateSuppressionFilter::DuplicateSuppressionFilter()
+    : lastHash (0)
+    , repeated (0)
+    , summaryLogLevel (NOT_SET_LOG_LEVEL)
+{ }
+
+
+DuplicateSuppressionFilter::DuplicateSuppressionFilter(
+    const helpers::Properties&)
+    : DuplicateSuppressionFilter ()
+{ }
+
+
+DuplicateSuppressionFilter::~DuplicateSuppressionFilter() = default;
+
+
+FilterResult
+DuplicateSuppressionFilter::decide(const InternalLoggingEvent& event) const
+{
+    if (hashEvent (event) != lastHash.load (std::memory_order_acquire))
+        return NEUTRAL;
+
+    // Remember whose repetitions these are before they are counted, so
+    // that takeSummary() finding them counted finds the logger as well.
+    if (repeated.load (std::memory_order_acquire) == 0)
+    {
+        thread::MutexGuard guard (summaryMutex);
+        summaryLogger = event.getLoggerName ();
+        summaryLogLevel = event.getLogLevel ();
+    }
+
+    repeated.fetch_add (1, std::memory_order_acq_rel);
+    return DENY;
+}
+
+
+unsigned
+DuplicateSuppressionFilter::getRequiredEventFields() const
+{
+    return EVENT_FIELDS_NONE;
+}
+
+
+std::unique_ptr<InternalLoggingEvent>
+DuplicateSuppressionFilter::takeSummary(
+    const InternalLoggingEvent& event) const
+{
+    lastHash.store (hashEvent (event), std::memory_order_release);
+    if (repeated.load (std::memory_order_acquire) == 0)
+        return nullptr;
+
+    std::size_t const count = repeated.exchange (0, std::memory_order_acq_rel);
+    if (count == 0)
+        return nullptr;
+
+    thread::MutexGuard guard (summaryMutex);
+    return makeSummary (event, summaryLogger, summaryLogLevel,
+        LOG4CPLUS_TEXT ("Last message repeated ")
+        + helpers::convertIntegerToString (count)
+        + LOG4CPLUS_TEXT (" times."));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SamplingFilter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+//! FNV-1a over characters of <code>str</code> followed by SplitMix64
+//! finalizer, which spreads the hash over the upper bits compared with
+//! sampling threshold.
+std::uint64_t
+hashSamplingKey (tstring const & str)
+{
+    std::uint64_t hash = 0xCBF29CE484222325ull;
+    for (tchar const ch : str)
+    {
+        hash ^= static_cast<std::make_unsigned_t<tchar>>(ch);
+        hash *= 0x100000001B3ull;
+    }
+
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBull;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+} // namespace
+
+
+SamplingFilter::SamplingFilter()
+    : acceptOnMatch (false)
+    , neutralOnEmpty (true)
+{
+    init (tstring (), 1.0);
+}
+
+
+SamplingFilter::SamplingFilter(const helpers::Properties& properties)
+    : acceptOnMatch (false)
+    , neutralOnEmpty (true)
+{
+    properties.getBool (acceptOnMatch, LOG4CPLUS_TEXT("AcceptOnMatch"));
+    properties.getBool (neutralOnEmpty, LOG4CPLUS_TEXT("NeutralOnEmpty"));
+
+    double ratio = 1.0;
+    tstring const & ratioStr = properties.getProperty (LOG4CPLUS_TEXT("Ratio"));
+    if (! ratioStr.empty ())
+    {
+        std::istringstream iss (LOG4CPLUS_TSTRING_TO_STRING (ratioStr));
+        iss.imbue (std::locale::classic ());
+        if (! (iss >> ratio) || ratio < 0 || ratio > 1)
+        {
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("SamplingFilter: Ratio is not a number")
+                LOG4CPLUS_TEXT (" between 0 and 1: ") + ratioStr);
+            ratio = 1.0;
+        }
+    }
+
+    init (properties.getProperty (LOG4CPLUS_TEXT("MDCKey")), ratio);
+}
+
+
+SamplingFilter::SamplingFilter(const tstring& mdcKey_, double ratio,
+    bool acceptOnMatch_)
+    : acceptOnMatch (acceptOnMatch_)
+    , neutralOnEmpty (true)
+{
+    init (mdcKey_, ratio);
+}
+
+
+void
+SamplingFilter::init(const tstring& mdcKey_, double ratio)
+{
+    mdcKey = mdcKey_;
+    if (! mdcKey.empty ())
+        mdcKeyHandle = MDC::registerKey (mdcKey);
+
+    sampleAll = ! (ratio < 1.0);
+    // 2^64 as double; the product is below it unless sampleAll is set.
+    threshold = ratio > 0 && ! sampleAll
+        ? static_cast<std::uint64_t>(ratio * 18446744073709551616.0)
+        : 0;
+}
+
+
+FilterResult
+SamplingFilter::decide(const InternalLoggingEvent& event) const
+{
+    if (mdcKey.empty ())
+        return NEUTRAL;
+
+    return decideValue (&event.getMDC (mdcKeyHandle));
+}
+
+
+FilterResult
+SamplingFilter::preDecide(LogLevel, const tstring&, bool& contextual) const
+{
+    if (mdcKey.empty ())
+        return NEUTRAL;
+
+    contextual = true;
+    MappedDiagnosticContextPtr const snapshot = getMDC ().getSnapshot ();
+    return decideValue (snapshot ? snapshot->get (mdcKeyHandle) : nullptr);
+}
+
+
+FilterResult
+SamplingFilter::decideValue(const tstring* value) const
+{
+    static tstring const empty;
+    if (! value)
+        value = &empty;
+
+    if (neutralOnEmpty && value->empty ())
+        return NEUTRAL;
+
+    if (! sampleAll && hashSamplingKey (*value) >= threshold)
+        return DENY;
+
+    return acceptOnMatch ? ACCEPT : NEUTRAL;
+}
+
+
+unsigned
+SamplingFilter::getRequiredEventFields() const
+{
+    return EVENT_FIELD_MDC;
+}
+
+
+
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 CATCH_TEST_CASE ("Filter", "[filter]")
 {
@@ -484,6 +1338,185 @@ CATCH_TEST_CASE ("Filter", "[filter]")
         }
     }
 
+    CATCH_SECTION ("multi string match filter")
+    {
+        CATCH_SECTION ("no strings to match is neutral")
+        {
+            filter = new MultiStringMatchFilter;
+            CATCH_REQUIRE (filter->decide (info_ev) == NEUTRAL);
+            CATCH_REQUIRE (filter->decide (error_ev) == NEUTRAL);
+        }
+
+        CATCH_SECTION ("accept on any match")
+        {
+            helpers::Properties props;
+            props.setProperty (LOG4CPLUS_TEXT ("StringsToMatch"),
+                LOG4CPLUS_TEXT ("nonexistent,warn,rror l"));
+            filter = new MultiStringMatchFilter (props);
+            CATCH_REQUIRE (filter->decide (empty_ev) == NEUTRAL);
+            CATCH_REQUIRE (filter->decide (info_ev) == NEUTRAL);
+            CATCH_REQUIRE (filter->decide (warn_ev) == ACCEPT);
+            CATCH_REQUIRE (filter->decide (error_ev) == ACCEPT);
+            CATCH_REQUIRE (filter->decide (fatal_ev) == NEUTRAL);
+        }
+
+        CATCH_SECTION ("overlapping strings")
+        {
+            // "fatal lo" fails over into "al log" of the second string.
+            filter = new MultiStringMatchFilter (
+                {LOG4CPLUS_TEXT ("fatal lox"), LOG4CPLUS_TEXT ("al log")},
+                false);
+            CATCH_REQUIRE (filter->decide (fatal_ev) == DENY);
+            CATCH_REQUIRE (filter->decide (info_ev) == NEUTRAL);
+        }
+
+        CATCH_SECTION ("custom separator")
+        {
+            helpers::Properties props;
+            props.setProperty (LOG4CPLUS_TEXT ("StringsToMatch"),
+                LOG4CPLUS_TEXT ("debug|info"));
+            props.setProperty (LOG4CPLUS_TEXT ("Separator"),
+                LOG4CPLUS_TEXT ("|"));
+            props.setProperty (LOG4CPLUS_TEXT ("AcceptOnMatch"),
+                LOG4CPLUS_TEXT ("false"));
+            filter = new MultiStringMatchFilter (props);
+            CATCH_REQUIRE (filter->decide (debug_ev) == DENY);
+            CATCH_REQUIRE (filter->decide (info_ev) == DENY);
+            CATCH_REQUIRE (filter->decide (warn_ev) == NEUTRAL);
+        }
+    }
+
+    CATCH_SECTION ("rate limit filter")
+    {
+        helpers::Time const start = helpers::now ();
+        auto make_event = [&] (helpers::Time time, int line)
+        {
+            return InternalLoggingEvent (log.getName (), WARN_LOG_LEVEL,
+                LOG4CPLUS_TEXT (""), MappedDiagnosticContextMap (),
+                LOG4CPLUS_TEXT ("rate limited message"), LOG4CPLUS_TEXT (""),
+                LOG4CPLUS_TEXT (""), time, LOG4CPLUS_TEXT ("file.cxx"), line);
+        };
+
+        CATCH_SECTION ("no rate is neutral")
+        {
+            filter = new RateLimitFilter;
+            for (int i = 0; i != 10; ++i)
+                CATCH_REQUIRE (filter->decide (make_event (start, 1))
+                    == NEUTRAL);
+            CATCH_REQUIRE (! filter->takeSummary (info_ev));
+        }
+
+        CATCH_SECTION ("deny over burst")
+        {
+            helpers::Properties props;
+            props.setProperty (LOG4CPLUS_TEXT ("Rate"), LOG4CPLUS_TEXT ("1"));
+            props.setProperty (LOG4CPLUS_TEXT ("Burst"),
+                LOG4CPLUS_TEXT ("2"));
+            filter = new RateLimitFilter (props);
+            CATCH_REQUIRE (filter->decide (make_event (start, 1)) == NEUTRAL);
+            CATCH_REQUIRE (filter->decide (make_event (start, 1)) == NEUTRAL);
+            CATCH_REQUIRE (filter->decide (make_event (start, 1)) == DENY);
+            CATCH_REQUIRE (filter->decide (make_event (start, 1)) == DENY);
+
+            // Other call site has its own bucket.
+            CATCH_REQUIRE (filter->decide (make_event (start, 2)) == NEUTRAL);
+
+            // The bucket refills one event per second.
+            helpers::Time const later = start + std::chrono::seconds (1);
+            CATCH_REQUIRE (filter->decide (make_event (later, 1)) == NEUTRAL);
+            CATCH_REQUIRE (filter->decide (make_event (later, 1)) == DENY);
+
+            auto const summary = filter->takeSummary (info_ev);
+            CATCH_REQUIRE (summary);
+            CATCH_REQUIRE (summary->getMessage ()
+                == LOG4CPLUS_TEXT ("Rate limit denied 3 messages."));
+            CATCH_REQUIRE (! filter->takeSummary (info_ev));
+        }
+
+        CATCH_SECTION ("per logger")
+        {
+            filter = new RateLimitFilter (1, 1, false);
+            CATCH_REQUIRE (filter->decide (make_event (start, 1)) == NEUTRAL);
+            CATCH_REQUIRE (filter->decide (make_event (start, 2)) == DENY);
+        }
+    }
+
+    CATCH_SECTION ("duplicate suppression filter")
+    {
+        filter = new DuplicateSuppressionFilter;
+        CATCH_REQUIRE (filter->decide (info_ev) == NEUTRAL);
+        CATCH_REQUIRE (! filter->takeSummary (info_ev));
+        CATCH_REQUIRE (filter->decide (info_ev) == DENY);
+        CATCH_REQUIRE (filter->decide (info_ev) == DENY);
+        CATCH_REQUIRE (filter->decide (warn_ev) == NEUTRAL);
+
+        auto const summary = filter->takeSummary (warn_ev);
+        CATCH_REQUIRE (summary);
+        CATCH_REQUIRE (summary->getLogLevel () == INFO_LOG_LEVEL);
+        CATCH_REQUIRE (summary->getLoggerName () == log.getName ());
+        CATCH_REQUIRE (summary->getMessage ()
+            == LOG4CPLUS_TEXT ("Last message repeated 2 times."));
+
+        CATCH_REQUIRE (filter->decide (info_ev) == NEUTRAL);
+        CATCH_REQUIRE (filter->decide (warn_ev) == DENY);
+    }
+
+    CATCH_SECTION ("sampling filter")
+    {
+        tstring const key = LOG4CPLUS_TEXT ("traceId");
+        bool contextual = false;
+
+        CATCH_SECTION ("empty MDC value is neutral")
+        {
+            filter = new SamplingFilter (key, 0.0);
+            CATCH_REQUIRE (filter->decide (debug_ev) == NEUTRAL);
+            CATCH_REQUIRE (filter->preDecide (DEBUG_LOG_LEVEL, log.getName (),
+                contextual) == NEUTRAL);
+            CATCH_REQUIRE (contextual);
+        }
+
+        CATCH_SECTION ("ratio is respected")
+        {
+            helpers::Properties props;
+            props.setProperty (LOG4CPLUS_TEXT ("MDCKey"), key);
+            props.setProperty (LOG4CPLUS_TEXT ("Ratio"),
+                LOG4CPLUS_TEXT ("0.25"));
+            props.setProperty (LOG4CPLUS_TEXT ("AcceptOnMatch"),
+                LOG4CPLUS_TEXT ("true"));
+            filter = new SamplingFilter (props);
+
+            int sampled = 0;
+            for (int i = 0; i != 4000; ++i)
+            {
+                getMDC ().put (key, helpers::convertIntegerToString (i));
+                InternalLoggingEvent const ev (log.getName (),
+                    DEBUG_LOG_LEVEL, LOG4CPLUS_TEXT ("traced message"),
+                    __FILE__, __LINE__);
+                FilterResult const result = filter->decide (ev);
+                CATCH_REQUIRE (result != NEUTRAL);
+                CATCH_REQUIRE (filter->preDecide (DEBUG_LOG_LEVEL,
+                    log.getName (), contextual) == result);
+                sampled += result == ACCEPT;
+            }
+            getMDC ().clear ();
+
+            CATCH_REQUIRE (sampled > 800);
+            CATCH_REQUIRE (sampled < 1200);
+        }
+
+        CATCH_SECTION ("ratio of 0 and 1")
+        {
+            getMDC ().put (key, LOG4CPLUS_TEXT ("4bf92f3577b34da6"));
+            InternalLoggingEvent const ev (log.getName (), DEBUG_LOG_LEVEL,
+                LOG4CPLUS_TEXT ("traced message"), __FILE__, __LINE__);
+            filter = new SamplingFilter (key, 0.0);
+            CATCH_REQUIRE (filter->decide (ev) == DENY);
+            filter = new SamplingFilter (key, 1.0);
+            CATCH_REQUIRE (filter->decide (ev) == NEUTRAL);
+            getMDC ().clear ();
+        }
+    }
+
     CATCH_SECTION ("function filter")
     {
         filter = new FunctionFilter (
@@ -706,6 +1739,101 @@ CATCH_TEST_CASE ("Filter", "[filter]")
             }
         }
     }
+
+    CATCH_SECTION ("required event fields")
+    {
+        CATCH_REQUIRE (getRequiredEventFields (nullptr) == EVENT_FIELDS_NONE);
+
+        filter = new LogLevelMatchFilter;
+        CATCH_REQUIRE (getRequiredEventFields (filter.get ())
+            == EVENT_FIELDS_NONE);
+
+        filter->appendFilter (FilterPtr (new NDCMatchFilter));
+        filter->appendFilter (FilterPtr (new MDCMatchFilter));
+        CATCH_REQUIRE (getRequiredEventFields (filter.get ())
+            == (EVENT_FIELD_NDC | EVENT_FIELD_MDC));
+
+        filter->appendFilter (FilterPtr (new FunctionFilter (
+            [] (InternalLoggingEvent const &) { return NEUTRAL; })));
+        CATCH_REQUIRE (getRequiredEventFields (filter.get ())
+            == EVENT_FIELDS_ALL);
+    }
+}
+
+
+CATCH_TEST_CASE ("FilterProgram", "[filter]")
+{
+    struct InvertedMatchFilter
+        : LogLevelMatchFilter
+    {
+        explicit InvertedMatchFilter (helpers::Properties const & p)
+            : LogLevelMatchFilter (p)
+        { }
+
+        FilterResult decide (InternalLoggingEvent const & ev) const override
+        {
+            FilterResult const result = LogLevelMatchFilter::decide (ev);
+            return result == NEUTRAL ? NEUTRAL
+                : result == ACCEPT ? DENY : ACCEPT;
+        }
+    };
+
+    std::vector<InternalLoggingEvent> events;
+    LogLevel const levels[] = {TRACE_LOG_LEVEL, DEBUG_LOG_LEVEL,
+        INFO_LOG_LEVEL, WARN_LOG_LEVEL, ERROR_LOG_LEVEL, FATAL_LOG_LEVEL};
+    tstring const messages[] = {LOG4CPLUS_TEXT ("plain"),
+        LOG4CPLUS_TEXT ("secret plain"), LOG4CPLUS_TEXT ("noise")};
+    for (LogLevel ll : levels)
+        for (tstring const & msg : messages)
+            events.emplace_back (LOG4CPLUS_TEXT ("test"), ll, msg, __FILE__,
+                __LINE__);
+
+    helpers::Properties debug;
+    debug.setProperty (LOG4CPLUS_TEXT ("LogLevelToMatch"),
+        LOG4CPLUS_TEXT ("DEBUG"));
+    helpers::Properties range;
+    range.setProperty (LOG4CPLUS_TEXT ("LogLevelMin"),
+        LOG4CPLUS_TEXT ("INFO"));
+    range.setProperty (LOG4CPLUS_TEXT ("LogLevelMax"),
+        LOG4CPLUS_TEXT ("ERROR"));
+    range.setProperty (LOG4CPLUS_TEXT ("AcceptOnMatch"),
+        LOG4CPLUS_TEXT ("false"));
+    helpers::Properties secret;
+    secret.setProperty (LOG4CPLUS_TEXT ("StringToMatch"),
+        LOG4CPLUS_TEXT ("secret"));
+    secret.setProperty (LOG4CPLUS_TEXT ("AcceptOnMatch"),
+        LOG4CPLUS_TEXT ("false"));
+
+    FilterPtr chain (new StringMatchFilter (secret));
+    chain->appendFilter (FilterPtr (new InvertedMatchFilter (debug)));
+    chain->appendFilter (FilterPtr (new FunctionFilter (
+        [] (InternalLoggingEvent const & ev)
+        {
+            return ev.getMessage () == LOG4CPLUS_TEXT ("noise")
+                ? DENY : NEUTRAL;
+        })));
+    chain->appendFilter (FilterPtr (new LogLevelRangeFilter (range)));
+
+    auto const same_results = [&] (FilterProgram const & program)
+    {
+        for (InternalLoggingEvent const & ev : events)
+            if (program.check (ev) != checkFilter (chain.get (), ev))
+                return false;
+        return true;
+    };
+
+    FilterProgram const program (chain.get ());
+    CATCH_REQUIRE (program.getChain () == chain.get ());
+    CATCH_REQUIRE (same_results (program));
+    CATCH_REQUIRE (program.check (events[6]) == ACCEPT);
+
+    // Filters appended after compilation are still consulted.
+    chain->appendFilter (FilterPtr (new DenyAllFilter));
+    CATCH_REQUIRE (same_results (program));
+    CATCH_REQUIRE (program.check (events[6]) == DENY);
+    CATCH_REQUIRE (same_results (FilterProgram (chain.get ())));
+
+    CATCH_REQUIRE (FilterProgram ().check (events[0]) == ACCEPT);
 }
 
 #endif
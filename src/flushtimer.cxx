@@ -0,0 +1,438 @@
+// Module:  Log4cplus
+// File:    flushtimer.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/config.hxx>
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+#include <log4cplus/internal/internal.h>
+#include <log4cplus/thread/threads.h>
+#include <bit>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <atomic>
+#endif
+
+
+namespace log4cplus { namespace internal {
+
+
+namespace
+{
+
+//! Hierarchical timer wheel on one thread shared by appenders with
+//! flush intervals and other periodic tasks. Ticks are milliseconds.
+//! Level <i>L</i> has 64 slots of 64<sup><i>L</i></sup> ticks each;
+//! timers are moved to lower levels as their time approaches, so
+//! adding, removing and expiring a timer takes constant time and the
+//! thread wakes up only when a timer is due or has to be moved. Timers
+//! beyond the last level wait in an overflow list. The thread runs only
+//! while there are registered timers.
+class timer_wheel
+{
+public:
+    void
+    add (void const * owner, std::chrono::milliseconds interval,
+        std::function<void ()> callback)
+    {
+        std::uint64_t const ticks = (std::max) (
+            static_cast<std::uint64_t> (interval.count ()), std::uint64_t (1));
+        auto t = std::make_unique<timer> ();
+        t->owner = owner;
+        t->callback = std::move (callback);
+        t->interval = ticks;
+
+        std::unique_lock<std::mutex> lock (mtx);
+        t->due = now_tick () + ticks;
+        link (t.get ());
+        timers.emplace (owner, std::move (t));
+
+        if (! running)
+        {
+            // Previous thread, if any, has already left run().
+            if (thread.joinable ())
+                thread.join ();
+
+            running = true;
+            thread = std::thread ([this] { run (); });
+        }
+        else
+            cond.notify_one ();
+    }
+
+    void
+    remove (void const * owner)
+    {
+        std::unique_lock<std::mutex> lock (mtx);
+        auto const range = timers.equal_range (owner);
+        for (auto it = range.first; it != range.second; )
+        {
+            timer * const t = it->second.get ();
+            if (t->linked)
+            {
+                unlink (t);
+                it = timers.erase (it);
+            }
+            else
+            {
+                // Expiring on the timer thread, which drops it.
+                t->cancelled = true;
+                ++it;
+            }
+        }
+
+        // A callback that is running has to finish first, unless it is
+        // the one removing itself.
+        if (std::this_thread::get_id () != thread.get_id ())
+            done_cond.wait (lock,
+                [&] { return ! current_timer
+                    || current_timer->owner != owner; });
+        cond.notify_one ();
+    }
+
+    static timer_wheel &
+    get ()
+    {
+        // Intentionally leaked so that appenders destroyed during static
+        // destruction can still unregister.
+        static timer_wheel * const wheel = new timer_wheel;
+        return *wheel;
+    }
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    static unsigned const slot_bits = 6;
+    static std::size_t const slot_count = std::size_t (1) << slot_bits;
+    static std::size_t const level_count = 4;
+
+    struct timer
+    {
+        void const * owner = nullptr;
+        std::function<void ()> callback;
+        std::uint64_t interval = 0;
+        std::uint64_t due = 0;
+        timer * prev = nullptr;
+        timer * next = nullptr;
+        //! Slot list <code>timer</code> is in, if linked.
+        timer ** slot = nullptr;
+        std::uint64_t * occupied = nullptr;
+        std::size_t index = 0;
+        bool linked = false;
+        bool cancelled = false;
+    };
+
+    std::uint64_t
+    now_tick () const
+    {
+        return static_cast<std::uint64_t> (
+            std::chrono::duration_cast<std::chrono::milliseconds> (
+                clock::now () - epoch).count ());
+    }
+
+    //! Puts <code>t</code> on the lowest level whose slots still
+    //! separate its due tick from the current tick.
+    void
+    link (timer * t)
+    {
+        if (t->due <= current)
+            t->due = current + 1;
+
+        timer ** list = &overflow;
+        std::uint64_t * occupied_mask = nullptr;
+        std::size_t index = 0;
+        for (std::size_t level = 0; level != level_count; ++level)
+        {
+            unsigned const shift = slot_bits * static_cast<unsigned> (level);
+            if ((t->due >> (shift + slot_bits))
+                == (current >> (shift + slot_bits)))
+            {
+                index = static_cast<std::size_t> (
+                    (t->due >> shift) & (slot_count - 1));
+                list = &wheel[level][index];
+                occupied_mask = &occupied[level];
+                break;
+            }
+        }
+
+        t->prev = nullptr;
+        t->next = *list;
+        if (t->next)
+            t->next->prev = t;
+        *list = t;
+        t->slot = list;
+        t->occupied = occupied_mask;
+        t->index = index;
+        t->linked = true;
+        if (occupied_mask)
+            *occupied_mask |= std::uint64_t (1) << index;
+    }
+
+    void
+    unlink (timer * t)
+    {
+        if (t->prev)
+            t->prev->next = t->next;
+        else
+            *t->slot = t->next;
+        if (t->next)
+            t->next->prev = t->prev;
+        if (! *t->slot && t->occupied)
+            *t->occupied &= ~(std::uint64_t (1) << t->index);
+        t->linked = false;
+    }
+
+    //! Unlinks and returns timers of <code>list</code>.
+    std::vector<timer *>
+    take (timer ** list)
+    {
+        std::vector<timer *> taken;
+        while (timer * const t = *list)
+        {
+            unlink (t);
+            taken.push_back (t);
+        }
+        return taken;
+    }
+
+    //! \return Tick at which the earliest timer expires or has to be
+    //! moved to a lower level, or zero when there is none.
+    std::uint64_t
+    next_event () const
+    {
+        for (std::size_t level = 0; level != level_count; ++level)
+        {
+            unsigned const shift = slot_bits * static_cast<unsigned> (level);
+            if (occupied[level] == 0)
+                continue;
+
+            // Occupied slots all follow the current one.
+            std::size_t const index = static_cast<std::size_t> (
+                std::countr_zero (occupied[level]));
+            std::uint64_t const block_mask
+                = (std::uint64_t (1) << (shift + slot_bits)) - 1;
+            return (current & ~block_mask)
+                | (std::uint64_t (index) << shift);
+        }
+
+        if (overflow)
+        {
+            unsigned const shift
+                = slot_bits * static_cast<unsigned> (level_count);
+            return ((current >> shift) + 1) << shift;
+        }
+
+        return 0;
+    }
+
+    //! Advances the current tick to <code>target</code>, moving timers
+    //! down and collecting expired ones into <code>expired</code>.
+    void
+    advance (std::uint64_t target, std::vector<timer *> & expired)
+    {
+        while (current < target)
+        {
+            // Jump over empty slots to the next event.
+            std::uint64_t const next = next_event ();
+            if (next == 0 || next > target)
+            {
+                current = target;
+                return;
+            }
+            current = next;
+
+            // Move down timers of higher levels whose slot begins now.
+            for (std::size_t level = level_count; level != 0; --level)
+            {
+                unsigned const shift
+                    = slot_bits * static_cast<unsigned> (level);
+                if ((current & ((std::uint64_t (1) << shift) - 1)) != 0)
+                    continue;
+
+                timer ** const list = level == level_count
+                    ? &overflow
+                    : &wheel[level][static_cast<std::size_t> (
+                        (current >> shift) & (slot_count - 1))];
+                for (timer * t : take (list))
+                    link (t);
+            }
+
+            std::vector<timer *> const due = take (
+                &wheel[0][static_cast<std::size_t> (
+                    current & (slot_count - 1))]);
+            expired.insert (expired.end (), due.begin (), due.end ());
+        }
+    }
+
+    void
+    erase (timer * t)
+    {
+        auto const range = timers.equal_range (t->owner);
+        for (auto it = range.first; it != range.second; ++it)
+            if (it->second.get () == t)
+            {
+                timers.erase (it);
+                return;
+            }
+    }
+
+    void
+    run ()
+    {
+        thread::blockAllSignals ();
+        thread::applyBackgroundThreadSettings (LOG4CPLUS_TEXT ("timer"));
+
+        std::vector<timer *> expired;
+        std::unique_lock<std::mutex> lock (mtx);
+        while (! timers.empty ())
+        {
+            advance (now_tick (), expired);
+            for (timer * t : expired)
+            {
+                if (! t->cancelled)
+                {
+                    // Callbacks run unlocked; remove() waits for them.
+                    current_timer = t;
+                    lock.unlock ();
+                    t->callback ();
+                    lock.lock ();
+                    current_timer = nullptr;
+                    done_cond.notify_all ();
+                }
+
+                if (t->cancelled)
+                    erase (t);
+                else
+                {
+                    t->due = now_tick () + t->interval;
+                    link (t);
+                }
+            }
+            expired.clear ();
+
+            if (timers.empty ())
+                break;
+
+            std::uint64_t const next = next_event ();
+            cond.wait_until (lock,
+                epoch + std::chrono::milliseconds (next));
+        }
+
+        running = false;
+    }
+
+    clock::time_point const epoch = clock::now ();
+    //! Tick up to which timers have been expired.
+    std::uint64_t current = 0;
+    timer * wheel[level_count][slot_count] {};
+    //! Bit <i>i</i> of element <i>L</i> is set when slot <i>i</i> of
+    //! level <i>L</i> holds timers.
+    std::uint64_t occupied[level_count] {};
+    timer * overflow = nullptr;
+    std::unordered_multimap<void const *, std::unique_ptr<timer>> timers;
+    timer * current_timer = nullptr;
+
+    std::mutex mtx;
+    std::condition_variable cond;
+    std::condition_variable done_cond;
+    std::thread thread;
+    bool running = false;
+};
+
+} // namespace
+
+
+void
+add_timer (void const * owner, std::chrono::milliseconds interval,
+    std::function<void ()> callback)
+{
+    timer_wheel::get ().add (owner, interval, std::move (callback));
+}
+
+
+void
+remove_timer (void const * owner)
+{
+    timer_wheel::get ().remove (owner);
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Timer wheel", "[timer]")
+{
+    // Intervals spanning the first three levels.
+    std::chrono::milliseconds const intervals[] {
+        std::chrono::milliseconds (3), std::chrono::milliseconds (70),
+        std::chrono::milliseconds (5000)};
+    std::atomic<unsigned> calls[3] {};
+    auto const start = std::chrono::steady_clock::now ();
+    for (std::size_t i = 0; i != 3; ++i)
+        add_timer (&calls[i], intervals[i], [&calls, i] { ++calls[i]; });
+
+    std::this_thread::sleep_for (std::chrono::milliseconds (300));
+    remove_timer (&calls[0]);
+    remove_timer (&calls[1]);
+    unsigned const fast = calls[0];
+    unsigned const medium = calls[1];
+    auto const elapsed = std::chrono::steady_clock::now () - start;
+
+    CATCH_REQUIRE (fast >= 10);
+    CATCH_REQUIRE (fast <= elapsed / intervals[0]);
+    CATCH_REQUIRE (medium >= 1);
+    CATCH_REQUIRE (medium <= elapsed / intervals[1]);
+    CATCH_REQUIRE (calls[2] == 0);
+
+    // Removed timers are not called again.
+    std::this_thread::sleep_for (std::chrono::milliseconds (20));
+    CATCH_REQUIRE (calls[0] == fast);
+    remove_timer (&calls[2]);
+
+    // A callback can remove its own timer.
+    std::atomic<unsigned> self_calls {0};
+    add_timer (&self_calls, std::chrono::milliseconds (1),
+        [&] { ++self_calls; remove_timer (&self_calls); });
+    for (int i = 0; i != 500 && self_calls == 0; ++i)
+        std::this_thread::sleep_for (std::chrono::milliseconds (2));
+    std::this_thread::sleep_for (std::chrono::milliseconds (20));
+    CATCH_REQUIRE (self_calls == 1);
+}
+#endif
+
+
+} } // namespace log4cplus { namespace internal {
+
+#endif // ! defined (LOG4CPLUS_SINGLE_THREADED)
@@ -30,22 +30,37 @@
 #include <log4cplus/initializer.h>
 #include <log4cplus/config/windowsh-inc.h>
 #include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
 #include <log4cplus/ndc.h>
 #include <log4cplus/mdc.h>
 #include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/queue.h>
+#include <log4cplus/helpers/timehelper.h>
 #include <log4cplus/internal/customloglevelmanager.h>
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/thread/impl/tls.h>
+#include <log4cplus/thread/threads.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/thread/lockprofile.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/spi/factory.h>
 #include <log4cplus/hierarchy.h>
-#if ! defined (LOG4CPLUS_SINGLE_THREADED)
-#include "ThreadPool.h"
-#endif
+#include <log4cplus/helpers/stringhelper.h>
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <functional>
 #include <iostream>
 #include <stdexcept>
+#include <thread>
+
+#if defined (LOG4CPLUS_USE_PTHREADS)
+#include <pthread.h>
+#endif
+#if ! defined (_WIN32)
+#include <sys/mman.h>
+#include <cerrno>
+#endif
 
 
 // Forward Declarations
@@ -103,6 +118,50 @@ Initializer::Initializer ()
 }
 
 
+Initializer::Initializer (helpers::EventClock eventClock)
+    : Initializer ()
+{
+    helpers::setEventClock (eventClock);
+}
+
+
+Initializer::Initializer (
+    thread::BackgroundThreadSettings const & threadSettings)
+    : Initializer ()
+{
+    thread::setBackgroundThreadSettings (threadSettings);
+}
+
+
+Initializer::Initializer (ThreadDataPoolSettings const & poolSettings)
+    : Initializer ()
+{
+    setThreadDataPoolSize (poolSettings.size);
+}
+
+
+Initializer::Initializer (ShutdownSettings const & shutdownSettings)
+    : Initializer ()
+{
+    setShutdownTimeout (static_cast<unsigned> (
+        shutdownSettings.timeout.count ()));
+}
+
+
+Initializer::Initializer (MemorySettings const & memorySettings)
+    : Initializer ()
+{
+    setMemoryResource (memorySettings.resource);
+}
+
+
+Initializer::Initializer (RealTimeSettings const & realTimeSettings)
+    : Initializer ()
+{
+    enableRealTimeMode (realTimeSettings);
+}
+
+
 // Forward declaration. Defined in this file.
 void shutdownThreadPool();
 
@@ -128,32 +187,149 @@ Initializer::~Initializer ()
 }
 
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+namespace internal
+{
+
+//! Event waiting to be appended by asynchronous appender.
+struct async_event
+    : async_node
+{
+    spi::InternalLoggingEvent event;
+    //! Event shared by fan-out appenders, see Appender::doAppendShared().
+    //! When set, <code>event</code> is not used.
+    std::shared_ptr<spi::InternalLoggingEvent const> shared;
+    SharedAppenderPtr appender;
+    //! Pool the event is returned to after appending. It is null while
+    //! the event is free and for events not owned by any pool.
+    std::shared_ptr<async_event_pool> pool;
+    //! Time of queueing, set only for appenders with enabled metrics.
+    std::chrono::steady_clock::time_point queued;
+
+    static void *
+    operator new (std::size_t size)
+    {
+        return resource_allocate (size);
+    }
+
+    static void
+    operator delete (void * p, std::size_t size) noexcept
+    {
+        resource_deallocate (p, size);
+    }
+};
+
+} // namespace internal
+#endif
+
+
 namespace
 {
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+//! Lock site of AsyncEventQueue::mutex. Its hold time is not measured,
+//! it would include condition variable waits.
+thread::LockSite async_queue_mutex_site ("AsyncEventQueue::mutex");
+
+
+//! Limits number of events waiting in strands of all asynchronous
+//! appenders. The events themselves are queued in appenders' strands.
+struct AsyncEventQueue
+{
+    std::mutex mutex;
+    std::condition_variable not_full;
+    //! Number of queued events.
+    std::atomic<std::size_t> count {0};
+    //! Producers block while <code>count</code> reaches it.
+    static constexpr std::size_t limit = 100000;
+
+    //! Counters reported by getThreadPoolQueueStats().
+    std::atomic<std::size_t> high_water {0};
+    std::atomic<std::uint64_t> blocked_puts {0};
+    std::atomic<std::uint64_t> blocked_ns {0};
+    std::atomic<std::uint64_t> batches {0};
+    std::atomic<std::uint64_t> batched_events {0};
+    std::atomic<std::size_t> max_batch {0};
+
+    //! See setThreadPoolHighWaterCallback().
+    std::atomic<std::size_t> high_water_threshold {0};
+    std::atomic<bool> high_water_armed {true};
+    std::mutex callback_mutex;
+    thread::HighWaterCallback high_water_callback;
+
+    //! Updates high-water mark and calls high-water callback if it is
+    //! due. Called by producers.
+    void
+    note_depth (std::size_t depth)
+    {
+        std::size_t hwm = high_water.load (std::memory_order_relaxed);
+        while (depth > hwm
+            && ! high_water.compare_exchange_weak (hwm, depth,
+                std::memory_order_relaxed))
+        { }
+
+        std::size_t const threshold
+            = high_water_threshold.load (std::memory_order_relaxed);
+        if (threshold == 0 || depth < threshold
+            || ! high_water_armed.load (std::memory_order_relaxed)
+            || ! high_water_armed.exchange (false, std::memory_order_acq_rel))
+            return;
+
+        thread::HighWaterCallback callback;
+        {
+            std::lock_guard<std::mutex> guard (callback_mutex);
+            callback = high_water_callback;
+        }
+
+        if (callback)
+            callback (depth);
+    }
+
+    //! Accounts batch of <code>size</code> events appended by a strand
+    //! and re-arms high-water callback. Called by workers.
+    void
+    note_batch (std::size_t size)
+    {
+        batches.fetch_add (1, std::memory_order_relaxed);
+        batched_events.fetch_add (size, std::memory_order_relaxed);
+        std::size_t max = max_batch.load (std::memory_order_relaxed);
+        while (size > max
+            && ! max_batch.compare_exchange_weak (max, size,
+                std::memory_order_relaxed))
+        { }
+
+        std::size_t const threshold
+            = high_water_threshold.load (std::memory_order_relaxed);
+        if (threshold != 0
+            && count.load (std::memory_order_relaxed) < threshold)
+            high_water_armed.store (true, std::memory_order_relaxed);
+    }
+};
+#endif
+
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
 static
-std::unique_ptr<progschj::ThreadPool>
+std::unique_ptr<internal::executor>
 instantiate_thread_pool ()
 {
-    log4cplus::thread::SignalsBlocker sb;
 #if defined (LOG4CPLUS_ENABLE_THREAD_POOL)
-    return std::unique_ptr<progschj::ThreadPool>(new progschj::ThreadPool (4));
+    return std::unique_ptr<internal::executor>(new internal::executor (
+        internal::executor::default_pool_size ()));
 #else
-    return std::unique_ptr<progschj::ThreadPool>();
+    return std::unique_ptr<internal::executor>();
 #endif
 }
 #endif
 
 
-//! Helper structure for holding progschj::ThreadPool pointer.
+//! Helper structure for holding internal::executor pointer.
 //! It is necessary to have this so that we can correctly order
-//! destructors between Hierarchy and the progschj::ThreadPool.
+//! destructors between Hierarchy and the internal::executor.
 //! Hierarchy wants to wait for outstading logging to finish
-//! therefore the ThreadPool can only be destroyed after that.
+//! therefore the executor can only be destroyed after that.
 struct ThreadPoolHolder
 {
-    std::atomic<progschj::ThreadPool*> thread_pool{};
+    std::atomic<internal::executor*> thread_pool{};
 
     ThreadPoolHolder () = default;
     ThreadPoolHolder (ThreadPoolHolder const&) = delete;
@@ -170,8 +346,9 @@ struct DefaultContext
 {
     log4cplus::thread::Mutex console_mutex;
     helpers::LogLog loglog;
-    LogLevelManager log_level_manager;
+    // Destroyed after log_level_manager, which refers to it.
     internal::CustomLogLevelManager custom_log_level_manager;
+    LogLevelManager log_level_manager;
     helpers::Time TTCCLayout_time_base;
     NDC ndc;
     MDC mdc;
@@ -179,11 +356,14 @@ struct DefaultContext
     spi::LayoutFactoryRegistry layout_factory_registry;
     spi::FilterFactoryRegistry filter_factory_registry;
     spi::LocaleFactoryRegistry locale_factory_registry;
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    AsyncEventQueue async_events;
+#endif
     Hierarchy hierarchy;
     ThreadPoolHolder thread_pool;
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    progschj::ThreadPool *
+    internal::executor *
     get_thread_pool (bool init)
     {
         if (init) {
@@ -204,6 +384,14 @@ struct DefaultContext
         delete tp;
     }
 
+    //! Detaches the thread pool without joining its workers, which
+    //! are stuck in tasks that missed the shutdown deadline.
+    void
+    abandon_thread_pool ()
+    {
+        thread_pool.thread_pool.exchange (nullptr, std::memory_order_release);
+    }
+
 private:
     std::once_flag thread_pool_once;
 #endif
@@ -222,10 +410,28 @@ static DCState default_context_state = DC_UNINITIALIZED;
 static DefaultContext * default_context = nullptr;
 
 
+//! Set by setFastExit().
+static std::atomic<bool> fast_exit {false};
+
+
 struct destroy_default_context
 {
     ~destroy_default_context ()
     {
+        if (default_context
+            && fast_exit.load (std::memory_order_relaxed))
+        {
+            // Flush and close appenders but leave the loggers, their
+            // arena and the rest of the context to process exit.
+            default_context->hierarchy.shutdown ();
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+            default_context->shutdown_thread_pool ();
+#endif
+            default_context = nullptr;
+            default_context_state = DC_DESTROYED;
+            return;
+        }
+
         delete default_context;
         default_context = nullptr;
         default_context_state = DC_DESTROYED;
@@ -352,197 +558,946 @@ getMDC ()
 }
 
 
-#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
-    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
-void
-enqueueAsyncDoAppend (SharedAppenderPtr const & appender,
-    spi::InternalLoggingEvent const & event)
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+namespace
 {
-    get_dc ()->get_thread_pool (true)->enqueue (
-        [=] ()
-        {
-            appender->asyncDoAppend (event);
-        });
-}
 
-#endif
+//! Number of events a strand appends before it yields its worker to
+//! other tasks.
+std::size_t const async_strand_batch = 64;
 
-void
-shutdownThreadPool ()
+
+//! Takes event from per-thread pool, allocating new one if the pool
+//! has none free.
+internal::async_event *
+take_async_event (internal::per_thread_data * ptd)
 {
-#if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    DefaultContext * const dc = get_dc (false);
-    if (dc)
+    std::shared_ptr<internal::async_event_pool> & pool = ptd->async_events;
+    if (! pool)
+        pool = std::make_shared<internal::async_event_pool> ();
+
+    if (! pool->free)
+        pool->free = pool->returned.exchange (nullptr,
+            std::memory_order_acquire);
+
+    internal::async_event * ev = pool->free;
+    if (ev)
+        pool->free = static_cast<internal::async_event *>(
+            ev->next.load (std::memory_order_relaxed));
+    else
     {
-        dc->shutdown_thread_pool ();
+        ev = new internal::async_event;
+        if (pool->events == internal::async_event_pool::max_events)
+            return ev;
+
+        ++pool->events;
     }
-#endif
+
+    ev->pool = pool;
+    return ev;
 }
 
 
+//! Returns appended event into the pool it came from.
 void
-waitUntilEmptyThreadPoolQueue ()
+release_async_event (internal::async_event * ev)
 {
-#if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    DefaultContext * const dc = get_dc (false);
-    progschj::ThreadPool * tp;
-    if (dc && (tp = dc->get_thread_pool (false)))
+    ev->appender = SharedAppenderPtr ();
+    ev->shared.reset ();
+    std::shared_ptr<internal::async_event_pool> const pool
+        = std::move (ev->pool);
+    if (! pool)
     {
-        tp->wait_until_empty ();
-        tp->wait_until_nothing_in_flight ();
+        delete ev;
+        return;
     }
-#endif
+
+    internal::async_event * head
+        = pool->returned.load (std::memory_order_relaxed);
+    do
+        ev->next.store (head, std::memory_order_relaxed);
+    while (! pool->returned.compare_exchange_weak (head, ev,
+            std::memory_order_release, std::memory_order_relaxed));
 }
 
+} // namespace
+
 
-namespace spi
+namespace internal
 {
 
+async_strand::async_strand (Appender * owner_)
+    : owner (owner_)
+    , tail (&stub)
+    , head (&stub)
+    , pending (0)
+{ }
+
 
-AppenderFactoryRegistry &
-getAppenderFactoryRegistry ()
+async_strand::~async_strand ()
 {
-    return get_dc ()->appender_factory_registry;
+    assert (pending.load (std::memory_order_relaxed) == 0);
 }
 
 
-LayoutFactoryRegistry &
-getLayoutFactoryRegistry ()
+bool
+async_strand::push (async_node * node)
 {
-    return get_dc ()->layout_factory_registry;
-}
+    // Count the node before it is linked so that the running strand,
+    // which can see it right after the link, never sees pending drop
+    // below zero.
+    bool const first = pending.fetch_add (1, std::memory_order_acq_rel) == 0;
 
+    node->next.store (nullptr, std::memory_order_relaxed);
+    async_node * const prev = tail.exchange (node, std::memory_order_acq_rel);
+    prev->next.store (node, std::memory_order_release);
 
-FilterFactoryRegistry &
-getFilterFactoryRegistry ()
-{
-    return get_dc ()->filter_factory_registry;
+    return first;
 }
 
 
-LocaleFactoryRegistry &
-getLocaleFactoryRegistry()
+async_node *
+async_strand::pop ()
 {
-    return get_dc ()->locale_factory_registry;
-}
+    async_node * node = head;
+    async_node * next = node->next.load (std::memory_order_acquire);
+    if (node == &stub)
+    {
+        if (! next)
+            return nullptr;
 
+        head = next;
+        node = next;
+        next = next->next.load (std::memory_order_acquire);
+    }
 
-} // namespace spi
+    if (next)
+    {
+        head = next;
+        return node;
+    }
 
+    // Producer is between tail exchange and link of the next node.
+    if (node != tail.load (std::memory_order_acquire))
+        return nullptr;
 
-namespace internal
-{
+    // The node is the last one. Put the stub behind it so that it can
+    // be unlinked.
+    stub.next.store (nullptr, std::memory_order_relaxed);
+    async_node * const prev = tail.exchange (&stub, std::memory_order_acq_rel);
+    prev->next.store (&stub, std::memory_order_release);
 
+    next = node->next.load (std::memory_order_acquire);
+    if (next)
+    {
+        head = next;
+        return node;
+    }
 
-gft_scratch_pad::gft_scratch_pad ()
-    : uc_q_str_valid (false)
-    , q_str_valid (false)
-    , s_str_valid (false)
-{ }
+    return nullptr;
+}
 
 
-gft_scratch_pad::~gft_scratch_pad () = default;
+void
+async_strand::run (executor & exec)
+{
+    // Queued events keep the appender alive only until they are
+    // released. This keeps it, and this strand, alive until the strand
+    // stops touching itself.
+    SharedAppenderPtr const keep (owner);
+    AsyncEventQueue & queue = get_dc ()->async_events;
 
+    for (std::size_t appended = 0; ; )
+    {
+        if (appended >= async_strand_batch)
+        {
+            // Let other tasks of this worker run. Nobody else submits
+            // the strand while pending is not zero.
+            exec.submit (this);
+            return;
+        }
 
-appender_sratch_pad::appender_sratch_pad () = default;
+        // Move queued events into the batch so that the appender takes
+        // its locks, including the lock file, and flushes only once
+        // for all of them.
+        std::size_t const count = (std::min) (
+            pending.load (std::memory_order_acquire),
+            async_strand_batch - appended);
+        batch.resize (count);
+        std::size_t batched = 0;
+        auto const append_batch = [&]
+        {
+            if (batched == 0)
+                return;
+
+            try
+            {
+                owner->syncDoAppendBatch (
+                    std::span<spi::InternalLoggingEvent const> (
+                        batch.data (), batched));
+            }
+            catch (...)
+            {
+                // Same as for exceptions in other thread pool tasks.
+            }
+            batched = 0;
+        };
+
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            async_node * node;
+            while (! (node = pop ()))
+                std::this_thread::yield ();
+
+            async_event * const ev = static_cast<async_event *>(node);
+            if (ev->queued != std::chrono::steady_clock::time_point ())
+            {
+                if (appender_metrics * const m
+                    = owner->metrics.load (std::memory_order_acquire))
+                    m->queue_latency.record (
+                        std::chrono::steady_clock::now () - ev->queued);
+            }
+
+            if (ev->shared)
+            {
+                // Other appenders read the shared event too, so it
+                // cannot be moved into the batch. It is appended in
+                // place after the events queued before it.
+                std::shared_ptr<spi::InternalLoggingEvent const> const
+                    shared = std::move (ev->shared);
+                release_async_event (ev);
+                append_batch ();
+                try
+                {
+                    owner->syncDoAppend (*shared);
+                }
+                catch (...)
+                { }
+                continue;
+            }
+
+            batch[batched++].swap (ev->event);
+            release_async_event (ev);
+        }
+        append_batch ();
 
+        // Accounted before waitToFinishAsyncLogging() can return.
+        queue.note_batch (count);
+        owner->subtract_in_flight (count);
+        appended += count;
 
-appender_sratch_pad::~appender_sratch_pad () = default;
+        std::size_t const prev_count
+            = queue.count.fetch_sub (count, std::memory_order_relaxed);
+        if (prev_count >= queue.limit && prev_count - count < queue.limit)
+        {
+            std::unique_lock<std::mutex> guard (queue.mutex,
+                std::defer_lock);
+            async_queue_mutex_site.acquire (guard);
+            queue.not_full.notify_all ();
+        }
 
+        if (pending.fetch_sub (count, std::memory_order_acq_rel) == count)
+            return;
+    }
+}
 
-per_thread_data::per_thread_data ()
-    : fnull (nullptr)
-{ }
+} // namespace internal
 
 
-per_thread_data::~per_thread_data ()
+namespace
 {
-    if (fnull)
-        std::fclose (fnull);
-}
 
+//! Queues <code>ev</code> into <code>strand</code>, waiting while the
+//! limit of queued events is reached, and submits the strand if it is
+//! not running.
+void
+queue_async_event (AsyncEventQueue & queue, internal::executor * tp,
+    internal::async_strand & strand, internal::async_event * ev)
+{
+    ev->queued = ev->appender->isMetricsEnabled ()
+        ? std::chrono::steady_clock::now ()
+        : std::chrono::steady_clock::time_point ();
 
-log4cplus::thread::impl::tls_key_type tls_storage_key;
+    if (queue.count.load (std::memory_order_relaxed) >= queue.limit)
+    {
+        auto const start = std::chrono::steady_clock::now ();
+        {
+            std::unique_lock<std::mutex> guard (queue.mutex,
+                std::defer_lock);
+            async_queue_mutex_site.acquire (guard);
+            queue.not_full.wait (guard,
+                [&] {
+                    return queue.count.load (std::memory_order_relaxed)
+                        < queue.limit; });
+        }
+        queue.blocked_puts.fetch_add (1, std::memory_order_relaxed);
+        queue.blocked_ns.fetch_add (static_cast<std::uint64_t> (
+                std::chrono::duration_cast<std::chrono::nanoseconds> (
+                    std::chrono::steady_clock::now () - start).count ()),
+            std::memory_order_relaxed);
+    }
+    queue.note_depth (
+        queue.count.fetch_add (1, std::memory_order_relaxed) + 1);
 
+    if (strand.push (ev))
+        tp->submit (&strand);
+}
 
-#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
-    && defined (LOG4CPLUS_THREAD_LOCAL_VAR)
+} // namespace
 
-LOG4CPLUS_THREAD_LOCAL_VAR per_thread_data * ptd = nullptr;
+
+void
+enqueueAsyncDoAppend (SharedAppenderPtr const & appender,
+    internal::async_strand & strand, spi::InternalLoggingEvent const & event,
+    unsigned fields)
+{
+    DefaultContext * const dc = get_dc ();
+    internal::executor * const tp = dc->get_thread_pool (true);
+    if (! tp)
+    {
+        // Thread pool has been shut down. Append here.
+        appender->asyncDoAppend (event);
+        return;
+    }
+
+    internal::async_event * const ev = take_async_event (internal::get_ptd ());
+    try
+    {
+        ev->event.assign (event, fields);
+    }
+    catch (...)
+    {
+        release_async_event (ev);
+        throw;
+    }
+    ev->appender = appender;
+    queue_async_event (dc->async_events, tp, strand, ev);
+}
 
 
-per_thread_data *
-alloc_ptd ()
+void
+enqueueAsyncDoAppend (SharedAppenderPtr const & appender,
+    internal::async_strand & strand,
+    std::shared_ptr<spi::InternalLoggingEvent const> const & event)
 {
-    auto * tmp = new per_thread_data;
-    set_ptd (tmp);
-    // This is a special hack. We set the keys' value to non-NULL to
-    // get the ptd_cleanup_func to execute when this thread ends. The
-    // cast is safe; the associated value will never be used if read
-    // again using the key.
-    thread::impl::tls_set_value (tls_storage_key,
-        reinterpret_cast<void *>(1));
+    DefaultContext * const dc = get_dc ();
+    internal::executor * const tp = dc->get_thread_pool (true);
+    if (! tp)
+    {
+        appender->asyncDoAppend (*event);
+        return;
+    }
 
-    return tmp;
+    internal::async_event * const ev = take_async_event (internal::get_ptd ());
+    ev->shared = event;
+    ev->appender = appender;
+    queue_async_event (dc->async_events, tp, strand, ev);
 }
 
-#  else
 
-per_thread_data *
-alloc_ptd ()
+void
+enqueueAsyncTask (std::function<void ()> task)
 {
-    auto * tmp = new per_thread_data;
-    set_ptd (tmp);
-    return tmp;
+    internal::executor * const tp = get_dc ()->get_thread_pool (true);
+    if (! tp)
+        throw std::runtime_error ("thread pool has been shut down");
+
+    tp->submit (std::move (task));
 }
 
-#  endif
+#endif
 
-} // namespace internal
+#if defined (LOG4CPLUS_USE_PTHREADS)
+namespace
+{
 
+//! State of internal::fork_gate_guard. Waits are polled; condition
+//! variables could be left with waiters that do not exist in the child
+//! process.
+struct ForkGate
+{
+    //! Number of threads inside the gate.
+    std::atomic<std::size_t> active {0};
+    std::atomic<bool> closed {false};
+};
 
-void initializeFactoryRegistry ();
+ForkGate fork_gate;
 
+//! Nesting depth of fork_gate_guard in this thread. Exempt threads
+//! keep it above zero.
+thread_local unsigned fork_gate_depth = 0;
 
-//! Thread local storage clean up function for POSIX threads.
-#if defined (LOG4CPLUS_USE_WIN32_THREADS)
-static
-void NTAPI
-#else
-static
+std::chrono::milliseconds const fork_poll_interval (1);
+
+//! Time fork handlers wait for queues and the thread pool to become
+//! idle. A queue thread stuck, e.g., in a network appender must not
+//! block fork() forever.
+std::chrono::seconds const fork_quiesce_timeout (5);
+
+
+//! Runs before fork(). Keeps new events out of asynchronous appenders
+//! and waits until the queued ones are appended, so that no thread of
+//! log4cplus holds a lock the child would inherit locked.
 void
-#endif
-ptd_cleanup_func (void * arg)
+fork_prepare ()
 {
-    auto * const arg_ptd
-        = static_cast<internal::per_thread_data *>(arg);
-    internal::per_thread_data * const ptd = internal::get_ptd (false);
-    (void) ptd;
+    fork_gate.closed.store (true, std::memory_order_seq_cst);
+    while (fork_gate.active.load (std::memory_order_seq_cst) != 0)
+        std::this_thread::sleep_for (fork_poll_interval);
+
+    internal::async_appenders_lock_for_fork ();
+
+    DefaultContext * const dc = default_context;
+    internal::executor * const tp = dc ? dc->get_thread_pool (false) : nullptr;
+
+    // Queue threads can append to appenders which use the thread pool
+    // and workers can append to AsyncAppender, so wait until all are
+    // idle at once.
+    auto const deadline = std::chrono::steady_clock::now ()
+        + fork_quiesce_timeout;
+    while (! ((! tp || tp->is_idle ()) && internal::async_appenders_idle ())
+        && std::chrono::steady_clock::now () < deadline)
+        std::this_thread::sleep_for (fork_poll_interval);
+}
 
-    // Either it is a dummy value or it should be the per thread data
-    // pointer we get from internal::get_ptd().
-    assert (arg == reinterpret_cast<void *>(1)
-        || arg_ptd == ptd
-        || (! ptd && arg_ptd));
 
-    if (arg == reinterpret_cast<void *>(1))
-        // Setting the value through the key here is necessary in case
-        // we are using TLS using __thread or __declspec(thread) or
-        // similar constructs with POSIX threads.  Otherwise POSIX
-        // calls this cleanup routine more than once if the value
-        // stays non-NULL after it returns.
-        thread::impl::tls_set_value (internal::tls_storage_key, nullptr);
-    else if (arg)
+void
+fork_parent ()
+{
+    internal::async_appenders_after_fork (false);
+    fork_gate.closed.store (false, std::memory_order_release);
+}
+
+
+//! Runs in the child process, which has only the thread that has
+//! called fork(). Replaces the thread pool and queue threads of
+//! AsyncAppender instances; their old state is leaked, it can be
+//! neither joined nor destroyed.
+void
+fork_child ()
+{
+    DefaultContext * const dc = default_context;
+    if (internal::executor * const tp
+        = dc ? dc->get_thread_pool (false) : nullptr)
     {
-        // Instead of using internal::get_ptd(false) here we are using
-        // the value passed to this function directly.  This is
+        try
+        {
+            dc->thread_pool.thread_pool.store (
+                new internal::executor (tp->get_pool_size (),
+                    tp->get_idle_timeout ()),
+                std::memory_order_release);
+        }
+        catch (...)
+        {
+            // Asynchronous appends run synchronously without the pool.
+            dc->thread_pool.thread_pool.store (nullptr,
+                std::memory_order_release);
+        }
+    }
+
+    internal::async_appenders_after_fork (true);
+
+    fork_gate.active.store (0, std::memory_order_relaxed);
+    fork_gate.closed.store (false, std::memory_order_release);
+}
+
+} // namespace
+
+
+namespace internal
+{
+
+fork_gate_guard::fork_gate_guard (bool enter)
+    : entered (enter)
+{
+    // Nested appends are covered by the outermost one.
+    if (! entered || fork_gate_depth++ != 0)
+        return;
+
+    for (;;)
+    {
+        fork_gate.active.fetch_add (1, std::memory_order_seq_cst);
+        if (! fork_gate.closed.load (std::memory_order_seq_cst))
+            return;
+
+        fork_gate.active.fetch_sub (1, std::memory_order_seq_cst);
+        while (fork_gate.closed.load (std::memory_order_acquire))
+            std::this_thread::sleep_for (fork_poll_interval);
+    }
+}
+
+
+fork_gate_guard::~fork_gate_guard ()
+{
+    if (entered && --fork_gate_depth == 0)
+        fork_gate.active.fetch_sub (1, std::memory_order_release);
+}
+
+
+void
+fork_gate_guard::exempt_current_thread ()
+{
+    fork_gate_depth = 1;
+}
+
+} // namespace internal
+#endif
+
+
+void
+shutdownThreadPool ()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    DefaultContext * const dc = get_dc (false);
+    if (dc)
+    {
+        dc->shutdown_thread_pool ();
+    }
+#endif
+}
+
+
+void
+waitUntilEmptyThreadPoolQueue ()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    DefaultContext * const dc = get_dc (false);
+    internal::executor * tp;
+    if (dc && (tp = dc->get_thread_pool (false)))
+        tp->wait_until_idle ();
+#endif
+}
+
+
+bool
+waitUntilEmptyThreadPoolQueue (
+    std::chrono::steady_clock::time_point LOG4CPLUS_THREADED (deadline))
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    DefaultContext * const dc = get_dc (false);
+    internal::executor * tp;
+    if (dc && (tp = dc->get_thread_pool (false)))
+        return tp->wait_until_idle (deadline);
+#endif
+
+    return true;
+}
+
+
+namespace spi
+{
+
+
+AppenderFactoryRegistry &
+getAppenderFactoryRegistry ()
+{
+    return get_dc ()->appender_factory_registry;
+}
+
+
+LayoutFactoryRegistry &
+getLayoutFactoryRegistry ()
+{
+    return get_dc ()->layout_factory_registry;
+}
+
+
+FilterFactoryRegistry &
+getFilterFactoryRegistry ()
+{
+    return get_dc ()->filter_factory_registry;
+}
+
+
+LocaleFactoryRegistry &
+getLocaleFactoryRegistry()
+{
+    return get_dc ()->locale_factory_registry;
+}
+
+
+} // namespace spi
+
+
+namespace internal
+{
+
+
+gft_scratch_pad::gft_scratch_pad ()
+    : uc_q_str_valid (false)
+    , q_str_valid (false)
+    , s_str_valid (false)
+{ }
+
+
+gft_scratch_pad::~gft_scratch_pad () = default;
+
+
+appender_sratch_pad::appender_sratch_pad () = default;
+
+
+appender_sratch_pad::~appender_sratch_pad () = default;
+
+
+socket_buffer_pool::socket_buffer_pool () = default;
+
+
+socket_buffer_pool::~socket_buffer_pool ()
+{
+    for (auto & free_blocks : blocks)
+        for (char * block : free_blocks)
+            delete [] block;
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+async_event_pool::async_event_pool ()
+    : free (nullptr)
+    , returned (nullptr)
+    , events (0)
+{ }
+
+
+async_event_pool::~async_event_pool ()
+{
+    for (async_event * list : {free, returned.load (std::memory_order_acquire)})
+        while (list)
+        {
+            async_event * const next = static_cast<async_event *>(
+                list->next.load (std::memory_order_relaxed));
+            delete list;
+            list = next;
+        }
+}
+#endif
+
+
+per_thread_data::per_thread_data ()
+    : fnull (nullptr)
+{ }
+
+
+per_thread_data::~per_thread_data ()
+{
+    if (fnull)
+        std::fclose (fnull);
+}
+
+
+//! Resource of library internal allocations, see setMemoryResource().
+static std::atomic<std::pmr::memory_resource *> memory_resource {nullptr};
+
+
+//! Room in front of blocks of resource_allocate() for their resource.
+static constexpr std::size_t resource_header_size
+    = alignof (std::max_align_t);
+
+static_assert (resource_header_size >= sizeof (std::pmr::memory_resource *));
+
+
+void *
+resource_allocate (std::size_t size)
+{
+    std::pmr::memory_resource * const resource = getMemoryResource ();
+    char * const block = static_cast<char *>(resource->allocate (
+        resource_header_size + size, alignof (std::max_align_t)));
+    *reinterpret_cast<std::pmr::memory_resource **>(block) = resource;
+    return block + resource_header_size;
+}
+
+
+void
+resource_deallocate (void * p, std::size_t size) noexcept
+{
+    if (! p)
+        return;
+
+    char * const block = static_cast<char *>(p) - resource_header_size;
+    (*reinterpret_cast<std::pmr::memory_resource **>(block))->deallocate (
+        block, resource_header_size + size, alignof (std::max_align_t));
+}
+
+
+//! Capacity limit of per thread buffers, see
+//! setThreadBufferCapacityLimit().
+static std::atomic<std::size_t> thread_buffer_capacity_limit {1024 * 1024};
+
+
+void
+per_thread_data::reset ()
+{
+    clear_thread_buffer (macros_str);
+    detail::clear_tostringstream (macros_oss);
+    if (macros_tostringstream)
+        detail::clear_tostringstream (*macros_tostringstream);
+    detail::clear_tostringstream (layout_oss);
+    clear_thread_buffer (layout_str);
+    ndc_dcs.reset ();
+    ndc_full.clear ();
+    ndc_full_valid = false;
+    mdc_map.reset ();
+    thread_name.clear ();
+    thread_name2.clear ();
+    gft_sp.reset ();
+    detail::clear_tostringstream (appender_sp.oss);
+    clear_thread_buffer (appender_sp.str);
+    appender_sp.chstr.clear ();
+    appender_sp.chstr2.clear ();
+    layout_cache_event = nullptr;
+    layout_cache_used = 0;
+    clear_thread_buffer (faa_str);
+    clear_thread_buffer (ll_str);
+    spi::InternalLoggingEvent ().swap (forced_log_ev);
+    merge_thread_volume (this);
+    warm_ptd (this);
+}
+
+
+//! Upper bound of setThreadDataPoolSize().
+static std::size_t const ptd_pool_capacity = 1024;
+
+//! Slots of per_thread_data kept for reuse, null when empty. Threads
+//! take and return objects by exchanging slots, without locking.
+static std::atomic<per_thread_data *> ptd_pool[ptd_pool_capacity] {};
+
+//! Number of slots in use, see setThreadDataPoolSize().
+static std::atomic<std::size_t> ptd_pool_size {16};
+
+
+static
+per_thread_data *
+take_pooled_ptd ()
+{
+    std::size_t const size = ptd_pool_size.load (std::memory_order_relaxed);
+    for (std::size_t i = 0; i != size; ++i)
+        if (ptd_pool[i].load (std::memory_order_relaxed))
+            if (per_thread_data * const p
+                = ptd_pool[i].exchange (nullptr, std::memory_order_acquire))
+                return p;
+
+    return nullptr;
+}
+
+
+static
+bool
+return_pooled_ptd (per_thread_data * p)
+{
+    std::size_t const size = ptd_pool_size.load (std::memory_order_relaxed);
+    for (std::size_t i = 0; i != size; ++i)
+    {
+        per_thread_data * expected = nullptr;
+        if (! ptd_pool[i].load (std::memory_order_relaxed)
+            && ptd_pool[i].compare_exchange_strong (expected, p,
+                std::memory_order_release, std::memory_order_relaxed))
+            return true;
+    }
+
+    return false;
+}
+
+
+void
+release_ptd (per_thread_data * p)
+{
+    if (! p)
+        return;
+
+    p->reset ();
+    if (! return_pooled_ptd (p))
+        delete p;
+}
+
+
+//! Deletes pooled objects in slots from <code>first</code> on.
+static
+void
+drain_ptd_pool (std::size_t first)
+{
+    for (std::size_t i = first; i != ptd_pool_capacity; ++i)
+        delete ptd_pool[i].exchange (nullptr, std::memory_order_acquire);
+}
+
+
+std::size_t
+get_thread_buffer_capacity_limit ()
+{
+    return thread_buffer_capacity_limit.load (std::memory_order_relaxed);
+}
+
+
+void
+clear_thread_buffer (tstring & buf)
+{
+    std::size_t const limit = get_thread_buffer_capacity_limit ();
+    if (limit != 0 && buf.capacity () > limit)
+        tstring ().swap (buf);
+    else
+        buf.clear ();
+}
+
+
+//! Capacity of buffers reserved in real-time mode, zero when it is
+//! not enabled, see enableRealTimeMode().
+static std::atomic<std::size_t> real_time_buffer_capacity {0};
+
+//! Number of events for asynchronous appending preallocated per thread
+//! in real-time mode.
+static std::atomic<std::size_t> real_time_async_events {0};
+
+
+std::size_t
+get_real_time_buffer_capacity ()
+{
+    return real_time_buffer_capacity.load (std::memory_order_relaxed);
+}
+
+
+//! Reserves <code>capacity</code> characters in empty buffer
+//! <code>buf</code> and writes them so that their pages are faulted in.
+static
+void
+warm_buffer (tstring & buf, std::size_t capacity)
+{
+    buf.resize (capacity);
+    buf.clear ();
+}
+
+
+static
+void
+warm_stream (helpers::buffer_ostream & oss, std::size_t capacity)
+{
+    // Growing the buffer writes all of it.
+    oss.rdbuf ()->reserve (capacity);
+}
+
+
+void
+warm_ptd (per_thread_data * p)
+{
+    std::size_t const capacity = get_real_time_buffer_capacity ();
+    if (capacity == 0)
+        return;
+
+    warm_buffer (p->macros_str, capacity);
+    warm_stream (p->macros_oss, capacity);
+    warm_stream (p->layout_oss, capacity);
+    warm_buffer (p->layout_str, capacity);
+    warm_buffer (p->ndc_full, capacity);
+    warm_stream (p->appender_sp.oss, capacity);
+    warm_buffer (p->appender_sp.str, capacity);
+    warm_buffer (p->faa_str, capacity);
+    warm_buffer (p->ll_str, capacity);
+    p->forced_log_ev.reserveMessage (capacity);
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    std::size_t const events = (std::min) (
+        real_time_async_events.load (std::memory_order_relaxed),
+        async_event_pool::max_events);
+    if (events == 0)
+        return;
+
+    std::shared_ptr<async_event_pool> & pool = p->async_events;
+    if (! pool)
+        pool = std::make_shared<async_event_pool> ();
+
+    for (; pool->events < events; ++pool->events)
+    {
+        async_event * ev = new async_event;
+        ev->event.reserveMessage (capacity);
+        ev->next.store (pool->free, std::memory_order_relaxed);
+        pool->free = ev;
+    }
+#endif
+}
+
+
+log4cplus::thread::impl::tls_key_type tls_storage_key;
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_THREAD_LOCAL_VAR)
+
+LOG4CPLUS_THREAD_LOCAL_VAR per_thread_data * ptd = nullptr;
+
+
+per_thread_data *
+alloc_ptd ()
+{
+    per_thread_data * tmp = take_pooled_ptd ();
+    if (! tmp)
+        tmp = new per_thread_data;
+    set_ptd (tmp);
+    // This is a special hack. We set the keys' value to non-NULL to
+    // get the ptd_cleanup_func to execute when this thread ends. The
+    // cast is safe; the associated value will never be used if read
+    // again using the key.
+    thread::impl::tls_set_value (tls_storage_key,
+        reinterpret_cast<void *>(1));
+
+    return tmp;
+}
+
+#  else
+
+per_thread_data *
+alloc_ptd ()
+{
+    per_thread_data * tmp = take_pooled_ptd ();
+    if (! tmp)
+        tmp = new per_thread_data;
+    set_ptd (tmp);
+    return tmp;
+}
+
+#  endif
+
+} // namespace internal
+
+
+void initializeFactoryRegistry ();
+
+
+//! Thread local storage clean up function for POSIX threads.
+#if defined (LOG4CPLUS_USE_WIN32_THREADS)
+static
+void NTAPI
+#else
+static
+void
+#endif
+ptd_cleanup_func (void * arg)
+{
+    auto * const arg_ptd
+        = static_cast<internal::per_thread_data *>(arg);
+    internal::per_thread_data * const ptd = internal::get_ptd (false);
+    (void) ptd;
+
+    // Either it is a dummy value or it should be the per thread data
+    // pointer we get from internal::get_ptd().
+    assert (arg == reinterpret_cast<void *>(1)
+        || arg_ptd == ptd
+        || (! ptd && arg_ptd));
+
+    if (arg == reinterpret_cast<void *>(1))
+        // Setting the value through the key here is necessary in case
+        // we are using TLS using __thread or __declspec(thread) or
+        // similar constructs with POSIX threads.  Otherwise POSIX
+        // calls this cleanup routine more than once if the value
+        // stays non-NULL after it returns.
+        thread::impl::tls_set_value (internal::tls_storage_key, nullptr);
+    else if (arg)
+    {
+        // Instead of using internal::get_ptd(false) here we are using
+        // the value passed to this function directly.  This is
         // necessary because of the following (from SUSv4):
         //
         // A call to pthread_getspecific() for the thread-specific
         // data key being destroyed shall return the value NULL,
         // unless the value is changed (after the destructor starts)
         // by a call to pthread_setspecific().
-        delete arg_ptd;
+        internal::release_ptd (arg_ptd);
         thread::impl::tls_set_value (internal::tls_storage_key, nullptr);
     }
     else
@@ -579,6 +1534,13 @@ initializeLog4cplus()
     Logger::getRoot();
     initializeFactoryRegistry();
 
+#if defined (LOG4CPLUS_USE_PTHREADS)
+    if (int const ret = pthread_atfork (fork_prepare, fork_parent,
+            fork_child))
+        dc->loglog.error (LOG4CPLUS_TEXT ("pthread_atfork() has failed: ")
+            + helpers::convertIntegerToString (ret));
+#endif
+
     initialized = true;
 }
 
@@ -590,10 +1552,33 @@ initialize ()
 }
 
 
+//! Time limit of deinitialize(), see setShutdownTimeout().
+static std::atomic<unsigned> shutdown_timeout {0};
+
+
 void
 deinitialize ()
 {
-    Logger::shutdown ();
+    unsigned const timeout = shutdown_timeout.load (std::memory_order_relaxed);
+    if (timeout == 0)
+    {
+        Logger::shutdown ();
+        shutdownThreadPool();
+        return;
+    }
+
+    ShutdownReport const report
+        = Logger::shutdown (std::chrono::milliseconds (timeout));
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (! report.threadPoolIdle)
+    {
+        // Joining workers stuck in tasks would block past the deadline.
+        if (DefaultContext * const dc = get_dc (false))
+            dc->abandon_thread_pool ();
+        return;
+    }
+#endif
+
     shutdownThreadPool();
 }
 
@@ -623,7 +1608,7 @@ threadCleanup ()
 #endif
         // Do thread-specific cleanup.
         internal::per_thread_data * ptd = internal::get_ptd (false);
-        delete ptd;
+        internal::release_ptd (ptd);
 #if defined (_WIN32)
     }
     else
@@ -649,6 +1634,147 @@ setThreadPoolSize (std::size_t LOG4CPLUS_THREADED (pool_size))
 }
 
 
+void
+setThreadPoolIdleTimeout (unsigned LOG4CPLUS_THREADED (milliseconds))
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    auto const thread_pool = get_dc ()->get_thread_pool (true);
+    if (thread_pool)
+        thread_pool->set_idle_timeout (
+            std::chrono::milliseconds (milliseconds));
+
+#endif
+}
+
+
+void
+setShutdownTimeout (unsigned milliseconds)
+{
+    shutdown_timeout.store (milliseconds, std::memory_order_relaxed);
+}
+
+
+void
+setThreadBufferCapacityLimit (std::size_t limit)
+{
+    internal::thread_buffer_capacity_limit.store (limit,
+        std::memory_order_relaxed);
+}
+
+
+void
+setMemoryResource (std::pmr::memory_resource * resource)
+{
+    internal::memory_resource.store (resource, std::memory_order_release);
+}
+
+
+std::pmr::memory_resource *
+getMemoryResource ()
+{
+    std::pmr::memory_resource * const resource
+        = internal::memory_resource.load (std::memory_order_acquire);
+    return resource ? resource : std::pmr::new_delete_resource ();
+}
+
+
+void
+setThreadDataPoolSize (std::size_t size)
+{
+    size = (std::min) (size, internal::ptd_pool_capacity);
+    internal::ptd_pool_size.store (size, std::memory_order_relaxed);
+    internal::drain_ptd_pool (size);
+
+    for (std::size_t i = 0; i != size; ++i)
+        if (! internal::ptd_pool[i].load (std::memory_order_relaxed))
+        {
+            auto * p = new internal::per_thread_data;
+            internal::warm_ptd (p);
+            internal::per_thread_data * expected = nullptr;
+            if (! internal::ptd_pool[i].compare_exchange_strong (expected, p,
+                    std::memory_order_release, std::memory_order_relaxed))
+                delete p;
+        }
+}
+
+
+void
+enableRealTimeMode (RealTimeSettings const & settings)
+{
+    internal::real_time_async_events.store (settings.asyncEvents,
+        std::memory_order_relaxed);
+    internal::real_time_buffer_capacity.store (settings.bufferCapacity,
+        std::memory_order_relaxed);
+
+    // Recreate pooled objects so that all of them are warmed up.
+    setThreadDataPoolSize (0);
+    setThreadDataPoolSize (settings.threadDataObjects);
+
+    if (! settings.lockMemory)
+        return;
+
+#if ! defined (_WIN32)
+    if (::mlockall (MCL_CURRENT | MCL_FUTURE) != 0)
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("mlockall() failed: ")
+            + helpers::convertIntegerToString (errno));
+#else
+    helpers::getLogLog ().warn (
+        LOG4CPLUS_TEXT ("Locking memory is not supported on this platform."));
+#endif
+}
+
+
+void
+warmUpThread ()
+{
+    internal::warm_ptd (internal::get_ptd ());
+}
+
+
+void
+setFastExit (bool enabled)
+{
+    fast_exit.store (enabled, std::memory_order_relaxed);
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+thread::QueueStats
+getThreadPoolQueueStats ()
+{
+    AsyncEventQueue const & queue = get_dc ()->async_events;
+    thread::QueueStats stats;
+    stats.capacity = queue.limit;
+    stats.depth = queue.count.load (std::memory_order_relaxed);
+    stats.highWaterMark = queue.high_water.load (std::memory_order_relaxed);
+    stats.blockedPuts = queue.blocked_puts.load (std::memory_order_relaxed);
+    stats.blockedTime = std::chrono::nanoseconds (
+        queue.blocked_ns.load (std::memory_order_relaxed));
+    stats.batches = queue.batches.load (std::memory_order_relaxed);
+    stats.batchedEvents
+        = queue.batched_events.load (std::memory_order_relaxed);
+    stats.maxBatch = queue.max_batch.load (std::memory_order_relaxed);
+    return stats;
+}
+
+
+void
+setThreadPoolHighWaterCallback (std::size_t threshold,
+    thread::HighWaterCallback callback)
+{
+    AsyncEventQueue & queue = get_dc ()->async_events;
+    {
+        std::lock_guard<std::mutex> guard (queue.callback_mutex);
+        queue.high_water_callback = std::move (callback);
+    }
+
+    queue.high_water_armed.store (true, std::memory_order_relaxed);
+    queue.high_water_threshold.store (threshold, std::memory_order_release);
+}
+#endif
+
+
 static
 void
 freeTLSSlot ()
@@ -752,6 +1878,169 @@ thread_callback_terminator(LPVOID hinstDLL, DWORD fdwReason, LPVOID lpReserved)
 #endif
 
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) && ! defined (LOG4CPLUS_SINGLE_THREADED)
+CATCH_TEST_CASE ("Pooled per thread data", "[thread]")
+{
+    setThreadDataPoolSize (0);
+    setThreadDataPoolSize (1);
+
+    internal::per_thread_data * first = nullptr;
+    tstring first_name;
+    std::thread ([&]
+    {
+        first = internal::get_ptd ();
+        getNDC ().push (LOG4CPLUS_TEXT ("ndc"));
+        getMDC ().put (LOG4CPLUS_TEXT ("key"), LOG4CPLUS_TEXT ("value"));
+        thread::setCurrentThreadName (LOG4CPLUS_TEXT ("first"));
+        first_name = thread::getCurrentThreadName ();
+        threadCleanup ();
+    }).join ();
+
+    internal::per_thread_data * second = nullptr;
+    tstring ndc, mdc, second_name;
+    bool has_mdc = true;
+    std::thread ([&]
+    {
+        second = internal::get_ptd ();
+        ndc = getNDC ().get ();
+        has_mdc = getMDC ().get (&mdc, LOG4CPLUS_TEXT ("key"));
+        second_name = thread::getCurrentThreadName ();
+        threadCleanup ();
+    }).join ();
+
+    // Other threads of the process may take the pooled object first.
+    CATCH_CHECK (second == first);
+    CATCH_REQUIRE (ndc.empty ());
+    CATCH_REQUIRE (! has_mdc);
+    CATCH_REQUIRE (second_name != first_name);
+
+    setThreadDataPoolSize (16);
+}
+#endif
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) && ! defined (LOG4CPLUS_SINGLE_THREADED)
+namespace
+{
+
+class counting_resource
+    : public std::pmr::memory_resource
+{
+public:
+    std::atomic<std::size_t> allocations {0};
+    std::atomic<std::size_t> deallocations {0};
+
+private:
+    void *
+    do_allocate (std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocations;
+        return std::pmr::new_delete_resource ()->allocate (bytes, alignment);
+    }
+
+    void
+    do_deallocate (void * p, std::size_t bytes, std::size_t alignment)
+        override
+    {
+        ++deallocations;
+        std::pmr::new_delete_resource ()->deallocate (p, bytes, alignment);
+    }
+
+    bool
+    do_is_equal (std::pmr::memory_resource const & other) const noexcept
+        override
+    {
+        return this == &other;
+    }
+};
+
+} // namespace
+
+
+CATCH_TEST_CASE ("Memory resource", "[memory]")
+{
+    // Blocks taken by other threads of the process while the resource
+    // is set are returned to it later, so it is never destroyed.
+    static counting_resource * const resource = new counting_resource;
+
+    CATCH_SECTION ("hierarchy")
+    {
+        std::size_t const before = resource->allocations;
+        {
+            Hierarchy h (resource);
+            for (int i = 0; i != 1000; ++i)
+                h.getInstance (LOG4CPLUS_TEXT ("l")
+                    + helpers::convertIntegerToString (i));
+            CATCH_REQUIRE (resource->allocations > before);
+        }
+        CATCH_REQUIRE (resource->deallocations == resource->allocations);
+    }
+
+    CATCH_SECTION ("queue and per thread data")
+    {
+        setThreadDataPoolSize (0);
+        setMemoryResource (resource);
+        CATCH_REQUIRE (getMemoryResource () == resource);
+
+        std::size_t const before = resource->allocations;
+        {
+            thread::QueuePtr queue (new thread::Queue (16));
+            CATCH_REQUIRE (resource->allocations >= before + 1);
+        }
+
+        std::thread ([] {
+            internal::get_ptd ();
+            threadCleanup ();
+        }).join ();
+        CATCH_REQUIRE (resource->allocations >= before + 2);
+
+        setMemoryResource (nullptr);
+        CATCH_REQUIRE (getMemoryResource ()
+            == std::pmr::new_delete_resource ());
+        setThreadDataPoolSize (16);
+    }
+}
+
+
+CATCH_TEST_CASE ("Real-time mode", "[thread]")
+{
+    RealTimeSettings settings;
+    settings.threadDataObjects = 1;
+    settings.bufferCapacity = 4096;
+    settings.asyncEvents = 8;
+    settings.lockMemory = false;
+    enableRealTimeMode (settings);
+
+    std::size_t macros_capacity = 0, message_capacity = 0, events = 0;
+    std::thread ([&]
+    {
+        internal::per_thread_data * p = internal::get_ptd ();
+        macros_capacity = p->macros_str.capacity ();
+        message_capacity = p->forced_log_ev.getMessage ().capacity ();
+        events = p->async_events ? p->async_events->events : 0;
+        threadCleanup ();
+    }).join ();
+
+    // Other threads of the process may take the pooled object first, so
+    // check the calling thread as well.
+    CATCH_CHECK (macros_capacity >= settings.bufferCapacity);
+    CATCH_CHECK (message_capacity >= settings.bufferCapacity);
+    CATCH_CHECK (events == settings.asyncEvents);
+
+    warmUpThread ();
+    internal::per_thread_data * p = internal::get_ptd ();
+    CATCH_REQUIRE (p->layout_str.capacity () >= settings.bufferCapacity);
+    CATCH_REQUIRE (p->async_events->events >= settings.asyncEvents);
+
+    settings.threadDataObjects = 16;
+    settings.bufferCapacity = 0;
+    settings.asyncEvents = 0;
+    enableRealTimeMode (settings);
+    CATCH_REQUIRE (internal::get_real_time_buffer_capacity () == 0);
+}
+#endif
+
+
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 LOG4CPLUS_EXPORT int unit_tests_main (int argc, char* argv[]);
 int
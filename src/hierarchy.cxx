@@ -20,11 +20,29 @@
 
 #include <log4cplus/hierarchy.h>
 #include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/internal/internal.h>
 #include <log4cplus/spi/loggerimpl.h>
 #include <log4cplus/spi/rootlogger.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/thread/lockprofile.h>
+#include <algorithm>
+#include <map>
 #include <utility>
 #include <limits>
+#include <set>
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/appender.h>
+#include <log4cplus/configurator.h>
+#include <log4cplus/helpers/property.h>
+#include <catch.hpp>
+#endif
 
 
 namespace log4cplus
@@ -38,15 +56,41 @@ namespace log4cplus
 namespace
 {
 
+//! Matches <code>name</code> against glob <code>pattern</code> with
+//! <code>*</code> and <code>?</code> wildcards.
 static
-bool startsWith(tstring_view const & teststr, tstring_view const & substr)
+bool
+globMatch(tstring_view const & pattern, tstring_view const & name)
 {
-    bool val = false;
-    tstring::size_type const len = substr.length();
-    if (teststr.length() > len)
-        val = teststr.compare (0, len, substr) == 0;
+    std::size_t p = 0, n = 0;
+    std::size_t star = tstring_view::npos, starName = 0;
+    while (n != name.size())
+    {
+        if (p != pattern.size() && pattern[p] == LOG4CPLUS_TEXT('*'))
+        {
+            star = p++;
+            starName = n;
+        }
+        else if (p != pattern.size()
+            && (pattern[p] == LOG4CPLUS_TEXT('?') || pattern[p] == name[n]))
+        {
+            ++p;
+            ++n;
+        }
+        else if (star != tstring_view::npos)
+        {
+            // Let the last star consume one more character.
+            p = star + 1;
+            n = ++starName;
+        }
+        else
+            return false;
+    }
 
-    return val;
+    while (p != pattern.size() && pattern[p] == LOG4CPLUS_TEXT('*'))
+        ++p;
+
+    return p == pattern.size();
 }
 
 } // namespace
@@ -59,6 +103,87 @@ bool startsWith(tstring_view const & teststr, tstring_view const & substr)
 const LogLevel Hierarchy::DISABLE_OFF = -1;
 const LogLevel Hierarchy::DISABLE_OVERRIDE = -2;
 
+//! Shared by logger tables of all hierarchies.
+static thread::LockSite hashtable_mutex_site ("Hierarchy::hashtable_mutex");
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+// SharedAppenderRegistry
+//////////////////////////////////////////////////////////////////////////////
+
+SharedAppenderRegistry::SharedAppenderRegistry() = default;
+
+
+SharedAppenderRegistry::~SharedAppenderRegistry() = default;
+
+
+void
+SharedAppenderRegistry::put(SharedAppenderPtr appender)
+{
+    tstring name = appender->getName();
+    thread::MutexGuard guard (mutex);
+    appenders[std::move(name)] = std::move(appender);
+}
+
+
+SharedAppenderPtr
+SharedAppenderRegistry::get(const tstring_view& name) const
+{
+    thread::MutexGuard guard (mutex);
+    auto it = appenders.find(name);
+    return it != appenders.end() ? it->second : SharedAppenderPtr();
+}
+
+
+bool
+SharedAppenderRegistry::contains(Appender const * appender) const
+{
+    thread::MutexGuard guard (mutex);
+    return std::any_of(appenders.begin(), appenders.end(),
+        [appender] (auto const & entry)
+        { return entry.second.get() == appender; });
+}
+
+
+void
+SharedAppenderRegistry::remove(const tstring_view& name)
+{
+    thread::MutexGuard guard (mutex);
+    auto it = appenders.find(name);
+    if (it != appenders.end())
+        appenders.erase(it);
+}
+
+
+SharedAppenderPtrList
+SharedAppenderRegistry::getAll() const
+{
+    SharedAppenderPtrList list;
+    thread::MutexGuard guard (mutex);
+    for (auto const & entry : appenders)
+        list.push_back(entry.second);
+    return list;
+}
+
+
+void
+SharedAppenderRegistry::closeAll()
+{
+    std::map<tstring, SharedAppenderPtr, std::less<>> closing;
+    {
+        thread::MutexGuard guard (mutex);
+        closing.swap(appenders);
+    }
+
+    for (auto & entry : closing)
+    {
+        entry.second->waitToFinishAsyncLogging();
+        if (! entry.second->isClosed())
+            entry.second->close();
+    }
+}
+
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -66,10 +191,26 @@ const LogLevel Hierarchy::DISABLE_OVERRIDE = -2;
 //////////////////////////////////////////////////////////////////////////////
 
 Hierarchy::Hierarchy()
-  : defaultFactory(new DefaultLoggerFactory())
+  : Hierarchy(nullptr)
+{
+}
+
+
+Hierarchy::Hierarchy(std::pmr::memory_resource * resource)
+  : hashtable_mutex(hashtable_mutex_site)
+  , defaultFactory(new DefaultLoggerFactory())
+  , loggerCount(0)
+  , loggerArena(new internal::logger_arena(resource))
   , root(nullptr)
   // Don't disable any LogLevel level by default.
   , disableValue(DISABLE_OFF)
+  , levelGeneration(1)
+  , sheddingThreshold(NOT_SET_LOG_LEVEL)
+  , volumeAccounting(false)
+  , volumeId(internal::new_volume_id())
+  , captureLimited(false)
+  , truncatedEvents(0)
+  , sharedAppenders(nullptr)
   , emittedNoAppenderWarning(false)
 {
     root = Logger( new spi::RootLogger(*this, DEBUG_LOG_LEVEL) );
@@ -79,6 +220,7 @@ Hierarchy::Hierarchy()
 Hierarchy::~Hierarchy()
 {
     shutdown();
+    loggerArena->release();
 }
 
 
@@ -92,8 +234,11 @@ Hierarchy::clear()
 {
     thread::MutexGuard guard (hashtable_mutex);
 
-    provisionNodes.erase(provisionNodes.begin(), provisionNodes.end());
-    loggerPtrs.erase(loggerPtrs.begin(), loggerPtrs.end());
+    loggerTree.children.clear();
+    loggerCount = 0;
+    for (auto & shard : loggerIndex)
+        shard.store(LoggerIndexMapPtr(), std::memory_order_release);
+    invalidateLogLevelCaches();
 }
 
 
@@ -104,10 +249,8 @@ Hierarchy::exists(const tstring_view& name)
     if (name.empty ())
         return true;
 
-    thread::MutexGuard guard (hashtable_mutex);
-
-    auto it = loggerPtrs.find(name);
-    return it != loggerPtrs.end();
+    Logger logger;
+    return findLogger(name, logger);
 }
 
 
@@ -116,6 +259,7 @@ Hierarchy::disable(const tstring_view& loglevelStr)
 {
     if(disableValue != DISABLE_OVERRIDE) {
         disableValue = getLogLevelManager().fromString(loglevelStr);
+        invalidateLogLevelCaches();
     }
 }
 
@@ -125,6 +269,7 @@ Hierarchy::disable(LogLevel ll)
 {
     if(disableValue != DISABLE_OVERRIDE) {
         disableValue = ll;
+        invalidateLogLevelCaches();
     }
 }
 
@@ -154,6 +299,7 @@ void
 Hierarchy::enableAll()
 {
     disableValue = DISABLE_OFF;
+    invalidateLogLevelCaches();
 }
 
 
@@ -167,6 +313,12 @@ Hierarchy::getInstance(const tstring_view& name)
 Logger
 Hierarchy::getInstance(const tstring_view& name, spi::LoggerFactory& factory)
 {
+    Logger logger;
+    if (name.empty ())
+        return root;
+    else if (findLogger(name, logger))
+        return logger;
+
     thread::MutexGuard guard (hashtable_mutex);
 
     return getInstanceImpl(name, factory);
@@ -187,6 +339,99 @@ Hierarchy::getCurrentLoggers()
 }
 
 
+std::size_t
+Hierarchy::setLogLevels(const tstring_view& pattern, LogLevel ll)
+{
+    tstring_view const prefix
+        = pattern.substr(0, pattern.find_first_of(LOG4CPLUS_TEXT("*?")));
+    std::size_t count = 0;
+
+    // Names starting with the prefix are below the node of its complete
+    // segments, in children whose keys start with the rest of it.
+    std::size_t const dot = prefix.rfind(LOG4CPLUS_TEXT('.'));
+    tstring_view const partial
+        = dot == tstring_view::npos ? prefix : prefix.substr(dot + 1);
+
+    thread::MutexGuard guard (hashtable_mutex);
+
+    LoggerNode * node = &loggerTree;
+    for (std::size_t pos = 0; node && dot != tstring_view::npos
+             && pos <= dot; )
+    {
+        std::size_t const end = prefix.find(LOG4CPLUS_TEXT('.'), pos);
+        auto const it = node->children.find(prefix.substr(pos, end - pos));
+        node = it != node->children.end() ? it->second.get() : nullptr;
+        pos = end + 1;
+    }
+
+    if (! node)
+        return 0;
+
+    LoggerList candidates;
+    for (auto it = node->children.lower_bound(partial);
+         it != node->children.end()
+             && it->first.compare(0, partial.size(), partial) == 0;
+         ++it)
+    {
+        if (it->second->logger.value)
+            candidates.push_back(it->second->logger);
+        collectLoggers(*it->second, candidates);
+    }
+
+    for (Logger const & logger : candidates)
+    {
+        if (globMatch(pattern, logger.getName()))
+        {
+            logger.value->ll = ll;
+            ++count;
+        }
+    }
+
+    if (count != 0)
+        invalidateLogLevelCaches();
+
+    return count;
+}
+
+
+std::vector<AppenderMetrics>
+Hierarchy::collectMetrics()
+{
+    LoggerList loggers = getCurrentLoggers();
+    loggers.push_back(getRoot());
+
+    std::vector<AppenderMetrics> result;
+    std::set<Appender const *> visited;
+    SharedAppenderPtrList pending;
+    for (Logger & logger : loggers)
+    {
+        SharedAppenderPtrList const appenders = logger.getAllAppenders();
+        pending.insert(pending.end(), appenders.begin(), appenders.end());
+    }
+
+    while (! pending.empty())
+    {
+        SharedAppenderPtr const appender = std::move(pending.back());
+        pending.pop_back();
+        if (! visited.insert(appender.get()).second)
+            continue;
+
+        if (appender->isMetricsEnabled())
+            result.push_back(appender->getMetrics());
+
+        if (auto attachable
+            = dynamic_cast<spi::AppenderAttachable *>(appender.get()))
+        {
+            SharedAppenderPtrList const nested
+                = attachable->getAllAppenders();
+            pending.insert(pending.end(), nested.begin(), nested.end());
+        }
+    }
+
+    return result;
+}
+
+
 bool
 Hierarchy::isDisabled(LogLevel level)
 {
@@ -206,6 +451,7 @@ Hierarchy::resetConfiguration()
 {
     getRoot().setLogLevel(DEBUG_LOG_LEVEL);
     disableValue = DISABLE_OFF;
+    invalidateLogLevelCaches();
 
     shutdown();
 
@@ -214,6 +460,7 @@ Hierarchy::resetConfiguration()
     {
         logger.setLogLevel(NOT_SET_LOG_LEVEL);
         logger.setAdditivity(true);
+        logger.setCaptureLimits(nullptr);
     }
 
 }
@@ -233,8 +480,114 @@ Hierarchy::getLoggerFactory()
 }
 
 
+void
+Hierarchy::setSheddingThreshold(LogLevel ll)
+{
+    if (sheddingThreshold.exchange(ll, std::memory_order_relaxed) != ll)
+        invalidateLogLevelCaches();
+}
+
+
+LogLevel
+Hierarchy::getSheddingThreshold() const
+{
+    return sheddingThreshold.load(std::memory_order_relaxed);
+}
+
+
+void
+Hierarchy::setVolumeAccounting(bool enabled)
+{
+    volumeAccounting.store(enabled, std::memory_order_relaxed);
+}
+
+
+bool
+Hierarchy::isVolumeAccounting() const
+{
+    return volumeAccounting.load(std::memory_order_relaxed);
+}
+
+
+std::uint64_t
+Hierarchy::getTruncatedEventCount() const
+{
+    return truncatedEvents.load(std::memory_order_relaxed);
+}
+
+
+void
+Hierarchy::setSharedAppenders(SharedAppenderRegistryPtr registry)
+{
+    sharedAppenders.store(std::move(registry), std::memory_order_release);
+}
+
+
+SharedAppenderRegistryPtr
+Hierarchy::getSharedAppenders() const
+{
+    return sharedAppenders.load(std::memory_order_acquire);
+}
+
+
+VolumeReport
+Hierarchy::volumeReport(std::size_t topN)
+{
+    // Counts of every logger are added to all its ancestors up to root.
+    tstring const & rootName = getRoot().getName();
+    std::map<tstring, LoggerVolume> totals;
+    for (LoggerVolume const & counted : internal::collect_logger_volume(
+             volumeId))
+    {
+        LoggerVolume & self = totals[counted.name];
+        self.events += counted.events;
+        self.bytes += counted.bytes;
+
+        tstring name = counted.name;
+        for (;;)
+        {
+            LoggerVolume & v = totals[name];
+            v.totalEvents += counted.events;
+            v.totalBytes += counted.bytes;
+            if (name == rootName)
+                break;
+
+            tstring::size_type const dot = name.rfind(LOG4CPLUS_TEXT('.'));
+            if (dot == tstring::npos)
+                name = rootName;
+            else
+                name.resize(dot);
+        }
+    }
+
+    VolumeReport report;
+    for (auto & item : totals)
+    {
+        item.second.name = item.first;
+        report.loggers.push_back(std::move(item.second));
+    }
+
+    std::stable_sort(report.loggers.begin(), report.loggers.end(),
+        [](LoggerVolume const & a, LoggerVolume const & b)
+        { return a.totalBytes > b.totalBytes; });
+    if (report.loggers.size() > topN)
+        report.loggers.resize(topN);
+
+    report.appenders = collectMetrics();
+    std::stable_sort(report.appenders.begin(), report.appenders.end(),
+        [](AppenderMetrics const & a, AppenderMetrics const & b)
+        { return a.bytes > b.bytes; });
+    if (report.appenders.size() > topN)
+        report.appenders.resize(topN);
+
+    return report;
+}
+
+
 // from global-init.cxx
 void waitUntilEmptyThreadPoolQueue ();
+bool waitUntilEmptyThreadPoolQueue (
+    std::chrono::steady_clock::time_point deadline);
 
 void
 Hierarchy::shutdown()
@@ -243,33 +596,161 @@ Hierarchy::shutdown()
 
     LoggerList loggers;
     initializeLoggerList (loggers);
+    loggers.insert (loggers.begin (), root);
 
-    // begin by closing nested appenders
-    // then, remove all appenders
-
-    for (auto & appenderPtr : root.getAllAppenders())
-    {
-        Appender & appender = *appenderPtr;
-        appender.waitToFinishAsyncLogging ();
-    }
-    root.closeNestedAppenders();
-    root.removeAllAppenders();
-
-    // repeat
+    // Appenders shared with other hierarchies are only detached.
+    SharedAppenderRegistryPtr const shared = getSharedAppenders ();
     for (auto & logger : loggers)
     {
         for (auto & appenderPtr : logger.getAllAppenders())
         {
             Appender & appender = *appenderPtr;
             appender.waitToFinishAsyncLogging ();
+            if (! appender.isClosed ()
+                && ! (shared && shared->contains (&appender)))
+                appender.close ();
         }
-        logger.closeNestedAppenders();
         logger.removeAllAppenders();
     }
 }
 
 
 
+namespace
+{
+
+//! Drains and closes <code>appenders</code> concurrently, each on its
+//! own thread. Names of appenders not closed by <code>deadline</code>
+//! are added to <code>report</code>; their threads are detached and
+//! keep the appenders alive until close() returns.
+static
+void
+closeAppenders (SharedAppenderPtrList const & appenders,
+    std::chrono::steady_clock::time_point deadline, ShutdownReport & report)
+{
+    auto close_one = [] (Appender & appender,
+        std::chrono::steady_clock::time_point deadline_)
+    {
+        try
+        {
+            appender.waitToFinishAsyncLogging (deadline_);
+            if (! appender.isClosed ())
+                appender.close ();
+        }
+        catch (std::exception const & e)
+        {
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("Closing appender [") + appender.getName ()
+                + LOG4CPLUS_TEXT ("] failed: ")
+                + LOG4CPLUS_C_STR_TO_TSTRING (e.what ()));
+        }
+    };
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    struct Closing
+    {
+        std::mutex mtx;
+        std::condition_variable cond;
+        std::vector<bool> closed;
+        std::size_t remaining = 0;
+    };
+
+    auto const state = std::make_shared<Closing> ();
+    state->closed.resize (appenders.size ());
+    state->remaining = appenders.size ();
+
+    std::vector<std::thread> threads;
+    threads.reserve (appenders.size ());
+    for (std::size_t i = 0; i != appenders.size (); ++i)
+        threads.emplace_back (
+            [state, appender = appenders[i], i, deadline, close_one]
+            {
+                close_one (*appender, deadline);
+
+                std::lock_guard<std::mutex> guard (state->mtx);
+                state->closed[i] = true;
+                if (--state->remaining == 0)
+                    state->cond.notify_all ();
+            });
+
+    std::unique_lock<std::mutex> lock (state->mtx);
+    state->cond.wait_until (lock, deadline,
+        [&state] { return state->remaining == 0; });
+    for (std::size_t i = 0; i != appenders.size (); ++i)
+    {
+        if (state->closed[i])
+            continue;
+
+        report.undrainedAppenders.push_back (appenders[i]->getName ());
+        threads[i].detach ();
+    }
+    lock.unlock ();
+
+    for (auto & thread : threads)
+        if (thread.joinable ())
+            thread.join ();
+
+#else
+    for (auto const & appender : appenders)
+        close_one (*appender, deadline);
+
+#endif
+}
+
+} // namespace
+
+
+ShutdownReport
+Hierarchy::shutdown(std::chrono::milliseconds timeout)
+{
+    auto const deadline = std::chrono::steady_clock::now () + timeout;
+    ShutdownReport report;
+
+    disableAll ();
+
+    LoggerList loggers;
+    initializeLoggerList (loggers);
+    loggers.push_back (root);
+
+    // Every appender once, even if it is attached to several loggers.
+    // Appenders with nested appenders go first so that they can still
+    // flush into the nested ones.
+    // Appenders shared with other hierarchies are only detached.
+    SharedAppenderRegistryPtr const shared = getSharedAppenders ();
+    SharedAppenderPtrList nesting;
+    SharedAppenderPtrList plain;
+    std::set<Appender *> seen;
+    for (auto & logger : loggers)
+        for (auto & appenderPtr : logger.getAllAppenders ())
+            if (seen.insert (appenderPtr.get ()).second
+                && ! (shared && shared->contains (appenderPtr.get ())))
+                (dynamic_cast<spi::AppenderAttachable *> (appenderPtr.get ())
+                    ? nesting : plain).push_back (appenderPtr);
+
+    closeAppenders (nesting, deadline, report);
+    closeAppenders (plain, deadline, report);
+    report.threadPoolIdle = waitUntilEmptyThreadPoolQueue (deadline);
+
+    for (auto & logger : loggers)
+        logger.removeAllAppenders ();
+
+    if (! report.complete ())
+    {
+        tstring names;
+        for (auto const & name : report.undrainedAppenders)
+            names += LOG4CPLUS_TEXT (" [") + name + LOG4CPLUS_TEXT ("]");
+        if (! report.threadPoolIdle)
+            names += LOG4CPLUS_TEXT (" thread pool");
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("Shutdown deadline passed, not drained:")
+            + names);
+    }
+
+    return report;
+}
+
+
+
 //////////////////////////////////////////////////////////////////////////////
 // Hierarchy private methods
 //////////////////////////////////////////////////////////////////////////////
@@ -278,106 +759,458 @@ Logger
 Hierarchy::getInstanceImpl(const tstring_view& name,
     spi::LoggerFactory& factory)
 {
-    Logger logger;
-    LoggerMap::iterator lm_it;
-
     if (name.empty ())
-        logger = root;
-    else if ((lm_it = loggerPtrs.find(name)) != loggerPtrs.end())
-        logger = lm_it->second;
-    else
+        return root;
+
+    // Walk down segments of the name, creating nodes for missing ones;
+    // the nearest existing logger on the way is the parent.
+    LoggerNode * node = &loggerTree;
+    spi::LoggerImpl * parent = root.value;
+    for (std::size_t pos = 0; ; )
     {
-        // Need to create a new logger
-        logger = factory.makeNewLoggerInstance(name, *this);
-        bool inserted = loggerPtrs.emplace (name, logger).second;
-        if (! inserted)
-        {
-            helpers::getLogLog().error(
-                LOG4CPLUS_TEXT("Hierarchy::getInstanceImpl()- Insert failed"),
-                true);
-        }
+        std::size_t const end = name.find(LOG4CPLUS_TEXT('.'), pos);
+        tstring_view const segment = name.substr(pos, end - pos);
+        auto it = node->children.find(segment);
+        if (it == node->children.end())
+            it = node->children.emplace(tstring(segment),
+                std::make_unique<LoggerNode>()).first;
+
+        node = it->second.get();
+        if (end == tstring_view::npos)
+            break;
+
+        if (node->logger.value)
+            parent = node->logger.value;
+        pos = end + 1;
+    }
+
+    if (node->logger.value)
+        return node->logger;
+
+    // Need to create a new logger
+    Logger logger = factory.makeNewLoggerInstance(name, *this);
+    logger.value->parent = parent;
+    adoptChildren(*node, logger.value);
+    node->logger = logger;
+    ++loggerCount;
+    publishLogger(logger);
+    invalidateLogLevelCaches();
+
+    return logger;
+}
+
 
-        auto pnm_it = provisionNodes.find(name);
-        if (pnm_it != provisionNodes.end())
+void
+Hierarchy::initializeLoggerList(LoggerList& list) const
+{
+    list.reserve (list.size () + loggerCount);
+    collectLoggers(loggerTree, list);
+}
+
+
+struct Hierarchy::LoggerIndexTable
+{
+    explicit
+    LoggerIndexTable(std::size_t capacity)
+        : slots(new std::atomic<spi::LoggerImpl *>[capacity])
+        , mask(capacity - 1)
+        , size(0)
+    {
+        for (std::size_t i = 0; i != capacity; ++i)
+            slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~LoggerIndexTable()
+    {
+        for (std::size_t i = 0; i <= mask; ++i)
+            if (spi::LoggerImpl * logger
+                = slots[i].load(std::memory_order_relaxed))
+                logger->removeReference();
+    }
+
+    LoggerIndexTable(LoggerIndexTable const &) = delete;
+    LoggerIndexTable & operator = (LoggerIndexTable const &) = delete;
+
+    spi::LoggerImpl *
+    find(tstring_view const & name, std::size_t hash) const
+    {
+        for (std::size_t i = hash & mask; ; i = (i + 1) & mask)
         {
-            updateChildren(pnm_it->second, logger);
-            provisionNodes.erase(pnm_it);
+            spi::LoggerImpl * logger = slots[i].load(std::memory_order_acquire);
+            if (! logger || logger->getName() == name)
+                return logger;
         }
-        updateParents(logger);
     }
 
-    return logger;
+    //! Only called with <code>hashtable_mutex</code> locked.
+    void
+    insert(spi::LoggerImpl * logger, std::size_t hash)
+    {
+        std::size_t i = hash & mask;
+        while (slots[i].load(std::memory_order_relaxed))
+            i = (i + 1) & mask;
+
+        logger->addReference();
+        slots[i].store(logger, std::memory_order_release);
+        ++size;
+    }
+
+    std::unique_ptr<std::atomic<spi::LoggerImpl *>[]> slots;
+    std::size_t const mask;
+    std::size_t size;
+};
+
+
+bool
+Hierarchy::findLogger(tstring_view const & name, Logger & logger) const
+{
+    std::size_t const hash = LoggerNameHash() (name);
+    LoggerIndexMapPtr const table
+        = getLoggerIndexShard(name).load(std::memory_order_acquire);
+    if (! table)
+        return false;
+
+    spi::LoggerImpl * found = table->find(name, hash);
+    if (! found)
+        return false;
+
+    logger = Logger(found);
+    return true;
 }
 
 
 void
-Hierarchy::initializeLoggerList(LoggerList& list) const
+Hierarchy::publishLogger(Logger const & logger)
 {
-    list.reserve (list.size () + loggerPtrs.size ());
-    for (auto & kv : loggerPtrs)
-        list.push_back(kv.second);
+    std::size_t const hash = LoggerNameHash() (logger.getName());
+    auto & shard = getLoggerIndexShard(logger.getName());
+    LoggerIndexMapPtr table = shard.load(std::memory_order_relaxed);
+    if (! table || (table->size + 1) * 2 > table->mask + 1)
+    {
+        // Readers keep using the old table until they drop it.
+        std::size_t const capacity = table ? (table->mask + 1) * 2 : 64;
+        auto grown = std::make_shared<LoggerIndexTable>(capacity);
+        if (table)
+            for (std::size_t i = 0; i <= table->mask; ++i)
+                if (spi::LoggerImpl * existing
+                    = table->slots[i].load(std::memory_order_relaxed))
+                    grown->insert(existing,
+                        LoggerNameHash() (existing->getName()));
+
+        grown->insert(logger.value, hash);
+        shard.store(std::move(grown), std::memory_order_release);
+    }
+    else
+        table->insert(logger.value, hash);
+}
+
+
+std::atomic<Hierarchy::LoggerIndexMapPtr> &
+Hierarchy::getLoggerIndexShard(tstring_view const & name) const
+{
+    // Fold higher bits in; lower bits also select buckets within the shard.
+    std::size_t const hash = LoggerNameHash() (name);
+    return loggerIndex[(hash ^ (hash >> 17)) % LOGGER_INDEX_SHARDS];
+}
+
+
+thread::Mutex &
+Hierarchy::getAppenderListMutex(tstring_view const & name)
+{
+    return appenderListMutexes[LoggerNameHash() (name)
+        % APPENDER_LIST_MUTEXES];
 }
 
 
 void
-Hierarchy::updateParents(Logger const & logger)
+Hierarchy::adoptChildren(LoggerNode & node, spi::LoggerImpl * parent)
 {
-    tstring const & name = logger.getName();
-    auto const length = name.length();
-    bool parentFound = false;
-    tstring substr;
+    for (auto & kv : node.children)
+    {
+        LoggerNode & child = *kv.second;
+        if (child.logger.value)
+            child.logger.value->parent = parent;
+        else
+            adoptChildren(child, parent);
+    }
+}
+
+
+void
+Hierarchy::collectLoggers(LoggerNode const & node, LoggerList & list)
+{
+    for (auto const & kv : node.children)
+    {
+        LoggerNode const & child = *kv.second;
+        if (child.logger.value)
+            list.push_back(child.logger);
+        collectLoggers(child, list);
+    }
+}
+
+
+void
+Hierarchy::invalidateLogLevelCaches()
+{
+    // Skip over zero on wrap around, see levelGeneration.
+    if (levelGeneration.fetch_add(1, std::memory_order_acq_rel) + 1 == 0)
+        levelGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Hierarchy", "[hierarchy]")
+{
+    Hierarchy h;
+
+    CATCH_SECTION ("lookup returns the same logger")
+    {
+        CATCH_REQUIRE (! h.exists (LOG4CPLUS_TEXT ("x.y")));
+        Logger a = h.getInstance (LOG4CPLUS_TEXT ("x.y"));
+        CATCH_REQUIRE (h.exists (LOG4CPLUS_TEXT ("x.y")));
+        CATCH_REQUIRE (! h.exists (LOG4CPLUS_TEXT ("x")));
+        Logger b = h.getInstance (LOG4CPLUS_TEXT ("x.y"));
+        a.setLogLevel (ERROR_LOG_LEVEL);
+        CATCH_REQUIRE (b.getLogLevel () == ERROR_LOG_LEVEL);
+        CATCH_REQUIRE (h.getCurrentLoggers ().size () == 1);
+    }
+
+    CATCH_SECTION ("clear empties lookup index")
+    {
+        for (int i = 0; i != 100; ++i)
+            h.getInstance (LOG4CPLUS_TEXT ("l") + helpers::convertIntegerToString (i));
+        CATCH_REQUIRE (h.exists (LOG4CPLUS_TEXT ("l42")));
+        CATCH_REQUIRE (h.getCurrentLoggers ().size () == 100);
+
+        h.clear ();
+        CATCH_REQUIRE (! h.exists (LOG4CPLUS_TEXT ("l42")));
+        CATCH_REQUIRE (h.getCurrentLoggers ().empty ());
+    }
 
-    // if name = "w.x.y.z", loop thourgh "w.x.y", "w.x" and "w", but not "w.x.y.z"
-    for(std::size_t i=name.find_last_of(LOG4CPLUS_TEXT('.'), length-1);
-        i != tstring::npos && i > 0;
-        i = name.find_last_of(LOG4CPLUS_TEXT('.'), i-1))
+    CATCH_SECTION ("children created before parents")
     {
-        substr.assign (name, 0, i);
+        // The name buffer is reused; the name space must not refer to it.
+        tstring name (LOG4CPLUS_TEXT ("a.b.c"));
+        Logger abc = h.getInstance (name);
+        name = LOG4CPLUS_TEXT ("a.x");
+        Logger ax = h.getInstance (name);
+        name = LOG4CPLUS_TEXT ("a");
+        Logger a = h.getInstance (name);
+        name.clear ();
+
+        CATCH_REQUIRE (abc.getParent ().getName () == LOG4CPLUS_TEXT ("a"));
+        CATCH_REQUIRE (ax.getParent ().getName () == LOG4CPLUS_TEXT ("a"));
+        Logger ab = h.getInstance (LOG4CPLUS_TEXT ("a.b"));
+        CATCH_REQUIRE (abc.getParent ().getName () == LOG4CPLUS_TEXT ("a.b"));
+        CATCH_REQUIRE (ab.getParent ().getName () == LOG4CPLUS_TEXT ("a"));
+        CATCH_REQUIRE (h.exists (LOG4CPLUS_TEXT ("a.b.c")));
+        CATCH_REQUIRE (h.getInstance (LOG4CPLUS_TEXT ("a.x")).getName ()
+            == LOG4CPLUS_TEXT ("a.x"));
+
+        a.setLogLevel (ERROR_LOG_LEVEL);
+        CATCH_REQUIRE (abc.getChainedLogLevel () == ERROR_LOG_LEVEL);
+    }
 
-        auto it = loggerPtrs.find(substr);
-        if(it != loggerPtrs.end()) {
-            parentFound = true;
-            logger.value->parent = it->second.value;
-            break;  // no need to update the ancestors of the closest ancestor
+    CATCH_SECTION ("parent inserted between logger and its descendants")
+    {
+        Logger abcd = h.getInstance (LOG4CPLUS_TEXT ("a.b.c.d"));
+        Logger abce = h.getInstance (LOG4CPLUS_TEXT ("a.b.c.e"));
+        Logger ab = h.getInstance (LOG4CPLUS_TEXT ("a.b"));
+        Logger abx = h.getInstance (LOG4CPLUS_TEXT ("a.bx"));
+        Logger a = h.getInstance (LOG4CPLUS_TEXT ("a"));
+        Logger abc = h.getInstance (LOG4CPLUS_TEXT ("a.b.c"));
+        Logger empty = h.getInstance (LOG4CPLUS_TEXT ("a..b"));
+
+        CATCH_REQUIRE (abcd.getParent ().getName () == LOG4CPLUS_TEXT ("a.b.c"));
+        CATCH_REQUIRE (abce.getParent ().getName () == LOG4CPLUS_TEXT ("a.b.c"));
+        CATCH_REQUIRE (abc.getParent ().getName () == LOG4CPLUS_TEXT ("a.b"));
+        CATCH_REQUIRE (ab.getParent ().getName () == LOG4CPLUS_TEXT ("a"));
+        CATCH_REQUIRE (abx.getParent ().getName () == LOG4CPLUS_TEXT ("a"));
+        CATCH_REQUIRE (empty.getParent ().getName () == LOG4CPLUS_TEXT ("a"));
+        CATCH_REQUIRE (a.getParent ().getName () == LOG4CPLUS_TEXT ("root"));
+        CATCH_REQUIRE (h.getCurrentLoggers ().size () == 7);
+        CATCH_REQUIRE (! h.exists (LOG4CPLUS_TEXT ("a.b.c.d.e")));
+
+        CATCH_REQUIRE (h.setLogLevels (LOG4CPLUS_TEXT ("a.b*"),
+            WARN_LOG_LEVEL) == 5);
+        CATCH_REQUIRE (h.setLogLevels (LOG4CPLUS_TEXT ("a.b.c.*"),
+            ERROR_LOG_LEVEL) == 2);
+        CATCH_REQUIRE (abcd.getLogLevel () == ERROR_LOG_LEVEL);
+        CATCH_REQUIRE (abc.getLogLevel () == WARN_LOG_LEVEL);
+        CATCH_REQUIRE (a.getLogLevel () == NOT_SET_LOG_LEVEL);
+        CATCH_REQUIRE (h.setLogLevels (LOG4CPLUS_TEXT ("z.*"),
+            ERROR_LOG_LEVEL) == 0);
+    }
+
+    CATCH_SECTION ("loggers outlive clear and their hierarchy")
+    {
+        Logger kept;
+        {
+            Hierarchy h2;
+            Logger cleared = h2.getInstance (LOG4CPLUS_TEXT ("c.d"));
+            h2.clear ();
+            for (int i = 0; i != 1000; ++i)
+                h2.getInstance (LOG4CPLUS_TEXT ("l")
+                    + helpers::convertIntegerToString (i));
+            kept = h2.getInstance (LOG4CPLUS_TEXT ("l42"));
+            CATCH_REQUIRE (cleared.getName () == LOG4CPLUS_TEXT ("c.d"));
         }
-        else {
-            auto it2 = provisionNodes.find(substr);
-            if(it2 != provisionNodes.end()) {
-                it2->second.push_back(logger);
-            }
-            else {
-                ProvisionNode node;
-                node.push_back(logger);
-                std::pair<ProvisionNodeMap::iterator, bool> tmp =
-                    provisionNodes.emplace (substr, node);
-                if(!tmp.second) {
-                    helpers::getLogLog().error(
-                        LOG4CPLUS_TEXT("Hierarchy::updateParents()- Insert failed"),
-                        true);
-                }
-            }
-        } // end if Logger found
-    } // end for loop
-
-    if(!parentFound) {
-        logger.value->parent = root.value;
+
+        CATCH_REQUIRE (kept.getName () == LOG4CPLUS_TEXT ("l42"));
+        CATCH_REQUIRE (kept.getParent ().getName ()
+            == LOG4CPLUS_TEXT ("root"));
+    }
+
+    CATCH_SECTION ("bulk log level update")
+    {
+        Logger net = h.getInstance (LOG4CPLUS_TEXT ("net"));
+        Logger tcp = h.getInstance (LOG4CPLUS_TEXT ("net.tcp"));
+        Logger tcp_conn = h.getInstance (LOG4CPLUS_TEXT ("net.tcp.conn"));
+        Logger udp = h.getInstance (LOG4CPLUS_TEXT ("net.udp"));
+        Logger network = h.getInstance (LOG4CPLUS_TEXT ("network"));
+        h.getRoot ().setLogLevel (ERROR_LOG_LEVEL);
+        CATCH_REQUIRE (! tcp_conn.isEnabledFor (DEBUG_LOG_LEVEL));
+
+        CATCH_REQUIRE (h.setLogLevels (LOG4CPLUS_TEXT ("net.*"),
+                DEBUG_LOG_LEVEL) == 3);
+        CATCH_REQUIRE (net.getLogLevel () == NOT_SET_LOG_LEVEL);
+        CATCH_REQUIRE (network.getLogLevel () == NOT_SET_LOG_LEVEL);
+        CATCH_REQUIRE (tcp.getLogLevel () == DEBUG_LOG_LEVEL);
+        CATCH_REQUIRE (udp.getLogLevel () == DEBUG_LOG_LEVEL);
+        CATCH_REQUIRE (tcp_conn.isEnabledFor (DEBUG_LOG_LEVEL));
+
+        CATCH_REQUIRE (h.setLogLevels (LOG4CPLUS_TEXT ("net.?dp"),
+                WARN_LOG_LEVEL) == 1);
+        CATCH_REQUIRE (udp.getLogLevel () == WARN_LOG_LEVEL);
+        CATCH_REQUIRE (h.setLogLevels (LOG4CPLUS_TEXT ("*.conn"),
+                INFO_LOG_LEVEL) == 1);
+        CATCH_REQUIRE (! tcp_conn.isEnabledFor (DEBUG_LOG_LEVEL));
+        CATCH_REQUIRE (h.setLogLevels (LOG4CPLUS_TEXT ("net"),
+                FATAL_LOG_LEVEL) == 1);
+        CATCH_REQUIRE (net.getLogLevel () == FATAL_LOG_LEVEL);
+        CATCH_REQUIRE (h.setLogLevels (LOG4CPLUS_TEXT ("nope*"),
+                FATAL_LOG_LEVEL) == 0);
+        CATCH_REQUIRE (h.setLogLevels (LOG4CPLUS_TEXT ("*"),
+                NOT_SET_LOG_LEVEL) == 5);
+        CATCH_REQUIRE (h.getRoot ().getLogLevel () == ERROR_LOG_LEVEL);
     }
 }
 
 
-void
-Hierarchy::updateChildren(ProvisionNode& pn, Logger const & logger)
+CATCH_TEST_CASE ("Hierarchies sharing appenders", "[hierarchy]")
 {
-    for (Logger & c : pn)
+    struct TestAppender
+        : Appender
     {
-        // Unless this child already points to a correct (lower) parent,
-        // make logger.parent point to c.parent and c.parent to logger.
-        if( !startsWith(c.value->parent->getName(), logger.getName()) ) {
-            logger.value->parent = c.value->parent;
-            c.value->parent = logger.value;
+        ~TestAppender () { destructorImpl (); }
+
+        void close () override { closed = true; }
+
+        std::vector<tstring> messages;
+
+    protected:
+        void append (spi::InternalLoggingEvent const & ev) override
+        {
+            messages.push_back (ev.getMessage ());
+        }
+    };
+
+    auto const registry = std::make_shared<SharedAppenderRegistry> ();
+    helpers::SharedObjectPtr<TestAppender> shared (new TestAppender);
+    shared->setName (LOG4CPLUS_TEXT ("shared"));
+    registry->put (SharedAppenderPtr (shared.get ()));
+    CATCH_REQUIRE (registry->get (LOG4CPLUS_TEXT ("shared")).get ()
+        == shared.get ());
+    CATCH_REQUIRE (! registry->get (LOG4CPLUS_TEXT ("other")));
+
+    std::unique_ptr<Hierarchy> plugins[2];
+    for (auto & plugin : plugins)
+    {
+        plugin = std::make_unique<Hierarchy> ();
+        plugin->setSharedAppenders (registry);
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("log4cplus.rootLogger"),
+            LOG4CPLUS_TEXT ("INFO, shared"));
+        PropertyConfigurator (props, *plugin).configure ();
+    }
+
+    plugins[0]->getInstance (LOG4CPLUS_TEXT ("a")).forcedLog (INFO_LOG_LEVEL,
+        LOG4CPLUS_TEXT ("first"));
+    plugins[1]->getInstance (LOG4CPLUS_TEXT ("a")).forcedLog (INFO_LOG_LEVEL,
+        LOG4CPLUS_TEXT ("second"));
+    CATCH_REQUIRE (shared->messages.size () == 2);
+
+    // Shutting one plugin down leaves the appender to the other one.
+    plugins[0].reset ();
+    CATCH_REQUIRE (! shared->isClosed ());
+    plugins[1]->resetConfiguration ();
+    CATCH_REQUIRE (! shared->isClosed ());
+    CATCH_REQUIRE (plugins[1]->getRoot ().getAllAppenders ().empty ());
+
+    registry->closeAll ();
+    CATCH_REQUIRE (shared->isClosed ());
+    CATCH_REQUIRE (registry->getAll ().empty ());
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+CATCH_TEST_CASE ("Hierarchy shutdown with deadline", "[hierarchy]")
+{
+    struct TestAppender
+        : Appender
+    {
+        explicit TestAppender (std::chrono::milliseconds delay_)
+            : delay (delay_)
+        { }
+
+        ~TestAppender () { destructorImpl (); }
+
+        void close () override
+        {
+            std::this_thread::sleep_for (delay);
+            closed = true;
         }
+
+        std::chrono::milliseconds const delay;
+
+    protected:
+        void append (spi::InternalLoggingEvent const &) override
+        { }
+    };
+
+    Hierarchy h;
+    SharedAppenderPtr slow (new TestAppender (std::chrono::seconds (2)));
+    slow->setName (LOG4CPLUS_TEXT ("slow"));
+    SharedAppenderPtr fast[3];
+    Logger logger = h.getInstance (LOG4CPLUS_TEXT ("a"));
+    logger.addAppender (slow);
+    for (auto & appender : fast)
+    {
+        appender = SharedAppenderPtr (
+            new TestAppender (std::chrono::milliseconds (100)));
+        logger.addAppender (appender);
+        h.getRoot ().addAppender (appender);
     }
+
+    auto const start = std::chrono::steady_clock::now ();
+    ShutdownReport const report = h.shutdown (std::chrono::milliseconds (500));
+    auto const elapsed = std::chrono::steady_clock::now () - start;
+
+    // Fast appenders close concurrently, each of them once.
+    CATCH_REQUIRE (elapsed < std::chrono::milliseconds (1500));
+    CATCH_REQUIRE (! report.complete ());
+    CATCH_REQUIRE (report.undrainedAppenders
+        == std::vector<tstring> {LOG4CPLUS_TEXT ("slow")});
+    for (auto & appender : fast)
+        CATCH_REQUIRE (appender->isClosed ());
+    CATCH_REQUIRE (logger.getAllAppenders ().empty ());
+    CATCH_REQUIRE (! logger.isEnabledFor (FATAL_LOG_LEVEL));
+
+    h.resetConfiguration ();
+    CATCH_REQUIRE (logger.isEnabledFor (FATAL_LOG_LEVEL));
 }
+#endif
 
+#endif
 
 } // namespace log4cplus
@@ -40,21 +40,21 @@ HierarchyLocker::HierarchyLocker(Hierarchy& _h)
     // Get a copy of all of the Hierarchy's Loggers (except the Root Logger)
     h.initializeLoggerList(loggerList);
 
-    // Lock all of the Hierarchy's Loggers' mutexs
-    LoggerList::iterator it;
+    // Lock all of the Hierarchy's Loggers' mutexs; the loggers share
+    // them.
+    std::size_t i = 0;
     try
     {
-        for (it = loggerList.begin(); it != loggerList.end(); ++it)
-            it->value->appender_list_mutex.lock ();
+        for (; i != h.appenderListMutexes.size (); ++i)
+            h.appenderListMutexes[i].lock ();
     }
     catch (...)
     {
         helpers::getLogLog().error(
             LOG4CPLUS_TEXT("HierarchyLocker::ctor()")
             LOG4CPLUS_TEXT("- An error occurred while locking"));
-        auto range_end = it;
-        for (it = loggerList.begin (); it != range_end; ++it)
-            it->value->appender_list_mutex.unlock ();
+        while (i != 0)
+            h.appenderListMutexes[--i].unlock ();
         throw;
     }
 }
@@ -63,8 +63,8 @@ HierarchyLocker::HierarchyLocker(Hierarchy& _h)
 HierarchyLocker::~HierarchyLocker() LOG4CPLUS_NOEXCEPT_FALSE
 {
     try {
-        for (auto & logger : loggerList)
-            logger.value->appender_list_mutex.unlock ();
+        for (auto & mutex : h.appenderListMutexes)
+            mutex.unlock ();
     }
     catch(...) {
         helpers::getLogLog().error(LOG4CPLUS_TEXT("HierarchyLocker::dtor()- An error occurred while unlocking"));
@@ -113,18 +113,8 @@ HierarchyLocker::getInstance(const tstring& name, spi::LoggerFactory& factory)
 void
 HierarchyLocker::addAppender(Logger& logger, SharedAppenderPtr& appender)
 {
-    for (auto & l : loggerList)
-    {
-        if (l.value == logger.value)
-        {
-            logger.value->appender_list_mutex.unlock ();
-            logger.addAppender(appender);
-            logger.value->appender_list_mutex.lock ();
-            return;
-        }
-    }
-
-    // I don't have this Logger locked
+    // The appender list mutexes are recursive and this thread holds
+    // all of them.
     logger.addAppender(appender);
 }
 
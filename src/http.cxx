@@ -0,0 +1,282 @@
+// Module:  Log4cplus
+// File:    http.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/internal/http.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/version.h>
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#endif
+
+
+namespace log4cplus::internal {
+
+
+namespace
+{
+
+//! Largest HTTP response header that is accepted.
+std::size_t const max_response_header = 16 * 1024;
+
+
+tstring
+trim (tstring const & str)
+{
+    tstring::size_type const begin
+        = str.find_first_not_of (LOG4CPLUS_TEXT (" \t"));
+    if (begin == tstring::npos)
+        return tstring ();
+
+    tstring::size_type const end
+        = str.find_last_not_of (LOG4CPLUS_TEXT (" \t"));
+    return str.substr (begin, end - begin + 1);
+}
+
+} // namespace
+
+
+bool
+parse_http_url (http_url & url, tstring const & str,
+    tstring const & defaultPath)
+{
+    tstring::size_type pos = str.find (LOG4CPLUS_TEXT ("://"));
+    if (pos == tstring::npos)
+        return false;
+
+    tstring const scheme = helpers::toLower (str.substr (0, pos));
+    if (scheme == LOG4CPLUS_TEXT ("https"))
+        url.tls = true;
+    else if (scheme == LOG4CPLUS_TEXT ("http"))
+        url.tls = false;
+    else
+        return false;
+
+    pos += 3;
+    tstring::size_type const pathPos = str.find (LOG4CPLUS_TEXT ('/'), pos);
+    tstring const authority = str.substr (pos, pathPos - pos);
+    url.path = pathPos == tstring::npos ? defaultPath : str.substr (pathPos);
+
+    url.port = url.tls ? 443 : 80;
+    url.ipv6 = false;
+    tstring::size_type portPos = authority.rfind (LOG4CPLUS_TEXT (':'));
+    if (! authority.empty () && authority[0] == LOG4CPLUS_TEXT ('['))
+    {
+        // Bracketed IPv6 address.
+        tstring::size_type const close
+            = authority.find (LOG4CPLUS_TEXT (']'));
+        if (close == tstring::npos)
+            return false;
+
+        if (portPos < close)
+            portPos = tstring::npos;
+        url.host = authority.substr (1, close - 1);
+        url.ipv6 = true;
+    }
+    else
+        url.host = authority.substr (0, portPos);
+
+    if (portPos != tstring::npos)
+    {
+        unsigned long const value = std::strtoul (
+            LOG4CPLUS_TSTRING_TO_STRING (authority.substr (portPos + 1))
+                .c_str (), nullptr, 10);
+        if (value == 0 || value > 0xFFFF)
+            return false;
+
+        url.port = static_cast<unsigned short> (value);
+    }
+
+    return ! url.host.empty ();
+}
+
+
+std::vector<std::pair<tstring, tstring>>
+parse_key_value_list (tstring const & list)
+{
+    std::vector<tstring> items;
+    helpers::tokenize (list, LOG4CPLUS_TEXT (','),
+        std::back_inserter (items));
+
+    std::vector<std::pair<tstring, tstring>> pairs;
+    for (tstring const & item : items)
+    {
+        tstring::size_type const eq = item.find (LOG4CPLUS_TEXT ('='));
+        if (eq == tstring::npos)
+            continue;
+
+        tstring key = trim (item.substr (0, eq));
+        if (! key.empty ())
+            pairs.emplace_back (std::move (key), trim (item.substr (eq + 1)));
+    }
+
+    return pairs;
+}
+
+
+std::string
+http_post_header (http_url const & url,
+    std::vector<std::pair<tstring, tstring>> const & headers)
+{
+    std::string const host = LOG4CPLUS_TSTRING_TO_STRING (url.host);
+    std::string header = "POST ";
+    header += LOG4CPLUS_TSTRING_TO_STRING (url.path);
+    header += " HTTP/1.1\r\nHost: ";
+    header += url.ipv6 ? "[" + host + "]" : host;
+    header += ':';
+    header += std::to_string (url.port);
+    header += "\r\nUser-Agent: log4cplus/" LOG4CPLUS_VERSION_STR "\r\n";
+    for (auto const & kv : headers)
+    {
+        header += LOG4CPLUS_TSTRING_TO_STRING (kv.first);
+        header += ": ";
+        header += LOG4CPLUS_TSTRING_TO_STRING (kv.second);
+        header += "\r\n";
+    }
+
+    return header;
+}
+
+
+int
+read_http_response (helpers::Socket & socket)
+{
+    std::string response;
+    char buf[1024];
+    std::size_t headerEnd;
+    while ((headerEnd = response.find ("\r\n\r\n")) == std::string::npos)
+    {
+        if (response.size () > max_response_header)
+        {
+            socket.close ();
+            return 0;
+        }
+
+        std::size_t const got = socket.readSome (buf, sizeof (buf));
+        if (got == 0)
+            return 0;
+
+        response.append (buf, got);
+    }
+
+    // Status line is, e.g., "HTTP/1.1 200 OK".
+    int status = 0;
+    std::size_t pos = response.find (' ');
+    if (pos != std::string::npos)
+        for (++pos; pos < headerEnd && response[pos] >= '0'
+                 && response[pos] <= '9' && status < 1000; ++pos)
+            status = status * 10 + (response[pos] - '0');
+
+    if (status < 100 || status >= 1000)
+    {
+        socket.close ();
+        return 0;
+    }
+
+    std::string headers (response, 0, headerEnd + 2);
+    std::transform (headers.begin (), headers.end (), headers.begin (),
+        [] (char ch) {
+            return ch >= 'A' && ch <= 'Z' ? static_cast<char> (ch - 'A' + 'a')
+                : ch; });
+
+    bool const reusable
+        = headers.find ("\r\nconnection: close") == std::string::npos
+        && headers.compare (0, 9, "http/1.0 ") != 0;
+    bool knownLength = status == 204 || status == 304;
+    std::size_t contentLength = 0;
+    pos = headers.find ("\r\ncontent-length:");
+    if (pos != std::string::npos)
+    {
+        pos += 17;
+        while (pos < headers.size () && headers[pos] == ' ')
+            ++pos;
+        for (; pos < headers.size () && headers[pos] >= '0'
+                 && headers[pos] <= '9'; ++pos)
+            contentLength = contentLength * 10
+                + static_cast<std::size_t> (headers[pos] - '0');
+        knownLength = true;
+    }
+
+    // Body of unknown length, e.g., chunked one, is not parsed; the
+    // connection is closed instead.
+    std::size_t have = response.size () - headerEnd - 4;
+    while (knownLength && have < contentLength)
+    {
+        std::size_t const got = socket.readSome (buf,
+            (std::min) (sizeof (buf), contentLength - have));
+        if (got == 0)
+            return status;
+
+        have += got;
+    }
+
+    if (! reusable || ! knownLength)
+        socket.close ();
+
+    return status;
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("HTTP URL", "[http]")
+{
+    http_url url;
+    CATCH_REQUIRE (parse_http_url (url,
+        LOG4CPLUS_TEXT ("https://[::1]:9200/_bulk")));
+    CATCH_REQUIRE (url.host == LOG4CPLUS_TEXT ("::1"));
+    CATCH_REQUIRE (url.port == 9200);
+    CATCH_REQUIRE (url.path == LOG4CPLUS_TEXT ("/_bulk"));
+    CATCH_REQUIRE (url.tls);
+    CATCH_REQUIRE (url.ipv6);
+
+    CATCH_REQUIRE (parse_http_url (url, LOG4CPLUS_TEXT ("HTTP://loki"),
+        LOG4CPLUS_TEXT ("/loki/api/v1/push")));
+    CATCH_REQUIRE (url.host == LOG4CPLUS_TEXT ("loki"));
+    CATCH_REQUIRE (url.port == 80);
+    CATCH_REQUIRE (url.path == LOG4CPLUS_TEXT ("/loki/api/v1/push"));
+    CATCH_REQUIRE (! url.tls);
+    CATCH_REQUIRE (! url.ipv6);
+
+    CATCH_REQUIRE (! parse_http_url (url, LOG4CPLUS_TEXT ("ftp://host/")));
+    CATCH_REQUIRE (! parse_http_url (url, LOG4CPLUS_TEXT ("http://host:0/")));
+    CATCH_REQUIRE (! parse_http_url (url, LOG4CPLUS_TEXT ("host:80")));
+
+    auto const headers = parse_key_value_list (
+        LOG4CPLUS_TEXT ("Authorization = Splunk abc, X-Scope-OrgID=1,bad"));
+    CATCH_REQUIRE (headers.size () == 2);
+    CATCH_REQUIRE (headers[0].first == LOG4CPLUS_TEXT ("Authorization"));
+    CATCH_REQUIRE (headers[0].second == LOG4CPLUS_TEXT ("Splunk abc"));
+    CATCH_REQUIRE (headers[1].second == LOG4CPLUS_TEXT ("1"));
+}
+#endif
+
+
+} // namespace log4cplus::internal
@@ -0,0 +1,989 @@
+// Module:  Log4cplus
+// File:    httpbulkappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/config.hxx>
+#ifndef LOG4CPLUS_SINGLE_THREADED
+
+#include <log4cplus/httpbulkappender.h>
+#include <log4cplus/spi/factory.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/helpers/connectorthread.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/helpers/tlscontext.h>
+#include <log4cplus/internal/http.h>
+#include <log4cplus/internal/internal.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/thread/threads.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+#include <zlib.h>
+#endif
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/layout.h>
+#include <catch.hpp>
+#include <atomic>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+//! Upper bound of the delay between retries, in milliseconds.
+unsigned const max_retry_backoff = 30 * 1000;
+
+
+//! Parses size with optional "KB" or "MB" suffix.
+bool
+parse_size (std::size_t & size, tstring const & str)
+{
+    tstring const tmp = helpers::toUpper (str);
+    if (tmp.empty ())
+        return false;
+
+    size = std::strtoul (LOG4CPLUS_TSTRING_TO_STRING (tmp).c_str (),
+        nullptr, 10);
+    tstring::size_type const len = tmp.length ();
+    if (len > 2 && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT ("MB")) == 0)
+        size *= (1024 * 1024); // convert to megabytes
+    else if (len > 2 && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT ("KB")) == 0)
+        size *= 1024; // convert to kilobytes
+    return true;
+}
+
+
+//! \return <code>str</code> without trailing line terminator added
+//! by layouts.
+tstring_view
+strip_newline (tstring_view str)
+{
+    while (! str.empty () && (str.back () == LOG4CPLUS_TEXT ('\n')
+            || str.back () == LOG4CPLUS_TEXT ('\r')))
+        str.remove_suffix (1);
+    return str;
+}
+
+
+void
+append_json_string (std::string & out, tstring_view str)
+{
+    tstring escaped;
+    internal::append_json_escaped (escaped, str);
+    out += '"';
+    internal::append_utf8 (out, escaped);
+    out += '"';
+}
+
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+//! Compresses <code>in</code> into gzip member in <code>out</code>.
+bool
+gzip_compress (std::string & out, std::string_view in)
+{
+    z_stream zs {};
+    if (deflateInit2 (&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+            Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+
+    out.resize (deflateBound (&zs, static_cast<uLong> (in.size ())));
+    zs.next_in = reinterpret_cast<Bytef *> (const_cast<char *> (in.data ()));
+    zs.avail_in = static_cast<uInt> (in.size ());
+    zs.next_out = reinterpret_cast<Bytef *> (&out[0]);
+    zs.avail_out = static_cast<uInt> (out.size ());
+    int const ret = deflate (&zs, Z_FINISH);
+    out.resize (zs.total_out);
+    deflateEnd (&zs);
+    return ret == Z_STREAM_END;
+}
+#endif
+
+
+} // namespace
+
+
+namespace internal
+{
+
+struct http_bulk_sender;
+
+
+//! Sealed request body.
+struct http_bulk_body
+{
+    std::string data;
+    std::size_t records;
+    //! Order of sealing, used by flush.
+    std::uint64_t seq;
+};
+
+
+//! Persistent connection of one sender thread. The ConnectorThread
+//! reopens it in the background when the sender thread finds it
+//! closed.
+struct http_bulk_connection
+    : public helpers::IConnectorThreadClient
+{
+    explicit http_bulk_connection (http_bulk_sender & s)
+        : sender (s)
+    { }
+
+    thread::Mutex const &
+    ctcGetAccessMutex () const override
+    {
+        return mutex;
+    }
+
+    helpers::Socket &
+    ctcGetSocket () override
+    {
+        return socket;
+    }
+
+    helpers::Socket ctcConnect () override;
+
+    void
+    ctcSetConnected () override
+    {
+        connected.signal ();
+    }
+
+    http_bulk_sender & sender;
+    thread::Mutex mutex;
+    helpers::Socket socket;
+    thread::ManualResetEvent connected;
+    helpers::SharedObjectPtr<helpers::ConnectorThread> connector;
+    std::thread worker;
+};
+
+
+//! Queue of sealed bodies and the sender threads posting them, one per
+//! connection.
+struct http_bulk_sender
+{
+    http_bulk_sender (http_url const & url_, std::string header,
+        std::unique_ptr<helpers::TlsContext> tls, unsigned maxInFlight)
+        : url (url_)
+        , requestHeader (std::move (header))
+        , tlsContext (std::move (tls))
+    {
+        for (unsigned i = 0; i != maxInFlight; ++i)
+            connections.emplace_back (new http_bulk_connection (*this));
+
+        for (auto & conn : connections)
+        {
+            conn->connector = new helpers::ConnectorThread (*conn);
+            conn->connector->start ();
+            conn->worker = std::thread ([this, c = conn.get ()] {
+                run (*c); });
+        }
+    }
+
+    ~http_bulk_sender ()
+    {
+        stop ();
+    }
+
+    //! Queues <code>data</code> holding <code>records</code> records.
+    //! \return <code>false</code> when the body has been dropped.
+    bool
+    submit (std::string && data, std::size_t records)
+    {
+        std::unique_lock<std::mutex> lock (mtx);
+        if (exit
+            || (! queue.empty () && queuedBytes + data.size () > queueLimit))
+        {
+            stats.droppedRecords += records;
+            return false;
+        }
+
+        queuedBytes += data.size ();
+        queue.push_back (http_bulk_body {std::move (data), records, ++sealed});
+        lock.unlock ();
+
+        cond.notify_one ();
+        return true;
+    }
+
+    //! Waits until all bodies submitted so far have been sent or have
+    //! failed.
+    void
+    waitSent ()
+    {
+        std::unique_lock<std::mutex> lock (mtx);
+        std::uint64_t const target = sealed;
+        done.wait (lock, [&] {
+            return (queue.empty () || queue.front ().seq > target)
+                && (inFlight.empty () || *inFlight.begin () > target); });
+    }
+
+    //! Sends what is queued, joins the sender threads and closes the
+    //! connections.
+    void
+    stop ()
+    {
+        {
+            std::lock_guard<std::mutex> lock (mtx);
+            if (exit)
+                return;
+            exit = true;
+        }
+        cond.notify_all ();
+        backoff.notify_all ();
+
+        for (auto & conn : connections)
+            if (conn->worker.joinable ())
+                conn->worker.join ();
+
+        for (auto & conn : connections)
+        {
+            conn->connector->terminate ();
+            thread::MutexGuard guard (conn->mutex);
+            conn->socket.close ();
+        }
+    }
+
+    HttpBulkAppender::SendStats
+    getStats () const
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        HttpBulkAppender::SendStats ret = stats;
+        ret.queuedBytes = queuedBytes;
+        return ret;
+    }
+
+    bool
+    stopping () const
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        return exit;
+    }
+
+    http_url url;
+    std::string requestHeader;
+    std::unique_ptr<helpers::TlsContext> tlsContext;
+    bool gzip = false;
+    unsigned maxRetries = 3;
+    unsigned retryBackoff = 500;
+    std::size_t queueLimit = 16 * 1024 * 1024;
+
+private:
+    void
+    run (http_bulk_connection & conn)
+    {
+        thread::blockAllSignals ();
+        thread::applyBackgroundThreadSettings (LOG4CPLUS_TEXT ("http"));
+
+        std::string compressed;
+        std::unique_lock<std::mutex> lock (mtx);
+        for (;;)
+        {
+            cond.wait (lock, [this] { return exit || ! queue.empty (); });
+            if (queue.empty ())
+                break;
+
+            http_bulk_body body = std::move (queue.front ());
+            queue.pop_front ();
+            queuedBytes -= body.data.size ();
+            inFlight.insert (body.seq);
+            lock.unlock ();
+
+            bool const ok = send (conn, body, compressed);
+
+            lock.lock ();
+            inFlight.erase (body.seq);
+            if (ok)
+            {
+                ++stats.requests;
+                stats.sentRecords += body.records;
+            }
+            else
+                stats.failedRecords += body.records;
+            done.notify_all ();
+        }
+    }
+
+    //! Posts <code>body</code>, retrying it with exponential backoff.
+    bool
+    send (http_bulk_connection & conn, http_bulk_body const & body,
+        std::string & compressed)
+    {
+        std::string header = requestHeader;
+        std::string_view payload = body.data;
+#if defined (LOG4CPLUS_WITH_ZLIB)
+        if (gzip && gzip_compress (compressed, body.data))
+        {
+            header += "Content-Encoding: gzip\r\n";
+            payload = compressed;
+        }
+#else
+        (void) compressed;
+#endif
+        header += "Content-Length: ";
+        header += std::to_string (payload.size ());
+        header += "\r\n\r\n";
+        std::string_view const parts[] = {header, payload};
+
+        unsigned delay = retryBackoff;
+        for (unsigned attempt = 0; ; ++attempt)
+        {
+            int const status = post (conn, parts);
+            if (status / 100 == 2)
+                return true;
+
+            if (status != 0)
+                helpers::getLogLog ().warn (
+                    LOG4CPLUS_TEXT ("HttpBulkAppender")
+                    LOG4CPLUS_TEXT ("- endpoint responded with status ")
+                    + helpers::convertIntegerToString (status));
+
+            // Bodies left at closing are not retried, so that closing
+            // does not wait for unreachable endpoint.
+            bool const retriable = status == 0 || status == 408
+                || status == 429 || status / 100 == 5;
+            std::unique_lock<std::mutex> lock (mtx);
+            if (! retriable || attempt == maxRetries || exit)
+            {
+                lock.unlock ();
+                helpers::getLogLog ().error (
+                    LOG4CPLUS_TEXT ("HttpBulkAppender")
+                    LOG4CPLUS_TEXT ("- request failed, records lost: ")
+                    + helpers::convertIntegerToString (body.records));
+                return false;
+            }
+
+            ++stats.retries;
+            backoff.wait_for (lock, std::chrono::milliseconds (delay),
+                [this] { return exit; });
+            delay = (std::min) (delay * 2, max_retry_backoff);
+        }
+    }
+
+    //! Writes request over kept alive connection of <code>conn</code>.
+    //! \return Status code, or 0 when no response was received.
+    int
+    post (http_bulk_connection & conn,
+        std::span<std::string_view const> parts)
+    {
+        thread::MutexGuard guard (conn.mutex);
+
+        // Endpoint may have closed kept alive connection meanwhile;
+        // such request is retried once over new connection.
+        for (int attempt = 0; attempt != 2; ++attempt)
+        {
+            bool const reused = conn.socket.isOpen ();
+            if (! reused)
+            {
+                conn.connected.reset ();
+                guard.unlock ();
+                conn.connector->trigger ();
+                conn.connected.timed_wait (stopping () ? 1000 : 5000);
+                guard.lock ();
+                if (! conn.socket.isOpen ())
+                    return 0;
+            }
+
+            int status = 0;
+            if (conn.socket.write (parts))
+                status = read_http_response (conn.socket);
+            else
+                conn.socket.close ();
+
+            if (status != 0 || ! reused)
+                return status;
+        }
+
+        return 0;
+    }
+
+    std::vector<std::unique_ptr<http_bulk_connection>> connections;
+
+    mutable std::mutex mtx;
+    std::condition_variable cond;
+    //! Signalled when a body has been sent or has failed.
+    std::condition_variable done;
+    //! Cuts retry backoff short at closing.
+    std::condition_variable backoff;
+    std::deque<http_bulk_body> queue;
+    std::size_t queuedBytes = 0;
+    //! Sequence numbers of bodies being sent.
+    std::set<std::uint64_t> inFlight;
+    //! Count of bodies ever submitted.
+    std::uint64_t sealed = 0;
+    HttpBulkAppender::SendStats stats;
+    bool exit = false;
+};
+
+
+helpers::Socket
+http_bulk_connection::ctcConnect ()
+{
+    http_url const & url = sender.url;
+    helpers::Socket sock (url.host, url.port, false, url.ipv6);
+    if (sock.isOpen () && url.tls
+        && ! (sender.tlsContext && sock.startTls (*sender.tlsContext)))
+        sock.close ();
+    return sock;
+}
+
+} // namespace internal
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HttpBulkAppender ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+HttpBulkAppender::HttpBulkAppender (tstring const & url, BodyFormat format_)
+    : format (format_)
+    , maxBodySize (1024 * 1024)
+    , flushInterval (1000)
+    , bulkAction ("{\"index\":{}}")
+    , bodyRecords (0)
+    , flushTimerRegistered (false)
+{
+    init (url, helpers::Properties ());
+}
+
+
+HttpBulkAppender::HttpBulkAppender (helpers::Properties const & properties)
+    : Appender (properties)
+    , format (NDJSON)
+    , maxBodySize (1024 * 1024)
+    , flushInterval (1000)
+    , bulkAction ("{\"index\":{}}")
+    , bodyRecords (0)
+    , flushTimerRegistered (false)
+{
+    tstring const formatName = helpers::toUpper (
+        properties.getProperty (LOG4CPLUS_TEXT ("Format")));
+    if (formatName == LOG4CPLUS_TEXT ("JSON"))
+        format = JSON_ARRAY;
+    else if (formatName == LOG4CPLUS_TEXT ("ELASTICSEARCH"))
+        format = ELASTICSEARCH_BULK;
+    else if (formatName == LOG4CPLUS_TEXT ("LOKI"))
+        format = LOKI_PUSH;
+    else if (formatName == LOG4CPLUS_TEXT ("SPLUNK"))
+        format = SPLUNK_HEC;
+    else if (! formatName.empty () && formatName != LOG4CPLUS_TEXT ("NDJSON"))
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("HttpBulkAppender")
+            LOG4CPLUS_TEXT ("- unknown Format: ") + formatName);
+
+    tstring action;
+    if (properties.getString (action, LOG4CPLUS_TEXT ("BulkAction")))
+    {
+        bulkAction.clear ();
+        internal::append_utf8 (bulkAction, action);
+    }
+
+    parse_size (maxBodySize,
+        properties.getProperty (LOG4CPLUS_TEXT ("MaxBodySize")));
+    properties.getUInt (flushInterval, LOG4CPLUS_TEXT ("FlushInterval"));
+
+    init (properties.getProperty (LOG4CPLUS_TEXT ("URL")), properties);
+}
+
+
+HttpBulkAppender::~HttpBulkAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+HttpBulkAppender::init (tstring const & urlStr,
+    helpers::Properties const & properties)
+{
+    internal::http_url url;
+    if (! internal::parse_http_url (url, urlStr))
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("HttpBulkAppender")
+            LOG4CPLUS_TEXT ("- unsupported URL: ") + urlStr, true);
+
+    bool ipv6 = false;
+    properties.getBool (ipv6, LOG4CPLUS_TEXT ("IPv6"));
+    url.ipv6 = url.ipv6 || ipv6;
+
+    std::unique_ptr<helpers::TlsContext> tlsContext;
+    if (url.tls)
+    {
+        helpers::TlsConfig config;
+        config.serverName = url.host;
+        config.caFile = properties.getProperty (LOG4CPLUS_TEXT ("TlsCAFile"));
+        config.certFile = properties.getProperty (
+            LOG4CPLUS_TEXT ("TlsCertFile"));
+        config.keyFile = properties.getProperty (
+            LOG4CPLUS_TEXT ("TlsKeyFile"));
+        properties.getString (config.serverName,
+            LOG4CPLUS_TEXT ("TlsServerName"));
+        properties.getBool (config.verifyPeer,
+            LOG4CPLUS_TEXT ("TlsVerifyPeer"));
+
+        tlsContext = helpers::createTlsContext (config);
+        if (! tlsContext)
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("HttpBulkAppender")
+                LOG4CPLUS_TEXT ("- TLS is not available"));
+    }
+
+    switch (format)
+    {
+    case NDJSON:
+    case ELASTICSEARCH_BULK:
+    case SPLUNK_HEC:
+        break;
+
+    case JSON_ARRAY:
+        bodyPrefix = "[";
+        separator = ",";
+        bodySuffix = "]";
+        break;
+
+    case LOKI_PUSH:
+    {
+        bodyPrefix = "{\"streams\":[{\"stream\":{";
+        bool first = true;
+        for (auto const & label : internal::parse_key_value_list (
+                properties.getProperty (LOG4CPLUS_TEXT ("Labels"))))
+        {
+            if (! first)
+                bodyPrefix += ',';
+            first = false;
+            append_json_string (bodyPrefix, label.first);
+            bodyPrefix += ':';
+            append_json_string (bodyPrefix, label.second);
+        }
+        bodyPrefix += "},\"values\":[";
+        separator = ",";
+        bodySuffix = "]}]}";
+        break;
+    }
+    }
+
+    tstring contentType = format == NDJSON || format == ELASTICSEARCH_BULK
+        ? LOG4CPLUS_TEXT ("application/x-ndjson")
+        : LOG4CPLUS_TEXT ("application/json");
+    properties.getString (contentType, LOG4CPLUS_TEXT ("ContentType"));
+
+    std::string header = internal::http_post_header (url,
+        internal::parse_key_value_list (
+            properties.getProperty (LOG4CPLUS_TEXT ("Headers"))));
+    header += "Content-Type: ";
+    internal::append_utf8 (header, contentType);
+    header += "\r\n";
+
+    unsigned maxInFlight = 2;
+    properties.getUInt (maxInFlight, LOG4CPLUS_TEXT ("MaxInFlight"));
+
+    sender.reset (new internal::http_bulk_sender (url, std::move (header),
+        std::move (tlsContext), (std::max) (maxInFlight, 1u)));
+
+    bool gzip = false;
+    if (properties.getBool (gzip, LOG4CPLUS_TEXT ("Gzip")) && gzip)
+    {
+#if defined (LOG4CPLUS_WITH_ZLIB)
+        sender->gzip = true;
+#else
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("HttpBulkAppender")
+            LOG4CPLUS_TEXT ("- gzip compression is not available"));
+#endif
+    }
+    properties.getUInt (sender->maxRetries, LOG4CPLUS_TEXT ("MaxRetries"));
+    properties.getUInt (sender->retryBackoff,
+        LOG4CPLUS_TEXT ("RetryBackoff"));
+    sender->retryBackoff = (std::max) (sender->retryBackoff, 1u);
+    parse_size (sender->queueLimit,
+        properties.getProperty (LOG4CPLUS_TEXT ("QueueLimit")));
+
+    if (flushInterval != 0)
+    {
+        internal::add_timer (this,
+            std::chrono::milliseconds (flushInterval),
+            [this]
+            {
+                thread::MutexGuard guard (access_mutex);
+                if (bodyRecords != 0)
+                    sealBody ();
+            });
+        flushTimerRegistered = true;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HttpBulkAppender public methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+HttpBulkAppender::close ()
+{
+    // This has to be done before locking access_mutex; the timer thread
+    // locks it while holding its own mutex.
+    if (flushTimerRegistered)
+    {
+        internal::remove_timer (this);
+        flushTimerRegistered = false;
+    }
+
+    {
+        thread::MutexGuard guard (access_mutex);
+        if (bodyRecords != 0)
+            sealBody ();
+    }
+
+    if (sender)
+        sender->stop ();
+
+    closed = true;
+}
+
+
+void
+HttpBulkAppender::flush ()
+{
+    {
+        thread::MutexGuard guard (access_mutex);
+        if (bodyRecords != 0)
+            sealBody ();
+    }
+
+    if (sender)
+        sender->waitSent ();
+}
+
+
+HttpBulkAppender::SendStats
+HttpBulkAppender::getStats () const
+{
+    return sender ? sender->getStats () : SendStats ();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HttpBulkAppender protected methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+HttpBulkAppender::append (spi::InternalLoggingEvent const & event)
+{
+    scratch.clear ();
+    formatEvent (event, scratch);
+    record.clear ();
+    encodeRecord (record, event, scratch);
+
+    if (bodyRecords != 0 && body.size () + separator.size () + record.size ()
+        + bodySuffix.size () > maxBodySize)
+        sealBody ();
+
+    if (bodyRecords == 0)
+        body = bodyPrefix;
+    else
+        body += separator;
+    body += record;
+    ++bodyRecords;
+
+    if (body.size () + bodySuffix.size () >= maxBodySize)
+        sealBody ();
+}
+
+
+void
+HttpBulkAppender::encodeRecord (std::string & out,
+    spi::InternalLoggingEvent const & event, tstring const & formatted) const
+{
+    switch (format)
+    {
+    case NDJSON:
+    case ELASTICSEARCH_BULK:
+        if (format == ELASTICSEARCH_BULK)
+        {
+            out += bulkAction;
+            out += '\n';
+        }
+        internal::append_utf8 (out, strip_newline (formatted));
+        out += '\n';
+        break;
+
+    case JSON_ARRAY:
+        internal::append_utf8 (out, strip_newline (formatted));
+        break;
+
+    case LOKI_PUSH:
+        out += "[\"";
+        out += std::to_string (
+            std::chrono::duration_cast<std::chrono::nanoseconds> (
+                event.getTimestamp ().time_since_epoch ()).count ());
+        out += "\",";
+        append_json_string (out, strip_newline (formatted));
+        out += ']';
+        break;
+
+    case SPLUNK_HEC:
+    {
+        auto const micros = std::chrono::duration_cast<
+            std::chrono::microseconds> (
+                event.getTimestamp ().time_since_epoch ()).count ();
+        std::string fraction = std::to_string (micros % 1000000);
+        out += "{\"time\":";
+        out += std::to_string (micros / 1000000);
+        out += '.';
+        out.append (6 - fraction.size (), '0');
+        out += fraction;
+        out += ",\"event\":";
+        append_json_string (out, strip_newline (formatted));
+        out += "}\n";
+        break;
+    }
+    }
+}
+
+
+void
+HttpBulkAppender::sealBody ()
+{
+    body += bodySuffix;
+    std::size_t const records = bodyRecords;
+    bodyRecords = 0;
+    if (! sender || ! sender->submit (std::move (body), records))
+        for (std::size_t i = 0; i != records; ++i)
+            recordDroppedEvent ();
+    body.clear ();
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+namespace
+{
+
+//! Minimal HTTP server answering requests of single connection at a
+//! time with statuses from <code>statuses</code>, then with 200.
+struct test_http_server
+{
+    explicit test_http_server (unsigned short port)
+        : server (port, false, false, LOG4CPLUS_TEXT ("localhost"))
+    {
+        thread = std::thread ([this] { run (); });
+    }
+
+    ~test_http_server ()
+    {
+        server.interruptAccept ();
+        thread.join ();
+    }
+
+    std::vector<std::string>
+    getBodies ()
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        return bodies;
+    }
+
+    helpers::ServerSocket server;
+    std::mutex mtx;
+    std::vector<std::string> headers;
+    std::vector<std::string> bodies;
+    std::deque<int> statuses;
+    std::atomic<int> connections {0};
+    std::thread thread;
+
+private:
+    void
+    run ()
+    {
+        for (;;)
+        {
+            helpers::Socket client = server.accept ();
+            if (! client.isOpen ())
+                return;
+
+            ++connections;
+            serve (client);
+        }
+    }
+
+    void
+    serve (helpers::Socket & client)
+    {
+        std::string buffer;
+        char chunk[4096];
+        for (;;)
+        {
+            std::size_t const headerEnd = buffer.find ("\r\n\r\n");
+            if (headerEnd != std::string::npos)
+            {
+                std::string const header = buffer.substr (0, headerEnd + 4);
+                std::size_t const lengthPos = header.find ("Content-Length: ");
+                if (lengthPos == std::string::npos)
+                    return;
+                std::size_t const length = std::strtoul (
+                    header.c_str () + lengthPos + 16, nullptr, 10);
+                if (buffer.size () >= headerEnd + 4 + length)
+                {
+                    int status = 200;
+                    {
+                        std::lock_guard<std::mutex> lock (mtx);
+                        headers.push_back (header);
+                        bodies.push_back (buffer.substr (headerEnd + 4,
+                            length));
+                        if (! statuses.empty ())
+                        {
+                            status = statuses.front ();
+                            statuses.pop_front ();
+                        }
+                    }
+                    buffer.erase (0, headerEnd + 4 + length);
+                    client.write ("HTTP/1.1 " + std::to_string (status)
+                        + " X\r\nContent-Length: 2\r\n\r\nok");
+                    continue;
+                }
+            }
+
+            std::size_t const read = client.readSome (chunk, sizeof (chunk));
+            if (read == 0)
+                return;
+            buffer.append (chunk, read);
+        }
+    }
+};
+
+} // namespace
+
+
+CATCH_TEST_CASE ("HttpBulkAppender", "[appender][http]")
+{
+    unsigned short const port = 29523;
+    test_http_server server (port);
+    CATCH_REQUIRE (server.server.isOpen ());
+
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("URL"),
+        LOG4CPLUS_TEXT ("http://localhost:")
+        + helpers::convertIntegerToString (port)
+        + LOG4CPLUS_TEXT ("/ingest"));
+    props.setProperty (LOG4CPLUS_TEXT ("MaxInFlight"), LOG4CPLUS_TEXT ("1"));
+    props.setProperty (LOG4CPLUS_TEXT ("FlushInterval"), LOG4CPLUS_TEXT ("0"));
+    props.setProperty (LOG4CPLUS_TEXT ("RetryBackoff"), LOG4CPLUS_TEXT ("1"));
+    props.setProperty (LOG4CPLUS_TEXT ("Headers"),
+        LOG4CPLUS_TEXT ("Authorization=Bearer t"));
+
+    auto const make_event = [] (tchar const * msg) {
+        return spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("test"),
+            INFO_LOG_LEVEL, msg, nullptr, 0); };
+
+    CATCH_SECTION ("NDJSON bodies over kept alive connection")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("MaxBodySize"),
+            LOG4CPLUS_TEXT ("25"));
+        HttpBulkAppender appender (props);
+        appender.setLayout (std::unique_ptr<Layout> (
+            new PatternLayout (LOG4CPLUS_TEXT ("{\"m\":\"%m\"}%n"))));
+        {
+            std::lock_guard<std::mutex> lock (server.mtx);
+            server.statuses.push_back (503);
+        }
+
+        // Two 10 byte records fit into 25 bytes, the third seals them.
+        appender.doAppend (make_event (LOG4CPLUS_TEXT ("a")));
+        appender.doAppend (make_event (LOG4CPLUS_TEXT ("b")));
+        appender.doAppend (make_event (LOG4CPLUS_TEXT ("c")));
+        appender.flush ();
+
+        HttpBulkAppender::SendStats const stats = appender.getStats ();
+        CATCH_REQUIRE (stats.requests == 2);
+        CATCH_REQUIRE (stats.sentRecords == 3);
+        CATCH_REQUIRE (stats.failedRecords == 0);
+        CATCH_REQUIRE (stats.retries == 1);
+
+        std::vector<std::string> const bodies = server.getBodies ();
+        CATCH_REQUIRE (bodies.size () == 3);
+        CATCH_REQUIRE (bodies[0] == "{\"m\":\"a\"}\n{\"m\":\"b\"}\n");
+        CATCH_REQUIRE (bodies[1] == bodies[0]);
+        CATCH_REQUIRE (bodies[2] == "{\"m\":\"c\"}\n");
+        CATCH_REQUIRE (server.connections == 1);
+
+        std::lock_guard<std::mutex> lock (server.mtx);
+        CATCH_REQUIRE (server.headers[0].find ("POST /ingest HTTP/1.1\r\n")
+            == 0);
+        CATCH_REQUIRE (server.headers[0].find (
+            "\r\nContent-Type: application/x-ndjson\r\n")
+            != std::string::npos);
+        CATCH_REQUIRE (server.headers[0].find (
+            "\r\nAuthorization: Bearer t\r\n") != std::string::npos);
+    }
+
+    CATCH_SECTION ("Loki push body")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("Format"), LOG4CPLUS_TEXT ("Loki"));
+        props.setProperty (LOG4CPLUS_TEXT ("Labels"),
+            LOG4CPLUS_TEXT ("job=app"));
+        HttpBulkAppender appender (props);
+        appender.setLayout (std::unique_ptr<Layout> (
+            new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+
+        spi::InternalLoggingEvent const ev1 (make_event (
+            LOG4CPLUS_TEXT ("say \"hi\"")));
+        spi::InternalLoggingEvent const ev2 (make_event (
+            LOG4CPLUS_TEXT ("bye")));
+        appender.doAppend (ev1);
+        appender.doAppend (ev2);
+        appender.close ();
+
+        auto const ns = [] (spi::InternalLoggingEvent const & ev) {
+            return std::to_string (
+                std::chrono::duration_cast<std::chrono::nanoseconds> (
+                    ev.getTimestamp ().time_since_epoch ()).count ()); };
+        std::vector<std::string> const bodies = server.getBodies ();
+        CATCH_REQUIRE (bodies.size () == 1);
+        CATCH_REQUIRE (bodies[0]
+            == "{\"streams\":[{\"stream\":{\"job\":\"app\"},\"values\":[[\""
+            + ns (ev1) + "\",\"say \\\"hi\\\"\"],[\"" + ns (ev2)
+            + "\",\"bye\"]]}]}");
+        CATCH_REQUIRE (appender.getStats ().sentRecords == 2);
+    }
+}
+
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_SINGLE_THREADED
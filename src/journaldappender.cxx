@@ -0,0 +1,479 @@
+// Module:  Log4cplus
+// File:    journaldappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <log4cplus/config.hxx>
+#if defined (LOG4CPLUS_HAVE_SYS_UN_H) && ! defined (_WIN32)
+
+#if defined (LOG4CPLUS_HAVE_SYS_TYPES_H)
+#include <sys/types.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_SYS_SOCKET_H)
+#include <sys/socket.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_FCNTL_H)
+#include <fcntl.h>
+#endif
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include <log4cplus/journaldappender.h>
+#include <log4cplus/loglevel.h>
+#include <log4cplus/ndc.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <log4cplus/mdc.h>
+#include <cstdio>
+#include <vector>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+char const default_journal_socket[] = "/run/systemd/journal/socket";
+
+
+//! Priority of the journal, the same as that of SysLogAppender.
+int
+journal_priority (LogLevel ll)
+{
+    if (ll < INFO_LOG_LEVEL)
+        return 7; // LOG_DEBUG
+    else if (ll < WARN_LOG_LEVEL)
+        return 6; // LOG_INFO
+    else if (ll < ERROR_LOG_LEVEL)
+        return 4; // LOG_WARNING
+    else if (ll < FATAL_LOG_LEVEL)
+        return 3; // LOG_ERR
+    else if (ll == FATAL_LOG_LEVEL)
+        return 2; // LOG_CRIT
+    else
+        return 1; // LOG_ALERT
+}
+
+
+//! Appends field in the native journal format. Values with new lines
+//! are written in the binary form, with 64-bit little endian length.
+void
+append_field (std::string & out, std::string_view name,
+    std::string_view value)
+{
+    if (value.empty ())
+        return;
+
+    out.append (name);
+    if (value.find ('\n') == std::string_view::npos)
+    {
+        out += '=';
+        out.append (value);
+    }
+    else
+    {
+        out += '\n';
+        std::uint64_t const size = value.size ();
+        for (unsigned i = 0; i != 8; ++i)
+            out += static_cast<char> ((size >> (i * 8)) & 0xFF);
+        out.append (value);
+    }
+    out += '\n';
+}
+
+
+void
+append_field (std::string & out, std::string_view name,
+    tstring const & value)
+{
+#if defined (UNICODE)
+    append_field (out, name, std::string_view (
+        LOG4CPLUS_TSTRING_TO_STRING (value)));
+#else
+    append_field (out, name, std::string_view (value));
+#endif
+}
+
+
+//! Turns <code>key</code> into valid journal field name.
+std::string
+journal_field_name (tstring const & key)
+{
+    // Journal limits field names to 64 characters.
+    std::size_t const max_name = 64;
+
+    std::string name;
+    if (key.empty ()
+        || ! ((key[0] >= LOG4CPLUS_TEXT ('A') && key[0] <= LOG4CPLUS_TEXT ('Z'))
+            || (key[0] >= LOG4CPLUS_TEXT ('a')
+                && key[0] <= LOG4CPLUS_TEXT ('z'))))
+        name = "X_";
+
+    for (tchar ch : key)
+    {
+        if (name.size () == max_name)
+            break;
+
+        if (ch >= LOG4CPLUS_TEXT ('a') && ch <= LOG4CPLUS_TEXT ('z'))
+            name += static_cast<char> (ch - LOG4CPLUS_TEXT ('a') + 'A');
+        else if ((ch >= LOG4CPLUS_TEXT ('A') && ch <= LOG4CPLUS_TEXT ('Z'))
+            || (ch >= LOG4CPLUS_TEXT ('0') && ch <= LOG4CPLUS_TEXT ('9')))
+            name += static_cast<char> (ch);
+        else
+            name += '_';
+    }
+
+    return name;
+}
+
+} // namespace
+
+
+JournaldAppender::JournaldAppender (tstring const & ident_)
+    : ident (LOG4CPLUS_TSTRING_TO_STRING (ident_))
+    , socketPath (default_journal_socket)
+    , fd (-1)
+{
+    open ();
+}
+
+
+JournaldAppender::JournaldAppender (helpers::Properties const & props)
+    : Appender (props)
+    , socketPath (default_journal_socket)
+    , fd (-1)
+{
+    ident = LOG4CPLUS_TSTRING_TO_STRING (
+        props.getProperty (LOG4CPLUS_TEXT ("Ident")));
+    tstring const & socket_path
+        = props.getProperty (LOG4CPLUS_TEXT ("Socket"));
+    if (! socket_path.empty ())
+        socketPath = LOG4CPLUS_TSTRING_TO_STRING (socket_path);
+
+    open ();
+}
+
+
+JournaldAppender::~JournaldAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+JournaldAppender::open ()
+{
+    if (socketPath.size () >= sizeof (sockaddr_un::sun_path))
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("JournaldAppender: socket path is too long: ")
+            + LOG4CPLUS_STRING_TO_TSTRING (socketPath));
+        return;
+    }
+
+    int type = SOCK_DGRAM;
+#if defined (SOCK_CLOEXEC)
+    type |= SOCK_CLOEXEC;
+#endif
+    fd = ::socket (AF_UNIX, type, 0);
+    if (fd == -1)
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("JournaldAppender: socket() failed: ")
+            + helpers::convertIntegerToString (errno));
+}
+
+
+void
+JournaldAppender::close ()
+{
+    if (fd != -1)
+    {
+        ::close (fd);
+        fd = -1;
+    }
+
+    closed = true;
+}
+
+
+void
+JournaldAppender::append (spi::InternalLoggingEvent const & event)
+{
+    if (fd == -1)
+        return;
+
+    datagram.clear ();
+    append_field (datagram, "MESSAGE", event.getMessage ());
+
+    char priority[2] = {
+        static_cast<char> ('0' + journal_priority (event.getLogLevel ())),
+        0 };
+    append_field (datagram, "PRIORITY", std::string_view (priority, 1));
+
+    append_field (datagram, "CODE_FILE", event.getFile ());
+    if (event.getLine () > 0)
+        append_field (datagram, "CODE_LINE",
+            std::string_view (helpers::convertIntegerToNarrowString (
+                    event.getLine ())));
+    append_field (datagram, "CODE_FUNC", event.getFunction ());
+    append_field (datagram, "SYSLOG_IDENTIFIER", std::string_view (ident));
+    append_field (datagram, "LOG4CPLUS_LOGGER", event.getLoggerName ());
+    append_field (datagram, "LOG4CPLUS_THREAD", event.getThread ());
+    append_field (datagram, "LOG4CPLUS_NDC", event.getNDC ());
+
+    for (auto const & kv : event.getMDCCopy ())
+        append_field (datagram, journal_field_name (kv.first), kv.second);
+
+    spi::KeyValues const & kvs = event.getKeyValues ();
+    if (! kvs.empty ())
+    {
+        tstring value;
+        for (std::size_t i = 0; i != kvs.size (); ++i)
+        {
+            spi::KeyValue const kv = kvs[i];
+            value.clear ();
+            spi::KeyValues::appendValue (value, kv);
+            append_field (datagram,
+                journal_field_name (tstring (kv.key)), value);
+        }
+    }
+
+    struct sockaddr_un addr = sockaddr_un ();
+    addr.sun_family = AF_UNIX;
+    std::memcpy (addr.sun_path, socketPath.c_str (), socketPath.size () + 1);
+
+    struct iovec iov;
+    iov.iov_base = &datagram[0];
+    iov.iov_len = datagram.size ();
+
+    struct msghdr msg = msghdr ();
+    msg.msg_name = &addr;
+    msg.msg_namelen = sizeof (addr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    if (::sendmsg (fd, &msg, MSG_NOSIGNAL) != -1)
+        return;
+
+    int const err = errno;
+    if ((err == EMSGSIZE || err == ENOBUFS) && sendThroughMemfd ())
+        return;
+
+    helpers::getLogLog ().error (
+        LOG4CPLUS_TEXT ("JournaldAppender: sendmsg() failed: ")
+        + helpers::convertIntegerToString (err));
+}
+
+
+bool
+JournaldAppender::sendThroughMemfd ()
+{
+#if defined (MFD_ALLOW_SEALING) && defined (F_ADD_SEALS)
+    int const mfd = ::memfd_create ("log4cplus-journal",
+        MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (mfd == -1)
+        return false;
+
+    bool ok = true;
+    for (std::size_t written = 0; ok && written != datagram.size (); )
+    {
+        ssize_t const ret = ::write (mfd, datagram.data () + written,
+            datagram.size () - written);
+        if (ret > 0)
+            written += static_cast<std::size_t> (ret);
+        else if (ret == -1 && errno == EINTR)
+            continue;
+        else
+            ok = false;
+    }
+
+    // Journal accepts only sealed memfds.
+    ok = ok && ::fcntl (mfd, F_ADD_SEALS,
+        F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != -1;
+
+    if (ok)
+    {
+        struct sockaddr_un addr = sockaddr_un ();
+        addr.sun_family = AF_UNIX;
+        std::memcpy (addr.sun_path, socketPath.c_str (),
+            socketPath.size () + 1);
+
+        union
+        {
+            struct cmsghdr header;
+            char buf[CMSG_SPACE (sizeof (int))];
+        } control;
+        std::memset (&control, 0, sizeof (control));
+
+        struct msghdr msg = msghdr ();
+        msg.msg_name = &addr;
+        msg.msg_namelen = sizeof (addr);
+        msg.msg_control = &control;
+        msg.msg_controllen = sizeof (control);
+
+        struct cmsghdr * cmsg = CMSG_FIRSTHDR (&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+        std::memcpy (CMSG_DATA (cmsg), &mfd, sizeof (int));
+
+        ok = ::sendmsg (fd, &msg, MSG_NOSIGNAL) != -1;
+    }
+
+    ::close (mfd);
+    return ok;
+
+#else
+    return false;
+
+#endif
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("JournaldAppender", "[appender]")
+{
+    char const path[] = "log4cplus-journald-test.sock";
+    std::remove (path);
+
+    int const server = ::socket (AF_UNIX, SOCK_DGRAM, 0);
+    CATCH_REQUIRE (server >= 0);
+    struct sockaddr_un addr = sockaddr_un ();
+    addr.sun_family = AF_UNIX;
+    std::strcpy (addr.sun_path, path);
+    CATCH_REQUIRE (::bind (server, reinterpret_cast<struct sockaddr *>(&addr),
+            sizeof (addr)) == 0);
+
+    // Returns the next datagram, or contents of memfd passed with it.
+    auto const receive = [&]
+    {
+        std::vector<char> buf (64 * 1024);
+        union
+        {
+            struct cmsghdr header;
+            char buf[CMSG_SPACE (sizeof (int))];
+        } control;
+        struct iovec iov;
+        iov.iov_base = buf.data ();
+        iov.iov_len = buf.size ();
+        struct msghdr msg = msghdr ();
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = &control;
+        msg.msg_controllen = sizeof (control);
+
+        long const len = ::recvmsg (server, &msg, MSG_DONTWAIT);
+        if (len < 0)
+            return std::string ();
+
+        struct cmsghdr * cmsg = CMSG_FIRSTHDR (&msg);
+        if (! cmsg || cmsg->cmsg_type != SCM_RIGHTS)
+            return std::string (buf.data (), static_cast<std::size_t> (len));
+
+        int mfd;
+        std::memcpy (&mfd, CMSG_DATA (cmsg), sizeof (int));
+        std::string data;
+        ::lseek (mfd, 0, SEEK_SET);
+        long n;
+        while ((n = ::read (mfd, buf.data (), buf.size ())) > 0)
+            data.append (buf.data (), static_cast<std::size_t> (n));
+        ::close (mfd);
+        return data;
+    };
+
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("Ident"), LOG4CPLUS_TEXT ("test"));
+    props.setProperty (LOG4CPLUS_TEXT ("Socket"),
+        LOG4CPLUS_C_STR_TO_TSTRING (path));
+    JournaldAppender appender (props);
+
+    CATCH_SECTION ("fields")
+    {
+        MDC & mdc = getMDC ();
+        mdc.put (LOG4CPLUS_TEXT ("request-id"), LOG4CPLUS_TEXT ("42"));
+        mdc.put (LOG4CPLUS_TEXT ("1st"), LOG4CPLUS_TEXT ("x"));
+        appender.doAppend (spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("app"),
+                WARN_LOG_LEVEL, LOG4CPLUS_TEXT ("two\nlines"), "file.cxx", 7,
+                "func"));
+        mdc.clear ();
+
+        std::string const received = receive ();
+        std::string const message ("MESSAGE\n\x09\0\0\0\0\0\0\0two\nlines\n",
+            26);
+        CATCH_REQUIRE (received.compare (0, message.size (), message) == 0);
+        CATCH_REQUIRE (received.find ("\nPRIORITY=4\n") != std::string::npos);
+        CATCH_REQUIRE (received.find ("\nCODE_FILE=file.cxx\n")
+            != std::string::npos);
+        CATCH_REQUIRE (received.find ("\nCODE_LINE=7\n") != std::string::npos);
+        CATCH_REQUIRE (received.find ("\nCODE_FUNC=func\n")
+            != std::string::npos);
+        CATCH_REQUIRE (received.find ("\nSYSLOG_IDENTIFIER=test\n")
+            != std::string::npos);
+        CATCH_REQUIRE (received.find ("\nLOG4CPLUS_LOGGER=app\n")
+            != std::string::npos);
+        CATCH_REQUIRE (received.find ("\nREQUEST_ID=42\n")
+            != std::string::npos);
+        CATCH_REQUIRE (received.find ("\nX_1ST=x\n") != std::string::npos);
+        CATCH_REQUIRE (received.find ("LOG4CPLUS_NDC") == std::string::npos);
+    }
+
+    CATCH_SECTION ("large event")
+    {
+        tstring const large (4 * 1024 * 1024, LOG4CPLUS_TEXT ('x'));
+        appender.doAppend (spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("app"),
+                INFO_LOG_LEVEL, large, nullptr, 0));
+
+        std::string const received = receive ();
+        CATCH_REQUIRE (received.compare (0, 8 + large.size (),
+                "MESSAGE=" + LOG4CPLUS_TSTRING_TO_STRING (large)) == 0);
+    }
+
+    appender.close ();
+    ::close (server);
+    std::remove (path);
+}
+#endif
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_HAVE_SYS_UN_H && ! _WIN32
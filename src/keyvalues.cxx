@@ -0,0 +1,282 @@
+// Module:  Log4cplus
+// File:    keyvalues.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/spi/keyvalues.h>
+#include <charconv>
+#include <utility>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <cmath>
+#endif
+
+
+namespace log4cplus::spi {
+
+
+namespace
+{
+
+template <typename T>
+void
+append_number (tstring & output, T value)
+{
+    char buf[32];
+    std::to_chars_result const res
+        = std::to_chars (buf, buf + sizeof (buf), value);
+    for (char const * it = buf; it != res.ptr; ++it)
+        output += static_cast<tchar> (*it);
+}
+
+} // namespace
+
+
+KeyValues::KeyValues () = default;
+
+
+KeyValues::KeyValues (KeyValues const &) = default;
+
+
+KeyValues::KeyValues (KeyValues &&) noexcept = default;
+
+
+KeyValues::~KeyValues () = default;
+
+
+KeyValues &
+KeyValues::operator = (KeyValues const &) = default;
+
+
+KeyValues &
+KeyValues::operator = (KeyValues &&) noexcept = default;
+
+
+void
+KeyValues::clear ()
+{
+    entries.clear ();
+    chars.clear ();
+}
+
+
+KeyValue
+KeyValues::operator [] (std::size_t i) const
+{
+    Entry const & e = entries[i];
+    KeyValue kv;
+    kv.key = tstring_view (chars).substr (e.keyPos, e.keyLen);
+    kv.type = e.type;
+    switch (e.type)
+    {
+    case KV_BOOL:
+        kv.b = e.b;
+        break;
+
+    case KV_INT:
+        kv.i = e.i;
+        break;
+
+    case KV_UINT:
+        kv.u = e.u;
+        break;
+
+    case KV_DOUBLE:
+        kv.d = e.d;
+        break;
+
+    case KV_STRING:
+        kv.str = tstring_view (chars).substr (e.strPos, e.strLen);
+        break;
+    }
+    return kv;
+}
+
+
+bool
+KeyValues::find (tstring_view const & key, KeyValue & kv) const
+{
+    tstring_view const all (chars);
+    for (std::size_t i = 0; i != entries.size (); ++i)
+        if (all.substr (entries[i].keyPos, entries[i].keyLen) == key)
+        {
+            kv = (*this)[i];
+            return true;
+        }
+
+    return false;
+}
+
+
+KeyValues::Entry &
+KeyValues::addEntry (tstring_view const & key, KeyValueType type)
+{
+    Entry & e = entries.emplace_back ();
+    e.keyPos = chars.size ();
+    e.keyLen = key.size ();
+    e.strPos = 0;
+    e.strLen = 0;
+    e.type = type;
+    e.u = 0;
+    chars.append (key);
+    return e;
+}
+
+
+void
+KeyValues::addBool (tstring_view const & key, bool value)
+{
+    addEntry (key, KV_BOOL).b = value;
+}
+
+
+void
+KeyValues::addInt (tstring_view const & key, std::int64_t value)
+{
+    addEntry (key, KV_INT).i = value;
+}
+
+
+void
+KeyValues::addUInt (tstring_view const & key, std::uint64_t value)
+{
+    addEntry (key, KV_UINT).u = value;
+}
+
+
+void
+KeyValues::addDouble (tstring_view const & key, double value)
+{
+    addEntry (key, KV_DOUBLE).d = value;
+}
+
+
+void
+KeyValues::addString (tstring_view const & key, tstring_view const & value)
+{
+    Entry & e = addEntry (key, KV_STRING);
+    e.strPos = chars.size ();
+    e.strLen = value.size ();
+    chars.append (value);
+}
+
+
+void
+KeyValues::swap (KeyValues & other) noexcept
+{
+    entries.swap (other.entries);
+    chars.swap (other.chars);
+}
+
+
+void
+KeyValues::appendValue (tstring & output, KeyValue const & kv)
+{
+    switch (kv.type)
+    {
+    case KV_BOOL:
+        output += kv.b ? LOG4CPLUS_TEXT ("true") : LOG4CPLUS_TEXT ("false");
+        break;
+
+    case KV_INT:
+        append_number (output, kv.i);
+        break;
+
+    case KV_UINT:
+        append_number (output, kv.u);
+        break;
+
+    case KV_DOUBLE:
+        append_number (output, kv.d);
+        break;
+
+    case KV_STRING:
+        output += kv.str;
+        break;
+    }
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("KeyValues", "[keyvalues]")
+{
+    enum Color { RED, GREEN };
+
+    KeyValues kvs;
+    tstring const str (LOG4CPLUS_TEXT ("string"));
+    kvs.add (LOG4CPLUS_TEXT ("b"), true);
+    kvs.add (LOG4CPLUS_TEXT ("i"), -42);
+    kvs.add (LOG4CPLUS_TEXT ("u"), 42u);
+    kvs.add (LOG4CPLUS_TEXT ("d"), 0.1);
+    kvs.add (LOG4CPLUS_TEXT ("s"), LOG4CPLUS_TEXT ("literal"));
+    kvs.add (LOG4CPLUS_TEXT ("t"), str);
+    kvs.add (LOG4CPLUS_TEXT ("c"), LOG4CPLUS_TEXT ('x'));
+    kvs.add (LOG4CPLUS_TEXT ("e"), GREEN);
+
+    CATCH_REQUIRE (kvs.size () == 8);
+    CATCH_REQUIRE (kvs[0].type == KV_BOOL);
+    CATCH_REQUIRE (kvs[1].type == KV_INT);
+    CATCH_REQUIRE (kvs[1].i == -42);
+    CATCH_REQUIRE (kvs[2].type == KV_UINT);
+    CATCH_REQUIRE (kvs[3].type == KV_DOUBLE);
+    CATCH_REQUIRE (kvs[4].type == KV_STRING);
+    CATCH_REQUIRE (kvs[6].str == LOG4CPLUS_TEXT ("x"));
+    CATCH_REQUIRE (kvs[7].i == GREEN);
+
+    tstring text;
+    for (std::size_t i = 0; i != kvs.size (); ++i)
+    {
+        KeyValue const kv = kvs[i];
+        text += kv.key;
+        text += LOG4CPLUS_TEXT ('=');
+        KeyValues::appendValue (text, kv);
+        text += LOG4CPLUS_TEXT (' ');
+    }
+    CATCH_REQUIRE (text == LOG4CPLUS_TEXT (
+            "b=true i=-42 u=42 d=0.1 s=literal t=string c=x e=1 "));
+
+    KeyValue kv;
+    CATCH_REQUIRE (kvs.find (LOG4CPLUS_TEXT ("t"), kv));
+    CATCH_REQUIRE (kv.str == str);
+    CATCH_REQUIRE (! kvs.find (LOG4CPLUS_TEXT ("missing"), kv));
+
+    // Copies own their strings.
+    KeyValues copy (kvs);
+    kvs.clear ();
+    CATCH_REQUIRE (kvs.empty ());
+    CATCH_REQUIRE (copy.find (LOG4CPLUS_TEXT ("s"), kv));
+    CATCH_REQUIRE (kv.str == LOG4CPLUS_TEXT ("literal"));
+
+    text.clear ();
+    kvs.addDouble (LOG4CPLUS_TEXT ("n"), std::nan (""));
+    KeyValues::appendValue (text, kvs[0]);
+    CATCH_REQUIRE (text == LOG4CPLUS_TEXT ("nan"));
+}
+
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+} // namespace log4cplus::spi
@@ -26,11 +26,37 @@
 #include <log4cplus/internal/internal.h>
 #include <ostream>
 #include <iomanip>
+#include <map>
+#include <mutex>
 
 
 namespace log4cplus
 {
 
+namespace internal
+{
+
+std::atomic<bool> layout_cache_enabled {false};
+
+
+unsigned
+get_layout_cache_key (tstring const & config)
+{
+    static std::mutex mutex;
+    static std::map<tstring, unsigned> keys;
+
+    std::lock_guard<std::mutex> guard (mutex);
+    auto const ins = keys.emplace (config,
+        static_cast<unsigned> (keys.size () + 1));
+    if (! ins.second)
+        layout_cache_enabled.store (true, std::memory_order_relaxed);
+
+    return ins.first->second;
+}
+
+} // namespace internal
+
+
 void
 formatRelativeTimestamp (log4cplus::tostream & output,
     log4cplus::spi::InternalLoggingEvent const & event)
@@ -60,6 +86,35 @@ Layout::Layout (const log4cplus::helpers::Properties&)
 Layout::~Layout() = default;
 
 
+void
+Layout::formatAndAppend (log4cplus::tstring& output,
+    const log4cplus::spi::InternalLoggingEvent& event)
+{
+    helpers::buffer_ostream & oss = internal::get_ptd ()->layout_oss;
+    detail::clear_tostringstream (oss);
+    formatAndAppend (oss, event);
+    output += oss.view ();
+}
+
+
+void
+Layout::formatBatch (
+    std::span<log4cplus::spi::InternalLoggingEvent const> events,
+    log4cplus::tstring& output)
+{
+    for (auto const & event : events)
+        formatAndAppend (output, event);
+}
+
+
+unsigned
+Layout::getRequiredEventFields () const
+{
+    return spi::EVENT_FIELDS_ALL;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // log4cplus::SimpleLayout public methods
 ///////////////////////////////////////////////////////////////////////////////
@@ -86,6 +141,13 @@ SimpleLayout::formatAndAppend(log4cplus::tostream& output,
 }
 
 
+unsigned
+SimpleLayout::getRequiredEventFields () const
+{
+    return spi::EVENT_FIELDS_NONE;
+}
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // log4cplus::TTCCLayout ctors and dtor
@@ -156,6 +218,13 @@ TTCCLayout::formatAndAppend(log4cplus::tostream& output,
 }
 
 
+unsigned
+TTCCLayout::getRequiredEventFields () const
+{
+    return spi::EVENT_FIELD_THREAD | spi::EVENT_FIELD_NDC;
+}
+
+
 bool
 TTCCLayout::getThreadPrinting() const
 {
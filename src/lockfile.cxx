@@ -58,6 +58,7 @@
 #include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/internal/env.h>
+#include <log4cplus/thread/lockprofile.h>
 
 #if defined (_WIN32)
 #  define LOG4CPLUS_USE_WIN32_LOCKFILEEX
@@ -178,9 +179,16 @@ struct LockFile::Impl
     int fd;
 
 #endif
+
+    //! Start of hold for lock profile, see lock_file_site.
+    std::uint64_t hold_start = 0;
 };
 
 
+//! Shared by all lock files.
+static thread::LockSite lock_file_site ("LockFile");
+
+
 //
 //
 //
@@ -273,6 +281,7 @@ LockFile::lock () const
     int ret = 0;
     (void) loglog;
     (void) ret;
+    std::uint64_t const wait_start = lock_file_site.wait_start ();
 
 #if defined (LOG4CPLUS_USE_WIN32_LOCKFILEEX)
     HANDLE fh = get_os_HANDLE (data->fd);
@@ -327,6 +336,102 @@ LockFile::lock () const
     while (ret == -1);
 
 #endif
+
+    data->hold_start = wait_start != 0
+        ? lock_file_site.acquired (wait_start)
+        : 0;
+}
+
+
+bool
+LockFile::try_lock () const
+{
+    int ret = 0;
+    (void) ret;
+
+#if defined (LOG4CPLUS_USE_WIN32_LOCKFILEEX)
+    HANDLE fh = get_os_HANDLE (data->fd);
+
+    OVERLAPPED overlapped;
+    std::memset (&overlapped, 0, sizeof (overlapped));
+    overlapped.hEvent = 0;
+
+    ret = LockFileEx(fh, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY,
+        0, (std::numeric_limits<DWORD>::max) (),
+        (std::numeric_limits<DWORD>::max) (), &overlapped);
+    if (! ret)
+    {
+        DWORD const eno = GetLastError ();
+        if (eno == ERROR_LOCK_VIOLATION)
+            return false;
+
+        getLogLog ().error (tstring (LOG4CPLUS_TEXT ("LockFileEx() failed: "))
+            + convertIntegerToString (eno), true);
+    }
+
+#elif defined (LOG4CPLUS_USE_O_EXLOCK)
+    if (create_dirs)
+        internal::make_dirs (lock_file_name);
+
+    data->fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (lock_file_name).c_str (),
+        OPEN_FLAGS | O_EXLOCK | O_NONBLOCK, OPEN_MODE);
+    if (data->fd == -1)
+    {
+        if (errno == EWOULDBLOCK || errno == EAGAIN)
+            return false;
+
+        getLogLog ().error (
+            tstring (LOG4CPLUS_TEXT ("could not open or create file "))
+            + lock_file_name, true);
+    }
+
+#elif defined (LOG4CPLUS_USE_SETLKW)
+    do
+    {
+        struct flock fl;
+        fl.l_type = F_WRLCK;
+        fl.l_whence = SEEK_SET;
+        fl.l_start = 0;
+        fl.l_len = 0;
+        ret = fcntl (data->fd, F_SETLK, &fl);
+        if (ret == -1 && (errno == EACCES || errno == EAGAIN))
+            return false;
+        else if (ret == -1 && errno != EINTR)
+            getLogLog ().error (tstring (LOG4CPLUS_TEXT("fcntl(F_SETLK) failed: "))
+                + convertIntegerToString (errno), true);
+    }
+    while (ret == -1);
+
+#elif defined (LOG4CPLUS_USE_LOCKF)
+    do
+    {
+        ret = lockf (data->fd, F_TLOCK, 0);
+        if (ret == -1 && (errno == EACCES || errno == EAGAIN))
+            return false;
+        else if (ret == -1 && errno != EINTR)
+            getLogLog ().error (tstring (LOG4CPLUS_TEXT("lockf() failed: "))
+                + convertIntegerToString (errno), true);
+    }
+    while (ret == -1);
+
+#elif defined (LOG4CPLUS_USE_FLOCK)
+    do
+    {
+        ret = flock (data->fd, LOCK_EX | LOCK_NB);
+        if (ret == -1 && errno == EWOULDBLOCK)
+            return false;
+        else if (ret == -1 && errno != EINTR)
+            getLogLog ().error (tstring (LOG4CPLUS_TEXT("flock() failed: "))
+                + convertIntegerToString (errno), true);
+    }
+    while (ret == -1);
+
+#endif
+
+    data->hold_start = thread::LockSite::is_enabled ()
+        ? lock_file_site.acquired (0)
+        : 0;
+    return true;
 }
 
 
@@ -334,6 +439,9 @@ void LockFile::unlock () const
 {
     int ret = 0;
 
+    lock_file_site.release (data->hold_start);
+    data->hold_start = 0;
+
 #if defined (LOG4CPLUS_USE_WIN32_LOCKFILEEX)
     HANDLE fh = get_os_HANDLE (data->fd);
 
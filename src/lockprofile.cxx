@@ -0,0 +1,310 @@
+// Module:  Log4cplus
+// File:    lockprofile.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/thread/lockprofile.h>
+#include <log4cplus/thread/syncprims.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <algorithm>
+#include <iomanip>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <thread>
+#include <catch.hpp>
+#endif
+
+
+namespace log4cplus { namespace thread {
+
+
+namespace
+{
+
+//! Head of list of registered lock sites.
+std::atomic<LockSite *> lock_sites {nullptr};
+
+
+void
+update_max (std::atomic<std::uint64_t> & max, std::uint64_t value)
+{
+    std::uint64_t current = max.load (std::memory_order_relaxed);
+    while (value > current
+        && ! max.compare_exchange_weak (current, value,
+            std::memory_order_relaxed))
+    { }
+}
+
+} // namespace
+
+
+std::atomic<bool> LockSite::enabled {false};
+
+
+std::uint64_t
+LockSite::now ()
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds> (
+            std::chrono::steady_clock::now ().time_since_epoch ()).count ());
+}
+
+
+std::uint64_t
+LockSite::acquired (std::uint64_t start)
+{
+    if (! registered.load (std::memory_order_acquire))
+        register_site ();
+
+    std::uint64_t const hold_start = now ();
+    acquisitions.fetch_add (1, std::memory_order_relaxed);
+    if (start != 0)
+    {
+        std::uint64_t const wait = hold_start - start;
+        contended.fetch_add (1, std::memory_order_relaxed);
+        wait_ns.fetch_add (wait, std::memory_order_relaxed);
+        update_max (max_wait_ns, wait);
+    }
+
+    return hold_start;
+}
+
+
+void
+LockSite::released (std::uint64_t hold_start)
+{
+    std::uint64_t const hold = now () - hold_start;
+    hold_ns.fetch_add (hold, std::memory_order_relaxed);
+    update_max (max_hold_ns, hold);
+}
+
+
+void
+LockSite::register_site ()
+{
+    if (registered.exchange (true, std::memory_order_acq_rel))
+        return;
+
+    LockSite * head = lock_sites.load (std::memory_order_relaxed);
+    do
+        next = head;
+    while (! lock_sites.compare_exchange_weak (head, this,
+            std::memory_order_release, std::memory_order_relaxed));
+}
+
+
+LockSiteProfile
+LockSite::get_profile () const
+{
+    LockSiteProfile profile;
+    profile.name = name;
+    profile.acquisitions = acquisitions.load (std::memory_order_relaxed);
+    profile.contended = contended.load (std::memory_order_relaxed);
+    profile.waitTime = std::chrono::nanoseconds (
+        wait_ns.load (std::memory_order_relaxed));
+    profile.maxWaitTime = std::chrono::nanoseconds (
+        max_wait_ns.load (std::memory_order_relaxed));
+    profile.holdTime = std::chrono::nanoseconds (
+        hold_ns.load (std::memory_order_relaxed));
+    profile.maxHoldTime = std::chrono::nanoseconds (
+        max_hold_ns.load (std::memory_order_relaxed));
+    return profile;
+}
+
+
+void
+LockSite::reset ()
+{
+    acquisitions.store (0, std::memory_order_relaxed);
+    contended.store (0, std::memory_order_relaxed);
+    wait_ns.store (0, std::memory_order_relaxed);
+    max_wait_ns.store (0, std::memory_order_relaxed);
+    hold_ns.store (0, std::memory_order_relaxed);
+    max_hold_ns.store (0, std::memory_order_relaxed);
+}
+
+
+void
+LockSite::set_enabled (bool enable)
+{
+    enabled.store (enable, std::memory_order_relaxed);
+}
+
+
+std::vector<LockSite *>
+LockSite::get_sites ()
+{
+    std::vector<LockSite *> sites;
+    for (LockSite * site = lock_sites.load (std::memory_order_acquire); site;
+         site = site->next)
+        sites.push_back (site);
+    return sites;
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+void
+Mutex::profiled_lock () const
+{
+    std::uint64_t const start = site->acquire (mtx);
+    if (depth++ == 0)
+        hold_start = start;
+}
+
+
+void
+Mutex::profiled_unlock () const
+{
+    if (--depth == 0)
+        site->release (hold_start);
+    mtx.unlock ();
+}
+
+#endif
+
+
+void
+setLockProfilingEnabled (bool enable)
+{
+    LockSite::set_enabled (enable);
+}
+
+
+std::vector<LockSiteProfile>
+getLockProfile ()
+{
+    std::vector<LockSiteProfile> result;
+    for (LockSite const * site : LockSite::get_sites ())
+        result.push_back (site->get_profile ());
+
+    std::stable_sort (result.begin (), result.end (),
+        [] (LockSiteProfile const & a, LockSiteProfile const & b)
+        {
+            return a.waitTime > b.waitTime;
+        });
+    return result;
+}
+
+
+void
+dumpLockProfile (tostream & os)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    os << std::setw (14) << LOG4CPLUS_TEXT ("acquisitions")
+        << std::setw (12) << LOG4CPLUS_TEXT ("contended")
+        << std::setw (14) << LOG4CPLUS_TEXT ("wait [us]")
+        << std::setw (14) << LOG4CPLUS_TEXT ("max wait [us]")
+        << std::setw (14) << LOG4CPLUS_TEXT ("hold [us]")
+        << std::setw (14) << LOG4CPLUS_TEXT ("max hold [us]")
+        << LOG4CPLUS_TEXT ("  lock\n");
+
+    for (LockSiteProfile const & p : getLockProfile ())
+        os << std::setw (14) << p.acquisitions
+            << std::setw (12) << p.contended
+            << std::setw (14)
+            << duration_cast<microseconds> (p.waitTime).count ()
+            << std::setw (14)
+            << duration_cast<microseconds> (p.maxWaitTime).count ()
+            << std::setw (14)
+            << duration_cast<microseconds> (p.holdTime).count ()
+            << std::setw (14)
+            << duration_cast<microseconds> (p.maxHoldTime).count ()
+            << LOG4CPLUS_TEXT ("  ") << LOG4CPLUS_C_STR_TO_TSTRING (p.name)
+            << LOG4CPLUS_TEXT ('\n');
+}
+
+
+void
+resetLockProfile ()
+{
+    for (LockSite * site : LockSite::get_sites ())
+        site->reset ();
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) && ! defined (LOG4CPLUS_SINGLE_THREADED)
+CATCH_TEST_CASE ("Lock profile", "[lockprofile]")
+{
+    static LockSite site ("test lock");
+    Mutex mutex (site);
+
+    // Nothing is recorded while profiling is disabled.
+    {
+        MutexGuard guard (mutex);
+    }
+    CATCH_REQUIRE (site.get_profile ().acquisitions == 0);
+
+    setLockProfilingEnabled (true);
+
+    CATCH_SECTION ("wait and hold time")
+    {
+        {
+            MutexGuard guard (mutex);
+            // Recursive locking is one acquisition of the outer lock.
+            MutexGuard inner (mutex);
+            std::this_thread::sleep_for (std::chrono::milliseconds (2));
+        }
+
+        std::thread holder;
+        {
+            MutexGuard guard (mutex);
+            holder = std::thread ([&] { MutexGuard other (mutex); });
+            std::this_thread::sleep_for (std::chrono::milliseconds (5));
+        }
+        holder.join ();
+
+        LockSiteProfile const p = site.get_profile ();
+        CATCH_REQUIRE (p.acquisitions == 4);
+        CATCH_REQUIRE (p.contended == 1);
+        CATCH_REQUIRE (p.waitTime >= std::chrono::milliseconds (1));
+        CATCH_REQUIRE (p.maxHoldTime >= std::chrono::milliseconds (2));
+        CATCH_REQUIRE (p.holdTime >= p.maxHoldTime);
+
+        std::vector<LockSiteProfile> const profile = getLockProfile ();
+        CATCH_REQUIRE (std::find_if (profile.begin (), profile.end (),
+                [] (LockSiteProfile const & lsp)
+                {
+                    return lsp.name == site.get_name ();
+                }) != profile.end ());
+
+        tostringstream report;
+        dumpLockProfile (report);
+        CATCH_REQUIRE (report.str ().find (LOG4CPLUS_TEXT ("test lock"))
+            != tstring::npos);
+    }
+
+    setLockProfilingEnabled (false);
+    site.reset ();
+    CATCH_REQUIRE (site.get_profile ().acquisitions == 0);
+}
+
+#endif
+
+
+} } // namespace log4cplus { namespace thread {
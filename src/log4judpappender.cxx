@@ -23,10 +23,13 @@
 #include <log4cplus/streams.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/helpers/timehelper.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
-#include <iomanip>
+#include <chrono>
+#include <cstdint>
 #include <cstring>
 #if defined (UNICODE)
 #include <cwctype>
@@ -35,6 +38,10 @@
 #endif
 #include <memory>
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#endif
+
 
 namespace log4cplus
 {
@@ -54,75 +61,96 @@ is_control (tchar ch)
 }
 
 
-//! Outputs str with reserved XML characters escaped.
+//! Marks ASCII characters that have to be escaped in XML text and
+//! attribute values: the reserved ones and controls.
+struct xml_escape_table
+{
+    xml_escape_table ()
+    {
+        for (unsigned ch = 0; ch != 128; ++ch)
+            escape[ch] = is_control (static_cast<tchar>(ch));
+
+        for (char const ch : {'<', '>', '&', '\'', '"'})
+            escape[static_cast<unsigned char>(ch)] = true;
+    }
+
+    bool escape[128];
+};
+
+
+static inline bool
+needs_xml_escape (tchar ch)
+{
+    static xml_escape_table const table;
+    auto const uch = std::char_traits<tchar>::to_int_type (ch);
+    return uch < 128 ? table.escape[uch] : is_control (ch);
+}
+
+
+//! Appends str to out with reserved XML characters escaped. Runs of
+//! characters that need no escaping are appended at once.
 static
 void
-output_xml_escaped (tostream & os, tstring const & str)
+append_xml_escaped (tstring & out, tstring const & str)
 {
-    for (tchar ch : str)
+    tchar const * it = str.data ();
+    tchar const * const end = it + str.size ();
+    while (it != end)
     {
-        switch (ch)
+        tchar const * const run = it;
+        while (it != end && ! needs_xml_escape (*it))
+            ++it;
+
+        out.append (run, it);
+        if (it == end)
+            break;
+
+        switch (*it)
         {
         case LOG4CPLUS_TEXT ('<'):
-            os << LOG4CPLUS_TEXT ("&lt;");
+            out += LOG4CPLUS_TEXT ("&lt;");
             break;
 
         case LOG4CPLUS_TEXT ('>'):
-            os << LOG4CPLUS_TEXT ("&gt;");
+            out += LOG4CPLUS_TEXT ("&gt;");
             break;
 
         case LOG4CPLUS_TEXT ('&'):
-            os << LOG4CPLUS_TEXT ("&amp;");
+            out += LOG4CPLUS_TEXT ("&amp;");
             break;
 
         case LOG4CPLUS_TEXT ('\''):
-            os << LOG4CPLUS_TEXT ("&apos;");
+            out += LOG4CPLUS_TEXT ("&apos;");
             break;
 
         case LOG4CPLUS_TEXT ('"'):
-            os << LOG4CPLUS_TEXT ("&quot;");
+            out += LOG4CPLUS_TEXT ("&quot;");
             break;
 
         default:
-            if (is_control (ch))
+        {
+            // Control character as at least two digit hex reference.
+            static tchar const digits[] = LOG4CPLUS_TEXT ("0123456789abcdef");
+            auto value = static_cast<std::uint32_t>(
+                std::char_traits<tchar>::to_int_type (*it));
+            tchar hex[8];
+            std::size_t len = 0;
+            do
             {
-                tchar const prev_fill = os.fill ();
-                std::ios_base::fmtflags const prev_flags = os.flags ();
-                os.flags (std::ios_base::hex | std::ios_base::right);
-                os.fill (LOG4CPLUS_TEXT ('0'));
-
-                os << std::setw (0) << LOG4CPLUS_TEXT ("&#x")
-                    << std::setw (2) << std::char_traits<tchar>::to_int_type (ch)
-                    << std::setw (0) << LOG4CPLUS_TEXT (";");
-
-                os.fill (prev_fill);
-                os.flags (prev_flags);
+                hex[len++] = digits[value & 0xf];
+                value >>= 4;
             }
-            else
-                os.put (ch);
-        }
-    }
-}
-
-
-//! Helper manipulator like class for escaped XML output.
-struct outputXMLEscaped
-{
-    explicit outputXMLEscaped (tstring const & s)
-        : str (s)
-    { }
-
-    tstring const & str;
-};
+            while (value != 0 || len < 2);
 
+            out += LOG4CPLUS_TEXT ("&#x");
+            while (len != 0)
+                out += hex[--len];
+            out += LOG4CPLUS_TEXT (';');
+        }
+        }
 
-//! Overload stream insertion for outputXMLEscaped.
-static
-tostream &
-operator << (tostream & os, outputXMLEscaped const & x)
-{
-    output_xml_escaped (os, x.str);
-    return os;
+        ++it;
+    }
 }
 
 
@@ -152,8 +180,24 @@ Log4jUdpAppender::Log4jUdpAppender(const helpers::Properties & properties)
         LOG4CPLUS_TEXT ("localhost") );
     properties.getInt (port, LOG4CPLUS_TEXT ("port"));
     properties.getBool (ipv6, LOG4CPLUS_TEXT ("IPv6"));
+    properties.getULong (batchSize, LOG4CPLUS_TEXT ("BatchSize"));
+    properties.getULong (batchInterval, LOG4CPLUS_TEXT ("BatchIntervalMs"));
 
     openSocket();
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (batchSize != 0 && batchInterval != 0)
+    {
+        internal::add_timer (this,
+            std::chrono::milliseconds (batchInterval),
+            [this]
+            {
+                thread::MutexGuard guard (access_mutex);
+                flushDatagram ();
+            });
+        batchTimerRegistered = true;
+    }
+#endif
 }
 
 
@@ -175,11 +219,30 @@ Log4jUdpAppender::close()
     helpers::getLogLog().debug(
         LOG4CPLUS_TEXT("Entering Log4jUdpAppender::close()..."));
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // This has to be done before locking access_mutex; the timer thread
+    // locks it while holding its own mutex.
+    if (batchTimerRegistered)
+    {
+        internal::remove_timer (this);
+        batchTimerRegistered = false;
+    }
+#endif
+
+    thread::MutexGuard guard (access_mutex);
+    flushDatagram();
     socket.close();
     closed = true;
 }
 
 
+unsigned
+Log4jUdpAppender::getRequiredEventFields() const
+{
+    return spi::EVENT_FIELDS_ALL;
+}
+
+
 
 //////////////////////////////////////////////////////////////////////////////
 // Log4jUdpAppender protected methods
@@ -193,6 +256,64 @@ Log4jUdpAppender::openSocket()
     }
 }
 
+
+void
+Log4jUdpAppender::formatXml(const spi::InternalLoggingEvent& event)
+{
+    tstring const & str = formatEvent (event);
+
+    eventXml.clear ();
+    eventXml += LOG4CPLUS_TEXT("<log4j:event logger=\"");
+    append_xml_escaped (eventXml, event.getLoggerName());
+    eventXml += LOG4CPLUS_TEXT("\" level=\"");
+    append_xml_escaped (eventXml,
+        getLogLevelManager().toString(event.getLogLevel()));
+
+    // Milliseconds since epoch, the same as "%s%q" formatted time.
+    helpers::Time const & timestamp = event.getTimestamp();
+    eventXml += LOG4CPLUS_TEXT("\" timestamp=\"");
+    eventXml += helpers::convertIntegerToString (
+        static_cast<long long>(helpers::to_time_t (timestamp)) * 1000
+        + helpers::microseconds_part (timestamp) / 1000);
+
+    eventXml += LOG4CPLUS_TEXT("\" thread=\"");
+    eventXml += event.getThread();
+    eventXml += LOG4CPLUS_TEXT("\">");
+
+    eventXml += LOG4CPLUS_TEXT("<log4j:message>");
+    append_xml_escaped (eventXml, str);
+    eventXml += LOG4CPLUS_TEXT("</log4j:message>");
+
+    eventXml += LOG4CPLUS_TEXT("<log4j:NDC>");
+    append_xml_escaped (eventXml, event.getNDC());
+    eventXml += LOG4CPLUS_TEXT("</log4j:NDC>");
+
+    eventXml += LOG4CPLUS_TEXT("<log4j:locationInfo class=\"\" file=\"");
+    append_xml_escaped (eventXml, event.getFile());
+    eventXml += LOG4CPLUS_TEXT("\" method=\"");
+    append_xml_escaped (eventXml, event.getFunction());
+    eventXml += LOG4CPLUS_TEXT("\" line=\"");
+    eventXml += helpers::convertIntegerToString (event.getLine());
+    eventXml += LOG4CPLUS_TEXT("\"/>");
+    eventXml += LOG4CPLUS_TEXT("</log4j:event>");
+}
+
+
+void
+Log4jUdpAppender::flushDatagram()
+{
+    if (datagram.empty ())
+        return;
+
+    if (! socket.write (datagram))
+        helpers::getLogLog().error(
+            LOG4CPLUS_TEXT(
+                "Log4jUdpAppender::append()- Cannot write to server"));
+
+    datagram.clear ();
+}
+
+
 void
 Log4jUdpAppender::append(const spi::InternalLoggingEvent& event)
 {
@@ -206,54 +327,63 @@ Log4jUdpAppender::append(const spi::InternalLoggingEvent& event)
         }
     }
 
-    tstring & str = formatEvent (event);
-
-    internal::appender_sratch_pad & appender_sp
-        = internal::get_appender_sp ();
-    tostringstream & buffer = appender_sp.oss;
-    detail::clear_tostringstream (buffer);
-
-    buffer << LOG4CPLUS_TEXT("<log4j:event logger=\"")
-           << outputXMLEscaped (event.getLoggerName())
-           << LOG4CPLUS_TEXT("\" level=\"")
-           // TODO: Some escaping of special characters is needed here.
-           << outputXMLEscaped (getLogLevelManager()
-               .toString(event.getLogLevel()))
-           << LOG4CPLUS_TEXT("\" timestamp=\"")
-           << helpers::getFormattedTime(LOG4CPLUS_TEXT("%s%q"),
-               event.getTimestamp())
-           << LOG4CPLUS_TEXT("\" thread=\"") << event.getThread()
-           << LOG4CPLUS_TEXT("\">")
-
-           << LOG4CPLUS_TEXT("<log4j:message>")
-           // TODO: Some escaping of special characters is needed here.
-           << outputXMLEscaped (str)
-           << LOG4CPLUS_TEXT("</log4j:message>")
-
-           << LOG4CPLUS_TEXT("<log4j:NDC>")
-           // TODO: Some escaping of special characters is needed here.
-           << outputXMLEscaped (event.getNDC())
-           << LOG4CPLUS_TEXT("</log4j:NDC>")
-
-           << LOG4CPLUS_TEXT("<log4j:locationInfo class=\"\" file=\"")
-           // TODO: Some escaping of special characters is needed here.
-           << outputXMLEscaped (event.getFile())
-           << LOG4CPLUS_TEXT("\" method=\"")
-           << outputXMLEscaped (event.getFunction())
-           << LOG4CPLUS_TEXT("\" line=\"")
-           << event.getLine()
-           << LOG4CPLUS_TEXT("\"/>")
-           << LOG4CPLUS_TEXT("</log4j:event>");
-
-    appender_sp.chstr = LOG4CPLUS_TSTRING_TO_STRING (buffer.str ());
-
-    bool ret = socket.write(appender_sp.chstr);
-    if (!ret)
+    formatXml (event);
+
+#if defined (UNICODE)
+    // XML without encoding declaration is UTF-8.
+    std::string & chstr = internal::get_appender_sp ().chstr;
+    chstr.clear ();
+    internal::append_utf8 (chstr, eventXml);
+    std::string_view const xml (chstr);
+#else
+    std::string_view const xml (eventXml);
+#endif
+
+    if (batchSize == 0)
     {
-        helpers::getLogLog().error(
-            LOG4CPLUS_TEXT(
-                "Log4jUdpAppender::append()- Cannot write to server"));
+        // Send straight from the XML buffer, without copying it.
+        if (! socket.write (std::span<std::string_view const> (&xml, 1)))
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT(
+                    "Log4jUdpAppender::append()- Cannot write to server"));
+        return;
     }
+
+    if (! datagram.empty () && datagram.size () + xml.size () > batchSize)
+        flushDatagram ();
+
+    datagram += xml;
+    if (datagram.size () >= batchSize)
+        flushDatagram ();
 }
 
+
+// This method does not need to be locked since it is called by
+// syncDoAppendBatch() which performs the locking
+void
+Log4jUdpAppender::appendBatch(
+    std::span<spi::InternalLoggingEvent const> events)
+{
+    Appender::appendBatch (events);
+    if (batchInterval == 0)
+        flushDatagram ();
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Log4jUdpAppender XML escaping", "[appender]")
+{
+    tstring out (LOG4CPLUS_TEXT ("x"));
+    append_xml_escaped (out, LOG4CPLUS_TEXT ("plain text"));
+    CATCH_REQUIRE (out == LOG4CPLUS_TEXT ("xplain text"));
+
+    out.clear ();
+    append_xml_escaped (out,
+        LOG4CPLUS_TEXT ("a<b>&'\"c\td\x1f"));
+    CATCH_REQUIRE (out
+        == LOG4CPLUS_TEXT ("a&lt;b&gt;&amp;&apos;&quot;c&#x09;d&#x1f;"));
+}
+
+#endif
+
 } // namespace log4cplus
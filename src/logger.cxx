@@ -42,7 +42,7 @@ spi::LoggerImpl *
 DefaultLoggerFactory::makeNewLoggerImplInstance(
     const log4cplus::tstring_view& name, Hierarchy& h)
 {
-    return new spi::LoggerImpl (name, h);
+    return spi::LoggerImpl::create (name, h);
 }
 
 
@@ -100,6 +100,13 @@ Logger::shutdown ()
 }
 
 
+ShutdownReport
+Logger::shutdown (std::chrono::milliseconds timeout)
+{
+    return getDefaultHierarchy ().shutdown (timeout);
+}
+
+
 //////////////////////////////////////////////////////////////////////////////
 // Logger ctors and dtor
 //////////////////////////////////////////////////////////////////////////////
@@ -181,6 +188,13 @@ Logger::getParent () const
 }
 
 
+LoggerRef
+Logger::view () const LOG4CPLUS_NOEXCEPT
+{
+    return LoggerRef (*this);
+}
+
+
 void
 Logger::addAppender (SharedAppenderPtr newAppender)
 {
@@ -275,6 +289,13 @@ Logger::forcedLog (spi::InternalLoggingEvent const & ev) const
 }
 
 
+void
+Logger::logBatch (std::span<spi::InternalLoggingEvent const> events) const
+{
+    value->logBatch (events);
+}
+
+
 void
 Logger::callAppenders (const spi::InternalLoggingEvent& event) const
 {
@@ -282,6 +303,28 @@ Logger::callAppenders (const spi::InternalLoggingEvent& event) const
 }
 
 
+void
+Logger::callAppenders (
+    std::span<spi::InternalLoggingEvent const> events) const
+{
+    value->callAppenders (events);
+}
+
+
+bool
+Logger::hasOnlyAsyncAppenders () const
+{
+    return value->hasOnlyAsyncAppenders ();
+}
+
+
+unsigned
+Logger::getRequiredEventFields () const
+{
+    return value->getRequiredEventFields ();
+}
+
+
 LogLevel
 Logger::getChainedLogLevel () const
 {
@@ -289,6 +332,13 @@ Logger::getChainedLogLevel () const
 }
 
 
+LogLevel
+Logger::getEnabledThreshold () const
+{
+    return value->getEnabledThreshold ();
+}
+
+
 LogLevel
 Logger::getLogLevel() const
 {
@@ -331,4 +381,80 @@ Logger::setAdditivity (bool additive)
 }
 
 
+void
+Logger::setCaptureLimits (std::shared_ptr<spi::CaptureLimits const> limits)
+{
+    value->setCaptureLimits (std::move (limits));
+}
+
+
+std::shared_ptr<spi::CaptureLimits const>
+Logger::getCaptureLimits () const
+{
+    return value->getCaptureLimits ();
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// LoggerRef Methods
+//////////////////////////////////////////////////////////////////////////////
+
+Logger
+LoggerRef::lock () const
+{
+    return Logger (value);
+}
+
+
+bool
+LoggerRef::isEnabledFor (LogLevel ll) const
+{
+    return value->isEnabledFor (ll);
+}
+
+
+void
+LoggerRef::log (LogLevel ll, const log4cplus::tstring_view& message,
+    const char* file, int line, const char* function) const
+{
+    value->log (ll, message, file, line, function ? function : "");
+}
+
+
+void
+LoggerRef::forcedLog (LogLevel ll, const log4cplus::tstring_view& message,
+    const char* file, int line, const char* function) const
+{
+    value->forcedLog (ll, message, file, line, function ? function : "");
+}
+
+
+void
+LoggerRef::forcedLog (spi::InternalLoggingEvent const & ev) const
+{
+    value->forcedLog (ev);
+}
+
+
+bool
+LoggerRef::hasOnlyAsyncAppenders () const
+{
+    return value->hasOnlyAsyncAppenders ();
+}
+
+
+LogLevel
+LoggerRef::getChainedLogLevel () const
+{
+    return value->getChainedLogLevel ();
+}
+
+
+log4cplus::tstring const &
+LoggerRef::getName () const
+{
+    return value->getName ();
+}
+
+
 } // namespace log4cplus
@@ -22,23 +22,119 @@
 #include <log4cplus/spi/loggerimpl.h>
 #include <log4cplus/appender.h>
 #include <log4cplus/hierarchy.h>
+#include <log4cplus/initializer.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/spi/rootlogger.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <new>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/logger.h>
+#include <log4cplus/ndc.h>
+#include <log4cplus/mdc.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/thread/lockprofile.h>
+#include <catch.hpp>
+#endif
+
+
+namespace log4cplus::internal {
+
+//! Generation of cached LoggerImpl::mayLog() results. Zero is never used.
+std::atomic<unsigned> pre_filter_generation {1};
+
+
+void
+invalidate_pre_filter_caches()
+{
+    if (pre_filter_generation.fetch_add(1, std::memory_order_acq_rel) + 1 == 0)
+        pre_filter_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+// logger_arena
+//////////////////////////////////////////////////////////////////////////////
+
+logger_arena::~logger_arena ()
+{
+    for (auto const & c : chunks)
+        c.resource->deallocate (c.memory, c.size, LOG4CPLUS_CACHE_LINE_SIZE);
+}
+
+
+void *
+logger_arena::allocate (std::size_t size, std::size_t alignment)
+{
+    thread::MutexGuard guard (mutex);
+
+    void * p = next;
+    std::size_t space = static_cast<std::size_t>(end - next);
+    if (! next || ! std::align (alignment, size, p, space))
+    {
+        std::size_t const grown = chunks.size () < 5
+            ? first_chunk_size << chunks.size () : chunk_size;
+        std::size_t const bytes = (std::max) ((std::min) (grown, chunk_size),
+            size);
+        std::pmr::memory_resource * const r
+            = resource ? resource : getMemoryResource ();
+        p = r->allocate (bytes, LOG4CPLUS_CACHE_LINE_SIZE);
+        chunks.push_back (chunk {p, bytes, r});
+        end = static_cast<char *>(p) + bytes;
+    }
+
+    next = static_cast<char *>(p) + size;
+    refs.fetch_add (1, std::memory_order_relaxed);
+    return p;
+}
+
+
+void
+logger_arena::release ()
+{
+    if (refs.fetch_sub (1, std::memory_order_acq_rel) == 1)
+        delete this;
+}
+
+
+} // namespace log4cplus::internal
 
 
 namespace log4cplus::spi {
 
+namespace
+{
+
+//! Bits of LoggerImpl::computePreFilter() results.
+enum : unsigned
+{
+    //! Some appender may append the events.
+    PRE_FILTER_MAY = 1,
+    //! The result depends on NDC or MDC and must not be cached.
+    PRE_FILTER_CONTEXTUAL = 2
+};
+
+} // namespace
+
+
 //////////////////////////////////////////////////////////////////////////////
 // Logger Constructors and Destructor
 //////////////////////////////////////////////////////////////////////////////
 LoggerImpl::LoggerImpl(const log4cplus::tstring_view& name_, Hierarchy& h)
-  : name(name_),
+  : AppenderAttachableImpl(h.getAppenderListMutex(name_)),
+    name(name_),
     ll(NOT_SET_LOG_LEVEL),
     parent(nullptr),
     additive(true),
-    hierarchy(h)
+    hierarchy(h),
+    cachedThreshold(0),
+    captureLimits(nullptr),
+    arena(nullptr)
 {
 }
 
@@ -46,6 +142,45 @@ LoggerImpl::LoggerImpl(const log4cplus::tstring_view& name_, Hierarchy& h)
 LoggerImpl::~LoggerImpl() = default;
 
 
+LoggerImpl *
+LoggerImpl::create(const log4cplus::tstring_view& name_, Hierarchy& h)
+{
+    static_assert (alignof (LoggerImpl) <= LOG4CPLUS_CACHE_LINE_SIZE);
+
+    internal::logger_arena & a = *h.loggerArena;
+    void * const p = a.allocate(sizeof (LoggerImpl), alignof (LoggerImpl));
+    LoggerImpl * impl;
+    try
+    {
+        impl = new (p) LoggerImpl(name_, h);
+    }
+    catch (...)
+    {
+        a.release();
+        throw;
+    }
+
+    impl->arena = &a;
+    return impl;
+}
+
+
+void
+LoggerImpl::dispose() const
+{
+    if (! arena)
+    {
+        delete this;
+        return;
+    }
+
+    // Only the memory of the whole arena is freed, with its last logger.
+    internal::logger_arena * const a = arena;
+    this->~LoggerImpl();
+    a->release();
+}
+
+
 //////////////////////////////////////////////////////////////////////////////
 // Logger Methods
 //////////////////////////////////////////////////////////////////////////////
@@ -53,6 +188,17 @@ LoggerImpl::~LoggerImpl() = default;
 void
 LoggerImpl::callAppenders(const InternalLoggingEvent& event)
 {
+    if (event.getLogLevel() >= spi::getStackTraceLogLevel())
+        event.captureStackTrace();
+
+    if (spi::getEventSequencing())
+        event.assignSequenceNumber();
+
+    if (hierarchy.volumeAccounting.load(std::memory_order_relaxed))
+        internal::count_logger_volume(this, name, hierarchy.volumeId,
+            event.getMessage().size() * sizeof(tchar));
+
+    internal::layout_cache_scope layout_cache (event);
     int writes = 0;
     for(const LoggerImpl* c = this; c != nullptr; c=c->parent.get()) {
         writes += c->appendLoopOnAppenders(event);
@@ -74,6 +220,78 @@ LoggerImpl::callAppenders(const InternalLoggingEvent& event)
 }
 
 
+void
+LoggerImpl::callAppenders(std::span<InternalLoggingEvent const> events)
+{
+    if (hierarchy.volumeAccounting.load(std::memory_order_relaxed))
+        for (InternalLoggingEvent const & event : events)
+            internal::count_logger_volume(this, name, hierarchy.volumeId,
+                event.getMessage().size() * sizeof(tchar));
+
+    int writes = 0;
+    for(const LoggerImpl* c = this; c != nullptr; c=c->parent.get()) {
+        writes += c->appendLoopOnAppenders(events);
+        if(!c->additive) {
+            break;
+        }
+    }
+
+    if(!hierarchy.emittedNoAppenderWarning && writes == 0) {
+        helpers::getLogLog().error(
+            LOG4CPLUS_TEXT("No appenders could be found for logger (")
+            + getName()
+            + LOG4CPLUS_TEXT(")."));
+        helpers::getLogLog().error(
+            LOG4CPLUS_TEXT("Please initialize the log4cplus system properly."));
+        hierarchy.emittedNoAppenderWarning = true;
+    }
+}
+
+
+bool
+LoggerImpl::hasOnlyAsyncAppenders() const
+{
+    bool found = false;
+    for(const LoggerImpl* c = this; c != nullptr; c=c->parent.get()) {
+        ListPtr const list = c->getAppenderList();
+        if (list) {
+            for (auto const & appender : *list) {
+                if (! appender->isAsynchronous())
+                    return false;
+
+                found = true;
+            }
+        }
+
+        if(!c->additive) {
+            break;
+        }
+    }
+
+    return found;
+}
+
+
+unsigned
+LoggerImpl::getRequiredEventFields() const
+{
+    unsigned fields = spi::EVENT_FIELDS_NONE;
+    for(const LoggerImpl* c = this; c != nullptr; c=c->parent.get()) {
+        ListPtr const list = c->getAppenderList();
+        if (list) {
+            for (auto const & appender : *list)
+                fields |= appender->getRequiredEventFields();
+        }
+
+        if(!c->additive) {
+            break;
+        }
+    }
+
+    return fields;
+}
+
+
 void
 LoggerImpl::closeNestedAppenders()
 {
@@ -90,10 +308,96 @@ LoggerImpl::closeNestedAppenders()
 bool
 LoggerImpl::isEnabledFor(LogLevel loglevel) const
 {
-    if(hierarchy.disableValue >= loglevel) {
-        return false;
+    return loglevel >= getEnabledThreshold() && mayLog(loglevel);
+}
+
+
+bool
+LoggerImpl::mayLog(LogLevel loglevel) const
+{
+    if (loglevel < TRACE_LOG_LEVEL || loglevel > FATAL_LOG_LEVEL
+        || loglevel % DEBUG_LOG_LEVEL != 0)
+        return (computePreFilter(loglevel) & PRE_FILTER_MAY) != 0;
+
+    std::atomic<std::uint64_t> & entry
+        = cachedPreFilter[loglevel / DEBUG_LOG_LEVEL];
+    std::uint64_t const cached = entry.load(std::memory_order_relaxed);
+    unsigned const generation
+        = internal::pre_filter_generation.load(std::memory_order_acquire);
+    unsigned result;
+    if (static_cast<unsigned>(cached >> 32) == generation
+        && (static_cast<unsigned>(cached) & PRE_FILTER_CONTEXTUAL) == 0)
+        result = static_cast<unsigned>(cached);
+    else
+    {
+        result = computePreFilter(loglevel);
+        entry.store((static_cast<std::uint64_t>(generation) << 32) | result,
+            std::memory_order_relaxed);
     }
-    return loglevel >= getChainedLogLevel();
+
+    return (result & PRE_FILTER_MAY) != 0;
+}
+
+
+unsigned
+LoggerImpl::computePreFilter(LogLevel loglevel) const
+{
+    bool found = false;
+    unsigned result = 0;
+    for(const LoggerImpl* c = this; c != nullptr; c=c->parent.get()) {
+        ListPtr const list = c->getAppenderList();
+        if (list) {
+            for (auto const & appender : *list) {
+                found = true;
+                bool contextual = false;
+                bool const may = appender->mayAppend(loglevel, name,
+                    contextual);
+                if (may && ! contextual)
+                    return PRE_FILTER_MAY;
+
+                if (may)
+                    result |= PRE_FILTER_MAY;
+                if (contextual)
+                    result |= PRE_FILTER_CONTEXTUAL;
+            }
+        }
+
+        if(!c->additive) {
+            break;
+        }
+    }
+
+    // Let callAppenders() warn about missing appenders.
+    return found ? result : PRE_FILTER_MAY;
+}
+
+
+LogLevel
+LoggerImpl::getEnabledThreshold() const
+{
+    std::uint64_t const cached
+        = cachedThreshold.load(std::memory_order_relaxed);
+    unsigned const generation
+        = hierarchy.levelGeneration.load(std::memory_order_acquire);
+    if (static_cast<unsigned>(cached >> 32) == generation)
+        return static_cast<LogLevel>(static_cast<std::int32_t>(
+            static_cast<std::uint32_t>(cached)));
+
+    // Events at or below disableValue are disabled. Saturate the threshold
+    // when everything is disabled (see Hierarchy::disableAll()).
+    LogLevel threshold = (std::max)(getChainedLogLevel(),
+        hierarchy.sheddingThreshold.load(std::memory_order_relaxed));
+    LogLevel const disableValue = hierarchy.disableValue;
+    if (disableValue >= threshold)
+        threshold = disableValue == (std::numeric_limits<LogLevel>::max) ()
+            ? disableValue
+            : disableValue + 1;
+
+    cachedThreshold.store(
+        (static_cast<std::uint64_t>(generation) << 32)
+        | static_cast<std::uint32_t>(threshold),
+        std::memory_order_relaxed);
+    return threshold;
 }
 
 
@@ -134,6 +438,14 @@ LoggerImpl::getChainedLogLevel() const
 }
 
 
+void
+LoggerImpl::setLogLevel(LogLevel _ll)
+{
+    this->ll = _ll;
+    hierarchy.invalidateLogLevelCaches();
+}
+
+
 Hierarchy&
 LoggerImpl::getHierarchy() const
 {
@@ -152,6 +464,36 @@ void
 LoggerImpl::setAdditivity(bool additive_)
 {
     additive = additive_;
+    internal::invalidate_pre_filter_caches();
+}
+
+
+void
+LoggerImpl::setCaptureLimits(std::shared_ptr<CaptureLimits const> limits)
+{
+    if (limits)
+        hierarchy.captureLimited.store(true, std::memory_order_relaxed);
+    captureLimits.store(std::move(limits), std::memory_order_release);
+}
+
+
+std::shared_ptr<CaptureLimits const>
+LoggerImpl::getCaptureLimits() const
+{
+    return captureLimits.load(std::memory_order_acquire);
+}
+
+
+std::shared_ptr<CaptureLimits const>
+LoggerImpl::getChainedCaptureLimits() const
+{
+    for(const LoggerImpl *c=this; c != nullptr; c=c->parent.get()) {
+        std::shared_ptr<CaptureLimits const> limits = c->getCaptureLimits();
+        if (limits)
+            return limits;
+    }
+
+    return nullptr;
 }
 
 
@@ -164,8 +506,25 @@ LoggerImpl::forcedLog(LogLevel loglevel,
 {
     spi::InternalLoggingEvent & ev = internal::get_ptd ()->forced_log_ev;
     assert (function);
-    ev.setLoggingEvent (this->getName(), loglevel, message, file, line,
-        function);
+    std::shared_ptr<CaptureLimits const> limits;
+    if (hierarchy.captureLimited.load(std::memory_order_relaxed))
+        limits = getChainedCaptureLimits();
+    if (! limits) {
+        ev.setLoggingEvent (&this->getName(), loglevel, message, file, line,
+            function);
+        callAppenders(ev);
+        return;
+    }
+
+    // Copy at most one character more than the limit, enough for
+    // applyCaptureLimits() to see the message is too long.
+    std::size_t const max = limits->maxMessageSize;
+    ev.setLoggingEvent (&this->getName(), loglevel,
+        max != 0 && message.size() > max ? message.substr(0, max + 1)
+            : message,
+        file, line, function);
+    if (ev.applyCaptureLimits(*limits))
+        hierarchy.truncatedEvents.fetch_add(1, std::memory_order_relaxed);
     callAppenders(ev);
 }
 
@@ -173,8 +532,408 @@ LoggerImpl::forcedLog(LogLevel loglevel,
 void
 LoggerImpl::forcedLog(spi::InternalLoggingEvent const & ev)
 {
-    callAppenders(ev);
+    std::shared_ptr<CaptureLimits const> limits;
+    if (hierarchy.captureLimited.load(std::memory_order_relaxed))
+        limits = getChainedCaptureLimits();
+    if (! limits) {
+        callAppenders(ev);
+        return;
+    }
+
+    bool const ndcCut = ev.captureLimitedNDC(*limits);
+    if (! ev.exceedsCaptureLimits(*limits)) {
+        if (ndcCut)
+            hierarchy.truncatedEvents.fetch_add(1,
+                std::memory_order_relaxed);
+        callAppenders(ev);
+        return;
+    }
+
+    // The event belongs to the caller, limit a copy of it. Copies share
+    // large messages instead of copying them.
+    spi::InternalLoggingEvent limited(ev);
+    limited.applyCaptureLimits(*limits);
+    hierarchy.truncatedEvents.fetch_add(1, std::memory_order_relaxed);
+    callAppenders(limited);
 }
 
 
+void
+LoggerImpl::logBatch(std::span<spi::InternalLoggingEvent const> events)
+{
+    auto run_begin = events.begin ();
+    for (auto it = run_begin; it != events.end (); ++it)
+    {
+        if (isEnabledFor (it->getLogLevel ()))
+            continue;
+
+        if (run_begin != it)
+            callAppenders (std::span<spi::InternalLoggingEvent const> (
+                run_begin, it));
+        run_begin = it + 1;
+    }
+
+    if (run_begin != events.end ())
+        callAppenders (std::span<spi::InternalLoggingEvent const> (
+            run_begin, events.end ()));
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("LoggerImpl", "[loggerimpl]")
+{
+    Hierarchy h;
+    Logger root = h.getRoot ();
+    Logger child = h.getInstance (LOG4CPLUS_TEXT ("a.b"));
+
+    CATCH_SECTION ("cached level follows ancestors")
+    {
+        root.setLogLevel (INFO_LOG_LEVEL);
+        CATCH_REQUIRE (! child.isEnabledFor (DEBUG_LOG_LEVEL));
+        CATCH_REQUIRE (child.isEnabledFor (INFO_LOG_LEVEL));
+
+        root.setLogLevel (ERROR_LOG_LEVEL);
+        CATCH_REQUIRE (! child.isEnabledFor (WARN_LOG_LEVEL));
+        CATCH_REQUIRE (child.isEnabledFor (ERROR_LOG_LEVEL));
+    }
+
+    CATCH_SECTION ("cached level follows re-parenting")
+    {
+        root.setLogLevel (DEBUG_LOG_LEVEL);
+        CATCH_REQUIRE (child.isEnabledFor (DEBUG_LOG_LEVEL));
+
+        // Creating "a" inserts it between root and "a.b".
+        Logger parent = h.getInstance (LOG4CPLUS_TEXT ("a"));
+        parent.setLogLevel (WARN_LOG_LEVEL);
+        CATCH_REQUIRE (! child.isEnabledFor (INFO_LOG_LEVEL));
+        CATCH_REQUIRE (child.isEnabledFor (WARN_LOG_LEVEL));
+
+        h.resetConfiguration ();
+        CATCH_REQUIRE (child.isEnabledFor (DEBUG_LOG_LEVEL));
+    }
+
+    CATCH_SECTION ("cached level follows disable threshold")
+    {
+        root.setLogLevel (TRACE_LOG_LEVEL);
+        CATCH_REQUIRE (child.isEnabledFor (INFO_LOG_LEVEL));
+
+        h.disableInfo ();
+        CATCH_REQUIRE (! child.isEnabledFor (INFO_LOG_LEVEL));
+        CATCH_REQUIRE (child.isEnabledFor (WARN_LOG_LEVEL));
+
+        h.disableAll ();
+        CATCH_REQUIRE (! child.isEnabledFor (FATAL_LOG_LEVEL));
+
+        h.enableAll ();
+        CATCH_REQUIRE (child.isEnabledFor (TRACE_LOG_LEVEL));
+    }
+
+    CATCH_SECTION ("only asynchronous appenders")
+    {
+        struct TestAppender
+            : Appender
+        {
+            explicit TestAppender (bool async_)
+                : asyncFlag (async_)
+            { }
+
+            ~TestAppender () { destructorImpl (); }
+
+            void close () override { closed = true; }
+            bool isAsynchronous () const override { return asyncFlag; }
+
+        protected:
+            void append (InternalLoggingEvent const &) override { }
+
+            bool asyncFlag;
+        };
+
+        CATCH_REQUIRE (! child.hasOnlyAsyncAppenders ());
+
+        root.addAppender (SharedAppenderPtr (new TestAppender (true)));
+        CATCH_REQUIRE (child.hasOnlyAsyncAppenders ());
+
+        child.addAppender (SharedAppenderPtr (new TestAppender (false)));
+        CATCH_REQUIRE (! child.hasOnlyAsyncAppenders ());
+        CATCH_REQUIRE (root.hasOnlyAsyncAppenders ());
+
+        child.setAdditivity (false);
+        child.removeAllAppenders ();
+        CATCH_REQUIRE (! child.hasOnlyAsyncAppenders ());
+    }
+
+    CATCH_SECTION ("appender thresholds and filters")
+    {
+        struct TestAppender
+            : Appender
+        {
+            ~TestAppender () { destructorImpl (); }
+
+            void close () override { closed = true; }
+
+        protected:
+            void append (InternalLoggingEvent const &) override { }
+        };
+
+        root.setLogLevel (TRACE_LOG_LEVEL);
+        SharedAppenderPtr rootAppender (new TestAppender);
+        rootAppender->setThreshold (INFO_LOG_LEVEL);
+        root.addAppender (rootAppender);
+        CATCH_REQUIRE (! child.isEnabledFor (DEBUG_LOG_LEVEL));
+        CATCH_REQUIRE (child.isEnabledFor (INFO_LOG_LEVEL));
+
+        rootAppender->setThreshold (DEBUG_LOG_LEVEL);
+        CATCH_REQUIRE (child.isEnabledFor (DEBUG_LOG_LEVEL));
+
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("LogLevelToMatch"),
+            LOG4CPLUS_TEXT ("DEBUG"));
+        props.setProperty (LOG4CPLUS_TEXT ("AcceptOnMatch"),
+            LOG4CPLUS_TEXT ("false"));
+        rootAppender->addFilter (FilterPtr (new LogLevelMatchFilter (props)));
+        CATCH_REQUIRE (! child.isEnabledFor (DEBUG_LOG_LEVEL));
+        CATCH_REQUIRE (child.isEnabledFor (WARN_LOG_LEVEL));
+
+        SharedAppenderPtr childAppender (new TestAppender);
+        helpers::Properties ndcProps;
+        ndcProps.setProperty (LOG4CPLUS_TEXT ("NDCToMatch"),
+            LOG4CPLUS_TEXT ("x"));
+        childAppender->addFilter (FilterPtr (new NDCMatchFilter (ndcProps)));
+        child.addAppender (childAppender);
+        {
+            NDCContextCreator ndc (LOG4CPLUS_TEXT ("x"));
+            CATCH_REQUIRE (child.isEnabledFor (DEBUG_LOG_LEVEL));
+        }
+        {
+            NDCContextCreator ndc (LOG4CPLUS_TEXT ("y"));
+            CATCH_REQUIRE (! child.isEnabledFor (DEBUG_LOG_LEVEL));
+        }
+
+        child.removeAllAppenders ();
+        rootAppender->setFilter (FilterPtr ());
+        CATCH_REQUIRE (child.isEnabledFor (DEBUG_LOG_LEVEL));
+
+        // Appenders of loggers whose thresholds all exclude the event
+        // are not visited at all.
+        childAppender->setFilter (FilterPtr ());
+        childAppender->setThreshold (WARN_LOG_LEVEL);
+        childAppender->setMetricsEnabled (true);
+        rootAppender->setMetricsEnabled (true);
+        child.addAppender (childAppender);
+        child.log (INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("info"));
+        CATCH_REQUIRE (childAppender->getMetrics ().filtered == 0);
+        CATCH_REQUIRE (childAppender->getMetrics ().events == 0);
+        CATCH_REQUIRE (rootAppender->getMetrics ().events == 1);
+
+        childAppender->setThreshold (INFO_LOG_LEVEL);
+        child.log (INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("info"));
+        CATCH_REQUIRE (childAppender->getMetrics ().events == 1);
+        CATCH_REQUIRE (rootAppender->getMetrics ().events == 2);
+        child.removeAllAppenders ();
+    }
+
+    CATCH_SECTION ("contextual filters do not lock appenders")
+    {
+        struct TestAppender
+            : Appender
+        {
+            ~TestAppender () { destructorImpl (); }
+
+            void close () override { closed = true; }
+
+        protected:
+            void append (InternalLoggingEvent const &) override { }
+        };
+
+        auto appenderLocks = [] {
+            for (thread::LockSiteProfile const & site
+                : thread::getLockProfile ())
+                if (std::string_view (site.name)
+                    == "SharedObject::access_mutex")
+                    return site.acquisitions;
+            return std::uint64_t (0);
+        };
+
+        thread::setLockProfilingEnabled (true);
+        root.setLogLevel (DEBUG_LOG_LEVEL);
+        SharedAppenderPtr appender (new TestAppender);
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("MDCKeyToMatch"),
+            LOG4CPLUS_TEXT ("user"));
+        props.setProperty (LOG4CPLUS_TEXT ("MDCValueToMatch"),
+            LOG4CPLUS_TEXT ("x"));
+        props.setProperty (LOG4CPLUS_TEXT ("AcceptOnMatch"),
+            LOG4CPLUS_TEXT ("false"));
+        appender->addFilter (FilterPtr (new MDCMatchFilter (props)));
+        root.addAppender (appender);
+
+        getMDC ().put (LOG4CPLUS_TEXT ("user"), LOG4CPLUS_TEXT ("x"));
+        std::uint64_t const locks = appenderLocks ();
+        CATCH_REQUIRE (locks != 0);
+        for (int i = 0; i != 10; ++i)
+            CATCH_REQUIRE (! child.isEnabledFor (DEBUG_LOG_LEVEL));
+        CATCH_REQUIRE (appenderLocks () == locks);
+
+        getMDC ().put (LOG4CPLUS_TEXT ("user"), LOG4CPLUS_TEXT ("y"));
+        CATCH_REQUIRE (child.isEnabledFor (DEBUG_LOG_LEVEL));
+        CATCH_REQUIRE (appenderLocks () == locks);
+
+        getMDC ().remove (LOG4CPLUS_TEXT ("user"));
+        thread::setLockProfilingEnabled (false);
+        root.removeAllAppenders ();
+    }
+
+    CATCH_SECTION ("appenders without consumers")
+    {
+        struct TracingAppender
+            : Appender
+        {
+            ~TracingAppender () { destructorImpl (); }
+
+            void close () override { closed = true; }
+
+            bool hasConsumers (LogLevel ll) const override
+            {
+                return ll >= listening;
+            }
+
+            void setListening (LogLevel ll)
+            {
+                listening = ll;
+                consumersChanged ();
+            }
+
+            LogLevel listening = OFF_LOG_LEVEL;
+
+        protected:
+            void append (InternalLoggingEvent const &) override { }
+        };
+
+        root.setLogLevel (TRACE_LOG_LEVEL);
+        helpers::SharedObjectPtr<TracingAppender> appender (
+            new TracingAppender);
+        root.addAppender (SharedAppenderPtr (appender.get ()));
+        CATCH_REQUIRE (! child.isEnabledFor (FATAL_LOG_LEVEL));
+
+        appender->setListening (WARN_LOG_LEVEL);
+        CATCH_REQUIRE (! child.isEnabledFor (INFO_LOG_LEVEL));
+        CATCH_REQUIRE (child.isEnabledFor (WARN_LOG_LEVEL));
+
+        appender->setListening (TRACE_LOG_LEVEL);
+        CATCH_REQUIRE (child.isEnabledFor (TRACE_LOG_LEVEL));
+
+        root.removeAllAppenders ();
+    }
+
+    CATCH_SECTION ("required event fields")
+    {
+        struct TestAppender
+            : Appender
+        {
+            ~TestAppender () { destructorImpl (); }
+
+            void close () override { closed = true; }
+
+        protected:
+            void append (InternalLoggingEvent const &) override { }
+        };
+
+        CATCH_REQUIRE (child.getRequiredEventFields () == EVENT_FIELDS_NONE);
+
+        SharedAppenderPtr rootAppender (new TestAppender);
+        root.addAppender (rootAppender);
+        CATCH_REQUIRE (child.getRequiredEventFields () == EVENT_FIELDS_NONE);
+
+        rootAppender->setLayout (std::make_unique<PatternLayout> (
+            LOG4CPLUS_TEXT ("[%t] %m%n")));
+        CATCH_REQUIRE (child.getRequiredEventFields () == EVENT_FIELD_THREAD);
+
+        SharedAppenderPtr childAppender (new TestAppender);
+        childAppender->addFilter (FilterPtr (new NDCMatchFilter));
+        child.addAppender (childAppender);
+        CATCH_REQUIRE (child.getRequiredEventFields ()
+            == (EVENT_FIELD_THREAD | EVENT_FIELD_NDC));
+        CATCH_REQUIRE (root.getRequiredEventFields () == EVENT_FIELD_THREAD);
+
+        child.setAdditivity (false);
+        CATCH_REQUIRE (child.getRequiredEventFields () == EVENT_FIELD_NDC);
+    }
+
+    CATCH_SECTION ("copy of required event fields")
+    {
+        NDC & ndc = getNDC ();
+        ndc.push (LOG4CPLUS_TEXT ("context"));
+        InternalLoggingEvent const ev (child.getName (), INFO_LOG_LEVEL,
+            LOG4CPLUS_TEXT ("message"), "file.cxx", 1, "func");
+
+        InternalLoggingEvent const copy (ev,
+            EVENT_FIELD_NDC | EVENT_FIELD_FILE);
+        CATCH_REQUIRE (copy.getMessage () == ev.getMessage ());
+        CATCH_REQUIRE (copy.getNDC () == LOG4CPLUS_TEXT ("context"));
+        CATCH_REQUIRE (copy.getFile () == LOG4CPLUS_TEXT ("file.cxx"));
+        CATCH_REQUIRE (copy.getFunction ().empty ());
+        CATCH_REQUIRE (copy.getThread ().empty ());
+        ndc.pop_void ();
+    }
+
+    CATCH_SECTION ("capture limits")
+    {
+        struct TestAppender
+            : Appender
+        {
+            ~TestAppender () { destructorImpl (); }
+
+            void close () override { closed = true; }
+
+            InternalLoggingEvent last;
+
+        protected:
+            void append (InternalLoggingEvent const & ev) override
+            {
+                last = ev;
+            }
+        };
+
+        root.setLogLevel (TRACE_LOG_LEVEL);
+        helpers::SharedObjectPtr<TestAppender> appender (new TestAppender);
+        root.addAppender (SharedAppenderPtr (appender.get ()));
+
+        auto limits = std::make_shared<CaptureLimits> ();
+        limits->maxMessageSize = 4;
+        limits->maxNDCDepth = 1;
+        limits->maxMDCValueSize = 2;
+        limits->marker = LOG4CPLUS_TEXT ("~");
+        h.getInstance (LOG4CPLUS_TEXT ("a")).setCaptureLimits (limits);
+        CATCH_REQUIRE (! child.getCaptureLimits ());
+
+        NDCContextCreator outer (LOG4CPLUS_TEXT ("outer"));
+        NDCContextCreator inner (LOG4CPLUS_TEXT ("inner"));
+        getMDC ().put (LOG4CPLUS_TEXT ("key"), LOG4CPLUS_TEXT ("value"));
+
+        child.forcedLog (INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"));
+        CATCH_REQUIRE (appender->last.getMessage () == LOG4CPLUS_TEXT ("mess~"));
+        CATCH_REQUIRE (appender->last.getNDC () == LOG4CPLUS_TEXT ("outer ~"));
+        CATCH_REQUIRE (appender->last.getMDC (LOG4CPLUS_TEXT ("key"))
+            == LOG4CPLUS_TEXT ("va~"));
+        CATCH_REQUIRE (h.getTruncatedEventCount () == 1);
+
+        // Events of the caller are limited in a copy.
+        InternalLoggingEvent const ev (child.getName (), INFO_LOG_LEVEL,
+            LOG4CPLUS_TEXT ("another message"), nullptr, -1);
+        child.forcedLog (ev);
+        CATCH_REQUIRE (appender->last.getMessage () == LOG4CPLUS_TEXT ("anot~"));
+        CATCH_REQUIRE (ev.getMessage () == LOG4CPLUS_TEXT ("another message"));
+        CATCH_REQUIRE (h.getTruncatedEventCount () == 2);
+
+        getMDC ().clear ();
+        child.forcedLog (INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("fits"));
+        CATCH_REQUIRE (appender->last.getMessage () == LOG4CPLUS_TEXT ("fits"));
+        CATCH_REQUIRE (h.getTruncatedEventCount () == 3);
+
+        h.resetConfiguration ();
+        CATCH_REQUIRE (! h.getInstance (LOG4CPLUS_TEXT ("a")).getCaptureLimits ());
+    }
+}
+#endif
+
 } // namespace log4cplus::spi
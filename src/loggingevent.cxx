@@ -21,6 +21,14 @@
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/internal/internal.h>
 #include <algorithm>
+#include <atomic>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/layout.h>
+#include <catch.hpp>
+#include <set>
+#include <thread>
+#endif
 
 
 namespace log4cplus::spi {
@@ -29,6 +37,41 @@ namespace log4cplus::spi {
 static const int LOG4CPLUS_DEFAULT_TYPE = 1;
 
 
+//! Length from which messages are shared by copies of an event rather
+//! than copied, see InternalLoggingEvent::copyMessage().
+static constexpr std::size_t shared_message_threshold = 1024;
+
+
+//! Number of sequence numbers a thread leases at once, see
+//! InternalLoggingEvent::assignSequenceNumber().
+static constexpr std::uint64_t sequence_block_size = 1024;
+
+
+//! See setEventSequencing().
+static std::atomic<bool> event_sequencing {false};
+
+
+//! Start of the next block of sequence numbers; 0 is never assigned.
+static std::atomic<std::uint64_t> next_sequence_block {1};
+
+
+void
+setEventSequencing (bool enable)
+{
+    event_sequencing.store (enable, std::memory_order_relaxed);
+}
+
+
+bool
+getEventSequencing ()
+{
+    return event_sequencing.load (std::memory_order_relaxed);
+}
+
+
+DeferredMessage::~DeferredMessage () = default;
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // InternalLoggingEvent ctors and dtor
 ///////////////////////////////////////////////////////////////////////////////
@@ -39,20 +82,19 @@ InternalLoggingEvent::InternalLoggingEvent(
     const char* filename, int line_, const char * function_)
     : message(message_)
     , loggerName(logger)
+    , loggerNameRef(nullptr)
     , ll(loglevel)
-    , timestamp(log4cplus::helpers::now ())
-    , file(filename
-        ? LOG4CPLUS_C_STR_TO_TSTRING(filename)
-        : log4cplus::tstring())
-    , function (function_
-        ? LOG4CPLUS_C_STR_TO_TSTRING(function_)
-        : log4cplus::tstring())
+    , fileRef(filename)
+    , functionRef(function_)
+    , sequence(0)
     , line(line_)
     , threadCached(false)
     , thread2Cached(false)
     , ndcCached(false)
     , mdcCached(false)
+    , messageCached(true)
 {
+    setPreciseTimestamp (helpers::eventNowPrecise ());
 }
 
 
@@ -68,9 +110,12 @@ InternalLoggingEvent::InternalLoggingEvent(
     const log4cplus::tstring_view& function_)
     : message(message_)
     , loggerName(logger)
+    , loggerNameRef(nullptr)
     , ll(loglevel)
     , ndc(ndc_)
-    , mdc(mdc_)
+    , mdc(mdc_.empty ()
+        ? MappedDiagnosticContextPtr ()
+        : std::make_shared<MappedDiagnosticContext const> (mdc_))
     , thread(thread_)
     , thread2(thread2_)
     , timestamp(time)
@@ -78,43 +123,70 @@ InternalLoggingEvent::InternalLoggingEvent(
     , function (function_.data ()
         ? function_
         : log4cplus::tstring())
+    , fileRef(nullptr)
+    , functionRef(nullptr)
+    , sequence(0)
     , line(line_)
+    , timestampNanos(0)
     , threadCached(true)
     , thread2Cached(true)
     , ndcCached(true)
     , mdcCached(true)
+    , messageCached(true)
 {
 }
 
 
 InternalLoggingEvent::InternalLoggingEvent ()
-    : ll (NOT_SET_LOG_LEVEL)
+    : loggerNameRef (nullptr)
+    , ll (NOT_SET_LOG_LEVEL)
+    , fileRef (nullptr)
+    , functionRef (nullptr)
+    , sequence (0)
     , line (0)
+    , timestampNanos (0)
     , threadCached(false)
     , thread2Cached(false)
     , ndcCached(false)
     , mdcCached(false)
+    , messageCached(true)
 { }
 
 
 InternalLoggingEvent::InternalLoggingEvent(
     const log4cplus::spi::InternalLoggingEvent& rhs)
-    : message(rhs.getMessage())
-    , loggerName(rhs.getLoggerName())
+    : loggerName(rhs.getLoggerName())
+    , loggerNameRef(nullptr)
     , ll(rhs.getLogLevel())
     , ndc(rhs.getNDC())
-    , mdc(rhs.getMDCCopy())
+    , mdc(rhs.getMDCSnapshot())
     , thread(rhs.getThread())
     , thread2(rhs.getThread2())
     , timestamp(rhs.getTimestamp())
     , file(rhs.getFile())
     , function(rhs.getFunction())
+    , fileRef(nullptr)
+    , functionRef(nullptr)
+    , keyValues(rhs.keyValues)
+    , stackTrace(rhs.stackTrace)
+    , sequence(rhs.sequence)
     , line(rhs.getLine())
+    , timestampNanos(rhs.timestampNanos)
     , threadCached(true)
     , thread2Cached(true)
     , ndcCached(true)
     , mdcCached(true)
+    , messageCached(true)
+{
+    copyMessage (rhs);
+}
+
+
+InternalLoggingEvent::InternalLoggingEvent(
+    const log4cplus::spi::InternalLoggingEvent& rhs, unsigned fields)
+    : InternalLoggingEvent ()
 {
+    assign (rhs, fields);
 }
 
 
@@ -142,6 +214,27 @@ void
 InternalLoggingEvent::setLoggingEvent (const log4cplus::tstring_view & logger,
     LogLevel loglevel, const log4cplus::tstring_view & msg,
     const char * filename, int fline, const char * function_)
+{
+    loggerName = logger;
+    loggerNameRef = nullptr;
+    setLoggingEventData (loglevel, msg, filename, fline, function_);
+}
+
+
+void
+InternalLoggingEvent::setLoggingEvent (const log4cplus::tstring * logger,
+    LogLevel loglevel, const log4cplus::tstring_view & msg,
+    const char * filename, int fline, const char * function_)
+{
+    loggerNameRef = logger;
+    setLoggingEventData (loglevel, msg, filename, fline, function_);
+}
+
+
+void
+InternalLoggingEvent::setLoggingEventData (LogLevel loglevel,
+    const log4cplus::tstring_view & msg, const char * filename, int fline,
+    const char * function_)
 {
     // This could be imlemented using the swap idiom:
     //
@@ -150,25 +243,31 @@ InternalLoggingEvent::setLoggingEvent (const log4cplus::tstring_view & logger,
     // But that defeats the optimization of using thread local instance
     // of InternalLoggingEvent to avoid memory allocation.
 
-    loggerName = logger;
     ll = loglevel;
     message = msg;
-    timestamp = helpers::now ();
-
-    if (filename)
-        file = LOG4CPLUS_C_STR_TO_TSTRING (filename);
-    else
-        file.clear ();
-
-    if (function_)
-        function = LOG4CPLUS_C_STR_TO_TSTRING (function_);
-    else
-        function.clear ();
+    sharedMessage.reset ();
+    deferredMessage.reset ();
+    messageCached = true;
+    setPreciseTimestamp (helpers::eventNowPrecise ());
+
+    // File and function names usually come from __FILE__ and __func__ and
+    // many layouts never print them. Borrow them and convert them lazily.
+
+    file.clear ();
+    fileRef = filename;
+    function.clear ();
+    functionRef = function_;
+    keyValues.clear ();
+    stackTrace.reset ();
+    sequence = 0;
 
     line = fline;
     threadCached = false;
     thread2Cached = false;
     ndcCached = false;
+    // Reused events must not keep snapshots they no longer show alive,
+    // MDC would have to copy them on its next change.
+    mdc.reset ();
     mdcCached = false;
 }
 
@@ -176,16 +275,15 @@ InternalLoggingEvent::setLoggingEvent (const log4cplus::tstring_view & logger,
 void
 InternalLoggingEvent::setFunction (char const * func)
 {
-    if (func)
-        function = LOG4CPLUS_C_STR_TO_TSTRING (func);
-    else
-        function.clear ();
+    function.clear ();
+    functionRef = func;
 }
 
 
 void
 InternalLoggingEvent::setFunction (log4cplus::tstring_view const & func)
 {
+    functionRef = nullptr;
     if (func.data ())
         function = func;
     else
@@ -193,10 +291,205 @@ InternalLoggingEvent::setFunction (log4cplus::tstring_view const & func)
 }
 
 
+void
+InternalLoggingEvent::setTimestamp (helpers::Time const & time)
+{
+    timestamp = time;
+    timestampNanos = 0;
+}
+
+
+void
+InternalLoggingEvent::setPreciseTimestamp (helpers::PreciseTime const & time)
+{
+    timestamp = helpers::chrono::floor<helpers::Duration> (time);
+    timestampNanos = static_cast<std::uint16_t>((time - timestamp).count ());
+}
+
+
+void
+InternalLoggingEvent::setDeferredMessage (DeferredMessagePtr msg)
+{
+    deferredMessage = std::move (msg);
+    messageCached = ! deferredMessage;
+    sharedMessage.reset ();
+}
+
+
+void
+InternalLoggingEvent::reserveMessage (std::size_t capacity)
+{
+    deferredMessage.reset ();
+    messageCached = true;
+    sharedMessage.reset ();
+    message.resize (capacity);
+    message.clear ();
+}
+
+
+bool
+InternalLoggingEvent::exceedsCaptureLimits (
+    CaptureLimits const & limits) const
+{
+    if (limits.maxMessageSize != 0
+        && getMessage ().size () > limits.maxMessageSize)
+        return true;
+
+    if (limits.maxMDCValueSize != 0)
+        for (auto const & kv : getMDCCopy ())
+            if (kv.second.size () > limits.maxMDCValueSize)
+                return true;
+
+    return false;
+}
+
+
+bool
+InternalLoggingEvent::applyCaptureLimits (CaptureLimits const & limits)
+{
+    bool cut = false;
+
+    if (limits.maxMessageSize != 0
+        && getMessage ().size () > limits.maxMessageSize)
+    {
+        if (sharedMessage)
+        {
+            message.assign (*sharedMessage, 0, limits.maxMessageSize);
+            sharedMessage.reset ();
+        }
+        else
+            message.resize (limits.maxMessageSize);
+
+        message += limits.marker;
+        // The deferred form would bring the whole message back.
+        deferredMessage.reset ();
+        cut = true;
+    }
+
+    if (captureLimitedNDC (limits))
+        cut = true;
+
+    if (limits.maxMDCValueSize != 0)
+    {
+        MappedDiagnosticContextMap const & map = getMDCCopy ();
+        auto const too_long = [&limits] (auto const & kv) {
+            return kv.second.size () > limits.maxMDCValueSize; };
+        if (std::any_of (map.begin (), map.end (), too_long))
+        {
+            MappedDiagnosticContextMap limited (map);
+            for (auto & kv : limited)
+                if (too_long (kv))
+                {
+                    kv.second.resize (limits.maxMDCValueSize);
+                    kv.second += limits.marker;
+                }
+
+            mdc = std::make_shared<MappedDiagnosticContext const> (
+                std::move (limited));
+            mdcCached = true;
+            cut = true;
+        }
+    }
+
+    return cut;
+}
+
+
+bool
+InternalLoggingEvent::captureLimitedNDC (CaptureLimits const & limits) const
+{
+    if (limits.maxNDCDepth == 0 || ndcCached
+        || log4cplus::getNDC ().getDepth () <= limits.maxNDCDepth)
+        return false;
+
+    DiagnosticContextStack const stack = log4cplus::getNDC ().cloneStack ();
+    ndc.clear ();
+    for (std::size_t i = 0; i != limits.maxNDCDepth; ++i)
+    {
+        ndc += stack[i].message;
+        ndc += LOG4CPLUS_TEXT (' ');
+    }
+
+    ndc += limits.marker;
+    ndcCached = true;
+    return true;
+}
+
+
 const log4cplus::tstring&
 InternalLoggingEvent::getMessage() const
 {
-    return message;
+    if (! messageCached)
+    {
+        message.clear ();
+        deferredMessage->format (message);
+        messageCached = true;
+    }
+
+    return sharedMessage ? *sharedMessage : message;
+}
+
+
+void
+InternalLoggingEvent::copyMessage (const InternalLoggingEvent & rhs)
+{
+    // Keep deferred message unformatted so that formatting happens on
+    // the thread that actually needs the message.
+    deferredMessage = rhs.deferredMessage;
+    messageCached = rhs.messageCached;
+    if (! messageCached)
+    {
+        message.clear ();
+        sharedMessage.reset ();
+        return;
+    }
+
+    // Large messages are copied once into a buffer which the event and
+    // all of its copies then share.
+    if (! rhs.sharedMessage
+        && rhs.message.size () >= shared_message_threshold)
+    {
+        rhs.sharedMessage
+            = std::make_shared<tstring const> (std::move (rhs.message));
+        rhs.message.clear ();
+    }
+
+    if (rhs.sharedMessage)
+    {
+        sharedMessage = rhs.sharedMessage;
+        message.clear ();
+    }
+    else
+    {
+        sharedMessage.reset ();
+        message = rhs.message;
+    }
+}
+
+
+void
+InternalLoggingEvent::captureStackTrace () const
+{
+    // Leaves out this function's frame.
+    if (! stackTrace)
+        stackTrace = currentStackTrace (1);
+}
+
+
+void
+InternalLoggingEvent::assignSequenceNumber () const
+{
+    if (sequence != 0)
+        return;
+
+    internal::per_thread_data * const ptd = internal::get_ptd ();
+    if (ptd->sequence_next == ptd->sequence_end)
+    {
+        ptd->sequence_next = next_sequence_block.fetch_add (
+            sequence_block_size, std::memory_order_relaxed);
+        ptd->sequence_end = ptd->sequence_next + sequence_block_size;
+    }
+    sequence = ptd->sequence_next++;
 }
 
 
@@ -216,6 +509,23 @@ InternalLoggingEvent::clone() const
 }
 
 
+MappedDiagnosticContextMap const &
+InternalLoggingEvent::getMDCCopy () const
+{
+    MappedDiagnosticContextPtr const & mdc_ = getMDCSnapshot ();
+    return mdc_ ? mdc_->map : internal::empty_mdc;
+}
+
+
+tstring const &
+InternalLoggingEvent::getMDC (MDCKey key) const
+{
+    MappedDiagnosticContextPtr const & mdc_ = getMDCSnapshot ();
+    tstring const * const value = mdc_ ? mdc_->get (key) : nullptr;
+    return value ? *value : internal::empty_str;
+}
+
+
 tstring const &
 InternalLoggingEvent::getMDC (tstring const & key) const
 {
@@ -232,18 +542,99 @@ InternalLoggingEvent::getMDC (tstring const & key) const
 InternalLoggingEvent &
 InternalLoggingEvent::operator = (const InternalLoggingEvent& rhs)
 {
-    InternalLoggingEvent (rhs).swap (*this);
+    // Assign member by member instead of using the copy and swap idiom so
+    // that events which are reused as storage, e.g., by thread::Queue,
+    // keep capacity of their strings.
+
+    if (this != &rhs)
+        assign (rhs, EVENT_FIELDS_ALL);
+
     return *this;
 }
 
 
 void
-InternalLoggingEvent::gatherThreadSpecificData () const
+InternalLoggingEvent::assign (const InternalLoggingEvent& rhs,
+    unsigned fields)
+{
+    copyMessage (rhs);
+    loggerName = rhs.getLoggerName ();
+    loggerNameRef = nullptr;
+    ll = rhs.getLogLevel ();
+
+    if (fields & EVENT_FIELD_NDC)
+        ndc = rhs.getNDC ();
+    else
+        ndc.clear ();
+
+    if (fields & EVENT_FIELD_MDC)
+        mdc = rhs.getMDCSnapshot ();
+    else
+        mdc.reset ();
+
+    if (fields & EVENT_FIELD_THREAD)
+        thread = rhs.getThread ();
+    else
+        thread.clear ();
+
+    if (fields & EVENT_FIELD_THREAD2)
+        thread2 = rhs.getThread2 ();
+    else
+        thread2.clear ();
+
+    timestamp = rhs.getTimestamp ();
+    timestampNanos = rhs.timestampNanos;
+
+    if (fields & EVENT_FIELD_FILE)
+        file = rhs.getFile ();
+    else
+        file.clear ();
+    fileRef = nullptr;
+
+    if (fields & EVENT_FIELD_FUNCTION)
+        function = rhs.getFunction ();
+    else
+        function.clear ();
+    functionRef = nullptr;
+
+    keyValues = rhs.keyValues;
+    stackTrace = rhs.stackTrace;
+    sequence = rhs.sequence;
+    line = rhs.getLine ();
+    threadCached = true;
+    thread2Cached = true;
+    ndcCached = true;
+    mdcCached = true;
+}
+
+
+void
+InternalLoggingEvent::gatherThreadSpecificData (unsigned fields) const
 {
-    getNDC ();
-    getMDCCopy ();
-    getThread ();
-    getThread2 ();
+    if (fields & EVENT_FIELD_NDC)
+        getNDC ();
+    if (fields & EVENT_FIELD_MDC)
+        getMDCSnapshot ();
+    if ((fields & EVENT_FIELD_THREAD) && ! threadCached)
+    {
+        thread = thread::getCurrentThreadName ();
+        threadCached = true;
+    }
+    if ((fields & EVENT_FIELD_THREAD2) && ! thread2Cached)
+    {
+        thread2 = thread::getCurrentThreadName2 ();
+        thread2Cached = true;
+    }
+    // Borrowed strings might not outlive the logging call.
+    if (loggerNameRef)
+    {
+        loggerName = *loggerNameRef;
+        loggerNameRef = nullptr;
+    }
+    if (fields & EVENT_FIELD_FILE)
+        getFile ();
+    if (fields & EVENT_FIELD_FUNCTION)
+        getFunction ();
 }
 
 
@@ -253,20 +644,106 @@ InternalLoggingEvent::swap (InternalLoggingEvent & other)
     using std::swap;
 
     swap (message, other.message);
+    swap (sharedMessage, other.sharedMessage);
+    swap (deferredMessage, other.deferredMessage);
+    swap (messageCached, other.messageCached);
     swap (loggerName, other.loggerName);
+    swap (loggerNameRef, other.loggerNameRef);
     swap (ll, other.ll);
     swap (ndc, other.ndc);
     swap (mdc, other.mdc);
     swap (thread, other.thread);
     swap (thread2, other.thread2);
     swap (timestamp, other.timestamp);
+    swap (timestampNanos, other.timestampNanos);
     swap (file, other.file);
     swap (function, other.function);
+    swap (fileRef, other.fileRef);
+    swap (functionRef, other.functionRef);
+    keyValues.swap (other.keyValues);
+    swap (stackTrace, other.stackTrace);
+    swap (sequence, other.sequence);
     swap (line, other.line);
     swap (threadCached, other.threadCached);
     swap (thread2Cached, other.thread2Cached);
     swap (ndcCached, other.ndcCached);
+    swap (mdcCached, other.mdcCached);
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Shared message", "[event]")
+{
+    tstring const large (shared_message_threshold, LOG4CPLUS_TEXT ('x'));
+    InternalLoggingEvent ev;
+    ev.setLoggingEvent (tstring_view (LOG4CPLUS_TEXT ("logger")),
+        INFO_LOG_LEVEL, large, __FILE__, __LINE__);
+
+    InternalLoggingEvent copy (ev);
+    std::unique_ptr<InternalLoggingEvent> clone = copy.clone ();
+    InternalLoggingEvent assigned;
+    assigned = *clone;
+    CATCH_REQUIRE (ev.getMessage () == large);
+    CATCH_REQUIRE (&copy.getMessage () == &ev.getMessage ());
+    CATCH_REQUIRE (&clone->getMessage () == &ev.getMessage ());
+    CATCH_REQUIRE (&assigned.getMessage () == &ev.getMessage ());
+
+    // Reuse of the event does not affect its copies.
+    ev.setLoggingEvent (tstring_view (LOG4CPLUS_TEXT ("logger")),
+        INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("small"), __FILE__, __LINE__);
+    InternalLoggingEvent small (ev);
+    CATCH_REQUIRE (small.getMessage () == LOG4CPLUS_TEXT ("small"));
+    CATCH_REQUIRE (&small.getMessage () != &ev.getMessage ());
+    CATCH_REQUIRE (copy.getMessage () == large);
+}
+
+
+CATCH_TEST_CASE ("Event sequence numbers", "[event]")
+{
+    constexpr std::size_t threads = 4;
+    constexpr std::size_t events = 3 * sequence_block_size;
+    std::vector<std::vector<std::uint64_t>> seqs (threads);
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t != threads; ++t)
+        workers.emplace_back ([&seqs, t] {
+            InternalLoggingEvent ev;
+            for (std::size_t i = 0; i != events; ++i)
+            {
+                // Reused events get new numbers.
+                ev.setLoggingEvent (tstring_view (LOG4CPLUS_TEXT ("seq")),
+                    INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("msg"), __FILE__,
+                    __LINE__);
+                ev.assignSequenceNumber ();
+                ev.assignSequenceNumber ();
+                seqs[t].push_back (ev.getSequenceNumber ());
+            }
+        });
+    for (std::thread & worker : workers)
+        worker.join ();
+
+    std::set<std::uint64_t> all;
+    for (std::vector<std::uint64_t> const & s : seqs)
+    {
+        CATCH_REQUIRE (std::is_sorted (s.begin (), s.end ()));
+        CATCH_REQUIRE (s.front () != 0);
+        all.insert (s.begin (), s.end ());
+    }
+    CATCH_REQUIRE (all.size () == threads * events);
+
+    InternalLoggingEvent ev (LOG4CPLUS_TEXT ("seq"), INFO_LOG_LEVEL,
+        LOG4CPLUS_TEXT ("msg"), __FILE__, __LINE__);
+    PatternLayout layout (LOG4CPLUS_TEXT ("[%Y]"));
+    tstring out;
+    layout.formatAndAppend (out, ev);
+    CATCH_REQUIRE (out == LOG4CPLUS_TEXT ("[]"));
+
+    ev.setSequenceNumber (42);
+    InternalLoggingEvent const copy (ev);
+    out.clear ();
+    layout.formatAndAppend (out, copy);
+    CATCH_REQUIRE (out == LOG4CPLUS_TEXT ("[42]"));
 }
+#endif
 
 
 } // namespace log4cplus::spi
@@ -23,8 +23,15 @@
 
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/loggingmacros.h>
+#include <log4cplus/hierarchy.h>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
 
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/layout.h>
+#include <log4cplus/nullappender.h>
 #include <catch.hpp>
 #endif
 
@@ -44,12 +51,13 @@ static std::streamsize const default_precision
     = macros_oss_defaults.precision ();
 static std::streamsize const default_width = macros_oss_defaults.width ();
 
-//! Clears string stream using defaults taken from macros_oss_defaults.
+//! Restores formatting state of stream using defaults taken from
+//! macros_oss_defaults.
+static
 void
-clear_tostringstream (tostringstream & os)
+reset_stream_format (tostream & os)
 {
     os.clear ();
-    os.str (internal::empty_str);
     os.setf (default_flags);
     os.fill (default_fill);
     os.precision (default_precision);
@@ -62,15 +70,52 @@ clear_tostringstream (tostringstream & os)
 }
 
 
-log4cplus::tostringstream &
-get_macro_body_oss ()
+//! Clears string stream using defaults taken from macros_oss_defaults.
+void
+clear_tostringstream (tostringstream & os)
 {
-    tostringstream & oss = internal::get_ptd ()->macros_oss;
+    // Move the buffer out and back to empty the stream without giving up
+    // its capacity, unless it has grown over the limit.
+    tstring buf (std::move (os).str ());
+    internal::clear_thread_buffer (buf);
+    os.str (std::move (buf));
+    reset_stream_format (os);
+}
+
+
+//! Clears buffer stream using defaults taken from macros_oss_defaults.
+//! The buffer keeps its capacity up to
+//! internal::get_thread_buffer_capacity_limit().
+void
+clear_tostringstream (helpers::buffer_ostream & os)
+{
+    os.rdbuf ()->clear (internal::get_thread_buffer_capacity_limit ());
+    reset_stream_format (os);
+}
+
+
+helpers::buffer_ostream &
+get_macro_body_stream ()
+{
+    helpers::buffer_ostream & oss = internal::get_ptd ()->macros_oss;
     clear_tostringstream (oss);
     return oss;
 }
 
 
+tostringstream &
+get_macro_body_oss ()
+{
+    std::unique_ptr<tostringstream> & oss
+        = internal::get_ptd ()->macros_tostringstream;
+    if (oss)
+        clear_tostringstream (*oss);
+    else
+        oss = std::make_unique<tostringstream> ();
+    return *oss;
+}
+
+
 log4cplus::helpers::snprintf_buf &
 get_macro_body_snprintf_buf ()
 {
@@ -79,28 +124,126 @@ get_macro_body_snprintf_buf ()
 
 
 void
-macro_forced_log (log4cplus::Logger const & logger,
+macro_forced_log (log4cplus::LoggerRef const & logger,
     log4cplus::LogLevel log_level, log4cplus::tchar const * msg,
     char const * filename, int line, char const * func)
 {
-    macro_forced_log (logger, log_level,
-        internal::get_ptd ()->macros_str = msg, filename, line, func);
+    tstring & str = internal::get_ptd ()->macros_str;
+    internal::clear_thread_buffer (str);
+    macro_forced_log (logger, log_level, str.append (msg), filename, line,
+        func);
 }
 
 
 void
-macro_forced_log (log4cplus::Logger const & logger,
+macro_forced_log (log4cplus::LoggerRef const & logger,
+    log4cplus::LogLevel log_level, log4cplus::tstring_view const & msg,
+    char const * filename, int line, char const * func)
+{
+    log4cplus::spi::InternalLoggingEvent & ev
+        = internal::get_ptd ()->forced_log_ev;
+    ev.setLoggingEvent (&logger.getName (), log_level, msg, filename, line,
+        func);
+    logger.forcedLog (ev);
+}
+
+
+void
+macro_forced_log (log4cplus::LoggerRef const & logger,
+    log4cplus::LogLevel log_level, spi::DeferredMessagePtr msg,
+    char const * filename, int line, char const * func)
+{
+    log4cplus::spi::InternalLoggingEvent & ev
+        = internal::get_ptd ()->forced_log_ev;
+    ev.setLoggingEvent (&logger.getName (), log_level, tstring_view (),
+        filename, line, func);
+    ev.setDeferredMessage (std::move (msg));
+    logger.forcedLog (ev);
+}
+
+
+spi::InternalLoggingEvent &
+macro_kv_event (log4cplus::LoggerRef const & logger,
     log4cplus::LogLevel log_level, log4cplus::tstring_view const & msg,
     char const * filename, int line, char const * func)
 {
     log4cplus::spi::InternalLoggingEvent & ev
         = internal::get_ptd ()->forced_log_ev;
-    ev.setLoggingEvent (logger.getName (), log_level, msg, filename, line,
+    ev.setLoggingEvent (&logger.getName (), log_level, msg, filename, line,
         func);
+    return ev;
+}
+
+
+void
+trace_scope_exit (LoggerRef const & logger, TraceScopeSite const & site,
+    std::chrono::steady_clock::time_point start)
+{
+    auto const duration = std::chrono::steady_clock::now () - start;
+    spi::InternalLoggingEvent & ev = macro_kv_event (logger,
+        TRACE_LOG_LEVEL, site.msg, site.location.file_name (),
+        site.location.line (), site.location.function_name ());
+    ev.getKeyValues ().addInt (LOG4CPLUS_TEXT ("duration_ns"),
+        std::chrono::duration_cast<std::chrono::nanoseconds> (
+            duration).count ());
     logger.forcedLog (ev);
 }
 
 
+void
+named_logger_cache::retire (entry const * e)
+{
+    // Logging calls that have loaded the entry before it was replaced
+    // may still use its logger, so it is kept until exit.
+    static std::mutex mtx;
+    static std::vector<std::unique_ptr<entry const>> retired;
+
+    std::lock_guard<std::mutex> guard (mtx);
+    retired.emplace_back (e);
+}
+
+
+Logger const &
+named_logger_cache::refresh (tchar const * name)
+{
+    Hierarchy & h = getDefaultHierarchy ();
+    unsigned const generation
+        = h.levelGeneration.load (std::memory_order_acquire);
+    Logger logger = h.getInstance (name);
+
+    // Loggers are the same object when their names are; they differ
+    // only when the hierarchy has been cleared since.
+    entry const * e = current.load (std::memory_order_acquire);
+    if (! e || &e->logger.getName () != &logger.getName ())
+    {
+        entry const * fresh = new entry {logger, &h.levelGeneration};
+        if (current.compare_exchange_strong (e, fresh,
+                std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            if (e)
+                retire (e);
+            e = fresh;
+        }
+        else
+            delete fresh;
+    }
+
+    LogLevel const threshold = e->logger.getEnabledThreshold ();
+    state.store ((static_cast<std::uint64_t>(generation) << 32)
+        | static_cast<std::uint32_t>(threshold), std::memory_order_relaxed);
+    return e->logger;
+}
+
+
+log4cplus::tstring &
+get_macro_body_str ()
+{
+    tstring & str = internal::get_ptd ()->macros_str;
+    internal::clear_thread_buffer (str);
+    return str;
+}
+
+
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 CATCH_TEST_CASE ("Macros", "[macros]")
 {
@@ -112,6 +255,377 @@ CATCH_TEST_CASE ("Macros", "[macros]")
         CATCH_REQUIRE_THAT (loc.file_name (), Catch::Matchers::Equals (file));
         CATCH_REQUIRE (loc.line () == line);
     }
+
+    CATCH_SECTION ("deferred message")
+    {
+        struct TestMessage
+            : spi::DeferredMessage
+        {
+            void
+            format (tstring & message) const override
+            {
+                ++calls;
+                message += LOG4CPLUS_TEXT ("deferred");
+            }
+
+            mutable int calls = 0;
+        };
+
+        auto msg = std::make_shared<TestMessage> ();
+        spi::InternalLoggingEvent ev (LOG4CPLUS_TEXT ("logger"),
+            INFO_LOG_LEVEL, tstring_view (), nullptr, -1, nullptr);
+        ev.setDeferredMessage (msg);
+
+        // Copies share the unformatted message.
+        spi::InternalLoggingEvent copy (ev);
+        CATCH_REQUIRE (msg->calls == 0);
+        CATCH_REQUIRE (copy.getMessage () == LOG4CPLUS_TEXT ("deferred"));
+        CATCH_REQUIRE (copy.getMessage () == LOG4CPLUS_TEXT ("deferred"));
+        CATCH_REQUIRE (msg->calls == 1);
+        CATCH_REQUIRE (ev.getMessage () == LOG4CPLUS_TEXT ("deferred"));
+        CATCH_REQUIRE (msg->calls == 2);
+
+        // Setting new event data drops the deferred message.
+        ev.setDeferredMessage (msg);
+        ev.setLoggingEvent (LOG4CPLUS_TEXT ("logger"), INFO_LOG_LEVEL,
+            LOG4CPLUS_TEXT ("plain"), nullptr, -1, nullptr);
+        CATCH_REQUIRE (ev.getMessage () == LOG4CPLUS_TEXT ("plain"));
+        CATCH_REQUIRE (msg->calls == 2);
+    }
+
+    CATCH_SECTION ("compile time floor")
+    {
+        constexpr LogLevel log4cplus_compile_time_min_level
+            = WARN_LOG_LEVEL;
+        Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("macros.floor"));
+        logger.addAppender (SharedAppenderPtr (new NullAppender));
+        logger.setLogLevel (TRACE_LOG_LEVEL);
+
+        // Arguments of compiled out statements are not evaluated.
+        int evaluated = 0;
+        LOG4CPLUS_INFO (logger, ++evaluated);
+        LOG4CPLUS_DEBUG_FMT (logger, LOG4CPLUS_TEXT ("%d"), ++evaluated);
+        CATCH_REQUIRE (evaluated == 0);
+
+        LOG4CPLUS_WARN (logger, ++evaluated);
+        CATCH_REQUIRE (evaluated == 1);
+
+        logger.removeAllAppenders ();
+        logger.setLogLevel (NOT_SET_LOG_LEVEL);
+    }
+
+    CATCH_SECTION ("logger named by string literal")
+    {
+        Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("macros.named"));
+        SharedAppenderPtr appender (new NullAppender);
+        appender->setMetricsEnabled (true);
+        logger.addAppender (appender);
+        logger.setAdditivity (false);
+        logger.setLogLevel (INFO_LOG_LEVEL);
+
+        CATCH_REQUIRE (std::is_base_of_v<named_logger_cache,
+            macro_logger_cache<decltype ((LOG4CPLUS_TEXT ("name")))>>);
+
+        // One call site so that its cache is reused.
+        auto const log = [] {
+            LOG4CPLUS_INFO (LOG4CPLUS_TEXT ("macros.named"),
+                LOG4CPLUS_TEXT ("message"));
+        };
+
+        log ();
+        log ();
+        CATCH_REQUIRE (appender->getMetrics ().events == 2);
+
+        logger.setLogLevel (WARN_LOG_LEVEL);
+        log ();
+        CATCH_REQUIRE (appender->getMetrics ().events == 2);
+
+        logger.setLogLevel (INFO_LOG_LEVEL);
+        logger.getHierarchy ().disableInfo ();
+        log ();
+        CATCH_REQUIRE (appender->getMetrics ().events == 2);
+
+        logger.getHierarchy ().enableAll ();
+        log ();
+        CATCH_REQUIRE (appender->getMetrics ().events == 3);
+
+        logger.removeAllAppenders ();
+        logger.setAdditivity (true);
+        logger.setLogLevel (NOT_SET_LOG_LEVEL);
+    }
+
+    CATCH_SECTION ("shedding at cached call site")
+    {
+        Logger logger = Logger::getInstance (
+            LOG4CPLUS_TEXT ("macros.shedding"));
+        SharedAppenderPtr appender (new NullAppender);
+        appender->setMetricsEnabled (true);
+        logger.addAppender (appender);
+        logger.setAdditivity (false);
+        logger.setLogLevel (DEBUG_LOG_LEVEL);
+        Hierarchy & h = logger.getHierarchy ();
+
+        named_logger_cache cache;
+        auto const log = [&] {
+            LoggerRef const l = cache.get_logger (
+                LOG4CPLUS_TEXT ("macros.shedding"));
+            if (cache.is_enabled_for (l, DEBUG_LOG_LEVEL))
+                l.forcedLog (DEBUG_LOG_LEVEL, LOG4CPLUS_TEXT ("message"));
+        };
+
+        log ();
+        CATCH_REQUIRE (cache.threshold () == DEBUG_LOG_LEVEL);
+        CATCH_REQUIRE (appender->getMetrics ().events == 1);
+
+        // The cached threshold alone rejects shed events.
+        h.setSheddingThreshold (INFO_LOG_LEVEL);
+        log ();
+        CATCH_REQUIRE (cache.threshold () == INFO_LOG_LEVEL);
+        CATCH_REQUIRE (cache.threshold () == logger.getEnabledThreshold ());
+        CATCH_REQUIRE (appender->getMetrics ().events == 1);
+
+        h.setSheddingThreshold (NOT_SET_LOG_LEVEL);
+        log ();
+        CATCH_REQUIRE (cache.threshold () == DEBUG_LOG_LEVEL);
+        CATCH_REQUIRE (appender->getMetrics ().events == 2);
+
+        logger.removeAllAppenders ();
+        logger.setAdditivity (true);
+        logger.setLogLevel (NOT_SET_LOG_LEVEL);
+    }
+
+    CATCH_SECTION ("non-owning logger handle")
+    {
+        Logger const logger
+            = Logger::getInstance (LOG4CPLUS_TEXT ("macros.ref"));
+        SharedAppenderPtr appender (new NullAppender);
+        appender->setMetricsEnabled (true);
+        Logger (logger).addAppender (appender);
+
+        // Loggers given by lvalues are not copied by the macros.
+        CATCH_REQUIRE (std::is_same_v<LoggerRef,
+            decltype (macros_get_logger (logger))>);
+
+        LoggerRef const ref = logger.view ();
+        CATCH_REQUIRE (ref);
+        CATCH_REQUIRE (ref == LoggerRef (logger));
+        CATCH_REQUIRE (&ref.getName () == &logger.getName ());
+        CATCH_REQUIRE (&ref.lock ().getName () == &logger.getName ());
+        CATCH_REQUIRE (! LoggerRef ());
+
+        LOG4CPLUS_INFO (ref, LOG4CPLUS_TEXT ("message"));
+        LOG4CPLUS_INFO (logger, LOG4CPLUS_TEXT ("message"));
+        CATCH_REQUIRE (appender->getMetrics ().events == 2);
+
+        Logger (logger).removeAllAppenders ();
+    }
+
+    CATCH_SECTION ("key/value fields")
+    {
+        struct TestAppender
+            : Appender
+        {
+            ~TestAppender () { destructorImpl (); }
+
+            void close () override { }
+
+            tstring output;
+
+        protected:
+            void append (spi::InternalLoggingEvent const & ev) override
+            {
+                layout->formatAndAppend (output, ev);
+            }
+        };
+
+        Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("macros.kv"));
+        helpers::SharedObjectPtr<TestAppender> appender (new TestAppender);
+        appender->setLayout (std::make_unique<PatternLayout> (
+            LOG4CPLUS_TEXT ("%m user=%K{user} %K%n")));
+        logger.addAppender (SharedAppenderPtr (appender.get ()));
+        logger.setAdditivity (false);
+        logger.setLogLevel (INFO_LOG_LEVEL);
+
+        tstring const name (LOG4CPLUS_TEXT ("alice"));
+        LOG4CPLUS_INFO_KV (logger, LOG4CPLUS_TEXT ("done"),
+            LOG4CPLUS_TEXT ("user"), 42, LOG4CPLUS_TEXT ("latency_us"), 12.5,
+            LOG4CPLUS_TEXT ("name"), name);
+        LOG4CPLUS_WARN_KV (logger, LOG4CPLUS_TEXT ("no fields"));
+
+        // Arguments of disabled statements are not evaluated.
+        int evaluated = 0;
+        LOG4CPLUS_DEBUG_KV (logger, LOG4CPLUS_TEXT ("off"),
+            LOG4CPLUS_TEXT ("n"), ++evaluated);
+        CATCH_REQUIRE (evaluated == 0);
+
+        CATCH_REQUIRE (appender->output == LOG4CPLUS_TEXT (
+                "done user=42 {user, 42}{latency_us, 12.5}{name, alice}\n"
+                "no fields user= \n"));
+
+        logger.removeAllAppenders ();
+        logger.setAdditivity (true);
+        logger.setLogLevel (NOT_SET_LOG_LEVEL);
+    }
+
+#if defined (LOG4CPLUS_HAVE_FORMAT)
+    CATCH_SECTION ("format macros")
+    {
+        struct TestAppender
+            : Appender
+        {
+            ~TestAppender () { destructorImpl (); }
+
+            void close () override { }
+
+            bool isAsynchronous () const override { return async; }
+
+            bool async = false;
+            std::vector<spi::InternalLoggingEvent> events;
+
+        protected:
+            void append (spi::InternalLoggingEvent const & ev) override
+            {
+                events.push_back (ev);
+            }
+        };
+
+        Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("macros.format"));
+        helpers::SharedObjectPtr<TestAppender> appender (new TestAppender);
+        logger.addAppender (SharedAppenderPtr (appender.get ()));
+        logger.setAdditivity (false);
+        logger.setLogLevel (INFO_LOG_LEVEL);
+
+        tstring name (LOG4CPLUS_TEXT ("alice"));
+        LOG4CPLUS_INFO_FORMAT (logger, LOG4CPLUS_TEXT ("{} is {}"), name, 42);
+
+        // Arguments are copied when formatting is deferred.
+        appender->async = true;
+        LOG4CPLUS_WARN_FORMAT (logger, LOG4CPLUS_TEXT ("{}: {:.1f}"), name,
+            2.25);
+        name = LOG4CPLUS_TEXT ("bob");
+
+        int evaluated = 0;
+        LOG4CPLUS_DEBUG_FORMAT (logger, LOG4CPLUS_TEXT ("{}"), ++evaluated);
+        CATCH_REQUIRE (evaluated == 0);
+
+        CATCH_REQUIRE (appender->events.size () == 2);
+        CATCH_REQUIRE (appender->events[0].getMessage ()
+            == LOG4CPLUS_TEXT ("alice is 42"));
+        CATCH_REQUIRE (appender->events[1].getMessage ()
+            == LOG4CPLUS_TEXT ("alice: 2.2"));
+
+        logger.removeAllAppenders ();
+        logger.setAdditivity (true);
+        logger.setLogLevel (NOT_SET_LOG_LEVEL);
+    }
+#endif
+
+    CATCH_SECTION ("trace scope")
+    {
+        Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("macros.scope"));
+        SharedAppenderPtr appender (new NullAppender);
+        appender->setMetricsEnabled (true);
+        logger.addAppender (appender);
+        logger.setAdditivity (false);
+
+        logger.setLogLevel (DEBUG_LOG_LEVEL);
+        {
+            LOG4CPLUS_TRACE_SCOPE (logger, LOG4CPLUS_TEXT ("disabled"));
+        }
+        CATCH_REQUIRE (appender->getMetrics ().events == 0);
+
+        // One event on exit, carrying the duration.
+        logger.setLogLevel (TRACE_LOG_LEVEL);
+        {
+            LOG4CPLUS_TRACE_SCOPE (logger, LOG4CPLUS_TEXT ("enabled"));
+            CATCH_REQUIRE (appender->getMetrics ().events == 0);
+        }
+        CATCH_REQUIRE (appender->getMetrics ().events == 1);
+        spi::InternalLoggingEvent const & ev
+            = internal::get_ptd ()->forced_log_ev;
+        CATCH_REQUIRE (ev.getMessage () == LOG4CPLUS_TEXT ("enabled"));
+        spi::KeyValue kv;
+        CATCH_REQUIRE (ev.getKeyValues ().find (
+                LOG4CPLUS_TEXT ("duration_ns"), kv));
+        CATCH_REQUIRE (kv.type == spi::KV_INT);
+        CATCH_REQUIRE (kv.i >= 0);
+
+        logger.removeAllAppenders ();
+        logger.setAdditivity (true);
+        logger.setLogLevel (NOT_SET_LOG_LEVEL);
+    }
+
+    CATCH_SECTION ("buffer stream")
+    {
+        helpers::buffer_ostream oss;
+        CATCH_REQUIRE (oss.view ().empty ());
+
+        // Growing keeps contents written so far.
+        tstring const big (5000, LOG4CPLUS_TEXT ('x'));
+        oss << LOG4CPLUS_TEXT ("a") << 42 << big << LOG4CPLUS_TEXT ('z');
+        CATCH_REQUIRE (oss.view ()
+            == LOG4CPLUS_TEXT ("a42") + big + LOG4CPLUS_TEXT ("z"));
+        CATCH_REQUIRE (oss.str () == oss.view ());
+
+        std::size_t const capacity = oss.rdbuf ()->capacity ();
+        oss.rdbuf ()->clear ();
+        CATCH_REQUIRE (oss.view ().empty ());
+        CATCH_REQUIRE (oss.rdbuf ()->capacity () == capacity);
+
+        oss.rdbuf ()->reserve (2 * capacity);
+        CATCH_REQUIRE (oss.rdbuf ()->capacity () >= 2 * capacity);
+
+        oss.rdbuf ()->clear (capacity);
+        CATCH_REQUIRE (oss.rdbuf ()->capacity () == 0);
+        oss << 7;
+        CATCH_REQUIRE (oss.view () == LOG4CPLUS_TEXT ("7"));
+    }
+
+    CATCH_SECTION ("per thread buffer capacity limit")
+    {
+        setThreadBufferCapacityLimit (4000);
+        helpers::buffer_ostream & oss = get_macro_body_stream ();
+
+        // Capacity under the limit is kept for the next message.
+        oss << tstring (1000, LOG4CPLUS_TEXT ('x'));
+        tchar const * const data = oss.view ().data ();
+        get_macro_body_stream ();
+        CATCH_REQUIRE (oss.view ().empty ());
+        CATCH_REQUIRE (oss.rdbuf ()->capacity () >= 1000);
+        oss << tstring (1000, LOG4CPLUS_TEXT ('y'));
+        CATCH_REQUIRE (oss.view ().data () == data);
+
+        // Oversized buffer is released.
+        oss << tstring (8000, LOG4CPLUS_TEXT ('x'));
+        get_macro_body_stream ();
+        CATCH_REQUIRE (oss.view ().empty ());
+        CATCH_REQUIRE (oss.rdbuf ()->capacity () <= 4000);
+
+        tstring buf (8000, LOG4CPLUS_TEXT ('x'));
+        internal::clear_thread_buffer (buf);
+        CATCH_REQUIRE (buf.empty ());
+        CATCH_REQUIRE (buf.capacity () <= 4000);
+
+        // Zero disables the limit.
+        setThreadBufferCapacityLimit (0);
+        buf.assign (8000, LOG4CPLUS_TEXT ('x'));
+        internal::clear_thread_buffer (buf);
+        CATCH_REQUIRE (buf.capacity () >= 8000);
+
+        setThreadBufferCapacityLimit (1024 * 1024);
+    }
+
+    CATCH_SECTION ("string stream of earlier headers")
+    {
+        tostringstream & oss = get_macro_body_oss ();
+        oss << std::hex << 255;
+        CATCH_REQUIRE (oss.str () == LOG4CPLUS_TEXT ("ff"));
+
+        CATCH_REQUIRE (&get_macro_body_oss () == &oss);
+        CATCH_REQUIRE (oss.str ().empty ());
+        oss << 255;
+        CATCH_REQUIRE (oss.str () == LOG4CPLUS_TEXT ("255"));
+    }
 } // CATCH_TEST_CASE
 
 #endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
@@ -153,6 +153,7 @@ protected:
 //////////////////////////////////////////////////////////////////////////////
 
 LogLevelManager::LogLevelManager()
+    : generation (0)
 {
     pushLogLevelTranslator (SharedLogLevelTranslatorPtr (new DefaultLogLevelTranslator ()));
 }
@@ -234,6 +235,14 @@ LogLevelManager::pushLogLevelTranslator(SharedLogLevelTranslatorPtr translator)
 #endif
 
     translator_list.push_back (std::move (translator));
+    invalidateCaches ();
+}
+
+
+void
+LogLevelManager::invalidateCaches()
+{
+    generation.fetch_add (1, std::memory_order_acq_rel);
 }
 
 
@@ -20,14 +20,34 @@
 
 #include <log4cplus/streams.h>
 #include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
 #include <log4cplus/thread/threads.h>
 #include <log4cplus/internal/env.h>
 #include <log4cplus/consoleappender.h>
 #include <log4cplus/exception.h>
+#include <chrono>
 #include <ostream>
 #include <stdexcept>
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <thread>
+#include <vector>
+#endif
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+namespace log4cplus {
+
+// from global-init.cxx
+void enqueueAsyncTask (std::function<void ()> task);
+
+} // namespace log4cplus
+
+#endif
+
 
 namespace log4cplus::helpers {
 
@@ -41,6 +61,73 @@ static tchar const ERR_PREFIX[] = LOG4CPLUS_TEXT("log4cplus:ERROR ");
 } // namespace
 
 
+//! State of rate limiting and deduplication of warnings and errors. It
+//! is read and updated without locks; races can at worst let a repeat
+//! through or miscount a suppressed message.
+struct LogLog::Limiter
+{
+    //! Messages are deduplicated through a small table indexed by their
+    //! hashes; a message evicted by a colliding one is simply output
+    //! again.
+    static std::size_t const slot_count = 64;
+
+    struct Slot
+    {
+        std::atomic<std::size_t> hash {0};
+        std::atomic<std::int64_t> last_ms {0};
+        std::atomic<std::uint32_t> repeats {0};
+    };
+
+    std::atomic<unsigned> per_second {0};
+    std::atomic<unsigned> dedup_ms {0};
+
+    std::atomic<std::int64_t> second {0};
+    std::atomic<unsigned> in_second {0};
+    //! Messages suppressed by the rate limit since last output.
+    std::atomic<std::uint64_t> rate_limited_pending {0};
+
+    std::atomic<std::uint64_t> emitted {0};
+    std::atomic<std::uint64_t> deduplicated {0};
+    std::atomic<std::uint64_t> rate_limited {0};
+    std::atomic<std::uint64_t> dropped {0};
+
+    Slot slots[slot_count];
+};
+
+
+//! Lock free multiple producer queue of messages for
+//! LogLog::setAsyncSink(). Messages are pushed on a stack, which is
+//! reversed by the draining thread.
+struct LogLog::AsyncSink
+{
+    static unsigned const capacity = 1024;
+
+    struct Node
+    {
+        tstring text;
+        Node * next;
+    };
+
+    ~AsyncSink ()
+    {
+        for (Node * node = head.load (); node; )
+        {
+            Node * const next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    std::atomic<bool> active {false};
+    std::atomic<Node *> head {nullptr};
+    std::atomic<unsigned> queued {0};
+    std::atomic<bool> draining {false};
+
+    //! Guarded by LogLog::mutex.
+    std::function<void (tstring const &)> sink;
+};
+
+
 LogLog *
 LogLog::getLogLog()
 {
@@ -51,6 +138,8 @@ LogLog::getLogLog()
 LogLog::LogLog()
     : debugEnabled(TriUndef)
     , quietMode(TriUndef)
+    , limiter (new Limiter)
+    , asyncSink (new AsyncSink)
 { }
 
 
@@ -60,8 +149,6 @@ LogLog::~LogLog() = default;
 void
 LogLog::setInternalDebugging(bool enabled)
 {
-    thread::MutexGuard guard (mutex);
-
     debugEnabled = enabled ? TriTrue : TriFalse;
 }
 
@@ -69,8 +156,6 @@ LogLog::setInternalDebugging(bool enabled)
 void
 LogLog::setQuietMode(bool quietModeVal)
 {
-    thread::MutexGuard guard (mutex);
-
     quietMode = quietModeVal ? TriTrue : TriFalse;
 }
 
@@ -119,14 +204,58 @@ LogLog::error(tchar const * msg, bool throw_flag) const
 }
 
 
+void
+LogLog::setRateLimit(unsigned messagesPerSecond, unsigned dedupWindowMs)
+{
+    limiter->per_second.store (messagesPerSecond, std::memory_order_relaxed);
+    limiter->dedup_ms.store (dedupWindowMs, std::memory_order_relaxed);
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+void
+LogLog::setAsyncSink(std::function<void (tstring const &)> sink)
+{
+    bool const active = !! sink;
+    {
+        thread::MutexGuard guard (mutex);
+        asyncSink->sink = std::move (sink);
+        asyncSink->active.store (active, std::memory_order_release);
+    }
+
+    // Queued messages go to the new sink, or to std::cerr.
+    drain_async_sink ();
+}
+
+#endif
+
+
+LogLogStats
+LogLog::getStats() const
+{
+    LogLogStats stats;
+    stats.emitted = limiter->emitted.load (std::memory_order_relaxed);
+    stats.deduplicated = limiter->deduplicated.load (
+        std::memory_order_relaxed);
+    stats.rateLimited = limiter->rate_limited.load (
+        std::memory_order_relaxed);
+    stats.dropped = limiter->dropped.load (std::memory_order_relaxed);
+    return stats;
+}
+
+
 bool
 LogLog::get_quiet_mode () const
 {
-    if (LOG4CPLUS_UNLIKELY (quietMode == TriUndef))
-        set_tristate_from_env (&quietMode,
+    TriState value = quietMode.load (std::memory_order_relaxed);
+    if (LOG4CPLUS_UNLIKELY (value == TriUndef))
+    {
+        value = get_tristate_from_env (
             LOG4CPLUS_TEXT ("LOG4CPLUS_LOGLOG_QUIETMODE"));
+        quietMode.store (value, std::memory_order_relaxed);
+    }
 
-    return quietMode == TriTrue;
+    return value == TriTrue;
 }
 
 
@@ -140,24 +269,227 @@ LogLog::get_not_quiet_mode () const
 bool
 LogLog::get_debug_mode () const
 {
-    if (LOG4CPLUS_UNLIKELY (debugEnabled == TriUndef))
-        set_tristate_from_env (&debugEnabled,
+    TriState value = debugEnabled.load (std::memory_order_relaxed);
+    if (LOG4CPLUS_UNLIKELY (value == TriUndef))
+    {
+        value = get_tristate_from_env (
             LOG4CPLUS_TEXT ("LOG4CPLUS_LOGLOG_DEBUGENABLED"));
+        debugEnabled.store (value, std::memory_order_relaxed);
+    }
 
-    return debugEnabled && ! get_quiet_mode ();
+    return value == TriTrue && ! get_quiet_mode ();
 }
 
 
-void
-LogLog::set_tristate_from_env (TriState * result, tchar const * envvar_name)
+LogLog::TriState
+LogLog::get_tristate_from_env (tchar const * envvar_name)
 {
     tstring envvar_value;
     bool exists = internal::get_env_var (envvar_value, envvar_name);
     bool value = false;
     if (exists && internal::parse_bool (value, envvar_value) && value)
-        *result = TriTrue;
+        return TriTrue;
     else
-        *result = TriFalse;
+        return TriFalse;
+}
+
+
+//! Decides whether message <code>text</code> is output and appends
+//! numbers of messages suppressed before it.
+bool
+LogLog::admit (tstring & text) const
+{
+    Limiter & lim = *limiter;
+    unsigned const per_second = lim.per_second.load (
+        std::memory_order_relaxed);
+    unsigned const dedup_ms = lim.dedup_ms.load (std::memory_order_relaxed);
+    if (LOG4CPLUS_LIKELY (per_second == 0 && dedup_ms == 0))
+        return true;
+
+    std::int64_t const now_ms
+        = std::chrono::duration_cast<std::chrono::milliseconds> (
+            std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+
+    Limiter::Slot * slot = nullptr;
+    std::size_t hash = 0;
+    if (dedup_ms != 0)
+    {
+        hash = std::hash<tstring> () (text);
+        slot = &lim.slots[hash % Limiter::slot_count];
+        if (slot->hash.load (std::memory_order_relaxed) == hash
+            && now_ms - slot->last_ms.load (std::memory_order_relaxed)
+                < static_cast<std::int64_t> (dedup_ms))
+        {
+            slot->repeats.fetch_add (1, std::memory_order_relaxed);
+            lim.deduplicated.fetch_add (1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    std::uint64_t rate_limited = 0;
+    if (per_second != 0)
+    {
+        std::int64_t const second = now_ms / 1000;
+        std::int64_t current = lim.second.load (std::memory_order_relaxed);
+        if (current != second
+            && lim.second.compare_exchange_strong (current, second,
+                std::memory_order_relaxed))
+            lim.in_second.store (0, std::memory_order_relaxed);
+
+        if (lim.in_second.fetch_add (1, std::memory_order_relaxed)
+            >= per_second)
+        {
+            lim.rate_limited.fetch_add (1, std::memory_order_relaxed);
+            lim.rate_limited_pending.fetch_add (1,
+                std::memory_order_relaxed);
+            return false;
+        }
+
+        rate_limited = lim.rate_limited_pending.exchange (0,
+            std::memory_order_relaxed);
+    }
+
+    std::uint32_t repeats = 0;
+    if (slot)
+    {
+        std::uint32_t const pending = slot->repeats.exchange (0,
+            std::memory_order_relaxed);
+        if (slot->hash.exchange (hash, std::memory_order_relaxed) == hash)
+            repeats = pending;
+        slot->last_ms.store (now_ms, std::memory_order_relaxed);
+    }
+
+    if (repeats != 0)
+    {
+        text += LOG4CPLUS_TEXT (" [repeated ");
+        text += convertIntegerToString (repeats);
+        text += LOG4CPLUS_TEXT (" more times]");
+    }
+
+    if (rate_limited != 0)
+    {
+        text += LOG4CPLUS_TEXT (" [");
+        text += convertIntegerToString (rate_limited);
+        text += LOG4CPLUS_TEXT (" messages suppressed by rate limit]");
+    }
+
+    return true;
+}
+
+
+void
+LogLog::emit (tostream & os, tstring const & text) const
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    AsyncSink & as = *asyncSink;
+    if (as.active.load (std::memory_order_acquire))
+    {
+        if (as.queued.fetch_add (1, std::memory_order_relaxed)
+            >= AsyncSink::capacity)
+        {
+            as.queued.fetch_sub (1, std::memory_order_relaxed);
+            limiter->dropped.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+
+        limiter->emitted.fetch_add (1, std::memory_order_relaxed);
+
+        AsyncSink::Node * const node = new AsyncSink::Node {text, nullptr};
+        AsyncSink::Node * old = as.head.load (std::memory_order_relaxed);
+        do
+            node->next = old;
+        while (! as.head.compare_exchange_weak (old, node,
+                std::memory_order_release, std::memory_order_relaxed));
+
+        // Only the push onto an empty queue schedules draining.
+        if (old)
+            return;
+
+#if defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+        try
+        {
+            enqueueAsyncTask ([this] { drain_async_sink (); });
+            return;
+        }
+        catch (std::exception const &)
+        {
+            // The thread pool is gone, drain synchronously.
+        }
+#endif
+
+        drain_async_sink ();
+        return;
+    }
+#endif
+
+    limiter->emitted.fetch_add (1, std::memory_order_relaxed);
+
+    // XXX This is potential recursive lock of
+    // ConsoleAppender::outputMutex.
+    thread::MutexGuard outputGuard (ConsoleAppender::getOutputMutex ());
+    os << text << std::endl;
+}
+
+
+void
+LogLog::drain_async_sink () const
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    AsyncSink & as = *asyncSink;
+    for (;;)
+    {
+        // A drain already running, possibly further up this thread's
+        // stack when the sink itself reports an error, picks up the
+        // queued messages.
+        if (as.draining.exchange (true, std::memory_order_acquire))
+            return;
+
+        std::function<void (tstring const &)> sink;
+        {
+            thread::MutexGuard guard (mutex);
+            sink = as.sink;
+        }
+
+        AsyncSink::Node * node = as.head.exchange (nullptr,
+            std::memory_order_acquire);
+        AsyncSink::Node * reversed = nullptr;
+        while (node)
+        {
+            AsyncSink::Node * const next = node->next;
+            node->next = reversed;
+            reversed = node;
+            node = next;
+        }
+
+        while (reversed)
+        {
+            AsyncSink::Node * const next = reversed->next;
+            as.queued.fetch_sub (1, std::memory_order_relaxed);
+            if (sink)
+            {
+                try
+                {
+                    sink (reversed->text);
+                }
+                catch (...)
+                { }
+            }
+            else
+            {
+                thread::MutexGuard outputGuard (
+                    ConsoleAppender::getOutputMutex ());
+                tcerr << reversed->text << std::endl;
+            }
+
+            delete reversed;
+            reversed = next;
+        }
+
+        as.draining.store (false, std::memory_order_release);
+        if (! as.head.load (std::memory_order_acquire))
+            return;
+    }
+#endif
 }
 
 
@@ -166,23 +498,98 @@ void
 LogLog::logging_worker (tostream & os, bool (LogLog:: * cond) () const,
     tchar const * prefix, StringType const & msg, bool throw_flag) const
 {
-    bool output;
+    if (LOG4CPLUS_UNLIKELY ((this->*cond) ()))
     {
-        thread::MutexGuard guard (mutex);
-        output = (this->*cond) ();
+        tstring text (prefix);
+        text += msg;
+
+        // Only warnings and errors, which go to std::cerr, are limited;
+        // debugging output is enabled explicitly.
+        if (&os == &tcerr)
+        {
+            if (admit (text))
+                emit (os, text);
+        }
+        else
+        {
+            thread::MutexGuard outputGuard (
+                ConsoleAppender::getOutputMutex ());
+            os << text << std::endl;
+        }
     }
 
-    if (LOG4CPLUS_UNLIKELY (output))
+    if (LOG4CPLUS_UNLIKELY (throw_flag))
+        throw log4cplus::exception (msg);
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) \
+    && ! defined (LOG4CPLUS_SINGLE_THREADED)
+CATCH_TEST_CASE ("LogLog rate limit", "[loglog]")
+{
+    LogLog & loglog = getLogLog ();
+    loglog.setQuietMode (false);
+
+    thread::Mutex received_mutex;
+    std::vector<tstring> received;
+    loglog.setAsyncSink (
+        [&] (tstring const & text) {
+            thread::MutexGuard guard (received_mutex);
+            received.push_back (text);
+        });
+
+    LogLogStats const before = loglog.getStats ();
+
+    CATCH_SECTION ("repeats are deduplicated")
     {
-        // XXX This is potential recursive lock of
-        // ConsoleAppender::outputMutex.
-        thread::MutexGuard outputGuard (ConsoleAppender::getOutputMutex ());
-        os << prefix << msg << std::endl;
+        loglog.setRateLimit (0, 60 * 1000);
+        for (int i = 0; i != 5; ++i)
+            loglog.error (LOG4CPLUS_TEXT ("dedup test"));
+        loglog.warn (LOG4CPLUS_TEXT ("dedup test other"));
+
+        LogLogStats const after = loglog.getStats ();
+        CATCH_REQUIRE (after.emitted - before.emitted == 2);
+        CATCH_REQUIRE (after.deduplicated - before.deduplicated == 4);
     }
 
-    if (LOG4CPLUS_UNLIKELY (throw_flag))
-        throw log4cplus::exception (msg);
+    CATCH_SECTION ("messages are limited per second")
+    {
+        loglog.setRateLimit (3, 0);
+        for (int i = 0; i != 10; ++i)
+            loglog.warn (LOG4CPLUS_TEXT ("rate test ")
+                + convertIntegerToString (i));
+
+        // The loop can cross a second boundary at most once.
+        LogLogStats const after = loglog.getStats ();
+        CATCH_REQUIRE (after.emitted - before.emitted
+            + after.rateLimited - before.rateLimited == 10);
+        CATCH_REQUIRE (after.emitted - before.emitted <= 6);
+    }
+
+    loglog.setRateLimit (0, 0);
+
+    std::size_t const expected
+        = static_cast<std::size_t> (loglog.getStats ().emitted
+            - before.emitted);
+    for (int i = 0; i != 1000; ++i)
+    {
+        {
+            thread::MutexGuard guard (received_mutex);
+            if (received.size () >= expected)
+                break;
+        }
+        std::this_thread::sleep_for (std::chrono::milliseconds (10));
+    }
+
+    loglog.setAsyncSink ({});
+
+    thread::MutexGuard guard (received_mutex);
+    CATCH_REQUIRE (received.size () == expected);
+    CATCH_REQUIRE (received.front ().find (LOG4CPLUS_TEXT ("log4cplus:"))
+        == 0);
 }
 
+#endif
+
 
 } // namespace log4cplus::helpers
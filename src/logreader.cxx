@@ -0,0 +1,560 @@
+// Module:  Log4cplus
+// File:    logreader.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_SYS_TYPES_H)
+#include <sys/types.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_SYS_STAT_H)
+#include <sys/stat.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_FCNTL_H)
+#include <fcntl.h>
+#endif
+#if ! defined (_WIN32)
+#include <sys/mman.h>
+#endif
+#include <log4cplus/config/windowsh-inc.h>
+
+#include <log4cplus/logreader.h>
+#include <log4cplus/fstreams.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <log4cplus/fileappender.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <cstdio>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+std::int64_t
+to_microseconds (helpers::Time const & time)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds> (
+        time.time_since_epoch ()).count ();
+}
+
+
+[[noreturn]]
+void
+throw_open_failure (tstring const & name)
+{
+    throw std::runtime_error ("Unable to open file: "
+        + LOG4CPLUS_TSTRING_TO_STRING (name));
+}
+
+
+//! Parses <code>count</code> digits at <code>pos</code>.
+bool
+parse_digits (std::string_view line, std::size_t & pos, std::size_t count,
+    int & value)
+{
+    if (line.size () - pos < count)
+        return false;
+
+    value = 0;
+    for (std::size_t const end = pos + count; pos != end; ++pos)
+    {
+        unsigned const digit = static_cast<unsigned char> (line[pos]) - '0';
+        if (digit > 9)
+            return false;
+        value = value * 10 + static_cast<int> (digit);
+    }
+
+    return true;
+}
+
+
+//! Parses time stamps at starts of lines, see LogMerger. Local time is
+//! converted to UTC once per hour of time stamps; lines of a file
+//! mostly share the hour of their predecessors.
+class time_stamp_parser
+{
+public:
+    explicit time_stamp_parser (std::string_view format_)
+        : format (format_)
+        , hourKey (-1)
+        , hourStart (0)
+    { }
+
+    //! \returns <code>false</code> if <code>line</code> does not start
+    //! with a time stamp.
+    bool
+    parse (std::string_view line, std::int64_t & micros)
+    {
+        // Year, month, day, hour, minute, second.
+        int fields[6] = {1970, 1, 1, 0, 0, 0};
+        int millis = 0;
+        int usecs = 0;
+        std::size_t pos = 0;
+        for (std::size_t i = 0; i != format.size (); ++i)
+        {
+            char const ch = format[i];
+            if (ch == '%' && i + 1 != format.size ())
+            {
+                bool ok;
+                switch (format[++i])
+                {
+                case 'Y': ok = parse_digits (line, pos, 4, fields[0]); break;
+                case 'm': ok = parse_digits (line, pos, 2, fields[1]); break;
+                case 'd': ok = parse_digits (line, pos, 2, fields[2]); break;
+                case 'H': ok = parse_digits (line, pos, 2, fields[3]); break;
+                case 'M': ok = parse_digits (line, pos, 2, fields[4]); break;
+                case 'S': ok = parse_digits (line, pos, 2, fields[5]); break;
+                case 'q': ok = parse_digits (line, pos, 3, millis); break;
+
+                case 'Q':
+                    ok = parse_digits (line, pos, 3, millis)
+                        && pos != line.size () && line[pos++] == '.'
+                        && parse_digits (line, pos, 3, usecs);
+                    break;
+
+                default:
+                    ok = pos != line.size () && line[pos++] == '%';
+                }
+
+                if (! ok)
+                    return false;
+            }
+            else if (pos == line.size () || line[pos++] != ch)
+                return false;
+        }
+
+        long long const key = ((fields[0] * 16LL + fields[1]) * 32
+            + fields[2]) * 32 + fields[3];
+        if (key != hourKey)
+        {
+            std::tm t = std::tm ();
+            t.tm_year = fields[0] - 1900;
+            t.tm_mon = fields[1] - 1;
+            t.tm_mday = fields[2];
+            t.tm_hour = fields[3];
+            t.tm_isdst = -1;
+            hourStart = to_microseconds (helpers::from_struct_tm (&t));
+            hourKey = key;
+        }
+
+        micros = hourStart + (fields[4] * 60LL + fields[5]) * 1000000
+            + millis * 1000LL + usecs;
+        return true;
+    }
+
+private:
+    std::string_view format;
+    long long hourKey;
+    std::int64_t hourStart;
+};
+
+} // namespace
+
+
+IndexedLogReader::IndexedLogReader (tstring const & name)
+    : data (nullptr)
+    , size (0)
+{
+#if defined (_WIN32)
+    HANDLE const handle = CreateFile (name.c_str (), GENERIC_READ,
+        FILE_SHARE_DELETE | FILE_SHARE_WRITE | FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        throw_open_failure (name);
+
+    LARGE_INTEGER file_size;
+    if (! GetFileSizeEx (handle, &file_size))
+    {
+        CloseHandle (handle);
+        throw_open_failure (name);
+    }
+
+    size = static_cast<std::size_t> (file_size.QuadPart);
+    if (size != 0)
+    {
+        // The view keeps the mapping alive after the handles are
+        // closed.
+        HANDLE const mapping = CreateFileMapping (handle, nullptr,
+            PAGE_READONLY, 0, 0, nullptr);
+        if (mapping)
+        {
+            data = static_cast<char const *> (
+                MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, size));
+            CloseHandle (mapping);
+        }
+    }
+    CloseHandle (handle);
+
+#else
+    int flags = O_RDONLY
+#if defined (O_CLOEXEC)
+        | O_CLOEXEC
+#endif
+        ;
+    int const fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (name).c_str (),
+        flags);
+    if (fd == -1)
+        throw_open_failure (name);
+
+    struct stat st;
+    if (::fstat (fd, &st) != 0)
+    {
+        ::close (fd);
+        throw_open_failure (name);
+    }
+
+    size = static_cast<std::size_t> (st.st_size);
+    if (size != 0)
+    {
+        void * ptr = ::mmap (nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (ptr != MAP_FAILED)
+            data = static_cast<char const *> (ptr);
+    }
+    ::close (fd);
+
+#endif
+
+    if (size != 0 && ! data)
+        throw std::runtime_error ("Unable to map file: "
+            + LOG4CPLUS_TSTRING_TO_STRING (name));
+
+    tstring const index_name = name + LOG4CPLUS_TEXT (".idx");
+    std::ifstream in (
+        LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (index_name).c_str (),
+        std::ios_base::binary);
+    unsigned char buf[16];
+    while (in.read (reinterpret_cast<char *> (buf), sizeof (buf)))
+    {
+        std::uint64_t fields[2] = {0, 0};
+        for (std::size_t i = 0; i != sizeof (buf); ++i)
+            fields[i / 8] |= std::uint64_t (buf[i]) << (i % 8 * 8);
+
+        // Entries can outlive the file contents they point to, e.g.,
+        // when the file has been truncated by another process.
+        if (fields[1] >= size
+            || (! index.empty () && fields[1] < index.back ().offset))
+            continue;
+
+        index.push_back (
+            Entry {static_cast<std::int64_t> (fields[0]), fields[1]});
+    }
+}
+
+
+IndexedLogReader::~IndexedLogReader ()
+{
+    if (! data)
+        return;
+
+#if defined (_WIN32)
+    UnmapViewOfFile (data);
+#else
+    ::munmap (const_cast<char *> (data), size);
+#endif
+}
+
+
+std::size_t
+IndexedLogReader::seek (helpers::Time const & since) const
+{
+    // The range starts with the last entry before the first entry at
+    // or after since; events in between are not indexed and may be
+    // newer.
+    std::int64_t const t = to_microseconds (since);
+    auto it = std::partition_point (index.begin (), index.end (),
+        [t] (Entry const & entry) { return entry.time < t; });
+    if (it == index.begin ())
+        return 0;
+
+    return static_cast<std::size_t> ((it - 1)->offset);
+}
+
+
+std::size_t
+IndexedLogReader::seekEnd (helpers::Time const & until) const
+{
+    std::int64_t const t = to_microseconds (until);
+    auto it = std::partition_point (index.begin (), index.end (),
+        [t] (Entry const & entry) { return entry.time <= t; });
+    if (it == index.end ())
+        return size;
+
+    return static_cast<std::size_t> (it->offset);
+}
+
+
+struct LogMerger::Source
+{
+    explicit Source (tstring const & name)
+        : reader (name)
+    { }
+
+    IndexedLogReader reader;
+
+    //! Time stamps and offsets of events, ordered by offsets.
+    std::vector<IndexedLogReader::Entry> events;
+};
+
+
+LogMerger::LogMerger (tstring const & dateFormat_)
+    : dateFormat (LOG4CPLUS_TSTRING_TO_STRING (dateFormat_))
+{
+    for (std::size_t i = 0; i != dateFormat.size (); ++i)
+        if (dateFormat[i] == '%'
+            && (++i == dateFormat.size ()
+                || std::string_view ("YmdHMSqQ%").find (dateFormat[i])
+                    == std::string_view::npos))
+            throw std::runtime_error ("Unsupported date format: "
+                + dateFormat);
+}
+
+
+LogMerger::~LogMerger ()
+{ }
+
+
+void
+LogMerger::addFile (tstring const & name)
+{
+    auto source = std::make_unique<Source> (name);
+    std::string_view const contents = source->reader.contents ();
+    std::vector<IndexedLogReader::Entry> & events = source->events;
+    events = source->reader.getIndex ();
+    if (events.empty () && ! contents.empty ())
+    {
+        if (dateFormat.empty ())
+            throw std::runtime_error ("File has no index: "
+                + LOG4CPLUS_TSTRING_TO_STRING (name));
+
+        time_stamp_parser parser (dateFormat);
+        for (std::size_t pos = 0; pos != contents.size (); )
+        {
+            std::int64_t time;
+            if (parser.parse (contents.substr (pos), time))
+                events.push_back (IndexedLogReader::Entry {time, pos});
+
+            std::size_t const eol = contents.find ('\n', pos);
+            pos = eol == std::string_view::npos ? contents.size () : eol + 1;
+        }
+
+        if (events.empty ())
+            throw std::runtime_error ("No time stamps found in file: "
+                + LOG4CPLUS_TSTRING_TO_STRING (name));
+    }
+
+    // Events written before the index was started and lines before the
+    // first time stamp are attributed to time of the first event.
+    if (! events.empty () && events.front ().offset != 0)
+        events.insert (events.begin (),
+            IndexedLogReader::Entry {events.front ().time, 0});
+
+    sources.push_back (std::move (source));
+}
+
+
+void
+LogMerger::merge (std::function<void (std::string_view)> const & sink) const
+{
+    // Next event of each source; equal times keep order of sources.
+    using item = std::pair<std::int64_t, std::size_t>;
+    std::priority_queue<item, std::vector<item>, std::greater<item>> queue;
+    std::vector<std::size_t> next (sources.size (), 0);
+    for (std::size_t s = 0; s != sources.size (); ++s)
+        if (! sources[s]->events.empty ())
+            queue.emplace (sources[s]->events.front ().time, s);
+
+    while (! queue.empty ())
+    {
+        std::size_t const s = queue.top ().second;
+        queue.pop ();
+
+        // Take all events of the source that precede the next event of
+        // any other source; they are contiguous in the file.
+        Source const & source = *sources[s];
+        std::vector<IndexedLogReader::Entry> const & events = source.events;
+        std::size_t const first = next[s];
+        std::size_t last = first + 1;
+        if (queue.empty ())
+            last = events.size ();
+        else
+            while (last != events.size ()
+                && item (events[last].time, s) < queue.top ())
+                ++last;
+
+        std::string_view const contents = source.reader.contents ();
+        std::size_t const begin = static_cast<std::size_t> (
+            events[first].offset);
+        std::size_t const end = last != events.size ()
+            ? static_cast<std::size_t> (events[last].offset)
+            : contents.size ();
+        sink (contents.substr (begin, end - begin));
+
+        next[s] = last;
+        if (last != events.size ())
+            queue.emplace (events[last].time, s);
+    }
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("IndexedLogReader", "[appender]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-reader-test.log"));
+    tstring const index_name = file_name + LOG4CPLUS_TEXT (".idx");
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (file_name).c_str ());
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (index_name).c_str ());
+
+    helpers::Time const start = helpers::now ();
+    auto const at = [&] (int second)
+    { return start + std::chrono::seconds (second); };
+    long const line_size = 4 + 8; // "INFO - " prefix and EOL
+
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("File"), file_name);
+        props.setProperty (LOG4CPLUS_TEXT ("Index"),
+            LOG4CPLUS_TEXT ("true"));
+        props.setProperty (LOG4CPLUS_TEXT ("IndexEvery"),
+            LOG4CPLUS_TEXT ("10"));
+        RollingFileAppender appender (props);
+        for (int i = 0; i != 100; ++i)
+        {
+            spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+                INFO_LOG_LEVEL, tstring_view (), MappedDiagnosticContextMap (),
+                LOG4CPLUS_TEXT ("1234"), tstring_view (), tstring_view (),
+                at (i), LOG4CPLUS_TEXT (__FILE__), __LINE__);
+            appender.doAppend (ev);
+        }
+        appender.close ();
+    }
+
+    {
+        IndexedLogReader reader (file_name);
+        CATCH_REQUIRE (reader.contents ().size () == 100 * line_size);
+
+        // Entries for the first event and each tenth one after it.
+        std::vector<IndexedLogReader::Entry> const & index
+            = reader.getIndex ();
+        CATCH_REQUIRE (index.size () == 10);
+        for (std::size_t i = 0; i != index.size (); ++i)
+            CATCH_REQUIRE (index[i].offset == i * 10 * line_size);
+
+        CATCH_REQUIRE (reader.seek (at (0)) == 0);
+        CATCH_REQUIRE (reader.seek (at (10)) == 0);
+        CATCH_REQUIRE (reader.seek (at (15)) == 10 * line_size);
+        CATCH_REQUIRE (reader.seek (at (1000)) == 90 * line_size);
+        CATCH_REQUIRE (reader.seekEnd (at (-1)) == 0);
+        CATCH_REQUIRE (reader.seekEnd (at (15)) == 20 * line_size);
+        CATCH_REQUIRE (reader.seekEnd (at (95)) == 100 * line_size);
+    }
+
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (file_name).c_str ());
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (index_name).c_str ());
+}
+
+
+CATCH_TEST_CASE ("LogMerger", "[appender]")
+{
+    tstring const names[2] = {LOG4CPLUS_TEXT ("log4cplus-merge-test.1.log"),
+        LOG4CPLUS_TEXT ("log4cplus-merge-test.2.log")};
+    auto const write_file = [] (tstring const & name, std::string const & data)
+    {
+        std::ofstream out (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (name)
+            .c_str (), std::ios_base::binary);
+        out << data;
+    };
+    write_file (names[0],
+        "header\n"
+        "[2026-10-15 10:59:59.000.100] a1\n"
+        "[2026-10-15 11:00:00.000.000] a2\n"
+        "  continued\n"
+        "[2026-10-15 11:00:00.500.000] a3\n"
+        "[2026-10-15 11:00:01.000.000] a4\n");
+    write_file (names[1],
+        "[2026-10-15 10:59:59.000.050] b1\n"
+        "[2026-10-15 11:00:00.000.000] b2\n"
+        "[2026-10-15 11:00:02.000.000] b3");
+
+    std::vector<std::string> parts;
+    auto const sink = [&] (std::string_view part)
+    { parts.emplace_back (part); };
+
+    CATCH_SECTION ("time stamps")
+    {
+        LogMerger merger (LOG4CPLUS_TEXT ("[%Y-%m-%d %H:%M:%S.%Q]"));
+        merger.addFile (names[0]);
+        merger.addFile (names[1]);
+        merger.merge (sink);
+        CATCH_REQUIRE (parts == std::vector<std::string> {
+                "[2026-10-15 10:59:59.000.050] b1\n",
+                "header\n"
+                "[2026-10-15 10:59:59.000.100] a1\n"
+                "[2026-10-15 11:00:00.000.000] a2\n"
+                "  continued\n",
+                "[2026-10-15 11:00:00.000.000] b2\n",
+                "[2026-10-15 11:00:00.500.000] a3\n"
+                "[2026-10-15 11:00:01.000.000] a4\n",
+                "[2026-10-15 11:00:02.000.000] b3"});
+    }
+
+    CATCH_SECTION ("errors")
+    {
+        CATCH_REQUIRE_THROWS_AS (LogMerger (LOG4CPLUS_TEXT ("%Y %j")),
+            std::runtime_error);
+        CATCH_REQUIRE_THROWS_AS (LogMerger ().addFile (names[0]),
+            std::runtime_error);
+        CATCH_REQUIRE_THROWS_AS (
+            LogMerger (LOG4CPLUS_TEXT ("%H:%M")).addFile (names[0]),
+            std::runtime_error);
+    }
+
+    for (tstring const & name : names)
+        std::remove (LOG4CPLUS_TSTRING_TO_STRING (name).c_str ());
+}
+#endif
+
+
+} // namespace log4cplus
@@ -0,0 +1,458 @@
+// Module:  Log4cplus
+// File:    mappedringfileappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_SYS_TYPES_H)
+#include <sys/types.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_SYS_STAT_H)
+#include <sys/stat.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_FCNTL_H)
+#include <fcntl.h>
+#endif
+#if ! defined (_WIN32)
+#include <sys/mman.h>
+#endif
+#include <log4cplus/config/windowsh-inc.h>
+
+#include <log4cplus/mappedringfileappender.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/internal/env.h>
+#include <log4cplus/internal/internal.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <cstdio>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+//! Layout of the header at the start of the ring file. Records follow
+//! the header.
+struct ring_header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t header_size;
+    std::uint64_t capacity;
+
+    //! Total number of bytes ever written into the ring. The write
+    //! position is <code>head % capacity</code>.
+    std::uint64_t head;
+};
+
+
+char const ring_magic[8] = {'L', '4', 'C', 'P', 'R', 'I', 'N', 'G'};
+std::uint32_t const ring_version = 1;
+std::size_t const ring_header_size = 64;
+std::size_t const minimum_ring_size = 4 * 1024;
+
+static_assert (sizeof (ring_header) <= ring_header_size);
+
+
+bool
+is_valid_header (ring_header const & hdr, std::uint64_t capacity)
+{
+    return std::memcmp (hdr.magic, ring_magic, sizeof (ring_magic)) == 0
+        && hdr.version == ring_version
+        && hdr.header_size == ring_header_size
+        && hdr.capacity == capacity;
+}
+
+
+#if defined (_WIN32)
+HANDLE const invalid_handle = INVALID_HANDLE_VALUE;
+#endif
+
+} // namespace
+
+
+MappedRingFileAppender::MappedRingFileAppender (tstring const & filename_,
+    std::size_t fileSize_, bool createDirs_)
+    : filename (filename_)
+    , fileSize (fileSize_)
+    , createDirs (createDirs_)
+{
+    init ();
+}
+
+
+MappedRingFileAppender::MappedRingFileAppender (
+    helpers::Properties const & props)
+    : Appender (props)
+    , fileSize (10 * 1024 * 1024)
+    , createDirs (false)
+{
+    filename = props.getProperty (LOG4CPLUS_TEXT ("File"));
+    props.getBool (createDirs, LOG4CPLUS_TEXT ("CreateDirs"));
+
+    tstring tmp (
+        helpers::toUpper (
+            props.getProperty (LOG4CPLUS_TEXT ("FileSize"))));
+    if (! tmp.empty ())
+    {
+        std::size_t size = std::strtoul (
+            LOG4CPLUS_TSTRING_TO_STRING (tmp).c_str (), nullptr, 10);
+        tstring::size_type const len = tmp.length ();
+        if (len > 2
+            && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT ("MB")) == 0)
+            size *= (1024 * 1024); // convert to megabytes
+        else if (len > 2
+            && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT ("KB")) == 0)
+            size *= 1024; // convert to kilobytes
+        fileSize = size;
+    }
+
+    init ();
+}
+
+
+MappedRingFileAppender::~MappedRingFileAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+MappedRingFileAppender::init ()
+{
+    mapping = nullptr;
+#if defined (_WIN32)
+    handle = invalid_handle;
+    mappingHandle = nullptr;
+#else
+    fd = -1;
+#endif
+
+    if (fileSize < minimum_ring_size)
+    {
+        tostringstream oss;
+        oss << LOG4CPLUS_TEXT ("MappedRingFileAppender: FileSize property")
+            LOG4CPLUS_TEXT (" value is too small. Resetting to ")
+            << minimum_ring_size << ".";
+        helpers::getLogLog ().warn (oss.str ());
+        fileSize = minimum_ring_size;
+    }
+
+    open ();
+}
+
+
+void
+MappedRingFileAppender::close ()
+{
+    thread::MutexGuard guard (access_mutex);
+
+#if defined (_WIN32)
+    if (mapping)
+        UnmapViewOfFile (mapping);
+    if (mappingHandle)
+        CloseHandle (mappingHandle);
+    if (handle != invalid_handle)
+        CloseHandle (handle);
+    handle = invalid_handle;
+    mappingHandle = nullptr;
+
+#else
+    if (mapping)
+        ::munmap (mapping, fileSize);
+    if (fd != -1)
+        ::close (fd);
+    fd = -1;
+
+#endif
+
+    mapping = nullptr;
+    closed = true;
+}
+
+
+void
+MappedRingFileAppender::open ()
+{
+    if (createDirs)
+        internal::make_dirs (filename);
+
+    std::uint64_t const capacity = fileSize - ring_header_size;
+    bool existing = false;
+
+#if defined (_WIN32)
+    handle = CreateFile (filename.c_str (), GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_DELETE | FILE_SHARE_WRITE | FILE_SHARE_READ, nullptr,
+        OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == invalid_handle)
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to open file: ") + filename);
+        return;
+    }
+
+    LARGE_INTEGER size;
+    existing = GetFileSizeEx (handle, &size)
+        && static_cast<std::uint64_t> (size.QuadPart) == fileSize;
+
+    ULARGE_INTEGER mapping_size;
+    mapping_size.QuadPart = fileSize;
+    mappingHandle = CreateFileMapping (handle, nullptr, PAGE_READWRITE,
+        mapping_size.HighPart, mapping_size.LowPart, nullptr);
+    if (mappingHandle)
+        mapping = static_cast<char *> (
+            MapViewOfFile (mappingHandle, FILE_MAP_WRITE, 0, 0, 0));
+
+#else
+    int flags = O_RDWR | O_CREAT
+#if defined (O_CLOEXEC)
+        | O_CLOEXEC
+#endif
+        ;
+    mode_t const mode = (S_IRWXU ^ S_IXUSR)
+        | (S_IRWXG ^ S_IXGRP)
+        | (S_IRWXO ^ S_IXOTH);
+
+    fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (filename).c_str (), flags,
+        mode);
+    if (fd == -1)
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to open file: ") + filename);
+        return;
+    }
+
+    struct stat st;
+    existing = ::fstat (fd, &st) == 0
+        && static_cast<std::uint64_t> (st.st_size) == fileSize;
+
+    if (existing || ::ftruncate (fd, static_cast<off_t> (fileSize)) == 0)
+    {
+        void * ptr = ::mmap (nullptr, fileSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+        if (ptr != MAP_FAILED)
+            mapping = static_cast<char *> (ptr);
+    }
+
+#endif
+
+    if (! mapping)
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to map file: ") + filename);
+        return;
+    }
+
+    auto & hdr = *reinterpret_cast<ring_header *> (mapping);
+    if (existing && is_valid_header (hdr, capacity))
+    {
+        helpers::getLogLog ().debug (
+            LOG4CPLUS_TEXT ("Reopened ring file: ") + filename);
+        return;
+    }
+
+    std::memset (mapping, 0, ring_header_size);
+    std::memcpy (hdr.magic, ring_magic, sizeof (ring_magic));
+    hdr.version = ring_version;
+    hdr.header_size = ring_header_size;
+    hdr.capacity = capacity;
+    std::atomic_ref<std::uint64_t> (hdr.head).store (0,
+        std::memory_order_release);
+
+    helpers::getLogLog ().debug (
+        LOG4CPLUS_TEXT ("Just opened ring file: ") + filename);
+}
+
+
+// This method does not need to be locked since it is called by
+// doAppend() which performs the locking
+void
+MappedRingFileAppender::append (spi::InternalLoggingEvent const & event)
+{
+    if (! mapping)
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("file is not mapped: ") + filename);
+        return;
+    }
+
+    record.clear ();
+    internal::append_utf8 (record, formatEvent (event));
+
+    auto & hdr = *reinterpret_cast<ring_header *> (mapping);
+    char * const data = mapping + ring_header_size;
+    std::size_t const capacity = fileSize - ring_header_size;
+    std::atomic_ref<std::uint64_t> head (hdr.head);
+    std::uint64_t const old_head = head.load (std::memory_order_relaxed);
+
+    // Only the tail of a record larger than the whole ring survives.
+    char const * src = record.data ();
+    std::size_t size = record.size ();
+    std::uint64_t const new_head = old_head + size;
+    if (size > capacity)
+    {
+        src += size - capacity;
+        size = capacity;
+    }
+
+    std::size_t const pos
+        = static_cast<std::size_t> ((new_head - size) % capacity);
+    std::size_t const first = (std::min) (size, capacity - pos);
+    std::memcpy (data + pos, src, first);
+    std::memcpy (data, src + first, size - first);
+
+    // Publish the record only after it has been completely copied.
+    head.store (new_head, std::memory_order_release);
+}
+
+
+bool
+MappedRingFileAppender::readContents (tstring const & filename,
+    std::string & contents)
+{
+    contents.clear ();
+
+    std::ifstream in (LOG4CPLUS_TSTRING_TO_STRING (filename).c_str (),
+        std::ios_base::binary);
+    ring_header hdr;
+    if (! in.read (reinterpret_cast<char *> (&hdr), sizeof (hdr)))
+        return false;
+
+    if (std::memcmp (hdr.magic, ring_magic, sizeof (ring_magic)) != 0
+        || hdr.version != ring_version
+        || hdr.header_size != ring_header_size
+        || hdr.capacity == 0)
+        return false;
+
+    std::string data (static_cast<std::size_t> (hdr.capacity), '\0');
+    in.seekg (ring_header_size);
+    if (! in.read (&data[0], static_cast<std::streamsize> (data.size ())))
+        return false;
+
+    if (hdr.head <= hdr.capacity)
+    {
+        contents.assign (data, 0, static_cast<std::size_t> (hdr.head));
+        return true;
+    }
+
+    // The ring has wrapped. The oldest byte is at the write position.
+    // Drop the partially overwritten record.
+    std::size_t const pos
+        = static_cast<std::size_t> (hdr.head % hdr.capacity);
+    contents.reserve (data.size ());
+    contents.append (data, pos, std::string::npos);
+    contents.append (data, 0, pos);
+
+    std::string::size_type const eol = contents.find ('\n');
+    contents.erase (0,
+        eol == std::string::npos ? contents.size () : eol + 1);
+
+    return true;
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("MappedRingFileAppender", "[appender]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-ring-test.log"));
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (file_name).c_str ());
+
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+        INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"), __FILE__, __LINE__,
+        nullptr);
+    std::string const line ("INFO - message\n");
+    std::string contents;
+
+    CATCH_SECTION ("records are visible without flush")
+    {
+        MappedRingFileAppender appender (file_name, minimum_ring_size);
+        appender.doAppend (ev);
+        appender.doAppend (ev);
+        CATCH_REQUIRE (
+            MappedRingFileAppender::readContents (file_name, contents));
+        CATCH_REQUIRE (contents == line + line);
+        appender.close ();
+    }
+
+    CATCH_SECTION ("reopening continues")
+    {
+        {
+            MappedRingFileAppender appender (file_name, minimum_ring_size);
+            appender.doAppend (ev);
+        }
+        MappedRingFileAppender appender (file_name, minimum_ring_size);
+        appender.doAppend (ev);
+        appender.close ();
+        CATCH_REQUIRE (
+            MappedRingFileAppender::readContents (file_name, contents));
+        CATCH_REQUIRE (contents == line + line);
+    }
+
+    CATCH_SECTION ("wrapping drops oldest records")
+    {
+        std::size_t const capacity = minimum_ring_size - ring_header_size;
+        std::size_t const count = capacity / line.size () * 3 + 1;
+
+        MappedRingFileAppender appender (file_name, minimum_ring_size);
+        for (std::size_t i = 0; i != count; ++i)
+            appender.doAppend (ev);
+        appender.close ();
+
+        CATCH_REQUIRE (
+            MappedRingFileAppender::readContents (file_name, contents));
+        CATCH_REQUIRE (! contents.empty ());
+        CATCH_REQUIRE (contents.size () <= capacity);
+        CATCH_REQUIRE (contents.size () > capacity - 2 * line.size ());
+        CATCH_REQUIRE (contents.size () % line.size () == 0);
+        for (std::size_t i = 0; i != contents.size (); i += line.size ())
+            CATCH_REQUIRE (contents.compare (i, line.size (), line) == 0);
+    }
+
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (file_name).c_str ());
+}
+
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+} // namespace log4cplus
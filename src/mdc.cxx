@@ -23,6 +23,9 @@
 
 #include <log4cplus/mdc.h>
 #include <log4cplus/internal/internal.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <atomic>
 
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 #include <catch.hpp>
@@ -32,6 +35,169 @@
 namespace log4cplus
 {
 
+namespace internal
+{
+
+MappedDiagnosticContextMap const empty_mdc;
+
+} // namespace internal
+
+
+namespace
+{
+
+//! Keys registered with MDC::registerKey(); threads keep copies of
+//! them in per_thread_data::mdc_keys.
+struct mdc_key_registry
+{
+    thread::Mutex mutex;
+    std::vector<tstring> keys;
+    std::atomic<std::size_t> count {0};
+};
+
+
+mdc_key_registry &
+get_mdc_key_registry ()
+{
+    static mdc_key_registry registry;
+    return registry;
+}
+
+
+std::size_t const no_index = static_cast<std::size_t>(-1);
+
+
+//! \return Registered keys, brought up to date.
+std::vector<tstring> const &
+sync_mdc_keys (internal::per_thread_data & ptd)
+{
+    mdc_key_registry & registry = get_mdc_key_registry ();
+    if (ptd.mdc_keys.size ()
+        != registry.count.load (std::memory_order_acquire))
+    {
+        thread::MutexGuard guard (registry.mutex);
+        ptd.mdc_keys.assign (registry.keys.begin (), registry.keys.end ());
+    }
+
+    return ptd.mdc_keys;
+}
+
+
+std::size_t
+find_mdc_key (std::vector<tstring> const & keys, tstring const & key)
+{
+    auto it = std::find (keys.begin (), keys.end (), key);
+    return it != keys.end ()
+        ? static_cast<std::size_t>(it - keys.begin ())
+        : no_index;
+}
+
+
+//! \return Context that can be modified without affecting snapshots
+//! held by events, with values of all <code>keys</code> indexed.
+MappedDiagnosticContext &
+writable_mdc (std::shared_ptr<MappedDiagnosticContext> & dc,
+    std::vector<tstring> const & keys)
+{
+    if (! dc)
+        dc = std::make_shared<MappedDiagnosticContext> ();
+    else if (dc.use_count () != 1)
+    {
+        // References are added only by copying existing ones, held by
+        // this thread's events or by DiagnosticContextHandle copies, the
+        // count cannot grow from one behind our back.
+        auto copy = std::make_shared<MappedDiagnosticContext> ();
+        copy->map = dc->map;
+        dc = std::move (copy);
+    }
+    else if (dc->values.size () == keys.size ())
+        return *dc;
+
+    // Values point into the map, index them again after copying it and
+    // index keys registered since.
+    dc->values.resize (keys.size ());
+    for (std::size_t i = 0; i != keys.size (); ++i)
+    {
+        auto it = dc->map.find (keys[i]);
+        dc->values[i] = it != dc->map.end () ? &it->second : nullptr;
+    }
+
+    return *dc;
+}
+
+
+void
+put_mdc (internal::per_thread_data & ptd, tstring const & key,
+    std::size_t index, tstring const & value)
+{
+    std::shared_ptr<MappedDiagnosticContext> & dc = ptd.mdc_map;
+    std::vector<tstring> const & keys = ptd.mdc_keys;
+    if (dc)
+    {
+        // Setting the same value again does not need a new snapshot.
+        tstring const * current = nullptr;
+        if (index != no_index && index < dc->values.size ())
+            current = dc->values[index];
+        else
+        {
+            auto it = dc->map.find (key);
+            if (it != dc->map.end ())
+                current = &it->second;
+        }
+
+        if (current && *current == value)
+            return;
+    }
+
+    MappedDiagnosticContext & ctx = writable_mdc (dc, keys);
+    auto const it = ctx.map.insert_or_assign (key, value).first;
+    if (index != no_index)
+        ctx.values[index] = &it->second;
+}
+
+} // namespace
+
+
+MappedDiagnosticContext::MappedDiagnosticContext () = default;
+
+
+MappedDiagnosticContext::MappedDiagnosticContext (
+    MappedDiagnosticContextMap map_)
+    : map (std::move (map_))
+{
+    mdc_key_registry & registry = get_mdc_key_registry ();
+    thread::MutexGuard guard (registry.mutex);
+    values.reserve (registry.keys.size ());
+    for (tstring const & key : registry.keys)
+    {
+        auto it = map.find (key);
+        values.push_back (it != map.end () ? &it->second : nullptr);
+    }
+}
+
+
+tstring const *
+MappedDiagnosticContext::get (MDCKey key) const
+{
+    std::size_t const index = static_cast<std::size_t>(key);
+    if (index < values.size ())
+        return values[index];
+
+    // The key was registered after this context was last changed.
+    tstring name;
+    {
+        mdc_key_registry & registry = get_mdc_key_registry ();
+        thread::MutexGuard guard (registry.mutex);
+        if (index >= registry.keys.size ())
+            return nullptr;
+
+        name = registry.keys[index];
+    }
+
+    auto it = map.find (name);
+    return it != map.end () ? &it->second : nullptr;
+}
+
 
 MDC::MDC () = default;
 
@@ -39,7 +205,7 @@ MDC::MDC () = default;
 MDC::~MDC () = default;
 
 
-MappedDiagnosticContextMap *
+std::shared_ptr<MappedDiagnosticContext> *
 MDC::getPtr ()
 {
     return &internal::get_ptd ()->mdc_map;
@@ -49,16 +215,15 @@ MDC::getPtr ()
 void
 MDC::clear()
 {
-    MappedDiagnosticContextMap * const dc = getPtr ();
-    MappedDiagnosticContextMap ().swap (*dc);
+    getPtr ()->reset ();
 }
 
 
 void
 MDC::put (tstring const & key, tstring const & value)
 {
-    MappedDiagnosticContextMap * const dc = getPtr ();
-    (*dc)[key] = value;
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    put_mdc (*ptd, key, find_mdc_key (sync_mdc_keys (*ptd), key), value);
 }
 
 
@@ -67,9 +232,9 @@ MDC::get (tstring * value, tstring const & key) const
 {
     assert (value);
 
-    MappedDiagnosticContextMap * const dc = getPtr ();
-    auto it = dc->find (key);
-    if (it != dc->end ())
+    MappedDiagnosticContextMap const & dc = getContext ();
+    auto it = dc.find (key);
+    if (it != dc.end ())
     {
         *value = it->second;
         return true;
@@ -82,13 +247,73 @@ MDC::get (tstring * value, tstring const & key) const
 void
 MDC::remove (tstring const & key)
 {
-    MappedDiagnosticContextMap * const dc = getPtr ();
-    dc->erase (key);
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    std::shared_ptr<MappedDiagnosticContext> & dc = ptd->mdc_map;
+    if (! dc || dc->map.find (key) == dc->map.end ())
+        return;
+
+    std::vector<tstring> const & keys = sync_mdc_keys (*ptd);
+    MappedDiagnosticContext & ctx = writable_mdc (dc, keys);
+    ctx.map.erase (key);
+    std::size_t const index = find_mdc_key (keys, key);
+    if (index != no_index)
+        ctx.values[index] = nullptr;
+}
+
+
+MDCKey
+MDC::registerKey (tstring const & key)
+{
+    mdc_key_registry & registry = get_mdc_key_registry ();
+    thread::MutexGuard guard (registry.mutex);
+    std::size_t index = find_mdc_key (registry.keys, key);
+    if (index == no_index)
+    {
+        index = registry.keys.size ();
+        registry.keys.push_back (key);
+        registry.count.store (registry.keys.size (),
+            std::memory_order_release);
+    }
+
+    return static_cast<MDCKey>(index);
+}
+
+
+void
+MDC::put (MDCKey key, tstring const & value)
+{
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    std::vector<tstring> const & keys = sync_mdc_keys (*ptd);
+    std::size_t const index = static_cast<std::size_t>(key);
+    if (index < keys.size ())
+        put_mdc (*ptd, keys[index], index, value);
+}
+
+
+bool
+MDC::get (tstring * value, MDCKey key) const
+{
+    assert (value);
+
+    std::shared_ptr<MappedDiagnosticContext> const & dc = *getPtr ();
+    tstring const * const found = dc ? dc->get (key) : nullptr;
+    if (found)
+        *value = *found;
+
+    return !! found;
 }
 
 
 MappedDiagnosticContextMap const &
 MDC::getContext () const
+{
+    std::shared_ptr<MappedDiagnosticContext> const & dc = *getPtr ();
+    return dc ? dc->map : internal::empty_mdc;
+}
+
+
+MappedDiagnosticContextPtr
+MDC::getSnapshot () const
 {
     return *getPtr ();
 }
@@ -125,6 +350,58 @@ CATCH_TEST_CASE ("MDC", "[MDC]")
         CATCH_REQUIRE (! mdc.get (&str, LOG4CPLUS_TEXT ("key1")));
         CATCH_REQUIRE (! mdc.get (&str, LOG4CPLUS_TEXT ("key2")));
     }
+
+    CATCH_SECTION ("snapshots are not affected by later changes")
+    {
+        MappedDiagnosticContextPtr const snapshot = mdc.getSnapshot ();
+        CATCH_REQUIRE (snapshot == mdc.getSnapshot ());
+
+        mdc.put (LOG4CPLUS_TEXT ("key1"), LOG4CPLUS_TEXT ("changed"));
+        mdc.remove (LOG4CPLUS_TEXT ("key2"));
+        CATCH_REQUIRE (snapshot != mdc.getSnapshot ());
+        CATCH_REQUIRE (snapshot->map.size () == 2);
+        CATCH_REQUIRE (snapshot->map.at (LOG4CPLUS_TEXT ("key1"))
+            == LOG4CPLUS_TEXT ("value1"));
+        CATCH_REQUIRE (mdc.get (&str, LOG4CPLUS_TEXT ("key1")));
+        CATCH_REQUIRE (str == LOG4CPLUS_TEXT ("changed"));
+        CATCH_REQUIRE (! mdc.get (&str, LOG4CPLUS_TEXT ("key2")));
+
+        // Events share the snapshot instead of copying it.
+        spi::InternalLoggingEvent event (LOG4CPLUS_TEXT ("logger"),
+            INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"), __FILE__, __LINE__);
+        spi::InternalLoggingEvent const copy (event);
+        CATCH_REQUIRE (&event.getMDCCopy () == &copy.getMDCCopy ());
+        CATCH_REQUIRE (&event.getMDCCopy () == &mdc.getContext ());
+    }
+
+    CATCH_SECTION ("registered keys")
+    {
+        MDCKey const key1 = MDC::registerKey (LOG4CPLUS_TEXT ("key1"));
+        MDCKey const key3 = MDC::registerKey (LOG4CPLUS_TEXT ("key3"));
+        CATCH_REQUIRE (MDC::registerKey (LOG4CPLUS_TEXT ("key1")) == key1);
+        CATCH_REQUIRE (key1 != key3);
+
+        // Values put before the registration are found too.
+        CATCH_REQUIRE (mdc.get (&str, key1));
+        CATCH_REQUIRE (str == LOG4CPLUS_TEXT ("value1"));
+        CATCH_REQUIRE (! mdc.get (&str, key3));
+
+        mdc.put (key3, LOG4CPLUS_TEXT ("value3"));
+        CATCH_REQUIRE (mdc.get (&str, LOG4CPLUS_TEXT ("key3")));
+        CATCH_REQUIRE (str == LOG4CPLUS_TEXT ("value3"));
+        MappedDiagnosticContextPtr const snapshot = mdc.getSnapshot ();
+        CATCH_REQUIRE (*snapshot->get (key3) == LOG4CPLUS_TEXT ("value3"));
+
+        mdc.put (LOG4CPLUS_TEXT ("key1"), LOG4CPLUS_TEXT ("changed"));
+        mdc.remove (LOG4CPLUS_TEXT ("key3"));
+        CATCH_REQUIRE (*snapshot->get (key1) == LOG4CPLUS_TEXT ("value1"));
+        CATCH_REQUIRE (*snapshot->get (key3) == LOG4CPLUS_TEXT ("value3"));
+        CATCH_REQUIRE (mdc.get (&str, key1));
+        CATCH_REQUIRE (str == LOG4CPLUS_TEXT ("changed"));
+        CATCH_REQUIRE (! mdc.get (&str, key3));
+    }
+
+    mdc.clear ();
 }
 
 #endif
@@ -0,0 +1,1055 @@
+// Module:  Log4cplus
+// File:    metrics.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/metrics.h>
+#include <log4cplus/asyncappender.h>
+#include <log4cplus/hierarchy.h>
+#include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
+#include <log4cplus/streams.h>
+#include <log4cplus/helpers/queue.h>
+#include <log4cplus/internal/internal.h>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <map>
+#include <set>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/nullappender.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <catch.hpp>
+#include <thread>
+#endif
+
+
+namespace log4cplus
+{
+
+
+//////////////////////////////////////////////////////////////////////////////
+// LatencyHistogram
+//////////////////////////////////////////////////////////////////////////////
+
+std::size_t
+LatencyHistogram::bucketIndex (std::uint64_t ns)
+{
+    std::size_t const sub_buckets = std::size_t (1) << sub_bucket_bits;
+    if (ns < sub_buckets)
+        return static_cast<std::size_t>(ns);
+
+    std::size_t const msb = static_cast<std::size_t>(std::bit_width (ns)) - 1;
+    if (msb >= max_bits)
+        return bucket_count - 1;
+
+    return ((msb - sub_bucket_bits + 1) << sub_bucket_bits)
+        + static_cast<std::size_t>(
+            (ns >> (msb - sub_bucket_bits)) & (sub_buckets - 1));
+}
+
+
+std::uint64_t
+LatencyHistogram::bucketLowerBound (std::size_t index)
+{
+    std::size_t const sub_buckets = std::size_t (1) << sub_bucket_bits;
+    if (index < sub_buckets)
+        return index;
+
+    std::size_t const exponent = index >> sub_bucket_bits;
+    std::uint64_t const mantissa = sub_buckets + (index & (sub_buckets - 1));
+    return mantissa << (exponent - 1);
+}
+
+
+std::uint64_t
+LatencyHistogram::quantile (double q) const
+{
+    if (count == 0)
+        return 0;
+
+    std::uint64_t const rank = (std::max) (std::uint64_t (1),
+        static_cast<std::uint64_t>(std::ceil (q * static_cast<double>(count))));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i != bucket_count - 1; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+            return (std::min) (bucketLowerBound (i + 1) - 1, maxNs);
+    }
+
+    return maxNs;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Prometheus export
+//////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+tstring
+escapeLabelValue (tstring const & value)
+{
+    tstring result;
+    for (tchar ch : value)
+    {
+        if (ch == LOG4CPLUS_TEXT ('\\') || ch == LOG4CPLUS_TEXT ('"'))
+            result += LOG4CPLUS_TEXT ('\\');
+        else if (ch == LOG4CPLUS_TEXT ('\n'))
+        {
+            result += LOG4CPLUS_TEXT ("\\n");
+            continue;
+        }
+
+        result += ch;
+    }
+    return result;
+}
+
+
+void
+formatCounter (tostream & out, std::vector<AppenderMetrics> const & metrics,
+    tchar const * family, std::uint64_t AppenderMetrics::* counter)
+{
+    out << LOG4CPLUS_TEXT ("# TYPE ") << family << LOG4CPLUS_TEXT (" counter\n");
+    for (AppenderMetrics const & m : metrics)
+        out << family << LOG4CPLUS_TEXT ("{appender=\"")
+            << escapeLabelValue (m.name) << LOG4CPLUS_TEXT ("\"} ")
+            << m.*counter << LOG4CPLUS_TEXT ('\n');
+}
+
+
+void
+formatHistogram (tostream & out, std::vector<AppenderMetrics> const & metrics,
+    tchar const * family, LatencyHistogram AppenderMetrics::* histogram)
+{
+    // Boundaries from about 1 us to about 1 min.
+    std::size_t const min_bits = 10;
+    std::size_t const max_bits = 36;
+
+    out << LOG4CPLUS_TEXT ("# TYPE ") << family
+        << LOG4CPLUS_TEXT (" histogram\n");
+    for (AppenderMetrics const & m : metrics)
+    {
+        LatencyHistogram const & hist = m.*histogram;
+        tstring const label = LOG4CPLUS_TEXT ("appender=\"")
+            + escapeLabelValue (m.name) + LOG4CPLUS_TEXT ("\"");
+
+        std::uint64_t cumulative = 0;
+        std::size_t index = 0;
+        for (std::size_t bits = min_bits; bits <= max_bits; ++bits)
+        {
+            std::uint64_t const bound = std::uint64_t (1) << bits;
+            for (; LatencyHistogram::bucketLowerBound (index) < bound;
+                 ++index)
+                cumulative += hist.buckets[index];
+
+            out << family << LOG4CPLUS_TEXT ("_bucket{") << label
+                << LOG4CPLUS_TEXT (",le=\"")
+                << static_cast<double>(bound) / 1e9
+                << LOG4CPLUS_TEXT ("\"} ") << cumulative
+                << LOG4CPLUS_TEXT ('\n');
+        }
+
+        out << family << LOG4CPLUS_TEXT ("_bucket{") << label
+            << LOG4CPLUS_TEXT (",le=\"+Inf\"} ") << hist.count
+            << LOG4CPLUS_TEXT ('\n')
+            << family << LOG4CPLUS_TEXT ("_sum{") << label
+            << LOG4CPLUS_TEXT ("} ")
+            << static_cast<double>(hist.sumNs) / 1e9 << LOG4CPLUS_TEXT ('\n')
+            << family << LOG4CPLUS_TEXT ("_count{") << label
+            << LOG4CPLUS_TEXT ("} ") << hist.count << LOG4CPLUS_TEXT ('\n');
+    }
+}
+
+} // namespace
+
+
+tstring
+formatPrometheusMetrics (std::vector<AppenderMetrics> const & metrics)
+{
+    tostringstream out;
+    formatCounter (out, metrics,
+        LOG4CPLUS_TEXT ("log4cplus_appender_events_total"),
+        &AppenderMetrics::events);
+    formatCounter (out, metrics,
+        LOG4CPLUS_TEXT ("log4cplus_appender_bytes_total"),
+        &AppenderMetrics::bytes);
+    formatCounter (out, metrics,
+        LOG4CPLUS_TEXT ("log4cplus_appender_filtered_total"),
+        &AppenderMetrics::filtered);
+    formatCounter (out, metrics,
+        LOG4CPLUS_TEXT ("log4cplus_appender_dropped_total"),
+        &AppenderMetrics::dropped);
+    formatCounter (out, metrics,
+        LOG4CPLUS_TEXT ("log4cplus_appender_errors_total"),
+        &AppenderMetrics::errors);
+    formatHistogram (out, metrics,
+        LOG4CPLUS_TEXT ("log4cplus_appender_append_seconds"),
+        &AppenderMetrics::appendLatency);
+    formatHistogram (out, metrics,
+        LOG4CPLUS_TEXT ("log4cplus_appender_queue_seconds"),
+        &AppenderMetrics::queueLatency);
+    return out.str ();
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// internal::latency_histogram_counters
+//////////////////////////////////////////////////////////////////////////////
+
+namespace internal
+{
+
+void
+latency_histogram_counters::record (std::chrono::steady_clock::duration duration)
+{
+    auto const count = std::chrono::duration_cast<std::chrono::nanoseconds> (
+        duration).count ();
+    std::uint64_t const ns = count > 0 ? static_cast<std::uint64_t>(count) : 0;
+
+    buckets[LatencyHistogram::bucketIndex (ns)].fetch_add (1,
+        std::memory_order_relaxed);
+    sum_ns.fetch_add (ns, std::memory_order_relaxed);
+
+    std::uint64_t max = max_ns.load (std::memory_order_relaxed);
+    while (ns > max
+        && ! max_ns.compare_exchange_weak (max, ns, std::memory_order_relaxed))
+    { }
+}
+
+
+void
+latency_histogram_counters::snapshot (LatencyHistogram & histogram) const
+{
+    histogram.count = 0;
+    for (std::size_t i = 0; i != LatencyHistogram::bucket_count; ++i)
+    {
+        histogram.buckets[i] = buckets[i].load (std::memory_order_relaxed);
+        histogram.count += histogram.buckets[i];
+    }
+
+    histogram.sumNs = sum_ns.load (std::memory_order_relaxed);
+    histogram.maxNs = max_ns.load (std::memory_order_relaxed);
+}
+
+} // namespace internal
+
+
+//////////////////////////////////////////////////////////////////////////////
+// volume accounting
+//////////////////////////////////////////////////////////////////////////////
+
+namespace internal
+{
+
+namespace
+{
+
+//! Tables of all threads that have counted volume and totals of exited
+//! threads.
+struct volume_registry
+{
+    std::mutex mtx;
+    std::vector<std::weak_ptr<thread_volume>> tables;
+    std::map<std::pair<std::uint64_t, tstring>,
+        std::pair<std::uint64_t, std::uint64_t>> totals;
+};
+
+
+volume_registry &
+get_volume_registry ()
+{
+    static volume_registry registry;
+    return registry;
+}
+
+
+//! Adds counts of <code>entry</code> to totals. Registry has to be
+//! locked.
+void
+add_to_totals (volume_registry & registry, logger_volume_entry const & entry)
+{
+    auto & total = registry.totals[std::make_pair (entry.hierarchy_id,
+        entry.name)];
+    total.first += entry.events.load (std::memory_order_relaxed);
+    total.second += entry.bytes.load (std::memory_order_relaxed);
+}
+
+
+thread_volume &
+get_thread_volume ()
+{
+    per_thread_data * const ptd = get_ptd ();
+    if (LOG4CPLUS_UNLIKELY (! ptd->volume))
+    {
+        ptd->volume = std::make_shared<thread_volume> ();
+        volume_registry & registry = get_volume_registry ();
+        std::lock_guard guard (registry.mtx);
+        std::erase_if (registry.tables,
+            [] (std::weak_ptr<thread_volume> const & table)
+            { return table.expired (); });
+        registry.tables.push_back (ptd->volume);
+    }
+
+    return *ptd->volume;
+}
+
+
+//! Adds entry for new logger, or replaces stale entry of a logger of
+//! destroyed hierarchy at the same address.
+logger_volume_entry &
+add_volume_entry (thread_volume & table, void const * logger,
+    tstring const & name, std::uint64_t hierarchy_id)
+{
+    auto entry = std::make_unique<logger_volume_entry> ();
+    entry->hierarchy_id = hierarchy_id;
+    entry->name = name;
+    logger_volume_entry & result = *entry;
+
+    volume_registry & registry = get_volume_registry ();
+    std::lock_guard registry_guard (registry.mtx);
+    std::lock_guard guard (table.mtx);
+    std::unique_ptr<logger_volume_entry> & slot = table.entries[logger];
+    if (slot)
+        add_to_totals (registry, *slot);
+
+    slot = std::move (entry);
+    return result;
+}
+
+} // namespace
+
+
+std::uint64_t
+new_volume_id ()
+{
+    static std::atomic<std::uint64_t> next {1};
+    return next.fetch_add (1, std::memory_order_relaxed);
+}
+
+
+void
+count_logger_volume (void const * logger, tstring const & name,
+    std::uint64_t hierarchy_id, std::size_t bytes)
+{
+    thread_volume & table = get_thread_volume ();
+    auto const it = table.entries.find (logger);
+    logger_volume_entry & entry
+        = it != table.entries.end () && it->second->hierarchy_id == hierarchy_id
+        ? *it->second
+        : add_volume_entry (table, logger, name, hierarchy_id);
+
+    // Only this thread writes the counters, plain stores suffice.
+    entry.events.store (entry.events.load (std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+    entry.bytes.store (entry.bytes.load (std::memory_order_relaxed) + bytes,
+        std::memory_order_relaxed);
+}
+
+
+void
+merge_thread_volume (per_thread_data * p)
+{
+    if (! p->volume)
+        return;
+
+    volume_registry & registry = get_volume_registry ();
+    std::lock_guard registry_guard (registry.mtx);
+    std::lock_guard guard (p->volume->mtx);
+    for (auto const & item : p->volume->entries)
+        add_to_totals (registry, *item.second);
+
+    p->volume->entries.clear ();
+}
+
+
+std::vector<LoggerVolume>
+collect_logger_volume (std::uint64_t hierarchy_id)
+{
+    std::map<tstring, LoggerVolume> loggers;
+    auto const add = [&] (tstring const & name, std::uint64_t events,
+        std::uint64_t bytes)
+    {
+        LoggerVolume & volume = loggers[name];
+        volume.events += events;
+        volume.bytes += bytes;
+    };
+
+    volume_registry & registry = get_volume_registry ();
+    {
+        std::lock_guard registry_guard (registry.mtx);
+        for (auto const & total : registry.totals)
+            if (total.first.first == hierarchy_id)
+                add (total.first.second, total.second.first,
+                    total.second.second);
+
+        for (auto const & weak : registry.tables)
+        {
+            std::shared_ptr<thread_volume> const table = weak.lock ();
+            if (! table)
+                continue;
+
+            std::lock_guard guard (table->mtx);
+            for (auto const & item : table->entries)
+                if (item.second->hierarchy_id == hierarchy_id)
+                    add (item.second->name,
+                        item.second->events.load (std::memory_order_relaxed),
+                        item.second->bytes.load (std::memory_order_relaxed));
+        }
+    }
+
+    std::vector<LoggerVolume> result;
+    result.reserve (loggers.size ());
+    for (auto & item : loggers)
+    {
+        item.second.name = item.first;
+        result.push_back (std::move (item.second));
+    }
+
+    return result;
+}
+
+} // namespace internal
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+//////////////////////////////////////////////////////////////////////////////
+// MetricsDumpTask
+//////////////////////////////////////////////////////////////////////////////
+
+//! Dumps metrics periodically from the shared timer thread, see
+//! internal::add_timer().
+class MetricsDumpTask
+{
+public:
+    MetricsDumpTask (Logger const & logger_, unsigned millis,
+        Hierarchy & hierarchy_)
+        : logger (logger_)
+        , hierarchy (hierarchy_)
+    {
+        internal::add_timer (this, std::chrono::milliseconds (millis),
+            [this] { dump (); });
+    }
+
+    ~MetricsDumpTask ()
+    {
+        internal::remove_timer (this);
+    }
+
+private:
+    void dump ()
+    {
+        for (AppenderMetrics const & m : hierarchy.collectMetrics ())
+            LOG4CPLUS_INFO (logger,
+                LOG4CPLUS_TEXT ("appender=") << m.name
+                << LOG4CPLUS_TEXT (" events=") << m.events
+                << LOG4CPLUS_TEXT (" bytes=") << m.bytes
+                << LOG4CPLUS_TEXT (" filtered=") << m.filtered
+                << LOG4CPLUS_TEXT (" dropped=") << m.dropped
+                << LOG4CPLUS_TEXT (" errors=") << m.errors
+                << LOG4CPLUS_TEXT (" append_p50_ns=")
+                << m.appendLatency.quantile (0.5)
+                << LOG4CPLUS_TEXT (" append_p99_ns=")
+                << m.appendLatency.quantile (0.99)
+                << LOG4CPLUS_TEXT (" append_max_ns=") << m.appendLatency.maxNs
+                << LOG4CPLUS_TEXT (" queue_p99_ns=")
+                << m.queueLatency.quantile (0.99));
+    }
+
+    Logger const logger;
+    Hierarchy & hierarchy;
+};
+
+
+//////////////////////////////////////////////////////////////////////////////
+// MetricsReporter
+//////////////////////////////////////////////////////////////////////////////
+
+MetricsReporter::MetricsReporter (Logger const & logger, unsigned millis)
+    : MetricsReporter (logger, millis, getDefaultHierarchy ())
+{ }
+
+
+MetricsReporter::MetricsReporter (Logger const & logger, unsigned millis,
+    Hierarchy & hierarchy)
+    : dumpTask (new MetricsDumpTask (logger, millis, hierarchy))
+{ }
+
+
+MetricsReporter::~MetricsReporter ()
+{
+    delete dumpTask;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// VolumeReportTask
+//////////////////////////////////////////////////////////////////////////////
+
+//! Logs volume reports periodically from the shared timer thread.
+class VolumeReportTask
+{
+public:
+    VolumeReportTask (Logger const & logger_, unsigned millis,
+        std::size_t topN_, Hierarchy & hierarchy_)
+        : logger (logger_)
+        , topN (topN_)
+        , hierarchy (hierarchy_)
+    {
+        internal::add_timer (this, std::chrono::milliseconds (millis),
+            [this] { report (); });
+    }
+
+    ~VolumeReportTask ()
+    {
+        internal::remove_timer (this);
+    }
+
+private:
+    void report ()
+    {
+        VolumeReport const volume = hierarchy.volumeReport (topN);
+        for (LoggerVolume const & v : volume.loggers)
+            LOG4CPLUS_INFO (logger,
+                LOG4CPLUS_TEXT ("logger=") << v.name
+                << LOG4CPLUS_TEXT (" events=") << v.events
+                << LOG4CPLUS_TEXT (" bytes=") << v.bytes
+                << LOG4CPLUS_TEXT (" total_events=") << v.totalEvents
+                << LOG4CPLUS_TEXT (" total_bytes=") << v.totalBytes);
+
+        for (AppenderMetrics const & m : volume.appenders)
+            LOG4CPLUS_INFO (logger,
+                LOG4CPLUS_TEXT ("appender=") << m.name
+                << LOG4CPLUS_TEXT (" events=") << m.events
+                << LOG4CPLUS_TEXT (" bytes=") << m.bytes);
+    }
+
+    Logger const logger;
+    std::size_t const topN;
+    Hierarchy & hierarchy;
+};
+
+
+//////////////////////////////////////////////////////////////////////////////
+// VolumeReporter
+//////////////////////////////////////////////////////////////////////////////
+
+VolumeReporter::VolumeReporter (Logger const & logger, unsigned millis,
+    std::size_t topN)
+    : VolumeReporter (logger, millis, topN, getDefaultHierarchy ())
+{ }
+
+
+VolumeReporter::VolumeReporter (Logger const & logger, unsigned millis,
+    std::size_t topN, Hierarchy & hierarchy)
+    : reportTask (new VolumeReportTask (logger, millis, topN, hierarchy))
+{ }
+
+
+VolumeReporter::~VolumeReporter ()
+{
+    delete reportTask;
+}
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// load_shedding_state
+//////////////////////////////////////////////////////////////////////////////
+
+namespace internal
+{
+
+unsigned
+load_shedding_state::update (double pressure, bool dropped,
+    unsigned restore_intervals)
+{
+    unsigned target = pressure >= 2 ? 2 : pressure >= 1 ? 1 : 0;
+    // Events are lost although the current step was supposed to
+    // prevent that.
+    if (dropped)
+        target = (std::max) (target, (std::min) (step + 1, max_step));
+
+    if (target > step)
+    {
+        step = target;
+        calm = 0;
+    }
+    else if (step != 0 && ! dropped && pressure < 0.5)
+    {
+        if (++calm >= restore_intervals)
+        {
+            --step;
+            calm = 0;
+        }
+    }
+    else
+        calm = 0;
+
+    return step;
+}
+
+} // namespace internal
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+//////////////////////////////////////////////////////////////////////////////
+// LoadSheddingTask
+//////////////////////////////////////////////////////////////////////////////
+
+//! Samples load periodically from the shared timer thread, see
+//! internal::add_timer().
+class LoadSheddingTask
+{
+public:
+    LoadSheddingTask (Logger const & logger_,
+        LoadSheddingSettings const & settings_, Hierarchy & hierarchy_)
+        : logger (logger_)
+        , settings (settings_)
+        , hierarchy (hierarchy_)
+        , currentStep (0)
+    {
+        internal::add_timer (this,
+            std::chrono::milliseconds (settings.intervalMillis),
+            [this] { sample (); });
+    }
+
+    ~LoadSheddingTask ()
+    {
+        internal::remove_timer (this);
+
+        if (unsigned const old_step = state.step)
+        {
+            state.step = 0;
+            apply ();
+            log_marker (old_step, 0, 0, 0);
+        }
+    }
+
+    unsigned getStep () const
+    {
+        return currentStep.load (std::memory_order_relaxed);
+    }
+
+private:
+    struct Previous
+    {
+        SharedAppenderPtr appender;
+        AppenderMetrics metrics;
+    };
+
+    void sample ()
+    {
+        std::size_t depth = getThreadPoolQueueStats ().depth;
+        LatencyHistogram latency;
+        std::uint64_t dropped = 0;
+
+        // Appenders of all loggers, including nested ones, once each.
+        LoggerList loggers = hierarchy.getCurrentLoggers ();
+        loggers.push_back (hierarchy.getRoot ());
+        SharedAppenderPtrList pending;
+        for (Logger & l : loggers)
+        {
+            SharedAppenderPtrList const appenders = l.getAllAppenders ();
+            pending.insert (pending.end (), appenders.begin (),
+                appenders.end ());
+        }
+
+        std::map<Appender const *, Previous> current;
+        std::set<Appender const *> visited;
+        while (! pending.empty ())
+        {
+            SharedAppenderPtr const appender = std::move (pending.back ());
+            pending.pop_back ();
+            if (! visited.insert (appender.get ()).second)
+                continue;
+
+            if (auto async = dynamic_cast<AsyncAppender *> (appender.get ()))
+                depth += async->getQueueStats ().depth;
+
+            if (appender->isMetricsEnabled ())
+            {
+                Previous & cur = current[appender.get ()];
+                cur.appender = appender;
+                cur.metrics = appender->getMetrics ();
+                auto const prev = previous.find (appender.get ());
+                if (prev != previous.end ()
+                    && prev->second.appender == appender)
+                    add_delta (latency, dropped, cur.metrics,
+                        prev->second.metrics);
+            }
+
+            if (auto attachable
+                = dynamic_cast<spi::AppenderAttachable *> (appender.get ()))
+            {
+                SharedAppenderPtrList const nested
+                    = attachable->getAllAppenders ();
+                pending.insert (pending.end (), nested.begin (),
+                    nested.end ());
+            }
+        }
+        previous.swap (current);
+
+        double const depth_ratio = settings.queueDepth
+            ? static_cast<double> (depth)
+                / static_cast<double> (settings.queueDepth)
+            : 0;
+        std::uint64_t const p99 = latency.quantile (0.99);
+        double const latency_ratio = settings.appendLatency.count () > 0
+            ? static_cast<double> (p99)
+                / static_cast<double> (settings.appendLatency.count ())
+            : 0;
+
+        unsigned const old_step = state.step;
+        if (state.update ((std::max) (depth_ratio, latency_ratio),
+                dropped != 0, settings.restoreIntervals) != old_step)
+        {
+            apply ();
+            log_marker (old_step, depth, p99, dropped);
+        }
+    }
+
+    static void add_delta (LatencyHistogram & latency,
+        std::uint64_t & dropped, AppenderMetrics const & cur,
+        AppenderMetrics const & prev)
+    {
+        LatencyHistogram const & c = cur.appendLatency;
+        LatencyHistogram const & p = prev.appendLatency;
+        for (std::size_t i = 0; i != LatencyHistogram::bucket_count; ++i)
+            if (c.buckets[i] > p.buckets[i])
+            {
+                latency.buckets[i] += c.buckets[i] - p.buckets[i];
+                latency.count += c.buckets[i] - p.buckets[i];
+            }
+        latency.maxNs = (std::max) (latency.maxNs, c.maxNs);
+
+        if (cur.dropped > prev.dropped)
+            dropped += cur.dropped - prev.dropped;
+    }
+
+    void apply ()
+    {
+        static LogLevel const thresholds[internal::load_shedding_state
+            ::max_step + 1] {NOT_SET_LOG_LEVEL, INFO_LOG_LEVEL,
+                WARN_LOG_LEVEL};
+        hierarchy.setSheddingThreshold (thresholds[state.step]);
+        currentStep.store (state.step, std::memory_order_relaxed);
+    }
+
+    void log_marker (unsigned old_step, std::size_t depth, std::uint64_t p99,
+        std::uint64_t dropped)
+    {
+        static tchar const * const descriptions[
+            internal::load_shedding_state::max_step + 1] {
+            LOG4CPLUS_TEXT ("nothing"),
+            LOG4CPLUS_TEXT ("TRACE and DEBUG events"),
+            LOG4CPLUS_TEXT ("TRACE, DEBUG and INFO events")};
+
+        tostringstream oss;
+        oss << LOG4CPLUS_TEXT ("load shedding: dropping ")
+            << descriptions[state.step]
+            << LOG4CPLUS_TEXT (" (queue_depth=") << depth
+            << LOG4CPLUS_TEXT (" append_p99_ns=") << p99
+            << LOG4CPLUS_TEXT (" dropped=") << dropped
+            << LOG4CPLUS_TEXT (")");
+
+        // Escalation markers are logged above every shed level.
+        logger.log (state.step > old_step ? WARN_LOG_LEVEL : INFO_LOG_LEVEL,
+            oss.str (), __FILE__, __LINE__, LOG4CPLUS_MACRO_FUNCTION ());
+    }
+
+    Logger const logger;
+    LoadSheddingSettings const settings;
+    Hierarchy & hierarchy;
+    internal::load_shedding_state state;
+    std::atomic<unsigned> currentStep;
+    std::map<Appender const *, Previous> previous;
+};
+
+
+//////////////////////////////////////////////////////////////////////////////
+// LoadShedder
+//////////////////////////////////////////////////////////////////////////////
+
+LoadShedder::LoadShedder (Logger const & logger,
+    LoadSheddingSettings const & settings)
+    : LoadShedder (logger, settings, getDefaultHierarchy ())
+{ }
+
+
+LoadShedder::LoadShedder (Logger const & logger,
+    LoadSheddingSettings const & settings, Hierarchy & hierarchy)
+    : sheddingTask (new LoadSheddingTask (logger, settings, hierarchy))
+{ }
+
+
+LoadShedder::~LoadShedder ()
+{
+    delete sheddingTask;
+}
+
+
+unsigned
+LoadShedder::getStep () const
+{
+    return sheddingTask->getStep ();
+}
+#endif
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Appender metrics", "[metrics]")
+{
+    CATCH_SECTION ("histogram buckets")
+    {
+        for (std::uint64_t ns : {0ull, 3ull, 4ull, 7ull, 8ull, 1000ull,
+                 123456789ull, (1ull << 40) - 1})
+        {
+            std::size_t const index = LatencyHistogram::bucketIndex (ns);
+            CATCH_REQUIRE (LatencyHistogram::bucketLowerBound (index) <= ns);
+            CATCH_REQUIRE (ns < LatencyHistogram::bucketLowerBound (index + 1));
+        }
+        CATCH_REQUIRE (LatencyHistogram::bucketIndex (~0ull)
+            == LatencyHistogram::bucket_count - 1);
+
+        internal::latency_histogram_counters counters;
+        for (int i = 1; i <= 100; ++i)
+            counters.record (std::chrono::microseconds (i));
+        LatencyHistogram hist;
+        counters.snapshot (hist);
+        CATCH_REQUIRE (hist.count == 100);
+        CATCH_REQUIRE (hist.maxNs == 100000);
+        CATCH_REQUIRE (hist.quantile (0.5) >= 50000);
+        CATCH_REQUIRE (hist.quantile (0.5) < 50000 * 5 / 4);
+        CATCH_REQUIRE (hist.quantile (1.0) == 100000);
+    }
+
+    CATCH_SECTION ("counters and collection")
+    {
+        Hierarchy h;
+        Logger logger = h.getInstance (LOG4CPLUS_TEXT ("metrics"));
+        SharedAppenderPtr counted (new NullAppender);
+        counted->setName (LOG4CPLUS_TEXT ("counted"));
+        counted->setThreshold (INFO_LOG_LEVEL);
+        counted->setMetricsEnabled (true);
+        SharedAppenderPtr uncounted (new NullAppender);
+        logger.addAppender (counted);
+        logger.addAppender (uncounted);
+        h.getRoot ().addAppender (counted);
+        logger.setAdditivity (false);
+
+        LOG4CPLUS_INFO (logger, LOG4CPLUS_TEXT ("appended"));
+        LOG4CPLUS_INFO (logger, LOG4CPLUS_TEXT ("appended"));
+        // Loggers skip appenders whose threshold rejects the event
+        // before appending, hand it over directly.
+        counted->doAppend (spi::InternalLoggingEvent (logger.getName (),
+                DEBUG_LOG_LEVEL, LOG4CPLUS_TEXT ("filtered"), __FILE__,
+                __LINE__));
+
+        std::vector<AppenderMetrics> const metrics = h.collectMetrics ();
+        CATCH_REQUIRE (metrics.size () == 1);
+        CATCH_REQUIRE (metrics[0].name == LOG4CPLUS_TEXT ("counted"));
+        CATCH_REQUIRE (metrics[0].events == 2);
+        CATCH_REQUIRE (metrics[0].filtered == 1);
+        // Events under the threshold are rejected before they are timed.
+        CATCH_REQUIRE (metrics[0].appendLatency.count == 2);
+        CATCH_REQUIRE (! uncounted->isMetricsEnabled ());
+
+        counted->setMetricsEnabled (false);
+        LOG4CPLUS_INFO (logger, LOG4CPLUS_TEXT ("not counted"));
+        CATCH_REQUIRE (counted->getMetrics ().events == 2);
+
+        tstring const text = formatPrometheusMetrics (metrics);
+        CATCH_REQUIRE (text.find (
+                LOG4CPLUS_TEXT ("log4cplus_appender_events_total")
+                LOG4CPLUS_TEXT ("{appender=\"counted\"} 2\n"))
+            != tstring::npos);
+        CATCH_REQUIRE (text.find (
+                LOG4CPLUS_TEXT ("log4cplus_appender_append_seconds_count")
+                LOG4CPLUS_TEXT ("{appender=\"counted\"} 2\n"))
+            != tstring::npos);
+
+        h.shutdown ();
+    }
+}
+
+
+CATCH_TEST_CASE ("Volume accounting", "[metrics]")
+{
+    Hierarchy h;
+    h.getRoot ().addAppender (SharedAppenderPtr (new NullAppender));
+    Logger const ab = h.getInstance (LOG4CPLUS_TEXT ("a.b"));
+    Logger const ac = h.getInstance (LOG4CPLUS_TEXT ("a.c"));
+    Logger const other = h.getInstance (LOG4CPLUS_TEXT ("other"));
+
+    LOG4CPLUS_INFO (ab, LOG4CPLUS_TEXT ("not counted"));
+    h.setVolumeAccounting (true);
+    CATCH_REQUIRE (h.isVolumeAccounting ());
+
+    LOG4CPLUS_INFO (ab, LOG4CPLUS_TEXT ("1234"));
+    LOG4CPLUS_INFO (ac, LOG4CPLUS_TEXT ("12"));
+    LOG4CPLUS_INFO (other, LOG4CPLUS_TEXT ("1"));
+    // Counts of exited threads are merged into totals.
+    std::thread ([&]
+    {
+        LOG4CPLUS_INFO (ab, LOG4CPLUS_TEXT ("1234"));
+        threadCleanup ();
+    }).join ();
+
+    VolumeReport const report = h.volumeReport (10);
+    auto const find = [&] (tchar const * name) -> LoggerVolume const &
+    {
+        auto const it = std::find_if (report.loggers.begin (),
+            report.loggers.end (),
+            [&] (LoggerVolume const & v) { return v.name == name; });
+        CATCH_REQUIRE (it != report.loggers.end ());
+        return *it;
+    };
+
+    std::uint64_t const ch = sizeof (tchar);
+    CATCH_REQUIRE (report.loggers.front ().name == h.getRoot ().getName ());
+    CATCH_REQUIRE (report.loggers.front ().totalEvents == 4);
+    CATCH_REQUIRE (report.loggers.front ().events == 0);
+    CATCH_REQUIRE (find (LOG4CPLUS_TEXT ("a")).totalBytes == 10 * ch);
+    CATCH_REQUIRE (find (LOG4CPLUS_TEXT ("a")).events == 0);
+    CATCH_REQUIRE (find (LOG4CPLUS_TEXT ("a.b")).events == 2);
+    CATCH_REQUIRE (find (LOG4CPLUS_TEXT ("a.b")).bytes == 8 * ch);
+    CATCH_REQUIRE (report.loggers[1].name == LOG4CPLUS_TEXT ("a"));
+    CATCH_REQUIRE (h.volumeReport (1).loggers.size () == 1);
+
+    // Other hierarchies do not see the counts.
+    Hierarchy h2;
+    CATCH_REQUIRE (h2.volumeReport (10).loggers.empty ());
+
+    h.setVolumeAccounting (false);
+    LOG4CPLUS_INFO (other, LOG4CPLUS_TEXT ("1"));
+    CATCH_REQUIRE (h.volumeReport (10).loggers.front ().totalEvents == 4);
+    h.shutdown ();
+}
+
+
+CATCH_TEST_CASE ("Load shedding", "[metrics]")
+{
+    CATCH_SECTION ("steps")
+    {
+        internal::load_shedding_state state;
+        CATCH_REQUIRE (state.update (0.9, false, 2) == 0);
+        CATCH_REQUIRE (state.update (1.2, false, 2) == 1);
+        CATCH_REQUIRE (state.update (0.7, false, 2) == 1);
+        CATCH_REQUIRE (state.update (3, false, 2) == 2);
+        // Drops escalate by one step, up to the last one.
+        CATCH_REQUIRE (state.update (0, true, 2) == 2);
+
+        // Hysteresis: consecutive calm samples only.
+        CATCH_REQUIRE (state.update (0.1, false, 2) == 2);
+        CATCH_REQUIRE (state.update (0.6, false, 2) == 2);
+        CATCH_REQUIRE (state.update (0.1, false, 2) == 2);
+        CATCH_REQUIRE (state.update (0.1, false, 2) == 1);
+        CATCH_REQUIRE (state.update (0.1, false, 2) == 1);
+        CATCH_REQUIRE (state.update (0.1, false, 2) == 0);
+        CATCH_REQUIRE (state.update (0, true, 2) == 1);
+    }
+
+    CATCH_SECTION ("shedding threshold")
+    {
+        Hierarchy h;
+        Logger logger = h.getInstance (LOG4CPLUS_TEXT ("a.b"));
+        logger.setLogLevel (TRACE_LOG_LEVEL);
+        CATCH_REQUIRE (logger.isEnabledFor (TRACE_LOG_LEVEL));
+
+        h.setSheddingThreshold (INFO_LOG_LEVEL);
+        CATCH_REQUIRE (! logger.isEnabledFor (DEBUG_LOG_LEVEL));
+        CATCH_REQUIRE (logger.isEnabledFor (INFO_LOG_LEVEL));
+        CATCH_REQUIRE (h.getRoot ().getLogLevel () == DEBUG_LOG_LEVEL);
+
+        h.setSheddingThreshold (NOT_SET_LOG_LEVEL);
+        CATCH_REQUIRE (logger.isEnabledFor (TRACE_LOG_LEVEL));
+    }
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    CATCH_SECTION ("governor")
+    {
+        struct SlowAppender
+            : NullAppender
+        {
+        protected:
+            void append (spi::InternalLoggingEvent const &) override
+            {
+                std::this_thread::sleep_for (std::chrono::milliseconds (3));
+            }
+        };
+
+        Hierarchy h;
+        Logger logger = h.getInstance (LOG4CPLUS_TEXT ("app"));
+        logger.setAdditivity (false);
+        SharedAppenderPtr slow (new SlowAppender);
+        slow->setMetricsEnabled (true);
+        logger.addAppender (slow);
+        h.getRoot ().addAppender (SharedAppenderPtr (new NullAppender));
+
+        LoadSheddingSettings settings;
+        settings.intervalMillis = 10;
+        settings.appendLatency = std::chrono::microseconds (500);
+        settings.restoreIntervals = 2;
+
+        auto wait_for = [] (auto && cond)
+        {
+            for (int i = 0; i != 500 && ! cond (); ++i)
+                std::this_thread::sleep_for (std::chrono::milliseconds (10));
+            return cond ();
+        };
+
+        {
+            LoadShedder shedder (h.getInstance (LOG4CPLUS_TEXT ("shedding")),
+                settings, h);
+            CATCH_REQUIRE (wait_for ([&] {
+                    LOG4CPLUS_WARN (logger, LOG4CPLUS_TEXT ("slow"));
+                    return shedder.getStep () == 2; }));
+            CATCH_REQUIRE (! logger.isEnabledFor (INFO_LOG_LEVEL));
+            CATCH_REQUIRE (logger.isEnabledFor (WARN_LOG_LEVEL));
+
+            // No appends, no latency, the steps are restored.
+            CATCH_REQUIRE (wait_for ([&] { return shedder.getStep () == 0; }));
+            CATCH_REQUIRE (logger.isEnabledFor (DEBUG_LOG_LEVEL));
+
+            LOG4CPLUS_WARN (logger, LOG4CPLUS_TEXT ("slow"));
+            CATCH_REQUIRE (wait_for ([&] { return shedder.getStep () != 0; }));
+        }
+
+        CATCH_REQUIRE (h.getSheddingThreshold () == NOT_SET_LOG_LEVEL);
+        h.shutdown ();
+    }
+#endif
+}
+#endif
+
+
+} // namespace log4cplus
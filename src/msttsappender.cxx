@@ -100,6 +100,7 @@ public:
     explicit SpeechObjectThread (ISpVoice * & ispvoice_ref)
         : ispvoice (ispvoice_ref)
     {
+        setThreadRole (LOG4CPLUS_TEXT ("speech"));
         terminate_ev = CreateEvent (0, true, false, 0);
         if (! terminate_ev)
             loglog_win32_error (
@@ -22,6 +22,7 @@
 #include <log4cplus/internal/internal.h>
 #include <utility>
 #include <algorithm>
+#include <memory>
 
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 #include <catch.hpp>
@@ -60,6 +61,46 @@ init_full_message (log4cplus::tstring & fullMessage,
 }
 
 
+DiagnosticContextStack const empty_ndc;
+
+
+DiagnosticContextStack const &
+ndc_stack (internal::per_thread_data const & ptd)
+{
+    return ptd.ndc_dcs ? *ptd.ndc_dcs : empty_ndc;
+}
+
+
+//! \return Stack that can be modified without affecting snapshots held
+//! by DiagnosticContextHandle.
+DiagnosticContextStack &
+writable_ndc (internal::per_thread_data & ptd)
+{
+    std::shared_ptr<DiagnosticContextStack> & dcs = ptd.ndc_dcs;
+    if (! dcs)
+        dcs = std::make_shared<DiagnosticContextStack> ();
+    else if (dcs.use_count () != 1)
+        dcs = std::make_shared<DiagnosticContextStack> (*dcs);
+
+    return *dcs;
+}
+
+
+//! Keeps joined messages in sync with removal of the innermost
+//! context, whose message is <code>messageSize</code> long.
+void
+ndc_popped (internal::per_thread_data & ptd, std::size_t messageSize)
+{
+    if (! ptd.ndc_full_valid)
+        return;
+
+    if (ndc_stack (ptd).empty ())
+        ptd.ndc_full_valid = false;
+    else
+        ptd.ndc_full.resize (ptd.ndc_full.size () - messageSize - 1);
+}
+
+
 } // namespace
 
 
@@ -81,14 +122,12 @@ DiagnosticContext::DiagnosticContext(tchar const * message_,
 
 DiagnosticContext::DiagnosticContext(const log4cplus::tstring& message_)
     : message(message_)
-    , fullMessage(message)
 {
 }
 
 
 DiagnosticContext::DiagnosticContext(tchar const * message_)
     : message(message_)
-    , fullMessage(message)
 {
 }
 
@@ -146,8 +185,10 @@ NDC::~NDC()
 void
 NDC::clear()
 {
-    DiagnosticContextStack* ptr = getPtr();
-    DiagnosticContextStack ().swap (*ptr);
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    ptd->ndc_dcs.reset ();
+    tstring ().swap (ptd->ndc_full);
+    ptd->ndc_full_valid = false;
 }
 
 
@@ -161,47 +202,70 @@ NDC::remove()
 DiagnosticContextStack
 NDC::cloneStack() const
 {
-    DiagnosticContextStack* ptr = getPtr();
-    return DiagnosticContextStack(*ptr);
+    return *getPtr ();
 }
 
 
 void
 NDC::inherit(const DiagnosticContextStack& stack)
 {
-    DiagnosticContextStack* ptr = getPtr();
-    DiagnosticContextStack (stack).swap (*ptr);
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    ptd->ndc_dcs = std::make_shared<DiagnosticContextStack> (stack);
+    ptd->ndc_full_valid = false;
 }
 
 
 log4cplus::tstring const &
 NDC::get() const
 {
-    DiagnosticContextStack* ptr = getPtr();
-    if(!ptr->empty())
-        return ptr->back().fullMessage;
-    else
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    DiagnosticContextStack const & dcs = ndc_stack (*ptd);
+    if (dcs.empty ())
         return internal::empty_str;
+    else if (dcs.size () == 1)
+        return dcs.back ().message;
+
+    if (! ptd->ndc_full_valid)
+    {
+        std::size_t size = dcs.size () - 1;
+        for (DiagnosticContext const & dc : dcs)
+            size += dc.message.size ();
+
+        tstring & full = ptd->ndc_full;
+        full.clear ();
+        full.reserve (size);
+        full += dcs.front ().message;
+        for (auto it = dcs.begin () + 1; it != dcs.end (); ++it)
+        {
+            full += LOG4CPLUS_TEXT(' ');
+            full += it->message;
+        }
+
+        ptd->ndc_full_valid = true;
+    }
+
+    return ptd->ndc_full;
 }
 
 
 std::size_t
 NDC::getDepth() const
 {
-    DiagnosticContextStack* ptr = getPtr();
-    return ptr->size();
+    return getPtr ()->size ();
 }
 
 
 log4cplus::tstring
 NDC::pop()
 {
-    DiagnosticContextStack* ptr = getPtr();
-    if(!ptr->empty())
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    if (! ndc_stack (*ptd).empty ())
     {
+        DiagnosticContextStack* ptr = &writable_ndc (*ptd);
         tstring message;
         message.swap (ptr->back ().message);
         ptr->pop_back();
+        ndc_popped (*ptd, message.size ());
         return message;
     }
     else
@@ -212,16 +276,21 @@ NDC::pop()
 void
 NDC::pop_void ()
 {
-    DiagnosticContextStack* ptr = getPtr ();
-    if (! ptr->empty ())
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    if (! ndc_stack (*ptd).empty ())
+    {
+        DiagnosticContextStack* ptr = &writable_ndc (*ptd);
+        std::size_t const messageSize = ptr->back ().message.size ();
         ptr->pop_back ();
+        ndc_popped (*ptd, messageSize);
+    }
 }
 
 
 log4cplus::tstring const &
 NDC::peek() const
 {
-    DiagnosticContextStack* ptr = getPtr();
+    DiagnosticContextStack const * ptr = getPtr();
     if(!ptr->empty())
         return ptr->back().message;
     else
@@ -247,13 +316,15 @@ template <typename StringType>
 void
 NDC::push_worker (StringType const & message)
 {
-    DiagnosticContextStack* ptr = getPtr();
-    if (ptr->empty())
-        ptr->push_back( DiagnosticContext(message, nullptr) );
-    else
+    // Only the message is kept, messages of all levels are joined by
+    // get() when some layout asks for them.
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    DiagnosticContextStack* ptr = &writable_ndc (*ptd);
+    ptr->push_back( DiagnosticContext(message) );
+    if (ptd->ndc_full_valid)
     {
-        DiagnosticContext const & dc = ptr->back();
-        ptr->push_back( DiagnosticContext(message, &dc) );
+        ptd->ndc_full += LOG4CPLUS_TEXT(' ');
+        ptd->ndc_full += ptr->back ().message;
     }
 }
 
@@ -261,16 +332,24 @@ NDC::push_worker (StringType const & message)
 void
 NDC::setMaxDepth(std::size_t maxDepth)
 {
-    DiagnosticContextStack* ptr = getPtr();
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    if (maxDepth >= ndc_stack (*ptd).size ())
+        return;
+
+    DiagnosticContextStack* ptr = &writable_ndc (*ptd);
     while(maxDepth < ptr->size())
+    {
+        std::size_t const messageSize = ptr->back ().message.size ();
         ptr->pop_back();
+        ndc_popped (*ptd, messageSize);
+    }
 }
 
 
-DiagnosticContextStack* NDC::getPtr()
+DiagnosticContextStack const * NDC::getPtr()
 {
     internal::per_thread_data * ptd = internal::get_ptd ();
-    return &ptd->ndc_dcs;
+    return &ndc_stack (*ptd);
 }
 
 
@@ -348,6 +427,32 @@ CATCH_TEST_CASE ("NDC", "[NDC]")
         CATCH_REQUIRE (ndc.peek ().empty ());
         CATCH_REQUIRE (ndc.getDepth () == 0);
     }
+
+    CATCH_SECTION ("joined messages follow changes")
+    {
+        ndc.push (CONTEXT1);
+        ndc.push (CONTEXT2);
+        CATCH_REQUIRE (ndc.get () == C1C2);
+        ndc.push (CONTEXT3);
+        CATCH_REQUIRE (ndc.get () == C1C2C3);
+        ndc.pop_void ();
+        CATCH_REQUIRE (ndc.get () == C1C2);
+        ndc.push (CONTEXT3);
+        ndc.setMaxDepth (2);
+        CATCH_REQUIRE (ndc.get () == C1C2);
+
+        DiagnosticContextStack const stack = ndc.cloneStack ();
+        ndc.setMaxDepth (0);
+        CATCH_REQUIRE (ndc.get ().empty ());
+        ndc.inherit (stack);
+        CATCH_REQUIRE (ndc.get () == C1C2);
+        ndc.push (tstring ());
+        CATCH_REQUIRE (ndc.get () == C1C2 + LOG4CPLUS_TEXT (' '));
+        ndc.clear ();
+        ndc.push (CONTEXT3);
+        CATCH_REQUIRE (ndc.get () == CONTEXT3);
+        ndc.clear ();
+    }
 }
 
 #endif
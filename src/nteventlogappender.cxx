@@ -28,8 +28,16 @@
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/thread/threads.h>
+#include <algorithm>
 #include <sstream>
 #include <cstdlib>
+#include <vector>
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+#include <condition_variable>
+#include <mutex>
+#endif
 
 
 namespace log4cplus
@@ -142,9 +150,61 @@ namespace {
                       sizeof(DWORD));
     }
 
+
+    //! From MSDN documentation for ReportEvent():
+    //! Each string is limited to 31,839 characters.
+    std::size_t const max_event_string = 31839;
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    class EventLogWriterThread
+        : public thread::AbstractThread
+    {
+    public:
+        explicit EventLogWriterThread (NTEventLogAppender * app)
+            : appender (app)
+        {
+            setThreadRole (LOG4CPLUS_TEXT ("eventlog"));
+        }
+
+        void run () override
+        {
+            appender->writerLoop ();
+        }
+
+    private:
+        // close() joins the thread before the appender goes away.
+        NTEventLogAppender * appender;
+    };
+#endif
+
 }
 
 
+//! State of asynchronous mode. Records are kept in a vector swapped
+//! with the writer's one, so that their strings keep their capacity.
+struct NTEventLogAppender::AsyncWriter
+{
+    struct Record
+    {
+        WORD type;
+        WORD category;
+        tstring message;
+    };
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    std::mutex mtx;
+    std::condition_variable queued;
+    std::condition_variable taken;
+    std::vector<Record> queue;
+    std::size_t count = 0;
+    std::size_t limit = 1000;
+    bool stop = false;
+    thread::AbstractThreadPtr thread;
+#endif
+};
+
+
 
 //////////////////////////////////////////////////////////////////////////////
 // NTEventLogAppender ctor and dtor
@@ -174,6 +234,24 @@ NTEventLogAppender::NTEventLogAppender(const helpers::Properties & properties)
     source = properties.getProperty( LOG4CPLUS_TEXT("source") );
 
     init();
+
+    bool asynchronous = false;
+    properties.getBool (asynchronous, LOG4CPLUS_TEXT("Asynchronous"));
+    if (! asynchronous || hEventLog == NULL)
+        return;
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    writer.reset (new AsyncWriter);
+    unsigned limit = 0;
+    if (properties.getUInt (limit, LOG4CPLUS_TEXT("QueueLimit")))
+        writer->limit = (std::max) (limit, 1u);
+    writer->thread = new EventLogWriterThread (this);
+    writer->thread->start ();
+#else
+    helpers::getLogLog().warn(
+        LOG4CPLUS_TEXT("Asynchronous NTEventLogAppender is not available")
+        LOG4CPLUS_TEXT(" in single threaded build."));
+#endif
 }
 
 
@@ -226,6 +304,19 @@ NTEventLogAppender::~NTEventLogAppender()
 void
 NTEventLogAppender::close()
 {
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (writer && writer->thread)
+    {
+        {
+            std::lock_guard guard (writer->mtx);
+            writer->stop = true;
+        }
+        writer->queued.notify_one ();
+        writer->thread->join ();
+        writer->thread = nullptr;
+    }
+#endif
+
     if(hEventLog != NULL) {
         ::DeregisterEventSource(hEventLog);
         hEventLog = NULL;
@@ -247,17 +338,49 @@ NTEventLogAppender::append(const spi::InternalLoggingEvent& event)
         return;
     }
 
-    tstring & str = formatEvent (event);
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (writer)
+    {
+        std::unique_lock lock (writer->mtx);
+        writer->taken.wait (lock,
+            [this] { return writer->count < writer->limit; });
+
+        if (writer->queue.size () == writer->count)
+            writer->queue.emplace_back ();
+        AsyncWriter::Record & rec = writer->queue[writer->count];
+        rec.type = getEventType(event);
+        rec.category = getEventCategory(event);
+        rec.message.clear ();
+        formatEvent (event, rec.message);
+        ++writer->count;
+        lock.unlock ();
+
+        writer->queued.notify_one ();
+        return;
+    }
+#endif
+
+    reportEvent (getEventType(event), getEventCategory(event),
+        formatEvent (event));
+}
+
 
-    // From MSDN documentation for ReportEvent():
-    // Each string is limited to 31,839 characters.
-    if (str.size () > 31839)
-        str.resize (31839);
+void
+NTEventLogAppender::reportEvent(WORD type, WORD category,
+    tstring const & message)
+{
+    tstring truncated;
+    tstring const * str = &message;
+    if (message.size () > max_event_string)
+    {
+        truncated.assign (message, 0, max_event_string);
+        str = &truncated;
+    }
 
-    const tchar * s = str.c_str ();
+    const tchar * s = str->c_str ();
     BOOL bSuccess = ::ReportEvent(hEventLog,
-                                  getEventType(event),
-                                  getEventCategory(event),
+                                  type,
+                                  category,
                                   0x1000,
                                   pCurrentUserSID,
                                   1,
@@ -272,6 +395,41 @@ NTEventLogAppender::append(const spi::InternalLoggingEvent& event)
 }
 
 
+void
+NTEventLogAppender::writerLoop()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    std::vector<AsyncWriter::Record> batch;
+    for (;;)
+    {
+        std::size_t count;
+        bool stop;
+        {
+            std::unique_lock lock (writer->mtx);
+            writer->queued.wait (lock,
+                [this] { return writer->count != 0 || writer->stop; });
+
+            // Trade the vectors; records keep their strings' capacity.
+            batch.swap (writer->queue);
+            count = writer->count;
+            writer->count = 0;
+            stop = writer->stop;
+            if (writer->queue.size () < batch.size ())
+                writer->queue.resize (batch.size ());
+        }
+        writer->taken.notify_all ();
+
+        // The event log handle stays open until close() has joined us.
+        for (std::size_t i = 0; i != count; ++i)
+            reportEvent (batch[i].type, batch[i].category, batch[i].message);
+
+        if (stop && count == 0)
+            break;
+    }
+#endif
+}
+
+
 
 
 WORD
@@ -22,6 +22,10 @@
 #include <log4cplus/thread/syncprims-pub-impl.h>
 #include <log4cplus/thread/threads.h>
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#endif
+
 
 namespace log4cplus::spi {
 
@@ -46,9 +50,7 @@ ObjectRegistryBase::~ObjectRegistryBase() = default;
 bool
 ObjectRegistryBase::exists(const tstring& name) const
 {
-    thread::MutexGuard guard (mutex);
-
-    return data.find(name) != data.end();
+    return getVal (name) != nullptr;
 }
 
 
@@ -85,6 +87,9 @@ ObjectRegistryBase::putVal(const tstring& name, void* object)
             guard.attach_and_lock (mutex);
 
         ret = data.insert(std::move (value));
+        if (ret.second)
+            index.store (std::make_shared<ObjectIndex const> (data.begin (),
+                    data.end ()), std::memory_order_release);
     }
 
     if (! ret.second)
@@ -97,10 +102,12 @@ ObjectRegistryBase::putVal(const tstring& name, void* object)
 void*
 ObjectRegistryBase::getVal(const tstring& name) const
 {
-    thread::MutexGuard guard (mutex);
+    ObjectIndexPtr const snapshot = index.load (std::memory_order_acquire);
+    if (! snapshot)
+        return nullptr;
 
-    auto it (data.find (name));
-    if (it != data.end ())
+    auto it (snapshot->find (name));
+    if (it != snapshot->end ())
         return it->second;
     else
         return nullptr;
@@ -114,6 +121,7 @@ ObjectRegistryBase::clear()
 {
     thread::MutexGuard guard (mutex);
 
+    index.store (ObjectIndexPtr (), std::memory_order_release);
     for (auto const & kv : data)
         deleteObject (kv.second);
 }
@@ -126,4 +134,47 @@ ObjectRegistryBase::_enableLocking (bool enable)
 }
 
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("ObjectRegistryBase", "[factory]")
+{
+    struct IntRegistry
+        : ObjectRegistryBase
+    {
+        ~IntRegistry () { clear (); }
+
+        bool put (tstring const & name, int value)
+        {
+            return putVal (name, new int (value));
+        }
+
+        int const * get (tstring const & name) const
+        {
+            return static_cast<int const *> (getVal (name));
+        }
+
+    protected:
+        void deleteObject (void * object) const override
+        {
+            delete static_cast<int *> (object);
+        }
+    };
+
+    IntRegistry registry;
+    CATCH_REQUIRE (! registry.exists (LOG4CPLUS_TEXT ("a")));
+    CATCH_REQUIRE (registry.get (LOG4CPLUS_TEXT ("a")) == nullptr);
+
+    CATCH_REQUIRE (registry.put (LOG4CPLUS_TEXT ("b"), 2));
+    CATCH_REQUIRE (registry.put (LOG4CPLUS_TEXT ("a"), 1));
+    // Names are bound only once; the duplicate object is deleted.
+    CATCH_REQUIRE (! registry.put (LOG4CPLUS_TEXT ("a"), 3));
+
+    CATCH_REQUIRE (registry.exists (LOG4CPLUS_TEXT ("a")));
+    CATCH_REQUIRE (*registry.get (LOG4CPLUS_TEXT ("a")) == 1);
+    CATCH_REQUIRE (*registry.get (LOG4CPLUS_TEXT ("b")) == 2);
+    CATCH_REQUIRE (registry.getAllNames () == std::vector<tstring> {
+            LOG4CPLUS_TEXT ("a"), LOG4CPLUS_TEXT ("b")});
+}
+#endif
+
+
 } // namespace log4cplus::spi
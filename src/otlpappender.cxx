@@ -0,0 +1,1136 @@
+// Module:  Log4cplus
+// File:    otlpappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/config.hxx>
+#ifndef LOG4CPLUS_SINGLE_THREADED
+
+#include <log4cplus/otlpappender.h>
+#include <log4cplus/spi/factory.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <log4cplus/helpers/tlscontext.h>
+#include <log4cplus/internal/http.h>
+#include <log4cplus/internal/internal.h>
+#include <log4cplus/thread/threads.h>
+#include <log4cplus/version.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/mdc.h>
+#include <catch.hpp>
+#include <map>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+//! Wire types of protobuf fields.
+enum wire_type : unsigned
+{
+    wire_varint = 0,
+    wire_fixed64 = 1,
+    wire_len = 2
+};
+
+
+//! Field numbers of the OTLP messages, see
+//! opentelemetry/proto/logs/v1/logs.proto and
+//! opentelemetry/proto/common/v1/common.proto.
+enum otlp_field : unsigned
+{
+    request_resource_logs = 1,
+
+    resource_logs_resource = 1,
+    resource_logs_scope_logs = 2,
+
+    resource_attributes = 1,
+
+    scope_logs_scope = 1,
+    scope_logs_log_records = 2,
+
+    scope_name = 1,
+    scope_version = 2,
+
+    log_record_time_unix_nano = 1,
+    log_record_severity_number = 2,
+    log_record_severity_text = 3,
+    log_record_body = 5,
+    log_record_attributes = 6,
+    log_record_trace_id = 9,
+    log_record_span_id = 10,
+    log_record_observed_time_unix_nano = 11,
+
+    key_value_key = 1,
+    key_value_value = 2,
+
+    any_value_string = 1,
+    any_value_bool = 2,
+    any_value_int = 3,
+    any_value_double = 4
+};
+
+
+std::size_t
+varint_size (std::uint64_t value)
+{
+    std::size_t size = 1;
+    for (; value >= 0x80; value >>= 7)
+        ++size;
+    return size;
+}
+
+
+void
+put_varint (std::string & out, std::uint64_t value)
+{
+    for (; value >= 0x80; value >>= 7)
+        out.push_back (static_cast<char> (value | 0x80));
+    out.push_back (static_cast<char> (value));
+}
+
+
+void
+put_tag (std::string & out, unsigned field, wire_type type)
+{
+    put_varint (out, field << 3 | type);
+}
+
+
+void
+put_fixed64 (std::string & out, unsigned field, std::uint64_t value)
+{
+    put_tag (out, field, wire_fixed64);
+    for (int i = 0; i != 8; ++i, value >>= 8)
+        out.push_back (static_cast<char> (value & 0xFF));
+}
+
+
+void
+put_bytes (std::string & out, unsigned field, std::string_view bytes)
+{
+    put_tag (out, field, wire_len);
+    put_varint (out, bytes.size ());
+    out.append (bytes);
+}
+
+
+//! Starts length delimited field whose content is appended next.
+//! \return Start of the content, to be passed to end_message().
+std::size_t
+begin_message (std::string & out, unsigned field)
+{
+    put_tag (out, field, wire_len);
+    out.push_back (0);
+    return out.size ();
+}
+
+
+//! Stores length of the content started by begin_message(). The one
+//! byte reserved for it is enough for content shorter than 128 bytes,
+//! the content is moved otherwise.
+void
+end_message (std::string & out, std::size_t start)
+{
+    std::uint64_t const size = out.size () - start;
+    if (size < 0x80)
+    {
+        out[start - 1] = static_cast<char> (size);
+        return;
+    }
+
+    std::string length;
+    put_varint (length, size);
+    out[start - 1] = length[0];
+    out.insert (start, length, 1);
+}
+
+
+void
+put_string (std::string & out, unsigned field, tstring_view str)
+{
+    std::size_t const start = begin_message (out, field);
+    internal::append_utf8 (out, str);
+    end_message (out, start);
+}
+
+
+//! Appends <tt>KeyValue</tt> message field with string value.
+void
+put_attribute (std::string & out, unsigned field, tstring_view key,
+    tstring_view value)
+{
+    std::size_t const kv = begin_message (out, field);
+    put_string (out, key_value_key, key);
+    std::size_t const any = begin_message (out, key_value_value);
+    put_string (out, any_value_string, value);
+    end_message (out, any);
+    end_message (out, kv);
+}
+
+
+//! Appends <tt>KeyValue</tt> message field for typed key/value field.
+void
+put_attribute (std::string & out, unsigned field, spi::KeyValue const & kv)
+{
+    std::size_t const kvStart = begin_message (out, field);
+    put_string (out, key_value_key, kv.key);
+    std::size_t const any = begin_message (out, key_value_value);
+    switch (kv.type)
+    {
+    case spi::KV_BOOL:
+        put_tag (out, any_value_bool, wire_varint);
+        put_varint (out, kv.b);
+        break;
+
+    case spi::KV_INT:
+        put_tag (out, any_value_int, wire_varint);
+        put_varint (out, static_cast<std::uint64_t> (kv.i));
+        break;
+
+    case spi::KV_UINT:
+        // AnyValue has signed integers only.
+        if (kv.u > static_cast<std::uint64_t> (INT64_MAX))
+        {
+            tstring str;
+            spi::KeyValues::appendValue (str, kv);
+            put_string (out, any_value_string, str);
+        }
+        else
+        {
+            put_tag (out, any_value_int, wire_varint);
+            put_varint (out, kv.u);
+        }
+        break;
+
+    case spi::KV_DOUBLE:
+    {
+        std::uint64_t bits;
+        std::memcpy (&bits, &kv.d, sizeof (bits));
+        put_fixed64 (out, any_value_double, bits);
+        break;
+    }
+
+    case spi::KV_STRING:
+        put_string (out, any_value_string, kv.str);
+        break;
+    }
+    end_message (out, any);
+    end_message (out, kvStart);
+}
+
+
+//! Maps log level to OpenTelemetry SeverityNumber; each of the six
+//! standard levels starts its range of four numbers.
+unsigned
+severity_number (LogLevel ll)
+{
+    if (ll < DEBUG_LOG_LEVEL)
+        return 1;
+    else if (ll < INFO_LOG_LEVEL)
+        return 5;
+    else if (ll < WARN_LOG_LEVEL)
+        return 9;
+    else if (ll < ERROR_LOG_LEVEL)
+        return 13;
+    else if (ll < FATAL_LOG_LEVEL)
+        return 17;
+    else
+        return 21;
+}
+
+
+//! Parses hexadecimal trace or span ID of <code>size</code> bytes.
+//! \return <code>false</code> for malformed or all zero ID.
+bool
+parse_hex_id (char * dest, std::size_t size, tstring_view hex)
+{
+    if (hex.size () != size * 2)
+        return false;
+
+    bool nonZero = false;
+    for (std::size_t i = 0; i != hex.size (); ++i)
+    {
+        tchar const ch = hex[i];
+        unsigned digit;
+        if (ch >= LOG4CPLUS_TEXT ('0') && ch <= LOG4CPLUS_TEXT ('9'))
+            digit = static_cast<unsigned> (ch - LOG4CPLUS_TEXT ('0'));
+        else if (ch >= LOG4CPLUS_TEXT ('a') && ch <= LOG4CPLUS_TEXT ('f'))
+            digit = static_cast<unsigned> (ch - LOG4CPLUS_TEXT ('a') + 10);
+        else if (ch >= LOG4CPLUS_TEXT ('A') && ch <= LOG4CPLUS_TEXT ('F'))
+            digit = static_cast<unsigned> (ch - LOG4CPLUS_TEXT ('A') + 10);
+        else
+            return false;
+
+        if (i % 2 == 0)
+            dest[i / 2] = static_cast<char> (digit << 4);
+        else
+            dest[i / 2] = static_cast<char> (dest[i / 2] | digit);
+        nonZero |= digit != 0;
+    }
+
+    return nonZero;
+}
+
+
+} // namespace
+
+
+namespace internal
+{
+
+//! Queue of encoded log records and the exporter thread that sends
+//! them in batches.
+struct otlp_exporter
+{
+    explicit otlp_exporter (OtlpAppender & app)
+        : appender (app)
+    {
+        thread = std::thread ([this] { run (); });
+    }
+
+    ~otlp_exporter ()
+    {
+        stop ();
+    }
+
+    //! Encodes <code>event</code> into the queue or drops it when the
+    //! queue is full.
+    void
+    enqueue (spi::InternalLoggingEvent const & event)
+    {
+        std::unique_lock<std::mutex> lock (mtx);
+        if (exit || ends.size () >= appender.maxQueueSize)
+        {
+            ++stats.dropped;
+            lock.unlock ();
+            appender.recordDroppedEvent ();
+            return;
+        }
+
+        std::size_t const size = queue.size ();
+        try
+        {
+            std::size_t const start
+                = begin_message (queue, scope_logs_log_records);
+            appender.encodeLogRecord (queue, event);
+            end_message (queue, start);
+        }
+        catch (...)
+        {
+            queue.resize (size);
+            throw;
+        }
+
+        if (ends.empty ())
+            firstQueued = std::chrono::steady_clock::now ();
+        ends.push_back (queue.size ());
+        ++enqueued;
+        bool const wake = ends.size () == 1
+            || ends.size () == appender.maxExportBatchSize;
+        lock.unlock ();
+
+        if (wake)
+            cond.notify_one ();
+    }
+
+    bool
+    flush ()
+    {
+        std::unique_lock<std::mutex> lock (mtx);
+        std::uint64_t const target = enqueued;
+        std::uint64_t const failedBefore = stats.failed;
+        flushTarget = (std::max) (flushTarget, target);
+        cond.notify_one ();
+        done.wait (lock, [&] { return processed >= target || finished; });
+        return processed >= target && stats.failed == failedBefore;
+    }
+
+    //! Exports whatever is queued and joins the exporter thread.
+    void
+    stop ()
+    {
+        {
+            std::lock_guard<std::mutex> lock (mtx);
+            exit = true;
+        }
+        cond.notify_one ();
+
+        if (thread.joinable ())
+            thread.join ();
+    }
+
+    OtlpAppender::ExportStats
+    getStats () const
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        OtlpAppender::ExportStats ret = stats;
+        ret.queued = ends.size ();
+        return ret;
+    }
+
+private:
+    void
+    run ()
+    {
+        thread::blockAllSignals ();
+        thread::applyBackgroundThreadSettings (LOG4CPLUS_TEXT ("otlp"));
+
+        std::string batch;
+        std::vector<std::size_t> batchEnds;
+        std::unique_lock<std::mutex> lock (mtx);
+        for (;;)
+        {
+            cond.wait (lock, [this] { return exit || ! ends.empty (); });
+            if (ends.empty ())
+                break;
+
+            cond.wait_until (lock, firstQueued
+                + std::chrono::milliseconds (appender.scheduleDelay),
+                [this] {
+                    return exit || flushTarget > processed
+                        || ends.size () >= appender.maxExportBatchSize; });
+
+            // Take the whole queue; the emptied batch buffers become
+            // the new queue, so their capacity is reused.
+            batch.clear ();
+            batchEnds.clear ();
+            batch.swap (queue);
+            batchEnds.swap (ends);
+            lock.unlock ();
+
+            std::uint64_t exported = 0;
+            std::uint64_t failed = 0;
+            exportBatch (batch, batchEnds, exported, failed);
+
+            lock.lock ();
+            stats.exported += exported;
+            stats.failed += failed;
+            processed += batchEnds.size ();
+            done.notify_all ();
+        }
+
+        finished = true;
+        done.notify_all ();
+        lock.unlock ();
+        appender.socket.close ();
+    }
+
+    //! Sends records of <code>batch</code> in requests of at most
+    //! <tt>MaxExportBatchSize</tt> records. The records are sent where
+    //! they were encoded, only the enclosing messages are prepended.
+    void
+    exportBatch (std::string const & batch,
+        std::vector<std::size_t> const & batchEnds,
+        std::uint64_t & exported, std::uint64_t & failed)
+    {
+        std::size_t const maxBatch = appender.maxExportBatchSize;
+        std::size_t begin = 0;
+        for (std::size_t i = 0; i < batchEnds.size (); i += maxBatch)
+        {
+            std::size_t const last = (std::min) (i + maxBatch,
+                batchEnds.size ());
+            std::string_view const records (batch.data () + begin,
+                batchEnds[last - 1] - begin);
+            begin = batchEnds[last - 1];
+
+            std::size_t const scopeLogsSize
+                = appender.scope.size () + records.size ();
+            std::size_t const resourceLogsSize = appender.resource.size ()
+                + 1 + varint_size (scopeLogsSize) + scopeLogsSize;
+            prefix.clear ();
+            put_tag (prefix, request_resource_logs, wire_len);
+            put_varint (prefix, resourceLogsSize);
+            prefix += appender.resource;
+            put_tag (prefix, resource_logs_scope_logs, wire_len);
+            put_varint (prefix, scopeLogsSize);
+            prefix += appender.scope;
+
+            std::string_view const body[] = {prefix, records};
+            bool ok;
+            try
+            {
+                ok = appender.exportRequest (body);
+            }
+            catch (std::exception const & e)
+            {
+                helpers::getLogLog ().warn (
+                    LOG4CPLUS_TEXT ("OtlpAppender")
+                    LOG4CPLUS_TEXT ("- export failed: ")
+                    + LOG4CPLUS_C_STR_TO_TSTRING (e.what ()));
+                ok = false;
+            }
+
+            (ok ? exported : failed) += last - i;
+        }
+    }
+
+    OtlpAppender & appender;
+
+    // Accessed by exporter thread only.
+    std::string prefix;
+
+    mutable std::mutex mtx;
+    std::condition_variable cond;
+    //! Signalled when records have been processed.
+    std::condition_variable done;
+    //! Encoded <tt>log_records</tt> fields of <tt>ScopeLogs</tt>.
+    std::string queue;
+    //! End offsets of records in queue.
+    std::vector<std::size_t> ends;
+    std::chrono::steady_clock::time_point firstQueued;
+    //! Counts of records ever queued and exported or failed.
+    std::uint64_t enqueued = 0;
+    std::uint64_t processed = 0;
+    //! Value of enqueued that forceFlush() waits for.
+    std::uint64_t flushTarget = 0;
+    OtlpAppender::ExportStats stats;
+    bool exit = false;
+    bool finished = false;
+    std::thread thread;
+};
+
+} // namespace internal
+
+
+///////////////////////////////////////////////////////////////////////////////
+// OtlpAppender ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+OtlpAppender::OtlpAppender (tstring const & endpoint,
+    tstring const & serviceName)
+    : port (0)
+    , useTls (false)
+    , ipv6 (false)
+    , traceIdKey (LOG4CPLUS_TEXT ("trace_id"))
+    , spanIdKey (LOG4CPLUS_TEXT ("span_id"))
+    , maxExportBatchSize (512)
+    , scheduleDelay (1000)
+    , maxQueueSize (2048)
+{
+    init (endpoint, serviceName, tstring (), tstring (), nullptr);
+}
+
+
+OtlpAppender::OtlpAppender (helpers::Properties const & properties)
+    : Appender (properties)
+    , port (0)
+    , useTls (false)
+    , ipv6 (false)
+    , traceIdKey (LOG4CPLUS_TEXT ("trace_id"))
+    , spanIdKey (LOG4CPLUS_TEXT ("span_id"))
+    , maxExportBatchSize (512)
+    , scheduleDelay (1000)
+    , maxQueueSize (2048)
+{
+    properties.getBool (ipv6, LOG4CPLUS_TEXT ("IPv6"));
+    properties.getString (traceIdKey, LOG4CPLUS_TEXT ("TraceIdKey"));
+    properties.getString (spanIdKey, LOG4CPLUS_TEXT ("SpanIdKey"));
+
+    unsigned long value = 0;
+    if (properties.getULong (value, LOG4CPLUS_TEXT ("MaxExportBatchSize")))
+        maxExportBatchSize = (std::max) (value, 1ul);
+    properties.getUInt (scheduleDelay, LOG4CPLUS_TEXT ("ScheduleDelay"));
+    if (properties.getULong (value, LOG4CPLUS_TEXT ("MaxQueueSize")))
+        maxQueueSize = (std::max) (value, 1ul);
+
+    init (properties.getProperty (LOG4CPLUS_TEXT ("Endpoint"),
+            LOG4CPLUS_TEXT ("http://localhost:4318/v1/logs")),
+        properties.getProperty (LOG4CPLUS_TEXT ("ServiceName"),
+            LOG4CPLUS_TEXT ("unknown_service")),
+        properties.getProperty (LOG4CPLUS_TEXT ("ResourceAttributes")),
+        properties.getProperty (LOG4CPLUS_TEXT ("Headers")), &properties);
+}
+
+
+OtlpAppender::~OtlpAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+OtlpAppender::init (tstring const & endpoint, tstring const & serviceName,
+    tstring const & resourceAttributes, tstring const & headers,
+    helpers::Properties const * properties)
+{
+    internal::http_url url;
+    if (! internal::parse_http_url (url, endpoint,
+            LOG4CPLUS_TEXT ("/v1/logs")))
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("OtlpAppender")
+            LOG4CPLUS_TEXT ("- unsupported endpoint: ") + endpoint, true);
+
+    host = url.host;
+    port = url.port;
+    path = url.path;
+    useTls = url.tls;
+    ipv6 = ipv6 || url.ipv6;
+
+    if (useTls)
+    {
+        helpers::TlsConfig config;
+        config.serverName = host;
+        if (properties)
+        {
+            config.caFile = properties->getProperty (
+                LOG4CPLUS_TEXT ("TlsCAFile"));
+            config.certFile = properties->getProperty (
+                LOG4CPLUS_TEXT ("TlsCertFile"));
+            config.keyFile = properties->getProperty (
+                LOG4CPLUS_TEXT ("TlsKeyFile"));
+            properties->getString (config.serverName,
+                LOG4CPLUS_TEXT ("TlsServerName"));
+            properties->getBool (config.verifyPeer,
+                LOG4CPLUS_TEXT ("TlsVerifyPeer"));
+        }
+
+        tlsContext = helpers::createTlsContext (config);
+        if (! tlsContext)
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("OtlpAppender")
+                LOG4CPLUS_TEXT ("- TLS is not available"));
+    }
+
+    requestHeader = internal::http_post_header (url,
+        internal::parse_key_value_list (headers));
+    requestHeader += "Content-Type: application/x-protobuf\r\n";
+
+    std::size_t const resourceStart
+        = begin_message (resource, resource_logs_resource);
+    put_attribute (resource, resource_attributes,
+        LOG4CPLUS_TEXT ("service.name"), serviceName);
+    put_attribute (resource, resource_attributes,
+        LOG4CPLUS_TEXT ("host.name"),
+        helpers::getHostname (true).value_or (tstring ()));
+    for (auto const & attribute
+        : internal::parse_key_value_list (resourceAttributes))
+        put_attribute (resource, resource_attributes, attribute.first,
+            attribute.second);
+    end_message (resource, resourceStart);
+
+    std::size_t const scopeStart = begin_message (scope, scope_logs_scope);
+    put_bytes (scope, scope_name, "log4cplus");
+    put_bytes (scope, scope_version, LOG4CPLUS_VERSION_STR);
+    end_message (scope, scopeStart);
+
+    exporter.reset (new internal::otlp_exporter (*this));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// OtlpAppender public methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+OtlpAppender::close ()
+{
+    if (exporter)
+        exporter->stop ();
+
+    closed = true;
+}
+
+
+unsigned
+OtlpAppender::getRequiredEventFields () const
+{
+    return Appender::getRequiredEventFields ()
+        | spi::EVENT_FIELD_MDC | spi::EVENT_FIELD_THREAD
+        | spi::EVENT_FIELD_FILE | spi::EVENT_FIELD_FUNCTION;
+}
+
+
+bool
+OtlpAppender::forceFlush ()
+{
+    return exporter && exporter->flush ();
+}
+
+
+OtlpAppender::ExportStats
+OtlpAppender::getStats () const
+{
+    return exporter ? exporter->getStats () : ExportStats ();
+}
+
+
+void
+OtlpAppender::encodeLogRecord (std::string & out,
+    spi::InternalLoggingEvent const & event) const
+{
+    auto const since_epoch = [] (helpers::Time const & time) {
+        return static_cast<std::uint64_t> (
+            std::chrono::duration_cast<std::chrono::nanoseconds> (
+                time.time_since_epoch ()).count ()); };
+
+    put_fixed64 (out, log_record_time_unix_nano,
+        since_epoch (event.getTimestamp ()));
+    put_fixed64 (out, log_record_observed_time_unix_nano,
+        since_epoch (helpers::now ()));
+
+    LogLevel const ll = event.getLogLevel ();
+    put_tag (out, log_record_severity_number, wire_varint);
+    put_varint (out, severity_number (ll));
+    put_string (out, log_record_severity_text,
+        getLogLevelManager ().toString (ll));
+
+    std::size_t const body = begin_message (out, log_record_body);
+    put_string (out, any_value_string, event.getMessage ());
+    end_message (out, body);
+
+    put_attribute (out, log_record_attributes, LOG4CPLUS_TEXT ("logger.name"),
+        event.getLoggerName ());
+    if (! event.getThread ().empty ())
+        put_attribute (out, log_record_attributes,
+            LOG4CPLUS_TEXT ("thread.name"), event.getThread ());
+    if (! event.getFile ().empty ())
+    {
+        put_attribute (out, log_record_attributes,
+            LOG4CPLUS_TEXT ("code.file.path"), event.getFile ());
+
+        spi::KeyValue line;
+        line.key = LOG4CPLUS_TEXT ("code.line.number");
+        line.type = spi::KV_INT;
+        line.i = event.getLine ();
+        put_attribute (out, log_record_attributes, line);
+    }
+    if (! event.getFunction ().empty ())
+        put_attribute (out, log_record_attributes,
+            LOG4CPLUS_TEXT ("code.function.name"), event.getFunction ());
+
+    char traceId[16];
+    char spanId[8];
+    bool haveTraceId = false;
+    bool haveSpanId = false;
+    for (auto const & entry : event.getMDCCopy ())
+    {
+        if (entry.first == traceIdKey)
+            haveTraceId = parse_hex_id (traceId, sizeof (traceId),
+                entry.second);
+        else if (entry.first == spanIdKey)
+            haveSpanId = parse_hex_id (spanId, sizeof (spanId), entry.second);
+        else
+            put_attribute (out, log_record_attributes, entry.first,
+                entry.second);
+    }
+
+    spi::KeyValues const & kvs = event.getKeyValues ();
+    for (std::size_t i = 0; i != kvs.size (); ++i)
+        put_attribute (out, log_record_attributes, kvs[i]);
+
+    if (haveTraceId)
+        put_bytes (out, log_record_trace_id,
+            std::string_view (traceId, sizeof (traceId)));
+    if (haveSpanId)
+        put_bytes (out, log_record_span_id,
+            std::string_view (spanId, sizeof (spanId)));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// OtlpAppender protected methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+OtlpAppender::append (spi::InternalLoggingEvent const & event)
+{
+    exporter->enqueue (event);
+}
+
+
+bool
+OtlpAppender::exportRequest (std::span<std::string_view const> body)
+{
+    std::size_t size = 0;
+    for (std::string_view part : body)
+        size += part.size ();
+
+    std::string header = requestHeader;
+    header += "Content-Length: ";
+    header += std::to_string (size);
+    header += "\r\n\r\n";
+
+    std::vector<std::string_view> parts;
+    parts.reserve (body.size () + 1);
+    parts.push_back (header);
+    parts.insert (parts.end (), body.begin (), body.end ());
+
+    // Collector may have closed kept alive connection meanwhile; such
+    // request is retried once over new connection.
+    for (int attempt = 0; attempt != 2; ++attempt)
+    {
+        bool const reused = socket.isOpen ();
+        if (! reused && ! connect ())
+            return false;
+
+        int status = 0;
+        if (socket.write (parts))
+            status = internal::read_http_response (socket);
+        else
+            socket.close ();
+
+        if (status == 0)
+        {
+            if (reused)
+                continue;
+
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("OtlpAppender")
+                LOG4CPLUS_TEXT ("- no response from ") + host);
+            return false;
+        }
+
+        if (status / 100 == 2)
+            return true;
+
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("OtlpAppender")
+            LOG4CPLUS_TEXT ("- collector responded with status ")
+            + helpers::convertIntegerToString (status));
+        return false;
+    }
+
+    return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// OtlpAppender private methods
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+OtlpAppender::connect ()
+{
+    auto const now = std::chrono::steady_clock::now ();
+    if (now < nextConnect)
+        return false;
+
+    socket = helpers::Socket (host, port, false, ipv6);
+    if (socket.isOpen ()
+        && (! useTls || (tlsContext && socket.startTls (*tlsContext))))
+        return true;
+
+    // Do not hammer unreachable collector, batches exported while
+    // waiting for the next attempt fail.
+    socket.close ();
+    nextConnect = now + std::chrono::seconds (1);
+    helpers::getLogLog ().error (
+        LOG4CPLUS_TEXT ("OtlpAppender")
+        LOG4CPLUS_TEXT ("- failed to connect to ")
+        + host + LOG4CPLUS_TEXT (":")
+        + helpers::convertIntegerToString (port));
+    return false;
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+namespace
+{
+
+struct pb_field
+{
+    unsigned number;
+    std::uint64_t value;
+    std::string_view bytes;
+};
+
+
+//! Splits protobuf message into its fields.
+std::vector<pb_field>
+pb_parse (std::string_view msg)
+{
+    auto const varint = [&msg] {
+        std::uint64_t value = 0;
+        for (int shift = 0; ! msg.empty (); shift += 7)
+        {
+            unsigned char const byte = static_cast<unsigned char> (msg[0]);
+            msg.remove_prefix (1);
+            value |= std::uint64_t (byte & 0x7F) << shift;
+            if (! (byte & 0x80))
+                break;
+        }
+        return value;
+    };
+
+    std::vector<pb_field> fields;
+    while (! msg.empty ())
+    {
+        std::uint64_t const tag = varint ();
+        pb_field field {static_cast<unsigned> (tag >> 3), 0, {}};
+        switch (tag & 7)
+        {
+        case wire_varint:
+            field.value = varint ();
+            break;
+
+        case wire_fixed64:
+            for (int i = 0; i != 8; ++i)
+                field.value |= std::uint64_t (
+                    static_cast<unsigned char> (msg[i])) << (i * 8);
+            msg.remove_prefix (8);
+            break;
+
+        case wire_len:
+        {
+            std::size_t const size = static_cast<std::size_t> (varint ());
+            field.bytes = msg.substr (0, size);
+            msg.remove_prefix (size);
+            break;
+        }
+
+        default:
+            CATCH_FAIL ("unexpected wire type");
+        }
+        fields.push_back (field);
+    }
+
+    return fields;
+}
+
+
+std::vector<pb_field>
+pb_fields (std::string_view msg, unsigned number)
+{
+    std::vector<pb_field> ret;
+    for (pb_field const & field : pb_parse (msg))
+        if (field.number == number)
+            ret.push_back (field);
+    return ret;
+}
+
+
+//! \return Attributes of message as key and AnyValue message.
+std::vector<std::pair<std::string_view, std::string_view>>
+pb_attributes (std::string_view msg, unsigned number)
+{
+    std::vector<std::pair<std::string_view, std::string_view>> ret;
+    for (pb_field const & kv : pb_fields (msg, number))
+        ret.emplace_back (pb_fields (kv.bytes, key_value_key).at (0).bytes,
+            pb_fields (kv.bytes, key_value_value).at (0).bytes);
+    return ret;
+}
+
+
+class TestOtlpAppender
+    : public OtlpAppender
+{
+public:
+    explicit TestOtlpAppender (helpers::Properties const & props)
+        : OtlpAppender (props)
+    { }
+
+    ~TestOtlpAppender ()
+    {
+        destructorImpl ();
+    }
+
+    std::vector<std::string> requests;
+
+protected:
+    bool
+    exportRequest (std::span<std::string_view const> body) override
+    {
+        std::string request;
+        for (std::string_view part : body)
+            request.append (part);
+        requests.push_back (std::move (request));
+        return true;
+    }
+};
+
+} // namespace
+
+
+CATCH_TEST_CASE ("OtlpAppender", "[appender][otlp]")
+{
+    CATCH_SECTION ("varint length of large message")
+    {
+        std::string out;
+        std::size_t const start = begin_message (out, 5);
+        out.append (300, 'x');
+        end_message (out, start);
+        auto const fields = pb_parse (out);
+        CATCH_REQUIRE (fields.size () == 1);
+        CATCH_REQUIRE (fields[0].number == 5);
+        CATCH_REQUIRE (fields[0].bytes == std::string (300, 'x'));
+    }
+
+    CATCH_SECTION ("batches and encoding")
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("Endpoint"),
+            LOG4CPLUS_TEXT ("http://collector.invalid:4318/v1/logs"));
+        props.setProperty (LOG4CPLUS_TEXT ("ServiceName"),
+            LOG4CPLUS_TEXT ("svc"));
+        props.setProperty (LOG4CPLUS_TEXT ("ResourceAttributes"),
+            LOG4CPLUS_TEXT ("deployment.environment = test"));
+        props.setProperty (LOG4CPLUS_TEXT ("MaxExportBatchSize"),
+            LOG4CPLUS_TEXT ("2"));
+        props.setProperty (LOG4CPLUS_TEXT ("ScheduleDelay"),
+            LOG4CPLUS_TEXT ("60000"));
+        helpers::SharedObjectPtr<TestOtlpAppender> app (
+            new TestOtlpAppender (props));
+
+        MDC & mdc = getMDC ();
+        mdc.put (LOG4CPLUS_TEXT ("trace_id"),
+            LOG4CPLUS_TEXT ("4bf92f3577b34da6a3ce929d0e0e4736"));
+        mdc.put (LOG4CPLUS_TEXT ("span_id"),
+            LOG4CPLUS_TEXT ("00f067aa0ba902b7"));
+        mdc.put (LOG4CPLUS_TEXT ("user"), LOG4CPLUS_TEXT ("alice"));
+
+        spi::InternalLoggingEvent event (LOG4CPLUS_TEXT ("a.b"),
+            WARN_LOG_LEVEL, LOG4CPLUS_TEXT ("first"), "file.cxx", 42,
+            "func");
+        event.getKeyValues ().add (LOG4CPLUS_TEXT ("count"), 7);
+        app->doAppend (event);
+        mdc.clear ();
+        app->doAppend (spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("a"),
+            INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("second"), nullptr, 0));
+        app->doAppend (spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("a"),
+            ERROR_LOG_LEVEL, LOG4CPLUS_TEXT ("third"), nullptr, 0));
+
+        // First two records fill a batch, the third one waits for
+        // ScheduleDelay or flush.
+        CATCH_REQUIRE (app->forceFlush ());
+        OtlpAppender::ExportStats const stats = app->getStats ();
+        CATCH_REQUIRE (stats.exported == 3);
+        CATCH_REQUIRE (stats.dropped == 0);
+        CATCH_REQUIRE (stats.queued == 0);
+        CATCH_REQUIRE (app->requests.size () == 2);
+
+        auto const resourceLogs = pb_fields (app->requests[0],
+            request_resource_logs);
+        CATCH_REQUIRE (resourceLogs.size () == 1);
+        auto const resource = pb_fields (resourceLogs[0].bytes,
+            resource_logs_resource).at (0).bytes;
+        auto const resAttrs = pb_attributes (resource, resource_attributes);
+        CATCH_REQUIRE (resAttrs.size () == 3);
+        CATCH_REQUIRE (resAttrs[0].first == "service.name");
+        CATCH_REQUIRE (pb_fields (resAttrs[0].second, any_value_string)
+            .at (0).bytes == "svc");
+        CATCH_REQUIRE (resAttrs[2].first == "deployment.environment");
+
+        auto const scopeLogs = pb_fields (resourceLogs[0].bytes,
+            resource_logs_scope_logs).at (0).bytes;
+        auto const scope = pb_fields (scopeLogs, scope_logs_scope)
+            .at (0).bytes;
+        CATCH_REQUIRE (pb_fields (scope, scope_name).at (0).bytes
+            == "log4cplus");
+        auto const records = pb_fields (scopeLogs, scope_logs_log_records);
+        CATCH_REQUIRE (records.size () == 2);
+
+        std::string_view const first = records[0].bytes;
+        CATCH_REQUIRE (pb_fields (first, log_record_time_unix_nano).at (0)
+            .value == static_cast<std::uint64_t> (
+                std::chrono::duration_cast<std::chrono::nanoseconds> (
+                    event.getTimestamp ().time_since_epoch ()).count ()));
+        CATCH_REQUIRE (pb_fields (first, log_record_severity_number).at (0)
+            .value == 13);
+        CATCH_REQUIRE (pb_fields (first, log_record_severity_text).at (0)
+            .bytes == "WARN");
+        CATCH_REQUIRE (pb_fields (pb_fields (first, log_record_body).at (0)
+            .bytes, any_value_string).at (0).bytes == "first");
+        CATCH_REQUIRE (pb_fields (first, log_record_trace_id).at (0).bytes
+            == std::string_view ("\x4b\xf9\x2f\x35\x77\xb3\x4d\xa6"
+                "\xa3\xce\x92\x9d\x0e\x0e\x47\x36", 16));
+        CATCH_REQUIRE (pb_fields (first, log_record_span_id).at (0).bytes
+            == std::string_view ("\x00\xf0\x67\xaa\x0b\xa9\x02\xb7", 8));
+
+        std::map<std::string_view, std::string_view> attrs;
+        for (auto const & attr : pb_attributes (first, log_record_attributes))
+            attrs.insert (attr);
+        CATCH_REQUIRE (pb_fields (attrs.at ("logger.name"), any_value_string)
+            .at (0).bytes == "a.b");
+        CATCH_REQUIRE (pb_fields (attrs.at ("code.line.number"),
+            any_value_int).at (0).value == 42);
+        CATCH_REQUIRE (pb_fields (attrs.at ("code.function.name"),
+            any_value_string).at (0).bytes == "func");
+        CATCH_REQUIRE (pb_fields (attrs.at ("user"), any_value_string)
+            .at (0).bytes == "alice");
+        CATCH_REQUIRE (pb_fields (attrs.at ("count"), any_value_int)
+            .at (0).value == 7);
+        CATCH_REQUIRE (attrs.count ("trace_id") == 0);
+
+        // The second record has no trace context.
+        CATCH_REQUIRE (pb_fields (records[1].bytes, log_record_trace_id)
+            .empty ());
+        CATCH_REQUIRE (pb_fields (records[1].bytes,
+            log_record_severity_number).at (0).value == 9);
+
+        auto const lastRecords = pb_fields (pb_fields (pb_fields (
+            app->requests[1], request_resource_logs).at (0).bytes,
+            resource_logs_scope_logs).at (0).bytes, scope_logs_log_records);
+        CATCH_REQUIRE (lastRecords.size () == 1);
+        CATCH_REQUIRE (pb_fields (lastRecords[0].bytes,
+            log_record_severity_number).at (0).value == 17);
+
+        app->close ();
+    }
+
+    CATCH_SECTION ("queue limit")
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("MaxQueueSize"),
+            LOG4CPLUS_TEXT ("2"));
+        props.setProperty (LOG4CPLUS_TEXT ("MaxExportBatchSize"),
+            LOG4CPLUS_TEXT ("100"));
+        props.setProperty (LOG4CPLUS_TEXT ("ScheduleDelay"),
+            LOG4CPLUS_TEXT ("60000"));
+        helpers::SharedObjectPtr<TestOtlpAppender> app (
+            new TestOtlpAppender (props));
+
+        for (int i = 0; i != 5; ++i)
+            app->doAppend (spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("a"),
+                INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("x"), nullptr, 0));
+
+        CATCH_REQUIRE (app->getStats ().dropped == 3);
+        app->close ();
+        CATCH_REQUIRE (app->getStats ().exported == 2);
+        CATCH_REQUIRE (app->requests.size () == 1);
+    }
+}
+
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_SINGLE_THREADED
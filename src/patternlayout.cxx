@@ -19,6 +19,7 @@
 // limitations under the License.
 
 #include <log4cplus/layout.h>
+#include <log4cplus/staticpatternlayout.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/helpers/timehelper.h>
 #include <log4cplus/helpers/stringhelper.h>
@@ -27,17 +28,26 @@
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/internal/env.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <limits>
 #include <cstdlib>
 #include <memory>
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#endif
+
 
 namespace
 {
 
 
 static
-log4cplus::tstring
+log4cplus::tstring_view
 get_basename (const log4cplus::tstring& filename)
 {
 #if defined(_WIN32)
@@ -48,12 +58,30 @@ get_basename (const log4cplus::tstring& filename)
 
     log4cplus::tstring::size_type pos = filename.rfind(dir_sep);
     if (pos != log4cplus::tstring::npos)
-        return filename.substr(pos+1);
+        return log4cplus::tstring_view (filename).substr(pos+1);
     else
         return filename;
 }
 
 
+//! Appends all key/value fields in the same form as %X appends MDC.
+static
+void
+appendAllKeyValues (log4cplus::tstring & result,
+    log4cplus::spi::KeyValues const & kvs)
+{
+    for (std::size_t i = 0; i != kvs.size (); ++i)
+    {
+        log4cplus::spi::KeyValue const kv = kvs[i];
+        result += LOG4CPLUS_TEXT("{");
+        result += kv.key;
+        result += LOG4CPLUS_TEXT(", ");
+        log4cplus::spi::KeyValues::appendValue (result, kv);
+        result += LOG4CPLUS_TEXT("}");
+    }
+}
+
+
 } // namespace
 
 
@@ -62,9 +90,6 @@ namespace log4cplus
 
 static tchar const ESCAPE_CHAR = LOG4CPLUS_TEXT('%');
 
-extern void formatRelativeTimestamp (log4cplus::tostream & output,
-    log4cplus::spi::InternalLoggingEvent const & event);
-
 
 namespace pattern
 {
@@ -98,12 +123,22 @@ class PatternConverter
 public:
     explicit PatternConverter(const FormattingInfo& info);
     virtual ~PatternConverter() = default;
-    void formatAndAppend(tostream& output,
+
+    //! Appends the field to <code>output</code> and applies minimal and
+    //! maximal width and alignment to it in place.
+    void formatAndAppend(tstring& output,
         const spi::InternalLoggingEvent& event);
 
+    //! Appends unpadded value of the field to <code>result</code>.
     virtual void convert(tstring & result,
         const spi::InternalLoggingEvent& event) = 0;
 
+    //! Returns combination of spi::EventFields that convert() reads.
+    virtual unsigned getRequiredEventFields() const
+    {
+        return spi::EVENT_FIELDS_NONE;
+    }
+
 private:
     int minLen;
     std::size_t maxLen;
@@ -126,7 +161,7 @@ public:
     void convert(tstring & result,
         const spi::InternalLoggingEvent&) override
     {
-        result = str;
+        result += str;
     }
 
 private:
@@ -145,7 +180,6 @@ public:
     enum Type { THREAD_CONVERTER,
                 THREAD2_CONVERTER,
                 PROCESS_CONVERTER,
-                LOGLEVEL_CONVERTER,
                 NDC_CONVERTER,
                 MESSAGE_CONVERTER,
                 NEWLINE_CONVERTER,
@@ -157,14 +191,58 @@ public:
     BasicPatternConverter(const FormattingInfo& info, Type type);
     void convert(tstring & result,
         const spi::InternalLoggingEvent& event) override;
+    unsigned getRequiredEventFields() const override;
 
 private:
   // Disable copy
     BasicPatternConverter(const BasicPatternConverter&) = delete;
     BasicPatternConverter& operator=(BasicPatternConverter&) = delete;
 
-    LogLevelManager& llmCache;
     Type type;
+    //! Id of per-thread cache entries of FULL_LOCATION_CONVERTER.
+    std::uint64_t cacheId;
+};
+
+
+
+/**
+ * This PatternConverter is used to format the LogLevel field found in
+ * the InternalLoggingEvent object. Level names are looked up in
+ * LogLevelManager once and kept already padded or trimmed in a table
+ * that is rebuilt when LogLevelManager::getGeneration() changes.
+ */
+class LogLevelPatternConverter : public PatternConverter
+{
+public:
+    explicit LogLevelPatternConverter(const FormattingInfo& info);
+    void convert(tstring & result,
+        const spi::InternalLoggingEvent& event) override;
+
+private:
+    struct Table
+    {
+        unsigned generation;
+        //! Names of levels TRACE (0), DEBUG (10000), ..., OFF (60000).
+        std::array<tstring, 7> builtin;
+        //! Names of other levels seen so far, sorted by level.
+        std::vector<std::pair<LogLevel, tstring> > others;
+    };
+
+    static constexpr std::size_t MAX_OTHER_LEVELS = 64;
+
+    tstring formatName(LogLevel ll) const;
+    Table const * rebuildTable(LogLevel ll);
+    static tstring const * find(Table const & table, LogLevel ll);
+
+    LogLevelManager& llmCache;
+    FormattingInfo info;
+
+    //! Current table, read without locking.
+    std::atomic<Table const *> table;
+
+    //! Serializes rebuildTable() and owns all published tables.
+    thread::Mutex tablesMutex;
+    std::vector<std::unique_ptr<Table const> > tables;
 };
 
 
@@ -181,6 +259,8 @@ public:
 
 private:
     int precision;
+    //! Id of per-thread cache entries of abbreviated names.
+    std::uint64_t cacheId;
 };
 
 
@@ -199,8 +279,25 @@ public:
         const spi::InternalLoggingEvent& event) override;
 
 private:
+    bool canFormatFast() const;
+    void formatFast(tstring & output, tstring const & segment,
+        tm const & time) const;
+
     bool use_gmtime;
     tstring format;
+
+    //! Date format split at %q, %Q and %N specifiers.
+    std::vector<tstring> segments;
+    //! Set when <code>segments</code> use only numeric specifiers, %b
+    //! and %%, that are formatted by formatFast() instead of strftime().
+    bool fast;
+    //! Month names for %b, taken from strftime() when the converter is
+    //! created.
+    std::array<tstring, 12> monthNames;
+    //! Sub-second specifiers, between each two of <code>segments</code>.
+    tstring subsecond;
+    //! Unique id identifying this converter in per-thread date cache.
+    std::uint64_t cacheId;
 };
 
 
@@ -228,6 +325,16 @@ public:
 };
 
 
+//! Formats sequence number of the event, see
+//! spi::InternalLoggingEvent::getSequenceNumber().
+class SequenceNumberConverter: public PatternConverter {
+public:
+    explicit SequenceNumberConverter(const FormattingInfo& info);
+    void convert(tstring & result,
+        const spi::InternalLoggingEvent& event) override;
+};
+
+
 /**
  * This PatternConverter is used to format the hostname field.
  */
@@ -254,9 +361,47 @@ public:
     MDCPatternConverter(const FormattingInfo& info, tstring const & k);
     void convert(tstring & result,
         const spi::InternalLoggingEvent& event) override;
+    unsigned getRequiredEventFields() const override
+    {
+        return spi::EVENT_FIELD_MDC;
+    }
 
 private:
     tstring key;
+    //! Registered <code>key</code>; nothing is looked up by name.
+    MDCKey keyHandle;
+};
+
+
+/**
+ * This PatternConverter is used to format the key/value fields of
+ * the InternalLoggingEvent object, optionally limited to the field
+ * named \c k.
+ */
+class KeyValuesPatternConverter
+    : public PatternConverter
+{
+public:
+    KeyValuesPatternConverter(const FormattingInfo& info, tstring const & k);
+    void convert(tstring & result,
+        const spi::InternalLoggingEvent& event) override;
+
+private:
+    tstring key;
+};
+
+
+/**
+ * This PatternConverter is used to format the stack trace of the
+ * InternalLoggingEvent object, one frame per line.
+ */
+class StackTracePatternConverter
+    : public PatternConverter
+{
+public:
+    explicit StackTracePatternConverter(const FormattingInfo& info);
+    void convert(tstring & result,
+        const spi::InternalLoggingEvent& event) override;
 };
 
 
@@ -270,9 +415,15 @@ public:
     NDCPatternConverter(const FormattingInfo& info, int precision);
     void convert(tstring & result,
         const spi::InternalLoggingEvent& event) override;
+    unsigned getRequiredEventFields() const override
+    {
+        return spi::EVENT_FIELD_NDC;
+    }
 
 private:
     int precision;
+    //! Id of per-thread cache entries of abbreviated names.
+    std::uint64_t cacheId;
 };
 
 
@@ -355,32 +506,27 @@ PatternConverter::PatternConverter(const FormattingInfo& i)
 
 void
 PatternConverter::formatAndAppend(
-    tostream& output, const spi::InternalLoggingEvent& event)
+    tstring& output, const spi::InternalLoggingEvent& event)
 {
-    tstring & s = internal::get_ptd ()->faa_str;
-    convert (s, event);
-    std::size_t len = s.length();
+    std::size_t const start = output.length ();
+    convert (output, event);
+    std::size_t const len = output.length () - start;
 
     if (len > maxLen)
     {
         if (trimStart)
-            output << s.substr(len - maxLen);
+            output.erase (start, len - maxLen);
         else
-            output << s.substr(0, maxLen);
+            output.resize (start + maxLen);
     }
     else if (static_cast<int>(len) < minLen)
     {
-        std::ios_base::fmtflags const original_flags = output.flags ();
-        tchar const fill = output.fill (LOG4CPLUS_TEXT(' '));
-        output.setf (leftAlign ? std::ios_base::left : std::ios_base::right,
-            std::ios_base::adjustfield);
-        output.width (minLen);
-        output << s;
-        output.fill (fill);
-        output.flags (original_flags);
+        std::size_t const fill = static_cast<std::size_t>(minLen) - len;
+        if (leftAlign)
+            output.append (fill, LOG4CPLUS_TEXT(' '));
+        else
+            output.insert (start, fill, LOG4CPLUS_TEXT(' '));
     }
-    else
-        output << s;
 }
 
 
@@ -410,8 +556,9 @@ LiteralPatternConverter::LiteralPatternConverter(
 BasicPatternConverter::BasicPatternConverter(
     const FormattingInfo& info, Type type_)
     : PatternConverter(info)
-    , llmCache(getLogLevelManager())
     , type(type_)
+    , cacheId(type_ == FULL_LOCATION_CONVERTER
+        ? internal::new_date_cache_id() : 0)
 {
 }
 
@@ -421,73 +568,229 @@ void
 BasicPatternConverter::convert(tstring & result,
     const spi::InternalLoggingEvent& event)
 {
+    tstring & tmp = internal::get_ptd ()->faa_str;
+
     switch(type)
     {
-    case LOGLEVEL_CONVERTER:
-        result = llmCache.toString(event.getLogLevel());
-        return;
-
     case BASENAME_CONVERTER:
-        result = get_basename(event.getFile());
+        result += get_basename(event.getFile());
         return;
 
     case PROCESS_CONVERTER:
-        helpers::convertIntegerToString(result, internal::get_process_id ());
+        helpers::convertIntegerToString(tmp, internal::get_process_id ());
+        result += tmp;
         return;
 
     case NDC_CONVERTER:
-        result = event.getNDC();
+        result += event.getNDC();
         return;
 
     case MESSAGE_CONVERTER:
-        result = event.getMessage();
+        result += event.getMessage();
         return;
 
     case NEWLINE_CONVERTER:
-        result = LOG4CPLUS_TEXT("\n");
+        result += LOG4CPLUS_TEXT("\n");
         return;
 
     case FILE_CONVERTER:
-        result = event.getFile();
+        result += event.getFile();
         return;
 
     case THREAD_CONVERTER:
-        result = event.getThread();
+        result += event.getThread();
         return;
 
     case THREAD2_CONVERTER:
-        result = event.getThread2();
+        result += event.getThread2();
         return;
 
     case LINE_CONVERTER:
         {
             if(event.getLine() != -1)
-                helpers::convertIntegerToString(result, event.getLine());
-            else
-                result.clear ();
+            {
+                helpers::convertIntegerToString(tmp, event.getLine());
+                result += tmp;
+            }
             return;
         }
 
     case FULL_LOCATION_CONVERTER:
         {
             tstring const & file = event.getFile();
-            if (! file.empty ())
+            if (file.empty ())
             {
-                result = file;
                 result += LOG4CPLUS_TEXT(":");
-                result += helpers::convertIntegerToString(event.getLine());
+                return;
             }
-            else
-                result = LOG4CPLUS_TEXT(":");
+
+            // Call sites repeat, format file:line once per thread.
+            bool hit;
+            internal::converter_cache_entry & entry
+                = internal::get_converter_cache_entry(internal::get_ptd (),
+                    cacheId, file, event.getLine(), hit);
+            if (! hit)
+            {
+                entry.value = file;
+                entry.value += LOG4CPLUS_TEXT(":");
+                helpers::convertIntegerToString(tmp, event.getLine());
+                entry.value += tmp;
+            }
+            result += entry.value;
             return;
         }
 
     case FUNCTION_CONVERTER:
-        result = event.getFunction ();
+        result += event.getFunction ();
         return;
     }
 
-    result = LOG4CPLUS_TEXT("INTERNAL LOG4CPLUS ERROR");
+    result += LOG4CPLUS_TEXT("INTERNAL LOG4CPLUS ERROR");
+}
+
+
+unsigned
+BasicPatternConverter::getRequiredEventFields() const
+{
+    switch(type)
+    {
+    case NDC_CONVERTER:
+        return spi::EVENT_FIELD_NDC;
+
+    case BASENAME_CONVERTER:
+    case FILE_CONVERTER:
+    case FULL_LOCATION_CONVERTER:
+        return spi::EVENT_FIELD_FILE;
+
+    case THREAD_CONVERTER:
+        return spi::EVENT_FIELD_THREAD;
+
+    case THREAD2_CONVERTER:
+        return spi::EVENT_FIELD_THREAD2;
+
+    case FUNCTION_CONVERTER:
+        return spi::EVENT_FIELD_FUNCTION;
+
+    default:
+        return spi::EVENT_FIELDS_NONE;
+    }
+}
+
+
+
+////////////////////////////////////////////////
+// LogLevelPatternConverter methods:
+////////////////////////////////////////////////
+
+// Padding is applied to the cached names, the base does not pad again.
+LogLevelPatternConverter::LogLevelPatternConverter(const FormattingInfo& i)
+    : PatternConverter(FormattingInfo())
+    , llmCache(getLogLevelManager())
+    , info(i)
+    , table(nullptr)
+{
+    rebuildTable(NOT_SET_LOG_LEVEL);
+}
+
+
+void
+LogLevelPatternConverter::convert(tstring & result,
+    const spi::InternalLoggingEvent& event)
+{
+    LogLevel const ll = event.getLogLevel();
+    Table const * t = table.load(std::memory_order_acquire);
+    if (t->generation != llmCache.getGeneration())
+        t = rebuildTable(NOT_SET_LOG_LEVEL);
+
+    tstring const * name = find(*t, ll);
+    if (! name)
+        name = find(*rebuildTable(ll), ll);
+
+    if (name)
+        result += *name;
+    else
+        result += formatName(ll);
+}
+
+
+tstring
+LogLevelPatternConverter::formatName(LogLevel ll) const
+{
+    tstring name = llmCache.toString(ll);
+    std::size_t const len = name.length();
+    if (len > info.maxLen)
+    {
+        if (info.trimStart)
+            name.erase(0, len - info.maxLen);
+        else
+            name.resize(info.maxLen);
+    }
+    else if (static_cast<int>(len) < info.minLen)
+    {
+        std::size_t const fill = static_cast<std::size_t>(info.minLen) - len;
+        if (info.leftAlign)
+            name.append(fill, LOG4CPLUS_TEXT(' '));
+        else
+            name.insert(0, fill, LOG4CPLUS_TEXT(' '));
+    }
+
+    return name;
+}
+
+
+LogLevelPatternConverter::Table const *
+LogLevelPatternConverter::rebuildTable(LogLevel ll)
+{
+    thread::MutexGuard guard (tablesMutex);
+
+    unsigned const generation = llmCache.getGeneration();
+    Table const * const current = table.load(std::memory_order_relaxed);
+    std::unique_ptr<Table> t;
+    if (current && current->generation == generation)
+    {
+        // Another thread might have added the level already.
+        if (find(*current, ll)
+            || current->others.size() >= MAX_OTHER_LEVELS)
+            return current;
+
+        t = std::make_unique<Table>(*current);
+    }
+    else
+    {
+        t = std::make_unique<Table>();
+        t->generation = generation;
+        for (std::size_t i = 0; i != t->builtin.size(); ++i)
+            t->builtin[i] = formatName(static_cast<LogLevel>(i * 10000));
+    }
+
+    if (! find(*t, ll))
+    {
+        auto it = std::lower_bound(t->others.begin(), t->others.end(), ll,
+            [](auto const & item, LogLevel key) { return item.first < key; });
+        t->others.emplace(it, ll, formatName(ll));
+    }
+
+    // Replaced tables stay alive, other threads may still be reading them.
+    Table const * const result = t.get();
+    table.store(result, std::memory_order_release);
+    tables.push_back(std::move(t));
+    return result;
+}
+
+
+tstring const *
+LogLevelPatternConverter::find(Table const & t, LogLevel ll)
+{
+    if (ll >= 0 && ll % 10000 == 0
+        && static_cast<std::size_t>(ll / 10000) < t.builtin.size())
+        return &t.builtin[ll / 10000];
+
+    auto it = std::lower_bound(t.others.begin(), t.others.end(), ll,
+        [](auto const & item, LogLevel key) { return item.first < key; });
+    if (it != t.others.end() && it->first == ll)
+        return &it->second;
+
+    return nullptr;
 }
 
 
@@ -500,6 +803,7 @@ LoggerPatternConverter::LoggerPatternConverter(
     const FormattingInfo& info, int prec)
     : PatternConverter(info)
     , precision(prec)
+    , cacheId(prec > 0 ? internal::new_date_cache_id() : 0)
 {
 }
 
@@ -511,24 +815,17 @@ LoggerPatternConverter::convert(tstring & result,
 {
     const tstring& name = event.getLoggerName();
     if (precision <= 0) {
-        result = name;
+        result += name;
     }
     else {
-        auto len = name.length();
-
-        // We substract 1 from 'len' when assigning to 'end' to avoid out of
-        // bounds exception in return r.substring(end+1, len). This can happen
-        // if precision is 1 and the logger name ends with a dot.
-        auto end = len - 1;
-        for (int i = precision; i > 0; --i)
-        {
-            end = name.rfind(LOG4CPLUS_TEXT('.'), end - 1);
-            if(end == tstring::npos) {
-                result = name;
-                return;
-            }
-        }
-        result.assign (name, end + 1, tstring::npos);
+        // Logger names do not change, abbreviate each once per thread.
+        bool hit;
+        internal::converter_cache_entry & entry
+            = internal::get_converter_cache_entry(internal::get_ptd (),
+                cacheId, name, 0, hit);
+        if (! hit)
+            entry.value = pattern::staticLoggerName(name, precision);
+        result += entry.value;
     }
 }
 
@@ -545,7 +842,180 @@ DatePatternConverter::DatePatternConverter(
     : PatternConverter(info)
     , use_gmtime(use_gmtime_)
     , format(pattern)
+    , fast(false)
+    , cacheId(0)
 {
+    cacheId = internal::new_date_cache_id();
+
+    // Split the format the same way helpers::getFormattedTime() walks it
+    // so that escaped %% is not mistaken for start of %q, %Q or %N.
+    tstring segment;
+    bool percent = false;
+    for (tchar const ch : format)
+    {
+        if (percent)
+        {
+            percent = false;
+            if (ch == LOG4CPLUS_TEXT('q') || ch == LOG4CPLUS_TEXT('Q')
+                || ch == LOG4CPLUS_TEXT('N'))
+            {
+                segments.push_back(std::move(segment));
+                segment.clear();
+                subsecond.push_back(ch);
+                continue;
+            }
+            segment.push_back(LOG4CPLUS_TEXT('%'));
+            segment.push_back(ch);
+        }
+        else if (ch == LOG4CPLUS_TEXT('%'))
+            percent = true;
+        else
+            segment.push_back(ch);
+    }
+    // Trailing lone % is dropped by getFormattedTime() as well.
+    segments.push_back(std::move(segment));
+
+    fast = canFormatFast();
+    if (fast && format.find(LOG4CPLUS_TEXT("%b")) != tstring::npos)
+    {
+        tm month_tm{};
+        month_tm.tm_year = 100;
+        month_tm.tm_mday = 15;
+        month_tm.tm_hour = 12;
+        month_tm.tm_isdst = -1;
+        for (int i = 0; i != 12; ++i)
+        {
+            month_tm.tm_mon = i;
+            monthNames[i] = helpers::getFormattedTime(LOG4CPLUS_TEXT("%b"),
+                helpers::from_struct_tm(&month_tm), false);
+        }
+    }
+}
+
+
+bool
+DatePatternConverter::canFormatFast() const
+{
+    for (tstring const & segment : segments)
+        for (std::size_t i = 0; i != segment.size(); ++i)
+            if (segment[i] == LOG4CPLUS_TEXT('%'))
+                switch (segment[++i])
+                {
+                case LOG4CPLUS_TEXT('Y'):
+                case LOG4CPLUS_TEXT('y'):
+                case LOG4CPLUS_TEXT('m'):
+                case LOG4CPLUS_TEXT('d'):
+                case LOG4CPLUS_TEXT('H'):
+                case LOG4CPLUS_TEXT('M'):
+                case LOG4CPLUS_TEXT('S'):
+                case LOG4CPLUS_TEXT('j'):
+                case LOG4CPLUS_TEXT('F'):
+                case LOG4CPLUS_TEXT('T'):
+                case LOG4CPLUS_TEXT('b'):
+                case LOG4CPLUS_TEXT('%'):
+                    break;
+
+                default:
+                    return false;
+                }
+
+    return true;
+}
+
+
+namespace
+{
+
+//! Appends <code>value</code> as exactly <code>digits</code> decimal
+//! digits.
+void
+appendDigits(tstring & output, int value, int digits)
+{
+    tchar buf[9];
+    for (int i = digits - 1; i >= 0; --i)
+    {
+        buf[i] = static_cast<tchar>(LOG4CPLUS_TEXT('0') + value % 10);
+        value /= 10;
+    }
+    output.append(buf, static_cast<std::size_t>(digits));
+}
+
+} // namespace
+
+
+void
+DatePatternConverter::formatFast(tstring & output, tstring const & segment,
+    tm const & time) const
+{
+    int const year = time.tm_year + 1900;
+    for (std::size_t i = 0; i != segment.size(); ++i)
+    {
+        tchar const ch = segment[i];
+        if (ch != LOG4CPLUS_TEXT('%'))
+        {
+            output += ch;
+            continue;
+        }
+
+        switch (segment[++i])
+        {
+        case LOG4CPLUS_TEXT('Y'):
+            appendDigits(output, year, 4);
+            break;
+
+        case LOG4CPLUS_TEXT('y'):
+            appendDigits(output, year % 100, 2);
+            break;
+
+        case LOG4CPLUS_TEXT('m'):
+            appendDigits(output, time.tm_mon + 1, 2);
+            break;
+
+        case LOG4CPLUS_TEXT('d'):
+            appendDigits(output, time.tm_mday, 2);
+            break;
+
+        case LOG4CPLUS_TEXT('H'):
+            appendDigits(output, time.tm_hour, 2);
+            break;
+
+        case LOG4CPLUS_TEXT('M'):
+            appendDigits(output, time.tm_min, 2);
+            break;
+
+        case LOG4CPLUS_TEXT('S'):
+            appendDigits(output, time.tm_sec, 2);
+            break;
+
+        case LOG4CPLUS_TEXT('j'):
+            appendDigits(output, time.tm_yday + 1, 3);
+            break;
+
+        case LOG4CPLUS_TEXT('F'):
+            appendDigits(output, year, 4);
+            output += LOG4CPLUS_TEXT('-');
+            appendDigits(output, time.tm_mon + 1, 2);
+            output += LOG4CPLUS_TEXT('-');
+            appendDigits(output, time.tm_mday, 2);
+            break;
+
+        case LOG4CPLUS_TEXT('T'):
+            appendDigits(output, time.tm_hour, 2);
+            output += LOG4CPLUS_TEXT(':');
+            appendDigits(output, time.tm_min, 2);
+            output += LOG4CPLUS_TEXT(':');
+            appendDigits(output, time.tm_sec, 2);
+            break;
+
+        case LOG4CPLUS_TEXT('b'):
+            output += monthNames[time.tm_mon];
+            break;
+
+        case LOG4CPLUS_TEXT('%'):
+            output += LOG4CPLUS_TEXT('%');
+            break;
+        }
+    }
 }
 
 
@@ -554,8 +1024,70 @@ void
 DatePatternConverter::convert(tstring & result,
     const spi::InternalLoggingEvent& event)
 {
-    result = helpers::getFormattedTime(format, event.getTimestamp(),
-        use_gmtime);
+    // Formatting via localtime/gmtime and strftime is expensive. Cache the
+    // formatted segments for the current second, per thread, and patch in
+    // only the sub-second values. Time zone changes are picked up when
+    // the next second starts.
+
+    helpers::Time const & timestamp = event.getTimestamp();
+    time_t const seconds = helpers::to_time_t(timestamp);
+    internal::per_thread_data * ptd = internal::get_ptd();
+
+    internal::date_cache_entry * entry = &internal::get_date_cache_entry(
+        ptd, cacheId, segments.size(), seconds);
+
+    if (entry->seconds != seconds)
+    {
+        helpers::Time const second_start = helpers::from_time_t(seconds);
+        tm time{};
+        if (fast)
+        {
+            if (use_gmtime)
+                helpers::gmTime(&time, second_start);
+            else
+                helpers::localTime(&time, second_start);
+        }
+
+        // The fast path always writes four digits of %Y, years out of
+        // that range go through strftime().
+        int const year = time.tm_year + 1900;
+        if (fast && year >= 1000 && year <= 9999)
+            for (std::size_t i = 0; i != segments.size(); ++i)
+            {
+                entry->parts[i].clear();
+                formatFast(entry->parts[i], segments[i], time);
+            }
+        else
+            for (std::size_t i = 0; i != segments.size(); ++i)
+                entry->parts[i] = helpers::getFormattedTime(segments[i],
+                    second_start, use_gmtime);
+        entry->seconds = seconds;
+    }
+
+    result += entry->parts[0];
+    if (subsecond.empty())
+        return;
+
+    // Same digits as internal::build_q_value() and
+    // internal::build_uc_q_value() produce.
+    int const usec = static_cast<int>(helpers::microseconds_part(timestamp));
+    for (std::size_t i = 0; i != subsecond.size(); ++i)
+    {
+        if (subsecond[i] == LOG4CPLUS_TEXT('N'))
+            appendDigits(result, usec * 1000
+                + static_cast<int>((event.getPreciseTimestamp()
+                        - timestamp).count()), 9);
+        else
+        {
+            appendDigits(result, usec / 1000, 3);
+            if (subsecond[i] == LOG4CPLUS_TEXT('Q'))
+            {
+                result += LOG4CPLUS_TEXT('.');
+                appendDigits(result, usec % 1000, 3);
+            }
+        }
+        result += entry->parts[i + 1];
+    }
 }
 
 
@@ -575,11 +1107,10 @@ void
 EnvPatternConverter::convert(tstring & result,
     const spi::InternalLoggingEvent&)
 {
-    if (! internal::get_env_var (result, envKey))
-    {
-        // Variable doesn't exist, return empty string.
-        result.clear ();
-    }
+    // Variable that doesn't exist is formatted as empty string.
+    tstring & value = internal::get_ptd ()->faa_str;
+    if (internal::get_env_var (value, envKey))
+        result += value;
 }
 
 
@@ -596,10 +1127,37 @@ void
 RelativeTimestampConverter::convert (tstring & result,
     spi::InternalLoggingEvent const & event)
 {
-    tostringstream & oss = internal::get_ptd ()->layout_oss;
-    detail::clear_tostringstream (oss);
-    log4cplus::formatRelativeTimestamp (oss, event);
-    result = oss.str ();
+    // Same as formatRelativeTimestamp() without going through a stream.
+    auto const duration = event.getTimestamp () - getTTCCLayoutTimeBase ();
+    tstring & tmp = internal::get_ptd ()->faa_str;
+    helpers::convertIntegerToString (tmp,
+        helpers::chrono::duration_cast<
+            helpers::chrono::duration<long long, std::milli>>(
+                duration).count ());
+    result += tmp;
+}
+
+
+//
+//
+//
+
+SequenceNumberConverter::SequenceNumberConverter (FormattingInfo const & info)
+    : PatternConverter (info)
+{ }
+
+
+void
+SequenceNumberConverter::convert (tstring & result,
+    spi::InternalLoggingEvent const & event)
+{
+    std::uint64_t const seq = event.getSequenceNumber ();
+    if (seq == 0)
+        return;
+
+    tstring & tmp = internal::get_ptd ()->faa_str;
+    helpers::convertIntegerToString (tmp, seq);
+    result += tmp;
 }
 
 
@@ -618,7 +1176,7 @@ void
 HostnamePatternConverter::convert (
     tstring & result, const spi::InternalLoggingEvent&)
 {
-    result = hostname_;
+    result += hostname_;
 }
 
 
@@ -631,6 +1189,7 @@ log4cplus::pattern::MDCPatternConverter::MDCPatternConverter (
     const FormattingInfo& info, tstring const & k)
     : PatternConverter(info)
     , key (k)
+    , keyHandle (key.empty () ? MDCKey () : MDC::registerKey (key))
 { }
 
 
@@ -640,12 +1199,10 @@ log4cplus::pattern::MDCPatternConverter::convert (tstring & result,
 {
     if (!key.empty())
     {
-        result = event.getMDC (key);
+        result += event.getMDC (keyHandle);
     }
     else
     {
-        result.clear ();
-
         MappedDiagnosticContextMap const & mdcMap = event.getMDCCopy();
         for (auto const & kv : mdcMap)
         {
@@ -663,6 +1220,60 @@ log4cplus::pattern::MDCPatternConverter::convert (tstring & result,
 }
 
 
+////////////////////////////////////////////////
+// KeyValuesPatternConverter methods:
+////////////////////////////////////////////////
+
+log4cplus::pattern::KeyValuesPatternConverter::KeyValuesPatternConverter (
+    const FormattingInfo& info, tstring const & k)
+    : PatternConverter(info)
+    , key (k)
+{ }
+
+
+void
+log4cplus::pattern::KeyValuesPatternConverter::convert (tstring & result,
+    const spi::InternalLoggingEvent& event)
+{
+    spi::KeyValues const & kvs = event.getKeyValues ();
+    if (! key.empty ())
+    {
+        spi::KeyValue kv;
+        if (kvs.find (key, kv))
+            spi::KeyValues::appendValue (result, kv);
+    }
+    else
+        appendAllKeyValues (result, kvs);
+}
+
+
+////////////////////////////////////////////////
+// StackTracePatternConverter methods:
+////////////////////////////////////////////////
+
+log4cplus::pattern::StackTracePatternConverter::StackTracePatternConverter (
+    const FormattingInfo& info)
+    : PatternConverter(info)
+{ }
+
+
+void
+log4cplus::pattern::StackTracePatternConverter::convert (tstring & result,
+    const spi::InternalLoggingEvent& event)
+{
+    spi::StackTracePtr const & trace = event.getStackTrace ();
+    if (! trace)
+        return;
+
+    for (std::size_t i = 0; i != trace->size; ++i)
+    {
+        result += LOG4CPLUS_TEXT ("\tat ");
+        result += spi::symbolizeStackFrame (trace->frames[i]);
+        result += LOG4CPLUS_TEXT ('\n');
+    }
+}
+
+
 ////////////////////////////////////////////////
 // NDCPatternConverter methods:
 ////////////////////////////////////////////////
@@ -680,14 +1291,14 @@ log4cplus::pattern::NDCPatternConverter::convert (tstring & result,
 {
     const log4cplus::tstring& text = event.getNDC();
     if (precision <= 0)
-        result = text;
+        result += text;
     else
     {
         tstring::size_type p = text.find(LOG4CPLUS_TEXT(' '));
         for (int i = 1; i < precision && p != tstring::npos; ++i)
             p = text.find(LOG4CPLUS_TEXT(' '), p + 1);
 
-        result.assign (text, 0, p);
+        result.append (text, 0, p);
     }
 }
 
@@ -936,6 +1547,11 @@ PatternParser::finalizeConverter(tchar c)
             //formattingInfo.dump(getLogLog());
             break;
 
+        case LOG4CPLUS_TEXT('K'):
+            pc = new KeyValuesPatternConverter (formattingInfo,
+                extractOption ());
+            break;
+
         case LOG4CPLUS_TEXT('l'):
             pc = new BasicPatternConverter
                           (formattingInfo,
@@ -976,9 +1592,7 @@ PatternParser::finalizeConverter(tchar c)
             break;
 
         case LOG4CPLUS_TEXT('p'):
-            pc = new BasicPatternConverter
-                          (formattingInfo,
-                           BasicPatternConverter::LOGLEVEL_CONVERTER);
+            pc = new LogLevelPatternConverter (formattingInfo);
             //getLogLog().debug("LOGLEVEL converter.");
             //formattingInfo.dump(getLogLog());
             break;
@@ -989,6 +1603,10 @@ PatternParser::finalizeConverter(tchar c)
             //formattingInfo.dump(getLogLog());
             break;
 
+        case LOG4CPLUS_TEXT('S'):
+            pc = new StackTracePatternConverter (formattingInfo);
+            break;
+
         case LOG4CPLUS_TEXT('t'):
             pc = new BasicPatternConverter
                           (formattingInfo,
@@ -1015,6 +1633,10 @@ PatternParser::finalizeConverter(tchar c)
             //getLogLog().debug("MDC converter.");
             break;
 
+        case LOG4CPLUS_TEXT('Y'):
+            pc = new SequenceNumberConverter (formattingInfo);
+            break;
+
         default:
             tostringstream buf;
             buf << LOG4CPLUS_TEXT("Unexpected char [")
@@ -1033,6 +1655,163 @@ PatternParser::finalizeConverter(tchar c)
 }
 
 
+////////////////////////////////////////////////
+// StaticPatternLayout helpers:
+////////////////////////////////////////////////
+
+void
+staticAppendPadded (tstring & output, tstring_view str,
+    StaticField const & field)
+{
+    std::size_t const len = str.length ();
+
+    if (len > field.maxLen)
+    {
+        if (field.trimStart)
+            output.append (str.substr (len - field.maxLen));
+        else
+            output.append (str.substr (0, field.maxLen));
+    }
+    else if (static_cast<int>(len) < field.minLen)
+    {
+        std::size_t const fill = static_cast<std::size_t>(field.minLen) - len;
+        if (! field.leftAlign)
+            output.append (fill, LOG4CPLUS_TEXT (' '));
+        output.append (str);
+        if (field.leftAlign)
+            output.append (fill, LOG4CPLUS_TEXT (' '));
+    }
+    else
+        output.append (str);
+}
+
+
+tstring &
+staticLayoutBuffer ()
+{
+    tstring & buffer = internal::get_ptd ()->layout_str;
+    internal::clear_thread_buffer (buffer);
+    return buffer;
+}
+
+
+tstring const &
+staticFormatField (StaticField const & field, tstring const & option,
+    spi::InternalLoggingEvent const & event)
+{
+    tstring & result = internal::get_ptd ()->faa_str;
+
+    switch (field.type)
+    {
+    case BASENAME_FIELD:
+        result = get_basename (event.getFile ());
+        break;
+
+    case PROCESS_FIELD:
+        helpers::convertIntegerToString (result, internal::get_process_id ());
+        break;
+
+    case LINE_FIELD:
+        if (event.getLine () != -1)
+            helpers::convertIntegerToString (result, event.getLine ());
+        else
+            result.clear ();
+        break;
+
+    case FULL_LOCATION_FIELD:
+        result = event.getFile ();
+        result += LOG4CPLUS_TEXT (":");
+        if (! event.getFile ().empty ())
+            result += helpers::convertIntegerToString (event.getLine ());
+        break;
+
+    case LOCAL_DATE_FIELD:
+    case GMT_DATE_FIELD:
+        result = helpers::getFormattedTime (option, event.getTimestamp (),
+            field.type == GMT_DATE_FIELD);
+        break;
+
+    case RELATIVE_TIMESTAMP_FIELD:
+        helpers::convertIntegerToString (result,
+            helpers::chrono::duration_cast<
+                helpers::chrono::duration<long long, std::milli>>(
+                    event.getTimestamp () - getTTCCLayoutTimeBase ()).count ());
+        break;
+
+    case SEQUENCE_FIELD:
+        if (event.getSequenceNumber () != 0)
+            helpers::convertIntegerToString (result,
+                event.getSequenceNumber ());
+        else
+            result.clear ();
+        break;
+
+    case MDC_FIELD:
+        result.clear ();
+        for (auto const & kv : event.getMDCCopy ())
+        {
+            result += LOG4CPLUS_TEXT ("{");
+            result += kv.first;
+            result += LOG4CPLUS_TEXT (", ");
+            result += kv.second;
+            result += LOG4CPLUS_TEXT ("}");
+        }
+        break;
+
+    case KEY_VALUES_FIELD:
+    {
+        result.clear ();
+        spi::KeyValue kv;
+        if (option.empty ())
+            appendAllKeyValues (result, event.getKeyValues ());
+        else if (event.getKeyValues ().find (option, kv))
+            spi::KeyValues::appendValue (result, kv);
+        break;
+    }
+
+    default:
+        result = LOG4CPLUS_TEXT ("INTERNAL LOG4CPLUS ERROR");
+    }
+
+    return result;
+}
+
+
+tstring_view
+staticLoggerName (tstring const & name, int precision)
+{
+    if (precision <= 0)
+        return name;
+
+    // Starting at 'len - 1' avoids out of bounds access in substr() when
+    // precision is 1 and the logger name ends with a dot.
+    auto end = name.length () - 1;
+    for (int i = precision; i > 0; --i)
+    {
+        end = name.rfind (LOG4CPLUS_TEXT ('.'), end - 1);
+        if (end == tstring::npos)
+            return name;
+    }
+
+    return tstring_view (name).substr (end + 1);
+}
+
+
+tstring_view
+staticNDC (tstring const & text, unsigned precision)
+{
+    if (precision == 0)
+        return text;
+
+    // See NDCPatternConverter::convert().
+    tstring::size_type p = text.find (LOG4CPLUS_TEXT (' '));
+    for (unsigned i = 1; i < precision && p != tstring::npos; ++i)
+        p = text.find (LOG4CPLUS_TEXT (' '), p + 1);
+
+    return tstring_view (text).substr (0, p);
+}
+
+
 } // namespace pattern
 
 
@@ -1044,12 +1823,14 @@ using PatternConverterList = pattern::PatternConverterList;
 ////////////////////////////////////////////////
 
 PatternLayout::PatternLayout(const tstring& pattern_)
+    : requiredEventFields (spi::EVENT_FIELDS_NONE)
 {
     init(pattern_, 0);
 }
 
 
 PatternLayout::PatternLayout(const helpers::Properties& properties)
+    : requiredEventFields (spi::EVENT_FIELDS_NONE)
 {
     unsigned ndcMaxDepth = 0;
     properties.getUInt (ndcMaxDepth, LOG4CPLUS_TEXT ("NDCMaxDepth"));
@@ -1107,6 +1888,17 @@ PatternLayout::init(const tstring& pattern_, unsigned ndcMaxDepth)
                 new pattern::BasicPatternConverter(pattern::FormattingInfo(),
                     pattern::BasicPatternConverter::MESSAGE_CONVERTER)));
     }
+
+    requiredEventFields = spi::EVENT_FIELDS_NONE;
+    for (auto const & pc : parsedPattern)
+        requiredEventFields |= pc->getRequiredEventFields ();
+
+    // Output of the converters depends only on the event, the pattern
+    // and NDC depth.
+    cacheKey = internal::get_layout_cache_key (
+        LOG4CPLUS_TEXT ("PatternLayout ")
+        + helpers::convertIntegerToString (ndcMaxDepth)
+        + LOG4CPLUS_TEXT (' ') + pattern);
 }
 
 
@@ -1118,6 +1910,18 @@ PatternLayout::~PatternLayout() = default;
 void
 PatternLayout::formatAndAppend(tostream& output,
                                const spi::InternalLoggingEvent& event)
+{
+    tstring & buffer = internal::get_ptd ()->layout_str;
+    internal::clear_thread_buffer (buffer);
+    formatAndAppend (buffer, event);
+    output.write (buffer.data (),
+        static_cast<std::streamsize>(buffer.size ()));
+}
+
+
+void
+PatternLayout::formatAndAppend(tstring& output,
+                               const spi::InternalLoggingEvent& event)
 {
     for (auto const & pc : parsedPattern)
     {
@@ -1126,4 +1930,301 @@ PatternLayout::formatAndAppend(tostream& output,
 }
 
 
+void
+PatternLayout::formatBatch(
+    std::span<spi::InternalLoggingEvent const> events, tstring& output)
+{
+    if (events.empty ())
+        return;
+
+    std::size_t const start = output.size ();
+    for (auto const & pc : parsedPattern)
+        pc->formatAndAppend(output, events.front ());
+
+    // Records of one batch tend to be of similar size; leave a quarter
+    // more for the longer ones.
+    std::size_t const first = output.size () - start;
+    std::size_t const expected = first * (events.size () - 1);
+    if (output.capacity () < output.size () + expected)
+        output.reserve (output.size () + expected + expected / 4);
+
+    for (auto const & event : events.subspan (1))
+        for (auto const & pc : parsedPattern)
+            pc->formatAndAppend(output, event);
+}
+
+
+unsigned
+PatternLayout::getRequiredEventFields() const
+{
+    return requiredEventFields;
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("DatePatternConverter", "[layout]")
+{
+    tstring const formats[] = {
+        LOG4CPLUS_TEXT ("%Y-%m-%d %H:%M:%S"),
+        LOG4CPLUS_TEXT ("%H:%M:%S,%q"),
+        LOG4CPLUS_TEXT ("%q%%q %Q %s%"),
+        LOG4CPLUS_TEXT ("%Q"),
+        LOG4CPLUS_TEXT ("%s.%N %%N")
+    };
+    helpers::Time const base = helpers::from_time_t (1700000000);
+    helpers::Time const times[] = {
+        base,
+        base + std::chrono::microseconds (1),
+        base + std::chrono::microseconds (999999),
+        base + std::chrono::seconds (1) + std::chrono::microseconds (12345),
+        base - std::chrono::seconds (3600) + std::chrono::microseconds (7)
+    };
+
+    for (bool use_gmtime : {true, false})
+        for (tstring const & format : formats)
+        {
+            pattern::DatePatternConverter converter (
+                pattern::FormattingInfo (), format,
+                use_gmtime);
+            for (int pass = 0; pass != 2; ++pass)
+                for (helpers::Time const & t : times)
+                {
+                    spi::InternalLoggingEvent ev (
+                        LOG4CPLUS_TEXT ("test"), INFO_LOG_LEVEL,
+                        LOG4CPLUS_TEXT (""),
+                        MappedDiagnosticContextMap (), LOG4CPLUS_TEXT (""),
+                        LOG4CPLUS_TEXT (""), LOG4CPLUS_TEXT (""), t,
+                        LOG4CPLUS_TEXT (""), 0);
+                    tstring result;
+                    converter.convert (result, ev);
+                    CATCH_REQUIRE (result
+                        == helpers::getFormattedTime (format, t, use_gmtime));
+                }
+        }
+
+    // Nanoseconds are kept by events, not by helpers::Time.
+    pattern::DatePatternConverter converter (pattern::FormattingInfo (),
+        LOG4CPLUS_TEXT ("%S.%N"), true);
+    spi::InternalLoggingEvent ev (LOG4CPLUS_TEXT ("test"), INFO_LOG_LEVEL,
+        LOG4CPLUS_TEXT (""), nullptr, 0);
+    ev.setPreciseTimestamp (helpers::PreciseTime (base.time_since_epoch ())
+        + std::chrono::nanoseconds (1002003));
+    CATCH_REQUIRE (ev.getTimestamp ()
+        == base + std::chrono::microseconds (1002));
+    tstring result;
+    converter.convert (result, ev);
+    CATCH_REQUIRE (result == LOG4CPLUS_TEXT ("20.001002003"));
+
+    ev.setTimestamp (base);
+    CATCH_REQUIRE (ev.getPreciseTimestamp () == base);
+}
+
+
+CATCH_TEST_CASE ("LogLevelPatternConverter", "[layout]")
+{
+    auto const format = [] (tchar const * pattern, LogLevel ll)
+    {
+        PatternLayout layout (pattern);
+        spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"), ll,
+            LOG4CPLUS_TEXT (""), nullptr, 0, nullptr);
+        tstring result;
+        layout.formatAndAppend (result, ev);
+        return result;
+    };
+
+    CATCH_REQUIRE (format (LOG4CPLUS_TEXT ("%p"), WARN_LOG_LEVEL)
+        == LOG4CPLUS_TEXT ("WARN"));
+    CATCH_REQUIRE (format (LOG4CPLUS_TEXT ("[%-5p][%5p]"), INFO_LOG_LEVEL)
+        == LOG4CPLUS_TEXT ("[INFO ][ INFO]"));
+    CATCH_REQUIRE (format (LOG4CPLUS_TEXT ("%.2p"), DEBUG_LOG_LEVEL)
+        == LOG4CPLUS_TEXT ("UG"));
+    CATCH_REQUIRE (format (LOG4CPLUS_TEXT ("%p"), NOT_SET_LOG_LEVEL)
+        == LOG4CPLUS_TEXT ("NOTSET"));
+
+    // Levels registered after the layout has been created are picked up.
+    PatternLayout layout (LOG4CPLUS_TEXT ("%-8p|"));
+    LogLevel const notice = 25321;
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"), notice,
+        LOG4CPLUS_TEXT (""), nullptr, 0, nullptr);
+    tstring result;
+    layout.formatAndAppend (result, ev);
+    CATCH_REQUIRE (result == LOG4CPLUS_TEXT ("UNKNOWN |"));
+
+    getLogLevelManager ().pushLogLevel (notice, LOG4CPLUS_TEXT ("NOTICE"));
+    for (int pass = 0; pass != 2; ++pass)
+    {
+        result.clear ();
+        layout.formatAndAppend (result, ev);
+        CATCH_REQUIRE (result == LOG4CPLUS_TEXT ("NOTICE  |"));
+    }
+}
+
+
+CATCH_TEST_CASE ("Cached logger and location converters", "[layout]")
+{
+    PatternLayout layout (LOG4CPLUS_TEXT ("%c{2}|%l|%c{1}"));
+    auto const format = [&layout] (tchar const * logger, char const * file,
+        int line)
+    {
+        spi::InternalLoggingEvent const ev (logger, INFO_LOG_LEVEL,
+            LOG4CPLUS_TEXT (""), file, line, nullptr);
+        tstring result;
+        layout.formatAndAppend (result, ev);
+        return result;
+    };
+
+    // Repeated and alternating names and call sites hit and replace
+    // cache entries; output must not depend on the order.
+    for (int pass = 0; pass != 2; ++pass)
+    {
+        CATCH_REQUIRE (format (LOG4CPLUS_TEXT ("a.b.c"), "f.cxx", 1)
+            == LOG4CPLUS_TEXT ("b.c|f.cxx:1|c"));
+        CATCH_REQUIRE (format (LOG4CPLUS_TEXT ("a.b.c"), "f.cxx", 2)
+            == LOG4CPLUS_TEXT ("b.c|f.cxx:2|c"));
+        CATCH_REQUIRE (format (LOG4CPLUS_TEXT ("x.b.c"), "g.cxx", 1)
+            == LOG4CPLUS_TEXT ("b.c|g.cxx:1|c"));
+        CATCH_REQUIRE (format (LOG4CPLUS_TEXT ("root"), "", 3)
+            == LOG4CPLUS_TEXT ("root|:|root"));
+        CATCH_REQUIRE (format (LOG4CPLUS_TEXT ("a."), "f.cxx", 1)
+            == LOG4CPLUS_TEXT ("a.|f.cxx:1|a."));
+    }
+}
+
+
+CATCH_TEST_CASE ("DatePatternConverter fast path", "[layout]")
+{
+    tchar const * const formats[] = {
+        LOG4CPLUS_TEXT ("%Y-%m-%dT%H:%M:%S.%q"),
+        LOG4CPLUS_TEXT ("%y-%m-%d %H:%M:%S,%Q"),
+        LOG4CPLUS_TEXT ("%H:%M:%S,%q"),
+        LOG4CPLUS_TEXT ("%d %b %Y %H:%M:%S,%q"),
+        LOG4CPLUS_TEXT ("%F %T %j 100%% %q%q"),
+        // Not handled by the fast path.
+        LOG4CPLUS_TEXT ("%a %Y %s.%q"),
+    };
+
+    for (tchar const * format : formats)
+        for (bool gmt : {true, false})
+        {
+            tstring pattern (gmt ? LOG4CPLUS_TEXT ("%d{")
+                : LOG4CPLUS_TEXT ("%D{"));
+            pattern += format;
+            pattern += LOG4CPLUS_TEXT ("}");
+            PatternLayout layout (pattern);
+
+            // Leap days, turns of years and sub-second values with and
+            // without leading zeros.
+            for (long long sec = 946684700; sec < 1800000000;
+                 sec += 86400 * 29 + 3600 * 7 + 123)
+                for (long usec : {0L, 7L, 42001L, 999999L})
+                {
+                    helpers::Time const ts
+                        = helpers::time_from_parts (sec, usec);
+                    spi::InternalLoggingEvent const ev (
+                        LOG4CPLUS_TEXT ("test"), INFO_LOG_LEVEL,
+                        LOG4CPLUS_TEXT (""), MappedDiagnosticContextMap (),
+                        LOG4CPLUS_TEXT (""), LOG4CPLUS_TEXT (""),
+                        LOG4CPLUS_TEXT (""), ts, LOG4CPLUS_TEXT (""), 0);
+                    tstring result;
+                    layout.formatAndAppend (result, ev);
+                    CATCH_REQUIRE (result
+                        == helpers::getFormattedTime (format, ts, gmt));
+                }
+        }
+}
+
+
+CATCH_TEST_CASE ("PatternLayout required event fields", "[layout]")
+{
+    CATCH_REQUIRE (PatternLayout (LOG4CPLUS_TEXT ("%d %-5p %c - %m%n"))
+        .getRequiredEventFields () == spi::EVENT_FIELDS_NONE);
+    CATCH_REQUIRE (PatternLayout (LOG4CPLUS_TEXT ("[%t] %x %X{key} %m"))
+        .getRequiredEventFields () == (spi::EVENT_FIELD_THREAD
+            | spi::EVENT_FIELD_NDC | spi::EVENT_FIELD_MDC));
+    CATCH_REQUIRE (PatternLayout (LOG4CPLUS_TEXT ("%b:%L %M %T"))
+        .getRequiredEventFields () == (spi::EVENT_FIELD_FILE
+            | spi::EVENT_FIELD_FUNCTION | spi::EVENT_FIELD_THREAD2));
+    CATCH_REQUIRE (SimpleLayout ().getRequiredEventFields ()
+        == spi::EVENT_FIELDS_NONE);
+}
+
+
+CATCH_TEST_CASE ("PatternLayout formatBatch", "[layout]")
+{
+    helpers::Time const base = helpers::from_time_t (1700000000);
+    LogLevel const levels[] = {INFO_LOG_LEVEL, WARN_LOG_LEVEL,
+        ERROR_LOG_LEVEL, 12345};
+    std::vector<spi::InternalLoggingEvent> events;
+    for (int i = 0; i != 50; ++i)
+    {
+        spi::InternalLoggingEvent ev (LOG4CPLUS_TEXT ("a.b"), levels[i % 4],
+            helpers::convertIntegerToString (i), __FILE__, __LINE__);
+        // Events span three seconds.
+        ev.setTimestamp (base + std::chrono::milliseconds (i * 50));
+        events.push_back (ev);
+    }
+
+    PatternLayout layout (
+        LOG4CPLUS_TEXT ("%D{%Y-%m-%d %H:%M:%S,%q} %-5p %c{1} - %m%n"));
+    tstring expected (LOG4CPLUS_TEXT ("prefix"));
+    for (auto const & ev : events)
+        layout.formatAndAppend (expected, ev);
+
+    tstring batch (LOG4CPLUS_TEXT ("prefix"));
+    layout.formatBatch (events, batch);
+    CATCH_REQUIRE (batch == expected);
+
+    tstring simple;
+    SimpleLayout ().formatBatch (
+        std::span<spi::InternalLoggingEvent const> (events).first (2),
+        simple);
+    CATCH_REQUIRE (simple == LOG4CPLUS_TEXT ("INFO - 0\nWARN - 1\n"));
+}
+
+
+CATCH_TEST_CASE ("StaticPatternLayout", "[layout]")
+{
+    spi::InternalLoggingEvent ev (LOG4CPLUS_TEXT ("a.b.c"), WARN_LOG_LEVEL,
+        LOG4CPLUS_TEXT ("message"), "dir/file.cxx", 42, "func");
+    ev.getKeyValues ().add (LOG4CPLUS_TEXT ("id"), 7);
+    ev.getKeyValues ().add (LOG4CPLUS_TEXT ("name"), LOG4CPLUS_TEXT ("x"));
+
+    auto check = [&ev] (Layout & static_layout, tstring const & pattern)
+    {
+        PatternLayout layout (pattern);
+        tostringstream expected;
+        layout.formatAndAppend (expected, ev);
+        tostringstream actual;
+        static_layout.formatAndAppend (actual, ev);
+        CATCH_REQUIRE (actual.str () == expected.str ());
+        CATCH_REQUIRE (static_layout.getRequiredEventFields ()
+            == layout.getRequiredEventFields ());
+    };
+
+#define LOG4CPLUS_CHECK_STATIC_PATTERN(pat)                             \
+    do {                                                                \
+        StaticPatternLayout<LOG4CPLUS_TEXT (pat)> static_layout;        \
+        check (static_layout, LOG4CPLUS_TEXT (pat));                    \
+    } while (0)
+
+    CATCH_SECTION ("plain fields")
+    {
+        LOG4CPLUS_CHECK_STATIC_PATTERN ("%p %c [%t] %m%n");
+        LOG4CPLUS_CHECK_STATIC_PATTERN ("%F:%L %b %l %M");
+        LOG4CPLUS_CHECK_STATIC_PATTERN ("100%% %x %X %X{key} %i %");
+        LOG4CPLUS_CHECK_STATIC_PATTERN ("%d{%Y %H:%M:%S} %D %d{}");
+        LOG4CPLUS_CHECK_STATIC_PATTERN ("%K %K{name} [%-4K{id}] %K{none}");
+    }
+
+    CATCH_SECTION ("formatting")
+    {
+        LOG4CPLUS_CHECK_STATIC_PATTERN ("[%-10p] [%10p] [%.2m] [%.-2m]");
+        LOG4CPLUS_CHECK_STATIC_PATTERN ("[%-30c{1}] [%3.5c{2}] %c{5}");
+        LOG4CPLUS_CHECK_STATIC_PATTERN ("%-40m|%40m|%-5.40m");
+    }
+
+#undef LOG4CPLUS_CHECK_STATIC_PATTERN
+}
+#endif
+
 } // namespace log4cplus
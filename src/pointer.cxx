@@ -21,6 +21,7 @@
 #include <log4cplus/streams.h>
 #include <log4cplus/helpers/pointer.h>
 #include <log4cplus/thread/threads.h>
+#include <log4cplus/thread/lockprofile.h>
 #include <log4cplus/thread/impl/syncprims-impl.h>
 #include <cassert>
 
@@ -28,11 +29,30 @@
 namespace log4cplus::helpers {
 
 
+//! Shared by access mutexes of all shared objects.
+static thread::LockSite access_mutex_site ("SharedObject::access_mutex");
+
+
 ///////////////////////////////////////////////////////////////////////////////
-// log4cplus::helpers::SharedObject dtor
+// log4cplus::helpers::SharedObjectBase ctors and dtor
 ///////////////////////////////////////////////////////////////////////////////
 
-SharedObject::~SharedObject()
+SharedObjectBase::SharedObjectBase() LOG4CPLUS_NOEXCEPT
+    : count__(0)
+{ }
+
+
+SharedObjectBase::SharedObjectBase(const SharedObjectBase&) LOG4CPLUS_NOEXCEPT
+    : count__(0)
+{ }
+
+
+SharedObjectBase::SharedObjectBase(SharedObjectBase &&) LOG4CPLUS_NOEXCEPT
+    : count__(0)
+{ }
+
+
+SharedObjectBase::~SharedObjectBase()
 {
     assert(count__ == 0);
 }
@@ -40,11 +60,11 @@ SharedObject::~SharedObject()
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// log4cplus::helpers::SharedObject public methods
+// log4cplus::helpers::SharedObjectBase public methods
 ///////////////////////////////////////////////////////////////////////////////
 
 void
-SharedObject::addReference() const LOG4CPLUS_NOEXCEPT
+SharedObjectBase::addReference() const LOG4CPLUS_NOEXCEPT
 {
 #if defined (LOG4CPLUS_SINGLE_THREADED)
     ++count__;
@@ -58,7 +78,7 @@ SharedObject::addReference() const LOG4CPLUS_NOEXCEPT
 
 
 void
-SharedObject::removeReference() const
+SharedObjectBase::removeReference() const
 {
     assert (count__ > 0);
     bool destroy;
@@ -74,8 +94,41 @@ SharedObject::removeReference() const
 
 #endif
     if (LOG4CPLUS_UNLIKELY (destroy))
-        delete this;
+        dispose ();
+}
+
+
+void
+SharedObjectBase::dispose() const
+{
+    delete this;
 }
 
 
+
+///////////////////////////////////////////////////////////////////////////////
+// log4cplus::helpers::SharedObject ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+SharedObject::SharedObject()
+    : access_mutex(access_mutex_site)
+{ }
+
+
+SharedObject::SharedObject(const SharedObject& other)
+    : SharedObjectBase(other)
+    , access_mutex(access_mutex_site)
+{ }
+
+
+SharedObject::SharedObject(SharedObject && other)
+    : SharedObjectBase(std::move (other))
+    , access_mutex(access_mutex_site)
+{ }
+
+
+SharedObject::~SharedObject()
+{ }
+
+
 } // namespace log4cplus::helpers
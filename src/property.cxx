@@ -219,79 +219,193 @@ imbue_file_from_flags ([[maybe_unused]] tistream & file, unsigned flags)
  * @param val The string on which variable substitution is performed.
  * @param dest The result.
  */
+namespace
+{
+
+tchar const DELIM_START[] = LOG4CPLUS_TEXT("${");
+tchar const DELIM_STOP[] = LOG4CPLUS_TEXT("}");
+std::size_t const DELIM_START_LEN = 2;
+std::size_t const DELIM_STOP_LEN = 1;
+
+
+//! Looks up value of variable <code>key</code> for substVars().
+void
+lookup_var (tstring & replacement, tstring const & key,
+    helpers::Properties const & props, unsigned flags)
+{
+    bool const empty_vars
+        = !! (flags & PropertyConfigurator::fAllowEmptyVars);
+    bool const shadow_env
+        = !! (flags & PropertyConfigurator::fShadowEnvironment);
+
+    replacement.clear ();
+    if (shadow_env)
+        replacement = props.getProperty (key);
+    if (! shadow_env || (! empty_vars && replacement.empty ()))
+        internal::get_env_var (replacement, key);
+}
+
+
+void
+report_unclosed_var (helpers::LogLog& loglog, tstring const & pattern,
+    tstring::size_type var_start)
+{
+    tostringstream buffer;
+    buffer << '"' << pattern
+            << "\" has no closing brace. "
+            << "Opening brace at position " << var_start << ".";
+    loglog.error(buffer.str());
+}
+
+
+//! substVars() with recursive expansion. Substituted values are
+//! expanded again in place, together with the rest of the string.
 bool
-substVars (tstring & dest, const tstring & val,
+subst_vars_recursive (tstring & dest, const tstring & val,
     helpers::Properties const & props, helpers::LogLog& loglog,
-    unsigned flags)
+    unsigned flags, tstring::size_type var_start)
 {
-    static tchar const DELIM_START[] = LOG4CPLUS_TEXT("${");
-    static tchar const DELIM_STOP[] = LOG4CPLUS_TEXT("}");
-    static std::size_t const DELIM_START_LEN = 2;
-    static std::size_t const DELIM_STOP_LEN = 1;
-
-    tstring::size_type i = 0;
-    tstring::size_type var_start, var_end;
     tstring pattern (val);
     tstring key;
     tstring replacement;
+    tstring::size_type i = 0;
     bool changed = false;
     bool const empty_vars
         = !! (flags & PropertyConfigurator::fAllowEmptyVars);
-    bool const shadow_env
-        = !! (flags & PropertyConfigurator::fShadowEnvironment);
-    bool const rec_exp
-        = !! (flags & PropertyConfigurator::fRecursiveExpansion);
 
-    while (true)
+    while (var_start != tstring::npos)
     {
-        // Find opening paren of variable substitution.
-        var_start = pattern.find(DELIM_START, i);
-        if (var_start == tstring::npos)
-        {
-            dest = pattern;
-            return changed;
-        }
-
         // Find closing paren of variable substitution.
-        var_end = pattern.find(DELIM_STOP, var_start);
+        tstring::size_type const var_end = pattern.find(DELIM_STOP, var_start);
         if (var_end == tstring::npos)
         {
-            tostringstream buffer;
-            buffer << '"' << pattern
-                    << "\" has no closing brace. "
-                    << "Opening brace at position " << var_start << ".";
-            loglog.error(buffer.str());
+            report_unclosed_var (loglog, pattern, var_start);
             dest = val;
             return false;
         }
 
         key.assign (pattern, var_start + DELIM_START_LEN,
             var_end - (var_start + DELIM_START_LEN));
-        replacement.clear ();
-        if (shadow_env)
-            replacement = props.getProperty (key);
-        if (! shadow_env || (! empty_vars && replacement.empty ()))
-            internal::get_env_var (replacement, key);
+        lookup_var (replacement, key, props, flags);
 
         if (empty_vars || ! replacement.empty ())
         {
-            // Substitute the variable with its value in place.
+            // Substitute the variable with its value in place and retry
+            // expansion on the same spot.
             pattern.replace (var_start, var_end - var_start + DELIM_STOP_LEN,
                 replacement);
             changed = true;
-            if (rec_exp)
-                // Retry expansion on the same spot.
-                continue;
-            else
-                // Move beyond the just substituted part.
-                i = var_start + replacement.size ();
         }
         else
             // Nothing has been subtituted, just move beyond the
             // unexpanded variable.
             i = var_end + DELIM_STOP_LEN;
-    } // end while loop
 
+        // Find opening paren of variable substitution.
+        var_start = pattern.find(DELIM_START, i);
+    }
+
+    dest = std::move (pattern);
+    return changed;
+}
+
+} // namespace
+
+
+/**
+ * Perform variable substitution in string <code>val</code> from
+ * environment variables.
+ *
+ * <p>The variable substitution delimeters are <b>${</b> and <b>}</b>.
+ *
+ * <p>For example, if the System properties contains "key=value", then
+ * the call
+ * <pre>
+ * string s;
+ * substEnvironVars(s, "Value of key is ${key}.");
+ * </pre>
+ *
+ * will set the variable <code>s</code> to "Value of key is value.".
+ *
+ * <p>If no value could be found for the specified key, then
+ * substitution defaults to the empty string.
+ *
+ * <p>For example, if there is no environment variable "inexistentKey",
+ * then the call
+ *
+ * <pre>
+ * string s;
+ * substEnvironVars(s, "Value of inexistentKey is [${inexistentKey}]");
+ * </pre>
+ * will set <code>s</code> to "Value of inexistentKey is []"
+ *
+ * Without recursive expansion the string is scanned once and the result
+ * is built by appending, so the time is linear in the length of the
+ * string.
+ *
+ * @param val The string on which variable substitution is performed.
+ * @param dest The result.
+ */
+bool
+substVars (tstring & dest, const tstring & val,
+    helpers::Properties const & props, helpers::LogLog& loglog,
+    unsigned flags)
+{
+    // Find opening paren of variable substitution.
+    tstring::size_type var_start = val.find(DELIM_START);
+    if (var_start == tstring::npos)
+    {
+        dest = val;
+        return false;
+    }
+
+    if (flags & PropertyConfigurator::fRecursiveExpansion)
+        return subst_vars_recursive (dest, val, props, loglog, flags,
+            var_start);
+
+    bool const empty_vars
+        = !! (flags & PropertyConfigurator::fAllowEmptyVars);
+    tstring result;
+    result.reserve (val.size ());
+    tstring key;
+    tstring replacement;
+    tstring::size_type i = 0;
+    bool changed = false;
+
+    do
+    {
+        // Find closing paren of variable substitution.
+        tstring::size_type const var_end = val.find(DELIM_STOP, var_start);
+        if (var_end == tstring::npos)
+        {
+            report_unclosed_var (loglog, val, var_start);
+            dest = val;
+            return false;
+        }
+
+        key.assign (val, var_start + DELIM_START_LEN,
+            var_end - (var_start + DELIM_START_LEN));
+        lookup_var (replacement, key, props, flags);
+
+        result.append (val, i, var_start - i);
+        if (empty_vars || ! replacement.empty ())
+        {
+            result += replacement;
+            changed = true;
+        }
+        else
+            // Nothing has been subtituted, keep the unexpanded variable.
+            result.append (val, var_start,
+                var_end + DELIM_STOP_LEN - var_start);
+
+        i = var_end + DELIM_STOP_LEN;
+        var_start = val.find(DELIM_START, i);
+    }
+    while (var_start != tstring::npos);
+
+    result.append (val, i, tstring::npos);
+    dest = std::move (result);
+    return changed;
 } // end substVars()
 
 
@@ -385,7 +499,7 @@ Properties::init(tistream& input)
                 tstring value = buffer.substr(idx + 1);
                 trim_trailing_ws (key);
                 trim_ws (value);
-                setProperty(key, value);
+                data.insert_or_assign (std::move (key), std::move (value));
             }
         }
     }
@@ -472,15 +586,15 @@ Properties::removeProperty(const log4cplus::tstring& key)
 Properties
 Properties::getPropertySubset(const log4cplus::tstring& prefix) const
 {
+    // Keys starting with the prefix are adjacent in the sorted map and
+    // stay sorted with the prefix removed.
     Properties ret;
     auto const prefix_len = prefix.size ();
-    std::vector<tstring> keys = propertyNames();
-    for (tstring const & key : keys)
-    {
-        int result = key.compare (0, prefix_len, prefix);
-        if (result == 0)
-            ret.setProperty (key.substr (prefix_len), getProperty(key));
-    }
+    for (auto it = data.lower_bound (prefix);
+         it != data.end () && it->first.compare (0, prefix_len, prefix) == 0;
+         ++it)
+        ret.data.emplace_hint (ret.data.end (), it->first.substr (prefix_len),
+            it->second);
 
     return ret;
 }
@@ -647,6 +761,57 @@ CATCH_TEST_CASE ("Properties", "[properties]")
                 PROP_SECOND) != std::end (names));
     }
 
+    CATCH_SECTION ("property subset")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("a"), LOG4CPLUS_TEXT ("0"));
+        props.setProperty (LOG4CPLUS_TEXT ("a.b"), LOG4CPLUS_TEXT ("1"));
+        props.setProperty (LOG4CPLUS_TEXT ("a.c.d"), LOG4CPLUS_TEXT ("2"));
+        props.setProperty (LOG4CPLUS_TEXT ("a/b"), LOG4CPLUS_TEXT ("3"));
+        props.setProperty (LOG4CPLUS_TEXT ("b.a"), LOG4CPLUS_TEXT ("4"));
+        Properties const subset (
+            props.getPropertySubset (LOG4CPLUS_TEXT ("a.")));
+        CATCH_REQUIRE (subset.size () == 2);
+        CATCH_REQUIRE (subset.getProperty (LOG4CPLUS_TEXT ("b"))
+            == LOG4CPLUS_TEXT ("1"));
+        CATCH_REQUIRE (subset.getProperty (LOG4CPLUS_TEXT ("c.d"))
+            == LOG4CPLUS_TEXT ("2"));
+        CATCH_REQUIRE (props.getPropertySubset (LOG4CPLUS_TEXT ("")).size ()
+            == props.size ());
+        CATCH_REQUIRE (props.getPropertySubset (LOG4CPLUS_TEXT ("c")).size ()
+            == 0);
+    }
+
+    CATCH_SECTION ("variable substitution")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("x"), LOG4CPLUS_TEXT ("X"));
+        props.setProperty (LOG4CPLUS_TEXT ("y"), LOG4CPLUS_TEXT ("${x}"));
+        unsigned const flags = PropertyConfigurator::fShadowEnvironment;
+        helpers::LogLog & loglog = helpers::getLogLog ();
+        tstring dest;
+
+        CATCH_REQUIRE (substVars (dest,
+            LOG4CPLUS_TEXT ("a${x}b${x}${log4cplus-no-such-var}c"), props,
+            loglog, flags));
+        CATCH_REQUIRE (dest
+            == LOG4CPLUS_TEXT ("aXbX${log4cplus-no-such-var}c"));
+
+        CATCH_REQUIRE (! substVars (dest, LOG4CPLUS_TEXT ("plain"), props,
+            loglog, flags));
+        CATCH_REQUIRE (dest == LOG4CPLUS_TEXT ("plain"));
+
+        CATCH_REQUIRE (substVars (dest, LOG4CPLUS_TEXT ("<${y}>"), props,
+            loglog, flags));
+        CATCH_REQUIRE (dest == LOG4CPLUS_TEXT ("<${x}>"));
+
+        CATCH_REQUIRE (substVars (dest, LOG4CPLUS_TEXT ("<${y}>"), props,
+            loglog, flags | PropertyConfigurator::fRecursiveExpansion));
+        CATCH_REQUIRE (dest == LOG4CPLUS_TEXT ("<X>"));
+
+        CATCH_REQUIRE (! substVars (dest, LOG4CPLUS_TEXT ("${x}${x"), props,
+            loglog, flags));
+        CATCH_REQUIRE (dest == LOG4CPLUS_TEXT ("${x}${x"));
+    }
+
     CATCH_SECTION ("throw on nonexistent file")
     {
         auto && f = [] {
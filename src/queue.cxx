@@ -26,56 +26,389 @@
 
 #include <log4cplus/helpers/queue.h>
 #include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <log4cplus/initializer.h>
+#include <log4cplus/internal/internal.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/thread/lockprofile.h>
 #include <stdexcept>
 #include <algorithm>
 #include <iterator>
+#include <memory>
+#include <thread>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <vector>
+#include <catch.hpp>
+#endif
 
 
 namespace log4cplus::thread {
 
 
+namespace
+{
+
+
+//! Number of times a producer re-checks a full slot, yielding in
+//! between, before it goes to sleep.
+constexpr unsigned producer_spin_count = 64;
+
+
+//! Shared by producer mutexes of all queues. Their hold time is not
+//! measured, it would include condition variable waits.
+LockSite producers_mutex_site ("Queue::producers_mutex");
+
+
+std::size_t
+round_up_capacity (unsigned len)
+{
+    std::size_t capacity = 2;
+    while (capacity < len)
+        capacity <<= 1;
+    return capacity;
+}
+
+
+//! Approximate footprint of <code>ev</code> queued with
+//! <code>fields</code>. Deferred message is not formatted just to be
+//! measured, its size is guessed.
+std::size_t
+event_footprint (spi::InternalLoggingEvent const & ev, unsigned fields)
+{
+    constexpr std::size_t deferred_message_size = 128;
+
+    std::size_t chars = ev.getDeferredMessage ()
+        ? deferred_message_size : ev.getMessage ().size ();
+    if (fields & spi::EVENT_FIELD_NDC)
+        chars += ev.getNDC ().size ();
+    if (fields & spi::EVENT_FIELD_MDC)
+        if (MappedDiagnosticContextPtr const & mdc = ev.getMDCSnapshot ())
+            for (auto const & kv : mdc->map)
+                chars += kv.first.size () + kv.second.size ();
+
+    return sizeof (spi::InternalLoggingEvent) + chars * sizeof (tchar);
+}
+
+
+} // namespace
+
+
 Queue::Queue (unsigned len)
-    : ev_consumer (false)
-    , sem (len, len)
+    : slots (round_up_capacity (len), getMemoryResource ())
+    , mask (slots.size () - 1)
+    , tail (0)
+    , active_producers (0)
+    , head (0)
     , flags (DRAIN)
-{ }
+    , consumer_waiting (false)
+    , ev_consumer (false)
+    , queued_bytes (0)
+    , max_bytes (0)
+    , producers_waiting (0)
+    , high_water (0)
+    , blocked_puts (0)
+    , blocked_ns (0)
+    , batches (0)
+    , batched_events (0)
+    , max_batch (0)
+    , owner (nullptr)
+    , next_sequence (std::make_shared<std::atomic<std::uint64_t>> (0))
+    , high_water_threshold (0)
+    , high_water_armed (true)
+{
+    if (slots.size () != len)
+        helpers::getLogLog ().debug (
+            LOG4CPLUS_TEXT ("Queue length ")
+            + helpers::convertIntegerToString (len)
+            + LOG4CPLUS_TEXT (" rounded up to capacity ")
+            + helpers::convertIntegerToString (slots.size ()));
+
+    for (std::size_t i = 0; i != slots.size (); ++i)
+    {
+        slots[i].sequence.store (i, std::memory_order_relaxed);
+        slots[i].valid = false;
+        slots[i].timestamp.store (0, std::memory_order_relaxed);
+        slots[i].bytes = 0;
+    }
+
+    // In real-time mode messages copied into slots reuse storage
+    // reserved here.
+    std::size_t const capacity = internal::get_real_time_buffer_capacity ();
+    if (capacity != 0)
+        for (Slot & slot : slots)
+            slot.event.reserveMessage (capacity);
+}
 
 
 Queue::~Queue () = default;
 
 
+template <typename Ready>
+bool
+Queue::wait_producer (Ready ready)
+{
+    // Unless the consumer is draining, EXIT abandons the wait because
+    // nobody is going to free the slot.
+    auto abandon = [&] {
+        return (flags.load (std::memory_order_acquire) & (EXIT | DRAIN))
+            == EXIT; };
+
+    if (ready ())
+        return true;
+
+    // Time of waiting is accounted only for producers that really wait.
+    struct blocked_guard
+    {
+        Queue & queue;
+        std::chrono::steady_clock::time_point const start
+            = std::chrono::steady_clock::now ();
+
+        ~blocked_guard ()
+        {
+            auto const ns = std::chrono::duration_cast<
+                std::chrono::nanoseconds> (
+                    std::chrono::steady_clock::now () - start).count ();
+            queue.blocked_puts.fetch_add (1, std::memory_order_relaxed);
+            queue.blocked_ns.fetch_add (static_cast<std::uint64_t> (ns),
+                std::memory_order_relaxed);
+        }
+    } const guard {*this};
+
+    for (unsigned i = 0; i != producer_spin_count; ++i)
+    {
+        if (ready ())
+            return true;
+        else if (abandon ())
+            return false;
+
+        std::this_thread::yield ();
+    }
+
+    std::unique_lock<std::mutex> lock (producers_mutex, std::defer_lock);
+    producers_mutex_site.acquire (lock);
+    producers_waiting.fetch_add (1, std::memory_order_seq_cst);
+    // Ready may have side effects, it is not called again once it
+    // has returned true.
+    bool done = false;
+    producers_cv.wait (lock, [&] { return (done = ready ()) || abandon (); });
+    producers_waiting.fetch_sub (1, std::memory_order_relaxed);
+    return done;
+}
+
+
+bool
+Queue::wait_for_free_slot (Slot & slot, std::size_t pos)
+{
+    return wait_producer ([&] {
+        return slot.sequence.load (std::memory_order_acquire) == pos; });
+}
+
+
+bool
+Queue::try_reserve_bytes (std::size_t bytes)
+{
+    std::size_t const limit = max_bytes.load (std::memory_order_relaxed);
+    std::size_t used = queued_bytes.load (std::memory_order_relaxed);
+    do
+    {
+        if (limit != 0 && used != 0 && used + bytes > limit)
+            return false;
+    }
+    while (! queued_bytes.compare_exchange_weak (used, used + bytes,
+            std::memory_order_seq_cst, std::memory_order_relaxed));
+
+    return true;
+}
+
+
+void
+Queue::release_bytes (std::size_t bytes)
+{
+    if (bytes != 0)
+        queued_bytes.fetch_sub (bytes, std::memory_order_seq_cst);
+}
+
+
+void
+Queue::wake_producers ()
+{
+    if (producers_waiting.load (std::memory_order_seq_cst) != 0)
+    {
+        std::unique_lock<std::mutex> lock (producers_mutex, std::defer_lock);
+        producers_mutex_site.acquire (lock);
+        producers_cv.notify_all ();
+    }
+}
+
+
+bool
+Queue::try_claim_slot (std::size_t & pos)
+{
+    pos = tail.load (std::memory_order_relaxed);
+    while (true)
+    {
+        std::size_t const seq
+            = slots[pos & mask].sequence.load (std::memory_order_acquire);
+        auto const diff = static_cast<std::ptrdiff_t> (seq - pos);
+        if (diff == 0)
+        {
+            if (tail.compare_exchange_weak (pos, pos + 1,
+                    std::memory_order_relaxed))
+                return true;
+        }
+        else if (diff < 0)
+            return false;
+        else
+            pos = tail.load (std::memory_order_relaxed);
+    }
+}
+
+
+Queue::flags_type
+Queue::put_event (spi::InternalLoggingEvent const & ev, unsigned fields)
+{
+    return put_event_impl (ev, fields, true);
+}
+
+
 Queue::flags_type
-Queue::put_event (spi::InternalLoggingEvent const & ev)
+Queue::try_put_event (spi::InternalLoggingEvent const & ev,
+    unsigned fields)
+{
+    return put_event_impl (ev, fields, false);
+}
+
+
+Queue::flags_type
+Queue::put_event_impl (spi::InternalLoggingEvent const & ev,
+    unsigned fields, bool block)
 {
     flags_type ret_flags = ERROR_BIT;
+
+    struct active_producer_guard
+    {
+        std::atomic<std::size_t> & count;
+
+        explicit active_producer_guard (std::atomic<std::size_t> & c)
+            : count (c)
+        {
+            count.fetch_add (1, std::memory_order_seq_cst);
+        }
+
+        ~active_producer_guard ()
+        {
+            count.fetch_sub (1, std::memory_order_release);
+        }
+    };
+
     try
     {
-        ev.gatherThreadSpecificData ();
+        ev.gatherThreadSpecificData (fields);
+
+        active_producer_guard producer_guard (active_producers);
 
-        SemaphoreGuard semguard (sem);
-        MutexGuard mguard (mutex);
+        ret_flags |= flags.load (std::memory_order_seq_cst);
+        if (ret_flags & EXIT)
+        {
+            ret_flags &= ~(ERROR_BIT | ERROR_AFTER);
+            return ret_flags;
+        }
+
+        // Bytes are reserved before the slot is claimed, a producer
+        // holding a claimed slot while it waits for bytes would stall
+        // the consumer.
+        struct bytes_reservation
+        {
+            Queue & queue;
+            std::size_t bytes = 0;
 
-        ret_flags |= flags;
+            ~bytes_reservation ()
+            {
+                if (bytes != 0)
+                {
+                    queue.release_bytes (bytes);
+                    queue.wake_producers ();
+                }
+            }
+        } reservation {*this};
 
-        if (flags & EXIT)
+        std::size_t const bytes = event_footprint (ev, fields);
+        if (try_reserve_bytes (bytes))
+            reservation.bytes = bytes;
+        else if (! block)
         {
+            ret_flags |= FULL;
             ret_flags &= ~(ERROR_BIT | ERROR_AFTER);
             return ret_flags;
         }
+        else if (wait_producer ([&] { return try_reserve_bytes (bytes); }))
+            reservation.bytes = bytes;
         else
         {
-            queue.push_back (ev);
-            ret_flags |= ERROR_AFTER;
-            semguard.detach ();
-            flags |= QUEUE;
-            ret_flags |= flags;
-            mguard.unlock ();
-            mguard.detach ();
-            ev_consumer.signal ();
+            ret_flags |= flags.load (std::memory_order_acquire);
+            ret_flags &= ~(ERROR_BIT | ERROR_AFTER);
+            return ret_flags;
         }
+
+        std::size_t pos;
+        if (block)
+        {
+            pos = tail.fetch_add (1, std::memory_order_relaxed);
+            if (! wait_for_free_slot (slots[pos & mask], pos))
+            {
+                ret_flags |= flags.load (std::memory_order_acquire);
+                ret_flags &= ~(ERROR_BIT | ERROR_AFTER);
+                return ret_flags;
+            }
+        }
+        else if (! try_claim_slot (pos))
+        {
+            ret_flags |= FULL;
+            ret_flags &= ~(ERROR_BIT | ERROR_AFTER);
+            return ret_flags;
+        }
+
+        // The slot owns the bytes from now on.
+        Slot & slot = slots[pos & mask];
+        slot.bytes = reservation.bytes;
+        reservation.bytes = 0;
+        ret_flags |= ERROR_AFTER;
+        Queue & consumer = owner ? *owner : *this;
+        try
+        {
+            slot.event.assign (ev, fields);
+            if (! consumer.sequence_key.empty ())
+                slot.event.getKeyValues ().addUInt (consumer.sequence_key,
+                    consumer.next_sequence->fetch_add (1,
+                        std::memory_order_relaxed));
+            slot.valid = true;
+            slot.timestamp.store (
+                slot.event.getTimestamp ().time_since_epoch ().count (),
+                std::memory_order_relaxed);
+        }
+        catch (...)
+        {
+            // Publish the slot anyway so that the consumer does not
+            // stall on it.
+            slot.valid = false;
+            slot.sequence.store (pos + 1, std::memory_order_seq_cst);
+            throw;
+        }
+
+        slot.sequence.store (pos + 1, std::memory_order_seq_cst);
+        ret_flags |= flags.load (std::memory_order_relaxed) | QUEUE;
+
+        // Consumer of a lane waits on its owner.
+        if (consumer.consumer_waiting.load (std::memory_order_seq_cst)
+            && consumer.consumer_waiting.exchange (false,
+                std::memory_order_acq_rel))
+            consumer.ev_consumer.signal ();
+
+        note_depth (current_depth ());
     }
-    catch (std::runtime_error const & e)
+    catch (std::exception const & e)
     {
         log4cplus::helpers::getLogLog().error(
             LOG4CPLUS_TEXT("put_event() exception: ")
@@ -88,6 +421,67 @@ Queue::put_event (spi::InternalLoggingEvent const & ev)
 }
 
 
+bool
+Queue::discard_oldest ()
+{
+    Slot * slot;
+    std::size_t pos = head.load (std::memory_order_relaxed);
+    if (! try_take_head (pos, slot))
+        return false;
+
+    release_slot (*slot, pos);
+    wake_producers ();
+    return true;
+}
+
+
+bool
+Queue::empty () const
+{
+    return ! any_published ();
+}
+
+
+bool
+Queue::idle () const
+{
+    return ! any_active_producer ()
+        && consumer_waiting.load (std::memory_order_seq_cst)
+        && ! any_published ();
+}
+
+
+std::size_t
+Queue::add_lane (unsigned len)
+{
+    QueuePtr lane (new Queue (len));
+    lane->owner = this;
+    lanes.push_back (lane);
+    return lanes.size () - 1;
+}
+
+
+std::size_t
+Queue::lane_count () const
+{
+    return lanes.size ();
+}
+
+
+Queue &
+Queue::get_lane (std::size_t i) const
+{
+    return *lanes.at (i);
+}
+
+
+void
+Queue::set_sequence_key (tstring key)
+{
+    sequence_key = std::move (key);
+}
+
+
 Queue::flags_type
 Queue::signal_exit (bool drain)
 {
@@ -95,22 +489,32 @@ Queue::signal_exit (bool drain)
 
     try
     {
-        MutexGuard mguard (mutex);
+        flags_type old_flags = flags.load (std::memory_order_relaxed);
+        flags_type new_flags;
+        do
+        {
+            if (old_flags & EXIT)
+                return old_flags;
+
+            new_flags = (drain ? (old_flags | DRAIN) : (old_flags & ~DRAIN))
+                | EXIT;
+        }
+        while (! flags.compare_exchange_weak (old_flags, new_flags,
+                std::memory_order_seq_cst));
 
-        ret_flags |= flags;
+        ret_flags = new_flags;
+        consumer_waiting.store (false, std::memory_order_relaxed);
+        ev_consumer.signal ();
 
-        if (! (flags & EXIT))
         {
-            if (drain)
-                flags |= DRAIN;
-            else
-                flags &= ~DRAIN;
-            flags |= EXIT;
-            ret_flags = flags;
-            mguard.unlock ();
-            mguard.detach ();
-            ev_consumer.signal ();
+            std::unique_lock<std::mutex> lock (producers_mutex,
+                std::defer_lock);
+            producers_mutex_site.acquire (lock);
+            producers_cv.notify_all ();
         }
+
+        for (QueuePtr const & lane : lanes)
+            lane->signal_exit (drain);
     }
     catch (std::runtime_error const & e)
     {
@@ -125,6 +529,316 @@ Queue::signal_exit (bool drain)
 }
 
 
+std::size_t
+Queue::current_depth () const
+{
+    // Head is read first. It never passes tail, so the difference
+    // cannot underflow.
+    std::size_t const h = head.load (std::memory_order_acquire);
+    std::size_t const t = tail.load (std::memory_order_acquire);
+    return t - h;
+}
+
+
+void
+Queue::note_depth (std::size_t depth)
+{
+    std::size_t hwm = high_water.load (std::memory_order_relaxed);
+    while (depth > hwm
+        && ! high_water.compare_exchange_weak (hwm, depth,
+            std::memory_order_relaxed))
+    { }
+
+    std::size_t const threshold
+        = high_water_threshold.load (std::memory_order_relaxed);
+    if (threshold == 0 || depth < threshold
+        || ! high_water_armed.load (std::memory_order_relaxed)
+        || ! high_water_armed.exchange (false, std::memory_order_acq_rel))
+        return;
+
+    HighWaterCallback callback;
+    {
+        std::lock_guard<std::mutex> lock (high_water_mutex);
+        callback = high_water_callback;
+    }
+
+    if (callback)
+        callback (depth);
+}
+
+
+QueueStats
+Queue::get_stats () const
+{
+    QueueStats stats;
+    stats.capacity = slots.size ();
+    stats.depth = (std::min) (current_depth (), slots.size ());
+    stats.highWaterMark = (std::min) (
+        high_water.load (std::memory_order_relaxed), slots.size ());
+    stats.blockedPuts = blocked_puts.load (std::memory_order_relaxed);
+    stats.blockedTime = std::chrono::nanoseconds (
+        blocked_ns.load (std::memory_order_relaxed));
+    stats.batches = batches.load (std::memory_order_relaxed);
+    stats.batchedEvents = batched_events.load (std::memory_order_relaxed);
+    stats.maxBatch = max_batch.load (std::memory_order_relaxed);
+    stats.queuedBytes = queued_bytes.load (std::memory_order_relaxed);
+    stats.maxBytes = max_bytes.load (std::memory_order_relaxed);
+
+    std::size_t const pos = head.load (std::memory_order_acquire);
+    Slot const & slot = slots[pos & mask];
+    if (slot.sequence.load (std::memory_order_acquire) == pos + 1)
+    {
+        std::int64_t const timestamp
+            = slot.timestamp.load (std::memory_order_relaxed);
+        // The slot could have been consumed and refilled meanwhile;
+        // the age is an estimate either way.
+        auto const age = helpers::now ().time_since_epoch ().count ()
+            - timestamp;
+        if (age > 0)
+            stats.oldestEventAge = std::chrono::microseconds (age);
+    }
+
+    return stats;
+}
+
+
+void
+Queue::set_high_water_callback (std::size_t threshold,
+    HighWaterCallback callback)
+{
+    {
+        std::lock_guard<std::mutex> lock (high_water_mutex);
+        high_water_callback = std::move (callback);
+    }
+
+    high_water_armed.store (true, std::memory_order_relaxed);
+    high_water_threshold.store (threshold, std::memory_order_release);
+}
+
+
+void
+Queue::set_max_bytes (std::size_t bytes)
+{
+    max_bytes.store (bytes, std::memory_order_seq_cst);
+    // Producers waiting for bytes may fit under the new limit.
+    wake_producers ();
+}
+
+
+std::size_t
+Queue::get_max_bytes () const
+{
+    return max_bytes.load (std::memory_order_relaxed);
+}
+
+
+Queue *
+Queue::clone_empty () const
+{
+    return clone_empty (static_cast<unsigned> (slots.size ()));
+}
+
+
+Queue *
+Queue::clone_empty (unsigned len) const
+{
+    std::unique_ptr<Queue> queue (new Queue (len));
+    {
+        std::lock_guard<std::mutex> lock (high_water_mutex);
+        queue->high_water_callback = high_water_callback;
+    }
+    queue->high_water_threshold.store (
+        high_water_threshold.load (std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    queue->max_bytes.store (max_bytes.load (std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    for (QueuePtr const & lane : lanes)
+    {
+        QueuePtr clone (lane->clone_empty ());
+        clone->owner = queue.get ();
+        queue->lanes.push_back (clone);
+    }
+    queue->sequence_key = sequence_key;
+    queue->next_sequence = next_sequence;
+    return queue.release ();
+}
+
+
+void
+Queue::emergency_visit (
+    void (* visit) (spi::InternalLoggingEvent const &, void *),
+    void * arg) const noexcept
+{
+    for (QueuePtr const & lane : lanes)
+        lane->emergency_visit (visit, arg);
+
+    std::size_t const first = head.load (std::memory_order_acquire);
+    std::size_t const last = tail.load (std::memory_order_acquire);
+    for (std::size_t pos = first;
+         pos != last && pos - first < slots.size (); ++pos)
+    {
+        Slot const & slot = slots[pos & mask];
+        if (slot.sequence.load (std::memory_order_acquire) == pos + 1
+            && slot.valid)
+            visit (slot.event, arg);
+    }
+}
+
+
+bool
+Queue::head_published () const
+{
+    std::size_t const pos = head.load (std::memory_order_relaxed);
+    return slots[pos & mask].sequence.load (std::memory_order_seq_cst)
+        == pos + 1;
+}
+
+
+bool
+Queue::any_published () const
+{
+    return head_published ()
+        || std::any_of (lanes.begin (), lanes.end (),
+            [] (QueuePtr const & lane) { return lane->head_published (); });
+}
+
+
+bool
+Queue::any_active_producer () const
+{
+    return active_producers.load (std::memory_order_seq_cst) != 0
+        || std::any_of (lanes.begin (), lanes.end (),
+            [] (QueuePtr const & lane) {
+                return lane->active_producers.load (
+                    std::memory_order_seq_cst) != 0; });
+}
+
+
+bool
+Queue::try_take_head (std::size_t & pos, Slot * & slot)
+{
+    // The consumer and producers discarding oldest events compete for
+    // the head position.
+    while (true)
+    {
+        slot = &slots[pos & mask];
+        if (slot->sequence.load (std::memory_order_seq_cst) != pos + 1)
+            return false;
+
+        if (head.compare_exchange_weak (pos, pos + 1,
+                std::memory_order_acq_rel, std::memory_order_relaxed))
+            return true;
+    }
+}
+
+
+void
+Queue::release_slot (Slot & slot, std::size_t pos)
+{
+    slot.valid = false;
+    release_bytes (slot.bytes);
+    slot.bytes = 0;
+    slot.sequence.store (pos + slots.size (), std::memory_order_seq_cst);
+}
+
+
+std::size_t
+Queue::take_published (queue_storage_type * buf)
+{
+    Queue & consumer = owner ? *owner : *this;
+    // The buffer is reserved for total_capacity() events; taking more
+    // would grow it and copy the events. The rest waits for the next
+    // get_events() call.
+    std::size_t const limit = consumer.total_capacity ();
+    std::size_t count = 0;
+    std::size_t pos = head.load (std::memory_order_relaxed);
+    Slot * slot;
+    while ((! buf || buf->size () < limit) && try_take_head (pos, slot))
+    {
+        if (slot->valid && buf)
+        {
+            buf->emplace_back ();
+            buf->back ().swap (slot->event);
+
+            queue_storage_type & spare = consumer.spare_events;
+            if (! spare.empty ())
+            {
+                slot->event.swap (spare.back ());
+                spare.pop_back ();
+            }
+        }
+
+        release_slot (*slot, pos);
+        ++pos;
+        ++count;
+
+        // Let blocked producers proceed while we keep draining.
+        if ((count & mask) == 0)
+            wake_producers ();
+    }
+
+    if (count != 0)
+        wake_producers ();
+
+    return count;
+}
+
+
+void
+Queue::recycle_events (queue_storage_type & buf)
+{
+    static spi::InternalLoggingEvent const empty;
+
+    // Reserved once, growing the vector would copy the events.
+    if (spare_events.capacity () == 0)
+        spare_events.reserve (total_capacity ());
+
+    for (spi::InternalLoggingEvent & ev : buf)
+    {
+        if (spare_events.size () == spare_events.capacity ())
+            break;
+
+        // Drops references to MDC snapshots, shared messages and stack
+        // traces; a kept MDC snapshot would make its thread copy MDC
+        // on its next change.
+        ev.assign (empty, spi::EVENT_FIELDS_NONE);
+        spare_events.emplace_back ();
+        spare_events.back ().swap (ev);
+    }
+
+    buf.clear ();
+}
+
+
+std::size_t
+Queue::total_capacity () const
+{
+    std::size_t capacity = slots.size ();
+    for (QueuePtr const & lane : lanes)
+        capacity += lane->slots.size ();
+    return capacity;
+}
+
+
+void
+Queue::note_batch (std::size_t size)
+{
+    if (size == 0)
+        return;
+
+    // Only the consumer writes these.
+    batches.fetch_add (1, std::memory_order_relaxed);
+    batched_events.fetch_add (size, std::memory_order_relaxed);
+    if (size > max_batch.load (std::memory_order_relaxed))
+        max_batch.store (size, std::memory_order_relaxed);
+
+    std::size_t const threshold
+        = high_water_threshold.load (std::memory_order_relaxed);
+    if (threshold != 0 && current_depth () < threshold)
+        high_water_armed.store (true, std::memory_order_relaxed);
+}
+
+
 Queue::flags_type
 Queue::get_events (queue_storage_type * buf)
 {
@@ -132,45 +846,58 @@ Queue::get_events (queue_storage_type * buf)
 
     try
     {
+        recycle_events (*buf);
+        // Lanes included, growing the buffer would copy the events.
+        buf->reserve (total_capacity ());
+
         while (true)
         {
-            MutexGuard mguard (mutex);
+            ret_flags = flags.load (std::memory_order_seq_cst);
 
-            ret_flags = flags;
-
-            if (((QUEUE & flags) && ! (EXIT & flags))
-                || ((EXIT | DRAIN | QUEUE) & flags) == (EXIT | DRAIN | QUEUE))
+            if (any_published ())
             {
-                assert (! queue.empty ());
-
-                std::size_t const count = queue.size ();
-                queue.swap (*buf);
-                queue.clear ();
-                flags &= ~QUEUE;
-                for (std::size_t i = 0; i != count; ++i)
-                    sem.unlock ();
-
-                ret_flags = flags | EVENT;
-                break;
+                if (! (EXIT & ret_flags) || (DRAIN & ret_flags))
+                {
+                    // Lanes go first, their events must not wait
+                    // behind a backlog of this queue.
+                    for (QueuePtr const & lane : lanes)
+                        lane->take_published (buf);
+                    take_published (buf);
+                    note_batch (buf->size ());
+                    ret_flags = flags.load (std::memory_order_relaxed);
+                    if (! buf->empty ())
+                    {
+                        ret_flags |= EVENT;
+                        break;
+                    }
+                }
+                else
+                {
+                    for (QueuePtr const & lane : lanes)
+                        lane->take_published (nullptr);
+                    take_published (nullptr);
+                    break;
+                }
             }
-            else if (((EXIT | QUEUE) & flags) == (EXIT | QUEUE))
+            else if (EXIT & ret_flags)
             {
-                assert (! queue.empty ());
-                queue.clear ();
-                flags &= ~QUEUE;
-                ev_consumer.reset ();
-                sem.unlock ();
-                ret_flags = flags;
-                break;
+                // Producers that entered put_event() before EXIT was
+                // set still get their events drained.
+                if (! (DRAIN & ret_flags)
+                    || (! any_active_producer () && ! any_published ()))
+                    break;
+
+                std::this_thread::yield ();
             }
-            else if (EXIT & flags)
-                break;
             else
             {
                 ev_consumer.reset ();
-                mguard.unlock ();
-                mguard.detach ();
-                ev_consumer.wait ();
+                consumer_waiting.store (true, std::memory_order_seq_cst);
+                if (any_published ()
+                    || (flags.load (std::memory_order_seq_cst) & EXIT))
+                    consumer_waiting.store (false, std::memory_order_relaxed);
+                else
+                    ev_consumer.wait ();
             }
         }
     }
@@ -186,6 +913,293 @@ Queue::get_events (queue_storage_type * buf)
 }
 
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Queue", "[queue]")
+{
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("test"),
+        INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("queue test message"),
+        __FILE__, __LINE__);
+
+    CATCH_SECTION ("events are drained on exit")
+    {
+        QueuePtr queue (new Queue (4));
+        for (int i = 0; i != 3; ++i)
+            CATCH_REQUIRE ((queue->put_event (ev) & Queue::ERROR_BIT) == 0);
+
+        queue->signal_exit (true);
+
+        Queue::queue_storage_type buf;
+        Queue::flags_type flags = queue->get_events (&buf);
+        CATCH_REQUIRE ((flags & Queue::EVENT) != 0);
+        CATCH_REQUIRE (buf.size () == 3);
+        CATCH_REQUIRE (buf.front ().getMessage () == ev.getMessage ());
+
+        flags = queue->get_events (&buf);
+        CATCH_REQUIRE ((flags & Queue::EVENT) == 0);
+        CATCH_REQUIRE ((flags & Queue::EXIT) != 0);
+    }
+
+    CATCH_SECTION ("events are discarded on exit without drain")
+    {
+        QueuePtr queue (new Queue (4));
+        queue->put_event (ev);
+        queue->signal_exit (false);
+
+        Queue::queue_storage_type buf;
+        Queue::flags_type flags = queue->get_events (&buf);
+        CATCH_REQUIRE ((flags & Queue::EVENT) == 0);
+        CATCH_REQUIRE (buf.empty ());
+        CATCH_REQUIRE ((queue->put_event (ev) & Queue::EXIT) != 0);
+    }
+
+    CATCH_SECTION ("slots reuse storage of consumed events")
+    {
+        tstring const long_message (200, LOG4CPLUS_TEXT ('x'));
+        spi::InternalLoggingEvent const long_ev (LOG4CPLUS_TEXT ("test"),
+            INFO_LOG_LEVEL, long_message, __FILE__, __LINE__);
+        QueuePtr queue (new Queue (2));
+        Queue::queue_storage_type buf;
+
+        // The first batch is recycled into the slots by the second
+        // get_events() call, the third batch lands in its storage.
+        for (int round = 0; round != 3; ++round)
+        {
+            spi::InternalLoggingEvent const & put
+                = round == 0 ? long_ev : ev;
+            queue->put_event (put);
+            queue->put_event (put);
+            CATCH_REQUIRE ((queue->get_events (&buf) & Queue::EVENT) != 0);
+            CATCH_REQUIRE (buf.size () == 2);
+            CATCH_REQUIRE (buf.back ().getMessage () == put.getMessage ());
+        }
+
+        for (spi::InternalLoggingEvent const & queued : buf)
+            CATCH_REQUIRE (queued.getMessage ().capacity ()
+                >= long_message.size ());
+    }
+
+    CATCH_SECTION ("batches stay within capacity while slots are recycled")
+    {
+        // Slots emptied by take_published() are refilled by producers
+        // while the consumer is still taking a long run of them; the
+        // batch must still fit the reserved buffer.
+        unsigned const producers_count = 4;
+        unsigned const events_count = 20000;
+        QueuePtr queue (new Queue (1024));
+        Queue & lane = queue->get_lane (queue->add_lane (2));
+        std::size_t const capacity = 1024 + 2;
+
+        std::vector<std::thread> producers;
+        for (unsigned i = 0; i != producers_count; ++i)
+            producers.emplace_back ([&, i] {
+                Queue & q = i % 2 ? lane : *queue;
+                // Spinning producers take a slot as soon as it is
+                // released.
+                for (unsigned j = 0; j != events_count; ++j)
+                    while (q.try_put_event (ev) & Queue::FULL)
+                        ;
+            });
+
+        Queue::queue_storage_type buf;
+        std::size_t received = 0;
+        spi::InternalLoggingEvent const * storage = nullptr;
+        bool bounded = true;
+        bool stable = true;
+        while (received != producers_count * events_count)
+        {
+            if (! (queue->get_events (&buf) & Queue::EVENT))
+                continue;
+
+            bounded = bounded && buf.size () <= capacity;
+            if (! storage)
+                storage = buf.data ();
+            stable = stable && buf.data () == storage;
+            received += buf.size ();
+        }
+
+        for (std::thread & producer : producers)
+            producer.join ();
+
+        CATCH_REQUIRE (bounded);
+        CATCH_REQUIRE (stable);
+        CATCH_REQUIRE (queue->empty ());
+    }
+
+    CATCH_SECTION ("try_put_event() does not block on full queue")
+    {
+        QueuePtr queue (new Queue (2));
+        CATCH_REQUIRE ((queue->try_put_event (ev) & Queue::FULL) == 0);
+        CATCH_REQUIRE ((queue->try_put_event (ev) & Queue::FULL) == 0);
+        CATCH_REQUIRE ((queue->try_put_event (ev) & Queue::FULL) != 0);
+
+        CATCH_REQUIRE (queue->discard_oldest ());
+        CATCH_REQUIRE ((queue->try_put_event (ev) & Queue::FULL) == 0);
+
+        Queue::queue_storage_type buf;
+        CATCH_REQUIRE ((queue->get_events (&buf) & Queue::EVENT) != 0);
+        CATCH_REQUIRE (buf.size () == 2);
+        CATCH_REQUIRE (queue->empty ());
+        CATCH_REQUIRE (! queue->discard_oldest ());
+    }
+
+    CATCH_SECTION ("multiple producers")
+    {
+        unsigned const producers_count = 4;
+        std::size_t const events_per_producer = 1000;
+        QueuePtr queue (new Queue (8));
+
+        std::vector<std::thread> producers;
+        for (unsigned i = 0; i != producers_count; ++i)
+            producers.emplace_back ([&] {
+                for (std::size_t j = 0; j != events_per_producer; ++j)
+                    queue->put_event (ev);
+            });
+
+        std::size_t received = 0;
+        Queue::queue_storage_type buf;
+        while (received != producers_count * events_per_producer)
+        {
+            Queue::flags_type const flags = queue->get_events (&buf);
+            CATCH_REQUIRE ((flags & Queue::EVENT) != 0);
+            received += buf.size ();
+        }
+
+        for (auto & thread : producers)
+            thread.join ();
+
+        queue->signal_exit (true);
+        CATCH_REQUIRE ((queue->get_events (&buf) & Queue::EVENT) == 0);
+        CATCH_REQUIRE (received == producers_count * events_per_producer);
+
+        QueueStats const stats = queue->get_stats ();
+        CATCH_REQUIRE (stats.batchedEvents == received);
+        CATCH_REQUIRE (stats.maxBatch <= stats.capacity);
+        CATCH_REQUIRE (stats.depth == 0);
+    }
+
+    CATCH_SECTION ("statistics and high-water callback")
+    {
+        QueuePtr queue (new Queue (8));
+        std::vector<std::size_t> calls;
+        queue->set_high_water_callback (3,
+            [&calls] (std::size_t depth) { calls.push_back (depth); });
+
+        for (int i = 0; i != 5; ++i)
+            queue->put_event (ev);
+
+        QueueStats stats = queue->get_stats ();
+        CATCH_REQUIRE (stats.capacity == 8);
+        CATCH_REQUIRE (stats.depth == 5);
+        CATCH_REQUIRE (stats.highWaterMark == 5);
+        CATCH_REQUIRE (stats.blockedPuts == 0);
+        CATCH_REQUIRE (calls == std::vector<std::size_t> {3});
+
+        Queue::queue_storage_type buf;
+        queue->get_events (&buf);
+        stats = queue->get_stats ();
+        CATCH_REQUIRE (stats.depth == 0);
+        CATCH_REQUIRE (stats.batches == 1);
+        CATCH_REQUIRE (stats.maxBatch == 5);
+        CATCH_REQUIRE (stats.oldestEventAge.count () == 0);
+
+        // Callback is re-armed once the queue drains below threshold.
+        for (int i = 0; i != 3; ++i)
+            queue->put_event (ev);
+        CATCH_REQUIRE (calls == std::vector<std::size_t> {3, 3});
+        std::this_thread::sleep_for (std::chrono::milliseconds (2));
+        CATCH_REQUIRE (queue->get_stats ().oldestEventAge
+            >= std::chrono::milliseconds (2));
+    }
+
+    CATCH_SECTION ("byte limit")
+    {
+        spi::InternalLoggingEvent const big (LOG4CPLUS_TEXT ("test"),
+            INFO_LOG_LEVEL, tstring (10000, LOG4CPLUS_TEXT ('x')),
+            __FILE__, __LINE__);
+
+        QueuePtr queue (new Queue (64));
+        queue->set_max_bytes (3 * 10000 * sizeof (tchar));
+        CATCH_REQUIRE ((queue->try_put_event (ev) & Queue::FULL) == 0);
+        CATCH_REQUIRE ((queue->try_put_event (big) & Queue::FULL) == 0);
+        CATCH_REQUIRE ((queue->try_put_event (big) & Queue::FULL) == 0);
+        CATCH_REQUIRE ((queue->try_put_event (big) & Queue::FULL) != 0);
+        CATCH_REQUIRE (queue->get_stats ().depth == 3);
+        std::size_t const queued = queue->get_stats ().queuedBytes;
+        CATCH_REQUIRE (queued > 2 * 10000 * sizeof (tchar));
+        CATCH_REQUIRE (queued <= queue->get_max_bytes ());
+
+        // Blocked producer proceeds once the consumer frees bytes.
+        std::thread producer ([&] { queue->put_event (big); });
+        Queue::queue_storage_type buf;
+        std::size_t received = 0;
+        while (received != 4)
+        {
+            CATCH_REQUIRE ((queue->get_events (&buf) & Queue::EVENT) != 0);
+            received += buf.size ();
+        }
+        producer.join ();
+        CATCH_REQUIRE (queue->get_stats ().queuedBytes == 0);
+
+        // Event larger than the limit still gets into empty queue.
+        queue->set_max_bytes (100);
+        CATCH_REQUIRE ((queue->try_put_event (big) & Queue::FULL) == 0);
+        CATCH_REQUIRE ((queue->try_put_event (ev) & Queue::FULL) != 0);
+        CATCH_REQUIRE (queue->discard_oldest ());
+        CATCH_REQUIRE (queue->get_stats ().queuedBytes == 0);
+    }
+
+    CATCH_SECTION ("lanes")
+    {
+        spi::InternalLoggingEvent const fatal (LOG4CPLUS_TEXT ("test"),
+            FATAL_LOG_LEVEL, LOG4CPLUS_TEXT ("fatal"), __FILE__, __LINE__);
+
+        QueuePtr queue (new Queue (2));
+        queue->set_sequence_key (LOG4CPLUS_TEXT ("seq"));
+        Queue & lane = queue->get_lane (queue->add_lane (4));
+        CATCH_REQUIRE (queue->lane_count () == 1);
+
+        CATCH_REQUIRE ((queue->try_put_event (ev) & Queue::FULL) == 0);
+        CATCH_REQUIRE ((queue->try_put_event (ev) & Queue::FULL) == 0);
+        CATCH_REQUIRE ((queue->try_put_event (ev) & Queue::FULL) != 0);
+
+        // Full main queue does not hold up the lane.
+        CATCH_REQUIRE ((lane.try_put_event (fatal) & Queue::FULL) == 0);
+
+        Queue::queue_storage_type buf;
+        CATCH_REQUIRE ((queue->get_events (&buf) & Queue::EVENT) != 0);
+        CATCH_REQUIRE (buf.size () == 3);
+        CATCH_REQUIRE (buf.front ().getMessage () == fatal.getMessage ());
+
+        spi::KeyValue kv;
+        CATCH_REQUIRE (buf.front ().getKeyValues ().find (
+            LOG4CPLUS_TEXT ("seq"), kv));
+        CATCH_REQUIRE (kv.u == 2);
+        CATCH_REQUIRE (buf.back ().getKeyValues ().find (
+            LOG4CPLUS_TEXT ("seq"), kv));
+        CATCH_REQUIRE (kv.u == 1);
+
+        // Consumer waiting on the queue is woken by the lane.
+        std::thread producer ([&] { lane.put_event (fatal); });
+        CATCH_REQUIRE ((queue->get_events (&buf) & Queue::EVENT) != 0);
+        CATCH_REQUIRE (buf.size () == 1);
+        producer.join ();
+
+        // Clones keep lanes, exit drains them.
+        QueuePtr clone (queue->clone_empty ());
+        CATCH_REQUIRE (clone->lane_count () == 1);
+        clone->get_lane (0).put_event (fatal);
+        CATCH_REQUIRE (! clone->empty ());
+        clone->signal_exit (true);
+        CATCH_REQUIRE ((clone->get_lane (0).put_event (fatal) & Queue::EXIT)
+            != 0);
+        CATCH_REQUIRE ((clone->get_events (&buf) & Queue::EVENT) != 0);
+        CATCH_REQUIRE (buf.size () == 1);
+        CATCH_REQUIRE (clone->empty ());
+    }
+}
+#endif
+
+
 } // namespace log4cplus::thread
 
 
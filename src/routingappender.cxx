@@ -0,0 +1,553 @@
+// Module:  Log4cplus
+// File:    routingappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/routingappender.h>
+#include <log4cplus/spi/factory.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <log4cplus/internal/internal.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/mdc.h>
+#include <catch.hpp>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+//! Placeholder of route key in file names, see <tt>File</tt> property
+//! of the children.
+tchar const route_key_token[] = LOG4CPLUS_TEXT ("%route");
+
+
+//! Child of a route. Dropping the last reference closes the child, so
+//! an evicted child is closed only after events being appended to it
+//! by other threads are done.
+struct route_child
+{
+    explicit route_child (SharedAppenderPtr app)
+        : appender (std::move (app))
+    { }
+
+    ~route_child ()
+    {
+        try
+        {
+            appender->close ();
+        }
+        catch (...)
+        {
+            // The child reports its errors itself.
+        }
+    }
+
+    SharedAppenderPtr const appender;
+};
+
+
+typedef std::shared_ptr<route_child> route_child_ptr;
+
+
+struct route_key_hash
+{
+    using is_transparent = void;
+
+    std::size_t
+    operator () (tstring_view key) const noexcept
+    {
+        return std::hash<tstring_view> () (key);
+    }
+};
+
+
+//! Returns <code>key</code> usable as part of file name.
+tstring
+sanitize_route_key (tstring_view key)
+{
+    tstring name (key);
+    for (tchar & ch : name)
+        if (! ((ch >= LOG4CPLUS_TEXT ('a') && ch <= LOG4CPLUS_TEXT ('z'))
+                || (ch >= LOG4CPLUS_TEXT ('A') && ch <= LOG4CPLUS_TEXT ('Z'))
+                || (ch >= LOG4CPLUS_TEXT ('0') && ch <= LOG4CPLUS_TEXT ('9'))
+                || ch == LOG4CPLUS_TEXT ('-') || ch == LOG4CPLUS_TEXT ('_')
+                || ch == LOG4CPLUS_TEXT ('.')))
+            ch = LOG4CPLUS_TEXT ('_');
+
+    // No hidden files and no "..".
+    if (! name.empty () && name[0] == LOG4CPLUS_TEXT ('.'))
+        name[0] = LOG4CPLUS_TEXT ('_');
+
+    return name;
+}
+
+
+//! Returns <code>file</code> with <tt>%route</tt> placeholders replaced
+//! by sanitized <code>key</code>, or with the key appended if it has
+//! none.
+tstring
+expand_route_file (tstring const & file, tstring_view key)
+{
+    tstring const id = sanitize_route_key (key);
+    tstring::size_type const token_len = sizeof (route_key_token)
+        / sizeof (route_key_token[0]) - 1;
+
+    tstring::size_type found = file.find (route_key_token);
+    if (found == tstring::npos)
+        return file + LOG4CPLUS_TEXT (".") + id;
+
+    tstring name;
+    tstring::size_type pos = 0;
+    for (; found != tstring::npos;
+        pos = found + token_len,
+            found = file.find (route_key_token, pos))
+    {
+        name.append (file, pos, found - pos);
+        name += id;
+    }
+    name.append (file, pos, tstring::npos);
+
+    return name;
+}
+
+} // namespace
+
+
+struct RoutingAppender::Routes
+{
+    struct Route
+    {
+        route_child_ptr child;
+        //! Position of the key in <code>lru</code>.
+        std::list<tstring const *>::iterator position;
+        helpers::Time lastUsed;
+    };
+
+    std::unordered_map<tstring, Route, route_key_hash, std::equal_to<>>
+        map;
+    //! Keys of <code>map</code>, most recently used first.
+    std::list<tstring const *> lru;
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+    helpers::Time lastIdleCheck;
+#endif
+
+    //! Removes the least recently used route, moving its child into
+    //! <code>evicted</code>.
+    void
+    evict (std::vector<route_child_ptr> & evicted)
+    {
+        auto const it = map.find (*lru.back ());
+        evicted.push_back (std::move (it->second.child));
+        lru.pop_back ();
+        map.erase (it);
+    }
+
+    //! Removes routes last used before <code>limit</code>. Keys in
+    //! <code>lru</code> are ordered by use, so they are at its end.
+    void
+    evict_idle (helpers::Time const & limit,
+        std::vector<route_child_ptr> & evicted)
+    {
+        while (! lru.empty ()
+            && map.find (*lru.back ())->second.lastUsed < limit)
+            evict (evicted);
+    }
+};
+
+
+RoutingAppender::RoutingAppender (RouteFactory factory_,
+    tstring const & mdcKey_, std::size_t maxRoutes_)
+    : factory (std::move (factory_))
+    , mdcKey (mdcKey_)
+    , loggerDepth (1)
+    , defaultRoute (LOG4CPLUS_TEXT ("default"))
+    , maxRoutes (maxRoutes_)
+    , idleTimeout (0)
+{
+    init ();
+}
+
+
+RoutingAppender::RoutingAppender (helpers::Properties const & props)
+    : Appender (props)
+    , mdcKey (props.getProperty (LOG4CPLUS_TEXT ("MDCKey")))
+    , loggerDepth (1)
+    , defaultRoute (props.getProperty (LOG4CPLUS_TEXT ("DefaultRoute"),
+            LOG4CPLUS_TEXT ("default")))
+    , maxRoutes (256)
+    , idleTimeout (0)
+{
+    props.getUInt (loggerDepth, LOG4CPLUS_TEXT ("LoggerDepth"));
+
+    unsigned max_routes = static_cast<unsigned> (maxRoutes);
+    props.getUInt (max_routes, LOG4CPLUS_TEXT ("MaxRoutes"));
+    maxRoutes = max_routes;
+
+    unsigned long idle_seconds = 0;
+    props.getULong (idle_seconds, LOG4CPLUS_TEXT ("IdleTimeout"));
+    idleTimeout = idle_seconds * 1000;
+
+    tstring const & appender_name (
+        props.getProperty (LOG4CPLUS_TEXT ("Appender")));
+    if (appender_name.empty ())
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unspecified appender for RoutingAppender."));
+    else if (spi::AppenderFactory * appender_factory
+        = spi::getAppenderFactoryRegistry ().get (appender_name))
+    {
+        factory = [appender_factory,
+            appender_props = props.getPropertySubset (
+                LOG4CPLUS_TEXT ("Appender."))] (tstring const & key)
+            {
+                helpers::Properties child_props (appender_props);
+                tstring const file = child_props.getProperty (
+                    LOG4CPLUS_TEXT ("File"));
+                if (! file.empty ())
+                    child_props.setProperty (LOG4CPLUS_TEXT ("File"),
+                        expand_route_file (file, key));
+
+                return SharedAppenderPtr (
+                    appender_factory->createObject (child_props));
+            };
+    }
+    else
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("RoutingAppender::RoutingAppender()")
+            LOG4CPLUS_TEXT (" - Cannot find AppenderFactory: ")
+            + appender_name);
+
+    init ();
+}
+
+
+RoutingAppender::~RoutingAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+RoutingAppender::init ()
+{
+    concurrentAppend = true;
+    maxRoutes = (std::max) (maxRoutes, std::size_t (1));
+    routes = std::make_unique<Routes> ();
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (idleTimeout != 0)
+        internal::add_timer (this,
+            std::chrono::milliseconds (idleTimeout),
+            [this] { closeIdleRoutes (); });
+#else
+    routes->lastIdleCheck = helpers::now ();
+#endif
+}
+
+
+void
+RoutingAppender::close ()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    internal::remove_timer (this);
+#endif
+
+    // Children are closed outside of the lock, once threads appending
+    // to them are done.
+    std::vector<route_child_ptr> evicted;
+    {
+        thread::MutexGuard guard (routesMutex);
+        if (closed)
+            return;
+
+        evicted.reserve (routes->map.size ());
+        while (! routes->lru.empty ())
+            routes->evict (evicted);
+        closed = true;
+    }
+}
+
+
+unsigned
+RoutingAppender::getRequiredEventFields () const
+{
+    return spi::EVENT_FIELDS_ALL;
+}
+
+
+SharedAppenderPtr
+RoutingAppender::getRoute (tstring_view key) const
+{
+    thread::MutexGuard guard (routesMutex);
+    auto const it = routes->map.find (key);
+    return it != routes->map.end ()
+        ? it->second.child->appender
+        : SharedAppenderPtr ();
+}
+
+
+std::size_t
+RoutingAppender::getRouteCount () const
+{
+    thread::MutexGuard guard (routesMutex);
+    return routes->map.size ();
+}
+
+
+void
+RoutingAppender::closeIdleRoutes ()
+{
+    if (idleTimeout == 0)
+        return;
+
+    helpers::Time const limit = helpers::now ()
+        - std::chrono::milliseconds (idleTimeout);
+    std::vector<route_child_ptr> evicted;
+    {
+        thread::MutexGuard guard (routesMutex);
+        routes->evict_idle (limit, evicted);
+    }
+}
+
+
+tstring_view
+RoutingAppender::routeKey (spi::InternalLoggingEvent const & event) const
+{
+    if (! mdcKey.empty ())
+        return event.getMDC (mdcKey);
+
+    tstring const & logger = event.getLoggerName ();
+    tstring::size_type end = 0;
+    for (unsigned i = 0; i != loggerDepth; ++i)
+    {
+        end = logger.find (LOG4CPLUS_TEXT ('.'), end);
+        if (end == tstring::npos)
+            return logger;
+
+        if (i + 1 != loggerDepth)
+            ++end;
+    }
+
+    return tstring_view (logger).substr (0, end);
+}
+
+
+void
+RoutingAppender::append (spi::InternalLoggingEvent const & event)
+{
+    tstring_view key = routeKey (event);
+    if (key.empty ())
+        key = defaultRoute;
+
+    route_child_ptr child;
+    std::vector<route_child_ptr> evicted;
+    {
+        thread::MutexGuard guard (routesMutex);
+        if (closed)
+        {
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("Attempted to append to closed appender named [")
+                + name + LOG4CPLUS_TEXT ("]."));
+            return;
+        }
+
+        auto const it = routes->map.find (key);
+        if (it != routes->map.end ())
+        {
+            Routes::Route & route = it->second;
+            routes->lru.splice (routes->lru.begin (), routes->lru,
+                route.position);
+            route.lastUsed = event.getTimestamp ();
+            child = route.child;
+        }
+        else if (factory)
+        {
+            tstring const route_key (key);
+            SharedAppenderPtr app;
+            try
+            {
+                app = factory (route_key);
+            }
+            catch (std::exception const & e)
+            {
+                getErrorHandler ()->error (
+                    LOG4CPLUS_TEXT ("RoutingAppender: cannot create route ")
+                    + route_key + LOG4CPLUS_TEXT (": ")
+                    + LOG4CPLUS_C_STR_TO_TSTRING (e.what ()));
+            }
+            if (! app)
+                return;
+
+            app->setName (name + LOG4CPLUS_TEXT ("/") + route_key);
+            child = std::make_shared<route_child> (std::move (app));
+
+            if (routes->map.size () >= maxRoutes)
+                routes->evict (evicted);
+
+            auto const inserted = routes->map.emplace (route_key,
+                Routes::Route {child, {}, event.getTimestamp ()}).first;
+            routes->lru.push_front (&inserted->first);
+            inserted->second.position = routes->lru.begin ();
+        }
+
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+        // There is no timer thread; idle routes are checked here.
+        if (idleTimeout != 0)
+        {
+            helpers::Time const now = helpers::now ();
+            if (now - routes->lastIdleCheck
+                >= std::chrono::milliseconds (idleTimeout))
+            {
+                routes->lastIdleCheck = now;
+                routes->evict_idle (
+                    now - std::chrono::milliseconds (idleTimeout), evicted);
+            }
+        }
+#endif
+    }
+
+    // A child closed meanwhile by close() reports the event itself.
+    if (child)
+        child->appender->doAppend (event);
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+namespace
+{
+
+class RouteCountingAppender
+    : public Appender
+{
+public:
+    RouteCountingAppender ()
+        : count (0)
+    { }
+
+    virtual ~RouteCountingAppender ()
+    {
+        destructorImpl ();
+    }
+
+    virtual void close ()
+    {
+        closed = true;
+    }
+
+    std::size_t count;
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const &)
+    {
+        ++count;
+    }
+};
+
+} // namespace
+
+
+CATCH_TEST_CASE ("RoutingAppender", "[appender]")
+{
+    CATCH_SECTION ("file names of routes")
+    {
+        CATCH_REQUIRE (expand_route_file (LOG4CPLUS_TEXT ("a.log"),
+                LOG4CPLUS_TEXT ("t1")) == LOG4CPLUS_TEXT ("a.log.t1"));
+        CATCH_REQUIRE (expand_route_file (LOG4CPLUS_TEXT ("%route/%route.log"),
+                LOG4CPLUS_TEXT ("../x y")) == LOG4CPLUS_TEXT ("_._x_y/_._x_y.log"));
+    }
+
+    std::vector<helpers::SharedObjectPtr<RouteCountingAppender>> created;
+    RoutingAppender::RouteFactory const factory
+        = [&created] (tstring const &)
+        {
+            created.emplace_back (new RouteCountingAppender);
+            return SharedAppenderPtr (created.back ().get ());
+        };
+
+    CATCH_SECTION ("routes by MDC key with LRU eviction")
+    {
+        RoutingAppenderPtr routing (new RoutingAppender (factory,
+                LOG4CPLUS_TEXT ("tenant"), 2));
+        MDC & mdc = getMDC ();
+        for (tchar const * tenant : {LOG4CPLUS_TEXT ("a"),
+                LOG4CPLUS_TEXT ("b"), LOG4CPLUS_TEXT ("a"),
+                LOG4CPLUS_TEXT ("c"), LOG4CPLUS_TEXT ("a")})
+        {
+            mdc.put (LOG4CPLUS_TEXT ("tenant"), tenant);
+            spi::InternalLoggingEvent const event (LOG4CPLUS_TEXT ("test"),
+                INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"), nullptr, 0);
+            routing->doAppend (event);
+        }
+        mdc.remove (LOG4CPLUS_TEXT ("tenant"));
+
+        // "b" is the least recently used when "c" arrives.
+        CATCH_REQUIRE (created.size () == 3);
+        CATCH_REQUIRE (created[0]->count == 3);
+        CATCH_REQUIRE (! created[0]->isClosed ());
+        CATCH_REQUIRE (created[1]->isClosed ());
+        CATCH_REQUIRE (routing->getRouteCount () == 2);
+        CATCH_REQUIRE (routing->getRoute (LOG4CPLUS_TEXT ("c")).get ()
+            == created[2].get ());
+        CATCH_REQUIRE (! routing->getRoute (LOG4CPLUS_TEXT ("b")));
+
+        routing->close ();
+        CATCH_REQUIRE (created[0]->isClosed ());
+        CATCH_REQUIRE (created[2]->isClosed ());
+    }
+
+    CATCH_SECTION ("routes by logger name prefix")
+    {
+        RoutingAppenderPtr routing (new RoutingAppender (factory, tstring ()));
+        for (tchar const * logger : {LOG4CPLUS_TEXT ("app.db"),
+                LOG4CPLUS_TEXT ("app.net.tcp"), LOG4CPLUS_TEXT ("lib")})
+            routing->doAppend (spi::InternalLoggingEvent (logger,
+                    INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"), nullptr, 0));
+
+        CATCH_REQUIRE (routing->getRouteCount () == 2);
+        CATCH_REQUIRE (routing->getRoute (LOG4CPLUS_TEXT ("app"))->getName ()
+            == LOG4CPLUS_TEXT ("/app"));
+        CATCH_REQUIRE (created[0]->count == 2);
+        CATCH_REQUIRE (routing->getRoute (LOG4CPLUS_TEXT ("lib")));
+        routing->close ();
+    }
+}
+#endif
+
+} // namespace log4cplus
@@ -0,0 +1,598 @@
+// Module:  Log4cplus
+// File:    runtimecontrol.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/runtimecontrol.h>
+#include <log4cplus/asyncappender.h>
+#include <log4cplus/fileappender.h>
+#include <log4cplus/logger.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/spi/appenderattachable.h>
+#include <log4cplus/internal/internal.h>
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_HAVE_SYS_UN_H) && ! defined (_WIN32)
+#define LOG4CPLUS_CONTROL_ENDPOINT
+#if defined (LOG4CPLUS_HAVE_SYS_TYPES_H)
+#include <sys/types.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_SYS_SOCKET_H)
+#include <sys/socket.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_FCNTL_H)
+#include <fcntl.h>
+#endif
+#include <sys/un.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <thread>
+#endif
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <log4cplus/loggingmacros.h>
+#include <log4cplus/nullappender.h>
+#include <cstdio>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+//! Splits <code>command</code> into words separated by white space.
+std::vector<tstring>
+split_words (tstring_view const & command)
+{
+    std::vector<tstring> words;
+    tstring_view::size_type pos = 0;
+    for (;;)
+    {
+        pos = command.find_first_not_of (LOG4CPLUS_TEXT (" \t\r\n"), pos);
+        if (pos == tstring_view::npos)
+            break;
+
+        tstring_view::size_type const end
+            = command.find_first_of (LOG4CPLUS_TEXT (" \t\r\n"), pos);
+        words.emplace_back (command.substr (pos, end - pos));
+        pos = end;
+    }
+
+    return words;
+}
+
+
+bool
+parse_number (tstring const & str, unsigned long & value)
+{
+    if (str.empty ()
+        || str.find_first_not_of (LOG4CPLUS_TEXT ("0123456789"))
+            != tstring::npos)
+        return false;
+
+    value = std::strtoul (LOG4CPLUS_TSTRING_TO_STRING (str).c_str (),
+        nullptr, 10);
+    return true;
+}
+
+
+tstring
+reply_count (std::size_t count, bool & ok)
+{
+    ok = count != 0;
+    return ok
+        ? LOG4CPLUS_TEXT ("OK ") + helpers::convertIntegerToString (count)
+        : tstring (LOG4CPLUS_TEXT ("ERROR no such appender"));
+}
+
+} // namespace
+
+
+RuntimeControl::RuntimeControl (Hierarchy & hierarchy_)
+    : hierarchy (hierarchy_)
+{ }
+
+
+RuntimeControl::~RuntimeControl () = default;
+
+
+std::size_t
+RuntimeControl::setLogLevel (tstring_view const & prefix, LogLevel ll)
+{
+    if (prefix.empty () || prefix == LOG4CPLUS_TEXT ("root"))
+    {
+        hierarchy.getRoot ().setLogLevel (ll);
+        return 1 + hierarchy.setLogLevels (LOG4CPLUS_TEXT ("*"), ll);
+    }
+
+    // The logger itself is created so that loggers created under it
+    // later inherit the level.
+    hierarchy.getInstance (prefix).setLogLevel (ll);
+    tstring pattern (prefix);
+    pattern += LOG4CPLUS_TEXT (".*");
+    return 1 + hierarchy.setLogLevels (pattern, ll);
+}
+
+
+std::size_t
+RuntimeControl::setAppenderEnabled (tstring const & name, bool enabled)
+{
+    SharedAppenderPtrList const appenders = findAppenders (name);
+
+    std::lock_guard<std::mutex> guard (mtx);
+    for (SharedAppenderPtr const & appender : appenders)
+    {
+        auto it = disabled.find (appender.get ());
+        if (enabled && it != disabled.end ())
+        {
+            appender->setThreshold (it->second.second);
+            disabled.erase (it);
+        }
+        else if (! enabled && it == disabled.end ())
+        {
+            disabled.emplace (appender.get (),
+                std::make_pair (appender, appender->getThreshold ()));
+            appender->setThreshold (OFF_LOG_LEVEL);
+        }
+    }
+
+    return appenders.size ();
+}
+
+
+std::size_t
+RuntimeControl::setQueueLimit (tstring const & name, unsigned len)
+{
+    std::size_t count = 0;
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    for (SharedAppenderPtr const & appender : findAppenders (name))
+        if (auto async = dynamic_cast<AsyncAppender *> (appender.get ()))
+            count += async->setQueueLimit (len);
+#else
+    (void) name;
+    (void) len;
+#endif
+
+    return count;
+}
+
+
+std::size_t
+RuntimeControl::setFlushPolicy (tstring const & name, unsigned long bytes,
+    unsigned long intervalMs)
+{
+    std::size_t count = 0;
+    for (SharedAppenderPtr const & appender : findAppenders (name))
+        if (auto file = dynamic_cast<FileAppenderBase *> (appender.get ()))
+        {
+            file->setFlushPolicy (bytes, intervalMs);
+            ++count;
+        }
+
+    return count;
+}
+
+
+tstring
+RuntimeControl::execute (tstring_view const & command, bool & ok)
+{
+    std::vector<tstring> const words = split_words (command);
+    ok = false;
+    if (words.empty ())
+        return LOG4CPLUS_TEXT ("ERROR empty command");
+
+    tstring const & verb = words[0];
+    unsigned long num1 = 0, num2 = 0;
+    if (verb == LOG4CPLUS_TEXT ("level") && words.size () == 3)
+    {
+        tstring const level = helpers::toUpper (words[2]);
+        LogLevel ll = NOT_SET_LOG_LEVEL;
+        if (level != LOG4CPLUS_TEXT ("INHERITED")
+            && level != LOG4CPLUS_TEXT ("NOTSET"))
+        {
+            ll = getLogLevelManager ().fromString (level);
+            if (ll == NOT_SET_LOG_LEVEL)
+                return LOG4CPLUS_TEXT ("ERROR unknown log level ") + words[2];
+        }
+
+        ok = true;
+        return LOG4CPLUS_TEXT ("OK ")
+            + helpers::convertIntegerToString (setLogLevel (words[1], ll));
+    }
+    else if ((verb == LOG4CPLUS_TEXT ("enable")
+            || verb == LOG4CPLUS_TEXT ("disable"))
+        && words.size () == 2)
+        return reply_count (setAppenderEnabled (words[1],
+                verb == LOG4CPLUS_TEXT ("enable")), ok);
+    else if (verb == LOG4CPLUS_TEXT ("queue") && words.size () == 3
+        && parse_number (words[2], num1) && num1 != 0)
+        return reply_count (setQueueLimit (words[1],
+                static_cast<unsigned> (num1)), ok);
+    else if (verb == LOG4CPLUS_TEXT ("flush") && words.size () == 4
+        && parse_number (words[2], num1) && parse_number (words[3], num2))
+        return reply_count (setFlushPolicy (words[1], num1, num2), ok);
+    else if (verb == LOG4CPLUS_TEXT ("list") && words.size () == 1)
+    {
+        SharedAppenderPtrList const appenders = findAppenders (tstring ());
+        tstring reply = LOG4CPLUS_TEXT ("OK ")
+            + helpers::convertIntegerToString (appenders.size ());
+
+        std::lock_guard<std::mutex> guard (mtx);
+        for (SharedAppenderPtr const & appender : appenders)
+        {
+            reply += LOG4CPLUS_TEXT (' ');
+            reply += appender->getName ();
+            if (disabled.count (appender.get ()))
+                reply += LOG4CPLUS_TEXT (":disabled");
+        }
+
+        ok = true;
+        return reply;
+    }
+
+    return LOG4CPLUS_TEXT ("ERROR invalid command ") + verb;
+}
+
+
+//! \return Appenders named <code>name</code>, or all appenders if
+//! <code>name</code> is empty.
+SharedAppenderPtrList
+RuntimeControl::findAppenders (tstring const & name) const
+{
+    LoggerList loggers = hierarchy.getCurrentLoggers ();
+    loggers.push_back (hierarchy.getRoot ());
+
+    SharedAppenderPtrList result;
+    std::set<Appender const *> visited;
+    SharedAppenderPtrList pending;
+    for (Logger & logger : loggers)
+    {
+        SharedAppenderPtrList const appenders = logger.getAllAppenders ();
+        pending.insert (pending.end (), appenders.begin (), appenders.end ());
+    }
+
+    while (! pending.empty ())
+    {
+        SharedAppenderPtr const appender = std::move (pending.back ());
+        pending.pop_back ();
+        if (! visited.insert (appender.get ()).second)
+            continue;
+
+        if (name.empty () || appender->getName () == name)
+            result.push_back (appender);
+
+        if (auto attachable
+            = dynamic_cast<spi::AppenderAttachable *> (appender.get ()))
+        {
+            SharedAppenderPtrList const nested
+                = attachable->getAllAppenders ();
+            pending.insert (pending.end (), nested.begin (), nested.end ());
+        }
+    }
+
+    return result;
+}
+
+
+RuntimeControl &
+getDefaultRuntimeControl ()
+{
+    // Leaked like the default hierarchy it refers to.
+    static RuntimeControl * const control = new RuntimeControl;
+    return *control;
+}
+
+
+#if defined (LOG4CPLUS_CONTROL_ENDPOINT)
+
+struct ControlEndpoint::Impl
+{
+    RuntimeControl & control;
+    std::string path;
+    int listenFd = -1;
+    //! Written to by the destructor to stop the thread.
+    int stopPipe[2] = {-1, -1};
+    std::thread thread;
+
+    explicit Impl (RuntimeControl & control_)
+        : control (control_)
+    { }
+
+    //! Waits for <code>fd</code> to become readable.
+    //! \return <code>false</code> when the endpoint is being stopped.
+    bool
+    wait (int fd) const
+    {
+        struct pollfd fds[2] = {{fd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+        for (;;)
+        {
+            int const ret = ::poll (fds, 2, -1);
+            if (ret == -1 && errno == EINTR)
+                continue;
+
+            return ret > 0 && fds[1].revents == 0;
+        }
+    }
+
+    void
+    serve (int fd)
+    {
+        std::string input;
+        char buf[1024];
+        for (;;)
+        {
+            std::string::size_type eol;
+            while ((eol = input.find ('\n')) != std::string::npos)
+            {
+                bool ok;
+                std::string reply = LOG4CPLUS_TSTRING_TO_STRING (
+                    control.execute (LOG4CPLUS_STRING_TO_TSTRING (
+                        input.substr (0, eol)), ok));
+                reply += '\n';
+                input.erase (0, eol + 1);
+                if (::send (fd, reply.data (), reply.size (), MSG_NOSIGNAL)
+                    != static_cast<ssize_t> (reply.size ()))
+                    return;
+            }
+
+            // Commands are short, do not let a client fill the memory.
+            if (input.size () > 64 * 1024 || ! wait (fd))
+                return;
+
+            ssize_t const n = ::recv (fd, buf, sizeof (buf), 0);
+            if (n < 0 && errno == EINTR)
+                continue;
+            else if (n <= 0)
+                return;
+
+            input.append (buf, static_cast<std::size_t> (n));
+        }
+    }
+
+    void
+    run ()
+    {
+        while (wait (listenFd))
+        {
+            int const fd = ::accept (listenFd, nullptr, nullptr);
+            if (fd == -1)
+                continue;
+
+            serve (fd);
+            ::close (fd);
+        }
+    }
+};
+
+
+ControlEndpoint::ControlEndpoint (RuntimeControl & control,
+    tstring const & path)
+    : impl (new Impl (control))
+{
+    impl->path = LOG4CPLUS_TSTRING_TO_STRING (path);
+
+    struct sockaddr_un addr = sockaddr_un ();
+    addr.sun_family = AF_UNIX;
+    if (impl->path.size () >= sizeof (addr.sun_path))
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("ControlEndpoint: socket path too long: ")
+            + path);
+        return;
+    }
+    std::memcpy (addr.sun_path, impl->path.c_str (), impl->path.size () + 1);
+
+    int const fd = ::socket (AF_UNIX, SOCK_STREAM, 0);
+    ::unlink (addr.sun_path);
+    if (fd == -1
+        || ::bind (fd, reinterpret_cast<struct sockaddr *> (&addr),
+            sizeof (addr)) == -1
+        || ::listen (fd, 4) == -1
+        || ::pipe (impl->stopPipe) == -1)
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("ControlEndpoint: cannot listen at ") + path);
+        if (fd != -1)
+            ::close (fd);
+        return;
+    }
+
+    ::fcntl (fd, F_SETFD, FD_CLOEXEC);
+    ::fcntl (impl->stopPipe[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl (impl->stopPipe[1], F_SETFD, FD_CLOEXEC);
+    impl->listenFd = fd;
+    impl->thread = std::thread ([this] { impl->run (); });
+}
+
+
+ControlEndpoint::~ControlEndpoint ()
+{
+    if (impl->thread.joinable ())
+    {
+        char const byte = 0;
+        ssize_t const ret = ::write (impl->stopPipe[1], &byte, 1);
+        (void) ret;
+        impl->thread.join ();
+    }
+
+    if (impl->listenFd != -1)
+    {
+        ::close (impl->listenFd);
+        ::unlink (impl->path.c_str ());
+    }
+
+    for (int fd : impl->stopPipe)
+        if (fd != -1)
+            ::close (fd);
+}
+
+
+bool
+ControlEndpoint::isOpen () const
+{
+    return impl->listenFd != -1;
+}
+
+#endif // defined (LOG4CPLUS_CONTROL_ENDPOINT)
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("RuntimeControl", "[control]")
+{
+    Hierarchy h;
+    RuntimeControl control (h);
+    Logger net = h.getInstance (LOG4CPLUS_TEXT ("net"));
+    Logger tcp = h.getInstance (LOG4CPLUS_TEXT ("net.tcp"));
+    Logger network = h.getInstance (LOG4CPLUS_TEXT ("network"));
+    tcp.setLogLevel (ERROR_LOG_LEVEL);
+    h.getRoot ().setLogLevel (INFO_LOG_LEVEL);
+
+    SharedAppenderPtr null (new NullAppender);
+    null->setName (LOG4CPLUS_TEXT ("null"));
+    net.addAppender (null);
+
+    bool ok = false;
+
+    CATCH_SECTION ("log levels of subtree")
+    {
+        CATCH_REQUIRE (! tcp.isEnabledFor (DEBUG_LOG_LEVEL));
+        CATCH_REQUIRE (control.execute (LOG4CPLUS_TEXT ("level net debug"),
+                ok) == LOG4CPLUS_TEXT ("OK 2"));
+        CATCH_REQUIRE (ok);
+        CATCH_REQUIRE (net.isEnabledFor (DEBUG_LOG_LEVEL));
+        CATCH_REQUIRE (tcp.isEnabledFor (DEBUG_LOG_LEVEL));
+        CATCH_REQUIRE (! network.isEnabledFor (DEBUG_LOG_LEVEL));
+
+        // Loggers created later inherit from the prefix.
+        CATCH_REQUIRE (control.setLogLevel (LOG4CPLUS_TEXT ("app.db"),
+                WARN_LOG_LEVEL) == 1);
+        CATCH_REQUIRE (! h.getInstance (LOG4CPLUS_TEXT ("app.db.pool"))
+            .isEnabledFor (INFO_LOG_LEVEL));
+
+        CATCH_REQUIRE (control.execute (
+                LOG4CPLUS_TEXT (" level  net.tcp inherited "), ok)
+            == LOG4CPLUS_TEXT ("OK 1"));
+        CATCH_REQUIRE (tcp.getLogLevel () == NOT_SET_LOG_LEVEL);
+
+        control.execute (LOG4CPLUS_TEXT ("level net loud"), ok);
+        CATCH_REQUIRE (! ok);
+    }
+
+    CATCH_SECTION ("appender enabling")
+    {
+        null->setThreshold (WARN_LOG_LEVEL);
+        CATCH_REQUIRE (control.execute (LOG4CPLUS_TEXT ("disable null"), ok)
+            == LOG4CPLUS_TEXT ("OK 1"));
+        CATCH_REQUIRE (null->getThreshold () == OFF_LOG_LEVEL);
+        CATCH_REQUIRE (control.execute (LOG4CPLUS_TEXT ("list"), ok)
+            == LOG4CPLUS_TEXT ("OK 1 null:disabled"));
+
+        // Repeated disabling keeps the original threshold.
+        control.setAppenderEnabled (LOG4CPLUS_TEXT ("null"), false);
+        CATCH_REQUIRE (control.setAppenderEnabled (LOG4CPLUS_TEXT ("null"),
+                true) == 1);
+        CATCH_REQUIRE (null->getThreshold () == WARN_LOG_LEVEL);
+
+        control.execute (LOG4CPLUS_TEXT ("enable missing"), ok);
+        CATCH_REQUIRE (! ok);
+    }
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    CATCH_SECTION ("queue limit")
+    {
+        AsyncAppender * const async = new AsyncAppender (null, 8);
+        SharedAppenderPtr const async_ptr (async);
+        async->setName (LOG4CPLUS_TEXT ("async"));
+        tcp.addAppender (async_ptr);
+        CATCH_REQUIRE (async->getQueueStats ().capacity == 8);
+
+        CATCH_REQUIRE (control.execute (LOG4CPLUS_TEXT ("queue async 1000"),
+                ok) == LOG4CPLUS_TEXT ("OK 1"));
+        CATCH_REQUIRE (async->getQueueStats ().capacity == 1024);
+        LOG4CPLUS_ERROR (tcp, LOG4CPLUS_TEXT ("after resize"));
+
+        // Nested appenders are found, NullAppender has no queue.
+        CATCH_REQUIRE (control.execute (LOG4CPLUS_TEXT ("list"), ok)
+            .compare (0, 5, LOG4CPLUS_TEXT ("OK 2 ")) == 0);
+        control.execute (LOG4CPLUS_TEXT ("queue null 10"), ok);
+        CATCH_REQUIRE (! ok);
+        control.execute (LOG4CPLUS_TEXT ("queue async 0"), ok);
+        CATCH_REQUIRE (! ok);
+        async->close ();
+    }
+#endif
+
+#if defined (LOG4CPLUS_CONTROL_ENDPOINT)
+    CATCH_SECTION ("unix socket endpoint")
+    {
+        char const path[] = "log4cplus-control-test.sock";
+        ControlEndpoint endpoint (control, LOG4CPLUS_C_STR_TO_TSTRING (path));
+        CATCH_REQUIRE (endpoint.isOpen ());
+
+        int const fd = ::socket (AF_UNIX, SOCK_STREAM, 0);
+        struct sockaddr_un addr = sockaddr_un ();
+        addr.sun_family = AF_UNIX;
+        std::strcpy (addr.sun_path, path);
+        CATCH_REQUIRE (::connect (fd,
+                reinterpret_cast<struct sockaddr *> (&addr),
+                sizeof (addr)) == 0);
+
+        std::string const commands = "level net.tcp TRACE\nbogus\n";
+        CATCH_REQUIRE (::send (fd, commands.data (), commands.size (), 0)
+            == static_cast<ssize_t> (commands.size ()));
+
+        std::string replies;
+        char buf[256];
+        ssize_t n;
+        while (std::count (replies.begin (), replies.end (), '\n') != 2
+            && (n = ::recv (fd, buf, sizeof (buf), 0)) > 0)
+            replies.append (buf, static_cast<std::size_t> (n));
+        ::close (fd);
+
+        CATCH_REQUIRE (replies == "OK 1\nERROR invalid command bogus\n");
+        CATCH_REQUIRE (tcp.getLogLevel () == TRACE_LOG_LEVEL);
+    }
+#endif
+
+    h.shutdown ();
+}
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+} // namespace log4cplus
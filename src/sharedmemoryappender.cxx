@@ -0,0 +1,874 @@
+// Module:  Log4cplus
+// File:    sharedmemoryappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/config.hxx>
+#ifndef LOG4CPLUS_SINGLE_THREADED
+
+#if defined (LOG4CPLUS_HAVE_SYS_TYPES_H)
+#include <sys/types.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_SYS_STAT_H)
+#include <sys/stat.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_FCNTL_H)
+#include <fcntl.h>
+#endif
+#if ! defined (_WIN32)
+#include <sys/mman.h>
+#endif
+#include <log4cplus/config/windowsh-inc.h>
+
+#include <log4cplus/sharedmemoryappender.h>
+#include <log4cplus/socketappender.h>
+#include <log4cplus/spi/factory.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/socketbuffer.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/internal/env.h>
+#include <log4cplus/internal/internal.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+//! Layout of the header at the start of the ring file. Producer and
+//! consumer positions live on separate cache lines.
+struct shm_header
+{
+    char magic[8];
+    std::uint32_t version;
+    //! One of shm_state values.
+    std::uint32_t state;
+    std::uint64_t capacity;
+    //! Events dropped by producers since the drainer last reported.
+    std::uint64_t dropped;
+
+    //! Total number of bytes ever reserved by producers.
+    alignas (64) std::uint64_t head;
+
+    //! Total number of bytes ever consumed by the drainer.
+    alignas (64) std::uint64_t tail;
+};
+
+
+//! Initialization state of the ring. The file starts zeroed.
+enum shm_state : std::uint32_t
+{
+    shm_new = 0,
+    shm_initializing = 1,
+    shm_ready = 2
+};
+
+
+//! Header of each record in the ring. Records are 8 bytes aligned.
+struct record_header
+{
+    //! Size of the serialized event following the header.
+    std::uint32_t size;
+    //! One of record_state values.
+    std::uint32_t state;
+};
+
+
+enum record_state : std::uint32_t
+{
+    //! Reserved, still being copied.
+    record_empty = 0,
+    record_committed = 1,
+    //! Fills the end of the ring that a record did not fit into.
+    record_padding = 2
+};
+
+
+char const shm_magic[8] = {'L', '4', 'C', 'P', 'S', 'H', 'M', 'R'};
+std::uint32_t const shm_version = 1;
+std::size_t const shm_header_size = 192;
+std::size_t const minimum_ring_size = 4 * 1024;
+
+static_assert (sizeof (shm_header) <= shm_header_size);
+static_assert (sizeof (record_header) == 8);
+static_assert (std::atomic_ref<std::uint64_t>::is_always_lock_free
+    && std::atomic_ref<std::uint32_t>::is_always_lock_free,
+    "ring is shared by processes, it needs lock free atomics");
+
+
+std::size_t
+record_total_size (std::size_t size)
+{
+    return (sizeof (record_header) + size + 7) & ~std::size_t (7);
+}
+
+
+std::uint64_t
+now_ms ()
+{
+    return static_cast<std::uint64_t> (
+        std::chrono::duration_cast<std::chrono::milliseconds> (
+            std::chrono::steady_clock::now ().time_since_epoch ()).count ());
+}
+
+
+//! Lock files with a drainer candidate in this process. POSIX record
+//! locks are owned by processes, so the lock file alone cannot tell
+//! instances of one process apart.
+struct drainer_candidates
+{
+    thread::Mutex mutex;
+    std::map<tstring, SharedMemoryAppender const *> candidates;
+};
+
+
+drainer_candidates &
+get_drainer_candidates ()
+{
+    static drainer_candidates dc;
+    return dc;
+}
+
+
+class DrainerThread
+    : public thread::AbstractThread
+{
+public:
+    explicit DrainerThread (SharedMemoryAppenderPtr app)
+        : appender (std::move (app))
+    {
+        setThreadRole (LOG4CPLUS_TEXT ("shmdrain"));
+    }
+
+    void run () override
+    {
+        appender->drainerLoop ();
+    }
+
+private:
+    SharedMemoryAppenderPtr appender;
+};
+
+
+#if defined (_WIN32)
+HANDLE const invalid_handle = INVALID_HANDLE_VALUE;
+#endif
+
+} // namespace
+
+
+SharedMemoryAppender::SharedMemoryAppender (SharedAppenderPtr const & app,
+    tstring const & filename_, std::size_t ringSize_)
+    : filename (filename_)
+    , lockFileName (filename_ + LOG4CPLUS_TEXT (".lock"))
+    , ringSize (ringSize_)
+    , maxEventSize (LOG4CPLUS_MAX_MESSAGE_SIZE)
+    , drainInterval (10)
+    , fullTimeout (1000)
+    , stallTimeout (5000)
+    , createDirs (false)
+{
+    addAppender (app);
+    init ();
+}
+
+
+SharedMemoryAppender::SharedMemoryAppender (
+    helpers::Properties const & props)
+    : Appender (props)
+    , ringSize (1024 * 1024)
+    , maxEventSize (LOG4CPLUS_MAX_MESSAGE_SIZE)
+    , drainInterval (10)
+    , fullTimeout (1000)
+    , stallTimeout (5000)
+    , createDirs (false)
+{
+    filename = props.getProperty (LOG4CPLUS_TEXT ("File"));
+    lockFileName = props.getProperty (LOG4CPLUS_TEXT ("LockFile"),
+        filename + LOG4CPLUS_TEXT (".lock"));
+    props.getBool (createDirs, LOG4CPLUS_TEXT ("CreateDirs"));
+    props.getUInt (drainInterval, LOG4CPLUS_TEXT ("DrainInterval"));
+    props.getUInt (fullTimeout, LOG4CPLUS_TEXT ("FullTimeout"));
+    props.getUInt (stallTimeout, LOG4CPLUS_TEXT ("StallTimeout"));
+
+    unsigned max_event_size = 0;
+    if (props.getUInt (max_event_size, LOG4CPLUS_TEXT ("MaxEventSize"))
+        && max_event_size != 0)
+        maxEventSize = max_event_size;
+
+    tstring tmp (
+        helpers::toUpper (
+            props.getProperty (LOG4CPLUS_TEXT ("RingSize"))));
+    if (! tmp.empty ())
+    {
+        std::size_t size = std::strtoul (
+            LOG4CPLUS_TSTRING_TO_STRING (tmp).c_str (), nullptr, 10);
+        tstring::size_type const len = tmp.length ();
+        if (len > 2
+            && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT ("MB")) == 0)
+            size *= (1024 * 1024); // convert to megabytes
+        else if (len > 2
+            && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT ("KB")) == 0)
+            size *= 1024; // convert to kilobytes
+        ringSize = size;
+    }
+
+    tstring const & appender_name (
+        props.getProperty (LOG4CPLUS_TEXT ("Appender")));
+    if (appender_name.empty ())
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unspecified appender for SharedMemoryAppender."));
+    else
+    {
+        spi::AppenderFactory * factory
+            = spi::getAppenderFactoryRegistry ().get (appender_name);
+        if (! factory)
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("SharedMemoryAppender::SharedMemoryAppender()")
+                LOG4CPLUS_TEXT (" - Cannot find AppenderFactory: ")
+                + appender_name, true);
+
+        addAppender (factory->createObject (props.getPropertySubset (
+            LOG4CPLUS_TEXT ("Appender."))));
+    }
+
+    init ();
+}
+
+
+SharedMemoryAppender::~SharedMemoryAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+SharedMemoryAppender::init ()
+{
+    mapping = nullptr;
+    mappingSize = 0;
+#if defined (_WIN32)
+    handle = invalid_handle;
+    mappingHandle = nullptr;
+#else
+    fd = -1;
+#endif
+    drainer = false;
+    creatorProcess = static_cast<std::uint64_t> (internal::get_process_id ());
+    stallPosition = 0;
+    stallStart = 0;
+
+    if (ringSize < minimum_ring_size)
+    {
+        tostringstream oss;
+        oss << LOG4CPLUS_TEXT ("SharedMemoryAppender: RingSize property")
+            LOG4CPLUS_TEXT (" value is too small. Resetting to ")
+            << minimum_ring_size << ".";
+        helpers::getLogLog ().warn (oss.str ());
+        ringSize = minimum_ring_size;
+    }
+    ringSize &= ~std::size_t (7);
+
+    open ();
+    if (! mapping)
+        return;
+
+    drainerThread = new DrainerThread (SharedMemoryAppenderPtr (this));
+    drainerThread->start ();
+}
+
+
+void
+SharedMemoryAppender::open ()
+{
+    if (createDirs)
+        internal::make_dirs (filename);
+
+    std::size_t const size = shm_header_size + ringSize;
+    bool existing = false;
+
+#if defined (_WIN32)
+    handle = CreateFile (filename.c_str (), GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_DELETE | FILE_SHARE_WRITE | FILE_SHARE_READ, nullptr,
+        OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == invalid_handle)
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to open file: ") + filename);
+        return;
+    }
+
+    LARGE_INTEGER file_size;
+    existing = GetFileSizeEx (handle, &file_size) && file_size.QuadPart != 0;
+    if (existing && static_cast<std::uint64_t> (file_size.QuadPart) != size)
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Ring file has different size: ") + filename);
+        return;
+    }
+
+    ULARGE_INTEGER mapping_size;
+    mapping_size.QuadPart = size;
+    mappingHandle = CreateFileMapping (handle, nullptr, PAGE_READWRITE,
+        mapping_size.HighPart, mapping_size.LowPart, nullptr);
+    if (mappingHandle)
+        mapping = static_cast<char *> (
+            MapViewOfFile (mappingHandle, FILE_MAP_WRITE, 0, 0, 0));
+
+#else
+    int flags = O_RDWR | O_CREAT
+#if defined (O_CLOEXEC)
+        | O_CLOEXEC
+#endif
+        ;
+    mode_t const mode = (S_IRWXU ^ S_IXUSR)
+        | (S_IRWXG ^ S_IXGRP)
+        | (S_IRWXO ^ S_IXOTH);
+
+    fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (filename).c_str (), flags,
+        mode);
+    if (fd == -1)
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to open file: ") + filename);
+        return;
+    }
+
+    struct stat st;
+    existing = ::fstat (fd, &st) == 0 && st.st_size != 0;
+    if (existing && static_cast<std::uint64_t> (st.st_size) != size)
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Ring file has different size: ") + filename);
+        return;
+    }
+
+    // Concurrent processes may all extend the new file; that is
+    // harmless, the size is the same.
+    if (existing || ::ftruncate (fd, static_cast<off_t> (size)) == 0)
+    {
+        void * ptr = ::mmap (nullptr, size, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+        if (ptr != MAP_FAILED)
+            mapping = static_cast<char *> (ptr);
+    }
+
+#endif
+
+    if (! mapping)
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to map file: ") + filename);
+        return;
+    }
+
+    mappingSize = size;
+
+    // The first process to see the zeroed file initializes it, the
+    // others wait for it.
+    auto & hdr = *reinterpret_cast<shm_header *> (mapping);
+    std::atomic_ref<std::uint32_t> state (hdr.state);
+    std::uint32_t expected = shm_new;
+    if (state.compare_exchange_strong (expected, shm_initializing,
+            std::memory_order_acquire))
+    {
+        std::memcpy (hdr.magic, shm_magic, sizeof (shm_magic));
+        hdr.version = shm_version;
+        hdr.capacity = ringSize;
+        state.store (shm_ready, std::memory_order_release);
+        helpers::getLogLog ().debug (
+            LOG4CPLUS_TEXT ("Initialized shared ring file: ") + filename);
+    }
+    else
+    {
+        std::uint64_t const deadline = now_ms () + stallTimeout;
+        while (state.load (std::memory_order_acquire) != shm_ready
+            && now_ms () < deadline)
+            std::this_thread::yield ();
+    }
+
+    if (state.load (std::memory_order_acquire) != shm_ready
+        || std::memcmp (hdr.magic, shm_magic, sizeof (shm_magic)) != 0
+        || hdr.version != shm_version
+        || hdr.capacity != ringSize)
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Not a compatible shared ring file: ")
+            + filename);
+#if defined (_WIN32)
+        UnmapViewOfFile (mapping);
+#else
+        ::munmap (mapping, mappingSize);
+#endif
+        mapping = nullptr;
+    }
+}
+
+
+void
+SharedMemoryAppender::close ()
+{
+    // Forked children share the mapping but not the drainer thread.
+    if (static_cast<std::uint64_t> (internal::get_process_id ())
+        == creatorProcess)
+    {
+        stopDrainer.signal ();
+        if (drainerThread && drainerThread->isRunning ())
+            drainerThread->join ();
+        drainerThread = nullptr;
+        removeAllAppenders ();
+    }
+
+    thread::MutexGuard guard (access_mutex);
+
+#if defined (_WIN32)
+    if (mapping)
+        UnmapViewOfFile (mapping);
+    if (mappingHandle)
+        CloseHandle (mappingHandle);
+    if (handle != invalid_handle)
+        CloseHandle (handle);
+    handle = invalid_handle;
+    mappingHandle = nullptr;
+
+#else
+    if (mapping)
+        ::munmap (mapping, mappingSize);
+    if (fd != -1)
+        ::close (fd);
+    fd = -1;
+
+#endif
+
+    mapping = nullptr;
+    closed = true;
+}
+
+
+unsigned
+SharedMemoryAppender::getRequiredEventFields () const
+{
+    // Events are serialized as SocketAppender does it.
+    return spi::EVENT_FIELD_NDC | spi::EVENT_FIELD_THREAD
+        | spi::EVENT_FIELD_FILE | spi::EVENT_FIELD_FUNCTION;
+}
+
+
+bool
+SharedMemoryAppender::isDrainer () const
+{
+    return drainer.load (std::memory_order_relaxed);
+}
+
+
+bool
+SharedMemoryAppender::tryBecomeDrainer ()
+{
+    drainer_candidates & dc = get_drainer_candidates ();
+    thread::MutexGuard guard (dc.mutex);
+
+    auto it = dc.candidates.find (lockFileName);
+    if (it != dc.candidates.end () && it->second != this)
+        return false;
+
+    try
+    {
+        if (! lockFile)
+        {
+            lockFile = std::make_unique<helpers::LockFile> (lockFileName,
+                createDirs);
+            dc.candidates[lockFileName] = this;
+        }
+
+        if (! lockFile->try_lock ())
+            return false;
+    }
+    catch (std::exception const &)
+    {
+        // Errors have been logged by LockFile.
+        return false;
+    }
+
+    helpers::getLogLog ().debug (
+        LOG4CPLUS_TEXT ("Became drainer of shared ring file: ") + filename);
+    drainer = true;
+    return true;
+}
+
+
+void
+SharedMemoryAppender::resignDrainer ()
+{
+    drainer_candidates & dc = get_drainer_candidates ();
+    thread::MutexGuard guard (dc.mutex);
+
+    if (! lockFile)
+        return;
+
+    try
+    {
+        if (drainer)
+            lockFile->unlock ();
+    }
+    catch (std::exception const &)
+    { }
+
+    drainer = false;
+    lockFile.reset ();
+    dc.candidates.erase (lockFileName);
+}
+
+
+void
+SharedMemoryAppender::drainerLoop ()
+{
+    do
+    {
+        if (drainer || tryBecomeDrainer ())
+            while (drain () != 0)
+                ;
+    }
+    while (! stopDrainer.timed_wait (drainInterval));
+
+    if (drainer)
+        drain ();
+
+    resignDrainer ();
+}
+
+
+std::size_t
+SharedMemoryAppender::drain ()
+{
+    auto & hdr = *reinterpret_cast<shm_header *> (mapping);
+    char * const data = mapping + shm_header_size;
+    std::uint64_t const capacity = ringSize;
+    std::atomic_ref<std::uint64_t> head (hdr.head);
+    std::atomic_ref<std::uint64_t> tail (hdr.tail);
+
+    std::size_t count = 0;
+    std::uint64_t t = tail.load (std::memory_order_relaxed);
+    std::uint64_t h = head.load (std::memory_order_acquire);
+    while (t != h)
+    {
+        std::size_t const pos = static_cast<std::size_t> (t % capacity);
+        auto & rec = *reinterpret_cast<record_header *> (data + pos);
+        std::uint32_t const state = std::atomic_ref<std::uint32_t> (
+            rec.state).load (std::memory_order_acquire);
+        std::uint32_t const size = std::atomic_ref<std::uint32_t> (
+            rec.size).load (std::memory_order_relaxed);
+        std::size_t const total = record_total_size (size);
+        if (total > capacity - pos)
+        {
+            getErrorHandler ()->error (
+                LOG4CPLUS_TEXT ("Corrupted shared ring file: ") + filename);
+            t = h;
+            tail.store (t, std::memory_order_release);
+            break;
+        }
+
+        if (state == record_empty)
+        {
+            // The producer is still copying, or it has died while at it.
+            // Without the size the record cannot be skipped.
+            std::uint64_t const now = now_ms ();
+            if (stallPosition != t || stallStart == 0)
+            {
+                stallPosition = t;
+                stallStart = now;
+                break;
+            }
+            else if (now - stallStart < stallTimeout || size == 0)
+                break;
+
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("Skipping incomplete record in shared ring")
+                LOG4CPLUS_TEXT (" file: ") + filename);
+            recordDroppedEvent ();
+        }
+        else if (state == record_committed)
+        {
+            helpers::SocketBuffer buffer (size);
+            std::memcpy (buffer.getBuffer (), data + pos + sizeof (rec),
+                size);
+            buffer.setSize (size);
+            try
+            {
+                appendLoopOnAppenders (helpers::readFromBuffer (buffer));
+            }
+            catch (std::runtime_error const &)
+            {
+                recordDroppedEvent ();
+            }
+            ++count;
+        }
+
+        stallStart = 0;
+
+        // Producers see zeroed space only after the tail moves past it.
+        std::memset (data + pos, 0, total);
+        t += total;
+        tail.store (t, std::memory_order_release);
+        if (t == h)
+            h = head.load (std::memory_order_acquire);
+    }
+
+    std::atomic_ref<std::uint64_t> dropped (hdr.dropped);
+    if (dropped.load (std::memory_order_relaxed) != 0)
+    {
+        std::uint64_t const n = dropped.exchange (0,
+            std::memory_order_relaxed);
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("SharedMemoryAppender [") + name
+            + LOG4CPLUS_TEXT ("]: ") + helpers::convertIntegerToString (n)
+            + LOG4CPLUS_TEXT (" events dropped by producers"));
+    }
+
+    return count;
+}
+
+
+// This method does not need to be locked since it is called by
+// doAppend() which performs the locking
+void
+SharedMemoryAppender::append (spi::InternalLoggingEvent const & event)
+{
+    if (! mapping)
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("file is not mapped: ") + filename);
+        return;
+    }
+
+    helpers::SocketBuffer buffer (maxEventSize);
+    try
+    {
+        helpers::convertToBuffer (buffer, event, tstring ());
+    }
+    catch (std::runtime_error const &)
+    {
+        recordDroppedEvent ();
+        return;
+    }
+
+    auto & hdr = *reinterpret_cast<shm_header *> (mapping);
+    char * const data = mapping + shm_header_size;
+    std::uint64_t const capacity = ringSize;
+    std::atomic_ref<std::uint64_t> head (hdr.head);
+    std::atomic_ref<std::uint64_t> tail (hdr.tail);
+
+    std::size_t const size = buffer.getSize ();
+    std::size_t const total = record_total_size (size);
+    if (total > capacity)
+    {
+        recordDroppedEvent ();
+        return;
+    }
+
+    // Reserve space for the record, and for padding if it does not fit
+    // before the end of the ring.
+    std::uint64_t h = head.load (std::memory_order_relaxed);
+    std::size_t skip;
+    std::uint64_t deadline = 0;
+    for (;;)
+    {
+        std::uint64_t const t = tail.load (std::memory_order_acquire);
+        std::size_t const pos = static_cast<std::size_t> (h % capacity);
+        skip = pos + total > capacity ? capacity - pos : 0;
+        if (h + skip + total - t <= capacity)
+        {
+            if (head.compare_exchange_weak (h, h + skip + total,
+                    std::memory_order_relaxed))
+                break;
+            continue;
+        }
+
+        std::uint64_t const now = now_ms ();
+        if (deadline == 0)
+            deadline = now + fullTimeout;
+        else if (now >= deadline)
+        {
+            std::atomic_ref<std::uint64_t> (hdr.dropped).fetch_add (1,
+                std::memory_order_relaxed);
+            recordDroppedEvent ();
+            return;
+        }
+
+        std::this_thread::yield ();
+        h = head.load (std::memory_order_relaxed);
+    }
+
+    if (skip != 0)
+    {
+        auto & pad = *reinterpret_cast<record_header *> (
+            data + static_cast<std::size_t> (h % capacity));
+        std::atomic_ref<std::uint32_t> (pad.size).store (
+            static_cast<std::uint32_t> (skip - sizeof (record_header)),
+            std::memory_order_relaxed);
+        std::atomic_ref<std::uint32_t> (pad.state).store (record_padding,
+            std::memory_order_release);
+    }
+
+    std::size_t const pos = static_cast<std::size_t> ((h + skip) % capacity);
+    auto & rec = *reinterpret_cast<record_header *> (data + pos);
+    std::atomic_ref<std::uint32_t> (rec.size).store (
+        static_cast<std::uint32_t> (size), std::memory_order_relaxed);
+    std::memcpy (data + pos + sizeof (rec), buffer.getBuffer (), size);
+
+    // Publish the record only after it has been completely copied.
+    std::atomic_ref<std::uint32_t> (rec.state).store (record_committed,
+        std::memory_order_release);
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("SharedMemoryAppender", "[appender]")
+{
+    struct TestAppender
+        : Appender
+    {
+        ~TestAppender () { destructorImpl (); }
+
+        void close () override { closed = true; }
+
+        std::vector<tstring>
+        get_messages ()
+        {
+            std::lock_guard<std::mutex> guard (mutex);
+            return messages;
+        }
+
+        std::mutex mutex;
+        std::vector<tstring> messages;
+
+    protected:
+        void append (spi::InternalLoggingEvent const & ev) override
+        {
+            std::lock_guard<std::mutex> guard (mutex);
+            messages.push_back (ev.getLoggerName ()
+                + LOG4CPLUS_TEXT (":") + ev.getMessage ());
+        }
+    };
+
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-shm-test.ring"));
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (file_name).c_str ());
+
+    helpers::SharedObjectPtr<TestAppender> sink1 (new TestAppender);
+    helpers::SharedObjectPtr<TestAppender> sink2 (new TestAppender);
+    SharedMemoryAppenderPtr app1 (new SharedMemoryAppender (
+        SharedAppenderPtr (sink1.get ()), file_name, minimum_ring_size));
+    SharedMemoryAppenderPtr app2 (new SharedMemoryAppender (
+        SharedAppenderPtr (sink2.get ()), file_name, minimum_ring_size));
+
+    auto log = [] (SharedMemoryAppender & app, tchar const * logger,
+        std::size_t count)
+    {
+        for (std::size_t i = 0; i != count; ++i)
+            app.doAppend (spi::InternalLoggingEvent (logger,
+                INFO_LOG_LEVEL, helpers::convertIntegerToString (i),
+                __FILE__, __LINE__, nullptr));
+    };
+
+    auto wait_for = [] (TestAppender & sink, std::size_t count)
+    {
+        for (int i = 0; i != 500 && sink.get_messages ().size () < count;
+             ++i)
+            std::this_thread::sleep_for (std::chrono::milliseconds (10));
+        return sink.get_messages ();
+    };
+
+    // Wait for the election.
+    for (int i = 0; i != 500 && ! app1->isDrainer () && ! app2->isDrainer ();
+         ++i)
+        std::this_thread::sleep_for (std::chrono::milliseconds (10));
+    CATCH_REQUIRE (app1->isDrainer () != app2->isDrainer ());
+    SharedMemoryAppenderPtr drainer = app1->isDrainer () ? app1 : app2;
+    SharedMemoryAppenderPtr other = app1->isDrainer () ? app2 : app1;
+    helpers::SharedObjectPtr<TestAppender> drainer_sink
+        = app1->isDrainer () ? sink1 : sink2;
+    helpers::SharedObjectPtr<TestAppender> other_sink
+        = app1->isDrainer () ? sink2 : sink1;
+
+    // More than the ring holds at once, so that it wraps and fills up.
+    std::size_t const count = 300;
+    std::thread producer ([&] { log (*other, LOG4CPLUS_TEXT ("b"), count); });
+    log (*drainer, LOG4CPLUS_TEXT ("a"), count);
+    producer.join ();
+
+    std::vector<tstring> messages = wait_for (*drainer_sink, 2 * count);
+    CATCH_REQUIRE (messages.size () == 2 * count);
+    CATCH_REQUIRE (other_sink->get_messages ().empty ());
+
+    // Events of each producer arrive in order.
+    std::size_t next_a = 0;
+    std::size_t next_b = 0;
+    for (tstring const & msg : messages)
+    {
+        std::size_t & next = msg[0] == LOG4CPLUS_TEXT ('a') ? next_a : next_b;
+        CATCH_REQUIRE (msg.substr (2) == helpers::convertIntegerToString (
+            next++));
+    }
+
+    // The other instance takes over when the drainer is closed.
+    drainer->close ();
+    log (*other, LOG4CPLUS_TEXT ("c"), 3);
+    messages = wait_for (*other_sink, 3);
+    CATCH_REQUIRE (other->isDrainer ());
+    CATCH_REQUIRE (messages.size () == 3);
+    CATCH_REQUIRE (messages[2] == LOG4CPLUS_TEXT ("c:2"));
+
+    other->close ();
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (file_name).c_str ());
+    tstring const lock_file_name (file_name + LOG4CPLUS_TEXT (".lock"));
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (lock_file_name).c_str ());
+}
+
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_SINGLE_THREADED
@@ -0,0 +1,817 @@
+// Module:  Log4cplus
+// File:    shmtransportappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/config.hxx>
+#if defined (LOG4CPLUS_HAVE_SYS_UN_H) && defined (__linux__)
+
+#if defined (LOG4CPLUS_HAVE_SYS_TYPES_H)
+#include <sys/types.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_SYS_SOCKET_H)
+#include <sys/socket.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_FCNTL_H)
+#include <fcntl.h>
+#endif
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include <log4cplus/shmtransportappender.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <poll.h>
+#include <cstdio>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+char const default_socket[] = "/tmp/log4cplus-shm.sock";
+
+std::uint32_t const ring_magic = 0x4c345348; // "L4SH"
+std::uint32_t const ring_version = 1;
+
+std::size_t const minimum_ring_size = 4 * 1024;
+
+//! Length prefix of the record that makes the reader continue at the
+//! start of the ring.
+std::uint32_t const wrap_marker = 0xFFFFFFFF;
+
+
+//! Start of the mapping shared by ShmTransportAppender and
+//! ShmTransportReceiver. Ring data follow it. Positions are byte counts
+//! since the ring was created; the appender advances head, the receiver
+//! advances tail.
+struct ring_header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t size;
+    alignas (64) std::atomic<std::uint64_t> head;
+    alignas (64) std::atomic<std::uint64_t> tail;
+};
+
+static_assert (std::atomic<std::uint64_t>::is_always_lock_free,
+    "ring positions are shared between processes");
+
+
+//! Registration sent by the appender along with the memfd and the
+//! eventfd. Ident follows it.
+struct registration
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+};
+
+
+std::uint32_t
+read_be32 (char const * p)
+{
+    unsigned char const * const u = reinterpret_cast<unsigned char const *> (p);
+    return (std::uint32_t (u[0]) << 24) | (std::uint32_t (u[1]) << 16)
+        | (std::uint32_t (u[2]) << 8) | std::uint32_t (u[3]);
+}
+
+
+//! \return Position at which record of <code>size</code> bytes is
+//! stored when written at <code>pos</code>; records do not wrap.
+std::uint64_t
+place_record (std::uint64_t pos, std::size_t size, std::size_t ringSize)
+{
+    std::size_t const left = ringSize - static_cast<std::size_t> (
+        pos % ringSize);
+    return left < size ? pos + left : pos;
+}
+
+
+bool
+make_unix_address (struct sockaddr_un & addr, tstring const & path)
+{
+    std::string const p = LOG4CPLUS_TSTRING_TO_STRING (path);
+    addr = sockaddr_un ();
+    addr.sun_family = AF_UNIX;
+    if (p.size () >= sizeof (addr.sun_path))
+        return false;
+
+    std::memcpy (addr.sun_path, p.c_str (), p.size () + 1);
+    return true;
+}
+
+
+void
+set_receive_timeout (int fd, long ms)
+{
+    struct timeval tv;
+    tv.tv_sec = ms / 1000;
+    tv.tv_usec = ms % 1000 * 1000;
+    ::setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof (tv));
+}
+
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ShmTransportAppender ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+ShmTransportAppender::ShmTransportAppender (tstring const & socketPath_,
+    std::size_t ringSize_)
+    : socketPath (socketPath_)
+    , ringSize (ringSize_)
+    , fullTimeout (1000)
+    , connection (-1)
+    , wakeupFd (-1)
+    , mapping (nullptr)
+    , mappingSize (0)
+    , resendDictionary (false)
+{
+    init ();
+}
+
+
+ShmTransportAppender::ShmTransportAppender (
+    helpers::Properties const & props)
+    : Appender (props)
+    , socketPath (LOG4CPLUS_C_STR_TO_TSTRING (default_socket))
+    , ringSize (1024 * 1024)
+    , fullTimeout (1000)
+    , connection (-1)
+    , wakeupFd (-1)
+    , mapping (nullptr)
+    , mappingSize (0)
+    , resendDictionary (false)
+{
+    props.getString (socketPath, LOG4CPLUS_TEXT ("Socket"));
+    props.getString (serverName, LOG4CPLUS_TEXT ("ServerName"));
+    props.getUInt (fullTimeout, LOG4CPLUS_TEXT ("FullTimeout"));
+
+    tstring tmp (
+        helpers::toUpper (
+            props.getProperty (LOG4CPLUS_TEXT ("RingSize"))));
+    if (! tmp.empty ())
+    {
+        std::size_t size = std::strtoul (
+            LOG4CPLUS_TSTRING_TO_STRING (tmp).c_str (), nullptr, 10);
+        tstring::size_type const len = tmp.length ();
+        if (len > 2
+            && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT ("MB")) == 0)
+            size *= (1024 * 1024); // convert to megabytes
+        else if (len > 2
+            && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT ("KB")) == 0)
+            size *= 1024; // convert to kilobytes
+        ringSize = size;
+    }
+
+    init ();
+}
+
+
+ShmTransportAppender::~ShmTransportAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+ShmTransportAppender::init ()
+{
+    if (ringSize < minimum_ring_size)
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("ShmTransportAppender: RingSize property")
+            LOG4CPLUS_TEXT (" value is too small. Resetting to ")
+            + helpers::convertIntegerToString (minimum_ring_size));
+        ringSize = minimum_ring_size;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ShmTransportAppender public methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+ShmTransportAppender::close ()
+{
+    thread::MutexGuard guard (access_mutex);
+    disconnect ();
+    closed = true;
+}
+
+
+unsigned
+ShmTransportAppender::getRequiredEventFields () const
+{
+    return spi::EVENT_FIELDS_ALL;
+}
+
+
+bool
+ShmTransportAppender::isConnected () const
+{
+    thread::MutexGuard guard (access_mutex);
+    return connection != -1;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ShmTransportAppender protected methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+ShmTransportAppender::append (spi::InternalLoggingEvent const & event)
+{
+    if (connection == -1 && ! connect ())
+    {
+        recordDroppedEvent ();
+        return;
+    }
+
+    frames.clear ();
+    if (resendDictionary)
+        encoder.encodeDictionary (frames);
+    std::size_t const eventStart = frames.size ();
+    encoder.encode (frames, event, serverName, true);
+
+    if (frames.size () - eventStart > ringSize / 2)
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("ShmTransportAppender: event too large"));
+        resendDictionary = true;
+        recordDroppedEvent ();
+        return;
+    }
+
+    auto const deadline = std::chrono::steady_clock::now ()
+        + std::chrono::milliseconds (fullTimeout);
+    while (! writeFrames (frames))
+    {
+        // Check that the server still reads the ring before waiting.
+        char byte;
+        ssize_t const ret = ::recv (connection, &byte, 1,
+            MSG_PEEK | MSG_DONTWAIT);
+        bool const alive = ret == -1
+            && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+        if (! alive || std::chrono::steady_clock::now () >= deadline)
+        {
+            if (! alive)
+            {
+                helpers::getLogLog ().error (
+                    LOG4CPLUS_TEXT ("ShmTransportAppender: server")
+                    LOG4CPLUS_TEXT (" closed connection"));
+                disconnect ();
+            }
+
+            resendDictionary = true;
+            recordDroppedEvent ();
+            return;
+        }
+
+        std::this_thread::sleep_for (std::chrono::milliseconds (1));
+    }
+
+    resendDictionary = false;
+}
+
+
+bool
+ShmTransportAppender::connect ()
+{
+    auto const now = std::chrono::steady_clock::now ();
+    if (now < nextConnect)
+        return false;
+
+    // Do not hammer missing server, events are dropped meanwhile.
+    nextConnect = now + std::chrono::seconds (1);
+
+    struct sockaddr_un addr;
+    if (! make_unix_address (addr, socketPath))
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("ShmTransportAppender: socket path too long: ")
+            + socketPath);
+        return false;
+    }
+
+    mappingSize = sizeof (ring_header) + ringSize;
+    int const mfd = ::memfd_create ("log4cplus-shm-transport", MFD_CLOEXEC);
+    if (mfd == -1 || ::ftruncate (mfd, static_cast<off_t> (mappingSize)) == -1)
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("ShmTransportAppender: cannot create ring: ")
+            + helpers::convertIntegerToString (errno));
+        if (mfd != -1)
+            ::close (mfd);
+        return false;
+    }
+
+    void * const addrMapped = ::mmap (nullptr, mappingSize,
+        PROT_READ | PROT_WRITE, MAP_SHARED, mfd, 0);
+    wakeupFd = ::eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+    connection = ::socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    bool ok = addrMapped != MAP_FAILED && wakeupFd != -1 && connection != -1;
+    if (addrMapped != MAP_FAILED)
+        mapping = static_cast<char *> (addrMapped);
+
+    if (ok)
+    {
+        ring_header * const header = new (mapping) ring_header;
+        header->magic = ring_magic;
+        header->version = ring_version;
+        header->size = ringSize;
+        header->head.store (0, std::memory_order_relaxed);
+        header->tail.store (0, std::memory_order_relaxed);
+
+        ok = ::connect (connection,
+            reinterpret_cast<struct sockaddr *> (&addr), sizeof (addr)) == 0;
+    }
+
+    if (ok)
+    {
+        std::string message (sizeof (registration), '\0');
+        registration const reg {ring_magic, ring_version};
+        std::memcpy (&message[0], &reg, sizeof (reg));
+        message += LOG4CPLUS_TSTRING_TO_STRING (serverName.empty ()
+            ? LOG4CPLUS_TEXT ("pid ")
+                + helpers::convertIntegerToString (::getpid ())
+            : serverName);
+
+        struct iovec iov;
+        iov.iov_base = &message[0];
+        iov.iov_len = message.size ();
+
+        union
+        {
+            struct cmsghdr header;
+            char buf[CMSG_SPACE (2 * sizeof (int))];
+        } control;
+        std::memset (&control, 0, sizeof (control));
+
+        struct msghdr msg = msghdr ();
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = &control;
+        msg.msg_controllen = sizeof (control);
+
+        struct cmsghdr * cmsg = CMSG_FIRSTHDR (&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN (2 * sizeof (int));
+        int const fds[2] = {mfd, wakeupFd};
+        std::memcpy (CMSG_DATA (cmsg), fds, sizeof (fds));
+
+        // The server confirms registration by single byte.
+        char ack = 0;
+        set_receive_timeout (connection, 5000);
+        ok = ::sendmsg (connection, &msg, MSG_NOSIGNAL)
+                == static_cast<ssize_t> (message.size ())
+            && ::recv (connection, &ack, 1, 0) == 1;
+    }
+
+    ::close (mfd);
+    if (! ok)
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("ShmTransportAppender: cannot register with ")
+            + socketPath);
+        disconnect ();
+        return false;
+    }
+
+    // Dictionary is per ring.
+    encoder.reset ();
+    resendDictionary = false;
+    return true;
+}
+
+
+void
+ShmTransportAppender::disconnect ()
+{
+    if (connection != -1)
+        ::close (connection);
+    if (wakeupFd != -1)
+        ::close (wakeupFd);
+    if (mapping)
+        ::munmap (mapping, mappingSize);
+
+    connection = -1;
+    wakeupFd = -1;
+    mapping = nullptr;
+}
+
+
+bool
+ShmTransportAppender::writeFrames (std::string const & frames_)
+{
+    ring_header & header = *reinterpret_cast<ring_header *> (mapping);
+    char * const data = mapping + sizeof (ring_header);
+
+    // Only this appender moves head.
+    std::uint64_t const oldHead = header.head.load (std::memory_order_relaxed);
+    std::uint64_t const tail = header.tail.load (std::memory_order_acquire);
+
+    std::uint64_t end = oldHead;
+    for (std::size_t i = 0; i != frames_.size (); )
+    {
+        std::size_t const size = 4 + read_be32 (frames_.data () + i);
+        end = place_record (end, size, ringSize) + size;
+        i += size;
+    }
+    if (end - tail > ringSize)
+        return false;
+
+    std::uint64_t pos = oldHead;
+    for (std::size_t i = 0; i != frames_.size (); )
+    {
+        std::size_t const size = 4 + read_be32 (frames_.data () + i);
+        std::uint64_t const placed = place_record (pos, size, ringSize);
+        std::size_t const offset = static_cast<std::size_t> (pos % ringSize);
+        if (placed != pos && ringSize - offset >= 4)
+            std::memcpy (data + offset, "\xFF\xFF\xFF\xFF", 4);
+
+        std::memcpy (data + placed % ringSize, frames_.data () + i, size);
+        pos = placed + size;
+        i += size;
+    }
+
+    header.head.store (end, std::memory_order_release);
+
+    // Pairs with the fence in ShmTransportReceiver::receive(): either
+    // the receiver sees the new head before it sleeps, or this sees
+    // the tail it has left empty ring at.
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+    if (header.tail.load (std::memory_order_relaxed) == oldHead)
+    {
+        std::uint64_t const one = 1;
+        ssize_t const ret = ::write (wakeupFd, &one, sizeof (one));
+        (void) ret;
+    }
+
+    return true;
+}
+
+
+namespace helpers
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// ShmTransportReceiver
+///////////////////////////////////////////////////////////////////////////////
+
+ShmTransportReceiver::ShmTransportReceiver (int connection_)
+    : connection (connection_)
+    , wakeupFd (-1)
+    , mapping (nullptr)
+    , mappingSize (0)
+    , ringSize (0)
+{
+    char buf[256];
+    struct iovec iov;
+    iov.iov_base = buf;
+    iov.iov_len = sizeof (buf);
+
+    union
+    {
+        struct cmsghdr header;
+        char buf[CMSG_SPACE (2 * sizeof (int))];
+    } control;
+
+    struct msghdr msg = msghdr ();
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = &control;
+    msg.msg_controllen = sizeof (control);
+
+    set_receive_timeout (connection, 5000);
+    ssize_t const len = ::recvmsg (connection, &msg, MSG_CMSG_CLOEXEC);
+    struct cmsghdr * const cmsg = len > 0 ? CMSG_FIRSTHDR (&msg) : nullptr;
+    if (! cmsg || cmsg->cmsg_level != SOL_SOCKET
+        || cmsg->cmsg_type != SCM_RIGHTS
+        || cmsg->cmsg_len != CMSG_LEN (2 * sizeof (int)))
+    {
+        getLogLog ().error (
+            LOG4CPLUS_TEXT ("ShmTransportReceiver: invalid registration"));
+        return;
+    }
+
+    int fds[2];
+    std::memcpy (fds, CMSG_DATA (cmsg), sizeof (fds));
+    wakeupFd = fds[1];
+
+    registration reg;
+    struct stat st;
+    bool ok = static_cast<std::size_t> (len) >= sizeof (reg)
+        && ::fstat (fds[0], &st) == 0
+        && static_cast<std::size_t> (st.st_size) > sizeof (ring_header);
+    if (ok)
+    {
+        std::memcpy (&reg, buf, sizeof (reg));
+        ident.assign (buf + sizeof (reg), static_cast<std::size_t> (len)
+            - sizeof (reg));
+        mappingSize = static_cast<std::size_t> (st.st_size);
+        void * const addr = ::mmap (nullptr, mappingSize,
+            PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+        if (addr != MAP_FAILED)
+            mapping = static_cast<char *> (addr);
+    }
+    ::close (fds[0]);
+
+    // The size is taken from the memfd, not trusted from the header.
+    ring_header const * const header
+        = reinterpret_cast<ring_header const *> (mapping);
+    ok = ok && mapping && reg.magic == ring_magic
+        && reg.version == ring_version && header->magic == ring_magic
+        && header->size == mappingSize - sizeof (ring_header);
+    char const ack = 1;
+    if (! ok || ::send (connection, &ack, 1, MSG_NOSIGNAL) != 1)
+    {
+        getLogLog ().error (
+            LOG4CPLUS_TEXT ("ShmTransportReceiver: invalid registration"));
+        if (mapping)
+            ::munmap (mapping, mappingSize);
+        mapping = nullptr;
+        return;
+    }
+
+    ringSize = mappingSize - sizeof (ring_header);
+}
+
+
+ShmTransportReceiver::~ShmTransportReceiver ()
+{
+    if (mapping)
+        ::munmap (mapping, mappingSize);
+    if (wakeupFd != -1)
+        ::close (wakeupFd);
+    ::close (connection);
+}
+
+
+bool
+ShmTransportReceiver::isOpen () const
+{
+    return mapping != nullptr;
+}
+
+
+int
+ShmTransportReceiver::getConnection () const
+{
+    return connection;
+}
+
+
+int
+ShmTransportReceiver::getWakeupFd () const
+{
+    return wakeupFd;
+}
+
+
+std::string const &
+ShmTransportReceiver::getIdent () const
+{
+    return ident;
+}
+
+
+bool
+ShmTransportReceiver::receive (std::vector<spi::InternalLoggingEvent> & events)
+{
+    if (! mapping)
+        return false;
+
+    std::uint64_t counter;
+    ssize_t const ret = ::read (wakeupFd, &counter, sizeof (counter));
+    (void) ret;
+
+    ring_header & header = *reinterpret_cast<ring_header *> (mapping);
+    char const * const data = mapping + sizeof (ring_header);
+    std::uint64_t tail = header.tail.load (std::memory_order_relaxed);
+    for (;;)
+    {
+        std::uint64_t const head = header.head.load (std::memory_order_acquire);
+        if (head - tail > ringSize)
+            break;
+
+        while (tail != head)
+        {
+            std::size_t const offset = static_cast<std::size_t> (
+                tail % ringSize);
+            std::size_t const left = ringSize - offset;
+            std::uint32_t const length = left < 4 ? wrap_marker
+                : read_be32 (data + offset);
+            if (length == wrap_marker)
+            {
+                tail += left;
+                continue;
+            }
+
+            if (length > left - 4 || length > head - tail - 4)
+            {
+                tail = head + ringSize + 1;
+                break;
+            }
+
+            events.emplace_back ();
+            if (! decoder.decode (data + offset + 4, length, events.back ()))
+                events.pop_back ();
+            tail += 4 + length;
+        }
+        if (tail != head)
+            break;
+
+        header.tail.store (tail, std::memory_order_release);
+
+        // See ShmTransportAppender::writeFrames().
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+        if (header.head.load (std::memory_order_relaxed) == tail)
+            return true;
+    }
+
+    getLogLog ().error (
+        LOG4CPLUS_TEXT ("ShmTransportReceiver: corrupted ring of ")
+        + LOG4CPLUS_STRING_TO_TSTRING (ident));
+    ::munmap (mapping, mappingSize);
+    mapping = nullptr;
+    return false;
+}
+
+
+int
+openShmTransportListener (tstring const & path)
+{
+    struct sockaddr_un addr;
+    if (! make_unix_address (addr, path))
+        return -1;
+
+    int const fd = ::socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC
+        | SOCK_NONBLOCK, 0);
+    if (fd == -1)
+        return -1;
+
+    ::unlink (addr.sun_path);
+    if (::bind (fd, reinterpret_cast<struct sockaddr *> (&addr),
+            sizeof (addr)) == -1
+        || ::listen (fd, SOMAXCONN) == -1)
+    {
+        ::close (fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+} // namespace helpers
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("ShmTransportAppender", "[appender]")
+{
+    char const path[] = "log4cplus-shm-test.sock";
+    int const listener = helpers::openShmTransportListener (
+        LOG4CPLUS_C_STR_TO_TSTRING (path));
+    CATCH_REQUIRE (listener != -1);
+
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("Socket"),
+        LOG4CPLUS_C_STR_TO_TSTRING (path));
+    props.setProperty (LOG4CPLUS_TEXT ("RingSize"), LOG4CPLUS_TEXT ("4KB"));
+    props.setProperty (LOG4CPLUS_TEXT ("FullTimeout"), LOG4CPLUS_TEXT ("0"));
+    props.setProperty (LOG4CPLUS_TEXT ("ServerName"),
+        LOG4CPLUS_TEXT ("client"));
+    ShmTransportAppender appender (props);
+
+    auto const make_event = [] (tstring const & msg) {
+        return spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("shm.test"),
+            INFO_LOG_LEVEL, msg, __FILE__, __LINE__, nullptr); };
+
+    // Registration waits for the server's confirmation.
+    std::unique_ptr<helpers::ShmTransportReceiver> receiver;
+    std::thread server ([&] {
+        struct pollfd pfd = {listener, POLLIN, 0};
+        if (::poll (&pfd, 1, 5000) == 1)
+            receiver.reset (new helpers::ShmTransportReceiver (
+                ::accept4 (listener, nullptr, nullptr, SOCK_CLOEXEC)));
+    });
+    appender.doAppend (make_event (LOG4CPLUS_TEXT ("first")));
+    server.join ();
+    CATCH_REQUIRE (receiver);
+    CATCH_REQUIRE (receiver->isOpen ());
+    CATCH_REQUIRE (appender.isConnected ());
+    CATCH_REQUIRE (receiver->getIdent () == "client");
+
+    // Only the first event into empty ring wakes the server.
+    appender.doAppend (make_event (LOG4CPLUS_TEXT ("second")));
+    std::uint64_t counter = 0;
+    CATCH_REQUIRE (::read (receiver->getWakeupFd (), &counter,
+        sizeof (counter)) == sizeof (counter));
+    CATCH_REQUIRE (counter == 1);
+
+    std::vector<spi::InternalLoggingEvent> events;
+    CATCH_REQUIRE (receiver->receive (events));
+    CATCH_REQUIRE (events.size () == 2);
+    CATCH_REQUIRE (events[0].getMessage () == LOG4CPLUS_TEXT ("first"));
+    CATCH_REQUIRE (events[1].getMessage () == LOG4CPLUS_TEXT ("second"));
+    CATCH_REQUIRE (events[1].getLoggerName () == LOG4CPLUS_TEXT ("shm.test"));
+    CATCH_REQUIRE (events[1].getNDC () == LOG4CPLUS_TEXT ("client"));
+
+    CATCH_SECTION ("records wrap around the ring")
+    {
+        for (int round = 0; round != 50; ++round)
+        {
+            events.clear ();
+            for (int i = 0; i != 7; ++i)
+                appender.doAppend (make_event (tstring (100 + round,
+                    static_cast<tchar> (LOG4CPLUS_TEXT ('a') + i))));
+            CATCH_REQUIRE (receiver->receive (events));
+            CATCH_REQUIRE (events.size () == 7);
+            CATCH_REQUIRE (events[6].getMessage ()
+                == tstring (100 + round, LOG4CPLUS_TEXT ('g')));
+        }
+    }
+
+    CATCH_SECTION ("full ring drops events and keeps dictionary")
+    {
+        int i = 0;
+        for (; i != 100; ++i)
+            appender.doAppend (make_event (tstring (200, LOG4CPLUS_TEXT ('x'))));
+
+        // A new logger name defined by a dropped event.
+        appender.doAppend (spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("new"),
+            INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("dropped"), __FILE__, __LINE__,
+            nullptr));
+        events.clear ();
+        CATCH_REQUIRE (receiver->receive (events));
+        CATCH_REQUIRE (events.size () < 100);
+        CATCH_REQUIRE (events.size () > 10);
+
+        appender.doAppend (spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("new"),
+            INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("kept"), __FILE__, __LINE__,
+            nullptr));
+        events.clear ();
+        CATCH_REQUIRE (receiver->receive (events));
+        CATCH_REQUIRE (events.size () == 1);
+        CATCH_REQUIRE (events[0].getLoggerName () == LOG4CPLUS_TEXT ("new"));
+        CATCH_REQUIRE (events[0].getMessage () == LOG4CPLUS_TEXT ("kept"));
+    }
+
+    appender.close ();
+    ::close (listener);
+    std::remove (path);
+}
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_HAVE_SYS_UN_H && __linux__
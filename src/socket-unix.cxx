@@ -22,6 +22,8 @@
 #include <log4cplus/config.hxx>
 #if defined (LOG4CPLUS_USE_BSD_SOCKETS)
 
+#include <climits>
+#include <cstddef>
 #include <cstring>
 #include <vector>
 #include <algorithm>
@@ -60,6 +62,10 @@
 #include <netdb.h>
 #endif
 
+#if defined (LOG4CPLUS_HAVE_SYS_UN_H)
+#include <sys/un.h>
+#endif
+
 #ifdef LOG4CPLUS_HAVE_FCNTL_H
 #include <fcntl.h>
 #endif
@@ -72,6 +78,14 @@
 #include <poll.h>
 #endif
 
+#ifdef LOG4CPLUS_HAVE_SYS_IOCTL_H
+#include <sys/ioctl.h>
+#endif
+
+#ifdef LOG4CPLUS_HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
 
 namespace log4cplus::helpers {
 
@@ -113,6 +127,34 @@ get_host_by_name (char const * hostname, std::string * name,
 }
 
 
+#if defined (LOG4CPLUS_HAVE_SYS_UN_H)
+//! Fills <code>addr</code> with local socket <code>path</code>. On
+//! Linux, path starting with '@' names socket in abstract namespace.
+//! \return Length of the address, or 0 when the path does not fit.
+static
+socklen_t
+make_unix_address (struct sockaddr_un & addr, std::string const & path)
+{
+    addr = sockaddr_un ();
+    addr.sun_family = AF_UNIX;
+    if (path.empty () || path.size () >= sizeof (addr.sun_path))
+        return 0;
+
+    std::memcpy (addr.sun_path, path.c_str (), path.size () + 1);
+#if defined (__linux__)
+    if (path[0] == '@')
+    {
+        addr.sun_path[0] = '\0';
+        return static_cast<socklen_t>(
+            offsetof (struct sockaddr_un, sun_path) + path.size ());
+    }
+#endif
+
+    return sizeof (addr);
+}
+#endif
+
+
 } // namespace
 
 
@@ -133,6 +175,10 @@ SOCKET_TYPE
 openSocket(tstring const & host, unsigned short port, bool udp, bool ipv6,
     SocketState& state)
 {
+    tstring path;
+    if (parseUnixSocketHost (host, path))
+        return openUnixSocket (path, udp, state);
+
     struct addrinfo addr_info_hints = addrinfo();
     struct addrinfo * ai = nullptr;
     std::unique_ptr<struct addrinfo, addrinfo_deleter> addr_info;
@@ -182,7 +228,7 @@ openSocket(tstring const & host, unsigned short port, bool udp, bool ipv6,
     if (retval < 0)
         return INVALID_SOCKET_VALUE;
 
-    if (::listen(sock_holder.sock, 10))
+    if (! udp && ::listen(sock_holder.sock, 10))
         return INVALID_SOCKET_VALUE;
 
     state = ok;
@@ -190,40 +236,131 @@ openSocket(tstring const & host, unsigned short port, bool udp, bool ipv6,
 }
 
 
-SOCKET_TYPE
-connectSocket(const tstring& hostn, unsigned short port, bool udp, bool ipv6,
-    SocketState& state)
+namespace
+{
+
+//! Resolves <code>hostn</code> through getaddrinfo().
+std::shared_ptr<resolved_addresses const>
+resolve_address (tstring const & hostn, unsigned short port, bool udp,
+    bool ipv6)
 {
-    int retval;
     struct addrinfo addr_info_hints = addrinfo();
     struct addrinfo * ai = nullptr;
-    std::unique_ptr<struct addrinfo, addrinfo_deleter> addr_info;
-    int const family = ipv6 ? AF_INET6 : AF_INET;
-    int const socket_type = udp ? SOCK_DGRAM : SOCK_STREAM;
-    int const protocol = udp ? IPPROTO_UDP : IPPROTO_TCP;
     std::string const port_str = convertIntegerToNarrowString(port);
 
-    addr_info_hints.ai_family = family;
-    addr_info_hints.ai_socktype = socket_type;
-    addr_info_hints.ai_protocol = protocol;
+    addr_info_hints.ai_family = ipv6 ? AF_INET6 : AF_INET;
+    addr_info_hints.ai_socktype = udp ? SOCK_DGRAM : SOCK_STREAM;
+    addr_info_hints.ai_protocol = udp ? IPPROTO_UDP : IPPROTO_TCP;
     addr_info_hints.ai_flags = AI_NUMERICSERV;
-    retval = getaddrinfo (LOG4CPLUS_TSTRING_TO_STRING(hostn).c_str(),
+    int const retval = getaddrinfo (LOG4CPLUS_TSTRING_TO_STRING(hostn).c_str(),
         port_str.c_str(), &addr_info_hints, &ai);
     if (retval != 0)
     {
         set_last_socket_error (retval);
-        return INVALID_SOCKET_VALUE;
+        return nullptr;
     }
 
-    addr_info.reset(ai);
+    std::unique_ptr<struct addrinfo, addrinfo_deleter> addr_info (ai);
+    auto addrs = std::make_shared<resolved_addresses> ();
+    for (struct addrinfo * rp = ai; rp; rp = rp->ai_next)
+    {
+        auto const bytes = reinterpret_cast<unsigned char const *>(rp->ai_addr);
+        addrs->push_back (resolved_address {rp->ai_family, rp->ai_socktype,
+            rp->ai_protocol,
+            std::vector<unsigned char> (bytes, bytes + rp->ai_addrlen)});
+    }
+
+    return addrs;
+}
 
-    struct addrinfo * rp;
+
+void
+set_int_option (os_socket_type sock, int level, int name, int value,
+    char const * what)
+{
+    if (setsockopt (sock, level, name, &value, sizeof (value)) != 0)
+    {
+        int const eno = errno;
+        getLogLog ().warn (LOG4CPLUS_TEXT ("setsockopt(")
+            + LOG4CPLUS_C_STR_TO_TSTRING (what)
+            + LOG4CPLUS_TEXT (") failed: ") + convertIntegerToString (eno));
+    }
+}
+
+
+void
+set_socket_options (os_socket_type sock, bool udp,
+    SocketOptions const & options)
+{
+    if (options.sendBufferSize != 0)
+        set_int_option (sock, SOL_SOCKET, SO_SNDBUF,
+            static_cast<int>((std::min<std::size_t>) (options.sendBufferSize,
+                    INT_MAX)), "SO_SNDBUF");
+
+    if (udp)
+        return;
+
+    if (options.noDelay)
+        set_int_option (sock, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+
+    if (! options.keepAlive)
+        return;
+
+    set_int_option (sock, SOL_SOCKET, SO_KEEPALIVE, 1, "SO_KEEPALIVE");
+#if defined (TCP_KEEPIDLE)
+    if (options.keepAliveIdle != 0)
+        set_int_option (sock, IPPROTO_TCP, TCP_KEEPIDLE,
+            static_cast<int>(options.keepAliveIdle), "TCP_KEEPIDLE");
+#elif defined (TCP_KEEPALIVE)
+    if (options.keepAliveIdle != 0)
+        set_int_option (sock, IPPROTO_TCP, TCP_KEEPALIVE,
+            static_cast<int>(options.keepAliveIdle), "TCP_KEEPALIVE");
+#endif
+#if defined (TCP_KEEPINTVL)
+    if (options.keepAliveInterval != 0)
+        set_int_option (sock, IPPROTO_TCP, TCP_KEEPINTVL,
+            static_cast<int>(options.keepAliveInterval), "TCP_KEEPINTVL");
+#endif
+#if defined (TCP_KEEPCNT)
+    if (options.keepAliveCount != 0)
+        set_int_option (sock, IPPROTO_TCP, TCP_KEEPCNT,
+            static_cast<int>(options.keepAliveCount), "TCP_KEEPCNT");
+#endif
+}
+
+} // namespace
+
+
+SOCKET_TYPE
+connectSocket(const tstring& hostn, unsigned short port, bool udp, bool ipv6,
+    SocketState& state, SocketOptions const & options)
+{
+    tstring path;
+    if (parseUnixSocketHost (hostn, path))
+        return connectUnixSocket (path, udp, state);
+
+    std::shared_ptr<resolved_addresses const> addrs;
+    if (options.dnsCacheTtl != 0)
+        addrs = find_resolved_addresses (hostn, port, udp, ipv6,
+            options.dnsCacheTtl);
+
+    if (! addrs)
+    {
+        addrs = resolve_address (hostn, port, udp, ipv6);
+        if (! addrs)
+            return INVALID_SOCKET_VALUE;
+
+        if (options.dnsCacheTtl != 0)
+            store_resolved_addresses (hostn, port, udp, ipv6, addrs);
+    }
+
+    int retval;
     socket_holder sock_holder;
-    for (rp = ai; rp; rp = rp->ai_next)
+    for (resolved_address const & ra : *addrs)
     {
         sock_holder.reset (
-            ::socket(rp->ai_family, rp->ai_socktype | TYPE_SOCK_CLOEXEC,
-                rp->ai_protocol));
+            ::socket(ra.family, ra.socktype | TYPE_SOCK_CLOEXEC,
+                ra.protocol));
         if (sock_holder.sock < 0)
             continue;
 
@@ -231,20 +368,119 @@ connectSocket(const tstring& hostn, unsigned short port, bool udp, bool ipv6,
         trySetCloseOnExec (sock_holder.sock);
 #endif
 
-        while ((retval = ::connect (sock_holder.sock, rp->ai_addr,
-                    rp->ai_addrlen)) == -1
+        set_socket_options (sock_holder.sock, udp, options);
+
+        while ((retval = ::connect (sock_holder.sock,
+                    reinterpret_cast<struct sockaddr const *>(ra.addr.data ()),
+                    static_cast<socklen_t>(ra.addr.size ()))) == -1
             && (errno == EINTR))
             ;
         if (retval == 0)
-            break;
+        {
+            state = ok;
+            return to_log4cplus_socket (sock_holder.detach ());
+        }
+    }
+
+    // No address succeeded.
+    return INVALID_SOCKET_VALUE;
+}
+
+
+SOCKET_TYPE
+connectUnixSocket(tstring const & path, bool datagram, SocketState& state)
+{
+#if defined (LOG4CPLUS_HAVE_SYS_UN_H)
+    std::string const path_str (LOG4CPLUS_TSTRING_TO_STRING (path));
+    struct sockaddr_un addr;
+    socklen_t const addr_len = make_unix_address (addr, path_str);
+    if (addr_len == 0)
+    {
+        set_last_socket_error (ENAMETOOLONG);
+        return INVALID_SOCKET_VALUE;
     }
 
-    if (rp == nullptr)
-        // No address succeeded.
+    socket_holder sock_holder (
+        ::socket (AF_UNIX,
+            (datagram ? SOCK_DGRAM : SOCK_STREAM) | TYPE_SOCK_CLOEXEC, 0));
+    if (sock_holder.sock < 0)
+        return INVALID_SOCKET_VALUE;
+
+#if ! defined (SOCK_CLOEXEC)
+    trySetCloseOnExec (sock_holder.sock);
+#endif
+
+    int retval;
+    while ((retval = ::connect (sock_holder.sock,
+                reinterpret_cast<struct sockaddr *>(&addr), addr_len)) == -1
+        && (errno == EINTR))
+        ;
+    if (retval != 0)
         return INVALID_SOCKET_VALUE;
 
     state = ok;
     return to_log4cplus_socket (sock_holder.detach ());
+
+#else
+    (void) path;
+    (void) datagram;
+    (void) state;
+    set_last_socket_error (EAFNOSUPPORT);
+    return INVALID_SOCKET_VALUE;
+
+#endif
+}
+
+
+SOCKET_TYPE
+openUnixSocket(tstring const & path, bool datagram, SocketState& state)
+{
+#if defined (LOG4CPLUS_HAVE_SYS_UN_H)
+    std::string const path_str (LOG4CPLUS_TSTRING_TO_STRING (path));
+    struct sockaddr_un addr;
+    socklen_t const addr_len = make_unix_address (addr, path_str);
+    if (addr_len == 0)
+    {
+        set_last_socket_error (ENAMETOOLONG);
+        return INVALID_SOCKET_VALUE;
+    }
+
+    socket_holder sock_holder (
+        ::socket (AF_UNIX,
+            (datagram ? SOCK_DGRAM : SOCK_STREAM) | TYPE_SOCK_CLOEXEC, 0));
+    if (sock_holder.sock < 0)
+        return INVALID_SOCKET_VALUE;
+
+#if ! defined (SOCK_CLOEXEC)
+    trySetCloseOnExec (sock_holder.sock);
+#endif
+
+#if defined (LOG4CPLUS_HAVE_SYS_STAT_H)
+    // Socket file left behind by previous server would fail bind().
+    struct stat st;
+    if (addr.sun_path[0] != '\0'
+        && ::lstat (addr.sun_path, &st) == 0 && S_ISSOCK (st.st_mode))
+        ::unlink (addr.sun_path);
+#endif
+
+    if (::bind (sock_holder.sock,
+            reinterpret_cast<struct sockaddr *>(&addr), addr_len) != 0)
+        return INVALID_SOCKET_VALUE;
+
+    if (! datagram && ::listen (sock_holder.sock, 10) != 0)
+        return INVALID_SOCKET_VALUE;
+
+    state = ok;
+    return to_log4cplus_socket (sock_holder.detach ());
+
+#else
+    (void) path;
+    (void) datagram;
+    (void) state;
+    set_last_socket_error (EAFNOSUPPORT);
+    return INVALID_SOCKET_VALUE;
+
+#endif
 }
 
 
@@ -380,6 +616,17 @@ read(SOCKET_TYPE sock, SocketBuffer& buffer)
 }
 
 
+long
+readSome(SOCKET_TYPE sock, char * buffer, std::size_t len)
+{
+    long res;
+    do
+        res = ::recv(to_os_socket (sock), buffer, len, 0);
+    while (res < 0 && errno == EINTR);
+    return res;
+}
+
+
 
 long
 write(SOCKET_TYPE sock, const SocketBuffer& buffer)
@@ -394,9 +641,15 @@ write(SOCKET_TYPE sock, const SocketBuffer& buffer)
 }
 
 
+namespace
+{
+
+//! Gathers up to this many buffers without allocating.
+std::size_t const stack_iovecs = 16;
+
+
 long
-write(SOCKET_TYPE sock, std::size_t bufferCount,
-    SocketBuffer const * const * buffers)
+send_iovecs (SOCKET_TYPE sock, iovec * iovecs, std::size_t count)
 {
 #if defined(MSG_NOSIGNAL)
     int flags = MSG_NOSIGNAL;
@@ -404,17 +657,6 @@ write(SOCKET_TYPE sock, std::size_t bufferCount,
     int flags = 0;
 #endif
 
-    std::vector<iovec> iovecs (bufferCount);
-    for (std::size_t i = 0; i != bufferCount; ++i)
-    {
-        iovec & iov = iovecs[i];
-        std::memset (&iov, 0, sizeof (iov));
-        SocketBuffer const & buffer = *buffers[i];
-
-        iov.iov_base = buffer.getBuffer();
-        iov.iov_len = buffer.getSize();
-    }
-
     msghdr message;
     std::memset (&message, 0, sizeof (message));
     message.msg_name = nullptr;
@@ -422,13 +664,110 @@ write(SOCKET_TYPE sock, std::size_t bufferCount,
     message.msg_control = nullptr;
     message.msg_controllen = 0;
     message.msg_flags = 0;
-    message.msg_iov = &iovecs[0];
-    message.msg_iovlen = iovecs.size ();
+    message.msg_iov = iovecs;
+    message.msg_iovlen = count;
 
     return sendmsg (to_os_socket (sock), &message, flags);
 }
 
 
+template <typename Buffers, typename Fill>
+long
+gather_write (SOCKET_TYPE sock, std::size_t count, Buffers const & buffers,
+    Fill fill)
+{
+    iovec stack[stack_iovecs];
+    std::vector<iovec> heap;
+    iovec * iovecs = stack;
+    if (count > stack_iovecs)
+    {
+        heap.resize (count);
+        iovecs = &heap[0];
+    }
+
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        iovec & iov = iovecs[i];
+        std::memset (&iov, 0, sizeof (iov));
+        fill (iov, buffers[i]);
+    }
+
+    return send_iovecs (sock, iovecs, count);
+}
+
+} // namespace
+
+
+long
+write(SOCKET_TYPE sock, std::size_t bufferCount,
+    SocketBuffer const * const * buffers)
+{
+    return gather_write (sock, bufferCount, buffers,
+        [] (iovec & iov, SocketBuffer const * buffer)
+        {
+            iov.iov_base = buffer->getBuffer();
+            iov.iov_len = buffer->getSize();
+        });
+}
+
+
+long
+write(SOCKET_TYPE sock, std::span<std::string_view const> buffers)
+{
+    return gather_write (sock, buffers.size (), buffers,
+        [] (iovec & iov, std::string_view buffer)
+        {
+            iov.iov_base = const_cast<char *>(buffer.data ());
+            iov.iov_len = buffer.size ();
+        });
+}
+
+
+long
+writeDatagrams(SOCKET_TYPE sock, std::span<std::string_view const> datagrams)
+{
+#if defined(MSG_NOSIGNAL)
+    int flags = MSG_NOSIGNAL;
+#else
+    int flags = 0;
+#endif
+
+    std::size_t sent = 0;
+    while (sent != datagrams.size ())
+    {
+#if defined (LOG4CPLUS_HAVE_SENDMMSG)
+        std::size_t const count
+            = (std::min) (datagrams.size () - sent, stack_iovecs);
+        iovec iovecs[stack_iovecs];
+        mmsghdr messages[stack_iovecs];
+        std::memset (messages, 0, sizeof (messages));
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            iovecs[i].iov_base = const_cast<char *>(datagrams[sent + i].data ());
+            iovecs[i].iov_len = datagrams[sent + i].size ();
+            messages[i].msg_hdr.msg_iov = &iovecs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int const ret = sendmmsg (to_os_socket (sock), messages,
+            static_cast<unsigned>(count), flags);
+#else
+        std::string_view const datagram = datagrams[sent];
+        long ret = ::send (to_os_socket (sock), datagram.data (),
+            datagram.size (), flags);
+        if (ret >= 0)
+            ret = 1;
+#endif
+        if (ret <= 0)
+            return sent != 0 ? static_cast<long>(sent) : -1;
+
+        sent += static_cast<std::size_t>(ret);
+    }
+
+    return static_cast<long>(sent);
+}
+
+
 long
 write(SOCKET_TYPE sock, const std::string & buffer)
 {
@@ -512,6 +851,27 @@ setTCPNoDelay (SOCKET_TYPE sock, bool val)
 }
 
 
+std::size_t
+getUnsentBytes (SOCKET_TYPE sock)
+{
+#if defined (LOG4CPLUS_HAVE_SYS_IOCTL_H) && defined (TIOCOUTQ)
+    int unsent = 0;
+    if (ioctl (to_os_socket (sock), TIOCOUTQ, &unsent) == 0 && unsent > 0)
+        return static_cast<std::size_t>(unsent);
+
+#elif defined (LOG4CPLUS_HAVE_SYS_IOCTL_H) && defined (FIONWRITE)
+    int unsent = 0;
+    if (ioctl (to_os_socket (sock), FIONWRITE, &unsent) == 0 && unsent > 0)
+        return static_cast<std::size_t>(unsent);
+
+#else
+    (void) sock;
+
+#endif
+    return 0;
+}
+
+
 //
 // ServerSocket OS dependent stuff
 //
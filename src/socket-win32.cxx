@@ -23,15 +23,33 @@
 
 #include <cassert>
 #include <cerrno>
+#include <climits>
 #include <vector>
 #include <cstring>
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <log4cplus/internal/socket.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/thread/threads.h>
 #include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/internal/internal.h>
 
+#if defined (__has_include)
+#  if __has_include (<afunix.h>)
+#    include <afunix.h>
+#    define LOG4CPLUS_HAVE_AFUNIX_H
+#  endif
+#endif
+
+#include <mswsock.h>
+#if defined (LOG4CPLUS_WITH_RIO) \
+    && defined (SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER) \
+    && defined (WSAID_MULTIPLE_RIO) && defined (WSA_FLAG_REGISTERED_IO)
+#  define LOG4CPLUS_HAVE_RIO
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // file LOCAL Classes
@@ -160,6 +178,132 @@ WinSockInitializer WinSockInitializer::winSockInitializer;
 namespace log4cplus { namespace helpers {
 
 
+#if defined (LOG4CPLUS_HAVE_RIO)
+namespace
+{
+
+//! Size of registered buffer of every socket; batches of datagrams
+//! that do not fit are sent in several rounds.
+std::size_t const rio_buffer_size = 256 * 1024;
+
+//! Maximum number of outstanding sends of one socket.
+ULONG const rio_queue_depth = 256;
+
+
+//! Registered I/O functions, available since Windows 8.
+struct rio_api
+{
+    RIO_EXTENSION_FUNCTION_TABLE table{};
+    bool available = false;
+};
+
+
+rio_api const &
+get_rio_api ()
+{
+    static rio_api const api = []
+    {
+        rio_api result;
+        init_winsock ();
+        SOCKET const sock = WSASocketW (AF_INET, SOCK_DGRAM, IPPROTO_UDP,
+            nullptr, 0, WSA_FLAG_REGISTERED_IO);
+        if (sock == INVALID_SOCKET)
+            return result;
+
+        GUID id = WSAID_MULTIPLE_RIO;
+        DWORD bytes = 0;
+        result.table.cbSize = sizeof (result.table);
+        result.available = WSAIoctl (sock,
+            SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER, &id, sizeof (id),
+            &result.table, sizeof (result.table), &bytes, nullptr,
+            nullptr) == 0;
+        ::closesocket (sock);
+        return result;
+    } ();
+    return api;
+}
+
+
+//! Registered buffer, completion queue and request queue of one UDP
+//! socket. Batches of datagrams are copied into the buffer and posted
+//! with one system call instead of one send() per datagram.
+struct rio_socket
+{
+    rio_socket () = default;
+    rio_socket (rio_socket const &) = delete;
+    rio_socket & operator = (rio_socket const &) = delete;
+    ~rio_socket ();
+
+    bool init (os_socket_type sock);
+
+    //! \return Number of datagrams sent.
+    std::size_t send (os_socket_type sock,
+        std::span<std::string_view const> datagrams);
+
+    std::mutex mtx;
+    char * buffer = nullptr;
+    RIO_BUFFERID bufferId = RIO_INVALID_BUFFERID;
+    HANDLE event = nullptr;
+    RIO_CQ cq = RIO_INVALID_CQ;
+    RIO_RQ rq = RIO_INVALID_RQ;
+};
+
+
+//! RIO state of sockets by their handles. Null entries mark sockets
+//! RIO could not be set up for, they are not tried again.
+struct rio_sockets
+{
+    std::mutex mtx;
+    std::unordered_map<os_socket_type, std::shared_ptr<rio_socket>> map;
+};
+
+
+rio_sockets &
+get_rio_sockets ()
+{
+    static rio_sockets sockets;
+    return sockets;
+}
+
+
+std::shared_ptr<rio_socket>
+find_rio_socket (os_socket_type sock)
+{
+    if (! get_rio_api ().available)
+        return std::shared_ptr<rio_socket> ();
+
+    rio_sockets & sockets = get_rio_sockets ();
+    std::lock_guard guard (sockets.mtx);
+    auto it = sockets.map.find (sock);
+    if (it != sockets.map.end ())
+        return it->second;
+
+    auto rio = std::make_shared<rio_socket> ();
+    if (! rio->init (sock))
+        rio.reset ();
+    sockets.map.emplace (sock, rio);
+    return rio;
+}
+
+
+std::shared_ptr<rio_socket>
+release_rio_socket (os_socket_type sock)
+{
+    rio_sockets & sockets = get_rio_sockets ();
+    std::lock_guard guard (sockets.mtx);
+    auto it = sockets.map.find (sock);
+    if (it == sockets.map.end ())
+        return std::shared_ptr<rio_socket> ();
+
+    std::shared_ptr<rio_socket> rio = std::move (it->second);
+    sockets.map.erase (it);
+    return rio;
+}
+
+} // namespace
+#endif // defined (LOG4CPLUS_HAVE_RIO)
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Global Methods
 /////////////////////////////////////////////////////////////////////////////
@@ -168,6 +312,10 @@ SOCKET_TYPE
 openSocket(tstring const & host, unsigned short port, bool udp, bool ipv6,
     SocketState& state)
 {
+    tstring path;
+    if (parseUnixSocketHost (host, path))
+        return openUnixSocket (path, udp, state);
+
     ADDRINFOT addr_info_hints{};
     PADDRINFOT ai = nullptr;
     std::unique_ptr<ADDRINFOT, ADDRINFOT_deleter> addr_info;
@@ -208,7 +356,7 @@ openSocket(tstring const & host, unsigned short port, bool udp, bool ipv6,
     if (bind(sock_holder.sock, ai->ai_addr, static_cast<int>(ai->ai_addrlen)) != 0)
         goto error;
 
-    if (::listen(sock_holder.sock, 10) != 0)
+    if (! udp && ::listen(sock_holder.sock, 10) != 0)
         goto error;
 
     state = ok;
@@ -221,17 +369,106 @@ error:
 }
 
 
-SOCKET_TYPE
-connectSocket(const tstring& hostn, unsigned short port, bool udp, bool ipv6,
-    SocketState& state)
+namespace
+{
+
+//! Resolves <code>hostn</code> through GetAddrInfo().
+std::shared_ptr<resolved_addresses const>
+resolve_address (tstring const & hostn, unsigned short port, bool udp,
+    bool ipv6)
 {
     ADDRINFOT addr_info_hints{};
     PADDRINFOT ai = nullptr;
-    std::unique_ptr<ADDRINFOT, ADDRINFOT_deleter> addr_info;
-    int const family = ipv6 ? AF_INET6 : AF_INET;
-    int const socket_type = udp ? SOCK_DGRAM : SOCK_STREAM;
-    int const protocol = udp ? IPPROTO_UDP : IPPROTO_TCP;
     tstring const port_str = convertIntegerToString (port);
+
+    addr_info_hints.ai_family = ipv6 ? AF_INET6 : AF_INET;
+    addr_info_hints.ai_socktype = udp ? SOCK_DGRAM : SOCK_STREAM;
+    addr_info_hints.ai_protocol = udp ? IPPROTO_UDP : IPPROTO_TCP;
+    addr_info_hints.ai_flags = AI_NUMERICSERV;
+    int const retval = GetAddrInfo(hostn.c_str(), port_str.c_str(),
+        &addr_info_hints, &ai);
+    if (retval != 0)
+    {
+        set_last_socket_error(retval);
+        return nullptr;
+    }
+
+    std::unique_ptr<ADDRINFOT, ADDRINFOT_deleter> addr_info (ai);
+    auto addrs = std::make_shared<resolved_addresses> ();
+    for (ADDRINFOT * rp = ai; rp; rp = rp->ai_next)
+    {
+        auto const bytes = reinterpret_cast<unsigned char const *>(rp->ai_addr);
+        addrs->push_back (resolved_address {rp->ai_family, rp->ai_socktype,
+            rp->ai_protocol,
+            std::vector<unsigned char> (bytes, bytes + rp->ai_addrlen)});
+    }
+
+    return addrs;
+}
+
+
+void
+set_int_option (os_socket_type sock, int level, int name, int value,
+    char const * what)
+{
+    if (setsockopt (sock, level, name, reinterpret_cast<char const *>(&value),
+            sizeof (value)) != 0)
+    {
+        int const eno = WSAGetLastError ();
+        getLogLog ().warn (LOG4CPLUS_TEXT ("setsockopt(")
+            + LOG4CPLUS_C_STR_TO_TSTRING (what)
+            + LOG4CPLUS_TEXT (") failed: ") + convertIntegerToString (eno));
+    }
+}
+
+
+void
+set_socket_options (os_socket_type sock, bool udp,
+    SocketOptions const & options)
+{
+    if (options.sendBufferSize != 0)
+        set_int_option (sock, SOL_SOCKET, SO_SNDBUF,
+            static_cast<int>((std::min<std::size_t>) (options.sendBufferSize,
+                    INT_MAX)), "SO_SNDBUF");
+
+    if (udp)
+        return;
+
+    if (options.noDelay)
+        set_int_option (sock, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+
+    if (! options.keepAlive)
+        return;
+
+    set_int_option (sock, SOL_SOCKET, SO_KEEPALIVE, 1, "SO_KEEPALIVE");
+#if defined (TCP_KEEPIDLE)
+    if (options.keepAliveIdle != 0)
+        set_int_option (sock, IPPROTO_TCP, TCP_KEEPIDLE,
+            static_cast<int>(options.keepAliveIdle), "TCP_KEEPIDLE");
+#endif
+#if defined (TCP_KEEPINTVL)
+    if (options.keepAliveInterval != 0)
+        set_int_option (sock, IPPROTO_TCP, TCP_KEEPINTVL,
+            static_cast<int>(options.keepAliveInterval), "TCP_KEEPINTVL");
+#endif
+#if defined (TCP_KEEPCNT)
+    if (options.keepAliveCount != 0)
+        set_int_option (sock, IPPROTO_TCP, TCP_KEEPCNT,
+            static_cast<int>(options.keepAliveCount), "TCP_KEEPCNT");
+#endif
+}
+
+} // namespace
+
+
+SOCKET_TYPE
+connectSocket(const tstring& hostn, unsigned short port, bool udp, bool ipv6,
+    SocketState& state, SocketOptions const & options)
+{
+    tstring path;
+    if (parseUnixSocketHost (hostn, path))
+        return connectUnixSocket (path, udp, state);
+
     int retval;
     DWORD const wsa_socket_flags =
 #if defined (WSA_FLAG_NO_HANDLE_INHERIT)
@@ -242,47 +479,171 @@ connectSocket(const tstring& hostn, unsigned short port, bool udp, bool ipv6,
 
     init_winsock ();
 
-    addr_info_hints.ai_family = family;
-    addr_info_hints.ai_socktype = socket_type;
-    addr_info_hints.ai_protocol = protocol;
-    addr_info_hints.ai_flags = AI_NUMERICSERV;
-    retval = GetAddrInfo(hostn.c_str(), port_str.c_str(), &addr_info_hints,
-        &ai);
-    if (retval != 0)
+    std::shared_ptr<resolved_addresses const> addrs;
+    if (options.dnsCacheTtl != 0)
+        addrs = find_resolved_addresses (hostn, port, udp, ipv6,
+            options.dnsCacheTtl);
+
+    if (! addrs)
     {
-        set_last_socket_error(retval);
-        return INVALID_SOCKET_VALUE;
+        addrs = resolve_address (hostn, port, udp, ipv6);
+        if (! addrs)
+            return INVALID_SOCKET_VALUE;
+
+        if (options.dnsCacheTtl != 0)
+            store_resolved_addresses (hostn, port, udp, ipv6, addrs);
     }
 
-    addr_info.reset(ai);
+    DWORD socket_flags = wsa_socket_flags;
+#if defined (LOG4CPLUS_HAVE_RIO)
+    // Batches of datagrams are sent through Registered I/O, see
+    // writeDatagrams().
+    if (udp && get_rio_api ().available)
+        socket_flags |= WSA_FLAG_REGISTERED_IO;
+#endif
 
     socket_holder sock_holder;
-    for (ADDRINFOT * rp = ai; rp; rp = rp->ai_next)
+    for (resolved_address const & ra : *addrs)
     {
         sock_holder.reset(
-            WSASocketW(rp->ai_family, rp->ai_socktype, rp->ai_protocol,
-                nullptr, 0, wsa_socket_flags));
+            WSASocketW(ra.family, ra.socktype, ra.protocol,
+                nullptr, 0, socket_flags));
         if (sock_holder.sock == INVALID_OS_SOCKET_VALUE)
             continue;
 
+        set_socket_options (sock_holder.sock, udp, options);
+
         while (
-            (retval = ::connect(sock_holder.sock, rp->ai_addr,
-                static_cast<int>(rp->ai_addrlen))) == -1
+            (retval = ::connect(sock_holder.sock,
+                reinterpret_cast<struct sockaddr const *>(ra.addr.data ()),
+                static_cast<int>(ra.addr.size ()))) == -1
             && (WSAGetLastError() == WSAEINTR))
             ;
         if (retval != SOCKET_ERROR)
-            break;
+        {
+            state = ok;
+            return to_log4cplus_socket (sock_holder.detach());
+        }
+    }
+
+    DWORD const eno = WSAGetLastError();
+    set_last_socket_error(eno);
+    return INVALID_SOCKET_VALUE;
+}
+
+
+#if defined (LOG4CPLUS_HAVE_AFUNIX_H)
+namespace
+{
+
+//! Opens stream <code>AF_UNIX</code> socket and fills <code>addr</code>
+//! with <code>path</code>.
+static
+SOCKET
+open_unix_socket (tstring const & path, bool datagram,
+    SOCKADDR_UN & addr)
+{
+    // Windows supports only stream local sockets.
+    if (datagram)
+    {
+        set_last_socket_error (WSAEAFNOSUPPORT);
+        return INVALID_OS_SOCKET_VALUE;
+    }
+
+    std::string const path_str (LOG4CPLUS_TSTRING_TO_STRING (path));
+    addr = SOCKADDR_UN ();
+    addr.sun_family = AF_UNIX;
+    if (path_str.empty () || path_str.size () >= sizeof (addr.sun_path))
+    {
+        set_last_socket_error (WSAENAMETOOLONG);
+        return INVALID_OS_SOCKET_VALUE;
+    }
+
+    std::memcpy (addr.sun_path, path_str.c_str (), path_str.size () + 1);
+
+    init_winsock ();
+    SOCKET const sock = WSASocketW (AF_UNIX, SOCK_STREAM, 0, nullptr, 0,
+#if defined (WSA_FLAG_NO_HANDLE_INHERIT)
+        WSA_FLAG_NO_HANDLE_INHERIT
+#else
+        0
+#endif
+        );
+    if (sock == INVALID_OS_SOCKET_VALUE)
+        set_last_socket_error (WSAGetLastError ());
+
+    return sock;
+}
+
+} // namespace
+#endif
+
+
+SOCKET_TYPE
+connectUnixSocket(tstring const & path, bool datagram, SocketState& state)
+{
+#if defined (LOG4CPLUS_HAVE_AFUNIX_H)
+    SOCKADDR_UN addr;
+    socket_holder sock_holder (open_unix_socket (path, datagram, addr));
+    if (sock_holder.sock == INVALID_OS_SOCKET_VALUE)
+        return INVALID_SOCKET_VALUE;
+
+    if (::connect (sock_holder.sock, reinterpret_cast<sockaddr *>(&addr),
+            static_cast<int>(sizeof (addr))) != 0)
+    {
+        set_last_socket_error (WSAGetLastError ());
+        return INVALID_SOCKET_VALUE;
     }
 
+    state = ok;
+    return to_log4cplus_socket (sock_holder.detach ());
+
+#else
+    (void) path;
+    (void) datagram;
+    (void) state;
+    set_last_socket_error (WSAEAFNOSUPPORT);
+    return INVALID_SOCKET_VALUE;
+
+#endif
+}
+
+
+SOCKET_TYPE
+openUnixSocket(tstring const & path, bool datagram, SocketState& state)
+{
+#if defined (LOG4CPLUS_HAVE_AFUNIX_H)
+    SOCKADDR_UN addr;
+    socket_holder sock_holder (open_unix_socket (path, datagram, addr));
     if (sock_holder.sock == INVALID_OS_SOCKET_VALUE)
+        return INVALID_SOCKET_VALUE;
+
+    // Socket file left behind by previous server would fail bind().
+    // Socket files are reparse points.
+    DWORD const attrs = GetFileAttributesA (addr.sun_path);
+    if (attrs != INVALID_FILE_ATTRIBUTES
+        && (attrs & FILE_ATTRIBUTE_REPARSE_POINT))
+        DeleteFileA (addr.sun_path);
+
+    if (bind (sock_holder.sock, reinterpret_cast<sockaddr *>(&addr),
+            static_cast<int>(sizeof (addr))) != 0
+        || ::listen (sock_holder.sock, 10) != 0)
     {
-        DWORD const eno = WSAGetLastError();
-        set_last_socket_error(eno);
+        set_last_socket_error (WSAGetLastError ());
         return INVALID_SOCKET_VALUE;
     }
 
     state = ok;
-    return to_log4cplus_socket (sock_holder.detach());
+    return to_log4cplus_socket (sock_holder.detach ());
+
+#else
+    (void) path;
+    (void) datagram;
+    (void) state;
+    set_last_socket_error (WSAEAFNOSUPPORT);
+    return INVALID_SOCKET_VALUE;
+
+#endif
 }
 
 
@@ -306,6 +667,12 @@ acceptSocket(SOCKET_TYPE sock, SocketState & state)
 int
 closeSocket(SOCKET_TYPE sock)
 {
+#if defined (LOG4CPLUS_HAVE_RIO)
+    // Request queue of the socket goes away with it, its completion
+    // queue and buffer are released after it.
+    std::shared_ptr<rio_socket> const rio
+        = release_rio_socket (to_os_socket (sock));
+#endif
     return ::closesocket (to_os_socket (sock));
 }
 
@@ -348,6 +715,17 @@ read(SOCKET_TYPE sock, SocketBuffer& buffer)
 }
 
 
+long
+readSome(SOCKET_TYPE sock, char * buffer, std::size_t len)
+{
+    long const res = ::recv (to_os_socket (sock), buffer,
+        static_cast<int>(len), 0);
+    if (res == SOCKET_ERROR)
+        set_last_socket_error (WSAGetLastError ());
+    return res;
+}
+
+
 
 long
 write(SOCKET_TYPE sock, const SocketBuffer& buffer)
@@ -360,23 +738,36 @@ write(SOCKET_TYPE sock, const SocketBuffer& buffer)
 }
 
 
+namespace
+{
+
+//! Gathers up to this many buffers without allocating.
+std::size_t const stack_wsabufs = 16;
+
+
+template <typename Buffers, typename Fill>
 long
-write (SOCKET_TYPE sock, std::size_t bufferCount,
-    SocketBuffer const * const * buffers)
+gather_write (SOCKET_TYPE sock, std::size_t count, Buffers const & buffers,
+    Fill fill)
 {
-    std::vector<WSABUF> wsabufs (bufferCount);
-    for (std::size_t i = 0; i != bufferCount; ++i)
+    WSABUF stack[stack_wsabufs];
+    std::vector<WSABUF> heap;
+    WSABUF * wsabufs = stack;
+    if (count > stack_wsabufs)
+    {
+        heap.resize (count);
+        wsabufs = &heap[0];
+    }
+
+    for (std::size_t i = 0; i != count; ++i)
     {
         WSABUF & wsabuf = wsabufs[i];
         std::memset (&wsabuf, 0, sizeof (wsabuf));
-        SocketBuffer const & buffer = *buffers[i];
-
-        wsabuf.buf = buffer.getBuffer ();
-        wsabuf.len = static_cast<ULONG>(buffer.getSize ());
+        fill (wsabuf, buffers[i]);
     }
 
     DWORD bytes_sent = 0;
-    int ret = WSASend (sock, &wsabufs[0], static_cast<DWORD>(bufferCount),
+    int ret = WSASend (sock, wsabufs, static_cast<DWORD>(count),
         &bytes_sent, 0, nullptr, nullptr);
     if (ret == SOCKET_ERROR)
     {
@@ -387,6 +778,226 @@ write (SOCKET_TYPE sock, std::size_t bufferCount,
         return static_cast<long>(bytes_sent);
 }
 
+} // namespace
+
+
+long
+write (SOCKET_TYPE sock, std::size_t bufferCount,
+    SocketBuffer const * const * buffers)
+{
+    return gather_write (sock, bufferCount, buffers,
+        [] (WSABUF & wsabuf, SocketBuffer const * buffer)
+        {
+            wsabuf.buf = buffer->getBuffer ();
+            wsabuf.len = static_cast<ULONG>(buffer->getSize ());
+        });
+}
+
+
+long
+write (SOCKET_TYPE sock, std::span<std::string_view const> buffers)
+{
+    return gather_write (sock, buffers.size (), buffers,
+        [] (WSABUF & wsabuf, std::string_view buffer)
+        {
+            wsabuf.buf = const_cast<char *>(buffer.data ());
+            wsabuf.len = static_cast<ULONG>(buffer.size ());
+        });
+}
+
+
+namespace
+{
+
+//! Sends datagrams one by one.
+std::size_t
+send_datagrams (os_socket_type sock,
+    std::span<std::string_view const> datagrams)
+{
+    std::size_t sent = 0;
+    for (std::string_view datagram : datagrams)
+    {
+        long ret = ::send (sock, datagram.data (),
+            static_cast<int>(datagram.size ()), 0);
+        if (ret == SOCKET_ERROR)
+        {
+            set_last_socket_error (WSAGetLastError ());
+            break;
+        }
+
+        ++sent;
+    }
+
+    return sent;
+}
+
+
+#if defined (LOG4CPLUS_HAVE_RIO)
+rio_socket::~rio_socket ()
+{
+    rio_api const & api = get_rio_api ();
+    if (cq != RIO_INVALID_CQ)
+        api.table.RIOCloseCompletionQueue (cq);
+    if (bufferId != RIO_INVALID_BUFFERID)
+        api.table.RIODeregisterBuffer (bufferId);
+    if (buffer)
+        VirtualFree (buffer, 0, MEM_RELEASE);
+    if (event)
+        CloseHandle (event);
+}
+
+
+bool
+rio_socket::init (os_socket_type sock)
+{
+    rio_api const & api = get_rio_api ();
+
+    // Page aligned memory, as RIORegisterBuffer() recommends.
+    buffer = static_cast<char *>(VirtualAlloc (nullptr, rio_buffer_size,
+        MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+    if (! buffer)
+        return false;
+
+    bufferId = api.table.RIORegisterBuffer (buffer,
+        static_cast<DWORD>(rio_buffer_size));
+    if (bufferId == RIO_INVALID_BUFFERID)
+        return false;
+
+    event = CreateEventW (nullptr, FALSE, FALSE, nullptr);
+    if (! event)
+        return false;
+
+    RIO_NOTIFICATION_COMPLETION completion{};
+    completion.Type = RIO_EVENT_COMPLETION;
+    completion.Event.EventHandle = event;
+    completion.Event.NotifyReset = TRUE;
+    // Receive completions share the queue, none are ever requested.
+    cq = api.table.RIOCreateCompletionQueue (rio_queue_depth + 1,
+        &completion);
+    if (cq == RIO_INVALID_CQ)
+        return false;
+
+    // Fails for sockets created without WSA_FLAG_REGISTERED_IO.
+    rq = api.table.RIOCreateRequestQueue (sock, 1, 1, rio_queue_depth, 1,
+        cq, cq, this);
+    return rq != RIO_INVALID_RQ;
+}
+
+
+std::size_t
+rio_socket::send (os_socket_type sock,
+    std::span<std::string_view const> datagrams)
+{
+    rio_api const & api = get_rio_api ();
+    std::lock_guard guard (mtx);
+
+    std::size_t sent = 0;
+    while (sent != datagrams.size ())
+    {
+        // Copy as many datagrams as fit into the registered buffer and
+        // post them deferred, so that they reach the kernel together.
+        ULONG offset = 0;
+        ULONG posted = 0;
+        std::size_t i = sent;
+        for (; i != datagrams.size () && posted != rio_queue_depth; ++i)
+        {
+            std::string_view const datagram = datagrams[i];
+            if (datagram.size () > rio_buffer_size - offset)
+                break;
+
+            std::memcpy (buffer + offset, datagram.data (), datagram.size ());
+            RIO_BUF buf;
+            buf.BufferId = bufferId;
+            buf.Offset = offset;
+            buf.Length = static_cast<ULONG>(datagram.size ());
+            if (! api.table.RIOSend (rq, &buf, 1, RIO_MSG_DEFER, nullptr))
+            {
+                set_last_socket_error (WSAGetLastError ());
+                break;
+            }
+
+            offset += buf.Length;
+            ++posted;
+        }
+
+        if (posted == 0)
+        {
+            // Datagram larger than the registered buffer, or failure.
+            if (i == sent && datagrams[i].size () > rio_buffer_size
+                && send_datagrams (sock, datagrams.subspan (i, 1)) == 1)
+            {
+                ++sent;
+                continue;
+            }
+
+            return sent;
+        }
+
+        if (! api.table.RIOSend (rq, nullptr, 0, RIO_MSG_COMMIT_ONLY,
+                nullptr))
+            set_last_socket_error (WSAGetLastError ());
+
+        // Wait for all posted sends, the buffer is reused by the next
+        // round.
+        ULONG completed = 0;
+        ULONG failed = 0;
+        RIORESULT results[64];
+        while (completed != posted)
+        {
+            ULONG const count = api.table.RIODequeueCompletion (cq,
+                results, static_cast<ULONG>(std::size (results)));
+            if (count == RIO_CORRUPT_CQ)
+                return sent;
+
+            if (count == 0)
+            {
+                if (api.table.RIONotify (cq) != ERROR_SUCCESS
+                    || WaitForSingleObject (event, INFINITE)
+                        != WAIT_OBJECT_0)
+                    return sent;
+                continue;
+            }
+
+            for (ULONG k = 0; k != count; ++k)
+                if (results[k].Status != 0)
+                {
+                    set_last_socket_error (results[k].Status);
+                    ++failed;
+                }
+            completed += count;
+        }
+
+        sent += posted - failed;
+        if (failed != 0)
+            return sent;
+    }
+
+    return sent;
+}
+#endif // defined (LOG4CPLUS_HAVE_RIO)
+
+} // namespace
+
+
+long
+writeDatagrams (SOCKET_TYPE sock, std::span<std::string_view const> datagrams)
+{
+    os_socket_type const osSocket = to_os_socket (sock);
+    std::size_t sent;
+#if defined (LOG4CPLUS_HAVE_RIO)
+    // Single datagrams gain nothing from copying into registered buffer.
+    std::shared_ptr<rio_socket> rio;
+    if (datagrams.size () > 1)
+        rio = find_rio_socket (osSocket);
+    if (rio)
+        sent = rio->send (osSocket, datagrams);
+    else
+#endif
+        sent = send_datagrams (osSocket, datagrams);
+
+    return sent != 0 ? static_cast<long>(sent) : -1;
+}
+
 
 long
 write(SOCKET_TYPE sock, const std::string & buffer)
@@ -501,6 +1112,14 @@ setTCPNoDelay (SOCKET_TYPE sock, bool val)
 }
 
 
+std::size_t
+getUnsentBytes (SOCKET_TYPE)
+{
+    // Winsock does not report the send queue length.
+    return 0;
+}
+
+
 //
 // ServerSocket OS dependent stuff
 //
@@ -19,8 +19,15 @@
 // limitations under the License.
 
 #include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/tlscontext.h>
 #include <log4cplus/internal/socket.h>
 #include <log4cplus/internal/internal.h>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
 
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 #include <catch.hpp>
@@ -134,19 +141,17 @@ Socket::Socket()
 
 Socket::Socket(const tstring& address, unsigned short port,
     bool udp /*= false*/, bool ipv6 /*= false */)
+    : Socket (address, port, udp, ipv6, SocketOptions ())
+{ }
+
+
+Socket::Socket(const tstring& address, unsigned short port,
+    bool udp, bool ipv6, SocketOptions const & options)
     : AbstractSocket()
 {
-    sock = connectSocket(address, port, udp, ipv6, state);
+    sock = connectSocket(address, port, udp, ipv6, state, options);
     if (sock == INVALID_SOCKET_VALUE)
-        goto error;
-
-    if (! udp && setTCPNoDelay (sock, true) != 0)
-        goto error;
-
-    return;
-
-error:
-    err = get_last_socket_error ();
+        err = get_last_socket_error ();
 }
 
 
@@ -157,6 +162,7 @@ Socket::Socket(SOCKET_TYPE sock_, SocketState state_, int err_)
 
 Socket::Socket (Socket && other) LOG4CPLUS_NOEXCEPT
     : AbstractSocket (std::move (other))
+    , tls (std::move (other.tls))
 { }
 
 
@@ -175,9 +181,73 @@ Socket::operator = (Socket && other) LOG4CPLUS_NOEXCEPT
 // Socket methods
 //////////////////////////////////////////////////////////////////////////////
 
+void
+Socket::swap (Socket & rhs)
+{
+    AbstractSocket::swap (rhs);
+    tls.swap (rhs.tls);
+}
+
+
+void
+Socket::close()
+{
+    if (tls)
+    {
+        tls->shutdown ();
+        tls.reset ();
+    }
+
+    AbstractSocket::close ();
+}
+
+
+bool
+Socket::startTls(TlsContext & context)
+{
+    if (! isOpen ())
+        return false;
+
+    tls = context.startSession (sock);
+    if (! tls)
+        close ();
+
+    return !! tls;
+}
+
+
+std::size_t
+Socket::getUnsentBytes() const
+{
+    return isOpen () ? helpers::getUnsentBytes (sock) : 0;
+}
+
+
 bool
 Socket::read(SocketBuffer& buffer)
 {
+    if (tls)
+    {
+        // Fill the whole buffer like helpers::read() does.
+        std::size_t const size = buffer.getMaxSize ();
+        std::size_t got = 0;
+        while (got != size)
+        {
+            long const ret = tls->read (buffer.getBuffer () + got, size - got);
+            if (ret <= 0)
+            {
+                tls.reset ();
+                close ();
+                return false;
+            }
+
+            got += static_cast<std::size_t>(ret);
+        }
+
+        buffer.setSize (got);
+        return true;
+    }
+
     long retval = helpers::read(sock, buffer);
     if(retval <= 0) {
         close();
@@ -190,10 +260,33 @@ Socket::read(SocketBuffer& buffer)
 }
 
 
+std::size_t
+Socket::readSome(char * buffer, std::size_t len)
+{
+    long const ret = tls
+        ? tls->read (buffer, len)
+        : helpers::readSome (sock, buffer, len);
+    if (ret <= 0)
+    {
+        tls.reset ();
+        close ();
+        return 0;
+    }
+
+    return static_cast<std::size_t>(ret);
+}
+
+
 
 bool
 Socket::write(const SocketBuffer& buffer)
 {
+    if (tls)
+    {
+        std::string_view const view (buffer.getBuffer (), buffer.getSize ());
+        return write (std::span<std::string_view const> (&view, 1));
+    }
+
     long retval = helpers::write(sock, buffer);
     if(retval <= 0) {
         close();
@@ -206,6 +299,16 @@ Socket::write(const SocketBuffer& buffer)
 bool
 Socket::write(std::size_t bufferCount, SocketBuffer const * const * buffers)
 {
+    if (tls)
+    {
+        std::vector<std::string_view> views;
+        views.reserve (bufferCount);
+        for (std::size_t i = 0; i != bufferCount; ++i)
+            views.emplace_back (buffers[i]->getBuffer (),
+                buffers[i]->getSize ());
+        return write (std::span<std::string_view const> (views));
+    }
+
     long retval = helpers::write(sock, bufferCount, buffers);
     if (retval <= 0)
         close ();
@@ -214,9 +317,57 @@ Socket::write(std::size_t bufferCount, SocketBuffer const * const * buffers)
 }
 
 
+bool
+Socket::write(std::span<std::string_view const> buffers)
+{
+    if (tls)
+    {
+        bool const ret = tls->write (buffers);
+        if (! ret)
+        {
+            // Close notification cannot be sent over failed channel.
+            tls.reset ();
+            close ();
+        }
+
+        return ret;
+    }
+
+    long retval = helpers::write (sock, buffers);
+    if (retval <= 0)
+        close ();
+
+    return retval > 0;
+}
+
+
+bool
+Socket::writeDatagrams(std::span<std::string_view const> datagrams)
+{
+    if (datagrams.empty ())
+        return true;
+
+    // There are no datagrams over TLS, only byte stream.
+    if (tls)
+        return write (datagrams);
+
+    long retval = helpers::writeDatagrams (sock, datagrams);
+    if (retval <= 0)
+        close ();
+
+    return retval == static_cast<long>(datagrams.size ());
+}
+
+
 bool
 Socket::write(const std::string & buffer)
 {
+    if (tls)
+    {
+        std::string_view const view (buffer);
+        return write (std::span<std::string_view const> (&view, 1));
+    }
+
     long retval = helpers::write (sock, buffer);
     if (retval <= 0)
         close();
@@ -258,6 +409,19 @@ ServerSocket::swap (ServerSocket & other)
 //
 //
 
+bool
+parseUnixSocketHost (tstring const & host, tstring & path)
+{
+    tstring_view const prefix (LOG4CPLUS_TEXT ("unix://"));
+    if (host.size () <= prefix.size ()
+        || tstring_view (host).substr (0, prefix.size ()) != prefix)
+        return false;
+
+    path.assign (host, prefix.size (), tstring::npos);
+    return true;
+}
+
+
 SOCKET_TYPE
 openSocket(unsigned short port, bool udp, bool ipv6, SocketState& state)
 {
@@ -265,6 +429,88 @@ openSocket(unsigned short port, bool udp, bool ipv6, SocketState& state)
 }
 
 
+SOCKET_TYPE
+connectSocket(const tstring& hostn, unsigned short port, bool udp, bool ipv6,
+    SocketState& state)
+{
+    SocketOptions options;
+    options.noDelay = false;
+    return connectSocket (hostn, port, udp, ipv6, state, options);
+}
+
+
+namespace
+{
+
+struct dns_cache_entry
+{
+    std::chrono::steady_clock::time_point resolved;
+    std::shared_ptr<resolved_addresses const> addrs;
+};
+
+
+typedef std::tuple<tstring, unsigned short, bool, bool> dns_cache_key;
+
+
+struct dns_cache
+{
+    std::mutex mtx;
+    std::map<dns_cache_key, dns_cache_entry> entries;
+};
+
+
+dns_cache &
+get_dns_cache ()
+{
+    static dns_cache cache;
+    return cache;
+}
+
+} // namespace
+
+
+std::shared_ptr<resolved_addresses const>
+find_resolved_addresses (tstring const & host, unsigned short port, bool udp,
+    bool ipv6, unsigned ttl)
+{
+    dns_cache & cache = get_dns_cache ();
+    std::lock_guard guard (cache.mtx);
+    auto it = cache.entries.find (dns_cache_key (host, port, udp, ipv6));
+    if (it == cache.entries.end ())
+        return nullptr;
+
+    if (std::chrono::steady_clock::now () - it->second.resolved
+        >= std::chrono::milliseconds (ttl))
+    {
+        cache.entries.erase (it);
+        return nullptr;
+    }
+
+    return it->second.addrs;
+}
+
+
+void
+store_resolved_addresses (tstring const & host, unsigned short port, bool udp,
+    bool ipv6, std::shared_ptr<resolved_addresses const> addrs)
+{
+    dns_cache & cache = get_dns_cache ();
+    std::lock_guard guard (cache.mtx);
+    cache.entries[dns_cache_key (host, port, udp, ipv6)]
+        = dns_cache_entry {std::chrono::steady_clock::now (),
+            std::move (addrs)};
+}
+
+
+void
+clearDnsCache ()
+{
+    dns_cache & cache = get_dns_cache ();
+    std::lock_guard guard (cache.mtx);
+    cache.entries.clear ();
+}
+
+
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 CATCH_TEST_CASE ("Socket", "[sockets]")
 {
@@ -283,6 +529,103 @@ CATCH_TEST_CASE ("Socket", "[sockets]")
             CATCH_REQUIRE (result.has_value ());
         }
     }
+
+    CATCH_SECTION ("DNS cache")
+    {
+        clearDnsCache ();
+        tstring const host (LOG4CPLUS_TEXT ("localhost"));
+        SocketOptions options;
+        options.dnsCacheTtl = 60 * 1000;
+
+        // Name is cached even when nobody listens on the port.
+        Socket (host, 1, false, false, options);
+        auto addrs = find_resolved_addresses (host, 1, false, false,
+            options.dnsCacheTtl);
+        CATCH_REQUIRE (addrs);
+        CATCH_REQUIRE (! addrs->empty ());
+        CATCH_REQUIRE (! find_resolved_addresses (host, 2, false, false,
+                options.dnsCacheTtl));
+        CATCH_REQUIRE (! find_resolved_addresses (host, 1, false, false, 0));
+
+        // Expired entry is resolved again.
+        Socket (host, 1, false, false, options);
+        CATCH_REQUIRE (find_resolved_addresses (host, 1, false, false,
+                options.dnsCacheTtl));
+        clearDnsCache ();
+    }
+
+    CATCH_SECTION ("local socket host")
+    {
+        tstring path;
+        CATCH_REQUIRE (parseUnixSocketHost (
+                LOG4CPLUS_TEXT ("unix:///run/log.sock"), path));
+        CATCH_REQUIRE (path == LOG4CPLUS_TEXT ("/run/log.sock"));
+        CATCH_REQUIRE (! parseUnixSocketHost (LOG4CPLUS_TEXT ("unix://"),
+                path));
+        CATCH_REQUIRE (! parseUnixSocketHost (LOG4CPLUS_TEXT ("localhost"),
+                path));
+    }
+
+    CATCH_SECTION ("batch of UDP datagrams")
+    {
+        // Batches go through sendmmsg() or Registered I/O where built.
+        unsigned short const port = 29524;
+        SocketState state = not_opened;
+        Socket server (openSocket (LOG4CPLUS_TEXT ("localhost"), port, true,
+                false, state), state, 0);
+        CATCH_REQUIRE (server.isOpen ());
+
+        Socket client (LOG4CPLUS_TEXT ("localhost"), port, true, false);
+        CATCH_REQUIRE (client.isOpen ());
+        std::string_view const datagrams[] { "a", "bb", "ccc" };
+        CATCH_REQUIRE (client.writeDatagrams (datagrams));
+
+        char buffer[16];
+        for (std::string_view const & datagram : datagrams)
+        {
+            std::size_t const size = server.readSome (buffer, sizeof (buffer));
+            CATCH_REQUIRE (std::string_view (buffer, size) == datagram);
+        }
+    }
+
+#if ! defined (_WIN32)
+    CATCH_SECTION ("local stream socket")
+    {
+        tstring const host (
+            LOG4CPLUS_TEXT ("unix://log4cplus-socket-test.sock"));
+        ServerSocket server (0, false, false, host);
+        CATCH_REQUIRE (server.isOpen ());
+
+        Socket client (host, 0);
+        CATCH_REQUIRE (client.isOpen ());
+        Socket accepted = server.accept ();
+        CATCH_REQUIRE (accepted.isOpen ());
+
+        CATCH_REQUIRE (client.write (std::string ("event")));
+        SocketBuffer buffer (5);
+        CATCH_REQUIRE (accepted.read (buffer));
+        CATCH_REQUIRE (std::string (buffer.getBuffer (), 5) == "event");
+        std::remove ("log4cplus-socket-test.sock");
+    }
+#endif
+
+#if defined (__linux__)
+    CATCH_SECTION ("abstract datagram socket")
+    {
+        tstring const path (LOG4CPLUS_TEXT ("@log4cplus-socket-test"));
+        SocketState state = not_opened;
+        Socket server (openUnixSocket (path, true, state), state, 0);
+        CATCH_REQUIRE (server.isOpen ());
+
+        Socket client (LOG4CPLUS_TEXT ("unix://") + path, 0, true, false);
+        CATCH_REQUIRE (client.isOpen ());
+        CATCH_REQUIRE (client.write (std::string ("event")));
+
+        char buffer[16];
+        CATCH_REQUIRE (server.readSome (buffer, sizeof (buffer)) == 5);
+        CATCH_REQUIRE (std::string (buffer, 5) == "event");
+    }
+#endif
 }
 #endif // LOG4CPLUS_WITH_UNIT_TESTS
 
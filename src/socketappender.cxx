@@ -18,22 +18,72 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <stdexcept>
 #include <log4cplus/socketappender.h>
+#include <log4cplus/fstreams.h>
 #include <log4cplus/layout.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
 #include <log4cplus/internal/internal.h>
 
+#if defined (LOG4CPLUS_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#endif
+
 
 namespace log4cplus {
 
 int const LOG4CPLUS_MESSAGE_VERSION = 3;
 
 
+#if defined (LOG4CPLUS_WITH_ZSTD)
+namespace internal {
+
+//! Compresses batches of one SocketAppender.
+struct socket_compressor
+{
+    std::unique_ptr<ZSTD_CCtx, std::size_t (*) (ZSTD_CCtx *)> cctx {
+        ZSTD_createCCtx (), &ZSTD_freeCCtx};
+};
+
+
+//! Decompresses batches received over one connection.
+struct socket_decompressor
+{
+    std::unique_ptr<ZSTD_DCtx, std::size_t (*) (ZSTD_DCtx *)> dctx {
+        ZSTD_createDCtx (), &ZSTD_freeDCtx};
+};
+
+} // namespace internal
+#endif
+
+
+namespace
+{
+
+//! Spool limit while the first connection is being made, see
+//! <tt>AsyncConnect</tt>.
+std::size_t const pending_connect_spool_size = 1024 * 1024;
+
+} // namespace
+
+
 //////////////////////////////////////////////////////////////////////////////
 // SocketAppender ctors and dtor
 //////////////////////////////////////////////////////////////////////////////
@@ -45,7 +95,8 @@ SocketAppender::SocketAppender(const tstring& host_,
     , serverName(serverName_)
     , ipv6(ipv6_)
 {
-    openSocket();
+    if (! asyncConnect)
+        openSocket();
     initConnector ();
 }
 
@@ -59,9 +110,43 @@ SocketAppender::SocketAppender(const helpers::Properties & properties)
     properties.getUInt (port, LOG4CPLUS_TEXT("port"));
     serverName = properties.getProperty( LOG4CPLUS_TEXT("ServerName") );
     properties.getBool(ipv6, LOG4CPLUS_TEXT("IPv6"));
+    properties.getBool (asyncConnect, LOG4CPLUS_TEXT("AsyncConnect"));
+    properties.getUInt (reconnectDelay, LOG4CPLUS_TEXT("ReconnectDelayMs"));
+    properties.getUInt (reconnectMaxDelay,
+        LOG4CPLUS_TEXT("ReconnectMaxDelayMs"));
+    properties.getBool (socketOptions.noDelay, LOG4CPLUS_TEXT("TcpNoDelay"));
+    unsigned long sendBufferSize = 0;
+    properties.getULong (sendBufferSize, LOG4CPLUS_TEXT("SendBufferSize"));
+    socketOptions.sendBufferSize = sendBufferSize;
+    properties.getBool (socketOptions.keepAlive, LOG4CPLUS_TEXT("KeepAlive"));
+    properties.getUInt (socketOptions.keepAliveIdle,
+        LOG4CPLUS_TEXT("KeepAliveIdle"));
+    properties.getUInt (socketOptions.keepAliveInterval,
+        LOG4CPLUS_TEXT("KeepAliveInterval"));
+    properties.getUInt (socketOptions.keepAliveCount,
+        LOG4CPLUS_TEXT("KeepAliveCount"));
+    properties.getUInt (socketOptions.dnsCacheTtl,
+        LOG4CPLUS_TEXT("DnsCacheTtlMs"));
+    properties.getULong (batchSize, LOG4CPLUS_TEXT("BatchSize"));
+    properties.getULong (batchEvents, LOG4CPLUS_TEXT("BatchEvents"));
+    properties.getULong (batchInterval, LOG4CPLUS_TEXT("BatchIntervalMs"));
+    properties.getULong (spoolSize, LOG4CPLUS_TEXT("SpoolSize"));
+    spoolFile = properties.getProperty (LOG4CPLUS_TEXT("SpoolFile"));
+    properties.getUInt (wireFormat, LOG4CPLUS_TEXT("WireFormat"));
+    if (wireFormat != 1 && wireFormat != 2)
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("SocketAppender- Unknown WireFormat, using 1"));
+        wireFormat = 1;
+    }
 
-    openSocket();
+    initEndpoints (properties);
+    initTls (properties);
+    initCompression (properties);
+    if (! asyncConnect)
+        openSocket();
     initConnector ();
+    initBatching ();
 }
 
 
@@ -84,14 +169,55 @@ SocketAppender::close()
         LOG4CPLUS_TEXT("Entering SocketAppender::close()..."));
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    connector->terminate ();
+    // This has to be done before locking access_mutex; the timer thread
+    // locks it while holding its own mutex.
+    if (batchTimerRegistered)
+    {
+        internal::remove_timer (this);
+        batchTimerRegistered = false;
+    }
+
+    if (!! connector)
+        connector->terminate ();
+
+    for (auto & endpoint : endpoints)
+        endpoint->connector->terminate ();
+#endif
+
+    thread::MutexGuard guard (access_mutex);
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // The connector threads can be terminated before their first
+    // attempt. Events appended during startup get one chance.
+    if (pendingConnects.load () != 0
+        && (! sendBuffer.empty () || ! spool.empty () || spoolFileUsed))
+    {
+        openSocket ();
+        connected = socket.isOpen ();
+        for (auto & endpoint : endpoints)
+            endpoint->connected = endpoint->socket.isOpen ();
+        pendingConnects = 0;
+    }
 #endif
 
+    flushBatch ();
+    // Keep what could not be sent for the next run.
+    if (! spool.empty () && ! spoolFile.empty ())
+        spillSpool ();
+
     socket.close();
+    for (auto & endpoint : endpoints)
+        endpoint->socket.close ();
     closed = true;
 }
 
 
+unsigned
+SocketAppender::getRequiredEventFields() const
+{
+    return spi::EVENT_FIELDS_ALL;
+}
+
+
 
 //////////////////////////////////////////////////////////////////////////////
 // SocketAppender protected methods
@@ -100,9 +226,223 @@ SocketAppender::close()
 void
 SocketAppender::openSocket()
 {
+    if (! endpoints.empty ())
+    {
+        for (auto & endpoint : endpoints)
+            if (! endpoint->socket.isOpen ())
+                endpoint->socket = connectServer (endpoint->host,
+                    endpoint->port, endpoint->tlsContext.get ());
+
+        return;
+    }
+
     if(!socket.isOpen()) {
-        socket = helpers::Socket(host, static_cast<unsigned short>(port), false, ipv6);
+        socket = connectServer();
+    }
+}
+
+
+helpers::Socket
+SocketAppender::connectServer()
+{
+    return connectServer (host, port, tlsContext.get ());
+}
+
+
+helpers::Socket
+SocketAppender::connectServer(tstring const & serverHost,
+    unsigned int serverPort, helpers::TlsContext * context)
+{
+    // Never fall back to plain text connection.
+    if (useTls && ! context)
+        return helpers::Socket ();
+
+    helpers::Socket sock (serverHost, static_cast<unsigned short>(serverPort),
+        false, ipv6, socketOptions);
+    if (context && sock.isOpen () && ! sock.startTls (*context))
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("SocketAppender- TLS handshake with ")
+            + serverHost + LOG4CPLUS_TEXT (" failed"));
+
+    return sock;
+}
+
+
+void
+SocketAppender::initEndpoints (helpers::Properties const & properties)
+{
+    tstring const & list = properties.getProperty (
+        LOG4CPLUS_TEXT("Endpoints"));
+    if (list.empty ())
+        return;
+
+    tstring stripped;
+    std::remove_copy_if (list.begin (), list.end (),
+        std::back_inserter (stripped),
+        [](tchar const ch) -> bool { return ch == LOG4CPLUS_TEXT(' '); });
+
+    std::vector<tstring> entries;
+    helpers::tokenize (stripped, LOG4CPLUS_TEXT(','),
+        std::back_inserter (entries), true);
+    for (tstring const & entry : entries)
+    {
+        // Local sockets have no port.
+        tstring path;
+        if (helpers::parseUnixSocketHost (entry, path))
+        {
+            endpoints.push_back (
+                std::make_unique<Endpoint> (*this, entry, port));
+            continue;
+        }
+
+        // IPv6 addresses are written in brackets, "[::1]:9998".
+        tstring::size_type const bracket = entry.rfind (LOG4CPLUS_TEXT(']'));
+        tstring::size_type const colon = entry.rfind (LOG4CPLUS_TEXT(':'));
+        bool const hasPort = colon != tstring::npos
+            && (bracket == tstring::npos ? entry.find (LOG4CPLUS_TEXT(':'))
+                == colon : colon > bracket);
+
+        tstring entryHost = hasPort ? entry.substr (0, colon) : entry;
+        unsigned int entryPort = port;
+        if (hasPort)
+        {
+            tstring const portStr = entry.substr (colon + 1);
+            bool valid = ! portStr.empty ();
+            entryPort = 0;
+            for (tchar ch : portStr)
+            {
+                if (ch < LOG4CPLUS_TEXT('0') || ch > LOG4CPLUS_TEXT('9')
+                    || entryPort > 65535)
+                {
+                    valid = false;
+                    break;
+                }
+
+                entryPort = entryPort * 10 + (ch - LOG4CPLUS_TEXT('0'));
+            }
+
+            if (! valid || entryPort == 0 || entryPort > 65535)
+            {
+                helpers::getLogLog ().error (
+                    LOG4CPLUS_TEXT ("SocketAppender- Invalid endpoint: ")
+                    + entry);
+                continue;
+            }
+        }
+
+        if (entryHost.size () >= 2
+            && entryHost.front () == LOG4CPLUS_TEXT('[')
+            && entryHost.back () == LOG4CPLUS_TEXT(']'))
+            entryHost = entryHost.substr (1, entryHost.size () - 2);
+
+        endpoints.push_back (
+            std::make_unique<Endpoint> (*this, entryHost, entryPort));
+    }
+
+    tstring const & balancing = properties.getProperty (
+        LOG4CPLUS_TEXT("LoadBalancing"));
+    if (balancing == LOG4CPLUS_TEXT("LeastOutstanding"))
+        leastOutstanding = true;
+    else if (! balancing.empty ()
+        && balancing != LOG4CPLUS_TEXT("RoundRobin"))
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("SocketAppender- Unknown LoadBalancing: ")
+            + balancing + LOG4CPLUS_TEXT (", using RoundRobin"));
+}
+
+
+void
+SocketAppender::initTls (helpers::Properties const & properties)
+{
+    properties.getBool (useTls, LOG4CPLUS_TEXT("Tls"));
+    if (! useTls)
+        return;
+
+    helpers::TlsConfig config;
+    config.caFile = properties.getProperty (LOG4CPLUS_TEXT("TlsCAFile"));
+    config.certFile = properties.getProperty (LOG4CPLUS_TEXT("TlsCertFile"));
+    config.keyFile = properties.getProperty (LOG4CPLUS_TEXT("TlsKeyFile"));
+    config.serverName = properties.getProperty (
+        LOG4CPLUS_TEXT("TlsServerName"), host);
+    properties.getBool (config.verifyPeer, LOG4CPLUS_TEXT("TlsVerifyPeer"));
+    properties.getBool (config.kernelOffload,
+        LOG4CPLUS_TEXT("TlsKernelOffload"));
+
+    tlsContext = helpers::createTlsContext (config);
+    if (! tlsContext)
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("SocketAppender- TLS is not available,")
+            LOG4CPLUS_TEXT (" events will not be sent"));
+
+    // Sessions are resumed per server.
+    bool const commonName = properties.exists (LOG4CPLUS_TEXT("TlsServerName"));
+    for (auto & endpoint : endpoints)
+    {
+        if (! commonName)
+            config.serverName = endpoint->host;
+
+        endpoint->tlsContext = helpers::createTlsContext (config);
+    }
+}
+
+
+void
+SocketAppender::initCompression (helpers::Properties const & properties)
+{
+    tstring const compressionName = helpers::toLower (
+        properties.getProperty (LOG4CPLUS_TEXT ("Compression")));
+    if (compressionName.empty ()
+        || compressionName == LOG4CPLUS_TEXT ("none"))
+        return;
+
+    if (compressionName != LOG4CPLUS_TEXT ("zstd"))
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("Unknown Compression property value: ")
+            + compressionName);
+        return;
+    }
+
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    int level = 1;
+    properties.getInt (level, LOG4CPLUS_TEXT ("CompressionLevel"));
+    auto newCompressor = std::make_shared<internal::socket_compressor> ();
+    ZSTD_CCtx * const cctx = newCompressor->cctx.get ();
+    if (! cctx || ZSTD_isError (ZSTD_CCtx_setParameter (cctx,
+                ZSTD_c_compressionLevel, level)))
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("SocketAppender- Unable to set up compression"));
+        return;
+    }
+
+    tstring const dictionaryFile
+        = properties.getProperty (LOG4CPLUS_TEXT ("CompressionDictionary"));
+    if (! dictionaryFile.empty ())
+    {
+        std::ifstream in (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (dictionaryFile)
+            .c_str (), std::ios_base::binary);
+        std::string const dictionary {std::istreambuf_iterator<char> (in),
+            std::istreambuf_iterator<char> ()};
+        if (dictionary.empty ()
+            || ZSTD_isError (ZSTD_CCtx_loadDictionary (cctx,
+                    dictionary.data (), dictionary.size ())))
+        {
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("SocketAppender- Unable to load")
+                LOG4CPLUS_TEXT (" compression dictionary ")
+                + dictionaryFile);
+            return;
+        }
     }
+
+    compressor = std::move (newCompressor);
+
+#else
+    helpers::getLogLog ().warn (
+        LOG4CPLUS_TEXT ("zstd compression is not available"));
+
+#endif
 }
 
 
@@ -110,21 +450,110 @@ void
 SocketAppender::initConnector ()
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    connected = true;
+    if (! endpoints.empty ())
+    {
+        connected = true;
+        for (auto & endpoint : endpoints)
+        {
+            endpoint->connected = endpoint->socket.isOpen ();
+            endpoint->connectPending = asyncConnect && ! endpoint->connected;
+            if (endpoint->connectPending)
+                ++pendingConnects;
+            endpoint->connector = new helpers::ConnectorThread (*endpoint);
+            endpoint->connector->setReconnectBackoff (endpoint->host
+                + LOG4CPLUS_TEXT (":")
+                + helpers::convertIntegerToString (endpoint->port),
+                reconnectDelay, reconnectMaxDelay);
+            endpoint->connector->start ();
+            if (! endpoint->connected)
+                endpoint->connector->trigger ();
+        }
+
+        return;
+    }
+
+    // A failed synchronous connection is found out by the first write.
+    connected = socket.isOpen () || ! asyncConnect;
+    connectPending = ! connected;
+    if (connectPending)
+        ++pendingConnects;
     connector = new helpers::ConnectorThread (*this);
+    connector->setReconnectBackoff (host + LOG4CPLUS_TEXT (":")
+        + helpers::convertIntegerToString (port),
+        reconnectDelay, reconnectMaxDelay);
     connector->start ();
+    if (connectPending)
+        connector->trigger ();
 #endif
 }
 
 
 void
-SocketAppender::append(const spi::InternalLoggingEvent& event)
+SocketAppender::initBatching ()
+{
+    if (! spoolFile.empty ())
+    {
+        // Events spooled by previous run are replayed first.
+        std::ifstream in (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (spoolFile)
+            .c_str (), std::ios_base::binary | std::ios_base::ate);
+        spoolFileUsed = in && in.tellg () > 0;
+    }
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (batchInterval != 0)
+    {
+        internal::add_timer (this,
+            std::chrono::milliseconds (batchInterval),
+            [this]
+            {
+                thread::MutexGuard guard (access_mutex);
+                flushBatch ();
+            });
+        batchTimerRegistered = true;
+    }
+#endif
+}
+
+
+bool
+SocketAppender::ensureConnected()
 {
+    if (! endpoints.empty ())
+    {
+        auto const usable = [this]
+        {
+            return std::any_of (endpoints.begin (), endpoints.end (),
+                [this](std::unique_ptr<Endpoint> const & endpoint)
+                { return isUsable (*endpoint); });
+        };
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        for (auto & endpoint : endpoints)
+            if (! endpoint->connected)
+                endpoint->connector->trigger ();
+
+        return usable ();
+
+#else
+        if (usable ())
+            return true;
+
+        openSocket ();
+        if (usable ())
+            return true;
+
+        helpers::getLogLog().error(
+            LOG4CPLUS_TEXT(
+                "SocketAppender::append()- Cannot connect to any endpoint"));
+        return false;
+#endif
+    }
+
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
     if (! connected)
     {
         connector->trigger ();
-        return;
+        return false;
     }
 
 #else
@@ -134,117 +563,552 @@ SocketAppender::append(const spi::InternalLoggingEvent& event)
             helpers::getLogLog().error(
                 LOG4CPLUS_TEXT(
                     "SocketAppender::append()- Cannot connect to server"));
-            return;
+            return false;
         }
     }
 #endif
 
+    return true;
+}
+
+
+bool
+SocketAppender::appendFrame(const spi::InternalLoggingEvent& event)
+{
+    if (wireFormat == 2)
+    {
+        // Events spooled while disconnected must not depend on names
+        // sent over the lost connection.
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        bool const useDictionary = endpoints.empty () && connected;
+#else
+        bool const useDictionary = endpoints.empty () && socket.isOpen ();
+#endif
+        encoder.encode (sendBuffer, event, serverName, useDictionary);
+        ++sendBufferEvents;
+        return true;
+    }
+
     helpers::SocketBuffer msgBuffer(LOG4CPLUS_MAX_MESSAGE_SIZE
         - sizeof (unsigned int));
-
     try
     {
         convertToBuffer (msgBuffer, event, serverName);
     }
     catch (std::runtime_error const &)
     {
-        return;
+        return false;
     }
 
-    helpers::SocketBuffer buffer(sizeof(unsigned int));
-    buffer.appendInt(static_cast<unsigned>(msgBuffer.getSize()));
+    helpers::SocketBuffer sizeBuffer(sizeof(unsigned int));
+    sizeBuffer.appendInt(static_cast<unsigned>(msgBuffer.getSize()));
+
+    sendBuffer.append (sizeBuffer.getBuffer (), sizeBuffer.getSize ());
+    sendBuffer.append (msgBuffer.getBuffer (), msgBuffer.getSize ());
+    ++sendBufferEvents;
+    return true;
+}
+
+
+bool
+SocketAppender::batchFull() const
+{
+    // Size of the batch after which accumulated messages are written
+    // when BatchSize is not set.
+    std::size_t const batch_write_threshold = 64 * 1024;
+
+    return sendBuffer.size ()
+            >= (batchSize != 0 ? batchSize : batch_write_threshold)
+        || (batchEvents != 0 && sendBufferEvents >= batchEvents);
+}
+
+
+void
+SocketAppender::flushBatch()
+{
+    if (sendBuffer.empty () && spool.empty () && ! spoolFileUsed)
+        return;
+
+    std::string frames;
+    frames.swap (sendBuffer);
+    sendBufferEvents = 0;
 
-    bool ret = helpers::Socket::write(socket, buffer, msgBuffer);
-    if (! ret)
+    if (ensureConnected () && replaySpool ()
+        && (frames.empty () || writeFrames (frames)))
     {
-        helpers::getLogLog().error(
-            LOG4CPLUS_TEXT(
-                "SocketAppender::append()- Write failed"));
+        // Reuse the allocation.
+        frames.clear ();
+        frames.swap (sendBuffer);
+        return;
+    }
 
-#if ! defined (LOG4CPLUS_SINGLE_THREADED)
-        connected = false;
-        connector->trigger ();
-#endif
+    if (wireFormat == 2)
+    {
+        // Names of spooled events have to be defined again on the next
+        // connection, which starts with empty dictionary.
+        if (! frames.empty ())
+        {
+            std::string dictionary;
+            encoder.encodeDictionary (dictionary);
+            frames.insert (0, dictionary);
+        }
+
+        encoder.reset ();
     }
+
+    spoolFrames (std::move (frames));
 }
 
 
-#if ! defined (LOG4CPLUS_SINGLE_THREADED)
-thread::Mutex const &
-SocketAppender::ctcGetAccessMutex () const
+bool
+SocketAppender::writeFrames(const std::string& frames)
 {
-    return access_mutex;
+    std::string_view const view (frames);
+    return writeFrames (std::span<std::string_view const> (&view, 1));
 }
 
 
-helpers::Socket &
-SocketAppender::ctcGetSocket ()
+bool
+SocketAppender::writeFrames(std::span<std::string_view const> frames)
 {
-    return socket;
+    std::string_view compressed;
+    if (compressor)
+    {
+        compressedFrames.clear ();
+        if (helpers::SocketMessageEncoder::encodeCompressed (
+                compressedFrames, frames, *compressor))
+        {
+            compressed = compressedFrames;
+            frames = std::span<std::string_view const> (&compressed, 1);
+        }
+        else
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("SocketAppender- Compression failed,")
+                LOG4CPLUS_TEXT (" sending batch uncompressed"));
+    }
+
+    if (! endpoints.empty ())
+    {
+        // Fail over to the remaining connected servers.
+        while (Endpoint * endpoint = selectEndpoint ())
+        {
+            if (endpoint->socket.write (frames))
+                return true;
+
+            endpointFailed (*endpoint);
+        }
+
+        return false;
+    }
+
+    if (socket.write (frames))
+        return true;
+
+    helpers::getLogLog().error(
+        LOG4CPLUS_TEXT("SocketAppender::append()- Write failed"));
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    connected = false;
+    connector->trigger ();
+#else
+    socket.close ();
+#endif
+
+    return false;
 }
 
 
-helpers::Socket
-SocketAppender::ctcConnect ()
+bool
+SocketAppender::isUsable (Endpoint const & endpoint) const
 {
-    return helpers::Socket (host, static_cast<unsigned short>(port));
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    return endpoint.connected;
+#else
+    return endpoint.socket.isOpen ();
+#endif
 }
 
-void
-SocketAppender::ctcSetConnected ()
+
+SocketAppender::Endpoint *
+SocketAppender::selectEndpoint ()
 {
-    connected = true;
-}
+    std::size_t const count = endpoints.size ();
+    std::size_t selected = count;
+    std::size_t leastUnsent = 0;
+    // Candidates are visited starting after the last used one so that
+    // ties are also spread evenly.
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        std::size_t const index = (nextEndpoint + i) % count;
+        Endpoint & endpoint = *endpoints[index];
+        if (! isUsable (endpoint))
+            continue;
 
-#endif
+        if (! leastOutstanding)
+        {
+            selected = index;
+            break;
+        }
 
+        std::size_t const unsent = endpoint.socket.getUnsentBytes ();
+        if (selected == count || unsent < leastUnsent)
+        {
+            selected = index;
+            leastUnsent = unsent;
+        }
+    }
 
-/////////////////////////////////////////////////////////////////////////////
-// namespace helpers methods
-/////////////////////////////////////////////////////////////////////////////
+    if (selected == count)
+        return nullptr;
 
-namespace helpers
-{
+    nextEndpoint = (selected + 1) % count;
+    return endpoints[selected].get ();
+}
 
 
 void
-convertToBuffer(SocketBuffer & buffer,
-    const spi::InternalLoggingEvent& event,
-    const tstring& serverName)
+SocketAppender::endpointFailed (Endpoint & endpoint)
 {
-    buffer.appendByte(LOG4CPLUS_MESSAGE_VERSION);
-#ifndef UNICODE
-    buffer.appendByte(1);
+    helpers::getLogLog().error(
+        LOG4CPLUS_TEXT("SocketAppender::append()- Write to ")
+        + endpoint.host + LOG4CPLUS_TEXT(" failed"));
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    endpoint.connected = false;
+    endpoint.connector->trigger ();
 #else
-    buffer.appendByte(2);
+    endpoint.socket.close ();
 #endif
-
-    buffer.appendString(serverName);
-    buffer.appendString(event.getLoggerName());
-    buffer.appendInt(event.getLogLevel());
-    buffer.appendString(event.getNDC());
-    buffer.appendString(event.getMessage());
-    buffer.appendString(event.getThread());
-    buffer.appendInt(
-        static_cast<unsigned int>(to_time_t (event.getTimestamp())));
-    buffer.appendInt(
-        static_cast<unsigned int>(microseconds_part(event.getTimestamp())));
-    buffer.appendString(event.getFile());
-    buffer.appendInt(event.getLine());
-    buffer.appendString(event.getFunction());
 }
 
 
-spi::InternalLoggingEvent
-readFromBuffer(SocketBuffer& buffer)
+bool
+SocketAppender::replaySpool()
 {
-    unsigned char msgVersion = buffer.readByte();
-    if(msgVersion != LOG4CPLUS_MESSAGE_VERSION) {
-        LogLog * loglog = LogLog::getLogLog();
-        loglog->warn(LOG4CPLUS_TEXT("readFromBuffer() received socket message with an invalid version"));
-    }
+    if (spoolFileUsed)
+    {
+        std::string contents;
+        {
+            std::ifstream in (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (spoolFile)
+                .c_str (), std::ios_base::binary);
+            contents.assign (std::istreambuf_iterator<char> (in),
+                std::istreambuf_iterator<char> ());
+        }
 
-    unsigned char sizeOfChar = buffer.readByte();
+        if (! contents.empty () && ! writeFrames (contents))
+            return false;
+
+        std::ofstream out (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (spoolFile)
+            .c_str (), std::ios_base::binary | std::ios_base::trunc);
+        spoolFileUsed = false;
+    }
+
+    while (! spool.empty ())
+    {
+        // Send several spooled batches with each system call.
+        std::string_view batches[16];
+        std::size_t count = 0;
+        for (auto it = spool.begin (); it != spool.end () && count != 16;
+             ++it)
+            batches[count++] = *it;
+
+        if (! writeFrames (
+                std::span<std::string_view const> (batches, count)))
+            return false;
+
+        for (; count != 0; --count)
+        {
+            spoolBytes -= spool.front ().size ();
+            spool.pop_front ();
+        }
+    }
+
+    if (spoolDropped != 0)
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("SocketAppender- Dropped ")
+            + helpers::convertIntegerToString (spoolDropped)
+            + LOG4CPLUS_TEXT (" bytes of events while disconnected"));
+        spoolDropped = 0;
+    }
+
+    return true;
+}
+
+
+bool
+SocketAppender::spooling() const
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (pendingConnects.load () != 0)
+        return true;
+#endif
+
+    return spoolSize != 0 || ! spoolFile.empty ();
+}
+
+
+void
+SocketAppender::spoolFrames(std::string && frames)
+{
+    if (frames.empty ())
+        return;
+
+    spoolBytes += frames.size ();
+    spool.push_back (std::move (frames));
+
+    std::size_t limit = spoolSize;
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // Events appended before the first connection is made are not
+    // dropped right away.
+    if (pendingConnects.load () != 0)
+        limit = (std::max<std::size_t>) (limit, pending_connect_spool_size);
+#endif
+
+    if (spoolBytes > limit && ! spoolFile.empty () && spillSpool ())
+        return;
+
+    // Drop the oldest events.
+    while (spoolBytes > limit)
+    {
+        spoolBytes -= spool.front ().size ();
+        spoolDropped += spool.front ().size ();
+        spool.pop_front ();
+    }
+}
+
+
+bool
+SocketAppender::spillSpool()
+{
+    std::ofstream out (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (spoolFile)
+        .c_str (), std::ios_base::binary | std::ios_base::app);
+    for (std::string const & frames : spool)
+        out.write (frames.data (),
+            static_cast<std::streamsize>(frames.size ()));
+
+    out.close ();
+    if (! out)
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to write spool file: ") + spoolFile);
+        return false;
+    }
+
+    spoolFileUsed = true;
+    spool.clear ();
+    spoolBytes = 0;
+    return true;
+}
+
+
+void
+SocketAppender::append(const spi::InternalLoggingEvent& event)
+{
+    // Without spool, events are not even serialized while disconnected.
+    if (! spooling () && ! ensureConnected ())
+        return;
+
+    bool const batching = batchSize != 0 || batchEvents != 0
+        || batchInterval != 0;
+    if (! batching && wireFormat == 1 && sendBuffer.empty ()
+        && spool.empty () && ! spoolFileUsed && ensureConnected ())
+    {
+        // Nothing is queued, send the length prefix and the message
+        // with single gather write instead of concatenating them.
+        helpers::SocketBuffer msgBuffer(LOG4CPLUS_MAX_MESSAGE_SIZE
+            - sizeof (unsigned int));
+        try
+        {
+            convertToBuffer (msgBuffer, event, serverName);
+        }
+        catch (std::runtime_error const &)
+        {
+            return;
+        }
+
+        helpers::SocketBuffer sizeBuffer(sizeof(unsigned int));
+        sizeBuffer.appendInt(static_cast<unsigned>(msgBuffer.getSize()));
+
+        std::string_view const frame[2] {
+            {sizeBuffer.getBuffer (), sizeBuffer.getSize ()},
+            {msgBuffer.getBuffer (), msgBuffer.getSize ()}};
+        if (writeFrames (frame))
+            return;
+
+        sendBuffer.append (frame[0]);
+        sendBuffer.append (frame[1]);
+        ++sendBufferEvents;
+        flushBatch ();
+        return;
+    }
+
+    if (! appendFrame (event))
+        return;
+
+    if (! batching || batchFull ())
+        flushBatch ();
+}
+
+
+void
+SocketAppender::appendBatch(
+    std::span<spi::InternalLoggingEvent const> events)
+{
+    if (! spooling () && ! ensureConnected ())
+        return;
+
+    for (auto const & event : events)
+        if (appendFrame (event) && batchFull ())
+            flushBatch ();
+
+    bool const batching = batchSize != 0 || batchEvents != 0
+        || batchInterval != 0;
+    if (! batching)
+        flushBatch ();
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+thread::Mutex const &
+SocketAppender::ctcGetAccessMutex () const
+{
+    return access_mutex;
+}
+
+
+helpers::Socket &
+SocketAppender::ctcGetSocket ()
+{
+    return socket;
+}
+
+
+helpers::Socket
+SocketAppender::ctcConnect ()
+{
+    helpers::Socket sock = connectServer ();
+    if (! sock.isOpen ())
+        connectFinished (connectPending);
+    return sock;
+}
+
+void
+SocketAppender::ctcSetConnected ()
+{
+    connected = true;
+    // Called with access_mutex held; replay spooled events right away.
+    if (! spool.empty () || spoolFileUsed)
+        flushBatch ();
+    connectFinished (connectPending);
+}
+
+
+void
+SocketAppender::connectFinished (bool & pending)
+{
+    if (pending)
+    {
+        pending = false;
+        --pendingConnects;
+    }
+}
+
+#endif
+
+
+SocketAppender::Endpoint::Endpoint (SocketAppender & owner_,
+    tstring const & host_, unsigned int port_)
+    : owner (owner_)
+    , host (host_)
+    , port (port_)
+{ }
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+thread::Mutex const &
+SocketAppender::Endpoint::ctcGetAccessMutex () const
+{
+    return owner.access_mutex;
+}
+
+
+helpers::Socket &
+SocketAppender::Endpoint::ctcGetSocket ()
+{
+    return socket;
+}
+
+
+helpers::Socket
+SocketAppender::Endpoint::ctcConnect ()
+{
+    helpers::Socket sock = owner.connectServer (host, port,
+        tlsContext.get ());
+    if (! sock.isOpen ())
+        owner.connectFinished (connectPending);
+    return sock;
+}
+
+
+void
+SocketAppender::Endpoint::ctcSetConnected ()
+{
+    connected = true;
+    if (! owner.spool.empty () || owner.spoolFileUsed)
+        owner.flushBatch ();
+    owner.connectFinished (connectPending);
+}
+
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// namespace helpers methods
+/////////////////////////////////////////////////////////////////////////////
+
+namespace helpers
+{
+
+
+void
+convertToBuffer(SocketBuffer & buffer,
+    const spi::InternalLoggingEvent& event,
+    const tstring& serverName)
+{
+    buffer.appendByte(LOG4CPLUS_MESSAGE_VERSION);
+#ifndef UNICODE
+    buffer.appendByte(1);
+#else
+    buffer.appendByte(2);
+#endif
+
+    buffer.appendString(serverName);
+    buffer.appendString(event.getLoggerName());
+    buffer.appendInt(event.getLogLevel());
+    buffer.appendString(event.getNDC());
+    buffer.appendString(event.getMessage());
+    buffer.appendString(event.getThread());
+    buffer.appendInt(
+        static_cast<unsigned int>(to_time_t (event.getTimestamp())));
+    buffer.appendInt(
+        static_cast<unsigned int>(microseconds_part(event.getTimestamp())));
+    buffer.appendString(event.getFile());
+    buffer.appendInt(event.getLine());
+    buffer.appendString(event.getFunction());
+}
+
+
+spi::InternalLoggingEvent
+readFromBuffer(SocketBuffer& buffer)
+{
+    unsigned char msgVersion = buffer.readByte();
+    if(msgVersion != LOG4CPLUS_MESSAGE_VERSION) {
+        LogLog * loglog = LogLog::getLogLog();
+        loglog->warn(LOG4CPLUS_TEXT("readFromBuffer() received socket message with an invalid version"));
+    }
+
+    unsigned char sizeOfChar = buffer.readByte();
 
     tstring serverName = buffer.readString(sizeOfChar);
     tstring loggerName = buffer.readString(sizeOfChar);
@@ -275,7 +1139,1024 @@ readFromBuffer(SocketBuffer& buffer)
 }
 
 
+namespace
+{
+
+//! Message version byte of wire format 2.
+unsigned char const LOG4CPLUS_COMPACT_MESSAGE_VERSION = 4;
+
+//! Kinds of wire format 2 messages.
+enum compact_message_type { compact_event = 0, compact_dictionary = 1,
+    compact_compressed = 2 };
+
+//! Compressed batch is not decompressed beyond this size.
+std::size_t const max_decompressed_batch_size = 64 * 1024 * 1024;
+
+//! Dictionary is not grown beyond this many names.
+std::size_t const compact_dictionary_limit = 64 * 1024;
+
+
+void
+put_varint (std::string & out, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back (static_cast<char> ((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+
+    out.push_back (static_cast<char> (value));
+}
+
+
+void
+put_zigzag (std::string & out, std::int64_t value)
+{
+    put_varint (out, (static_cast<std::uint64_t> (value) << 1)
+        ^ static_cast<std::uint64_t> (value >> 63));
+}
+
+
+//! Strings are sent with the char size of wire format 1.
+void
+put_string (std::string & out, tstring const & str)
+{
+    put_varint (out, str.size ());
+#ifndef UNICODE
+    out.append (str);
+#else
+    for (tchar ch : str)
+    {
+        out.push_back (static_cast<char> ((ch >> 8) & 0xFF));
+        out.push_back (static_cast<char> (ch & 0xFF));
+    }
+#endif
+}
+
+
+//! Reads wire format 2 message fields. Any malformed input makes the
+//! reader fail; values read afterwards are zero or empty.
+struct compact_reader
+{
+    compact_reader (char const * begin, char const * end_)
+        : p (begin)
+        , end (end_)
+    { }
+
+    std::uint64_t
+    varint ()
+    {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; ok && shift < 64; shift += 7)
+        {
+            if (p == end)
+                break;
+
+            auto const byte = static_cast<unsigned char> (*p++);
+            value |= static_cast<std::uint64_t> (byte & 0x7F) << shift;
+            if (! (byte & 0x80))
+                return value;
+        }
+
+        ok = false;
+        return 0;
+    }
+
+    std::int64_t
+    zigzag ()
+    {
+        std::uint64_t const value = varint ();
+        return static_cast<std::int64_t> (value >> 1)
+            ^ -static_cast<std::int64_t> (value & 1);
+    }
+
+    tstring
+    string (unsigned char sizeOfChar)
+    {
+        std::uint64_t const length = varint ();
+        if (! ok || (sizeOfChar != 1 && sizeOfChar != 2)
+            || length > static_cast<std::uint64_t> (end - p) / sizeOfChar)
+        {
+            ok = false;
+            return tstring ();
+        }
+
+        tstring str;
+        str.reserve (static_cast<std::size_t> (length));
+        for (std::uint64_t i = 0; i != length; ++i)
+        {
+            unsigned ch = static_cast<unsigned char> (*p++);
+            if (sizeOfChar == 2)
+                ch = (ch << 8) | static_cast<unsigned char> (*p++);
+#ifndef UNICODE
+            str.push_back (static_cast<char> (ch < 256 ? ch : ' '));
+#else
+            str.push_back (static_cast<tchar> (ch));
+#endif
+        }
+
+#if defined (UNICODE)
+        if (sizeOfChar == 1)
+            return towstring (LOG4CPLUS_TSTRING_TO_STRING (str));
+#endif
+        return str;
+    }
+
+    //! Reads inline string, dictionary definition or reference.
+    tstring
+    name (std::vector<tstring> & names, unsigned char sizeOfChar)
+    {
+        std::uint64_t const code = varint ();
+        if (code == 0)
+            return string (sizeOfChar);
+
+        std::uint64_t const id = (code - 1) >> 1;
+        if (id >= compact_dictionary_limit)
+        {
+            ok = false;
+            return tstring ();
+        }
+
+        if (code & 1)
+        {
+            if (names.size () <= id)
+                names.resize (static_cast<std::size_t> (id) + 1);
+
+            names[id] = string (sizeOfChar);
+            return names[id];
+        }
+        else if (id < names.size ())
+            return names[id];
+
+        ok = false;
+        return tstring ();
+    }
+
+    char const * p;
+    char const * end;
+    bool ok = true;
+};
+
+} // namespace
+
+
+//////////////////////////////////////////////////////////////////////////////
+// SocketMessageEncoder
+//////////////////////////////////////////////////////////////////////////////
+
+SocketMessageEncoder::SocketMessageEncoder ()
+{ }
+
+
+SocketMessageEncoder::~SocketMessageEncoder ()
+{ }
+
+
+// Names are written as 0 followed by inline string, as 2 * id + 1
+// followed by string that defines entry id, or as 2 * id + 2 which
+// refers to entry id.
+void
+SocketMessageEncoder::appendName (std::string & out, tstring const & name,
+    bool useDictionary)
+{
+    if (useDictionary)
+    {
+        auto it = ids.find (name);
+        if (it != ids.end ())
+        {
+            put_varint (out, 2 * static_cast<std::uint64_t> (it->second) + 2);
+            return;
+        }
+
+        if (names.size () < compact_dictionary_limit)
+        {
+            std::size_t const id = names.size ();
+            it = ids.emplace (name, id).first;
+            names.push_back (&it->first);
+            put_varint (out, 2 * static_cast<std::uint64_t> (id) + 1);
+            put_string (out, name);
+            return;
+        }
+    }
+
+    put_varint (out, 0);
+    put_string (out, name);
+}
+
+
+namespace
+{
+
+//! Starts length prefixed wire format 2 message.
+std::size_t
+begin_compact_message (std::string & out, compact_message_type type)
+{
+    std::size_t const start = out.size ();
+    out.append (sizeof (unsigned int), '\0');
+    out.push_back (static_cast<char> (LOG4CPLUS_COMPACT_MESSAGE_VERSION));
+#ifndef UNICODE
+    out.push_back (1);
+#else
+    out.push_back (2);
+#endif
+    put_varint (out, static_cast<std::uint64_t> (type));
+    return start;
+}
+
+
+//! Fills in the length prefix in network byte order.
+void
+end_compact_message (std::string & out, std::size_t start)
+{
+    auto const size = static_cast<std::uint32_t> (
+        out.size () - start - sizeof (unsigned int));
+    out[start] = static_cast<char> (size >> 24);
+    out[start + 1] = static_cast<char> (size >> 16);
+    out[start + 2] = static_cast<char> (size >> 8);
+    out[start + 3] = static_cast<char> (size);
+}
+
+} // namespace
+
+
+void
+SocketMessageEncoder::encode (std::string & out,
+    spi::InternalLoggingEvent const & event, tstring const & serverName,
+    bool useDictionary)
+{
+    std::size_t const start = begin_compact_message (out, compact_event);
+
+    appendName (out, serverName, useDictionary);
+    appendName (out, event.getLoggerName (), useDictionary);
+    put_zigzag (out, event.getLogLevel ());
+    put_string (out, event.getNDC ());
+
+    MappedDiagnosticContextMap const & mdc = event.getMDCCopy ();
+    put_varint (out, mdc.size ());
+    for (auto const & kv : mdc)
+    {
+        appendName (out, kv.first, useDictionary);
+        put_string (out, kv.second);
+    }
+
+    put_string (out, event.getMessage ());
+    appendName (out, event.getThread (), useDictionary);
+    appendName (out, event.getThread2 (), useDictionary);
+    put_zigzag (out, to_time_t (event.getTimestamp ()));
+    put_varint (out, microseconds_part (event.getTimestamp ()));
+    appendName (out, event.getFile (), useDictionary);
+    put_zigzag (out, event.getLine ());
+    appendName (out, event.getFunction (), useDictionary);
+
+    end_compact_message (out, start);
+}
+
+
+bool
+SocketMessageEncoder::encodeCompressed (std::string & out,
+    std::span<std::string_view const> frames,
+    internal::socket_compressor & compressor)
+{
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    std::size_t total = 0;
+    for (std::string_view const & frame : frames)
+        total += frame.size ();
+
+    ZSTD_CCtx * const cctx = compressor.cctx.get ();
+    ZSTD_CCtx_reset (cctx, ZSTD_reset_session_only);
+    ZSTD_CCtx_setPledgedSrcSize (cctx, total);
+
+    std::size_t const start = begin_compact_message (out, compact_compressed);
+    std::size_t const frameStart = out.size ();
+    out.resize (frameStart + ZSTD_compressBound (total));
+    ZSTD_outBuffer output = {&out[frameStart], out.size () - frameStart, 0};
+
+    std::size_t const count = (std::max<std::size_t>) (frames.size (), 1);
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        bool const last = i + 1 == count;
+        ZSTD_inBuffer input = {
+            frames.empty () ? nullptr : frames[i].data (),
+            frames.empty () ? 0 : frames[i].size (), 0};
+        std::size_t remaining;
+        do
+        {
+            if (output.pos == output.size)
+            {
+                out.resize (out.size () + ZSTD_CStreamOutSize ());
+                output.dst = &out[frameStart];
+                output.size = out.size () - frameStart;
+            }
+
+            remaining = ZSTD_compressStream2 (cctx, &output, &input,
+                last ? ZSTD_e_end : ZSTD_e_continue);
+            if (ZSTD_isError (remaining))
+            {
+                out.resize (start);
+                return false;
+            }
+        }
+        while (input.pos != input.size || (last && remaining != 0));
+    }
+
+    out.resize (frameStart + output.pos);
+    end_compact_message (out, start);
+    return true;
+
+#else
+    (void) out;
+    (void) frames;
+    (void) compressor;
+    return false;
+
+#endif
+}
+
+
+void
+SocketMessageEncoder::encodeDictionary (std::string & out) const
+{
+    if (names.empty ())
+        return;
+
+    std::size_t const start = begin_compact_message (out, compact_dictionary);
+    put_varint (out, names.size ());
+    for (std::size_t id = 0; id != names.size (); ++id)
+    {
+        put_varint (out, 2 * static_cast<std::uint64_t> (id) + 1);
+        put_string (out, *names[id]);
+    }
+
+    end_compact_message (out, start);
+}
+
+
+void
+SocketMessageEncoder::reset ()
+{
+    names.clear ();
+    ids.clear ();
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// SocketMessageDecoder
+//////////////////////////////////////////////////////////////////////////////
+
+SocketMessageDecoder::SocketMessageDecoder ()
+{ }
+
+
+SocketMessageDecoder::~SocketMessageDecoder ()
+{ }
+
+
+bool
+SocketMessageDecoder::decode (SocketBuffer & buffer,
+    spi::InternalLoggingEvent & event)
+{
+    char const * const begin = buffer.getBuffer () + buffer.getPos ();
+    std::size_t const size = buffer.getSize () - buffer.getPos ();
+    if (size != 0 && static_cast<unsigned char> (*begin)
+        != LOG4CPLUS_COMPACT_MESSAGE_VERSION)
+    {
+        event = readFromBuffer (buffer);
+        return true;
+    }
+
+    return decode (begin, size, event);
+}
+
+
+bool
+SocketMessageDecoder::decode (char const * data, std::size_t size,
+    spi::InternalLoggingEvent & event)
+{
+    if (size == 0)
+        return false;
+
+    if (static_cast<unsigned char> (*data)
+        != LOG4CPLUS_COMPACT_MESSAGE_VERSION)
+    {
+        SocketBuffer buffer (size);
+        std::memcpy (buffer.getBuffer (), data, size);
+        buffer.setSize (size);
+        event = readFromBuffer (buffer);
+        return true;
+    }
+
+    compact_reader in (data + 1, data + size);
+    unsigned char const sizeOfChar = in.p != in.end
+        ? static_cast<unsigned char> (*in.p++) : 0;
+    std::uint64_t const type = in.varint ();
+
+    if (in.ok && type == compact_dictionary)
+    {
+        std::uint64_t const count = in.varint ();
+        for (std::uint64_t i = 0; in.ok && i != count; ++i)
+            in.name (names, sizeOfChar);
+
+        if (in.ok)
+            return false;
+    }
+    else if (in.ok && type == compact_event)
+    {
+        tstring const serverName = in.name (names, sizeOfChar);
+        tstring const loggerName = in.name (names, sizeOfChar);
+        auto const ll = static_cast<LogLevel> (in.zigzag ());
+        tstring ndc = in.string (sizeOfChar);
+        if (! serverName.empty ())
+            ndc = ndc.empty () ? serverName
+                : serverName + LOG4CPLUS_TEXT(" - ") + ndc;
+
+        MappedDiagnosticContextMap mdc;
+        std::uint64_t const mdcSize = in.varint ();
+        for (std::uint64_t i = 0; in.ok && i != mdcSize; ++i)
+        {
+            tstring key = in.name (names, sizeOfChar);
+            mdc[std::move (key)] = in.string (sizeOfChar);
+        }
+
+        tstring const message = in.string (sizeOfChar);
+        tstring const thread = in.name (names, sizeOfChar);
+        tstring const thread2 = in.name (names, sizeOfChar);
+        auto const sec = static_cast<time_t> (in.zigzag ());
+        auto const usec = static_cast<long> (in.varint ());
+        tstring const file = in.name (names, sizeOfChar);
+        auto const line = static_cast<int> (in.zigzag ());
+        tstring const function = in.name (names, sizeOfChar);
+
+        if (in.ok)
+        {
+            event = spi::InternalLoggingEvent (loggerName, ll, ndc, mdc,
+                message, thread, thread2,
+                from_time_t (sec) + chrono::microseconds (usec), file, line,
+                function);
+            return true;
+        }
+    }
+
+    else if (in.ok && type == compact_compressed)
+    {
+        getLogLog ().error (
+            LOG4CPLUS_TEXT ("SocketMessageDecoder::decode()- Compressed")
+            LOG4CPLUS_TEXT (" batch carries more than one event"));
+        return false;
+    }
+
+    getLogLog ().error (
+        LOG4CPLUS_TEXT ("SocketMessageDecoder::decode()- Invalid message"));
+    return false;
+}
+
+
+std::size_t
+SocketMessageDecoder::decode (char const * data, std::size_t size,
+    std::vector<spi::InternalLoggingEvent> & events)
+{
+    std::size_t const before = events.size ();
+    if (size > 2 && static_cast<unsigned char> (*data)
+        == LOG4CPLUS_COMPACT_MESSAGE_VERSION)
+    {
+        // Version and size of character precede message type.
+        compact_reader in (data + 2, data + size);
+        if (in.varint () == compact_compressed && in.ok)
+        {
+            std::string batch;
+            if (! decompress (in.p, static_cast<std::size_t> (in.end - in.p),
+                    batch))
+                return 0;
+
+            std::size_t pos = 0;
+            while (batch.size () - pos >= sizeof (unsigned int))
+            {
+                auto const prefix
+                    = reinterpret_cast<unsigned char const *> (&batch[pos]);
+                std::size_t const msgSize = (std::size_t (prefix[0]) << 24)
+                    | (std::size_t (prefix[1]) << 16)
+                    | (std::size_t (prefix[2]) << 8)
+                    | std::size_t (prefix[3]);
+                pos += sizeof (unsigned int);
+                if (batch.size () - pos < msgSize)
+                    break;
+
+                events.emplace_back ();
+                if (! decode (&batch[pos], msgSize, events.back ()))
+                    events.pop_back ();
+                pos += msgSize;
+            }
+
+            if (pos != batch.size ())
+                getLogLog ().error (
+                    LOG4CPLUS_TEXT ("SocketMessageDecoder::decode()-")
+                    LOG4CPLUS_TEXT (" Truncated compressed batch"));
+
+            return events.size () - before;
+        }
+    }
+
+    events.emplace_back ();
+    if (! decode (data, size, events.back ()))
+        events.pop_back ();
+
+    return events.size () - before;
+}
+
+
+void
+SocketMessageDecoder::setCompressionDictionary (std::string const & dictionary)
+{
+    compressionDictionary = dictionary;
+    decompressor.reset ();
+}
+
+
+bool
+SocketMessageDecoder::decompress (char const * data, std::size_t size,
+    std::string & out)
+{
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    if (! decompressor)
+    {
+        auto newDecompressor
+            = std::make_shared<internal::socket_decompressor> ();
+        if (! newDecompressor->dctx
+            || (! compressionDictionary.empty ()
+                && ZSTD_isError (ZSTD_DCtx_loadDictionary (
+                        newDecompressor->dctx.get (),
+                        compressionDictionary.data (),
+                        compressionDictionary.size ()))))
+        {
+            getLogLog ().error (
+                LOG4CPLUS_TEXT ("SocketMessageDecoder::decode()- Unable to")
+                LOG4CPLUS_TEXT (" set up decompression"));
+            return false;
+        }
+
+        decompressor = std::move (newDecompressor);
+    }
+
+    unsigned long long const contentSize
+        = ZSTD_getFrameContentSize (data, size);
+    if (contentSize == ZSTD_CONTENTSIZE_UNKNOWN
+        || contentSize == ZSTD_CONTENTSIZE_ERROR
+        || contentSize > max_decompressed_batch_size)
+    {
+        getLogLog ().error (
+            LOG4CPLUS_TEXT ("SocketMessageDecoder::decode()- Invalid")
+            LOG4CPLUS_TEXT (" compressed batch"));
+        return false;
+    }
+
+    out.resize (static_cast<std::size_t> (contentSize));
+    std::size_t const result = ZSTD_decompressDCtx (decompressor->dctx.get (),
+        out.data (), out.size (), data, size);
+    if (ZSTD_isError (result) || result != out.size ())
+    {
+        getLogLog ().error (
+            LOG4CPLUS_TEXT ("SocketMessageDecoder::decode()- Unable to")
+            LOG4CPLUS_TEXT (" decompress batch: ")
+            + LOG4CPLUS_C_STR_TO_TSTRING (ZSTD_isError (result)
+                ? ZSTD_getErrorName (result) : "size mismatch"));
+        return false;
+    }
+
+    return true;
+
+#else
+    (void) data;
+    (void) size;
+    (void) out;
+    getLogLog ().error (
+        LOG4CPLUS_TEXT ("SocketMessageDecoder::decode()- Compressed batch")
+        LOG4CPLUS_TEXT (" received, zstd compression is not available"));
+    return false;
+
+#endif
+}
+
+
 } // namespace helpers
 
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+namespace
+{
+
+spi::InternalLoggingEvent
+make_test_event (tstring const & message)
+{
+    return spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("test"),
+        INFO_LOG_LEVEL, message, __FILE__, __LINE__, nullptr);
+}
+
+
+std::vector<tstring>
+parse_frames (std::string const & frames)
+{
+    std::vector<tstring> messages;
+    std::size_t pos = 0;
+    while (frames.size () - pos >= sizeof (unsigned int))
+    {
+        helpers::SocketBuffer sizeBuffer (sizeof (unsigned int));
+        std::memcpy (sizeBuffer.getBuffer (), frames.data () + pos,
+            sizeof (unsigned int));
+        sizeBuffer.setSize (sizeof (unsigned int));
+        std::size_t const size = sizeBuffer.readInt ();
+        pos += sizeof (unsigned int);
+        if (frames.size () - pos < size)
+            break;
+
+        helpers::SocketBuffer msgBuffer (size);
+        std::memcpy (msgBuffer.getBuffer (), frames.data () + pos, size);
+        msgBuffer.setSize (size);
+        pos += size;
+        messages.push_back (helpers::readFromBuffer (msgBuffer).getMessage ());
+    }
+
+    return messages;
+}
+
+
+tstring
+read_message (helpers::Socket & socket,
+    helpers::SocketMessageDecoder & decoder)
+{
+    spi::InternalLoggingEvent event;
+    for (;;)
+    {
+        helpers::SocketBuffer sizeBuffer (sizeof (unsigned int));
+        if (! socket.read (sizeBuffer))
+            return tstring ();
+
+        helpers::SocketBuffer msgBuffer (sizeBuffer.readInt ());
+        if (! socket.read (msgBuffer))
+            return tstring ();
+
+        if (decoder.decode (msgBuffer, event))
+            break;
+    }
+
+    return event.getMessage ();
+}
+
+} // namespace
+
+
+CATCH_TEST_CASE ("SocketAppender spool", "[appender]")
+{
+    tstring const spool_name (LOG4CPLUS_TEXT ("log4cplus-socket-spool.bin"));
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (spool_name).c_str ());
+
+    // Nothing is expected to listen on this port from the start.
+    unsigned short const port = 29517;
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("host"), LOG4CPLUS_TEXT ("localhost"));
+    props.setProperty (LOG4CPLUS_TEXT ("port"),
+        helpers::convertIntegerToString (port));
+    // Dropping of the oldest events starts with the first failure.
+    props.setProperty (LOG4CPLUS_TEXT ("AsyncConnect"),
+        LOG4CPLUS_TEXT ("false"));
+
+    CATCH_SECTION ("spool file is replayed in order")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("SpoolSize"), LOG4CPLUS_TEXT ("1"));
+        props.setProperty (LOG4CPLUS_TEXT ("SpoolFile"), spool_name);
+        {
+            SocketAppender appender (props);
+            appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("1")));
+            appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("2")));
+            appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("3")));
+        }
+
+        std::string contents;
+        {
+            std::ifstream in (LOG4CPLUS_TSTRING_TO_STRING (spool_name).c_str (),
+                std::ios_base::binary);
+            contents.assign (std::istreambuf_iterator<char> (in),
+                std::istreambuf_iterator<char> ());
+        }
+        std::vector<tstring> const spooled = parse_frames (contents);
+        CATCH_REQUIRE (spooled.size () == 3);
+        CATCH_REQUIRE (spooled[0] == LOG4CPLUS_TEXT ("1"));
+        CATCH_REQUIRE (spooled[2] == LOG4CPLUS_TEXT ("3"));
+
+        helpers::ServerSocket server (port, false, false,
+            LOG4CPLUS_TEXT ("localhost"));
+        CATCH_REQUIRE (server.isOpen ());
+        {
+            SocketAppender appender (props);
+            appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("4")));
+        }
+
+        helpers::Socket client = server.accept ();
+        helpers::SocketMessageDecoder decoder;
+        CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("1"));
+        CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("2"));
+        CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("3"));
+        CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("4"));
+        CATCH_REQUIRE (read_message (client, decoder).empty ());
+    }
+
+    CATCH_SECTION ("memory spool drops oldest and replays on reconnect")
+    {
+        helpers::SocketBuffer frame (LOG4CPLUS_MAX_MESSAGE_SIZE);
+        convertToBuffer (frame, make_test_event (LOG4CPLUS_TEXT ("1")),
+            tstring ());
+        props.setProperty (LOG4CPLUS_TEXT ("SpoolSize"),
+            helpers::convertIntegerToString (
+                2 * (frame.getSize () + sizeof (unsigned int))));
+
+        SocketAppender appender (props);
+        appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("1")));
+        appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("2")));
+        appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("3")));
+
+        helpers::ServerSocket server (port, false, false,
+            LOG4CPLUS_TEXT ("localhost"));
+        CATCH_REQUIRE (server.isOpen ());
+
+        // Triggers reconnection, replay follows once it succeeds.
+        appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("4")));
+        helpers::Socket client = server.accept ();
+        helpers::SocketMessageDecoder decoder;
+        CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("3"));
+        CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("4"));
+
+        appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("5")));
+        CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("5"));
+        appender.close ();
+    }
+
+    CATCH_SECTION ("format 2 events are replayed on reconnect")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("SpoolSize"),
+            LOG4CPLUS_TEXT ("65536"));
+        props.setProperty (LOG4CPLUS_TEXT ("WireFormat"), LOG4CPLUS_TEXT ("2"));
+
+        SocketAppender appender (props);
+        appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("1")));
+        appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("2")));
+
+        helpers::ServerSocket server (port, false, false,
+            LOG4CPLUS_TEXT ("localhost"));
+        CATCH_REQUIRE (server.isOpen ());
+
+        appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("3")));
+        helpers::Socket client = server.accept ();
+        helpers::SocketMessageDecoder decoder;
+        CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("1"));
+        CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("2"));
+        CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("3"));
+
+        // These use the dictionary of the new connection.
+        appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("4")));
+        appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("5")));
+        CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("4"));
+        CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("5"));
+        appender.close ();
+    }
+
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (spool_name).c_str ());
+}
+
+CATCH_TEST_CASE ("SocketAppender asynchronous connect", "[appender]")
+{
+    unsigned short const port = 29522;
+    helpers::ServerSocket server (port, false, false,
+        LOG4CPLUS_TEXT ("localhost"));
+    CATCH_REQUIRE (server.isOpen ());
+
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("host"), LOG4CPLUS_TEXT ("localhost"));
+    props.setProperty (LOG4CPLUS_TEXT ("port"),
+        helpers::convertIntegerToString (port));
+
+    // Events appended before the connection is made are kept and sent
+    // in order, either by the connector thread or at closing.
+    SocketAppender appender (props);
+    for (tchar const * msg : {LOG4CPLUS_TEXT ("1"), LOG4CPLUS_TEXT ("2"),
+            LOG4CPLUS_TEXT ("3")})
+        appender.doAppend (make_test_event (msg));
+
+    helpers::Socket client = server.accept ();
+    helpers::SocketMessageDecoder decoder;
+    CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("1"));
+    CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("2"));
+    CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("3"));
+
+    appender.doAppend (make_test_event (LOG4CPLUS_TEXT ("4")));
+    CATCH_REQUIRE (read_message (client, decoder) == LOG4CPLUS_TEXT ("4"));
+    appender.close ();
+    CATCH_REQUIRE (read_message (client, decoder).empty ());
+}
+
+
+CATCH_TEST_CASE ("SocketAppender endpoints", "[appender]")
+{
+    unsigned short const port1 = 29520;
+    unsigned short const port2 = 29521;
+    helpers::ServerSocket server1 (port1, false, false,
+        LOG4CPLUS_TEXT ("localhost"));
+    helpers::ServerSocket server2 (port2, false, false,
+        LOG4CPLUS_TEXT ("localhost"));
+    CATCH_REQUIRE (server1.isOpen ());
+    CATCH_REQUIRE (server2.isOpen ());
+
+    helpers::Properties props;
+    // The last entry is invalid and skipped.
+    props.setProperty (LOG4CPLUS_TEXT ("Endpoints"),
+        LOG4CPLUS_TEXT ("localhost:") + helpers::convertIntegerToString (port1)
+        + LOG4CPLUS_TEXT (", localhost:")
+        + helpers::convertIntegerToString (port2)
+        + LOG4CPLUS_TEXT (", localhost:99999"));
+    // Both connections have to be up before the first event.
+    props.setProperty (LOG4CPLUS_TEXT ("AsyncConnect"),
+        LOG4CPLUS_TEXT ("false"));
+
+    CATCH_SECTION ("round robin")
+    {
+    }
+
+    CATCH_SECTION ("least outstanding")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("LoadBalancing"),
+            LOG4CPLUS_TEXT ("LeastOutstanding"));
+    }
+
+    SocketAppender appender (props);
+    for (tchar const * msg : {LOG4CPLUS_TEXT ("1"), LOG4CPLUS_TEXT ("2"),
+            LOG4CPLUS_TEXT ("3"), LOG4CPLUS_TEXT ("4")})
+        appender.doAppend (make_test_event (msg));
+
+    // Idle connections tie, events alternate between the servers.
+    helpers::Socket client1 = server1.accept ();
+    helpers::Socket client2 = server2.accept ();
+    helpers::SocketMessageDecoder decoder1;
+    helpers::SocketMessageDecoder decoder2;
+    CATCH_REQUIRE (read_message (client1, decoder1) == LOG4CPLUS_TEXT ("1"));
+    CATCH_REQUIRE (read_message (client2, decoder2) == LOG4CPLUS_TEXT ("2"));
+    CATCH_REQUIRE (read_message (client1, decoder1) == LOG4CPLUS_TEXT ("3"));
+    CATCH_REQUIRE (read_message (client2, decoder2) == LOG4CPLUS_TEXT ("4"));
+    appender.close ();
+    CATCH_REQUIRE (read_message (client1, decoder1).empty ());
+    CATCH_REQUIRE (read_message (client2, decoder2).empty ());
+}
+
+
+CATCH_TEST_CASE ("SocketMessageEncoder", "[appender]")
+{
+    helpers::SocketMessageEncoder encoder;
+    tstring const server_name (LOG4CPLUS_TEXT ("server"));
+    MappedDiagnosticContextMap mdc;
+    mdc[LOG4CPLUS_TEXT ("key")] = LOG4CPLUS_TEXT ("value");
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("logger"),
+        WARN_LOG_LEVEL, LOG4CPLUS_TEXT ("ndc"), mdc,
+        tstring (3 * 8 * 1024, LOG4CPLUS_TEXT ('x')),
+        LOG4CPLUS_TEXT ("thread"), LOG4CPLUS_TEXT ("thread2"),
+        helpers::from_time_t (1234567) + helpers::chrono::microseconds (890),
+        LOG4CPLUS_TEXT ("file.cxx"), 42, LOG4CPLUS_TEXT ("function"));
+
+    auto const decode_all = [] (helpers::SocketMessageDecoder & decoder,
+        std::string const & frames)
+    {
+        std::vector<spi::InternalLoggingEvent> events;
+        std::size_t pos = 0;
+        while (pos != frames.size ())
+        {
+            helpers::SocketBuffer sizeBuffer (sizeof (unsigned int));
+            std::memcpy (sizeBuffer.getBuffer (), frames.data () + pos,
+                sizeof (unsigned int));
+            sizeBuffer.setSize (sizeof (unsigned int));
+            std::size_t const size = sizeBuffer.readInt ();
+            pos += sizeof (unsigned int);
+
+            helpers::SocketBuffer msgBuffer (size);
+            std::memcpy (msgBuffer.getBuffer (), frames.data () + pos, size);
+            msgBuffer.setSize (size);
+            pos += size;
+
+            spi::InternalLoggingEvent event;
+            if (decoder.decode (msgBuffer, event))
+                events.push_back (event);
+        }
+
+        return events;
+    };
+
+    auto const check_event = [&] (spi::InternalLoggingEvent const & event)
+    {
+        CATCH_REQUIRE (event.getLoggerName () == ev.getLoggerName ());
+        CATCH_REQUIRE (event.getLogLevel () == ev.getLogLevel ());
+        CATCH_REQUIRE (event.getNDC () == server_name
+            + LOG4CPLUS_TEXT (" - ") + ev.getNDC ());
+        CATCH_REQUIRE (event.getMDCCopy () == mdc);
+        CATCH_REQUIRE (event.getMessage () == ev.getMessage ());
+        CATCH_REQUIRE (event.getThread () == ev.getThread ());
+        CATCH_REQUIRE (event.getThread2 () == ev.getThread2 ());
+        CATCH_REQUIRE (event.getTimestamp () == ev.getTimestamp ());
+        CATCH_REQUIRE (event.getFile () == ev.getFile ());
+        CATCH_REQUIRE (event.getLine () == ev.getLine ());
+        CATCH_REQUIRE (event.getFunction () == ev.getFunction ());
+    };
+
+    CATCH_SECTION ("names are sent once")
+    {
+        std::string first, second;
+        encoder.encode (first, ev, server_name, true);
+        encoder.encode (second, ev, server_name, true);
+        CATCH_REQUIRE (second.size () < first.size ());
+
+        helpers::SocketMessageDecoder decoder;
+        auto const events = decode_all (decoder, first + second);
+        CATCH_REQUIRE (events.size () == 2);
+        check_event (events[0]);
+        check_event (events[1]);
+    }
+
+    CATCH_SECTION ("dictionary message makes events decodable")
+    {
+        std::string first, second, dictionary;
+        encoder.encode (first, ev, server_name, true);
+        encoder.encode (second, ev, server_name, true);
+        encoder.encodeDictionary (dictionary);
+
+        helpers::SocketMessageDecoder decoder;
+        auto const events = decode_all (decoder, dictionary + second);
+        CATCH_REQUIRE (events.size () == 1);
+        check_event (events[0]);
+    }
+
+    CATCH_SECTION ("inline events do not need dictionary")
+    {
+        std::string frames;
+        encoder.encode (frames, ev, server_name, true);
+        frames.clear ();
+        encoder.encode (frames, ev, server_name, false);
+
+        helpers::SocketMessageDecoder decoder;
+        auto const events = decode_all (decoder, frames);
+        CATCH_REQUIRE (events.size () == 1);
+        check_event (events[0]);
+    }
+
+    CATCH_SECTION ("format 1 messages are decoded")
+    {
+        spi::InternalLoggingEvent const small (LOG4CPLUS_TEXT ("logger"),
+            INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"), __FILE__, __LINE__,
+            nullptr);
+        helpers::SocketBuffer buffer (LOG4CPLUS_MAX_MESSAGE_SIZE);
+        convertToBuffer (buffer, small, server_name);
+        helpers::SocketBuffer received (buffer.getSize ());
+        std::memcpy (received.getBuffer (), buffer.getBuffer (),
+            buffer.getSize ());
+        received.setSize (buffer.getSize ());
+
+        helpers::SocketMessageDecoder decoder;
+        spi::InternalLoggingEvent event;
+        CATCH_REQUIRE (decoder.decode (received, event));
+        CATCH_REQUIRE (event.getMessage () == small.getMessage ());
+        CATCH_REQUIRE (event.getLoggerName () == small.getLoggerName ());
+    }
+
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    CATCH_SECTION ("compressed batch is decoded into its events")
+    {
+        std::string frames;
+        encoder.encode (frames, ev, server_name, true);
+        encoder.encode (frames, ev, server_name, true);
+        std::string const dictionary (64, 'x');
+
+        for (bool useDictionary : {false, true})
+        {
+            internal::socket_compressor compressor;
+            if (useDictionary)
+                CATCH_REQUIRE (! ZSTD_isError (ZSTD_CCtx_loadDictionary (
+                    compressor.cctx.get (), dictionary.data (),
+                    dictionary.size ())));
+
+            std::string_view const halves[] = {
+                std::string_view (frames).substr (0, frames.size () / 2),
+                std::string_view (frames).substr (frames.size () / 2)};
+            std::string message;
+            CATCH_REQUIRE (helpers::SocketMessageEncoder::encodeCompressed (
+                message, halves, compressor));
+            CATCH_REQUIRE (message.size () < frames.size () / 10);
+
+            helpers::SocketMessageDecoder decoder;
+            if (useDictionary)
+                decoder.setCompressionDictionary (dictionary);
+            std::vector<spi::InternalLoggingEvent> events;
+            CATCH_REQUIRE (decoder.decode (message.data () + 4,
+                    message.size () - 4, events) == 2);
+            check_event (events[0]);
+            check_event (events[1]);
+        }
+    }
+#endif
+}
+
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+
 } // namespace log4cplus
@@ -22,6 +22,7 @@
 #include <limits>
 #include <log4cplus/helpers/socketbuffer.h>
 #include <log4cplus/helpers/loglog.h>
+#include <log4cplus/internal/internal.h>
 
 #if defined (LOG4CPLUS_HAVE_SYS_TYPES_H)
 #include <sys/types.h>
@@ -49,18 +50,71 @@ namespace log4cplus::helpers {
 // SocketBuffer ctors and dtor
 //////////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+
+using internal::socket_buffer_pool;
+
+
+//! \return Index of pooled size class for blocks of <code>size</code>
+//! bytes, or -1 for sizes that are not pooled.
+int
+size_class (std::size_t size)
+{
+    std::size_t shift = socket_buffer_pool::min_shift;
+    while ((std::size_t (1) << shift) < size)
+        if (++shift > socket_buffer_pool::max_shift)
+            return -1;
+
+    return static_cast<int>(shift - socket_buffer_pool::min_shift);
+}
+
+
+char *
+acquire_block (std::size_t size)
+{
+    int const sc = size_class (size);
+    if (sc < 0)
+        return new char[size];
+
+    std::vector<char *> & free_blocks = internal::get_ptd ()->sb_pool.blocks[sc];
+    if (free_blocks.empty ())
+        return new char[std::size_t (1) << (sc + socket_buffer_pool::min_shift)];
+
+    char * const block = free_blocks.back ();
+    free_blocks.pop_back ();
+    return block;
+}
+
+
+void
+release_block (char * block, std::size_t size)
+{
+    int const sc = size_class (size);
+    // Per thread data might be already gone during thread clean up.
+    internal::per_thread_data * const ptd = sc < 0 ? nullptr
+        : internal::get_ptd (false);
+    if (ptd && ptd->sb_pool.blocks[sc].size () < socket_buffer_pool::max_blocks)
+        ptd->sb_pool.blocks[sc].push_back (block);
+    else
+        delete [] block;
+}
+
+} // namespace
+
+
 SocketBuffer::SocketBuffer(std::size_t maxsize_)
 : maxsize(maxsize_),
   size(0),
   pos(0),
-  buffer(new char[maxsize])
+  buffer(acquire_block (maxsize))
 {
 }
 
 
 SocketBuffer::~SocketBuffer()
 {
-    delete [] buffer;
+    release_block (buffer, maxsize);
 }
 
 
@@ -321,6 +375,19 @@ CATCH_TEST_CASE ("SocketBuffer", "[sockets]")
 
         CATCH_REQUIRE_THROWS (small_sb.appendByte (1));
     }
+
+    CATCH_SECTION ("storage is reused")
+    {
+        char const * storage;
+        {
+            SocketBuffer sb (1000);
+            storage = sb.getBuffer ();
+        }
+        SocketBuffer same_class (900);
+        CATCH_REQUIRE (same_class.getBuffer () == storage);
+        SocketBuffer other (900);
+        CATCH_REQUIRE (other.getBuffer () != storage);
+    }
 }
 #endif
 
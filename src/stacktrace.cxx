@@ -0,0 +1,280 @@
+// Module:  Log4cplus
+// File:    stacktrace.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <log4cplus/config.hxx>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/thread/syncprims.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+
+#if defined (LOG4CPLUS_HAVE_EXECINFO_H)
+#include <execinfo.h>
+#elif defined (_WIN32)
+#include <log4cplus/config/windowsh-inc.h>
+#endif
+
+#if defined (__GNUC__)
+#include <cxxabi.h>
+#endif
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/appender.h>
+#include <log4cplus/hierarchy.h>
+#include <log4cplus/layout.h>
+#include <log4cplus/logger.h>
+#include <catch.hpp>
+#endif
+
+
+namespace log4cplus::spi {
+
+
+namespace
+{
+
+//! See setStackTraceLogLevel().
+std::atomic<LogLevel> stack_trace_log_level {OFF_LOG_LEVEL};
+
+
+//! Descriptions of return addresses, see symbolizeStackFrame().
+struct symbol_cache
+{
+    thread::Mutex mutex;
+    std::unordered_map<void *, tstring> symbols;
+};
+
+
+symbol_cache &
+get_symbol_cache ()
+{
+    // Never destroyed, layouts may format stack traces at exit.
+    static symbol_cache * const cache = new symbol_cache;
+    return *cache;
+}
+
+
+//! Replaces mangled name in <code>module(name+0x1f) [0x...]</code>
+//! form of backtrace_symbols() by its demangled form.
+std::string
+demangle_frame (std::string frame)
+{
+#if defined (__GNUC__)
+    std::size_t const open = frame.find ('(');
+    if (open == std::string::npos)
+        return frame;
+
+    std::size_t const end = frame.find_first_of ("+)", open);
+    if (end == std::string::npos || end == open + 1)
+        return frame;
+
+    std::string const mangled (frame, open + 1, end - open - 1);
+    int status = 0;
+    char * const demangled = abi::__cxa_demangle (mangled.c_str (), nullptr,
+        nullptr, &status);
+    if (status == 0 && demangled)
+        frame.replace (open + 1, mangled.size (), demangled);
+    std::free (demangled);
+#endif
+
+    return frame;
+}
+
+
+std::string
+describe_address (void * address)
+{
+#if defined (LOG4CPLUS_HAVE_EXECINFO_H)
+    if (char ** const symbols = backtrace_symbols (&address, 1))
+    {
+        std::string frame (symbols[0]);
+        std::free (symbols);
+        return demangle_frame (std::move (frame));
+    }
+#endif
+
+    char buf[2 + sizeof (void *) * 2 + 1];
+    std::snprintf (buf, sizeof (buf), "%p", address);
+    return buf;
+}
+
+} // namespace
+
+
+StackTracePtr
+currentStackTrace (unsigned skip)
+{
+    // One more for this function.
+    ++skip;
+
+#if defined (LOG4CPLUS_HAVE_EXECINFO_H)
+    void * frames[StackTrace::max_frames + 8];
+    int const max = static_cast<int>(
+        (std::min) (StackTrace::max_frames + skip, std::size (frames)));
+    int const count = backtrace (frames, max);
+    auto trace = std::make_shared<StackTrace> ();
+    if (count > static_cast<int>(skip))
+    {
+        trace->size = static_cast<std::size_t>(count) - skip;
+        std::copy (frames + skip, frames + count, trace->frames);
+    }
+    return trace;
+
+#elif defined (_WIN32)
+    auto trace = std::make_shared<StackTrace> ();
+    trace->size = CaptureStackBackTrace (static_cast<DWORD>(skip),
+        static_cast<DWORD>(StackTrace::max_frames), trace->frames, nullptr);
+    return trace;
+
+#else
+    (void) skip;
+    return StackTracePtr ();
+
+#endif
+}
+
+
+tstring const &
+symbolizeStackFrame (void * address)
+{
+    symbol_cache & cache = get_symbol_cache ();
+    {
+        thread::MutexGuard guard (cache.mutex);
+        auto it = cache.symbols.find (address);
+        if (it != cache.symbols.end ())
+            return it->second;
+    }
+
+    // Resolved without the lock; a racing thread's equal description
+    // wins.
+    tstring description = LOG4CPLUS_STRING_TO_TSTRING (
+        describe_address (address));
+    thread::MutexGuard guard (cache.mutex);
+    return cache.symbols.emplace (address, std::move (description))
+        .first->second;
+}
+
+
+void
+setStackTraceLogLevel (LogLevel ll)
+{
+    stack_trace_log_level.store (ll, std::memory_order_relaxed);
+}
+
+
+LogLevel
+getStackTraceLogLevel ()
+{
+    return stack_trace_log_level.load (std::memory_order_relaxed);
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Stack trace", "[event]")
+{
+#if defined (LOG4CPLUS_HAVE_EXECINFO_H) || defined (_WIN32)
+    CATCH_SECTION ("capture and symbolize")
+    {
+        StackTracePtr const trace = currentStackTrace ();
+        CATCH_REQUIRE (trace);
+        CATCH_REQUIRE (trace->size > 0);
+        CATCH_REQUIRE (trace->size <= StackTrace::max_frames);
+
+        tstring const & first = symbolizeStackFrame (trace->frames[0]);
+        CATCH_REQUIRE (! first.empty ());
+        CATCH_REQUIRE (&symbolizeStackFrame (trace->frames[0]) == &first);
+    }
+
+    CATCH_SECTION ("captured for events from log level")
+    {
+        struct TestAppender
+            : Appender
+        {
+            ~TestAppender () { destructorImpl (); }
+
+            void close () override { }
+
+            std::vector<StackTracePtr> traces;
+
+        protected:
+            void append (InternalLoggingEvent const & event) override
+            {
+                traces.push_back (event.getStackTrace ());
+            }
+        };
+
+        Hierarchy h;
+        Logger logger = h.getInstance (LOG4CPLUS_TEXT ("stack"));
+        helpers::SharedObjectPtr<TestAppender> appender (new TestAppender);
+        logger.addAppender (SharedAppenderPtr (appender.get ()));
+
+        setStackTraceLogLevel (ERROR_LOG_LEVEL);
+        logger.forcedLog (WARN_LOG_LEVEL, LOG4CPLUS_TEXT ("warn"));
+        logger.forcedLog (ERROR_LOG_LEVEL, LOG4CPLUS_TEXT ("error"));
+        setStackTraceLogLevel (OFF_LOG_LEVEL);
+        logger.forcedLog (FATAL_LOG_LEVEL, LOG4CPLUS_TEXT ("fatal"));
+
+        CATCH_REQUIRE (appender->traces.size () == 3);
+        CATCH_REQUIRE (! appender->traces[0]);
+        CATCH_REQUIRE (appender->traces[1]);
+        CATCH_REQUIRE (appender->traces[1]->size > 0);
+        CATCH_REQUIRE (! appender->traces[2]);
+        h.shutdown ();
+    }
+
+    CATCH_SECTION ("pattern converter")
+    {
+        InternalLoggingEvent ev (LOG4CPLUS_TEXT ("stack"), ERROR_LOG_LEVEL,
+            LOG4CPLUS_TEXT ("msg"), __FILE__, __LINE__);
+        PatternLayout layout (LOG4CPLUS_TEXT ("%m%n%S"));
+        tstring output;
+        layout.formatAndAppend (output, ev);
+        CATCH_REQUIRE (output == LOG4CPLUS_TEXT ("msg\n"));
+
+        ev.captureStackTrace ();
+        InternalLoggingEvent const copy (ev);
+        CATCH_REQUIRE (copy.getStackTrace () == ev.getStackTrace ());
+
+        output.clear ();
+        layout.formatAndAppend (output, copy);
+        CATCH_REQUIRE (output.compare (0, 8, LOG4CPLUS_TEXT ("msg\n\tat ")) == 0);
+        CATCH_REQUIRE (output.back () == LOG4CPLUS_TEXT ('\n'));
+    }
+#endif
+}
+#endif
+
+
+} // namespace log4cplus::spi
@@ -29,6 +29,8 @@
 #include <cwctype>
 #include <cctype>
 #include <cassert>
+#include <cstdint>
+#include <locale>
 
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 #include <catch.hpp>
@@ -41,6 +43,255 @@ namespace log4cplus::internal
 
 log4cplus::tstring const empty_str;
 
+
+void
+append_utf8 (std::string & out, tstring_view str)
+{
+#if defined (UNICODE)
+    helpers::appendUtf8 (out, str);
+
+#else
+    out += str;
+
+#endif
+}
+
+
+namespace
+{
+
+bool
+is_high_surrogate (wchar_t ch)
+{
+    return sizeof (wchar_t) == 2 && ch >= 0xD800 && ch <= 0xDBFF;
+}
+
+
+//! \return Length of UTF-8 sequence starting with <code>lead</code>;
+//! 1 for bytes that cannot start one.
+std::size_t
+utf8_sequence_length (char lead)
+{
+    unsigned char const ch = static_cast<unsigned char> (lead);
+    if ((ch & 0xE0) == 0xC0)
+        return 2;
+    else if ((ch & 0xF0) == 0xE0)
+        return 3;
+    else if ((ch & 0xF8) == 0xF0)
+        return 4;
+    else
+        return 1;
+}
+
+
+//! UTF-8 codecvt facet. Wide file streams pass whole buffers to
+//! out(), which are transcoded in bulk. A high surrogate at the end of
+//! a buffer is kept in the conversion state until the next call.
+class utf8_codecvt
+    : public std::codecvt<wchar_t, char, std::mbstate_t>
+{
+public:
+    using std::codecvt<wchar_t, char, std::mbstate_t>::codecvt;
+
+protected:
+    result
+    do_out (state_type & state, intern_type const * from,
+        intern_type const * from_end, intern_type const * & from_next,
+        extern_type * to, extern_type * to_end, extern_type * & to_next)
+        const override
+    {
+        from_next = from;
+        to_next = to;
+
+        if (wchar_t const high = get_pending (state))
+        {
+            if (from_next == from_end)
+                return ok;
+
+            // A lone high surrogate is encoded as U+FFFD and the next
+            // character is left for the loop below.
+            bool const paired = *from_next >= 0xDC00 && *from_next <= 0xDFFF;
+            wchar_t const pair[2] = { high, *from_next };
+            char tmp[8];
+            std::size_t const len = helpers::encodeUtf8 (tmp,
+                std::wstring_view (pair, paired ? 2 : 1));
+            if (static_cast<std::size_t> (to_end - to_next) < len)
+                return partial;
+
+            std::memcpy (to_next, tmp, len);
+            to_next += len;
+            from_next += paired ? 1 : 0;
+            set_pending (state, 0);
+        }
+
+        while (from_next != from_end)
+        {
+            std::size_t const size
+                = static_cast<std::size_t> (from_end - from_next);
+            std::size_t count = (std::min) (size,
+                static_cast<std::size_t> (to_end - to_next)
+                / helpers::utf8MaxSize (1));
+            // Do not split surrogate pairs.
+            if (count != 0 && is_high_surrogate (from_next[count - 1]))
+                --count;
+
+            if (count != 0)
+            {
+                to_next += helpers::encodeUtf8 (to_next,
+                    std::wstring_view (from_next, count));
+                from_next += count;
+                continue;
+            }
+
+            // Character by character when output space is short or at
+            // a high surrogate.
+            if (is_high_surrogate (*from_next) && size == 1)
+            {
+                set_pending (state, *from_next);
+                ++from_next;
+                break;
+            }
+
+            std::size_t const units = is_high_surrogate (*from_next) ? 2 : 1;
+            char tmp[8];
+            std::size_t const len = helpers::encodeUtf8 (tmp,
+                std::wstring_view (from_next, units));
+            if (static_cast<std::size_t> (to_end - to_next) < len)
+                return partial;
+
+            std::memcpy (to_next, tmp, len);
+            to_next += len;
+            from_next += units;
+        }
+
+        return ok;
+    }
+
+    result
+    do_unshift (state_type & state, extern_type * to, extern_type * to_end,
+        extern_type * & to_next) const override
+    {
+        to_next = to;
+        if (! get_pending (state))
+            return noconv;
+
+        // Replace lone high surrogate at the end of output.
+        if (to_end - to < 3)
+            return partial;
+
+        wchar_t const replacement = 0xFFFD;
+        to_next += helpers::encodeUtf8 (to_next,
+            std::wstring_view (&replacement, 1));
+        set_pending (state, 0);
+        return ok;
+    }
+
+    result
+    do_in (state_type &, extern_type const * from,
+        extern_type const * from_end, extern_type const * & from_next,
+        intern_type * to, intern_type * to_end, intern_type * & to_next)
+        const override
+    {
+        // Decoding never produces more wide characters than it consumes
+        // bytes.
+        std::size_t const size = (std::min) (
+            static_cast<std::size_t> (from_end - from),
+            static_cast<std::size_t> (to_end - to));
+        std::size_t const count = complete_prefix (from, size);
+        from_next = from + count;
+        to_next = to + helpers::decodeUtf8 (to,
+            std::string_view (from, count));
+        return from_next == from_end ? ok : partial;
+    }
+
+    int
+    do_encoding () const noexcept override
+    {
+        return 0;
+    }
+
+    bool
+    do_always_noconv () const noexcept override
+    {
+        return false;
+    }
+
+    int
+    do_length (state_type &, extern_type const * from,
+        extern_type const * from_end, std::size_t max) const override
+    {
+        extern_type const * it = from;
+        std::size_t units = 0;
+        while (it != from_end)
+        {
+            std::size_t const len = utf8_sequence_length (*it);
+            if (static_cast<std::size_t> (from_end - it) < len)
+                break;
+
+            wchar_t tmp[4];
+            units += helpers::decodeUtf8 (tmp, std::string_view (it, len));
+            if (units > max)
+                break;
+
+            it += len;
+        }
+
+        return static_cast<int> (it - from);
+    }
+
+    int
+    do_max_length () const noexcept override
+    {
+        return 4;
+    }
+
+private:
+    static
+    wchar_t
+    get_pending (state_type const & state)
+    {
+        std::uint32_t value;
+        std::memcpy (&value, &state, sizeof (value));
+        return static_cast<wchar_t> (value);
+    }
+
+    static
+    void
+    set_pending (state_type & state, wchar_t ch)
+    {
+        std::uint32_t const value = static_cast<std::uint32_t> (ch);
+        std::memcpy (&state, &value, sizeof (value));
+    }
+
+    static_assert (sizeof (state_type) >= sizeof (std::uint32_t));
+
+    //! \return Length of the longest prefix of <code>str</code> that
+    //! does not end with an incomplete UTF-8 sequence.
+    static
+    std::size_t
+    complete_prefix (char const * str, std::size_t size)
+    {
+        if (size == 0)
+            return 0;
+
+        std::size_t lead = size;
+        for (int i = 0; i != 4 && lead != 0; ++i)
+            if ((static_cast<unsigned char> (str[--lead]) & 0xC0) != 0x80)
+                break;
+
+        return lead + utf8_sequence_length (str[lead]) > size ? lead : size;
+    }
+};
+
+} // namespace
+
+
+std::locale
+with_utf8_codecvt (std::locale const & loc)
+{
+    return std::locale (loc, new utf8_codecvt);
+}
+
 } // namespace log4cplus
 
 
@@ -75,6 +326,197 @@ clear_mbstate (std::mbstate_t & mbs)
 }
 
 
+namespace
+{
+
+//! Characters per iteration of the ASCII fast paths. Blocks are tested
+//! with 64 bit loads, which compilers turn into vector code where it
+//! pays off.
+std::size_t const ascii_block = 16;
+
+
+bool
+is_ascii_block (wchar_t const * src)
+{
+    std::uint64_t const mask = sizeof (wchar_t) == 2
+        ? UINT64_C (0xFF80FF80FF80FF80) : UINT64_C (0xFFFFFF80FFFFFF80);
+    std::uint64_t acc = 0;
+    for (std::size_t i = 0; i != ascii_block * sizeof (wchar_t) / 8; ++i)
+    {
+        std::uint64_t word;
+        std::memcpy (&word, reinterpret_cast<char const *> (src) + i * 8, 8);
+        acc |= word;
+    }
+    return (acc & mask) == 0;
+}
+
+
+bool
+is_ascii_block (char const * src)
+{
+    std::uint64_t word[2];
+    std::memcpy (word, src, sizeof (word));
+    return ((word[0] | word[1]) & UINT64_C (0x8080808080808080)) == 0;
+}
+
+
+std::uint32_t const replacement_char = 0xFFFD;
+
+} // namespace
+
+
+std::size_t
+encodeUtf8 (char * dest, std::wstring_view src)
+{
+    char * out = dest;
+    wchar_t const * it = src.data ();
+    wchar_t const * const end = it + src.size ();
+    while (it != end)
+    {
+        if (static_cast<std::size_t> (end - it) >= ascii_block
+            && is_ascii_block (it))
+        {
+            for (std::size_t i = 0; i != ascii_block; ++i)
+                out[i] = static_cast<char> (it[i]);
+            it += ascii_block;
+            out += ascii_block;
+            continue;
+        }
+
+        std::uint32_t cp = static_cast<std::uint32_t> (*it++);
+        if (cp < 0x80)
+        {
+            *out++ = static_cast<char> (cp);
+            continue;
+        }
+
+        if constexpr (sizeof (wchar_t) == 2)
+        {
+            // Combine UTF-16 surrogate pairs; lone surrogates are
+            // replaced.
+            if (cp >= 0xD800 && cp <= 0xDBFF && it != end
+                && *it >= 0xDC00 && *it <= 0xDFFF)
+            {
+                cp = 0x10000 + ((cp - 0xD800) << 10)
+                    + (static_cast<std::uint32_t> (*it++) - 0xDC00);
+            }
+        }
+
+        if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+            cp = replacement_char;
+
+        if (cp < 0x800)
+        {
+            *out++ = static_cast<char> (0xC0 | (cp >> 6));
+            *out++ = static_cast<char> (0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000)
+        {
+            *out++ = static_cast<char> (0xE0 | (cp >> 12));
+            *out++ = static_cast<char> (0x80 | ((cp >> 6) & 0x3F));
+            *out++ = static_cast<char> (0x80 | (cp & 0x3F));
+        }
+        else
+        {
+            *out++ = static_cast<char> (0xF0 | (cp >> 18));
+            *out++ = static_cast<char> (0x80 | ((cp >> 12) & 0x3F));
+            *out++ = static_cast<char> (0x80 | ((cp >> 6) & 0x3F));
+            *out++ = static_cast<char> (0x80 | (cp & 0x3F));
+        }
+    }
+
+    return static_cast<std::size_t> (out - dest);
+}
+
+
+void
+appendUtf8 (std::string & out, std::wstring_view src)
+{
+    std::size_t const size = out.size ();
+    out.resize (size + utf8MaxSize (src.size ()));
+    out.resize (size + encodeUtf8 (&out[0] + size, src));
+}
+
+
+std::size_t
+decodeUtf8 (wchar_t * dest, std::string_view src)
+{
+    wchar_t * out = dest;
+    char const * it = src.data ();
+    char const * const end = it + src.size ();
+    while (it != end)
+    {
+        if (static_cast<std::size_t> (end - it) >= ascii_block
+            && is_ascii_block (it))
+        {
+            for (std::size_t i = 0; i != ascii_block; ++i)
+                out[i] = static_cast<wchar_t> (it[i]);
+            it += ascii_block;
+            out += ascii_block;
+            continue;
+        }
+
+        unsigned char const lead = static_cast<unsigned char> (*it);
+        if (lead < 0x80)
+        {
+            *out++ = static_cast<wchar_t> (lead);
+            ++it;
+            continue;
+        }
+
+        std::size_t len;
+        std::uint32_t cp;
+        std::uint32_t min;
+        if ((lead & 0xE0) == 0xC0)
+            len = 2, cp = lead & 0x1F, min = 0x80;
+        else if ((lead & 0xF0) == 0xE0)
+            len = 3, cp = lead & 0x0F, min = 0x800;
+        else if ((lead & 0xF8) == 0xF0)
+            len = 4, cp = lead & 0x07, min = 0x10000;
+        else
+            len = 0, cp = 0, min = 0;
+
+        bool valid = len != 0 && static_cast<std::size_t> (end - it) >= len;
+        for (std::size_t i = 1; valid && i != len; ++i)
+        {
+            unsigned char const ch = static_cast<unsigned char> (it[i]);
+            valid = (ch & 0xC0) == 0x80;
+            cp = (cp << 6) | (ch & 0x3F);
+        }
+
+        // Reject overlong forms, surrogates and values past U+10FFFF.
+        if (! valid || cp < min || (cp >= 0xD800 && cp <= 0xDFFF)
+            || cp > 0x10FFFF)
+        {
+            *out++ = static_cast<wchar_t> (replacement_char);
+            ++it;
+            continue;
+        }
+
+        it += len;
+        if (sizeof (wchar_t) == 2 && cp >= 0x10000)
+        {
+            cp -= 0x10000;
+            *out++ = static_cast<wchar_t> (0xD800 + (cp >> 10));
+            *out++ = static_cast<wchar_t> (0xDC00 + (cp & 0x3FF));
+        }
+        else
+            *out++ = static_cast<wchar_t> (cp);
+    }
+
+    return static_cast<std::size_t> (out - dest);
+}
+
+
+void
+appendFromUtf8 (std::wstring & out, std::string_view src)
+{
+    std::size_t const size = out.size ();
+    out.resize (size + src.size ());
+    out.resize (size + decodeUtf8 (&out[0] + size, src));
+}
+
+
 #if defined (LOG4CPLUS_POOR_MANS_CHCONV)
 
 static
@@ -479,6 +921,25 @@ CATCH_TEST_CASE( "Strings helpers", "[strings]" )
         LOG4CPLUS_GEN_TEST (long long)
         LOG4CPLUS_GEN_TEST (unsigned long long)
 #undef LOG4CPLUS_GEN_TEST
+
+        CATCH_SECTION ("global locale with digit grouping")
+        {
+            struct grouping
+                : std::numpunct<tchar>
+            {
+                std::string do_grouping () const override { return "\3"; }
+            };
+
+            std::locale const previous = std::locale::global (
+                std::locale (std::locale::classic (), new grouping));
+            tostringstream oss;
+            oss << 1234567;
+            tstring const converted = convertIntegerToString (1234567);
+            std::locale::global (previous);
+
+            CATCH_REQUIRE (oss.str () != LOG4CPLUS_TEXT ("1234567"));
+            CATCH_REQUIRE (converted == LOG4CPLUS_TEXT ("1234567"));
+        }
     }
 
     CATCH_SECTION ("join strings")
@@ -510,6 +971,79 @@ CATCH_TEST_CASE( "Strings helpers", "[strings]" )
             CATCH_REQUIRE (result == LOG4CPLUS_TEXT ("1,2,3"));
         }
     }
+
+    CATCH_SECTION ("UTF-8 transcoding")
+    {
+        // Long enough to take the ASCII fast path around non-ASCII
+        // characters: U+00E9, U+20AC and U+1F600.
+        std::wstring wide (L"The quick brown fox jumps \u00E9 over the lazy"
+            L" dog \u20AC and ");
+        std::string narrow ("The quick brown fox jumps \xC3\xA9 over the lazy"
+            " dog \xE2\x82\xAC and ");
+        if constexpr (sizeof (wchar_t) == 2)
+            wide += L"\xD83D\xDE00";
+        else
+            wide += static_cast<wchar_t> (0x1F600);
+        narrow += "\xF0\x9F\x98\x80";
+        wide += L" 0123456789abcdefghijklmnopqrstuvwxyz";
+        narrow += " 0123456789abcdefghijklmnopqrstuvwxyz";
+
+        std::string encoded ("x");
+        appendUtf8 (encoded, wide);
+        CATCH_REQUIRE (encoded == "x" + narrow);
+
+        std::wstring decoded (L"x");
+        appendFromUtf8 (decoded, narrow);
+        CATCH_REQUIRE (decoded == L"x" + wide);
+
+        // Lone surrogate or overlong, truncated and stray continuation
+        // bytes are replaced.
+        encoded.clear ();
+        appendUtf8 (encoded, std::wstring (1, static_cast<wchar_t> (0xDC00)));
+        CATCH_REQUIRE (encoded == "\xEF\xBF\xBD");
+
+        decoded.clear ();
+        appendFromUtf8 (decoded, "a\xC0\x80" "b\xE2\x82" "c\x80");
+        CATCH_REQUIRE (decoded == L"a\xFFFD\xFFFD" L"b\xFFFD\xFFFD" L"c\xFFFD");
+
+        CATCH_SECTION ("codecvt facet")
+        {
+            using codecvt_type = std::codecvt<wchar_t, char, std::mbstate_t>;
+            std::locale const loc (
+                internal::with_utf8_codecvt (std::locale::classic ()));
+            codecvt_type const & cvt = std::use_facet<codecvt_type> (loc);
+            std::mbstate_t state {};
+
+            // One character per call splits the surrogate pair of
+            // U+1F600 in UTF-16.
+            encoded.clear ();
+            for (wchar_t const & ch : wide)
+            {
+                wchar_t const * from_next;
+                char buf[8];
+                char * to_next;
+                CATCH_REQUIRE (cvt.out (state, &ch, &ch + 1, from_next,
+                        buf, buf + sizeof (buf), to_next) == codecvt_type::ok);
+                encoded.append (buf, to_next);
+            }
+            CATCH_REQUIRE (encoded == narrow);
+
+            decoded.clear ();
+            for (std::size_t pos = 0; pos != narrow.size (); )
+            {
+                char const * const from = narrow.data () + pos;
+                char const * from_next;
+                wchar_t buf[8];
+                wchar_t * to_next;
+                cvt.in (state, from, from + (std::min) (narrow.size () - pos,
+                        std::size_t (4)), from_next, buf, buf + 8, to_next);
+                CATCH_REQUIRE (from_next != from);
+                decoded.append (buf, to_next);
+                pos += static_cast<std::size_t> (from_next - from);
+            }
+            CATCH_REQUIRE (decoded == wide);
+        }
+    }
 }
 #endif
 
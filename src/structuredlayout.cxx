@@ -0,0 +1,1275 @@
+// Module:  Log4cplus
+// File:    structuredlayout.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/structuredlayout.h>
+#include <log4cplus/jsonlayout.h>
+#include <log4cplus/logfmtlayout.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/internal/internal.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+using utchar = std::make_unsigned_t<tchar>;
+
+
+//! Number of characters char_class::clean_block() checks at once.
+std::size_t const char_block = 16;
+
+
+//! Bit masks of 64 bit word holding 8 / sizeof (tchar) characters.
+struct char_lanes
+{
+    //! Lowest bit of every lane.
+    static constexpr std::uint64_t ones = UINT64_MAX
+        / ((std::uint64_t (1) << (8 * sizeof (tchar) - 1)) * 2 - 1);
+    //! Highest bit of every lane.
+    static constexpr std::uint64_t high = ones << (8 * sizeof (tchar) - 1);
+};
+
+
+//! \return Non-zero when any lane of <code>word</code> is zero.
+constexpr
+std::uint64_t
+zero_lane (std::uint64_t word)
+{
+    return (word - char_lanes::ones) & ~word & char_lanes::high;
+}
+
+
+/**
+ * Characters below <code>Below</code> and the <code>Extra</code> ones.
+ * Clean spans are skipped a block at a time; all lanes of a word are
+ * tested for all characters of the class at once.
+ */
+template <unsigned Below, unsigned... Extra>
+struct char_class
+{
+    static_assert (Below <= 0x80);
+
+    static
+    bool
+    contains (tchar ch)
+    {
+        utchar const uch = static_cast<utchar> (ch);
+        return uch < Below || ((uch == Extra) || ...);
+    }
+
+    //! \return True when none of char_block characters at
+    //! <code>src</code> is in the class.
+    static
+    bool
+    clean_block (tchar const * src)
+    {
+        std::uint64_t acc = 0;
+        for (std::size_t i = 0; i != char_block * sizeof (tchar) / 8; ++i)
+        {
+            std::uint64_t word;
+            std::memcpy (&word, reinterpret_cast<char const *> (src) + i * 8,
+                8);
+            acc |= (word - char_lanes::ones * Below) & ~word
+                & char_lanes::high;
+            ((acc |= zero_lane (word ^ (char_lanes::ones * Extra))), ...);
+        }
+        return acc == 0;
+    }
+
+    //! \return First character of the class in [it, end), or end.
+    static
+    tchar const *
+    find (tchar const * it, tchar const * const end)
+    {
+        while (it != end)
+        {
+            if (static_cast<std::size_t> (end - it) >= char_block
+                && clean_block (it))
+                it += char_block;
+            else if (contains (*it))
+                return it;
+            else
+                ++it;
+        }
+        return end;
+    }
+};
+
+
+//! Characters which have to be escaped in JSON strings.
+using json_special = char_class<0x20, '"', '\\'>;
+
+//! Characters which have to be quoted in logfmt values; they are not
+//! allowed in keys.
+using logfmt_special = char_class<0x21, '"', '\\', '='>;
+
+
+} // namespace
+
+
+namespace internal
+{
+
+//! Appends <code>str</code> as content of JSON string. Clean spans are
+//! copied in bulk.
+void
+append_json_escaped (tstring & output, tstring_view str)
+{
+    tchar const * it = str.data ();
+    tchar const * const end = it + str.size ();
+    for (;;)
+    {
+        tchar const * const special = json_special::find (it, end);
+        output.append (it, special);
+        if (special == end)
+            break;
+
+        tchar const ch = *special;
+        tchar esc[6] = { LOG4CPLUS_TEXT ('\\') };
+        std::size_t esc_len = 2;
+        switch (ch)
+        {
+        case LOG4CPLUS_TEXT ('"'): esc[1] = LOG4CPLUS_TEXT ('"'); break;
+        case LOG4CPLUS_TEXT ('\\'): esc[1] = LOG4CPLUS_TEXT ('\\'); break;
+        case LOG4CPLUS_TEXT ('\b'): esc[1] = LOG4CPLUS_TEXT ('b'); break;
+        case LOG4CPLUS_TEXT ('\f'): esc[1] = LOG4CPLUS_TEXT ('f'); break;
+        case LOG4CPLUS_TEXT ('\n'): esc[1] = LOG4CPLUS_TEXT ('n'); break;
+        case LOG4CPLUS_TEXT ('\r'): esc[1] = LOG4CPLUS_TEXT ('r'); break;
+        case LOG4CPLUS_TEXT ('\t'): esc[1] = LOG4CPLUS_TEXT ('t'); break;
+        default:
+        {
+            static tchar const hex[] = LOG4CPLUS_TEXT ("0123456789abcdef");
+            esc[1] = LOG4CPLUS_TEXT ('u');
+            esc[2] = LOG4CPLUS_TEXT ('0');
+            esc[3] = LOG4CPLUS_TEXT ('0');
+            esc[4] = hex[static_cast<utchar> (ch) >> 4];
+            esc[5] = hex[static_cast<utchar> (ch) & 0xF];
+            esc_len = 6;
+        }
+        }
+        output.append (esc, esc_len);
+        it = special + 1;
+    }
+}
+
+} // namespace internal
+
+
+namespace
+{
+
+using internal::append_json_escaped;
+
+
+//! Appends <code>value</code> as logfmt value, quoted only when it is
+//! empty or contains logfmt_special characters.
+void
+append_logfmt_value (tstring & output, tstring_view value)
+{
+    tchar const * const end = value.data () + value.size ();
+    if (! value.empty () && logfmt_special::find (value.data (), end) == end)
+    {
+        output.append (value);
+        return;
+    }
+
+    output += LOG4CPLUS_TEXT ('"');
+    append_json_escaped (output, value);
+    output += LOG4CPLUS_TEXT ('"');
+}
+
+
+//! Appends <code>key</code> with characters that are not allowed in
+//! logfmt keys replaced by underscore.
+void
+append_logfmt_key (tstring & output, tstring_view key)
+{
+    if (key.empty ())
+    {
+        output += LOG4CPLUS_TEXT ('_');
+        return;
+    }
+
+    tchar const * it = key.data ();
+    tchar const * const end = it + key.size ();
+    for (;;)
+    {
+        tchar const * const special = logfmt_special::find (it, end);
+        output.append (it, special);
+        if (special == end)
+            break;
+
+        output += LOG4CPLUS_TEXT ('_');
+        it = special + 1;
+    }
+}
+
+
+/**
+ * Quotes value appended to <code>output</code> since position
+ * <code>start</code> in place using <code>append</code> when any of
+ * its characters is in <code>Class</code>. It is meant for values like
+ * dates which are formatted in place and rarely need quoting.
+ */
+template <typename Class, typename Append>
+void
+requote_tail (tstring & output, std::size_t start, bool quote_empty,
+    Append append)
+{
+    tchar const * const begin = output.data () + start;
+    tchar const * const end = output.data () + output.size ();
+    if ((begin != end || ! quote_empty) && Class::find (begin, end) == end)
+        return;
+
+    tstring & tmp = internal::get_ptd ()->faa_str;
+    tmp.assign (begin, end);
+    output.resize (start);
+    append (output, tmp);
+}
+
+
+tchar const * const field_names[] = {
+    LOG4CPLUS_TEXT ("timestamp"),
+    LOG4CPLUS_TEXT ("level"),
+    LOG4CPLUS_TEXT ("logger"),
+    LOG4CPLUS_TEXT ("thread"),
+    LOG4CPLUS_TEXT ("ndc"),
+    LOG4CPLUS_TEXT ("mdc"),
+    LOG4CPLUS_TEXT ("kv"),
+    LOG4CPLUS_TEXT ("file"),
+    LOG4CPLUS_TEXT ("line"),
+    LOG4CPLUS_TEXT ("function"),
+    LOG4CPLUS_TEXT ("message"),
+    LOG4CPLUS_TEXT ("stack"),
+    LOG4CPLUS_TEXT ("seq")
+};
+
+std::size_t const field_count = std::size (field_names);
+
+
+unsigned const field_event_fields[] = {
+    spi::EVENT_FIELDS_NONE,
+    spi::EVENT_FIELDS_NONE,
+    spi::EVENT_FIELDS_NONE,
+    spi::EVENT_FIELD_THREAD,
+    spi::EVENT_FIELD_NDC,
+    spi::EVENT_FIELD_MDC,
+    spi::EVENT_FIELDS_NONE,
+    spi::EVENT_FIELD_FILE,
+    spi::EVENT_FIELD_FILE,
+    spi::EVENT_FIELD_FUNCTION,
+    spi::EVENT_FIELDS_NONE,
+    spi::EVENT_FIELDS_NONE,
+    spi::EVENT_FIELDS_NONE
+};
+
+
+tchar const default_date_format[]
+    = LOG4CPLUS_TEXT ("%Y-%m-%dT%H:%M:%S.%qZ");
+
+
+tstring_view
+trim_spaces (tstring_view str)
+{
+    std::size_t const first = str.find_first_not_of (LOG4CPLUS_TEXT (" \t"));
+    if (first == tstring_view::npos)
+        return tstring_view ();
+
+    std::size_t const last = str.find_last_not_of (LOG4CPLUS_TEXT (" \t"));
+    return str.substr (first, last - first + 1);
+}
+
+
+//! Appends line number, which has to be known.
+void
+append_line (tstring & output, int line)
+{
+    tstring & tmp = internal::get_ptd ()->faa_str;
+    helpers::convertIntegerToString (tmp, line);
+    output += tmp;
+}
+
+
+//! Appends sequence number, which has to be assigned.
+void
+append_sequence (tstring & output, std::uint64_t seq)
+{
+    tstring & tmp = internal::get_ptd ()->faa_str;
+    helpers::convertIntegerToString (tmp, seq);
+    output += tmp;
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// StructuredLayout
+///////////////////////////////////////////////////////////////////////////////
+
+StructuredLayout::StructuredLayout()
+{
+    for (std::size_t i = 0; i != field_count; ++i)
+        addField (static_cast<Field> (i), field_names[i]);
+    initDateFormat (default_date_format, true);
+}
+
+
+StructuredLayout::StructuredLayout(const helpers::Properties& properties)
+    : Layout(properties)
+{
+    bool use_gmtime = true;
+    properties.getBool (use_gmtime, LOG4CPLUS_TEXT("Use_gmtime"));
+    initDateFormat (properties.getProperty (LOG4CPLUS_TEXT("DateFormat"),
+            default_date_format), use_gmtime);
+
+    helpers::Properties const names
+        = properties.getPropertySubset (LOG4CPLUS_TEXT("FieldName."));
+    auto add = [&] (std::size_t field) {
+        addField (static_cast<Field> (field),
+            names.getProperty (field_names[field], field_names[field]));
+    };
+
+    tstring const & list = properties.getProperty (LOG4CPLUS_TEXT("Fields"));
+    if (list.empty ())
+    {
+        for (std::size_t i = 0; i != field_count; ++i)
+            add (i);
+        return;
+    }
+
+    std::vector<tstring> tokens;
+    helpers::tokenize (list, LOG4CPLUS_TEXT(','),
+        std::back_inserter (tokens));
+    for (tstring const & token : tokens)
+    {
+        tstring_view const name = trim_spaces (token);
+        if (name.empty ())
+            continue;
+
+        std::size_t field = 0;
+        while (field != field_count && name != field_names[field])
+            ++field;
+
+        if (field != field_count)
+            add (field);
+        else
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("StructuredLayout- Unknown field: ")
+                + tstring (name));
+    }
+}
+
+
+StructuredLayout::~StructuredLayout() = default;
+
+
+void
+StructuredLayout::addField(Field field, tstring const & name)
+{
+    fields.push_back (FieldSpec {field, name});
+    requiredEventFields |= field_event_fields[field];
+}
+
+
+void
+StructuredLayout::initDateFormat(tstring const & dateFormat, bool use_gmtime)
+{
+    dateLayout = std::make_unique<PatternLayout> (
+        (use_gmtime ? LOG4CPLUS_TEXT ("%d{") : LOG4CPLUS_TEXT ("%D{"))
+        + dateFormat + LOG4CPLUS_TEXT ('}'));
+}
+
+
+void
+StructuredLayout::formatAndAppend(tostream& output,
+    const spi::InternalLoggingEvent& event)
+{
+    tstring & buffer = internal::get_ptd ()->layout_str;
+    internal::clear_thread_buffer (buffer);
+    formatAndAppend (buffer, event);
+    output.write (buffer.data (),
+        static_cast<std::streamsize>(buffer.size ()));
+}
+
+
+unsigned
+StructuredLayout::getRequiredEventFields() const
+{
+    return requiredEventFields;
+}
+
+
+std::vector<StructuredLayout::FieldSpec> const &
+StructuredLayout::getFields() const
+{
+    return fields;
+}
+
+
+void
+StructuredLayout::appendTimestamp(tstring& output,
+    const spi::InternalLoggingEvent& event) const
+{
+    dateLayout->formatAndAppend (output, event);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// JsonLayout
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+//! Appends separator and <code>key</code> of next member of the object.
+void
+append_json_key (tstring & output, tstring const & key)
+{
+    if (output.back () != LOG4CPLUS_TEXT ('{'))
+        output += LOG4CPLUS_TEXT (',');
+    output += key;
+}
+
+
+void
+append_json_string_member (tstring & output, tstring const & key,
+    tstring_view value)
+{
+    append_json_key (output, key);
+    output += LOG4CPLUS_TEXT ('"');
+    append_json_escaped (output, value);
+    output += LOG4CPLUS_TEXT ('"');
+}
+
+} // namespace
+
+
+struct JsonLayout::Writers
+{
+    static
+    void
+    timestamp (JsonLayout const & layout, tstring & output,
+        tstring const & key, spi::InternalLoggingEvent const & event)
+    {
+        append_json_key (output, key);
+        output += LOG4CPLUS_TEXT ('"');
+        std::size_t const start = output.size ();
+        layout.appendTimestamp (output, event);
+        requote_tail<json_special> (output, start, false,
+            append_json_escaped);
+        output += LOG4CPLUS_TEXT ('"');
+    }
+
+    static
+    void
+    level (JsonLayout const & layout, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        append_json_string_member (output, key,
+            layout.llmCache.toString (event.getLogLevel ()));
+    }
+
+    static
+    void
+    logger (JsonLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        append_json_string_member (output, key, event.getLoggerName ());
+    }
+
+    static
+    void
+    thread (JsonLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        append_json_string_member (output, key, event.getThread ());
+    }
+
+    static
+    void
+    ndc (JsonLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        tstring const & value = event.getNDC ();
+        if (! value.empty ())
+            append_json_string_member (output, key, value);
+    }
+
+    static
+    void
+    mdc (JsonLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        MappedDiagnosticContextMap const & map = event.getMDCCopy ();
+        if (map.empty ())
+            return;
+
+        append_json_key (output, key);
+        output += LOG4CPLUS_TEXT ('{');
+        for (auto const & kv : map)
+        {
+            if (output.back () != LOG4CPLUS_TEXT ('{'))
+                output += LOG4CPLUS_TEXT (',');
+            output += LOG4CPLUS_TEXT ('"');
+            append_json_escaped (output, kv.first);
+            output += LOG4CPLUS_TEXT ("\":\"");
+            append_json_escaped (output, kv.second);
+            output += LOG4CPLUS_TEXT ('"');
+        }
+        output += LOG4CPLUS_TEXT ('}');
+    }
+
+    static
+    void
+    kv (JsonLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        spi::KeyValues const & kvs = event.getKeyValues ();
+        if (kvs.empty ())
+            return;
+
+        append_json_key (output, key);
+        output += LOG4CPLUS_TEXT ('{');
+        for (std::size_t i = 0; i != kvs.size (); ++i)
+        {
+            spi::KeyValue const kv = kvs[i];
+            if (i != 0)
+                output += LOG4CPLUS_TEXT (',');
+            output += LOG4CPLUS_TEXT ('"');
+            append_json_escaped (output, kv.key);
+            output += LOG4CPLUS_TEXT ("\":");
+            if (kv.type == spi::KV_STRING)
+            {
+                output += LOG4CPLUS_TEXT ('"');
+                append_json_escaped (output, kv.str);
+                output += LOG4CPLUS_TEXT ('"');
+            }
+            // JSON has no representation of NaN and infinities.
+            else if (kv.type == spi::KV_DOUBLE && ! std::isfinite (kv.d))
+                output += LOG4CPLUS_TEXT ("null");
+            else
+                spi::KeyValues::appendValue (output, kv);
+        }
+        output += LOG4CPLUS_TEXT ('}');
+    }
+
+    static
+    void
+    file (JsonLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        tstring const & value = event.getFile ();
+        if (! value.empty ())
+            append_json_string_member (output, key, value);
+    }
+
+    static
+    void
+    line (JsonLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        if (event.getLine () == -1)
+            return;
+
+        append_json_key (output, key);
+        append_line (output, event.getLine ());
+    }
+
+    static
+    void
+    function (JsonLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        tstring const & value = event.getFunction ();
+        if (! value.empty ())
+            append_json_string_member (output, key, value);
+    }
+
+    static
+    void
+    message (JsonLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        append_json_string_member (output, key, event.getMessage ());
+    }
+
+    static
+    void
+    stack (JsonLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        spi::StackTracePtr const & trace = event.getStackTrace ();
+        if (! trace || trace->size == 0)
+            return;
+
+        append_json_key (output, key);
+        output += LOG4CPLUS_TEXT ('[');
+        for (std::size_t i = 0; i != trace->size; ++i)
+        {
+            if (i != 0)
+                output += LOG4CPLUS_TEXT (',');
+            output += LOG4CPLUS_TEXT ('"');
+            append_json_escaped (output,
+                spi::symbolizeStackFrame (trace->frames[i]));
+            output += LOG4CPLUS_TEXT ('"');
+        }
+        output += LOG4CPLUS_TEXT (']');
+    }
+    static
+    void
+    seq (JsonLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        if (event.getSequenceNumber () == 0)
+            return;
+
+        append_json_key (output, key);
+        append_sequence (output, event.getSequenceNumber ());
+    }
+};
+
+
+JsonLayout::JsonLayout()
+{
+    init ();
+}
+
+
+JsonLayout::JsonLayout(const helpers::Properties& properties)
+    : StructuredLayout(properties)
+{
+    properties.getBool (ndjson, LOG4CPLUS_TEXT("NDJSON"));
+    init ();
+}
+
+
+JsonLayout::~JsonLayout() = default;
+
+
+void
+JsonLayout::init()
+{
+    static void (* const write[]) (JsonLayout const &, tstring &,
+        tstring const &, spi::InternalLoggingEvent const &) = {
+        Writers::timestamp,
+        Writers::level,
+        Writers::logger,
+        Writers::thread,
+        Writers::ndc,
+        Writers::mdc,
+        Writers::kv,
+        Writers::file,
+        Writers::line,
+        Writers::function,
+        Writers::message,
+        Writers::stack,
+        Writers::seq
+    };
+
+    // Keys are escaped once here instead of for every event.
+    for (FieldSpec const & spec : getFields ())
+    {
+        FieldWriter writer;
+        writer.write = write[spec.field];
+        writer.key = LOG4CPLUS_TEXT ('"');
+        append_json_escaped (writer.key, spec.name);
+        writer.key += LOG4CPLUS_TEXT ("\":");
+        writers.push_back (std::move (writer));
+    }
+}
+
+
+void
+JsonLayout::formatAndAppend(tstring& output,
+    const spi::InternalLoggingEvent& event)
+{
+    output += LOG4CPLUS_TEXT ('{');
+    for (FieldWriter const & writer : writers)
+        writer.write (*this, output, writer.key, event);
+    output += LOG4CPLUS_TEXT ('}');
+    if (ndjson)
+        output += LOG4CPLUS_TEXT ('\n');
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LogfmtLayout
+///////////////////////////////////////////////////////////////////////////////
+
+struct LogfmtLayout::Writers
+{
+    static
+    void
+    timestamp (LogfmtLayout const & layout, tstring & output,
+        tstring const & key, spi::InternalLoggingEvent const & event)
+    {
+        output += key;
+        std::size_t const start = output.size ();
+        layout.appendTimestamp (output, event);
+        requote_tail<logfmt_special> (output, start, true,
+            append_logfmt_value);
+    }
+
+    static
+    void
+    level (LogfmtLayout const & layout, tstring & output,
+        tstring const & key, spi::InternalLoggingEvent const & event)
+    {
+        output += key;
+        append_logfmt_value (output,
+            layout.llmCache.toString (event.getLogLevel ()));
+    }
+
+    static
+    void
+    logger (LogfmtLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        output += key;
+        append_logfmt_value (output, event.getLoggerName ());
+    }
+
+    static
+    void
+    thread (LogfmtLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        output += key;
+        append_logfmt_value (output, event.getThread ());
+    }
+
+    static
+    void
+    ndc (LogfmtLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        tstring const & value = event.getNDC ();
+        if (value.empty ())
+            return;
+
+        output += key;
+        append_logfmt_value (output, value);
+    }
+
+    static
+    void
+    mdc (LogfmtLayout const &, tstring & output, tstring const & prefix,
+        spi::InternalLoggingEvent const & event)
+    {
+        for (auto const & kv : event.getMDCCopy ())
+        {
+            output += prefix;
+            append_logfmt_key (output, kv.first);
+            output += LOG4CPLUS_TEXT ('=');
+            append_logfmt_value (output, kv.second);
+        }
+    }
+
+    static
+    void
+    kv (LogfmtLayout const &, tstring & output, tstring const & prefix,
+        spi::InternalLoggingEvent const & event)
+    {
+        spi::KeyValues const & kvs = event.getKeyValues ();
+        for (std::size_t i = 0; i != kvs.size (); ++i)
+        {
+            spi::KeyValue const kv = kvs[i];
+            output += prefix;
+            append_logfmt_key (output, kv.key);
+            output += LOG4CPLUS_TEXT ('=');
+            // Text of numbers and booleans never needs quoting.
+            if (kv.type == spi::KV_STRING)
+                append_logfmt_value (output, kv.str);
+            else
+                spi::KeyValues::appendValue (output, kv);
+        }
+    }
+
+    static
+    void
+    file (LogfmtLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        tstring const & value = event.getFile ();
+        if (value.empty ())
+            return;
+
+        output += key;
+        append_logfmt_value (output, value);
+    }
+
+    static
+    void
+    line (LogfmtLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        if (event.getLine () == -1)
+            return;
+
+        output += key;
+        append_line (output, event.getLine ());
+    }
+
+    static
+    void
+    function (LogfmtLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        tstring const & value = event.getFunction ();
+        if (value.empty ())
+            return;
+
+        output += key;
+        append_logfmt_value (output, value);
+    }
+
+    static
+    void
+    message (LogfmtLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        output += key;
+        append_logfmt_value (output, event.getMessage ());
+    }
+
+    static
+    void
+    stack (LogfmtLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        spi::StackTracePtr const & trace = event.getStackTrace ();
+        if (! trace || trace->size == 0)
+            return;
+
+        tstring frames;
+        for (std::size_t i = 0; i != trace->size; ++i)
+        {
+            if (i != 0)
+                frames += LOG4CPLUS_TEXT (';');
+            frames += spi::symbolizeStackFrame (trace->frames[i]);
+        }
+
+        output += key;
+        append_logfmt_value (output, frames);
+    }
+    static
+    void
+    seq (LogfmtLayout const &, tstring & output, tstring const & key,
+        spi::InternalLoggingEvent const & event)
+    {
+        if (event.getSequenceNumber () == 0)
+            return;
+
+        output += key;
+        append_sequence (output, event.getSequenceNumber ());
+    }
+};
+
+
+LogfmtLayout::LogfmtLayout()
+{
+    init ();
+}
+
+
+LogfmtLayout::LogfmtLayout(const helpers::Properties& properties)
+    : StructuredLayout(properties)
+{
+    init ();
+}
+
+
+LogfmtLayout::~LogfmtLayout() = default;
+
+
+void
+LogfmtLayout::init()
+{
+    static void (* const write[]) (LogfmtLayout const &, tstring &,
+        tstring const &, spi::InternalLoggingEvent const &) = {
+        Writers::timestamp,
+        Writers::level,
+        Writers::logger,
+        Writers::thread,
+        Writers::ndc,
+        Writers::mdc,
+        Writers::kv,
+        Writers::file,
+        Writers::line,
+        Writers::function,
+        Writers::message,
+        Writers::stack,
+        Writers::seq
+    };
+
+    // Every pair starts with a space; formatAndAppend() drops the first
+    // one.
+    for (FieldSpec const & spec : getFields ())
+    {
+        FieldWriter writer;
+        writer.write = write[spec.field];
+        writer.key = LOG4CPLUS_TEXT (' ');
+        if (spec.field != MDC_FIELD && spec.field != KV_FIELD)
+        {
+            append_logfmt_key (writer.key, spec.name);
+            writer.key += LOG4CPLUS_TEXT ('=');
+        }
+        else if (! spec.name.empty ())
+        {
+            append_logfmt_key (writer.key, spec.name);
+            writer.key += LOG4CPLUS_TEXT ('.');
+        }
+        writers.push_back (std::move (writer));
+    }
+}
+
+
+void
+LogfmtLayout::formatAndAppend(tstring& output,
+    const spi::InternalLoggingEvent& event)
+{
+    std::size_t const start = output.size ();
+    for (FieldWriter const & writer : writers)
+        writer.write (*this, output, writer.key, event);
+    if (output.size () != start)
+        output.erase (start, 1);
+    output += LOG4CPLUS_TEXT ('\n');
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("JSON escaping", "[layout]")
+{
+    auto const escape = [] (tstring_view str)
+    {
+        tstring result;
+        append_json_escaped (result, str);
+        return result;
+    };
+
+    CATCH_REQUIRE (escape (LOG4CPLUS_TEXT ("")).empty ());
+    CATCH_REQUIRE (escape (LOG4CPLUS_TEXT ("plain text"))
+        == LOG4CPLUS_TEXT ("plain text"));
+    CATCH_REQUIRE (escape (LOG4CPLUS_TEXT ("say \"hi\"\\"))
+        == LOG4CPLUS_TEXT ("say \\\"hi\\\"\\\\"));
+    CATCH_REQUIRE (escape (LOG4CPLUS_TEXT ("a\nb\r\tc\b\f"))
+        == LOG4CPLUS_TEXT ("a\\nb\\r\\tc\\b\\f"));
+    CATCH_REQUIRE (escape (tstring_view (LOG4CPLUS_TEXT ("\x01\0\x1f\x7f"), 4))
+        == LOG4CPLUS_TEXT ("\\u0001\\u0000\\u001f\x7f"));
+
+    // Every position within and around the blocks checked at once.
+    tstring const clean (3 * char_block + 5, LOG4CPLUS_TEXT ('x'));
+    CATCH_REQUIRE (escape (clean) == clean);
+    for (std::size_t i = 0; i != clean.size (); ++i)
+        for (tchar const ch : {LOG4CPLUS_TEXT ('"'), LOG4CPLUS_TEXT ('\\'),
+                LOG4CPLUS_TEXT ('\n'), LOG4CPLUS_TEXT ('\x1f')})
+        {
+            tstring str (clean);
+            str[i] = ch;
+            tstring expected (clean, 0, i);
+            tchar const one[] = { ch };
+            expected += escape (tstring_view (one, 1));
+            expected.append (clean, i + 1);
+            CATCH_REQUIRE (expected.size () > clean.size ());
+            CATCH_REQUIRE (escape (str) == expected);
+        }
+
+    // Characters just outside of escaped ranges and, for wide
+    // characters, with bits of escaped ones in their upper bytes.
+    tchar const others[] = {
+        LOG4CPLUS_TEXT (' '), LOG4CPLUS_TEXT ('!'), LOG4CPLUS_TEXT ('#'),
+        LOG4CPLUS_TEXT ('['), LOG4CPLUS_TEXT (']'), static_cast<tchar> (0x7f),
+        static_cast<tchar> (0x80), static_cast<tchar> (0xA2),
+        static_cast<tchar> (0xDC), static_cast<tchar> (0xFF)
+#if defined (UNICODE)
+        , static_cast<tchar> (0x2200), static_cast<tchar> (0x5C00),
+        static_cast<tchar> (0x0122), static_cast<tchar> (0x1F5C),
+        static_cast<tchar> (0xFFFF)
+#endif
+    };
+    for (tchar const ch : others)
+    {
+        tstring const str (2 * char_block, ch);
+        CATCH_REQUIRE (escape (str) == str);
+    }
+}
+
+
+CATCH_TEST_CASE ("JsonLayout", "[layout]")
+{
+    MappedDiagnosticContextMap mdc;
+    mdc[LOG4CPLUS_TEXT ("key")] = LOG4CPLUS_TEXT ("value");
+    mdc[LOG4CPLUS_TEXT ("q\"")] = LOG4CPLUS_TEXT ("a\nb");
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("app.db"),
+        WARN_LOG_LEVEL, LOG4CPLUS_TEXT ("outer inner"), mdc,
+        LOG4CPLUS_TEXT ("Connected to \"db1\".\n"), LOG4CPLUS_TEXT ("1234"),
+        LOG4CPLUS_TEXT ("worker"),
+        helpers::from_time_t (1700000000) + std::chrono::microseconds (7000),
+        LOG4CPLUS_TEXT ("src/db.cxx"), 42, LOG4CPLUS_TEXT ("connect"));
+    spi::InternalLoggingEvent const bare (LOG4CPLUS_TEXT ("app"),
+        INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("hi"), nullptr, -1, nullptr);
+
+    auto const format = [] (Layout & layout,
+        spi::InternalLoggingEvent const & event)
+    {
+        tstring result (LOG4CPLUS_TEXT ("prefix "));
+        layout.formatAndAppend (result, event);
+        return result;
+    };
+
+    {
+        JsonLayout layout;
+        CATCH_REQUIRE (format (layout, ev) == LOG4CPLUS_TEXT ("prefix "
+                "{\"timestamp\":\"2023-11-14T22:13:20.007Z\","
+                "\"level\":\"WARN\",\"logger\":\"app.db\",\"thread\":\"1234\","
+                "\"ndc\":\"outer inner\","
+                "\"mdc\":{\"key\":\"value\",\"q\\\"\":\"a\\nb\"},"
+                "\"file\":\"src/db.cxx\",\"line\":42,\"function\":\"connect\","
+                "\"message\":\"Connected to \\\"db1\\\".\\n\"}\n"));
+        CATCH_REQUIRE (layout.getRequiredEventFields ()
+            == (spi::EVENT_FIELD_THREAD | spi::EVENT_FIELD_NDC
+                | spi::EVENT_FIELD_MDC | spi::EVENT_FIELD_FILE
+                | spi::EVENT_FIELD_FUNCTION));
+
+        tostringstream oss;
+        layout.formatAndAppend (oss, ev);
+        CATCH_REQUIRE (LOG4CPLUS_TEXT ("prefix ") + oss.str ()
+            == format (layout, ev));
+    }
+
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("Fields"),
+            LOG4CPLUS_TEXT (" message, level,line ,ndc,mdc,file,function"));
+        props.setProperty (LOG4CPLUS_TEXT ("FieldName.message"),
+            LOG4CPLUS_TEXT ("msg"));
+        props.setProperty (LOG4CPLUS_TEXT ("FieldName.level"),
+            LOG4CPLUS_TEXT ("log.\"level\""));
+        props.setProperty (LOG4CPLUS_TEXT ("NDJSON"),
+            LOG4CPLUS_TEXT ("false"));
+        JsonLayout layout (props);
+        CATCH_REQUIRE (format (layout, bare) == LOG4CPLUS_TEXT ("prefix "
+                "{\"msg\":\"hi\",\"log.\\\"level\\\"\":\"INFO\"}"));
+        CATCH_REQUIRE (layout.getRequiredEventFields ()
+            == (spi::EVENT_FIELD_NDC | spi::EVENT_FIELD_MDC
+                | spi::EVENT_FIELD_FILE | spi::EVENT_FIELD_FUNCTION));
+    }
+
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("Fields"),
+            LOG4CPLUS_TEXT ("timestamp,logger"));
+        props.setProperty (LOG4CPLUS_TEXT ("DateFormat"),
+            LOG4CPLUS_TEXT ("%H \"%q\""));
+        JsonLayout layout (props);
+        CATCH_REQUIRE (format (layout, ev) == LOG4CPLUS_TEXT ("prefix "
+                "{\"timestamp\":\"22 \\\"007\\\"\","
+                "\"logger\":\"app.db\"}\n"));
+        CATCH_REQUIRE (layout.getRequiredEventFields ()
+            == spi::EVENT_FIELDS_NONE);
+    }
+
+    {
+        spi::InternalLoggingEvent kvev (bare);
+        spi::KeyValues & kvs = kvev.getKeyValues ();
+        kvs.add (LOG4CPLUS_TEXT ("user"), 42);
+        kvs.add (LOG4CPLUS_TEXT ("latency"), 1.5);
+        kvs.add (LOG4CPLUS_TEXT ("ok"), true);
+        kvs.add (LOG4CPLUS_TEXT ("nan"), std::nan (""));
+        kvs.add (LOG4CPLUS_TEXT ("q\""), LOG4CPLUS_TEXT ("a\nb"));
+
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("Fields"),
+            LOG4CPLUS_TEXT ("kv,message"));
+        JsonLayout layout (props);
+        CATCH_REQUIRE (format (layout, kvev) == LOG4CPLUS_TEXT ("prefix "
+                "{\"kv\":{\"user\":42,\"latency\":1.5,\"ok\":true,"
+                "\"nan\":null,\"q\\\"\":\"a\\nb\"},\"message\":\"hi\"}\n"));
+        CATCH_REQUIRE (format (layout, bare) == LOG4CPLUS_TEXT ("prefix "
+                "{\"message\":\"hi\"}\n"));
+    }
+
+    {
+        spi::InternalLoggingEvent seqev (bare);
+        seqev.setSequenceNumber (1025);
+
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("Fields"),
+            LOG4CPLUS_TEXT ("seq,message"));
+        JsonLayout layout (props);
+        CATCH_REQUIRE (format (layout, seqev) == LOG4CPLUS_TEXT ("prefix "
+                "{\"seq\":1025,\"message\":\"hi\"}\n"));
+        CATCH_REQUIRE (format (layout, bare) == LOG4CPLUS_TEXT ("prefix "
+                "{\"message\":\"hi\"}\n"));
+    }
+}
+
+
+CATCH_TEST_CASE ("logfmt quoting", "[layout]")
+{
+    auto const value = [] (tstring_view str)
+    {
+        tstring result;
+        append_logfmt_value (result, str);
+        return result;
+    };
+
+    CATCH_REQUIRE (value (LOG4CPLUS_TEXT ("")) == LOG4CPLUS_TEXT ("\"\""));
+    CATCH_REQUIRE (value (LOG4CPLUS_TEXT ("plain")) == LOG4CPLUS_TEXT ("plain"));
+    CATCH_REQUIRE (value (LOG4CPLUS_TEXT ("two words"))
+        == LOG4CPLUS_TEXT ("\"two words\""));
+    CATCH_REQUIRE (value (LOG4CPLUS_TEXT ("a=b")) == LOG4CPLUS_TEXT ("\"a=b\""));
+    CATCH_REQUIRE (value (LOG4CPLUS_TEXT ("say \"hi\"\n"))
+        == LOG4CPLUS_TEXT ("\"say \\\"hi\\\"\\n\""));
+    CATCH_REQUIRE (value (LOG4CPLUS_TEXT ("C:\\dir"))
+        == LOG4CPLUS_TEXT ("\"C:\\\\dir\""));
+
+    tstring const clean (3 * char_block + 5, LOG4CPLUS_TEXT ('x'));
+    CATCH_REQUIRE (value (clean) == clean);
+    for (std::size_t i = 0; i != clean.size (); ++i)
+        for (tchar const ch : {LOG4CPLUS_TEXT (' '), LOG4CPLUS_TEXT ('='),
+                LOG4CPLUS_TEXT ('"'), LOG4CPLUS_TEXT ('\\'),
+                LOG4CPLUS_TEXT ('\t')})
+        {
+            tstring str (clean);
+            str[i] = ch;
+            tstring const quoted = value (str);
+            CATCH_REQUIRE (quoted.front () == LOG4CPLUS_TEXT ('"'));
+            CATCH_REQUIRE (quoted.back () == LOG4CPLUS_TEXT ('"'));
+
+            tstring key;
+            append_logfmt_key (key, str);
+            str[i] = LOG4CPLUS_TEXT ('_');
+            CATCH_REQUIRE (key == str);
+        }
+
+    for (tchar const ch : {LOG4CPLUS_TEXT ('!'), LOG4CPLUS_TEXT ('<'),
+            LOG4CPLUS_TEXT ('>'), LOG4CPLUS_TEXT (']'),
+            static_cast<tchar> (0x7f), static_cast<tchar> (0xBD)})
+    {
+        tstring const str (2 * char_block, ch);
+        CATCH_REQUIRE (value (str) == str);
+    }
+}
+
+
+CATCH_TEST_CASE ("LogfmtLayout", "[layout]")
+{
+    MappedDiagnosticContextMap mdc;
+    mdc[LOG4CPLUS_TEXT ("user")] = LOG4CPLUS_TEXT ("alice");
+    mdc[LOG4CPLUS_TEXT ("bad key")] = LOG4CPLUS_TEXT ("");
+    spi::InternalLoggingEvent const ev (LOG4CPLUS_TEXT ("app.db"),
+        WARN_LOG_LEVEL, LOG4CPLUS_TEXT ("outer inner"), mdc,
+        LOG4CPLUS_TEXT ("Connected to \"db1\"."), LOG4CPLUS_TEXT ("1234"),
+        LOG4CPLUS_TEXT ("worker"),
+        helpers::from_time_t (1700000000) + std::chrono::microseconds (7000),
+        LOG4CPLUS_TEXT ("src/db.cxx"), 42, LOG4CPLUS_TEXT ("connect"));
+
+    auto const format = [] (Layout & layout,
+        spi::InternalLoggingEvent const & event)
+    {
+        tstring result (LOG4CPLUS_TEXT ("prefix "));
+        layout.formatAndAppend (result, event);
+        return result;
+    };
+
+    {
+        LogfmtLayout layout;
+        CATCH_REQUIRE (format (layout, ev) == LOG4CPLUS_TEXT ("prefix "
+                "timestamp=2023-11-14T22:13:20.007Z level=WARN logger=app.db "
+                "thread=1234 ndc=\"outer inner\" mdc.bad_key=\"\" "
+                "mdc.user=alice file=src/db.cxx line=42 function=connect "
+                "message=\"Connected to \\\"db1\\\".\"\n"));
+        CATCH_REQUIRE (layout.getRequiredEventFields ()
+            == (spi::EVENT_FIELD_THREAD | spi::EVENT_FIELD_NDC
+                | spi::EVENT_FIELD_MDC | spi::EVENT_FIELD_FILE
+                | spi::EVENT_FIELD_FUNCTION));
+
+        tostringstream oss;
+        layout.formatAndAppend (oss, ev);
+        CATCH_REQUIRE (LOG4CPLUS_TEXT ("prefix ") + oss.str ()
+            == format (layout, ev));
+    }
+
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("Fields"),
+            LOG4CPLUS_TEXT ("timestamp,mdc,message"));
+        props.setProperty (LOG4CPLUS_TEXT ("FieldName.timestamp"),
+            LOG4CPLUS_TEXT ("ts"));
+        props.setProperty (LOG4CPLUS_TEXT ("FieldName.mdc"),
+            LOG4CPLUS_TEXT (""));
+        props.setProperty (LOG4CPLUS_TEXT ("FieldName.message"),
+            LOG4CPLUS_TEXT ("the msg"));
+        props.setProperty (LOG4CPLUS_TEXT ("DateFormat"),
+            LOG4CPLUS_TEXT ("%H:%M:%S %q"));
+        LogfmtLayout layout (props);
+        CATCH_REQUIRE (format (layout, ev) == LOG4CPLUS_TEXT ("prefix "
+                "ts=\"22:13:20 007\" bad_key=\"\" user=alice "
+                "the_msg=\"Connected to \\\"db1\\\".\"\n"));
+    }
+
+    {
+        spi::InternalLoggingEvent kvev (ev);
+        spi::KeyValues & kvs = kvev.getKeyValues ();
+        kvs.add (LOG4CPLUS_TEXT ("user id"), 42u);
+        kvs.add (LOG4CPLUS_TEXT ("latency"), -0.5);
+        kvs.add (LOG4CPLUS_TEXT ("name"), LOG4CPLUS_TEXT ("a b"));
+
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("Fields"),
+            LOG4CPLUS_TEXT ("level,kv"));
+        LogfmtLayout layout (props);
+        CATCH_REQUIRE (format (layout, kvev) == LOG4CPLUS_TEXT ("prefix "
+                "level=WARN kv.user_id=42 kv.latency=-0.5 "
+                "kv.name=\"a b\"\n"));
+
+        props.setProperty (LOG4CPLUS_TEXT ("FieldName.kv"),
+            LOG4CPLUS_TEXT (""));
+        LogfmtLayout bare_keys (props);
+        CATCH_REQUIRE (format (bare_keys, kvev) == LOG4CPLUS_TEXT ("prefix "
+                "level=WARN user_id=42 latency=-0.5 name=\"a b\"\n"));
+    }
+}
+#endif
+
+} // namespace log4cplus
@@ -26,7 +26,28 @@
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/internal/env.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
+#include <chrono>
+#include <vector>
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/helpers/socketbuffer.h>
+#include <catch.hpp>
+#include <cstdio>
+#if defined (LOG4CPLUS_HAVE_SYS_UN_H)
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#endif
 
 #if defined (LOG4CPLUS_HAVE_SYSLOG_H)
 #include <syslog.h>
@@ -224,6 +245,196 @@ substrOrNil(tstring const & str, tstring::size_type const limit)
 } // namespace
 
 
+namespace internal
+{
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+//! Queue of remote syslog messages with its own sender thread. The
+//! logging threads only append to the queue, the sender thread owns
+//! the socket, reconnects it and writes whole queue at once.
+struct syslog_sender
+{
+    syslog_sender (tstring const & host_, int port_, bool udp_,
+        bool ipv6_, std::size_t limit_)
+        : host (host_)
+        , port (static_cast<unsigned short>(port_))
+        , udp (udp_)
+        , ipv6 (ipv6_)
+        , limit (limit_)
+    {
+        thread = std::thread ([this] { run (); });
+    }
+
+    ~syslog_sender ()
+    {
+        stop ();
+    }
+
+    //! Appends message to the queue or drops it when the queue is full.
+    void
+    enqueue (std::string_view header, std::string_view msg)
+    {
+        std::size_t const size = header.size () + msg.size ();
+        std::unique_lock<std::mutex> lock (mtx);
+        if (exit || stats.queuedBytes + size > limit)
+        {
+            ++stats.dropped;
+            return;
+        }
+
+        bool const wake = queue.empty ();
+        queue.append (header);
+        queue.append (msg);
+        ends.push_back (queue.size ());
+        stats.queuedBytes += size;
+        lock.unlock ();
+
+        if (wake)
+            cond.notify_one ();
+    }
+
+    //! Sends whatever is queued and joins the sender thread.
+    void
+    stop ()
+    {
+        {
+            std::lock_guard<std::mutex> lock (mtx);
+            exit = true;
+        }
+        cond.notify_one ();
+
+        if (thread.joinable ())
+            thread.join ();
+    }
+
+    SysLogAppender::RemoteQueueStats
+    getStats () const
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        return stats;
+    }
+
+private:
+    void
+    run ()
+    {
+        thread::blockAllSignals ();
+        thread::applyBackgroundThreadSettings (LOG4CPLUS_TEXT ("syslog"));
+
+        std::string batch;
+        std::vector<std::size_t> batchEnds;
+        std::unique_lock<std::mutex> lock (mtx);
+        for (;;)
+        {
+            cond.wait (lock, [this] { return exit || ! queue.empty (); });
+            if (queue.empty ())
+                break;
+
+            // Take the whole queue; the emptied batch buffers become
+            // the new queue, so their capacity is reused.
+            batch.clear ();
+            batchEnds.clear ();
+            batch.swap (queue);
+            batchEnds.swap (ends);
+            stats.queuedBytes = 0;
+            lock.unlock ();
+
+            bool const ok = send (batch, batchEnds);
+
+            lock.lock ();
+            (ok ? stats.sent : stats.failed) += batchEnds.size ();
+        }
+
+        lock.unlock ();
+        socket.close ();
+    }
+
+    bool
+    connect ()
+    {
+        auto const now = std::chrono::steady_clock::now ();
+        if (now < nextConnect)
+            return false;
+
+        socket = helpers::Socket (host, port, udp, ipv6);
+        if (socket.isOpen ())
+            return true;
+
+        // Do not hammer unreachable server, messages queued while
+        // waiting for the next attempt are lost.
+        nextConnect = now + std::chrono::seconds (1);
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("SysLogAppender")
+            LOG4CPLUS_TEXT ("- failed to connect to ")
+            + host + LOG4CPLUS_TEXT (":")
+            + helpers::convertIntegerToString (port));
+        return false;
+    }
+
+    bool
+    send (std::string const & batch, std::vector<std::size_t> const & batchEnds)
+    {
+        if (! socket.isOpen () && ! connect ())
+            return false;
+
+        bool ret;
+        if (udp)
+        {
+            datagrams.clear ();
+            std::size_t begin = 0;
+            for (std::size_t end : batchEnds)
+            {
+                datagrams.emplace_back (batch.data () + begin, end - begin);
+                begin = end;
+            }
+
+            ret = socket.writeDatagrams (datagrams);
+        }
+        else
+        {
+            // Octet counted frames are self delimiting, the whole
+            // batch goes out with single write.
+            ret = socket.write (batch);
+        }
+
+        if (! ret)
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("SysLogAppender")
+                LOG4CPLUS_TEXT ("- socket write failed"));
+
+        return ret;
+    }
+
+    tstring const host;
+    unsigned short const port;
+    bool const udp;
+    bool const ipv6;
+    std::size_t const limit;
+
+    // Accessed by sender thread only.
+    helpers::Socket socket;
+    std::chrono::steady_clock::time_point nextConnect;
+    std::vector<std::string_view> datagrams;
+
+    mutable std::mutex mtx;
+    std::condition_variable cond;
+    std::string queue;
+    //! End offsets of messages in queue.
+    std::vector<std::size_t> ends;
+    SysLogAppender::RemoteQueueStats stats;
+    bool exit = false;
+    std::thread thread;
+};
+
+#else
+struct syslog_sender
+{ };
+
+#endif
+
+} // namespace internal
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // SysLogAppender ctors and dtor
 ///////////////////////////////////////////////////////////////////////////////
@@ -266,14 +477,26 @@ SysLogAppender::SysLogAppender(const helpers::Properties & properties)
     remoteSyslogType = udp ? RSTUdp : RSTTcp;
 
     properties.getBool (ipv6, LOG4CPLUS_TEXT ("IPv6"));
+    properties.getBool (asyncConnect, LOG4CPLUS_TEXT ("AsyncConnect"));
 
     bool fqdn = true;
     properties.getBool (fqdn, LOG4CPLUS_TEXT ("fqdn"));
     hostname = std::move(helpers::getHostname (fqdn).value_or (LOG4CPLUS_C_STR_TO_TSTRING ("-")));
+    initRemoteHeader ();
 
     properties.getString (host, LOG4CPLUS_TEXT ("host"))
       || properties.getString (host, LOG4CPLUS_TEXT ("SyslogHost"));
-    if (host.empty ())
+    properties.getString (localSocket, LOG4CPLUS_TEXT ("LocalSocket"));
+
+    if (host.empty () && ! localSocket.empty ())
+    {
+        localRfc5424 = helpers::toLower (
+            properties.getProperty (LOG4CPLUS_TEXT ("LocalFormat")))
+            == LOG4CPLUS_TEXT ("rfc5424");
+        appendFunc = &SysLogAppender::appendLocalSocket;
+        openLocalSocket ();
+    }
+    else if (host.empty ())
     {
 #if defined (LOG4CPLUS_HAVE_SYSLOG_H)
         appendFunc = &SysLogAppender::appendLocal;
@@ -292,7 +515,27 @@ SysLogAppender::SysLogAppender(const helpers::Properties & properties)
             port = 514;
 
         appendFunc = &SysLogAppender::appendRemote;
-        openSocket ();
+
+        unsigned long queueLimit = 0;
+        properties.getULong (queueLimit, LOG4CPLUS_TEXT ("QueueLimit"));
+        if (queueLimit != 0)
+        {
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+            // The sender thread connects on its own.
+            sender.reset (new internal::syslog_sender (host, port,
+                remoteSyslogType == RSTUdp, ipv6, queueLimit));
+            return;
+
+#else
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("SysLogAppender")
+                LOG4CPLUS_TEXT ("- QueueLimit is ignored in single threaded")
+                LOG4CPLUS_TEXT (" build"));
+#endif
+        }
+
+        if (! asyncConnect)
+            openSocket ();
         initConnector ();
     }
 }
@@ -315,7 +558,9 @@ SysLogAppender::SysLogAppender(const tstring& id, const tstring & h,
     , identStr(LOG4CPLUS_TSTRING_TO_STRING (id) )
     , hostname (helpers::getHostname (fqdn).value_or (LOG4CPLUS_C_STR_TO_TSTRING ("-")))
 {
-    openSocket ();
+    initRemoteHeader ();
+    if (! asyncConnect)
+        openSocket ();
     initConnector ();
 }
 
@@ -338,14 +583,23 @@ SysLogAppender::close()
         LOG4CPLUS_TEXT("Entering SysLogAppender::close()..."));
     thread::MutexGuard guard (access_mutex);
 
-    if (host.empty ())
+    if (appendFunc == &SysLogAppender::appendLocalSocket)
+        syslogSocket.close ();
+    else if (host.empty ())
     {
 #if defined (LOG4CPLUS_HAVE_SYSLOG_H)
         ::closelog();
 #endif
     }
     else
+    {
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        if (sender)
+            sender->stop ();
+#endif
+
         syslogSocket.close ();
+    }
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
     if (connector)
@@ -356,6 +610,18 @@ SysLogAppender::close()
 }
 
 
+SysLogAppender::RemoteQueueStats
+SysLogAppender::getRemoteQueueStats () const
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (sender)
+        return sender->getStats ();
+#endif
+
+    return RemoteQueueStats ();
+}
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // SysLogAppender protected methods
@@ -413,15 +679,27 @@ tstring const SysLogAppender::remoteTimeFormat (
     LOG4CPLUS_TEXT ("%Y-%m-%dT%H:%M:%S.%qZ"));
 
 
-void
-SysLogAppender::appendRemote(const spi::InternalLoggingEvent& event)
+namespace
 {
 
+//! Part of SysLogAppender::remoteTimeFormat before %q.
+tstring const remoteTimeSecondsFormat (
+    LOG4CPLUS_TEXT ("%Y-%m-%dT%H:%M:%S."));
+
+//! RFC3164 TIMESTAMP format, in local time.
+tstring const localTimeFormat (LOG4CPLUS_TEXT ("%b %e %H:%M:%S"));
+
+} // namespace
+
+
+bool
+SysLogAppender::ensureRemoteConnected ()
+{
     if (! connected)
     {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
         connector->trigger ();
-        return;
+        return false;
 
 #else
         openSocket ();
@@ -432,32 +710,62 @@ SysLogAppender::appendRemote(const spi::InternalLoggingEvent& event)
                 LOG4CPLUS_TEXT ("- failed to connect to ")
                 + host + LOG4CPLUS_TEXT (":")
                 + helpers::convertIntegerToString (port));
-            return;
+            return false;
         }
 #endif
     }
 
+    return true;
+}
+
+
+std::string_view
+SysLogAppender::formatRemote (const spi::InternalLoggingEvent& event)
+{
     int const level = getSysLogLevel(event.getLogLevel());
     internal::appender_sratch_pad & appender_sp = internal::get_appender_sp ();
     detail::clear_tostringstream (appender_sp.oss);
 
+    // TIMESTAMP is formatted once per second, only %q of
+    // remoteTimeFormat changes within the second.
+    helpers::Time const & timestamp = event.getTimestamp ();
+    time_t const seconds = helpers::to_time_t (timestamp);
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    internal::date_cache_entry & entry = internal::get_date_cache_entry (
+        ptd, timeCacheId, 1, seconds);
+    if (entry.seconds != seconds)
+    {
+        entry.parts[0] = helpers::getFormattedTime (
+            remoteTimeSecondsFormat, helpers::from_time_t (seconds), true);
+        entry.seconds = seconds;
+    }
+
+    tstring & q_str = ptd->gft_sp.q_str;
+    internal::build_q_value (q_str, helpers::microseconds_part (timestamp));
+
+    tstring const & logger = event.getLoggerName ();
+
     appender_sp.oss
         // PRI
         << LOG4CPLUS_TEXT ('<') << (level | facility) << LOG4CPLUS_TEXT ('>')
         // VERSION
-        << 1
+        << LOG4CPLUS_TEXT ("1 ")
         // TIMESTAMP
-        << LOG4CPLUS_TEXT (' ')
-        << helpers::getFormattedTime (remoteTimeFormat, event.getTimestamp (),
-            true)
-        // HOSTNAME
-        << LOG4CPLUS_TEXT (' ') << substrOrNil (hostname, 255)
-        // APP-NAME
-        << LOG4CPLUS_TEXT (' ') << substrOrNil (ident, 48)
-        // PROCID
-        << LOG4CPLUS_TEXT (' ') << internal::get_process_id ()
+        << entry.parts[0] << q_str << LOG4CPLUS_TEXT ('Z')
+        // HOSTNAME, APP-NAME
+        << remoteHeader
+        // PROCID, it changes across fork()
+        << internal::get_process_id ()
         // MSGID
-        << LOG4CPLUS_TEXT (' ') << substrOrNil (event.getLoggerName (), 32)
+        << LOG4CPLUS_TEXT (' ');
+    if (logger.empty ())
+        appender_sp.oss << LOG4CPLUS_TEXT ('-');
+    else
+        appender_sp.oss.write (logger.data (),
+            static_cast<std::streamsize>((std::min) (logger.size (),
+                    tstring::size_type (32))));
+
+    appender_sp.oss
         // STRUCTURED-DATA
         // no structured data, it could be whole MDC
         << LOG4CPLUS_TEXT (" - ");
@@ -465,20 +773,82 @@ SysLogAppender::appendRemote(const spi::InternalLoggingEvent& event)
     // MSG
     layout->formatAndAppend (appender_sp.oss, event);
 
-    appender_sp.chstr = LOG4CPLUS_TSTRING_TO_STRING (appender_sp.oss.str ());
+#if defined (UNICODE)
+    // RFC 5424 messages are UTF-8.
+    appender_sp.chstr2.clear ();
+    internal::append_utf8 (appender_sp.chstr2, appender_sp.oss.view ());
+    return appender_sp.chstr2;
+#else
+    return appender_sp.oss.view ();
+#endif
+}
+
+
+std::string_view
+SysLogAppender::formatLocal (const spi::InternalLoggingEvent& event)
+{
+    if (localRfc5424)
+        return formatRemote (event);
+
+    int const level = getSysLogLevel(event.getLogLevel());
+    internal::appender_sratch_pad & appender_sp = internal::get_appender_sp ();
+    detail::clear_tostringstream (appender_sp.oss);
 
-    if (remoteSyslogType != RSTUdp)
+    // RFC3164 TIMESTAMP has one second resolution, as syslog() sends it.
+    time_t const seconds = helpers::to_time_t (event.getTimestamp ());
+    internal::date_cache_entry & entry = internal::get_date_cache_entry (
+        internal::get_ptd (), timeCacheId, 1, seconds);
+    if (entry.seconds != seconds)
     {
-        // see (RFC6587, 3.4.1 Octet
-        // Counting)[http://tools.ietf.org/html/rfc6587#section-3.4.1]
-        std::string syslogFrameHeader (
-            helpers::convertIntegerToNarrowString (appender_sp.chstr.size ()));
-        syslogFrameHeader += ' ';
-        appender_sp.chstr.insert (appender_sp.chstr.begin (),
-            syslogFrameHeader.begin (), syslogFrameHeader.end ());
+        entry.parts[0] = helpers::getFormattedTime (localTimeFormat,
+            helpers::from_time_t (seconds), false);
+        entry.seconds = seconds;
     }
 
-    bool ret = syslogSocket.write (appender_sp.chstr);
+    appender_sp.oss
+        // PRI
+        << LOG4CPLUS_TEXT ('<') << (level | facility) << LOG4CPLUS_TEXT ('>')
+        // TIMESTAMP
+        << entry.parts[0] << LOG4CPLUS_TEXT (' ')
+        // TAG
+        << ident << LOG4CPLUS_TEXT ('[') << internal::get_process_id ()
+        << LOG4CPLUS_TEXT ("]: ");
+
+    // MSG
+    layout->formatAndAppend (appender_sp.oss, event);
+
+#if defined (UNICODE)
+    appender_sp.chstr2 = LOG4CPLUS_TSTRING_TO_STRING (appender_sp.oss.str ());
+    return appender_sp.chstr2;
+#else
+    return appender_sp.oss.view ();
+#endif
+}
+
+
+std::string
+SysLogAppender::frameHeader (std::string_view msg)
+{
+    // see (RFC6587, 3.4.1 Octet
+    // Counting)[http://tools.ietf.org/html/rfc6587#section-3.4.1]
+    std::string header (helpers::convertIntegerToNarrowString (msg.size ()));
+    header += ' ';
+    return header;
+}
+
+
+bool
+SysLogAppender::writeRemote (std::string const & data)
+{
+    std::string_view const view (data);
+    return writeRemote (std::span<std::string_view const> (&view, 1));
+}
+
+
+bool
+SysLogAppender::writeRemote (std::span<std::string_view const> data)
+{
+    bool ret = syslogSocket.write (data);
     if (! ret)
     {
         helpers::getLogLog ().warn (
@@ -491,6 +861,167 @@ SysLogAppender::appendRemote(const spi::InternalLoggingEvent& event)
         connector->trigger ();
 #endif
     }
+
+    return ret;
+}
+
+
+void
+SysLogAppender::appendRemote(const spi::InternalLoggingEvent& event)
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (sender)
+    {
+        std::string_view const msg = formatRemote (event);
+        if (remoteSyslogType == RSTUdp)
+            sender->enqueue (std::string_view (), msg);
+        else
+            sender->enqueue (frameHeader (msg), msg);
+
+        return;
+    }
+#endif
+
+    if (! ensureRemoteConnected ())
+        return;
+
+    // Header and message are sent with single gather write.
+    std::string_view const msg = formatRemote (event);
+    if (remoteSyslogType == RSTUdp)
+        writeRemote (std::span<std::string_view const> (&msg, 1));
+    else
+    {
+        std::string const header (frameHeader (msg));
+        std::string_view const frame[2] {header, msg};
+        writeRemote (frame);
+    }
+}
+
+
+void
+SysLogAppender::appendLocalSocket(const spi::InternalLoggingEvent& event)
+{
+    std::string_view const msg = formatLocal (event);
+    writeLocal (std::span<std::string_view const> (&msg, 1));
+}
+
+
+bool
+SysLogAppender::writeLocal (std::span<std::string_view const> datagrams)
+{
+    bool ret = syslogSocket.isOpen ()
+        && syslogSocket.writeDatagrams (datagrams);
+    if (! ret)
+    {
+        // The socket is invalid after syslog daemon restarts, the
+        // new connection goes to the new daemon.
+        openLocalSocket ();
+        ret = syslogSocket.isOpen ()
+            && syslogSocket.writeDatagrams (datagrams);
+    }
+
+    if (! ret)
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("SysLogAppender")
+            LOG4CPLUS_TEXT ("- write to local syslog socket failed"));
+
+    return ret;
+}
+
+
+void
+SysLogAppender::appendDatagrams (
+    std::span<spi::InternalLoggingEvent const> events)
+{
+    bool const local = appendFunc == &SysLogAppender::appendLocalSocket;
+    if (! local && ! ensureRemoteConnected ())
+        return;
+
+    // Format all messages into one buffer first, views into it can
+    // only be made once it does not grow anymore.
+    std::string & data = internal::get_appender_sp ().chstr;
+    data.clear ();
+    datagramEnds.clear ();
+    for (auto const & event : events)
+    {
+        data += local ? formatLocal (event) : formatRemote (event);
+        datagramEnds.push_back (data.size ());
+    }
+
+    datagramViews.clear ();
+    std::size_t begin = 0;
+    for (std::size_t end : datagramEnds)
+    {
+        datagramViews.emplace_back (data.data () + begin, end - begin);
+        begin = end;
+    }
+
+    if (local)
+        writeLocal (datagramViews);
+    else if (! syslogSocket.writeDatagrams (datagramViews))
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("SysLogAppender::appendRemote")
+            LOG4CPLUS_TEXT ("- socket write failed"));
+
+        connected = false;
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        connector->trigger ();
+#endif
+    }
+}
+
+
+// This method does not need to be locked since it is called by
+// syncDoAppendBatch() which performs the locking
+void
+SysLogAppender::appendBatch(
+    std::span<spi::InternalLoggingEvent const> events)
+{
+    // Datagrams of batch go out with single sendmmsg() where available.
+    if (appendFunc == &SysLogAppender::appendLocalSocket
+        || (appendFunc == &SysLogAppender::appendRemote
+            && remoteSyslogType == RSTUdp && ! sender))
+    {
+        appendDatagrams (events);
+        return;
+    }
+
+    // Octet counted TCP frames are coalesced into single write. Local
+    // syslog() calls are per event. Queued messages are coalesced by
+    // the sender thread.
+    if (appendFunc != &SysLogAppender::appendRemote
+        || sender)
+    {
+        Appender::appendBatch (events);
+        return;
+    }
+
+    if (! ensureRemoteConnected ())
+        return;
+
+    // Size of the batch after which accumulated frames are written.
+    std::size_t const batch_write_threshold = 64 * 1024;
+
+    std::string & frames = internal::get_appender_sp ().chstr;
+    frames.clear ();
+    for (auto const & event : events)
+    {
+        std::string_view const msg = formatRemote (event);
+        frames += frameHeader (msg);
+        frames += msg;
+        if (frames.size () >= batch_write_threshold)
+        {
+            if (! writeRemote (frames))
+                return;
+
+            frames.clear ();
+        }
+    }
+
+    if (! frames.empty ())
+        writeRemote (frames);
 }
 
 
@@ -513,7 +1044,7 @@ helpers::Socket
 SysLogAppender::ctcConnect ()
 {
     return helpers::Socket (host, static_cast<unsigned short>(port),
-        remoteSyslogType == RSTUdp);
+        remoteSyslogType == RSTUdp, ipv6);
 }
 
 
@@ -526,17 +1057,54 @@ SysLogAppender::ctcSetConnected ()
 #endif
 
 
+void
+SysLogAppender::initRemoteHeader ()
+{
+    timeCacheId = internal::new_date_cache_id ();
+
+    remoteHeader = LOG4CPLUS_TEXT (' ');
+    remoteHeader += substrOrNil (hostname, 255);
+    remoteHeader += LOG4CPLUS_TEXT (' ');
+    remoteHeader += substrOrNil (ident, 48);
+    remoteHeader += LOG4CPLUS_TEXT (' ');
+}
+
+
 void
 SysLogAppender::initConnector ()
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    connected = true;
+    // A failed synchronous connection is found out by the first write.
+    connected = syslogSocket.isOpen () || ! asyncConnect;
     connector = new helpers::ConnectorThread (*this);
     connector->start ();
+    if (! connected)
+        connector->trigger ();
 #endif
 }
 
 
+void
+SysLogAppender::openLocalSocket ()
+{
+    helpers::SocketState state = helpers::not_opened;
+    helpers::SOCKET_TYPE const sock = helpers::connectUnixSocket (
+        localSocket, true, state);
+    if (sock == helpers::INVALID_SOCKET_VALUE)
+    {
+        int const eno = errno;
+        syslogSocket = helpers::Socket ();
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("SysLogAppender")
+            LOG4CPLUS_TEXT ("- failed to connect to local socket ")
+            + localSocket + LOG4CPLUS_TEXT (": ")
+            + helpers::convertIntegerToString (eno));
+    }
+    else
+        syslogSocket = helpers::Socket (sock, state, 0);
+}
+
+
 void
 SysLogAppender::openSocket ()
 {
@@ -552,4 +1120,142 @@ SysLogAppender::openSocket ()
 }
 
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) \
+    && ! defined (LOG4CPLUS_SINGLE_THREADED)
+CATCH_TEST_CASE ("SysLogAppender queue", "[appender]")
+{
+    unsigned short const port = 29518;
+    int const count = 50;
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("host"), LOG4CPLUS_TEXT ("localhost"));
+    props.setProperty (LOG4CPLUS_TEXT ("port"),
+        helpers::convertIntegerToString (port));
+    props.setProperty (LOG4CPLUS_TEXT ("udp"), LOG4CPLUS_TEXT ("false"));
+
+    auto const event = [] (int i) {
+        return spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("test"),
+            INFO_LOG_LEVEL, helpers::convertIntegerToString (i), __FILE__,
+            __LINE__, nullptr);
+    };
+
+    CATCH_SECTION ("octet counted frames are sent by sender thread")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("QueueLimit"),
+            LOG4CPLUS_TEXT ("65536"));
+        helpers::ServerSocket server (port, false, false,
+            LOG4CPLUS_TEXT ("localhost"));
+        CATCH_REQUIRE (server.isOpen ());
+
+        SysLogAppender appender (props);
+        for (int i = 0; i != count; ++i)
+            appender.doAppend (event (i));
+        appender.close ();
+
+        SysLogAppender::RemoteQueueStats const stats
+            = appender.getRemoteQueueStats ();
+        CATCH_REQUIRE (stats.sent == static_cast<std::uint64_t>(count));
+        CATCH_REQUIRE (stats.dropped == 0);
+        CATCH_REQUIRE (stats.queuedBytes == 0);
+
+        helpers::Socket client = server.accept ();
+        CATCH_REQUIRE (client.isOpen ());
+        std::string data;
+        helpers::SocketBuffer byte (1);
+        while (client.read (byte))
+        {
+            data += byte.getBuffer ()[0];
+            byte.clear ();
+        }
+
+        std::vector<std::string> frames;
+        for (std::size_t pos = 0; pos < data.size (); )
+        {
+            std::size_t const space = data.find (' ', pos);
+            CATCH_REQUIRE (space != std::string::npos);
+            std::size_t const size = std::stoul (data.substr (pos, space - pos));
+            frames.push_back (data.substr (space + 1, size));
+            pos = space + 1 + size;
+        }
+        CATCH_REQUIRE (frames.size () == static_cast<std::size_t>(count));
+        // PRI, VERSION and TIMESTAMP with milliseconds in UTC.
+        CATCH_REQUIRE (frames.front ().substr (0, 6) == "<14>1 ");
+        CATCH_REQUIRE (frames.front ()[25] == '.');
+        CATCH_REQUIRE (frames.front ()[29] == 'Z');
+        CATCH_REQUIRE (frames.front ()[30] == ' ');
+        CATCH_REQUIRE (frames.back ().find (" - 49") != std::string::npos);
+    }
+
+    CATCH_SECTION ("messages over limit are dropped")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("QueueLimit"), LOG4CPLUS_TEXT ("1"));
+        SysLogAppender appender (props);
+        for (int i = 0; i != count; ++i)
+            appender.doAppend (event (i));
+        appender.close ();
+
+        SysLogAppender::RemoteQueueStats const stats
+            = appender.getRemoteQueueStats ();
+        CATCH_REQUIRE (stats.dropped == static_cast<std::uint64_t>(count));
+        CATCH_REQUIRE (stats.sent == 0);
+    }
+}
+
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) \
+    && defined (LOG4CPLUS_HAVE_SYS_UN_H)
+CATCH_TEST_CASE ("SysLogAppender local socket", "[appender]")
+{
+    char const path[] = "log4cplus-syslog-test.sock";
+    std::remove (path);
+
+    int const server = ::socket (AF_UNIX, SOCK_DGRAM, 0);
+    CATCH_REQUIRE (server >= 0);
+    struct sockaddr_un addr = sockaddr_un ();
+    addr.sun_family = AF_UNIX;
+    std::strcpy (addr.sun_path, path);
+    CATCH_REQUIRE (::bind (server, reinterpret_cast<struct sockaddr *>(&addr),
+            sizeof (addr)) == 0);
+
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("ident"), LOG4CPLUS_TEXT ("test"));
+    props.setProperty (LOG4CPLUS_TEXT ("LocalSocket"),
+        LOG4CPLUS_C_STR_TO_TSTRING (path));
+
+    auto const event = [] (tstring const & msg) {
+        return spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("test"),
+            INFO_LOG_LEVEL, msg, __FILE__, __LINE__, nullptr);
+    };
+
+    std::vector<std::string> received;
+    {
+        SysLogAppender appender (props);
+        appender.doAppend (event (LOG4CPLUS_TEXT ("single")));
+        spi::InternalLoggingEvent const batch[] {
+            event (LOG4CPLUS_TEXT ("a")), event (LOG4CPLUS_TEXT ("b")),
+            event (LOG4CPLUS_TEXT ("c")) };
+        appender.syncDoAppendBatch (batch);
+    }
+
+    char buf[1024];
+    long len;
+    while ((len = ::recv (server, buf, sizeof (buf), MSG_DONTWAIT)) > 0)
+        received.emplace_back (buf, static_cast<std::size_t>(len));
+    ::close (server);
+    std::remove (path);
+
+    std::string const tag (" test["
+        + helpers::convertIntegerToNarrowString (internal::get_process_id ())
+        + "]: ");
+    CATCH_REQUIRE (received.size () == 4);
+    CATCH_REQUIRE (received[0].substr (0, 4) == "<14>");
+    CATCH_REQUIRE (received[0].find (tag) == 19);
+    CATCH_REQUIRE (received[0].find ("single") != std::string::npos);
+    CATCH_REQUIRE (received[3].find (tag + "INFO - c") == 19);
+}
+
+#endif
+
+
 } // namespace log4cplus
@@ -20,9 +20,15 @@
 
 #include <log4cplus/config.hxx>
 
+#include <algorithm>
 #include <exception>
+#include <fstream>
 #include <memory>
 #include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
 #include <cerrno>
 
 #ifdef LOG4CPLUS_HAVE_SYS_TYPES_H
@@ -65,6 +71,11 @@
 #include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/helpers/timehelper.h>
 #include <log4cplus/internal/internal.h>
+#include <mutex>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#endif
 
 #endif // LOG4CPLUS_SINGLE_THREADED
 
@@ -113,9 +124,16 @@ getCurrentThreadName()
     log4cplus::tstring & name = log4cplus::internal::get_thread_name_str ();
     if (LOG4CPLUS_UNLIKELY (name.empty ()))
     {
-        log4cplus::tostringstream tmp;
-        tmp << impl::getCurrentThreadId ();
-        name = tmp.str ();
+        auto const id = impl::getCurrentThreadId ();
+        if constexpr (std::is_integral_v<decltype (id)>)
+            name = helpers::convertIntegerToString (id);
+        else
+        {
+            // Opaque thread id type.
+            log4cplus::tostringstream tmp;
+            tmp << id;
+            name = tmp.str ();
+        }
     }
 #else
     log4cplus::tstring & name = thread_name;
@@ -134,26 +152,22 @@ namespace
 
 
 static
-bool
-get_current_thread_name_alt (log4cplus::tostream * s)
+log4cplus::tstring
+get_current_thread_name_alt ()
 {
-    log4cplus::tostream & os = *s;
-
 #if defined (LOG4CPLUS_USE_PTHREADS) && defined (__linux__) \
     && defined (LOG4CPLUS_HAVE_GETTID)
-    pid_t tid = syscall (SYS_gettid);
-    os << tid;
+    pid_t tid = static_cast<pid_t>(syscall (SYS_gettid));
+    return helpers::convertIntegerToString (tid);
 
 #elif defined (__CYGWIN__)
     unsigned long tid = cygwin::get_current_win32_thread_id ();
-    os << tid;
+    return helpers::convertIntegerToString (tid);
 
 #else
-    os << getCurrentThreadName ();
+    return getCurrentThreadName ();
 
 #endif
-
-    return true;
 }
 
 
@@ -167,11 +181,7 @@ getCurrentThreadName2()
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
     log4cplus::tstring & name = log4cplus::internal::get_thread_name2_str ();
     if (LOG4CPLUS_UNLIKELY (name.empty ()))
-    {
-        log4cplus::tostringstream tmp;
-        get_current_thread_name_alt (&tmp);
-        name = tmp.str ();
-    }
+        name = get_current_thread_name_alt ();
 
 #else
     log4cplus::tstring & name = thread_name2;
@@ -203,6 +213,41 @@ LOG4CPLUS_EXPORT void setCurrentThreadName2(const log4cplus::tstring & name)
 #endif
 }
 
+LOG4CPLUS_EXPORT void setCurrentThreadSystemName(
+    const log4cplus::tstring & name)
+{
+    setCurrentThreadName (name);
+
+#if defined (LOG4CPLUS_USE_PTHREADS) \
+    && defined (LOG4CPLUS_HAVE_PTHREAD_SETNAME_NP)
+    std::string const narrow = LOG4CPLUS_TSTRING_TO_STRING (name);
+#if defined (__APPLE__)
+    pthread_setname_np (narrow.c_str ());
+#elif defined (__NetBSD__)
+    pthread_setname_np (pthread_self (), "%s",
+        const_cast<char *>(narrow.c_str ()));
+#else
+    // Longer names are rejected on Linux.
+    pthread_setname_np (pthread_self (), narrow.substr (0, 15).c_str ());
+#endif
+
+#elif defined (LOG4CPLUS_USE_WIN32_THREADS)
+    // SetThreadDescription() is available since Windows 10 1607.
+    typedef HRESULT (WINAPI * set_thread_description_func) (HANDLE, PCWSTR);
+    HMODULE const kernel = GetModuleHandleW (L"kernel32.dll");
+    auto const set_thread_description = kernel
+        ? reinterpret_cast<set_thread_description_func>(
+            GetProcAddress (kernel, "SetThreadDescription"))
+        : nullptr;
+    if (set_thread_description)
+    {
+        std::wstring const wide = helpers::towstring (name);
+        set_thread_description (GetCurrentThread (), wide.c_str ());
+    }
+
+#endif
+}
+
 
 //
 //
@@ -235,6 +280,279 @@ SignalsBlocker::~SignalsBlocker()
 }
 
 
+//
+//
+//
+
+namespace
+{
+
+BackgroundThreadSettings background_thread_settings;
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+std::mutex background_thread_settings_mutex;
+#endif
+
+} // namespace
+
+
+LOG4CPLUS_EXPORT void setBackgroundThreadSettings(
+    BackgroundThreadSettings const & settings)
+{
+    LOG4CPLUS_THREADED (
+        std::lock_guard<std::mutex> guard (background_thread_settings_mutex));
+    background_thread_settings = settings;
+}
+
+
+LOG4CPLUS_EXPORT BackgroundThreadSettings getBackgroundThreadSettings()
+{
+    LOG4CPLUS_THREADED (
+        std::lock_guard<std::mutex> guard (background_thread_settings_mutex));
+    return background_thread_settings;
+}
+
+
+LOG4CPLUS_EXPORT void applyBackgroundThreadSettings(
+    const log4cplus::tstring & LOG4CPLUS_THREADED (role))
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    BackgroundThreadSettings const settings = getBackgroundThreadSettings ();
+    helpers::LogLog & loglog = helpers::getLogLog ();
+
+    if (! settings.namePrefix.empty ())
+        setCurrentThreadSystemName (settings.namePrefix
+            + LOG4CPLUS_TEXT ("-") + role);
+
+    if (! settings.cpus.empty ())
+    {
+#if defined (LOG4CPLUS_USE_PTHREADS) \
+    && defined (LOG4CPLUS_HAVE_PTHREAD_SETAFFINITY_NP)
+        cpu_set_t cpu_set;
+        CPU_ZERO (&cpu_set);
+        for (unsigned cpu : settings.cpus)
+            if (cpu < CPU_SETSIZE)
+                CPU_SET (cpu, &cpu_set);
+
+        int const ret = pthread_setaffinity_np (pthread_self (),
+            sizeof (cpu_set), &cpu_set);
+        if (ret != 0)
+            loglog.warn (LOG4CPLUS_TEXT ("pthread_setaffinity_np() failed: ")
+                + helpers::convertIntegerToString (ret));
+
+#elif defined (LOG4CPLUS_USE_WIN32_THREADS)
+        DWORD_PTR mask = 0;
+        for (unsigned cpu : settings.cpus)
+            if (cpu < sizeof (mask) * 8)
+                mask |= DWORD_PTR (1) << cpu;
+
+        if (! SetThreadAffinityMask (GetCurrentThread (), mask))
+            loglog.warn (LOG4CPLUS_TEXT ("SetThreadAffinityMask() failed: ")
+                + helpers::convertIntegerToString (GetLastError ()));
+
+#else
+        loglog.warn (
+            LOG4CPLUS_TEXT ("Thread affinity is not supported"));
+
+#endif
+    }
+
+    if (settings.policy != BackgroundThreadSettings::POLICY_INHERIT)
+    {
+#if defined (LOG4CPLUS_USE_PTHREADS)
+        int policy = SCHED_OTHER;
+        sched_param param {};
+        switch (settings.policy)
+        {
+#if defined (SCHED_BATCH)
+        case BackgroundThreadSettings::POLICY_BATCH:
+            policy = SCHED_BATCH;
+            break;
+#endif
+
+#if defined (SCHED_IDLE)
+        case BackgroundThreadSettings::POLICY_IDLE:
+            policy = SCHED_IDLE;
+            break;
+#endif
+
+        case BackgroundThreadSettings::POLICY_FIFO:
+            policy = SCHED_FIFO;
+            param.sched_priority = settings.priority;
+            break;
+
+        case BackgroundThreadSettings::POLICY_RR:
+            policy = SCHED_RR;
+            param.sched_priority = settings.priority;
+            break;
+
+        default:
+            break;
+        }
+
+        int const ret = pthread_setschedparam (pthread_self (), policy,
+            &param);
+        if (ret != 0)
+            loglog.warn (LOG4CPLUS_TEXT ("pthread_setschedparam() failed: ")
+                + helpers::convertIntegerToString (ret));
+
+#elif defined (LOG4CPLUS_USE_WIN32_THREADS)
+        int priority = THREAD_PRIORITY_NORMAL;
+        switch (settings.policy)
+        {
+        case BackgroundThreadSettings::POLICY_BATCH:
+            priority = THREAD_PRIORITY_BELOW_NORMAL;
+            break;
+
+        case BackgroundThreadSettings::POLICY_IDLE:
+            priority = THREAD_PRIORITY_LOWEST;
+            break;
+
+        case BackgroundThreadSettings::POLICY_FIFO:
+        case BackgroundThreadSettings::POLICY_RR:
+            priority = THREAD_PRIORITY_HIGHEST;
+            break;
+
+        default:
+            break;
+        }
+
+        if (! SetThreadPriority (GetCurrentThread (), priority))
+            loglog.warn (LOG4CPLUS_TEXT ("SetThreadPriority() failed: ")
+                + helpers::convertIntegerToString (GetLastError ()));
+
+#endif
+    }
+#endif
+}
+
+
+namespace
+{
+
+//! NUMA nodes and their CPUs.
+struct numa_topology
+{
+    //! Index of node of each CPU.
+    std::vector<unsigned> cpu_node;
+    //! CPUs of each node, nodes are indexed in the order of their ids.
+    std::vector<std::vector<unsigned>> node_cpus;
+};
+
+
+#if defined (__linux__)
+//! Parses list of CPUs like <code>0-3,8,10-11</code>.
+std::vector<unsigned>
+parse_cpu_list (std::string const & list)
+{
+    std::vector<unsigned> cpus;
+    std::istringstream in (list);
+    std::string range;
+    while (std::getline (in, range, ','))
+    {
+        unsigned first = 0, last = 0;
+        char dash = 0;
+        std::istringstream range_in (range);
+        if (! (range_in >> first))
+            continue;
+        if (! (range_in >> dash >> last) || dash != '-')
+            last = first;
+        for (unsigned cpu = first; cpu <= last; ++cpu)
+            cpus.push_back (cpu);
+    }
+    return cpus;
+}
+#endif
+
+
+numa_topology
+read_numa_topology ()
+{
+    numa_topology topology;
+#if defined (__linux__)
+    // Node ids can have gaps, they are listed like CPUs.
+    std::ifstream online ("/sys/devices/system/node/online");
+    std::string ids;
+    std::getline (online, ids);
+    for (unsigned id : parse_cpu_list (ids))
+    {
+        std::ifstream in ("/sys/devices/system/node/node"
+            + std::to_string (id) + "/cpulist");
+        std::string list;
+        std::getline (in, list);
+        std::vector<unsigned> cpus = parse_cpu_list (list);
+        if (cpus.empty ())
+            continue;
+
+        unsigned const node = static_cast<unsigned> (
+            topology.node_cpus.size ());
+        for (unsigned cpu : cpus)
+        {
+            if (topology.cpu_node.size () <= cpu)
+                topology.cpu_node.resize (cpu + 1, 0);
+            topology.cpu_node[cpu] = node;
+        }
+        topology.node_cpus.push_back (std::move (cpus));
+    }
+#endif
+    return topology;
+}
+
+
+numa_topology const &
+get_numa_topology ()
+{
+    static numa_topology const topology = read_numa_topology ();
+    return topology;
+}
+
+} // namespace
+
+
+unsigned
+getNumaNodeCount ()
+{
+    return (std::max) (std::size_t (1),
+        get_numa_topology ().node_cpus.size ());
+}
+
+
+unsigned
+getCurrentNumaNode ()
+{
+#if defined (__linux__)
+    numa_topology const & topology = get_numa_topology ();
+    int const cpu = sched_getcpu ();
+    if (cpu >= 0 && static_cast<std::size_t> (cpu) < topology.cpu_node.size ())
+        return topology.cpu_node[cpu];
+#endif
+    return 0;
+}
+
+
+bool
+setCurrentThreadNumaNode (unsigned node)
+{
+#if defined (LOG4CPLUS_USE_PTHREADS) \
+    && defined (LOG4CPLUS_HAVE_PTHREAD_SETAFFINITY_NP)
+    numa_topology const & topology = get_numa_topology ();
+    if (node >= topology.node_cpus.size ())
+        return false;
+
+    cpu_set_t cpu_set;
+    CPU_ZERO (&cpu_set);
+    for (unsigned cpu : topology.node_cpus[node])
+        if (cpu < CPU_SETSIZE)
+            CPU_SET (cpu, &cpu_set);
+
+    return pthread_setaffinity_np (pthread_self (), sizeof (cpu_set),
+        &cpu_set) == 0;
+#else
+    (void) node;
+    return false;
+#endif
+}
+
+
 #ifndef LOG4CPLUS_SINGLE_THREADED
 
 //
@@ -243,9 +561,17 @@ SignalsBlocker::~SignalsBlocker()
 
 AbstractThread::AbstractThread ()
     : flags (0)
+    , threadRole (LOG4CPLUS_TEXT ("thread"))
 { }
 
 
+void
+AbstractThread::setThreadRole (const log4cplus::tstring & role)
+{
+    threadRole = role;
+}
+
+
 bool
 AbstractThread::isRunning() const
 {
@@ -263,6 +589,7 @@ AbstractThread::start()
             [this] (AbstractThreadPtr const & thread_ptr) {
                     (void) thread_ptr;
                     blockAllSignals ();
+                    applyBackgroundThreadSettings (threadRole);
                     helpers::LogLog & loglog = helpers::getLogLog();
                     try
                     {
@@ -310,6 +637,29 @@ AbstractThread::~AbstractThread()
         thread->detach ();
 }
 
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Background thread settings", "[threads]")
+{
+    BackgroundThreadSettings const saved = getBackgroundThreadSettings ();
+    BackgroundThreadSettings settings;
+    settings.namePrefix = LOG4CPLUS_TEXT ("test");
+    setBackgroundThreadSettings (settings);
+
+    tstring name;
+    std::thread (
+        [&name]
+        {
+            applyBackgroundThreadSettings (LOG4CPLUS_TEXT ("role"));
+            name = getCurrentThreadName ();
+            threadCleanup ();
+        }).join ();
+    setBackgroundThreadSettings (saved);
+
+    CATCH_REQUIRE (name == LOG4CPLUS_TEXT ("test-role"));
+}
+#endif
+
 #endif // LOG4CPLUS_SINGLE_THREADED
 
 
@@ -0,0 +1,323 @@
+// Module:  Log4cplus
+// File:    threadshardedappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <log4cplus/config.hxx>
+#ifndef LOG4CPLUS_SINGLE_THREADED
+
+#include <log4cplus/threadshardedappender.h>
+#include <log4cplus/spi/factory.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <atomic>
+#include <thread>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+//! Placeholder of shard index in file names, see <tt>File</tt>
+//! property of the children.
+tchar const shard_index_token[] = LOG4CPLUS_TEXT ("%shard");
+
+
+//! Source of thread ordinals.
+std::atomic<std::size_t> next_thread_ordinal (0);
+
+
+//! Ordinal of the calling thread, assigned on its first call.
+std::size_t
+thread_ordinal ()
+{
+    thread_local std::size_t const ordinal
+        = next_thread_ordinal.fetch_add (1, std::memory_order_relaxed);
+    return ordinal;
+}
+
+
+//! Returns <code>file</code> with <tt>%shard</tt> placeholders replaced
+//! by <code>index</code>, or with the index appended if it has none.
+tstring
+expand_shard_file (tstring const & file, std::size_t index)
+{
+    tstring const id = helpers::convertIntegerToString (index);
+    tstring::size_type const token_len = sizeof (shard_index_token)
+        / sizeof (shard_index_token[0]) - 1;
+
+    tstring::size_type found = file.find (shard_index_token);
+    if (found == tstring::npos)
+        return file + LOG4CPLUS_TEXT (".") + id;
+
+    tstring name;
+    tstring::size_type pos = 0;
+    for (; found != tstring::npos;
+        pos = found + token_len,
+            found = file.find (shard_index_token, pos))
+    {
+        name.append (file, pos, found - pos);
+        name += id;
+    }
+    name.append (file, pos, tstring::npos);
+
+    return name;
+}
+
+} // namespace
+
+
+ThreadShardedAppender::ThreadShardedAppender (
+    std::vector<SharedAppenderPtr> shards_, unsigned threadsPerShard_)
+    : shards (std::move (shards_))
+    , threadsPerShard ((std::max) (threadsPerShard_, 1u))
+{
+    concurrentAppend = true;
+}
+
+
+ThreadShardedAppender::ThreadShardedAppender (
+    helpers::Properties const & props)
+    : Appender (props)
+    , threadsPerShard (1)
+{
+    concurrentAppend = true;
+
+    props.getUInt (threadsPerShard, LOG4CPLUS_TEXT ("ThreadsPerShard"));
+    threadsPerShard = (std::max) (threadsPerShard, 1u);
+
+    unsigned shard_count = std::thread::hardware_concurrency ();
+    props.getUInt (shard_count, LOG4CPLUS_TEXT ("Shards"));
+    shard_count = (std::max) (shard_count, 1u);
+
+    tstring const & appender_name (
+        props.getProperty (LOG4CPLUS_TEXT ("Appender")));
+    if (appender_name.empty ())
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unspecified appender for ThreadShardedAppender."));
+        return;
+    }
+
+    spi::AppenderFactory * factory
+        = spi::getAppenderFactoryRegistry ().get (appender_name);
+    if (! factory)
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("ThreadShardedAppender::ThreadShardedAppender()")
+            LOG4CPLUS_TEXT (" - Cannot find AppenderFactory: ")
+            + appender_name);
+        return;
+    }
+
+    helpers::Properties appender_props = props.getPropertySubset (
+        LOG4CPLUS_TEXT ("Appender."));
+    tstring const file = appender_props.getProperty (LOG4CPLUS_TEXT ("File"));
+    shards.reserve (shard_count);
+    for (std::size_t i = 0; i != shard_count; ++i)
+    {
+        if (! file.empty ())
+            appender_props.setProperty (LOG4CPLUS_TEXT ("File"),
+                expand_shard_file (file, i));
+
+        SharedAppenderPtr shard (factory->createObject (appender_props));
+        shard->setName (name + LOG4CPLUS_TEXT ("#")
+            + helpers::convertIntegerToString (i));
+        shards.push_back (std::move (shard));
+    }
+}
+
+
+ThreadShardedAppender::~ThreadShardedAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+ThreadShardedAppender::close ()
+{
+    thread::MutexGuard guard (access_mutex);
+    if (closed)
+        return;
+
+    for (SharedAppenderPtr const & shard : shards)
+        shard->close ();
+
+    closed = true;
+}
+
+
+unsigned
+ThreadShardedAppender::getRequiredEventFields () const
+{
+    unsigned fields = Appender::getRequiredEventFields ();
+    for (SharedAppenderPtr const & shard : shards)
+        fields |= shard->getRequiredEventFields ();
+
+    return fields;
+}
+
+
+std::size_t
+ThreadShardedAppender::shardIndex () const
+{
+    return thread_ordinal () / threadsPerShard % shards.size ();
+}
+
+
+SharedAppenderPtr
+ThreadShardedAppender::getShard () const
+{
+    if (shards.empty ())
+        return SharedAppenderPtr ();
+
+    return shards[shardIndex ()];
+}
+
+
+std::vector<SharedAppenderPtr> const &
+ThreadShardedAppender::getShards () const
+{
+    return shards;
+}
+
+
+void
+ThreadShardedAppender::append (spi::InternalLoggingEvent const & event)
+{
+    // A closed child reports the event itself.
+    if (! shards.empty ())
+        shards[shardIndex ()]->doAppend (event);
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+namespace
+{
+
+class CountingAppender
+    : public Appender
+{
+public:
+    CountingAppender ()
+        : count (0)
+    { }
+
+    virtual ~CountingAppender ()
+    {
+        destructorImpl ();
+    }
+
+    virtual void close ()
+    {
+        closed = true;
+    }
+
+    std::size_t count;
+
+protected:
+    virtual void append (spi::InternalLoggingEvent const &)
+    {
+        ++count;
+    }
+};
+
+} // namespace
+
+
+CATCH_TEST_CASE ("ThreadShardedAppender", "[appender]")
+{
+    CATCH_SECTION ("file names of shards")
+    {
+        CATCH_REQUIRE (expand_shard_file (LOG4CPLUS_TEXT ("a.log"), 3)
+            == LOG4CPLUS_TEXT ("a.log.3"));
+        CATCH_REQUIRE (expand_shard_file (LOG4CPLUS_TEXT ("a%shard.%shard"), 2)
+            == LOG4CPLUS_TEXT ("a2.2"));
+    }
+
+    CATCH_SECTION ("threads are routed to their shards")
+    {
+        helpers::SharedObjectPtr<CountingAppender> first (
+            new CountingAppender);
+        helpers::SharedObjectPtr<CountingAppender> second (
+            new CountingAppender);
+        ThreadShardedAppenderPtr sharded (new ThreadShardedAppender (
+            std::vector<SharedAppenderPtr> {SharedAppenderPtr (first.get ()),
+                SharedAppenderPtr (second.get ())}));
+
+        spi::InternalLoggingEvent const event (LOG4CPLUS_TEXT ("test"),
+            INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"), nullptr, 0);
+        sharded->doAppend (event);
+        sharded->doAppend (event);
+
+        SharedAppenderPtr const main_shard = sharded->getShard ();
+        SharedAppenderPtr other_shard;
+        std::thread ([&]
+            {
+                other_shard = sharded->getShard ();
+                sharded->doAppend (event);
+            }).join ();
+
+        CATCH_REQUIRE (main_shard != other_shard);
+        CATCH_REQUIRE (first->count + second->count == 3);
+        CATCH_REQUIRE (
+            (main_shard.get () == first.get () ? first : second)->count == 2);
+
+        sharded->close ();
+        CATCH_REQUIRE (first->isClosed ());
+        CATCH_REQUIRE (second->isClosed ());
+    }
+
+    CATCH_SECTION ("shards from properties")
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("Shards"), LOG4CPLUS_TEXT ("3"));
+        props.setProperty (LOG4CPLUS_TEXT ("ThreadsPerShard"),
+            LOG4CPLUS_TEXT ("2"));
+        props.setProperty (LOG4CPLUS_TEXT ("Appender"),
+            LOG4CPLUS_TEXT ("log4cplus::NullAppender"));
+        ThreadShardedAppenderPtr sharded (new ThreadShardedAppender (props));
+        CATCH_REQUIRE (sharded->getShards ().size () == 3);
+        sharded->close ();
+    }
+}
+#endif
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_SINGLE_THREADED
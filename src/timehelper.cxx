@@ -25,6 +25,10 @@
 #include <log4cplus/internal/internal.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <vector>
 #include <iomanip>
 #include <cassert>
@@ -53,7 +57,33 @@
 #define LOG4CPLUS_NEED_LOCALTIME_R
 #endif
 
+#if defined (LOG4CPLUS_HAVE_LOCALTIME_R) \
+    && defined (LOG4CPLUS_HAVE_STRUCT_TM_TM_GMTOFF)
+#define LOG4CPLUS_CACHE_LOCAL_TIME
+#endif
+
+#if defined (LOG4CPLUS_HAVE_TIME_H)
+#include <time.h>
+#endif
+
+#if (defined (__GNUC__) || defined (__clang__)) \
+    && (defined (__x86_64__) || defined (__i386__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define LOG4CPLUS_HAVE_TSC
+
+#elif defined (_MSC_VER) && (defined (_M_X64) || defined (_M_IX86))
+#include <intrin.h>
+#define LOG4CPLUS_HAVE_TSC
+
+#endif
+
 #include <log4cplus/config/windowsh-inc.h>
+#include <thread>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#endif
 
 
 namespace log4cplus::helpers {
@@ -104,11 +134,115 @@ gmTime (tm* t, Time const & the_time)
 }
 
 
+#if defined (LOG4CPLUS_CACHE_LOCAL_TIME)
+namespace
+{
+
+//! Length of intervals for which local time offset is cached.
+time_t const LOCAL_TIME_CACHE_SECONDS = 3600;
+
+
+//! Fills <code>t</code> with broken down time of <code>clock</code>
+//! seconds since epoch, without any time zone adjustment.
+void
+civil_from_seconds (tm * t, time_t clock)
+{
+    // Days to civil date conversion by Howard Hinnant, valid for the
+    // whole range of proleptic Gregorian calendar.
+    std::int64_t secs = clock;
+    std::int64_t days = secs / 86400;
+    std::int64_t rem = secs % 86400;
+    if (rem < 0)
+    {
+        rem += 86400;
+        --days;
+    }
+
+    t->tm_hour = static_cast<int>(rem / 3600);
+    t->tm_min = static_cast<int>(rem % 3600 / 60);
+    t->tm_sec = static_cast<int>(rem % 60);
+    // 1970-01-01 was Thursday.
+    std::int64_t const wday = (days + 4) % 7;
+    t->tm_wday = static_cast<int>(wday < 0 ? wday + 7 : wday);
+
+    std::int64_t const z = days + 719468;
+    std::int64_t const era = (z >= 0 ? z : z - 146096) / 146097;
+    std::int64_t const doe = z - era * 146097;
+    std::int64_t const yoe
+        = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    std::int64_t const doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    std::int64_t const mp = (5 * doy + 2) / 153;
+    std::int64_t const mday = doy - (153 * mp + 2) / 5 + 1;
+    std::int64_t const month = mp < 10 ? mp + 3 : mp - 9;
+    std::int64_t const year = yoe + era * 400 + (month <= 2);
+
+    bool const leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    // Day of year of March 1st is 59 or 60 in leap years.
+    std::int64_t const yday = doy >= 306 ? doy - 306 : doy + 59 + leap;
+
+    t->tm_mday = static_cast<int>(mday);
+    t->tm_mon = static_cast<int>(month - 1);
+    t->tm_year = static_cast<int>(year - 1900);
+    t->tm_yday = static_cast<int>(yday);
+}
+
+
+//! Refreshes <code>cache</code> for the interval around
+//! <code>clock</code> and fills <code>t</code> with local time of
+//! <code>clock</code>.
+void
+refresh_local_time_cache (internal::local_time_cache & cache, tm * t,
+    time_t clock)
+{
+    time_t begin = clock % LOCAL_TIME_CACHE_SECONDS;
+    begin = clock - (begin < 0 ? begin + LOCAL_TIME_CACHE_SECONDS : begin);
+    time_t const last = begin + LOCAL_TIME_CACHE_SECONDS - 1;
+
+    tm first_tm;
+    tm last_tm;
+    ::localtime_r (&begin, &first_tm);
+    ::localtime_r (&last, &last_tm);
+    ::localtime_r (&clock, t);
+
+    cache.begin = begin;
+    cache.end = last + 1;
+    // A time zone transition within the interval leaves the cache
+    // invalid and localtime_r() is used until the next interval.
+    cache.valid = first_tm.tm_gmtoff == last_tm.tm_gmtoff
+        && first_tm.tm_isdst == last_tm.tm_isdst
+        && first_tm.tm_zone == last_tm.tm_zone;
+    cache.gmtoff = first_tm.tm_gmtoff;
+    cache.isdst = first_tm.tm_isdst;
+    cache.zone = first_tm.tm_zone;
+}
+
+} // namespace
+#endif
+
+
 void
 localTime (tm* t, Time const & the_time)
 {
     time_t clock = to_time_t (the_time);
-#ifdef LOG4CPLUS_NEED_LOCALTIME_R
+#if defined (LOG4CPLUS_CACHE_LOCAL_TIME)
+    // localtime_r() can take a global lock in libc. The offset from UTC
+    // is looked up at most once per hour per thread and the rest is
+    // computed here. Time zone changes made at run time are therefore
+    // picked up only in the next interval.
+    internal::local_time_cache & cache = internal::get_ptd ()->lt_cache;
+    if (LOG4CPLUS_UNLIKELY (clock < cache.begin || clock >= cache.end))
+        refresh_local_time_cache (cache, t, clock);
+    else if (LOG4CPLUS_LIKELY (cache.valid))
+    {
+        civil_from_seconds (t, clock + cache.gmtoff);
+        t->tm_isdst = cache.isdst;
+        t->tm_gmtoff = cache.gmtoff;
+        t->tm_zone = cache.zone;
+    }
+    else
+        ::localtime_r (&clock, t);
+
+#elif defined (LOG4CPLUS_NEED_LOCALTIME_R)
     ::localtime_r(&clock, t);
 #elif defined (LOG4CPLUS_HAVE_LOCALTIME_S)
     errno_t eno;
@@ -122,6 +256,281 @@ localTime (tm* t, Time const & the_time)
 }
 
 
+namespace
+{
+
+std::atomic<EventClock> event_clock {EventClock::System};
+
+
+PreciseTime
+precise_now ()
+{
+    return chrono::time_point_cast<chrono::nanoseconds> (Clock::now ());
+}
+
+
+PreciseTime
+coarse_now ()
+{
+#if defined (LOG4CPLUS_HAVE_CLOCK_GETTIME) && defined (CLOCK_REALTIME_COARSE)
+    struct timespec ts;
+    if (clock_gettime (CLOCK_REALTIME_COARSE, &ts) == 0)
+        return PreciseTime (chrono::seconds (ts.tv_sec))
+            + chrono::nanoseconds (ts.tv_nsec);
+
+#elif defined (_WIN32)
+    // Unlike GetSystemTimePreciseAsFileTime(), this only reads the time
+    // of the last clock tick.
+    FILETIME ft;
+    GetSystemTimeAsFileTime (&ft);
+    ULARGE_INTEGER ticks;
+    ticks.LowPart = ft.dwLowDateTime;
+    ticks.HighPart = ft.dwHighDateTime;
+    // 100 ns ticks since 1601-01-01.
+    std::uint64_t const epoch_offset = 116444736000000000ULL;
+    return PreciseTime (chrono::nanoseconds (
+        static_cast<long long>(ticks.QuadPart - epoch_offset) * 100));
+
+#endif
+    return precise_now ();
+}
+
+
+#if defined (LOG4CPLUS_HAVE_TSC)
+//! Conversion of TSC readings to wall clock time. Readers retry while
+//! <code>seq</code> is odd or changes under them.
+struct tsc_clock
+{
+    //! Fixed point shift of <code>scale</code>. Products of ticks and
+    //! scale stay in 64 bits for over 1000 s of 3 GHz ticks.
+    static int const scale_shift = 24;
+
+    std::atomic<std::uint32_t> seq {0};
+    std::atomic<std::uint64_t> base_ticks {0};
+    std::atomic<long long> base_time {0};
+    //! Nanoseconds per tick, shifted left by scale_shift.
+    std::atomic<std::uint64_t> scale {0};
+    //! Ticks after which the time is taken from the system clock again.
+    std::atomic<std::uint64_t> resync_ticks {0};
+
+    //! First calibration point; the scale is refined against it.
+    std::uint64_t first_ticks = 0;
+    long long first_time = 0;
+};
+
+
+tsc_clock tsc;
+
+
+std::uint64_t
+read_tsc ()
+{
+    return __rdtsc ();
+}
+
+
+bool
+has_invariant_tsc ()
+{
+#if defined (_MSC_VER)
+    int regs[4];
+    __cpuid (regs, 0x80000000);
+    if (static_cast<unsigned>(regs[0]) < 0x80000007u)
+        return false;
+
+    __cpuid (regs, 0x80000007);
+    return (regs[3] & (1 << 8)) != 0;
+
+#else
+    unsigned eax, ebx, ecx, edx;
+    if (! __get_cpuid (0x80000007, &eax, &ebx, &ecx, &edx))
+        return false;
+
+    return (edx & (1u << 8)) != 0;
+
+#endif
+}
+
+
+long long
+system_nanos ()
+{
+    return precise_now ().time_since_epoch ().count ();
+}
+
+
+//! Stores new base point; the caller has made <code>seq</code> odd.
+void
+tsc_store_base (std::uint64_t ticks, long long time)
+{
+    // The longer the interval since the first point, the more precise
+    // the scale is. When the system clock has been stepped, measuring
+    // starts over.
+    if (ticks > tsc.first_ticks && time > tsc.first_time)
+    {
+        std::uint64_t const scale = static_cast<std::uint64_t>(std::ldexp (
+            static_cast<double>(time - tsc.first_time)
+                / static_cast<double>(ticks - tsc.first_ticks),
+            tsc_clock::scale_shift));
+        std::uint64_t const previous
+            = tsc.scale.load (std::memory_order_relaxed);
+        if (previous == 0
+            || (scale > previous - previous / 100
+                && scale < previous + previous / 100))
+            tsc.scale.store (scale, std::memory_order_relaxed);
+        else
+        {
+            tsc.first_ticks = ticks;
+            tsc.first_time = time;
+        }
+    }
+
+    tsc.base_ticks.store (ticks, std::memory_order_relaxed);
+    tsc.base_time.store (time, std::memory_order_relaxed);
+}
+
+
+bool
+tsc_calibrate ()
+{
+    if (! has_invariant_tsc ())
+        return false;
+
+    std::uint64_t const ticks0 = read_tsc ();
+    long long const time0 = system_nanos ();
+    std::this_thread::sleep_for (chrono::milliseconds (10));
+    std::uint64_t const ticks1 = read_tsc ();
+    long long const time1 = system_nanos ();
+    if (ticks1 <= ticks0 || time1 <= time0)
+        return false;
+
+    // Wait for a concurrent re-synchronization to finish.
+    std::uint32_t seq;
+    do
+        seq = tsc.seq.load (std::memory_order_relaxed) & ~1u;
+    while (! tsc.seq.compare_exchange_weak (seq, seq + 1,
+            std::memory_order_acquire));
+
+    std::atomic_thread_fence (std::memory_order_release);
+    tsc.first_ticks = ticks0;
+    tsc.first_time = time0;
+    tsc_store_base (ticks1, time1);
+    tsc.resync_ticks.store ((ticks1 - ticks0) * 100,
+        std::memory_order_relaxed);
+    tsc.seq.store (seq + 2, std::memory_order_release);
+    return true;
+}
+
+
+PreciseTime
+tsc_now ()
+{
+    std::uint64_t const ticks = read_tsc ();
+    for (;;)
+    {
+        std::uint32_t const seq = tsc.seq.load (std::memory_order_acquire);
+        if (seq & 1)
+            break;
+
+        std::uint64_t const base_ticks
+            = tsc.base_ticks.load (std::memory_order_relaxed);
+        long long const base_time
+            = tsc.base_time.load (std::memory_order_relaxed);
+        std::uint64_t const scale = tsc.scale.load (std::memory_order_relaxed);
+        std::uint64_t const resync
+            = tsc.resync_ticks.load (std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_acquire);
+        if (tsc.seq.load (std::memory_order_relaxed) != seq)
+            continue;
+
+        if (ticks >= base_ticks && ticks - base_ticks < resync)
+            return PreciseTime (chrono::nanoseconds (base_time
+                + static_cast<long long>(
+                    ((ticks - base_ticks) * scale) >> tsc_clock::scale_shift)));
+
+        // Take new base point unless another thread already does.
+        std::uint32_t expected = seq;
+        if (! tsc.seq.compare_exchange_strong (expected, seq + 1,
+                std::memory_order_acquire))
+            break;
+
+        std::atomic_thread_fence (std::memory_order_release);
+        long long const time = system_nanos ();
+        tsc_store_base (read_tsc (), time);
+        tsc.seq.store (seq + 2, std::memory_order_release);
+        return PreciseTime (chrono::nanoseconds (time));
+    }
+
+    return precise_now ();
+}
+
+#endif
+
+} // namespace
+
+
+void
+setEventClock (EventClock clock)
+{
+    if (clock == EventClock::Tsc)
+    {
+#if defined (LOG4CPLUS_HAVE_TSC)
+        bool const calibrated = tsc_calibrate ();
+#else
+        bool const calibrated = false;
+#endif
+        if (! calibrated)
+        {
+            getLogLog ().warn (
+                LOG4CPLUS_TEXT ("Invariant TSC is not available,")
+                LOG4CPLUS_TEXT (" using system clock for events"));
+            clock = EventClock::System;
+        }
+    }
+
+    event_clock.store (clock, std::memory_order_release);
+}
+
+
+EventClock
+getEventClock ()
+{
+    return event_clock.load (std::memory_order_relaxed);
+}
+
+
+Time
+eventNow ()
+{
+    return time_cast (eventNowPrecise ());
+}
+
+
+PreciseTime
+eventNowPrecise ()
+{
+    switch (event_clock.load (std::memory_order_acquire))
+    {
+    case EventClock::Coarse:
+        return coarse_now ();
+
+#if defined (LOG4CPLUS_HAVE_TSC)
+    case EventClock::Tsc:
+        return tsc_now ();
+#endif
+
+    default:
+        return precise_now ();
+    }
+}
+
+
+} // namespace log4cplus::helpers
+
+
+namespace log4cplus::internal {
+
+
 namespace
 {
 
@@ -144,25 +553,26 @@ static log4cplus::tstring const uc_q_padding_zeros[4] =
 };
 
 
-static
+} // namespace
+
+
 void
 build_q_value (log4cplus::tstring & q_str, long tv_usec)
 {
-    convertIntegerToString(q_str, tv_usec / 1000);
+    helpers::convertIntegerToString(q_str, tv_usec / 1000);
     std::size_t const len = q_str.length();
     if (len <= 2)
         q_str.insert (0, padding_zeros[q_str.length()]);
 }
 
 
-static
 void
 build_uc_q_value (log4cplus::tstring & uc_q_str, long tv_usec,
     log4cplus::tstring & tmp)
 {
     build_q_value (uc_q_str, tv_usec);
 
-    convertIntegerToString(tmp, tv_usec % 1000);
+    helpers::convertIntegerToString(tmp, tv_usec % 1000);
     std::size_t const usecs_len = tmp.length();
     tmp.insert (0, usecs_len <= 3
         ? uc_q_padding_zeros[usecs_len] : uc_q_padding_zeros[3]);
@@ -170,7 +580,60 @@ build_uc_q_value (log4cplus::tstring & uc_q_str, long tv_usec,
 }
 
 
-} // namespace
+std::uint64_t
+new_date_cache_id ()
+{
+    static std::atomic<std::uint64_t> cache_id_counter (0);
+    return ++cache_id_counter;
+}
+
+
+date_cache_entry &
+get_date_cache_entry (per_thread_data * p, std::uint64_t id,
+    std::size_t parts, time_t seconds)
+{
+    for (auto & e : p->date_cache)
+        if (e.converter_id == id)
+            return e;
+
+    date_cache_entry & entry = p->date_cache[p->date_cache_next];
+    p->date_cache_next = (p->date_cache_next + 1) % DATE_CACHE_SIZE;
+    entry.converter_id = id;
+    entry.parts.resize (parts);
+    entry.seconds = seconds + 1;
+    return entry;
+}
+
+
+converter_cache_entry &
+get_converter_cache_entry (per_thread_data * p, std::uint64_t id,
+    tstring const & key, int line, bool & hit)
+{
+    // Direct mapped; the length and the last character tell most names
+    // apart without hashing all of them.
+    std::size_t h = static_cast<std::size_t>(id) * 31 + key.size ();
+    h = h * 31 + static_cast<std::size_t>(line);
+    if (! key.empty ())
+        h = h * 31 + static_cast<std::size_t>(key.back ());
+    converter_cache_entry & entry = p->converter_cache[
+        h % CONVERTER_CACHE_SIZE];
+
+    hit = entry.converter_id == id && entry.line == line && entry.key == key;
+    if (! hit)
+    {
+        entry.converter_id = id;
+        entry.line = line;
+        entry.key.assign (key);
+        entry.value.clear ();
+    }
+    return entry;
+}
+
+
+} // namespace log4cplus::internal
+
+
+namespace log4cplus::helpers {
 
 
 log4cplus::tstring
@@ -200,7 +663,8 @@ getFormattedTime(const log4cplus::tstring& fmt_orig,
     gft_sp.ret.reserve (fmt_orig_size + fmt_orig_size / 3);
     State state = TEXT;
 
-    // Walk the format string and process all occurences of %q, %Q and %s.
+    // Walk the format string and process all occurences of %q, %Q, %N
+    // and %s.
 
     long const tv_usec = microseconds_part (the_time);
     time_t const tv_sec = to_time_t (the_time);
@@ -225,7 +689,7 @@ getFormattedTime(const log4cplus::tstring& fmt_orig,
             {
                 if (! gft_sp.q_str_valid)
                 {
-                    build_q_value (gft_sp.q_str, tv_usec);
+                    internal::build_q_value (gft_sp.q_str, tv_usec);
                     gft_sp.q_str_valid = true;
                 }
                 gft_sp.ret.append (gft_sp.q_str);
@@ -237,7 +701,7 @@ getFormattedTime(const log4cplus::tstring& fmt_orig,
             {
                 if (! gft_sp.uc_q_str_valid)
                 {
-                    build_uc_q_value (gft_sp.uc_q_str, tv_usec, gft_sp.tmp);
+                    internal::build_uc_q_value (gft_sp.uc_q_str, tv_usec, gft_sp.tmp);
                     gft_sp.uc_q_str_valid = true;
                 }
                 gft_sp.ret.append (gft_sp.uc_q_str);
@@ -245,6 +709,16 @@ getFormattedTime(const log4cplus::tstring& fmt_orig,
             }
             break;
 
+            case LOG4CPLUS_TEXT ('N'):
+            {
+                convertIntegerToString (gft_sp.tmp, tv_usec * 1000L);
+                gft_sp.ret.append (9 - (std::min) (gft_sp.tmp.size (),
+                        std::size_t (9)), LOG4CPLUS_TEXT ('0'));
+                gft_sp.ret.append (gft_sp.tmp);
+                state = TEXT;
+            }
+            break;
+
             // Windows do not support %s format specifier
             // (seconds since epoch).
             case LOG4CPLUS_TEXT ('s'):
@@ -315,4 +789,85 @@ getFormattedTime(const log4cplus::tstring& fmt_orig,
 }
 
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Event clocks", "[timehelper]")
+{
+    for (EventClock clock : {EventClock::Coarse, EventClock::Tsc,
+            EventClock::System})
+    {
+        setEventClock (clock);
+        for (int i = 0; i != 3; ++i)
+        {
+            Duration const diff = eventNow () - now ();
+            CATCH_REQUIRE (diff < chrono::milliseconds (50));
+            CATCH_REQUIRE (diff > -chrono::milliseconds (50));
+            std::this_thread::sleep_for (chrono::milliseconds (5));
+        }
+    }
+
+    CATCH_REQUIRE (getEventClock () == EventClock::System);
+}
+
+
+#if defined (LOG4CPLUS_CACHE_LOCAL_TIME)
+CATCH_TEST_CASE ("Cached local time", "[timehelper]")
+{
+    auto const same = [] (tm const & a, tm const & b)
+    {
+        return a.tm_sec == b.tm_sec && a.tm_min == b.tm_min
+            && a.tm_hour == b.tm_hour && a.tm_mday == b.tm_mday
+            && a.tm_mon == b.tm_mon && a.tm_year == b.tm_year
+            && a.tm_wday == b.tm_wday && a.tm_yday == b.tm_yday
+            && a.tm_isdst == b.tm_isdst && a.tm_gmtoff == b.tm_gmtoff;
+    };
+
+    CATCH_SECTION ("civil date arithmetic")
+    {
+        // Leap days, century years and times before epoch.
+        for (time_t clock = -5000000000LL; clock < 5000000000LL;
+             clock += 86400 * 13 + 3607)
+        {
+            tm expected;
+            tm actual;
+            ::gmtime_r (&clock, &expected);
+            civil_from_seconds (&actual, clock);
+            actual.tm_isdst = expected.tm_isdst;
+            actual.tm_gmtoff = expected.tm_gmtoff;
+            CATCH_REQUIRE (same (actual, expected));
+        }
+    }
+
+    CATCH_SECTION ("daylight saving time transitions")
+    {
+        char const * const old_tz = std::getenv ("TZ");
+        std::string const saved_tz (old_tz ? old_tz : "");
+        // POSIX rule, does not depend on installed time zone data.
+        ::setenv ("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+        ::tzset ();
+
+        // Around 2021-03-28 and 2021-10-31 transitions.
+        for (time_t start : {time_t (1616880000), time_t (1635627600)})
+            for (time_t clock = start; clock < start + 4 * 3600;
+                 clock += 61)
+            {
+                tm expected;
+                tm actual;
+                ::localtime_r (&clock, &expected);
+                localTime (&actual, from_time_t (clock));
+                CATCH_REQUIRE (same (actual, expected));
+            }
+
+        if (old_tz)
+            ::setenv ("TZ", saved_tz.c_str (), 1);
+        else
+            ::unsetenv ("TZ");
+        ::tzset ();
+        internal::get_ptd ()->lt_cache = internal::local_time_cache ();
+    }
+}
+#endif
+
+#endif
+
+
 } // namespace log4cplus::helpers
@@ -0,0 +1,580 @@
+// Module:  Log4cplus
+// File:    tlscontext-openssl.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_WITH_OPENSSL)
+
+#include <log4cplus/helpers/tlscontext.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/socket.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <string>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#if defined (LOG4CPLUS_HAVE_SYS_SOCKET_H)
+#include <sys/socket.h>
+#endif
+
+#if defined (LOG4CPLUS_HAVE_POLL_H)
+#include <poll.h>
+#endif
+
+#if defined (LOG4CPLUS_HAVE_FCNTL_H)
+#include <fcntl.h>
+#endif
+
+#if defined (LOG4CPLUS_USE_PTHREADS)
+#include <signal.h>
+#include <time.h>
+#endif
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/helpers/socketbuffer.h>
+#include <catch.hpp>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <cstdio>
+#include <thread>
+#endif
+
+
+namespace log4cplus::helpers {
+
+
+namespace
+{
+
+
+//! Logs <code>what</code> together with queued OpenSSL errors.
+static
+void
+report_ssl_error (tstring const & what)
+{
+    tstring msg (what);
+    char buf[256];
+    while (unsigned long const code = ERR_get_error ())
+    {
+        ERR_error_string_n (code, buf, sizeof (buf));
+        msg += LOG4CPLUS_TEXT ("; ");
+        msg += LOG4CPLUS_C_STR_TO_TSTRING (buf);
+    }
+
+    getLogLog ().error (msg);
+}
+
+
+#if defined (LOG4CPLUS_USE_PTHREADS) && ! defined (SO_NOSIGPIPE)
+//! OpenSSL writes to the socket without MSG_NOSIGNAL. Broken
+//! connection must not kill the process, so SIGPIPE is blocked for
+//! this thread while OpenSSL does I/O and the raised one is consumed.
+struct sigpipe_guard
+{
+    sigpipe_guard ()
+    {
+        sigemptyset (&pipe_set);
+        sigaddset (&pipe_set, SIGPIPE);
+
+        sigset_t pending;
+        sigemptyset (&pending);
+        sigpending (&pending);
+        was_pending = sigismember (&pending, SIGPIPE) == 1;
+
+        pthread_sigmask (SIG_BLOCK, &pipe_set, &old_set);
+    }
+
+    ~sigpipe_guard ()
+    {
+        int const eno = errno;
+        if (! was_pending)
+        {
+            struct timespec const zero = timespec ();
+            while (sigtimedwait (&pipe_set, nullptr, &zero) == -1
+                && errno == EINTR)
+                ;
+        }
+
+        pthread_sigmask (SIG_SETMASK, &old_set, nullptr);
+        errno = eno;
+    }
+
+    sigset_t pipe_set;
+    sigset_t old_set;
+    bool was_pending;
+};
+
+#else
+struct sigpipe_guard
+{ };
+
+#endif
+
+
+class openssl_tls_channel
+    : public TlsChannel
+{
+public:
+    openssl_tls_channel (SSL * ssl_, SOCKET_TYPE sock_)
+        : ssl (ssl_)
+        , sock (sock_)
+    {
+#if defined (BIO_get_ktls_send)
+        ktlsSend = BIO_get_ktls_send (SSL_get_wbio (ssl));
+#endif
+    }
+
+    virtual ~openssl_tls_channel ()
+    {
+        SSL_free (ssl);
+    }
+
+    virtual long
+    read (char * buffer, std::size_t len)
+    {
+        sigpipe_guard guard;
+        int const ret = SSL_read (ssl, buffer,
+            static_cast<int>((std::min) (len, std::size_t (INT_MAX))));
+        if (ret <= 0)
+            ERR_clear_error ();
+
+        return ret;
+    }
+
+    virtual bool
+    write (std::span<std::string_view const> buffers)
+    {
+        // With kTLS the kernel encrypts, plain gather write goes
+        // straight from the caller's buffers.
+        if (ktlsSend)
+            return helpers::write (sock, buffers) > 0;
+
+        std::string_view data;
+        if (buffers.size () == 1)
+            data = buffers[0];
+        else
+        {
+            // One SSL_write() produces fewer, fuller TLS records than
+            // one per buffer.
+            scratch.clear ();
+            for (std::string_view const & buffer : buffers)
+                scratch += buffer;
+
+            data = scratch;
+        }
+
+        sigpipe_guard guard;
+        while (! data.empty ())
+        {
+            int const ret = SSL_write (ssl, data.data (),
+                static_cast<int>((std::min) (data.size (),
+                        std::size_t (INT_MAX))));
+            if (ret <= 0)
+            {
+                ERR_clear_error ();
+                return false;
+            }
+
+            data.remove_prefix (static_cast<std::size_t>(ret));
+        }
+
+        return true;
+    }
+
+    virtual void
+    shutdown ()
+    {
+        sigpipe_guard guard;
+        SSL_shutdown (ssl);
+        ERR_clear_error ();
+    }
+
+    virtual bool
+    isResumed () const
+    {
+        return SSL_session_reused (ssl) == 1;
+    }
+
+    virtual bool
+    isKernelOffloaded () const
+    {
+        return ktlsSend;
+    }
+
+private:
+    SSL * ssl;
+    SOCKET_TYPE sock;
+    bool ktlsSend = false;
+    std::string scratch;
+};
+
+
+class openssl_tls_context
+    : public TlsContext
+{
+public:
+    explicit openssl_tls_context (TlsConfig const & config_)
+        : config (config_)
+    { }
+
+    virtual ~openssl_tls_context ()
+    {
+        if (lastSession)
+            SSL_SESSION_free (lastSession);
+
+        if (ctx)
+            SSL_CTX_free (ctx);
+    }
+
+    bool init ();
+
+    virtual std::unique_ptr<TlsChannel> startSession (SOCKET_TYPE sock);
+
+private:
+    static int newSessionCallback (SSL * ssl, SSL_SESSION * session);
+
+    void receiveTickets (SSL * ssl, SOCKET_TYPE sock);
+
+    TlsConfig const config;
+    SSL_CTX * ctx = nullptr;
+
+    //! Session of the last connection, resumed by the next one.
+    thread::Mutex sessionMutex;
+    SSL_SESSION * lastSession = nullptr;
+};
+
+
+bool
+openssl_tls_context::init ()
+{
+    ctx = SSL_CTX_new (config.server
+        ? TLS_server_method () : TLS_client_method ());
+    if (! ctx)
+    {
+        report_ssl_error (LOG4CPLUS_TEXT ("SSL_CTX_new() failed"));
+        return false;
+    }
+
+    SSL_CTX_set_min_proto_version (ctx, TLS1_2_VERSION);
+    SSL_CTX_set_app_data (ctx, this);
+
+    if (config.kernelOffload)
+    {
+#if defined (SSL_OP_ENABLE_KTLS)
+        SSL_CTX_set_options (ctx, SSL_OP_ENABLE_KTLS);
+#else
+        getLogLog ().warn (
+            LOG4CPLUS_TEXT ("TLS kernel offload is not supported by this")
+            LOG4CPLUS_TEXT (" OpenSSL"));
+#endif
+    }
+
+    if (! config.certFile.empty ())
+    {
+        std::string const cert (LOG4CPLUS_TSTRING_TO_STRING (config.certFile));
+        std::string const key (LOG4CPLUS_TSTRING_TO_STRING (
+                config.keyFile.empty () ? config.certFile : config.keyFile));
+        if (SSL_CTX_use_certificate_chain_file (ctx, cert.c_str ()) != 1
+            || SSL_CTX_use_PrivateKey_file (ctx, key.c_str (),
+                SSL_FILETYPE_PEM) != 1
+            || SSL_CTX_check_private_key (ctx) != 1)
+        {
+            report_ssl_error (LOG4CPLUS_TEXT ("Cannot load TLS certificate ")
+                + config.certFile);
+            return false;
+        }
+    }
+    else if (config.server)
+    {
+        getLogLog ().error (
+            LOG4CPLUS_TEXT ("TLS server requires certificate"));
+        return false;
+    }
+
+    if (! config.caFile.empty ())
+    {
+        std::string const ca (LOG4CPLUS_TSTRING_TO_STRING (config.caFile));
+        if (SSL_CTX_load_verify_locations (ctx, ca.c_str (), nullptr) != 1)
+        {
+            report_ssl_error (LOG4CPLUS_TEXT ("Cannot load TLS CA file ")
+                + config.caFile);
+            return false;
+        }
+    }
+    else if (! config.server)
+        SSL_CTX_set_default_verify_paths (ctx);
+
+    if (config.server)
+    {
+        // Clients have to present certificate when CA file is given.
+        if (! config.caFile.empty ())
+            SSL_CTX_set_verify (ctx,
+                SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, nullptr);
+
+        // Server side session cache and tickets are enabled by
+        // default; resumption needs session id context.
+        static unsigned char const sid_ctx[] = "log4cplus";
+        SSL_CTX_set_session_id_context (ctx, sid_ctx, sizeof (sid_ctx) - 1);
+    }
+    else
+    {
+        SSL_CTX_set_verify (ctx,
+            config.verifyPeer ? SSL_VERIFY_PEER : SSL_VERIFY_NONE, nullptr);
+        SSL_CTX_set_session_cache_mode (ctx,
+            SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb (ctx, &openssl_tls_context::newSessionCallback);
+    }
+
+    return true;
+}
+
+
+int
+openssl_tls_context::newSessionCallback (SSL * ssl, SSL_SESSION * session)
+{
+    auto * const self = static_cast<openssl_tls_context *>(
+        SSL_CTX_get_app_data (SSL_get_SSL_CTX (ssl)));
+
+    thread::MutexGuard guard (self->sessionMutex);
+    if (self->lastSession)
+        SSL_SESSION_free (self->lastSession);
+
+    self->lastSession = session;
+
+    // Returning 1 keeps the reference to the session.
+    return 1;
+}
+
+
+void
+openssl_tls_context::receiveTickets (SSL * ssl, SOCKET_TYPE sock)
+{
+    // TLS 1.3 server sends session tickets after the handshake. Log
+    // clients never read, so the tickets are picked up here, waiting
+    // for them only briefly.
+#if defined (LOG4CPLUS_HAVE_POLL_H) && defined (LOG4CPLUS_HAVE_FCNTL_H)
+    if (SSL_version (ssl) != TLS1_3_VERSION)
+        return;
+
+    int const fd = static_cast<int>(sock);
+    struct pollfd pfd = pollfd ();
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    if (::poll (&pfd, 1, 100) != 1)
+        return;
+
+    int const flags = ::fcntl (fd, F_GETFL);
+    if (flags == -1 || ::fcntl (fd, F_SETFL, flags | O_NONBLOCK) == -1)
+        return;
+
+    char byte;
+    SSL_read (ssl, &byte, 1);
+    ERR_clear_error ();
+
+    ::fcntl (fd, F_SETFL, flags);
+
+#else
+    (void) ssl;
+    (void) sock;
+
+#endif
+}
+
+
+std::unique_ptr<TlsChannel>
+openssl_tls_context::startSession (SOCKET_TYPE sock)
+{
+    std::unique_ptr<SSL, decltype (&SSL_free)> ssl (SSL_new (ctx), &SSL_free);
+    if (! ssl || SSL_set_fd (ssl.get (), static_cast<int>(sock)) != 1)
+    {
+        report_ssl_error (LOG4CPLUS_TEXT ("Cannot create TLS session"));
+        return nullptr;
+    }
+
+#if defined (SO_NOSIGPIPE)
+    int optval = 1;
+    setsockopt (static_cast<int>(sock), SOL_SOCKET, SO_NOSIGPIPE, &optval,
+        sizeof (optval));
+#endif
+
+    if (! config.server)
+    {
+        std::string const name (
+            LOG4CPLUS_TSTRING_TO_STRING (config.serverName));
+        if (! name.empty ())
+        {
+            SSL_set_tlsext_host_name (ssl.get (), name.c_str ());
+            if (config.verifyPeer)
+                SSL_set1_host (ssl.get (), name.c_str ());
+        }
+
+        thread::MutexGuard guard (sessionMutex);
+        if (lastSession)
+            SSL_set_session (ssl.get (), lastSession);
+    }
+
+    {
+        sigpipe_guard guard;
+        int const ret = config.server
+            ? SSL_accept (ssl.get ()) : SSL_connect (ssl.get ());
+        if (ret != 1)
+        {
+            report_ssl_error (LOG4CPLUS_TEXT ("TLS handshake failed"));
+            return nullptr;
+        }
+
+        if (! config.server)
+            receiveTickets (ssl.get (), sock);
+    }
+
+    return std::unique_ptr<TlsChannel> (
+        new openssl_tls_channel (ssl.release (), sock));
+}
+
+
+} // namespace
+
+
+std::unique_ptr<TlsContext>
+createOpenSslTlsContext (TlsConfig const & config)
+{
+    std::unique_ptr<openssl_tls_context> context (
+        new openssl_tls_context (config));
+    if (! context->init ())
+        return nullptr;
+
+    return context;
+}
+
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) \
+    && ! defined (LOG4CPLUS_SINGLE_THREADED)
+namespace
+{
+
+//! Writes self-signed certificate and its key into PEM files.
+static
+void
+write_test_certificate (char const * cert_file, char const * key_file)
+{
+    EVP_PKEY * key = EVP_RSA_gen (2048);
+    CATCH_REQUIRE (key);
+    X509 * cert = X509_new ();
+    ASN1_INTEGER_set (X509_get_serialNumber (cert), 1);
+    X509_gmtime_adj (X509_getm_notBefore (cert), 0);
+    X509_gmtime_adj (X509_getm_notAfter (cert), 3600);
+    X509_set_pubkey (cert, key);
+    X509_NAME * name = X509_get_subject_name (cert);
+    X509_NAME_add_entry_by_txt (name, "CN", MBSTRING_ASC,
+        reinterpret_cast<unsigned char const *>("localhost"), -1, -1, 0);
+    X509_set_issuer_name (cert, name);
+    CATCH_REQUIRE (X509_sign (cert, key, EVP_sha256 ()) != 0);
+
+    std::FILE * out = std::fopen (cert_file, "w");
+    PEM_write_X509 (out, cert);
+    std::fclose (out);
+    out = std::fopen (key_file, "w");
+    PEM_write_PrivateKey (out, key, nullptr, nullptr, 0, nullptr, nullptr);
+    std::fclose (out);
+
+    X509_free (cert);
+    EVP_PKEY_free (key);
+}
+
+} // namespace
+
+
+CATCH_TEST_CASE ("TLS sockets", "[sockets]")
+{
+    char const cert_file[] = "log4cplus-tls-test.crt";
+    char const key_file[] = "log4cplus-tls-test.key";
+    write_test_certificate (cert_file, key_file);
+
+    TlsConfig server_config;
+    server_config.server = true;
+    server_config.certFile = LOG4CPLUS_C_STR_TO_TSTRING (cert_file);
+    server_config.keyFile = LOG4CPLUS_C_STR_TO_TSTRING (key_file);
+    std::unique_ptr<TlsContext> server_tls (createTlsContext (server_config));
+    CATCH_REQUIRE (server_tls);
+
+    TlsConfig client_config;
+    client_config.caFile = server_config.certFile;
+    client_config.serverName = LOG4CPLUS_TEXT ("localhost");
+    // Falls back to user space encryption where kTLS is not available.
+    client_config.kernelOffload = true;
+    std::unique_ptr<TlsContext> client_tls (createTlsContext (client_config));
+    CATCH_REQUIRE (client_tls);
+
+    unsigned short const port = 29519;
+    ServerSocket server (port, false, false, LOG4CPLUS_TEXT ("localhost"));
+    CATCH_REQUIRE (server.isOpen ());
+
+    std::string const payload ("hello over TLS");
+    for (int round = 0; round != 2; ++round)
+    {
+        std::string received;
+        std::thread server_thread ([&] {
+            Socket client = server.accept ();
+            if (! client.startTls (*server_tls))
+                return;
+
+            SocketBuffer buffer (payload.size ());
+            if (client.read (buffer))
+                received.assign (buffer.getBuffer (), buffer.getSize ());
+        });
+
+        Socket sock (LOG4CPLUS_TEXT ("localhost"), port);
+        bool const handshake = sock.startTls (*client_tls);
+        bool const written = handshake && sock.write (payload);
+        bool const resumed = handshake && sock.getTlsChannel ()->isResumed ();
+        sock.close ();
+        server_thread.join ();
+
+        CATCH_REQUIRE (handshake);
+        CATCH_REQUIRE (written);
+        CATCH_REQUIRE (received == payload);
+        // The second connection resumes the session of the first one.
+        CATCH_REQUIRE (resumed == (round == 1));
+    }
+
+    std::remove (cert_file);
+    std::remove (key_file);
+}
+
+#endif
+
+} // namespace log4cplus::helpers
+
+#endif // defined (LOG4CPLUS_WITH_OPENSSL)
@@ -0,0 +1,107 @@
+// Module:  Log4cplus
+// File:    tlscontext.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/helpers/tlscontext.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+
+
+namespace log4cplus::helpers {
+
+
+#if defined (LOG4CPLUS_WITH_OPENSSL)
+// from tlscontext-openssl.cxx
+std::unique_ptr<TlsContext> createOpenSslTlsContext (TlsConfig const &);
+
+#endif
+
+
+namespace
+{
+
+struct tls_backend_holder
+{
+    thread::Mutex mutex;
+    TlsBackend backend;
+};
+
+
+static
+tls_backend_holder &
+get_tls_backend_holder ()
+{
+    static tls_backend_holder holder;
+    return holder;
+}
+
+} // namespace
+
+
+TlsChannel::~TlsChannel () = default;
+
+
+TlsContext::~TlsContext () = default;
+
+
+void
+setTlsBackend (TlsBackend backend)
+{
+    tls_backend_holder & holder = get_tls_backend_holder ();
+    thread::MutexGuard guard (holder.mutex);
+    holder.backend = std::move (backend);
+}
+
+
+std::unique_ptr<TlsContext>
+createTlsContext (TlsConfig const & config)
+{
+    TlsBackend backend;
+    {
+        tls_backend_holder & holder = get_tls_backend_holder ();
+        thread::MutexGuard guard (holder.mutex);
+        backend = holder.backend;
+    }
+
+    if (backend)
+        return backend (config);
+
+#if defined (LOG4CPLUS_WITH_OPENSSL)
+    return createOpenSslTlsContext (config);
+
+#else
+    getLogLog ().error (
+        LOG4CPLUS_TEXT ("TLS requested but there is no TLS backend;")
+        LOG4CPLUS_TEXT (" build with OpenSSL or call setTlsBackend()"));
+    return nullptr;
+
+#endif
+}
+
+
+} // namespace log4cplus::helpers
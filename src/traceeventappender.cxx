@@ -0,0 +1,347 @@
+// Module:  Log4cplus
+// File:    traceeventappender.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/traceeventappender.h>
+#include <log4cplus/helpers/fileinfo.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/internal/env.h>
+#include <log4cplus/internal/internal.h>
+#include <charconv>
+#include <chrono>
+#include <functional>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <fstream>
+#include <sstream>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+tchar const enter_prefix[] = LOG4CPLUS_TEXT ("ENTER: ");
+tchar const exit_prefix[] = LOG4CPLUS_TEXT ("EXIT:  ");
+
+
+template <typename T>
+void
+append_integer (tstring & output, T value)
+{
+    char buffer[24];
+    std::to_chars_result const res
+        = std::to_chars (buffer, buffer + sizeof (buffer), value);
+    output.append (static_cast<char const *> (buffer),
+        static_cast<char const *> (res.ptr));
+}
+
+
+//! Appends <code>ns</code> nanoseconds as microseconds, which the
+//! format uses, with three decimal places.
+void
+append_microseconds (tstring & output, std::int64_t ns)
+{
+    if (ns < 0)
+    {
+        output += LOG4CPLUS_TEXT ('-');
+        ns = -ns;
+    }
+
+    append_integer (output, ns / 1000);
+    int const frac = static_cast<int> (ns % 1000);
+    tchar const digits[] = {
+        LOG4CPLUS_TEXT ('.'),
+        static_cast<tchar> (LOG4CPLUS_TEXT ('0') + frac / 100),
+        static_cast<tchar> (LOG4CPLUS_TEXT ('0') + frac / 10 % 10),
+        static_cast<tchar> (LOG4CPLUS_TEXT ('0') + frac % 10) };
+    output.append (digits, 4);
+}
+
+
+//! \return Numeric thread id of <code>event</code>.
+std::int64_t
+get_thread_id (spi::InternalLoggingEvent const & event)
+{
+    tstring const & name = event.getThread2 ();
+    std::int64_t id = 0;
+    for (tchar ch : name)
+    {
+        if (ch < LOG4CPLUS_TEXT ('0') || ch > LOG4CPLUS_TEXT ('9')
+            || id > (INT64_MAX - 9) / 10)
+            return static_cast<std::int64_t> (
+                std::hash<tstring> () (name) & INT32_MAX);
+
+        id = id * 10 + (ch - LOG4CPLUS_TEXT ('0'));
+    }
+
+    return id;
+}
+
+
+bool
+starts_with (tstring const & str, tchar const (& prefix)[8])
+{
+    return str.compare (0, 7, prefix, 7) == 0;
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TraceEventLayout
+///////////////////////////////////////////////////////////////////////////////
+
+TraceEventLayout::TraceEventLayout ()
+    : processId (static_cast<std::int64_t> (internal::get_process_id ()))
+{ }
+
+
+TraceEventLayout::TraceEventLayout (helpers::Properties const & properties)
+    : Layout (properties)
+    , processId (static_cast<std::int64_t> (internal::get_process_id ()))
+{ }
+
+
+TraceEventLayout::~TraceEventLayout ()
+{ }
+
+
+void
+TraceEventLayout::formatAndAppend (tostream & output,
+    spi::InternalLoggingEvent const & event)
+{
+    tstring & str = internal::get_ptd ()->layout_str;
+    str.clear ();
+    formatAndAppend (str, event);
+    output << str;
+}
+
+
+void
+TraceEventLayout::formatAndAppend (tstring & output,
+    spi::InternalLoggingEvent const & event)
+{
+    std::int64_t const tid = get_thread_id (event);
+    auto const append_ids = [&]
+    {
+        output += LOG4CPLUS_TEXT (",\"pid\":");
+        append_integer (output, processId);
+        output += LOG4CPLUS_TEXT (",\"tid\":");
+        append_integer (output, tid);
+    };
+
+    if (namedThreads.find (tid) == namedThreads.end ())
+    {
+        namedThreads.insert (tid);
+        output += LOG4CPLUS_TEXT ("{\"name\":\"thread_name\",\"ph\":\"M\"");
+        append_ids ();
+        output += LOG4CPLUS_TEXT (",\"args\":{\"name\":\"");
+        internal::append_json_escaped (output, event.getThread ());
+        output += LOG4CPLUS_TEXT ("\"}},\n");
+    }
+
+    tstring const & message = event.getMessage ();
+    tstring_view name (message);
+    tchar phase = LOG4CPLUS_TEXT ('i');
+    spi::KeyValue duration;
+    bool const complete = event.getKeyValues ().find (
+        LOG4CPLUS_TEXT ("duration_ns"), duration)
+        && (duration.type == spi::KV_INT || duration.type == spi::KV_UINT);
+    if (complete)
+        phase = LOG4CPLUS_TEXT ('X');
+    else if (starts_with (message, enter_prefix))
+    {
+        phase = LOG4CPLUS_TEXT ('B');
+        name.remove_prefix (7);
+    }
+    else if (starts_with (message, exit_prefix))
+    {
+        phase = LOG4CPLUS_TEXT ('E');
+        name.remove_prefix (7);
+    }
+
+    std::int64_t const end = std::chrono::duration_cast<
+        std::chrono::nanoseconds> (
+            event.getTimestamp ().time_since_epoch ()).count ();
+    std::int64_t const dur = ! complete ? 0
+        : duration.type == spi::KV_INT ? duration.i
+        : static_cast<std::int64_t> (duration.u);
+
+    output += LOG4CPLUS_TEXT ("{\"name\":\"");
+    internal::append_json_escaped (output, name);
+    output += LOG4CPLUS_TEXT ("\",\"cat\":\"");
+    internal::append_json_escaped (output, event.getLoggerName ());
+    output += LOG4CPLUS_TEXT ("\",\"ph\":\"");
+    output += phase;
+    output += LOG4CPLUS_TEXT ("\",\"ts\":");
+    append_microseconds (output, end - dur);
+    if (complete)
+    {
+        output += LOG4CPLUS_TEXT (",\"dur\":");
+        append_microseconds (output, dur);
+    }
+    else if (phase == LOG4CPLUS_TEXT ('i'))
+        output += LOG4CPLUS_TEXT (",\"s\":\"t\"");
+    append_ids ();
+    output += LOG4CPLUS_TEXT ("},\n");
+}
+
+
+unsigned
+TraceEventLayout::getRequiredEventFields () const
+{
+    return spi::EVENT_FIELD_THREAD | spi::EVENT_FIELD_THREAD2;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TraceEventAppender
+///////////////////////////////////////////////////////////////////////////////
+
+TraceEventAppender::TraceEventAppender (tstring const & filename_,
+    bool append_, bool createDirs_)
+    : DirectFileAppender (filename_, append_, true, createDirs_)
+{
+    bufferSize = 64 * 1024;
+    init ();
+}
+
+
+TraceEventAppender::TraceEventAppender (helpers::Properties const & props)
+    : DirectFileAppender (props)
+{
+    if (! props.exists (LOG4CPLUS_TEXT ("BufferSize")))
+        bufferSize = 64 * 1024;
+    init ();
+}
+
+
+TraceEventAppender::~TraceEventAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+TraceEventAppender::init ()
+{
+    setLayout (std::make_unique<TraceEventLayout> ());
+    maxFileSize = 0;
+    if (! isOpen ())
+        return;
+
+    helpers::FileInfo fi;
+    if (helpers::getFileInfo (&fi, filename) != 0 || fi.size != 0)
+        return;
+
+    record = "[\n";
+    if (segment)
+        appendDirect (record);
+    else
+        writeRecords (record);
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("TraceEventAppender", "[appender]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-trace-test.json"));
+    auto const read_file = [&]
+    {
+        std::ifstream in (LOG4CPLUS_TSTRING_TO_STRING (file_name).c_str (),
+            std::ios_base::binary);
+        std::ostringstream oss;
+        oss << in.rdbuf ();
+        return oss.str ();
+    };
+
+    auto const make_event = [] (tchar const * logger, tchar const * msg)
+    {
+        return spi::InternalLoggingEvent (logger, TRACE_LOG_LEVEL,
+            tstring_view (), MappedDiagnosticContextMap (), msg,
+            LOG4CPLUS_TEXT ("main"), LOG4CPLUS_TEXT ("4325"),
+            helpers::Time (std::chrono::seconds (100)), tstring_view (), 0);
+    };
+    spi::InternalLoggingEvent complete = make_event (
+        LOG4CPLUS_TEXT ("app.db"), LOG4CPLUS_TEXT ("query \"a\""));
+    complete.getKeyValues ().addInt (LOG4CPLUS_TEXT ("duration_ns"), 1234567);
+    spi::InternalLoggingEvent const enter = make_event (
+        LOG4CPLUS_TEXT ("app"), LOG4CPLUS_TEXT ("ENTER: f"));
+    spi::InternalLoggingEvent const exit = make_event (
+        LOG4CPLUS_TEXT ("app"), LOG4CPLUS_TEXT ("EXIT:  f"));
+    spi::InternalLoggingEvent const instant = make_event (
+        LOG4CPLUS_TEXT ("app"), LOG4CPLUS_TEXT ("note"));
+
+    std::string const ids = ",\"pid\":"
+        + helpers::convertIntegerToNarrowString (internal::get_process_id ())
+        + ",\"tid\":4325";
+
+    {
+        TraceEventAppender appender (file_name);
+        appender.doAppend (complete);
+        appender.doAppend (enter);
+        appender.doAppend (exit);
+        std::vector<spi::InternalLoggingEvent> const batch (2, instant);
+        appender.doAppendBatch (batch);
+        appender.close ();
+    }
+
+    std::string const instant_line = "{\"name\":\"note\",\"cat\":\"app\","
+        "\"ph\":\"i\",\"ts\":100000000.000,\"s\":\"t\"" + ids + "},\n";
+    CATCH_REQUIRE (read_file () == "[\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\"" + ids
+        + ",\"args\":{\"name\":\"main\"}},\n"
+        "{\"name\":\"query \\\"a\\\"\",\"cat\":\"app.db\",\"ph\":\"X\","
+        "\"ts\":99998765.433,\"dur\":1234.567" + ids + "},\n"
+        "{\"name\":\"f\",\"cat\":\"app\",\"ph\":\"B\","
+        "\"ts\":100000000.000" + ids + "},\n"
+        "{\"name\":\"f\",\"cat\":\"app\",\"ph\":\"E\","
+        "\"ts\":100000000.000" + ids + "},\n"
+        + instant_line + instant_line);
+
+    // Appending to non-empty file does not repeat the bracket.
+    {
+        TraceEventAppender appender (file_name, true);
+        appender.doAppend (instant);
+        appender.close ();
+    }
+    std::string const contents = read_file ();
+    CATCH_REQUIRE (contents.rfind ('[') == 0);
+    CATCH_REQUIRE (contents.size () > instant_line.size ());
+    CATCH_REQUIRE (contents.compare (contents.size () - instant_line.size (),
+        instant_line.size (), instant_line) == 0);
+}
+#endif
+
+} // namespace log4cplus
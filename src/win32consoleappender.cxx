@@ -29,8 +29,10 @@
 #include <log4cplus/win32consoleappender.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/helpers/property.h>
+#include <log4cplus/internal/internal.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
 #include <log4cplus/streams.h>
+#include <chrono>
 #include <sstream>
 
 /* list of available colors which can be OR'ed together and provided as an INT in the config file, e.g.:
@@ -48,14 +50,64 @@
 */
 
 
+#if ! defined (ENABLE_VIRTUAL_TERMINAL_PROCESSING)
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+
+
 namespace log4cplus
 {
 
 
+namespace
+{
+
+//! Maps blue, green and red bits of console attributes to ANSI color
+//! index.
+unsigned
+ansi_color_index (unsigned attrs)
+{
+    return ((attrs & FOREGROUND_BLUE) ? 4 : 0)
+        | ((attrs & FOREGROUND_GREEN) ? 2 : 0)
+        | ((attrs & FOREGROUND_RED) ? 1 : 0);
+}
+
+
+//! SGR escape sequence equivalent to console attributes.
+tstring
+vt_color_sequence (unsigned attrs)
+{
+    unsigned const fg = ((attrs & FOREGROUND_INTENSITY) ? 90 : 30)
+        + ansi_color_index (attrs);
+    unsigned const bg = ((attrs & BACKGROUND_INTENSITY) ? 100 : 40)
+        + ansi_color_index (attrs >> 4);
+
+    tostringstream oss;
+    oss << LOG4CPLUS_TEXT ("\x1b[") << fg << LOG4CPLUS_TEXT (';') << bg
+        << LOG4CPLUS_TEXT ('m');
+    return oss.str ();
+}
+
+
+tchar const vt_reset_sequence[] = LOG4CPLUS_TEXT ("\x1b[0m");
+
+} // namespace
+
+
 Win32ConsoleAppender::Win32ConsoleAppender (bool allocConsole, bool logToStdErr, unsigned int textColor)
     : alloc_console (allocConsole)
     , log_to_std_err (logToStdErr)
     , text_color (textColor)
+    , buffered (false)
+    , virtual_terminal (false)
+    , buffer_size (64 * 1024)
+    , flush_interval (100)
+    , output_handle (INVALID_HANDLE_VALUE)
+    , output_ready (false)
+    , output_is_console (false)
+    , vt_enabled (false)
+    , original_attributes (0)
+    , flush_timer_registered (false)
 { }
 
 
@@ -65,10 +117,42 @@ Win32ConsoleAppender::Win32ConsoleAppender (
     , alloc_console (true)
     , log_to_std_err (false)
     , text_color (0)
+    , buffered (false)
+    , virtual_terminal (false)
+    , buffer_size (64 * 1024)
+    , flush_interval (100)
+    , output_handle (INVALID_HANDLE_VALUE)
+    , output_ready (false)
+    , output_is_console (false)
+    , vt_enabled (false)
+    , original_attributes (0)
+    , flush_timer_registered (false)
 {
     properties.getBool (alloc_console, LOG4CPLUS_TEXT ("AllocConsole"));
     properties.getBool (log_to_std_err, LOG4CPLUS_TEXT ("logToStdErr"));
     properties.getUInt (text_color, LOG4CPLUS_TEXT ("TextColor"));
+    properties.getBool (buffered, LOG4CPLUS_TEXT ("Buffered"));
+    properties.getBool (virtual_terminal,
+        LOG4CPLUS_TEXT ("VirtualTerminal"));
+    properties.getULong (buffer_size, LOG4CPLUS_TEXT ("BufferSize"));
+    properties.getULong (flush_interval,
+        LOG4CPLUS_TEXT ("FlushIntervalMs"));
+
+    if (buffered)
+    {
+        buffer.reserve (buffer_size);
+        last_write = helpers::now ();
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        if (flush_interval != 0)
+        {
+            internal::add_timer (this,
+                std::chrono::milliseconds (flush_interval),
+                [this] { timed_flush (); });
+            flush_timer_registered = true;
+        }
+#endif
+    }
 }
 
 
@@ -81,13 +165,157 @@ Win32ConsoleAppender::~Win32ConsoleAppender ()
 void
 Win32ConsoleAppender::close ()
 {
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // This has to be done before locking access_mutex; the timer thread
+    // locks it while holding its own mutex.
+    if (flush_timer_registered)
+    {
+        internal::remove_timer (this);
+        flush_timer_registered = false;
+    }
+#endif
+
+    thread::MutexGuard guard (access_mutex);
+    flush_buffer ();
     closed = true;
 }
 
 
+void
+Win32ConsoleAppender::timed_flush ()
+{
+    thread::MutexGuard guard (access_mutex);
+    flush_buffer ();
+}
+
+
+void
+Win32ConsoleAppender::init_buffered_output ()
+{
+    output_ready = true;
+
+    if (alloc_console)
+        // We ignore the return value here. If we already have a console,
+        // it will fail.
+        AllocConsole ();
+
+    HANDLE const console_out = GetStdHandle (
+        log_to_std_err ? STD_ERROR_HANDLE : STD_OUTPUT_HANDLE);
+    if (console_out == INVALID_HANDLE_VALUE)
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("Win32ConsoleAppender::init_buffered_output")
+            LOG4CPLUS_TEXT ("- Unable to get STD_OUTPUT_HANDLE."));
+        return;
+    }
+
+    output_handle = console_out;
+
+    DWORD mode;
+    output_is_console = GetFileType (console_out) == FILE_TYPE_CHAR
+        && GetConsoleMode (console_out, &mode);
+    if (! output_is_console)
+        return;
+
+    CONSOLE_SCREEN_BUFFER_INFO csbiInfo;
+    if (GetConsoleScreenBufferInfo (console_out, &csbiInfo))
+        original_attributes = csbiInfo.wAttributes;
+    else
+        // fallback to standard gray on black
+        original_attributes
+            = FOREGROUND_BLUE | FOREGROUND_GREEN | FOREGROUND_RED;
+
+    if (virtual_terminal && text_color)
+        vt_enabled = (mode & ENABLE_VIRTUAL_TERMINAL_PROCESSING)
+            || SetConsoleMode (console_out,
+                mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+}
+
+
+void
+Win32ConsoleAppender::flush_buffer ()
+{
+    if (buffer.empty ())
+        return;
+
+    if (! output_ready)
+        init_buffered_output ();
+
+    if (output_handle == INVALID_HANDLE_VALUE)
+        ;
+    else if (! output_is_console)
+        write_handle (output_handle, buffer.c_str (), buffer.size ());
+    else if (vt_enabled)
+    {
+        // The color travels inside the single write.
+        tstring const color (vt_color_sequence (text_color));
+        buffer.insert (0, color);
+        buffer += vt_reset_sequence;
+        write_console_chars (output_handle, buffer.c_str (), buffer.size ());
+    }
+    else if (text_color)
+    {
+        if (! SetConsoleTextAttribute (output_handle, text_color))
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("Win32ConsoleAppender::flush_buffer:")
+                LOG4CPLUS_TEXT(" SetConsoleTextAttribute failed"));
+
+        write_console_chars (output_handle, buffer.c_str (), buffer.size ());
+
+        if (! SetConsoleTextAttribute (output_handle, original_attributes))
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("Win32ConsoleAppender::flush_buffer:")
+                LOG4CPLUS_TEXT(" SetConsoleTextAttribute failed"));
+    }
+    else
+        write_console_chars (output_handle, buffer.c_str (), buffer.size ());
+
+    buffer.clear ();
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+    last_write = helpers::now ();
+#endif
+}
+
+
+void
+Win32ConsoleAppender::appendBatch (
+    std::span<spi::InternalLoggingEvent const> events)
+{
+    if (! buffered)
+    {
+        Appender::appendBatch (events);
+        return;
+    }
+
+    for (auto const & event : events)
+    {
+        formatEvent (event, buffer);
+        if (buffer.size () >= buffer_size)
+            flush_buffer ();
+    }
+
+    flush_buffer ();
+}
+
+
 void
 Win32ConsoleAppender::append (spi::InternalLoggingEvent const & event)
 {
+    if (buffered)
+    {
+        formatEvent (event, buffer);
+        if (buffer.size () >= buffer_size)
+            flush_buffer ();
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+        // Without timer thread the interval is checked when writing.
+        else if (flush_interval != 0
+            && helpers::now () - last_write
+                >= helpers::chrono::milliseconds (flush_interval))
+            flush_buffer ();
+#endif
+        return;
+    }
+
     if (alloc_console)
         // We ignore the return value here. If we already have a console,
         // it will fail.
@@ -172,8 +400,6 @@ Win32ConsoleAppender::write_console (void * console_void, tchar const * s,
     std::size_t str_len)
 {
     HANDLE console_out = static_cast<HANDLE>(console_void);
-    DWORD const total_to_write = static_cast<DWORD>(str_len);
-    DWORD total_written = 0;
     BOOL ret = FALSE;
     unsigned int oldColor = 0;
 
@@ -205,14 +431,36 @@ Win32ConsoleAppender::write_console (void * console_void, tchar const * s,
     }
 
 output:;
+    write_console_chars (console_out, s, str_len);
+
+    if (text_color)
+    {
+        // restore old color again
+        ret = SetConsoleTextAttribute (console_out, oldColor);
+        if (! ret)
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("Win32ConsoleAppender::write_console:")
+                LOG4CPLUS_TEXT(" SetConsoleTextAttribute failed"));
+    }
+}
+
+
+void
+Win32ConsoleAppender::write_console_chars (void * console_void,
+    tchar const * s, std::size_t str_len)
+{
+    HANDLE console_out = static_cast<HANDLE>(console_void);
+    DWORD const total_to_write = static_cast<DWORD>(str_len);
+    DWORD total_written = 0;
+
     do
     {
         DWORD const to_write
             = (std::min<DWORD>) (64*1024 - 1, total_to_write - total_written);
         DWORD written = 0;
-        
-        ret = WriteConsole (console_out, s + total_written, to_write, &written,
-            0);
+
+        BOOL ret = WriteConsole (console_out, s + total_written, to_write,
+            &written, 0);
         if (! ret)
         {
             helpers::getLogLog ().error (
@@ -224,16 +472,6 @@ output:;
         total_written += written;
     }
     while (total_written != total_to_write);
-
-    if (text_color)
-    {
-        // restore old color again
-        ret = SetConsoleTextAttribute (console_out, oldColor);
-        if (! ret)
-            helpers::getLogLog().error(
-                LOG4CPLUS_TEXT("Win32ConsoleAppender::write_console:")
-                LOG4CPLUS_TEXT(" SetConsoleTextAttribute failed"));
-    }
 }
 
 
@@ -0,0 +1,413 @@
+// Module:  Log4cplus
+// File:    workloadcapture.cxx
+// Created: 10/2026
+//
+//
+//  Copyright (C) 2026, log4cplus authors. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/workloadcapture.h>
+#include <log4cplus/fstreams.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/internal/internal.h>
+#include <log4cplus/internal/env.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch.hpp>
+#include <cstdio>
+#include <filesystem>
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+char const workload_magic[] = "log4cplus-workload";
+unsigned char const workload_version = 1;
+
+//! Record tags.
+char const logger_record = 'L';
+char const event_record = 'E';
+
+//! Upper bound of logger name length read from files.
+std::uint64_t const max_logger_name = 64 * 1024;
+
+
+void
+put_varint (std::string & buf, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buf.push_back (static_cast<char> ((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buf.push_back (static_cast<char> (value));
+}
+
+
+std::uint64_t
+zigzag (std::int64_t value)
+{
+    return (static_cast<std::uint64_t> (value) << 1)
+        ^ static_cast<std::uint64_t> (value >> 63);
+}
+
+
+std::int64_t
+unzigzag (std::uint64_t value)
+{
+    return static_cast<std::int64_t> (value >> 1)
+        ^ -static_cast<std::int64_t> (value & 1);
+}
+
+
+[[noreturn]]
+void
+throw_malformed (tstring const & name, char const * what)
+{
+    throw std::runtime_error ("Malformed workload capture "
+        + LOG4CPLUS_TSTRING_TO_STRING (name) + ": " + what);
+}
+
+
+//! Reads varint from <code>in</code>.
+//! \return <code>false</code> at the end of the input.
+bool
+read_varint (std::istream & in, tstring const & name, std::uint64_t & value)
+{
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+        int const b = in.get ();
+        if (b == std::char_traits<char>::eof ())
+            return false;
+
+        value |= static_cast<std::uint64_t> (b & 0x7f) << shift;
+        if (! (b & 0x80))
+            return true;
+    }
+
+    throw_malformed (name, "overlong varint");
+}
+
+
+std::uint32_t
+to_size (std::size_t size)
+{
+    return static_cast<std::uint32_t> ((std::min) (size,
+        std::size_t (UINT32_MAX)));
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// WorkloadCaptureAppender
+///////////////////////////////////////////////////////////////////////////////
+
+WorkloadCaptureAppender::WorkloadCaptureAppender (tstring const & filename_,
+    bool createDirs_)
+    : filename (filename_)
+    , createDirs (createDirs_)
+    , previousTime (0)
+{
+    open ();
+}
+
+
+WorkloadCaptureAppender::WorkloadCaptureAppender (
+    helpers::Properties const & props)
+    : Appender (props)
+    , createDirs (false)
+    , previousTime (0)
+{
+    filename = props.getProperty (LOG4CPLUS_TEXT ("File"));
+    props.getBool (createDirs, LOG4CPLUS_TEXT ("CreateDirs"));
+    open ();
+}
+
+
+WorkloadCaptureAppender::~WorkloadCaptureAppender ()
+{
+    destructorImpl ();
+}
+
+
+void
+WorkloadCaptureAppender::close ()
+{
+    thread::MutexGuard guard (access_mutex);
+
+    out.close ();
+    closed = true;
+}
+
+
+unsigned
+WorkloadCaptureAppender::getRequiredEventFields () const
+{
+    return spi::EVENT_FIELD_THREAD | spi::EVENT_FIELD_NDC
+        | spi::EVENT_FIELD_MDC;
+}
+
+
+void
+WorkloadCaptureAppender::open ()
+{
+    if (createDirs)
+        internal::make_dirs (filename);
+
+    out.open (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (filename).c_str (),
+        std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+    if (! out.good ())
+    {
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to open file: ") + filename);
+        return;
+    }
+
+    out.write (workload_magic, sizeof (workload_magic) - 1);
+    out.put (static_cast<char> (workload_version));
+    helpers::getLogLog ().debug (
+        LOG4CPLUS_TEXT ("Just opened file: ") + filename);
+}
+
+
+// This method does not need to be locked since it is called by
+// doAppend() which performs the locking
+void
+WorkloadCaptureAppender::append (spi::InternalLoggingEvent const & event)
+{
+    if (! out.good ())
+        return;
+
+    record.clear ();
+
+    auto logger = loggers.find (event.getLoggerName ());
+    if (logger == loggers.end ())
+    {
+        logger = loggers.emplace (event.getLoggerName (),
+            static_cast<std::uint32_t> (loggers.size ())).first;
+
+        std::string loggerName;
+        internal::append_utf8 (loggerName, logger->first);
+        record.push_back (logger_record);
+        put_varint (record, loggerName.size ());
+        record.append (loggerName);
+    }
+
+    auto thread = threads.find (event.getThread ());
+    if (thread == threads.end ())
+        thread = threads.emplace (event.getThread (),
+            static_cast<std::uint32_t> (threads.size ())).first;
+
+    std::size_t mdcSize = 0;
+    MappedDiagnosticContextMap const & mdc = event.getMDCCopy ();
+    for (auto const & entry : mdc)
+        mdcSize += entry.first.size () + entry.second.size ();
+
+    // The first event carries its time since epoch, the others are
+    // relative to their predecessors. Events of several threads can
+    // arrive out of order.
+    std::int64_t const time = std::chrono::duration_cast<
+        std::chrono::microseconds> (
+            event.getTimestamp ().time_since_epoch ()).count ();
+    record.push_back (event_record);
+    put_varint (record, zigzag (time - previousTime));
+    put_varint (record, zigzag (event.getLogLevel ()));
+    put_varint (record, logger->second);
+    put_varint (record, thread->second);
+    put_varint (record, event.getMessage ().size ());
+    put_varint (record, event.getNDC ().size ());
+    put_varint (record, mdc.size ());
+    put_varint (record, mdcSize);
+    previousTime = time;
+
+    out.write (record.data (), static_cast<std::streamsize> (record.size ()));
+    if (! out.good ())
+        getErrorHandler ()->error (
+            LOG4CPLUS_TEXT ("Unable to write to file: ") + filename);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// WorkloadCaptureReader
+///////////////////////////////////////////////////////////////////////////////
+
+WorkloadCaptureReader::WorkloadCaptureReader (tstring const & name)
+    : threadCount (0)
+{
+    std::ifstream in (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (name).c_str (),
+        std::ios_base::in | std::ios_base::binary);
+    if (! in)
+        throw std::runtime_error ("Unable to open file: "
+            + LOG4CPLUS_TSTRING_TO_STRING (name));
+
+    char header[sizeof (workload_magic)];
+    if (! in.read (header, sizeof (header))
+        || std::memcmp (header, workload_magic, sizeof (workload_magic) - 1)
+            != 0)
+        throw_malformed (name, "bad header");
+    if (static_cast<unsigned char> (header[sizeof (header) - 1])
+        != workload_version)
+        throw_malformed (name, "unsupported version");
+
+    std::int64_t first = 0;
+    std::int64_t time = 0;
+    std::string bytes;
+    for (int tag; (tag = in.get ()) != std::char_traits<char>::eof (); )
+    {
+        if (tag == logger_record)
+        {
+            std::uint64_t size;
+            if (! read_varint (in, name, size))
+                break;
+            if (size > max_logger_name)
+                throw_malformed (name, "logger name too long");
+
+            bytes.resize (static_cast<std::size_t> (size));
+            if (! in.read (&bytes[0], static_cast<std::streamsize> (size)))
+                break;
+
+            tstring logger;
+#if defined (UNICODE)
+            helpers::appendFromUtf8 (logger, bytes);
+#else
+            logger = bytes;
+#endif
+            loggers.push_back (std::move (logger));
+        }
+        else if (tag == event_record)
+        {
+            std::uint64_t fields[8];
+            bool complete = true;
+            for (std::uint64_t & field : fields)
+                if (! (complete = read_varint (in, name, field)))
+                    break;
+            if (! complete)
+                break;
+
+            time += unzigzag (fields[0]);
+            if (events.empty ())
+            {
+                start = helpers::Time (std::chrono::duration_cast<
+                    helpers::Time::duration> (
+                        std::chrono::microseconds (time)));
+                first = time;
+            }
+
+            if (fields[2] >= loggers.size () || fields[3] > threadCount)
+                throw_malformed (name, "unknown logger or thread");
+            if (fields[3] == threadCount)
+                ++threadCount;
+
+            events.push_back (WorkloadEvent {time - first,
+                    static_cast<LogLevel> (unzigzag (fields[1])),
+                    static_cast<std::uint32_t> (fields[2]),
+                    static_cast<std::uint32_t> (fields[3]),
+                    to_size (fields[4]), to_size (fields[5]),
+                    to_size (fields[6]), to_size (fields[7])});
+        }
+        else
+            throw_malformed (name, "unknown record");
+    }
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("WorkloadCapture", "[appender]")
+{
+    tstring const file_name (LOG4CPLUS_TEXT ("log4cplus-workload-test.bin"));
+    helpers::Time const start = helpers::now ();
+    auto const event = [&] (tchar const * logger, LogLevel level,
+        int millis, tchar const * thread, std::size_t messageSize,
+        MappedDiagnosticContextMap const & mdc)
+    {
+        return spi::InternalLoggingEvent (logger, level,
+            LOG4CPLUS_TEXT ("ndc"), mdc, tstring (messageSize,
+                LOG4CPLUS_TEXT ('x')), thread, tstring_view (),
+            start + std::chrono::milliseconds (millis), tstring_view (), 0);
+    };
+
+    MappedDiagnosticContextMap mdc;
+    mdc[LOG4CPLUS_TEXT ("traceId")] = LOG4CPLUS_TEXT ("0123456789");
+    {
+        WorkloadCaptureAppender appender (file_name);
+        appender.doAppend (event (LOG4CPLUS_TEXT ("a.b"), INFO_LOG_LEVEL, 0,
+                LOG4CPLUS_TEXT ("1"), 100, MappedDiagnosticContextMap ()));
+        appender.doAppend (event (LOG4CPLUS_TEXT ("c"), DEBUG_LOG_LEVEL, 5,
+                LOG4CPLUS_TEXT ("2"), 10, mdc));
+        appender.doAppend (event (LOG4CPLUS_TEXT ("a.b"), ERROR_LOG_LEVEL, 3,
+                LOG4CPLUS_TEXT ("1"), 100000, mdc));
+        appender.close ();
+    }
+
+    {
+        WorkloadCaptureReader reader (file_name);
+        CATCH_REQUIRE (reader.getStart () == std::chrono::time_point_cast<
+            std::chrono::microseconds> (start));
+        CATCH_REQUIRE (reader.getLoggers () == std::vector<tstring> {
+                LOG4CPLUS_TEXT ("a.b"), LOG4CPLUS_TEXT ("c")});
+        CATCH_REQUIRE (reader.getThreadCount () == 2);
+
+        std::vector<WorkloadEvent> const & events = reader.getEvents ();
+        CATCH_REQUIRE (events.size () == 3);
+        CATCH_REQUIRE (events[0].time == 0);
+        CATCH_REQUIRE (events[0].level == INFO_LOG_LEVEL);
+        CATCH_REQUIRE (events[0].mdcCount == 0);
+        CATCH_REQUIRE (events[1].time == 5000);
+        CATCH_REQUIRE (events[1].logger == 1);
+        CATCH_REQUIRE (events[1].thread == 1);
+        CATCH_REQUIRE (events[1].messageSize == 10);
+        CATCH_REQUIRE (events[1].ndcSize == 3);
+        CATCH_REQUIRE (events[1].mdcCount == 1);
+        CATCH_REQUIRE (events[1].mdcSize == 17);
+        CATCH_REQUIRE (events[2].time == 3000);
+        CATCH_REQUIRE (events[2].logger == 0);
+        CATCH_REQUIRE (events[2].thread == 0);
+        CATCH_REQUIRE (events[2].messageSize == 100000);
+    }
+
+    // Record cut short ends the capture.
+    std::filesystem::path const path (
+        LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (file_name));
+    std::filesystem::resize_file (path,
+        std::filesystem::file_size (path) - 1);
+    CATCH_REQUIRE (WorkloadCaptureReader (file_name).getEvents ().size () == 2);
+
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (file_name).c_str ());
+}
+#endif
+
+
+} // namespace log4cplus
@@ -0,0 +1,79 @@
+#!/usr/bin/env python
+#
+# Smoke test of the Python bindings. It runs itself in a child process
+# that logs through BasicConfigurator's console appender and checks
+# what the child has written to its standard output.
+
+import subprocess
+import sys
+import threading
+
+INFO_LOG_LEVEL = 20000
+DEBUG_LOG_LEVEL = 10000
+
+THREADS = 4
+MESSAGES = 100
+
+
+def child():
+    import log4cplus
+
+    log4cplus.BasicConfigurator.doConfigure()
+    root = log4cplus.Logger.getRoot()
+    root.setLogLevel(INFO_LOG_LEVEL)
+    logger = log4cplus.Logger.getInstance("smoke")
+
+    # Filtered out by the level check of the Python proxy.
+    logger.log(DEBUG_LOG_LEVEL, "debug message")
+    logger.log(INFO_LOG_LEVEL, "info message")
+    logger.logMessages([INFO_LOG_LEVEL, DEBUG_LOG_LEVEL, INFO_LOG_LEVEL],
+                       ["batch 1", "batch debug", "batch 2"])
+
+    # Logger.log() releases the GIL while the appender runs.
+    def produce(n):
+        for i in range(MESSAGES):
+            logger.log(INFO_LOG_LEVEL, "thread %d message %d" % (n, i))
+
+    threads = [threading.Thread(target=produce, args=(n,))
+               for n in range(THREADS)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    queue = log4cplus.AsyncLogQueue(batch=16)
+    for i in range(MESSAGES):
+        queue.put(logger, INFO_LOG_LEVEL, "queued message %d" % i)
+    queue.close()
+
+
+def main():
+    if len(sys.argv) > 1 and sys.argv[1] == "child":
+        child()
+        return 0
+
+    out = subprocess.check_output([sys.executable, __file__, "child"])
+    lines = out.decode("utf-8", "replace").splitlines()
+
+    def count(text):
+        return sum(1 for line in lines if line.endswith(text))
+
+    failures = []
+    if count("debug message") or count("batch debug"):
+        failures.append("DEBUG messages have been logged")
+    if count("- info message") != 1:
+        failures.append("INFO message has not been logged once")
+    if count("batch 1") != 1 or count("batch 2") != 1:
+        failures.append("logMessages() has not logged its messages")
+    if sum(1 for line in lines if " thread " in line) != THREADS * MESSAGES:
+        failures.append("messages of threads are missing")
+    if sum(1 for line in lines if "queued message" in line) != MESSAGES:
+        failures.append("AsyncLogQueue has lost messages")
+
+    for failure in failures:
+        sys.stderr.write(failure + "\n")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
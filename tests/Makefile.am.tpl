@@ -44,7 +44,8 @@ check-local: %D%/atconfig %D%/atlocal $(TESTSUITE)
 clean-local:
 	cd "$(top_builddir)/tests" && (test ! -f "$(abs_top_srcdir)/$(TESTSUITE)" || $(SHELL) "$(abs_top_srcdir)/$(TESTSUITE)" --clean)
 
-EXTRA_DIST += %D%/testsuite.at $(TESTSUITE) %D%/atlocal.in
+EXTRA_DIST += %D%/testsuite.at $(TESTSUITE) %D%/atlocal.in \
+	%D%/benchcommon.h
 [= FOR tests =][=
  (out-push-new (string-append (get "name") "/" "Makefile.am"))
 =]## Generated by Autogen from [= (tpl-file) =]
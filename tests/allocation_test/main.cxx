@@ -0,0 +1,242 @@
+// Counts heap allocations done by the logging thread on the steady
+// state logging path. Global operator new is replaced to count
+// allocations of the calling thread; after warm-up every case logs a
+// batch of events and fails when it allocates more than its budget,
+// which is zero for all of them now.
+//
+// Replacing operator new does not reach into log4cplus built as
+// a Windows DLL; the counts are meaningful on ELF and Mach-O platforms
+// and with static linking.
+
+#include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
+#include <log4cplus/fileappender.h>
+#include <log4cplus/nullappender.h>
+#include <log4cplus/layout.h>
+#include <log4cplus/jsonlayout.h>
+#include <log4cplus/logfmtlayout.h>
+#include <log4cplus/initializer.h>
+#include <log4cplus/helpers/stringhelper.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+
+//! Number of allocations of this thread. It is trivially initialized,
+//! so operator new can use it at any time.
+thread_local std::size_t allocations = 0;
+
+} // namespace
+
+
+// The other forms of operator new and delete, except the aligned
+// ones, are specified to call these. The array and sized forms of
+// delete are replaced too and forward to the unsized one, so that
+// every form releases memory the same way.
+
+void *
+operator new (std::size_t size)
+{
+    ++allocations;
+    if (void * p = std::malloc (size ? size : 1))
+        return p;
+
+    throw std::bad_alloc ();
+}
+
+
+void
+operator delete (void * p) noexcept
+{
+    std::free (p);
+}
+
+
+void
+operator delete (void * p, std::size_t) noexcept
+{
+    operator delete (p);
+}
+
+
+void
+operator delete[] (void * p) noexcept
+{
+    operator delete (p);
+}
+
+
+void
+operator delete[] (void * p, std::size_t) noexcept
+{
+    operator delete (p);
+}
+
+
+using namespace log4cplus;
+
+namespace
+{
+
+std::size_t const WARM_UP = 100;
+std::size_t const EVENTS = 1000;
+
+tstring const FILE_NAME (LOG4CPLUS_TEXT ("log4cplus-allocation-test.log"));
+tchar const * const DEFAULT_PATTERN
+    = LOG4CPLUS_TEXT ("%d{%Y-%m-%d %H:%M:%S,%q} [%t] %-5p %c - %m%n");
+
+
+struct Case
+{
+    char const * name;
+
+    //! Allowed allocations per event.
+    std::size_t budget;
+
+    std::function<SharedAppenderPtr ()> makeAppender;
+
+    //! Logs one event.
+    std::function<void (Logger const &, std::size_t)> log;
+};
+
+
+SharedAppenderPtr
+file ()
+{
+    SharedAppenderPtr app (new FileAppender (FILE_NAME, std::ios_base::trunc,
+            false));
+    app->setLayout (std::make_unique<PatternLayout> (DEFAULT_PATTERN));
+    return app;
+}
+
+
+template <typename LayoutType>
+SharedAppenderPtr
+structuredFile ()
+{
+    SharedAppenderPtr app (new FileAppender (FILE_NAME, std::ios_base::trunc,
+            false));
+    app->setLayout (std::make_unique<LayoutType> ());
+    return app;
+}
+
+
+void
+logStream (Logger const & logger, std::size_t i)
+{
+    LOG4CPLUS_INFO (logger, LOG4CPLUS_TEXT ("Event number ") << i
+        << LOG4CPLUS_TEXT (" of the allocation test."));
+}
+
+
+void
+logStr (Logger const & logger, std::size_t)
+{
+    LOG4CPLUS_INFO_STR (logger,
+        LOG4CPLUS_TEXT ("The quick brown fox jumps over the lazy dog."));
+}
+
+
+void
+logKeyValues (Logger const & logger, std::size_t i)
+{
+    LOG4CPLUS_INFO_KV (logger, LOG4CPLUS_TEXT ("Request done."),
+        LOG4CPLUS_TEXT ("request"), i, LOG4CPLUS_TEXT ("latency_us"), 12.5,
+        LOG4CPLUS_TEXT ("user"), LOG4CPLUS_TEXT ("alice"));
+}
+
+
+//! Looks the logger up by name for every event.
+void
+logLookup (Logger const &, std::size_t)
+{
+    LOG4CPLUS_INFO_STR (
+        Logger::getInstance (LOG4CPLUS_TEXT ("allocation.test")),
+        LOG4CPLUS_TEXT ("The quick brown fox jumps over the lazy dog."));
+}
+
+
+void
+logDisabled (Logger const & logger, std::size_t i)
+{
+    LOG4CPLUS_DEBUG (logger, LOG4CPLUS_TEXT ("Event number ") << i);
+}
+
+
+std::vector<Case>
+makeCases ()
+{
+    auto const null = [] { return SharedAppenderPtr (new NullAppender); };
+    return {
+        {"disabled", 0, null, logDisabled},
+        {"null INFO", 0, null, logStream},
+        {"null INFO_STR", 0, null, logStr},
+        {"null lookup by name", 0, null, logLookup},
+        {"file INFO", 0, file, logStream},
+        {"file INFO_STR", 0, file, logStr},
+        {"JSON file INFO", 0, structuredFile<JsonLayout>, logStream},
+        {"logfmt file INFO", 0, structuredFile<LogfmtLayout>, logStream},
+        {"JSON file INFO_KV", 0, structuredFile<JsonLayout>, logKeyValues},
+        {"logfmt file INFO_KV", 0, structuredFile<LogfmtLayout>,
+         logKeyValues}
+    };
+}
+
+
+//! \return Allocations of EVENTS events in the steady state.
+std::size_t
+run (Case const & c)
+{
+    Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("allocation.test"));
+    logger.removeAllAppenders ();
+    logger.setAdditivity (false);
+    logger.setLogLevel (INFO_LOG_LEVEL);
+    logger.addAppender (c.makeAppender ());
+
+    for (std::size_t i = 0; i != WARM_UP; ++i)
+        c.log (logger, i);
+
+    std::size_t const before = allocations;
+    for (std::size_t i = 0; i != EVENTS; ++i)
+        c.log (logger, WARM_UP + i);
+    std::size_t const count = allocations - before;
+
+    logger.removeAllAppenders ();
+    return count;
+}
+
+} // namespace
+
+
+int
+main ()
+{
+    int status = 0;
+    {
+        log4cplus::Initializer initializer;
+        for (Case const & c : makeCases ())
+        {
+            std::size_t const count = run (c);
+            std::cout << c.name << ": " << count << " allocations in "
+                << EVENTS << " events, budget " << c.budget
+                << " per event\n";
+            if (count > c.budget * EVENTS)
+            {
+                std::cout << c.name << ": over budget\n";
+                status = 1;
+            }
+        }
+    }
+
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (FILE_NAME).c_str ());
+    return status;
+}
@@ -0,0 +1,356 @@
+// Harness shared by the benchmark programs: option parsing helpers,
+// the timed run of producer threads, latency percentiles and JSON
+// output.
+
+#ifndef LOG4CPLUS_TESTS_BENCHCOMMON_H
+#define LOG4CPLUS_TESTS_BENCHCOMMON_H
+
+#include <log4cplus/version.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <latch>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace bench
+{
+
+using steady_clock = std::chrono::steady_clock;
+
+
+//! \return Text following <code>name</code> if <code>arg</code> starts
+//! with it, null otherwise.
+inline
+char const *
+optionValue (std::string const & arg, char const * name)
+{
+    std::size_t const len = std::strlen (name);
+    return arg.compare (0, len, name) == 0 ? arg.c_str () + len : nullptr;
+}
+
+
+//! Appends thread counts of comma separated list <code>v</code>.
+inline
+void
+parseThreads (char const * v, std::vector<unsigned> & threads)
+{
+    std::istringstream iss (v);
+    std::string item;
+    while (std::getline (iss, item, ','))
+        threads.push_back (
+            static_cast<unsigned> (std::strtoul (item.c_str (), nullptr, 10)));
+}
+
+
+//! \return Powers of two below hardware concurrency followed by
+//! hardware concurrency itself.
+inline
+std::vector<unsigned>
+defaultThreads ()
+{
+    std::vector<unsigned> threads;
+    unsigned const hw = (std::max) (std::thread::hardware_concurrency (), 1U);
+    for (unsigned t = 1; t < hw; t *= 2)
+        threads.push_back (t);
+    threads.push_back (hw);
+    return threads;
+}
+
+
+//! Removes zero thread counts.
+//! \return False if no thread count is left.
+inline
+bool
+checkThreads (std::vector<unsigned> & threads)
+{
+    threads.erase (std::remove (threads.begin (), threads.end (), 0U),
+        threads.end ());
+    return ! threads.empty ();
+}
+
+
+//! Prints <code>arg</code> and <code>usage</code> to standard error.
+//! \return False, for parsers to return.
+inline
+bool
+unknownArgument (std::string const & arg, char const * usage)
+{
+    std::cerr << "Unknown argument: " << arg << "\n" << usage << "\n";
+    return false;
+}
+
+
+//! Command line option of parseArguments().
+struct Option
+{
+    //! Name of the option. Names of options taking a value end with
+    //! '='; other options are flags matched whole.
+    char const * name;
+    //! Called with text following the name, empty for flags.
+    std::function<void (char const *)> handle;
+};
+
+
+//! \return Text following name of <code>option</code> if
+//! <code>arg</code> is that option, null otherwise.
+inline
+char const *
+matchOption (std::string const & arg, Option const & option)
+{
+    std::size_t const len = std::strlen (option.name);
+    if (len != 0 && option.name[len - 1] == '=')
+        return optionValue (arg, option.name);
+    else
+        return arg == option.name ? arg.c_str () + len : nullptr;
+}
+
+
+//! Calls the handler of the option of <code>options</code> matching
+//! each argument.
+//! \return False, after printing <code>usage</code>, if an argument
+//! matches no option.
+inline
+bool
+parseArguments (int argc, char * argv[], std::vector<Option> const & options,
+    char const * usage)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string const arg (argv[i]);
+        auto matched = options.end ();
+        char const * value = nullptr;
+        for (auto it = options.begin (); it != options.end (); ++it)
+            if ((value = matchOption (arg, *it)) != nullptr)
+            {
+                matched = it;
+                break;
+            }
+
+        if (matched == options.end ())
+            return unknownArgument (arg, usage);
+
+        matched->handle (value);
+    }
+
+    return true;
+}
+
+
+//! \return Nanoseconds since <code>before</code>, saturated to fit
+//! a sample.
+inline
+std::uint32_t
+elapsedNs (steady_clock::time_point before)
+{
+    std::int64_t const ns = std::chrono::duration_cast<
+        std::chrono::nanoseconds> (steady_clock::now () - before).count ();
+    return static_cast<std::uint32_t> (
+        (std::min) (ns, static_cast<std::int64_t> (UINT32_MAX)));
+}
+
+
+//! Calls <code>call</code>.
+//! \return Duration of the call in nanoseconds, see elapsedNs().
+template <typename Call>
+std::uint32_t
+timeCall (Call && call)
+{
+    steady_clock::time_point const before = steady_clock::now ();
+    call ();
+    return elapsedNs (before);
+}
+
+
+//! Times of a run of producers.
+struct Run
+{
+    steady_clock::time_point begin;
+    steady_clock::time_point end;
+
+    //! \return Seconds from begin to end.
+    double
+    seconds () const
+    {
+        return std::chrono::duration<double> (end - begin).count ();
+    }
+};
+
+
+//! Lets producers of runProducers() start together.
+class StartGate
+{
+public:
+    explicit StartGate (unsigned threads)
+        : ready (threads)
+        , go (1)
+    { }
+
+    //! Called by a producer once it is set up. Waits for the other
+    //! producers.
+    //! \return Start of the run.
+    steady_clock::time_point
+    wait ()
+    {
+        ready.count_down ();
+        go.wait ();
+        return begin;
+    }
+
+private:
+    std::latch ready;
+    std::latch go;
+    steady_clock::time_point begin;
+
+    friend Run runProducers (unsigned,
+        std::function<void (unsigned, StartGate &)> const &);
+};
+
+
+//! Runs <code>produce (t, gate)</code> on <code>threads</code> threads
+//! and waits for all of them. The run begins when all producers have
+//! called <code>gate.wait ()</code> and ends when the last one returns.
+inline
+Run
+runProducers (unsigned threads,
+    std::function<void (unsigned, StartGate &)> const & produce)
+{
+    StartGate gate (threads);
+    std::vector<std::thread> producers;
+    for (unsigned t = 0; t != threads; ++t)
+        producers.emplace_back ([&, t] { produce (t, gate); });
+
+    gate.ready.wait ();
+    Run run;
+    run.begin = gate.begin = steady_clock::now ();
+    gate.go.count_down ();
+    for (auto & producer : producers)
+        producer.join ();
+    run.end = steady_clock::now ();
+    return run;
+}
+
+
+inline
+std::uint64_t
+percentile (std::vector<std::uint32_t> const & sorted, double p)
+{
+    if (sorted.empty ())
+        return 0;
+
+    std::size_t const i = static_cast<std::size_t> (p * (sorted.size () - 1));
+    return sorted[i];
+}
+
+
+//! Latency percentiles of single calls, in nanoseconds.
+struct Latency
+{
+    std::size_t samples = 0;
+    std::uint64_t p50 = 0;
+    std::uint64_t p90 = 0;
+    std::uint64_t p99 = 0;
+    std::uint64_t p999 = 0;
+    std::uint64_t p9999 = 0;
+    std::uint64_t max = 0;
+
+    //! Percentiles written by writeJson() besides p50, p99, p99.9
+    //! and max.
+    enum Extra
+    {
+        P90 = 1,
+        P9999 = 2
+    };
+
+    //! Writes the percentiles as a JSON object.
+    void
+    writeJson (std::ostream & out, unsigned extra = 0) const
+    {
+        out << "{\"p50\": " << p50;
+        if (extra & P90)
+            out << ", \"p90\": " << p90;
+        out << ", \"p99\": " << p99
+            << ", \"p99.9\": " << p999;
+        if (extra & P9999)
+            out << ", \"p99.99\": " << p9999;
+        out << ", \"max\": " << max << "}";
+    }
+};
+
+
+//! Merges samples of all producers and computes their percentiles.
+inline
+Latency
+summarize (std::vector<std::vector<std::uint32_t> > const & latencies)
+{
+    std::size_t total = 0;
+    for (auto const & samples : latencies)
+        total += samples.size ();
+
+    std::vector<std::uint32_t> all;
+    all.reserve (total);
+    for (auto const & samples : latencies)
+        all.insert (all.end (), samples.begin (), samples.end ());
+    std::sort (all.begin (), all.end ());
+
+    Latency latency;
+    latency.samples = all.size ();
+    latency.p50 = percentile (all, 0.5);
+    latency.p90 = percentile (all, 0.9);
+    latency.p99 = percentile (all, 0.99);
+    latency.p999 = percentile (all, 0.999);
+    latency.p9999 = percentile (all, 0.9999);
+    latency.max = all.empty () ? 0 : all.back ();
+    return latency;
+}
+
+
+//! Writes the opening brace of the JSON document and the members
+//! naming the library and its version.
+inline
+void
+writeJsonHeader (std::ostream & out)
+{
+    out << "{\n"
+        << "  \"library\": \"log4cplus\",\n"
+        << "  \"version\": \"" << LOG4CPLUS_VERSION_STR << "\",\n";
+}
+
+
+//! Calls <code>write</code> with standard output, or with file
+//! <code>output</code> unless it is empty.
+//! \return False if the file could not be written.
+inline
+bool
+writeOutput (std::string const & output,
+    std::function<void (std::ostream &)> const & write)
+{
+    if (output.empty ())
+    {
+        write (std::cout);
+        return true;
+    }
+
+    std::ofstream out (output.c_str ());
+    write (out);
+    if (! out)
+    {
+        std::cerr << "Failed to write " << output << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace bench
+
+#endif // LOG4CPLUS_TESTS_BENCHCOMMON_H
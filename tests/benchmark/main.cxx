@@ -0,0 +1,408 @@
+// Scenario driven benchmark of log4cplus. It runs every scenario with
+// 1 to N producer threads and prints throughput and per call latency
+// percentiles as JSON to standard output. Progress goes to standard
+// error.
+//
+// Usage: benchmark [--events=N] [--threads=1,2,4] [--scenario=substring]
+//                  [--port=N] [--output=file] [--quick]
+
+#include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
+#include <log4cplus/appender.h>
+#include <log4cplus/asyncappender.h>
+#include <log4cplus/fileappender.h>
+#include <log4cplus/nullappender.h>
+#include <log4cplus/socketappender.h>
+#include <log4cplus/traceeventappender.h>
+#include <log4cplus/layout.h>
+#include <log4cplus/mdc.h>
+#include <log4cplus/ndc.h>
+#include <log4cplus/initializer.h>
+#include <log4cplus/version.h>
+#include <log4cplus/helpers/socket.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/socketbuffer.h>
+#include <log4cplus/helpers/stringhelper.h>
+
+#include "../benchcommon.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace log4cplus;
+
+namespace
+{
+
+//! Appender that formats events with its layout and throws the result
+//! away, to measure layouts without I/O.
+class FormatOnlyAppender
+    : public Appender
+{
+public:
+    FormatOnlyAppender () = default;
+
+    ~FormatOnlyAppender () override
+    {
+        destructorImpl ();
+    }
+
+    void
+    close () override
+    {
+        closed = true;
+    }
+
+protected:
+    void
+    append (spi::InternalLoggingEvent const & event) override
+    {
+        bytes += formatEvent (event).size ();
+    }
+
+    std::size_t bytes = 0;
+};
+
+
+//! Accepts connections on <code>port</code> and discards everything
+//! that is sent to it.
+class SocketSink
+{
+public:
+    explicit SocketSink (unsigned short port)
+        : server (port)
+    {
+        if (server.isOpen ())
+            thread = std::thread ([this] { run (); });
+    }
+
+    ~SocketSink ()
+    {
+        if (thread.joinable ())
+        {
+            server.interruptAccept ();
+            thread.join ();
+        }
+    }
+
+    bool
+    isOpen () const
+    {
+        return server.isOpen ();
+    }
+
+private:
+    void
+    run ()
+    {
+        std::vector<std::thread> readers;
+        for (;;)
+        {
+            helpers::Socket client = server.accept ();
+            if (! client.isOpen ())
+                break;
+
+            readers.emplace_back (
+                [sock = std::move (client)] () mutable
+                {
+                    helpers::SocketBuffer buffer (4096);
+                    while (sock.read (buffer))
+                        buffer.clear ();
+                });
+        }
+
+        for (auto & reader : readers)
+            reader.join ();
+    }
+
+    helpers::ServerSocket server;
+    std::thread thread;
+};
+
+
+struct Options
+{
+    std::size_t events = 100000;
+    std::vector<unsigned> threads;
+    std::string scenario;
+    std::string output;
+    unsigned short port = 29999;
+};
+
+
+struct Scenario
+{
+    char const * name;
+
+    //! Level of the benchmark logger; events are logged at WARN.
+    LogLevel level;
+
+    //! Returns appender to attach or null to skip the scenario.
+    std::function<SharedAppenderPtr ()> makeAppender;
+};
+
+
+struct Result
+{
+    std::string scenario;
+    unsigned threads;
+    std::size_t events;
+    double seconds;
+    double drainSeconds;
+    bench::Latency latency;
+};
+
+
+tstring const FILE_NAME (LOG4CPLUS_TEXT ("log4cplus-benchmark.log"));
+tchar const * const DEFAULT_PATTERN
+    = LOG4CPLUS_TEXT ("%d{%Y-%m-%d %H:%M:%S,%q} [%t] %-5p %c - %m%n");
+
+
+SharedAppenderPtr
+withLayout (Appender * appender, tchar const * pattern)
+{
+    appender->setLayout (std::make_unique<PatternLayout> (pattern));
+    return SharedAppenderPtr (appender);
+}
+
+
+std::vector<Scenario>
+makeScenarios (Options const & options,
+    std::shared_ptr<SocketSink> & sink)
+{
+    auto const formatOnly = [] (tchar const * pattern)
+    {
+        return [pattern]
+        {
+            return withLayout (new FormatOnlyAppender, pattern);
+        };
+    };
+
+    return {
+        {"disabled", ERROR_LOG_LEVEL,
+         [] { return SharedAppenderPtr (new NullAppender); }},
+        {"null", TRACE_LOG_LEVEL,
+         [] { return SharedAppenderPtr (new NullAppender); }},
+        // Every call writes the in-flight counter of the appender
+        // while other threads read its threshold and filters.
+        {"async_null", TRACE_LOG_LEVEL,
+         [] {
+             helpers::Properties props;
+             props.setProperty (LOG4CPLUS_TEXT ("AsyncAppend"),
+                 LOG4CPLUS_TEXT ("true"));
+             return SharedAppenderPtr (new NullAppender (props));
+         }},
+        {"file", TRACE_LOG_LEVEL,
+         [] { return withLayout (new FileAppender (FILE_NAME,
+                 std::ios_base::trunc, false), DEFAULT_PATTERN); }},
+        {"file_immediate_flush", TRACE_LOG_LEVEL,
+         [] { return withLayout (new FileAppender (FILE_NAME,
+                 std::ios_base::trunc, true), DEFAULT_PATTERN); }},
+        {"rolling_file", TRACE_LOG_LEVEL,
+         [] { return withLayout (new RollingFileAppender (FILE_NAME,
+                 16 * 1024 * 1024, 2, false), DEFAULT_PATTERN); }},
+        {"async_file", TRACE_LOG_LEVEL,
+         [] {
+             SharedAppenderPtr file = withLayout (new FileAppender (
+                     FILE_NAME, std::ios_base::trunc, false),
+                 DEFAULT_PATTERN);
+             return SharedAppenderPtr (new AsyncAppender (file, 8192));
+         }},
+        {"trace_event", TRACE_LOG_LEVEL,
+         [] { return SharedAppenderPtr (new TraceEventAppender (
+                 FILE_NAME)); }},
+        {"socket", TRACE_LOG_LEVEL,
+         [&options, &sink] {
+             if (! sink)
+                 sink = std::make_shared<SocketSink> (options.port);
+             if (! sink->isOpen ())
+                 return SharedAppenderPtr ();
+             return SharedAppenderPtr (new SocketAppender (
+                     LOG4CPLUS_TEXT ("localhost"), options.port));
+         }},
+        {"layout_message", TRACE_LOG_LEVEL,
+         formatOnly (LOG4CPLUS_TEXT ("%m%n"))},
+        {"layout_default", TRACE_LOG_LEVEL,
+         formatOnly (DEFAULT_PATTERN)},
+        {"layout_ttcc", TRACE_LOG_LEVEL,
+         formatOnly (LOG4CPLUS_TEXT ("%r [%t] %-5p %c %x - %m%n"))},
+        {"layout_location", TRACE_LOG_LEVEL,
+         formatOnly (LOG4CPLUS_TEXT ("%D{%H:%M:%S.%q} %-5p %c{2} %l - %m%n"))},
+        {"layout_context", TRACE_LOG_LEVEL,
+         formatOnly (
+             LOG4CPLUS_TEXT ("%d %-5p %c [%X{request}] %x - %m%n"))}
+    };
+}
+
+
+Result
+runScenario (Scenario const & scenario, unsigned threads,
+    std::size_t events, SharedAppenderPtr const & appender)
+{
+    Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("bench.logger"));
+    logger.removeAllAppenders ();
+    logger.setAdditivity (false);
+    logger.setLogLevel (scenario.level);
+    logger.addAppender (appender);
+
+    std::vector<std::vector<std::uint32_t> > latencies (threads);
+    bench::Run const run = bench::runProducers (threads,
+        [&] (unsigned t, bench::StartGate & gate)
+        {
+            std::vector<std::uint32_t> & samples = latencies[t];
+            samples.reserve (events);
+            getMDC ().put (LOG4CPLUS_TEXT ("request"),
+                LOG4CPLUS_TEXT ("req-") + helpers::convertIntegerToString (t));
+            NDCContextCreator ndc (LOG4CPLUS_TEXT ("producer"));
+            tstring const msg (
+                LOG4CPLUS_TEXT ("The quick brown fox jumps over the lazy dog."));
+
+            gate.wait ();
+            for (std::size_t i = 0; i != events; ++i)
+                samples.push_back (bench::timeCall (
+                        [&] { LOG4CPLUS_WARN_STR (logger, msg); }));
+
+            getMDC ().clear ();
+        });
+
+    // Asynchronous appenders finish writing when they are closed.
+    logger.removeAllAppenders ();
+    appender->close ();
+    bench::steady_clock::time_point const drained
+        = bench::steady_clock::now ();
+
+    Result result;
+    result.scenario = scenario.name;
+    result.threads = threads;
+    result.latency = bench::summarize (latencies);
+    result.events = result.latency.samples;
+    result.seconds = run.seconds ();
+    result.drainSeconds = std::chrono::duration<double> (
+        drained - run.end).count ();
+    return result;
+}
+
+
+void
+writeJson (std::ostream & out, Options const & options,
+    std::vector<Result> const & results)
+{
+    bench::writeJsonHeader (out);
+    out << "  \"events_per_thread\": " << options.events << ",\n"
+        << "  \"results\": [";
+
+    char const * separator = "\n";
+    for (Result const & r : results)
+    {
+        out << separator
+            << "    {\"scenario\": \"" << r.scenario << "\""
+            << ", \"threads\": " << r.threads
+            << ", \"events\": " << r.events
+            << ", \"seconds\": " << r.seconds
+            << ", \"events_per_second\": "
+            << (r.seconds > 0 ? r.events / r.seconds : 0.0)
+            << ", \"drain_seconds\": " << r.drainSeconds
+            << ", \"latency_ns\": ";
+        r.latency.writeJson (out);
+        out << "}";
+        separator = ",\n";
+    }
+
+    out << "\n  ]\n}\n";
+}
+
+
+bool
+parseOptions (Options & options, int argc, char * argv[])
+{
+    bool const parsed = bench::parseArguments (argc, argv, {
+            {"--events=", [&] (char const * v) {
+                options.events = std::strtoul (v, nullptr, 10); }},
+            {"--threads=", [&] (char const * v) {
+                bench::parseThreads (v, options.threads); }},
+            {"--scenario=", [&] (char const * v) { options.scenario = v; }},
+            {"--output=", [&] (char const * v) { options.output = v; }},
+            {"--port=", [&] (char const * v) {
+                options.port = static_cast<unsigned short> (
+                    std::strtoul (v, nullptr, 10)); }},
+            {"--quick", [&] (char const *) {
+                options.events = 2000;
+                options.threads = {1, 2}; }}
+        },
+        "Usage: benchmark [--events=N] [--threads=1,2,4]"
+        " [--scenario=substring] [--port=N] [--output=file]"
+        " [--quick]");
+    if (! parsed)
+        return false;
+
+    if (options.threads.empty ())
+        options.threads = bench::defaultThreads ();
+
+    return bench::checkThreads (options.threads) && options.events != 0;
+}
+
+} // namespace
+
+
+int
+main (int argc, char * argv[])
+{
+    Options options;
+    if (! parseOptions (options, argc, argv))
+        return 2;
+
+    log4cplus::Initializer initializer;
+
+    std::vector<Result> results;
+    {
+        std::shared_ptr<SocketSink> sink;
+        for (Scenario const & scenario : makeScenarios (options, sink))
+        {
+            if (std::string (scenario.name).find (options.scenario)
+                == std::string::npos)
+                continue;
+
+            for (unsigned threads : options.threads)
+            {
+                SharedAppenderPtr const appender = scenario.makeAppender ();
+                if (! appender)
+                {
+                    std::cerr << scenario.name << ": skipped\n";
+                    break;
+                }
+
+                results.push_back (runScenario (scenario, threads,
+                        options.events, appender));
+                Result const & r = results.back ();
+                std::cerr << r.scenario << " threads=" << r.threads
+                    << " events/s=" << static_cast<std::uint64_t> (
+                        r.events / r.seconds)
+                    << " p50=" << r.latency.p50
+                    << "ns p99=" << r.latency.p99
+                    << "ns p99.9=" << r.latency.p999 << "ns\n";
+            }
+        }
+
+        Logger::getInstance (LOG4CPLUS_TEXT ("bench.logger"))
+            .removeAllAppenders ();
+    }
+
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (FILE_NAME).c_str ());
+    for (int i = 1; i <= 2; ++i)
+        std::remove ((LOG4CPLUS_TSTRING_TO_STRING (FILE_NAME) + "."
+                + std::to_string (i)).c_str ());
+
+    bool const written = bench::writeOutput (options.output,
+        [&] (std::ostream & out) { writeJson (out, options, results); });
+    return written ? 0 : 1;
+}
@@ -0,0 +1,499 @@
+// Runs the same logging scenarios through log4cplus and other C++
+// logging libraries. Every scenario is run with 1 to N producer threads
+// contending for one logger; throughput and per call latency percentiles
+// are printed as JSON to standard output, a table goes to standard
+// error.
+//
+// Usage: comparebench [--events=N] [--threads=1,2,4] [--library=substring]
+//                     [--scenario=substring] [--output=file] [--quick]
+
+#include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
+#include <log4cplus/asyncappender.h>
+#include <log4cplus/fileappender.h>
+#include <log4cplus/layout.h>
+#include <log4cplus/initializer.h>
+#include <log4cplus/version.h>
+
+#if defined (COMPAREBENCH_WITH_SPDLOG)
+#include <spdlog/spdlog.h>
+#include <spdlog/async.h>
+#include <spdlog/sinks/basic_file_sink.h>
+#endif
+
+#include "../benchcommon.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+
+using namespace log4cplus;
+using bench::steady_clock;
+
+
+enum Scenario
+{
+    //! Formatting call below the logger threshold.
+    DISABLED,
+    //! Constant message, written to a file by the calling thread.
+    SYNC_FILE,
+    //! Constant message, written to a file by a background thread.
+    ASYNC_FILE,
+    //! Message formatted from an integer, a double and a string,
+    //! written to a file by the calling thread.
+    FORMAT_FILE
+};
+
+
+struct ScenarioInfo
+{
+    Scenario scenario;
+    char const * name;
+};
+
+
+ScenarioInfo const SCENARIOS[] = {
+    {DISABLED, "disabled"},
+    {SYNC_FILE, "sync_file"},
+    {ASYNC_FILE, "async_file"},
+    {FORMAT_FILE, "format_file"}
+};
+
+
+char const MESSAGE[] = "The quick brown fox jumps over the lazy dog.";
+char const USER[] = "alice";
+double const DURATION = 3.25;
+
+
+// All backends write the same line, e.g.,
+// 2026-10-15 12:00:00,123 [thread] INFO  bench - message
+// to a file which is not flushed after every event.
+class Backend
+{
+public:
+    virtual ~Backend () = default;
+
+    virtual char const * name () const = 0;
+
+    //! \return Name of the file the backend writes to.
+    std::string fileName () const
+    {
+        return std::string ("comparebench-") + name () + ".log";
+    }
+
+    //! Prepares the scenario.
+    //! \return <code>false</code> if the library has no equivalent.
+    virtual bool setUp (Scenario scenario) = 0;
+
+    //! Logs i-th event of the scenario; called by all producer threads.
+    virtual void log (std::size_t i) = 0;
+
+    //! Flushes and closes the file. Asynchronous backends finish
+    //! writing here.
+    virtual void tearDown () = 0;
+
+protected:
+    Scenario scenario = DISABLED;
+};
+
+
+class Log4cplusBackend
+    : public Backend
+{
+public:
+    Log4cplusBackend ()
+        : logger (Logger::getInstance (LOG4CPLUS_TEXT ("bench")))
+    {
+        logger.setAdditivity (false);
+    }
+
+    virtual char const * name () const
+    {
+        return "log4cplus";
+    }
+
+    virtual bool setUp (Scenario s)
+    {
+        scenario = s;
+        appender = SharedAppenderPtr (new FileAppender (
+                LOG4CPLUS_STRING_TO_TSTRING (fileName ()),
+                std::ios_base::trunc, false));
+        appender->setLayout (std::make_unique<PatternLayout> (
+                LOG4CPLUS_TEXT ("%D{%Y-%m-%d %H:%M:%S,%q} [%t] %-5p %c - %m%n")));
+        if (scenario == ASYNC_FILE)
+            appender = SharedAppenderPtr (new AsyncAppender (appender, 8192));
+
+        logger.setLogLevel (INFO_LOG_LEVEL);
+        logger.addAppender (appender);
+        return true;
+    }
+
+    virtual void log (std::size_t i)
+    {
+        switch (scenario)
+        {
+        case DISABLED:
+            LOG4CPLUS_DEBUG (logger, LOG4CPLUS_TEXT ("request ") << i
+                << LOG4CPLUS_TEXT (" took ") << DURATION
+                << LOG4CPLUS_TEXT (" ms for ") << USER);
+            break;
+
+        case SYNC_FILE:
+        case ASYNC_FILE:
+            LOG4CPLUS_INFO_STR (logger, message);
+            break;
+
+        case FORMAT_FILE:
+            LOG4CPLUS_INFO (logger, LOG4CPLUS_TEXT ("request ") << i
+                << LOG4CPLUS_TEXT (" took ") << DURATION
+                << LOG4CPLUS_TEXT (" ms for ") << USER);
+            break;
+        }
+    }
+
+    virtual void tearDown ()
+    {
+        logger.removeAllAppenders ();
+        appender->close ();
+        appender = SharedAppenderPtr ();
+    }
+
+private:
+    Logger logger;
+    SharedAppenderPtr appender;
+    tstring const message = LOG4CPLUS_C_STR_TO_TSTRING (MESSAGE);
+};
+
+
+// Floor for the file scenarios: the line is formatted with snprintf()
+// and written with fwrite() under a mutex.
+class StdioBackend
+    : public Backend
+{
+public:
+    virtual char const * name () const
+    {
+        return "stdio";
+    }
+
+    virtual bool setUp (Scenario s)
+    {
+        if (s == ASYNC_FILE)
+            return false;
+
+        scenario = s;
+        file = std::fopen (fileName ().c_str (), "w");
+        return file != nullptr;
+    }
+
+    virtual void log (std::size_t i)
+    {
+        if (scenario == DISABLED)
+            return;
+
+        char buf[256];
+        using std::chrono::system_clock;
+        system_clock::time_point const now = system_clock::now ();
+        std::time_t const secs = system_clock::to_time_t (now);
+        unsigned const millis = static_cast<unsigned> (
+            std::chrono::duration_cast<std::chrono::milliseconds> (
+                now.time_since_epoch ()).count () % 1000);
+        unsigned const thread = static_cast<unsigned> (
+            std::hash<std::thread::id> () (std::this_thread::get_id ()));
+
+        std::lock_guard<std::mutex> guard (mutex);
+        std::size_t len = std::strftime (buf, sizeof (buf),
+            "%Y-%m-%d %H:%M:%S", std::localtime (&secs));
+        if (scenario == FORMAT_FILE)
+            len += std::snprintf (buf + len, sizeof (buf) - len,
+                ",%03u [%u] INFO  bench - request %zu took %g ms for %s\n",
+                millis, thread, i, DURATION, USER);
+        else
+            len += std::snprintf (buf + len, sizeof (buf) - len,
+                ",%03u [%u] INFO  bench - %s\n", millis, thread, MESSAGE);
+
+        std::fwrite (buf, 1, (std::min) (len, sizeof (buf) - 1), file);
+    }
+
+    virtual void tearDown ()
+    {
+        std::fclose (file);
+        file = nullptr;
+    }
+
+private:
+    std::FILE * file = nullptr;
+    std::mutex mutex;
+};
+
+
+#if defined (COMPAREBENCH_WITH_SPDLOG)
+class SpdlogBackend
+    : public Backend
+{
+public:
+    virtual char const * name () const
+    {
+        return "spdlog";
+    }
+
+    virtual bool setUp (Scenario s)
+    {
+        scenario = s;
+        if (scenario == ASYNC_FILE)
+        {
+            spdlog::init_thread_pool (8192, 1);
+            logger = spdlog::basic_logger_mt<spdlog::async_factory> (
+                "bench", fileName (), true);
+        }
+        else
+            logger = spdlog::basic_logger_mt ("bench", fileName (), true);
+
+        logger->set_pattern ("%Y-%m-%d %H:%M:%S,%e [%t] %-5!l %n - %v");
+        logger->set_level (spdlog::level::info);
+        return true;
+    }
+
+    virtual void log (std::size_t i)
+    {
+        switch (scenario)
+        {
+        case DISABLED:
+            logger->debug ("request {} took {} ms for {}", i, DURATION, USER);
+            break;
+
+        case SYNC_FILE:
+        case ASYNC_FILE:
+            logger->info (MESSAGE);
+            break;
+
+        case FORMAT_FILE:
+            logger->info ("request {} took {} ms for {}", i, DURATION, USER);
+            break;
+        }
+    }
+
+    virtual void tearDown ()
+    {
+        logger->flush ();
+        logger.reset ();
+        // Drops the logger and joins the thread pool once its queue is
+        // written out.
+        spdlog::shutdown ();
+    }
+
+private:
+    std::shared_ptr<spdlog::logger> logger;
+};
+#endif
+
+
+struct Options
+{
+    std::size_t events = 200000;
+    std::vector<unsigned> threads;
+    std::string library;
+    std::string scenario;
+    std::string output;
+};
+
+
+struct Result
+{
+    std::string library;
+    std::string scenario;
+    unsigned threads;
+    std::size_t events;
+    double seconds;
+    double drainSeconds;
+    std::uintmax_t bytes;
+    bench::Latency latency;
+};
+
+
+Result
+runScenario (Backend & backend, ScenarioInfo const & scenario,
+    unsigned threads, std::size_t events)
+{
+    std::vector<std::vector<std::uint32_t> > latencies (threads);
+    bench::Run const run = bench::runProducers (threads,
+        [&] (unsigned t, bench::StartGate & gate)
+        {
+            std::vector<std::uint32_t> & samples = latencies[t];
+            samples.reserve (events);
+
+            gate.wait ();
+            for (std::size_t i = 0; i != events; ++i)
+                samples.push_back (bench::timeCall (
+                        [&] { backend.log (i); }));
+        });
+
+    backend.tearDown ();
+    steady_clock::time_point const drained = steady_clock::now ();
+
+    std::error_code ec;
+    std::uintmax_t const bytes = std::filesystem::file_size (
+        backend.fileName (), ec);
+
+    Result result;
+    result.library = backend.name ();
+    result.scenario = scenario.name;
+    result.threads = threads;
+    result.latency = bench::summarize (latencies);
+    result.events = result.latency.samples;
+    result.seconds = run.seconds ();
+    result.drainSeconds = std::chrono::duration<double> (
+        drained - run.end).count ();
+    result.bytes = ec ? 0 : bytes;
+    return result;
+}
+
+
+double
+eventsPerSecond (Result const & r)
+{
+    // Asynchronous backends are done only when their queue is written.
+    double const seconds = r.seconds + r.drainSeconds;
+    return seconds > 0 ? r.events / seconds : 0.0;
+}
+
+
+void
+writeJson (std::ostream & out, Options const & options,
+    std::vector<Result> const & results)
+{
+    out << "{\n"
+        << "  \"log4cplus_version\": \"" << LOG4CPLUS_VERSION_STR << "\",\n"
+        << "  \"events_per_thread\": " << options.events << ",\n"
+        << "  \"results\": [";
+
+    char const * separator = "\n";
+    for (Result const & r : results)
+    {
+        out << separator
+            << "    {\"library\": \"" << r.library << "\""
+            << ", \"scenario\": \"" << r.scenario << "\""
+            << ", \"threads\": " << r.threads
+            << ", \"events\": " << r.events
+            << ", \"seconds\": " << r.seconds
+            << ", \"drain_seconds\": " << r.drainSeconds
+            << ", \"events_per_second\": " << eventsPerSecond (r)
+            << ", \"bytes\": " << r.bytes
+            << ", \"latency_ns\": ";
+        r.latency.writeJson (out);
+        out << "}";
+        separator = ",\n";
+    }
+
+    out << "\n  ]\n}\n";
+}
+
+
+void
+writeRow (std::ostream & out, Result const & r)
+{
+    out << std::left << std::setw (12) << r.scenario
+        << std::setw (11) << r.library
+        << std::right << std::setw (8) << r.threads
+        << std::setw (14) << static_cast<std::uint64_t> (eventsPerSecond (r))
+        << std::setw (10) << r.latency.p50
+        << std::setw (10) << r.latency.p99
+        << std::setw (10) << r.latency.p999
+        << std::setw (12) << r.latency.max << "\n";
+}
+
+
+bool
+parseOptions (Options & options, int argc, char * argv[])
+{
+    bool const parsed = bench::parseArguments (argc, argv, {
+            {"--events=", [&] (char const * v) {
+                options.events = std::strtoul (v, nullptr, 10); }},
+            {"--threads=", [&] (char const * v) {
+                bench::parseThreads (v, options.threads); }},
+            {"--library=", [&] (char const * v) { options.library = v; }},
+            {"--scenario=", [&] (char const * v) { options.scenario = v; }},
+            {"--output=", [&] (char const * v) { options.output = v; }},
+            {"--quick", [&] (char const *) {
+                options.events = 2000;
+                options.threads = {1, 2}; }}
+        },
+        "Usage: comparebench [--events=N] [--threads=1,2,4]"
+        " [--library=substring] [--scenario=substring]"
+        " [--output=file] [--quick]");
+    if (! parsed)
+        return false;
+
+    if (options.threads.empty ())
+        options.threads = bench::defaultThreads ();
+
+    return bench::checkThreads (options.threads) && options.events != 0;
+}
+
+} // namespace
+
+
+int
+main (int argc, char * argv[])
+{
+    Options options;
+    if (! parseOptions (options, argc, argv))
+        return 2;
+
+    log4cplus::Initializer initializer;
+
+    std::vector<std::unique_ptr<Backend> > backends;
+    backends.push_back (std::make_unique<Log4cplusBackend> ());
+    backends.push_back (std::make_unique<StdioBackend> ());
+#if defined (COMPAREBENCH_WITH_SPDLOG)
+    backends.push_back (std::make_unique<SpdlogBackend> ());
+#endif
+
+    std::cerr << "scenario    library     threads      events/s"
+        "   p50(ns)   p99(ns) p99.9(ns)     max(ns)\n";
+
+    std::vector<Result> results;
+    for (ScenarioInfo const & scenario : SCENARIOS)
+    {
+        if (std::string (scenario.name).find (options.scenario)
+            == std::string::npos)
+            continue;
+
+        for (unsigned threads : options.threads)
+            for (auto const & backend : backends)
+            {
+                if (std::string (backend->name ()).find (options.library)
+                    == std::string::npos)
+                    continue;
+
+                if (! backend->setUp (scenario.scenario))
+                    continue;
+
+                results.push_back (runScenario (*backend, scenario, threads,
+                        options.events));
+                writeRow (std::cerr, results.back ());
+            }
+    }
+
+    for (auto const & backend : backends)
+        std::remove (backend->fileName ().c_str ());
+
+    bool const written = bench::writeOutput (options.output,
+        [&] (std::ostream & out) { writeJson (out, options, results); });
+    return written ? 0 : 1;
+}
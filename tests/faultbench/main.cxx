@@ -0,0 +1,668 @@
+// Tail latency harness of log4cplus. Producers log through appenders
+// whose sink misbehaves -- it stalls, throttles, slows down in bursts,
+// delays randomly or fails -- and the distribution of producer side
+// latency of single logging calls is printed as JSON to standard
+// output. Progress goes to standard error.
+//
+// Usage: faultbench [--events=N] [--threads=1,2] [--scenario=substring]
+//                   [--fault=substring] [--interval-us=N] [--port=N]
+//                   [--output=file] [--quick]
+
+#include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
+#include <log4cplus/appender.h>
+#include <log4cplus/asyncappender.h>
+#include <log4cplus/fileappender.h>
+#include <log4cplus/socketappender.h>
+#include <log4cplus/layout.h>
+#include <log4cplus/initializer.h>
+#include <log4cplus/version.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/socket.h>
+#include <log4cplus/helpers/socketbuffer.h>
+#include <log4cplus/helpers/stringhelper.h>
+
+#include "../benchcommon.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace log4cplus;
+
+namespace
+{
+
+using bench::steady_clock;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+
+//! Misbehaviour of a sink. Faults are applied per written event for
+//! file sinks and per read of SocketSink::CHUNK bytes for socket sinks.
+struct Fault
+{
+    enum Kind
+    {
+        //! Well behaved sink.
+        NONE,
+
+        //! Every <code>period</code>-th write stalls for
+        //! <code>delay</code>.
+        STALL,
+
+        //! Writes are paced to one per <code>delay</code>.
+        THROTTLE,
+
+        //! First <code>burst</code> writes of every <code>period</code>
+        //! writes take <code>delay</code> each.
+        BURST,
+
+        //! Writes stall with <code>probability</code> for exponentially
+        //! distributed time with mean <code>delay</code>.
+        RANDOM,
+
+        //! Every <code>period</code>-th write fails.
+        FAIL
+    };
+
+    char const * name;
+    Kind kind;
+    std::size_t period;
+    std::size_t burst;
+    microseconds delay;
+    double probability;
+};
+
+
+std::vector<Fault> const FAULTS {
+    {"none", Fault::NONE, 0, 0, microseconds (0), 0},
+    {"stall", Fault::STALL, 1000, 0, milliseconds (50), 0},
+    {"throttle", Fault::THROTTLE, 0, 0, microseconds (20), 0},
+    {"burst", Fault::BURST, 2000, 200, microseconds (200), 0},
+    {"random", Fault::RANDOM, 0, 0, milliseconds (1), 0.01},
+    {"fail", Fault::FAIL, 100, 0, microseconds (0), 0}
+};
+
+
+//! Applies a Fault to a sequence of writes. It is not thread safe, its
+//! users serialize writes anyway.
+class FaultInjector
+{
+public:
+    explicit FaultInjector (Fault const & f)
+        : fault (f)
+        , rng (42)
+    { }
+
+    //! Delays the next write as the fault says.
+    //! \return False if the write should fail.
+    bool
+    next ()
+    {
+        std::size_t const n = writes++;
+        switch (fault.kind)
+        {
+        case Fault::NONE:
+            break;
+
+        case Fault::STALL:
+            if (n % fault.period == fault.period - 1)
+                stall (fault.delay);
+            break;
+
+        case Fault::THROTTLE:
+        {
+            steady_clock::time_point const now = steady_clock::now ();
+            slot = (std::max) (slot + fault.delay, now);
+            if (slot > now)
+            {
+                ++injected;
+                std::this_thread::sleep_until (slot);
+            }
+            break;
+        }
+
+        case Fault::BURST:
+            if (n % fault.period < fault.burst)
+                stall (fault.delay);
+            break;
+
+        case Fault::RANDOM:
+            if (std::uniform_real_distribution<> () (rng) < fault.probability)
+                stall (std::chrono::duration_cast<microseconds> (
+                        std::chrono::duration<double, std::micro> (
+                            std::exponential_distribution<> (
+                                1.0 / fault.delay.count ()) (rng))));
+            break;
+
+        case Fault::FAIL:
+            if (n % fault.period == fault.period - 1)
+            {
+                ++injected;
+                return false;
+            }
+            break;
+        }
+
+        return true;
+    }
+
+    //! \return Number of delays and failures injected so far.
+    std::size_t
+    getInjected () const
+    {
+        return injected.load (std::memory_order_relaxed);
+    }
+
+private:
+    void
+    stall (microseconds delay)
+    {
+        ++injected;
+        std::this_thread::sleep_for (delay);
+    }
+
+    Fault const fault;
+    std::mt19937 rng;
+    std::size_t writes = 0;
+    std::atomic<std::size_t> injected {0};
+    steady_clock::time_point slot;
+};
+
+
+//! Counts errors reported by appenders instead of printing them.
+class CountingErrorHandler
+    : public ErrorHandler
+{
+public:
+    explicit CountingErrorHandler (std::shared_ptr<std::atomic<std::size_t> > c)
+        : count (std::move (c))
+    { }
+
+    void
+    error (tstring const &) override
+    {
+        count->fetch_add (1, std::memory_order_relaxed);
+    }
+
+    void
+    reset () override
+    { }
+
+private:
+    std::shared_ptr<std::atomic<std::size_t> > count;
+};
+
+
+//! Appender that passes events to another appender and injects faults
+//! before every one. It is constructed from properties, so that it
+//! honours <code>AsyncAppend</code>. Failed writes go to the error
+//! handler, the event is lost.
+class FaultyAppender
+    : public Appender
+{
+public:
+    FaultyAppender (helpers::Properties const & props,
+        std::shared_ptr<FaultInjector> inj, SharedAppenderPtr app)
+        : Appender (props)
+        , injector (std::move (inj))
+        , sink (std::move (app))
+    { }
+
+    ~FaultyAppender () override
+    {
+        destructorImpl ();
+    }
+
+    void
+    close () override
+    {
+        sink->close ();
+        closed = true;
+    }
+
+protected:
+    void
+    append (spi::InternalLoggingEvent const & event) override
+    {
+        if (injector->next ())
+            sink->doAppend (event);
+        else
+            getErrorHandler ()->error (
+                LOG4CPLUS_TEXT ("FaultyAppender: injected write failure"));
+    }
+
+    std::shared_ptr<FaultInjector> injector;
+    SharedAppenderPtr sink;
+};
+
+
+//! Accepts connections on <code>port</code> and reads everything that is
+//! sent to it through a FaultInjector. Failures close the connection.
+class SocketSink
+{
+public:
+    static std::size_t const CHUNK = 256;
+
+    explicit SocketSink (unsigned short port)
+        : server (port)
+    {
+        if (server.isOpen ())
+            thread = std::thread ([this] { run (); });
+    }
+
+    ~SocketSink ()
+    {
+        if (thread.joinable ())
+        {
+            server.interruptAccept ();
+            thread.join ();
+        }
+    }
+
+    bool
+    isOpen () const
+    {
+        return server.isOpen ();
+    }
+
+    //! Sets injector used by connections accepted from now on.
+    void
+    setInjector (std::shared_ptr<FaultInjector> inj)
+    {
+        std::lock_guard<std::mutex> guard (mutex);
+        injector = std::move (inj);
+    }
+
+private:
+    void
+    run ()
+    {
+        std::vector<std::thread> readers;
+        for (;;)
+        {
+            helpers::Socket client = server.accept ();
+            if (! client.isOpen ())
+                break;
+
+            std::shared_ptr<FaultInjector> inj;
+            {
+                std::lock_guard<std::mutex> guard (mutex);
+                inj = injector;
+            }
+
+            readers.emplace_back (
+                [sock = std::move (client), inj] () mutable
+                {
+                    helpers::SocketBuffer buffer (CHUNK);
+                    while (sock.read (buffer))
+                    {
+                        buffer.clear ();
+                        if (inj && ! inj->next ())
+                            sock.close ();
+                    }
+                });
+        }
+
+        for (auto & reader : readers)
+            reader.join ();
+    }
+
+    helpers::ServerSocket server;
+    std::mutex mutex;
+    std::shared_ptr<FaultInjector> injector;
+    std::thread thread;
+};
+
+
+struct Options
+{
+    std::size_t events = 20000;
+    std::vector<unsigned> threads;
+    std::string scenario;
+    std::string fault;
+    std::string output;
+    microseconds interval {50};
+    unsigned short port = 29998;
+};
+
+
+//! Everything a scenario creates for one run.
+struct Setup
+{
+    SharedAppenderPtr appender;
+    std::shared_ptr<FaultInjector> injector;
+    std::shared_ptr<std::atomic<std::size_t> > errors;
+    AsyncAppender * async = nullptr;
+};
+
+
+struct Scenario
+{
+    char const * name;
+
+    //! Fills <code>setup.appender</code>, leaves it null to skip the
+    //! scenario.
+    std::function<void (Setup &)> make;
+};
+
+
+struct Result
+{
+    std::string scenario;
+    std::string fault;
+    unsigned threads;
+    std::size_t events;
+    double seconds;
+    double drainSeconds;
+    std::size_t injected;
+    std::size_t errors;
+    std::size_t dropped;
+    bench::Latency latency;
+};
+
+
+tstring const FILE_NAME (LOG4CPLUS_TEXT ("log4cplus-faultbench.log"));
+tchar const * const DEFAULT_PATTERN
+    = LOG4CPLUS_TEXT ("%d{%Y-%m-%d %H:%M:%S,%q} [%t] %-5p %c - %m%n");
+
+
+SharedAppenderPtr
+faultyFile (Setup & setup, bool asyncAppend)
+{
+    SharedAppenderPtr file (new FileAppender (FILE_NAME,
+            std::ios_base::trunc, false));
+    file->setLayout (std::make_unique<PatternLayout> (DEFAULT_PATTERN));
+
+    helpers::Properties props;
+    if (asyncAppend)
+        props.setProperty (LOG4CPLUS_TEXT ("AsyncAppend"),
+            LOG4CPLUS_TEXT ("true"));
+    SharedAppenderPtr faulty (new FaultyAppender (props, setup.injector,
+            file));
+    faulty->setErrorHandler (
+        std::make_unique<CountingErrorHandler> (setup.errors));
+    return faulty;
+}
+
+
+SharedAppenderPtr
+socket (Setup & setup, Options const & options, bool asyncAppend)
+{
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("host"), LOG4CPLUS_TEXT ("localhost"));
+    props.setProperty (LOG4CPLUS_TEXT ("port"),
+        helpers::convertIntegerToString (options.port));
+    if (asyncAppend)
+        props.setProperty (LOG4CPLUS_TEXT ("AsyncAppend"),
+            LOG4CPLUS_TEXT ("true"));
+    SharedAppenderPtr app (new SocketAppender (props));
+    app->setErrorHandler (
+        std::make_unique<CountingErrorHandler> (setup.errors));
+    return app;
+}
+
+
+SharedAppenderPtr
+async (Setup & setup, SharedAppenderPtr const & app,
+    AsyncAppender::OverflowPolicy policy)
+{
+    setup.async = new AsyncAppender (app, 1024);
+    setup.async->setOverflowPolicy (policy, ERROR_LOG_LEVEL);
+    return SharedAppenderPtr (setup.async);
+}
+
+
+std::vector<Scenario>
+makeScenarios (Options const & options,
+    std::shared_ptr<SocketSink> & sink)
+{
+    auto const withSink = [&options, &sink] (Setup & setup)
+    {
+        if (! sink)
+            sink = std::make_shared<SocketSink> (options.port);
+        sink->setInjector (setup.injector);
+        return sink->isOpen ();
+    };
+
+    return {
+        {"file", [] (Setup & s)
+         { s.appender = faultyFile (s, false); }},
+        {"file_asyncappend", [] (Setup & s)
+         { s.appender = faultyFile (s, true); }},
+        {"async_file_block", [] (Setup & s)
+         { s.appender = async (s, faultyFile (s, false),
+                 AsyncAppender::BLOCK); }},
+        {"async_file_drop_newest", [] (Setup & s)
+         { s.appender = async (s, faultyFile (s, false),
+                 AsyncAppender::DROP_NEWEST); }},
+        {"async_file_drop_below_level", [] (Setup & s)
+         { s.appender = async (s, faultyFile (s, false),
+                 AsyncAppender::DROP_BELOW_LEVEL); }},
+        {"socket", [&options, withSink] (Setup & s)
+         {
+             if (withSink (s))
+                 s.appender = socket (s, options, false);
+         }},
+        {"socket_asyncappend", [&options, withSink] (Setup & s)
+         {
+             if (withSink (s))
+                 s.appender = socket (s, options, true);
+         }},
+        {"async_socket_block", [&options, withSink] (Setup & s)
+         {
+             if (withSink (s))
+                 s.appender = async (s, socket (s, options, false),
+                     AsyncAppender::BLOCK);
+         }}
+    };
+}
+
+
+Result
+runScenario (Scenario const & scenario, Fault const & fault,
+    unsigned threads, Options const & options, Setup const & setup)
+{
+    Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("faultbench.logger"));
+    logger.removeAllAppenders ();
+    logger.setAdditivity (false);
+    logger.setLogLevel (TRACE_LOG_LEVEL);
+    logger.addAppender (setup.appender);
+
+    std::size_t const events = options.events;
+    std::vector<std::vector<std::uint32_t> > latencies (threads);
+    bench::Run const run = bench::runProducers (threads,
+        [&] (unsigned t, bench::StartGate & gate)
+        {
+            std::vector<std::uint32_t> & samples = latencies[t];
+            samples.reserve (events);
+            tstring const msg (
+                LOG4CPLUS_TEXT ("The quick brown fox jumps over the lazy dog."));
+
+            // Producers log at a fixed rate rather than as fast as they
+            // can, so that the latency of one call is not dominated by
+            // the queueing of the previous ones. A producer that falls
+            // behind does not try to catch up with bursts.
+            steady_clock::time_point next = gate.wait ();
+            for (std::size_t i = 0; i != events; ++i)
+            {
+                if (options.interval.count () != 0)
+                {
+                    next = (std::max) (next + options.interval,
+                        steady_clock::now ());
+                    std::this_thread::sleep_until (next);
+                }
+
+                samples.push_back (bench::timeCall (
+                        [&] { LOG4CPLUS_WARN_STR (logger, msg); }));
+            }
+        });
+
+    // Like Hierarchy::shutdown(), let AsyncAppend=true appenders finish
+    // before closing them; asynchronous appenders drain when closed.
+    logger.removeAllAppenders ();
+    setup.appender->waitToFinishAsyncLogging ();
+    setup.appender->close ();
+    steady_clock::time_point const drained = steady_clock::now ();
+
+    Result result;
+    result.scenario = scenario.name;
+    result.fault = fault.name;
+    result.threads = threads;
+    result.latency = bench::summarize (latencies);
+    result.events = result.latency.samples;
+    result.seconds = run.seconds ();
+    result.drainSeconds = std::chrono::duration<double> (
+        drained - run.end).count ();
+    result.injected = setup.injector->getInjected ();
+    result.errors = setup.errors->load ();
+    result.dropped = setup.async ? setup.async->getDroppedEventsCount () : 0;
+    return result;
+}
+
+
+void
+writeJson (std::ostream & out, Options const & options,
+    std::vector<Result> const & results)
+{
+    bench::writeJsonHeader (out);
+    out << "  \"events_per_thread\": " << options.events << ",\n"
+        << "  \"interval_us\": " << options.interval.count () << ",\n"
+        << "  \"results\": [";
+
+    char const * separator = "\n";
+    for (Result const & r : results)
+    {
+        out << separator
+            << "    {\"scenario\": \"" << r.scenario << "\""
+            << ", \"fault\": \"" << r.fault << "\""
+            << ", \"threads\": " << r.threads
+            << ", \"events\": " << r.events
+            << ", \"seconds\": " << r.seconds
+            << ", \"drain_seconds\": " << r.drainSeconds
+            << ", \"injected\": " << r.injected
+            << ", \"errors\": " << r.errors
+            << ", \"dropped\": " << r.dropped
+            << ", \"latency_ns\": ";
+        r.latency.writeJson (out,
+            bench::Latency::P90 | bench::Latency::P9999);
+        out << "}";
+        separator = ",\n";
+    }
+
+    out << "\n  ]\n}\n";
+}
+
+
+bool
+parseOptions (Options & options, int argc, char * argv[])
+{
+    bool const parsed = bench::parseArguments (argc, argv, {
+            {"--events=", [&] (char const * v) {
+                options.events = std::strtoul (v, nullptr, 10); }},
+            {"--threads=", [&] (char const * v) {
+                bench::parseThreads (v, options.threads); }},
+            {"--scenario=", [&] (char const * v) { options.scenario = v; }},
+            {"--fault=", [&] (char const * v) { options.fault = v; }},
+            {"--interval-us=", [&] (char const * v) {
+                options.interval = microseconds (
+                    std::strtoul (v, nullptr, 10)); }},
+            {"--output=", [&] (char const * v) { options.output = v; }},
+            {"--port=", [&] (char const * v) {
+                options.port = static_cast<unsigned short> (
+                    std::strtoul (v, nullptr, 10)); }},
+            {"--quick", [&] (char const *) {
+                options.events = 2000;
+                options.threads = {2};
+                options.interval = microseconds (0); }}
+        },
+        "Usage: faultbench [--events=N] [--threads=1,2]"
+        " [--scenario=substring] [--fault=substring]"
+        " [--interval-us=N] [--port=N] [--output=file] [--quick]");
+    if (! parsed)
+        return false;
+
+    if (options.threads.empty ())
+        options.threads = {1, 4};
+
+    return bench::checkThreads (options.threads) && options.events != 0;
+}
+
+} // namespace
+
+
+int
+main (int argc, char * argv[])
+{
+    Options options;
+    if (! parseOptions (options, argc, argv))
+        return 2;
+
+    log4cplus::Initializer initializer;
+
+    std::vector<Result> results;
+    {
+        std::shared_ptr<SocketSink> sink;
+        for (Scenario const & scenario : makeScenarios (options, sink))
+        {
+            if (std::string (scenario.name).find (options.scenario)
+                == std::string::npos)
+                continue;
+
+            for (Fault const & fault : FAULTS)
+            {
+                if (std::string (fault.name).find (options.fault)
+                    == std::string::npos)
+                    continue;
+
+                for (unsigned threads : options.threads)
+                {
+                    Setup setup;
+                    setup.injector = std::make_shared<FaultInjector> (fault);
+                    setup.errors
+                        = std::make_shared<std::atomic<std::size_t> > (0);
+                    scenario.make (setup);
+                    if (! setup.appender)
+                    {
+                        std::cerr << scenario.name << ": skipped\n";
+                        break;
+                    }
+
+                    results.push_back (runScenario (scenario, fault, threads,
+                            options, setup));
+                    Result const & r = results.back ();
+                    std::cerr << r.scenario << " fault=" << r.fault
+                        << " threads=" << r.threads
+                        << " p50=" << r.latency.p50
+                        << "ns p99=" << r.latency.p99
+                        << "ns p99.9=" << r.latency.p999
+                        << "ns max=" << r.latency.max
+                        << "ns errors=" << r.errors
+                        << " dropped=" << r.dropped << "\n";
+                }
+            }
+        }
+
+        Logger::getInstance (LOG4CPLUS_TEXT ("faultbench.logger"))
+            .removeAllAppenders ();
+    }
+
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (FILE_NAME).c_str ());
+
+    bool const written = bench::writeOutput (options.output,
+        [&] (std::ostream & out) { writeJson (out, options, results); });
+    return written ? 0 : 1;
+}
@@ -0,0 +1,354 @@
+// Microbenchmarks of PatternLayout conversion specifiers,
+// helpers::getFormattedTime(), LogLevelManager::toString() and of
+// disabled logging statements. Every
+// case is a single operation repeated until the time budget is spent;
+// the median of several runs is printed as JSON to standard output.
+//
+// Usage: microbench [--case=substring] [--quick]
+
+#include <log4cplus/layout.h>
+#include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
+#include <log4cplus/jsonlayout.h>
+#include <log4cplus/logfmtlayout.h>
+#include <log4cplus/loglevel.h>
+#include <log4cplus/mdc.h>
+#include <log4cplus/initializer.h>
+#include <log4cplus/version.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/helpers/timehelper.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+using namespace log4cplus;
+
+namespace
+{
+
+using steady_clock = std::chrono::steady_clock;
+
+
+struct Case
+{
+    std::string name;
+    std::function<void ()> run;
+};
+
+
+struct Options
+{
+    std::string filter;
+    std::chrono::milliseconds budget {200};
+    int runs = 5;
+};
+
+
+//! Keeps the optimizer from dropping results.
+std::size_t volatile sink;
+
+
+helpers::Time const BASE_TIME = helpers::from_time_t (1700000000)
+    + std::chrono::microseconds (123456);
+
+
+spi::InternalLoggingEvent
+makeEvent (helpers::Time time, tchar const * message
+    = LOG4CPLUS_TEXT ("The quick brown fox jumps over the lazy dog."))
+{
+    MappedDiagnosticContextMap mdc;
+    mdc[LOG4CPLUS_TEXT ("key")] = LOG4CPLUS_TEXT ("value");
+    mdc[LOG4CPLUS_TEXT ("request")] = LOG4CPLUS_TEXT ("req-42");
+    return spi::InternalLoggingEvent (
+        LOG4CPLUS_TEXT ("com.example.service.RequestHandler"),
+        WARN_LOG_LEVEL, LOG4CPLUS_TEXT ("outer inner"), mdc,
+        message, LOG4CPLUS_TEXT ("12345"), LOG4CPLUS_TEXT ("worker-1"), time,
+        LOG4CPLUS_TEXT ("/src/project/service/handler.cxx"), 123,
+        LOG4CPLUS_TEXT ("void RequestHandler::handle()"));
+}
+
+
+void
+addKeyValues (spi::InternalLoggingEvent & event)
+{
+    spi::KeyValues & kvs = event.getKeyValues ();
+    kvs.add (LOG4CPLUS_TEXT ("user"), 4242);
+    kvs.add (LOG4CPLUS_TEXT ("latency_us"), 12.5);
+    kvs.add (LOG4CPLUS_TEXT ("route"), LOG4CPLUS_TEXT ("/api/v1/items"));
+}
+
+
+Case
+layoutCase (std::string const & name, tchar const * pattern)
+{
+    auto layout = std::make_shared<PatternLayout> (pattern);
+    auto event = std::make_shared<spi::InternalLoggingEvent> (
+        makeEvent (BASE_TIME));
+    auto output = std::make_shared<tstring> ();
+    return {name, [=]
+    {
+        output->clear ();
+        layout->formatAndAppend (*output, *event);
+        sink = output->size ();
+    }};
+}
+
+
+//! Like layoutCase() but every event starts a new second, so that
+//! cached date strings cannot be reused.
+Case
+layoutNewSecondCase (std::string const & name, tchar const * pattern)
+{
+    auto layout = std::make_shared<PatternLayout> (pattern);
+    auto events = std::make_shared<std::vector<spi::InternalLoggingEvent> > ();
+    for (int i = 0; i != 1024; ++i)
+        events->push_back (makeEvent (BASE_TIME + std::chrono::seconds (i)));
+    auto output = std::make_shared<tstring> ();
+    auto index = std::make_shared<std::size_t> (0);
+    return {name, [=]
+    {
+        output->clear ();
+        layout->formatAndAppend (*output,
+            (*events)[(*index)++ % events->size ()]);
+        sink = output->size ();
+    }};
+}
+
+
+template <typename LayoutType>
+Case
+structuredLayoutCase (std::string const & name, tchar const * message,
+    bool keyValues = false)
+{
+    auto layout = std::make_shared<LayoutType> ();
+    auto event = std::make_shared<spi::InternalLoggingEvent> (
+        makeEvent (BASE_TIME, message));
+    if (keyValues)
+        addKeyValues (*event);
+    auto output = std::make_shared<tstring> ();
+    return {name, [=]
+    {
+        output->clear ();
+        layout->formatAndAppend (*output, *event);
+        sink = output->size ();
+    }};
+}
+
+
+Case
+formattedTimeCase (std::string const & name, tchar const * format)
+{
+    tstring const fmt (format);
+    return {name, [fmt]
+    {
+        sink = helpers::getFormattedTime (fmt, BASE_TIME).size ();
+    }};
+}
+
+
+//! Disabled statements of several levels between cheap arithmetic;
+//! compare builds with and without LOG4CPLUS_MACRO_DISABLE_OUTLINING.
+int
+disabledCallSites (Logger const & logger, int x)
+{
+    x = x * 31 + 1;
+    LOG4CPLUS_DEBUG (logger, "debug " << x << " step " << 1);
+    x = x * 31 + 2;
+    LOG4CPLUS_INFO (logger, "info " << x << " step " << 2);
+    x = x * 31 + 3;
+    LOG4CPLUS_WARN (logger, "warn " << x << " step " << 3);
+    x = x * 31 + 4;
+    LOG4CPLUS_DEBUG (logger, "debug " << x << " step " << 4);
+    x = x * 31 + 5;
+    LOG4CPLUS_INFO (logger, "info " << x << " step " << 5);
+    x = x * 31 + 6;
+    LOG4CPLUS_WARN (logger, "warn " << x << " step " << 6);
+    x = x * 31 + 7;
+    LOG4CPLUS_DEBUG (logger, "debug " << x << " step " << 7);
+    x = x * 31 + 8;
+    LOG4CPLUS_INFO (logger, "info " << x << " step " << 8);
+    return x;
+}
+
+
+std::vector<Case>
+makeCases ()
+{
+    std::vector<Case> cases {
+        layoutCase ("layout %m", LOG4CPLUS_TEXT ("%m")),
+        layoutCase ("layout %m%n", LOG4CPLUS_TEXT ("%m%n")),
+        layoutCase ("layout literal", LOG4CPLUS_TEXT ("some literal text")),
+        layoutCase ("layout %p", LOG4CPLUS_TEXT ("%p")),
+        layoutCase ("layout %-5p", LOG4CPLUS_TEXT ("%-5p")),
+        layoutCase ("layout %c", LOG4CPLUS_TEXT ("%c")),
+        layoutCase ("layout %c{2}", LOG4CPLUS_TEXT ("%c{2}")),
+        layoutCase ("layout %-40c", LOG4CPLUS_TEXT ("%-40c")),
+        layoutCase ("layout %.10c", LOG4CPLUS_TEXT ("%.10c")),
+        layoutCase ("layout %t", LOG4CPLUS_TEXT ("%t")),
+        layoutCase ("layout %T", LOG4CPLUS_TEXT ("%T")),
+        layoutCase ("layout %i", LOG4CPLUS_TEXT ("%i")),
+        layoutCase ("layout %x", LOG4CPLUS_TEXT ("%x")),
+        layoutCase ("layout %X{key}", LOG4CPLUS_TEXT ("%X{key}")),
+        layoutCase ("layout %X", LOG4CPLUS_TEXT ("%X")),
+        layoutCase ("layout %l", LOG4CPLUS_TEXT ("%l")),
+        layoutCase ("layout %F", LOG4CPLUS_TEXT ("%F")),
+        layoutCase ("layout %b", LOG4CPLUS_TEXT ("%b")),
+        layoutCase ("layout %L", LOG4CPLUS_TEXT ("%L")),
+        layoutCase ("layout %M", LOG4CPLUS_TEXT ("%M")),
+        layoutCase ("layout %r", LOG4CPLUS_TEXT ("%r")),
+        layoutCase ("layout %d", LOG4CPLUS_TEXT ("%d")),
+        layoutCase ("layout %D", LOG4CPLUS_TEXT ("%D")),
+        layoutCase ("layout %d{%H:%M:%S}", LOG4CPLUS_TEXT ("%d{%H:%M:%S}")),
+        layoutCase ("layout %d{%Y-%m-%d %H:%M:%S,%q}",
+            LOG4CPLUS_TEXT ("%d{%Y-%m-%d %H:%M:%S,%q}")),
+        layoutCase ("layout %D{%Y-%m-%dT%H:%M:%S.%Q}",
+            LOG4CPLUS_TEXT ("%D{%Y-%m-%dT%H:%M:%S.%Q}")),
+        layoutNewSecondCase ("layout %d{%Y-%m-%d %H:%M:%S,%q} new second",
+            LOG4CPLUS_TEXT ("%d{%Y-%m-%d %H:%M:%S,%q}")),
+        layoutCase ("layout default",
+            LOG4CPLUS_TEXT ("%d{%Y-%m-%d %H:%M:%S,%q} [%t] %-5p %c - %m%n")),
+        layoutCase ("layout ttcc",
+            LOG4CPLUS_TEXT ("%r [%t] %-5p %c %x - %m%n")),
+        structuredLayoutCase<JsonLayout> ("JsonLayout", LOG4CPLUS_TEXT (
+                "The quick brown fox jumps over the lazy dog.")),
+        structuredLayoutCase<JsonLayout> ("JsonLayout escaped message",
+            LOG4CPLUS_TEXT ("Value \"quoted\"\n\tand C:\\path\\to\\file")),
+        structuredLayoutCase<LogfmtLayout> ("LogfmtLayout", LOG4CPLUS_TEXT (
+                "The quick brown fox jumps over the lazy dog.")),
+        structuredLayoutCase<LogfmtLayout> ("LogfmtLayout bare message",
+            LOG4CPLUS_TEXT ("request_completed")),
+        structuredLayoutCase<JsonLayout> ("JsonLayout key/values",
+            LOG4CPLUS_TEXT ("request_completed"), true),
+        structuredLayoutCase<LogfmtLayout> ("LogfmtLayout key/values",
+            LOG4CPLUS_TEXT ("request_completed"), true),
+        formattedTimeCase ("getFormattedTime %H:%M:%S",
+            LOG4CPLUS_TEXT ("%H:%M:%S")),
+        formattedTimeCase ("getFormattedTime %Y-%m-%d %H:%M:%S,%q",
+            LOG4CPLUS_TEXT ("%Y-%m-%d %H:%M:%S,%q")),
+        formattedTimeCase ("getFormattedTime %H:%M:%S.%Q",
+            LOG4CPLUS_TEXT ("%H:%M:%S.%Q"))
+    };
+
+    LogLevelManager & llm = getLogLevelManager ();
+    cases.push_back ({"LogLevelManager::toString WARN", [&llm]
+    {
+        sink = llm.toString (WARN_LOG_LEVEL).size ();
+    }});
+    cases.push_back ({"LogLevelManager::toString unknown", [&llm]
+    {
+        sink = llm.toString (12345).size ();
+    }});
+
+    Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("microbench"));
+    logger.setLogLevel (ERROR_LOG_LEVEL);
+    cases.push_back ({"disabled call sites x8", [logger]
+    {
+        sink = static_cast<std::size_t> (disabledCallSites (logger,
+            static_cast<int> (sink)));
+    }});
+
+    return cases;
+}
+
+
+//! Returns nanoseconds per operation of one run of <code>c</code>.
+double
+measure (Case const & c, std::chrono::milliseconds budget,
+    std::uint64_t & iterations)
+{
+    // Grow the batch until it fills the budget.
+    std::uint64_t batch = 1;
+    for (;;)
+    {
+        steady_clock::time_point const start = steady_clock::now ();
+        for (std::uint64_t i = 0; i != batch; ++i)
+            c.run ();
+        steady_clock::duration const elapsed = steady_clock::now () - start;
+        if (elapsed >= budget || batch >= (UINT64_C (1) << 40))
+        {
+            iterations = batch;
+            return std::chrono::duration<double, std::nano> (elapsed).count ()
+                / static_cast<double> (batch);
+        }
+
+        batch *= elapsed * 10 < budget ? 10 : 2;
+    }
+}
+
+
+std::string
+jsonEscape (std::string const & str)
+{
+    std::string result;
+    for (char ch : str)
+    {
+        if (ch == '"' || ch == '\\')
+            result += '\\';
+        result += ch;
+    }
+    return result;
+}
+
+} // namespace
+
+
+int
+main (int argc, char * argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string const arg (argv[i]);
+        if (arg.compare (0, 7, "--case=") == 0)
+            options.filter = arg.substr (7);
+        else if (arg == "--quick")
+        {
+            options.budget = std::chrono::milliseconds (5);
+            options.runs = 1;
+        }
+        else
+        {
+            std::cerr << "Unknown argument: " << arg << "\n"
+                "Usage: microbench [--case=substring] [--quick]\n";
+            return 2;
+        }
+    }
+
+    log4cplus::Initializer initializer;
+
+    std::cout << "{\n"
+        << "  \"library\": \"log4cplus\",\n"
+        << "  \"version\": \"" << LOG4CPLUS_VERSION_STR << "\",\n"
+        << "  \"results\": [";
+
+    char const * separator = "\n";
+    for (Case const & c : makeCases ())
+    {
+        if (c.name.find (options.filter) == std::string::npos)
+            continue;
+
+        std::vector<double> runs;
+        std::uint64_t iterations = 0;
+        for (int run = 0; run != options.runs; ++run)
+            runs.push_back (measure (c, options.budget, iterations));
+        std::sort (runs.begin (), runs.end ());
+        double const median = runs[runs.size () / 2];
+
+        std::cerr << c.name << ": " << median << " ns/op\n";
+        std::cout << separator
+            << "    {\"case\": \"" << jsonEscape (c.name) << "\""
+            << ", \"ns_per_op\": " << median
+            << ", \"iterations\": " << iterations << "}";
+        separator = ",\n";
+    }
+
+    std::cout << "\n  ]\n}\n";
+    return 0;
+}
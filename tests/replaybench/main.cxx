@@ -0,0 +1,321 @@
+// Replays logging workload captured by WorkloadCaptureAppender against
+// any configuration. One thread per captured thread logs events of the
+// captured shapes at their captured times and the distribution of
+// latency of single logging calls is printed as JSON to standard
+// output. Progress goes to standard error.
+//
+// Usage: replaybench --capture=file [--config=file] [--speed=X]
+//                    [--output=file] [--quick]
+
+#include <log4cplus/logger.h>
+#include <log4cplus/configurator.h>
+#include <log4cplus/hierarchy.h>
+#include <log4cplus/initializer.h>
+#include <log4cplus/mdc.h>
+#include <log4cplus/ndc.h>
+#include <log4cplus/version.h>
+#include <log4cplus/workloadcapture.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/spi/loggingevent.h>
+
+#include "../benchcommon.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace log4cplus;
+
+namespace
+{
+
+using bench::steady_clock;
+
+
+struct Options
+{
+    std::string capture;
+    std::string config;
+    std::string output;
+    double speed = 1;
+    bool quick = false;
+};
+
+
+struct Result
+{
+    std::size_t events = 0;
+    std::size_t threads = 0;
+    double capturedSeconds = 0;
+    double seconds = 0;
+    bench::Latency latency;
+    std::uint64_t maxLagUs = 0;
+};
+
+
+tstring const QUICK_CAPTURE (LOG4CPLUS_TEXT ("replaybench-quick.bin"));
+
+
+//! Writes a short synthetic capture: two threads, a few loggers of
+//! various depths, mostly small messages and some large ones.
+void
+writeQuickCapture ()
+{
+    WorkloadCaptureAppender capture (QUICK_CAPTURE);
+    tstring const loggers[] = {LOG4CPLUS_TEXT ("app"),
+        LOG4CPLUS_TEXT ("app.db"), LOG4CPLUS_TEXT ("app.http.server")};
+    LogLevel const levels[] = {DEBUG_LOG_LEVEL, INFO_LOG_LEVEL,
+        INFO_LOG_LEVEL, WARN_LOG_LEVEL, ERROR_LOG_LEVEL};
+    tstring const threads[] = {LOG4CPLUS_TEXT ("1"), LOG4CPLUS_TEXT ("2")};
+    MappedDiagnosticContextMap mdc;
+    mdc[LOG4CPLUS_TEXT ("traceId")] = tstring (32, LOG4CPLUS_TEXT ('0'));
+
+    helpers::Time const start = helpers::now ();
+    for (std::size_t i = 0; i != 2000; ++i)
+    {
+        spi::InternalLoggingEvent const event (loggers[i % 3],
+            levels[i % 5], tstring_view (),
+            i % 2 ? mdc : MappedDiagnosticContextMap (),
+            tstring (i % 100 == 0 ? 4096 : 80, LOG4CPLUS_TEXT ('x')),
+            threads[i % 2], tstring_view (),
+            start + std::chrono::microseconds (i * 100), tstring_view (),
+            0);
+        capture.doAppend (event);
+    }
+
+    capture.close ();
+}
+
+
+//! Sets NDC and MDC of the calling thread to the sizes of the event.
+//! They are changed only when the shape changes, as applications
+//! mostly set them once per request.
+class ContextShaper
+{
+public:
+    void
+    apply (WorkloadEvent const & event)
+    {
+        if (event.ndcSize != ndcSize)
+        {
+            NDC & ndc = getNDC ();
+            ndc.clear ();
+            if (event.ndcSize != 0)
+                ndc.push (tstring (event.ndcSize, LOG4CPLUS_TEXT ('n')));
+            ndcSize = event.ndcSize;
+        }
+
+        if (event.mdcCount != mdcCount || event.mdcSize != mdcSize)
+        {
+            MDC & mdc = getMDC ();
+            mdc.clear ();
+            for (std::uint32_t i = 0; i != event.mdcCount; ++i)
+            {
+                tstring key (LOG4CPLUS_TEXT ("k"));
+                key += helpers::convertIntegerToString (i);
+                std::size_t const share = event.mdcSize / event.mdcCount;
+                mdc.put (key, tstring (share > key.size ()
+                        ? share - key.size () : 0, LOG4CPLUS_TEXT ('m')));
+            }
+            mdcCount = event.mdcCount;
+            mdcSize = event.mdcSize;
+        }
+    }
+
+private:
+    std::uint32_t ndcSize = 0;
+    std::uint32_t mdcCount = 0;
+    std::uint32_t mdcSize = 0;
+};
+
+
+Result
+replay (WorkloadCaptureReader const & capture, double speed)
+{
+    std::vector<Logger> loggers;
+    for (tstring const & name : capture.getLoggers ())
+        loggers.push_back (Logger::getInstance (name));
+
+    std::uint32_t const threads = capture.getThreadCount ();
+    std::vector<std::vector<WorkloadEvent const *> > perThread (threads);
+    std::size_t longest = 0;
+    for (WorkloadEvent const & event : capture.getEvents ())
+    {
+        perThread[event.thread].push_back (&event);
+        longest = (std::max<std::size_t>) (longest, event.messageSize);
+    }
+
+    // Messages are views of one buffer, so that producing them does not
+    // dominate the replay.
+    tstring const text (longest, LOG4CPLUS_TEXT ('x'));
+
+    std::vector<std::vector<std::uint32_t> > latencies (threads);
+    std::vector<std::int64_t> lags (threads, 0);
+    bench::Run const run = bench::runProducers (threads,
+        [&] (unsigned t, bench::StartGate & gate)
+        {
+            std::vector<std::uint32_t> & samples = latencies[t];
+            samples.reserve (perThread[t].size ());
+            ContextShaper context;
+
+            steady_clock::time_point const begin = gate.wait ();
+
+            for (WorkloadEvent const * event : perThread[t])
+            {
+                if (speed != 0)
+                {
+                    steady_clock::time_point const due = begin
+                        + std::chrono::duration_cast<steady_clock::duration> (
+                            std::chrono::duration<double, std::micro> (
+                                static_cast<double> (event->time) / speed));
+                    std::this_thread::sleep_until (due);
+                    lags[t] = (std::max) (lags[t], static_cast<std::int64_t> (
+                            std::chrono::duration_cast<
+                                std::chrono::microseconds> (
+                                    steady_clock::now () - due).count ()));
+                }
+
+                context.apply (*event);
+                Logger const & logger = loggers[event->logger];
+                tstring_view const message (text.data (),
+                    event->messageSize);
+
+                samples.push_back (bench::timeCall ([&]
+                    {
+                        if (logger.isEnabledFor (event->level))
+                            logger.forcedLog (event->level, message,
+                                __FILE__, __LINE__);
+                    }));
+            }
+
+            getNDC ().remove ();
+            getMDC ().clear ();
+        });
+
+    Result result;
+    result.latency = bench::summarize (latencies);
+    result.events = result.latency.samples;
+    result.threads = threads;
+    for (WorkloadEvent const & event : capture.getEvents ())
+        result.capturedSeconds = (std::max) (result.capturedSeconds,
+            static_cast<double> (event.time) / 1e6);
+    result.seconds = run.seconds ();
+    for (std::int64_t lag : lags)
+        result.maxLagUs = (std::max) (result.maxLagUs,
+            static_cast<std::uint64_t> ((std::max) (lag, std::int64_t (0))));
+    return result;
+}
+
+
+void
+writeJson (std::ostream & out, Options const & options, Result const & r)
+{
+    bench::writeJsonHeader (out);
+    out << "  \"capture\": \"" << options.capture << "\",\n"
+        << "  \"config\": \"" << options.config << "\",\n"
+        << "  \"speed\": " << options.speed << ",\n"
+        << "  \"events\": " << r.events << ",\n"
+        << "  \"threads\": " << r.threads << ",\n"
+        << "  \"captured_seconds\": " << r.capturedSeconds << ",\n"
+        << "  \"seconds\": " << r.seconds << ",\n"
+        << "  \"max_lag_us\": " << r.maxLagUs << ",\n"
+        << "  \"latency_ns\": ";
+    r.latency.writeJson (out, bench::Latency::P90);
+    out << "\n}\n";
+}
+
+
+bool
+parseOptions (Options & options, int argc, char * argv[])
+{
+    bool const parsed = bench::parseArguments (argc, argv, {
+            {"--capture=", [&] (char const * v) { options.capture = v; }},
+            {"--config=", [&] (char const * v) { options.config = v; }},
+            {"--speed=", [&] (char const * v) {
+                options.speed = std::strtod (v, nullptr); }},
+            {"--output=", [&] (char const * v) { options.output = v; }},
+            {"--quick", [&] (char const *) {
+                options.quick = true;
+                options.speed = 0; }}
+        },
+        "Usage: replaybench --capture=file [--config=file]"
+        " [--speed=X] [--output=file] [--quick]");
+    if (! parsed)
+        return false;
+
+    return (! options.capture.empty () || options.quick)
+        && options.speed >= 0;
+}
+
+} // namespace
+
+
+int
+main (int argc, char * argv[])
+{
+    Options options;
+    if (! parseOptions (options, argc, argv))
+        return 2;
+
+    log4cplus::Initializer initializer;
+
+    bool const synthetic = options.capture.empty ();
+    if (synthetic)
+    {
+        writeQuickCapture ();
+        options.capture = LOG4CPLUS_TSTRING_TO_STRING (QUICK_CAPTURE);
+    }
+
+    if (options.config.empty ())
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("log4cplus.rootLogger"),
+            LOG4CPLUS_TEXT ("TRACE, NULL"));
+        props.setProperty (LOG4CPLUS_TEXT ("log4cplus.appender.NULL"),
+            LOG4CPLUS_TEXT ("log4cplus::NullAppender"));
+        PropertyConfigurator (props).configure ();
+    }
+    else
+        PropertyConfigurator::doConfigure (
+            LOG4CPLUS_C_STR_TO_TSTRING (options.config));
+
+    Result result;
+    try
+    {
+        WorkloadCaptureReader const capture (
+            LOG4CPLUS_C_STR_TO_TSTRING (options.capture));
+        std::cerr << options.capture << ": " << capture.getEvents ().size ()
+            << " events, " << capture.getLoggers ().size () << " loggers, "
+            << capture.getThreadCount () << " threads\n";
+        result = replay (capture, options.speed);
+    }
+    catch (std::exception const & e)
+    {
+        std::cerr << e.what () << "\n";
+        return 1;
+    }
+
+    // Let AsyncAppend=true and asynchronous appenders finish the replay
+    // before the result is reported.
+    Logger::getDefaultHierarchy ().shutdown ();
+    std::cerr << "events=" << result.events << " seconds=" << result.seconds
+        << " p50=" << result.latency.p50
+        << "ns p99=" << result.latency.p99
+        << "ns max=" << result.latency.max << "ns max_lag=" << result.maxLagUs << "us\n";
+
+    if (synthetic)
+        std::remove (options.capture.c_str ());
+
+    bool const written = bench::writeOutput (options.output,
+        [&] (std::ostream & out) { writeJson (out, options, result); });
+    return written && result.events != 0 ? 0 : 1;
+}